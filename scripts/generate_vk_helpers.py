@@ -62,6 +62,7 @@ def get_device_cmds():
         Cmd("vkCmdSetScissor"),
         Cmd("vkCmdSetViewport"),
         Cmd("vkCmdClearColorImage"),
+        Cmd("vkCmdClearDepthStencilImage"),
         Cmd("vkCmdEndRenderPass"),
         Cmd("vkCmdBindDescriptorSets"),
         Cmd("vkCmdBindPipeline"),
@@ -70,6 +71,7 @@ def get_device_cmds():
         Cmd("vkCmdDraw"),
         Cmd("vkCmdDrawIndexed"),
         Cmd("vkCmdDispatch"),
+        Cmd("vkCmdExecuteCommands"),
         Cmd("vkCmdCopyBuffer"),
         Cmd("vkCmdCopyBufferToImage"),
         Cmd("vkCmdCopyImage"),
@@ -87,6 +89,7 @@ def get_device_cmds():
         None,
         Cmd("vkCreatePipelineCache"),
         Cmd("vkDestroyPipelineCache"),
+        Cmd("vkGetPipelineCacheData"),
         None,
         Cmd("vkResetDescriptorPool"),
         Cmd("vkCreateDescriptorPool"),
@@ -53,6 +53,8 @@ typedef struct _monado_metrics_SystemGpuInfo {
     uint64_t gpu_start_ns;
     uint64_t gpu_end_ns;
     uint64_t when_ns;
+    uint64_t layer_squash_ns;
+    uint64_t distortion_ns;
 } monado_metrics_SystemGpuInfo;
 
 typedef struct _monado_metrics_SystemPresentInfo {
@@ -73,6 +75,13 @@ typedef struct _monado_metrics_SystemPresentInfo {
     uint64_t earliest_present_time_ns;
 } monado_metrics_SystemPresentInfo;
 
+typedef struct _monado_metrics_SystemLatency {
+    int64_t frame_id;
+    uint64_t pose_sample_ns;
+    uint64_t present_time_ns;
+    bool present_time_is_actual;
+} monado_metrics_SystemLatency;
+
 typedef struct _monado_metrics_Record {
     pb_size_t which_record;
     union {
@@ -82,6 +91,7 @@ typedef struct _monado_metrics_Record {
         monado_metrics_SystemFrame system_frame;
         monado_metrics_SystemGpuInfo system_gpu_info;
         monado_metrics_SystemPresentInfo system_present_info;
+        monado_metrics_SystemLatency system_latency;
     } record;
 } monado_metrics_Record;
 
@@ -95,15 +105,17 @@ extern "C" {
 #define monado_metrics_SessionFrame_init_default {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define monado_metrics_Used_init_default         {0, 0, 0, 0}
 #define monado_metrics_SystemFrame_init_default  {0, 0, 0, 0, 0, 0}
-#define monado_metrics_SystemGpuInfo_init_default {0, 0, 0, 0}
+#define monado_metrics_SystemGpuInfo_init_default {0, 0, 0, 0, 0, 0}
 #define monado_metrics_SystemPresentInfo_init_default {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define monado_metrics_SystemLatency_init_default {0, 0, 0, 0}
 #define monado_metrics_Record_init_default       {0, {monado_metrics_Version_init_default}}
 #define monado_metrics_Version_init_zero         {0, 0}
 #define monado_metrics_SessionFrame_init_zero    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define monado_metrics_Used_init_zero            {0, 0, 0, 0}
 #define monado_metrics_SystemFrame_init_zero     {0, 0, 0, 0, 0, 0}
-#define monado_metrics_SystemGpuInfo_init_zero   {0, 0, 0, 0}
+#define monado_metrics_SystemGpuInfo_init_zero   {0, 0, 0, 0, 0, 0}
 #define monado_metrics_SystemPresentInfo_init_zero {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define monado_metrics_SystemLatency_init_zero {0, 0, 0, 0}
 #define monado_metrics_Record_init_zero          {0, {monado_metrics_Version_init_zero}}
 
 /* Field tags (for use in manual encoding/decoding) */
@@ -137,6 +149,8 @@ extern "C" {
 #define monado_metrics_SystemGpuInfo_gpu_start_ns_tag 2
 #define monado_metrics_SystemGpuInfo_gpu_end_ns_tag 3
 #define monado_metrics_SystemGpuInfo_when_ns_tag 4
+#define monado_metrics_SystemGpuInfo_layer_squash_ns_tag 5
+#define monado_metrics_SystemGpuInfo_distortion_ns_tag 6
 #define monado_metrics_SystemPresentInfo_frame_id_tag 1
 #define monado_metrics_SystemPresentInfo_expected_comp_time_ns_tag 2
 #define monado_metrics_SystemPresentInfo_predicted_wake_up_time_ns_tag 3
@@ -152,12 +166,17 @@ extern "C" {
 #define monado_metrics_SystemPresentInfo_present_margin_ns_tag 13
 #define monado_metrics_SystemPresentInfo_actual_present_time_ns_tag 14
 #define monado_metrics_SystemPresentInfo_earliest_present_time_ns_tag 15
+#define monado_metrics_SystemLatency_frame_id_tag 1
+#define monado_metrics_SystemLatency_pose_sample_ns_tag 2
+#define monado_metrics_SystemLatency_present_time_ns_tag 3
+#define monado_metrics_SystemLatency_present_time_is_actual_tag 4
 #define monado_metrics_Record_version_tag        1
 #define monado_metrics_Record_session_frame_tag  2
 #define monado_metrics_Record_used_tag           3
 #define monado_metrics_Record_system_frame_tag   4
 #define monado_metrics_Record_system_gpu_info_tag 5
 #define monado_metrics_Record_system_present_info_tag 6
+#define monado_metrics_Record_system_latency_tag 7
 
 /* Struct field encoding specification for nanopb */
 #define monado_metrics_Version_FIELDLIST(X, a) \
@@ -206,7 +225,9 @@ X(a, STATIC,   SINGULAR, UINT64,   present_slop_ns,   6)
 X(a, STATIC,   SINGULAR, INT64,    frame_id,          1) \
 X(a, STATIC,   SINGULAR, UINT64,   gpu_start_ns,      2) \
 X(a, STATIC,   SINGULAR, UINT64,   gpu_end_ns,        3) \
-X(a, STATIC,   SINGULAR, UINT64,   when_ns,           4)
+X(a, STATIC,   SINGULAR, UINT64,   when_ns,           4) \
+X(a, STATIC,   SINGULAR, UINT64,   layer_squash_ns,   5) \
+X(a, STATIC,   SINGULAR, UINT64,   distortion_ns,     6)
 #define monado_metrics_SystemGpuInfo_CALLBACK NULL
 #define monado_metrics_SystemGpuInfo_DEFAULT NULL
 
@@ -229,13 +250,22 @@ X(a, STATIC,   SINGULAR, UINT64,   earliest_present_time_ns,  15)
 #define monado_metrics_SystemPresentInfo_CALLBACK NULL
 #define monado_metrics_SystemPresentInfo_DEFAULT NULL
 
+#define monado_metrics_SystemLatency_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, INT64,    frame_id,          1) \
+X(a, STATIC,   SINGULAR, UINT64,   pose_sample_ns,    2) \
+X(a, STATIC,   SINGULAR, UINT64,   present_time_ns,   3) \
+X(a, STATIC,   SINGULAR, BOOL,     present_time_is_actual,   4)
+#define monado_metrics_SystemLatency_CALLBACK NULL
+#define monado_metrics_SystemLatency_DEFAULT NULL
+
 #define monado_metrics_Record_FIELDLIST(X, a) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,version,record.version),   1) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,session_frame,record.session_frame),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,used,record.used),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_frame,record.system_frame),   4) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_gpu_info,record.system_gpu_info),   5) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_present_info),   6)
+X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_present_info),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_latency,record.system_latency),   7)
 #define monado_metrics_Record_CALLBACK NULL
 #define monado_metrics_Record_DEFAULT NULL
 #define monado_metrics_Record_record_version_MSGTYPE monado_metrics_Version
@@ -244,6 +274,7 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_pre
 #define monado_metrics_Record_record_system_frame_MSGTYPE monado_metrics_SystemFrame
 #define monado_metrics_Record_record_system_gpu_info_MSGTYPE monado_metrics_SystemGpuInfo
 #define monado_metrics_Record_record_system_present_info_MSGTYPE monado_metrics_SystemPresentInfo
+#define monado_metrics_Record_record_system_latency_MSGTYPE monado_metrics_SystemLatency
 
 extern const pb_msgdesc_t monado_metrics_Version_msg;
 extern const pb_msgdesc_t monado_metrics_SessionFrame_msg;
@@ -251,6 +282,7 @@ extern const pb_msgdesc_t monado_metrics_Used_msg;
 extern const pb_msgdesc_t monado_metrics_SystemFrame_msg;
 extern const pb_msgdesc_t monado_metrics_SystemGpuInfo_msg;
 extern const pb_msgdesc_t monado_metrics_SystemPresentInfo_msg;
+extern const pb_msgdesc_t monado_metrics_SystemLatency_msg;
 extern const pb_msgdesc_t monado_metrics_Record_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
@@ -260,13 +292,15 @@ extern const pb_msgdesc_t monado_metrics_Record_msg;
 #define monado_metrics_SystemFrame_fields &monado_metrics_SystemFrame_msg
 #define monado_metrics_SystemGpuInfo_fields &monado_metrics_SystemGpuInfo_msg
 #define monado_metrics_SystemPresentInfo_fields &monado_metrics_SystemPresentInfo_msg
+#define monado_metrics_SystemLatency_fields &monado_metrics_SystemLatency_msg
 #define monado_metrics_Record_fields &monado_metrics_Record_msg
 
 /* Maximum encoded size of messages (where known) */
 #define monado_metrics_Record_size               168
 #define monado_metrics_SessionFrame_size         145
 #define monado_metrics_SystemFrame_size          66
-#define monado_metrics_SystemGpuInfo_size        44
+#define monado_metrics_SystemGpuInfo_size        66
+#define monado_metrics_SystemLatency_size        35
 #define monado_metrics_SystemPresentInfo_size    165
 #define monado_metrics_Used_size                 44
 #define monado_metrics_Version_size              12
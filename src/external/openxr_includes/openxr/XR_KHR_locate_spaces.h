@@ -0,0 +1,88 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Preview header for XR_KHR_locate_spaces extension
+ *
+ * The bundled openxr.h predates this extension, these are the definitions
+ * from the registry. Does nothing once openxr.h provides the extension.
+ *
+ * @ingroup external_openxr
+ */
+#ifndef XR_KHR_LOCATE_SPACES_H
+#define XR_KHR_LOCATE_SPACES_H 1
+
+#include <openxr/openxr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef XR_KHR_locate_spaces
+
+#define XR_KHR_locate_spaces 1
+#define XR_KHR_locate_spaces_SPEC_VERSION 1
+#define XR_KHR_LOCATE_SPACES_EXTENSION_NAME "XR_KHR_locate_spaces"
+
+#define XR_TYPE_SPACES_LOCATE_INFO_KHR ((XrStructureType)1000471000U)
+#define XR_TYPE_SPACE_LOCATIONS_KHR ((XrStructureType)1000471001U)
+#define XR_TYPE_SPACE_VELOCITIES_KHR ((XrStructureType)1000471002U)
+
+typedef struct XrSpacesLocateInfoKHR
+{
+	XrStructureType type;
+	const void *XR_MAY_ALIAS next;
+	XrSpace baseSpace;
+	XrTime time;
+	uint32_t spaceCount;
+	const XrSpace *spaces;
+} XrSpacesLocateInfoKHR;
+
+typedef struct XrSpaceLocationDataKHR
+{
+	XrSpaceLocationFlags locationFlags;
+	XrPosef pose;
+} XrSpaceLocationDataKHR;
+
+typedef struct XrSpaceLocationsKHR
+{
+	XrStructureType type;
+	void *XR_MAY_ALIAS next;
+	uint32_t locationCount;
+	XrSpaceLocationDataKHR *locations;
+} XrSpaceLocationsKHR;
+
+typedef struct XrSpaceVelocityDataKHR
+{
+	XrSpaceVelocityFlags velocityFlags;
+	XrVector3f linearVelocity;
+	XrVector3f angularVelocity;
+} XrSpaceVelocityDataKHR;
+
+// XrSpaceVelocitiesKHR extends XrSpaceLocationsKHR
+typedef struct XrSpaceVelocitiesKHR
+{
+	XrStructureType type;
+	void *XR_MAY_ALIAS next;
+	uint32_t velocityCount;
+	XrSpaceVelocityDataKHR *velocities;
+} XrSpaceVelocitiesKHR;
+
+typedef XrResult(XRAPI_PTR *PFN_xrLocateSpacesKHR)(XrSession session,
+                                                   const XrSpacesLocateInfoKHR *locateInfo,
+                                                   XrSpaceLocationsKHR *spaceLocations);
+
+#ifndef XR_NO_PROTOTYPES
+#ifdef XR_EXTENSION_PROTOTYPES
+XRAPI_ATTR XrResult XRAPI_CALL
+xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR *locateInfo, XrSpaceLocationsKHR *spaceLocations);
+#endif /* XR_EXTENSION_PROTOTYPES */
+#endif /* !XR_NO_PROTOTYPES */
+
+#endif // !XR_KHR_locate_spaces
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,8 +25,8 @@ extern "C" {
 
 //! Compatibility with these values should be checked against @ref vit_api_get_version.
 #define VIT_HEADER_VERSION_MAJOR 1 //!< API Breakages
-#define VIT_HEADER_VERSION_MINOR 0 //!< Backwards compatible API changes
-#define VIT_HEADER_VERSION_PATCH 1 //!< Backw. comp. .h-implemented changes
+#define VIT_HEADER_VERSION_MINOR 2 //!< Backwards compatible API changes
+#define VIT_HEADER_VERSION_PATCH 0 //!< Backw. comp. .h-implemented changes
 
 #define VIT_CAMERA_CALIBRATION_DISTORTION_MAX_COUNT 32
 
@@ -196,6 +196,21 @@ typedef struct vit_img_sample {
 	vit_mask_t *masks;
 } vit_img_sample_t;
 
+/*!
+ * @brief Reference counted handle to the data of an image sample, implemented
+ * by the consumer.
+ *
+ * Lets the tracker keep using the data of a sample after the push call has
+ * returned instead of copying it. Both functions are thread safe.
+ */
+typedef struct vit_img_buffer {
+	//! Takes one more reference to the buffer.
+	void (*retain)(struct vit_img_buffer *buffer);
+
+	//! Drops one reference, the data must not be accessed once all references taken have been dropped.
+	void (*release)(struct vit_img_buffer *buffer);
+} vit_img_buffer_t;
+
 /*!
  * Data that is always returned from tracker.
  */
@@ -314,6 +329,11 @@ typedef vit_result_t (*PFN_vit_tracker_reset)(vit_tracker_t *tracker);
 typedef vit_result_t (*PFN_vit_tracker_is_running)(const vit_tracker_t *tracker, bool *out_bool);
 typedef vit_result_t (*PFN_vit_tracker_push_imu_sample)(vit_tracker_t *tracker, const vit_imu_sample_t *sample);
 typedef vit_result_t (*PFN_vit_tracker_push_img_sample)(vit_tracker_t *tracker, const vit_img_sample_t *sample);
+typedef vit_result_t (*PFN_vit_tracker_push_img_buffer_sample)(vit_tracker_t *tracker, const vit_img_sample_t *sample,
+																vit_img_buffer_t *buffer);
+typedef vit_result_t (*PFN_vit_tracker_save_map)(vit_tracker_t *tracker, const char *path);
+typedef vit_result_t (*PFN_vit_tracker_load_map)(vit_tracker_t *tracker, const char *path);
+typedef vit_result_t (*PFN_vit_tracker_is_map_localized)(const vit_tracker_t *tracker, bool *out_localized);
 typedef vit_result_t (*PFN_vit_tracker_add_imu_calibration)(vit_tracker_t *tracker,
 															const vit_imu_calibration_t *calibration);
 typedef vit_result_t (*PFN_vit_tracker_add_camera_calibration)(vit_tracker_t *tracker,
@@ -421,6 +441,46 @@ vit_result_t vit_tracker_push_imu_sample(vit_tracker_t *tracker, const vit_imu_s
  */
 vit_result_t vit_tracker_push_img_sample(vit_tracker_t *tracker, const vit_img_sample_t *sample);
 
+/*!
+ * @brief Push an image sample into the tracker without it having to copy the image data.
+ *
+ * Same conditions as @ref vit_tracker_push_img_sample apply. The data of @p sample is valid until this call returns,
+ * to use it after that the tracker retains @p buffer and releases it once done, the consumer doesn't write to the data
+ * while a reference is held. Only @p sample's data is covered, the masks must still be copied.
+ *
+ * Optional, added in version 1.1.0.
+ */
+vit_result_t vit_tracker_push_img_buffer_sample(vit_tracker_t *tracker, const vit_img_sample_t *sample,
+												vit_img_buffer_t *buffer);
+
+/*!
+ * @brief Writes the map the tracker has built so far to @p path, in an implementation specific format.
+ *
+ * Can be called while the tracker is running or after it has been stopped. The file is replaced, implementations
+ * should write it so that a failed save doesn't leave a broken map behind.
+ *
+ * Optional, added in version 1.2.0.
+ */
+vit_result_t vit_tracker_save_map(vit_tracker_t *tracker, const char *path);
+
+/*!
+ * @brief Loads a map written by @ref vit_tracker_save_map, the tracker localizes itself in it instead of starting
+ * from an empty map so poses are in the same space as in the session that saved it. The tracker must not be started.
+ *
+ * Returns `VIT_ERROR_INVALID_VALUE` if the file can't be read or was made with an incompatible configuration.
+ *
+ * Optional, added in version 1.2.0.
+ */
+vit_result_t vit_tracker_load_map(vit_tracker_t *tracker, const char *path);
+
+/*!
+ * @brief Whether the tracker has recognized where it is in the map loaded with @ref vit_tracker_load_map. Poses
+ * produced before then are not in the space of the map. Always true if no map was loaded.
+ *
+ * Optional, added in version 1.2.0.
+ */
+vit_result_t vit_tracker_is_map_localized(const vit_tracker_t *tracker, bool *out_localized);
+
 /*!
  * @brief Adds an inertial measurement unit calibration to the tracker. The tracker must not be started.
  *
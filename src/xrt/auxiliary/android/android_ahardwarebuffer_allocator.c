@@ -14,6 +14,8 @@
 #include "util/u_debug.h"
 #include "util/u_handles.h"
 
+#include "os/os_threading.h"
+
 #include "xrt/xrt_vulkan_includes.h"
 
 #ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
@@ -26,6 +28,39 @@ DEBUG_GET_ONCE_LOG_OPTION(ahardwarebuffer_log, "AHARDWAREBUFFER_LOG", U_LOGGING_
 #define AHB_WARN(...) U_LOG_IFL_W(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_ERROR(...) U_LOG_IFL_E(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 
+/*!
+ * How many freed buffers to keep around for reuse, apps often recreate
+ * swapchains of the same size and allocating buffers isn't cheap.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(ahardwarebuffer_pool_count, "AHARDWAREBUFFER_POOL_COUNT", 8)
+
+#define POOL_MAX_COUNT (16)
+
+/*!
+ * Allocator that keeps freed buffers in a pool and hands them out again to
+ * swapchains with the same description, shared by all swapchains made from
+ * the allocator.
+ */
+struct ahardwarebuffer_allocator
+{
+	struct xrt_image_native_allocator base;
+
+	struct os_mutex mutex;
+
+	//! How many of @ref buffers may be used, from @ref AHARDWAREBUFFER_POOL_COUNT.
+	uint32_t max_count;
+
+	//! Freed buffers, oldest first.
+	AHardwareBuffer *buffers[POOL_MAX_COUNT];
+	uint32_t count;
+};
+
+static inline struct ahardwarebuffer_allocator *
+ahardwarebuffer_allocator(struct xrt_image_native_allocator *xina)
+{
+	return (struct ahardwarebuffer_allocator *)xina;
+}
+
 static inline enum AHardwareBuffer_Format
 vk_format_to_ahardwarebuffer(uint64_t format)
 {
@@ -97,6 +132,80 @@ ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt
 	return XRT_SUCCESS;
 }
 
+static bool
+desc_matches(const AHardwareBuffer_Desc *a, const AHardwareBuffer_Desc *b)
+{
+	return a->width == b->width &&   //
+	       a->height == b->height && //
+	       a->layers == b->layers && //
+	       a->format == b->format && //
+	       a->usage == b->usage;
+}
+
+//! Take a pooled buffer matching @p desc, returns NULL if there is none.
+static AHardwareBuffer *
+pool_take(struct ahardwarebuffer_allocator *aa, const AHardwareBuffer_Desc *desc)
+{
+	AHardwareBuffer *ret = NULL;
+
+	os_mutex_lock(&aa->mutex);
+
+	// Newest first, the most likely to still be warm in caches.
+	for (uint32_t i = aa->count; i-- > 0;) {
+		AHardwareBuffer_Desc pooled;
+		U_ZERO(&pooled);
+		AHardwareBuffer_describe(aa->buffers[i], &pooled);
+
+		if (!desc_matches(&pooled, desc)) {
+			continue;
+		}
+
+		ret = aa->buffers[i];
+		for (uint32_t k = i + 1; k < aa->count; k++) {
+			aa->buffers[k - 1] = aa->buffers[k];
+		}
+		aa->buffers[--aa->count] = NULL;
+		break;
+	}
+
+	os_mutex_unlock(&aa->mutex);
+
+	return ret;
+}
+
+//! Give the buffer to the pool, or release it if the pool isn't used.
+static void
+pool_give(struct ahardwarebuffer_allocator *aa, AHardwareBuffer **buffer_ptr)
+{
+	if (*buffer_ptr == NULL) {
+		return;
+	}
+
+	// Protected content is never reused for a different swapchain.
+	AHardwareBuffer_Desc desc;
+	U_ZERO(&desc);
+	AHardwareBuffer_describe(*buffer_ptr, &desc);
+	if (aa->max_count == 0 || (desc.usage & AHARDWAREBUFFER_USAGE_PROTECTED_CONTENT) != 0) {
+		u_graphics_buffer_unref(buffer_ptr);
+		return;
+	}
+
+	os_mutex_lock(&aa->mutex);
+
+	if (aa->count >= aa->max_count) {
+		u_graphics_buffer_unref(&aa->buffers[0]);
+		for (uint32_t k = 1; k < aa->count; k++) {
+			aa->buffers[k - 1] = aa->buffers[k];
+		}
+		aa->buffers[--aa->count] = NULL;
+	}
+
+	aa->buffers[aa->count++] = *buffer_ptr;
+	*buffer_ptr = NULL;
+
+	os_mutex_unlock(&aa->mutex);
+}
+
 static xrt_result_t
 ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
                                 const struct xrt_swapchain_create_info *xsci,
@@ -134,9 +243,18 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
 	}
 #endif
 
+	struct ahardwarebuffer_allocator *aa = ahardwarebuffer_allocator(xina);
+	uint32_t reused = 0;
+
 	memset(out_images, 0, sizeof(*out_images) * image_count);
 	bool failed = false;
 	for (size_t i = 0; i < image_count; ++i) {
+		out_images[i].handle = pool_take(aa, &desc);
+		if (out_images[i].handle != NULL) {
+			reused++;
+			continue;
+		}
+
 		int ret = AHardwareBuffer_allocate(&desc, &(out_images[i].handle));
 		if (ret != 0) {
 			AHB_ERROR("Failed allocating image %d.", (int)i);
@@ -150,6 +268,11 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
 		}
 		return XRT_ERROR_ALLOCATION;
 	}
+
+	if (reused > 0) {
+		AHB_DEBUG("Reused %u of %u buffers from the pool.", reused, (uint32_t)image_count);
+	}
+
 	return XRT_SUCCESS;
 }
 
@@ -158,27 +281,56 @@ ahardwarebuffer_images_free(struct xrt_image_native_allocator *xina,
                             size_t image_count,
                             struct xrt_image_native *images)
 {
+	struct ahardwarebuffer_allocator *aa = ahardwarebuffer_allocator(xina);
+
 	for (size_t i = 0; i < image_count; ++i) {
-		u_graphics_buffer_unref(&(images[i].handle));
+		pool_give(aa, &(images[i].handle));
 	}
 	return XRT_SUCCESS;
 }
 static void
 ahardwarebuffer_destroy(struct xrt_image_native_allocator *xina)
 {
-	if (xina != NULL) {
-		free(xina);
+	if (xina == NULL) {
+		return;
+	}
+
+	struct ahardwarebuffer_allocator *aa = ahardwarebuffer_allocator(xina);
+
+	for (uint32_t i = 0; i < aa->count; i++) {
+		u_graphics_buffer_unref(&aa->buffers[i]);
 	}
+	aa->count = 0;
+
+	os_mutex_destroy(&aa->mutex);
+
+	free(aa);
 }
 
 struct xrt_image_native_allocator *
 android_ahardwarebuffer_allocator_create()
 {
-	struct xrt_image_native_allocator *xina = U_TYPED_CALLOC(struct xrt_image_native_allocator);
-	xina->images_allocate = ahardwarebuffer_images_allocate;
-	xina->images_free = ahardwarebuffer_images_free;
-	xina->destroy = ahardwarebuffer_destroy;
-	return xina;
+	struct ahardwarebuffer_allocator *aa = U_TYPED_CALLOC(struct ahardwarebuffer_allocator);
+	aa->base.images_allocate = ahardwarebuffer_images_allocate;
+	aa->base.images_free = ahardwarebuffer_images_free;
+	aa->base.destroy = ahardwarebuffer_destroy;
+
+	int64_t max_count = debug_get_num_option_ahardwarebuffer_pool_count();
+	if (max_count < 0) {
+		max_count = 0;
+	} else if (max_count > POOL_MAX_COUNT) {
+		max_count = POOL_MAX_COUNT;
+	}
+	aa->max_count = (uint32_t)max_count;
+
+	int iret = os_mutex_init(&aa->mutex);
+	if (iret != 0) {
+		AHB_ERROR("Failed to init mutex!");
+		free(aa);
+		return NULL;
+	}
+
+	return &aa->base;
 }
 
 #endif // XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
@@ -12,6 +12,7 @@
 #include "xrt/xrt_frame.h"
 
 typedef struct _GstElement GstElement;
+typedef struct _GstAllocator GstAllocator;
 
 
 #ifdef __cplusplus
@@ -71,6 +72,15 @@ struct gstreamer_sink
 
 	//! Cached appsrc element.
 	GstElement *appsrc;
+
+	//! Only set if pushing dma-bufs, frames are then wrapped without any copies.
+	GstAllocator *dmabuf_allocator;
+
+	//! Set by the appsrc when its queue is full, frames are dropped until it wants more.
+	gint enough_data;
+
+	//! Number of frames dropped because the pipeline could not keep up.
+	uint64_t dropped_frames;
 };
 
 
@@ -16,6 +16,25 @@
 
 #include "gst/gst.h"
 
+#include <stdio.h>
+
+
+/*!
+ * H.264 encoders in order of preference, the bitrate in kbit/s is substituted
+ * into @p format, the last one is the software fallback.
+ */
+static const struct
+{
+	const char *factory;
+	const char *format;
+} h264_encoders[] = {
+    {"vah264enc", "vah264enc rate-control=cbr bitrate=%s"},
+    {"vaapih264enc", "vaapih264enc rate-control=cbr bitrate=%s tune=high-compression"},
+    {"nvh264enc", "nvh264enc bitrate=%s"},
+    {"v4l2h264enc", "v4l2h264enc extra-controls=\"controls,video_bitrate=%s000\""},
+    {"x264enc", "x264enc bitrate=%s speed-preset=veryfast"},
+};
+
 /*
  *
  * Internal pipeline functions.
@@ -58,6 +77,28 @@ destroy(struct xrt_frame_node *node)
  *
  */
 
+bool
+gstreamer_pipeline_get_h264_encoder(const char *bitrate_kbps, char *out_str, size_t size)
+{
+	gst_init(NULL, NULL);
+
+	const uint32_t last = ARRAY_SIZE(h264_encoders) - 1;
+
+	uint32_t i = 0;
+	for (; i < last; i++) {
+		GstElementFactory *factory = gst_element_factory_find(h264_encoders[i].factory);
+		if (factory != NULL) {
+			gst_object_unref(factory);
+			break;
+		}
+	}
+
+	U_LOG_I("Using H.264 encoder '%s'", h264_encoders[i].factory);
+	snprintf(out_str, size, h264_encoders[i].format, bitrate_kbps);
+
+	return i < last;
+}
+
 void
 gstreamer_pipeline_play(struct gstreamer_pipeline *gp)
 {
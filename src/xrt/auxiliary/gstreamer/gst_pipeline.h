@@ -28,6 +28,20 @@ gstreamer_pipeline_create_autovideo_sink(struct xrt_frame_context *xfctx,
                                          const char *appsrc_name,
                                          struct gstreamer_pipeline **out_gp);
 
+/*!
+ * Writes the pipeline description of the best installed H.264 encoder into
+ * @p out_str, hardware encoders are preferred with x264enc as the fallback.
+ * The encoder element takes NV12 system memory.
+ *
+ * @param bitrate_kbps Target bitrate in kbit/s, as a string.
+ * @param out_str Where the description is written to.
+ * @param size Size of @p out_str.
+ *
+ * @return true if a hardware encoder was picked.
+ */
+bool
+gstreamer_pipeline_get_h264_encoder(const char *bitrate_kbps, char *out_str, size_t size);
+
 void
 gstreamer_pipeline_play(struct gstreamer_pipeline *gp);
 
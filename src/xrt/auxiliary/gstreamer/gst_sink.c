@@ -9,6 +9,8 @@
  * @ingroup aux_util
  */
 
+#include "xrt/xrt_config_have.h"
+
 #include "util/u_trace_marker.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -22,7 +24,12 @@
 #include "gst/app/gstappsink.h"
 #include "gst/app/gstappsrc.h"
 
+#ifdef XRT_HAVE_GST_ALLOCATORS
+#include "gst/allocators/gstdmabuf.h"
+#endif
+
 #include <assert.h>
+#include <inttypes.h>
 
 
 /*
@@ -68,6 +75,44 @@ complain_if_wrong_image_size(struct xrt_frame *xf)
 	}
 }
 
+#ifdef XRT_HAVE_GST_ALLOCATORS
+static GstBuffer *
+wrap_frame_dmabuf(struct gstreamer_sink *gs, struct xrt_frame *xf)
+{
+	/* We need to take a reference on the frame to keep it alive. */
+	struct xrt_frame *taken = NULL;
+	xrt_frame_reference(&taken, xf);
+
+	// The fd is owned by the frame, which outlives the buffer.
+	GstMemory *mem = gst_dmabuf_allocator_alloc_with_flags( //
+	    gs->dmabuf_allocator,                               // allocator
+	    xf->dmabuf_fd,                                      // fd
+	    xf->dmabuf_offset + xf->size,                       // size
+	    GST_FD_MEMORY_FLAG_DONT_CLOSE);                     // flags
+	gst_memory_resize(mem, (gssize)xf->dmabuf_offset, xf->size);
+
+	GstBuffer *buffer = gst_buffer_new();
+	gst_buffer_append_memory(buffer, mem);
+
+	// Released when the buffer is freed.
+	gst_mini_object_set_qdata(                          //
+	    GST_MINI_OBJECT(buffer),                        //
+	    g_quark_from_static_string("monado-xrt-frame"), //
+	    taken,                                          //
+	    wrapped_buffer_destroy);                        //
+
+	return buffer;
+}
+#else
+static GstBuffer *
+wrap_frame_dmabuf(struct gstreamer_sink *gs, struct xrt_frame *xf)
+{
+	// The allocator is never created without gstreamer-allocators.
+	assert(false);
+	return NULL;
+}
+#endif
+
 static void
 push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 {
@@ -79,6 +124,19 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	GstBuffer *buffer;
 	GstFlowReturn ret;
 
+	// Can't mix system memory into a dma-buf stream.
+	if (gs->dmabuf_allocator != NULL && !xf->has_dmabuf) {
+		U_LOG_W("Dropping frame without a dma-buf!");
+		return;
+	}
+
+	// Drop instead of queueing without bound, the producer must never wait on the pipeline.
+	if (g_atomic_int_get(&gs->enough_data)) {
+		gs->dropped_frames++;
+		U_LOG_D("Pipeline is full, dropped %" PRIu64 " frames so far", gs->dropped_frames);
+		return;
+	}
+
 	U_LOG_T(
 	    "Called"
 	    "\n\tformat: %s"
@@ -86,19 +144,23 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	    "\n\theight: %u",
 	    u_format_str(xf->format), xf->width, xf->height);
 
-	/* We need to take a reference on the frame to keep it alive. */
-	struct xrt_frame *taken = NULL;
-	xrt_frame_reference(&taken, xf);
-
-	/* Wrap the frame that we now hold a reference to. */
-	buffer = gst_buffer_new_wrapped_full( //
-	    0,                                // GstMemoryFlags flags
-	    (gpointer)xf->data,               // gpointer data
-	    taken->size,                      // gsize maxsize
-	    0,                                // gsize offset
-	    taken->size,                      // gsize size
-	    taken,                            // gpointer user_data
-	    wrapped_buffer_destroy);          // GDestroyNotify notify
+	if (gs->dmabuf_allocator != NULL) {
+		buffer = wrap_frame_dmabuf(gs, xf);
+	} else {
+		/* We need to take a reference on the frame to keep it alive. */
+		struct xrt_frame *taken = NULL;
+		xrt_frame_reference(&taken, xf);
+
+		/* Wrap the frame that we now hold a reference to. */
+		buffer = gst_buffer_new_wrapped_full( //
+		    0,                                // GstMemoryFlags flags
+		    (gpointer)xf->data,               // gpointer data
+		    taken->size,                      // gsize maxsize
+		    0,                                // gsize offset
+		    taken->size,                      // gsize size
+		    taken,                            // gpointer user_data
+		    wrapped_buffer_destroy);          // GDestroyNotify notify
+	}
 
 	int stride = xf->stride;
 
@@ -132,8 +194,21 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 static void
 enough_data(GstElement *appsrc, gpointer udata)
 {
-	// Debugging code.
+	struct gstreamer_sink *gs = (struct gstreamer_sink *)udata;
+
 	U_LOG_T("Called");
+
+	g_atomic_int_set(&gs->enough_data, 1);
+}
+
+static void
+need_data(GstElement *appsrc, guint length, gpointer udata)
+{
+	struct gstreamer_sink *gs = (struct gstreamer_sink *)udata;
+
+	U_LOG_T("Called");
+
+	g_atomic_int_set(&gs->enough_data, 0);
 }
 
 static void
@@ -162,6 +237,11 @@ destroy(struct xrt_frame_node *node)
 	 * be called, it's now safe to destroy and free ourselves.
 	 */
 
+	if (gs->dmabuf_allocator != NULL) {
+		gst_object_unref(gs->dmabuf_allocator);
+		gs->dmabuf_allocator = NULL;
+	}
+
 	free(gs);
 }
 
@@ -184,14 +264,15 @@ gstreamer_sink_get_timestamp_offset(struct gstreamer_sink *gs)
 	return gs->offset_ns;
 }
 
-void
-gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
-                                    uint32_t width,
-                                    uint32_t height,
-                                    enum xrt_format format,
-                                    const char *appsrc_name,
-                                    struct gstreamer_sink **out_gs,
-                                    struct xrt_frame_sink **out_xfs)
+static void
+create_with_pipeline(struct gstreamer_pipeline *gp,
+                     uint32_t width,
+                     uint32_t height,
+                     enum xrt_format format,
+                     const char *appsrc_name,
+                     bool dmabuf,
+                     struct gstreamer_sink **out_gs,
+                     struct xrt_frame_sink **out_xfs)
 {
 	const char *format_str = NULL;
 	switch (format) {
@@ -219,14 +300,31 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
 	    "framerate", GST_TYPE_FRACTION, 0, 1, //
 	    NULL);
 
+#ifdef XRT_HAVE_GST_ALLOCATORS
+	if (dmabuf) {
+		gs->dmabuf_allocator = gst_dmabuf_allocator_new();
+		gst_caps_set_features(caps, 0, gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_DMABUF, NULL));
+	}
+#else
+	if (dmabuf) {
+		U_LOG_W("Built without gstreamer-allocators, falling back to system memory!");
+	}
+#endif
+
+	// Room for a few frames of the largest format before enough-data is signalled.
+	guint64 max_bytes = (guint64)width * height * 4 * 4;
+
 	g_object_set(G_OBJECT(gs->appsrc),                      //
 	             "caps", caps,                              //
 	             "stream-type", GST_APP_STREAM_TYPE_STREAM, //
 	             "format", GST_FORMAT_TIME,                 //
 	             "is-live", TRUE,                           //
+	             "block", FALSE,                            //
+	             "max-bytes", max_bytes,                    //
 	             NULL);
 
 	g_signal_connect(G_OBJECT(gs->appsrc), "enough-data", G_CALLBACK(enough_data), gs);
+	g_signal_connect(G_OBJECT(gs->appsrc), "need-data", G_CALLBACK(need_data), gs);
 
 	/*
 	 * Add ourselves to the context so we are destroyed.
@@ -237,3 +335,27 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
 	*out_gs = gs;
 	*out_xfs = &gs->base;
 }
+
+void
+gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
+                                    uint32_t width,
+                                    uint32_t height,
+                                    enum xrt_format format,
+                                    const char *appsrc_name,
+                                    struct gstreamer_sink **out_gs,
+                                    struct xrt_frame_sink **out_xfs)
+{
+	create_with_pipeline(gp, width, height, format, appsrc_name, false, out_gs, out_xfs);
+}
+
+void
+gstreamer_sink_create_with_pipeline_dmabuf(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           enum xrt_format format,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs,
+                                           struct xrt_frame_sink **out_xfs)
+{
+	create_with_pipeline(gp, width, height, format, appsrc_name, true, out_gs, out_xfs);
+}
@@ -34,6 +34,24 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
                                     struct gstreamer_sink **out_gs,
                                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Same as @ref gstreamer_sink_create_with_pipeline but the appsrc produces
+ * `memory:DMABuf` buffers, wrapping the @ref xrt_frame::dmabuf_fd of the
+ * frames so encoders can import them without any CPU copy. Frames without a
+ * dma-buf are dropped.
+ *
+ * If built without gstreamer-allocators this behaves like
+ * @ref gstreamer_sink_create_with_pipeline, wrapping the frame data instead.
+ */
+void
+gstreamer_sink_create_with_pipeline_dmabuf(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           enum xrt_format format,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs,
+                                           struct xrt_frame_sink **out_xfs);
+
 
 #ifdef __cplusplus
 }
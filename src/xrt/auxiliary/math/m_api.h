@@ -312,6 +312,22 @@ math_quat_ensure_normalized(struct xrt_quat *inout);
 void
 math_quat_rotate_vec3(const struct xrt_quat *left, const struct xrt_vec3 *right, struct xrt_vec3 *result);
 
+/*!
+ * Rotate @p count vectors by the same quaternion, the rotation is only
+ * converted to a matrix once.
+ *
+ * OK if input and output are the same addresses.
+ *
+ * @relates xrt_quat
+ * @see xrt_vec3
+ * @ingroup aux_math
+ */
+void
+math_quat_rotate_vec3_batch(const struct xrt_quat *left,
+                            const struct xrt_vec3 *right,
+                            uint32_t count,
+                            struct xrt_vec3 *result);
+
 /*!
  * Rotate a quaternion (compose rotations).
  *
@@ -734,6 +750,21 @@ math_pose_interpolate(const struct xrt_pose *a, const struct xrt_pose *b, float
 void
 math_pose_transform(const struct xrt_pose *transform, const struct xrt_pose *pose, struct xrt_pose *outPose);
 
+/*!
+ * Apply the same rigid-body transformation to @p count poses, like the joints
+ * of a hand, the rotation is only converted to a matrix once.
+ *
+ * OK if input and output are the same addresses.
+ *
+ * @relates xrt_pose
+ * @ingroup aux_math
+ */
+void
+math_pose_transform_batch(const struct xrt_pose *transform,
+                          const struct xrt_pose *poses,
+                          uint32_t count,
+                          struct xrt_pose *out_poses);
+
 /*!
  * Apply a rigid-body transformation to a point.
  *
@@ -384,6 +384,24 @@ math_quat_rotate_vec3(const struct xrt_quat *left, const struct xrt_vec3 *right,
 	map_vec3(*result) = v;
 }
 
+extern "C" void
+math_quat_rotate_vec3_batch(const struct xrt_quat *left,
+                            const struct xrt_vec3 *right,
+                            uint32_t count,
+                            struct xrt_vec3 *result)
+{
+	assert(left != NULL);
+	assert(count == 0 || right != NULL);
+	assert(count == 0 || result != NULL);
+
+	Eigen::Matrix3f m = copy(left).toRotationMatrix();
+
+	for (uint32_t i = 0; i < count; i++) {
+		// Evaluated into a temporary, so in place is fine.
+		map_vec3(result[i]) = m * copy(right[i]);
+	}
+}
+
 extern "C" void
 math_quat_rotate_derivative(const struct xrt_quat *quat, const struct xrt_vec3 *deriv, struct xrt_vec3 *result)
 {
@@ -928,6 +946,29 @@ math_pose_transform(const struct xrt_pose *transform, const struct xrt_pose *pos
 	memcpy(outPose, &newPose, sizeof(xrt_pose));
 }
 
+extern "C" void
+math_pose_transform_batch(const struct xrt_pose *transform,
+                          const struct xrt_pose *poses,
+                          uint32_t count,
+                          struct xrt_pose *out_poses)
+{
+	assert(transform != NULL);
+	assert(count == 0 || poses != NULL);
+	assert(count == 0 || out_poses != NULL);
+
+	Eigen::Quaternionf q = orientation(*transform);
+	Eigen::Matrix3f m = q.toRotationMatrix();
+	Eigen::Vector3f t = position(*transform);
+
+	for (uint32_t i = 0; i < count; i++) {
+		Eigen::Vector3f p = m * position(poses[i]) + t;
+		Eigen::Quaternionf o = q * orientation(poses[i]);
+
+		position(out_poses[i]) = p;
+		orientation(out_poses[i]) = o;
+	}
+}
+
 extern "C" void
 math_pose_transform_point(const struct xrt_pose *transform, const struct xrt_vec3 *point, struct xrt_vec3 *out_point)
 {
@@ -0,0 +1,186 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Tracking of the offset and drift between two clocks.
+ * @ingroup aux_math
+ */
+
+#include "util/u_misc.h"
+
+#include "math/m_clock_offset.h"
+#include "math/m_mathinclude.h"
+
+#include <assert.h>
+
+
+#define DEFAULT_BUCKET_NS (50 * U_TIME_1MS_IN_NS)
+#define DEFAULT_OUTLIER_NS (U_TIME_1MS_IN_NS)
+
+//! Clocks that drift more than this are broken or not the same clock, one millisecond per second.
+#define MAX_DRIFT (1e-3)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+struct point
+{
+	double x; //!< Clock A relative to the fit reference.
+	double y; //!< Offset relative to the first point.
+};
+
+/*!
+ * Least squares line through the points that have @p mask set, returns false
+ * if there were too few to fit a slope.
+ */
+static bool
+fit_line(const struct point *points, const bool *mask, uint32_t count, double *out_y0, double *out_slope)
+{
+	double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!mask[i]) {
+			continue;
+		}
+		sum_x += points[i].x;
+		sum_y += points[i].y;
+		sum_xx += points[i].x * points[i].x;
+		sum_xy += points[i].x * points[i].y;
+		n++;
+	}
+
+	if (n == 0) {
+		return false;
+	}
+
+	double mean_x = sum_x / n;
+	double mean_y = sum_y / n;
+	double var_x = sum_xx / n - mean_x * mean_x;
+
+	// Not enough spread in time to tell the drift.
+	if (n < 2 || var_x < 1.0) {
+		*out_y0 = mean_y;
+		*out_slope = 0;
+		return false;
+	}
+
+	double slope = (sum_xy / n - mean_x * mean_y) / var_x;
+	if (fabs(slope) > MAX_DRIFT) {
+		slope = 0;
+	}
+
+	*out_y0 = mean_y - slope * mean_x;
+	*out_slope = slope;
+
+	return true;
+}
+
+static void
+refit(struct m_clock_tracker *ct)
+{
+	struct point points[M_CLOCK_TRACKER_WINDOW + 1];
+	bool mask[M_CLOCK_TRACKER_WINDOW + 1];
+	uint32_t count = 0;
+
+	// Everything relative to the newest sample, keeps the doubles small.
+	timepoint_ns ref_a = ct->current.a;
+	time_duration_ns ref_a2b = ct->current.a2b;
+
+	for (uint32_t i = 0; i < ct->bucket_count; i++) {
+		points[count].x = (double)(ct->buckets[i].a - ref_a);
+		points[count].y = (double)(ct->buckets[i].a2b - ref_a2b);
+		count++;
+	}
+
+	points[count].x = 0;
+	points[count].y = 0;
+	count++;
+
+	for (uint32_t i = 0; i < count; i++) {
+		mask[i] = true;
+	}
+
+	double y0, slope;
+	if (fit_line(points, mask, count, &y0, &slope)) {
+		// Reject outliers, then fit again with the rest.
+		uint32_t inliers = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			double residual = points[i].y - (y0 + slope * points[i].x);
+			mask[i] = fabs(residual) <= (double)ct->outlier_ns;
+			inliers += mask[i] ? 1 : 0;
+		}
+
+		if (inliers > 0) {
+			fit_line(points, mask, count, &y0, &slope);
+		}
+	}
+
+	ct->fit.ref_a = ref_a;
+	ct->fit.a2b_ns = (double)ref_a2b + y0;
+	ct->fit.drift = slope;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+m_clock_tracker_init(struct m_clock_tracker *ct, time_duration_ns bucket_ns, time_duration_ns outlier_ns)
+{
+	U_ZERO(ct);
+
+	ct->bucket_ns = bucket_ns > 0 ? bucket_ns : DEFAULT_BUCKET_NS;
+	ct->outlier_ns = outlier_ns > 0 ? outlier_ns : DEFAULT_OUTLIER_NS;
+}
+
+void
+m_clock_tracker_add_sample(struct m_clock_tracker *ct, timepoint_ns a, timepoint_ns b)
+{
+	time_duration_ns a2b = b - a;
+
+	if (!ct->current.active || a - ct->current.start_a >= ct->bucket_ns || a < ct->current.start_a) {
+		// Finish the current bucket, going backwards in time also starts a new one.
+		if (ct->current.active) {
+			ct->buckets[ct->next_bucket].a = ct->current.a;
+			ct->buckets[ct->next_bucket].a2b = ct->current.a2b;
+			ct->next_bucket = (ct->next_bucket + 1) % M_CLOCK_TRACKER_WINDOW;
+			if (ct->bucket_count < M_CLOCK_TRACKER_WINDOW) {
+				ct->bucket_count++;
+			}
+		}
+
+		ct->current.active = true;
+		ct->current.start_a = a;
+		ct->current.a = a;
+		ct->current.a2b = a2b;
+	} else if (a2b < ct->current.a2b) {
+		// Least delayed sample in this bucket.
+		ct->current.a = a;
+		ct->current.a2b = a2b;
+	} else {
+		// Doesn't change the fit.
+		return;
+	}
+
+	refit(ct);
+}
+
+time_duration_ns
+m_clock_tracker_get_a2b(const struct m_clock_tracker *ct, timepoint_ns a)
+{
+	if (!ct->current.active) {
+		return 0;
+	}
+
+	double a2b = ct->fit.a2b_ns + ct->fit.drift * (double)(a - ct->fit.ref_a);
+
+	return (time_duration_ns)llround(a2b);
+}
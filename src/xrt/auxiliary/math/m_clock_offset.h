@@ -51,6 +51,128 @@ m_clock_offset_a2b(float freq, timepoint_ns a, timepoint_ns b, time_duration_ns
 	return a + new_a2b;
 }
 
+
+/*
+ *
+ * Clock tracker.
+ *
+ */
+
+//! Number of buckets kept by a @ref m_clock_tracker.
+#define M_CLOCK_TRACKER_WINDOW (64)
+
+/*!
+ * Tracks the mapping from a hardware clock A to a host clock B, like device
+ * IMU ticks to monotonic time, including the drift between the two.
+ *
+ * Samples are pairs of a hardware timestamp and the host time it was received
+ * at. The samples are grouped into buckets of @ref bucket_ns and only the one
+ * with the smallest offset, which is the one with the least transmission delay,
+ * is kept per bucket. A line is then fitted through the buckets of the sliding
+ * window, buckets that are more than @ref outlier_ns off the first fit are
+ * rejected and the line fitted again.
+ *
+ * Not thread safe.
+ *
+ * @ingroup aux_math
+ */
+struct m_clock_tracker
+{
+	//! Length of a bucket in clock A.
+	time_duration_ns bucket_ns;
+
+	//! How far from the line a bucket may be before it's rejected.
+	time_duration_ns outlier_ns;
+
+	//! Ring of finished buckets.
+	struct
+	{
+		timepoint_ns a;
+		time_duration_ns a2b;
+	} buckets[M_CLOCK_TRACKER_WINDOW];
+
+	//! Number of valid entries in @ref buckets.
+	uint32_t bucket_count;
+
+	//! Where the next finished bucket goes in @ref buckets.
+	uint32_t next_bucket;
+
+	//! The bucket currently being filled.
+	struct
+	{
+		bool active;
+		timepoint_ns start_a;
+		timepoint_ns a;
+		time_duration_ns a2b;
+	} current;
+
+	//! Offset at @p ref_a, and how much it changes per nanosecond of clock A.
+	struct
+	{
+		timepoint_ns ref_a;
+		double a2b_ns;
+		double drift;
+	} fit;
+};
+
+/*!
+ * Initialise a clock tracker.
+ *
+ * @param ct Tracker to initialise.
+ * @param bucket_ns Length of a bucket, the window covers @ref M_CLOCK_TRACKER_WINDOW of these. Zero means 50ms.
+ * @param outlier_ns Offset from the fitted line a bucket is rejected at. Zero means 1ms.
+ *
+ * @public @memberof m_clock_tracker
+ */
+void
+m_clock_tracker_init(struct m_clock_tracker *ct, time_duration_ns bucket_ns, time_duration_ns outlier_ns);
+
+/*!
+ * Add a sample and update the fit.
+ *
+ * @param ct Tracker.
+ * @param a Timestamp in clock A of the event.
+ * @param b Timestamp in clock B of the event.
+ *
+ * @public @memberof m_clock_tracker
+ */
+void
+m_clock_tracker_add_sample(struct m_clock_tracker *ct, timepoint_ns a, timepoint_ns b);
+
+/*!
+ * Estimated offset from clock A to clock B at @p a, zero if no samples have
+ * been added.
+ *
+ * @public @memberof m_clock_tracker
+ */
+time_duration_ns
+m_clock_tracker_get_a2b(const struct m_clock_tracker *ct, timepoint_ns a);
+
+/*!
+ * Drop in replacement for @ref m_clock_offset_a2b, adds the sample and returns
+ * @p a in clock B.
+ *
+ * @param ct Tracker.
+ * @param a Timestamp in clock A of the event.
+ * @param b Timestamp in clock B of the event.
+ * @param[out] out_a2b Estimated offset from A to B at @p a, may be NULL.
+ * @return timepoint_ns @p a in B clock
+ *
+ * @public @memberof m_clock_tracker
+ */
+static inline timepoint_ns
+m_clock_tracker_a2b(struct m_clock_tracker *ct, timepoint_ns a, timepoint_ns b, time_duration_ns *out_a2b)
+{
+	m_clock_tracker_add_sample(ct, a, b);
+
+	time_duration_ns a2b = m_clock_tracker_get_a2b(ct, a);
+	if (out_a2b != NULL) {
+		*out_a2b = a2b;
+	}
+
+	return a + a2b;
+}
+
 #ifdef __cplusplus
 }
 #endif
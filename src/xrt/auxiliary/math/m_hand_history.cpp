@@ -0,0 +1,484 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Keeps track of the history of a hand's joints, for interpolating
+ *         between tracker samples and predicting past the newest one.
+ * @ingroup aux_math
+ */
+
+#include "m_hand_history.h"
+
+#include "math/m_api.h"
+#include "math/m_predict.h"
+#include "math/m_vec3.h"
+#include "os/os_threading.h"
+#include "os/os_time.h"
+#include "util/u_logging.h"
+#include "util/u_seqlock.h"
+#include "util/u_trace_marker.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace os = xrt::auxiliary::os;
+
+
+#define JOINT_COUNT (XRT_HAND_JOINT_COUNT)
+
+static const enum xrt_space_relation_flags velocity_flags = (enum xrt_space_relation_flags)(
+    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+
+/*!
+ * One entry copied out of the history, so the math is done outside of the
+ * read section.
+ */
+struct hand_sample
+{
+	uint64_t timestamp;
+	bool active;
+	struct xrt_space_relation hand_pose;
+	struct xrt_space_relation root;
+	struct xrt_pose local_poses[JOINT_COUNT];
+	float radii[JOINT_COUNT];
+	enum xrt_space_relation_flags flags[JOINT_COUNT];
+};
+
+struct m_hand_history
+{
+	//! Guards @ref count and all of the arrays.
+	struct u_seqlock lock;
+
+	//! Number of entries pushed since creation or clear, the newest is in slot (count - 1) % capacity.
+	uint64_t count;
+
+	//! Fixed at creation, never resized.
+	uint32_t capacity;
+
+	//! Per entry.
+	std::vector<uint64_t> timestamps;
+	std::vector<uint8_t> active;
+	std::vector<struct xrt_space_relation> hand_poses;
+
+	//! The wrist joint, in the same space as the joint set.
+	std::vector<struct xrt_space_relation> roots;
+
+	//! Per joint, JOINT_COUNT for each entry, the poses are relative to the root.
+	std::vector<struct xrt_pose> local_poses;
+	std::vector<float> radii;
+	std::vector<enum xrt_space_relation_flags> flags;
+
+	//! Only taken by writers.
+	os::Mutex write_mutex;
+};
+
+enum class FindResult
+{
+	Empty,
+	Exact,
+	After,
+	Before,
+	Between,
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint32_t
+get_size_unsafe(const struct m_hand_history *hh)
+{
+	return (uint32_t)std::min<uint64_t>(hh->count, hh->capacity);
+}
+
+//! Slot of entry @p index counted from the oldest one.
+static inline uint32_t
+get_slot_unsafe(const struct m_hand_history *hh, uint32_t index)
+{
+	uint64_t first = hh->count - get_size_unsafe(hh);
+	return (uint32_t)((first + index) % hh->capacity);
+}
+
+static void
+read_sample_unsafe(const struct m_hand_history *hh, uint32_t slot, struct hand_sample *out_sample)
+{
+	out_sample->timestamp = hh->timestamps[slot];
+	out_sample->active = hh->active[slot] != 0;
+	out_sample->hand_pose = hh->hand_poses[slot];
+	out_sample->root = hh->roots[slot];
+
+	size_t first = (size_t)slot * JOINT_COUNT;
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		out_sample->local_poses[i] = hh->local_poses[first + i];
+		out_sample->radii[i] = hh->radii[first + i];
+		out_sample->flags[i] = hh->flags[first + i];
+	}
+}
+
+static FindResult
+find_samples(const struct m_hand_history *hh,
+             uint64_t at_timestamp_ns,
+             struct hand_sample *out_a,
+             struct hand_sample *out_b)
+{
+	FindResult result;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&hh->lock);
+
+		uint32_t size = get_size_unsafe(hh);
+		if (size == 0) {
+			result = FindResult::Empty;
+			continue;
+		}
+
+		// Find the first entry *not less than* our time, only touches the timestamps.
+		uint32_t low = 0;
+		uint32_t high = size;
+		while (low < high) {
+			uint32_t mid = low + (high - low) / 2;
+			if (hh->timestamps[get_slot_unsafe(hh, mid)] < at_timestamp_ns) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+
+		if (low == size) {
+			read_sample_unsafe(hh, get_slot_unsafe(hh, size - 1), out_a);
+			result = FindResult::After;
+		} else {
+			read_sample_unsafe(hh, get_slot_unsafe(hh, low), out_b);
+			if (out_b->timestamp == at_timestamp_ns) {
+				result = FindResult::Exact;
+			} else if (low == 0) {
+				result = FindResult::Before;
+			} else {
+				read_sample_unsafe(hh, get_slot_unsafe(hh, low - 1), out_a);
+				result = FindResult::Between;
+			}
+		}
+	} while (u_seqlock_read_retry(&hh->lock, seq));
+
+	return result;
+}
+
+//! Fills in the root velocities from the previous root, if they are missing.
+static void
+estimate_root_motion(const struct xrt_space_relation *last_root,
+                     uint64_t last_timestamp_ns,
+                     uint64_t timestamp_ns,
+                     struct xrt_space_relation *inout_root)
+{
+	enum xrt_space_relation_flags &flags = inout_root->relation_flags;
+	enum xrt_space_relation_flags both =
+	    (enum xrt_space_relation_flags)(last_root->relation_flags & inout_root->relation_flags);
+
+	float dt = (float)time_ns_to_s((int64_t)(timestamp_ns - last_timestamp_ns));
+
+	if ((flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0 &&
+	    (both & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0) {
+		inout_root->linear_velocity = (inout_root->pose.position - last_root->pose.position) / dt;
+		flags = (enum xrt_space_relation_flags)(flags | XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+	}
+
+	if ((flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) == 0 &&
+	    (both & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0) {
+		math_quat_finite_difference(&last_root->pose.orientation, &inout_root->pose.orientation, dt,
+		                            &inout_root->angular_velocity);
+		flags = (enum xrt_space_relation_flags)(flags | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+	}
+}
+
+static void
+interpolate_relation(const struct xrt_space_relation *a,
+                     const struct xrt_space_relation *b,
+                     float t,
+                     struct xrt_space_relation *out_rel)
+{
+	struct xrt_space_relation result = XRT_SPACE_RELATION_ZERO;
+	result.relation_flags = (enum xrt_space_relation_flags)(a->relation_flags & b->relation_flags);
+
+	if ((result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0) {
+		result.pose.position = m_vec3_lerp(a->pose.position, b->pose.position, t);
+	}
+	if ((result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0) {
+		math_quat_slerp(&a->pose.orientation, &b->pose.orientation, t, &result.pose.orientation);
+	}
+	if ((result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0) {
+		result.linear_velocity = m_vec3_lerp(a->linear_velocity, b->linear_velocity, t);
+	}
+	if ((result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0) {
+		result.angular_velocity = m_vec3_lerp(a->angular_velocity, b->angular_velocity, t);
+	}
+
+	*out_rel = result;
+}
+
+//! Result is written into @p a, the joints are interpolated in the root's space.
+static void
+interpolate_sample(struct hand_sample *a, const struct hand_sample *b, float t)
+{
+	interpolate_relation(&a->hand_pose, &b->hand_pose, t, &a->hand_pose);
+	interpolate_relation(&a->root, &b->root, t, &a->root);
+
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		struct xrt_pose *pose = &a->local_poses[i];
+		const struct xrt_pose *other = &b->local_poses[i];
+
+		pose->position = m_vec3_lerp(pose->position, other->position, t);
+		math_quat_slerp(&pose->orientation, &other->orientation, t, &pose->orientation);
+
+		a->radii[i] = a->radii[i] * (1.f - t) + b->radii[i] * t;
+		a->flags[i] = (enum xrt_space_relation_flags)(a->flags[i] & b->flags[i]);
+	}
+}
+
+//! Turns the local joints back into a full joint set.
+static void
+sample_to_set(const struct hand_sample *sample, struct xrt_hand_joint_set *out_set)
+{
+	struct xrt_pose poses[JOINT_COUNT];
+	math_pose_transform_batch(&sample->root.pose, sample->local_poses, JOINT_COUNT, poses);
+
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		struct xrt_hand_joint_value *joint = &out_set->values.hand_joint_set_default[i];
+
+		joint->relation = XRT_SPACE_RELATION_ZERO;
+		joint->relation.relation_flags = (enum xrt_space_relation_flags)(sample->flags[i] & ~velocity_flags);
+		joint->relation.pose = poses[i];
+		joint->radius = sample->radii[i];
+	}
+
+	// The wrist is the root and keeps its velocities.
+	struct xrt_hand_joint_value *wrist = &out_set->values.hand_joint_set_default[XRT_HAND_JOINT_WRIST];
+	wrist->relation = sample->root;
+
+	out_set->hand_pose = sample->hand_pose;
+	out_set->is_active = sample->active;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+m_hand_history_create(struct m_hand_history **hh_ptr, uint32_t capacity)
+{
+	if (capacity == 0) {
+		capacity = M_HAND_HISTORY_DEFAULT_CAPACITY;
+	}
+
+	auto ret = std::make_unique<m_hand_history>();
+	ret->capacity = capacity;
+	ret->timestamps.resize(capacity);
+	ret->active.resize(capacity);
+	ret->hand_poses.resize(capacity);
+	ret->roots.resize(capacity);
+	ret->local_poses.resize((size_t)capacity * JOINT_COUNT);
+	ret->radii.resize((size_t)capacity * JOINT_COUNT);
+	ret->flags.resize((size_t)capacity * JOINT_COUNT);
+	*hh_ptr = ret.release();
+}
+
+bool
+m_hand_history_push(struct m_hand_history *hh, const struct xrt_hand_joint_set *in_set, uint64_t timestamp_ns)
+{
+	XRT_TRACE_MARKER();
+
+	const struct xrt_hand_joint_value *joints = in_set->values.hand_joint_set_default;
+	struct xrt_space_relation root = joints[XRT_HAND_JOINT_WRIST].relation;
+
+	std::unique_lock<os::Mutex> lock(hh->write_mutex);
+
+	// Only writers change the arrays and we hold the mutex, so no need to go through the seqlock here.
+	if (hh->count > 0) {
+		uint32_t newest = (uint32_t)((hh->count - 1) % hh->capacity);
+		if (timestamp_ns <= hh->timestamps[newest]) {
+			return false;
+		}
+
+		estimate_root_motion(&hh->roots[newest], hh->timestamps[newest], timestamp_ns, &root);
+	}
+
+	// Do the transforms before taking the seqlock, keeps readers from retrying.
+	struct xrt_pose root_inv;
+	math_pose_invert(&root.pose, &root_inv);
+
+	struct xrt_pose poses[JOINT_COUNT];
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		poses[i] = joints[i].relation.pose;
+	}
+	math_pose_transform_batch(&root_inv, poses, JOINT_COUNT, poses);
+
+	uint32_t slot = (uint32_t)(hh->count % hh->capacity);
+	size_t first = (size_t)slot * JOINT_COUNT;
+
+	u_seqlock_write_begin(&hh->lock);
+
+	hh->timestamps[slot] = timestamp_ns;
+	hh->active[slot] = in_set->is_active ? 1 : 0;
+	hh->hand_poses[slot] = in_set->hand_pose;
+	hh->roots[slot] = root;
+
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		hh->local_poses[first + i] = poses[i];
+		hh->radii[first + i] = joints[i].radius;
+		hh->flags[first + i] = joints[i].relation.relation_flags;
+	}
+
+	hh->count++;
+
+	u_seqlock_write_end(&hh->lock);
+
+	return true;
+}
+
+enum m_relation_history_result
+m_hand_history_get(const struct m_hand_history *hh,
+                   uint64_t at_timestamp_ns,
+                   struct xrt_hand_joint_set *out_set,
+                   uint64_t *out_timestamp_ns)
+{
+	XRT_TRACE_MARKER();
+
+	struct hand_sample a;
+	struct hand_sample b;
+
+	FindResult found = FindResult::Empty;
+	if (at_timestamp_ns != 0) {
+		found = find_samples(hh, at_timestamp_ns, &a, &b);
+	}
+
+	switch (found) {
+	case FindResult::Empty: {
+		*out_set = {};
+		*out_timestamp_ns = 0;
+		return M_RELATION_HISTORY_RESULT_INVALID;
+	}
+	case FindResult::Exact: {
+		sample_to_set(&b, out_set);
+		*out_timestamp_ns = b.timestamp;
+		return M_RELATION_HISTORY_RESULT_EXACT;
+	}
+	case FindResult::Before: {
+		// Asking for something older than we have, only happens with tiny histories.
+		sample_to_set(&b, out_set);
+		*out_timestamp_ns = b.timestamp;
+		return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+	}
+	case FindResult::After: {
+		uint64_t delta_ns = at_timestamp_ns - a.timestamp;
+		bool too_far = delta_ns > M_HAND_HISTORY_MAX_PREDICTION_NS;
+		if (too_far) {
+			delta_ns = M_HAND_HISTORY_MAX_PREDICTION_NS;
+		}
+
+		double delta_s = time_ns_to_s((int64_t)delta_ns);
+		U_LOG_T("Predicting hand %f s past the newest entry", delta_s);
+
+		// Move the whole hand with the root, the fingers keep their pose.
+		m_predict_relation(&a.root, delta_s, &a.root);
+		sample_to_set(&a, out_set);
+
+		// The hand hasn't been seen for too long, don't pretend we know where it is.
+		if (too_far) {
+			for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+				struct xrt_space_relation *rel = &out_set->values.hand_joint_set_default[i].relation;
+				rel->relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
+			}
+			out_set->is_active = false;
+		}
+
+		*out_timestamp_ns = at_timestamp_ns;
+		return M_RELATION_HISTORY_RESULT_PREDICTED;
+	}
+	case FindResult::Between: break;
+	}
+
+	uint64_t diff_before = at_timestamp_ns - a.timestamp;
+	uint64_t diff_after = b.timestamp - at_timestamp_ns;
+
+	// Can't interpolate to or from a hand that wasn't seen, use the closest one.
+	if (!a.active || !b.active) {
+		const struct hand_sample *closest = diff_before <= diff_after ? &a : &b;
+		sample_to_set(closest, out_set);
+		*out_timestamp_ns = closest->timestamp;
+		return diff_before <= diff_after ? M_RELATION_HISTORY_RESULT_PREDICTED
+		                                 : M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+	}
+
+	float t = (float)((double)diff_before / (double)(diff_before + diff_after));
+
+	interpolate_sample(&a, &b, t);
+	sample_to_set(&a, out_set);
+	*out_timestamp_ns = at_timestamp_ns;
+
+	return M_RELATION_HISTORY_RESULT_INTERPOLATED;
+}
+
+bool
+m_hand_history_get_latest(const struct m_hand_history *hh,
+                          uint64_t *out_timestamp_ns,
+                          struct xrt_hand_joint_set *out_set)
+{
+	struct hand_sample sample;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&hh->lock);
+		if (hh->count == 0) {
+			return false;
+		}
+		read_sample_unsafe(hh, (uint32_t)((hh->count - 1) % hh->capacity), &sample);
+	} while (u_seqlock_read_retry(&hh->lock, seq));
+
+	sample_to_set(&sample, out_set);
+	*out_timestamp_ns = sample.timestamp;
+
+	return true;
+}
+
+uint32_t
+m_hand_history_get_size(const struct m_hand_history *hh)
+{
+	uint32_t size;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&hh->lock);
+		size = get_size_unsafe(hh);
+	} while (u_seqlock_read_retry(&hh->lock, seq));
+
+	return size;
+}
+
+void
+m_hand_history_clear(struct m_hand_history *hh)
+{
+	std::unique_lock<os::Mutex> lock(hh->write_mutex);
+
+	u_seqlock_write_begin(&hh->lock);
+	hh->count = 0;
+	u_seqlock_write_end(&hh->lock);
+}
+
+void
+m_hand_history_destroy(struct m_hand_history **hh_ptr)
+{
+	struct m_hand_history *hh = *hh_ptr;
+	if (hh == NULL) {
+		return;
+	}
+
+	delete hh;
+	*hh_ptr = NULL;
+}
@@ -0,0 +1,136 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Keeps track of the history of a hand's joints, for interpolating
+ *         between tracker samples and predicting past the newest one.
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "math/m_relation_history.h"
+#include "util/u_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Opaque type for storing the history of a @ref xrt_hand_joint_set in a ring
+ * buffer, fixed in size at creation.
+ *
+ * The joints are stored relative to the wrist, that is the root of the hand.
+ * Getting a set between two entries interpolates the root pose, then slerps
+ * the local joint orientations and lerps their local positions. Past the
+ * newest entry only the root is predicted, with constant velocity, the pose
+ * of the fingers is kept, and no further than
+ * @ref M_HAND_HISTORY_MAX_PREDICTION_NS.
+ *
+ * Each field is kept in its own array, so finding entries only walks the
+ * timestamps and the joints are only touched for the two entries used.
+ *
+ * Like @ref m_relation_history this is thread safe, readers never block and
+ * retry if a push happened while they were reading.
+ *
+ * @ingroup aux_math
+ */
+struct m_hand_history;
+
+//! Default capacity of a hand history, over two seconds at 30 Hz.
+#define M_HAND_HISTORY_DEFAULT_CAPACITY (64)
+
+/*!
+ * How far past the newest entry a hand is predicted, asking for later than
+ * this returns a hand that isn't active and has no valid joints.
+ */
+#define M_HAND_HISTORY_MAX_PREDICTION_NS (100 * U_TIME_1MS_IN_NS)
+
+/*!
+ * Creates a hand history.
+ *
+ * @param[out] hh_ptr   Created history.
+ * @param      capacity Number of joint sets kept, zero means the default.
+ *
+ * @public @memberof m_hand_history
+ */
+void
+m_hand_history_create(struct m_hand_history **hh_ptr, uint32_t capacity);
+
+/*!
+ * Pushes a new joint set to the history, replacing the oldest one when full.
+ *
+ * If the wrist doesn't have valid velocities they are estimated from the
+ * previous entry, they are used to predict past the newest entry.
+ *
+ * @return false if the timestamp isn't newer than the newest entry.
+ *
+ * @public @memberof m_hand_history
+ */
+bool
+m_hand_history_push(struct m_hand_history *hh, const struct xrt_hand_joint_set *in_set, uint64_t timestamp_ns);
+
+/*!
+ * Interpolates or extrapolates the joint set to the given time.
+ *
+ * Joints other than the wrist don't have valid velocities in the returned set,
+ * if one of the entries interpolated between isn't active the closest one is
+ * returned as is. More than @ref M_HAND_HISTORY_MAX_PREDICTION_NS past the
+ * newest entry the set isn't active and none of the joints are valid.
+ *
+ * @param      hh               Self.
+ * @param      at_timestamp_ns  Time to get the hand at.
+ * @param[out] out_set          Resulting joint set, not active if the history is empty.
+ * @param[out] out_timestamp_ns Time of @p out_set, that of the entry if one was returned as is.
+ *
+ * @public @memberof m_hand_history
+ */
+enum m_relation_history_result
+m_hand_history_get(const struct m_hand_history *hh,
+                   uint64_t at_timestamp_ns,
+                   struct xrt_hand_joint_set *out_set,
+                   uint64_t *out_timestamp_ns);
+
+/*!
+ * Get the newest joint set in the history.
+ *
+ * @return false if the history is empty.
+ *
+ * @public @memberof m_hand_history
+ */
+bool
+m_hand_history_get_latest(const struct m_hand_history *hh,
+                          uint64_t *out_timestamp_ns,
+                          struct xrt_hand_joint_set *out_set);
+
+/*!
+ * Returns the number of joint sets in the history.
+ *
+ * @public @memberof m_hand_history
+ */
+uint32_t
+m_hand_history_get_size(const struct m_hand_history *hh);
+
+/*!
+ * Removes all joint sets from the history.
+ *
+ * @public @memberof m_hand_history
+ */
+void
+m_hand_history_clear(struct m_hand_history *hh);
+
+/*!
+ * Destroys a hand history, sets the pointer to NULL.
+ *
+ * @public @memberof m_hand_history
+ */
+void
+m_hand_history_destroy(struct m_hand_history **hh_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
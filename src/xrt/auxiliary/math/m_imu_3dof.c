@@ -226,6 +226,34 @@ gyro_biasing(struct m_imu_3dof *f, uint64_t timestamp_ns)
 	f->gyro_bias.value = gyro_mean;
 }
 
+/*!
+ * Rotate the orientation by the bias corrected gyro over @p dt seconds.
+ */
+static void
+integrate_gyro(struct m_imu_3dof *f, const struct xrt_vec3 *gyro_biased, float gyro_biased_length, double dt)
+{
+	if (gyro_biased_length <= 0.0001f) {
+		return;
+	}
+
+#if 0
+	math_quat_integrate_velocity(&f->rot, gyro_biased, dt, &f->rot);
+#else
+	struct xrt_vec3 rot_axis = {
+	    gyro_biased->x / gyro_biased_length,
+	    gyro_biased->y / gyro_biased_length,
+	    gyro_biased->z / gyro_biased_length,
+	};
+
+	float rot_angle = gyro_biased_length * (float)dt;
+
+	struct xrt_quat delta_orient;
+	math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
+
+	math_quat_rotate(&f->rot, &delta_orient, &f->rot);
+#endif
+}
+
 void
 m_imu_3dof_update(struct m_imu_3dof *f,
                   uint64_t timestamp_ns,
@@ -267,24 +295,7 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 	f->last.gyro_biased_length = gyro_biased_length;
 
 
-	if (gyro_biased_length > 0.0001f) {
-#if 0
-		math_quat_integrate_velocity(&f->rot, gyro, dt, &f->rot);
-#else
-		struct xrt_vec3 rot_axis = {
-		    gyro_biased.x / gyro_biased_length,
-		    gyro_biased.y / gyro_biased_length,
-		    gyro_biased.z / gyro_biased_length,
-		};
-
-		float rot_angle = gyro_biased_length * (float)dt;
-
-		struct xrt_quat delta_orient;
-		math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
-
-		math_quat_rotate(&f->rot, &delta_orient, &f->rot);
-#endif
-	}
+	integrate_gyro(f, &gyro_biased, gyro_biased_length, dt);
 
 	// Gravity correction.
 	gravity_correction(f, timestamp_ns, accel, &gyro_biased, dt, gyro_biased_length);
@@ -298,3 +309,78 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 	 */
 	math_quat_normalize(&f->rot);
 }
+
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count)
+{
+	uint32_t first = 0;
+
+	//! Skip the first sample.
+	if (count > 0 && f->state == M_IMU_3DOF_STATE_START) {
+		f->state = M_IMU_3DOF_STATE_RUNNING;
+		f->last.timestamp_ns = timestamps_ns[0];
+		first = 1;
+	}
+
+	if (first >= count) {
+		return;
+	}
+
+	uint64_t start_ns = f->last.timestamp_ns;
+	struct xrt_vec3 world_accel_sum = XRT_VEC3_ZERO;
+	struct xrt_vec3 accel_sum = XRT_VEC3_ZERO;
+	struct xrt_vec3 gyro_sum = XRT_VEC3_ZERO;
+
+	for (uint32_t i = first; i < count; i++) {
+		// This code assumes all timestamps makes some forward progress.
+		assert(timestamps_ns[i] >= f->last.timestamp_ns);
+
+		struct xrt_vec3 world_accel = {0};
+		math_quat_rotate_vec3(&f->rot, &accels[i], &world_accel);
+		math_vec3_accum(&world_accel, &world_accel_sum);
+		math_vec3_accum(&accels[i], &accel_sum);
+		math_vec3_accum(&gyros[i], &gyro_sum);
+
+		double dt = (double)(timestamps_ns[i] - f->last.timestamp_ns) / DUR_1S_IN_NS;
+		f->last.timestamp_ns = timestamps_ns[i];
+
+		struct xrt_vec3 gyro_biased = m_vec3_sub(gyros[i], f->gyro_bias.value);
+		integrate_gyro(f, &gyro_biased, m_vec3_len(gyro_biased), dt);
+	}
+
+	uint64_t timestamp_ns = f->last.timestamp_ns;
+	float inv_n = 1.0f / (float)(count - first);
+
+	struct xrt_vec3 world_accel_mean = m_vec3_mul_scalar(world_accel_sum, inv_n);
+	struct xrt_vec3 accel_mean = m_vec3_mul_scalar(accel_sum, inv_n);
+	struct xrt_vec3 gyro_mean = m_vec3_mul_scalar(gyro_sum, inv_n);
+
+	// The filters only ever produce means over time windows, so one mean sample per packet works the same.
+	m_ff_vec3_f32_push(f->word_accel_ff, &world_accel_mean, timestamp_ns);
+	m_ff_vec3_f32_push(f->gyro_ff, &gyro_mean, timestamp_ns);
+
+	double dt = (double)(timestamp_ns - start_ns) / DUR_1S_IN_NS;
+
+	struct xrt_vec3 gyro_biased = m_vec3_sub(gyro_mean, f->gyro_bias.value);
+	float gyro_biased_length = m_vec3_len(gyro_biased);
+
+	f->last.gyro = gyros[count - 1];
+	f->last.accel = accels[count - 1];
+	f->last.delta_ms = dt * 1000.0f;
+	f->last.accel_length = m_vec3_len(f->last.accel);
+	f->last.gyro_length = m_vec3_len(f->last.gyro);
+	f->last.gyro_biased_length = gyro_biased_length;
+
+	// Gravity correction, over the whole packet.
+	gravity_correction(f, timestamp_ns, &accel_mean, &gyro_biased, dt, gyro_biased_length);
+
+	// Gyro bias calculations.
+	gyro_biasing(f, timestamp_ns);
+
+	// Once per packet is enough to mitigate drift.
+	math_quat_normalize(&f->rot);
+}
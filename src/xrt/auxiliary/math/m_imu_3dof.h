@@ -90,6 +90,19 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro);
 
+/*!
+ * Update with a packet of @p count samples at once, for devices that deliver
+ * several readings per report. The gyro is integrated per sample, but the
+ * filter fifos get the mean of the packet and gravity and bias correction
+ * run once per call.
+ */
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count);
+
 
 #ifdef __cplusplus
 }
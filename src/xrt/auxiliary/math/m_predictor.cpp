@@ -0,0 +1,325 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pose predictor with selectable per-device motion models.
+ * @ingroup aux_math
+ */
+
+#include "m_predictor.h"
+
+#include "math/m_api.h"
+#include "math/m_predict.h"
+#include "math/m_vec3.h"
+#include "os/os_threading.h"
+#include "os/os_time.h"
+#include "util/u_time.h"
+#include "util/u_trace_marker.h"
+
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+namespace os = xrt::auxiliary::os;
+
+
+/*
+ *
+ * Defines and structs.
+ *
+ */
+
+//! How many IMU samples are kept, a second at 250 Hz, must be a power of two.
+#define IMU_SAMPLE_COUNT (256)
+
+/*!
+ * Velocities further apart than this don't give a meaningful acceleration,
+ * the estimate is reset instead.
+ */
+#define MAX_ACCELERATION_GAP_NS (100 * U_TIME_1MS_IN_NS)
+
+/*!
+ * The estimated acceleration is only applied this far into the future, after
+ * that the velocity is held. Keeps noise in the estimate from blowing up long
+ * predictions.
+ */
+#define MAX_ACCELERATION_HORIZON_S (0.1)
+
+//! How much of each new acceleration estimate is blended in.
+#define ACCELERATION_ALPHA (0.2f)
+
+struct imu_sample
+{
+	uint64_t timestamp_ns;
+	struct xrt_vec3 accel;
+	struct xrt_vec3 gyro;
+};
+
+struct m_predictor
+{
+	enum m_predictor_model model;
+
+	struct xrt_vec3 gravity_correction;
+
+	//! Guards everything below, only held to copy samples in and out.
+	os::Mutex mutex;
+
+	//! Number of samples pushed since creation or clear, the newest is at (imu_count - 1) % IMU_SAMPLE_COUNT.
+	uint64_t imu_count;
+	struct imu_sample imu[IMU_SAMPLE_COUNT];
+
+	bool have_last_velocity;
+	uint64_t last_velocity_timestamp_ns;
+	struct xrt_vec3 last_linear_velocity;
+
+	//! Filtered estimate, zero until two velocities close enough in time have been pushed.
+	struct xrt_vec3 linear_acceleration;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+clear_locked(struct m_predictor *p)
+{
+	p->imu_count = 0;
+	p->have_last_velocity = false;
+	p->last_velocity_timestamp_ns = 0;
+	p->last_linear_velocity = {};
+	p->linear_acceleration = {};
+}
+
+static void
+predict_constant_acceleration(struct m_predictor *p,
+                              const struct xrt_space_relation *rel,
+                              double delta_s,
+                              struct xrt_space_relation *out_rel)
+{
+	struct xrt_vec3 accel;
+	{
+		std::unique_lock<os::Mutex> lock(p->mutex);
+		accel = p->linear_acceleration;
+	}
+
+	struct xrt_space_relation base = *rel;
+	m_predict_relation(&base, delta_s, out_rel);
+
+	enum xrt_space_relation_flags flags = base.relation_flags;
+	bool valid_position = (flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0;
+	bool valid_linear_velocity = (flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0;
+	if (delta_s <= 0 || !valid_position || !valid_linear_velocity) {
+		return;
+	}
+
+	// Accelerate up to the horizon, then hold the velocity reached.
+	double accel_s = std::min(delta_s, MAX_ACCELERATION_HORIZON_S);
+	float accel_f = (float)accel_s;
+	float offset = accel_f * accel_f * 0.5f + accel_f * (float)(delta_s - accel_s);
+
+	out_rel->pose.position += accel * offset;
+	out_rel->linear_velocity += accel * accel_f;
+}
+
+static void
+predict_imu_integrated(struct m_predictor *p,
+                       const struct xrt_space_relation *rel,
+                       uint64_t rel_timestamp_ns,
+                       uint64_t at_timestamp_ns,
+                       struct xrt_space_relation *out_rel)
+{
+	struct imu_sample samples[IMU_SAMPLE_COUNT];
+	uint32_t sample_count = 0;
+
+	// Copy out the samples between the two timestamps, oldest first.
+	{
+		std::unique_lock<os::Mutex> lock(p->mutex);
+
+		uint64_t stored = std::min<uint64_t>(p->imu_count, IMU_SAMPLE_COUNT);
+		for (uint64_t i = p->imu_count - stored; i < p->imu_count; i++) {
+			const struct imu_sample &s = p->imu[i & (IMU_SAMPLE_COUNT - 1)];
+			if (s.timestamp_ns <= rel_timestamp_ns) {
+				continue;
+			}
+			if (s.timestamp_ns > at_timestamp_ns) {
+				break;
+			}
+			samples[sample_count++] = s;
+		}
+	}
+
+	struct xrt_space_relation integ = *rel;
+	uint64_t integ_timestamp_ns = rel_timestamp_ns;
+
+	enum xrt_space_relation_flags flags = integ.relation_flags;
+	bool valid_orientation = (flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0;
+	bool valid_position = (flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0;
+	bool valid_linear_velocity = (flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0;
+
+	if (!valid_orientation) {
+		sample_count = 0;
+	}
+
+	struct xrt_quat &o = integ.pose.orientation;
+	struct xrt_vec3 &pos = integ.pose.position;
+	struct xrt_vec3 &v = integ.linear_velocity;
+
+	for (uint32_t i = 0; i < sample_count; i++) {
+		const struct imu_sample &s = samples[i];
+		float dt = (float)time_ns_to_s((int64_t)(s.timestamp_ns - integ_timestamp_ns));
+		integ_timestamp_ns = s.timestamp_ns;
+
+		// Integrate the gyroscope, it is in body space.
+		struct xrt_quat delta;
+		struct xrt_vec3 scaled_half_gyro = s.gyro * (dt * 0.5f);
+		math_quat_exp(&scaled_half_gyro, &delta);
+		math_quat_rotate(&o, &delta, &o);
+		math_quat_normalize(&o);
+		math_quat_rotate_derivative(&o, &s.gyro, &integ.angular_velocity);
+
+		if (!valid_position || !valid_linear_velocity) {
+			continue;
+		}
+
+		// Integrate the accelerometer in tracking space.
+		struct xrt_vec3 world_accel;
+		math_quat_rotate_vec3(&o, &s.accel, &world_accel);
+		world_accel += p->gravity_correction;
+		pos += v * dt + world_accel * (dt * dt * 0.5f);
+		v += world_accel * dt;
+	}
+
+	if (sample_count > 0) {
+		integ.relation_flags = (enum xrt_space_relation_flags)(flags | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+	}
+
+	// The rest of the way with constant velocity.
+	double delta_s = time_ns_to_s((int64_t)(at_timestamp_ns - integ_timestamp_ns));
+	m_predict_relation(&integ, delta_s, out_rel);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" void
+m_predictor_create(struct m_predictor **out_p,
+                   enum m_predictor_model model,
+                   const struct xrt_vec3 *gravity_correction)
+{
+	auto ret = std::make_unique<m_predictor>();
+	ret->model = model;
+	if (gravity_correction != NULL) {
+		ret->gravity_correction = *gravity_correction;
+	} else {
+		ret->gravity_correction = {0.0f, (float)-MATH_GRAVITY_M_S2, 0.0f};
+	}
+	clear_locked(ret.get());
+	*out_p = ret.release();
+}
+
+extern "C" void
+m_predictor_push_imu(struct m_predictor *p,
+                     uint64_t timestamp_ns,
+                     const struct xrt_vec3 *accel,
+                     const struct xrt_vec3 *gyro)
+{
+	if (p->model != M_PREDICTOR_MODEL_IMU_INTEGRATED) {
+		return;
+	}
+
+	std::unique_lock<os::Mutex> lock(p->mutex);
+
+	if (p->imu_count > 0 && timestamp_ns <= p->imu[(p->imu_count - 1) & (IMU_SAMPLE_COUNT - 1)].timestamp_ns) {
+		return;
+	}
+
+	struct imu_sample &s = p->imu[p->imu_count & (IMU_SAMPLE_COUNT - 1)];
+	s.timestamp_ns = timestamp_ns;
+	s.accel = *accel;
+	s.gyro = *gyro;
+	p->imu_count++;
+}
+
+extern "C" void
+m_predictor_push_relation(struct m_predictor *p, const struct xrt_space_relation *rel, uint64_t timestamp_ns)
+{
+	if (p->model != M_PREDICTOR_MODEL_CONSTANT_ACCELERATION) {
+		return;
+	}
+
+	std::unique_lock<os::Mutex> lock(p->mutex);
+
+	if ((rel->relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0) {
+		p->have_last_velocity = false;
+		p->linear_acceleration = {};
+		return;
+	}
+
+	if (p->have_last_velocity && timestamp_ns <= p->last_velocity_timestamp_ns) {
+		return;
+	}
+
+	if (p->have_last_velocity && timestamp_ns - p->last_velocity_timestamp_ns <= MAX_ACCELERATION_GAP_NS) {
+		float dt = (float)time_ns_to_s((int64_t)(timestamp_ns - p->last_velocity_timestamp_ns));
+		struct xrt_vec3 accel = (rel->linear_velocity - p->last_linear_velocity) / dt;
+		p->linear_acceleration += (accel - p->linear_acceleration) * ACCELERATION_ALPHA;
+	} else {
+		p->linear_acceleration = {};
+	}
+
+	p->have_last_velocity = true;
+	p->last_velocity_timestamp_ns = timestamp_ns;
+	p->last_linear_velocity = rel->linear_velocity;
+}
+
+extern "C" void
+m_predictor_predict(struct m_predictor *p,
+                    const struct xrt_space_relation *rel,
+                    uint64_t rel_timestamp_ns,
+                    uint64_t at_timestamp_ns,
+                    struct xrt_space_relation *out_rel)
+{
+	XRT_TRACE_MARKER();
+
+	double delta_s = time_ns_to_s((int64_t)at_timestamp_ns - (int64_t)rel_timestamp_ns);
+
+	switch (p->model) {
+	case M_PREDICTOR_MODEL_CONSTANT_ACCELERATION: predict_constant_acceleration(p, rel, delta_s, out_rel); return;
+	case M_PREDICTOR_MODEL_IMU_INTEGRATED:
+		if (at_timestamp_ns > rel_timestamp_ns) {
+			predict_imu_integrated(p, rel, rel_timestamp_ns, at_timestamp_ns, out_rel);
+			return;
+		}
+		break;
+	case M_PREDICTOR_MODEL_CONSTANT_VELOCITY: break;
+	}
+
+	struct xrt_space_relation base = *rel;
+	m_predict_relation(&base, delta_s, out_rel);
+}
+
+extern "C" void
+m_predictor_clear(struct m_predictor *p)
+{
+	std::unique_lock<os::Mutex> lock(p->mutex);
+	clear_locked(p);
+}
+
+extern "C" void
+m_predictor_destroy(struct m_predictor **ptr_p)
+{
+	struct m_predictor *p = *ptr_p;
+	if (p == NULL) {
+		return;
+	}
+
+	delete p;
+	*ptr_p = NULL;
+}
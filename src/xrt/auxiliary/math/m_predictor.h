@@ -0,0 +1,132 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Pose predictor with selectable per-device motion models.
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * @brief Opaque pose predictor, keeps the recent samples a motion model needs
+ * to predict a relation into the future.
+ *
+ * Thread safe, samples can be pushed from the driver thread while other
+ * threads predict.
+ *
+ * @ingroup aux_math
+ */
+struct m_predictor;
+
+/*!
+ * @brief Which motion model a @ref m_predictor uses, listed from cheapest to
+ * most expensive.
+ *
+ * @relates m_predictor
+ */
+enum m_predictor_model
+{
+	/*!
+	 * Constant linear and angular velocity, exactly what
+	 * @ref m_predict_relation does, no samples needed.
+	 */
+	M_PREDICTOR_MODEL_CONSTANT_VELOCITY = 0,
+
+	/*!
+	 * Constant angular velocity and constant linear acceleration, the
+	 * acceleration is estimated from the linear velocities of the
+	 * relations given to @ref m_predictor_push_relation.
+	 */
+	M_PREDICTOR_MODEL_CONSTANT_ACCELERATION,
+
+	/*!
+	 * Integrates the IMU samples given to @ref m_predictor_push_imu that
+	 * are newer than the relation predicted from, then predicts the rest
+	 * of the way with constant velocity. Falls back to constant velocity
+	 * if there are no such samples.
+	 */
+	M_PREDICTOR_MODEL_IMU_INTEGRATED,
+};
+
+/*!
+ * Creates a predictor.
+ *
+ * @param[out] out_p Created predictor.
+ * @param model Motion model to use.
+ * @param gravity_correction Added to the accelerometer samples once rotated
+ *                           into the tracking space, NULL means the standard
+ *                           gravity along -Y. Only used by the IMU model.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_create(struct m_predictor **out_p,
+                   enum m_predictor_model model,
+                   const struct xrt_vec3 *gravity_correction);
+
+/*!
+ * Gives an IMU sample to the predictor, ignored unless the model is
+ * @ref M_PREDICTOR_MODEL_IMU_INTEGRATED. Both @p accel and @p gyro are in the
+ * same frame as the pose of the predicted relations, samples older than the
+ * newest one pushed are dropped.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_push_imu(struct m_predictor *p,
+                     uint64_t timestamp_ns,
+                     const struct xrt_vec3 *accel,
+                     const struct xrt_vec3 *gyro);
+
+/*!
+ * Gives a tracked relation to the predictor, ignored unless the model is
+ * @ref M_PREDICTOR_MODEL_CONSTANT_ACCELERATION.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_push_relation(struct m_predictor *p, const struct xrt_space_relation *rel, uint64_t timestamp_ns);
+
+/*!
+ * Predicts @p rel, the relation at @p rel_timestamp_ns, to @p at_timestamp_ns.
+ * Output flags are the same as the input flags. OK to alias @p rel and
+ * @p out_rel.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_predict(struct m_predictor *p,
+                    const struct xrt_space_relation *rel,
+                    uint64_t rel_timestamp_ns,
+                    uint64_t at_timestamp_ns,
+                    struct xrt_space_relation *out_rel);
+
+/*!
+ * Drops all samples, for when tracking is lost or reset.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_clear(struct m_predictor *p);
+
+/*!
+ * Destroys a predictor and sets the pointer to NULL.
+ *
+ * @public @memberof m_predictor
+ */
+void
+m_predictor_destroy(struct m_predictor **ptr_p);
+
+
+#ifdef __cplusplus
+}
+#endif
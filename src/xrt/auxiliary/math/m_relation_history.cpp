@@ -14,15 +14,17 @@
 
 #include "math/m_api.h"
 #include "math/m_predict.h"
+#include "math/m_predictor.h"
 #include "math/m_vec3.h"
 #include "os/os_time.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 #include "xrt/xrt_defines.h"
 #include "os/os_threading.h"
-#include "util/u_template_historybuf.hpp"
+#include "util/u_seqlock.h"
 
 #include <memory>
+#include <vector>
 #include <algorithm>
 #include <cstring>
 #include <stdio.h>
@@ -31,7 +33,6 @@
 #include <assert.h>
 #include <mutex>
 
-using namespace xrt::auxiliary::util;
 namespace os = xrt::auxiliary::os;
 
 struct relation_history_entry
@@ -40,22 +41,182 @@ struct relation_history_entry
 	uint64_t timestamp;
 };
 
-static constexpr size_t BufLen = 4096;
-
+/*!
+ * Readers never take a lock, they copy what they need out of the ring and
+ * retry if the writer touched it meanwhile. Writers are serialised with a
+ * mutex, normally there is only the driver thread pushing so it is never
+ * contended.
+ */
 struct m_relation_history
 {
-	HistoryBuffer<struct relation_history_entry, BufLen> impl;
-	mutable os::Mutex mutex;
+	//! Guards @ref count and @ref entries.
+	struct u_seqlock lock;
+
+	//! Number of entries pushed since creation or clear, the newest is at (count - 1) % capacity.
+	uint64_t count;
+
+	//! Fixed at creation, never resized.
+	std::vector<struct relation_history_entry> entries;
+
+	enum m_relation_history_interpolation interpolation;
+
+	//! Optional, not owned, used to predict past the newest entry.
+	struct m_predictor *predictor;
+
+	//! Only taken by writers.
+	os::Mutex write_mutex;
+};
+
+/*!
+ * What @ref find_entries found, the entries to use are copied out of the ring
+ * so the math can be done outside of the read section.
+ */
+enum class FindResult
+{
+	Empty,
+	Exact,
+	After,
+	Before,
+	Between,
 };
 
+static inline uint32_t
+get_size_unsafe(const struct m_relation_history *rh)
+{
+	return (uint32_t)std::min<uint64_t>(rh->count, rh->entries.size());
+}
+
+static inline const struct relation_history_entry &
+get_newest_unsafe(const struct m_relation_history *rh)
+{
+	return rh->entries[(rh->count - 1) % rh->entries.size()];
+}
+
+//! Entry @p index counted from the oldest one.
+static inline const struct relation_history_entry &
+get_entry_unsafe(const struct m_relation_history *rh, uint32_t index)
+{
+	uint64_t first = rh->count - get_size_unsafe(rh);
+	return rh->entries[(first + index) % rh->entries.size()];
+}
+
+/*!
+ * Cubic Hermite spline between two entries that both have valid positions and
+ * linear velocities, also gives the velocity at that point on the curve.
+ */
+static void
+interpolate_hermite(const struct relation_history_entry &a,
+                    const struct relation_history_entry &b,
+                    float t,
+                    struct xrt_vec3 *out_position,
+                    struct xrt_vec3 *out_linear_velocity)
+{
+	float dt = (float)time_ns_to_s((int64_t)(b.timestamp - a.timestamp));
+
+	const struct xrt_vec3 &p0 = a.relation.pose.position;
+	const struct xrt_vec3 &p1 = b.relation.pose.position;
+	// Tangents are scaled to the interval, the spline is over t in [0, 1].
+	struct xrt_vec3 m0 = a.relation.linear_velocity * dt;
+	struct xrt_vec3 m1 = b.relation.linear_velocity * dt;
+
+	float t2 = t * t;
+	float t3 = t2 * t;
+
+	float h00 = 2 * t3 - 3 * t2 + 1;
+	float h10 = t3 - 2 * t2 + t;
+	float h01 = -2 * t3 + 3 * t2;
+	float h11 = t3 - t2;
+
+	*out_position = p0 * h00 + m0 * h10 + p1 * h01 + m1 * h11;
+
+	// Derivatives of the basis functions.
+	float d00 = 6 * t2 - 6 * t;
+	float d10 = 3 * t2 - 4 * t + 1;
+	float d01 = -6 * t2 + 6 * t;
+	float d11 = 3 * t2 - 2 * t;
+
+	*out_linear_velocity = (p0 * d00 + m0 * d10 + p1 * d01 + m1 * d11) / dt;
+}
+
+static FindResult
+find_entries(const struct m_relation_history *rh,
+             uint64_t at_timestamp_ns,
+             struct relation_history_entry *out_a,
+             struct relation_history_entry *out_b)
+{
+	FindResult result;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&rh->lock);
+
+		uint32_t size = get_size_unsafe(rh);
+		if (size == 0) {
+			result = FindResult::Empty;
+			continue;
+		}
+
+		// Find the first element *not less than* our value.
+		uint32_t low = 0;
+		uint32_t high = size;
+		while (low < high) {
+			uint32_t mid = low + (high - low) / 2;
+			if (get_entry_unsafe(rh, mid).timestamp < at_timestamp_ns) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+
+		if (low == size) {
+			*out_a = get_entry_unsafe(rh, size - 1);
+			result = FindResult::After;
+		} else {
+			*out_b = get_entry_unsafe(rh, low);
+			if (out_b->timestamp == at_timestamp_ns) {
+				result = FindResult::Exact;
+			} else if (low == 0) {
+				result = FindResult::Before;
+			} else {
+				*out_a = get_entry_unsafe(rh, low - 1);
+				result = FindResult::Between;
+			}
+		}
+	} while (u_seqlock_read_retry(&rh->lock, seq));
+
+	return result;
+}
+
 
 void
 m_relation_history_create(struct m_relation_history **rh_ptr)
 {
+	m_relation_history_create_with_params(rh_ptr, M_RELATION_HISTORY_DEFAULT_CAPACITY,
+	                                       M_RELATION_HISTORY_INTERPOLATION_LINEAR);
+}
+
+void
+m_relation_history_create_with_params(struct m_relation_history **rh_ptr,
+                                      uint32_t capacity,
+                                      enum m_relation_history_interpolation interpolation)
+{
+	if (capacity == 0) {
+		capacity = M_RELATION_HISTORY_DEFAULT_CAPACITY;
+	}
+
 	auto ret = std::make_unique<m_relation_history>();
+	ret->entries.resize(capacity);
+	ret->interpolation = interpolation;
 	*rh_ptr = ret.release();
 }
 
+void
+m_relation_history_set_predictor(struct m_relation_history *rh, struct m_predictor *predictor)
+{
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+	rh->predictor = predictor;
+}
+
 bool
 m_relation_history_push(struct m_relation_history *rh, struct xrt_space_relation const *in_relation, uint64_t timestamp)
 {
@@ -63,21 +224,26 @@ m_relation_history_push(struct m_relation_history *rh, struct xrt_space_relation
 	struct relation_history_entry rhe;
 	rhe.relation = *in_relation;
 	rhe.timestamp = timestamp;
-	bool ret = false;
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	try {
-		// if we aren't empty, we can compare against the latest timestamp.
-		if (rh->impl.empty() || rhe.timestamp > rh->impl.back().timestamp) {
-			// Everything explodes if the timestamps in relation_history aren't monotonically increasing. If
-			// we get a timestamp that's before the most recent timestamp in the buffer, don't put it
-			// in the history.
-			rh->impl.push_back(rhe);
-			ret = true;
-		}
-	} catch (std::exception const &e) {
-		U_LOG_E("Caught exception: %s", e.what());
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+
+	// Only writers change the ring and we hold the mutex, so no need to go through the seqlock here.
+	// Everything explodes if the timestamps in relation_history aren't monotonically increasing. If
+	// we get a timestamp that's before the most recent timestamp in the buffer, don't put it
+	// in the history.
+	if (rh->count > 0 && rhe.timestamp <= get_newest_unsafe(rh).timestamp) {
+		return false;
+	}
+
+	u_seqlock_write_begin(&rh->lock);
+	rh->entries[rh->count % rh->entries.size()] = rhe;
+	rh->count++;
+	u_seqlock_write_end(&rh->lock);
+
+	if (rh->predictor != NULL) {
+		m_predictor_push_relation(rh->predictor, in_relation, timestamp);
 	}
-	return ret;
+
+	return true;
 }
 
 enum m_relation_history_result
@@ -86,98 +252,104 @@ m_relation_history_get(const struct m_relation_history *rh,
                        struct xrt_space_relation *out_relation)
 {
 	XRT_TRACE_MARKER();
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	try {
-		if (rh->impl.empty() || at_timestamp_ns == 0) {
-			// Do nothing. You push nothing to the buffer you get nothing from the buffer.
-			*out_relation = {};
-			return M_RELATION_HISTORY_RESULT_INVALID;
-		}
-		const auto b = rh->impl.begin();
-		const auto e = rh->impl.end();
-
-		// Find the first element *not less than* our value. the lambda we pass is the comparison
-		// function, to compare against timestamps.
-		const auto it =
-		    std::lower_bound(b, e, at_timestamp_ns, [](const relation_history_entry &rhe, uint64_t timestamp) {
-			    return rhe.timestamp < timestamp;
-		    });
-
-		if (it == e) {
-			// lower bound is at the end:
-			// The desired timestamp is after what our buffer contains.
-			// (pose-prediction)
-			// Output flags match the most recent buffer entry.
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.back().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-
-			U_LOG_T("Extrapolating %f s past the back of the buffer!", delta_s);
-
-			m_predict_relation(&rh->impl.back().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_PREDICTED;
-		}
-		if (at_timestamp_ns == it->timestamp) {
-			// exact match:
-			// Flags copied directly along with everything else.
-			U_LOG_T("Exact match in the buffer!");
-			*out_relation = it->relation;
-			return M_RELATION_HISTORY_RESULT_EXACT;
-		}
-		if (it == b) {
-			// lower bound is at the beginning (and it's not an exact match):
-			// The desired timestamp is before what our buffer contains.
-			// (an edge case where somebody asks for a really old pose and we do our best)
-			// Output flags are the same as the input flags for the history entry we use
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.front().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-			U_LOG_T("Extrapolating %f s before the front of the buffer!", delta_s);
-			m_predict_relation(&rh->impl.front().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+
+	if (at_timestamp_ns == 0) {
+		*out_relation = {};
+		return M_RELATION_HISTORY_RESULT_INVALID;
+	}
+
+	struct relation_history_entry predecessor;
+	struct relation_history_entry successor;
+	FindResult found = find_entries(rh, at_timestamp_ns, &predecessor, &successor);
+
+	switch (found) {
+	case FindResult::Empty: {
+		// Do nothing. You push nothing to the buffer you get nothing from the buffer.
+		*out_relation = {};
+		return M_RELATION_HISTORY_RESULT_INVALID;
+	}
+	case FindResult::After: {
+		// lower bound is at the end:
+		// The desired timestamp is after what our buffer contains.
+		// (pose-prediction)
+		// Output flags match the most recent buffer entry.
+		int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
+		double delta_s = time_ns_to_s(diff_prediction_ns);
+
+		U_LOG_T("Extrapolating %f s past the back of the buffer!", delta_s);
+
+		if (rh->predictor != NULL) {
+			m_predictor_predict(rh->predictor, &predecessor.relation, predecessor.timestamp, at_timestamp_ns,
+			                    out_relation);
+		} else {
+			m_predict_relation(&predecessor.relation, delta_s, out_relation);
 		}
-		U_LOG_T("Interpolating within buffer!");
+		return M_RELATION_HISTORY_RESULT_PREDICTED;
+	}
+	case FindResult::Exact: {
+		// exact match:
+		// Flags copied directly along with everything else.
+		U_LOG_T("Exact match in the buffer!");
+		*out_relation = successor.relation;
+		return M_RELATION_HISTORY_RESULT_EXACT;
+	}
+	case FindResult::Before: {
+		// lower bound is at the beginning (and it's not an exact match):
+		// The desired timestamp is before what our buffer contains.
+		// (an edge case where somebody asks for a really old pose and we do our best)
+		// Output flags are the same as the input flags for the history entry we use
+		int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - successor.timestamp;
+		double delta_s = time_ns_to_s(diff_prediction_ns);
+		U_LOG_T("Extrapolating %f s before the front of the buffer!", delta_s);
+		m_predict_relation(&successor.relation, delta_s, out_relation);
+		return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+	}
+	case FindResult::Between: break;
+	}
 
-		// We precede *it and follow *(it - 1) (which we know exists because we already handled
-		// the it = begin() case)
-		const auto &predecessor = *(it - 1);
-		const auto &successor = *it;
+	U_LOG_T("Interpolating within buffer!");
 
-		// Do the thing.
-		int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
-		int64_t diff_after = static_cast<int64_t>(successor.timestamp) - at_timestamp_ns;
+	// Do the thing.
+	int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
+	int64_t diff_after = static_cast<int64_t>(successor.timestamp) - at_timestamp_ns;
 
-		float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
+	float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
 
-		// Copy intersection of relation flags
-		xrt_space_relation result{};
-		result.relation_flags = (enum xrt_space_relation_flags)(predecessor.relation.relation_flags &
-		                                                        successor.relation.relation_flags);
-		// First-order implementation - lerp between the before and after
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
-			result.pose.position = m_vec3_lerp(predecessor.relation.pose.position,
-			                                   successor.relation.pose.position, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
+	// Copy intersection of relation flags
+	xrt_space_relation result{};
+	result.relation_flags = (enum xrt_space_relation_flags)(predecessor.relation.relation_flags &
+	                                                        successor.relation.relation_flags);
+	const enum xrt_space_relation_flags hermite_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+	bool hermite = rh->interpolation == M_RELATION_HISTORY_INTERPOLATION_HERMITE &&
+	               (result.relation_flags & hermite_flags) == hermite_flags;
 
-			math_quat_slerp(&predecessor.relation.pose.orientation, &successor.relation.pose.orientation,
-			                amount_to_lerp, &result.pose.orientation);
-		}
+	if (hermite) {
+		// Third-order implementation - follow the velocities at both ends.
+		interpolate_hermite(predecessor, successor, amount_to_lerp, &result.pose.position,
+		                    &result.linear_velocity);
+	} else if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
+		// First-order implementation - lerp between the before and after
+		result.pose.position =
+		    m_vec3_lerp(predecessor.relation.pose.position, successor.relation.pose.position, amount_to_lerp);
+	}
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
 
-		//! @todo Does interpolating the velocities make any sense?
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
-			result.angular_velocity = m_vec3_lerp(predecessor.relation.angular_velocity,
-			                                      successor.relation.angular_velocity, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
-			result.linear_velocity = m_vec3_lerp(predecessor.relation.linear_velocity,
-			                                     successor.relation.linear_velocity, amount_to_lerp);
-		}
-		*out_relation = result;
-		return M_RELATION_HISTORY_RESULT_INTERPOLATED;
+		math_quat_slerp(&predecessor.relation.pose.orientation, &successor.relation.pose.orientation,
+		                amount_to_lerp, &result.pose.orientation);
+	}
 
-	} catch (std::exception const &e) {
-		U_LOG_E("Caught exception: %s", e.what());
-		return M_RELATION_HISTORY_RESULT_INVALID;
+	//! @todo Does interpolating the velocities make any sense?
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
+		result.angular_velocity = m_vec3_lerp(predecessor.relation.angular_velocity,
+		                                      successor.relation.angular_velocity, amount_to_lerp);
 	}
+	if (!hermite && 0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
+		result.linear_velocity = m_vec3_lerp(predecessor.relation.linear_velocity,
+		                                     successor.relation.linear_velocity, amount_to_lerp);
+	}
+	*out_relation = result;
+	return M_RELATION_HISTORY_RESULT_INTERPOLATED;
 }
 
 bool
@@ -232,27 +404,44 @@ m_relation_history_get_latest(const struct m_relation_history *rh,
                               uint64_t *out_time_ns,
                               struct xrt_space_relation *out_relation)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	if (rh->impl.empty()) {
-		return false;
-	}
-	*out_relation = rh->impl.back().relation;
-	*out_time_ns = rh->impl.back().timestamp;
+	struct relation_history_entry latest;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&rh->lock);
+		if (rh->count == 0) {
+			return false;
+		}
+		latest = get_newest_unsafe(rh);
+	} while (u_seqlock_read_retry(&rh->lock, seq));
+
+	*out_relation = latest.relation;
+	*out_time_ns = latest.timestamp;
 	return true;
 }
 
 uint32_t
 m_relation_history_get_size(const struct m_relation_history *rh)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	return (uint32_t)rh->impl.size();
+	uint32_t size;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&rh->lock);
+		size = get_size_unsafe(rh);
+	} while (u_seqlock_read_retry(&rh->lock, seq));
+
+	return size;
 }
 
 void
 m_relation_history_clear(struct m_relation_history *rh)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	rh->impl.clear();
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+
+	u_seqlock_write_begin(&rh->lock);
+	rh->count = 0;
+	u_seqlock_write_end(&rh->lock);
 }
 
 void
@@ -140,6 +140,51 @@ os_hid_destroy(struct os_hid_device *hid_dev)
  */
 int
 os_hid_open_hidraw(const char *path, struct os_hid_device **out_hid);
+
+/*!
+ * Get the file descriptor of a hidraw device, -1 if @p hid_dev is not one.
+ *
+ * @public @memberof os_hid_device
+ */
+int
+os_hid_hidraw_get_fd(struct os_hid_device *hid_dev);
+
+//! Most devices the reactor can read from at the same time.
+#define OS_HID_REACTOR_MAX_DEVICES (32)
+
+//! Largest input report the reactor reads, longer reports are truncated.
+#define OS_HID_REACTOR_MAX_REPORT_SIZE (1024)
+
+/*!
+ * Called from the reactor thread with one input report and the time it was
+ * read. On disconnect or error @p data is NULL and @p size is negative, the
+ * device is then no longer read from but still needs to be removed.
+ */
+typedef void (*os_hid_reactor_func_t)(void *user, const uint8_t *data, int size, int64_t timestamp_ns);
+
+/*!
+ * Read input reports from @p hid_dev on the reactor, a single real-time
+ * priority thread shared by all devices that waits on all of them with epoll,
+ * instead of the driver running its own read thread. The device is made
+ * non-blocking and must not be read with @ref os_hid_read until removed, the
+ * other functions can still be used, also from the callback.
+ *
+ * Only works on hidraw devices, returns a negative errno on failure.
+ *
+ * @public @memberof os_hid_device
+ */
+int
+os_hid_reactor_add(struct os_hid_device *hid_dev, os_hid_reactor_func_t func, void *user);
+
+/*!
+ * Stop reading from @p hid_dev, when this returns the callback is not running
+ * and will not be called again. Must not be called from a reactor callback,
+ * safe to call on devices that were never added.
+ *
+ * @public @memberof os_hid_device
+ */
+void
+os_hid_reactor_remove(struct os_hid_device *hid_dev);
 #endif
 
 #ifdef __cplusplus
@@ -158,4 +158,15 @@ os_hid_open_hidraw(const char *path, struct os_hid_device **out_hid)
 	return 0;
 }
 
+int
+os_hid_hidraw_get_fd(struct os_hid_device *ohdev)
+{
+	if (ohdev == NULL || ohdev->read != os_hidraw_read) {
+		return -1;
+	}
+
+	struct hid_hidraw *hrdev = (struct hid_hidraw *)ohdev;
+	return hrdev->fd;
+}
+
 #endif
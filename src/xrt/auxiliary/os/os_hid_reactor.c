@@ -0,0 +1,337 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared epoll based read loop for hidraw devices.
+ * @ingroup aux_os
+ */
+
+#include "os_hid.h"
+
+#ifdef XRT_OS_LINUX
+
+#include "os_time.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+/*!
+ * Reports read from one device before moving on to the next, keeps one busy
+ * device from starving the others.
+ */
+#define MAX_READS_PER_WAKEUP (8)
+
+//! Events handled per epoll_wait call.
+#define MAX_EVENTS (16)
+
+struct reactor_entry
+{
+	struct os_hid_device *hid_dev;
+	int fd;
+
+	//! Flags of the fd before it was made non-blocking, restored on remove.
+	int old_flags;
+
+	os_hid_reactor_func_t func;
+	void *user;
+};
+
+/*!
+ * The one reactor shared by all drivers, the thread is started on the first
+ * add and stopped on the last remove.
+ */
+static struct
+{
+	//! Held for all of add and remove, never taken by the thread.
+	pthread_mutex_t lifecycle;
+
+	//! Guards the entries, held by the thread while dispatching.
+	pthread_mutex_t mutex;
+
+	pthread_t thread;
+	bool running;
+
+	int epoll_fd;
+	int wake_fd;
+
+	struct reactor_entry entries[OS_HID_REACTOR_MAX_DEVICES];
+	uint32_t entry_count;
+} g_reactor = {
+    .lifecycle = PTHREAD_MUTEX_INITIALIZER,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .epoll_fd = -1,
+    .wake_fd = -1,
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static struct reactor_entry *
+find_by_fd_locked(int fd)
+{
+	for (uint32_t i = 0; i < g_reactor.entry_count; i++) {
+		if (g_reactor.entries[i].fd == fd) {
+			return &g_reactor.entries[i];
+		}
+	}
+	return NULL;
+}
+
+static struct reactor_entry *
+find_by_hid_locked(struct os_hid_device *hid_dev)
+{
+	for (uint32_t i = 0; i < g_reactor.entry_count; i++) {
+		if (g_reactor.entries[i].hid_dev == hid_dev) {
+			return &g_reactor.entries[i];
+		}
+	}
+	return NULL;
+}
+
+static void
+dispatch_locked(struct reactor_entry *e, uint32_t events)
+{
+	uint8_t buffer[OS_HID_REACTOR_MAX_REPORT_SIZE];
+
+	if (events & (EPOLLERR | EPOLLHUP)) {
+		// Device disconnect, stop polling it and let the driver know.
+		epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_DEL, e->fd, NULL);
+		e->func(e->user, NULL, -1, os_monotonic_get_ns());
+		return;
+	}
+
+	for (int i = 0; i < MAX_READS_PER_WAKEUP; i++) {
+		ssize_t ret = read(e->fd, buffer, sizeof(buffer));
+		int64_t timestamp_ns = os_monotonic_get_ns();
+
+		if (ret < 0 && (errno == EAGAIN || errno == EINTR)) {
+			return; // Drained.
+		}
+		if (ret < 0) {
+			epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_DEL, e->fd, NULL);
+			e->func(e->user, NULL, -errno, timestamp_ns);
+			return;
+		}
+
+		e->func(e->user, buffer, (int)ret, timestamp_ns);
+	}
+}
+
+static void *
+reactor_thread(void *ptr)
+{
+	pthread_setname_np(pthread_self(), "HID reactor");
+
+	// Best effort, needs CAP_SYS_NICE or a suitable rtprio limit.
+	struct sched_param params = {.sched_priority = sched_get_priority_min(SCHED_FIFO)};
+	pthread_setschedparam(pthread_self(), SCHED_FIFO, &params);
+
+	struct epoll_event events[MAX_EVENTS];
+
+	while (true) {
+		int count = epoll_wait(g_reactor.epoll_fd, events, MAX_EVENTS, -1);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count < 0) {
+			break;
+		}
+
+		pthread_mutex_lock(&g_reactor.mutex);
+
+		if (!g_reactor.running) {
+			pthread_mutex_unlock(&g_reactor.mutex);
+			break;
+		}
+
+		for (int i = 0; i < count; i++) {
+			int fd = events[i].data.fd;
+			if (fd == g_reactor.wake_fd) {
+				continue;
+			}
+
+			// Looked up by fd as the device might have been removed since epoll_wait returned.
+			struct reactor_entry *e = find_by_fd_locked(fd);
+			if (e != NULL) {
+				dispatch_locked(e, events[i].events);
+			}
+		}
+
+		pthread_mutex_unlock(&g_reactor.mutex);
+	}
+
+	return NULL;
+}
+
+static int
+start(void)
+{
+	g_reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (g_reactor.epoll_fd < 0) {
+		return -errno;
+	}
+
+	g_reactor.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (g_reactor.wake_fd < 0) {
+		int ret = -errno;
+		close(g_reactor.epoll_fd);
+		g_reactor.epoll_fd = -1;
+		return ret;
+	}
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = g_reactor.wake_fd};
+	epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, g_reactor.wake_fd, &ev);
+
+	g_reactor.running = true;
+
+	int ret = pthread_create(&g_reactor.thread, NULL, reactor_thread, NULL);
+	if (ret != 0) {
+		g_reactor.running = false;
+		close(g_reactor.wake_fd);
+		close(g_reactor.epoll_fd);
+		g_reactor.wake_fd = -1;
+		g_reactor.epoll_fd = -1;
+		return -ret;
+	}
+
+	return 0;
+}
+
+static void
+stop(void)
+{
+	uint64_t one = 1;
+	if (write(g_reactor.wake_fd, &one, sizeof(one)) != sizeof(one)) {
+		// Can only fail if the counter overflows, the thread is woken up either way.
+	}
+
+	pthread_join(g_reactor.thread, NULL);
+
+	close(g_reactor.wake_fd);
+	close(g_reactor.epoll_fd);
+	g_reactor.wake_fd = -1;
+	g_reactor.epoll_fd = -1;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+os_hid_reactor_add(struct os_hid_device *hid_dev, os_hid_reactor_func_t func, void *user)
+{
+	int fd = os_hid_hidraw_get_fd(hid_dev);
+	if (fd < 0) {
+		return -EINVAL;
+	}
+
+	int ret = 0;
+
+	pthread_mutex_lock(&g_reactor.lifecycle);
+
+	if (g_reactor.entry_count >= OS_HID_REACTOR_MAX_DEVICES) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	if (g_reactor.entry_count == 0) {
+		ret = start();
+		if (ret < 0) {
+			goto out;
+		}
+	}
+
+	int old_flags = fcntl(fd, F_GETFL);
+	if (old_flags < 0 || fcntl(fd, F_SETFL, old_flags | O_NONBLOCK) < 0) {
+		ret = -errno;
+		goto out_maybe_stop;
+	}
+
+	pthread_mutex_lock(&g_reactor.mutex);
+
+	struct reactor_entry *e = &g_reactor.entries[g_reactor.entry_count];
+	e->hid_dev = hid_dev;
+	e->fd = fd;
+	e->old_flags = old_flags;
+	e->func = func;
+	e->user = user;
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+	if (epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		ret = -errno;
+		pthread_mutex_unlock(&g_reactor.mutex);
+		fcntl(fd, F_SETFL, old_flags);
+		goto out_maybe_stop;
+	}
+
+	g_reactor.entry_count++;
+
+	pthread_mutex_unlock(&g_reactor.mutex);
+	pthread_mutex_unlock(&g_reactor.lifecycle);
+
+	return 0;
+
+out_maybe_stop:
+	if (g_reactor.entry_count == 0) {
+		pthread_mutex_lock(&g_reactor.mutex);
+		g_reactor.running = false;
+		pthread_mutex_unlock(&g_reactor.mutex);
+		stop();
+	}
+out:
+	pthread_mutex_unlock(&g_reactor.lifecycle);
+	return ret;
+}
+
+void
+os_hid_reactor_remove(struct os_hid_device *hid_dev)
+{
+	pthread_mutex_lock(&g_reactor.lifecycle);
+
+	// Waits for any callback in progress.
+	pthread_mutex_lock(&g_reactor.mutex);
+
+	struct reactor_entry *e = find_by_hid_locked(hid_dev);
+	if (e == NULL) {
+		pthread_mutex_unlock(&g_reactor.mutex);
+		pthread_mutex_unlock(&g_reactor.lifecycle);
+		return;
+	}
+
+	// Might already be gone if the device failed, that is fine.
+	epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_DEL, e->fd, NULL);
+	fcntl(e->fd, F_SETFL, e->old_flags);
+
+	// Keep the array packed, order does not matter.
+	*e = g_reactor.entries[--g_reactor.entry_count];
+
+	bool last = g_reactor.entry_count == 0;
+	if (last) {
+		g_reactor.running = false;
+	}
+
+	pthread_mutex_unlock(&g_reactor.mutex);
+
+	if (last) {
+		stop();
+	}
+
+	pthread_mutex_unlock(&g_reactor.lifecycle);
+}
+
+#endif
@@ -672,6 +672,25 @@ os_thread_helper_wait_locked(struct os_thread_helper *oth)
 	pthread_cond_wait(&oth->cond, &oth->mutex);
 }
 
+/*!
+ * Wait for a signal, but for at most @p timeout_ns nanoseconds.
+ *
+ * Same rules as @ref os_thread_helper_wait_locked applies, be sure to call
+ * this in a loop and check the thing you are actually waiting for.
+ *
+ * @public @memberof os_thread_helper
+ */
+static inline void
+os_thread_helper_timedwait_locked(struct os_thread_helper *oth, uint64_t timeout_ns)
+{
+	struct timespec abs_timeout;
+	if (os_semaphore_get_realtime_clock(&abs_timeout, timeout_ns) != 0) {
+		return;
+	}
+
+	pthread_cond_timedwait(&oth->cond, &oth->mutex, &abs_timeout);
+}
+
 /*!
  * Signal a waiting thread to wake up.
  *
@@ -15,12 +15,14 @@
 #include "util/u_frame.h"
 #include "util/u_format.h"
 #include "util/u_logging.h"
+#include "util/u_worker.h"
 
 #include "tracking/t_tracking.h"
 #include "tracking/t_calibration_opencv.hpp"
 
 #include <opencv2/opencv.hpp>
 #include <sys/stat.h>
+#include <atomic>
 #include <utility>
 
 #if CV_MAJOR_VERSION >= 4
@@ -169,6 +171,23 @@ public:
 	char text[512] = {};
 
 	t_calibration_status *status;
+
+	//! Detects the right view while the frame thread does the left, and runs the solver.
+	struct u_worker_group *group = NULL;
+
+	/*!
+	 * The solver runs on @ref group so frames keep coming while it works.
+	 * While it runs the frame thread doesn't touch the collected boards, the
+	 * maps or @ref text, the solver owns them until `done` is set.
+	 */
+	struct
+	{
+		bool running = false;
+		std::atomic<bool> done = {false};
+		bool stereo = false;
+		int cols = 0;
+		int rows = 0;
+	} solve;
 };
 
 
@@ -434,6 +453,22 @@ do_view(class Calibration &c, struct ViewState &view, cv::Mat &gray, cv::Mat &rg
 	return found;
 }
 
+struct view_task
+{
+	class Calibration *c;
+	struct ViewState *view;
+	cv::Mat gray;
+	cv::Mat rgb;
+	bool found;
+};
+
+static void
+run_view(void *ptr)
+{
+	struct view_task *task = (struct view_task *)ptr;
+	task->found = do_view(*task->c, *task->view, task->gray, task->rgb);
+}
+
 static void
 remap_view(class Calibration &c, struct ViewState &view, cv::Mat &rgb)
 {
@@ -570,8 +605,6 @@ moved_state_check(struct ViewState &view)
 XRT_NO_INLINE static void
 process_stereo_samples(class Calibration &c, int cols, int rows)
 {
-	c.state.calibrated = true;
-
 	cv::Size image_size(cols, rows);
 	cv::Size new_image_size(cols, rows);
 
@@ -624,12 +657,12 @@ process_stereo_samples(class Calibration &c, int cols, int rows)
 
 	// Preview undistortion/rectification.
 	StereoRectificationMaps maps(wrapped.base);
-	c.state.view[0].map1 = maps.view[0].rectify.remap_x;
-	c.state.view[0].map2 = maps.view[0].rectify.remap_y;
+	c.state.view[0].map1 = maps.view[0].rectify.map1;
+	c.state.view[0].map2 = maps.view[0].rectify.map2;
 	c.state.view[0].maps_valid = true;
 
-	c.state.view[1].map1 = maps.view[1].rectify.remap_x;
-	c.state.view[1].map2 = maps.view[1].rectify.remap_y;
+	c.state.view[1].map1 = maps.view[1].rectify.map1;
+	c.state.view[1].map2 = maps.view[1].rectify.map2;
 	c.state.view[1].maps_valid = true;
 
 	std::cout << "#####\n";
@@ -765,7 +798,7 @@ process_view_samples(class Calibration &c, struct ViewState &view, int cols, int
 		                                     cv::Matx33d::eye(), // R
 		                                     new_intrinsics_mat, // P
 		                                     image_size,         // size
-		                                     CV_32FC1,           // m1type
+		                                     CV_16SC2,           // m1type
 		                                     view.map1,          // map1
 		                                     view.map2);         // map2
 
@@ -778,15 +811,78 @@ process_view_samples(class Calibration &c, struct ViewState &view, int cols, int
 		    cv::noArray(),           // R
 		    new_intrinsics_mat,      // P
 		    image_size,              // size
-		    CV_32FC1,                // m1type
+		    CV_16SC2,                // m1type
 		    view.map1,               // map1
 		    view.map2);              // map2
 
 		// Set the maps as valid.
 		view.maps_valid = true;
 	}
+}
+
+//! Runs on the worker group, see @ref Calibration::solve.
+static void
+run_solve(void *ptr)
+{
+	auto &c = *(class Calibration *)ptr;
+
+	if (c.solve.stereo) {
+		process_stereo_samples(c, c.solve.cols, c.solve.rows);
+	} else {
+		process_view_samples(c, c.state.view[0], c.solve.cols, c.solve.rows);
+	}
+
+	c.solve.done.store(true, std::memory_order_release);
+}
+
+//! Hand all of the collected boards to the solver, called from the frame thread.
+static void
+start_solve(class Calibration &c, bool stereo, int cols, int rows)
+{
+	c.solve.running = true;
+	c.solve.done.store(false, std::memory_order_relaxed);
+	c.solve.stereo = stereo;
+	c.solve.cols = cols;
+	c.solve.rows = rows;
+
+	if (c.status != NULL) {
+		c.status->solving = true;
+	}
+
+	u_worker_group_push(c.group, run_solve, &c);
+}
+
+//! The solver owns @ref Calibration::text, so use a fixed one.
+static void
+send_solving_frame(class Calibration &c)
+{
+	print_txt(c.gui.rgb, "CALIBRATING, PLEASE WAIT", 1.5);
+	send_rgb_frame(c);
+}
+
+/*!
+ * Called on the frame thread while the solver runs, returns true once it has
+ * finished and the results can be used.
+ */
+static bool
+check_solve(class Calibration &c)
+{
+	if (!c.solve.done.load(std::memory_order_acquire)) {
+		return false;
+	}
 
+	// Already done, only releases the group's bookkeeping.
+	u_worker_group_wait_all(c.group);
+
+	c.solve.running = false;
 	c.state.calibrated = true;
+
+	if (c.status != NULL) {
+		c.status->solving = false;
+		c.status->finished = true;
+	}
+
+	return true;
 }
 
 static void
@@ -964,7 +1060,9 @@ make_calibration_frame_mono(class Calibration &c)
 	do_capture_logic_mono(c, c.state.view[0], found, gray, rgb);
 
 	if (c.state.board_models_f32.size() >= c.num_collect_total) {
-		process_view_samples(c, c.state.view[0], rgb.cols, rgb.rows);
+		start_solve(c, false, rgb.cols, rgb.rows);
+		send_solving_frame(c);
+		return;
 	}
 
 	// Draw text and finally send the frame off.
@@ -990,14 +1088,20 @@ make_calibration_frame_sbs(class Calibration &c)
 	cv::Mat l_rgb(rows, cols, CV_8UC3, c.gui.frame->data, c.gui.frame->stride);
 	cv::Mat r_rgb(rows, cols, CV_8UC3, c.gui.frame->data + 3 * cols, c.gui.frame->stride);
 
+	// The right view goes to the pool while this thread does the left one.
+	struct view_task r_task = {&c, &c.state.view[1], r_gray, r_rgb, false};
+	u_worker_group_push(c.group, run_view, &r_task);
 	bool found_left = do_view(c, c.state.view[0], l_gray, l_rgb);
-	bool found_right = do_view(c, c.state.view[1], r_gray, r_rgb);
+	u_worker_group_wait_all(c.group);
+	bool found_right = r_task.found;
 
 	do_capture_logic_stereo(c, gray, rgb, found_left, c.state.view[0], l_gray, l_rgb, found_right, c.state.view[1],
 	                        r_gray, r_rgb);
 
 	if (c.state.board_models_f32.size() >= c.num_collect_total) {
-		process_stereo_samples(c, cols, rows);
+		start_solve(c, true, cols, rows);
+		send_solving_frame(c);
+		return;
 	}
 
 	// Draw text and finally send the frame off.
@@ -1016,10 +1120,6 @@ make_calibration_frame(class Calibration &c, struct xrt_frame *xf)
 		make_gui_str(c);
 		return;
 	}
-
-	if (c.status != NULL && c.state.calibrated) {
-		c.status->finished = true;
-	}
 }
 
 static void
@@ -1153,7 +1253,7 @@ process_load_image(class Calibration &c, struct xrt_frame *xf)
 
 	for (uint32_t i = 0; i < c.load.num_images; i++) {
 		// Early out if the user requested less images.
-		if (c.state.calibrated) {
+		if (c.state.calibrated || c.solve.running) {
 			break;
 		}
 
@@ -1222,6 +1322,12 @@ t_calibration_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 		return;
 	}
 
+	// Show the live image until the solver is done, without touching its state.
+	if (c.solve.running && !check_solve(c)) {
+		send_solving_frame(c);
+		return;
+	}
+
 	// Don't do anything if we are done.
 	if (c.state.calibrated) {
 		make_remap_view(c, xf);
@@ -1324,6 +1430,10 @@ t_calibration_stereo_create(struct xrt_frame_context *xfctx,
 	c.save_images = params->save_images;
 	c.status = status;
 
+	// One worker is enough, the frame thread does the left view itself.
+	struct u_worker_thread_pool *pool = u_worker_thread_pool_create(1, 1, "Calibration");
+	c.group = u_worker_group_create(pool);
+	u_worker_thread_pool_reference(&pool, NULL);
 
 	// Setup a initial message.
 	P("Waiting for camera");
@@ -154,14 +154,19 @@ struct StereoCameraCalibrationWrapper
 
 
 /*!
- * @brief An x,y pair of matrices for the remap() function.
+ * @brief A pair of matrices for the remap() function, in OpenCV's fixed-point
+ * format which remaps a lot faster than floating point maps.
+ *
+ * Both can be cropped with the same cv::Rect to only remap a region.
  *
  * @see calibration_get_undistort_map
  */
 struct RemapPair
 {
-	cv::Mat remap_x;
-	cv::Mat remap_y;
+	//! Integer source x,y pairs, CV_16SC2, enough on its own for nearest sampling.
+	cv::Mat map1;
+	//! Sub-pixel interpolation table indices for linear sampling, CV_16UC1.
+	cv::Mat map2;
 };
 
 /*!
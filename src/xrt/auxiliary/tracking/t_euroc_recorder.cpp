@@ -14,10 +14,13 @@
 #include "util/u_sink.h"
 #include "util/u_var.h"
 #include "util/u_debug.h"
+#include "util/u_worker.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_tracking.h"
 
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
@@ -29,7 +32,13 @@
 #include <opencv2/imgcodecs.hpp>
 
 DEBUG_GET_ONCE_BOOL_OPTION(euroc_recorder_use_jpg, "EUROC_RECORDER_USE_JPG", false)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_recorder_threads, "EUROC_RECORDER_THREADS", 2)
+DEBUG_GET_ONCE_NUM_OPTION(euroc_recorder_png_compression, "EUROC_RECORDER_PNG_COMPRESSION", -1)
 
+//! How many frames per encoder thread can be waiting to be written before the writer sinks wait.
+#define FRAMES_IN_FLIGHT_PER_THREAD 4
+
+using std::condition_variable;
 using std::lock_guard;
 using std::mutex;
 using std::ofstream;
@@ -51,6 +60,15 @@ struct euroc_recorder
 
 	bool use_jpg; //! Whether or not we should save images as .jpg files
 
+	vector<int> imwrite_params; //!< Encoding parameters given to cv::imwrite
+
+	// Encoders: the writer sinks hand frames to these threads to be encoded and written to disk
+	struct u_worker_group *encoders = nullptr;
+	mutex in_flight_lock{};              //!< Lock for in_flight
+	condition_variable in_flight_cond{}; //!< Signaled when a frame has been written
+	int in_flight = 0;                   //!< Frames handed to the encoders and not yet written
+	int max_in_flight = 0;               //!< Writer sinks wait when there are this many in flight
+
 	// Cloner sinks: copy frame to heap for quick release of the original
 	struct xrt_slam_sinks cloner_queues; //!< Queue sinks that write into cloner sinks
 	struct xrt_imu_sink cloner_imu_sink;
@@ -181,6 +199,35 @@ euroc_recorder_save_gt(xrt_pose_sink *sink, struct xrt_pose_sample *sample)
 	*er->gt_csv << o.w << "," << o.x << "," << o.y << "," << o.z << CSV_EOL;
 }
 
+//! A frame waiting to be encoded and written by the encoder threads.
+struct euroc_recorder_encode_task
+{
+	euroc_recorder *er;
+	struct xrt_frame *frame;
+	string img_path;
+};
+
+static void
+euroc_recorder_encode(void *ptr)
+{
+	auto *task = (euroc_recorder_encode_task *)ptr;
+	euroc_recorder *er = task->er;
+	xrt_frame *frame = task->frame;
+
+	auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
+	cv::Mat img{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
+	cv::imwrite(task->img_path, img, er->imwrite_params);
+
+	xrt_frame_reference(&task->frame, NULL);
+	delete task;
+
+	{
+		lock_guard lock{er->in_flight_lock};
+		er->in_flight--;
+	}
+	er->in_flight_cond.notify_one();
+}
+
 static void
 euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_index)
 {
@@ -188,14 +235,22 @@ euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_i
 	uint64_t ts = frame->timestamp;
 
 	assert(frame->format == XRT_FORMAT_L8 || frame->format == XRT_FORMAT_R8G8B8); // Only formats supported
-	auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
 	string file_extension = er->use_jpg ? ".jpg" : ".png";
 	string filename = std::to_string(ts) + file_extension;
 	string img_path = er->path + "/mav0/" + cam_name + "/data/" + filename;
-	cv::Mat img{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
-	cv::imwrite(img_path, img);
 
 	*er->cams_csv[cam_index] << ts << "," << filename << CSV_EOL;
+
+	// Only wait here, on the writer queue thread, the sinks upstream never block on encoding
+	{
+		std::unique_lock lock{er->in_flight_lock};
+		er->in_flight_cond.wait(lock, [er] { return er->in_flight < er->max_in_flight; });
+		er->in_flight++;
+	}
+
+	auto *task = new euroc_recorder_encode_task{er, nullptr, img_path};
+	xrt_frame_reference(&task->frame, frame);
+	u_worker_group_push(er->encoders, euroc_recorder_encode, task);
 }
 
 #define DEFINE_SAVE_CAM(cam_id)                                                                                        \
@@ -322,6 +377,11 @@ extern "C" void
 euroc_recorder_node_destroy(struct xrt_frame_node *node)
 {
 	struct euroc_recorder *er = container_of(node, struct euroc_recorder, node);
+
+	// Finish writing the frames handed to the encoders.
+	u_worker_group_wait_all(er->encoders);
+	u_worker_group_reference(&er->encoders, NULL);
+
 	delete er->imu_csv;
 	delete er->gt_csv;
 	for (int i = 0; i < er->cam_count; i++) {
@@ -353,6 +413,17 @@ euroc_recorder_create(struct xrt_frame_context *xfctx, const char *record_path,
 
 	er->use_jpg = debug_get_bool_option_euroc_recorder_use_jpg();
 
+	int png_compression = (int)debug_get_num_option_euroc_recorder_png_compression();
+	if (!er->use_jpg && png_compression >= 0) {
+		er->imwrite_params = {cv::IMWRITE_PNG_COMPRESSION, png_compression};
+	}
+
+	int thread_count = std::max(1, (int)debug_get_num_option_euroc_recorder_threads());
+	er->max_in_flight = thread_count * FRAMES_IN_FLIGHT_PER_THREAD;
+	struct u_worker_thread_pool *pool = u_worker_thread_pool_create(thread_count, thread_count, "EuRoC Recorder");
+	er->encoders = u_worker_group_create(pool);
+	u_worker_thread_pool_reference(&pool, NULL);
+
 	// Setup sink pipeline
 
 	// We expose a "cloner" sink that will clone frames in memory so that original
@@ -89,9 +89,9 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 		                                     rectify_transform_optional, // R
 		                                     new_camera_matrix_optional, // newCameraMatrix
 		                                     image_size,                 // size
-		                                     CV_32FC1,                   // m1type
-		                                     ret.remap_x,                // map1
-		                                     ret.remap_y);               // map2
+		                                     CV_16SC2,                   // m1type
+		                                     ret.map1,                   // map1
+		                                     ret.map2);                  // map2
 		break;
 	case T_DISTORTION_OPENCV_RADTAN_5:
 		cv::initUndistortRectifyMap(wrap.intrinsics_mat,        // cameraMatrix
@@ -99,9 +99,9 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 		                            rectify_transform_optional, // R
 		                            new_camera_matrix_optional, // newCameraMatrix
 		                            image_size,                 // size
-		                            CV_32FC1,                   // m1type
-		                            ret.remap_x,                // map1
-		                            ret.remap_y);               // map2
+		                            CV_16SC2,                   // m1type
+		                            ret.map1,                   // map1
+		                            ret.map2);                  // map2
 		break;
 	default: assert(false);
 	}
@@ -143,9 +143,33 @@ struct t_hsv_filter
 
 	struct u_sink_debug usds[NUM_CHANNELS];
 
+	//! Recycles the channel frames once all sinks are done with them.
+	struct u_frame_pool *pool;
+
+	//! One row that channels nobody is listening to are written to, and overwritten.
+	uint8_t *scratch_row;
+	uint32_t scratch_row_size;
+
 	struct t_hsv_filter_optimized_table table;
 };
 
+/*!
+ * Where to write a channel, channels without a frame all share the scratch
+ * row with a stride of zero so the processing loops don't need to branch.
+ */
+static inline void
+get_dst(struct t_hsv_filter *f, size_t i, uint8_t **out_data, size_t *out_stride)
+{
+	struct xrt_frame *xf = f->frames[i];
+	if (xf != NULL) {
+		*out_data = xf->data;
+		*out_stride = xf->stride;
+	} else {
+		*out_data = f->scratch_row;
+		*out_stride = 0;
+	}
+}
+
 static void
 process_sample(struct t_hsv_filter *f,
                uint8_t y,
@@ -173,17 +197,19 @@ hsv_process_frame_yuv(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
 	SINK_TRACE_MARKER();
 
-	struct xrt_frame *f0 = f->frames[0];
-	struct xrt_frame *f1 = f->frames[1];
-	struct xrt_frame *f2 = f->frames[2];
-	struct xrt_frame *f3 = f->frames[3];
+	uint8_t *d0, *d1, *d2, *d3;
+	size_t s0, s1, s2, s3;
+	get_dst(f, 0, &d0, &s0);
+	get_dst(f, 1, &d1, &s1);
+	get_dst(f, 2, &d2, &s2);
+	get_dst(f, 3, &d3, &s3);
 
 	for (uint32_t y = 0; y < xf->height; y++) {
 		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
+		uint8_t *dst0 = d0 + y * s0;
+		uint8_t *dst1 = d1 + y * s1;
+		uint8_t *dst2 = d2 + y * s2;
+		uint8_t *dst3 = d3 + y * s3;
 
 		for (uint32_t x = 0; x < xf->width; x += 1) {
 			uint8_t y = src[0];
@@ -205,17 +231,19 @@ hsv_process_frame_yuyv(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
 	SINK_TRACE_MARKER();
 
-	struct xrt_frame *f0 = f->frames[0];
-	struct xrt_frame *f1 = f->frames[1];
-	struct xrt_frame *f2 = f->frames[2];
-	struct xrt_frame *f3 = f->frames[3];
+	uint8_t *d0, *d1, *d2, *d3;
+	size_t s0, s1, s2, s3;
+	get_dst(f, 0, &d0, &s0);
+	get_dst(f, 1, &d1, &s1);
+	get_dst(f, 2, &d2, &s2);
+	get_dst(f, 3, &d3, &s3);
 
 	for (uint32_t y = 0; y < xf->height; y++) {
 		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
+		uint8_t *dst0 = d0 + y * s0;
+		uint8_t *dst1 = d1 + y * s1;
+		uint8_t *dst2 = d2 + y * s2;
+		uint8_t *dst3 = d3 + y * s3;
 
 		for (uint32_t x = 0; x < xf->width; x += 2) {
 			uint8_t y1 = src[0];
@@ -249,15 +277,33 @@ hsv_process_frame_yuyv(struct t_hsv_filter *f, struct xrt_frame *xf)
 	}
 }
 
-static void
+/*!
+ * Gets frames for the channels that have a sink or an active debug sink,
+ * returns false if no channel is wanted.
+ */
+static bool
 ensure_buf_allocated(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
 	uint32_t w = xf->width;
 	uint32_t h = xf->height;
+	bool any = false;
 
 	for (size_t i = 0; i < NUM_CHANNELS; i++) {
-		u_frame_create_one_off(XRT_FORMAT_L8, w, h, &f->frames[i]);
+		if (f->sinks[i] == NULL && !u_sink_debug_is_active(&f->usds[i])) {
+			continue;
+		}
+
+		u_frame_pool_get(f->pool, XRT_FORMAT_L8, w, h, &f->frames[i]);
+		any = true;
+	}
+
+	if (any && f->scratch_row_size < w) {
+		free(f->scratch_row);
+		f->scratch_row = U_TYPED_ARRAY_CALLOC(uint8_t, w);
+		f->scratch_row_size = w;
 	}
+
+	return any;
 }
 
 static void
@@ -288,19 +334,27 @@ hsv_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 	struct t_hsv_filter *f = (struct t_hsv_filter *)xsink;
 
 
+	if (xf->format != XRT_FORMAT_YUV888 && xf->format != XRT_FORMAT_YUYV422) {
+		U_LOG_E("Bad format '%s'", u_format_str(xf->format));
+		return;
+	}
+
+	// Nobody is listening, skip the whole frame.
+	if (!ensure_buf_allocated(f, xf)) {
+		return;
+	}
+
 	switch (xf->format) {
-	case XRT_FORMAT_YUV888:
-		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuv(f, xf);
-		break;
-	case XRT_FORMAT_YUYV422:
-		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuyv(f, xf);
-		break;
-	default: U_LOG_E("Bad format '%s'", u_format_str(xf->format)); return;
+	case XRT_FORMAT_YUV888: hsv_process_frame_yuv(f, xf); break;
+	case XRT_FORMAT_YUYV422: hsv_process_frame_yuyv(f, xf); break;
+	default: assert(false);
 	}
 
 	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		if (f->frames[i] == NULL) {
+			continue;
+		}
+
 		push_buf(f, xf, f->sinks[i], &f->usds[i], f->frames[i]);
 		xrt_frame_reference(&f->frames[i], NULL);
 	}
@@ -321,6 +375,8 @@ hsv_destroy(struct xrt_frame_node *node)
 		u_sink_debug_destroy(&f->usds[i]);
 	}
 
+	u_frame_pool_reference(&f->pool, NULL);
+	free(f->scratch_row);
 	free(f);
 }
 
@@ -340,6 +396,8 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
 	f->sinks[2] = sinks[2];
 	f->sinks[3] = sinks[3];
 
+	f->pool = u_frame_pool_create(false, NUM_CHANNELS * 2);
+
 	t_hsv_build_optimized_table(&f->params, &f->table);
 
 	xrt_frame_context_add(xfctx, &f->node);
@@ -0,0 +1,412 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Filters for PS Move optical and IMU fusion.
+ *
+ * Header only so the micro-benchmarks can compare them without depending on
+ * the whole tracking library.
+ *
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/QR>
+
+#include "flexkalman/AbsoluteOrientationMeasurement.h"
+#include "flexkalman/EigenQuatExponentialMap.h"
+#include "flexkalman/FlexibleKalmanFilter.h"
+#include "flexkalman/FlexibleUnscentedCorrect.h"
+#include "flexkalman/PoseSeparatelyDampedConstantVelocity.h"
+#include "flexkalman/PoseState.h"
+
+#include "tracking/t_fusion.hpp"
+
+#include <cmath>
+
+
+namespace xrt::auxiliary::tracking {
+
+/*!
+ * Parameters of the damped constant velocity process model used by all of
+ * the PS Move filters, the defaults are the ones flexkalman uses.
+ */
+struct PSMVFilterParams
+{
+	//! Fraction of the linear velocity left after one second.
+	double position_damping = 0.3;
+	//! Fraction of the angular velocity left after one second.
+	double orientation_damping = 0.01;
+	//! Noise autocorrelation of the position axes.
+	double position_noise = 0.01;
+	//! Noise autocorrelation of the orientation axes.
+	double orientation_noise = 0.1;
+};
+
+//! Predicted pose of the tracked body, returned by the filters.
+struct PSMVFilterPrediction
+{
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	Eigen::Vector3d position;
+	Eigen::Quaterniond orientation;
+	Eigen::Vector3d linear_velocity;
+	Eigen::Vector3d angular_velocity;
+};
+
+/*!
+ * The original PS Move filter, the flexkalman externalized rotation pose
+ * state with an unscented correction for every measurement.
+ *
+ * Each correction draws 2 * (12 + 3) + 1 sigma points from an augmented 15x15
+ * covariance, kept as the reference the faster filter is compared against.
+ */
+class PSMVUnscentedFilter
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	using State = flexkalman::pose_externalized_rotation::State;
+	using ProcessModel = flexkalman::PoseSeparatelyDampedConstantVelocityProcessModel<State>;
+
+	explicit PSMVUnscentedFilter(PSMVFilterParams const &params = PSMVFilterParams{})
+	    : process_model(params.position_damping,
+	                    params.orientation_damping,
+	                    params.position_noise,
+	                    params.orientation_noise)
+	{}
+
+	void
+	reset()
+	{
+		state = State{};
+	}
+
+	void
+	predict(double dt)
+	{
+		flexkalman::predict(state, process_model, dt);
+	}
+
+	bool
+	correct_orientation(Eigen::Quaterniond const &orientation, Eigen::Vector3d const &variance)
+	{
+		auto meas = flexkalman::AbsoluteOrientationMeasurement{orientation, variance};
+		return flexkalman::correctUnscented(state, meas);
+	}
+
+	double
+	position_residual(Eigen::Vector3d const &position, Eigen::Vector3d const &lever_arm) const
+	{
+		auto meas = AbsolutePositionLeverArmMeasurement{position, lever_arm, Eigen::Vector3d::Ones()};
+		return meas.getResidual(state).norm();
+	}
+
+	bool
+	correct_position(Eigen::Vector3d const &position,
+	                 Eigen::Vector3d const &lever_arm,
+	                 Eigen::Vector3d const &variance)
+	{
+		auto meas = AbsolutePositionLeverArmMeasurement{position, lever_arm, variance};
+		return flexkalman::correctUnscented(state, meas);
+	}
+
+	Eigen::Vector3d
+	angular_velocity() const
+	{
+		return state.angularVelocity();
+	}
+
+	PSMVFilterPrediction
+	get_prediction(double dt) const
+	{
+		auto predicted = flexkalman::getPrediction(state, process_model, dt);
+
+		PSMVFilterPrediction ret;
+		ret.position = predicted.position();
+		ret.orientation = predicted.getQuaternion();
+		ret.linear_velocity = predicted.velocity();
+		ret.angular_velocity = predicted.angularVelocity();
+		return ret;
+	}
+
+private:
+	State state;
+	ProcessModel process_model;
+};
+
+/*!
+ * Extended Kalman filter for the same state and process model as
+ * @ref PSMVUnscentedFilter, written out for its structure.
+ *
+ * The state is position, incremental rotation, linear and angular velocity;
+ * all sizes are known at compile time and nothing is allocated. Prediction
+ * works on the 6x6 blocks of the covariance since the transition only couples
+ * each value with its derivative, and both measurements only depend on the
+ * position and rotation so the gain needs a 3x3 inverse instead of unscented
+ * sigma points. The rotation is folded into the quaternion before every
+ * correction so the measurement jacobians are evaluated at zero rotation.
+ *
+ * With @p SquareRoot the covariance is kept as a factor L where P = L L^T,
+ * predicted with a QR decomposition and corrected one axis at a time with
+ * Potter's update. Costs several times more, the covariance stays positive
+ * definite however the rounding works out, for very small variances.
+ */
+template <bool SquareRoot = false> class PSMVBlockFilter
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	static constexpr int Dimension = 12;
+	using StateVector = Eigen::Matrix<double, Dimension, 1>;
+	using StateSquareMatrix = Eigen::Matrix<double, Dimension, Dimension>;
+	using Block6 = Eigen::Matrix<double, 6, 6>;
+	//! Jacobian of a 3D measurement with regards to the position and rotation.
+	using Jacobian = Eigen::Matrix<double, 3, 6>;
+	//! The transposed factors of the predicted covariance stacked.
+	using Stacked = Eigen::Matrix<double, 2 * Dimension, Dimension>;
+
+	//! Initial variance on the diagonal, same as flexkalman uses.
+	static constexpr double InitialVariance = 10.0;
+
+	explicit PSMVBlockFilter(PSMVFilterParams const &params = PSMVFilterParams{}) : params(params)
+	{
+		reset();
+	}
+
+	void
+	reset()
+	{
+		x = StateVector::Zero();
+		orientation = Eigen::Quaterniond::Identity();
+		if constexpr (SquareRoot) {
+			cov = StateSquareMatrix::Identity() * std::sqrt(InitialVariance);
+		} else {
+			cov = StateSquareMatrix::Identity() * InitialVariance;
+		}
+	}
+
+	void
+	predict(double dt)
+	{
+		Eigen::Matrix<double, 6, 1> atten;
+		atten.head<3>().setConstant(std::pow(params.position_damping, dt));
+		atten.tail<3>().setConstant(std::pow(params.orientation_damping, dt));
+
+		x.head<6>() += x.tail<6>() * dt;
+		x.tail<6>().array() *= atten.array();
+
+		if constexpr (SquareRoot) {
+			predict_sqrt_cov(dt, atten);
+		} else {
+			predict_cov(dt, atten);
+		}
+	}
+
+	bool
+	correct_orientation(Eigen::Quaterniond const &measured, Eigen::Vector3d const &variance)
+	{
+		externalize_rotation();
+
+		Eigen::Vector3d residual = 2 * flexkalman::util::smallest_quat_ln(measured * orientation.conjugate());
+
+		Jacobian H = Jacobian::Zero();
+		H.rightCols<3>().setIdentity();
+
+		return correct(H, residual, variance);
+	}
+
+	double
+	position_residual(Eigen::Vector3d const &position, Eigen::Vector3d const &lever_arm) const
+	{
+		Eigen::Quaterniond combined = flexkalman::util::quat_exp(x.segment<3>(3) / 2.) * orientation;
+		return (position - (x.head<3>() + combined * lever_arm)).norm();
+	}
+
+	bool
+	correct_position(Eigen::Vector3d const &position,
+	                 Eigen::Vector3d const &lever_arm,
+	                 Eigen::Vector3d const &variance)
+	{
+		externalize_rotation();
+
+		Eigen::Vector3d arm_world = orientation * lever_arm;
+		Eigen::Vector3d residual = position - (x.head<3>() + arm_world);
+
+		// A small rotation d moves the point by d x arm_world.
+		Jacobian H;
+		H.leftCols<3>().setIdentity();
+		H.rightCols<3>() = -cross_matrix(arm_world);
+
+		return correct(H, residual, variance);
+	}
+
+	Eigen::Vector3d
+	angular_velocity() const
+	{
+		return x.tail<3>();
+	}
+
+	PSMVFilterPrediction
+	get_prediction(double dt) const
+	{
+		double pos_atten = std::pow(params.position_damping, dt);
+		double ori_atten = std::pow(params.orientation_damping, dt);
+		Eigen::Vector3d rotation = x.segment<3>(3) + x.tail<3>() * dt;
+
+		PSMVFilterPrediction ret;
+		ret.position = x.head<3>() + x.segment<3>(6) * dt;
+		ret.orientation = (flexkalman::util::quat_exp(rotation / 2.) * orientation).normalized();
+		ret.linear_velocity = x.segment<3>(6) * pos_atten;
+		ret.angular_velocity = x.tail<3>() * ori_atten;
+		return ret;
+	}
+
+	//! The full covariance, for comparing the two forms.
+	StateSquareMatrix
+	error_covariance() const
+	{
+		if constexpr (SquareRoot) {
+			return cov * cov.transpose();
+		}
+		return cov;
+	}
+
+private:
+	static Eigen::Matrix3d
+	cross_matrix(Eigen::Vector3d const &v)
+	{
+		Eigen::Matrix3d ret;
+		ret << 0, -v.z(), v.y(), //
+		    v.z(), 0, -v.x(),    //
+		    -v.y(), v.x(), 0;    //
+		return ret;
+	}
+
+	void
+	externalize_rotation()
+	{
+		orientation = (flexkalman::util::quat_exp(x.segment<3>(3) / 2.) * orientation).normalized();
+		x.segment<3>(3).setZero();
+	}
+
+	/*!
+	 * P = F P F^T + Q with F = [I, dt I; 0, D], worked out on the 6x6 blocks,
+	 * D is the diagonal attenuation so it is applied as row or column scaling.
+	 */
+	void
+	predict_cov(double dt, Eigen::Matrix<double, 6, 1> const &atten)
+	{
+		Block6 A = cov.topLeftCorner<6, 6>();
+		Block6 B = cov.topRightCorner<6, 6>();
+		Block6 C = cov.bottomRightCorner<6, 6>();
+
+		Block6 BC = B + dt * C;
+		Block6 top_left = A + dt * (B + B.transpose()) + dt * dt * C;
+		Block6 top_right = BC * atten.asDiagonal();
+		Block6 bottom_right = atten.asDiagonal() * C * atten.asDiagonal();
+
+		double dt2 = dt * dt / 2;
+		double dt3 = dt * dt * dt / 3;
+		for (int i = 0; i < 6; i++) {
+			double mu = i < 3 ? params.position_noise : params.orientation_noise;
+			top_left(i, i) += mu * dt3;
+			top_right(i, i) += mu * dt2;
+			bottom_right(i, i) += mu * dt;
+		}
+
+		cov.topLeftCorner<6, 6>() = top_left;
+		cov.topRightCorner<6, 6>() = top_right;
+		cov.bottomLeftCorner<6, 6>() = top_right.transpose();
+		cov.bottomRightCorner<6, 6>() = bottom_right;
+	}
+
+	/*!
+	 * Triangularise [F L, sqrt(Q)] so its product with its transpose, the
+	 * predicted covariance, is kept; sqrt(Q) has a closed form per axis.
+	 */
+	void
+	predict_sqrt_cov(double dt, Eigen::Matrix<double, 6, 1> const &atten)
+	{
+		Stacked stacked = Stacked::Zero();
+
+		StateSquareMatrix FL;
+		FL.topRows<6>() = cov.topRows<6>() + dt * cov.bottomRows<6>();
+		FL.bottomRows<6>() = atten.asDiagonal() * cov.bottomRows<6>();
+		stacked.topRows<Dimension>() = FL.transpose();
+
+		// Cholesky of mu * [dt^3/3, dt^2/2; dt^2/2, dt].
+		double dt_sqrt = std::sqrt(dt);
+		for (int i = 0; i < 6; i++) {
+			double mu_sqrt = std::sqrt(i < 3 ? params.position_noise : params.orientation_noise);
+			stacked(Dimension + i, i) = mu_sqrt * dt * dt_sqrt / std::sqrt(3.0);
+			stacked(Dimension + i, i + 6) = mu_sqrt * dt_sqrt * std::sqrt(3.0) / 2;
+			stacked(Dimension + i + 6, i + 6) = mu_sqrt * dt_sqrt / 2;
+		}
+
+		Eigen::HouseholderQR<Stacked> qr(stacked);
+		StateSquareMatrix R = qr.matrixQR().topRows<Dimension>().triangularView<Eigen::Upper>();
+		cov = R.transpose();
+	}
+
+	//! Linearised correction, the state is left untouched if anything isn't finite.
+	bool
+	correct(Jacobian const &H, Eigen::Vector3d const &residual, Eigen::Vector3d const &variance)
+	{
+		StateVector dx;
+		StateSquareMatrix new_cov;
+
+		if constexpr (SquareRoot) {
+			// Potter's update, one axis at a time as the noise is diagonal.
+			dx = StateVector::Zero();
+			new_cov = cov;
+			for (int i = 0; i < 3; i++) {
+				Eigen::Matrix<double, 1, 6> h = H.row(i);
+				StateVector phi = new_cov.topRows<6>().transpose() * h.transpose();
+				double alpha = phi.squaredNorm() + variance(i);
+				StateVector K = new_cov * phi / alpha;
+				double gamma = 1. / (1. + std::sqrt(variance(i) / alpha));
+
+				dx += K * (residual(i) - h * dx.head<6>());
+				new_cov -= gamma * K * phi.transpose();
+			}
+		} else {
+			Eigen::Matrix<double, Dimension, 3> PHt = cov.leftCols<6>() * H.transpose();
+			Eigen::Matrix3d S = H * PHt.topRows<6>();
+			S.diagonal() += variance;
+			Eigen::Matrix<double, Dimension, 3> K = PHt * S.inverse();
+
+			dx = K * residual;
+			new_cov = cov - K * PHt.transpose();
+
+			// Rounding makes it drift from symmetric, and it grows if left.
+			new_cov = (new_cov + new_cov.transpose()) * 0.5;
+		}
+
+		if (!dx.allFinite() || !new_cov.allFinite()) {
+			return false;
+		}
+
+		x += dx;
+		cov = new_cov;
+		externalize_rotation();
+
+		return true;
+	}
+
+	PSMVFilterParams params;
+
+	StateVector x;
+	//! Error covariance, or the factor of it with @p SquareRoot.
+	StateSquareMatrix cov;
+	Eigen::Quaterniond orientation;
+};
+
+} // namespace xrt::auxiliary::tracking
@@ -0,0 +1,138 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Predicts where a tracked object is in a rectified stereo pair.
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+namespace xrt::auxiliary::tracking {
+
+/*!
+ * @brief Keeps track of a region of interest in both views of a rectified
+ * stereo camera around an object that was found last frame, so that only that
+ * part of the frames needs to be processed.
+ *
+ * Every @ref reacquire_interval frames, and whenever the object was lost, the
+ * whole frame is asked for instead so that it can be found again.
+ *
+ * All points are in OpenCV camera space of the rectified left view, the space
+ * you get from the disparity to depth matrix.
+ */
+struct StereoRoiPredictor
+{
+public:
+	//! Inverse of the disparity to depth matrix.
+	cv::Matx44d depth_to_disparity = cv::Matx44d::eye();
+
+	//! Size of one rectified view.
+	cv::Size view_size = {};
+
+	//! Process the whole frame at least this often, zero disables regions of interest.
+	int reacquire_interval = 0;
+
+	int frames_since_full = 0;
+	bool have_last = false;
+	cv::Point3f last_point = {};
+
+
+	void
+	init(const cv::Matx44d &disparity_to_depth, cv::Size size, int interval)
+	{
+		depth_to_disparity = disparity_to_depth.inv();
+		view_size = size;
+		reacquire_interval = interval;
+		lost();
+	}
+
+	//! The object was found at @p point this frame.
+	void
+	found(const cv::Point3f &point)
+	{
+		last_point = point;
+		have_last = true;
+	}
+
+	//! The object was not found this frame.
+	void
+	lost()
+	{
+		have_last = false;
+	}
+
+	/*!
+	 * Gets the region of interest of each view for this frame, a box with
+	 * sides of two times @p half_size_m around the last point projected into
+	 * both views. Returns false if the whole frames should be processed.
+	 */
+	bool
+	get(float half_size_m, cv::Rect out_rects[2])
+	{
+		if (reacquire_interval <= 0 || !have_last || ++frames_since_full >= reacquire_interval) {
+			frames_since_full = 0;
+			return false;
+		}
+
+		// Behind or too close to the camera to say anything useful.
+		if (last_point.z - half_size_m <= 0) {
+			return false;
+		}
+
+		float min_x[2] = {FLT_MAX, FLT_MAX};
+		float max_x[2] = {-FLT_MAX, -FLT_MAX};
+		float min_y = FLT_MAX;
+		float max_y = -FLT_MAX;
+
+		for (int i = 0; i < 8; i++) {
+			float dx = (i & 1) ? half_size_m : -half_size_m;
+			float dy = (i & 2) ? half_size_m : -half_size_m;
+			float dz = (i & 4) ? half_size_m : -half_size_m;
+			cv::Vec4d corner(last_point.x + dx, last_point.y + dy, last_point.z + dz, 1.0);
+
+			cv::Vec4d xydw = depth_to_disparity * corner;
+			if (xydw[3] == 0.0) {
+				return false;
+			}
+
+			float x = (float)(xydw[0] / xydw[3]);
+			float y = (float)(xydw[1] / xydw[3]);
+			float disp = (float)(xydw[2] / xydw[3]);
+
+			// Disparity is left x minus right x.
+			min_x[0] = std::min(min_x[0], x);
+			max_x[0] = std::max(max_x[0], x);
+			min_x[1] = std::min(min_x[1], x - disp);
+			max_x[1] = std::max(max_x[1], x - disp);
+			min_y = std::min(min_y, y);
+			max_y = std::max(max_y, y);
+		}
+
+		cv::Rect bounds(cv::Point(0, 0), view_size);
+		for (int i = 0; i < 2; i++) {
+			cv::Point tl((int)floorf(min_x[i]), (int)floorf(min_y));
+			cv::Point br((int)ceilf(max_x[i]) + 1, (int)ceilf(max_y) + 1);
+			out_rects[i] = cv::Rect(tl, br) & bounds;
+
+			if (out_rects[i].empty()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+} // namespace xrt::auxiliary::tracking
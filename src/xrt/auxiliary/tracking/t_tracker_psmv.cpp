@@ -15,6 +15,7 @@
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_tracker_psmv_fusion.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
+#include "tracking/t_stereo_roi.hpp"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -35,6 +36,21 @@
 
 using namespace xrt::auxiliary::tracking;
 
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_tracking_roi, "PSMV_TRACKING_ROI", true)
+DEBUG_GET_ONCE_NUM_OPTION(psmv_imu_batch, "PSMV_IMU_BATCH", 4)
+
+/*!
+ * Half the side of the box around the last ball position that is searched,
+ * covers the ball and how far it can move between two frames.
+ */
+#define PSMV_ROI_HALF_SIZE_M (0.15f)
+
+//! Search the whole frames at least this often, in frames.
+#define PSMV_ROI_REACQUIRE_INTERVAL (30)
+
+//! Most IMU samples held back before correcting the filter with them.
+#define PSMV_IMU_BATCH_MAX (16)
+
 //! Namespace for PS Move tracking implementation
 namespace xrt::auxiliary::tracking::psmv {
 
@@ -46,8 +62,8 @@ namespace xrt::auxiliary::tracking::psmv {
 struct View
 {
 public:
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
+	cv::Mat undistort_rectify_map1;
+	cv::Mat undistort_rectify_map2;
 
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
@@ -65,8 +81,8 @@ public:
 		distortion = wrap.distortion_mat.clone();
 		distortion_model = wrap.distortion_model;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map1 = rectification.map1;
+		undistort_rectify_map2 = rectification.map2;
 	}
 };
 
@@ -116,8 +132,23 @@ public:
 
 	cv::Ptr<cv::SimpleBlobDetector> sbd;
 
+	//! Where in the views to look for the ball next frame.
+	StereoRoiPredictor roi;
+
 	std::shared_ptr<PSMVFusionInterface> filter;
 
+	/*!
+	 * IMU samples not yet given to the filter, they are given to it in one go
+	 * when there are @p size of them or a pose is asked for.
+	 */
+	struct
+	{
+		timepoint_ns timestamps_ns[PSMV_IMU_BATCH_MAX];
+		struct xrt_tracking_sample samples[PSMV_IMU_BATCH_MAX];
+		uint32_t count = 0;
+		uint32_t size = 1;
+	} imu_batch;
+
 	xrt_vec3 tracked_object_position;
 };
 
@@ -131,31 +162,42 @@ static_assert(std::is_standard_layout<TrackerPSMV>::value);
  * Right now, this is mainly finding blobs/keypoints.
  */
 static void
-do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb, const cv::Rect *roi)
 {
 	XRT_TRACE_MARKER();
 
+	cv::Size size = view.undistort_rectify_map1.size();
+	cv::Rect rect = roi != nullptr ? *roi : cv::Rect(cv::Point(0, 0), size);
+
+	view.frame_undist_rectified.create(size, CV_8UC1);
+	if (roi != nullptr && rgb.cols > 0) {
+		// Only the region is written, don't show stale pixels around it.
+		view.frame_undist_rectified.setTo(0);
+	}
+
+	cv::Mat dst = view.frame_undist_rectified(rect);
+
 	{
 		XRT_TRACE_IDENT(remap);
 
-		// Undistort and rectify the whole image.
-		cv::remap(grey,                         // src
-		          view.frame_undist_rectified,  // dst
-		          view.undistort_rectify_map_x, // map1
-		          view.undistort_rectify_map_y, // map2
-		          cv::INTER_NEAREST,            // interpolation
-		          cv::BORDER_CONSTANT,          // borderMode
-		          cv::Scalar(0, 0, 0));         // borderValue
+		// Undistort and rectify the region, the maps hold absolute source coordinates.
+		cv::remap(grey,                              // src
+		          dst,                               // dst
+		          view.undistort_rectify_map1(rect), // map1
+		          view.undistort_rectify_map2(rect), // map2
+		          cv::INTER_NEAREST,                 // interpolation
+		          cv::BORDER_CONSTANT,               // borderMode
+		          cv::Scalar(0, 0, 0));              // borderValue
 	}
 
 	{
 		XRT_TRACE_IDENT(threshold);
 
-		cv::threshold(view.frame_undist_rectified, // src
-		              view.frame_undist_rectified, // dst
-		              32.0,                        // thresh
-		              255.0,                       // maxval
-		              0);                          // type
+		cv::threshold(dst,   // src
+		              dst,   // dst
+		              32.0,  // thresh
+		              255.0, // maxval
+		              0);    // type
 	}
 
 	{
@@ -163,9 +205,14 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 
 		// Do blob detection with our masks.
 		//! @todo Re-enable masks.
-		t.sbd->detect(view.frame_undist_rectified, // image
-		              view.keypoints,              // keypoints
-		              cv::noArray());              // mask
+		t.sbd->detect(dst,            // image
+		              view.keypoints, // keypoints
+		              cv::noArray()); // mask
+
+		for (cv::KeyPoint &kp : view.keypoints) {
+			kp.pt.x += (float)rect.x;
+			kp.pt.y += (float)rect.y;
+		}
 	}
 
 
@@ -287,8 +334,11 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
 	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	cv::Rect rois[2];
+	bool use_roi = t.roi.get(PSMV_ROI_HALF_SIZE_M, rois);
+
+	do_view(t, t.view[0], l_grey, t.debug.rgb[0], use_roi ? &rois[0] : nullptr);
+	do_view(t, t.view[1], r_grey, t.debug.rgb[1], use_roi ? &rois[1] : nullptr);
 
 	cv::Point3f last_point(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
 	auto nearest_world = make_lowest_score_finder<cv::Point3f>([&](const cv::Point3f &world_point) {
@@ -324,8 +374,12 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 		cv::Point3f world_point = nearest_world.best;
 		// update internal state
 		memcpy(&t.tracked_object_position, &world_point.x, sizeof(t.tracked_object_position));
+
+		// Back to OpenCV camera space, see world_point_from_blobs.
+		t.roi.found(cv::Point3f(world_point.x, -world_point.y, -world_point.z));
 	} else {
 		t.filter->clear_position_tracked_flag();
+		t.roi.lost();
 	}
 
 	// We are done with the debug frame.
@@ -402,6 +456,18 @@ run(TrackerPSMV &t)
 	os_thread_helper_unlock(&t.oth);
 }
 
+//! Called with the lock held.
+static void
+flush_imu_locked(TrackerPSMV &t)
+{
+	if (t.imu_batch.count == 0) {
+		return;
+	}
+
+	t.filter->process_imu_batch(t.imu_batch.timestamps_ns, t.imu_batch.samples, t.imu_batch.count, NULL);
+	t.imu_batch.count = 0;
+}
+
 /*!
  * @brief Retrieves a pose from the filter.
  */
@@ -430,6 +496,7 @@ get_pose(TrackerPSMV &t, enum xrt_input_name name, timepoint_ns when_ns, struct
 		return;
 	}
 
+	flush_imu_locked(t);
 	t.filter->get_prediction(when_ns, out_relation);
 
 	os_thread_helper_unlock(&t.oth);
@@ -445,7 +512,13 @@ imu_data(TrackerPSMV &t, timepoint_ns timestamp_ns, struct xrt_tracking_sample *
 		os_thread_helper_unlock(&t.oth);
 		return;
 	}
-	t.filter->process_imu_data(timestamp_ns, sample, NULL);
+	uint32_t index = t.imu_batch.count++;
+	t.imu_batch.timestamps_ns[index] = timestamp_ns;
+	t.imu_batch.samples[index] = *sample;
+
+	if (t.imu_batch.count >= t.imu_batch.size) {
+		flush_imu_locked(t);
+	}
 
 	os_thread_helper_unlock(&t.oth);
 }
@@ -583,6 +656,7 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	t.fusion.rot.z = 0.0f;
 	t.fusion.rot.w = 1.0f;
 	t.filter = PSMVFusionInterface::create();
+	t.imu_batch.size = (uint32_t)CLAMP(debug_get_num_option_psmv_imu_batch(), 1, PSMV_IMU_BATCH_MAX);
 
 	ret = os_thread_helper_init(&t.oth);
 	if (ret != 0) {
@@ -618,6 +692,10 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	t.r_cam_translation = wrapped.camera_translation_mat;
 	t.calibrated = true;
 
+	int reacquire_interval = debug_get_bool_option_psmv_tracking_roi() ? PSMV_ROI_REACQUIRE_INTERVAL : 0;
+	t.roi.init(static_cast<cv::Matx44d>(t.disparity_to_depth), t.view[0].undistort_rectify_map1.size(),
+	           reacquire_interval);
+
 	// clang-format off
 	cv::SimpleBlobDetector::Params blob_params;
 	blob_params.filterByArea = false;
@@ -12,38 +12,34 @@
  * @ingroup aux_tracking
  */
 
-#include "tracking/t_fusion.hpp"
 #include "tracking/t_imu_fusion.hpp"
+#include "tracking/t_psmv_filter.hpp"
 #include "tracking/t_tracker_psmv_fusion.hpp"
 
 #include "math/m_api.h"
 #include "math/m_eigen_interop.hpp"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 
-#include "flexkalman/AbsoluteOrientationMeasurement.h"
-#include "flexkalman/FlexibleKalmanFilter.h"
-#include "flexkalman/FlexibleUnscentedCorrect.h"
-#include "flexkalman/PoseSeparatelyDampedConstantVelocity.h"
-#include "flexkalman/PoseState.h"
+#include <string.h>
 
 
 namespace xrt::auxiliary::tracking {
 
 using namespace xrt::auxiliary::math;
 
+DEBUG_GET_ONCE_OPTION(psmv_fusion_filter, "PSMV_FUSION_FILTER", "block")
+
 //! Anonymous namespace to hide implementation names
 namespace {
 
-	using State = flexkalman::pose_externalized_rotation::State;
-	using ProcessModel = flexkalman::PoseSeparatelyDampedConstantVelocityProcessModel<State>;
-
 	struct TrackingInfo
 	{
 		bool valid{false};
 		bool tracked{false};
 	};
-	class PSMVFusion : public PSMVFusionInterface
+	template <typename Filter> class PSMVFusion : public PSMVFusionInterface
 	{
 	public:
 		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -56,6 +52,11 @@ namespace {
 		                 const struct xrt_tracking_sample *sample,
 		                 const struct xrt_vec3 *orientation_variance_optional) override;
 		void
+		process_imu_batch(const timepoint_ns *timestamps_ns,
+		                  const struct xrt_tracking_sample *samples,
+		                  uint32_t sample_count,
+		                  const struct xrt_vec3 *orientation_variance_optional) override;
+		void
 		process_3d_vision_data(timepoint_ns timestamp_ns,
 		                       const struct xrt_vec3 *position,
 		                       const struct xrt_vec3 *variance_optional,
@@ -71,8 +72,14 @@ namespace {
 		void
 		reset_filter_and_imu();
 
-		State filter_state;
-		ProcessModel process_model;
+		//! Feed a sample to the simple fusion and predict the filter to it.
+		void
+		integrate_imu(timepoint_ns timestamp_ns, const struct xrt_tracking_sample *sample);
+		//! Correct the filter with the orientation from the simple fusion.
+		void
+		correct_orientation(const struct xrt_vec3 *orientation_variance_optional);
+
+		Filter filter;
 
 		xrt::auxiliary::tracking::SimpleIMUFusion imu;
 
@@ -84,54 +91,61 @@ namespace {
 
 
 
+	template <typename Filter>
 	void
-	PSMVFusion::clear_position_tracked_flag()
+	PSMVFusion<Filter>::clear_position_tracked_flag()
 	{
 		position_state.tracked = false;
 	}
 
+	template <typename Filter>
 	void
-	PSMVFusion::reset_filter()
+	PSMVFusion<Filter>::reset_filter()
 	{
-		filter_state = State{};
+		filter.reset();
 		tracked = false;
 		position_state = TrackingInfo{};
 	}
+	template <typename Filter>
 	void
-	PSMVFusion::reset_filter_and_imu()
+	PSMVFusion<Filter>::reset_filter_and_imu()
 	{
 		reset_filter();
 		orientation_state = TrackingInfo{};
 		imu = SimpleIMUFusion{};
 	}
 
+	template <typename Filter>
 	void
-	PSMVFusion::process_imu_data(timepoint_ns timestamp_ns,
-	                             const struct xrt_tracking_sample *sample,
-	                             const struct xrt_vec3 *orientation_variance_optional)
+	PSMVFusion<Filter>::integrate_imu(timepoint_ns timestamp_ns, const struct xrt_tracking_sample *sample)
 	{
-
-		Eigen::Vector3d variance = Eigen::Vector3d::Constant(0.01);
-		if (orientation_variance_optional) {
-			variance = map_vec3(*orientation_variance_optional).cast<double>();
-		}
 		imu.handleAccel(map_vec3(sample->accel_m_s2).cast<double>(), timestamp_ns);
 		imu.handleGyro(map_vec3(sample->gyro_rad_secs).cast<double>(), timestamp_ns);
 		imu.postCorrect();
 
-		//! @todo use better measurements instead of the preceding "simple
-		//! fusion"
 		if (filter_time_ns != 0 && filter_time_ns != timestamp_ns) {
 			float dt = time_ns_to_s(timestamp_ns - filter_time_ns);
 			assert(dt > 0);
-			flexkalman::predict(filter_state, process_model, dt);
+			filter.predict(dt);
 		}
 		filter_time_ns = timestamp_ns;
-		auto meas = flexkalman::AbsoluteOrientationMeasurement{
-		    // Must rotate by 180 to align
-		    Eigen::Quaterniond(Eigen::AngleAxisd(EIGEN_PI, Eigen::Vector3d::UnitY())) * imu.getQuat(),
-		    variance};
-		if (flexkalman::correctUnscented(filter_state, meas)) {
+	}
+
+	template <typename Filter>
+	void
+	PSMVFusion<Filter>::correct_orientation(const struct xrt_vec3 *orientation_variance_optional)
+	{
+		Eigen::Vector3d variance = Eigen::Vector3d::Constant(0.01);
+		if (orientation_variance_optional) {
+			variance = map_vec3(*orientation_variance_optional).cast<double>();
+		}
+
+		//! @todo use better measurements instead of the preceding "simple
+		//! fusion"
+		// Must rotate by 180 to align
+		Eigen::Quaterniond orientation =
+		    Eigen::Quaterniond(Eigen::AngleAxisd(EIGEN_PI, Eigen::Vector3d::UnitY())) * imu.getQuat();
+		if (filter.correct_orientation(orientation, variance)) {
 			orientation_state.tracked = true;
 			orientation_state.valid = true;
 		} else {
@@ -142,7 +156,7 @@ namespace {
 		}
 		// 7200 deg/sec
 		constexpr double max_rad_per_sec = 20 * double(EIGEN_PI) * 2;
-		if (filter_state.angularVelocity().squaredNorm() > max_rad_per_sec * max_rad_per_sec) {
+		if (filter.angular_velocity().squaredNorm() > max_rad_per_sec * max_rad_per_sec) {
 			U_LOG_E(
 			    "Got excessive angular velocity when filtering "
 			    "IMU - resetting filter and IMU fusion!");
@@ -150,12 +164,44 @@ namespace {
 		}
 	}
 
+	template <typename Filter>
+	void
+	PSMVFusion<Filter>::process_imu_data(timepoint_ns timestamp_ns,
+	                                     const struct xrt_tracking_sample *sample,
+	                                     const struct xrt_vec3 *orientation_variance_optional)
+	{
+		integrate_imu(timestamp_ns, sample);
+		correct_orientation(orientation_variance_optional);
+	}
+
+	template <typename Filter>
+	void
+	PSMVFusion<Filter>::process_imu_batch(const timepoint_ns *timestamps_ns,
+	                                      const struct xrt_tracking_sample *samples,
+	                                      uint32_t sample_count,
+	                                      const struct xrt_vec3 *orientation_variance_optional)
+	{
+		if (sample_count == 0) {
+			return;
+		}
+
+		/*
+		 * The simple fusion sees every sample, so its orientation after the
+		 * last one carries all of them and one correction is enough.
+		 */
+		for (uint32_t i = 0; i < sample_count; i++) {
+			integrate_imu(timestamps_ns[i], &samples[i]);
+		}
+		correct_orientation(orientation_variance_optional);
+	}
+
+	template <typename Filter>
 	void
-	PSMVFusion::process_3d_vision_data(timepoint_ns timestamp_ns,
-	                                   const struct xrt_vec3 *position,
-	                                   const struct xrt_vec3 *variance_optional,
-	                                   const struct xrt_vec3 *lever_arm_optional,
-	                                   float residual_limit)
+	PSMVFusion<Filter>::process_3d_vision_data(timepoint_ns timestamp_ns,
+	                                           const struct xrt_vec3 *position,
+	                                           const struct xrt_vec3 *variance_optional,
+	                                           const struct xrt_vec3 *lever_arm_optional,
+	                                           float residual_limit)
 	{
 		Eigen::Vector3f pos = map_vec3(*position);
 		Eigen::Vector3d variance{1.e-4, 1.e-4, 4.e-4};
@@ -166,9 +212,7 @@ namespace {
 		if (lever_arm_optional) {
 			lever_arm = map_vec3(*lever_arm_optional).cast<double>();
 		}
-		auto measurement = xrt::auxiliary::tracking::AbsolutePositionLeverArmMeasurement{pos.cast<double>(),
-		                                                                                 lever_arm, variance};
-		double resid = measurement.getResidual(filter_state).norm();
+		double resid = filter.position_residual(pos.cast<double>(), lever_arm);
 
 		if (resid > residual_limit) {
 			// Residual arbitrarily "too large"
@@ -179,7 +223,7 @@ namespace {
 			reset_filter();
 			return;
 		}
-		if (flexkalman::correctUnscented(filter_state, measurement)) {
+		if (filter.correct_position(pos.cast<double>(), lever_arm, variance)) {
 			tracked = true;
 			position_state.valid = true;
 			position_state.tracked = true;
@@ -191,8 +235,9 @@ namespace {
 		}
 	}
 
+	template <typename Filter>
 	void
-	PSMVFusion::get_prediction(timepoint_ns when_ns, struct xrt_space_relation *out_relation)
+	PSMVFusion<Filter>::get_prediction(timepoint_ns when_ns, struct xrt_space_relation *out_relation)
 	{
 		if (out_relation == NULL) {
 			return;
@@ -204,12 +249,12 @@ namespace {
 			return;
 		}
 		float dt = time_ns_to_s(when_ns - filter_time_ns);
-		auto predicted_state = flexkalman::getPrediction(filter_state, process_model, dt);
+		PSMVFilterPrediction predicted = filter.get_prediction(dt);
 
-		map_vec3(out_relation->pose.position) = predicted_state.position().cast<float>();
-		map_quat(out_relation->pose.orientation) = predicted_state.getQuaternion().cast<float>();
-		map_vec3(out_relation->linear_velocity) = predicted_state.velocity().cast<float>();
-		map_vec3(out_relation->angular_velocity) = predicted_state.angularVelocity().cast<float>();
+		map_vec3(out_relation->pose.position) = predicted.position.cast<float>();
+		map_quat(out_relation->pose.orientation) = predicted.orientation.cast<float>();
+		map_vec3(out_relation->linear_velocity) = predicted.linear_velocity.cast<float>();
+		map_vec3(out_relation->angular_velocity) = predicted.angular_velocity.cast<float>();
 
 		uint64_t flags = 0;
 		if (position_state.valid) {
@@ -234,7 +279,18 @@ namespace {
 std::unique_ptr<PSMVFusionInterface>
 PSMVFusionInterface::create()
 {
-	auto ret = std::make_unique<PSMVFusion>();
-	return ret;
+	const char *filter = debug_get_option_psmv_fusion_filter();
+
+	if (strcmp(filter, "unscented") == 0) {
+		return std::make_unique<PSMVFusion<PSMVUnscentedFilter>>();
+	}
+	if (strcmp(filter, "block_sqrt") == 0) {
+		return std::make_unique<PSMVFusion<PSMVBlockFilter<true>>>();
+	}
+	if (strcmp(filter, "block") != 0) {
+		U_LOG_W("Unknown PSMV_FUSION_FILTER '%s', using 'block'", filter);
+	}
+
+	return std::make_unique<PSMVFusion<PSMVBlockFilter<false>>>();
 }
 } // namespace xrt::auxiliary::tracking
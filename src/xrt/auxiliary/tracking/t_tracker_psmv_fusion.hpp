@@ -43,6 +43,18 @@ public:
 	process_imu_data(timepoint_ns timestamp_ns,
 	                 const struct xrt_tracking_sample *sample,
 	                 const struct xrt_vec3 *orientation_variance_optional) = 0;
+
+	/*!
+	 * Same as calling @ref process_imu_data for each sample, but the filter is
+	 * only corrected once, after the last sample. Much cheaper when samples
+	 * come in faster than the pose is read.
+	 */
+	virtual void
+	process_imu_batch(const timepoint_ns *timestamps_ns,
+	                  const struct xrt_tracking_sample *samples,
+	                  uint32_t sample_count,
+	                  const struct xrt_vec3 *orientation_variance_optional) = 0;
+
 	virtual void
 	process_3d_vision_data(timepoint_ns timestamp_ns,
 	                       const struct xrt_vec3 *position,
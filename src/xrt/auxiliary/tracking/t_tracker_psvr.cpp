@@ -20,6 +20,7 @@
 #include "util/u_format.h"
 #include "util/u_var.h"
 #include "util/u_logging.h"
+#include "util/u_worker.h"
 
 #include "math/m_mathinclude.h"
 #include "math/m_api.h"
@@ -131,10 +132,21 @@ typedef struct blob_point
 	blob_type_t btype; // blob type
 } blob_point_t;
 
+typedef struct blob_data
+{
+	int tc_to_bc; // top center to bottom center
+	int lc_to_rc; // left center to right center
+	int tl_to_br; // top left to bottom right
+	int bl_to_tr; // bottom left to top right
+	int diff_a;
+	int diff_b;
+	bool ignore;
+} blob_data_t;
+
 struct View
 {
-	cv::Mat undistort_rectify_map_x;
-	cv::Mat undistort_rectify_map_y;
+	cv::Mat undistort_rectify_map1;
+	cv::Mat undistort_rectify_map2;
 
 	cv::Matx33d intrinsics;
 	cv::Mat distortion; // size may vary
@@ -144,6 +156,9 @@ struct View
 
 	cv::Mat frame_undist_rectified;
 
+	//! One per view so that both views can be detected at the same time.
+	cv::Ptr<cv::SimpleBlobDetector> sbd;
+
 	void
 	populate_from_calib(t_camera_calibration &calib, const RemapPair &rectification)
 	{
@@ -152,8 +167,8 @@ struct View
 		distortion = wrap.distortion_mat.clone();
 		distortion_model = wrap.distortion_model;
 
-		undistort_rectify_map_x = rectification.remap_x;
-		undistort_rectify_map_y = rectification.remap_y;
+		undistort_rectify_map1 = rectification.map1;
+		undistort_rectify_map2 = rectification.map2;
 	}
 };
 
@@ -227,6 +242,9 @@ public:
 	//! Thread and lock helper.
 	struct os_thread_helper oth;
 
+	//! Used to process both views at the same time.
+	struct u_worker_group *group = NULL;
+
 	//! Have we received a new IMU sample.
 	bool has_imu = false;
 
@@ -272,7 +290,6 @@ public:
 	cv::Vec3d r_cam_translation;
 	cv::Matx33d r_cam_rotation;
 
-	cv::Ptr<cv::SimpleBlobDetector> sbd;
 	std::vector<cv::KeyPoint> l_blobs, r_blobs;
 	std::vector<match_model_t> matches;
 
@@ -284,6 +301,12 @@ public:
 
 	std::vector<match_data_t> match_vertices;
 
+	// per-frame scratch, kept here so their storage is reused between frames
+	std::vector<match_data_t> predicted_pose;
+	std::vector<blob_data_t> blob_datas;
+	std::vector<match_data_t> solved;
+	std::vector<match_data_t> resolved;
+
 	float avg_optical_correction; // used to converge to a 'lock' correction
 	                              // rotation
 
@@ -1226,26 +1249,26 @@ create_match_list(TrackerPSVR &t)
 }
 
 static void
-do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(View &view, cv::Mat &grey, cv::Mat &rgb)
 {
 	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation - LINEAR seems
-	                                        // very slow on my setup
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
+	cv::remap(grey,                        // src
+	          view.frame_undist_rectified, // dst
+	          view.undistort_rectify_map1, // map1
+	          view.undistort_rectify_map2, // map2
+	          cv::INTER_NEAREST,           // interpolation - LINEAR seems
+	                                       // very slow on my setup
+	          cv::BORDER_CONSTANT,         // borderMode
+	          cv::Scalar(0, 0, 0));        // borderValue
 
 	cv::threshold(view.frame_undist_rectified, // src
 	              view.frame_undist_rectified, // dst
 	              32.0,                        // thresh
 	              255.0,                       // maxval
 	              0);
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
+	view.sbd->detect(view.frame_undist_rectified, // image
+	                 view.keypoints,              // keypoints
+	                 cv::noArray());              // mask
 
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
@@ -1257,16 +1280,19 @@ do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 	}
 }
 
-typedef struct blob_data
+struct view_task
 {
-	int tc_to_bc; // top center to bottom center
-	int lc_to_rc; // left center to right center
-	int tl_to_br; // top left to bottom right
-	int bl_to_tr; // bottom left to top right
-	int diff_a;
-	int diff_b;
-	bool ignore;
-} blob_data_t;
+	View *view;
+	cv::Mat grey;
+	cv::Mat *rgb;
+};
+
+static void
+run_view(void *ptr)
+{
+	struct view_task *task = (struct view_task *)ptr;
+	do_view(*task->view, task->grey, *task->rgb);
+}
 
 
 static void
@@ -1523,7 +1549,8 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 		dt = 1.0f;
 	}
 
-	std::vector<match_data_t> predicted_pose;
+	std::vector<match_data_t> &predicted_pose = t.predicted_pose;
+	predicted_pose.clear();
 	filter_predict(&predicted_pose, t.track_filters, dt / 2.0f);
 
 
@@ -1545,8 +1572,11 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
 	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	// The right view goes to the pool while this thread does the left one.
+	struct view_task r_task = {&t.view[1], r_grey, &t.debug.rgb[1]};
+	u_worker_group_push(t.group, run_view, &r_task);
+	do_view(t.view[0], l_grey, t.debug.rgb[0]);
+	u_worker_group_wait_all(t.group);
 
 	// if we wish to confirm our camera input contents, dump frames
 	// to disk
@@ -1587,7 +1617,8 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	}
 
 	// Convert our 2d point + disparities into 3d points.
-	std::vector<blob_data_t> blob_datas;
+	std::vector<blob_data_t> &blob_datas = t.blob_datas;
+	blob_datas.clear();
 
 	if (!t.l_blobs.empty()) {
 		for (uint32_t i = 0; i < t.l_blobs.size(); i++) {
@@ -1668,7 +1699,8 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	// best estimate of the position of the model vertices
 	// in world space, and model_center_transform will
 	// contain the pose matrix
-	std::vector<match_data_t> solved;
+	std::vector<match_data_t> &solved = t.solved;
+	solved.clear();
 	Eigen::Matrix4f model_center_transform = disambiguate(t, &t.match_vertices, &predicted_pose, &solved, 0);
 
 
@@ -1741,10 +1773,8 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 			PSVR_INFO("TOO MANY BAD CORRECTIONS. DRIFTED?");
 		}
 
-		std::vector<match_data_t> resolved;
-		for (uint32_t i = 0; i < solved.size(); i++) {
-			resolved.push_back(solved[i]);
-		}
+		std::vector<match_data_t> &resolved = t.resolved;
+		resolved.swap(solved);
 		solved.clear();
 		model_center_transform = solve_with_imu(t, &resolved, &predicted_pose, &solved, PSVR_SEARCH_RADIUS);
 	}
@@ -1780,10 +1810,7 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 
 	// store our last vertices for continuity
 	// matching
-	t.last_vertices.clear();
-	for (uint32_t i = 0; i < solved.size(); i++) {
-		t.last_vertices.push_back(solved[i]);
-	}
+	t.last_vertices.assign(solved.begin(), solved.end());
 
 	if (!t.last_vertices.empty()) {
 		filter_update(&t.last_vertices, t.track_filters, dt / 1000.0f);
@@ -2007,6 +2034,8 @@ t_psvr_node_destroy(struct xrt_frame_node *node)
 
 	os_thread_helper_destroy(&t_ptr->oth);
 
+	u_worker_group_reference(&t_ptr->group, NULL);
+
 	m_imu_3dof_close(&t_ptr->fusion.imu_3dof);
 
 	delete t_ptr;
@@ -2089,7 +2118,8 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	blob_params.minRepeatability = 1; // need this to avoid error?
 	// clang-format on
 
-	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[0].sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.view[1].sbd = cv::SimpleBlobDetector::create(blob_params);
 
 	t.target_optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	t.optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
@@ -2124,6 +2154,10 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 		return ret;
 	}
 
+	struct u_worker_thread_pool *pool = u_worker_thread_pool_create(1, 1, "PSVR Tracker");
+	t.group = u_worker_group_create(pool);
+	u_worker_thread_pool_reference(&pool, NULL);
+
 	t.fusion.pos.x = 0.0f;
 	t.fusion.pos.y = 0.0f;
 	t.fusion.pos.z = 0.0f;
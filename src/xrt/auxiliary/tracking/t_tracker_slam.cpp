@@ -8,6 +8,7 @@
  */
 
 #include "xrt/xrt_config_have.h"
+#include "xrt/xrt_config_os.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_frameserver.h"
@@ -17,6 +18,7 @@
 #include "util/u_sink.h"
 #include "util/u_var.h"
 #include "util/u_trace_marker.h"
+#include "util/u_file.h"
 #include "os/os_threading.h"
 #include "math/m_api.h"
 #include "math/m_filter_fifo.h"
@@ -35,6 +37,9 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/version.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <deque>
 #include <filesystem>
 #include <fstream>
@@ -47,6 +52,9 @@
 //! @todo Get preferred system from systems found at build time
 #define PREFERRED_VIT_SYSTEM_LIBRARY "libbasalt.so"
 
+//! How long to wait for the pose of a frame in lockstep mode before giving up on it.
+#define LOCKSTEP_TIMEOUT_NS (250 * U_TIME_1MS_IN_NS)
+
 #define SLAM_TRACE(...) U_LOG_IFL_T(t.log_level, __VA_ARGS__)
 #define SLAM_DEBUG(...) U_LOG_IFL_D(t.log_level, __VA_ARGS__)
 #define SLAM_INFO(...) U_LOG_IFL_I(t.log_level, __VA_ARGS__)
@@ -78,13 +86,15 @@ DEBUG_GET_ONCE_OPTION(vit_system_library_path, "VIT_SYSTEM_LIBRARY_PATH", PREFER
 DEBUG_GET_ONCE_OPTION(slam_config, "SLAM_CONFIG", nullptr)
 DEBUG_GET_ONCE_BOOL_OPTION(slam_ui, "SLAM_UI", false)
 DEBUG_GET_ONCE_BOOL_OPTION(slam_submit_from_start, "SLAM_SUBMIT_FROM_START", false)
+DEBUG_GET_ONCE_BOOL_OPTION(slam_lockstep, "SLAM_LOCKSTEP", false)
 DEBUG_GET_ONCE_NUM_OPTION(slam_openvr_groundtruth_device, "SLAM_OPENVR_GROUNDTRUTH_DEVICE", 0)
 DEBUG_GET_ONCE_NUM_OPTION(slam_prediction_type, "SLAM_PREDICTION_TYPE", long(SLAM_PRED_IP_IO_IA_IL))
 DEBUG_GET_ONCE_BOOL_OPTION(slam_write_csvs, "SLAM_WRITE_CSVS", false)
 DEBUG_GET_ONCE_OPTION(slam_csv_path, "SLAM_CSV_PATH", "evaluation/")
-DEBUG_GET_ONCE_BOOL_OPTION(slam_timing_stat, "SLAM_TIMING_STAT", true)
+DEBUG_GET_ONCE_BOOL_OPTION(slam_timing_stat, "SLAM_TIMING_STAT", false)
 DEBUG_GET_ONCE_BOOL_OPTION(slam_features_stat, "SLAM_FEATURES_STAT", true)
 DEBUG_GET_ONCE_NUM_OPTION(slam_cam_count, "SLAM_CAM_COUNT", 2)
+DEBUG_GET_ONCE_OPTION(slam_map, "SLAM_MAP", nullptr)
 
 //! Namespace for the interface to the external SLAM tracking system
 namespace xrt::auxiliary::tracking::slam {
@@ -268,6 +278,7 @@ struct TrackerSlam
 
 	bool submit;        //!< Whether to submit data pushed to sinks to the SLAM tracker
 	uint32_t cam_count; //!< Number of cameras used for tracking
+	bool lockstep;      //!< Whether to block the frame pusher until the SLAM system has a pose for its frame
 
 	struct u_var_button reset_state_btn; //!< Reset tracker state button
 
@@ -278,6 +289,7 @@ struct TrackerSlam
 
 	// Used mainly for checking that the timestamps come in order
 	timepoint_ns last_imu_ts;                     //!< Last received IMU sample timestamp
+	std::atomic<timepoint_ns> last_pose_ts;       //!< Timestamp of the last pose dequeued from the SLAM system
 	vector<timepoint_ns> last_cam_ts;             //!< Last received image timestamp per cam
 	struct xrt_hand_masks_sample last_hand_masks; //!< Last received hand masks info
 	Mutex last_hand_masks_mutex;                  //!< Mutex for @ref last_hand_masks
@@ -293,12 +305,31 @@ struct TrackerSlam
 	struct os_mutex lock_ff;        //!< Lock for gyro_ff and accel_ff.
 	struct m_ff_vec3_f32 *gyro_ff;  //!< Last gyroscope samples
 	struct m_ff_vec3_f32 *accel_ff; //!< Last accelerometer samples
+
+	//! IMU samples integrated on top of the latest SLAM pose as they arrive, guarded by @ref lock_ff.
+	struct
+	{
+		bool valid = false;
+		timepoint_ns base_ts = INT64_MIN; //!< Timestamp of the SLAM pose the integration started from
+		timepoint_ns ts = INT64_MIN;      //!< Timestamp of the last integrated IMU sample
+		xrt_space_relation rel = {};      //!< Relation at @ref ts
+	} imu_integ;
+
 	vector<u_sink_debug> ui_sink;   //!< Sink to display frames in UI of each camera
 
 	//! Used to correct accelerometer measurements when integrating into the prediction.
 	//! @todo Should be automatically computed instead of required to be filled manually through the UI.
 	xrt_vec3 gravity_correction{0, 0, -MATH_GRAVITY_M_S2};
 
+	//! Map saved on shutdown and loaded on start, to relocalize in the same space as the last session
+	struct
+	{
+		string path = "";          //!< Where the map is saved to, empty to not save it
+		bool loaded = false;       //!< Whether a map was loaded at start
+		bool localized = true;     //!< Whether the tracker has found itself in the loaded map
+		char state[32] = "No map"; //!< Shown in the UI
+	} map;
+
 	struct xrt_space_relation last_rel = XRT_SPACE_RELATION_ZERO; //!< Last reported/tracked pose
 	timepoint_ns last_ts;                                         //!< Last reported/tracked pose timestamp
 
@@ -393,6 +424,14 @@ struct TrackerSlam
 		struct u_var_timing diff_ui;          //!< Realtime UI for positional error
 		bool override_tracking = false;       //!< Force the tracker to report gt poses instead
 	} gt;
+
+	//! Everything tracked so far, for @ref t_slam_get_stats
+	struct
+	{
+		Mutex mutex;                    //!< Guards the fields below
+		Trajectory *tracked;            //!< Poses dequeued from the SLAM system
+		vector<timing_sample> *timings; //!< Timing of the poses that have all columns
+	} stats;
 };
 
 
@@ -726,16 +765,164 @@ gt_ui_push(TrackerSlam &t, timepoint_ns ts, xrt_pose tracked_pose)
 	t.gt.diff_ui.reference_timing = (1 - a) * t.gt.diff_ui.reference_timing + a * len_mm;
 }
 
+/*
+ *
+ * Stats functionality
+ *
+ */
+
+//! Sorts @p durations_ns and summarizes them into @p out_stage.
+static void
+fill_stage(vector<timepoint_ns> &durations_ns, const string &name, t_slam_stats_stage &out_stage)
+{
+	out_stage = {};
+	snprintf(out_stage.name, sizeof(out_stage.name), "%s", name.c_str());
+
+	if (durations_ns.empty()) {
+		return;
+	}
+
+	std::sort(durations_ns.begin(), durations_ns.end());
+
+	double sum_ms = 0;
+	for (timepoint_ns d : durations_ns) {
+		sum_ms += time_ns_to_ms_f(d);
+	}
+
+	size_t n = durations_ns.size();
+	out_stage.count = n;
+	out_stage.mean_ms = sum_ms / n;
+	out_stage.p50_ms = time_ns_to_ms_f(durations_ns[n / 2]);
+	out_stage.p95_ms = time_ns_to_ms_f(durations_ns[std::min(n - 1, n * 95 / 100)]);
+	out_stage.max_ms = time_ns_to_ms_f(durations_ns.back());
+}
+
+//! Fills the trajectory error part of @p out_stats, needs the stats mutex.
+static void
+compute_trajectory_errors(const TrackerSlam &t, t_slam_stats &out_stats)
+{
+	const Trajectory &gt = *t.gt.trajectory;
+	if (gt.empty()) {
+		return;
+	}
+
+	timepoint_ns gt_begin = gt.begin()->first;
+	timepoint_ns gt_end = std::prev(gt.end())->first;
+
+	// Tracked and ground truth positions at the same times, in ground truth space.
+	vector<timepoint_ns> tss;
+	vector<xrt_vec3> est;
+	vector<xrt_vec3> ref;
+	for (const auto &[ts, pose] : *t.stats.tracked) {
+		if (ts < gt_begin || ts > gt_end) {
+			continue;
+		}
+		tss.push_back(ts);
+		est.push_back(xr2gt_pose(t.gt.origin, pose).position);
+		ref.push_back(get_gt_pose_at(gt, ts).position);
+	}
+
+	size_t n = tss.size();
+	if (n == 0) {
+		return;
+	}
+
+	double sum = 0;
+	double sum_sq = 0;
+	double max = 0;
+	for (size_t i = 0; i < n; i++) {
+		double e = m_vec3_len(est[i] - ref[i]);
+		sum += e;
+		sum_sq += e * e;
+		max = std::max(max, e);
+	}
+
+	out_stats.ate_count = n;
+	out_stats.ate_rmse_m = std::sqrt(sum_sq / n);
+	out_stats.ate_mean_m = sum / n;
+	out_stats.ate_max_m = max;
+
+	// Compare each pose with the first one at least the delta later.
+	uint32_t rpe_count = 0;
+	sum = 0;
+	sum_sq = 0;
+	for (size_t i = 0, j = 0; i < n; i++) {
+		while (j < n && tss[j] < tss[i] + T_SLAM_STATS_RPE_DELTA_NS) {
+			j++;
+		}
+		if (j == n) {
+			break;
+		}
+
+		double e = m_vec3_len((est[j] - est[i]) - (ref[j] - ref[i]));
+		sum += e;
+		sum_sq += e * e;
+		rpe_count++;
+	}
+
+	if (rpe_count > 0) {
+		out_stats.rpe_count = rpe_count;
+		out_stats.rpe_rmse_m = std::sqrt(sum_sq / rpe_count);
+		out_stats.rpe_mean_m = sum / rpe_count;
+	}
+}
+
+//! Fills the timing part of @p out_stats, needs the stats mutex.
+static void
+compute_stage_timings(const TrackerSlam &t, t_slam_stats &out_stats)
+{
+	const vector<string> &columns = t.timing.columns;
+	const vector<timing_sample> &timings = *t.stats.timings;
+
+	vector<timepoint_ns> durations_ns;
+	durations_ns.reserve(timings.size());
+
+	for (const timing_sample &tss : timings) {
+		durations_ns.push_back(tss.back() - tss.front());
+	}
+	fill_stage(durations_ns, "total", out_stats.total);
+
+	size_t stage_count = std::min<size_t>(columns.size() - 1, T_SLAM_STATS_MAX_STAGES);
+	for (size_t s = 0; s < stage_count; s++) {
+		durations_ns.clear();
+		for (const timing_sample &tss : timings) {
+			durations_ns.push_back(tss[s + 1] - tss[s]);
+		}
+		fill_stage(durations_ns, columns[s + 1], out_stats.stages[s]);
+	}
+	out_stats.stage_count = stage_count;
+}
+
 /*
  *
  * Tracker functionality
  *
  */
 
+//! Poll the tracker until it has found itself in the map loaded at start.
+static void
+update_map_localized(TrackerSlam &t)
+{
+	if (t.map.localized || t.vit.tracker_is_map_localized == NULL) {
+		return;
+	}
+
+	bool localized = false;
+	vit_result_t vres = t.vit.tracker_is_map_localized(t.tracker, &localized);
+	if (vres != VIT_SUCCESS || !localized) {
+		return;
+	}
+
+	t.map.localized = true;
+	snprintf(t.map.state, sizeof(t.map.state), "Localized");
+	SLAM_INFO("Relocalized in the map loaded from '%s'", t.map.path.c_str());
+}
+
 //! Dequeue all tracked poses from the SLAM system and update prediction data with them.
 static bool
 flush_poses(TrackerSlam &t)
 {
+	update_map_localized(t);
 
 	vit_pose_t *pose = NULL;
 	vit_result_t vres = t.vit.tracker_pop_pose(t.tracker, &pose);
@@ -796,17 +983,95 @@ flush_poses(TrackerSlam &t)
 		auto tss = timing_ui_push(t, pose, nts);
 		t.slam_times_writer->push(tss);
 
+		{
+			unique_lock lock(t.stats.mutex);
+			t.stats.tracked->insert_or_assign(nts, rel.pose);
+			if (tss.size() == t.timing.columns.size()) {
+				t.stats.timings->push_back(tss);
+			}
+		}
+
 		if (t.features.enabled) {
 			vector feat_count = features_ui_push(t, pose, nts);
 			t.slam_features_writer->push({nts, feat_count});
 		}
 
+		t.last_pose_ts = nts;
+
 		t.vit.pose_destroy(pose);
 	} while (t.vit.tracker_pop_pose(t.tracker, &pose) == VIT_SUCCESS && pose);
 
 	return true;
 }
 
+//! Integrates one IMU sample at @p ts into @p rel, which is at @p rel_ts, and moves @p rel_ts to @p ts.
+static void
+integrate_imu_sample(TrackerSlam &t,
+                     const xrt_vec3 &g,
+                     const xrt_vec3 &a,
+                     timepoint_ns ts,
+                     xrt_space_relation &rel,
+                     timepoint_ns &rel_ts)
+{
+	xrt_quat &o = rel.pose.orientation;
+	xrt_vec3 &p = rel.pose.position;
+	xrt_vec3 &w = rel.angular_velocity;
+	xrt_vec3 &v = rel.linear_velocity;
+
+	// Update time
+	float dt = (float)time_ns_to_s(ts - rel_ts);
+	rel_ts = ts;
+
+	// Integrate gyroscope
+	xrt_quat angvel_delta{};
+	xrt_vec3 scaled_half_g = g * dt * 0.5f;
+	math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
+	math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
+	math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
+
+	// Integrate accelerometer
+	xrt_vec3 world_accel{};
+	math_quat_rotate_vec3(&o, &a, &world_accel);
+	world_accel += t.gravity_correction;
+	v += world_accel * dt;                        // Linear velocity
+	p += v * dt + world_accel * (dt * dt * 0.5f); // Position
+}
+
+/*!
+ * Restarts the incremental IMU integration from a new SLAM pose, integrating
+ * the samples already received after it. Called with @ref TrackerSlam::lock_ff held.
+ */
+static void
+rebase_imu_integration_locked(TrackerSlam &t, const xrt_space_relation &base_rel, timepoint_ns base_rel_ts)
+{
+	// Find oldest imu index i that is not older than the SLAM pose (or -1)
+	int i = 0;
+	uint64_t imu_ts = UINT64_MAX;
+	xrt_vec3 _;
+	while (m_ff_vec3_f32_get(t.gyro_ff, i, &_, &imu_ts) && (int64_t)imu_ts >= base_rel_ts) {
+		i++;
+	}
+	i--;
+
+	t.imu_integ.valid = true;
+	t.imu_integ.base_ts = base_rel_ts;
+	t.imu_integ.ts = base_rel_ts;
+	t.imu_integ.rel = base_rel;
+
+	for (; i >= 0; i--) { // Decreasing i increases timestamp
+		xrt_vec3 g{};
+		xrt_vec3 a{};
+		uint64_t g_ts{};
+		uint64_t a_ts{};
+		bool got = true;
+		got &= m_ff_vec3_f32_get(t.gyro_ff, i, &g, &g_ts);
+		got &= m_ff_vec3_f32_get(t.accel_ff, i, &a, &a_ts);
+		SLAM_DASSERT(got && g_ts == a_ts, "Failure getting synced gyro and accel samples");
+
+		integrate_imu_sample(t, g, a, (timepoint_ns)g_ts, t.imu_integ.rel, t.imu_integ.ts);
+	}
+}
+
 //! Integrates IMU samples on top of a base pose and predicts from that
 static void
 predict_pose_from_imu(TrackerSlam &t,
@@ -835,10 +1100,6 @@ predict_pose_from_imu(TrackerSlam &t,
 
 	xrt_space_relation integ_rel = base_rel;
 	timepoint_ns integ_rel_ts = base_rel_ts;
-	xrt_quat &o = integ_rel.pose.orientation;
-	xrt_vec3 &p = integ_rel.pose.position;
-	xrt_vec3 &w = integ_rel.angular_velocity;
-	xrt_vec3 &v = integ_rel.linear_velocity;
 	bool clamped = false; // If when_ns is older than the latest IMU ts
 
 	while (i >= 0) { // Decreasing i increases timestamp
@@ -864,23 +1125,7 @@ predict_pose_from_imu(TrackerSlam &t,
 		SLAM_DASSERT(got && g_ts == a_ts, "Failure getting synced gyro and accel samples");
 		SLAM_DASSERT(ts >= base_rel_ts, "Accessing imu sample that is older than latest SLAM pose");
 
-		// Update time
-		float dt = (float)time_ns_to_s(ts - integ_rel_ts);
-		integ_rel_ts = ts;
-
-		// Integrate gyroscope
-		xrt_quat angvel_delta{};
-		xrt_vec3 scaled_half_g = g * dt * 0.5f;
-		math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
-		math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
-		math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
-
-		// Integrate accelerometer
-		xrt_vec3 world_accel{};
-		math_quat_rotate_vec3(&o, &a, &world_accel);
-		world_accel += t.gravity_correction;
-		v += world_accel * dt;                        // Linear velocity
-		p += v * dt + world_accel * (dt * dt * 0.5f); // Position
+		integrate_imu_sample(t, g, a, ts, integ_rel, integ_rel_ts);
 
 		if (clamped) {
 			break;
@@ -933,6 +1178,23 @@ predict_pose(TrackerSlam &t, timepoint_ns when_ns, struct xrt_space_relation *ou
 
 
 	if (t.pred_type == SLAM_PRED_IP_IO_IA_IL) {
+		// The IMU samples are integrated as they arrive, only predict from the last one when possible.
+		os_mutex_lock(&t.lock_ff);
+		if (!t.imu_integ.valid || t.imu_integ.base_ts != (int64_t)rel_ts) {
+			rebase_imu_integration_locked(t, rel, (int64_t)rel_ts);
+		}
+		bool use_integ = when_ns >= t.imu_integ.ts;
+		xrt_space_relation integ_rel = t.imu_integ.rel;
+		timepoint_ns integ_rel_ts = t.imu_integ.ts;
+		os_mutex_unlock(&t.lock_ff);
+
+		if (use_integ) {
+			double last_imu_to_now_dt = time_ns_to_s(when_ns - integ_rel_ts);
+			m_predict_relation(&integ_rel, last_imu_to_now_dt, out_relation);
+			return;
+		}
+
+		// Asking for a time between IMU samples, integrate up to it.
 		predict_pose_from_imu(t, when_ns, rel, (int64_t)rel_ts, out_relation);
 		return;
 	}
@@ -1041,6 +1303,7 @@ setup_ui(TrackerSlam &t)
 	u_var_add_root(&t, "SLAM Tracker", true);
 	u_var_add_log_level(&t, &t.log_level, "Log Level");
 	u_var_add_bool(&t, &t.submit, "Submit data to SLAM");
+	u_var_add_ro_text(&t, t.map.state, "Saved map");
 
 	u_var_button_cb reset_state_cb = [](void *t_ptr) {
 		TrackerSlam &t = *(TrackerSlam *)t_ptr;
@@ -1252,6 +1515,12 @@ t_slam_get_tracked_pose(struct xrt_tracked_slam *xts, timepoint_ns when_ns, stru
 	filter_pose(t, when_ns, out_relation);
 	t.filt_traj_writer->push({when_ns, out_relation->pose});
 
+	// Until then the pose is not in the space of the saved map, don't let apps anchor things to it
+	if (!t.map.localized) {
+		int tracked = XRT_SPACE_RELATION_POSITION_TRACKED_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
+		out_relation->relation_flags = xrt_space_relation_flags(out_relation->relation_flags & ~tracked);
+	}
+
 	t.last_rel = *out_relation;
 	t.last_ts = when_ns;
 
@@ -1260,6 +1529,22 @@ t_slam_get_tracked_pose(struct xrt_tracked_slam *xts, timepoint_ns when_ns, stru
 	}
 }
 
+extern "C" void
+t_slam_get_stats(struct xrt_tracked_slam *xts, struct t_slam_stats *out_stats)
+{
+	auto &t = *container_of(xts, TrackerSlam, base);
+
+	*out_stats = {};
+
+	unique_lock lock(t.stats.mutex);
+	out_stats->pose_count = t.stats.tracked->size();
+	compute_trajectory_errors(t, *out_stats);
+	compute_stage_timings(t, *out_stats);
+
+	out_stats->map_loaded = t.map.loaded;
+	out_stats->map_localized = t.map.localized;
+}
+
 //! Receive and register ground truth to use for trajectory error metrics.
 extern "C" void
 t_slam_gt_sink_push(struct xrt_pose_sink *sink, xrt_pose_sample *sample)
@@ -1331,9 +1616,69 @@ t_slam_receive_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 	os_mutex_lock(&t.lock_ff);
 	m_ff_vec3_f32_push(t.gyro_ff, &gyro, ts);
 	m_ff_vec3_f32_push(t.accel_ff, &accel, ts);
+	if (t.imu_integ.valid && ts > t.imu_integ.ts) {
+		integrate_imu_sample(t, gyro, accel, ts, t.imu_integ.rel, t.imu_integ.ts);
+	}
 	os_mutex_unlock(&t.lock_ff);
 }
 
+/*!
+ * Keeps a frame alive for as long as the SLAM system holds on to the image
+ * data, frames from a @ref u_frame_pool go back to it when released.
+ */
+struct SlamImgBuffer
+{
+	vit_img_buffer_t base = {};
+	xrt_reference reference = {};
+	xrt_frame *frame = nullptr;
+};
+
+static void
+slam_img_buffer_retain(vit_img_buffer_t *buffer)
+{
+	auto *b = container_of(buffer, SlamImgBuffer, base);
+	xrt_reference_inc(&b->reference);
+}
+
+static void
+slam_img_buffer_release(vit_img_buffer_t *buffer)
+{
+	auto *b = container_of(buffer, SlamImgBuffer, base);
+	if (!xrt_reference_dec_and_is_zero(&b->reference)) {
+		return;
+	}
+
+	xrt_frame_reference(&b->frame, NULL);
+	delete b;
+}
+
+/*!
+ * Block until the SLAM system produced a pose for the frame at @p ts, used in
+ * lockstep mode so that a source pushing as fast as it can does not get ahead
+ * of the tracker and runs are reproducible. Gives up after a timeout, as the
+ * system might never produce a pose for some frames, e.g. while initializing.
+ */
+static void
+wait_for_frame_pose(TrackerSlam &t, timepoint_ns ts)
+{
+	XRT_TRACE_MARKER();
+
+	timepoint_ns start = os_monotonic_get_ns();
+	while (t.last_pose_ts < ts) {
+		flush_poses(t);
+		if (t.last_pose_ts >= ts) {
+			break;
+		}
+
+		if (os_monotonic_get_ns() - start > LOCKSTEP_TIMEOUT_NS) {
+			SLAM_DEBUG("No pose for frame ts=%ld in lockstep mode, continuing", ts);
+			break;
+		}
+
+		os_nanosleep(U_TIME_1MS_IN_NS / 10);
+	}
+}
+
 //! Push the frame to the external SLAM system
 static void
 receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
@@ -1405,9 +1750,24 @@ receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
 		sample.masks = masks.empty() ? nullptr : masks.data();
 	}
 
-	{
-		XRT_TRACE_IDENT(slam_push);
+	XRT_TRACE_IDENT(slam_push);
+
+	if (t.vit.tracker_push_img_buffer_sample == NULL) {
 		t.vit.tracker_push_img_sample(t.tracker, &sample);
+	} else {
+		// Let the SLAM system retain the frame instead of copying it, our reference is dropped once pushed.
+		auto *buffer = new SlamImgBuffer();
+		buffer->base.retain = slam_img_buffer_retain;
+		buffer->base.release = slam_img_buffer_release;
+		xrt_reference_inc(&buffer->reference);
+		xrt_frame_reference(&buffer->frame, frame);
+
+		t.vit.tracker_push_img_buffer_sample(t.tracker, &sample, &buffer->base);
+		slam_img_buffer_release(&buffer->base);
+	}
+
+	if (t.lockstep && cam_index == t.cam_count - 1) {
+		wait_for_frame_pose(t, ts);
 	}
 }
 
@@ -1436,6 +1796,71 @@ void (*t_slam_receive_cam[XRT_TRACKING_MAX_SLAM_CAMS])(xrt_frame_sink *, xrt_fra
 };
 
 
+//! Save the map for the next session, unless it would replace a loaded map we never found ourselves in.
+static void
+save_map(TrackerSlam &t)
+{
+	if (t.map.path.empty() || t.vit.tracker_save_map == NULL) {
+		return;
+	}
+
+	if (t.map.loaded && !t.map.localized) {
+		SLAM_WARN("Never relocalized in the map from '%s', not replacing it", t.map.path.c_str());
+		return;
+	}
+
+	vit_result_t vres = t.vit.tracker_save_map(t.tracker, t.map.path.c_str());
+	if (vres != VIT_SUCCESS) {
+		SLAM_ERROR("Failed to save the map to '%s' (%d)", t.map.path.c_str(), vres);
+		return;
+	}
+
+	SLAM_INFO("Saved the map to '%s'", t.map.path.c_str());
+}
+
+//! Find where the map of @p key is stored and load it if it exists, must be called before starting the tracker.
+static void
+load_map(TrackerSlam &t, const char *key)
+{
+	if (key == nullptr || key[0] == '\0') {
+		return;
+	}
+
+	if (t.vit.tracker_save_map == NULL || t.vit.tracker_load_map == NULL) {
+		SLAM_WARN("The VIT system can't save or load maps, ignoring map '%s'", key);
+		return;
+	}
+
+#ifdef XRT_OS_LINUX
+	char path[1024];
+	string filename = string{key} + ".map";
+	if (u_file_get_path_in_config_dir_subpath("slam_maps", filename.c_str(), path, sizeof(path)) <= 0) {
+		SLAM_WARN("Failed to get the path of map '%s'", key);
+		return;
+	}
+	t.map.path = path;
+#else
+	SLAM_WARN("Saving maps is only supported on Linux, ignoring map '%s'", key);
+	return;
+#endif
+
+	if (!std::filesystem::exists(t.map.path)) {
+		SLAM_INFO("No map at '%s' yet, it will be saved there", t.map.path.c_str());
+		return;
+	}
+
+	vit_result_t vres = t.vit.tracker_load_map(t.tracker, t.map.path.c_str());
+	if (vres != VIT_SUCCESS) {
+		SLAM_WARN("Failed to load the map from '%s' (%d), starting a new one", t.map.path.c_str(), vres);
+		return;
+	}
+
+	t.map.loaded = true;
+	t.map.localized = t.vit.tracker_is_map_localized == NULL;
+	snprintf(t.map.state, sizeof(t.map.state), "%s", t.map.localized ? "Loaded" : "Relocalizing");
+	SLAM_INFO("Loaded the map from '%s'", t.map.path.c_str());
+}
+
 extern "C" void
 t_slam_node_break_apart(struct xrt_frame_node *node)
 {
@@ -1450,6 +1875,8 @@ t_slam_node_break_apart(struct xrt_frame_node *node)
 		return;
 	}
 
+	save_map(t);
+
 	SLAM_DEBUG("SLAM tracker dismantled");
 }
 
@@ -1463,6 +1890,8 @@ t_slam_node_destroy(struct xrt_frame_node *node)
 		t_openvr_tracker_destroy(t.ovr_tracker);
 	}
 	delete t.gt.trajectory;
+	delete t.stats.tracked;
+	delete t.stats.timings;
 	delete t.slam_times_writer;
 	delete t.slam_features_writer;
 	delete t.slam_traj_writer;
@@ -1506,6 +1935,7 @@ t_slam_fill_default_config(struct t_slam_tracker_config *config)
 	config->slam_config = debug_get_option_slam_config();
 	config->slam_ui = debug_get_bool_option_slam_ui();
 	config->submit_from_start = debug_get_bool_option_slam_submit_from_start();
+	config->lockstep = debug_get_bool_option_slam_lockstep();
 	config->openvr_groundtruth_device = int(debug_get_num_option_slam_openvr_groundtruth_device());
 	config->prediction = t_slam_prediction_type(debug_get_num_option_slam_prediction_type());
 	config->write_csvs = debug_get_bool_option_slam_write_csvs();
@@ -1514,6 +1944,7 @@ t_slam_fill_default_config(struct t_slam_tracker_config *config)
 	config->features_stat = debug_get_bool_option_slam_features_stat();
 	config->cam_count = int(debug_get_num_option_slam_cam_count());
 	config->slam_calib = NULL;
+	config->map_key = debug_get_option_slam_map();
 }
 
 extern "C" int
@@ -1576,6 +2007,8 @@ t_slam_create(struct xrt_frame_context *xfctx,
 		SLAM_INFO("Using sensor calibration provided by the SLAM_CONFIG file");
 	}
 
+	load_map(t, config->map_key);
+
 	SLAM_ASSERT(t_slam_receive_cam[ARRAY_SIZE(t_slam_receive_cam) - 1] != nullptr, "See `cam_sink_push` docs");
 	t.sinks.cam_count = config->cam_count;
 	for (int i = 0; i < XRT_TRACKING_MAX_SLAM_CAMS; i++) {
@@ -1594,6 +2027,7 @@ t_slam_create(struct xrt_frame_context *xfctx,
 
 	t.submit = config->submit_from_start;
 	t.cam_count = config->cam_count;
+	t.lockstep = config->lockstep;
 
 	t.node.break_apart = t_slam_node_break_apart;
 	t.node.destroy = t_slam_node_destroy;
@@ -1603,6 +2037,7 @@ t_slam_create(struct xrt_frame_context *xfctx,
 	t.euroc_recorder = euroc_recorder_create(xfctx, NULL, t.cam_count, false);
 
 	t.last_imu_ts = INT64_MIN;
+	t.last_pose_ts = INT64_MIN;
 	t.last_cam_ts = vector<timepoint_ns>(t.cam_count, INT64_MIN);
 	t.last_hand_masks = xrt_hand_masks_sample{};
 
@@ -1612,6 +2047,8 @@ t_slam_create(struct xrt_frame_context *xfctx,
 	m_filter_euro_quat_init(&t.filter.rot_oe, t.filter.min_cutoff, t.filter.min_dcutoff, t.filter.beta);
 
 	t.gt.trajectory = new Trajectory{};
+	t.stats.tracked = new Trajectory{};
+	t.stats.timings = new vector<timing_sample>{};
 
 	// Setup CSV files
 	bool write_csvs = config->write_csvs;
@@ -1624,6 +2061,11 @@ t_slam_create(struct xrt_frame_context *xfctx,
 
 	setup_ui(t);
 
+	// Same as pressing the UI button, the columns are already known by now
+	if (config->timing_stat && !t.timing.enable_btn.disabled) {
+		t.timing.enable_btn.cb(&t);
+	}
+
 	// Setup OpenVR groundtruth tracker
 	if (config->openvr_groundtruth_device > 0) {
 		enum openvr_device dev_class = openvr_device(config->openvr_groundtruth_device);
@@ -652,6 +652,7 @@ struct t_slam_tracker_config
 	int cam_count;                       //!< Number of cameras in use
 	bool slam_ui;                        //!< Whether to open the external UI of the external SLAM system
 	bool submit_from_start;              //!< Whether to submit data to the SLAM tracker without user action
+	bool lockstep;                       //!< Whether pushing a frame waits for its pose, for reproducible runs
 	int openvr_groundtruth_device;       //!< If >0, use lighthouse as groundtruth, see @ref openvr_device
 	enum t_slam_prediction_type prediction; //!< Which level of prediction to use
 	bool write_csvs;                        //!< Whether to enable CSV writers from the start for later analysis
@@ -661,6 +662,10 @@ struct t_slam_tracker_config
 
 	//!< Instead of a slam_config file you can set custom calibration data
 	const struct t_slam_calibration *slam_calib;
+
+	//! Name of the map to load on start and save on shutdown, like a room name or the device serial, NULL to not
+	//! keep one. Stored in the `slam_maps` config directory, needs a VIT system that supports maps.
+	const char *map_key;
 };
 
 /*!
@@ -686,6 +691,69 @@ t_slam_create(struct xrt_frame_context *xfctx,
 int
 t_slam_start(struct xrt_tracked_slam *xts);
 
+//! Max number of pipeline stages reported in @ref t_slam_stats.
+#define T_SLAM_STATS_MAX_STAGES (16)
+
+//! Time between the two poses compared for the relative pose error in @ref t_slam_stats.
+#define T_SLAM_STATS_RPE_DELTA_NS (1000000000)
+
+/*!
+ * Duration of one stage of the SLAM pipeline over all poses of a run.
+ *
+ * @see t_slam_stats
+ */
+struct t_slam_stats_stage
+{
+	char name[64]; //!< Timing column the stage ends at, the stage starts at the previous column
+	uint32_t count;
+	double mean_ms;
+	double p50_ms;
+	double p95_ms;
+	double max_ms;
+};
+
+/*!
+ * Accuracy and performance of the SLAM tracker over everything it has tracked
+ * so far, for evaluating runs on datasets.
+ *
+ * Errors are computed against the ground truth pushed to the gt sink, with
+ * the same fixed alignment used for the realtime error in the UI, so they are
+ * only meaningful for datasets where that alignment holds (EuRoC with Basalt).
+ * Only positions are compared.
+ *
+ * @see xrt_tracked_slam
+ */
+struct t_slam_stats
+{
+	uint32_t pose_count; //!< Poses dequeued from the SLAM system
+
+	uint32_t ate_count; //!< Poses within the ground truth, zero if there was none
+	double ate_rmse_m;  //!< Absolute trajectory error
+	double ate_mean_m;
+	double ate_max_m;
+
+	uint32_t rpe_count; //!< Pose pairs @ref T_SLAM_STATS_RPE_DELTA_NS apart within the ground truth
+	double rpe_rmse_m;  //!< Relative pose error, translation only
+	double rpe_mean_m;
+
+	//! From the first to the last timing column, the stages below add up to this.
+	struct t_slam_stats_stage total;
+
+	uint32_t stage_count;
+	struct t_slam_stats_stage stages[T_SLAM_STATS_MAX_STAGES];
+
+	bool map_loaded;    //!< Whether a saved map was loaded at start, see @ref t_slam_tracker_config::map_key
+	bool map_localized; //!< Whether the tracker has relocalized in it, poses are only tracked once it has
+};
+
+/*!
+ * Computes @ref t_slam_stats from all the poses tracked so far.
+ *
+ * @public @memberof xrt_tracked_slam
+ */
+void
+t_slam_get_stats(struct xrt_tracked_slam *xts, struct t_slam_stats *out_stats);
+
 /*
  *
  * Camera calibration
@@ -708,6 +776,8 @@ struct t_calibration_status
 {
 	//! Is calibration finished?
 	bool finished;
+	//! Are all frames collected and the solver running on them?
+	bool solving;
 	//! Was the target found this frame?
 	bool found;
 	//! Number of frames collected
@@ -37,6 +37,22 @@ vit_get_proc(void *handle, const char *name, void *proc_ptr)
 #endif
 }
 
+static inline void
+vit_get_optional_proc(void *handle, const char *name, void *proc_ptr)
+{
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_ANDROID)
+	void *proc = dlsym(handle, name);
+	if (proc == NULL) {
+		(void)dlerror(); // Clear the error, a missing symbol is fine here.
+		U_LOG_I("Optional symbol %s not found", name);
+	}
+
+	*(void **)proc_ptr = proc;
+#else
+#error "Unknown platform"
+#endif
+}
+
 bool
 t_vit_bundle_load(struct t_vit_bundle *vit, const char *path)
 {
@@ -92,6 +108,22 @@ t_vit_bundle_load(struct t_vit_bundle *vit, const char *path)
 	GET_PROC(pose_get_features);
 #undef GET_PROC
 
+	// Optional functions, missing from older versions.
+	vit->tracker_push_img_buffer_sample = NULL;
+	if (vit->version.minor >= 1) {
+		vit_get_optional_proc(vit->handle, "vit_tracker_push_img_buffer_sample",
+		                      &vit->tracker_push_img_buffer_sample);
+	}
+
+	vit->tracker_save_map = NULL;
+	vit->tracker_load_map = NULL;
+	vit->tracker_is_map_localized = NULL;
+	if (vit->version.minor >= 2) {
+		vit_get_optional_proc(vit->handle, "vit_tracker_save_map", &vit->tracker_save_map);
+		vit_get_optional_proc(vit->handle, "vit_tracker_load_map", &vit->tracker_load_map);
+		vit_get_optional_proc(vit->handle, "vit_tracker_is_map_localized", &vit->tracker_is_map_localized);
+	}
+
 	return true;
 }
 
@@ -45,6 +45,10 @@ struct t_vit_bundle
 	PFN_vit_tracker_is_running tracker_is_running;
 	PFN_vit_tracker_push_imu_sample tracker_push_imu_sample;
 	PFN_vit_tracker_push_img_sample tracker_push_img_sample;
+	PFN_vit_tracker_push_img_buffer_sample tracker_push_img_buffer_sample; //!< Optional, may be NULL.
+	PFN_vit_tracker_save_map tracker_save_map;                             //!< Optional, may be NULL.
+	PFN_vit_tracker_load_map tracker_load_map;                             //!< Optional, may be NULL.
+	PFN_vit_tracker_is_map_localized tracker_is_map_localized;             //!< Optional, may be NULL.
 	PFN_vit_tracker_add_imu_calibration tracker_add_imu_calibration;
 	PFN_vit_tracker_add_camera_calibration tracker_add_camera_calibration;
 	PFN_vit_tracker_pop_pose tracker_pop_pose;
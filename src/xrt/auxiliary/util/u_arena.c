@@ -0,0 +1,195 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Linear arena allocator for per-frame scratch memory.
+ * @ingroup aux_util
+ */
+
+#include "util/u_arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+struct u_arena_block
+{
+	//! Previously filled block, NULL for the first one.
+	struct u_arena_block *prev;
+
+	//! Bytes of data following the header.
+	size_t size;
+
+	//! Bytes of data handed out.
+	size_t used;
+};
+
+//! Data starts after the header, at an offset that keeps it max aligned.
+#define HEADER_SIZE                                                                                                    \
+	((sizeof(struct u_arena_block) + U_ARENA_ALIGNOF(max_align_t) - 1) & ~(U_ARENA_ALIGNOF(max_align_t) - 1))
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint8_t *
+block_data(struct u_arena_block *block)
+{
+	return (uint8_t *)block + HEADER_SIZE;
+}
+
+static inline bool
+is_power_of_two(size_t v)
+{
+	return v != 0 && (v & (v - 1)) == 0;
+}
+
+//! Pointer into @p block for the allocation, or NULL if it doesn't fit.
+static void *
+block_try_alloc(struct u_arena_block *block, size_t size, size_t alignment)
+{
+	uintptr_t start = (uintptr_t)block_data(block);
+	uintptr_t ptr = (start + block->used + alignment - 1) & ~((uintptr_t)alignment - 1);
+	size_t offset = (size_t)(ptr - start);
+
+	if (offset > block->size || size > block->size - offset) {
+		return NULL;
+	}
+
+	block->used = offset + size;
+
+	return (void *)ptr;
+}
+
+static struct u_arena_block *
+block_create(struct u_arena_block *prev, size_t size)
+{
+	struct u_arena_block *block = malloc(HEADER_SIZE + size);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->prev = prev;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+static void
+free_blocks(struct u_arena *arena)
+{
+	struct u_arena_block *block = arena->current;
+	while (block != NULL) {
+		struct u_arena_block *prev = block->prev;
+		free(block);
+		block = prev;
+	}
+	arena->current = NULL;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_arena_init(struct u_arena *arena, size_t block_size)
+{
+	arena->current = NULL;
+	arena->block_size = block_size != 0 ? block_size : U_ARENA_DEFAULT_BLOCK_SIZE;
+}
+
+void *
+u_arena_alloc(struct u_arena *arena, size_t size, size_t alignment)
+{
+	if (alignment == 0) {
+		alignment = U_ARENA_ALIGNOF(max_align_t);
+	}
+	assert(is_power_of_two(alignment));
+
+	if (arena->current != NULL) {
+		void *ptr = block_try_alloc(arena->current, size, alignment);
+		if (ptr != NULL) {
+			return ptr;
+		}
+	}
+
+	// Also make room for the worst case alignment padding.
+	size_t needed = size + alignment;
+	if (needed < size) {
+		return NULL;
+	}
+
+	size_t block_size = arena->block_size;
+	if (block_size < needed) {
+		block_size = needed;
+	}
+
+	struct u_arena_block *block = block_create(arena->current, block_size);
+	if (block == NULL) {
+		return NULL;
+	}
+	arena->current = block;
+
+	return block_try_alloc(block, size, alignment);
+}
+
+void *
+u_arena_calloc(struct u_arena *arena, size_t count, size_t size, size_t alignment)
+{
+	if (size != 0 && count > SIZE_MAX / size) {
+		return NULL;
+	}
+
+	void *ptr = u_arena_alloc(arena, count * size, alignment);
+	if (ptr != NULL) {
+		memset(ptr, 0, count * size);
+	}
+
+	return ptr;
+}
+
+void
+u_arena_reset(struct u_arena *arena)
+{
+	struct u_arena_block *block = arena->current;
+	if (block == NULL) {
+		return;
+	}
+
+	if (block->prev == NULL) {
+		block->used = 0;
+		return;
+	}
+
+	// Needed more than one block, replace them all with one that fits it all.
+	size_t total = 0;
+	for (struct u_arena_block *b = block; b != NULL; b = b->prev) {
+		total += b->size;
+	}
+
+	free_blocks(arena);
+
+	arena->block_size = total;
+	arena->current = block_create(NULL, total);
+}
+
+void
+u_arena_fini(struct u_arena *arena)
+{
+	free_blocks(arena);
+}
@@ -0,0 +1,117 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Linear arena allocator for per-frame scratch memory.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Size of the first block of an arena if none is given, in bytes.
+#define U_ARENA_DEFAULT_BLOCK_SIZE (16 * 1024)
+
+//! Alignment of @p TYPE, usable from both C and C++.
+#ifdef __cplusplus
+#define U_ARENA_ALIGNOF(TYPE) alignof(TYPE)
+#else
+#define U_ARENA_ALIGNOF(TYPE) _Alignof(TYPE)
+#endif
+
+struct u_arena_block;
+
+/*!
+ * A linear allocator, memory is handed out by bumping an offset into a block
+ * and is only given back all at once by @ref u_arena_reset. Meant to be reset
+ * at a frame boundary and used for variable length temporary data during that
+ * frame, no per allocation bookkeeping and no heap traffic once warmed up.
+ *
+ * When a block runs out a new one is chained; on reset the blocks are merged
+ * into a single one big enough for the whole of the previous frame, so after
+ * the first few frames all allocations come out of one block.
+ *
+ * Not thread safe, each arena should only be used by one thread at a time.
+ *
+ * @ingroup aux_util
+ */
+struct u_arena
+{
+	//! Block currently allocated from, the newest one.
+	struct u_arena_block *current;
+
+	//! Size of new blocks, grows to fit what one frame needs.
+	size_t block_size;
+};
+
+/*!
+ * Init the arena, does not allocate any memory until first used.
+ *
+ * @param arena      Arena to init.
+ * @param block_size Size of the first block, zero means @ref U_ARENA_DEFAULT_BLOCK_SIZE.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_init(struct u_arena *arena, size_t block_size);
+
+/*!
+ * Allocate @p size bytes aligned to @p alignment, the memory is not cleared.
+ *
+ * @param arena     Self.
+ * @param size      Number of bytes, may be zero.
+ * @param alignment Power of two alignment, zero means max_align_t.
+ *
+ * @return Pointer valid until the next reset, NULL if out of memory.
+ *
+ * @public @memberof u_arena
+ */
+void *
+u_arena_alloc(struct u_arena *arena, size_t size, size_t alignment);
+
+/*!
+ * Same as @ref u_arena_alloc but the memory is zeroed and @p count times
+ * @p size is checked for overflow.
+ *
+ * @public @memberof u_arena
+ */
+void *
+u_arena_calloc(struct u_arena *arena, size_t count, size_t size, size_t alignment);
+
+/*!
+ * Give back all memory allocated from the arena, invalidating all pointers
+ * returned from it. Keeps the memory around for the next frame.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_reset(struct u_arena *arena);
+
+/*!
+ * Free all memory held by the arena, it can be used again after
+ * @ref u_arena_init.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_fini(struct u_arena *arena);
+
+/*!
+ * Allocate a zeroed array of @p COUNT elements of @p TYPE from the arena.
+ *
+ * @ingroup aux_util
+ */
+#define U_ARENA_TYPED_ARRAY_CALLOC(ARENA, TYPE, COUNT)                                                                 \
+	((TYPE *)u_arena_calloc((ARENA), (COUNT), sizeof(TYPE), U_ARENA_ALIGNOF(TYPE)))
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,254 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Atomic loads, stores and fences with explicit ordering.
+ *
+ * Complements the read-modify-write helpers in @ref xrt_compiler.h. On MSVC
+ * plain volatile accesses have no ordering under `/volatile:iso`, which is the
+ * default on ARM, so the ordered accesses from `winnt.h` are used instead.
+ *
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ *
+ * 32 bit signed.
+ *
+ */
+
+static inline int32_t
+u_atomic_s32_load_acquire(const xrt_atomic_s32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	return ReadAcquire((const volatile LONG *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline int32_t
+u_atomic_s32_load_relaxed(const xrt_atomic_s32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	return ReadNoFence((const volatile LONG *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_s32_store_release(xrt_atomic_s32_t *p, int32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	WriteRelease((volatile LONG *)p, v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_s32_store_relaxed(xrt_atomic_s32_t *p, int32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	WriteNoFence((volatile LONG *)p, v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+/*
+ *
+ * 32 bit unsigned.
+ *
+ */
+
+static inline uint32_t
+u_atomic_u32_load_acquire(const volatile uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	return (uint32_t)ReadAcquire((const volatile LONG *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline uint32_t
+u_atomic_u32_load_relaxed(const volatile uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	return (uint32_t)ReadNoFence((const volatile LONG *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline uint32_t
+u_atomic_u32_load_seq_cst(const volatile uint32_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+	return (uint32_t)InterlockedCompareExchange((volatile LONG *)p, 0, 0);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_u32_store_release(volatile uint32_t *p, uint32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	WriteRelease((volatile LONG *)p, (LONG)v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_u32_store_relaxed(volatile uint32_t *p, uint32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+	WriteNoFence((volatile LONG *)p, (LONG)v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_u32_store_seq_cst(volatile uint32_t *p, uint32_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+#elif defined(_MSC_VER)
+	InterlockedExchange((volatile LONG *)p, (LONG)v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+/*
+ *
+ * 64 bit unsigned.
+ *
+ */
+
+static inline uint64_t
+u_atomic_u64_load_acquire(const volatile uint64_t *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	return (uint64_t)ReadAcquire64((const volatile LONG64 *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_u64_store_release(volatile uint64_t *p, uint64_t v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	WriteRelease64((volatile LONG64 *)p, (LONG64)v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+/*
+ *
+ * Pointers.
+ *
+ */
+
+static inline void *
+u_atomic_ptr_load_acquire(void *const volatile *p)
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	return ReadPointerAcquire((PVOID const volatile *)p);
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_ptr_store_release(void *volatile *p, void *v)
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	WritePointerRelease((PVOID volatile *)p, v);
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+/*
+ *
+ * Fences.
+ *
+ */
+
+static inline void
+u_atomic_fence_acquire(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+static inline void
+u_atomic_fence_release(void)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+	MemoryBarrier();
+#else
+#error "compiler not supported"
+#endif
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,7 @@
 #include <stdio.h>
 
 DEBUG_GET_ONCE_LOG_OPTION(aeg_log, "AEG_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_NUM_OPTION(aeg_update_interval, "AEG_UPDATE_INTERVAL", 1)
 
 #define AEG_TRACE(...) U_LOG_IFL_T(aeg->log_level, __VA_ARGS__)
 #define AEG_DEBUG(...) U_LOG_IFL_D(aeg->log_level, __VA_ARGS__)
@@ -110,10 +111,25 @@ struct u_autoexpgain
 	//! brightness changes.
 	int frame_delay;
 
+	//! Only every this many frames is looked at, the others are skipped
+	//! without building a histogram. The camera takes `frame_delay` frames to
+	//! apply new values anyway, so looking at every frame buys little.
+	int update_interval;
+
+	//! Frames skipped since the last one looked at.
+	int skipped_frames;
+
 	float exposure; //!< Currently computed exposure value to use
 	float gain;     //!< Currently computed gain value to use
 };
 
+//! How many frames pass between updates, `wait` counts frames not updates.
+static int
+get_update_interval(struct u_autoexpgain *aeg)
+{
+	return MAX(aeg->update_interval, 1);
+}
+
 static const char *
 state_to_string(enum u_aeg_state state)
 {
@@ -191,8 +207,8 @@ set_state(struct u_autoexpgain *aeg, enum u_aeg_action action)
 			aeg->overshoots++;
 			new_state = DARKEN;
 		} else if (action == GOOD) {
-			aeg->wait--;
-			new_state = aeg->wait == 0 ? IDLE : STOP_BRIGHTEN;
+			aeg->wait -= get_update_interval(aeg);
+			new_state = aeg->wait <= 0 ? IDLE : STOP_BRIGHTEN;
 		} else {
 			AEG_ASSERT_(false);
 		}
@@ -218,8 +234,8 @@ set_state(struct u_autoexpgain *aeg, enum u_aeg_action action)
 		} else if (action == BRIGHT) {
 			new_state = DARKEN;
 		} else if (action == GOOD) {
-			aeg->wait--;
-			new_state = aeg->wait == 0 ? IDLE : STOP_DARKEN;
+			aeg->wait -= get_update_interval(aeg);
+			new_state = aeg->wait <= 0 ? IDLE : STOP_DARKEN;
 		} else {
 			AEG_ASSERT_(false);
 		}
@@ -325,17 +341,20 @@ get_score(struct u_autoexpgain *aeg, struct xrt_frame *xf)
 {
 	uint32_t w = xf->width;
 	uint32_t h = xf->height;
-	uint32_t s = w / GRID_COLS; // Grid cell size
+	uint32_t s = MAX(w / GRID_COLS, 1); // Grid cell size
 
 	// Compute histogram (PDF)
 	int histogram[LEVELS] = {0};
 	int samples_count = 0;
 	size_t pixel_size = u_format_block_size(xf->format);
+	size_t step = s * pixel_size;
 	for (uint32_t y = 0; y < h; y += s) {
-		for (uint32_t x = 0; x < w; x += s) {
-			// Note that for multichannel images only the first channel is in use.
-			uint8_t intensity = xf->data[y * xf->stride + x * pixel_size];
-			histogram[intensity]++;
+		const uint8_t *row = xf->data + y * xf->stride;
+		const uint8_t *end = row + w * pixel_size;
+
+		// Note that for multichannel images only the first channel is in use.
+		for (const uint8_t *p = row; p < end; p += step) {
+			histogram[*p]++;
 			samples_count++;
 		}
 	}
@@ -447,6 +466,8 @@ u_autoexpgain_create(enum u_aeg_strategy strategy, bool enabled_from_start, int
 
 	aeg->threshold = INITIAL_THRESHOLD;
 	aeg->frame_delay = frame_delay;
+	aeg->update_interval = (int)debug_get_num_option_aeg_update_interval();
+	aeg->skipped_frames = 0;
 
 	brightness_to_expgain(aeg, INITIAL_BRIGHTNESS, &aeg->exposure, &aeg->gain);
 
@@ -467,6 +488,9 @@ u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix)
 	(void)snprintf(tmp, sizeof(tmp), "%sFrame update delay", prefix);
 	u_var_add_i32(root, &aeg->frame_delay, tmp);
 
+	(void)snprintf(tmp, sizeof(tmp), "%sUpdate every N frames", prefix);
+	u_var_add_i32(root, &aeg->update_interval, tmp);
+
 	(void)snprintf(tmp, sizeof(tmp), "%sStrategy", prefix);
 	u_var_add_combo(root, &aeg->strategy_combo, tmp);
 
@@ -494,6 +518,11 @@ u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix)
 void
 u_autoexpgain_update(struct u_autoexpgain *aeg, struct xrt_frame *xf)
 {
+	if (++aeg->skipped_frames < get_update_interval(aeg)) {
+		return;
+	}
+	aeg->skipped_frames = 0;
+
 	update_brightness(aeg, xf);
 	update_expgain(aeg);
 }
@@ -41,7 +41,10 @@ u_autoexpgain_create(enum u_aeg_strategy strategy, bool enabled_from_start, int
 void
 u_autoexpgain_add_vars(struct u_autoexpgain *aeg, void *root, char *prefix);
 
-//! Update the AEG with a frame
+/*!
+ * Update the AEG with a frame, only every `AEG_UPDATE_INTERVAL` frames is
+ * looked at, the others return straight away.
+ */
 void
 u_autoexpgain_update(struct u_autoexpgain *aeg, struct xrt_frame *xf);
 
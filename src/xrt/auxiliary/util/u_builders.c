@@ -13,6 +13,7 @@
 
 #include "util/u_debug.h"
 #include "util/u_builders.h"
+#include "util/u_device_timing.h"
 #include "util/u_system_helpers.h"
 #include "util/u_space_overseer.h"
 
@@ -221,6 +222,23 @@ u_builder_roles_helper_open_system(struct xrt_builder *xb,
 		return xret;
 	}
 
+	/*
+	 * Optionally time calls, before anything else holds on to the devices.
+	 */
+
+	if (u_device_timing_is_enabled()) {
+		struct xrt_device **const roles[] = {
+		    &ubrh.head,
+		    &ubrh.left,
+		    &ubrh.right,
+		    &ubrh.hand_tracking.left,
+		    &ubrh.hand_tracking.right,
+		};
+
+		u_device_timing_wrap_all(xsysd->xdevs, (uint32_t)xsysd->xdev_count, roles, ARRAY_SIZE(roles));
+	}
+
+
 	/*
 	 * Assign to role(s).
 	 */
@@ -1,57 +1,158 @@
-// Copyright 2022, Collabora, Ltd.
+// Copyright 2022-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::deque to C
+ * @brief  Expose a small buffer optimised deque to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
  */
 
 #include "u_deque.h"
 #include "util/u_time.h"
-#include <deque>
 
-using std::deque;
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace {
+
+/*!
+ * Ring buffer that starts out with inline storage, the capacity is always a
+ * power of two so wrapping is a mask. Only growing allocates.
+ */
+template <typename T> class small_ring
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only for plain old data");
+
+public:
+	void
+	push_back(T e)
+	{
+		if (mSize == mCapacity) {
+			reserve(mCapacity * 2);
+		}
+		mData[(mHead + mSize) & (mCapacity - 1)] = e;
+		mSize++;
+	}
+
+	bool
+	pop_front(T *e)
+	{
+		if (mSize == 0) {
+			return false;
+		}
+		*e = mData[mHead];
+		mHead = (mHead + 1) & (mCapacity - 1);
+		mSize--;
+		return true;
+	}
+
+	T
+	at(size_t i) const
+	{
+		if (i >= mSize) {
+			throw std::out_of_range("small_ring::at");
+		}
+		return mData[(mHead + i) & (mCapacity - 1)];
+	}
+
+	size_t
+	size() const
+	{
+		return mSize;
+	}
+
+	void
+	clear()
+	{
+		mHead = 0;
+		mSize = 0;
+	}
+
+	void
+	reserve(size_t capacity)
+	{
+		if (capacity <= mCapacity) {
+			return;
+		}
+
+		size_t new_capacity = mCapacity;
+		while (new_capacity < capacity) {
+			new_capacity *= 2;
+		}
+
+		// Unwrap the elements to the start of the new storage.
+		std::unique_ptr<T[]> storage(new T[new_capacity]);
+		for (size_t i = 0; i < mSize; i++) {
+			storage[i] = mData[(mHead + i) & (mCapacity - 1)];
+		}
+
+		mHeap = std::move(storage);
+		mData = mHeap.get();
+		mCapacity = new_capacity;
+		mHead = 0;
+	}
+
+private:
+	T mInline[U_DEQUE_INLINE_CAPACITY];
+	std::unique_ptr<T[]> mHeap;
+	T *mData = mInline;
+	size_t mCapacity = U_DEQUE_INLINE_CAPACITY;
+	size_t mHead = 0;
+	size_t mSize = 0;
+};
+
+static_assert((U_DEQUE_INLINE_CAPACITY & (U_DEQUE_INLINE_CAPACITY - 1)) == 0, "Must be a power of two");
+
+} // namespace
 
 #define U_DEQUE_IMPLEMENTATION(TYPE)                                                                                   \
 	u_deque_##TYPE u_deque_##TYPE##_create()                                                                       \
 	{                                                                                                              \
-		u_deque_##TYPE ud{new deque<TYPE>};                                                                    \
+		u_deque_##TYPE ud{new small_ring<TYPE>};                                                               \
 		return ud;                                                                                             \
 	}                                                                                                              \
                                                                                                                        \
 	void u_deque_##TYPE##_push_back(u_deque_##TYPE ud, TYPE e)                                                     \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
 		d->push_back(e);                                                                                       \
 	}                                                                                                              \
                                                                                                                        \
 	bool u_deque_##TYPE##_pop_front(u_deque_##TYPE ud, TYPE *e)                                                    \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
-		bool pop = !d->empty();                                                                                \
-		if (pop) {                                                                                             \
-			*e = d->front();                                                                               \
-			d->erase(d->begin());                                                                          \
-		}                                                                                                      \
-		return pop;                                                                                            \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
+		return d->pop_front(e);                                                                                \
 	}                                                                                                              \
                                                                                                                        \
 	TYPE u_deque_##TYPE##_at(u_deque_##TYPE ud, size_t i)                                                          \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
 		return d->at(i);                                                                                       \
 	}                                                                                                              \
                                                                                                                        \
 	size_t u_deque_##TYPE##_size(u_deque_##TYPE ud)                                                                \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud.ptr);                                                   \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
 		return d->size();                                                                                      \
 	}                                                                                                              \
                                                                                                                        \
+	void u_deque_##TYPE##_reserve(u_deque_##TYPE ud, size_t capacity)                                              \
+	{                                                                                                              \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
+		d->reserve(capacity);                                                                                  \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_deque_##TYPE##_clear(u_deque_##TYPE ud)                                                                 \
+	{                                                                                                              \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud.ptr);                                         \
+		d->clear();                                                                                            \
+	}                                                                                                              \
+                                                                                                                       \
 	void u_deque_##TYPE##_destroy(u_deque_##TYPE *ud)                                                              \
 	{                                                                                                              \
-		deque<TYPE> *d = static_cast<deque<TYPE> *>(ud->ptr);                                                  \
+		small_ring<TYPE> *d = static_cast<small_ring<TYPE> *>(ud->ptr);                                        \
 		delete d;                                                                                              \
 		ud->ptr = nullptr;                                                                                     \
 	}
@@ -16,6 +16,16 @@
 extern "C" {
 #endif
 
+/*!
+ * Number of elements a deque holds before allocating more memory, the
+ * storage is kept when elements are removed.
+ */
+#define U_DEQUE_INLINE_CAPACITY (16)
+
+/*!
+ * Declares a ring buffer backed deque of a plain old data type, only
+ * allocating when growing past the inline or reserved capacity.
+ */
 #define U_DEQUE_DECLARATION(TYPE)                                                                                      \
 	struct u_deque_##TYPE                                                                                          \
 	{                                                                                                              \
@@ -26,6 +36,8 @@ extern "C" {
 	bool u_deque_##TYPE##_pop_front(struct u_deque_##TYPE ud, TYPE *e);                                            \
 	TYPE u_deque_##TYPE##_at(struct u_deque_##TYPE ud, size_t i);                                                  \
 	size_t u_deque_##TYPE##_size(struct u_deque_##TYPE wrap);                                                      \
+	void u_deque_##TYPE##_reserve(struct u_deque_##TYPE ud, size_t capacity);                                      \
+	void u_deque_##TYPE##_clear(struct u_deque_##TYPE ud);                                                         \
 	void u_deque_##TYPE##_destroy(struct u_deque_##TYPE *ud);
 
 U_DEQUE_DECLARATION(timepoint_ns)
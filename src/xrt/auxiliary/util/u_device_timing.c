@@ -0,0 +1,388 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Device wrapper that measures how long driver calls take.
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_metrics.h"
+#include "util/u_device_timing.h"
+
+#include <stdio.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+//! How often the call rates and debug gui values are updated and the stats published.
+#define PUBLISH_PERIOD_NS (250 * U_TIME_1MS_IN_NS)
+
+DEBUG_GET_ONCE_BOOL_OPTION(device_timing, "XRT_DEVICE_TIMING", false)
+
+static const char *call_names[U_METRICS_DEVICE_CALL_COUNT] = {
+    [U_METRICS_DEVICE_CALL_GET_TRACKED_POSE] = "get_tracked_pose",
+    [U_METRICS_DEVICE_CALL_GET_HAND_TRACKING] = "get_hand_tracking",
+    [U_METRICS_DEVICE_CALL_UPDATE_INPUTS] = "update_inputs",
+    [U_METRICS_DEVICE_CALL_SET_OUTPUT] = "set_output",
+    [U_METRICS_DEVICE_CALL_GET_VIEW_POSES] = "get_view_poses",
+};
+
+/*!
+ * Values shown in the debug gui for one entry point, only updated every
+ * @ref PUBLISH_PERIOD_NS so the gui doesn't need to take the lock.
+ */
+struct timing_call_ui
+{
+	bool header;
+
+	uint64_t count;
+	float rate;
+	float mean_ms;
+	float max_ms;
+
+	float buckets[U_METRICS_LATENCY_BUCKET_COUNT];
+	struct u_var_histogram_f32 histogram;
+
+	//! Call count at the previous update, for the rate.
+	uint64_t last_count;
+};
+
+/*!
+ * Wraps a device and times the calls made to it.
+ *
+ * @implements xrt_device
+ */
+struct timing_device
+{
+	struct xrt_device base;
+
+	//! Owned.
+	struct xrt_device *target;
+
+	//! Index in the live stats.
+	uint32_t device_index;
+
+	//! Guards @ref calls and @ref last_update_ns, calls come from many threads.
+	struct os_mutex mutex;
+
+	struct u_metrics_latency_histogram calls[U_METRICS_DEVICE_CALL_COUNT];
+
+	uint64_t last_update_ns;
+
+	struct timing_call_ui ui[U_METRICS_DEVICE_CALL_COUNT];
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct timing_device *
+timing_device(struct xrt_device *xdev)
+{
+	return (struct timing_device *)xdev;
+}
+
+//! Called with the lock held.
+static void
+update_ui_locked(struct timing_device *d, uint64_t period_ns)
+{
+	double period_s = time_ns_to_s((time_duration_ns)period_ns);
+
+	for (uint32_t i = 0; i < U_METRICS_DEVICE_CALL_COUNT; i++) {
+		const struct u_metrics_latency_histogram *hist = &d->calls[i];
+		struct timing_call_ui *ui = &d->ui[i];
+
+		ui->rate = (float)((double)(hist->count - ui->last_count) / period_s);
+		ui->last_count = hist->count;
+		ui->count = hist->count;
+
+		if (hist->count > 0) {
+			ui->mean_ms = (float)time_ns_to_ms_f((int64_t)(hist->total_ns / hist->count));
+		}
+		ui->max_ms = (float)time_ns_to_ms_f((int64_t)hist->max_ns);
+
+		for (uint32_t k = 0; k < U_METRICS_LATENCY_BUCKET_COUNT; k++) {
+			ui->buckets[k] = (float)hist->buckets[k];
+		}
+	}
+}
+
+static void
+record_call(struct timing_device *d, enum u_metrics_device_call call, uint64_t start_ns)
+{
+	struct u_metrics_latency_histogram snapshot[U_METRICS_DEVICE_CALL_COUNT];
+	bool publish = false;
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	os_mutex_lock(&d->mutex);
+
+	u_metrics_latency_histogram_add(&d->calls[call], now_ns - start_ns);
+
+	if (now_ns - d->last_update_ns >= PUBLISH_PERIOD_NS) {
+		update_ui_locked(d, now_ns - d->last_update_ns);
+		d->last_update_ns = now_ns;
+
+		for (uint32_t i = 0; i < U_METRICS_DEVICE_CALL_COUNT; i++) {
+			snapshot[i] = d->calls[i];
+		}
+		publish = true;
+	}
+
+	os_mutex_unlock(&d->mutex);
+
+	// Outside of our lock, takes the stats lock.
+	if (publish) {
+		u_metrics_write_device_calls(d->device_index, snapshot);
+	}
+}
+
+static void
+setup_ui(struct timing_device *d)
+{
+	char tmp[XRT_DEVICE_NAME_LEN + 32];
+	snprintf(tmp, sizeof(tmp), "Device timing: %s", d->target->str);
+
+	u_var_add_root(d, tmp, true);
+
+	for (uint32_t i = 0; i < U_METRICS_DEVICE_CALL_COUNT; i++) {
+		struct timing_call_ui *ui = &d->ui[i];
+
+		ui->histogram.values = ui->buckets;
+		ui->histogram.count = U_METRICS_LATENCY_BUCKET_COUNT;
+
+		u_var_add_gui_header(d, &ui->header, call_names[i]);
+		u_var_add_ro_u64(d, &ui->count, "Calls");
+		u_var_add_ro_f32(d, &ui->rate, "Calls/s");
+		u_var_add_ro_f32(d, &ui->mean_ms, "Mean (ms)");
+		u_var_add_ro_f32(d, &ui->max_ms, "Max (ms)");
+		u_var_add_histogram_f32(d, &ui->histogram, "Latency (<2us, then x2 per bar)");
+	}
+}
+
+
+/*
+ *
+ * Timed functions.
+ *
+ */
+
+static void
+timing_update_inputs(struct xrt_device *xdev)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	xrt_device_update_inputs(d->target);
+	record_call(d, U_METRICS_DEVICE_CALL_UPDATE_INPUTS, start_ns);
+}
+
+static void
+timing_get_tracked_pose(struct xrt_device *xdev,
+                        enum xrt_input_name name,
+                        uint64_t at_timestamp_ns,
+                        struct xrt_space_relation *out_relation)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	xrt_device_get_tracked_pose(d->target, name, at_timestamp_ns, out_relation);
+	record_call(d, U_METRICS_DEVICE_CALL_GET_TRACKED_POSE, start_ns);
+}
+
+static void
+timing_get_hand_tracking(struct xrt_device *xdev,
+                         enum xrt_input_name name,
+                         uint64_t desired_timestamp_ns,
+                         struct xrt_hand_joint_set *out_value,
+                         uint64_t *out_timestamp_ns)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	xrt_device_get_hand_tracking(d->target, name, desired_timestamp_ns, out_value, out_timestamp_ns);
+	record_call(d, U_METRICS_DEVICE_CALL_GET_HAND_TRACKING, start_ns);
+}
+
+static void
+timing_set_output(struct xrt_device *xdev, enum xrt_output_name name, const union xrt_output_value *value)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	xrt_device_set_output(d->target, name, value);
+	record_call(d, U_METRICS_DEVICE_CALL_SET_OUTPUT, start_ns);
+}
+
+static void
+timing_get_view_poses(struct xrt_device *xdev,
+                      const struct xrt_vec3 *default_eye_relation,
+                      uint64_t at_timestamp_ns,
+                      uint32_t view_count,
+                      struct xrt_space_relation *out_head_relation,
+                      struct xrt_fov *out_fovs,
+                      struct xrt_pose *out_poses)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	xrt_device_get_view_poses(d->target, default_eye_relation, at_timestamp_ns, view_count, out_head_relation,
+	                          out_fovs, out_poses);
+	record_call(d, U_METRICS_DEVICE_CALL_GET_VIEW_POSES, start_ns);
+}
+
+
+/*
+ *
+ * Forwarded functions.
+ *
+ */
+
+static bool
+timing_compute_distortion(struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *out_result)
+{
+	struct timing_device *d = timing_device(xdev);
+	return xrt_device_compute_distortion(d->target, view, u, v, out_result);
+}
+
+static xrt_result_t
+timing_get_visibility_mask(struct xrt_device *xdev,
+                           enum xrt_visibility_mask_type type,
+                           uint32_t view_index,
+                           struct xrt_visibility_mask **out_mask)
+{
+	struct timing_device *d = timing_device(xdev);
+	return xrt_device_get_visibility_mask(d->target, type, view_index, out_mask);
+}
+
+static xrt_result_t
+timing_ref_space_usage(struct xrt_device *xdev,
+                       enum xrt_reference_space_type type,
+                       enum xrt_input_name name,
+                       bool used)
+{
+	struct timing_device *d = timing_device(xdev);
+	return xrt_device_ref_space_usage(d->target, type, name, used);
+}
+
+static bool
+timing_is_form_factor_available(struct xrt_device *xdev, enum xrt_form_factor form_factor)
+{
+	struct timing_device *d = timing_device(xdev);
+	return xrt_device_is_form_factor_available(d->target, form_factor);
+}
+
+static xrt_result_t
+timing_set_feature_enabled(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled)
+{
+	struct timing_device *d = timing_device(xdev);
+	return xrt_device_set_feature_enabled(d->target, type, enabled);
+}
+
+static void
+timing_destroy(struct xrt_device *xdev)
+{
+	struct timing_device *d = timing_device(xdev);
+
+	u_var_remove_root(d);
+
+	xrt_device_destroy(&d->target);
+	os_mutex_destroy(&d->mutex);
+
+	free(d);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+u_device_timing_is_enabled(void)
+{
+	return debug_get_bool_option_device_timing();
+}
+
+struct xrt_device *
+u_device_timing_wrap(struct xrt_device *target, uint32_t device_index)
+{
+	struct timing_device *d = U_TYPED_CALLOC(struct timing_device);
+	if (d == NULL) {
+		return target;
+	}
+
+	if (os_mutex_init(&d->mutex) != 0) {
+		U_LOG_E("Failed to init mutex, not timing '%s'", target->str);
+		free(d);
+		return target;
+	}
+
+	// Mimic the target, inputs and outputs are shared with it.
+	d->base = *target;
+	d->target = target;
+	d->device_index = device_index;
+	d->last_update_ns = os_monotonic_get_ns();
+
+	d->base.update_inputs = timing_update_inputs;
+	d->base.get_tracked_pose = timing_get_tracked_pose;
+	d->base.get_hand_tracking = timing_get_hand_tracking;
+	d->base.set_output = timing_set_output;
+	d->base.get_view_poses = timing_get_view_poses;
+	d->base.destroy = timing_destroy;
+
+	// Optional functions, keep them unset if the target has them unset.
+	d->base.compute_distortion = target->compute_distortion != NULL ? timing_compute_distortion : NULL;
+	d->base.get_visibility_mask = target->get_visibility_mask != NULL ? timing_get_visibility_mask : NULL;
+	d->base.ref_space_usage = target->ref_space_usage != NULL ? timing_ref_space_usage : NULL;
+	d->base.is_form_factor_available =
+	    target->is_form_factor_available != NULL ? timing_is_form_factor_available : NULL;
+	d->base.set_feature_enabled = target->set_feature_enabled != NULL ? timing_set_feature_enabled : NULL;
+
+	setup_ui(d);
+
+	U_LOG_I("Timing calls to '%s'", target->str);
+
+	return &d->base;
+}
+
+void
+u_device_timing_wrap_all(struct xrt_device **xdevs,
+                         uint32_t xdev_count,
+                         struct xrt_device **const *roles,
+                         uint32_t role_count)
+{
+	for (uint32_t i = 0; i < xdev_count; i++) {
+		struct xrt_device *target = xdevs[i];
+		if (target == NULL) {
+			continue;
+		}
+
+		struct xrt_device *wrapped = u_device_timing_wrap(target, i);
+		xdevs[i] = wrapped;
+
+		for (uint32_t k = 0; k < role_count; k++) {
+			if (*roles[k] == target) {
+				*roles[k] = wrapped;
+			}
+		}
+	}
+}
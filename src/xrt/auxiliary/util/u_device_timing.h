@@ -0,0 +1,59 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Device wrapper that measures how long driver calls take.
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct xrt_device;
+
+/*!
+ * Returns true if devices should be wrapped with @ref u_device_timing_wrap,
+ * controlled by the @p XRT_DEVICE_TIMING environment variable.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_device_timing_is_enabled(void);
+
+/*!
+ * Create a device that takes ownership of @p target and mimics it, timing the
+ * @p get_tracked_pose, @p get_hand_tracking, @p update_inputs,
+ * @p set_output and @p get_view_poses calls made to it.
+ *
+ * Latency histograms and call rates are shown in the debug gui, and published
+ * to the live metrics stats at @p device_index, which should be the index of
+ * the device in @ref xrt_system_devices::xdevs.
+ *
+ * @ingroup aux_util
+ */
+struct xrt_device *
+u_device_timing_wrap(struct xrt_device *target, uint32_t device_index);
+
+/*!
+ * Wraps all devices in @p xdevs in place with @ref u_device_timing_wrap and
+ * replaces any of them found in @p roles, which is an array of @p role_count
+ * pointers to device pointers, any of which may point to NULL.
+ *
+ * @ingroup aux_util
+ */
+void
+u_device_timing_wrap_all(struct xrt_device **xdevs,
+                         uint32_t xdev_count,
+                         struct xrt_device **const *roles,
+                         uint32_t role_count);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,20 +8,40 @@
  * @ingroup aux_distortion
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "util/u_misc.h"
+#include "util/u_file.h"
 #include "util/u_frame.h"
 #include "util/u_debug.h"
 #include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_worker.h"
 #include "util/u_distortion_mesh.h"
 
 #include "math/m_vec2.h"
 #include "math/m_api.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <inttypes.h>
 
 
 DEBUG_GET_ONCE_NUM_OPTION(mesh_size, "XRT_MESH_SIZE", 64)
+DEBUG_GET_ONCE_BOOL_OPTION(mesh_cache, "XRT_MESH_CACHE", true)
+
+//! Number of vertex rows computed by each task given to the worker threads.
+#define ROWS_PER_TASK (8)
+
+//! Number of threads used to compute the mesh.
+#define THREAD_COUNT (4)
+
+//! Grid size per view used to catch changed distortion parameters in the cache.
+#define PROBE_COUNT (8)
+
+//! Bump when the layout of the cache file or the generated vertices change.
+#define CACHE_VERSION (2)
 
 
 typedef bool (*func_calc)(struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *result);
@@ -32,6 +52,282 @@ index_for(int row, int col, uint32_t stride, uint32_t offset)
 	return row * stride + col + offset;
 }
 
+
+/*
+ *
+ * Vertex generation.
+ *
+ */
+
+/*!
+ * A range of vertex rows for one view, computed on a worker thread.
+ */
+struct mesh_task
+{
+	struct xrt_device *xdev;
+	func_calc calc;
+	uint32_t view;
+	uint32_t row_start;
+	uint32_t row_end;
+	uint32_t cells_rows;
+	uint32_t cells_cols;
+	uint32_t stride_in_floats;
+
+	//! First float of the first vertex of the view.
+	float *verts;
+
+	//! Set if the calc function failed for any vertex.
+	bool failed;
+};
+
+static void
+run_mesh_task(void *ptr)
+{
+	struct mesh_task *task = (struct mesh_task *)ptr;
+	uint32_t vert_cols = task->cells_cols + 1;
+
+	for (uint32_t r = task->row_start; r < task->row_end; r++) {
+		// This goes from 0 to 1.0 inclusive.
+		float v = (float)r / (float)task->cells_rows;
+
+		for (uint32_t c = 0; c < vert_cols; c++) {
+			// This goes from 0 to 1.0 inclusive.
+			float u = (float)c / (float)task->cells_cols;
+
+			float *vert = &task->verts[(r * vert_cols + c) * task->stride_in_floats];
+
+			// Make the position in the range of [-1, 1]
+			vert[0] = u * 2.0f - 1.0f;
+			vert[1] = v * 2.0f - 1.0f;
+
+			if (!task->calc(task->xdev, task->view, u, v, (struct xrt_uv_triplet *)&vert[2])) {
+				task->failed = true;
+				return;
+			}
+		}
+	}
+}
+
+/*!
+ * Fill in the vertices of all views, split up over a few threads since a
+ * large mesh with an expensive distortion function can take seconds.
+ */
+static bool
+compute_vertices(struct xrt_device *xdev,
+                 func_calc calc,
+                 int view_count,
+                 uint32_t num,
+                 uint32_t stride_in_floats,
+                 float *verts)
+{
+	uint32_t vert_rows = num + 1;
+	uint32_t vertex_count_per_view = vert_rows * (num + 1);
+	uint32_t tasks_per_view = (vert_rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	uint32_t task_count = tasks_per_view * view_count;
+
+	struct mesh_task *tasks = U_TYPED_ARRAY_CALLOC(struct mesh_task, task_count);
+
+	for (int view = 0; view < view_count; view++) {
+		for (uint32_t i = 0; i < tasks_per_view; i++) {
+			struct mesh_task *task = &tasks[view * tasks_per_view + i];
+
+			task->xdev = xdev;
+			task->calc = calc;
+			task->view = view;
+			task->row_start = i * ROWS_PER_TASK;
+			task->row_end = task->row_start + ROWS_PER_TASK;
+			if (task->row_end > vert_rows) {
+				task->row_end = vert_rows;
+			}
+			task->cells_rows = num;
+			task->cells_cols = num;
+			task->stride_in_floats = stride_in_floats;
+			task->verts = &verts[view * vertex_count_per_view * stride_in_floats];
+		}
+	}
+
+	/*
+	 * Not worth starting threads for tiny meshes, and the device might keep
+	 * state in its distortion function, so only if it says that is safe.
+	 */
+	struct u_worker_thread_pool *pool = NULL;
+	struct u_worker_group *group = NULL;
+	if (xdev->compute_distortion_thread_safe && task_count > (uint32_t)view_count) {
+		pool = u_worker_thread_pool_create(THREAD_COUNT - 1, THREAD_COUNT, "Distortion Mesh");
+		group = pool != NULL ? u_worker_group_create(pool) : NULL;
+	}
+
+	if (group != NULL) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			u_worker_group_push(group, run_mesh_task, &tasks[i]);
+		}
+		u_worker_group_wait_all(group);
+	} else {
+		for (uint32_t i = 0; i < task_count; i++) {
+			run_mesh_task(&tasks[i]);
+		}
+	}
+
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+
+	bool failed = false;
+	for (uint32_t i = 0; i < task_count; i++) {
+		failed = failed || tasks[i].failed;
+	}
+
+	free(tasks);
+
+	return !failed;
+}
+
+
+/*
+ *
+ * On disk cache.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+
+/*!
+ * Start of the cache file, followed by the probe values and then the vertices.
+ *
+ * The device is what identifies the mesh, most drivers keep their distortion
+ * parameters to themselves. Must be zero initialized as it is hashed and
+ * compared as bytes.
+ */
+struct cache_header
+{
+	uint32_t version;
+	uint32_t num;
+	uint32_t view_count;
+	uint32_t probe_count;
+	uint32_t float_count;
+
+	uint32_t device_name;
+	char device_str[XRT_DEVICE_NAME_LEN];
+	char device_serial[XRT_DEVICE_NAME_LEN];
+	struct xrt_fov fovs[2];
+
+	//! Only set if the device gives its parameters, see @ref XRT_DISTORTION_MODEL_VIVE.
+	struct xrt_distortion_vive_values vive[2];
+};
+
+/*!
+ * Evaluated on a small grid and stored next to the device identity, so that a
+ * device that changed its parameters, say a new calibration, doesn't get the
+ * old mesh. It isn't enough to tell different devices apart on its own.
+ */
+static bool
+compute_probe(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_uv_triplet *out_probe)
+{
+	for (int view = 0; view < view_count; view++) {
+		for (uint32_t r = 0; r < PROBE_COUNT; r++) {
+			for (uint32_t c = 0; c < PROBE_COUNT; c++) {
+				float u = ((float)c + 0.5f) / (float)PROBE_COUNT;
+				float v = ((float)r + 0.5f) / (float)PROBE_COUNT;
+				uint32_t index = (view * PROBE_COUNT + r) * PROBE_COUNT + c;
+
+				if (!calc(xdev, view, u, v, &out_probe[index])) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+static void
+get_cache_filename(const struct cache_header *header,
+                   const struct xrt_uv_triplet *probe,
+                   size_t probe_size,
+                   char *out_filename,
+                   size_t filename_size)
+{
+	size_t size = sizeof(*header) + probe_size;
+	char *data = U_TYPED_ARRAY_CALLOC(char, size);
+
+	memcpy(data, header, sizeof(*header));
+	memcpy(data + sizeof(*header), probe, probe_size);
+
+	// Not stable between platforms, only costs a cache miss.
+	size_t hash = math_hash_string(data, size);
+	snprintf(out_filename, filename_size, "distortion_mesh_%016" PRIx64 ".bin", (uint64_t)hash);
+
+	free(data);
+}
+
+static bool
+load_from_cache(const char *filename,
+                const struct cache_header *header,
+                const struct xrt_uv_triplet *probe,
+                size_t probe_size,
+                float *verts)
+{
+	FILE *file = u_file_open_file_in_config_dir_subpath("cache", filename, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	struct cache_header file_header = {0};
+	struct xrt_uv_triplet *file_probe = U_TYPED_ARRAY_CALLOC(struct xrt_uv_triplet, header->probe_count);
+	bool ret = false;
+
+	// Compare everything, a hash collision must not give us the wrong mesh.
+	do {
+		if (fread(&file_header, sizeof(file_header), 1, file) != 1 ||
+		    memcmp(&file_header, header, sizeof(file_header)) != 0) {
+			break;
+		}
+		if (fread(file_probe, probe_size, 1, file) != 1 || memcmp(file_probe, probe, probe_size) != 0) {
+			break;
+		}
+		if (fread(verts, sizeof(float) * header->float_count, 1, file) != 1) {
+			break;
+		}
+		ret = true;
+	} while (false);
+
+	free(file_probe);
+	fclose(file);
+
+	return ret;
+}
+
+static void
+save_to_cache(const char *filename,
+              const struct cache_header *header,
+              const struct xrt_uv_triplet *probe,
+              size_t probe_size,
+              const float *verts)
+{
+	FILE *file = u_file_open_file_in_config_dir_subpath("cache", filename, "wb");
+	if (file == NULL) {
+		U_LOG_W("Could not open distortion mesh cache file '%s' for writing", filename);
+		return;
+	}
+
+	bool ok = fwrite(header, sizeof(*header), 1, file) == 1;
+	ok = ok && fwrite(probe, probe_size, 1, file) == 1;
+	ok = ok && fwrite(verts, sizeof(float) * header->float_count, 1, file) == 1;
+	if (!ok) {
+		U_LOG_W("Failed to write distortion mesh cache file '%s'", filename);
+	}
+
+	fclose(file);
+}
+
+#endif // XRT_OS_LINUX
+
+
+/*
+ *
+ * Mesh generation.
+ *
+ */
+
 static void
 run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd_parts *target, uint32_t num)
 {
@@ -56,32 +352,55 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 
 	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
 
-	// Setup the vertices for all views.
-	uint32_t i = 0;
 	for (int view = 0; view < view_count; view++) {
-		vertex_offsets[view] = i / stride_in_floats;
-
-		for (uint32_t r = 0; r < vert_rows; r++) {
-			// This goes from 0 to 1.0 inclusive.
-			float v = (float)r / (float)cells_rows;
+		vertex_offsets[view] = view * vertex_count_per_view;
+	}
 
-			for (uint32_t c = 0; c < vert_cols; c++) {
-				// This goes from 0 to 1.0 inclusive.
-				float u = (float)c / (float)cells_cols;
+	bool loaded = false;
+
+#ifdef XRT_OS_LINUX
+	struct xrt_uv_triplet probe[2 * PROBE_COUNT * PROBE_COUNT];
+	size_t probe_size = sizeof(probe[0]) * view_count * PROBE_COUNT * PROBE_COUNT;
+	char filename[64] = {0};
+
+	struct cache_header header;
+	U_ZERO(&header);
+	header.version = CACHE_VERSION;
+	header.num = num;
+	header.view_count = (uint32_t)view_count;
+	header.probe_count = (uint32_t)view_count * PROBE_COUNT * PROBE_COUNT;
+	header.float_count = float_count;
+	header.device_name = (uint32_t)xdev->name;
+	snprintf(header.device_str, sizeof(header.device_str), "%s", xdev->str);
+	snprintf(header.device_serial, sizeof(header.device_serial), "%s", xdev->serial);
+	for (int view = 0; view < view_count; view++) {
+		header.fovs[view] = target->distortion.fov[view];
+		if ((target->distortion.models & XRT_DISTORTION_MODEL_VIVE) != 0) {
+			header.vive[view] = target->distortion.vive[view];
+		}
+	}
 
-				// Make the position in the range of [-1, 1]
-				verts[i + 0] = u * 2.0f - 1.0f;
-				verts[i + 1] = v * 2.0f - 1.0f;
+	bool use_cache = debug_get_bool_option_mesh_cache() && compute_probe(xdev, calc, view_count, probe);
+	if (use_cache) {
+		get_cache_filename(&header, probe, probe_size, filename, sizeof(filename));
+		loaded = load_from_cache(filename, &header, probe, probe_size, verts);
+	}
+#endif
 
-				if (!calc(xdev, view, u, v, (struct xrt_uv_triplet *)&verts[i + 2])) {
-					// bail on error, without updating
-					// distortion.preferred
-					return;
-				}
+	// Setup the vertices for all views.
+	if (!loaded) {
+		if (!compute_vertices(xdev, calc, view_count, num, stride_in_floats, verts)) {
+			// bail on error, without updating
+			// distortion.preferred
+			free(verts);
+			return;
+		}
 
-				i += stride_in_floats;
-			}
+#ifdef XRT_OS_LINUX
+		if (use_cache) {
+			save_to_cache(filename, &header, probe, probe_size, verts);
 		}
+#endif
 	}
 
 	uint32_t index_count_per_view = cells_rows * (vert_cols * 2 + 2);
@@ -89,7 +408,7 @@ run_func(struct xrt_device *xdev, func_calc calc, int view_count, struct xrt_hmd
 	int *indices = U_TYPED_ARRAY_CALLOC(int, index_count_total);
 
 	// Set up indices for all views.
-	i = 0;
+	uint32_t i = 0;
 	for (int view = 0; view < view_count; view++) {
 		index_offsets[view] = i;
 
@@ -184,6 +503,24 @@ u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct
 	return true;
 }
 
+void
+u_distortion_vive_fill_in_model(struct xrt_device *xdev, const struct u_vive_values values[2], bool flip_y)
+{
+	struct xrt_hmd_parts *target = xdev->hmd;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_distortion_vive_values *dst = &target->distortion.vive[view];
+
+		dst->aspect_x_over_y = values[view].aspect_x_over_y;
+		dst->grow_for_undistort = values[view].grow_for_undistort;
+		memcpy(dst->center, values[view].center, sizeof(dst->center));
+		memcpy(dst->coefficients, values[view].coefficients, sizeof(dst->coefficients));
+		dst->flip_y = flip_y;
+	}
+
+	target->distortion.models |= XRT_DISTORTION_MODEL_VIVE;
+}
+
 
 #define mul m_vec2_mul
 #define mul_scalar m_vec2_mul_scalar
@@ -232,6 +569,24 @@ u_compute_distortion_panotools(struct u_panotools_values *values, float u, float
 	return true;
 }
 
+void
+u_distortion_panotools_fill_in_model(struct xrt_device *xdev, const struct u_panotools_values values[2])
+{
+	struct xrt_hmd_parts *target = xdev->hmd;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_distortion_panotools_values *dst = &target->distortion.panotools[view];
+
+		memcpy(dst->distortion_k, values[view].distortion_k, sizeof(dst->distortion_k));
+		memcpy(dst->aberration_k, values[view].aberration_k, sizeof(dst->aberration_k));
+		dst->scale = values[view].scale;
+		dst->lens_center = values[view].lens_center;
+		dst->viewport_size = values[view].viewport_size;
+	}
+
+	target->distortion.models |= XRT_DISTORTION_MODEL_PANOTOOLS;
+}
+
 bool
 u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
                                float u,
@@ -268,6 +623,24 @@ u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
 	return true;
 }
 
+void
+u_distortion_cardboard_fill_in_model(struct xrt_device *xdev, const struct u_cardboard_distortion_values values[2])
+{
+	struct xrt_hmd_parts *target = xdev->hmd;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_distortion_cardboard_values *dst = &target->distortion.cardboard[view];
+
+		memcpy(dst->distortion_k, values[view].distortion_k, sizeof(dst->distortion_k));
+		dst->screen.size = values[view].screen.size;
+		dst->screen.offset = values[view].screen.offset;
+		dst->texture.size = values[view].texture.size;
+		dst->texture.offset = values[view].texture.offset;
+	}
+
+	target->distortion.models |= XRT_DISTORTION_MODEL_CARDBOARD;
+}
+
 /*
  *
  * North Star "2D Polynomial" distortion
@@ -321,6 +694,26 @@ u_compute_distortion_ns_p2d(struct u_ns_p2d_values *values, int view, float u, f
 	return true;
 }
 
+void
+u_distortion_ns_p2d_fill_in_model(struct xrt_device *xdev, const struct u_ns_p2d_values *values)
+{
+	struct xrt_hmd_parts *target = xdev->hmd;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_distortion_ns_p2d_values *dst = &target->distortion.ns_p2d[view];
+
+		// Same pick of coefficients as u_compute_distortion_ns_p2d.
+		const float *x = view ? values->x_coefficients_left : values->x_coefficients_right;
+		const float *y = view ? values->y_coefficients_left : values->y_coefficients_right;
+
+		memcpy(dst->x_coefficients, x, sizeof(dst->x_coefficients));
+		memcpy(dst->y_coefficients, y, sizeof(dst->y_coefficients));
+		dst->fov = values->fov[view];
+	}
+
+	target->distortion.models |= XRT_DISTORTION_MODEL_NS_P2D;
+}
+
 
 /*
  *
@@ -457,6 +850,7 @@ u_distortion_mesh_set_none(struct xrt_device *xdev)
 
 	// Make sure that the xdev implements the compute_distortion function.
 	xdev->compute_distortion = u_distortion_mesh_none;
+	xdev->compute_distortion_thread_safe = true;
 
 	// Make the target completely usable.
 	target->distortion.models |= XRT_DISTORTION_MODEL_COMPUTE;
@@ -54,6 +54,18 @@ struct u_panotools_values
 bool
 u_compute_distortion_panotools(struct u_panotools_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Copies the Panotools distortion values to
+ * `xdev->hmd_parts.distortion.panotools` and adds
+ * @ref XRT_DISTORTION_MODEL_PANOTOOLS to the models, see
+ * @ref u_distortion_vive_fill_in_model.
+ *
+ * @relatesalso xrt_device
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_panotools_fill_in_model(struct xrt_device *xdev, const struct u_panotools_values values[2]);
+
 
 /*
  *
@@ -89,6 +101,18 @@ struct u_vive_values
 bool
 u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Copies the Vive distortion values to `xdev->hmd_parts.distortion.vive` and
+ * adds @ref XRT_DISTORTION_MODEL_VIVE to the models, so the compositor can
+ * generate the distortion on the GPU. The device must still implement
+ * `xdev->compute_distortion()` as well.
+ *
+ * @relatesalso xrt_device
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_vive_fill_in_model(struct xrt_device *xdev, const struct u_vive_values values[2], bool flip_y);
+
 
 /*
  *
@@ -107,6 +131,18 @@ u_compute_distortion_cardboard(struct u_cardboard_distortion_values *values,
                                float v,
                                struct xrt_uv_triplet *result);
 
+/*!
+ * Copies the Cardboard distortion values to
+ * `xdev->hmd_parts.distortion.cardboard` and adds
+ * @ref XRT_DISTORTION_MODEL_CARDBOARD to the models, see
+ * @ref u_distortion_vive_fill_in_model.
+ *
+ * @relatesalso xrt_device
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_cardboard_fill_in_model(struct xrt_device *xdev, const struct u_cardboard_distortion_values values[2]);
+
 
 /*
  *
@@ -132,6 +168,18 @@ struct u_ns_p2d_values
 bool
 u_compute_distortion_ns_p2d(struct u_ns_p2d_values *values, int view, float u, float v, struct xrt_uv_triplet *result);
 
+/*!
+ * Copies the North Star 2D polynomial values to
+ * `xdev->hmd_parts.distortion.ns_p2d` and adds
+ * @ref XRT_DISTORTION_MODEL_NS_P2D to the models, see
+ * @ref u_distortion_vive_fill_in_model.
+ *
+ * @relatesalso xrt_device
+ * @ingroup aux_distortion
+ */
+void
+u_distortion_ns_p2d_fill_in_model(struct xrt_device *xdev, const struct u_ns_p2d_values *values);
+
 /*
  *
  * Values for Moshi Turner's North Star distortion correction.
@@ -31,9 +31,30 @@ u_file_open_file_in_config_dir(const char *filename, const char *mode);
 FILE *
 u_file_open_file_in_config_dir_subpath(const char *subpath, const char *filename, const char *mode);
 
+/*!
+ * Get the path to @p filename in @p subpath of the config directory, for code
+ * that opens the file itself. The directories are created if missing.
+ */
+ssize_t
+u_file_get_path_in_config_dir_subpath(const char *subpath, const char *filename, char *out_path, size_t out_path_size);
+
 ssize_t
 u_file_get_hand_tracking_models_dir(char *out_path, size_t out_path_size);
 
+/*!
+ * Get the directory for cached data that can be thrown away at any time,
+ * like $XDG_CACHE_HOME/monado.
+ */
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size);
+
+/*!
+ * Open a file in the cache directory, creating the directory when opened
+ * for writing.
+ */
+FILE *
+u_file_open_file_in_cache_dir(const char *filename, const char *mode);
+
 ssize_t
 u_file_get_runtime_dir(char *out_path, size_t out_path_size);
 
@@ -7,11 +7,21 @@
  * @ingroup aux_util
  */
 
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_threading.h"
+
 #include "util/u_misc.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_OS_WINDOWS
+#include <malloc.h>
+#endif
 
 
 static void
@@ -143,3 +153,196 @@ u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_f
 
 	xrt_frame_reference(out_frame, xf);
 }
+
+
+/*
+ *
+ * Frame pool.
+ *
+ */
+
+#define DEFAULT_MAX_FREE_FRAMES (4)
+
+struct pool_frame;
+
+struct frame_pool
+{
+	struct u_frame_pool base;
+
+	//! Guards @ref free_list and @ref free_count.
+	struct os_mutex mutex;
+
+	//! Released frames waiting to be reused.
+	struct pool_frame *free_list;
+	uint32_t free_count;
+
+	uint32_t max_free_frames;
+	bool aligned_rows;
+};
+
+struct pool_frame
+{
+	struct xrt_frame base;
+
+	//! Holds a reference, so the pool outlives all of its frames.
+	struct u_frame_pool *pool;
+
+	//! Allocated size of base.data.
+	size_t capacity;
+
+	//! Next in the pool's free list.
+	struct pool_frame *next;
+};
+
+static inline struct frame_pool *
+frame_pool(struct u_frame_pool *ufp)
+{
+	return (struct frame_pool *)ufp;
+}
+
+static uint8_t *
+aligned_data_alloc(size_t size)
+{
+#ifdef XRT_OS_WINDOWS
+	return (uint8_t *)_aligned_malloc(size, U_FRAME_POOL_ALIGNMENT);
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment, the capacity always is.
+	return (uint8_t *)aligned_alloc(U_FRAME_POOL_ALIGNMENT, size);
+#endif
+}
+
+static void
+aligned_data_free(uint8_t *data)
+{
+#ifdef XRT_OS_WINDOWS
+	_aligned_free(data);
+#else
+	free(data);
+#endif
+}
+
+static void
+pool_frame_free(struct pool_frame *pf)
+{
+	aligned_data_free(pf->base.data);
+	free(pf);
+}
+
+static void
+free_pooled(struct xrt_frame *xf)
+{
+	assert(xf->reference.count == 0);
+
+	struct pool_frame *pf = (struct pool_frame *)xf;
+	struct u_frame_pool *ufp = pf->pool;
+	struct frame_pool *fp = frame_pool(ufp);
+
+	os_mutex_lock(&fp->mutex);
+	bool keep = fp->free_count < fp->max_free_frames;
+	if (keep) {
+		pf->next = fp->free_list;
+		fp->free_list = pf;
+		fp->free_count++;
+	}
+	os_mutex_unlock(&fp->mutex);
+
+	if (!keep) {
+		pool_frame_free(pf);
+	}
+
+	// Might destroy the pool, so last and without the mutex held.
+	u_frame_pool_reference(&ufp, NULL);
+}
+
+struct u_frame_pool *
+u_frame_pool_create(bool aligned_rows, uint32_t max_free_frames)
+{
+	struct frame_pool *fp = U_TYPED_CALLOC(struct frame_pool);
+	if (os_mutex_init(&fp->mutex) != 0) {
+		free(fp);
+		return NULL;
+	}
+
+	fp->base.reference.count = 1;
+	fp->aligned_rows = aligned_rows;
+	fp->max_free_frames = max_free_frames > 0 ? max_free_frames : DEFAULT_MAX_FREE_FRAMES;
+
+	return &fp->base;
+}
+
+void
+u_frame_pool_get(struct u_frame_pool *ufp,
+                 enum xrt_format f,
+                 uint32_t width,
+                 uint32_t height,
+                 struct xrt_frame **out_frame)
+{
+	assert(width > 0);
+	assert(height > 0);
+	assert(u_format_is_blocks(f));
+
+	struct frame_pool *fp = frame_pool(ufp);
+
+	size_t stride = 0;
+	size_t size = 0;
+	u_format_size_for_dimensions(f, width, height, &stride, &size);
+	if (fp->aligned_rows) {
+		size_t rows = size / stride;
+		stride = (stride + U_FRAME_POOL_ALIGNMENT - 1) & ~(size_t)(U_FRAME_POOL_ALIGNMENT - 1);
+		size = rows * stride;
+	}
+	size_t capacity = (size + U_FRAME_POOL_ALIGNMENT - 1) & ~(size_t)(U_FRAME_POOL_ALIGNMENT - 1);
+
+	// Take the first released frame that is big enough, frames are mostly all the same size.
+	struct pool_frame *pf = NULL;
+	os_mutex_lock(&fp->mutex);
+	for (struct pool_frame **it = &fp->free_list; *it != NULL; it = &(*it)->next) {
+		if ((*it)->capacity >= capacity) {
+			pf = *it;
+			*it = pf->next;
+			fp->free_count--;
+			break;
+		}
+	}
+	os_mutex_unlock(&fp->mutex);
+
+	if (pf != NULL) {
+		// Clear everything but the buffer.
+		uint8_t *data = pf->base.data;
+		pf->base = (struct xrt_frame){0};
+		pf->base.data = data;
+	} else {
+		pf = U_TYPED_CALLOC(struct pool_frame);
+		pf->capacity = capacity;
+		pf->base.data = aligned_data_alloc(capacity);
+	}
+
+	pf->next = NULL;
+	pf->pool = NULL;
+	u_frame_pool_reference(&pf->pool, ufp);
+
+	pf->base.format = f;
+	pf->base.width = width;
+	pf->base.height = height;
+	pf->base.stride = stride;
+	pf->base.size = size;
+	pf->base.destroy = free_pooled;
+
+	xrt_frame_reference(out_frame, &pf->base);
+}
+
+void
+u_frame_pool_destroy(struct u_frame_pool *ufp)
+{
+	struct frame_pool *fp = frame_pool(ufp);
+
+	// No frames are out, they all hold a reference.
+	while (fp->free_list != NULL) {
+		struct pool_frame *pf = fp->free_list;
+		fp->free_list = pf->next;
+		pool_frame_free(pf);
+	}
+
+	os_mutex_destroy(&fp->mutex);
+	free(fp);
+}
@@ -37,6 +37,81 @@ u_frame_clone(struct xrt_frame *to_copy, struct xrt_frame **out_frame);
 void
 u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_frame **out_frame);
 
+
+/*
+ *
+ * Frame pool.
+ *
+ */
+
+//! Alignment of the data of frames from a @ref u_frame_pool, and of their rows if asked for.
+#define U_FRAME_POOL_ALIGNMENT (64)
+
+/*!
+ * A pool of frames that recycles the buffers of frames that have been
+ * released, instead of allocating a new one for every frame. Frames keep the
+ * pool alive until they are released, thread safe.
+ */
+struct u_frame_pool
+{
+	struct xrt_reference reference;
+};
+
+/*!
+ * Creates a frame pool.
+ *
+ * @param aligned_rows    Pad the stride of each row up to @ref U_FRAME_POOL_ALIGNMENT,
+ *                        only for producers and consumers that honour the stride.
+ * @param max_free_frames How many released frames are kept around for reuse,
+ *                        zero means a default of four.
+ */
+struct u_frame_pool *
+u_frame_pool_create(bool aligned_rows, uint32_t max_free_frames);
+
+/*!
+ * Gets a frame from the pool, reusing the buffer of a released frame if one
+ * is big enough. Only the dimensions, format, stride and size are set, the
+ * data is not cleared. When the reference reaches zero it goes back to the
+ * pool.
+ */
+void
+u_frame_pool_get(struct u_frame_pool *ufp,
+                 enum xrt_format f,
+                 uint32_t width,
+                 uint32_t height,
+                 struct xrt_frame **out_frame);
+
+/*!
+ * Internal function, only called by reference.
+ */
+void
+u_frame_pool_destroy(struct u_frame_pool *ufp);
+
+/*!
+ * Standard Monado reference function.
+ */
+static inline void
+u_frame_pool_reference(struct u_frame_pool **dst, struct u_frame_pool *src)
+{
+	struct u_frame_pool *old_dst = *dst;
+
+	if (old_dst == src) {
+		return;
+	}
+
+	if (src) {
+		xrt_reference_inc(&src->reference);
+	}
+
+	*dst = src;
+
+	if (old_dst) {
+		if (xrt_reference_dec_and_is_zero(&old_dst->reference)) {
+			u_frame_pool_destroy(old_dst);
+		}
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,7 +10,6 @@
 
 #include "util/u_hashmap.h"
 
-#include <unordered_map>
 #include <vector>
 
 
@@ -20,12 +19,132 @@
  *
  */
 
+//! Up to this many items are kept in a plain array and searched linearly.
+#define SMALL_SIZE (8)
+
+//! Smallest table once grown past @ref SMALL_SIZE, always a power of two.
+#define MIN_TABLE_SIZE (16)
+
+struct slot
+{
+	uint64_t key;
+	void *value;
+	bool used;
+};
+
+/*!
+ * Most maps only hold a handful of items, those are kept packed at the start
+ * of @ref slots and searched linearly, which is faster than hashing. Bigger
+ * maps are open addressed with linear probing, removal shifts the following
+ * items back so there are no tombstones.
+ */
 struct u_hashmap_int
 {
-	std::unordered_map<uint64_t, void *> map = {};
+	std::vector<struct slot> slots = {};
+
+	size_t count = 0;
+
+	//! If false the first @ref count slots are used, in no particular order.
+	bool is_table = false;
 };
 
 
+/*
+ *
+ * Helpers.
+ *
+ */
+
+//! The splitmix64 finalizer, keys are often sequential or aligned pointers.
+static inline uint64_t
+hash_key(uint64_t key)
+{
+	key ^= key >> 30;
+	key *= UINT64_C(0xbf58476d1ce4e5b9);
+	key ^= key >> 27;
+	key *= UINT64_C(0x94d049bb133111eb);
+	key ^= key >> 31;
+	return key;
+}
+
+static inline size_t
+home_index(const struct u_hashmap_int *hmi, uint64_t key)
+{
+	return (size_t)hash_key(key) & (hmi->slots.size() - 1);
+}
+
+//! Index of the slot with @p key, or the free slot where it would go.
+static size_t
+table_find_index(const struct u_hashmap_int *hmi, uint64_t key)
+{
+	size_t mask = hmi->slots.size() - 1;
+	size_t i = home_index(hmi, key);
+
+	while (hmi->slots[i].used && hmi->slots[i].key != key) {
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+static void
+table_rehash(struct u_hashmap_int *hmi, size_t size)
+{
+	std::vector<struct slot> old;
+	old.swap(hmi->slots);
+
+	hmi->slots.resize(size);
+
+	size_t count = hmi->is_table ? old.size() : hmi->count;
+	for (size_t k = 0; k < count; k++) {
+		if (!old[k].used) {
+			continue;
+		}
+		size_t i = table_find_index(hmi, old[k].key);
+		hmi->slots[i] = old[k];
+	}
+
+	hmi->is_table = true;
+}
+
+static int
+small_find_index(const struct u_hashmap_int *hmi, uint64_t key, size_t *out_index)
+{
+	for (size_t i = 0; i < hmi->count; i++) {
+		if (hmi->slots[i].key == key) {
+			*out_index = i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static void
+table_erase_at(struct u_hashmap_int *hmi, size_t hole)
+{
+	size_t mask = hmi->slots.size() - 1;
+	size_t i = hole;
+
+	// Move back any item that was probed past the hole.
+	while (true) {
+		i = (i + 1) & mask;
+		if (!hmi->slots[i].used) {
+			break;
+		}
+
+		size_t home = home_index(hmi, hmi->slots[i].key);
+
+		// Distance from home, can the item be moved to the hole without going past its home?
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			hmi->slots[hole] = hmi->slots[i];
+			hole = i;
+		}
+	}
+
+	hmi->slots[hole] = {};
+}
+
+
 /*
  *
  * "Exported" functions.
@@ -36,6 +155,7 @@ extern "C" int
 u_hashmap_int_create(struct u_hashmap_int **out_hashmap_int)
 {
 	auto *hs = new u_hashmap_int;
+	hs->slots.resize(SMALL_SIZE);
 	*out_hashmap_int = hs;
 	return 0;
 }
@@ -51,33 +171,86 @@ u_hashmap_int_destroy(struct u_hashmap_int **hmi)
 int
 u_hashmap_int_find(struct u_hashmap_int *hmi, uint64_t key, void **out_item)
 {
-	auto search = hmi->map.find(key);
-
-	if (search != hmi->map.end()) {
-		*out_item = search->second;
+	if (!hmi->is_table) {
+		size_t i;
+		if (small_find_index(hmi, key, &i) < 0) {
+			return -1;
+		}
+		*out_item = hmi->slots[i].value;
 		return 0;
 	}
-	return -1;
+
+	size_t i = table_find_index(hmi, key);
+	if (!hmi->slots[i].used) {
+		return -1;
+	}
+
+	*out_item = hmi->slots[i].value;
+	return 0;
 }
 
 extern "C" int
 u_hashmap_int_insert(struct u_hashmap_int *hmi, uint64_t key, void *value)
 {
-	hmi->map[key] = value;
+	if (!hmi->is_table) {
+		size_t i;
+		if (small_find_index(hmi, key, &i) == 0) {
+			hmi->slots[i].value = value;
+			return 0;
+		}
+
+		if (hmi->count < SMALL_SIZE) {
+			hmi->slots[hmi->count++] = {key, value, true};
+			return 0;
+		}
+
+		table_rehash(hmi, MIN_TABLE_SIZE);
+	}
+
+	size_t i = table_find_index(hmi, key);
+	if (hmi->slots[i].used) {
+		hmi->slots[i].value = value;
+		return 0;
+	}
+
+	// Keep the load factor at most 3/4, probes stay short.
+	if ((hmi->count + 1) * 4 > hmi->slots.size() * 3) {
+		table_rehash(hmi, hmi->slots.size() * 2);
+		i = table_find_index(hmi, key);
+	}
+
+	hmi->slots[i] = {key, value, true};
+	hmi->count++;
+
 	return 0;
 }
 
 extern "C" int
 u_hashmap_int_erase(struct u_hashmap_int *hmi, uint64_t key)
 {
-	hmi->map.erase(key);
+	if (!hmi->is_table) {
+		size_t i;
+		if (small_find_index(hmi, key, &i) == 0) {
+			// Order doesn't matter, fill the hole with the last one.
+			hmi->slots[i] = hmi->slots[--hmi->count];
+			hmi->slots[hmi->count] = {};
+		}
+		return 0;
+	}
+
+	size_t i = table_find_index(hmi, key);
+	if (hmi->slots[i].used) {
+		table_erase_at(hmi, i);
+		hmi->count--;
+	}
+
 	return 0;
 }
 
 bool
 u_hashmap_int_empty(const struct u_hashmap_int *hmi)
 {
-	return hmi->map.empty();
+	return hmi->count == 0;
 }
 
 void
@@ -85,8 +258,10 @@ u_hashmap_int_for_each(const struct u_hashmap_int *hmi, u_hashmap_int_foreach_ca
 {
 	if (hmi == NULL || cb == NULL)
 		return;
-	for (const auto &keyval : hmi->map) {
-		cb(keyval.first, keyval.second, priv_ctx);
+	for (const auto &s : hmi->slots) {
+		if (s.used) {
+			cb(s.key, s.value, priv_ctx);
+		}
 	}
 }
 
@@ -94,13 +269,19 @@ extern "C" void
 u_hashmap_int_clear_and_call_for_each(struct u_hashmap_int *hmi, u_hashmap_int_callback cb, void *priv)
 {
 	std::vector<void *> tmp;
-	tmp.reserve(hmi->map.size());
+	tmp.reserve(hmi->count);
 
-	for (auto &n : hmi->map) {
-		tmp.push_back(n.second);
+	for (auto &s : hmi->slots) {
+		if (s.used) {
+			tmp.push_back(s.value);
+		}
 	}
 
-	hmi->map.clear();
+	// Back to a small map, the callbacks might insert into it again.
+	hmi->slots.clear();
+	hmi->slots.resize(SMALL_SIZE);
+	hmi->count = 0;
+	hmi->is_table = false;
 
 	for (auto *n : tmp) {
 		cb(n, priv);
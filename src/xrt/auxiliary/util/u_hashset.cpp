@@ -11,7 +11,7 @@
 #include "util/u_hashset.h"
 
 #include <cstring>
-#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -22,11 +22,21 @@
  *
  */
 
+/*!
+ * The keys view the strings stored in the items themselves, so neither
+ * inserting nor looking up allocates a key.
+ */
 struct u_hashset
 {
-	std::unordered_map<std::string, struct u_hashset_item *> map = {};
+	std::unordered_map<std::string_view, struct u_hashset_item *> map = {};
 };
 
+static inline std::string_view
+item_key(struct u_hashset_item *item)
+{
+	return std::string_view(item->c_str(), item->length);
+}
+
 
 /*
  *
@@ -53,8 +63,7 @@ u_hashset_destroy(struct u_hashset **hs)
 extern "C" int
 u_hashset_find_str(struct u_hashset *hs, const char *str, size_t length, struct u_hashset_item **out_item)
 {
-	std::string key = std::string(str, length);
-	auto search = hs->map.find(key);
+	auto search = hs->map.find(std::string_view(str, length));
 
 	if (search != hs->map.end()) {
 		*out_item = search->second;
@@ -73,8 +82,11 @@ u_hashset_find_c_str(struct u_hashset *hs, const char *c_str, struct u_hashset_i
 extern "C" int
 u_hashset_insert_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	std::string_view key = item_key(item);
+
+	// Replace the key too, it must view the string of the new item.
+	hs->map.erase(key);
+	hs->map.emplace(key, item);
 	return 0;
 }
 
@@ -109,8 +121,7 @@ u_hashset_create_and_insert_str(struct u_hashset *hs, const char *str, size_t le
 	}
 	store[length] = '\0';
 
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	hs->map.emplace(item_key(item), item);
 
 	*out_item = item;
 
@@ -127,16 +138,14 @@ u_hashset_create_and_insert_str_c(struct u_hashset *hs, const char *c_str, struc
 extern "C" int
 u_hashset_erase_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map.erase(key);
+	hs->map.erase(item_key(item));
 	return 0;
 }
 
 extern "C" int
 u_hashset_erase_str(struct u_hashset *hs, const char *str, size_t length)
 {
-	std::string key = std::string(str, length);
-	hs->map.erase(key);
+	hs->map.erase(std::string_view(str, length));
 	return 0;
 }
 
@@ -11,11 +11,15 @@
 #include "util/u_linux.h"
 #include "util/u_pretty_print.h"
 
+#include <sys/resource.h>
+
+#include <errno.h>
 #include <pthread.h>
 #include <assert.h>
 #include <unistd.h>
 #include <sched.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 #define LOG_D(...) U_LOG_IFL_D(log_level, __VA_ARGS__)
 #define LOG_I(...) U_LOG_IFL_I(log_level, __VA_ARGS__)
@@ -86,8 +90,8 @@ print_thread_info(struct u_pp_delegate dg, enum u_logging_level log_level, pthre
  *
  */
 
-void
-u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, const char *name)
+bool
+u_linux_try_to_set_scheduling_on_thread(enum u_logging_level log_level, const char *name, int policy, int priority)
 {
 	pthread_t this_thread = pthread_self();
 	struct u_pp_sink_stack_only sink;
@@ -105,16 +109,17 @@ u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, c
 	}
 
 	if (log_level <= U_LOGGING_DEBUG) {
-		u_pp(dg, "Trying to raise priority on thread '%s'\n\t", name);
+		u_pp(dg, "Trying to set scheduling on thread '%s'\n\t", name);
 		u_pp(dg, "before: ");
 		print_thread_info(dg, log_level, this_thread);
 	}
 
-	// Get the maximum on this platform.
-	params.sched_priority = sched_get_priority_max(SCHED_FIFO);
+	// Keep the priority within what this platform has for the policy.
+	int min = sched_get_priority_min(policy);
+	int max = sched_get_priority_max(policy);
+	params.sched_priority = priority < min ? min : priority > max ? max : priority;
 
-	// Here we try to set the realtime scheduling with the max priority available.
-	ret = pthread_setschedparam(this_thread, SCHED_FIFO, &params);
+	ret = pthread_setschedparam(this_thread, policy, &params);
 
 	// Print different amount depending on log level.
 	if (log_level <= U_LOGGING_DEBUG) {
@@ -123,9 +128,9 @@ u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, c
 		u_pp(dg, "\n\tResult: %i", ret);
 	} else {
 		if (ret != 0) {
-			u_pp(dg, "Could not raise priority for thread '%s'", name);
+			u_pp(dg, "Could not set %s for thread '%s'", policy_to_string(policy), name);
 		} else {
-			u_pp(dg, "Raised priority of thread '%s' to ", name);
+			u_pp(dg, "Set scheduling of thread '%s' to ", name);
 			print_thread_info(dg, log_level, this_thread);
 		}
 	}
@@ -136,4 +141,66 @@ u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, c
 	} else {
 		LOG_I("%s", sink.buffer);
 	}
+
+	return ret == 0;
+}
+
+bool
+u_linux_try_to_set_nice_on_thread(enum u_logging_level log_level, const char *name, int nice)
+{
+	char str[NAME_LENGTH];
+
+	// Always have some name.
+	if (name == NULL) {
+		get_name(str, ARRAY_SIZE(str));
+		name = str;
+	}
+
+	// On Linux the nice value is per thread, not per process.
+	int ret = setpriority(PRIO_PROCESS, (id_t)gettid(), nice);
+	if (ret != 0) {
+		LOG_W("Could not set nice value %i for thread '%s': %i", nice, name, errno);
+		return false;
+	}
+
+	LOG_I("Set nice value of thread '%s' to %i", name, nice);
+
+	return true;
+}
+
+bool
+u_linux_try_to_set_affinity_on_thread(enum u_logging_level log_level, const char *name, uint64_t cpu_mask)
+{
+	char str[NAME_LENGTH];
+	cpu_set_t set;
+
+	// Always have some name.
+	if (name == NULL) {
+		get_name(str, ARRAY_SIZE(str));
+		name = str;
+	}
+
+	CPU_ZERO(&set);
+	for (int i = 0; i < 64; i++) {
+		if ((cpu_mask & (UINT64_C(1) << i)) != 0) {
+			CPU_SET(i, &set);
+		}
+	}
+
+	int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (ret != 0) {
+		LOG_W("Could not set CPU affinity 0x%" PRIx64 " for thread '%s': %i", cpu_mask, name, ret);
+		return false;
+	}
+
+	LOG_I("Set CPU affinity of thread '%s' to 0x%" PRIx64, name, cpu_mask);
+
+	return true;
+}
+
+void
+u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, const char *name)
+{
+	// Here we try to set the realtime scheduling with the max priority available.
+	u_linux_try_to_set_scheduling_on_thread(log_level, name, SCHED_FIFO, sched_get_priority_max(SCHED_FIFO));
 }
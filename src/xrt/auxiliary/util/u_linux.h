@@ -33,6 +33,46 @@ extern "C" {
 void
 u_linux_try_to_set_realtime_priority_on_thread(enum u_logging_level log_level, const char *name);
 
+/*!
+ * Try to set the scheduling policy and priority of this thread, the priority
+ * is clamped to what the platform supports for the policy. Returns true if it
+ * was set.
+ *
+ * @param log_level Logging level to control chattiness.
+ * @param name      Thread name to be used in logging, can be NULL.
+ * @param policy    Scheduling policy like `SCHED_FIFO` or `SCHED_BATCH`.
+ * @param priority  Static priority, only used by the realtime policies.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_linux_try_to_set_scheduling_on_thread(enum u_logging_level log_level, const char *name, int policy, int priority);
+
+/*!
+ * Try to set the nice value of this thread, for when realtime scheduling isn't
+ * allowed like on Android. Returns true if it was set.
+ *
+ * @param log_level Logging level to control chattiness.
+ * @param name      Thread name to be used in logging, can be NULL.
+ * @param nice      Nice value, from -20 (highest priority) to 19.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_linux_try_to_set_nice_on_thread(enum u_logging_level log_level, const char *name, int nice);
+
+/*!
+ * Try to restrict this thread to the given CPUs. Returns true if it was set.
+ *
+ * @param log_level Logging level to control chattiness.
+ * @param name      Thread name to be used in logging, can be NULL.
+ * @param cpu_mask  Bit per CPU the thread may run on, only the first 64 CPUs.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_linux_try_to_set_affinity_on_thread(enum u_logging_level log_level, const char *name, uint64_t cpu_mask);
+
 
 #ifdef __cplusplus
 }
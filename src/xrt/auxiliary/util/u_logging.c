@@ -11,13 +11,19 @@
 #include "xrt/xrt_config_os.h"
 #include "xrt/xrt_config_build.h"
 
+#include "os/os_threading.h"
+
 #include "util/u_debug.h"
 #include "u_json.h"
+#include "util/u_time.h"
 #include "util/u_truncate_printf.h"
+#include "util/u_thread_role.h"
+#include "util/u_mpsc_ring.h"
 
 #include <assert.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 
 
@@ -50,6 +56,18 @@
  */
 #define LOG_HEX_LINE_BUF_SIZE (128)
 
+/*
+ * Number of messages the async ring holds, must be a power of two. Only
+ * allocated if async logging is enabled.
+ */
+#define LOG_ASYNC_RING_SIZE (512)
+
+/*
+ * Longer messages are truncated in async mode, keeps the ring small.
+ */
+#define LOG_ASYNC_MESSAGE_SIZE (512)
+
+
 /*
  *
  * Global log level functions.
@@ -58,6 +76,7 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(global_log, "XRT_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(json_log, "XRT_JSON_LOG", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_log, "XRT_LOG_ASYNC", false)
 
 enum u_logging_level
 u_log_get_global_level(void)
@@ -349,15 +368,10 @@ log_as_json(const char *file, const char *func, enum u_logging_level level, cons
 }
 
 static int
-do_print(const char *file, int line, const char *func, enum u_logging_level level, const char *format, va_list args)
+format_message(
+    char *storage, int storage_size, const char *func, enum u_logging_level level, const char *format, va_list args)
 {
-	if (debug_get_bool_option_json_log()) {
-		return log_as_json(file, func, level, format, args);
-	}
-
-	char storage[LOG_BUFFER_SIZE];
-
-	int remaining = sizeof(storage) - 2; // 2 for \n\0
+	int remaining = storage_size - 2; // 2 for \n\0
 	int printed = 0;
 	char *buf = storage; // We update the pointer.
 	int ret = 0;
@@ -375,11 +389,30 @@ do_print(const char *file, int line, const char *func, enum u_logging_level leve
 
 	/*
 	 * The variable storage now holds the entire null-terminated message,
-	 * but without a new-line character, proceed to output it.
+	 * but without a new-line character.
 	 */
 	assert(storage[printed] == '\0');
 
+	return printed;
+}
+
+static int
+format_message_args(char *storage, const char *func, enum u_logging_level level, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int ret = format_message(storage, LOG_BUFFER_SIZE, func, level, format, args);
+	va_end(args);
+
+	return ret;
+}
 
+/*!
+ * Outputs a message from @ref format_message, adds the new-line to storage.
+ */
+static int
+output_message(char *storage, int printed, const char *func, enum u_logging_level level)
+{
 #ifdef XRT_OS_ANDROID
 
 	android_LogPriority prio = u_log_convert_priority(level);
@@ -406,6 +439,242 @@ do_print(const char *file, int line, const char *func, enum u_logging_level leve
 }
 
 
+/*
+ *
+ * Async writer.
+ *
+ * Messages are formatted on the calling thread and pushed into a bounded
+ * multi-producer ring, see @ref u_mpsc_ring, a writer thread does the
+ * (possibly blocking) output. When the ring is full the message is dropped
+ * and counted, the writer reports the drops.
+ *
+ */
+
+enum log_async_state
+{
+	LOG_ASYNC_STATE_OFF = 0,
+	LOG_ASYNC_STATE_STARTING,
+	LOG_ASYNC_STATE_RUNNING,
+	LOG_ASYNC_STATE_STOPPED,
+};
+
+struct log_async_slot
+{
+	enum u_logging_level level;
+	const char *func;
+	int printed;
+	char storage[LOG_ASYNC_MESSAGE_SIZE];
+};
+
+static struct
+{
+	//! A @ref log_async_state.
+	xrt_atomic_s32_t state;
+
+	//! Positions in @p slots.
+	struct u_mpsc_ring ring;
+
+	//! Dropped messages already reported, only touched by the writer thread.
+	int32_t reported_dropped;
+
+	struct log_async_slot *slots;
+
+	struct os_thread_helper oth;
+} g_async;
+
+//! Outputs all ready messages, only called from the writer thread.
+static bool
+async_drain(void)
+{
+	bool any = false;
+
+	uint32_t index;
+	while (u_mpsc_ring_peek(&g_async.ring, &index)) {
+		struct log_async_slot *slot = &g_async.slots[index];
+
+		output_message(slot->storage, slot->printed, slot->func, slot->level);
+
+		u_mpsc_ring_release(&g_async.ring);
+		any = true;
+	}
+
+	int32_t dropped = u_mpsc_ring_get_dropped(&g_async.ring);
+	if (dropped != g_async.reported_dropped) {
+		char storage[LOG_BUFFER_SIZE];
+		int32_t count = u_mpsc_ring_pos_diff(dropped, g_async.reported_dropped);
+		int printed = format_message_args(storage, __func__, U_LOGGING_WARN, "Dropped %d log messages", count);
+		if (printed >= 0) {
+			output_message(storage, printed, __func__, U_LOGGING_WARN);
+		}
+		g_async.reported_dropped = dropped;
+	}
+
+	return any;
+}
+
+static void *
+async_writer(void *ptr)
+{
+	os_thread_helper_name(&g_async.oth, "Log Writer");
+
+	// Writing logs can wait, keep it out of the way of everything else.
+	u_thread_role_apply(U_THREAD_ROLE_BACKGROUND, U_LOGGING_WARN, "Log Writer");
+
+	os_thread_helper_lock(&g_async.oth);
+	while (os_thread_helper_is_running_locked(&g_async.oth)) {
+		os_thread_helper_unlock(&g_async.oth);
+
+		bool any = async_drain();
+
+		os_thread_helper_lock(&g_async.oth);
+
+		// Nothing was queued, park for a while.
+		if (!any && os_thread_helper_is_running_locked(&g_async.oth)) {
+			os_thread_helper_timedwait_locked(&g_async.oth, U_MPSC_RING_PARK_NS);
+		}
+	}
+	os_thread_helper_unlock(&g_async.oth);
+
+	// Get out what was queued before stopping.
+	async_drain();
+
+	return NULL;
+}
+
+static void
+async_stop(void)
+{
+	int32_t old = xrt_atomic_s32_cmpxchg(&g_async.state, LOG_ASYNC_STATE_RUNNING, LOG_ASYNC_STATE_STOPPED);
+	if (old != LOG_ASYNC_STATE_RUNNING) {
+		return;
+	}
+
+	/*
+	 * New messages are now output on the calling thread, the ring is
+	 * leaked on purpose as a producer could still be writing to it.
+	 */
+	os_thread_helper_stop_and_wait(&g_async.oth);
+}
+
+static void
+async_start(void)
+{
+	struct log_async_slot *slots = U_TYPED_ARRAY_CALLOC(struct log_async_slot, LOG_ASYNC_RING_SIZE);
+	if (slots == NULL || !u_mpsc_ring_init(&g_async.ring, LOG_ASYNC_RING_SIZE)) {
+		free(slots);
+		u_atomic_s32_store_release(&g_async.state, LOG_ASYNC_STATE_STOPPED);
+		return;
+	}
+	g_async.slots = slots;
+
+	if (os_thread_helper_init(&g_async.oth) != 0 ||
+	    os_thread_helper_start(&g_async.oth, async_writer, NULL) != 0) {
+		u_atomic_s32_store_release(&g_async.state, LOG_ASYNC_STATE_STOPPED);
+		return;
+	}
+
+	// Make sure buffered messages are written out on exit.
+	atexit(async_stop);
+
+	u_atomic_s32_store_release(&g_async.state, LOG_ASYNC_STATE_RUNNING);
+}
+
+static bool
+async_is_running(void)
+{
+	int32_t state = u_atomic_s32_load_acquire(&g_async.state);
+	if (state == LOG_ASYNC_STATE_RUNNING) {
+		return true;
+	}
+
+	if (state != LOG_ASYNC_STATE_OFF || !debug_get_bool_option_async_log()) {
+		return false;
+	}
+
+	// Only one thread starts the writer, others log directly until it runs.
+	int32_t old = xrt_atomic_s32_cmpxchg(&g_async.state, LOG_ASYNC_STATE_OFF, LOG_ASYNC_STATE_STARTING);
+	if (old != LOG_ASYNC_STATE_OFF) {
+		return false;
+	}
+
+	async_start();
+
+	return u_atomic_s32_load_acquire(&g_async.state) == LOG_ASYNC_STATE_RUNNING;
+}
+
+/*!
+ * Formats the message straight into a claimed slot. If the ring is full the
+ * message is dropped, except for errors where false is returned so they can
+ * be output directly.
+ */
+static bool
+async_push(const char *func, enum u_logging_level level, const char *format, va_list args)
+{
+	int32_t pos;
+	if (!u_mpsc_ring_claim(&g_async.ring, &pos)) {
+		// The ring is full.
+		if (level >= U_LOGGING_ERROR) {
+			return false;
+		}
+		u_mpsc_ring_drop(&g_async.ring);
+		return true;
+	}
+
+	struct log_async_slot *slot = &g_async.slots[u_mpsc_ring_index(&g_async.ring, pos)];
+
+	int printed = format_message(slot->storage, sizeof(slot->storage), func, level, format, args);
+	if (printed < 0) {
+		// Still need to hand the slot back, output an empty message.
+		slot->storage[0] = '\0';
+		printed = 0;
+	}
+
+	slot->level = level;
+	slot->func = func;
+	slot->printed = printed;
+
+	// Publish the message.
+	u_mpsc_ring_publish(&g_async.ring, pos);
+
+	// Errors go out as soon as possible, and don't let the ring fill up.
+	if (level >= U_LOGGING_ERROR || u_mpsc_ring_should_wake(&g_async.ring, pos)) {
+		os_thread_helper_lock(&g_async.oth);
+		os_thread_helper_signal_locked(&g_async.oth);
+		os_thread_helper_unlock(&g_async.oth);
+	}
+
+	return true;
+}
+
+static int
+do_print(const char *file, int line, const char *func, enum u_logging_level level, const char *format, va_list args)
+{
+	if (debug_get_bool_option_json_log()) {
+		return log_as_json(file, func, level, format, args);
+	}
+
+	if (async_is_running()) {
+		va_list copy;
+		va_copy(copy, args);
+		bool pushed = async_push(func, level, format, copy);
+		va_end(copy);
+
+		if (pushed) {
+			return 0;
+		}
+	}
+
+	char storage[LOG_BUFFER_SIZE];
+
+	int printed = format_message(storage, sizeof(storage), func, level, format, args);
+	if (printed < 0) {
+		return printed;
+	}
+
+	return output_message(storage, printed, func, level);
+}
+
+
 /*
  *
  * 'Exported' functions.
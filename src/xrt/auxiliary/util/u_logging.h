@@ -261,7 +261,8 @@ u_log_xdev_hex(const char *file,
 
 /*!
  * Sets the logging sink, log is still passed on to the platform defined output
- * as well as the sink.
+ * as well as the sink. The sink is always called on the logging thread, also
+ * when the platform output is done asynchronously because of XRT_LOG_ASYNC.
  *
  * @param func Logging function for the calls to be sent to.
  * @param data User data to be passed into @p func.
@@ -11,20 +11,54 @@
 
 #include "util/u_metrics.h"
 #include "util/u_debug.h"
+#include "util/u_time.h"
+#include "util/u_thread_role.h"
+#include "util/u_mpsc_ring.h"
 
 #include "monado_metrics.pb.h"
 #include "pb_encode.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #define VERSION_MAJOR 1
-#define VERSION_MINOR 1
+#define VERSION_MINOR 2
+
+/*
+ * Number of records the ring holds, must be a power of two. At a few records
+ * per frame this is a couple of seconds worth.
+ */
+#define RING_SIZE (1024)
+
+/*
+ * Encoded records are batched up to this size before being written.
+ */
+#define BATCH_SIZE (64 * 1024)
 
 static FILE *g_file = NULL;
-static struct os_mutex g_file_mutex;
 static bool g_metrics_initialized = false;
 static bool g_metrics_early_flush = false;
 
+//! Records pushed by any thread, written by the writer thread.
+static monado_metrics_Record *g_records = NULL;
+
+//! Positions in @ref g_records.
+static struct u_mpsc_ring g_ring;
+
+//! Encoded records waiting to be written, only touched by the writer thread.
+static uint8_t g_batch[BATCH_SIZE];
+static size_t g_batch_size = 0;
+
+static struct os_thread_helper g_writer;
+
+//! Live stats, writes are serialized by @ref g_stats_mutex.
+static struct u_metrics_stats *g_stats = NULL;
+static struct os_mutex g_stats_mutex;
+static bool g_stats_mutex_initialized = false;
+
+//! Previous actual present time, for the frame period, guarded by @ref g_stats_mutex.
+static uint64_t g_stats_last_present_ns = 0;
+
 DEBUG_GET_ONCE_OPTION(metrics_file, "XRT_METRICS_FILE", NULL)
 DEBUG_GET_ONCE_BOOL_OPTION(metrics_early_flush, "XRT_METRICS_EARLY_FLUSH", false)
 
@@ -32,15 +66,29 @@ DEBUG_GET_ONCE_BOOL_OPTION(metrics_early_flush, "XRT_METRICS_EARLY_FLUSH", false
 
 /*
  *
- * Helper functions.
+ * Writer thread functions.
  *
  */
 
 static void
-write_record(monado_metrics_Record *r)
+flush_batch(void)
 {
-	uint8_t buffer[monado_metrics_Record_size + 10]; // Including submessage
+	if (g_batch_size == 0) {
+		return;
+	}
+
+	fwrite(g_batch, g_batch_size, 1, g_file);
+	g_batch_size = 0;
 
+	if (g_metrics_early_flush) {
+		fflush(g_file);
+	}
+}
+
+static void
+encode_record(const monado_metrics_Record *r)
+{
+	uint8_t buffer[monado_metrics_Record_size + 10]; // Including submessage
 
 	pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
 	bool ret = pb_encode_submessage(&stream, &monado_metrics_Record_msg, r);
@@ -49,15 +97,93 @@ write_record(monado_metrics_Record *r)
 		return;
 	}
 
-	os_mutex_lock(&g_file_mutex);
+	if (g_batch_size + stream.bytes_written > sizeof(g_batch)) {
+		flush_batch();
+	}
 
-	fwrite(buffer, stream.bytes_written, 1, g_file);
+	memcpy(g_batch + g_batch_size, buffer, stream.bytes_written);
+	g_batch_size += stream.bytes_written;
+}
 
-	if (g_metrics_early_flush) {
-		fflush(g_file);
+//! Encodes all queued records, returns true if there were any.
+static bool
+drain_ring(void)
+{
+	bool any = false;
+
+	uint32_t index;
+	while (u_mpsc_ring_peek(&g_ring, &index)) {
+		encode_record(&g_records[index]);
+
+		u_mpsc_ring_release(&g_ring);
+		any = true;
+	}
+
+	return any;
+}
+
+static void *
+writer_mainloop(void *ptr)
+{
+	os_thread_helper_name(&g_writer, "Metrics Writer");
+	u_thread_role_apply(U_THREAD_ROLE_BACKGROUND, U_LOGGING_WARN, "Metrics Writer");
+
+	os_thread_helper_lock(&g_writer);
+	while (os_thread_helper_is_running_locked(&g_writer)) {
+		os_thread_helper_unlock(&g_writer);
+
+		// Write out the batch whenever the ring runs dry.
+		if (!drain_ring()) {
+			flush_batch();
+		}
+
+		os_thread_helper_lock(&g_writer);
+
+		if (g_batch_size == 0 && os_thread_helper_is_running_locked(&g_writer)) {
+			os_thread_helper_timedwait_locked(&g_writer, U_MPSC_RING_PARK_NS);
+		}
+	}
+	os_thread_helper_unlock(&g_writer);
+
+	// Get out what was queued before stopping.
+	drain_ring();
+	flush_batch();
+
+	return NULL;
+}
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+/*!
+ * Copies the record into the ring, the record is dropped if the ring is full.
+ * Can be called from any thread, only takes a lock to wake up the writer when
+ * @ref u_mpsc_ring_should_wake says so.
+ */
+static void
+write_record(monado_metrics_Record *r)
+{
+	int32_t pos;
+	if (!u_mpsc_ring_claim(&g_ring, &pos)) {
+		// The writer can't keep up.
+		u_mpsc_ring_drop(&g_ring);
+		return;
 	}
 
-	os_mutex_unlock(&g_file_mutex);
+	g_records[u_mpsc_ring_index(&g_ring, pos)] = *r;
+
+	// Publish the record.
+	u_mpsc_ring_publish(&g_ring, pos);
+
+	if (u_mpsc_ring_should_wake(&g_ring, pos)) {
+		os_thread_helper_lock(&g_writer);
+		os_thread_helper_signal_locked(&g_writer);
+		os_thread_helper_unlock(&g_writer);
+	}
 }
 
 static void
@@ -78,6 +204,171 @@ write_version(uint32_t major, uint32_t minor)
 }
 
 
+/*
+ *
+ * Stats functions.
+ *
+ */
+
+static struct u_metrics_stats *
+stats_lock(void)
+{
+	if (g_stats == NULL) {
+		return NULL;
+	}
+
+	os_mutex_lock(&g_stats_mutex);
+	if (g_stats == NULL) {
+		os_mutex_unlock(&g_stats_mutex);
+		return NULL;
+	}
+
+	u_seqlock_write_begin(&g_stats->lock);
+
+	return g_stats;
+}
+
+static void
+stats_unlock(struct u_metrics_stats *stats)
+{
+	u_seqlock_write_end(&stats->lock);
+	os_mutex_unlock(&g_stats_mutex);
+}
+
+//! Finds the session or takes over the one that delivered a frame longest ago.
+static struct u_metrics_stats_session *
+stats_get_session(struct u_metrics_stats *stats, int64_t session_id)
+{
+	struct u_metrics_stats_session *oldest = &stats->sessions[0];
+
+	for (uint32_t i = 0; i < U_METRICS_STATS_MAX_SESSIONS; i++) {
+		struct u_metrics_stats_session *s = &stats->sessions[i];
+		if (s->valid && s->session_id == session_id) {
+			return s;
+		}
+
+		if (!s->valid) {
+			oldest = s;
+		} else if (oldest->valid && s->when_delivered_ns < oldest->when_delivered_ns) {
+			oldest = s;
+		}
+	}
+
+	U_ZERO(oldest);
+	oldest->valid = true;
+	oldest->session_id = session_id;
+
+	return oldest;
+}
+
+static void
+stats_session_frame(struct u_metrics_session_frame *umsf)
+{
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	struct u_metrics_stats_session *s = stats_get_session(stats, umsf->session_id);
+	if (umsf->discarded) {
+		s->discarded_frame_count++;
+	} else {
+		s->frame_count++;
+		s->when_delivered_ns = umsf->when_delivered_ns;
+
+		if (umsf->display_time_ns > umsf->when_wait_woke_ns) {
+			s->latency_ns = umsf->display_time_ns - umsf->when_wait_woke_ns;
+		}
+		if (umsf->when_delivered_ns > umsf->when_begin_ns) {
+			s->cpu_time_ns = umsf->when_delivered_ns - umsf->when_begin_ns;
+		}
+	}
+
+	stats_unlock(stats);
+}
+
+/*!
+ * Only written by the fake compositor pacing, which has no present timing,
+ * the real one writes present info instead.
+ */
+static void
+stats_system_frame(struct u_metrics_system_frame *umsf)
+{
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	stats->frame_count++;
+	stats->frame_period_ns = umsf->predicted_display_period_ns;
+
+	stats_unlock(stats);
+}
+
+static void
+stats_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
+{
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	if (umgi->gpu_end_ns > umgi->gpu_start_ns) {
+		stats->gpu_time_ns = umgi->gpu_end_ns - umgi->gpu_start_ns;
+	}
+	stats->layer_squash_ns = umgi->layer_squash_ns;
+	stats->distortion_ns = umgi->distortion_ns;
+
+	stats_unlock(stats);
+}
+
+static void
+stats_system_present_info(struct u_metrics_system_present_info *umpi)
+{
+	uint64_t actual_ns = umpi->actual_present_time_ns;
+	if (actual_ns == 0) {
+		// Present timing not available.
+		return;
+	}
+
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	stats->frame_count++;
+
+	// Same as the compositor pacing uses to detect missed frames.
+	if (actual_ns > umpi->desired_present_time_ns + U_TIME_HALF_MS_IN_NS) {
+		stats->missed_frame_count++;
+	}
+
+	if (g_stats_last_present_ns != 0 && actual_ns > g_stats_last_present_ns) {
+		stats->frame_period_ns = actual_ns - g_stats_last_present_ns;
+	}
+	g_stats_last_present_ns = actual_ns;
+
+	stats_unlock(stats);
+}
+
+static void
+stats_system_latency(struct u_metrics_system_latency *umsl)
+{
+	if (umsl->present_time_ns <= umsl->pose_sample_ns) {
+		return;
+	}
+
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	stats->pose_latency_ns = umsl->present_time_ns - umsl->pose_sample_ns;
+
+	stats_unlock(stats);
+}
+
+
 /*
  *
  * 'Exported' functions.
@@ -99,11 +390,35 @@ u_metrics_init(void)
 		return;
 	}
 
-	os_mutex_init(&g_file_mutex);
+	g_records = U_TYPED_ARRAY_CALLOC(monado_metrics_Record, RING_SIZE);
+	if (g_records == NULL || !u_mpsc_ring_init(&g_ring, RING_SIZE)) {
+		U_LOG_E("Could not allocate the metrics ring!");
+		free(g_records);
+		g_records = NULL;
+		fclose(g_file);
+		g_file = NULL;
+		return;
+	}
 
-	g_metrics_initialized = true;
 	g_metrics_early_flush = debug_get_bool_option_metrics_early_flush();
 
+	int ret = os_thread_helper_init(&g_writer);
+	if (ret == 0) {
+		ret = os_thread_helper_start(&g_writer, writer_mainloop, NULL);
+	}
+	if (ret != 0) {
+		U_LOG_E("Could not start metrics writer thread!");
+		os_thread_helper_destroy(&g_writer);
+		u_mpsc_ring_fini(&g_ring);
+		free(g_records);
+		g_records = NULL;
+		fclose(g_file);
+		g_file = NULL;
+		return;
+	}
+
+	g_metrics_initialized = true;
+
 	write_version(VERSION_MAJOR, VERSION_MINOR);
 
 	U_LOG_I("Opened metrics file: '%s'", str);
@@ -118,27 +433,72 @@ u_metrics_close(void)
 
 	U_LOG_I("Closing metrics file: '%s'", debug_get_option_metrics_file());
 
-	// At least try to avoid races.
-	os_mutex_lock(&g_file_mutex);
+	// Stop new records, at least try to avoid races.
+	g_metrics_initialized = false;
+
+	// Writes out everything queued.
+	os_thread_helper_destroy(&g_writer);
+
+	int32_t dropped = u_mpsc_ring_get_dropped(&g_ring);
+	if (dropped > 0) {
+		U_LOG_W("Dropped %d metrics records, the writer could not keep up!", dropped);
+	}
+
 	fflush(g_file);
 	fclose(g_file);
 	g_file = NULL;
-	os_mutex_unlock(&g_file_mutex);
-
-	os_mutex_destroy(&g_file_mutex);
 
-	g_metrics_initialized = false;
+	u_mpsc_ring_fini(&g_ring);
+	free(g_records);
+	g_records = NULL;
 }
 
 bool
 u_metrics_is_active(void)
 {
-	return g_metrics_initialized;
+	return g_metrics_initialized || g_stats != NULL;
+}
+
+void
+u_metrics_set_stats(struct u_metrics_stats *stats)
+{
+	if (!g_stats_mutex_initialized) {
+		os_mutex_init(&g_stats_mutex);
+		g_stats_mutex_initialized = true;
+	}
+
+	os_mutex_lock(&g_stats_mutex);
+	g_stats = stats;
+	g_stats_last_present_ns = 0;
+	os_mutex_unlock(&g_stats_mutex);
+}
+
+void
+u_metrics_write_device_calls(uint32_t device_index, const struct u_metrics_latency_histogram *calls)
+{
+	if (device_index >= U_METRICS_STATS_MAX_DEVICES) {
+		return;
+	}
+
+	struct u_metrics_stats *stats = stats_lock();
+	if (stats == NULL) {
+		return;
+	}
+
+	struct u_metrics_stats_device *d = &stats->devices[device_index];
+	for (uint32_t i = 0; i < U_METRICS_DEVICE_CALL_COUNT; i++) {
+		d->calls[i] = calls[i];
+	}
+	d->valid = true;
+
+	stats_unlock(stats);
 }
 
 void
 u_metrics_write_session_frame(struct u_metrics_session_frame *umsf)
 {
+	stats_session_frame(umsf);
+
 	if (!g_metrics_initialized) {
 		return;
 	}
@@ -179,6 +539,8 @@ u_metrics_write_used(struct u_metrics_used *umu)
 void
 u_metrics_write_system_frame(struct u_metrics_system_frame *umsf)
 {
+	stats_system_frame(umsf);
+
 	if (!g_metrics_initialized) {
 		return;
 	}
@@ -199,6 +561,8 @@ u_metrics_write_system_frame(struct u_metrics_system_frame *umsf)
 void
 u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
 {
+	stats_system_gpu_info(umgi);
+
 	if (!g_metrics_initialized) {
 		return;
 	}
@@ -219,6 +583,8 @@ u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
 void
 u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi)
 {
+	stats_system_present_info(umpi);
+
 	if (!g_metrics_initialized) {
 		return;
 	}
@@ -233,5 +599,27 @@ u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi)
 #undef COPY
 
 
+	write_record(&record);
+}
+
+void
+u_metrics_write_system_latency(struct u_metrics_system_latency *umsl)
+{
+	stats_system_latency(umsl);
+
+	if (!g_metrics_initialized) {
+		return;
+	}
+
+	monado_metrics_Record record = monado_metrics_Record_init_default;
+
+	// Select which filed is used.
+	record.which_record = monado_metrics_Record_system_latency_tag;
+
+#define COPY(_0, _1, _2, _3, FIELD, _4) (record.record.system_latency.FIELD = umsl->FIELD);
+	monado_metrics_SystemLatency_FIELDLIST(COPY, 0);
+#undef COPY
+
+
 	write_record(&record);
 }
@@ -11,6 +11,8 @@
 
 #include "xrt/xrt_compiler.h"
 
+#include "util/u_seqlock.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +59,8 @@ struct u_metrics_system_gpu_info
 	int64_t frame_id;
 	uint64_t gpu_start_ns;
 	uint64_t gpu_end_ns;
+	uint64_t layer_squash_ns;
+	uint64_t distortion_ns;
 	uint64_t when_ns;
 };
 
@@ -79,6 +83,191 @@ struct u_metrics_system_present_info
 	uint64_t earliest_present_time_ns;
 };
 
+/*!
+ * Motion to photon latency of a compositor frame, from when the oldest pose
+ * used to render any of its layers was sampled to when it was presented.
+ */
+struct u_metrics_system_latency
+{
+	int64_t frame_id;
+	uint64_t pose_sample_ns;
+
+	//! Actual present time if known, otherwise the predicted one.
+	uint64_t present_time_ns;
+	bool present_time_is_actual;
+};
+
+
+/*!
+ * Max number of sessions tracked in @ref u_metrics_stats.
+ */
+#define U_METRICS_STATS_MAX_SESSIONS (8)
+
+/*!
+ * Live stats of a single session, see @ref u_metrics_stats.
+ */
+struct u_metrics_stats_session
+{
+	//! Set once the session has delivered or discarded a frame.
+	bool valid;
+
+	int64_t session_id;
+
+	//! Frames delivered to the compositor.
+	uint64_t frame_count;
+
+	//! Frames discarded by the session.
+	uint64_t discarded_frame_count;
+
+	//! From the app waking up from xrWaitFrame to the display time, latest frame.
+	uint64_t latency_ns;
+
+	//! From xrBeginFrame to the frame being delivered, latest frame.
+	uint64_t cpu_time_ns;
+
+	//! When the latest frame was delivered, for finding stale sessions.
+	uint64_t when_delivered_ns;
+};
+
+/*!
+ * Max number of devices tracked in @ref u_metrics_stats, indexed the same as
+ * @ref xrt_system_devices::xdevs.
+ */
+#define U_METRICS_STATS_MAX_DEVICES (16)
+
+/*!
+ * Number of buckets in @ref u_metrics_latency_histogram, bucket zero is below
+ * two microseconds, each following one twice as wide and the last one
+ * everything from 32ms and up.
+ */
+#define U_METRICS_LATENCY_BUCKET_COUNT (16)
+
+/*!
+ * Device entry points that the latency of is tracked, see
+ * @ref u_metrics_stats_device.
+ */
+enum u_metrics_device_call
+{
+	U_METRICS_DEVICE_CALL_GET_TRACKED_POSE,
+	U_METRICS_DEVICE_CALL_GET_HAND_TRACKING,
+	U_METRICS_DEVICE_CALL_UPDATE_INPUTS,
+	U_METRICS_DEVICE_CALL_SET_OUTPUT,
+	U_METRICS_DEVICE_CALL_GET_VIEW_POSES,
+	U_METRICS_DEVICE_CALL_COUNT,
+};
+
+/*!
+ * Log2 latency histogram of calls, counters only go up.
+ */
+struct u_metrics_latency_histogram
+{
+	//! Number of calls made.
+	uint64_t count;
+
+	//! Sum of the time of all calls, for the mean.
+	uint64_t total_ns;
+
+	//! Longest call.
+	uint64_t max_ns;
+
+	//! Number of calls per bucket, see @ref u_metrics_latency_bucket.
+	uint64_t buckets[U_METRICS_LATENCY_BUCKET_COUNT];
+};
+
+/*!
+ * Call latencies of a single device, see @ref u_metrics_stats.
+ */
+struct u_metrics_stats_device
+{
+	//! Set once latencies have been published for the device.
+	bool valid;
+
+	struct u_metrics_latency_histogram calls[U_METRICS_DEVICE_CALL_COUNT];
+};
+
+/*!
+ * Returns which bucket of @ref u_metrics_latency_histogram a call taking
+ * @p duration_ns falls into.
+ */
+static inline uint32_t
+u_metrics_latency_bucket(uint64_t duration_ns)
+{
+	uint64_t us = duration_ns / 1000;
+	uint32_t bucket = 0;
+
+	while (us >= 2 && bucket < U_METRICS_LATENCY_BUCKET_COUNT - 1) {
+		us >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*!
+ * Adds a call taking @p duration_ns to the histogram.
+ */
+static inline void
+u_metrics_latency_histogram_add(struct u_metrics_latency_histogram *hist, uint64_t duration_ns)
+{
+	hist->count++;
+	hist->total_ns += duration_ns;
+	if (duration_ns > hist->max_ns) {
+		hist->max_ns = duration_ns;
+	}
+	hist->buckets[u_metrics_latency_bucket(duration_ns)]++;
+}
+
+/*!
+ * Live stats kept up to date by the metrics functions, meant to be placed in
+ * memory shared with monitoring tools. Counters only ever go up, the reader
+ * samples them to get rates. The writer is inside the metrics functions,
+ * readers copy it out with @ref u_metrics_stats_copy.
+ */
+struct u_metrics_stats
+{
+	//! Guards all other fields.
+	struct u_seqlock lock;
+
+	//! Frames presented by the compositor.
+	uint64_t frame_count;
+
+	//! Frames presented more than half a millisecond after the desired time.
+	uint64_t missed_frame_count;
+
+	//! Time between the latest two presents.
+	uint64_t frame_period_ns;
+
+	//! GPU time of the latest compositor frame.
+	uint64_t gpu_time_ns;
+
+	//! Layer squashing part of @ref gpu_time_ns, zero if not measured.
+	uint64_t layer_squash_ns;
+
+	//! Distortion part of @ref gpu_time_ns, zero if not measured.
+	uint64_t distortion_ns;
+
+	//! From pose sample to present of the latest compositor frame, zero if not measured.
+	uint64_t pose_latency_ns;
+
+	//! Sessions most recently seen, check @ref u_metrics_stats_session::valid.
+	struct u_metrics_stats_session sessions[U_METRICS_STATS_MAX_SESSIONS];
+
+	//! Call latencies of instrumented devices, check @ref u_metrics_stats_device::valid.
+	struct u_metrics_stats_device devices[U_METRICS_STATS_MAX_DEVICES];
+};
+
+/*!
+ * Copies out a consistent snapshot of @p stats, does not block the writer.
+ */
+static inline void
+u_metrics_stats_copy(const struct u_metrics_stats *stats, struct u_metrics_stats *out_stats)
+{
+	uint32_t seq;
+	do {
+		seq = u_seqlock_read_begin(&stats->lock);
+		*out_stats = *stats;
+	} while (u_seqlock_read_retry(&stats->lock, seq));
+}
 
 void
 u_metrics_init(void);
@@ -86,9 +275,30 @@ u_metrics_init(void);
 void
 u_metrics_close(void);
 
+/*!
+ * Returns true if there is a metrics file open or stats are being kept, the
+ * write functions only need to be called if this is true.
+ */
 bool
 u_metrics_is_active(void);
 
+/*!
+ * Starts keeping @p stats updated from the records written, NULL stops it.
+ * Independent of the metrics file. Once this returns the previous stats are no
+ * longer touched, so it can be freed.
+ */
+void
+u_metrics_set_stats(struct u_metrics_stats *stats);
+
+/*!
+ * Publishes the call latencies of the device at @p device_index to the live
+ * stats, @p calls holds @ref U_METRICS_DEVICE_CALL_COUNT histograms. Only goes
+ * to the stats, not the metrics file. Devices at indices past
+ * @ref U_METRICS_STATS_MAX_DEVICES are ignored.
+ */
+void
+u_metrics_write_device_calls(uint32_t device_index, const struct u_metrics_latency_histogram *calls);
+
 void
 u_metrics_write_session_frame(struct u_metrics_session_frame *umsf);
 
@@ -104,6 +314,9 @@ u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi);
 void
 u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi);
 
+void
+u_metrics_write_system_latency(struct u_metrics_system_latency *umsl);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,263 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Bounded lock free multi-producer single-consumer ring positions.
+ *
+ * Only keeps track of positions, the user keeps an array of slots of the
+ * same size and indexes it with @ref u_mpsc_ring_index. Each slot has a
+ * sequence number that tells if it is free to be written at a given position
+ * or ready to be consumed, producers claim positions with a compare and swap
+ * so no lock is taken to push.
+ *
+ * ```c
+ * // Producer, any thread.
+ * int32_t pos;
+ * if (!u_mpsc_ring_claim(&ring, &pos)) {
+ * 	u_mpsc_ring_drop(&ring);
+ * 	return;
+ * }
+ * slots[u_mpsc_ring_index(&ring, pos)] = data;
+ * u_mpsc_ring_publish(&ring, pos);
+ *
+ * // Consumer, a single thread.
+ * uint32_t index;
+ * while (u_mpsc_ring_peek(&ring, &index)) {
+ * 	consume(&slots[index]);
+ * 	u_mpsc_ring_release(&ring);
+ * }
+ * ```
+ *
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "util/u_atomic.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * How long a consumer thread should park for when the ring is empty, it is
+ * only woken up early when @ref u_mpsc_ring_should_wake says so.
+ */
+#define U_MPSC_RING_PARK_NS (5 * U_TIME_1MS_IN_NS)
+
+/*!
+ * Positions of a bounded multi-producer single-consumer ring.
+ *
+ * @ingroup aux_util
+ */
+struct u_mpsc_ring
+{
+	//! Next position to be claimed by a producer.
+	xrt_atomic_s32_t enqueue_pos;
+
+	//! Next position to be consumed, only touched by the consumer.
+	int32_t dequeue_pos;
+
+	//! Total number of pushes dropped because the ring was full.
+	xrt_atomic_s32_t dropped;
+
+	//! Number of slots, a power of two.
+	uint32_t size;
+
+	/*!
+	 * Sequence number per slot, equals the position when free and position
+	 * + 1 when ready to be consumed.
+	 */
+	xrt_atomic_s32_t *seqs;
+};
+
+static inline int32_t
+u_mpsc_ring_pos_add(int32_t pos, uint32_t value)
+{
+	// Positions wrap around.
+	return (int32_t)((uint32_t)pos + value);
+}
+
+static inline int32_t
+u_mpsc_ring_pos_diff(int32_t a, int32_t b)
+{
+	return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+/*!
+ * Allocates the sequence numbers, @p size must be a power of two. Returns
+ * false if the allocation failed.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline bool
+u_mpsc_ring_init(struct u_mpsc_ring *ring, uint32_t size)
+{
+	xrt_atomic_s32_t *seqs = U_TYPED_ARRAY_CALLOC(xrt_atomic_s32_t, size);
+	if (seqs == NULL) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < size; i++) {
+		seqs[i] = (int32_t)i;
+	}
+
+	ring->enqueue_pos = 0;
+	ring->dequeue_pos = 0;
+	ring->dropped = 0;
+	ring->size = size;
+	ring->seqs = seqs;
+
+	return true;
+}
+
+/*!
+ * Frees the sequence numbers, no producer may be using the ring.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline void
+u_mpsc_ring_fini(struct u_mpsc_ring *ring)
+{
+	free((void *)ring->seqs);
+	ring->seqs = NULL;
+	ring->size = 0;
+}
+
+/*!
+ * The slot index of a position.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline uint32_t
+u_mpsc_ring_index(const struct u_mpsc_ring *ring, int32_t pos)
+{
+	return (uint32_t)pos & (ring->size - 1);
+}
+
+/*!
+ * Claims the next position for a producer, returns false if the ring is
+ * full. The slot must then be filled and handed to @ref u_mpsc_ring_publish.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline bool
+u_mpsc_ring_claim(struct u_mpsc_ring *ring, int32_t *out_pos)
+{
+	int32_t pos = u_atomic_s32_load_acquire(&ring->enqueue_pos);
+
+	while (true) {
+		xrt_atomic_s32_t *seq = &ring->seqs[u_mpsc_ring_index(ring, pos)];
+		int32_t diff = u_mpsc_ring_pos_diff(u_atomic_s32_load_acquire(seq), pos);
+
+		if (diff < 0) {
+			// The consumer hasn't freed this slot yet, the ring is full.
+			return false;
+		}
+
+		if (diff > 0) {
+			// Another producer claimed this position, try the latest one.
+			pos = u_atomic_s32_load_acquire(&ring->enqueue_pos);
+			continue;
+		}
+
+		int32_t old = xrt_atomic_s32_cmpxchg(&ring->enqueue_pos, pos, u_mpsc_ring_pos_add(pos, 1));
+		if (old == pos) {
+			break;
+		}
+		pos = old;
+	}
+
+	*out_pos = pos;
+
+	return true;
+}
+
+/*!
+ * Counts a push that was dropped because the ring was full.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline void
+u_mpsc_ring_drop(struct u_mpsc_ring *ring)
+{
+	xrt_atomic_s32_inc_return(&ring->dropped);
+}
+
+/*!
+ * Makes the slot at the claimed position visible to the consumer.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline void
+u_mpsc_ring_publish(struct u_mpsc_ring *ring, int32_t pos)
+{
+	u_atomic_s32_store_release(&ring->seqs[u_mpsc_ring_index(ring, pos)], u_mpsc_ring_pos_add(pos, 1));
+}
+
+/*!
+ * Should the producer that published @p pos wake up the consumer, true once
+ * every quarter of the ring so the consumer can mostly park.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline bool
+u_mpsc_ring_should_wake(const struct u_mpsc_ring *ring, int32_t pos)
+{
+	return ((uint32_t)pos % (ring->size / 4)) == 0;
+}
+
+/*!
+ * Gets the slot index of the next position to consume, returns false if it
+ * has not been published yet. Only called from the consumer.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline bool
+u_mpsc_ring_peek(const struct u_mpsc_ring *ring, uint32_t *out_index)
+{
+	uint32_t index = u_mpsc_ring_index(ring, ring->dequeue_pos);
+	if (u_atomic_s32_load_acquire(&ring->seqs[index]) != u_mpsc_ring_pos_add(ring->dequeue_pos, 1)) {
+		return false;
+	}
+
+	*out_index = index;
+
+	return true;
+}
+
+/*!
+ * Frees the slot returned by @ref u_mpsc_ring_peek for the position one lap
+ * ahead and moves on to the next position. Only called from the consumer.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline void
+u_mpsc_ring_release(struct u_mpsc_ring *ring)
+{
+	uint32_t index = u_mpsc_ring_index(ring, ring->dequeue_pos);
+	u_atomic_s32_store_release(&ring->seqs[index], u_mpsc_ring_pos_add(ring->dequeue_pos, ring->size));
+	ring->dequeue_pos = u_mpsc_ring_pos_add(ring->dequeue_pos, 1);
+}
+
+/*!
+ * Total number of dropped pushes so far.
+ *
+ * @public @memberof u_mpsc_ring
+ */
+static inline int32_t
+u_mpsc_ring_get_dropped(const struct u_mpsc_ring *ring)
+{
+	return u_atomic_s32_load_acquire(&ring->dropped);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -44,6 +44,13 @@ enum u_timing_point
 
 	//! Finished submitting work to the GPU, only used by the compositor.
 	U_TIMING_POINT_SUBMIT_END,
+
+	/*!
+	 * When the oldest pose that went into the frame was sampled, only used
+	 * by the compositor and only for latency metrics, may come at any point
+	 * between begin and submit end.
+	 */
+	U_TIMING_POINT_POSE_SAMPLE,
 };
 
 
@@ -152,6 +159,10 @@ struct u_pacing_compositor
 	 * @param[in] frame_id     The frame ID to record for.
 	 * @param[in] gpu_start_ns When the GPU work startred.
 	 * @param[in] gpu_end_ns   When the GPU work stopped.
+	 * @param[in] layer_squash_ns How long the layer squashing took on the
+	 *                            GPU, zero if not measured.
+	 * @param[in] distortion_ns   How long the distortion took on the GPU,
+	 *                            zero if not measured.
 	 * @param[in] when_ns      When the informatioon collected, nominally
 	 *                         from @ref os_monotonic_get_ns.
 	 *
@@ -161,8 +172,26 @@ struct u_pacing_compositor
 	                 int64_t frame_id,
 	                 uint64_t gpu_start_ns,
 	                 uint64_t gpu_end_ns,
+	                 uint64_t layer_squash_ns,
+	                 uint64_t distortion_ns,
 	                 uint64_t when_ns);
 
+	/*!
+	 * Provide what the compositor is rendering for a frame, called once the
+	 * layers are known and before the GPU work is submitted. The content of
+	 * the next frames is very likely the same, so the pacer can use this to
+	 * predict how long they will take, like when overlays come and go.
+	 *
+	 * @param[in] upc         The compositor pacing helper.
+	 * @param[in] frame_id    The frame ID to record for.
+	 * @param[in] layer_count Number of layers in the frame, zero if none.
+	 * @param[in] fast_path   The layers are not squashed, a single
+	 *                        projection layer goes straight to distortion.
+	 *
+	 * @see @ref frame-pacing.
+	 */
+	void (*info_layers)(struct u_pacing_compositor *upc, int64_t frame_id, uint32_t layer_count, bool fast_path);
+
 	/*!
 	 * Provide a vblank timing information, derived from the
 	 * VK_EXT_display_control extension. Since the extension only says when
@@ -191,6 +220,18 @@ struct u_pacing_compositor
 	                              int64_t frame_id,
 	                              uint64_t present_to_display_offset_ns);
 
+	/*!
+	 * Provide the refresh period of the display as reported by the platform,
+	 * for when it differs from the estimate the helper was created with or
+	 * changes at runtime.
+	 *
+	 * @param[in] upc              The compositor pacing helper.
+	 * @param[in] frame_period_ns  The time between two vblanks.
+	 *
+	 * @see @ref frame-pacing.
+	 */
+	void (*update_frame_period)(struct u_pacing_compositor *upc, uint64_t frame_period_ns);
+
 	/*!
 	 * Destroy this u_pacing_compositor.
 	 */
@@ -272,10 +313,29 @@ u_pc_info(struct u_pacing_compositor *upc,
  * @ingroup aux_pacing
  */
 static inline void
-u_pc_info_gpu(
-    struct u_pacing_compositor *upc, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+u_pc_info_gpu(struct u_pacing_compositor *upc,
+              int64_t frame_id,
+              uint64_t gpu_start_ns,
+              uint64_t gpu_end_ns,
+              uint64_t layer_squash_ns,
+              uint64_t distortion_ns,
+              uint64_t when_ns)
+{
+	upc->info_gpu(upc, frame_id, gpu_start_ns, gpu_end_ns, layer_squash_ns, distortion_ns, when_ns);
+}
+
+/*!
+ * @copydoc u_pacing_compositor::info_layers
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_compositor
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pc_info_layers(struct u_pacing_compositor *upc, int64_t frame_id, uint32_t layer_count, bool fast_path)
 {
-	upc->info_gpu(upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+	upc->info_layers(upc, frame_id, layer_count, fast_path);
 }
 
 /*!
@@ -292,6 +352,20 @@ u_pc_update_vblank_from_display_control(struct u_pacing_compositor *upc, uint64_
 	upc->update_vblank_from_display_control(upc, last_vblank_ns);
 }
 
+/*!
+ * @copydoc u_pacing_compositor::update_frame_period
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_compositor
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pc_update_frame_period(struct u_pacing_compositor *upc, uint64_t frame_period_ns)
+{
+	upc->update_frame_period(upc, frame_period_ns);
+}
+
 /*!
  * @copydoc u_pacing_compositor::update_present_offset
  *
@@ -433,6 +507,27 @@ struct u_pacing_app
 	 */
 	void (*retired)(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns);
 
+	/*!
+	 * Get the render scale the app would need to fit its GPU work within
+	 * the time it has per frame, derived from the measured GPU time. The
+	 * scale is for each axis of the views and relative to the resolution
+	 * the app is currently rendering at, 1.0 means it fits, never above 1.0.
+	 *
+	 * @param      upa       App pacer struct.
+	 * @param[out] out_scale The recommended render scale.
+	 */
+	void (*get_render_scale)(struct u_pacing_app *upa, float *out_scale);
+
+	/*!
+	 * Get how long the app is measured to take for a frame, from waking up
+	 * until its GPU work is done. Used by the multi compositor to stagger
+	 * when clients are woken up.
+	 *
+	 * @param      upa             App pacer struct.
+	 * @param[out] out_app_time_ns The measured app time.
+	 */
+	void (*get_app_time)(struct u_pacing_app *upa, uint64_t *out_app_time_ns);
+
 	/*!
 	 * Add a new sample point from the main render loop.
 	 *
@@ -538,6 +633,34 @@ u_pa_mark_gpu_done(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 	upa->mark_gpu_done(upa, frame_id, when_ns);
 }
 
+/*!
+ * @copydoc u_pacing_app::get_render_scale
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_get_render_scale(struct u_pacing_app *upa, float *out_scale)
+{
+	upa->get_render_scale(upa, out_scale);
+}
+
+/*!
+ * @copydoc u_pacing_app::get_app_time
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_get_app_time(struct u_pacing_app *upa, uint64_t *out_app_time_ns)
+{
+	upa->get_app_time(upa, out_app_time_ns);
+}
+
 /*!
  * @copydoc u_pacing_app::info
  *
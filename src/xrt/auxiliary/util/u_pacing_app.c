@@ -18,6 +18,7 @@
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <assert.h>
 #include <inttypes.h>
@@ -146,6 +147,8 @@ struct pacing_app
 		uint64_t draw_time_ns;
 		//! Time between the frame data being delivered and GPU completing.
 		uint64_t gpu_time_ns;
+		//! Render scale that would fit the GPU time in the frame, see @ref calc_render_scale.
+		float render_scale;
 	} app; //!< App statistics.
 
 	struct
@@ -196,6 +199,7 @@ point_to_str(enum u_timing_point point)
 	case U_TIMING_POINT_BEGIN: return "U_TIMING_POINT_BEGIN";
 	case U_TIMING_POINT_SUBMIT_BEGIN: return "U_TIMING_POINT_SUBMIT_BEGIN";
 	case U_TIMING_POINT_SUBMIT_END: return "U_TIMING_POINT_SUBMIT_END";
+	case U_TIMING_POINT_POSE_SAMPLE: return "U_TIMING_POINT_POSE_SAMPLE";
 	default: return "UNKNOWN";
 	}
 }
@@ -210,6 +214,12 @@ point_to_str(enum u_timing_point point)
 #define IIR_ALPHA_LT 0.8
 #define IIR_ALPHA_GT 0.8
 
+//! Fraction of the available frame time that the recommended render scale aims for.
+#define RENDER_SCALE_TARGET 0.9
+
+//! Lowest render scale that is recommended, below this it's better to drop frames.
+#define RENDER_SCALE_MIN 0.5
+
 static void
 do_iir_filter(uint64_t *target, double alpha_lt, double alpha_gt, uint64_t sample)
 {
@@ -275,6 +285,34 @@ total_app_and_compositor_time_ns(const struct pacing_app *pa)
 	return total_app_time_ns(pa) + total_compositor_time_ns(pa);
 }
 
+/*!
+ * The GPU time scales with the number of pixels, so the scale for each axis is
+ * the square root of the fraction of the GPU time that fits in the frame. Aim
+ * a bit below the frame time to leave some headroom for spikes.
+ */
+static float
+calc_render_scale(const struct pacing_app *pa)
+{
+	uint64_t period_ns = min_period(pa);
+	uint64_t compositor_ns = total_compositor_time_ns(pa);
+	uint64_t gpu_ns = pa->app.gpu_time_ns;
+
+	if (period_ns <= compositor_ns || gpu_ns == 0) {
+		return 1.0f;
+	}
+
+	double budget_ns = (double)(period_ns - compositor_ns) * RENDER_SCALE_TARGET;
+	double scale = sqrt(budget_ns / (double)gpu_ns);
+
+	if (scale > 1.0) {
+		scale = 1.0;
+	} else if (scale < RENDER_SCALE_MIN) {
+		scale = RENDER_SCALE_MIN;
+	}
+
+	return (float)scale;
+}
+
 static uint64_t
 calc_period(const struct pacing_app *pa)
 {
@@ -519,6 +557,7 @@ pa_mark_point(struct u_pacing_app *upa, int64_t frame_id, enum u_timing_point po
 		break;
 	case U_TIMING_POINT_SUBMIT_BEGIN:
 	case U_TIMING_POINT_SUBMIT_END:
+	case U_TIMING_POINT_POSE_SAMPLE:
 	default: assert(false);
 	}
 }
@@ -616,6 +655,8 @@ pa_mark_gpu_done(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 	do_iir_filter(&pa->app.draw_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_draw_ns);
 	do_iir_filter(&pa->app.gpu_time_ns, IIR_ALPHA_LT, IIR_ALPHA_GT, diff_gpu_ns);
 
+	pa->app.render_scale = calc_render_scale(pa);
+
 	// Write out metrics and tracing data.
 	do_metrics(pa, f, false);
 	do_tracing(pa, f);
@@ -672,6 +713,22 @@ pa_retired(struct u_pacing_app *upa, int64_t frame_id, uint64_t when_ns)
 #endif
 }
 
+static void
+pa_get_render_scale(struct u_pacing_app *upa, float *out_scale)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	*out_scale = pa->app.render_scale;
+}
+
+static void
+pa_get_app_time(struct u_pacing_app *upa, uint64_t *out_app_time_ns)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	*out_app_time_ns = total_app_time_ns(pa);
+}
+
 static void
 pa_info(struct u_pacing_app *upa,
         uint64_t predicted_display_time_ns,
@@ -704,11 +761,14 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	pa->base.mark_gpu_done = pa_mark_gpu_done;
 	pa->base.latched = pa_latched;
 	pa->base.retired = pa_retired;
+	pa->base.get_render_scale = pa_get_render_scale;
+	pa->base.get_app_time = pa_get_app_time;
 	pa->base.info = pa_info;
 	pa->base.destroy = pa_destroy;
 	pa->session_id = session_id;
 	pa->app.cpu_time_ns = U_TIME_1MS_IN_NS * 2;
 	pa->app.draw_time_ns = U_TIME_1MS_IN_NS * 2;
+	pa->app.render_scale = 1.0f;
 
 	pa->min_margin_ms = (struct u_var_draggable_f32){
 	    .val = debug_get_float_option_min_margin_ms(),
@@ -736,6 +796,7 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	u_var_add_ro_u64(pa, &pa->app.cpu_time_ns, "CPU time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.draw_time_ns, "Draw time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.gpu_time_ns, "GPU time(ns)");
+	u_var_add_ro_f32(pa, &pa->app.render_scale, "Recommended render scale");
 
 	*out_upa = &pa->base;
 
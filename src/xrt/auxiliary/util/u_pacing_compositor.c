@@ -9,6 +9,8 @@
 
 #include "os/os_time.h"
 
+#include "math/m_api.h"
+
 #include "util/u_time.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -17,6 +19,7 @@
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <assert.h>
 #include <inttypes.h>
@@ -33,6 +36,18 @@ DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_COMPOSITOR_LOG", U_LOGGING_WARN)
 
 #define PRESENT_SLOP_NS (U_TIME_HALF_MS_IN_NS)
 
+//! Kinds of frame content the compositor time is learned for, see @ref get_content_index.
+#define NUM_CONTENTS 9
+
+//! Samples needed before the learned time of a content is used.
+#define CONTENT_MIN_SAMPLES 4
+
+//! Weight of new samples in the learned times, roughly the last 16 frames count.
+#define CONTENT_ALPHA (1.0 / 16.0)
+
+//! Headroom over the learned mean time, in standard deviations.
+#define CONTENT_STDDEVS (3.0)
+
 
 /*
  *
@@ -78,6 +93,18 @@ struct frame
 	//! How much time we currently expect the compositor to take rendering a frame. Updated in `predict_next_frame`
 	uint64_t current_comp_time_ns;
 
+	//! How long the GPU work of this frame took, zero if not known. Set in `pc_info_gpu`.
+	uint64_t gpu_duration_ns;
+
+	//! Oldest pose sample in the frame, zero if not known. Set in `pc_mark_point` with `U_TIMING_POINT_POSE_SAMPLE`.
+	uint64_t when_pose_sampled_ns;
+
+	//! What the compositor rendered, -1 if not known. Set in `pc_info_layers`.
+	int32_t content;
+
+	//! Was frame::current_comp_time_ns learned from the content. Set in `predict_next_frame`.
+	bool comp_time_from_content;
+
 	uint64_t expected_done_time_ns;     //!< When we expect the compositor to be done with its frame.
 	uint64_t desired_present_time_ns;   //!< The GPU should start scanning out at this time.
 	uint64_t predicted_display_time_ns; //!< At what time have we predicted that pixels turns to photons.
@@ -88,6 +115,22 @@ struct frame
 	enum frame_state state;
 };
 
+/*!
+ * How long the compositor needs for one kind of content, from when it was
+ * supposed to wake up until the GPU is done.
+ */
+struct content_time
+{
+	//! Exponentially weighted mean.
+	double mean_ns;
+
+	//! Exponentially weighted variance.
+	double var_ns2;
+
+	//! Number of samples, stops counting at @ref CONTENT_MIN_SAMPLES.
+	uint32_t samples;
+};
+
 struct pacing_compositor
 {
 	struct u_pacing_compositor base;
@@ -135,6 +178,24 @@ struct pacing_compositor
 	 */
 	uint64_t margin_ns;
 
+	/*!
+	 * Learned compositor time for each kind of content, used instead of
+	 * @ref comp_time_ns once the compositor reports what it renders.
+	 */
+	struct content_time contents[NUM_CONTENTS];
+
+	/*!
+	 * Content of the latest frame the compositor rendered, -1 if it never
+	 * reported any. The next frame most likely has the same content.
+	 */
+	int32_t last_content;
+
+	/*!
+	 * Added to the learned compositor time after missed frames, and taken
+	 * away again for every frame that wasn't missed.
+	 */
+	uint64_t miss_penalty_ns;
+
 	/*!
 	 * Frame store.
 	 */
@@ -167,10 +228,70 @@ get_percent_of_time(uint64_t time_ns, uint32_t fraction_percent)
 	return time_s_to_ns(time_ns_to_s(time_ns) * fraction);
 }
 
+/*!
+ * Kind of content, 0 for frames where nothing is squashed and otherwise the
+ * number of squashed layers, the last kind covers anything with more.
+ */
+static int32_t
+get_content_index(uint32_t layer_count, bool fast_path)
+{
+	if (fast_path || layer_count == 0) {
+		return 0;
+	}
+
+	return (int32_t)MIN(layer_count, NUM_CONTENTS - 1);
+}
+
+static void
+update_content_time(struct content_time *ct, uint64_t sample_ns)
+{
+	if (ct->samples < CONTENT_MIN_SAMPLES) {
+		ct->samples++;
+	}
+
+	// Plain average until there are enough samples, then forget old ones.
+	double alpha = MAX(1.0 / ct->samples, CONTENT_ALPHA);
+	double diff = (double)sample_ns - ct->mean_ns;
+	double incr = alpha * diff;
+
+	ct->mean_ns += incr;
+	ct->var_ns2 = (1.0 - alpha) * (ct->var_ns2 + diff * incr);
+}
+
+/*!
+ * The time the compositor needs for the next frame, from what it learned about
+ * the content it last rendered if it can, otherwise the adjusted estimate.
+ */
+static uint64_t
+get_comp_time(struct pacing_compositor *pc, bool *out_from_content)
+{
+	*out_from_content = false;
+
+	if (pc->last_content < 0) {
+		return pc->comp_time_ns;
+	}
+
+	// Content not seen enough yet, more squashed layers is an upper bound.
+	for (int32_t i = pc->last_content; i < NUM_CONTENTS; i++) {
+		const struct content_time *ct = &pc->contents[i];
+		if (ct->samples < CONTENT_MIN_SAMPLES) {
+			continue;
+		}
+
+		double comp_time_ns = ct->mean_ns + CONTENT_STDDEVS * sqrt(ct->var_ns2) + (double)pc->miss_penalty_ns;
+
+		*out_from_content = true;
+		return MIN((uint64_t)comp_time_ns, pc->comp_time_max_ns);
+	}
+
+	return pc->comp_time_ns;
+}
+
 static uint64_t
 calc_total_comp_time(struct pacing_compositor *pc)
 {
-	return pc->comp_time_ns + pc->margin_ns;
+	bool from_content;
+	return get_comp_time(pc, &from_content) + pc->margin_ns;
 }
 
 static uint64_t
@@ -227,6 +348,10 @@ create_frame(struct pacing_compositor *pc, enum frame_state state)
 
 	f->frame_id = frame_id;
 	f->state = state;
+	f->gpu_duration_ns = 0;
+	f->when_pose_sampled_ns = 0;
+	f->content = -1;
+	f->comp_time_from_content = false;
 
 	return f;
 }
@@ -348,8 +473,8 @@ predict_next_frame(struct pacing_compositor *pc, uint64_t now_ns)
 	}
 
 	f->predicted_display_time_ns = calc_display_time_from_present_time(pc, f->desired_present_time_ns);
-	f->wake_up_time_ns = f->desired_present_time_ns - calc_total_comp_time(pc);
-	f->current_comp_time_ns = pc->comp_time_ns;
+	f->current_comp_time_ns = get_comp_time(pc, &f->comp_time_from_content);
+	f->wake_up_time_ns = f->desired_present_time_ns - (f->current_comp_time_ns + pc->margin_ns);
 
 	return f;
 }
@@ -364,6 +489,14 @@ adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 		double missed_ms = ns_to_ms(f->actual_present_time_ns - f->desired_present_time_ns);
 		UPC_LOG_W("Frame %" PRIu64 " missed by %.2f!", f->frame_id, missed_ms);
 
+		// Get the events leading up to the miss out, if enabled.
+		u_trace_ring_dump("missed frame");
+
+		if (f->comp_time_from_content) {
+			pc->miss_penalty_ns = MIN(pc->miss_penalty_ns + pc->adjust_missed_ns, pc->comp_time_max_ns);
+			comp_time_ns = f->current_comp_time_ns;
+		}
+
 		comp_time_ns += pc->adjust_missed_ns;
 		if (comp_time_ns > pc->comp_time_max_ns) {
 			comp_time_ns = pc->comp_time_max_ns;
@@ -373,6 +506,13 @@ adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 		return;
 	}
 
+	if (f->comp_time_from_content) {
+		// The learned time is in charge, keep the fallback close to it.
+		pc->comp_time_ns = f->current_comp_time_ns;
+		pc->miss_penalty_ns -= MIN(pc->miss_penalty_ns, pc->adjust_non_miss_ns);
+		return;
+	}
+
 	// We want the GPU work to stop at margin_ns.
 	if (is_within_of_each_other(  //
 	        f->present_margin_ns, //
@@ -385,8 +525,13 @@ adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 
 	// We didn't miss the frame but we were outside the range: adjust the compositor time.
 	if (f->present_margin_ns > pc->margin_ns) {
-		// Approach the present time.
-		pc->comp_time_ns -= pc->adjust_non_miss_ns;
+		// Approach the present time, but never below what the GPU actually took.
+		uint64_t min_comp_time_ns = f->gpu_duration_ns + pc->margin_ns;
+		if (pc->comp_time_ns >= min_comp_time_ns + pc->adjust_non_miss_ns) {
+			pc->comp_time_ns -= pc->adjust_non_miss_ns;
+		} else if (pc->comp_time_ns > min_comp_time_ns) {
+			pc->comp_time_ns = min_comp_time_ns;
+		}
 	} else {
 		// Back off the present time.
 		pc->comp_time_ns += pc->adjust_non_miss_ns;
@@ -426,6 +571,19 @@ do_metrics(struct pacing_compositor *pc, struct frame *f)
 	};
 
 	u_metrics_write_system_present_info(&umpi);
+
+	if (f->when_pose_sampled_ns == 0) {
+		return;
+	}
+
+	struct u_metrics_system_latency umsl = {
+	    .frame_id = f->frame_id,
+	    .pose_sample_ns = f->when_pose_sampled_ns,
+	    .present_time_ns = f->actual_present_time_ns,
+	    .present_time_is_actual = true,
+	};
+
+	u_metrics_write_system_latency(&umsl);
 }
 
 static void
@@ -616,6 +774,7 @@ pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_
 		f->state = STATE_SUBMITTED;
 		f->when_submitted_ns = when_ns;
 		break;
+	case U_TIMING_POINT_POSE_SAMPLE: f->when_pose_sampled_ns = when_ns; break;
 	default: assert(false);
 	}
 }
@@ -695,14 +854,33 @@ pc_info(struct u_pacing_compositor *upc,
 }
 
 static void
-pc_info_gpu(
-    struct u_pacing_compositor *upc, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+pc_info_gpu(struct u_pacing_compositor *upc,
+            int64_t frame_id,
+            uint64_t gpu_start_ns,
+            uint64_t gpu_end_ns,
+            uint64_t layer_squash_ns,
+            uint64_t distortion_ns,
+            uint64_t when_ns)
 {
+	struct pacing_compositor *pc = pacing_compositor(upc);
+
+	struct frame *f = get_frame(pc, frame_id);
+	if (f->frame_id == frame_id && gpu_end_ns > gpu_start_ns) {
+		f->gpu_duration_ns = gpu_end_ns - gpu_start_ns;
+
+		// Includes oversleeping and CPU time, all of it has to fit before present.
+		if (f->content >= 0 && gpu_end_ns > f->wake_up_time_ns) {
+			update_content_time(&pc->contents[f->content], gpu_end_ns - f->wake_up_time_ns);
+		}
+	}
+
 	if (u_metrics_is_active()) {
 		struct u_metrics_system_gpu_info umgi = {
 		    .frame_id = frame_id,
 		    .gpu_start_ns = gpu_start_ns,
 		    .gpu_end_ns = gpu_end_ns,
+		    .layer_squash_ns = layer_squash_ns,
+		    .distortion_ns = distortion_ns,
 		    .when_ns = when_ns,
 		};
 
@@ -710,6 +888,20 @@ pc_info_gpu(
 	}
 }
 
+static void
+pc_info_layers(struct u_pacing_compositor *upc, int64_t frame_id, uint32_t layer_count, bool fast_path)
+{
+	struct pacing_compositor *pc = pacing_compositor(upc);
+
+	struct frame *f = get_frame(pc, frame_id);
+	if (f->frame_id != frame_id) {
+		return;
+	}
+
+	f->content = get_content_index(layer_count, fast_path);
+	pc->last_content = f->content;
+}
+
 static void
 pc_update_vblank_from_display_control(struct u_pacing_compositor *upc, uint64_t last_vblank_ns)
 {
@@ -730,6 +922,14 @@ pc_update_present_offset(struct u_pacing_compositor *upc, int64_t frame_id, uint
 	pc->present_to_display_offset_ns = present_to_display_offset_ns;
 }
 
+static void
+pc_update_frame_period(struct u_pacing_compositor *upc, uint64_t frame_period_ns)
+{
+	struct pacing_compositor *pc = pacing_compositor(upc);
+
+	pc->frame_period_ns = frame_period_ns;
+}
+
 static void
 pc_destroy(struct u_pacing_compositor *upc)
 {
@@ -760,8 +960,10 @@ u_pc_display_timing_create(uint64_t estimated_frame_period_ns,
 	pc->base.mark_point = pc_mark_point;
 	pc->base.info = pc_info;
 	pc->base.info_gpu = pc_info_gpu;
+	pc->base.info_layers = pc_info_layers;
 	pc->base.update_vblank_from_display_control = pc_update_vblank_from_display_control;
 	pc->base.update_present_offset = pc_update_present_offset;
+	pc->base.update_frame_period = pc_update_frame_period;
 	pc->base.destroy = pc_destroy;
 	pc->frame_period_ns = estimated_frame_period_ns;
 
@@ -779,6 +981,8 @@ u_pc_display_timing_create(uint64_t estimated_frame_period_ns,
 	pc->adjust_non_miss_ns = get_percent_of_time(estimated_frame_period_ns, config->adjust_non_miss_fraction);
 	// Extra margin that is added to compositor time.
 	pc->margin_ns = config->margin_ns;
+	// Nothing learned until the compositor tells us what it renders.
+	pc->last_content = -1;
 
 	*out_upc = &pc->base;
 
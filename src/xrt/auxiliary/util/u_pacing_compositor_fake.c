@@ -84,6 +84,12 @@ struct frame
 	 * `pc_mark_point` with `U_TIMING_POINT_SUBMIT_END`.
 	 */
 	uint64_t when_submit_end_ns;
+
+	/*!
+	 * When the oldest pose in the frame was sampled, zero if not known.
+	 * Set in `pc_mark_point` with `U_TIMING_POINT_POSE_SAMPLE`.
+	 */
+	uint64_t when_pose_sampled_ns;
 };
 
 /*!
@@ -342,6 +348,7 @@ pc_mark_point(struct u_pacing_compositor *upc, enum u_timing_point point, int64_
 		f->when_submit_end_ns = when_ns;
 		calc_frame_stats(ft, f);
 		break;
+	case U_TIMING_POINT_POSE_SAMPLE: f->when_pose_sampled_ns = when_ns; break;
 	default: assert(false);
 	}
 }
@@ -362,8 +369,13 @@ pc_info(struct u_pacing_compositor *upc,
 }
 
 static void
-pc_info_gpu(
-    struct u_pacing_compositor *upc, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+pc_info_gpu(struct u_pacing_compositor *upc,
+            int64_t frame_id,
+            uint64_t gpu_start_ns,
+            uint64_t gpu_end_ns,
+            uint64_t layer_squash_ns,
+            uint64_t distortion_ns,
+            uint64_t when_ns)
 {
 	struct fake_timing *ft = fake_timing(upc);
 
@@ -377,12 +389,26 @@ pc_info_gpu(
 		    .frame_id = frame_id,
 		    .gpu_start_ns = gpu_start_ns,
 		    .gpu_end_ns = gpu_end_ns,
+		    .layer_squash_ns = layer_squash_ns,
+		    .distortion_ns = distortion_ns,
 		    .when_ns = when_ns,
 		};
 
 		u_metrics_write_system_gpu_info(&umgi);
 	}
 
+	// No present feedback, so the frame is taken to be presented when it was predicted to be.
+	if (u_metrics_is_active() && f != NULL && f->when_pose_sampled_ns != 0) {
+		struct u_metrics_system_latency umsl = {
+		    .frame_id = frame_id,
+		    .pose_sample_ns = f->when_pose_sampled_ns,
+		    .present_time_ns = f->predicted_present_time_ns,
+		    .present_time_is_actual = false,
+		};
+
+		u_metrics_write_system_latency(&umsl);
+	}
+
 #ifdef U_TRACE_PERCETTO // Uses Percetto specific things.
 	if (U_TRACE_CATEGORY_IS_ENABLED(timing)) {
 #define TE_BEG(TRACK, TIME, NAME) U_TRACE_EVENT_BEGIN_ON_TRACK_DATA(timing, TRACK, TIME, NAME, PERCETTO_I(frame_id))
@@ -402,6 +428,12 @@ pc_info_gpu(
 #endif
 }
 
+static void
+pc_info_layers(struct u_pacing_compositor *upc, int64_t frame_id, uint32_t layer_count, bool fast_path)
+{
+	// The fake pacer only looks at the GPU time, ignore.
+}
+
 static void
 pc_update_vblank_from_display_control(struct u_pacing_compositor *upc, uint64_t last_vblank_ns)
 {
@@ -424,6 +456,14 @@ pc_update_present_offset(struct u_pacing_compositor *upc, int64_t frame_id, uint
 	ft->present_to_display_offset_ms.val = offset_ms;
 }
 
+static void
+pc_update_frame_period(struct u_pacing_compositor *upc, uint64_t frame_period_ns)
+{
+	struct fake_timing *ft = fake_timing(upc);
+
+	ft->frame_period_ns = frame_period_ns;
+}
+
 static void
 pc_destroy(struct u_pacing_compositor *upc)
 {
@@ -449,8 +489,10 @@ u_pc_fake_create(uint64_t estimated_frame_period_ns, uint64_t now_ns, struct u_p
 	ft->base.mark_point = pc_mark_point;
 	ft->base.info = pc_info;
 	ft->base.info_gpu = pc_info_gpu;
+	ft->base.info_layers = pc_info_layers;
 	ft->base.update_vblank_from_display_control = pc_update_vblank_from_display_control;
 	ft->base.update_present_offset = pc_update_present_offset;
+	ft->base.update_frame_period = pc_update_frame_period;
 	ft->base.destroy = pc_destroy;
 	ft->frame_period_ns = estimated_frame_period_ns;
 
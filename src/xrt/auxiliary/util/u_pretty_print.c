@@ -393,6 +393,7 @@ u_pp_xrt_result(struct u_pp_delegate dg, xrt_result_t xret)
 	case XRT_ERROR_COMPOSITOR_NOT_SUPPORTED:             DG("XRT_ERROR_COMPOSITOR_NOT_SUPPORTED"); return;
 	case XRT_ERROR_IPC_COMPOSITOR_NOT_CREATED:           DG("XRT_ERROR_IPC_COMPOSITOR_NOT_CREATED"); return;
 	case XRT_ERROR_DEVICE_FUNCTION_NOT_IMPLEMENTED:      DG("XRT_ERROR_DEVICE_FUNCTION_NOT_IMPLEMENTED"); return;
+	case XRT_ERROR_FEATURE_NOT_SUPPORTED:                DG("XRT_ERROR_FEATURE_NOT_SUPPORTED"); return;
 	}
 	// clang-format on
 
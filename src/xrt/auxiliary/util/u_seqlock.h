@@ -0,0 +1,113 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Single writer, multiple reader sequence lock.
+ *
+ * A sequence lock lets one writer publish data to any number of readers
+ * without the readers ever blocking the writer, readers simply retry if the
+ * writer was active while they were reading. Since it only consists of a
+ * counter it can be placed in memory shared between processes.
+ *
+ * ```c
+ * // Writer.
+ * u_seqlock_write_begin(&sl);
+ * data = new_data;
+ * u_seqlock_write_end(&sl);
+ *
+ * // Reader.
+ * uint32_t seq;
+ * do {
+ * 	seq = u_seqlock_read_begin(&sl);
+ * 	copy = data;
+ * } while (u_seqlock_read_retry(&sl, seq));
+ * ```
+ *
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_atomic.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * A sequence lock, zero initialized is a valid unlocked state.
+ *
+ * The counter is odd while the writer is updating the protected data.
+ *
+ * @ingroup aux_util
+ */
+struct u_seqlock
+{
+	volatile uint32_t seq;
+};
+
+/*!
+ * Start writing the protected data, only one writer may be active at a time.
+ *
+ * @public @memberof u_seqlock
+ */
+static inline void
+u_seqlock_write_begin(struct u_seqlock *sl)
+{
+	uint32_t seq = u_atomic_u32_load_relaxed(&sl->seq);
+	u_atomic_u32_store_relaxed(&sl->seq, seq + 1);
+	u_atomic_fence_release();
+}
+
+/*!
+ * Finish writing the protected data, makes it visible to readers.
+ *
+ * @public @memberof u_seqlock
+ */
+static inline void
+u_seqlock_write_end(struct u_seqlock *sl)
+{
+	uint32_t seq = u_atomic_u32_load_relaxed(&sl->seq);
+	u_atomic_u32_store_release(&sl->seq, seq + 1);
+}
+
+/*!
+ * Start reading the protected data, returns the sequence number that must be
+ * passed to @ref u_seqlock_read_retry once the data has been copied out.
+ *
+ * Spins while a writer is active.
+ *
+ * @public @memberof u_seqlock
+ */
+static inline uint32_t
+u_seqlock_read_begin(const struct u_seqlock *sl)
+{
+	uint32_t seq;
+	while (((seq = u_atomic_u32_load_acquire(&sl->seq)) & 1) != 0) {
+		// Writer active, spin.
+	}
+	return seq;
+}
+
+/*!
+ * Returns true if the data read since @ref u_seqlock_read_begin may be torn
+ * and the read needs to be redone.
+ *
+ * @public @memberof u_seqlock
+ */
+static inline bool
+u_seqlock_read_retry(const struct u_seqlock *sl, uint32_t seq)
+{
+	u_atomic_fence_acquire();
+	return u_atomic_u32_load_relaxed(&sl->seq) != seq;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,10 +7,22 @@
  * @ingroup aux_util
  */
 
+#include "util/u_misc.h"
 #include "util/u_system.h"
+#include "util/u_logging.h"
 #include "util/u_session.h"
 
 
+/*
+ *
+ * Defines.
+ *
+ */
+
+//! Number of events the ring starts out with, enough for most sessions.
+#define INITIAL_CAPACITY (8)
+
+
 /*
  *
  * Helpers.
@@ -23,6 +35,33 @@ u_session(struct xrt_session *xs)
 	return (struct u_session *)xs;
 }
 
+//! Makes room for at least one more event, must be called with the mutex held.
+static bool
+grow_ring_locked(struct u_session *us)
+{
+	if (us->events.count < us->events.capacity) {
+		return true;
+	}
+
+	uint32_t capacity = us->events.capacity == 0 ? INITIAL_CAPACITY : us->events.capacity * 2;
+	union xrt_session_event *ring = U_TYPED_ARRAY_CALLOC(union xrt_session_event, capacity);
+	if (ring == NULL) {
+		return false;
+	}
+
+	// Unwrap the old events to the start of the new ring.
+	for (uint32_t i = 0; i < us->events.count; i++) {
+		ring[i] = us->events.ring[(us->events.first + i) & (us->events.capacity - 1)];
+	}
+
+	free(us->events.ring);
+	us->events.ring = ring;
+	us->events.capacity = capacity;
+	us->events.first = 0;
+
+	return true;
+}
+
 
 /*
  *
@@ -59,6 +98,8 @@ destroy(struct xrt_session *xs)
 		u_system_remove_session(us->usys, &us->base, &us->sink);
 	}
 
+	os_mutex_destroy(&us->events.mutex);
+	free(us->events.ring);
 	free(xs);
 }
 
@@ -97,18 +138,17 @@ u_session_create(struct u_system *usys)
 void
 u_session_event_push(struct u_session *us, const union xrt_session_event *xse)
 {
-	struct u_session_event *use = U_TYPED_CALLOC(struct u_session_event);
-	use->xse = *xse;
-
 	os_mutex_lock(&us->events.mutex);
 
-	// Find the last slot.
-	struct u_session_event **slot = &us->events.ptr;
-	while (*slot != NULL) {
-		slot = &(*slot)->next;
+	if (!grow_ring_locked(us)) {
+		U_LOG_E("Out of memory, dropping session event!");
+		os_mutex_unlock(&us->events.mutex);
+		return;
 	}
 
-	*slot = use;
+	uint32_t index = (us->events.first + us->events.count) & (us->events.capacity - 1);
+	us->events.ring[index] = *xse;
+	us->events.count++;
 
 	os_mutex_unlock(&us->events.mutex);
 }
@@ -121,12 +161,10 @@ u_session_event_pop(struct u_session *us, union xrt_session_event *out_xse)
 
 	os_mutex_lock(&us->events.mutex);
 
-	if (us->events.ptr != NULL) {
-		struct u_session_event *use = us->events.ptr;
-
-		*out_xse = use->xse;
-		us->events.ptr = use->next;
-		free(use);
+	if (us->events.count > 0) {
+		*out_xse = us->events.ring[us->events.first];
+		us->events.first = (us->events.first + 1) & (us->events.capacity - 1);
+		us->events.count--;
 	}
 
 	os_mutex_unlock(&us->events.mutex);
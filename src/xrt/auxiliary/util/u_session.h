@@ -16,17 +16,6 @@ extern "C" {
 #endif
 
 
-/*!
- * Struct used by @ref u_session to queue up events.
- *
- * @ingroup aux_util
- */
-struct u_session_event
-{
-	union xrt_session_event xse;
-	struct u_session_event *next;
-};
-
 /*!
  * This is a helper struct that fully implements @ref xrt_session object.
  *
@@ -46,10 +35,25 @@ struct u_session
 	//! Owning system, optional.
 	struct u_system *usys;
 
+	/*!
+	 * Pending events, a ring that only grows when full so pushing doesn't
+	 * allocate once it has reached the size the session needs.
+	 */
 	struct
 	{
 		struct os_mutex mutex;
-		struct u_session_event *ptr;
+
+		//! Storage, @ref capacity long, allocated on the first push.
+		union xrt_session_event *ring;
+
+		//! Size of @ref ring, always a power of two.
+		uint32_t capacity;
+
+		//! Index of the oldest event.
+		uint32_t first;
+
+		//! Number of pending events.
+		uint32_t count;
 	} events;
 };
 
@@ -102,6 +102,20 @@ u_sink_deinterleaver_create(struct xrt_frame_context *xfctx,
                             struct xrt_frame_sink **out_xfs);
 
 /*!
+ * Which frame a full @ref u_sink_queue drops.
+ */
+enum u_sink_queue_drop
+{
+	//! Drop the frame being pushed, keeps the queued frames.
+	U_SINK_QUEUE_DROP_NEWEST,
+	//! Drop the oldest queued frame, the consumer always gets the latest frames.
+	U_SINK_QUEUE_DROP_OLDEST,
+};
+
+/*!
+ * Creates a queue that drops new frames when @p max_size frames are queued,
+ * 0 means unbounded.
+ *
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
  */
@@ -111,6 +125,20 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *downstream,
                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Creates a queue with a choice of which frame to drop when @p max_size frames
+ * are queued, 0 means unbounded and never drops.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+bool
+u_sink_queue_create_with_drop(struct xrt_frame_context *xfctx,
+                              uint64_t max_size,
+                              enum u_sink_queue_drop drop,
+                              struct xrt_frame_sink *downstream,
+                              struct xrt_frame_sink **out_xfs);
+
 
 /*!
  * @public @memberof xrt_frame_sink
@@ -171,6 +199,29 @@ u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
                             struct xrt_frame_sink **out_left_xfs,
                             struct xrt_frame_sink **out_right_xfs);
 
+//! Most cameras a @ref u_sink_sync_create node takes.
+#define U_SINK_SYNC_MAX_CAMS (8)
+
+/*!
+ * Matches frames from @p cam_count cameras by timestamp, frames pushed to
+ * `out_xfs[i]` from any thread are held until every camera has a frame within
+ * @p tolerance_ns of the others. The complete set is then pushed to
+ * `downstream[i]` in camera order, camera 0 first, which is what the SLAM
+ * sinks expect. Frames that can not be matched are dropped.
+ *
+ * @param xfctx Context to add the node to.
+ * @param cam_count Number of cameras, at most @ref U_SINK_SYNC_MAX_CAMS.
+ * @param tolerance_ns How far apart frames of the same set may be.
+ * @param downstream Array of @p cam_count sinks that the sets are pushed to.
+ * @param[out] out_xfs Array of @p cam_count sinks to push the frames of each camera to.
+ */
+bool
+u_sink_sync_create(struct xrt_frame_context *xfctx,
+                   uint32_t cam_count,
+                   uint64_t tolerance_ns,
+                   struct xrt_frame_sink **downstream,
+                   struct xrt_frame_sink **out_xfs);
+
 
 /*
  *
@@ -42,6 +42,9 @@ struct u_sink_converter
 	struct xrt_frame_sink *downstream;
 
 	enum xrt_format format;
+
+	//! Converted frames come from here, created on the first frame.
+	struct u_frame_pool *pool;
 };
 
 
@@ -57,13 +60,11 @@ from_L8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t st
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 1) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + x;
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			dst[2] = dst[1] = dst[0] = src[0];
+		for (uint32_t x = 0; x < w; x++) {
+			dst[x * 3 + 2] = dst[x * 3 + 1] = dst[x * 3 + 0] = src[x];
 		}
 	}
 }
@@ -143,6 +144,22 @@ YUYV422_to_R8G8B8X8(const uint8_t *input, uint32_t *rgb1, uint32_t *rgb2)
 #endif
 }
 
+/*!
+ * Straight to bytes, no packing into and out of a uint32_t, the clamps turn
+ * into min/max so the row loops calling this can be auto-vectorised.
+ */
+inline static void
+YUV444_to_R8G8B8_direct(int y, int u, int v, uint8_t *dst)
+{
+	int C = 298 * (y - 16) + 128;
+	int D = u - 128;
+	int E = v - 128;
+
+	dst[0] = (uint8_t)clamp_to_byte((C + 409 * E) >> 8);
+	dst[1] = (uint8_t)clamp_to_byte((C - 100 * D - 209 * E) >> 8);
+	dst[2] = (uint8_t)clamp_to_byte((C + 516 * D) >> 8);
+}
+
 inline static void
 YUYV422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 {
@@ -154,12 +171,6 @@ YUYV422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 #ifdef USE_TABLE
 	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
 	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
 
 	dst[0] = rgb1[0];
 	dst[1] = rgb1[1];
@@ -167,6 +178,10 @@ YUYV422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 	dst[3] = rgb2[0];
 	dst[4] = rgb2[1];
 	dst[5] = rgb2[2];
+#else
+	YUV444_to_R8G8B8_direct(y0, u, v, dst + 0);
+	YUV444_to_R8G8B8_direct(y1, u, v, dst + 3);
+#endif
 }
 
 inline static void
@@ -180,12 +195,6 @@ UYVY422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 #ifdef USE_TABLE
 	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
 	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
 
 	dst[0] = rgb1[0];
 	dst[1] = rgb1[1];
@@ -193,6 +202,10 @@ UYVY422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 	dst[3] = rgb2[0];
 	dst[4] = rgb2[1];
 	dst[5] = rgb2[2];
+#else
+	YUV444_to_R8G8B8_direct(y0, u, v, dst + 0);
+	YUV444_to_R8G8B8_direct(y1, u, v, dst + 3);
+#endif
 }
 
 inline static void
@@ -204,14 +217,13 @@ YUV444_to_R8G8B8(const uint8_t *input, uint8_t *dst)
 
 #ifdef USE_TABLE
 	uint8_t *rgb = (uint8_t *)&lookup_YUV_to_RGBX[y][u][v];
-#else
-	uint32_t rgbv = YUV444_to_RGBX8888(y, u, v);
-	uint8_t *rgb = (uint8_t *)&rgbv;
-#endif
 
 	dst[0] = rgb[0];
 	dst[1] = rgb[1];
 	dst[2] = rgb[2];
+#else
+	YUV444_to_R8G8B8_direct(y, u, v, dst);
+#endif
 }
 
 static void
@@ -220,13 +232,11 @@ from_YUYV422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUYV422_to_R8G8B8(src, dst);
+		for (uint32_t x = 0; x < w; x += 2) {
+			YUYV422_to_R8G8B8(src + (x * 2), dst + (x * 3));
 		}
 	}
 }
@@ -252,13 +262,11 @@ from_UYVY422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			UYVY422_to_R8G8B8(src, dst);
+		for (uint32_t x = 0; x < w; x += 2) {
+			UYVY422_to_R8G8B8(src + (x * 2), dst + (x * 3));
 		}
 	}
 }
@@ -270,13 +278,11 @@ from_YUV888_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_
 	SINK_TRACE_MARKER();
 
 	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x++) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+		const uint8_t *src = data + (y * stride);
+		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
 
-			src = src + (y * stride) + (x * 3);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUV444_to_R8G8B8(src, dst);
+		for (uint32_t x = 0; x < w; x++) {
+			YUV444_to_R8G8B8(src + (x * 3), dst + (x * 3));
 		}
 	}
 }
@@ -305,8 +311,13 @@ check_header(size_t size, const uint8_t *data)
 	return true;
 }
 
+/*!
+ * Decodes a MJPEG frame straight into @p dst_frame in the given color space.
+ * Decoding to grayscale lets libjpeg skip the chroma planes entirely, it only
+ * runs the IDCT on the luma channel and does no color conversion.
+ */
 static bool
-from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
+decode_MJPEG(struct xrt_frame *dst_frame, size_t size, const uint8_t *data, J_COLOR_SPACE color_space)
 {
 	SINK_TRACE_MARKER();
 
@@ -329,15 +340,31 @@ from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 		return false;
 	}
 
-	cinfo.out_color_space = JCS_RGB;
+	cinfo.out_color_space = color_space;
 	jpeg_start_decompress(&cinfo);
 
-	uint8_t *moving_ptr = dst_frame->data;
+	if (cinfo.output_width != dst_frame->width || cinfo.output_height != dst_frame->height) {
+		U_LOG_E("JPEG is %ux%u but frame is %ux%u!", cinfo.output_width, cinfo.output_height,
+		        dst_frame->width, dst_frame->height);
+		jpeg_abort_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
 
+	// Hand over as many rows as the decoder can produce per call, it writes one per pointer.
+	JSAMPROW rows[16];
 	uint32_t scanlines_read = 0;
-	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
-		moving_ptr += read_count * dst_frame->stride;
+	while (scanlines_read < cinfo.output_height) {
+		uint32_t count = cinfo.output_height - scanlines_read;
+		count = count < ARRAY_SIZE(rows) ? count : ARRAY_SIZE(rows);
+		for (uint32_t i = 0; i < count; i++) {
+			rows[i] = dst_frame->data + (scanlines_read + i) * dst_frame->stride;
+		}
+
+		uint32_t read_count = jpeg_read_scanlines(&cinfo, rows, count);
+		if (read_count == 0) {
+			break;
+		}
 		scanlines_read += read_count;
 	}
 
@@ -348,45 +375,21 @@ from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 }
 
 static bool
-from_MJPEG_to_YUV888(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
+from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
 {
-	SINK_TRACE_MARKER();
-
-	if (!check_header(size, data)) {
-		return false;
-	}
-
-	struct jpeg_decompress_struct cinfo = {0};
-	struct jpeg_error_mgr jerr = {0};
-
-	cinfo.err = jpeg_std_error(&jerr);
-	jerr.trace_level = 0;
-
-	jpeg_create_decompress(&cinfo);
-	jpeg_mem_src(&cinfo, data, size);
-
-	int ret = jpeg_read_header(&cinfo, TRUE);
-	if (ret != JPEG_HEADER_OK) {
-		jpeg_destroy_decompress(&cinfo);
-		return false;
-	}
-
-	cinfo.out_color_space = JCS_YCbCr;
-	jpeg_start_decompress(&cinfo);
-
-	uint8_t *moving_ptr = dst_frame->data;
-
-	uint32_t scanlines_read = 0;
-	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
-		moving_ptr += read_count * dst_frame->stride;
-		scanlines_read += read_count;
-	}
+	return decode_MJPEG(dst_frame, size, data, JCS_RGB);
+}
 
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
+static bool
+from_MJPEG_to_YUV888(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
+{
+	return decode_MJPEG(dst_frame, size, data, JCS_YCbCr);
+}
 
-	return true;
+static bool
+from_MJPEG_to_L8(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
+{
+	return decode_MJPEG(dst_frame, size, data, JCS_GRAYSCALE);
 }
 #endif
 
@@ -420,7 +423,7 @@ from_BAYER_GR8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, si
 			uint8_t g1 = src1[1];
 
 			dst[0] = r;
-			dst[1] = (g0 + g1) / 2;
+			dst[1] = (uint8_t)((g0 + g1) >> 1);
 			dst[2] = b;
 
 			src0 += 2;
@@ -440,15 +443,23 @@ from_BAYER_GR8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, si
 
 /*!
  * Creates a frame that the conversion should happen to, allows to set the size.
- *
- * @todo Allocate from a pool of frames.
  */
 static bool
-create_frame_with_format_of_size(
-    struct xrt_frame *xf, uint32_t w, uint32_t h, enum xrt_format format, struct xrt_frame **out_frame)
-{
+create_frame_with_format_of_size(struct u_sink_converter *s,
+                                 struct xrt_frame *xf,
+                                 uint32_t w,
+                                 uint32_t h,
+                                 enum xrt_format format,
+                                 struct xrt_frame **out_frame)
+{
+	if (s->pool == NULL) {
+		s->pool = u_frame_pool_create(true, 0);
+	}
+
 	struct xrt_frame *frame = NULL;
-	u_frame_create_one_off(format, w, h, &frame);
+	if (s->pool != NULL) {
+		u_frame_pool_get(s->pool, format, w, h, &frame);
+	}
 	if (frame == NULL) {
 		U_LOG_E("Failed to create target frame!");
 		*out_frame = NULL;
@@ -470,9 +481,12 @@ create_frame_with_format_of_size(
  * Creates a frame that the conversion should happen to.
  */
 static bool
-create_frame_with_format(struct xrt_frame *xf, enum xrt_format format, struct xrt_frame **out_frame)
+create_frame_with_format(struct u_sink_converter *s,
+                         struct xrt_frame *xf,
+                         enum xrt_format format,
+                         struct xrt_frame **out_frame)
 {
-	return create_frame_with_format_of_size(xf, xf->width, xf->height, format, out_frame);
+	return create_frame_with_format_of_size(s, xf, xf->width, xf->height, format, out_frame);
 }
 
 static void
@@ -487,11 +501,23 @@ convert_frame_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	switch (xf->format) {
 	case XRT_FORMAT_L8: s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_L8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_L8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_L8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
+#ifdef XRT_HAVE_JPEG
+	case XRT_FORMAT_MJPEG:
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_L8, &converted)) {
+			return;
+		}
+		if (!from_MJPEG_to_L8(converted, xf->size, xf->data)) {
+			// Make sure to free frame when we fail to decode.
+			xrt_frame_reference(&converted, NULL);
+			return;
+		}
+		break;
+#endif
 	default: U_LOG_E("Cannot convert from '%s' to L8!", u_format_str(xf->format)); return;
 	}
 
@@ -516,32 +542,32 @@ convert_frame_r8g8b8_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -590,26 +616,26 @@ convert_frame_r8g8b8_bayer_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf
 	case XRT_FORMAT_R8G8B8:
 	case XRT_FORMAT_BAYER_GR8:; s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -640,7 +666,7 @@ convert_frame_r8g8b8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	switch (xf->format) {
 	case XRT_FORMAT_R8G8B8: s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_L8:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_L8_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
@@ -648,32 +674,32 @@ convert_frame_r8g8b8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
@@ -709,10 +735,12 @@ convert_frame_rgb_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_fram
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+			// Make sure to free frame when we fail to decode.
+			xrt_frame_reference(&converted, NULL);
 			return;
 		}
 		break;
@@ -744,10 +772,12 @@ convert_frame_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *x
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+			// Make sure to free frame when we fail to decode.
+			xrt_frame_reference(&converted, NULL);
 			return;
 		}
 		break;
@@ -780,10 +810,12 @@ convert_frame_yuv_or_yuyv(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+			// Make sure to free frame when we fail to decode.
+			xrt_frame_reference(&converted, NULL);
 			return;
 		}
 		break;
@@ -808,7 +840,7 @@ convert_frame_bayer(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	uint32_t h = xf->height / 2;
 	struct xrt_frame *converted = NULL;
 
-	if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+	if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 		return;
 	}
 
@@ -829,6 +861,9 @@ destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_converter *s = container_of(node, struct u_sink_converter, node);
 
+	// Frames still held downstream keep the pool alive.
+	u_frame_pool_reference(&s->pool, NULL);
+
 	free(s);
 }
 
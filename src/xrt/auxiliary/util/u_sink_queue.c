@@ -14,17 +14,14 @@
 #include <stdio.h>
 #include <pthread.h>
 
-struct u_sink_queue_elem
-{
-	struct xrt_frame *frame;
-	struct u_sink_queue_elem *next;
-};
-
 /*!
  * An @ref xrt_frame_sink queue, any frames received will be pushed to the
  * downstream consumer on the queue thread. Will drop frames should multiple
  * frames be queued up.
  *
+ * The frames are kept in a ring that is allocated up front, so nothing is
+ * allocated per frame. Unbounded queues grow the ring when it fills up.
+ *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
  */
@@ -38,28 +35,40 @@ struct u_sink_queue
 	//! The consumer of the frames that are queued.
 	struct xrt_frame_sink *consumer;
 
-	//! Front of the queue (oldest frame, first to be consumed)
-	struct u_sink_queue_elem *front;
+	//! Ring of queued frames, each holding a reference.
+	struct xrt_frame **ring;
 
-	//! Back of the queue (newest frame, back->next is always null)
-	struct u_sink_queue_elem *back;
+	//! Number of slots in @ref ring.
+	uint64_t capacity;
+
+	//! Index of the front of the queue (oldest frame, first to be consumed)
+	uint64_t front;
 
 	//! Number of currently enqueued frames
 	uint64_t size;
 
-	//! Max amount of frames before dropping new ones. 0 means unbounded.
+	//! Max amount of frames before dropping. 0 means unbounded.
 	uint64_t max_size;
 
+	//! Which frame to drop when full.
+	enum u_sink_queue_drop drop;
+
 	pthread_t thread;
 	pthread_mutex_t mutex;
 
 	//! So we can wake the mainloop up
 	pthread_cond_t cond;
 
+	//! Is the mainloop waiting on @ref cond, no need to signal otherwise.
+	bool waiting;
+
 	//! Should we keep running.
 	bool running;
 };
 
+//! Starting capacity of unbounded queues.
+#define UNBOUNDED_INITIAL_CAPACITY (16)
+
 //! Call with q->mutex locked.
 static bool
 queue_is_empty(struct u_sink_queue *q)
@@ -81,35 +90,52 @@ static struct xrt_frame *
 queue_pop(struct u_sink_queue *q)
 {
 	assert(!queue_is_empty(q));
-	struct xrt_frame *frame = q->front->frame;
-	struct u_sink_queue_elem *old_front = q->front;
-	q->front = q->front->next;
-	free(old_front);
+	struct xrt_frame *frame = q->ring[q->front];
+	q->ring[q->front] = NULL;
+	q->front = (q->front + 1) % q->capacity;
 	q->size--;
-	if (q->front == NULL) {
-		assert(queue_is_empty(q));
-		q->back = NULL;
-	}
 	return frame;
 }
 
+//! Makes room for one more frame in an unbounded queue, moving the frames
+//! so that they don't wrap around in the bigger ring.
+//! Call with q->mutex locked.
+static void
+queue_grow(struct u_sink_queue *q)
+{
+	uint64_t new_capacity = q->capacity * 2;
+	struct xrt_frame **ring = U_TYPED_ARRAY_CALLOC(struct xrt_frame *, new_capacity);
+	for (uint64_t i = 0; i < q->size; i++) {
+		ring[i] = q->ring[(q->front + i) % q->capacity];
+	}
+
+	free(q->ring);
+	q->ring = ring;
+	q->capacity = new_capacity;
+	q->front = 0;
+}
+
 //! Tries to push a frame and increases its reference count.
 //! Call with q->mutex locked.
 static bool
 queue_try_refpush(struct u_sink_queue *q, struct xrt_frame *xf)
 {
 	if (queue_is_full(q)) {
-		return false;
+		if (q->drop == U_SINK_QUEUE_DROP_NEWEST) {
+			return false;
+		}
+
+		// Make room by dropping the oldest frame.
+		struct xrt_frame *old = queue_pop(q);
+		xrt_frame_reference(&old, NULL);
 	}
-	struct u_sink_queue_elem *elem = U_TYPED_CALLOC(struct u_sink_queue_elem);
-	xrt_frame_reference(&elem->frame, xf);
-	elem->next = NULL;
-	if (q->back == NULL) { // First frame
-		q->front = elem;
-	} else { // Next frame
-		q->back->next = elem;
+
+	if (q->size == q->capacity) {
+		queue_grow(q);
 	}
-	q->back = elem;
+
+	uint64_t back = (q->front + q->size) % q->capacity;
+	xrt_frame_reference(&q->ring[back], xf);
 	q->size++;
 	return true;
 }
@@ -120,7 +146,6 @@ static void
 queue_refclear(struct u_sink_queue *q)
 {
 	while (!queue_is_empty(q)) {
-		assert((q->size > 1) ^ (q->front == q->back));
 		struct xrt_frame *xf = queue_pop(q);
 		xrt_frame_reference(&xf, NULL);
 	}
@@ -140,7 +165,9 @@ queue_mainloop(void *ptr)
 
 		// No new frame, wait.
 		if (queue_is_empty(q)) {
+			q->waiting = true;
 			pthread_cond_wait(&q->cond, &q->mutex);
+			q->waiting = false;
 		}
 
 		// In this case, queue_break_apart woke us up to turn us off.
@@ -201,8 +228,10 @@ queue_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 		queue_try_refpush(q, xf);
 	}
 
-	// Wake up the thread.
-	pthread_cond_signal(&q->cond);
+	// Wake up the thread, if it is busy it will see the frame when done.
+	if (q->waiting) {
+		pthread_cond_signal(&q->cond);
+	}
 
 	pthread_mutex_unlock(&q->mutex);
 }
@@ -240,6 +269,7 @@ queue_destroy(struct xrt_frame_node *node)
 	// Destroy resources.
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
+	free(q->ring);
 	free(q);
 }
 
@@ -255,6 +285,16 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
                     uint64_t max_size,
                     struct xrt_frame_sink *downstream,
                     struct xrt_frame_sink **out_xfs)
+{
+	return u_sink_queue_create_with_drop(xfctx, max_size, U_SINK_QUEUE_DROP_NEWEST, downstream, out_xfs);
+}
+
+bool
+u_sink_queue_create_with_drop(struct xrt_frame_context *xfctx,
+                              uint64_t max_size,
+                              enum u_sink_queue_drop drop,
+                              struct xrt_frame_sink *downstream,
+                              struct xrt_frame_sink **out_xfs)
 {
 	struct u_sink_queue *q = U_TYPED_CALLOC(struct u_sink_queue);
 	int ret = 0;
@@ -267,9 +307,13 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 
 	q->size = 0;
 	q->max_size = max_size;
+	q->drop = drop;
+	q->capacity = max_size > 0 ? max_size : UNBOUNDED_INITIAL_CAPACITY;
+	q->ring = U_TYPED_ARRAY_CALLOC(struct xrt_frame *, q->capacity);
 
 	ret = pthread_mutex_init(&q->mutex, NULL);
 	if (ret != 0) {
+		free(q->ring);
 		free(q);
 		return false;
 	}
@@ -277,6 +321,7 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 	ret = pthread_cond_init(&q->cond, NULL);
 	if (ret) {
 		pthread_mutex_destroy(&q->mutex);
+		free(q->ring);
 		free(q);
 		return false;
 	}
@@ -285,6 +330,7 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 	if (ret != 0) {
 		pthread_cond_destroy(&q->cond);
 		pthread_mutex_destroy(&q->mutex);
+		free(q->ring);
 		free(q);
 		return false;
 	}
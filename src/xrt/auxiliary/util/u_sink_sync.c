@@ -0,0 +1,292 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  An @ref xrt_frame_sink that matches frames from many cameras by timestamp.
+ * @ingroup aux_util
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+
+#include <inttypes.h>
+
+
+/*!
+ * How many frames are kept per camera while waiting for the other cameras,
+ * must be a power of two.
+ */
+#define RING_SIZE (4)
+
+struct u_sink_sync;
+
+/*!
+ * One camera input of a @ref u_sink_sync.
+ *
+ * @implements xrt_frame_sink
+ */
+struct u_sink_sync_cam
+{
+	struct xrt_frame_sink base;
+
+	struct u_sink_sync *sync;
+
+	uint32_t index;
+
+	//! Frames oldest first, from @ref head to @ref tail, guarded by @ref u_sink_sync::mutex.
+	struct xrt_frame *ring[RING_SIZE];
+	uint32_t head;
+	uint32_t tail;
+};
+
+/*!
+ * An @ref xrt_frame_sink that takes frames from @ref cam_count cameras on any
+ * number of threads, pairs them up by timestamp and pushes each complete set
+ * downstream in camera order, camera 0 first. Frames that can not be matched
+ * within the tolerance, or that do not fit in the ring of their camera, are
+ * dropped.
+ *
+ * The matching is done under a short lock that only moves frame pointers,
+ * pushing downstream happens outside of it so the other cameras can keep
+ * queueing frames in the meantime.
+ *
+ * @implements xrt_frame_node
+ */
+struct u_sink_sync
+{
+	struct xrt_frame_node node;
+
+	struct u_sink_sync_cam cams[U_SINK_SYNC_MAX_CAMS];
+	struct xrt_frame_sink *downstream[U_SINK_SYNC_MAX_CAMS];
+	uint32_t cam_count;
+
+	//! Frames further apart than this are not the same exposure.
+	uint64_t tolerance_ns;
+
+	//! Guards the rings and @ref running.
+	struct os_mutex mutex;
+
+	//! Keeps sets in order, taken before @ref mutex is released.
+	struct os_mutex push_mutex;
+
+	bool running;
+
+	//! Frames that were dropped without being matched, guarded by @ref mutex.
+	uint64_t dropped;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint32_t
+ring_count(const struct u_sink_sync_cam *cam)
+{
+	return cam->tail - cam->head;
+}
+
+static inline struct xrt_frame *
+ring_oldest(const struct u_sink_sync_cam *cam)
+{
+	return cam->ring[cam->head & (RING_SIZE - 1)];
+}
+
+static inline void
+ring_pop(struct u_sink_sync_cam *cam, struct xrt_frame **out_xf)
+{
+	struct xrt_frame **slot = &cam->ring[cam->head & (RING_SIZE - 1)];
+	*out_xf = *slot;
+	*slot = NULL;
+	cam->head++;
+}
+
+static void
+ring_drop_oldest(struct u_sink_sync *s, struct u_sink_sync_cam *cam)
+{
+	struct xrt_frame *xf = NULL;
+	ring_pop(cam, &xf);
+	xrt_frame_reference(&xf, NULL);
+	s->dropped++;
+}
+
+static void
+ring_clear(struct u_sink_sync *s, struct u_sink_sync_cam *cam)
+{
+	while (ring_count(cam) > 0) {
+		ring_drop_oldest(s, cam);
+	}
+}
+
+/*!
+ * Looks for a set of frames within the tolerance of each other, dropping the
+ * frames that can never be part of one. The newest of the oldest frames is
+ * the earliest a complete set can be from, so everything too much older than
+ * that is dropped until either a set is found or a camera runs out.
+ */
+static bool
+find_set_locked(struct u_sink_sync *s, struct xrt_frame *out_frames[U_SINK_SYNC_MAX_CAMS])
+{
+	while (true) {
+		uint64_t newest = 0;
+		for (uint32_t i = 0; i < s->cam_count; i++) {
+			if (ring_count(&s->cams[i]) == 0) {
+				return false;
+			}
+			uint64_t ts = ring_oldest(&s->cams[i])->timestamp;
+			newest = ts > newest ? ts : newest;
+		}
+
+		bool all_close = true;
+		for (uint32_t i = 0; i < s->cam_count; i++) {
+			if (newest - ring_oldest(&s->cams[i])->timestamp > s->tolerance_ns) {
+				ring_drop_oldest(s, &s->cams[i]);
+				all_close = false;
+			}
+		}
+
+		if (all_close) {
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < s->cam_count; i++) {
+		ring_pop(&s->cams[i], &out_frames[i]);
+	}
+
+	return true;
+}
+
+static void
+sync_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_sync_cam *cam = container_of(xfs, struct u_sink_sync_cam, base);
+	struct u_sink_sync *s = cam->sync;
+
+	struct xrt_frame *frames[U_SINK_SYNC_MAX_CAMS] = {0};
+
+	os_mutex_lock(&s->mutex);
+
+	if (!s->running) {
+		os_mutex_unlock(&s->mutex);
+		return;
+	}
+
+	// Frames must come in order per camera, a full ring means the others are lagging.
+	if (ring_count(cam) == RING_SIZE) {
+		ring_drop_oldest(s, cam);
+		U_LOG_D("Camera %u is %u frames ahead, dropped %" PRIu64 " frames so far", cam->index, RING_SIZE,
+		        s->dropped);
+	}
+
+	xrt_frame_reference(&cam->ring[cam->tail & (RING_SIZE - 1)], xf);
+	cam->tail++;
+
+	bool found = find_set_locked(s, frames);
+	if (found) {
+		// Hand over to the push lock so sets found later go out after this one.
+		os_mutex_lock(&s->push_mutex);
+	}
+
+	os_mutex_unlock(&s->mutex);
+
+	if (!found) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < s->cam_count; i++) {
+		xrt_sink_push_frame(s->downstream[i], frames[i]);
+		xrt_frame_reference(&frames[i], NULL);
+	}
+
+	os_mutex_unlock(&s->push_mutex);
+}
+
+static void
+sync_break_apart(struct xrt_frame_node *node)
+{
+	struct u_sink_sync *s = container_of(node, struct u_sink_sync, node);
+
+	os_mutex_lock(&s->mutex);
+
+	// Inhibit any new frames and release the ones waiting for a match.
+	s->running = false;
+	for (uint32_t i = 0; i < s->cam_count; i++) {
+		ring_clear(s, &s->cams[i]);
+	}
+
+	os_mutex_unlock(&s->mutex);
+
+	// Wait for any set still being pushed.
+	os_mutex_lock(&s->push_mutex);
+	os_mutex_unlock(&s->push_mutex);
+}
+
+static void
+sync_destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_sync *s = container_of(node, struct u_sink_sync, node);
+
+	os_mutex_destroy(&s->push_mutex);
+	os_mutex_destroy(&s->mutex);
+	free(s);
+}
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+bool
+u_sink_sync_create(struct xrt_frame_context *xfctx,
+                   uint32_t cam_count,
+                   uint64_t tolerance_ns,
+                   struct xrt_frame_sink **downstream,
+                   struct xrt_frame_sink **out_xfs)
+{
+	if (cam_count == 0 || cam_count > U_SINK_SYNC_MAX_CAMS) {
+		U_LOG_E("Invalid camera count %u", cam_count);
+		return false;
+	}
+
+	struct u_sink_sync *s = U_TYPED_CALLOC(struct u_sink_sync);
+
+	if (os_mutex_init(&s->mutex) != 0) {
+		free(s);
+		return false;
+	}
+
+	if (os_mutex_init(&s->push_mutex) != 0) {
+		os_mutex_destroy(&s->mutex);
+		free(s);
+		return false;
+	}
+
+	s->node.break_apart = sync_break_apart;
+	s->node.destroy = sync_destroy;
+	s->cam_count = cam_count;
+	s->tolerance_ns = tolerance_ns;
+	s->running = true;
+
+	for (uint32_t i = 0; i < cam_count; i++) {
+		s->cams[i].base.push_frame = sync_push_frame;
+		s->cams[i].sync = s;
+		s->cams[i].index = i;
+		s->downstream[i] = downstream[i];
+		out_xfs[i] = &s->cams[i].base;
+	}
+
+	xrt_frame_context_add(xfctx, &s->node);
+
+	return true;
+}
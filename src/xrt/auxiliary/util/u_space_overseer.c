@@ -11,6 +11,7 @@
 #include "xrt/xrt_space.h"
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_session.h"
+#include "xrt/xrt_system.h"
 #include "xrt/xrt_tracking.h"
 
 #include "os/os_time.h"
@@ -20,6 +21,7 @@
 #include "util/u_misc.h"
 #include "util/u_hashmap.h"
 #include "util/u_logging.h"
+#include "util/u_seqlock.h"
 #include "util/u_space_overseer.h"
 
 #include <assert.h>
@@ -73,6 +75,24 @@ struct u_space
 			struct xrt_pose pose;
 		} offset;
 	};
+
+	/*!
+	 * For NULL and OFFSET spaces, all of the static offsets from this space
+	 * up to the first POSE or ROOT space collapsed into a single pose, so
+	 * traversing doesn't need to walk them one by one. Protected by the
+	 * overseer seqlock.
+	 */
+	struct
+	{
+		//! Valid if equal to @ref u_space_overseer::generation.
+		uint64_t generation;
+
+		//! The first POSE or ROOT space going up the graph, not referenced.
+		struct u_space *next;
+
+		//! Pose of this space in @ref next.
+		struct xrt_pose pose;
+	} cache;
 };
 
 /*!
@@ -82,11 +102,45 @@ struct u_space_overseer
 {
 	struct xrt_space_overseer base;
 
-	//! Main graph lock.
-	pthread_rwlock_t lock;
+	/*!
+	 * Serialises writers, they also hold @ref seqlock while changing
+	 * anything readers look at. Functions ending with _write_locked need
+	 * both, those ending with _read_locked run inside a read section of
+	 * @ref seqlock, which may be retried, or with this lock held.
+	 */
+	pthread_mutex_t lock;
 
-	//! Map from xdev to space, each entry holds a reference.
-	struct u_hashmap_int *xdev_map;
+	/*!
+	 * Guards the offsets, caches and the device to space mapping, readers
+	 * never write to it so they don't contend with each other.
+	 */
+	struct u_seqlock seqlock;
+
+	/*!
+	 * Bumped every time an offset changes, invalidating the cached static
+	 * offsets of all spaces, protected by the seqlock.
+	 */
+	uint64_t generation;
+
+	/*!
+	 * Mapping from xdev to space, each entry holds a reference. Entries
+	 * are only ever added or have their space replaced.
+	 */
+	struct
+	{
+		struct xrt_device *xdev;
+		struct u_space *space;
+	} xdev_spaces[XRT_SYSTEM_MAX_DEVICES];
+
+	//! Number of used entries in @ref xdev_spaces.
+	uint32_t xdev_space_count;
+
+	/*!
+	 * Spaces replaced in @ref xdev_spaces, a reader might still be
+	 * traversing them so they are only unreferenced on destroy.
+	 */
+	struct u_space **retired_spaces;
+	uint32_t retired_space_count;
 
 	//! Tracks usage of reference spaces.
 	struct xrt_reference ref_space_use[XRT_SPACE_REFERENCE_TYPE_COUNT];
@@ -194,28 +248,66 @@ hashmap_unreference_space_items(void *item, void *priv)
 	u_space_reference(&us, NULL);
 }
 
+/*!
+ * Returns NULL if the device has no space, callers need to check that after
+ * the read section is done as it might be torn.
+ */
 static struct u_space *
 find_xdev_space_read_locked(struct u_space_overseer *uso, struct xrt_device *xdev)
 {
-	void *ptr = NULL;
-	uint64_t key = (uint64_t)(intptr_t)xdev;
-	u_hashmap_int_find(uso->xdev_map, key, &ptr);
+	uint32_t count = uso->xdev_space_count;
+	if (count > ARRAY_SIZE(uso->xdev_spaces)) {
+		return NULL; // Torn.
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (uso->xdev_spaces[i].xdev == xdev) {
+			return uso->xdev_spaces[i].space;
+		}
+	}
 
-	if (ptr == NULL) {
+	return NULL;
+}
+
+static void
+check_xdev_space(struct u_space *us, struct xrt_device *xdev)
+{
+	if (us == NULL) {
 		U_LOG_E("Looking for space belonging to unknown xrt_device! '%s'", xdev->str);
 	}
-	assert(ptr != NULL);
+	assert(us != NULL);
+}
 
-	return (struct u_space *)ptr;
+static inline void
+write_lock(struct u_space_overseer *uso)
+{
+	pthread_mutex_lock(&uso->lock);
+	u_seqlock_write_begin(&uso->seqlock);
+}
+
+static inline void
+write_unlock(struct u_space_overseer *uso)
+{
+	u_seqlock_write_end(&uso->seqlock);
+	pthread_mutex_unlock(&uso->lock);
+}
+
+static inline bool
+is_static_space(const struct u_space *us)
+{
+	return us->type == U_SPACE_TYPE_NULL || us->type == U_SPACE_TYPE_OFFSET;
 }
 
 /*!
  * Updates the offset of a NULL or OFFSET space.
  */
 static void
-update_offset_write_locked(struct u_space *us, const struct xrt_pose *new_offset)
+update_offset_write_locked(struct u_space_overseer *uso, struct u_space *us, const struct xrt_pose *new_offset)
 {
-	assert(us->type == U_SPACE_TYPE_NULL || us->type == U_SPACE_TYPE_OFFSET);
+	assert(is_static_space(us));
+
+	// Any space under this one might have this offset collapsed into its cache.
+	uso->generation++;
 
 	if (m_pose_is_identity(new_offset)) { // Small optimisation.
 		us->type = U_SPACE_TYPE_NULL;
@@ -240,6 +332,43 @@ get_offset_or_ident_read_locked(const struct u_space *us, struct xrt_pose *offse
 	}
 }
 
+/*!
+ * Makes sure the cached static offsets of a space, and all of the static
+ * spaces above it, are up to date.
+ */
+static void
+refresh_cache_write_locked(struct u_space_overseer *uso, struct u_space *us)
+{
+	if (!is_static_space(us) || us->cache.generation == uso->generation) {
+		return;
+	}
+
+	struct u_space *parent = us->next;
+	assert(parent != NULL);
+
+	struct xrt_pose offset;
+	get_offset_or_ident_read_locked(us, &offset);
+
+	if (is_static_space(parent)) {
+		refresh_cache_write_locked(uso, parent);
+		math_pose_transform(&parent->cache.pose, &offset, &us->cache.pose);
+		us->cache.next = parent->cache.next;
+	} else {
+		us->cache.pose = offset;
+		us->cache.next = parent;
+	}
+
+	us->cache.generation = uso->generation;
+}
+
+static void
+refresh_cache(struct u_space_overseer *uso, struct u_space *us)
+{
+	write_lock(uso);
+	refresh_cache_write_locked(uso, us);
+	write_unlock(uso);
+}
+
 
 /*
  *
@@ -247,6 +376,16 @@ get_offset_or_ident_read_locked(const struct u_space *us, struct xrt_pose *offse
  *
  */
 
+/*!
+ * Has a reference space of this type been created, as tracked by
+ * ref_space_inc and ref_space_dec.
+ */
+static inline bool
+is_ref_space_in_use(struct u_space_overseer *uso, enum xrt_reference_space_type type)
+{
+	return uso->ref_space_use[type].count > 0;
+}
+
 static void
 notify_ref_space_usage_device(struct u_space_overseer *uso, enum xrt_reference_space_type type, bool used)
 {
@@ -280,23 +419,122 @@ notify_ref_space_usage_device(struct u_space_overseer *uso, enum xrt_reference_s
  *
  */
 
+//! Max number of different poses remembered in a @ref pose_cache.
+#define POSE_CACHE_SIZE 16
+
+/*!
+ * Poses sampled while locating multiple spaces at the same time, so spaces on
+ * the same device input, and their parents, only sample the device once.
+ */
+struct pose_cache
+{
+	uint32_t count;
+
+	struct
+	{
+		struct xrt_device *xdev;
+		enum xrt_input_name name;
+		struct xrt_space_relation relation;
+	} entries[POSE_CACHE_SIZE];
+};
+
+/*!
+ * State passed along while traversing the graph.
+ */
+struct traverse_state
+{
+	//! Copy of @ref u_space_overseer::generation, taken with the lock held.
+	uint64_t generation;
+
+	//! Set if a space with an out of date cache was traversed.
+	bool found_stale;
+
+	//! Shared sampled poses, may be NULL.
+	struct pose_cache *cache;
+};
+
+static inline void
+traverse_state_init_read_locked(struct traverse_state *ts, struct u_space_overseer *uso, struct pose_cache *cache)
+{
+	ts->generation = uso->generation;
+	ts->found_stale = false;
+	ts->cache = cache;
+}
+
+/*!
+ * Returns true if the cached static offsets of @p space can be used, marks the
+ * state as having found a stale cache otherwise.
+ */
+static inline bool
+use_cache(struct traverse_state *ts, const struct u_space *space)
+{
+	if (space->cache.generation == ts->generation) {
+		return true;
+	}
+
+	ts->found_stale = true;
+	return false;
+}
+
+/*!
+ * Get the pose of a pose space, using and filling @p cache if not NULL.
+ */
+static void
+sample_pose_space(struct pose_cache *cache,
+                  struct u_space *space,
+                  uint64_t at_timestamp_ns,
+                  struct xrt_space_relation *out_relation)
+{
+	assert(space->pose.xdev != NULL);
+	assert(space->pose.xname != 0);
+
+	struct xrt_device *xdev = space->pose.xdev;
+	enum xrt_input_name name = space->pose.xname;
+
+	if (cache != NULL) {
+		for (uint32_t i = 0; i < cache->count; i++) {
+			if (cache->entries[i].xdev == xdev && cache->entries[i].name == name) {
+				*out_relation = cache->entries[i].relation;
+				return;
+			}
+		}
+	}
+
+	xrt_device_get_tracked_pose(xdev, name, at_timestamp_ns, out_relation);
+
+	if (cache != NULL && cache->count < POSE_CACHE_SIZE) {
+		uint32_t i = cache->count++;
+		cache->entries[i].xdev = xdev;
+		cache->entries[i].name = name;
+		cache->entries[i].relation = *out_relation;
+	}
+}
+
 /*!
  * For each space, push the relation of that space and then traverse by calling
  * @p push_then_traverse again with the parent space. That means traverse goes
  * from a leaf space to a the root space, relations are pushed in the same
- * order.
+ * order. Runs of static spaces are pushed as one pose if their cache is valid.
  */
 static void
-push_then_traverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64_t at_timestamp_ns)
+push_then_traverse(struct xrt_relation_chain *xrc,
+                   struct u_space *space,
+                   uint64_t at_timestamp_ns,
+                   struct traverse_state *ts)
 {
+	if (is_static_space(space) && use_cache(ts, space)) {
+		m_relation_chain_push_pose_if_not_identity(xrc, &space->cache.pose);
+
+		assert(space->cache.next != NULL);
+		push_then_traverse(xrc, space->cache.next, at_timestamp_ns, ts);
+		return;
+	}
+
 	switch (space->type) {
 	case U_SPACE_TYPE_NULL: break; // No-op
 	case U_SPACE_TYPE_POSE: {
-		assert(space->pose.xdev != NULL);
-		assert(space->pose.xname != 0);
-
 		struct xrt_space_relation xsr;
-		xrt_device_get_tracked_pose(space->pose.xdev, space->pose.xname, at_timestamp_ns, &xsr);
+		sample_pose_space(ts->cache, space, at_timestamp_ns, &xsr);
 		m_relation_chain_push_relation(xrc, &xsr);
 	} break;
 	case U_SPACE_TYPE_OFFSET: m_relation_chain_push_pose_if_not_identity(xrc, &space->offset.pose); break;
@@ -305,18 +543,30 @@ push_then_traverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64
 
 	// Please tail-call optimise this miss compiler.
 	assert(space->next != NULL);
-	push_then_traverse(xrc, space->next, at_timestamp_ns);
+	push_then_traverse(xrc, space->next, at_timestamp_ns, ts);
 }
 
 /*!
  * For each space, traverse by calling @p traverse_then_push_inverse again with
  * the parent space then push the inverse of the relation of that. That means
  * traverse goes from a leaf space to a the root space, relations are pushed in
- * the reversed order.
+ * the reversed order. Runs of static spaces are pushed as one pose if their
+ * cache is valid.
  */
 static void
-traverse_then_push_inverse(struct xrt_relation_chain *xrc, struct u_space *space, uint64_t at_timestamp_ns)
+traverse_then_push_inverse(struct xrt_relation_chain *xrc,
+                           struct u_space *space,
+                           uint64_t at_timestamp_ns,
+                           struct traverse_state *ts)
 {
+	if (is_static_space(space) && use_cache(ts, space)) {
+		assert(space->cache.next != NULL);
+		traverse_then_push_inverse(xrc, space->cache.next, at_timestamp_ns, ts);
+
+		m_relation_chain_push_inverted_pose_if_not_identity(xrc, &space->cache.pose);
+		return;
+	}
+
 	// Done traversing.
 	switch (space->type) {
 	case U_SPACE_TYPE_NULL: break;
@@ -327,16 +577,13 @@ traverse_then_push_inverse(struct xrt_relation_chain *xrc, struct u_space *space
 
 	// Can't tail-call optimise this one :(
 	assert(space->next != NULL);
-	traverse_then_push_inverse(xrc, space->next, at_timestamp_ns);
+	traverse_then_push_inverse(xrc, space->next, at_timestamp_ns, ts);
 
 	switch (space->type) {
 	case U_SPACE_TYPE_NULL: break; // No-op
 	case U_SPACE_TYPE_POSE: {
-		assert(space->pose.xdev != NULL);
-		assert(space->pose.xname != 0);
-
 		struct xrt_space_relation xsr;
-		xrt_device_get_tracked_pose(space->pose.xdev, space->pose.xname, at_timestamp_ns, &xsr);
+		sample_pose_space(ts->cache, space, at_timestamp_ns, &xsr);
 		m_relation_chain_push_inverted_relation(xrc, &xsr);
 	} break;
 	case U_SPACE_TYPE_OFFSET: m_relation_chain_push_inverted_pose_if_not_identity(xrc, &space->offset.pose); break;
@@ -344,7 +591,10 @@ traverse_then_push_inverse(struct xrt_relation_chain *xrc, struct u_space *space
 	}
 }
 
-static void
+/*!
+ * Returns true if any of the traversed spaces had an out of date cache.
+ */
+static bool
 build_relation_chain_read_locked(struct u_space_overseer *uso,
                                  struct xrt_relation_chain *xrc,
                                  struct u_space *base,
@@ -355,8 +605,13 @@ build_relation_chain_read_locked(struct u_space_overseer *uso,
 	assert(base != NULL);
 	assert(target != NULL);
 
-	push_then_traverse(xrc, target, at_timestamp_ns);
-	traverse_then_push_inverse(xrc, base, at_timestamp_ns);
+	struct traverse_state ts;
+	traverse_state_init_read_locked(&ts, uso, NULL);
+
+	push_then_traverse(xrc, target, at_timestamp_ns, &ts);
+	traverse_then_push_inverse(xrc, base, at_timestamp_ns, &ts);
+
+	return ts.found_stale;
 }
 
 static void
@@ -366,9 +621,21 @@ build_relation_chain(struct u_space_overseer *uso,
                      struct u_space *target,
                      uint64_t at_timestamp_ns)
 {
-	pthread_rwlock_rdlock(&uso->lock);
-	build_relation_chain_read_locked(uso, xrc, base, target, at_timestamp_ns);
-	pthread_rwlock_unlock(&uso->lock);
+	struct xrt_relation_chain start = *xrc;
+	bool found_stale;
+	uint32_t seq;
+
+	do {
+		seq = u_seqlock_read_begin(&uso->seqlock);
+		*xrc = start;
+		found_stale = build_relation_chain_read_locked(uso, xrc, base, target, at_timestamp_ns);
+	} while (u_seqlock_read_retry(&uso->seqlock, seq));
+
+	// Rare, only after spaces are created or recentered, next locate takes the fast path.
+	if (found_stale) {
+		refresh_cache(uso, target);
+		refresh_cache(uso, base);
+	}
 }
 
 static inline void
@@ -463,6 +730,9 @@ create_offset_space(struct xrt_space_overseer *xso,
 		us->offset.pose = *offset;
 	}
 
+	// So the first locate doesn't have to.
+	refresh_cache(u_space_overseer(xso), us);
+
 	// Created with one references.
 	*out_space = &us->base;
 
@@ -480,14 +750,18 @@ create_pose_space(struct xrt_space_overseer *xso,
 
 	struct u_space_overseer *uso = u_space_overseer(xso);
 
-	// Only need the read lock.
-	pthread_rwlock_rdlock(&uso->lock);
+	struct u_space *uparent;
+	uint32_t seq;
 
-	struct u_space *uparent = find_xdev_space_read_locked(uso, xdev);
-	struct u_space *us = create_space(U_SPACE_TYPE_POSE, uparent);
+	do {
+		seq = u_seqlock_read_begin(&uso->seqlock);
+		uparent = find_xdev_space_read_locked(uso, xdev);
+	} while (u_seqlock_read_retry(&uso->seqlock, seq));
+
+	check_xdev_space(uparent, xdev);
 
-	// Safe to unlock now.
-	pthread_rwlock_unlock(&uso->lock);
+	// Replaced spaces are never freed while the overseer lives.
+	struct u_space *us = create_space(U_SPACE_TYPE_POSE, uparent);
 
 	us->pose.xdev = xdev;
 	us->pose.xname = name;
@@ -524,6 +798,64 @@ locate_space(struct xrt_space_overseer *xso,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct u_space_overseer *uso = u_space_overseer(xso);
+
+	struct u_space *ubase_space = u_space(base_space);
+
+	// Spaces on the same device input share the sampled pose, also means a retry doesn't sample again.
+	struct pose_cache cache;
+	cache.count = 0;
+
+	struct traverse_state ts;
+	uint32_t seq;
+
+	// Redone for all spaces if an offset changed meanwhile, which is rare.
+	do {
+		seq = u_seqlock_read_begin(&uso->seqlock);
+
+		traverse_state_init_read_locked(&ts, uso, &cache);
+
+		// The base space is the same for all spaces, only traverse it once.
+		struct xrt_relation_chain base_xrc = {0};
+		traverse_then_push_inverse(&base_xrc, ubase_space, at_timestamp_ns, &ts);
+
+		for (uint32_t i = 0; i < space_count; i++) {
+			struct xrt_relation_chain xrc = {0};
+
+			m_relation_chain_push_pose_if_not_identity(&xrc, &offsets[i]);
+			push_then_traverse(&xrc, u_space(spaces[i]), at_timestamp_ns, &ts);
+
+			// Same relations as traversing the base space again.
+			for (uint32_t k = 0; k < base_xrc.step_count; k++) {
+				m_relation_chain_push_relation(&xrc, &base_xrc.steps[k]);
+			}
+			m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+
+			// For base_space =~= space (approx equals).
+			special_resolve(&xrc, &out_relations[i]);
+		}
+	} while (u_seqlock_read_retry(&uso->seqlock, seq));
+
+	if (ts.found_stale) {
+		refresh_cache(uso, ubase_space);
+		for (uint32_t i = 0; i < space_count; i++) {
+			refresh_cache(uso, u_space(spaces[i]));
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -536,16 +868,31 @@ locate_device(struct xrt_space_overseer *xso,
 
 	struct u_space *ubase_space = u_space(base_space);
 
-	struct xrt_relation_chain xrc = {0};
+	struct xrt_relation_chain xrc;
+	struct u_space *uspace;
+	bool found_stale = false;
+	uint32_t seq;
 
-	// Only need the read lock.
-	pthread_rwlock_rdlock(&uso->lock);
+	do {
+		seq = u_seqlock_read_begin(&uso->seqlock);
 
-	struct u_space *uspace = find_xdev_space_read_locked(uso, xdev);
-	build_relation_chain_read_locked(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+		U_ZERO(&xrc);
+		uspace = find_xdev_space_read_locked(uso, xdev);
+		if (uspace != NULL) {
+			found_stale = build_relation_chain_read_locked(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+		}
+	} while (u_seqlock_read_retry(&uso->seqlock, seq));
 
-	// Safe to unlock now.
-	pthread_rwlock_unlock(&uso->lock);
+	check_xdev_space(uspace, xdev);
+	if (uspace == NULL) {
+		*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+		return XRT_SUCCESS;
+	}
+
+	if (found_stale) {
+		refresh_cache(uso, uspace);
+		refresh_cache(uso, ubase_space);
+	}
 
 	// Do as much work outside of the lock.
 	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
@@ -612,8 +959,8 @@ recenter_local_spaces(struct xrt_space_overseer *xso)
 	struct u_space_overseer *uso = u_space_overseer(xso);
 	xrt_result_t xret;
 
-	// Take the full lock from the start.
-	pthread_rwlock_wrlock(&uso->lock);
+	// Take the writer lock from the start, no other writer can change anything so no need for a read section.
+	pthread_mutex_lock(&uso->lock);
 
 	// Can we do recentering, check with lock held.
 	if (uso->can_do_local_spaces_recenter) {
@@ -681,8 +1028,14 @@ recenter_local_spaces(struct xrt_space_overseer *xso)
 	local_floor_offset.position.z = rel.pose.position.z;
 
 	// Update the offsets.
-	update_offset_write_locked(ulocal, &local_offset);
-	update_offset_write_locked(ulocal_floor, &local_floor_offset);
+	u_seqlock_write_begin(&uso->seqlock);
+	update_offset_write_locked(uso, ulocal, &local_offset);
+	update_offset_write_locked(uso, ulocal_floor, &local_floor_offset);
+
+	// The spaces above these haven't changed, refresh these directly.
+	refresh_cache_write_locked(uso, ulocal);
+	refresh_cache_write_locked(uso, ulocal_floor);
+	u_seqlock_write_end(&uso->seqlock);
 
 	// Push the events.
 	union xrt_session_event xse = XRT_STRUCT_INIT;
@@ -693,26 +1046,30 @@ recenter_local_spaces(struct xrt_space_overseer *xso)
 	xse.ref_change.pose_in_previous_space = (struct xrt_pose)XRT_POSE_IDENTITY;
 	xse.ref_change.timestamp_ns = os_monotonic_get_ns();
 
-	// Event for local space.
-	xse.ref_change.ref_type = XRT_SPACE_REFERENCE_TYPE_LOCAL;
-	xret = xrt_session_event_sink_push(uso->broadcast, &xse);
-	if (xret != XRT_SUCCESS) {
-		U_LOG_E("Failed to push event for LOCAL!");
+	// Event for local space, only if anybody has created one.
+	if (is_ref_space_in_use(uso, XRT_SPACE_REFERENCE_TYPE_LOCAL)) {
+		xse.ref_change.ref_type = XRT_SPACE_REFERENCE_TYPE_LOCAL;
+		xret = xrt_session_event_sink_push(uso->broadcast, &xse);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Failed to push event for LOCAL!");
+		}
 	}
 
-	// Event for local floor space.
-	xse.ref_change.ref_type = XRT_SPACE_REFERENCE_TYPE_LOCAL_FLOOR;
-	xret = xrt_session_event_sink_push(uso->broadcast, &xse);
-	if (xret != XRT_SUCCESS) {
-		U_LOG_E("Failed to push event LOCAL_FLOOR!");
+	// Event for local floor space, only if anybody has created one.
+	if (is_ref_space_in_use(uso, XRT_SPACE_REFERENCE_TYPE_LOCAL_FLOOR)) {
+		xse.ref_change.ref_type = XRT_SPACE_REFERENCE_TYPE_LOCAL_FLOOR;
+		xret = xrt_session_event_sink_push(uso->broadcast, &xse);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Failed to push event LOCAL_FLOOR!");
+		}
 	}
 
-	pthread_rwlock_unlock(&uso->lock);
+	pthread_mutex_unlock(&uso->lock);
 
 	return XRT_SUCCESS;
 
 err_unlock:
-	pthread_rwlock_unlock(&uso->lock);
+	pthread_mutex_unlock(&uso->lock);
 
 	return XRT_ERROR_RECENTERING_NOT_SUPPORTED;
 }
@@ -729,11 +1086,16 @@ destroy(struct xrt_space_overseer *xso)
 	xrt_space_reference(&uso->base.semantic.view, NULL);
 	xrt_space_reference(&uso->base.semantic.root, NULL);
 
-	// Each device has a reference to its space, make sure to unreference before creating.
-	u_hashmap_int_clear_and_call_for_each(uso->xdev_map, hashmap_unreference_space_items, uso);
-	u_hashmap_int_destroy(&uso->xdev_map);
+	// Each device has a reference to its space, make sure to unreference before destroying.
+	for (uint32_t i = 0; i < uso->xdev_space_count; i++) {
+		u_space_reference(&uso->xdev_spaces[i].space, NULL);
+	}
+	for (uint32_t i = 0; i < uso->retired_space_count; i++) {
+		u_space_reference(&uso->retired_spaces[i], NULL);
+	}
+	free(uso->retired_spaces);
 
-	pthread_rwlock_destroy(&uso->lock);
+	pthread_mutex_destroy(&uso->lock);
 
 	free(uso);
 }
@@ -752,19 +1114,18 @@ u_space_overseer_create(struct xrt_session_event_sink *broadcast)
 	uso->base.create_offset_space = create_offset_space;
 	uso->base.create_pose_space = create_pose_space;
 	uso->base.locate_space = locate_space;
+	uso->base.locate_spaces = locate_spaces;
 	uso->base.locate_device = locate_device;
 	uso->base.ref_space_inc = ref_space_inc;
 	uso->base.ref_space_dec = ref_space_dec;
 	uso->base.recenter_local_spaces = recenter_local_spaces;
 	uso->base.destroy = destroy;
 	uso->broadcast = broadcast;
+	uso->generation = 1; // Spaces start out with a stale cache.
 
 	XRT_MAYBE_UNUSED int ret = 0;
 
-	ret = pthread_rwlock_init(&uso->lock, NULL);
-	assert(ret == 0);
-
-	ret = u_hashmap_int_create(&uso->xdev_map);
+	ret = pthread_mutex_init(&uso->lock, NULL);
 	assert(ret == 0);
 
 	create_and_set_root_space(uso);
@@ -863,6 +1224,9 @@ u_space_overseer_create_null_space(struct u_space_overseer *uso, struct xrt_spac
 	struct u_space *uparent = u_space(parent);
 	struct u_space *us = create_space(U_SPACE_TYPE_NULL, uparent);
 
+	// So the first locate doesn't have to.
+	refresh_cache(uso, us);
+
 	// Created with one references.
 	*out_space = &us->base;
 }
@@ -870,24 +1234,32 @@ u_space_overseer_create_null_space(struct u_space_overseer *uso, struct xrt_spac
 void
 u_space_overseer_link_space_to_device(struct u_space_overseer *uso, struct xrt_space *xs, struct xrt_device *xdev)
 {
-	pthread_rwlock_wrlock(&uso->lock);
+	// Each xdev needs to add a reference to the space.
+	struct u_space *new_space = NULL;
+	u_space_reference(&new_space, u_space(xs));
 
-	void *ptr = NULL;
-	uint64_t key = (uint64_t)(intptr_t)xdev;
-	u_hashmap_int_find(uso->xdev_map, key, &ptr);
-	if (ptr != NULL) {
-		U_LOG_W("Device '%s' already have a space attached!", xdev->str);
-	}
+	write_lock(uso);
 
-	// Each xdev needs to add a reference to the space.
-	struct xrt_space *new_space = NULL;
-	xrt_space_reference(&new_space, xs);
+	uint32_t index = 0;
+	while (index < uso->xdev_space_count && uso->xdev_spaces[index].xdev != xdev) {
+		index++;
+	}
 
-	u_hashmap_int_insert(uso->xdev_map, (uint64_t)(intptr_t)xdev, new_space);
+	if (index < uso->xdev_space_count) {
+		U_LOG_W("Device '%s' already have a space attached!", xdev->str);
 
-	pthread_rwlock_unlock(&uso->lock);
+		// Readers might still be using the old space, keep it alive until destroy.
+		U_ARRAY_REALLOC_OR_FREE(uso->retired_spaces, struct u_space *, uso->retired_space_count + 1);
+		uso->retired_spaces[uso->retired_space_count++] = uso->xdev_spaces[index].space;
+		uso->xdev_spaces[index].space = new_space;
+	} else if (index < ARRAY_SIZE(uso->xdev_spaces)) {
+		uso->xdev_spaces[index].xdev = xdev;
+		uso->xdev_spaces[index].space = new_space;
+		uso->xdev_space_count++;
+	} else {
+		U_LOG_E("Too many devices, can't attach a space to '%s'!", xdev->str);
+		u_space_reference(&new_space, NULL);
+	}
 
-	// Dereferrence old space outside of lock.
-	struct xrt_space *old_space = (struct xrt_space *)ptr;
-	xrt_space_reference(&old_space, NULL);
+	write_unlock(uso);
 }
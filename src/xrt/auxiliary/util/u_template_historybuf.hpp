@@ -16,6 +16,7 @@
 
 #include <limits>
 #include <array>
+#include <utility>
 
 namespace xrt::auxiliary::util {
 
@@ -24,6 +25,33 @@ namespace detail {
 	template <typename T, size_t MaxSize> class HistoryBufIterator;
 } // namespace detail
 
+/*!
+ * @brief A non-owning view of a contiguous run of elements in a @ref HistoryBuffer, usable with standard algorithms.
+ */
+template <typename T> struct HistoryBufSpan
+{
+	T *data = nullptr;
+	size_t count = 0;
+
+	bool
+	empty() const noexcept
+	{
+		return count == 0;
+	}
+
+	T *
+	begin() const noexcept
+	{
+		return data;
+	}
+
+	T *
+	end() const noexcept
+	{
+		return data + count;
+	}
+};
+
 /*!
  * @brief Stores some number of values in a ring buffer, overwriting the earliest-pushed-remaining element if out of
  * room.
@@ -31,7 +59,7 @@ namespace detail {
  * Note this should only store value types, since there's no way to destroy elements other than overwriting them, and
  * all elements are default-initialized upon construction of the container.
  *
- * @note Unlike @ref m_relation_history which is based on this, this data structure is
+ * @note Unlike @ref m_relation_history, this data structure is
  * **not inherently safe for concurrent/threaded use**: there are no locks built-in.
  */
 template <typename T, size_t MaxSize> class HistoryBuffer
@@ -181,9 +209,33 @@ public:
 	const T &
 	back() const;
 
+	using span = HistoryBufSpan<T>;
+	using const_span = HistoryBufSpan<const T>;
+
+	/*!
+	 * @brief Get the stored elements as two contiguous spans of raw memory, in chronological order.
+	 *
+	 * The first span holds the oldest elements, the second is only non-empty when the elements wrap around the
+	 * end of the backing array. Lets callers run things like `std::lower_bound` on plain pointers instead of
+	 * the checked iterators, searching the second span first if the value is newer than the first's back.
+	 *
+	 * This is permitted to be invalidated by any modification of the buffer, like the iterators.
+	 */
+	std::pair<span, span>
+	contiguous_spans() noexcept;
+
+	//! @overload
+	std::pair<const_span, const_span>
+	contiguous_spans() const noexcept;
+
 	void
 	clear();
 
+	/*!
+	 * Is MaxSize a power of two, in which case all index wrapping is done with a mask rather than a modulo.
+	 */
+	static constexpr bool is_power_of_two = detail::RingBufferHelper::is_power_of_two(MaxSize);
+
 private:
 	// Make sure all valid indices can be represented in a signed integer of the same size
 	static_assert(MaxSize < (std::numeric_limits<size_t>::max() >> 1), "Cannot use most significant bit");
@@ -266,6 +318,29 @@ HistoryBuffer<T, MaxSize>::get_at_index(size_t index) const noexcept
 	return nullptr;
 }
 
+template <typename T, size_t MaxSize>
+inline std::pair<HistoryBufSpan<T>, HistoryBufSpan<T>>
+HistoryBuffer<T, MaxSize>::contiguous_spans() noexcept
+{
+	size_t first_inner_idx = 0;
+	size_t first_count = 0;
+	size_t second_count = 0;
+	helper_.contiguous_runs(first_inner_idx, first_count, second_count);
+	return {span{internalBuffer.data() + first_inner_idx, first_count}, span{internalBuffer.data(), second_count}};
+}
+
+template <typename T, size_t MaxSize>
+inline std::pair<HistoryBufSpan<const T>, HistoryBufSpan<const T>>
+HistoryBuffer<T, MaxSize>::contiguous_spans() const noexcept
+{
+	size_t first_inner_idx = 0;
+	size_t first_count = 0;
+	size_t second_count = 0;
+	helper_.contiguous_runs(first_inner_idx, first_count, second_count);
+	return {const_span{internalBuffer.data() + first_inner_idx, first_count},
+	        const_span{internalBuffer.data(), second_count}};
+}
+
 template <typename T, size_t MaxSize>
 inline T &
 HistoryBuffer<T, MaxSize>::front()
@@ -46,7 +46,9 @@ class RingBufferHelper
 {
 public:
 	//! Construct for a given size
-	explicit constexpr RingBufferHelper(size_t capacity) : capacity_(capacity) {}
+	explicit constexpr RingBufferHelper(size_t capacity)
+	    : capacity_(capacity), mask_(is_power_of_two(capacity) ? capacity - 1 : 0)
+	{}
 	RingBufferHelper(RingBufferHelper const &) = default;
 	RingBufferHelper(RingBufferHelper &&) = default;
 	RingBufferHelper &
@@ -115,13 +117,32 @@ public:
 	size_t
 	back_inner_index() const noexcept;
 
+	/*!
+	 * @brief Get the stored elements as (up to) two contiguous runs of inner indices, in chronological order.
+	 *
+	 * The first run starts at @p out_first_inner_idx and is @p out_first_count long, the second run (if the
+	 * elements wrap around the end of the backing array) always starts at inner index 0.
+	 */
+	void
+	contiguous_runs(size_t &out_first_inner_idx, size_t &out_first_count, size_t &out_second_count) const noexcept;
+
 	void
 	clear();
 
+	//! Is @p capacity a (non-zero) power of two, so wrapping can be done with a mask?
+	static constexpr bool
+	is_power_of_two(size_t capacity) noexcept
+	{
+		return capacity != 0 && (capacity & (capacity - 1)) == 0;
+	}
+
 private:
 	// Would be const, but that would mess up our ability to copy/move containers using this.
 	size_t capacity_;
 
+	//! capacity_ - 1 if capacity_ is a power of two, zero otherwise.
+	size_t mask_;
+
 	//! The inner index containing the most recently added element, if any
 	size_t latest_inner_idx_ = 0;
 
@@ -137,6 +158,20 @@ private:
 	 */
 	size_t
 	front_impl_() const noexcept;
+
+	/*!
+	 * @brief Wrap a (possibly past the end) inner index back into the backing array.
+	 *
+	 * @p idx must be less than twice capacity_, uses a mask instead of a modulo for power of two sizes.
+	 */
+	size_t
+	wrap_(size_t idx) const noexcept
+	{
+		if (mask_ != 0) {
+			return idx & mask_;
+		}
+		return idx % capacity_;
+	}
 };
 
 
@@ -152,7 +187,7 @@ RingBufferHelper::front_impl_() const noexcept
 {
 	assert(!empty());
 	// length will not exceed capacity_, so this will not underflow
-	return (latest_inner_idx_ + capacity_ - length_ + 1) % capacity_;
+	return wrap_(latest_inner_idx_ + capacity_ - length_ + 1);
 }
 
 inline bool
@@ -167,7 +202,7 @@ RingBufferHelper::age_to_inner_index(size_t age, size_t &out_inner_idx) const no
 	}
 	// latest_inner_idx_ is the same as (latest_inner_idx_ + capacity_) % capacity_ so we add capacity_ to
 	// prevent underflow with unsigned values
-	out_inner_idx = (latest_inner_idx_ + capacity_ - age) % capacity_;
+	out_inner_idx = wrap_(latest_inner_idx_ + capacity_ - age);
 	return true;
 }
 
@@ -190,8 +225,8 @@ RingBufferHelper::index_to_inner_index(size_t index, size_t &out_inner_idx) cons
 	if (index >= length_) {
 		return false;
 	}
-	// add to the front (oldest) index and take modulo capacity_
-	out_inner_idx = (front_impl_() + index) % capacity_;
+	// add to the front (oldest) index and wrap around
+	out_inner_idx = wrap_(front_impl_() + index);
 	return true;
 }
 
@@ -199,7 +234,7 @@ inline size_t
 RingBufferHelper::push_back_location() noexcept
 {
 	// We always increment the latest inner index modulo capacity_
-	latest_inner_idx_ = (latest_inner_idx_ + 1) % capacity_;
+	latest_inner_idx_ = wrap_(latest_inner_idx_ + 1);
 	// Length cannot exceed capacity_. If it already was capacity_, that means we're overwriting something at
 	// latest_inner_idx_
 	length_ = std::min(length_ + 1, capacity_);
@@ -220,7 +255,7 @@ RingBufferHelper::pop_back() noexcept
 		return false;
 	}
 	// adding capacity before -1 to avoid overflow
-	latest_inner_idx_ = (latest_inner_idx_ + capacity_ - 1) % capacity_;
+	latest_inner_idx_ = wrap_(latest_inner_idx_ + capacity_ - 1);
 	length_--;
 	return true;
 }
@@ -242,4 +277,21 @@ RingBufferHelper::back_inner_index() const noexcept
 	return latest_inner_idx_;
 }
 
+inline void
+RingBufferHelper::contiguous_runs(size_t &out_first_inner_idx,
+                                  size_t &out_first_count,
+                                  size_t &out_second_count) const noexcept
+{
+	if (empty()) {
+		out_first_inner_idx = 0;
+		out_first_count = 0;
+		out_second_count = 0;
+		return;
+	}
+	out_first_inner_idx = front_impl_();
+	// The stored elements stop either at their own end or at the end of the backing array.
+	out_first_count = (std::min)(length_, capacity_ - out_first_inner_idx);
+	out_second_count = length_ - out_first_count;
+}
+
 } // namespace xrt::auxiliary::util::detail
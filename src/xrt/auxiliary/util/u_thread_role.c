@@ -0,0 +1,257 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Scheduling profiles for the different kinds of threads in Monado.
+ *
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_thread_role.h"
+
+#if defined(XRT_OS_LINUX)
+#include "util/u_linux.h"
+#include <sched.h>
+#elif defined(XRT_OS_WINDOWS)
+#include "util/u_windows.h"
+#endif
+
+#include <ctype.h>
+#include <assert.h>
+#include <stdlib.h>
+
+
+DEBUG_GET_ONCE_NUM_OPTION(imu_priority, "XRT_THREAD_IMU_PRIORITY", 60)
+DEBUG_GET_ONCE_NUM_OPTION(camera_priority, "XRT_THREAD_CAMERA_PRIORITY", 50)
+DEBUG_GET_ONCE_NUM_OPTION(compositor_priority, "XRT_THREAD_COMPOSITOR_PRIORITY", 40)
+DEBUG_GET_ONCE_NUM_OPTION(ipc_frame_priority, "XRT_THREAD_IPC_FRAME_PRIORITY", 30)
+DEBUG_GET_ONCE_NUM_OPTION(background_priority, "XRT_THREAD_BACKGROUND_PRIORITY", 0)
+
+DEBUG_GET_ONCE_OPTION(imu_cpus, "XRT_THREAD_IMU_CPUS", NULL)
+DEBUG_GET_ONCE_OPTION(camera_cpus, "XRT_THREAD_CAMERA_CPUS", NULL)
+DEBUG_GET_ONCE_OPTION(compositor_cpus, "XRT_THREAD_COMPOSITOR_CPUS", NULL)
+DEBUG_GET_ONCE_OPTION(ipc_frame_cpus, "XRT_THREAD_IPC_FRAME_CPUS", NULL)
+DEBUG_GET_ONCE_OPTION(background_cpus, "XRT_THREAD_BACKGROUND_CPUS", NULL)
+
+#define LOG_W(...) U_LOG_IFL_W(log_level, __VA_ARGS__)
+
+//! Highest realtime priority a role can be given.
+#define MAX_PRIORITY (99)
+
+//! Nice value of background threads, same as Android's background priority.
+#define BACKGROUND_NICE (10)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+struct profile
+{
+	//! Realtime priority, 0 for normal scheduling.
+	int priority;
+
+	//! Parsed from the string of CPUs, zero for all.
+	uint64_t cpu_mask;
+};
+
+static void
+get_profile(enum u_thread_role role, enum u_logging_level log_level, struct profile *out_profile)
+{
+	long priority = 0;
+	const char *cpus = NULL;
+
+	switch (role) {
+	case U_THREAD_ROLE_IMU:
+		priority = debug_get_num_option_imu_priority();
+		cpus = debug_get_option_imu_cpus();
+		break;
+	case U_THREAD_ROLE_CAMERA:
+		priority = debug_get_num_option_camera_priority();
+		cpus = debug_get_option_camera_cpus();
+		break;
+	case U_THREAD_ROLE_COMPOSITOR:
+		priority = debug_get_num_option_compositor_priority();
+		cpus = debug_get_option_compositor_cpus();
+		break;
+	case U_THREAD_ROLE_IPC_FRAME:
+		priority = debug_get_num_option_ipc_frame_priority();
+		cpus = debug_get_option_ipc_frame_cpus();
+		break;
+	case U_THREAD_ROLE_BACKGROUND:
+		priority = debug_get_num_option_background_priority();
+		cpus = debug_get_option_background_cpus();
+		break;
+	default: assert(false);
+	}
+
+	if (priority < 0) {
+		priority = 0;
+	} else if (priority > MAX_PRIORITY) {
+		priority = MAX_PRIORITY;
+	}
+
+	uint64_t cpu_mask = 0;
+	if (cpus != NULL && !u_thread_role_parse_cpus(cpus, &cpu_mask)) {
+		LOG_W("Invalid CPU list '%s' for %s threads, not setting affinity", cpus, u_thread_role_str(role));
+		cpu_mask = 0;
+	}
+
+	out_profile->priority = (int)priority;
+	out_profile->cpu_mask = cpu_mask;
+}
+
+#if defined(XRT_OS_LINUX)
+
+/*!
+ * Nice values for when realtime scheduling isn't allowed, priority 40 gives
+ * -8 which is what Android uses for urgent display threads.
+ */
+static int
+priority_to_nice(int priority)
+{
+	return -(1 + (priority - 1) * 19 / (MAX_PRIORITY - 1));
+}
+
+static void
+apply_profile(enum u_thread_role role, enum u_logging_level log_level, const char *name, const struct profile *p)
+{
+	if (p->priority > 0) {
+		if (!u_linux_try_to_set_scheduling_on_thread(log_level, name, SCHED_FIFO, p->priority)) {
+			u_linux_try_to_set_nice_on_thread(log_level, name, priority_to_nice(p->priority));
+		}
+	} else if (role == U_THREAD_ROLE_BACKGROUND) {
+		u_linux_try_to_set_nice_on_thread(log_level, name, BACKGROUND_NICE);
+	}
+
+	if (p->cpu_mask != 0) {
+		u_linux_try_to_set_affinity_on_thread(log_level, name, p->cpu_mask);
+	}
+}
+
+#elif defined(XRT_OS_WINDOWS)
+
+static int
+priority_to_windows(int priority)
+{
+	if (priority >= 60) {
+		return THREAD_PRIORITY_TIME_CRITICAL;
+	} else if (priority >= 40) {
+		return THREAD_PRIORITY_HIGHEST;
+	} else {
+		return THREAD_PRIORITY_ABOVE_NORMAL;
+	}
+}
+
+static void
+apply_profile(enum u_thread_role role, enum u_logging_level log_level, const char *name, const struct profile *p)
+{
+	if (name == NULL) {
+		name = u_thread_role_str(role);
+	}
+
+	if (p->priority > 0) {
+		u_win_try_to_set_thread_priority(log_level, name, priority_to_windows(p->priority));
+	} else if (role == U_THREAD_ROLE_BACKGROUND) {
+		u_win_try_to_set_thread_priority(log_level, name, THREAD_PRIORITY_BELOW_NORMAL);
+	}
+
+	if (p->cpu_mask != 0) {
+		u_win_try_to_set_thread_affinity(log_level, name, p->cpu_mask);
+	}
+}
+
+#else
+
+static void
+apply_profile(enum u_thread_role role, enum u_logging_level log_level, const char *name, const struct profile *p)
+{
+	// Not supported on this platform.
+}
+
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+const char *
+u_thread_role_str(enum u_thread_role role)
+{
+	switch (role) {
+	case U_THREAD_ROLE_IMU: return "IMU";
+	case U_THREAD_ROLE_CAMERA: return "camera";
+	case U_THREAD_ROLE_COMPOSITOR: return "compositor";
+	case U_THREAD_ROLE_IPC_FRAME: return "IPC frame";
+	case U_THREAD_ROLE_BACKGROUND: return "background";
+	default: return "unknown";
+	}
+}
+
+bool
+u_thread_role_parse_cpus(const char *str, uint64_t *out_mask)
+{
+	uint64_t mask = 0;
+	const char *p = str;
+
+	while (*p != '\0') {
+		char *end = NULL;
+
+		if (!isdigit((unsigned char)*p)) {
+			return false;
+		}
+
+		unsigned long first = strtoul(p, &end, 10);
+		unsigned long last = first;
+		p = end;
+
+		if (*p == '-') {
+			p++;
+			if (!isdigit((unsigned char)*p)) {
+				return false;
+			}
+
+			last = strtoul(p, &end, 10);
+			p = end;
+		}
+
+		if (first > last || last > 63) {
+			return false;
+		}
+
+		for (unsigned long i = first; i <= last; i++) {
+			mask |= UINT64_C(1) << i;
+		}
+
+		if (*p == ',') {
+			p++;
+			if (*p == '\0') {
+				return false;
+			}
+		} else if (*p != '\0') {
+			return false;
+		}
+	}
+
+	*out_mask = mask;
+
+	return true;
+}
+
+void
+u_thread_role_apply(enum u_thread_role role, enum u_logging_level log_level, const char *name)
+{
+	struct profile p;
+	get_profile(role, log_level, &p);
+
+	apply_profile(role, log_level, name, &p);
+}
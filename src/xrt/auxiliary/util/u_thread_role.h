@@ -0,0 +1,95 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Scheduling profiles for the different kinds of threads in Monado.
+ *
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "util/u_logging.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * What a thread does, decides how it is scheduled compared to other threads.
+ *
+ * Each role has a realtime priority from 1 to 99, where 0 means normal
+ * scheduling, set with `XRT_THREAD_<ROLE>_PRIORITY`. And a list of CPUs the
+ * threads may run on like `2,3` or `4-7`, set with `XRT_THREAD_<ROLE>_CPUS`,
+ * all CPUs when not set. Pinning tracking threads to CPUs that are kept free
+ * with kernel command line `isolcpus` stops apps from preempting them.
+ *
+ * On Linux the priority is used with `SCHED_FIFO`, falling back to a nice
+ * value if realtime scheduling isn't allowed, which is normally the case on
+ * Android. On Windows it's mapped to the `THREAD_PRIORITY_*` values.
+ *
+ * @ingroup aux_util
+ */
+enum u_thread_role
+{
+	//! Reading IMU samples, the highest priority as they drive poses, default priority 60.
+	U_THREAD_ROLE_IMU,
+
+	//! Getting camera frames and running tracking on them, default priority 50.
+	U_THREAD_ROLE_CAMERA,
+
+	//! The compositor's render loop and vblank handling, default priority 40.
+	U_THREAD_ROLE_COMPOSITOR,
+
+	//! Threads that clients wait on to render their frames, default priority 30.
+	U_THREAD_ROLE_IPC_FRAME,
+
+	/*!
+	 * Things that can wait, like writing logs and metrics, default priority
+	 * 0 and scheduled below other normal threads.
+	 */
+	U_THREAD_ROLE_BACKGROUND,
+};
+
+/*!
+ * Returns a string of the role, for logging.
+ *
+ * @ingroup aux_util
+ */
+const char *
+u_thread_role_str(enum u_thread_role role);
+
+/*!
+ * Parse a list of CPUs like `0,2-3`, only CPUs 0 to 63 are supported. Returns
+ * false on syntax errors or CPUs out of range, an empty string gives an empty
+ * mask.
+ *
+ * @param      str      String to parse.
+ * @param[out] out_mask Bit per CPU in the list.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_thread_role_parse_cpus(const char *str, uint64_t *out_mask);
+
+/*!
+ * Apply the scheduling profile of the given role to the calling thread, so
+ * must be called from the thread itself, normally first thing in its function.
+ * Failing to raise the priority is not fatal and only logged.
+ *
+ * @param role      What the thread does.
+ * @param log_level Logging level to control chattiness.
+ * @param name      Thread name to be used in logging, can be NULL.
+ *
+ * @ingroup aux_util
+ */
+void
+u_thread_role_apply(enum u_thread_role role, enum u_logging_level log_level, const char *name);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,11 +12,19 @@
 #include "xrt/xrt_config_have.h"
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 
+#include "util/u_misc.h"
+#include "util/u_atomic.h"
+#include "util/u_time.h"
 #include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_thread_role.h"
 #include "util/u_trace_marker.h"
 
 #include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
 
 
 #ifdef U_TRACE_PERCETTO
@@ -117,3 +125,362 @@ u_trace_marker_init(void)
 }
 
 #endif // !U_TRACE_PERCETTO
+
+
+/*
+ *
+ * Built-in trace ring.
+ *
+ * Each thread that hits a trace marker gets its own fixed size ring of begin
+ * and end events, only that thread writes to it so recording is just a
+ * timestamp and a store. A dump copies the rings out and writes the last few
+ * seconds as Chrome JSON, which Perfetto and chrome://tracing can both open.
+ *
+ */
+
+//! Events per thread, must be a power of two.
+#define RING_EVENT_COUNT (4096)
+
+//! Threads beyond this many don't record anything.
+#define RING_MAX_THREADS (128)
+
+//! How far back a dump goes.
+#define RING_DUMP_WINDOW_NS (2 * (uint64_t)U_TIME_1S_IN_NS)
+
+//! Minimum time between two dumps, a bad patch misses many frames in a row.
+#define RING_DUMP_MIN_INTERVAL_NS (10 * (uint64_t)U_TIME_1S_IN_NS)
+
+#define RING_THREAD_NAME_LEN (64)
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREAD_LOCAL _Thread_local
+#else
+#error "compiler not supported"
+#endif
+
+DEBUG_GET_ONCE_BOOL_OPTION(trace_ring, "XRT_TRACE_RING", false)
+DEBUG_GET_ONCE_OPTION(trace_ring_dir, "XRT_TRACE_RING_DIR", ".")
+
+enum ring_event_type
+{
+	RING_EVENT_BEGIN,
+	RING_EVENT_END,
+};
+
+struct ring_event
+{
+	uint64_t timestamp_ns;
+	const char *name;
+	enum ring_event_type type;
+};
+
+struct thread_ring
+{
+	//! Used as the thread id in dumps.
+	uint32_t index;
+
+	//! Set by the owning thread, may be torn in a dump.
+	char name[RING_THREAD_NAME_LEN];
+
+	//! Number of events ever written, only the owning thread writes.
+	uint64_t count;
+
+	struct ring_event events[RING_EVENT_COUNT];
+};
+
+enum ring_dumper_state
+{
+	RING_DUMPER_OFF = 0,
+	RING_DUMPER_STARTING,
+	RING_DUMPER_RUNNING,
+	RING_DUMPER_FAILED,
+};
+
+static struct
+{
+	//! Number of rings handed out, may be higher than RING_MAX_THREADS.
+	xrt_atomic_s32_t thread_count;
+
+	//! Published with a release store once set up.
+	void *volatile rings[RING_MAX_THREADS];
+
+	//! A @ref ring_dumper_state.
+	xrt_atomic_s32_t dumper_state;
+
+	struct os_thread_helper dumper;
+
+	//! Guarded by the dumper lock.
+	bool dump_requested;
+	uint64_t dump_requested_ns;
+	uint64_t last_dump_ns;
+	const char *dump_reason;
+} g_ring;
+
+static THREAD_LOCAL struct thread_ring *t_ring = NULL;
+static THREAD_LOCAL bool t_ring_checked = false;
+
+static struct thread_ring *
+ring_create_for_thread(void)
+{
+	int32_t index = xrt_atomic_s32_inc_return(&g_ring.thread_count) - 1;
+	if (index >= RING_MAX_THREADS) {
+		return NULL;
+	}
+
+	struct thread_ring *ring = U_TYPED_CALLOC(struct thread_ring);
+	if (ring == NULL) {
+		return NULL;
+	}
+
+	ring->index = (uint32_t)index;
+	snprintf(ring->name, sizeof(ring->name), "Thread %u", ring->index);
+
+	u_atomic_ptr_store_release(&g_ring.rings[index], ring);
+
+	return ring;
+}
+
+static inline struct thread_ring *
+ring_get(void)
+{
+	if (t_ring != NULL || t_ring_checked) {
+		return t_ring;
+	}
+
+	t_ring_checked = true;
+	if (debug_get_bool_option_trace_ring()) {
+		t_ring = ring_create_for_thread();
+	}
+
+	return t_ring;
+}
+
+static inline void
+ring_push(enum ring_event_type type, const char *name)
+{
+	struct thread_ring *ring = ring_get();
+	if (ring == NULL) {
+		return;
+	}
+
+	uint64_t count = ring->count;
+	struct ring_event *e = &ring->events[count & (RING_EVENT_COUNT - 1)];
+	e->timestamp_ns = os_monotonic_get_ns();
+	e->name = name;
+	e->type = type;
+
+	// Publish the event to dumps.
+	u_atomic_u64_store_release(&ring->count, count + 1);
+}
+
+static void
+write_json_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (; *str != '\0'; str++) {
+		char c = *str;
+		if (c == '"' || c == '\\' || (unsigned char)c < 0x20) {
+			c = '_';
+		}
+		fputc(c, file);
+	}
+	fputc('"', file);
+}
+
+/*!
+ * Copies the events of @p ring newer than @p since_ns into @p out_events, skips
+ * any that the owning thread overwrote while copying.
+ */
+static uint32_t
+ring_snapshot(struct thread_ring *ring, uint64_t since_ns, struct ring_event *out_events)
+{
+	uint64_t end = u_atomic_u64_load_acquire(&ring->count);
+	uint64_t begin = end > RING_EVENT_COUNT ? end - RING_EVENT_COUNT : 0;
+
+	for (uint64_t i = begin; i < end; i++) {
+		out_events[i - begin] = ring->events[i & (RING_EVENT_COUNT - 1)];
+	}
+
+	// The writer may have lapped the oldest events while copying.
+	u_atomic_fence_acquire();
+	uint64_t now_count = u_atomic_u64_load_acquire(&ring->count);
+	uint64_t first_valid = now_count >= RING_EVENT_COUNT ? now_count - RING_EVENT_COUNT + 1 : 0;
+
+	uint32_t out_count = 0;
+	for (uint64_t i = begin; i < end; i++) {
+		struct ring_event *e = &out_events[i - begin];
+		if (i < first_valid || e->timestamp_ns < since_ns) {
+			continue;
+		}
+		out_events[out_count++] = *e;
+	}
+
+	return out_count;
+}
+
+static void
+ring_write_dump(const char *reason, uint64_t when_ns)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/monado_trace_%" PRIu64 ".json", debug_get_option_trace_ring_dir(), when_ns);
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		U_LOG_E("Could not open '%s' for the trace dump!", path);
+		return;
+	}
+
+	struct ring_event *events = U_TYPED_ARRAY_CALLOC(struct ring_event, RING_EVENT_COUNT);
+	uint64_t since_ns = when_ns > RING_DUMP_WINDOW_NS ? when_ns - RING_DUMP_WINDOW_NS : 0;
+	bool first = true;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	int32_t thread_count = u_atomic_s32_load_acquire(&g_ring.thread_count);
+	for (int32_t t = 0; t < thread_count && t < RING_MAX_THREADS; t++) {
+		struct thread_ring *ring = (struct thread_ring *)u_atomic_ptr_load_acquire(&g_ring.rings[t]);
+		if (ring == NULL) {
+			continue;
+		}
+
+		char name[RING_THREAD_NAME_LEN];
+		memcpy(name, ring->name, sizeof(name));
+		name[sizeof(name) - 1] = '\0';
+
+		fprintf(file, "%s{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+		        first ? "" : ",\n", ring->index);
+		write_json_string(file, name);
+		fprintf(file, "}}");
+		first = false;
+
+		uint32_t count = ring_snapshot(ring, since_ns, events);
+		for (uint32_t i = 0; i < count; i++) {
+			struct ring_event *e = &events[i];
+			fprintf(file, ",\n{\"ph\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"name\":",
+			        e->type == RING_EVENT_BEGIN ? "B" : "E", ring->index, (double)e->timestamp_ns / 1000.0);
+			write_json_string(file, e->name != NULL ? e->name : "");
+			fprintf(file, "}");
+		}
+	}
+
+	fprintf(file, "%s{\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"name\":", first ? "" : ",\n",
+	        (double)when_ns / 1000.0);
+	write_json_string(file, reason);
+	fprintf(file, "}\n]}\n");
+
+	fclose(file);
+	free(events);
+
+	U_LOG_I("Wrote trace dump '%s' (%s)", path, reason);
+}
+
+static void *
+ring_dumper_mainloop(void *ptr)
+{
+	os_thread_helper_name(&g_ring.dumper, "Trace Ring Dumper");
+	u_thread_role_apply(U_THREAD_ROLE_BACKGROUND, U_LOGGING_WARN, "Trace Ring Dumper");
+
+	os_thread_helper_lock(&g_ring.dumper);
+	while (os_thread_helper_is_running_locked(&g_ring.dumper)) {
+		if (!g_ring.dump_requested) {
+			os_thread_helper_wait_locked(&g_ring.dumper);
+			continue;
+		}
+
+		const char *reason = g_ring.dump_reason;
+		uint64_t when_ns = g_ring.dump_requested_ns;
+		g_ring.dump_requested = false;
+
+		os_thread_helper_unlock(&g_ring.dumper);
+		ring_write_dump(reason, when_ns);
+		os_thread_helper_lock(&g_ring.dumper);
+	}
+	os_thread_helper_unlock(&g_ring.dumper);
+
+	return NULL;
+}
+
+static bool
+ring_dumper_ensure_started(void)
+{
+	int32_t state = u_atomic_s32_load_acquire(&g_ring.dumper_state);
+	if (state == RING_DUMPER_RUNNING) {
+		return true;
+	}
+
+	if (state != RING_DUMPER_OFF) {
+		return false;
+	}
+
+	// Only one thread starts the dumper, others skip their dump until it runs.
+	if (xrt_atomic_s32_cmpxchg(&g_ring.dumper_state, RING_DUMPER_OFF, RING_DUMPER_STARTING) != RING_DUMPER_OFF) {
+		return false;
+	}
+
+	int ret = os_thread_helper_init(&g_ring.dumper);
+	if (ret == 0) {
+		ret = os_thread_helper_start(&g_ring.dumper, ring_dumper_mainloop, NULL);
+	}
+	if (ret != 0) {
+		U_LOG_E("Could not start the trace ring dumper thread!");
+		u_atomic_s32_store_release(&g_ring.dumper_state, RING_DUMPER_FAILED);
+		return false;
+	}
+
+	u_atomic_s32_store_release(&g_ring.dumper_state, RING_DUMPER_RUNNING);
+
+	return true;
+}
+
+const char *
+u_trace_ring_begin(const char *name)
+{
+	ring_push(RING_EVENT_BEGIN, name);
+
+	return name;
+}
+
+void
+u_trace_ring_end(const char *name)
+{
+	ring_push(RING_EVENT_END, name);
+}
+
+void
+u_trace_ring_set_thread_name(const char *name)
+{
+	struct thread_ring *ring = ring_get();
+	if (ring == NULL) {
+		return;
+	}
+
+	snprintf(ring->name, sizeof(ring->name), "%s", name);
+}
+
+void
+u_trace_ring_dump(const char *reason)
+{
+	if (!debug_get_bool_option_trace_ring()) {
+		return;
+	}
+
+	if (!ring_dumper_ensure_started()) {
+		return;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	os_thread_helper_lock(&g_ring.dumper);
+
+	if (g_ring.last_dump_ns == 0 || now_ns - g_ring.last_dump_ns >= RING_DUMP_MIN_INTERVAL_NS) {
+		g_ring.last_dump_ns = now_ns;
+		g_ring.dump_requested = true;
+		g_ring.dump_requested_ns = now_ns;
+		g_ring.dump_reason = reason;
+		os_thread_helper_signal_locked(&g_ring.dumper);
+	}
+
+	os_thread_helper_unlock(&g_ring.dumper);
+}
@@ -87,6 +87,45 @@ u_trace_marker_setup(enum u_trace_which which);
 void
 u_trace_marker_init(void);
 
+/*!
+ * Records the start of a scope in the built-in trace ring, used by the trace
+ * macros when no other tracing backend is compiled in, see @ref tracing.
+ * Returns @p name to make scope cleanup easy. @p name must be a string with
+ * static lifetime.
+ *
+ * @ingroup aux_util
+ */
+const char *
+u_trace_ring_begin(const char *name);
+
+/*!
+ * Records the end of the latest scope begun on this thread, see
+ * @ref u_trace_ring_begin.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_ring_end(const char *name);
+
+/*!
+ * Names the calling thread in trace ring dumps, the string is copied.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_ring_set_thread_name(const char *name);
+
+/*!
+ * Asks for the last few seconds of the trace ring to be written out as a
+ * Chrome/Perfetto JSON file, done on a background thread and rate limited so
+ * it is safe to call from the compositor when a frame is missed. Does nothing
+ * unless enabled with XRT_TRACE_RING.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_ring_dump(const char *reason);
+
 #define COLOR_TRACE_MARKER(COLOR) U_TRACE_FUNC_COLOR(color, COLOR)
 #define COLOR_TRACE_IDENT(IDENT, COLOR) U_TRACE_IDENT_COLOR(color, IDENT, COLOR)
 #define COLOR_TRACE_BEGIN(IDENT, COLOR) U_TRACE_BEGIN_COLOR(color, IDENT, COLOR)
@@ -146,6 +185,46 @@ u_trace_marker_init(void);
 
 #ifndef XRT_FEATURE_TRACING
 
+/*
+ * The built-in trace ring is used, scopes need a destructor or the cleanup
+ * attribute so MSVC C code only gets the explicit begin and end markers.
+ */
+#if defined(__cplusplus)
+
+struct u_trace_ring_scope
+{
+	const char *name;
+
+	u_trace_ring_scope(const char *name_) : name(u_trace_ring_begin(name_)) {}
+	~u_trace_ring_scope()
+	{
+		u_trace_ring_end(name);
+	}
+};
+
+#define U_TRACE_FUNC(CATEGORY) struct u_trace_ring_scope __trace_ring_func(__func__)
+
+#define U_TRACE_IDENT(CATEGORY, IDENT) struct u_trace_ring_scope __trace_ring_##IDENT(#IDENT)
+
+#elif defined(__GNUC__)
+
+static inline void
+u_trace_ring_scope_cleanup(const char **name_ptr)
+{
+	u_trace_ring_end(*name_ptr);
+}
+
+#define U_TRACE_FUNC(CATEGORY)                                                                                         \
+	const char *__trace_ring_func __attribute__((cleanup(u_trace_ring_scope_cleanup))) =                           \
+	    u_trace_ring_begin(__func__);                                                                              \
+	(void)__trace_ring_func
+
+#define U_TRACE_IDENT(CATEGORY, IDENT)                                                                                 \
+	const char *__trace_ring_##IDENT __attribute__((cleanup(u_trace_ring_scope_cleanup))) =                        \
+	    u_trace_ring_begin(#IDENT);                                                                                \
+	(void)__trace_ring_##IDENT
+
+#else // !__cplusplus && !__GNUC__
 
 #define U_TRACE_FUNC(CATEGORY)                                                                                         \
 	do {                                                                                                           \
@@ -155,14 +234,16 @@ u_trace_marker_init(void);
 	do {                                                                                                           \
 	} while (false)
 
+#endif // !__cplusplus && !__GNUC__
+
 #define U_TRACE_BEGIN(CATEGORY, IDENT)                                                                                 \
-	int __trace_##IDENT = 0; /* To ensure they are balanced */                                                     \
+	const char *__trace_##IDENT = u_trace_ring_begin(#IDENT); /* To ensure they are balanced */                    \
 	do {                                                                                                           \
 	} while (false)
 
 #define U_TRACE_END(CATEGORY, IDENT)                                                                                   \
 	do {                                                                                                           \
-		(void)__trace_##IDENT; /* To ensure they are balanced */                                               \
+		u_trace_ring_end(__trace_##IDENT); /* To ensure they are balanced */                                   \
 	} while (false)
 
 #define U_TRACE_EVENT_BEGIN_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                      \
@@ -185,7 +266,7 @@ u_trace_marker_init(void);
 
 #define U_TRACE_SET_THREAD_NAME(STRING)                                                                                \
 	do {                                                                                                           \
-		(void)STRING;                                                                                          \
+		u_trace_ring_set_thread_name(STRING);                                                                  \
 	} while (false)
 
 /*!
@@ -1,4 +1,4 @@
-// Copyright 2019-2022, Collabora, Ltd.
+// Copyright 2019-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -10,12 +10,15 @@
 #include "util/u_var.h"
 #include "util/u_debug.h"
 
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <unordered_map>
 
 
+#ifdef XRT_FEATURE_VARIABLE_TRACKING
+
 namespace xrt::auxiliary::util {
 
 
@@ -52,8 +55,19 @@ public:
 class Tracker
 {
 public:
+	//! Protects the maps and the cache below, recursive as the visit callbacks may add variables.
+	std::recursive_mutex mutex = {};
 	std::unordered_map<std::string, uint32_t> counters = {};
 	std::unordered_map<ptrdiff_t, Obj> map = {};
+
+	/*!
+	 * Variables are added in bursts to the same root, cache the last
+	 * looked up object to skip the hashmap lookup. Pointers into the map
+	 * are stable until the element is erased.
+	 */
+	ptrdiff_t last_root = 0;
+	Obj *last_obj = nullptr;
+
 	bool on = false;
 	bool tested = false;
 
@@ -67,6 +81,24 @@ public:
 
 		return count;
 	}
+
+	Obj *
+	find(ptrdiff_t root)
+	{
+		if (last_obj != nullptr && last_root == root) {
+			return last_obj;
+		}
+
+		auto s = map.find(root);
+		if (s == map.end()) {
+			return nullptr;
+		}
+
+		last_root = root;
+		last_obj = &s->second;
+
+		return last_obj;
+	}
 };
 
 /*!
@@ -96,17 +128,17 @@ get_on()
 static void
 add_var(void *root, void *ptr, u_var_kind kind, const char *c_name)
 {
-	auto s = gTracker.map.find((ptrdiff_t)root);
-	if (s == gTracker.map.end()) {
+	std::unique_lock<std::recursive_mutex> lock(gTracker.mutex);
+
+	Obj *obj = gTracker.find((ptrdiff_t)root);
+	if (obj == nullptr) {
 		return;
 	}
 
-	Var var;
+	Var &var = obj->vars.emplace_back();
 	snprintf(var.info.name, U_VAR_NAME_STRING_SIZE, "%s", c_name);
 	var.info.kind = kind;
 	var.info.ptr = ptr;
-
-	s->second.vars.push_back(var);
 }
 
 
@@ -134,6 +166,8 @@ u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
 	auto raw_name = name;
 	uint32_t count = 0; // Zero means no number.
 
+	std::unique_lock<std::recursive_mutex> lock(gTracker.mutex);
+
 	if (suffix_with_number) {
 		count = gTracker.getNumber(name);
 
@@ -148,6 +182,9 @@ u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
 	obj.info.name = obj.name.c_str();
 	obj.info.raw_name = obj.raw_name.c_str();
 	obj.info.number = count;
+
+	gTracker.last_root = (ptrdiff_t)root;
+	gTracker.last_obj = &obj;
 }
 
 extern "C" void
@@ -157,11 +194,17 @@ u_var_remove_root(void *root)
 		return;
 	}
 
+	std::unique_lock<std::recursive_mutex> lock(gTracker.mutex);
+
 	auto s = gTracker.map.find((ptrdiff_t)root);
 	if (s == gTracker.map.end()) {
 		return;
 	}
 
+	if (gTracker.last_obj == &s->second) {
+		gTracker.last_obj = nullptr;
+	}
+
 	gTracker.map.erase(s);
 }
 
@@ -172,6 +215,8 @@ u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb,
 		return;
 	}
 
+	std::unique_lock<std::recursive_mutex> lock(gTracker.mutex);
+
 	std::vector<Obj *> tmp;
 	tmp.reserve(gTracker.map.size());
 
@@ -204,3 +249,5 @@ U_VAR_ADD_FUNCS()
 #undef ADD_FUNC
 
 } // namespace xrt::auxiliary::util
+
+#endif // XRT_FEATURE_VARIABLE_TRACKING
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "xrt/xrt_config_build.h"
 #include "xrt/xrt_defines.h" // IWYU pragma: keep
 
 #include "util/u_logging.h"
@@ -309,6 +310,8 @@ typedef void (*u_var_root_cb)(struct u_var_root_info *info, void *);
  */
 typedef void (*u_var_elm_cb)(struct u_var_info *info, void *);
 
+#ifdef XRT_FEATURE_VARIABLE_TRACKING
+
 /*!
  * Add a named root object, the u_var subsystem is completely none-invasive
  * to the object it's tracking. The root pointer is used as a entry into a
@@ -333,6 +336,9 @@ typedef void (*u_var_elm_cb)(struct u_var_info *info, void *);
  * u_var_remove_root((void*)psmv);
  * ```
  *
+ * When built without @ref XRT_FEATURE_VARIABLE_TRACKING all of the functions
+ * are empty inline stubs, so none of the calls cost anything.
+ *
  * @param root               Object to be tracked.
  * @param c_name             Name of object, null terminated "C" string.
  * @param suffix_with_number Should name be suffixed with a number.
@@ -366,6 +372,38 @@ u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb,
 void
 u_var_force_on(void);
 
+#else // !XRT_FEATURE_VARIABLE_TRACKING
+
+static inline void
+u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
+{
+	(void)root;
+	(void)c_name;
+	(void)suffix_with_number;
+}
+
+static inline void
+u_var_remove_root(void *root)
+{
+	(void)root;
+}
+
+static inline void
+u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb, void *priv)
+{
+	(void)enter_cb;
+	(void)exit_cb;
+	(void)elem_cb;
+	(void)priv;
+}
+
+static inline void
+u_var_force_on(void)
+{
+}
+
+#endif // !XRT_FEATURE_VARIABLE_TRACKING
+
 #define U_VAR_ADD_FUNCS()                                                                                              \
 	ADD_FUNC(bool, bool, BOOL)                                                                                     \
 	ADD_FUNC(rgb_u8, struct xrt_colour_rgb_u8, RGB_U8)                                                             \
@@ -409,7 +447,17 @@ u_var_force_on(void);
 	ADD_FUNC(curve, struct u_var_curve, CURVE)                                                                     \
 	ADD_FUNC(curves, struct u_var_curves, CURVES)
 
+#ifdef XRT_FEATURE_VARIABLE_TRACKING
 #define ADD_FUNC(SUFFIX, TYPE, ENUM) void u_var_add_##SUFFIX(void *, TYPE *, const char *);
+#else
+#define ADD_FUNC(SUFFIX, TYPE, ENUM)                                                                                   \
+	static inline void u_var_add_##SUFFIX(void *obj, TYPE *ptr, const char *c_name)                                \
+	{                                                                                                              \
+		(void)obj;                                                                                             \
+		(void)ptr;                                                                                             \
+		(void)c_name;                                                                                          \
+	}
+#endif
 
 U_VAR_ADD_FUNCS()
 
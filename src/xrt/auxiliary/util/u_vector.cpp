@@ -1,40 +1,171 @@
-// Copyright 2022, Collabora, Ltd.
+// Copyright 2022-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
- * @brief  Expose std::vector to C
+ * @brief  Expose a small buffer optimised vector to C
  * @author Mateo de Mayo <mateo.demayo@collabora.com>
  * @ingroup aux_util
  */
 
 #include "u_vector.h"
-#include <vector>
+#include "u_arena.h"
 
-using std::vector;
+#include <new>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace {
+
+/*!
+ * Vector that starts out with inline storage, only growing allocates and
+ * clearing keeps the capacity. When given an arena all growing is done from
+ * it, the old storage is given back when the arena is reset.
+ */
+template <typename T> class small_vector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only for plain old data");
+
+public:
+	small_vector() = default;
+
+	explicit small_vector(u_arena *arena) : mArena(arena) {}
+
+	bool
+	in_arena() const
+	{
+		return mArena != nullptr;
+	}
+
+	void
+	push_back(T e)
+	{
+		if (mSize == mCapacity) {
+			reserve(mCapacity * 2);
+		}
+		mData[mSize++] = e;
+	}
+
+	T
+	at(size_t i) const
+	{
+		if (i >= mSize) {
+			throw std::out_of_range("small_vector::at");
+		}
+		return mData[i];
+	}
+
+	size_t
+	size() const
+	{
+		return mSize;
+	}
+
+	void
+	clear()
+	{
+		mSize = 0;
+	}
+
+	void
+	reserve(size_t capacity)
+	{
+		if (capacity <= mCapacity) {
+			return;
+		}
+
+		if (mArena != nullptr) {
+			T *storage = U_ARENA_TYPED_ARRAY_CALLOC(mArena, T, capacity);
+			if (storage == nullptr) {
+				throw std::bad_alloc();
+			}
+			copy_to(storage);
+			mData = storage;
+		} else {
+			std::unique_ptr<T[]> storage(new T[capacity]);
+			copy_to(storage.get());
+			mHeap = std::move(storage);
+			mData = mHeap.get();
+		}
+
+		mCapacity = capacity;
+	}
+
+private:
+	void
+	copy_to(T *storage) const
+	{
+		for (size_t i = 0; i < mSize; i++) {
+			storage[i] = mData[i];
+		}
+	}
+
+	T mInline[U_VECTOR_INLINE_CAPACITY];
+	u_arena *mArena = nullptr;
+	std::unique_ptr<T[]> mHeap;
+	T *mData = mInline;
+	size_t mCapacity = U_VECTOR_INLINE_CAPACITY;
+	size_t mSize = 0;
+};
+
+} // namespace
 
 #define U_VECTOR_IMPLEMENTATION(TYPE)                                                                                  \
 	u_vector_##TYPE u_vector_##TYPE##_create()                                                                     \
 	{                                                                                                              \
-		u_vector_##TYPE uv{new vector<TYPE>};                                                                  \
+		u_vector_##TYPE uv{new small_vector<TYPE>};                                                            \
+		return uv;                                                                                             \
+	}                                                                                                              \
+                                                                                                                       \
+	u_vector_##TYPE u_vector_##TYPE##_create_in_arena(u_arena *arena)                                              \
+	{                                                                                                              \
+		void *mem = u_arena_alloc(arena, sizeof(small_vector<TYPE>), alignof(small_vector<TYPE>));             \
+		if (mem == nullptr) {                                                                                  \
+			throw std::bad_alloc();                                                                        \
+		}                                                                                                      \
+		u_vector_##TYPE uv{new (mem) small_vector<TYPE>(arena)};                                               \
 		return uv;                                                                                             \
 	}                                                                                                              \
                                                                                                                        \
 	void u_vector_##TYPE##_push_back(u_vector_##TYPE uv, TYPE e)                                                   \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv.ptr);                                                 \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv.ptr);                                     \
 		v->push_back(e);                                                                                       \
 	}                                                                                                              \
                                                                                                                        \
 	TYPE u_vector_##TYPE##_at(u_vector_##TYPE uv, size_t i)                                                        \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv.ptr);                                                 \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv.ptr);                                     \
 		return v->at(i);                                                                                       \
 	}                                                                                                              \
                                                                                                                        \
+	size_t u_vector_##TYPE##_size(u_vector_##TYPE uv)                                                              \
+	{                                                                                                              \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv.ptr);                                     \
+		return v->size();                                                                                      \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_vector_##TYPE##_reserve(u_vector_##TYPE uv, size_t capacity)                                            \
+	{                                                                                                              \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv.ptr);                                     \
+		v->reserve(capacity);                                                                                  \
+	}                                                                                                              \
+                                                                                                                       \
+	void u_vector_##TYPE##_clear(u_vector_##TYPE uv)                                                               \
+	{                                                                                                              \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv.ptr);                                     \
+		v->clear();                                                                                            \
+	}                                                                                                              \
+                                                                                                                       \
 	void u_vector_##TYPE##_destroy(u_vector_##TYPE *uv)                                                            \
 	{                                                                                                              \
-		vector<TYPE> *v = static_cast<vector<TYPE> *>(uv->ptr);                                                \
-		delete v;                                                                                              \
+		small_vector<TYPE> *v = static_cast<small_vector<TYPE> *>(uv->ptr);                                    \
+		if (v->in_arena()) {                                                                                   \
+			v->~small_vector<TYPE>();                                                                      \
+		} else {                                                                                               \
+			delete v;                                                                                      \
+		}                                                                                                      \
 		uv->ptr = nullptr;                                                                                     \
 	}
 
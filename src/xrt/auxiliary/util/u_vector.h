@@ -15,14 +15,35 @@
 extern "C" {
 #endif
 
+struct u_arena;
+
+/*!
+ * Number of elements a vector holds before allocating more memory, clearing
+ * keeps the storage so it can be reused for scratch data every frame.
+ */
+#define U_VECTOR_INLINE_CAPACITY (16)
+
+/*!
+ * Declares a vector of a plain old data type, only allocating when growing
+ * past the inline or reserved capacity.
+ *
+ * A vector made with `_create_in_arena` lives in the given @ref u_arena and
+ * takes any storage it grows into from there too, so it never touches the
+ * heap. It is only valid until the arena is reset, calling `_destroy` on it is
+ * allowed but not needed.
+ */
 #define U_VECTOR_DECLARATION(TYPE)                                                                                     \
 	struct u_vector_##TYPE                                                                                         \
 	{                                                                                                              \
 		void *ptr;                                                                                             \
 	};                                                                                                             \
 	struct u_vector_##TYPE u_vector_##TYPE##_create();                                                             \
+	struct u_vector_##TYPE u_vector_##TYPE##_create_in_arena(struct u_arena *arena);                               \
 	void u_vector_##TYPE##_push_back(struct u_vector_##TYPE uv, TYPE e);                                           \
 	TYPE u_vector_##TYPE##_at(struct u_vector_##TYPE uv, size_t i);                                                \
+	size_t u_vector_##TYPE##_size(struct u_vector_##TYPE uv);                                                      \
+	void u_vector_##TYPE##_reserve(struct u_vector_##TYPE uv, size_t capacity);                                    \
+	void u_vector_##TYPE##_clear(struct u_vector_##TYPE uv);                                                       \
 	void u_vector_##TYPE##_destroy(struct u_vector_##TYPE *uv);
 
 U_VECTOR_DECLARATION(int)
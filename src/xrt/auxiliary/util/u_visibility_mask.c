@@ -38,6 +38,70 @@ static const struct xrt_vec2 vertices_line[] = {
 
 static const uint32_t indices_line[] = {0, 1, 2, 3, 4, 5, 6, 7};
 
+//! Samples along each side of a grid cell, including the edges.
+#define CELL_SAMPLES (5)
+
+static bool
+is_point_in_triangle(struct xrt_vec2 p, struct xrt_vec2 a, struct xrt_vec2 b, struct xrt_vec2 c)
+{
+	float d0 = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+	float d1 = (c.x - b.x) * (p.y - b.y) - (c.y - b.y) * (p.x - b.x);
+	float d2 = (a.x - c.x) * (p.y - c.y) - (a.y - c.y) * (p.x - c.x);
+
+	// Either winding order, points on the edges count as inside.
+	bool has_neg = d0 < 0.0f || d1 < 0.0f || d2 < 0.0f;
+	bool has_pos = d0 > 0.0f || d1 > 0.0f || d2 > 0.0f;
+
+	return !(has_neg && has_pos);
+}
+
+static bool
+is_point_hidden(const struct xrt_visibility_mask *mask, const struct xrt_vec2 *uvs, struct xrt_vec2 p)
+{
+	const uint32_t *indices = xrt_visibility_mask_get_indices(mask);
+
+	for (uint32_t i = 0; i + 2 < mask->index_count; i += 3) {
+		uint32_t i0 = indices[i + 0];
+		uint32_t i1 = indices[i + 1];
+		uint32_t i2 = indices[i + 2];
+
+		if (i0 >= mask->vertex_count || i1 >= mask->vertex_count || i2 >= mask->vertex_count) {
+			continue;
+		}
+
+		if (is_point_in_triangle(p, uvs[i0], uvs[i1], uvs[i2])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+is_cell_hidden(const struct xrt_visibility_mask *mask, const struct xrt_vec2 *uvs, uint32_t x, uint32_t y)
+{
+	const float cell_size = 1.0f / (float)U_VISIBILITY_MASK_GRID_SIZE;
+
+	// Pull the samples on the edges in a tiny bit, keeps rounding from failing edges shared with the view.
+	const float inset = 0.001f;
+	const float step = (1.0f - 2.0f * inset) / (CELL_SAMPLES - 1);
+
+	for (uint32_t sy = 0; sy < CELL_SAMPLES; sy++) {
+		for (uint32_t sx = 0; sx < CELL_SAMPLES; sx++) {
+			struct xrt_vec2 p = {
+			    ((float)x + inset + (float)sx * step) * cell_size,
+			    ((float)y + inset + (float)sy * step) * cell_size,
+			};
+
+			if (!is_point_hidden(mask, uvs, p)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 void
 u_visibility_mask_get_default(enum xrt_visibility_mask_type type,
                               const struct xrt_fov *fov,
@@ -122,3 +186,52 @@ u_visibility_mask_get_default(enum xrt_visibility_mask_type type,
 out:
 	*out_mask = mask; // Always NULL or allocated data.
 }
+
+void
+u_visibility_mask_get_hidden_grid(const struct xrt_visibility_mask *mask,
+                                  const struct xrt_fov *fov,
+                                  uint32_t out_rows[U_VISIBILITY_MASK_GRID_SIZE])
+{
+	for (uint32_t y = 0; y < U_VISIBILITY_MASK_GRID_SIZE; y++) {
+		out_rows[y] = 0;
+	}
+
+	if (mask == NULL || mask->vertex_count == 0 || mask->index_count < 3) {
+		return;
+	}
+
+	const double tan_left = tan(fov->angle_left);
+	const double tan_right = tan(fov->angle_right);
+	const double tan_down = tan(fov->angle_down);
+	const double tan_up = tan(fov->angle_up);
+
+	const double tan_width = tan_right - tan_left;
+	const double tan_height = tan_up - tan_down;
+
+	if (tan_width <= 0.0 || tan_height <= 0.0) {
+		return;
+	}
+
+	struct xrt_vec2 *uvs = U_TYPED_ARRAY_CALLOC(struct xrt_vec2, mask->vertex_count);
+	if (uvs == NULL) {
+		U_LOG_E("failed to allocate visibility mask uvs");
+		return;
+	}
+
+	// The mask has y going down from -tan_up to -tan_down, same as view uv.
+	const struct xrt_vec2 *vertices = xrt_visibility_mask_get_vertices(mask);
+	for (uint32_t i = 0; i < mask->vertex_count; i++) {
+		uvs[i].x = (float)((vertices[i].x - tan_left) / tan_width);
+		uvs[i].y = (float)((vertices[i].y + tan_up) / tan_height);
+	}
+
+	for (uint32_t y = 0; y < U_VISIBILITY_MASK_GRID_SIZE; y++) {
+		for (uint32_t x = 0; x < U_VISIBILITY_MASK_GRID_SIZE; x++) {
+			if (is_cell_hidden(mask, uvs, x, y)) {
+				out_rows[y] |= 1u << x;
+			}
+		}
+	}
+
+	free(uvs);
+}
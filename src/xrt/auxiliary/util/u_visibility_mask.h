@@ -16,6 +16,9 @@ extern "C" {
 #endif
 
 
+//! Number of cells along each side of the grid from @ref u_visibility_mask_get_hidden_grid.
+#define U_VISIBILITY_MASK_GRID_SIZE (32)
+
 /*!
  * Default visibility mask, only returns a very simple mask with four small
  * triangles in each corner, scaled to the given FoV so it matches the OpenXR
@@ -29,6 +32,24 @@ u_visibility_mask_get_default(enum xrt_visibility_mask_type type,
                               const struct xrt_fov *fov,
                               struct xrt_visibility_mask **out_mask);
 
+/*!
+ * Rasterise a hidden triangle mesh into a coarse grid over the view, in view
+ * uv space where (0, 0) is the top left of the view. A cell is only marked as
+ * hidden if it is completely covered by the mesh, so the grid can be used to
+ * skip rendering without ever touching visible pixels. Each row is a bitmask
+ * where bit x is set if cell x of that row is hidden.
+ *
+ * @param      mask     Mask of type @ref XRT_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH.
+ * @param      fov      FoV the mask was scaled to.
+ * @param[out] out_rows One bitmask per row of the grid, all zero if nothing is hidden.
+ *
+ * @ingroup aux_util
+ */
+void
+u_visibility_mask_get_hidden_grid(const struct xrt_visibility_mask *mask,
+                                  const struct xrt_fov *fov,
+                                  uint32_t out_rows[U_VISIBILITY_MASK_GRID_SIZE]);
+
 
 #ifdef __cplusplus
 }
@@ -298,3 +298,40 @@ u_win_try_privilege_or_priority_from_args(enum u_logging_level log_level, int ar
 		u_win_raise_cpu_priority(log_level);
 	}
 }
+
+bool
+u_win_try_to_set_thread_priority(enum u_logging_level log_level, const char *name, int priority)
+{
+	char buf[512];
+
+	// Always succeeds, pseudo handle, no need to close it.
+	HANDLE hThread = GetCurrentThread();
+
+	if (!SetThreadPriority(hThread, priority)) {
+		LOG_W("SetThreadPriority(%i) for thread '%s': '%s'", priority, name, GET_LAST_ERROR_STR(buf));
+		return false;
+	}
+
+	LOG_I("Set priority of thread '%s' to %i", name, priority);
+
+	return true;
+}
+
+bool
+u_win_try_to_set_thread_affinity(enum u_logging_level log_level, const char *name, uint64_t cpu_mask)
+{
+	char buf[512];
+
+	// Always succeeds, pseudo handle, no need to close it.
+	HANDLE hThread = GetCurrentThread();
+
+	if (SetThreadAffinityMask(hThread, (DWORD_PTR)cpu_mask) == 0) {
+		LOG_W("SetThreadAffinityMask(0x%llx) for thread '%s': '%s'", (unsigned long long)cpu_mask, name,
+		      GET_LAST_ERROR_STR(buf));
+		return false;
+	}
+
+	LOG_I("Set CPU affinity of thread '%s' to 0x%llx", name, (unsigned long long)cpu_mask);
+
+	return true;
+}
@@ -66,6 +66,28 @@ u_win_raise_cpu_priority(enum u_logging_level log_level);
 void
 u_win_try_privilege_or_priority_from_args(enum u_logging_level log_level, int argc, char *argv[]);
 
+/*!
+ * Tries to set the priority of the calling thread, one of the
+ * `THREAD_PRIORITY_*` values. How high it can go depends on the priority class
+ * of the process, see @ref u_win_raise_cpu_priority.
+ *
+ * @param log_level Control the amount of logging this function does.
+ * @param name      Thread name to be used in logging.
+ * @param priority  Value to pass to `SetThreadPriority`.
+ */
+bool
+u_win_try_to_set_thread_priority(enum u_logging_level log_level, const char *name, int priority);
+
+/*!
+ * Tries to restrict the calling thread to the given CPUs.
+ *
+ * @param log_level Control the amount of logging this function does.
+ * @param name      Thread name to be used in logging.
+ * @param cpu_mask  Bit per CPU the thread may run on, within the thread's processor group.
+ */
+bool
+u_win_try_to_set_thread_affinity(enum u_logging_level log_level, const char *name, uint64_t cpu_mask);
+
 
 #ifdef __cplusplus
 }
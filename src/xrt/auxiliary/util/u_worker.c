@@ -10,13 +10,21 @@
 
 #include "os/os_threading.h"
 
+#include "util/u_misc.h"
+#include "util/u_atomic.h"
 #include "util/u_logging.h"
 #include "util/u_worker.h"
 #include "util/u_trace_marker.h"
 
 
 #define MAX_TASK_COUNT (64)
-#define MAX_THREAD_COUNT (16)
+
+/*!
+ * How many times an idle worker checks for new tasks before parking on the
+ * condition variable, short tasks pushed back to back are then picked up
+ * without a wakeup.
+ */
+#define SPIN_COUNT (4096)
 
 struct group;
 struct pool;
@@ -58,6 +66,9 @@ struct pool
 	//! Number of tasks in array.
 	size_t tasks_in_array_count;
 
+	//! Mirrors tasks_in_array_count, written under the mutex but read without it by spinning workers.
+	xrt_atomic_s32_t tasks_in_array_hint;
+
 	struct
 	{
 		size_t count;
@@ -76,8 +87,8 @@ struct pool
 	//! Number of created threads.
 	size_t thread_count;
 
-	//! The worker threads.
-	struct thread threads[MAX_THREAD_COUNT];
+	//! The worker threads, thread_count of them.
+	struct thread *threads;
 
 	//! Is the pool up and running?
 	bool running;
@@ -133,6 +144,15 @@ pool(struct u_worker_thread_pool *uwtp)
  *
  */
 
+static void
+locked_pool_take_task(struct pool *p, size_t index, struct task *out_task)
+{
+	*out_task = p->tasks[index];
+	p->tasks[index] = (struct task){NULL, NULL, NULL};
+	p->tasks_in_array_count--;
+	u_atomic_s32_store_relaxed(&p->tasks_in_array_hint, (int32_t)p->tasks_in_array_count);
+}
+
 static void
 locked_pool_pop_task(struct pool *p, struct task *out_task)
 {
@@ -143,15 +163,36 @@ locked_pool_pop_task(struct pool *p, struct task *out_task)
 			continue;
 		}
 
-		*out_task = p->tasks[i];
-		p->tasks[i] = (struct task){NULL, NULL, NULL};
-		p->tasks_in_array_count--;
+		locked_pool_take_task(p, i, out_task);
 		return;
 	}
 
 	assert(false);
 }
 
+/*!
+ * Pop a task that was submitted from @p g, if any is still waiting to be
+ * started, used by a thread waiting on that group to help out.
+ */
+static bool
+locked_pool_pop_group_task(struct pool *p, struct group *g, struct task *out_task)
+{
+	if (p->tasks_in_array_count == 0) {
+		return false;
+	}
+
+	for (size_t i = 0; i < MAX_TASK_COUNT; i++) {
+		if (p->tasks[i].func == NULL || p->tasks[i].g != g) {
+			continue;
+		}
+
+		locked_pool_take_task(p, i, out_task);
+		return true;
+	}
+
+	return false;
+}
+
 static void
 locked_pool_push_task(struct pool *p, struct group *g, u_worker_group_func_t func, void *data)
 {
@@ -164,6 +205,7 @@ locked_pool_push_task(struct pool *p, struct group *g, u_worker_group_func_t fun
 
 		p->tasks[i] = (struct task){g, func, data};
 		p->tasks_in_array_count++;
+		u_atomic_s32_store_relaxed(&p->tasks_in_array_hint, (int32_t)p->tasks_in_array_count);
 		g->current_submitted_tasks_count++;
 		return;
 	}
@@ -322,6 +364,30 @@ locked_thread_allowed_to_work(struct pool *p)
 	return true;
 }
 
+/*!
+ * Spin for a short while without the mutex, hoping for a task to be pushed,
+ * before the thread parks itself on the condition variable. Returns with the
+ * mutex held again.
+ */
+static void
+locked_thread_spin_for_work(struct pool *p)
+{
+	// Other threads are using all of the allowed slots, no point in spinning.
+	if (p->working_count >= p->worker_limit) {
+		return;
+	}
+
+	os_mutex_unlock(&p->mutex);
+
+	for (uint32_t i = 0; i < SPIN_COUNT; i++) {
+		if (u_atomic_s32_load_relaxed(&p->tasks_in_array_hint) > 0) {
+			break;
+		}
+	}
+
+	os_mutex_lock(&p->mutex);
+}
+
 static void
 locked_thread_wait_for_work(struct pool *p)
 {
@@ -349,7 +415,12 @@ run_func(void *ptr)
 	while (p->running) {
 
 		if (!locked_thread_allowed_to_work(p)) {
-			locked_thread_wait_for_work(p);
+			locked_thread_spin_for_work(p);
+
+			// Only park if spinning didn't turn up anything.
+			if (p->running && !locked_thread_allowed_to_work(p)) {
+				locked_thread_wait_for_work(p);
+			}
 
 			// Check running first when woken up.
 			continue;
@@ -406,12 +477,8 @@ u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_coun
 		return NULL;
 	}
 
-	assert(thread_count <= MAX_THREAD_COUNT);
-	if (thread_count > MAX_THREAD_COUNT) {
-		return NULL;
-	}
-
 	struct pool *p = U_TYPED_CALLOC(struct pool);
+	p->threads = U_TYPED_ARRAY_CALLOC(struct thread, thread_count);
 	p->base.reference.count = 1;
 	p->initial_worker_limit = starting_worker_count;
 	p->worker_limit = starting_worker_count;
@@ -442,6 +509,7 @@ err_mutex:
 	os_mutex_destroy(&p->mutex);
 
 err_alloc:
+	free(p->threads);
 	free(p);
 
 	return NULL;
@@ -469,6 +537,7 @@ u_worker_thread_pool_destroy(struct u_worker_thread_pool *uwtp)
 	os_mutex_destroy(&p->mutex);
 	os_cond_destroy(&p->available.cond);
 
+	free(p->threads);
 	free(p);
 }
 
@@ -531,6 +600,19 @@ u_worker_group_wait_all(struct u_worker_group *uwg)
 
 	os_mutex_lock(&p->mutex);
 
+	// Rather than just blocking, run our own tasks that haven't been started yet.
+	struct task task = {NULL, NULL, NULL};
+	while (locked_pool_pop_group_task(p, g, &task)) {
+		os_mutex_unlock(&p->mutex);
+		task.func(task.data);
+		os_mutex_lock(&p->mutex);
+
+		g->current_submitted_tasks_count--;
+
+		// Other threads might be waiting on this group too.
+		locked_group_wake_waiter_if_allowed(p, g);
+	}
+
 	// Can we early out?
 	if (!locked_group_should_enter_wait_loop(p, g)) {
 		os_mutex_unlock(&p->mutex);
@@ -18,3 +18,65 @@ xrt::auxiliary::util::TaskCollection::cCallback(void *data_ptr)
 	f();
 	f = nullptr;
 }
+
+xrt::auxiliary::util::TaskGraph::NodeId
+xrt::auxiliary::util::TaskGraph::add(Functor func, std::initializer_list<NodeId> dependencies)
+{
+	assert(!mDispatched);
+
+	NodeId id = mNodes.size();
+	Node &node = mNodes.emplace_back();
+	node.graph = this;
+	node.func = std::move(func);
+	node.dependency_count = (uint32_t)dependencies.size();
+	node.remaining.store(node.dependency_count, std::memory_order_relaxed);
+
+	for (NodeId dep : dependencies) {
+		assert(dep < id);
+		mNodes[dep].successors.push_back(&node);
+	}
+
+	return id;
+}
+
+void
+xrt::auxiliary::util::TaskGraph::dispatch()
+{
+	if (mDispatched) {
+		return;
+	}
+	mDispatched = true;
+
+	for (Node &node : mNodes) {
+		if (node.dependency_count == 0) {
+			u_worker_group_push(mGroup, &cCallback, &node);
+		}
+	}
+}
+
+void
+xrt::auxiliary::util::TaskGraph::waitAll()
+{
+	if (mGroup == nullptr) {
+		return;
+	}
+	dispatch();
+
+	// Successors are pushed before their predecessor completes, so the group never runs dry early.
+	u_worker_group_wait_all(mGroup);
+	u_worker_group_reference(&mGroup, nullptr);
+}
+
+void
+xrt::auxiliary::util::TaskGraph::cCallback(void *data_ptr)
+{
+	auto &node = *static_cast<Node *>(data_ptr);
+	node.func();
+	node.func = nullptr;
+
+	for (Node *successor : node.successors) {
+		if (successor->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			u_worker_group_push(node.graph->mGroup, &cCallback, successor);
+		}
+	}
+}
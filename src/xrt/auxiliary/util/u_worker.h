@@ -130,6 +130,9 @@ u_worker_group_push(struct u_worker_group *uwg, u_worker_group_func_t f, void *d
  * Wait for all pushed tasks to be completed, "donates" this thread to the
  * shared thread pool.
  *
+ * Tasks of this group that no worker has started yet are run on the calling
+ * thread first, only then does it block for the ones already running.
+ *
  * @ingroup aux_util
  */
 void
@@ -12,14 +12,20 @@
 
 #include "util/u_worker.h"
 
+#include <deque>
+#include <atomic>
 #include <vector>
 #include <cassert>
+#include <algorithm>
 #include <functional>
+#include <type_traits>
+#include <initializer_list>
 
 
 namespace xrt::auxiliary::util {
 
 class TaskCollection;
+class TaskGraph;
 class SharedThreadGroup;
 
 /*!
@@ -105,7 +111,24 @@ public:
 		u_worker_group_reference(&mGroup, nullptr);
 	}
 
+	/*!
+	 * Calls @p func with consecutive chunks `[chunk_begin, chunk_end)` of
+	 * `[begin, end)`, each at most @p grain long, spread over the pool.
+	 * This thread helps out and it returns once all chunks are done.
+	 *
+	 * Only a handful of tasks are pushed no matter how many chunks there
+	 * are, they pull chunks off a shared counter, so nothing is allocated
+	 * per chunk or per element.
+	 *
+	 * @note This waits for every task pushed to this group, not just the
+	 * chunks.
+	 */
+	template <typename Func>
+	void
+	parallelFor(size_t begin, size_t end, size_t grain, Func &&func);
+
 	friend TaskCollection;
+	friend TaskGraph;
 
 	// No default constructor.
 	SharedThreadGroup() = delete;
@@ -188,4 +211,153 @@ private:
 	cCallback(void *data_ptr);
 };
 
+/*!
+ * A one shot graph of tasks with dependencies between them, a task is pushed
+ * to the pool once all the tasks it depends on have completed. Lets a single
+ * task fan out to several continuations and several tasks fan in to one.
+ *
+ * All tasks must be added before calling @ref dispatch. Continuations are
+ * pushed from the worker threads and the pool only queues a limited number of
+ * tasks, so keep the number of tasks that can become ready at once small.
+ *
+ * @ingroup aux_util
+ */
+class TaskGraph
+{
+public:
+	typedef std::function<void()> Functor;
+	typedef size_t NodeId;
+
+
+private:
+	struct Node
+	{
+		TaskGraph *graph;
+		Functor func;
+		std::vector<Node *> successors;
+		std::atomic<uint32_t> remaining;
+		uint32_t dependency_count;
+	};
+
+	//! A deque so nodes never move, tasks in flight point to them.
+	std::deque<Node> mNodes;
+	u_worker_group *mGroup = nullptr;
+	bool mDispatched = false;
+
+
+public:
+	explicit TaskGraph(SharedThreadGroup const &stg)
+	{
+		u_worker_group_reference(&mGroup, stg.mGroup);
+	}
+
+	~TaskGraph()
+	{
+		// Also unreferences the group.
+		waitAll();
+	}
+
+	/*!
+	 * Add a task that runs after all of @p dependencies have completed,
+	 * dependencies must have been added before.
+	 */
+	NodeId
+	add(Functor func, std::initializer_list<NodeId> dependencies = {});
+
+	/*!
+	 * Push all tasks without dependencies, the rest follow as they become
+	 * ready. Does not wait.
+	 */
+	void
+	dispatch();
+
+	/*!
+	 * Waits for all tasks in the graph to complete, also frees the group.
+	 * Dispatches the graph first if that hasn't been done.
+	 */
+	void
+	waitAll();
+
+
+	// Do not move or copy the task graph.
+	TaskGraph(TaskGraph const &) = delete;
+	TaskGraph(TaskGraph &&) = delete;
+	TaskGraph &
+	operator=(TaskGraph const &) = delete;
+	TaskGraph &
+	operator=(TaskGraph &&) = delete;
+
+
+private:
+	static void
+	cCallback(void *data_ptr);
+};
+
+
+/*
+ *
+ * Template implementations.
+ *
+ */
+
+namespace detail {
+
+	//! Shared by all of the tasks of a single @ref SharedThreadGroup::parallelFor call.
+	template <typename Func> struct ParallelForState
+	{
+		size_t begin;
+		size_t end;
+		size_t grain;
+		size_t chunk_count;
+		Func &func;
+		std::atomic<size_t> next_chunk;
+
+		static void
+		cCallback(void *data_ptr)
+		{
+			auto &state = *static_cast<ParallelForState *>(data_ptr);
+
+			size_t chunk;
+			while ((chunk = state.next_chunk.fetch_add(1, std::memory_order_relaxed)) < state.chunk_count) {
+				size_t chunk_begin = state.begin + chunk * state.grain;
+				size_t chunk_end = std::min(chunk_begin + state.grain, state.end);
+				state.func(chunk_begin, chunk_end);
+			}
+		}
+	};
+
+	//! Most tasks a single @ref SharedThreadGroup::parallelFor call pushes.
+	static constexpr size_t kMaxParallelForTasks = 16;
+
+} // namespace detail
+
+template <typename Func>
+inline void
+SharedThreadGroup::parallelFor(size_t begin, size_t end, size_t grain, Func &&func)
+{
+	if (begin >= end) {
+		return;
+	}
+
+	grain = std::max<size_t>(grain, 1);
+	size_t chunk_count = (end - begin + grain - 1) / grain;
+
+	// Not worth the round trip to the pool.
+	if (chunk_count == 1) {
+		func(begin, end);
+		return;
+	}
+
+	using State = detail::ParallelForState<std::remove_reference_t<Func>>;
+	State state{begin, end, grain, chunk_count, func, {0}};
+
+	size_t task_count = std::min(chunk_count, detail::kMaxParallelForTasks);
+	for (size_t i = 0; i < task_count; i++) {
+		u_worker_group_push(mGroup, &State::cCallback, &state);
+	}
+
+	// Helps out with any of the tasks not yet picked up by the workers.
+	u_worker_group_wait_all(mGroup);
+}
+
 } // namespace xrt::auxiliary::util
@@ -8,12 +8,15 @@
  * @ingroup aux_vive
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "math/m_api.h"
 #include "math/m_mathinclude.h"
 
 #include "util/u_misc.h"
 #include "util/u_json.h"
 #include "util/u_debug.h"
+#include "util/u_file.h"
 #include "util/u_distortion_mesh.h"
 
 #include "tracking/t_tracking.h"
@@ -22,6 +25,7 @@
 #include "vive_tweaks.h"
 
 #include <stdio.h>
+#include <inttypes.h>
 
 
 /*
@@ -43,6 +47,29 @@
 #define JSON_MATRIX_3X3(a, b, c) u_json_get_matrix_3x3(u_json_get(a, b), c)
 #define JSON_STRING(a, b, c) u_json_get_string_into_array(u_json_get(a, b), c, sizeof(c))
 
+#define CONFIG_CACHE_MAGIC 0x43435456 /* "VTCC" */
+
+/*!
+ * Bump when the parsing changes what ends up in @ref vive_config, so that
+ * configs cached by an older version are parsed again.
+ */
+#define CONFIG_CACHE_VERSION 1
+
+/*!
+ * Header of a cached config, followed by the @ref vive_config and then the
+ * lighthouse sensors.
+ */
+struct config_cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t json_hash;
+	uint32_t config_size;
+	uint32_t sensor_count;
+};
+
+DEBUG_GET_ONCE_BOOL_OPTION(vive_config_cache, "VIVE_CONFIG_CACHE", true)
+
 
 /*
  *
@@ -394,6 +421,107 @@ _calculate_fov(struct vive_config *d)
 }
 
 
+/*
+ *
+ * Config cache helpers.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+
+//! 64 bit FNV-1a, only used to tell if the JSON has changed.
+static uint64_t
+hash_json_string(const char *json_string)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	for (const char *c = json_string; *c != '\0'; c++) {
+		hash ^= (uint8_t)*c;
+		hash *= UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+static FILE *
+open_config_cache(uint64_t json_hash, const char *mode)
+{
+	char filename[64];
+	snprintf(filename, sizeof(filename), "vive_config_%016" PRIx64 ".bin", json_hash);
+
+	return u_file_open_file_in_cache_dir(filename, mode);
+}
+
+/*!
+ * Loads the config parsed from the JSON with the given hash by an earlier
+ * run, the Index and Pro 2 JSON is big enough to be slow to parse on
+ * low-end devices.
+ */
+static bool
+load_config_cache(struct vive_config *d, uint64_t json_hash)
+{
+	FILE *file = open_config_cache(json_hash, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	struct config_cache_header header;
+	struct vive_config config;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == CONFIG_CACHE_MAGIC &&
+	          header.version == CONFIG_CACHE_VERSION && header.json_hash == json_hash &&
+	          header.config_size == sizeof(struct vive_config) && fread(&config, sizeof(config), 1, file) == 1;
+
+	struct lh_sensor *sensors = NULL;
+	if (ok && header.sensor_count > 0) {
+		sensors = U_TYPED_ARRAY_CALLOC(struct lh_sensor, header.sensor_count);
+		ok = fread(sensors, sizeof(*sensors), header.sensor_count, file) == header.sensor_count;
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		free(sensors);
+		return false;
+	}
+
+	enum u_logging_level log_level = d->log_level;
+
+	*d = config;
+	d->log_level = log_level;
+	d->lh.sensors = sensors;
+	d->lh.sensor_count = header.sensor_count;
+
+	return true;
+}
+
+static void
+store_config_cache(const struct vive_config *d, uint64_t json_hash)
+{
+	FILE *file = open_config_cache(json_hash, "wb");
+	if (file == NULL) {
+		return;
+	}
+
+	struct config_cache_header header = {
+	    .magic = CONFIG_CACHE_MAGIC,
+	    .version = CONFIG_CACHE_VERSION,
+	    .json_hash = json_hash,
+	    .config_size = sizeof(struct vive_config),
+	    .sensor_count = (uint32_t)d->lh.sensor_count,
+	};
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(d, sizeof(*d), 1, file) == 1;
+	if (ok && d->lh.sensor_count > 0) {
+		ok = fwrite(d->lh.sensors, sizeof(*d->lh.sensors), d->lh.sensor_count, file) == d->lh.sensor_count;
+	}
+
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		VIVE_WARN(d, "Failed to write the config cache.");
+	}
+}
+
+#endif /* XRT_OS_LINUX */
+
+
 /*
  *
  * 'Exported' hmd functions.
@@ -408,6 +536,15 @@ vive_config_parse(struct vive_config *d, char *json_string, enum u_logging_level
 
 	VIVE_DEBUG(d, "JSON config:\n%s", json_string);
 
+#ifdef XRT_OS_LINUX
+	bool use_cache = debug_get_bool_option_vive_config_cache();
+	uint64_t json_hash = use_cache ? hash_json_string(json_string) : 0;
+	if (use_cache && load_config_cache(d, json_hash)) {
+		VIVE_DEBUG(d, "Loaded config from cache, model_number: %s", d->firmware.model_number);
+		return true;
+	}
+#endif
+
 	cJSON *json = cJSON_Parse(json_string);
 	if (!cJSON_IsObject(json)) {
 		VIVE_ERROR(d, "Could not parse JSON data.");
@@ -546,6 +683,12 @@ vive_config_parse(struct vive_config *d, char *json_string, enum u_logging_level
 
 	cJSON_Delete(json);
 
+#ifdef XRT_OS_LINUX
+	if (use_cache) {
+		store_config_cache(d, json_hash);
+	}
+#endif
+
 	// clang-format off
 	VIVE_DEBUG(d, "= Vive configuration =");
 	VIVE_DEBUG(d, "lens_separation: %f", d->display.lens_separation);
@@ -21,6 +21,7 @@
 #include "vk/vk_helpers.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 
 /*
@@ -669,6 +670,27 @@ err_free:
 	return VK_ERROR_INITIALIZATION_FAILED;
 }
 
+static uint32_t
+get_queue_family_queue_count(struct vk_bundle *vk, uint32_t queue_family_index)
+{
+	uint32_t queue_family_count = 0;
+	vk->vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &queue_family_count, NULL);
+
+	if (queue_family_index >= queue_family_count) {
+		return 0;
+	}
+
+	VkQueueFamilyProperties *queue_family_props = U_TYPED_ARRAY_CALLOC(VkQueueFamilyProperties, queue_family_count);
+
+	vk->vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &queue_family_count, queue_family_props);
+
+	uint32_t queue_count = queue_family_props[queue_family_index].queueCount;
+
+	free(queue_family_props);
+
+	return queue_count;
+}
+
 static VkResult
 find_compute_queue_family(struct vk_bundle *vk, uint32_t *out_compute_queue_family)
 {
@@ -1089,6 +1111,8 @@ XRT_CHECK_RESULT VkResult
 vk_create_device(struct vk_bundle *vk,
                  int forced_index,
                  bool only_compute,
+                 bool async_compute,
+                 bool async_transfer,
                  VkQueueGlobalPriorityEXT global_priority,
                  struct u_string_list *required_device_ext_list,
                  struct u_string_list *optional_device_ext_list,
@@ -1138,19 +1162,43 @@ vk_create_device(struct vk_bundle *vk,
 		return ret;
 	}
 
+	/*
+	 * The async compute and transfer queues come from the same family, that
+	 * way images doesn't need any queue family ownership transfers between
+	 * them and the main queue.
+	 */
+	uint32_t wanted_count = 1 + (async_compute ? 1 : 0) + (async_transfer ? 1 : 0);
+	uint32_t family_count = get_queue_family_queue_count(vk, vk->queue_family_index);
+	uint32_t queue_count = wanted_count < family_count ? wanted_count : family_count;
+	if (queue_count < wanted_count) {
+		VK_INFO(vk, "Queue family %u only has %u queue(s), wanted %u.", vk->queue_family_index, family_count,
+		        wanted_count);
+	}
+
+	bool has_compute_queue = async_compute && queue_count >= 2;
+	bool has_transfer_queue = async_transfer && queue_count >= (has_compute_queue ? 3 : 2);
+
 	VkDeviceQueueGlobalPriorityCreateInfoEXT priority_info = {
 	    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_GLOBAL_PRIORITY_CREATE_INFO_EXT,
 	    .pNext = NULL,
 	    .globalPriority = global_priority,
 	};
 
-	float queue_priority = 0.0f;
+	/*
+	 * The global priority is for the whole device against other processes,
+	 * these are relative to the other queues of this device. Rendering and
+	 * async compute are both on the frame's critical path, uploads are not.
+	 */
+	float queue_priorities[3] = {1.0f, 1.0f, 1.0f};
+	if (has_transfer_queue) {
+		queue_priorities[has_compute_queue ? 2 : 1] = 0.0f;
+	}
 	VkDeviceQueueCreateInfo queue_create_info = {
 	    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
 	    .pNext = NULL,
-	    .queueCount = 1,
+	    .queueCount = queue_count,
 	    .queueFamilyIndex = vk->queue_family_index,
-	    .pQueuePriorities = &queue_priority,
+	    .pQueuePriorities = queue_priorities,
 	};
 
 #ifdef VK_KHR_global_priority
@@ -1238,6 +1286,22 @@ vk_create_device(struct vk_bundle *vk,
 	}
 	vk->vkGetDeviceQueue(vk->device, vk->queue_family_index, 0, &vk->queue);
 
+	uint32_t next_queue_index = 1;
+
+	vk->compute_queue = VK_NULL_HANDLE;
+	vk->compute_queue_index = 0;
+	if (has_compute_queue) {
+		vk->compute_queue_index = next_queue_index++;
+		vk->vkGetDeviceQueue(vk->device, vk->queue_family_index, vk->compute_queue_index, &vk->compute_queue);
+	}
+
+	vk->transfer_queue = VK_NULL_HANDLE;
+	vk->transfer_queue_index = 0;
+	if (has_transfer_queue) {
+		vk->transfer_queue_index = next_queue_index++;
+		vk->vkGetDeviceQueue(vk->device, vk->queue_family_index, vk->transfer_queue_index, &vk->transfer_queue);
+	}
+
 	// Need to do this after functions have been gotten.
 	VK_NAME_INSTANCE(vk, vk->instance, "vk_bundle instance");
 	VK_NAME_DEVICE(vk, vk->device, "vk_bundle device");
@@ -1257,12 +1321,44 @@ vk_init_mutex(struct vk_bundle *vk)
 	if (os_mutex_init(&vk->queue_mutex) < 0) {
 		return VK_ERROR_INITIALIZATION_FAILED;
 	}
+	if (os_mutex_init(&vk->compute_queue_mutex) < 0) {
+		os_mutex_destroy(&vk->queue_mutex);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+	if (os_mutex_init(&vk->transfer_queue_mutex) < 0) {
+		os_mutex_destroy(&vk->compute_queue_mutex);
+		os_mutex_destroy(&vk->queue_mutex);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+	if (os_mutex_init(&vk->deferred.mutex) < 0) {
+		os_mutex_destroy(&vk->transfer_queue_mutex);
+		os_mutex_destroy(&vk->compute_queue_mutex);
+		os_mutex_destroy(&vk->queue_mutex);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
 	return VK_SUCCESS;
 }
 
 VkResult
 vk_deinit_mutex(struct vk_bundle *vk)
 {
+	// Anything left is leaked, the device should be gone by now.
+	if (vk->deferred.pending_count > 0 || vk->deferred.batch_count > 0) {
+		VK_WARN(vk, "Leaking deferred objects, vk_deferred_wait_and_collect_all not called!");
+	}
+	for (uint32_t i = 0; i < vk->deferred.batch_count; i++) {
+		free(vk->deferred.batches[i].objects);
+	}
+	free(vk->deferred.batches);
+	free(vk->deferred.pending);
+	vk->deferred.batches = NULL;
+	vk->deferred.batch_count = 0;
+	vk->deferred.pending = NULL;
+	vk->deferred.pending_count = 0;
+
+	os_mutex_destroy(&vk->deferred.mutex);
+	os_mutex_destroy(&vk->transfer_queue_mutex);
+	os_mutex_destroy(&vk->compute_queue_mutex);
 	os_mutex_destroy(&vk->queue_mutex);
 	return VK_SUCCESS;
 }
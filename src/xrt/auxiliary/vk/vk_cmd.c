@@ -10,6 +10,8 @@
 
 #include "vk/vk_cmd.h"
 
+#include <assert.h>
+
 
 XRT_CHECK_RESULT VkResult
 vk_cmd_create_cmd_buffer_locked(struct vk_bundle *vk, VkCommandPool pool, VkCommandBuffer *out_cmd_buffer)
@@ -94,7 +96,45 @@ vk_cmd_submit_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *i
 }
 
 XRT_CHECK_RESULT VkResult
-vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk, VkCommandPool pool, VkCommandBuffer cmd_buffer)
+vk_cmd_submit_compute_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence)
+{
+	VkResult ret;
+
+	assert(vk->compute_queue != VK_NULL_HANDLE);
+
+	os_mutex_lock(&vk->compute_queue_mutex);
+	ret = vk->vkQueueSubmit(vk->compute_queue, count, infos, fence);
+	os_mutex_unlock(&vk->compute_queue_mutex);
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+XRT_CHECK_RESULT VkResult
+vk_cmd_submit_transfer_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence)
+{
+	VkResult ret;
+
+	if (vk->transfer_queue == VK_NULL_HANDLE) {
+		return vk_cmd_submit_locked(vk, count, infos, fence);
+	}
+
+	os_mutex_lock(&vk->transfer_queue_mutex);
+	ret = vk->vkQueueSubmit(vk->transfer_queue, count, infos, fence);
+	os_mutex_unlock(&vk->transfer_queue_mutex);
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+static VkResult
+end_submit_wait_and_free_cmd_buffer(struct vk_bundle *vk, VkCommandPool pool, VkCommandBuffer cmd_buffer, bool transfer)
 {
 	VkFence fence;
 	VkResult ret;
@@ -127,7 +167,11 @@ vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk, VkComman
 	    .pCommandBuffers = &cmd_buffer,
 	};
 
-	ret = vk_cmd_submit_locked(vk, 1, &submitInfo, fence);
+	if (transfer) {
+		ret = vk_cmd_submit_transfer_locked(vk, 1, &submitInfo, fence);
+	} else {
+		ret = vk_cmd_submit_locked(vk, 1, &submitInfo, fence);
+	}
 	if (ret != VK_SUCCESS) {
 		VK_ERROR(vk, "vk_cmd_pool_submit_locked: %s", vk_result_string(ret));
 		goto out_fence;
@@ -151,6 +195,20 @@ out:
 	return ret;
 }
 
+XRT_CHECK_RESULT VkResult
+vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk, VkCommandPool pool, VkCommandBuffer cmd_buffer)
+{
+	return end_submit_wait_and_free_cmd_buffer(vk, pool, cmd_buffer, false);
+}
+
+XRT_CHECK_RESULT VkResult
+vk_cmd_end_submit_transfer_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk,
+                                                           VkCommandPool pool,
+                                                           VkCommandBuffer cmd_buffer)
+{
+	return end_submit_wait_and_free_cmd_buffer(vk, pool, cmd_buffer, true);
+}
+
 
 /*
  *
@@ -165,6 +165,30 @@ vk_cmd_create_and_begin_cmd_buffer_locked(struct vk_bundle *vk,
 XRT_CHECK_RESULT VkResult
 vk_cmd_submit_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence);
 
+/*!
+ * Same as @ref vk_cmd_submit_locked but submits to @ref vk_bundle::compute_queue
+ * and takes @ref vk_bundle::compute_queue_mutex instead.
+ *
+ * @pre The vk_bundle must have a compute queue.
+ *
+ * @ingroup aux_vk
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_submit_compute_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence);
+
+/*!
+ * Same as @ref vk_cmd_submit_locked but submits to @ref vk_bundle::transfer_queue
+ * and takes @ref vk_bundle::transfer_queue_mutex instead. Falls back to the
+ * main queue if the vk_bundle doesn't have a transfer queue.
+ *
+ * Work submitted here is not ordered with the main queue, so only use it for
+ * commands that the CPU waits on before the results are used elsewhere.
+ *
+ * @ingroup aux_vk
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_submit_transfer_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence);
+
 /*!
  * A do everything command buffer submission function, the `_locked` suffix
  * refers to the command pool not the queue, the queue lock will be taken during
@@ -187,6 +211,17 @@ vk_cmd_submit_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *i
 XRT_CHECK_RESULT VkResult
 vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk, VkCommandPool pool, VkCommandBuffer cmd_buffer);
 
+/*!
+ * Same as @ref vk_cmd_end_submit_wait_and_free_cmd_buffer_locked but submits
+ * with @ref vk_cmd_submit_transfer_locked.
+ *
+ * @ingroup aux_vk
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_end_submit_transfer_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk,
+                                                           VkCommandPool pool,
+                                                           VkCommandBuffer cmd_buffer);
+
 
 /*
  *
@@ -26,6 +26,8 @@ vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCr
 	XRT_MAYBE_UNUSED int iret = os_mutex_init(&pool->mutex);
 	assert(iret == 0);
 
+	pool->transfer = false;
+
 	VkCommandPoolCreateInfo cmd_pool_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 	    .flags = flags,
@@ -41,6 +43,20 @@ vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCr
 	return ret;
 }
 
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_init_transfer(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCreateFlags flags)
+{
+	// Same queue family, so the pool itself is the same.
+	VkResult ret = vk_cmd_pool_init(vk, pool, flags);
+	if (ret != VK_SUCCESS) {
+		return ret;
+	}
+
+	pool->transfer = true;
+
+	return VK_SUCCESS;
+}
+
 void
 vk_cmd_pool_destroy(struct vk_bundle *vk, struct vk_cmd_pool *pool)
 {
@@ -133,7 +149,11 @@ vk_cmd_pool_submit_cmd_buffer_locked(struct vk_bundle *vk, struct vk_cmd_pool *p
 	    .pCommandBuffers = &cmd_buffer,
 	};
 
-	ret = vk_cmd_submit_locked(vk, 1, &submitInfo, VK_NULL_HANDLE);
+	if (pool->transfer) {
+		ret = vk_cmd_submit_transfer_locked(vk, 1, &submitInfo, VK_NULL_HANDLE);
+	} else {
+		ret = vk_cmd_submit_locked(vk, 1, &submitInfo, VK_NULL_HANDLE);
+	}
 
 	if (ret != VK_SUCCESS) {
 		VK_ERROR(vk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
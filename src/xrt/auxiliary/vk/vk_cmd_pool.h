@@ -33,6 +33,9 @@ struct vk_cmd_pool
 {
 	VkCommandPool pool;
 	struct os_mutex mutex;
+
+	//! Submit to @ref vk_bundle::transfer_queue, see @ref vk_cmd_pool_init_transfer.
+	bool transfer;
 };
 
 
@@ -50,6 +53,16 @@ struct vk_cmd_pool
 XRT_CHECK_RESULT VkResult
 vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCreateFlags flags);
 
+/*!
+ * Create a command buffer pool whose command buffers are submitted to
+ * @ref vk_bundle::transfer_queue, if the bundle has one. Only for work that is
+ * waited on by the CPU, see @ref vk_cmd_submit_transfer_locked.
+ *
+ * @public @memberof vk_cmd_pool
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_init_transfer(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCreateFlags flags);
+
 /*!
  * Destroy a command buffer pool, lock must not be held, externally
  * synchronizable with all other pool commands.
@@ -113,6 +126,10 @@ vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(struct vk_bundle *vk,
                                                        struct vk_cmd_pool *pool,
                                                        VkCommandBuffer cmd_buffer)
 {
+	if (pool->transfer) {
+		return vk_cmd_end_submit_transfer_wait_and_free_cmd_buffer_locked(vk, pool->pool, cmd_buffer);
+	}
+
 	return vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(vk, pool->pool, cmd_buffer);
 }
 
@@ -111,10 +111,12 @@ vk_csci_get_barrier_optimal_layout(VkFormat format)
 	// clang-format off
 #define CASE_COLOR(FORMAT) case VK_FORMAT_##FORMAT: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 #define CASE_DS(FORMAT) case VK_FORMAT_##FORMAT: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+#define CASE_COMPRESSED(FORMAT) case VK_FORMAT_##FORMAT: return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; // Only copied to.
 	// clang-format on
 
 	switch (format) {
 		VK_CSCI_FORMATS(CASE_COLOR, CASE_DS, CASE_DS, CASE_DS)
+		VK_CSCI_COMPRESSED_FORMATS(CASE_COMPRESSED)
 	default: //
 		assert(false && !"Format not supported!");
 		return VK_IMAGE_LAYOUT_UNDEFINED;
@@ -122,6 +124,7 @@ vk_csci_get_barrier_optimal_layout(VkFormat format)
 
 #undef CASE_COLOR
 #undef CASE_DS
+#undef CASE_COMPRESSED
 }
 
 VkImageAspectFlags
@@ -136,6 +139,7 @@ vk_csci_get_barrier_aspect_mask(VkFormat format)
 
 	switch (format) {
 		VK_CSCI_FORMATS(CASE_COLOR, CASE_DS, CASE_D, CASE_S)
+		VK_CSCI_COMPRESSED_FORMATS(CASE_COLOR)
 	default: //
 		assert(false && !"Format not supported!");
 		return 0;
@@ -159,6 +163,7 @@ vk_csci_get_image_view_aspect(VkFormat format, enum xrt_swapchain_usage_bits bit
 
 	switch (format) {
 		VK_CSCI_FORMATS(CASE_COLOR, CASE_DS, CASE_D, CASE_S)
+		VK_CSCI_COMPRESSED_FORMATS(CASE_COLOR)
 	default: //
 		assert(false && !"Format not supported!");
 		return 0;
@@ -0,0 +1,228 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Destroying Vulkan objects once the GPU is done with them.
+ *
+ * @ingroup aux_vk
+ */
+
+#include "util/u_misc.h"
+
+#include "vk/vk_helpers.h"
+
+#include <stdlib.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+destroy_object(struct vk_bundle *vk, const struct vk_deferred_object *obj)
+{
+	switch (obj->type) {
+	case VK_OBJECT_TYPE_IMAGE: vk->vkDestroyImage(vk->device, (VkImage)obj->handle, NULL); break;
+	case VK_OBJECT_TYPE_IMAGE_VIEW: vk->vkDestroyImageView(vk->device, (VkImageView)obj->handle, NULL); break;
+	case VK_OBJECT_TYPE_BUFFER: vk->vkDestroyBuffer(vk->device, (VkBuffer)obj->handle, NULL); break;
+	case VK_OBJECT_TYPE_SAMPLER: vk->vkDestroySampler(vk->device, (VkSampler)obj->handle, NULL); break;
+	case VK_OBJECT_TYPE_DEVICE_MEMORY: vk->vkFreeMemory(vk->device, (VkDeviceMemory)obj->handle, NULL); break;
+	default: VK_ERROR(vk, "Can't destroy deferred object of type %u, leaking it!", (uint32_t)obj->type); break;
+	}
+}
+
+static void
+destroy_objects(struct vk_bundle *vk, struct vk_deferred_object *objects, uint32_t count)
+{
+	// Views before what they view and memory last, in the order they were added.
+	for (uint32_t i = 0; i < count; i++) {
+		destroy_object(vk, &objects[i]);
+	}
+}
+
+/*!
+ * Last resort if we can't track the objects, wait for the queue and destroy
+ * them right away. Called with the deferred mutex held.
+ */
+static void
+wait_and_destroy_locked(struct vk_bundle *vk, struct vk_deferred_object *objects, uint32_t count)
+{
+	os_mutex_lock(&vk->queue_mutex);
+	vk->vkQueueWaitIdle(vk->queue);
+	os_mutex_unlock(&vk->queue_mutex);
+
+	destroy_objects(vk, objects, count);
+}
+
+static void
+destroy_batch(struct vk_bundle *vk, struct vk_deferred_batch *batch)
+{
+	destroy_objects(vk, batch->objects, batch->object_count);
+	free(batch->objects);
+
+	vk->vkDestroyFence(vk->device, batch->fence, NULL);
+
+	U_ZERO(batch);
+}
+
+//! Removes the @p count oldest batches, called with the deferred mutex held.
+static void
+remove_batches_locked(struct vk_bundle *vk, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		destroy_batch(vk, &vk->deferred.batches[i]);
+	}
+
+	uint32_t left = vk->deferred.batch_count - count;
+	for (uint32_t i = 0; i < left; i++) {
+		vk->deferred.batches[i] = vk->deferred.batches[i + count];
+	}
+	vk->deferred.batch_count = left;
+}
+
+static void
+submit_locked(struct vk_bundle *vk)
+{
+	VkResult ret;
+
+	if (vk->deferred.pending_count == 0) {
+		return;
+	}
+
+	struct vk_deferred_object *objects = vk->deferred.pending;
+	uint32_t count = vk->deferred.pending_count;
+	vk->deferred.pending = NULL;
+	vk->deferred.pending_count = 0;
+
+	// Keep the old array if this fails, these objects are then destroyed right away.
+	size_t size = sizeof(struct vk_deferred_batch) * (vk->deferred.batch_count + 1);
+	struct vk_deferred_batch *batches = realloc(vk->deferred.batches, size);
+	if (batches == NULL) {
+		VK_ERROR(vk, "Out of memory, destroying deferred objects right away");
+		wait_and_destroy_locked(vk, objects, count);
+		free(objects);
+		return;
+	}
+	vk->deferred.batches = batches;
+
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	};
+
+	VkFence fence = VK_NULL_HANDLE;
+	ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+		wait_and_destroy_locked(vk, objects, count);
+		free(objects);
+		return;
+	}
+
+	/*
+	 * A submit without any batches still signals the fence once all work
+	 * previously submitted to the queue has completed.
+	 */
+	os_mutex_lock(&vk->queue_mutex);
+	ret = vk->vkQueueSubmit(vk->queue, 0, NULL, fence);
+	os_mutex_unlock(&vk->queue_mutex);
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
+		vk->vkDestroyFence(vk->device, fence, NULL);
+		wait_and_destroy_locked(vk, objects, count);
+		free(objects);
+		return;
+	}
+
+	vk->deferred.batches[vk->deferred.batch_count++] = (struct vk_deferred_batch){
+	    .fence = fence,
+	    .objects = objects,
+	    .object_count = count,
+	};
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+vk_deferred_destroy(struct vk_bundle *vk, VkObjectType type, uint64_t handle)
+{
+	if (handle == 0) {
+		return;
+	}
+
+	struct vk_deferred_object obj = {
+	    .type = type,
+	    .handle = handle,
+	};
+
+	os_mutex_lock(&vk->deferred.mutex);
+
+	// Keep the old array if this fails, this object is then destroyed right away.
+	size_t size = sizeof(struct vk_deferred_object) * (vk->deferred.pending_count + 1);
+	struct vk_deferred_object *pending = realloc(vk->deferred.pending, size);
+	if (pending == NULL) {
+		VK_ERROR(vk, "Out of memory, destroying object right away");
+		wait_and_destroy_locked(vk, &obj, 1);
+	} else {
+		vk->deferred.pending = pending;
+		vk->deferred.pending[vk->deferred.pending_count++] = obj;
+	}
+
+	os_mutex_unlock(&vk->deferred.mutex);
+}
+
+void
+vk_deferred_submit(struct vk_bundle *vk)
+{
+	os_mutex_lock(&vk->deferred.mutex);
+	submit_locked(vk);
+	os_mutex_unlock(&vk->deferred.mutex);
+}
+
+bool
+vk_deferred_collect(struct vk_bundle *vk)
+{
+	os_mutex_lock(&vk->deferred.mutex);
+
+	// Fences on the same queue signal in submission order.
+	uint32_t done = 0;
+	while (done < vk->deferred.batch_count) {
+		VkResult ret = vk->vkGetFenceStatus(vk->device, vk->deferred.batches[done].fence);
+		if (ret != VK_SUCCESS) {
+			break;
+		}
+		done++;
+	}
+
+	remove_batches_locked(vk, done);
+
+	os_mutex_unlock(&vk->deferred.mutex);
+
+	return done > 0;
+}
+
+void
+vk_deferred_wait_and_collect_all(struct vk_bundle *vk)
+{
+	os_mutex_lock(&vk->deferred.mutex);
+
+	submit_locked(vk);
+
+	for (uint32_t i = 0; i < vk->deferred.batch_count; i++) {
+		VkResult ret = vk->vkWaitForFences(vk->device, 1, &vk->deferred.batches[i].fence, VK_TRUE, UINT64_MAX);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+		}
+	}
+
+	remove_batches_locked(vk, vk->deferred.batch_count);
+
+	os_mutex_unlock(&vk->deferred.mutex);
+}
@@ -205,6 +205,7 @@ vk_get_device_functions(struct vk_bundle *vk)
 	vk->vkCmdSetScissor                             = GET_DEV_PROC(vk, vkCmdSetScissor);
 	vk->vkCmdSetViewport                            = GET_DEV_PROC(vk, vkCmdSetViewport);
 	vk->vkCmdClearColorImage                        = GET_DEV_PROC(vk, vkCmdClearColorImage);
+	vk->vkCmdClearDepthStencilImage                 = GET_DEV_PROC(vk, vkCmdClearDepthStencilImage);
 	vk->vkCmdEndRenderPass                          = GET_DEV_PROC(vk, vkCmdEndRenderPass);
 	vk->vkCmdBindDescriptorSets                     = GET_DEV_PROC(vk, vkCmdBindDescriptorSets);
 	vk->vkCmdBindPipeline                           = GET_DEV_PROC(vk, vkCmdBindPipeline);
@@ -213,6 +214,7 @@ vk_get_device_functions(struct vk_bundle *vk)
 	vk->vkCmdDraw                                   = GET_DEV_PROC(vk, vkCmdDraw);
 	vk->vkCmdDrawIndexed                            = GET_DEV_PROC(vk, vkCmdDrawIndexed);
 	vk->vkCmdDispatch                               = GET_DEV_PROC(vk, vkCmdDispatch);
+	vk->vkCmdExecuteCommands                        = GET_DEV_PROC(vk, vkCmdExecuteCommands);
 	vk->vkCmdCopyBuffer                             = GET_DEV_PROC(vk, vkCmdCopyBuffer);
 	vk->vkCmdCopyBufferToImage                      = GET_DEV_PROC(vk, vkCmdCopyBufferToImage);
 	vk->vkCmdCopyImage                              = GET_DEV_PROC(vk, vkCmdCopyImage);
@@ -230,6 +232,7 @@ vk_get_device_functions(struct vk_bundle *vk)
 
 	vk->vkCreatePipelineCache                       = GET_DEV_PROC(vk, vkCreatePipelineCache);
 	vk->vkDestroyPipelineCache                      = GET_DEV_PROC(vk, vkDestroyPipelineCache);
+	vk->vkGetPipelineCacheData                      = GET_DEV_PROC(vk, vkGetPipelineCacheData);
 
 	vk->vkResetDescriptorPool                       = GET_DEV_PROC(vk, vkResetDescriptorPool);
 	vk->vkCreateDescriptorPool                      = GET_DEV_PROC(vk, vkCreateDescriptorPool);
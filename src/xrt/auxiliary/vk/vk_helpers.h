@@ -38,6 +38,29 @@ extern "C" {
  *
  */
 
+/*!
+ * A Vulkan object waiting to be destroyed, see @ref vk_deferred_destroy.
+ *
+ * @ingroup aux_vk
+ */
+struct vk_deferred_object
+{
+	VkObjectType type;
+	uint64_t handle;
+};
+
+/*!
+ * Deferred objects that can be destroyed once @p fence has signalled.
+ *
+ * @ingroup aux_vk
+ */
+struct vk_deferred_batch
+{
+	VkFence fence;
+	struct vk_deferred_object *objects;
+	uint32_t object_count;
+};
+
 /*!
  * A bundle of Vulkan functions and objects, used by both @ref comp and @ref
  * comp_client. Note that they both have different instances of the object, and
@@ -60,6 +83,50 @@ struct vk_bundle
 
 	struct os_mutex queue_mutex;
 
+	/*!
+	 * Optional second queue from the same family as @ref queue, used for
+	 * async compute work. Only created if asked for when creating the
+	 * device and the family has more than one queue, otherwise
+	 * VK_NULL_HANDLE.
+	 */
+	VkQueue compute_queue;
+	uint32_t compute_queue_index;
+
+	//! Protects @ref compute_queue, separate so it doesn't contend with @ref queue_mutex.
+	struct os_mutex compute_queue_mutex;
+
+	/*!
+	 * Optional queue from the same family as @ref queue, used for uploads
+	 * that are waited on by the CPU so they don't contend with the
+	 * compositor's submits, it has a lower queue priority than the others.
+	 * Only created if asked for when creating the device and the family
+	 * has enough queues, otherwise VK_NULL_HANDLE.
+	 */
+	VkQueue transfer_queue;
+	uint32_t transfer_queue_index;
+
+	//! Protects @ref transfer_queue.
+	struct os_mutex transfer_queue_mutex;
+
+	/*!
+	 * Objects that the GPU might still be using, destroyed once the work
+	 * submitted to @ref queue before them has completed, instead of waiting
+	 * for the device to go idle. See @ref vk_deferred_destroy.
+	 */
+	struct
+	{
+		//! Protects the fields below, initialised in @ref vk_init_mutex.
+		struct os_mutex mutex;
+
+		//! Added since the last @ref vk_deferred_submit, not covered by a fence yet.
+		struct vk_deferred_object *pending;
+		uint32_t pending_count;
+
+		//! Submitted batches, oldest first.
+		struct vk_deferred_batch *batches;
+		uint32_t batch_count;
+	} deferred;
+
 	struct
 	{
 #if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_WIN32_HANDLE)
@@ -312,6 +379,7 @@ struct vk_bundle
 	PFN_vkCmdSetScissor vkCmdSetScissor;
 	PFN_vkCmdSetViewport vkCmdSetViewport;
 	PFN_vkCmdClearColorImage vkCmdClearColorImage;
+	PFN_vkCmdClearDepthStencilImage vkCmdClearDepthStencilImage;
 	PFN_vkCmdEndRenderPass vkCmdEndRenderPass;
 	PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
 	PFN_vkCmdBindPipeline vkCmdBindPipeline;
@@ -320,6 +388,7 @@ struct vk_bundle
 	PFN_vkCmdDraw vkCmdDraw;
 	PFN_vkCmdDrawIndexed vkCmdDrawIndexed;
 	PFN_vkCmdDispatch vkCmdDispatch;
+	PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 	PFN_vkCmdCopyBuffer vkCmdCopyBuffer;
 	PFN_vkCmdCopyBufferToImage vkCmdCopyBufferToImage;
 	PFN_vkCmdCopyImage vkCmdCopyImage;
@@ -337,6 +406,7 @@ struct vk_bundle
 
 	PFN_vkCreatePipelineCache vkCreatePipelineCache;
 	PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+	PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 
 	PFN_vkResetDescriptorPool vkResetDescriptorPool;
 	PFN_vkCreateDescriptorPool vkCreateDescriptorPool;
@@ -989,12 +1059,19 @@ struct vk_device_features
 /*!
  * Creates a VkDevice and initialises the VkQueue.
  *
+ * If @p async_compute is set a second queue is requested from the same queue
+ * family, see @ref vk_bundle::compute_queue. Same for @p async_transfer and
+ * @ref vk_bundle::transfer_queue, the compute queue is given precedence if the
+ * family doesn't have enough queues for both.
+ *
  * @ingroup aux_vk
  */
 XRT_CHECK_RESULT VkResult
 vk_create_device(struct vk_bundle *vk,
                  int forced_index,
                  bool only_compute,
+                 bool async_compute,
+                 bool async_transfer,
                  VkQueueGlobalPriorityEXT global_priority,
                  struct u_string_list *required_device_ext_list,
                  struct u_string_list *optional_device_ext_list,
@@ -1389,6 +1466,19 @@ vk_create_pipeline_layout(struct vk_bundle *vk,
 VkResult
 vk_create_pipeline_cache(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache);
 
+/*!
+ * Creates a pipeline cache seeded with data from an earlier
+ * vkGetPipelineCacheData call, data from another device or driver is
+ * silently dropped and an empty cache created.
+ *
+ * Does error logging.
+ */
+VkResult
+vk_create_pipeline_cache_with_data(struct vk_bundle *vk,
+                                   const void *initial_data,
+                                   size_t initial_data_size,
+                                   VkPipelineCache *out_pipeline_cache);
+
 /*!
  * Creates a compute pipeline, assumes entry function is called 'main'.
  *
@@ -1465,6 +1555,25 @@ vk_cb_get_buffer_external_handle_type(struct vk_bundle *vk);
 	/* stencil format */                                                                                           \
 	THING_S(S8_UINT)
 
+/*!
+ * Block compressed formats, only exposed when the compositor opts in to them.
+ * They can't be rendered to, apps fill them with copies and they are only
+ * useful for static non-projection layers like UI and poster quads. BC1 and
+ * BC7 are desktop formats, ASTC mobile, at 4 and 8 bits per texel they are
+ * a quarter to an eighth the size of R8G8B8A8.
+ *
+ * CSCI = Compositor SwapChain Images.
+ *
+ * @ingroup aux_vk
+ */
+#define VK_CSCI_COMPRESSED_FORMATS(THING)                                                                              \
+	THING(BC7_SRGB_BLOCK)       /* VK - Desktop. */                                                                \
+	THING(BC7_UNORM_BLOCK)      /* VK - Desktop. */                                                                \
+	THING(BC1_RGBA_SRGB_BLOCK)  /* VK - Desktop, 1 bit alpha. */                                                   \
+	THING(BC1_RGBA_UNORM_BLOCK) /* VK - Desktop, 1 bit alpha. */                                                   \
+	THING(ASTC_4x4_SRGB_BLOCK)  /* VK - Mobile. */                                                                 \
+	THING(ASTC_4x4_UNORM_BLOCK) /* VK - Mobile. */
+
 /*!
  * Returns the access flags for the compositor to app barriers.
  *
@@ -1545,6 +1654,54 @@ vk_csci_get_image_external_support(struct vk_bundle *vk,
                                    bool *out_exportable);
 
 
+/*
+ *
+ * Deferred destruction, in the vk_deferred.c file.
+ *
+ */
+
+/*!
+ * Destroy the given object once all work submitted to the bundle's queue so
+ * far has completed. Does not wait, the object is only guarded once @ref
+ * vk_deferred_submit is called and destroyed by a later @ref
+ * vk_deferred_collect. Supports images, image views, buffers, samplers and
+ * device memory.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_deferred_destroy(struct vk_bundle *vk, VkObjectType type, uint64_t handle);
+
+/*!
+ * Guard the objects added with @ref vk_deferred_destroy since the last call by
+ * submitting a fence to the bundle's queue, takes @ref vk_bundle::queue_mutex.
+ * No work is waited on, if the submit fails the queue is waited on and the
+ * objects are destroyed right away.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_deferred_submit(struct vk_bundle *vk);
+
+/*!
+ * Destroy the deferred objects that the GPU is done with, never blocks on the
+ * GPU. Returns true if anything was destroyed.
+ *
+ * @ingroup aux_vk
+ */
+bool
+vk_deferred_collect(struct vk_bundle *vk);
+
+/*!
+ * Wait for and destroy all deferred objects, must be called before the device
+ * is destroyed.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_deferred_wait_and_collect_all(struct vk_bundle *vk);
+
+
 /*
  *
  * Sync objects, in the vk_sync_objects.c file.
@@ -64,6 +64,29 @@ get_image_memory_handle_type(void)
 #endif
 }
 
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD) && defined(VK_EXT_external_memory_dma_buf)
+static VkResult
+get_dma_buf_from_device_memory(struct vk_bundle *vk, VkDeviceMemory device_memory, int *out_fd)
+{
+	VkMemoryGetFdInfoKHR fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+	    .memory = device_memory,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	int fd = -1;
+	VkResult ret = vk->vkGetMemoryFdKHR(vk->device, &fd_info, &fd);
+	if (ret != VK_SUCCESS) {
+		U_LOG_E("vkGetMemoryFdKHR: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	*out_fd = fd;
+
+	return ret;
+}
+#endif
+
 static void
 add_format_non_dup(struct format_list_helper *flh, VkFormat format)
 {
@@ -162,6 +185,31 @@ create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info,
 	 */
 
 	VkExternalMemoryHandleTypeFlags memory_handle_type = get_image_memory_handle_type();
+	VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
+
+	/*
+	 * Images that are imported on another GPU can't use any of the device
+	 * specific tiled layouts, so share them as linear dma-bufs instead.
+	 */
+	bool cross_device = (info->create & XRT_SWAPCHAIN_CREATE_CROSS_DEVICE) != 0;
+	if (cross_device) {
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD) && defined(VK_EXT_external_memory_dma_buf)
+		if (!vk->has_EXT_external_memory_dma_buf) {
+			U_LOG_E("create_image: Cross device images need VK_EXT_external_memory_dma_buf");
+			return VK_ERROR_FEATURE_NOT_PRESENT;
+		}
+		if (info->mip_count != 1 || info->array_size != 1 || info->face_count != 1) {
+			U_LOG_E("create_image: Cross device images must have one mip level and one layer");
+			return VK_ERROR_FEATURE_NOT_PRESENT;
+		}
+
+		memory_handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+		tiling = VK_IMAGE_TILING_LINEAR;
+#else
+		U_LOG_E("create_image: Cross device images are only supported with dma-bufs");
+		return VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+	}
 
 	VkExternalMemoryImageCreateInfoKHR external_memory_image_create_info = {
 	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO_KHR,
@@ -234,7 +282,7 @@ create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info,
 	    .mipLevels = info->mip_count,
 	    .arrayLayers = info->array_size * info->face_count,
 	    .samples = VK_SAMPLE_COUNT_1_BIT,
-	    .tiling = VK_IMAGE_TILING_OPTIMAL,
+	    .tiling = tiling,
 	    .usage = image_usage,
 	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
 	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
@@ -315,10 +363,24 @@ create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info,
 		return ret;
 	}
 
+	// The importer needs to know the layout of linear images.
+	uint32_t row_pitch = 0;
+	if (tiling == VK_IMAGE_TILING_LINEAR) {
+		VkImageSubresource subresource = {
+		    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		    .mipLevel = 0,
+		    .arrayLayer = 0,
+		};
+		VkSubresourceLayout layout;
+		vk->vkGetImageSubresourceLayout(vk->device, image, &subresource, &layout);
+		row_pitch = (uint32_t)layout.rowPitch;
+	}
+
 	out_image->handle = image;
 	out_image->memory = device_memory;
 	out_image->size = size;
 	out_image->use_dedicated_allocation = use_dedicated_allocation;
+	out_image->row_pitch = row_pitch;
 
 	return ret;
 }
@@ -474,6 +536,21 @@ vk_ic_destroy(struct vk_bundle *vk, struct vk_image_collection *vkic)
 	U_ZERO(&vkic->info);
 }
 
+void
+vk_ic_destroy_deferred(struct vk_bundle *vk, struct vk_image_collection *vkic)
+{
+	for (size_t i = 0; i < vkic->image_count; i++) {
+		struct vk_image *image = &vkic->images[i];
+
+		vk_deferred_destroy(vk, VK_OBJECT_TYPE_IMAGE, (uint64_t)image->handle);
+		vk_deferred_destroy(vk, VK_OBJECT_TYPE_DEVICE_MEMORY, (uint64_t)image->memory);
+		image->handle = VK_NULL_HANDLE;
+		image->memory = VK_NULL_HANDLE;
+	}
+	vkic->image_count = 0;
+	U_ZERO(&vkic->info);
+}
+
 VkResult
 vk_ic_get_handles(struct vk_bundle *vk,
                   struct vk_image_collection *vkic,
@@ -481,10 +558,21 @@ vk_ic_get_handles(struct vk_bundle *vk,
                   xrt_graphics_buffer_handle_t *out_handles)
 {
 	VkResult ret = VK_SUCCESS;
+	bool cross_device = (vkic->info.create & XRT_SWAPCHAIN_CREATE_CROSS_DEVICE) != 0;
 
 	size_t i = 0;
 	for (; i < vkic->image_count && i < max_handles; i++) {
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD) && defined(VK_EXT_external_memory_dma_buf)
+		// Allocated as a dma-buf in create_image.
+		if (cross_device) {
+			ret = get_dma_buf_from_device_memory(vk, vkic->images[i].memory, &out_handles[i]);
+		} else {
+			ret = vk_get_native_handle_from_device_memory(vk, vkic->images[i].memory, &out_handles[i]);
+		}
+#else
+		(void)cross_device;
 		ret = vk_get_native_handle_from_device_memory(vk, vkic->images[i].memory, &out_handles[i]);
+#endif
 		if (ret != VK_SUCCESS) {
 			break;
 		}
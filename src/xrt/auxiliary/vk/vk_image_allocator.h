@@ -30,6 +30,9 @@ struct vk_image
 	VkDeviceMemory memory;
 	VkDeviceSize size;
 	bool use_dedicated_allocation;
+
+	//! Bytes per row for linear images, zero for optimal tiled ones.
+	uint32_t row_pitch;
 };
 
 struct vk_image_collection
@@ -72,6 +75,14 @@ vk_ic_from_natives(struct vk_bundle *vk,
 void
 vk_ic_destroy(struct vk_bundle *vk, struct vk_image_collection *vkic);
 
+/*!
+ * Same as @ref vk_ic_destroy but the images are only destroyed once the GPU is
+ * done with them, see @ref vk_deferred_destroy. The caller must call @ref
+ * vk_deferred_submit afterwards.
+ */
+void
+vk_ic_destroy_deferred(struct vk_bundle *vk, struct vk_image_collection *vkic);
+
 /*!
  * Get the native handles (FDs on desktop Linux) for the images, this is a all
  * or nothing function. The ownership is transferred from the images to the
@@ -9,10 +9,17 @@
  * @ingroup aux_vk
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "os/os_threading.h"
 #include "util/u_trace_marker.h"
+#include "vk/vk_cmd.h"
 #include "vk/vk_image_readback_to_xf_pool.h"
 
+#ifdef XRT_OS_LINUX
+#include <unistd.h>
+#endif
+
 
 struct vk_image_readback_to_xf_pool
 {
@@ -23,6 +30,27 @@ struct vk_image_readback_to_xf_pool
 	VkExtent2D extent;
 	VkFormat vk_format;
 	enum xrt_format xrt_format;
+	bool export_dmabuf;
+
+	//! Signalled by async readbacks, VK_NULL_HANDLE if not supported.
+	VkSemaphore timeline;
+
+	//! Last value submitted to be signalled on @ref timeline.
+	uint64_t timeline_value;
+
+	/*!
+	 * Ring of async readbacks not yet retired, in submission order, there
+	 * can never be more pending than there are images.
+	 */
+	struct
+	{
+		struct vk_image_readback_to_xf *wrap;
+		VkCommandBuffer cmd;
+		uint64_t value;
+	} pending[READBACK_POOL_NUM_FRAMES];
+
+	uint32_t pending_first;
+	uint32_t pending_count;
 };
 
 static void
@@ -36,6 +64,113 @@ vk_xf_readback_release(struct xrt_frame *xf)
 	os_mutex_unlock(&w->pool->mutex);
 }
 
+#if defined(XRT_OS_LINUX) && defined(VK_EXT_external_memory_dma_buf)
+/*!
+ * Same as vk_create_image_advanced but with the memory exportable as a
+ * dma-buf, which is returned in @p out_fd.
+ */
+static VkResult
+create_image_dmabuf(struct vk_bundle *vk,
+                    VkExtent3D extent,
+                    VkFormat format,
+                    VkImageUsageFlags usage,
+                    VkMemoryPropertyFlags memory_property_flags,
+                    VkDeviceMemory *out_mem,
+                    VkImage *out_image,
+                    int *out_fd)
+{
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkResult ret;
+
+	VkExternalMemoryImageCreateInfo external_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkImageCreateInfo image_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .pNext = &external_info,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = format,
+	    .extent = extent,
+	    .mipLevels = 1,
+	    .arrayLayers = 1,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	ret = vk->vkCreateImage(vk->device, &image_info, NULL, &image);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateImage: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vk->vkGetImageMemoryRequirements(vk->device, image, &memory_requirements);
+
+	uint32_t memory_type_index = UINT32_MAX;
+	if (!vk_get_memory_type(vk, memory_requirements.memoryTypeBits, memory_property_flags, &memory_type_index)) {
+		VK_ERROR(vk, "vk_get_memory_type failed!");
+		ret = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		goto err_image;
+	}
+
+	VkExportMemoryAllocateInfo export_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkMemoryAllocateInfo alloc_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+	    .pNext = &export_info,
+	    .allocationSize = memory_requirements.size,
+	    .memoryTypeIndex = memory_type_index,
+	};
+
+	ret = vk->vkAllocateMemory(vk->device, &alloc_info, NULL, &memory);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkAllocateMemory: %s", vk_result_string(ret));
+		goto err_image;
+	}
+
+	ret = vk->vkBindImageMemory(vk->device, image, memory, 0);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkBindImageMemory: %s", vk_result_string(ret));
+		goto err_memory;
+	}
+
+	VkMemoryGetFdInfoKHR fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+	    .memory = memory,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	int fd = -1;
+	ret = vk->vkGetMemoryFdKHR(vk->device, &fd_info, &fd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkGetMemoryFdKHR: %s", vk_result_string(ret));
+		goto err_memory;
+	}
+
+	*out_mem = memory;
+	*out_image = image;
+	*out_fd = fd;
+
+	return VK_SUCCESS;
+
+err_memory:
+	vk->vkFreeMemory(vk->device, memory, NULL);
+err_image:
+	vk->vkDestroyImage(vk->device, image, NULL);
+
+	return ret;
+}
+#endif
+
 // Creates a new frame, if there's room for one.
 static void
 vk_xf_readback_pool_try_create_new_frame(struct vk_bundle *vk, struct vk_image_readback_to_xf_pool *pool)
@@ -59,15 +194,40 @@ vk_xf_readback_pool_try_create_new_frame(struct vk_bundle *vk, struct vk_image_r
 	    VK_MEMORY_PROPERTY_HOST_CACHED_BIT |            //
 	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;            //
 
-	VkResult res = vk_create_image_advanced( //
-	    vk,                                  //
-	    extent,                              //
-	    pool->vk_format,                     //
-	    VK_IMAGE_TILING_LINEAR,              //
-	    usage,                               //
-	    memory_property_flags,               //
-	    &memory,                             //
-	    &image);                             //
+	VkResult res = VK_ERROR_FEATURE_NOT_PRESENT;
+	int dmabuf_fd = -1;
+
+#if defined(XRT_OS_LINUX) && defined(VK_EXT_external_memory_dma_buf)
+	if (pool->export_dmabuf) {
+		res = create_image_dmabuf( //
+		    vk,                    //
+		    extent,                //
+		    pool->vk_format,       //
+		    usage,                 //
+		    memory_property_flags, //
+		    &memory,               //
+		    &image,                //
+		    &dmabuf_fd);           //
+
+		// Not all drivers can export host visible memory, fall back.
+		if (res != VK_SUCCESS) {
+			U_LOG_W("Failed to export readback image as dma-buf, not exporting any more.");
+			pool->export_dmabuf = false;
+		}
+	}
+#endif
+
+	if (res != VK_SUCCESS) {
+		res = vk_create_image_advanced( //
+		    vk,                         //
+		    extent,                     //
+		    pool->vk_format,            //
+		    VK_IMAGE_TILING_LINEAR,     //
+		    usage,                      //
+		    memory_property_flags,      //
+		    &memory,                    //
+		    &image);                    //
+	}
 
 	VK_NAME_DEVICE_MEMORY(vk, memory, "vk_image_readback_to_xf_pool device memory");
 	VK_NAME_IMAGE(vk, image, "vk_image_readback_to_xf_pool image");
@@ -110,6 +270,7 @@ vk_xf_readback_pool_try_create_new_frame(struct vk_bundle *vk, struct vk_image_r
 	im->pool = pool;
 	im->image = image;
 	im->memory = memory;
+	im->dmabuf_fd = dmabuf_fd;
 	im->image_extent = pool->extent;
 	im->created = true;
 	im->layout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -120,6 +281,9 @@ vk_xf_readback_pool_try_create_new_frame(struct vk_bundle *vk, struct vk_image_r
 	im->base_frame.height = extent.height;
 	im->base_frame.size = stride * extent.height;
 	im->base_frame.format = pool->xrt_format;
+	im->base_frame.dmabuf_fd = dmabuf_fd;
+	im->base_frame.dmabuf_offset = offset;
+	im->base_frame.has_dmabuf = dmabuf_fd >= 0;
 }
 
 /*
@@ -176,12 +340,196 @@ vk_image_readback_to_xf_pool_get_unused_frame(struct vk_bundle *vk,
 	return found;
 }
 
+#ifdef VK_KHR_timeline_semaphore
+static VkResult
+create_timeline_semaphore(struct vk_bundle *vk, VkSemaphore *out_sem)
+{
+	VkSemaphoreTypeCreateInfo type_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+	    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+	    .initialValue = 0,
+	};
+
+	VkSemaphoreCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = &type_info,
+	};
+
+	VkResult ret = vk->vkCreateSemaphore(vk->device, &create_info, NULL, out_sem);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+#endif
+
+bool
+vk_image_readback_to_xf_pool_supports_async(struct vk_image_readback_to_xf_pool *pool)
+{
+	return pool->timeline != VK_NULL_HANDLE;
+}
+
+XRT_CHECK_RESULT VkResult
+vk_image_readback_to_xf_pool_submit_async_locked(struct vk_bundle *vk,
+                                                 struct vk_image_readback_to_xf_pool *pool,
+                                                 struct vk_cmd_pool *cmd_pool,
+                                                 VkCommandBuffer cmd_buffer,
+                                                 struct vk_image_readback_to_xf *wrap,
+                                                 uint64_t *out_value)
+{
+#ifdef VK_KHR_timeline_semaphore
+	XRT_TRACE_MARKER();
+
+	assert(pool->timeline != VK_NULL_HANDLE);
+	assert(pool->pending_count < READBACK_POOL_NUM_FRAMES);
+
+	VkResult ret = vk->vkEndCommandBuffer(cmd_buffer);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		goto err_free;
+	}
+
+	// Only consumed if the submit succeeds.
+	uint64_t value = pool->timeline_value + 1;
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {
+	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+	    .signalSemaphoreValueCount = 1,
+	    .pSignalSemaphoreValues = &value,
+	};
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .pNext = &timeline_info,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd_buffer,
+	    .signalSemaphoreCount = 1,
+	    .pSignalSemaphores = &pool->timeline,
+	};
+
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+		goto err_free;
+	}
+
+	pool->timeline_value = value;
+
+	uint32_t index = (pool->pending_first + pool->pending_count++) % READBACK_POOL_NUM_FRAMES;
+	pool->pending[index].wrap = wrap;
+	pool->pending[index].cmd = cmd_buffer;
+	pool->pending[index].value = value;
+
+	*out_value = value;
+
+	return VK_SUCCESS;
+
+err_free:
+	vk->vkFreeCommandBuffers(vk->device, cmd_pool->pool, 1, &cmd_buffer);
+
+	return ret;
+#else
+	assert(false && "Timeline semaphores not supported");
+	return VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+}
+
+uint32_t
+vk_image_readback_to_xf_pool_retire_locked(struct vk_bundle *vk,
+                                           struct vk_image_readback_to_xf_pool *pool,
+                                           struct vk_cmd_pool *cmd_pool,
+                                           struct xrt_frame **out_frames,
+                                           uint32_t max_frames,
+                                           uint64_t *out_completed_value)
+{
+	uint64_t completed = 0;
+	uint32_t count = 0;
+
+#ifdef VK_KHR_timeline_semaphore
+	if (pool->timeline != VK_NULL_HANDLE) {
+		VkResult ret = vk->vkGetSemaphoreCounterValue(vk->device, pool->timeline, &completed);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkGetSemaphoreCounterValue: %s", vk_result_string(ret));
+			completed = 0;
+		}
+	}
+#endif
+
+	while (pool->pending_count > 0 && count < max_frames) {
+		uint32_t index = pool->pending_first;
+		if (pool->pending[index].value > completed) {
+			break;
+		}
+
+		vk->vkFreeCommandBuffers(vk->device, cmd_pool->pool, 1, &pool->pending[index].cmd);
+
+		// Hand over the reference the pending readback held.
+		out_frames[count++] = &pool->pending[index].wrap->base_frame;
+
+		pool->pending[index].wrap = NULL;
+		pool->pending[index].cmd = VK_NULL_HANDLE;
+		pool->pending_first = (index + 1) % READBACK_POOL_NUM_FRAMES;
+		pool->pending_count--;
+	}
+
+	*out_completed_value = completed;
+
+	return count;
+}
+
+void
+vk_image_readback_to_xf_pool_wait_idle(struct vk_bundle *vk,
+                                       struct vk_image_readback_to_xf_pool *pool,
+                                       struct vk_cmd_pool *cmd_pool)
+{
+	if (pool == NULL || pool->pending_count == 0) {
+		return;
+	}
+
+#ifdef VK_KHR_timeline_semaphore
+	VkSemaphoreWaitInfo wait_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .semaphoreCount = 1,
+	    .pSemaphores = &pool->timeline,
+	    .pValues = &pool->timeline_value,
+	};
+
+	VkResult ret = vk->vkWaitSemaphores(vk->device, &wait_info, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+	}
+#endif
+
+	struct xrt_frame *frames[READBACK_POOL_NUM_FRAMES];
+	uint64_t completed = 0;
+
+	vk_cmd_pool_lock(cmd_pool);
+	uint32_t count = vk_image_readback_to_xf_pool_retire_locked( //
+	    vk,                                                      // vk_bundle
+	    pool,                                                    // pool
+	    cmd_pool,                                                // cmd_pool
+	    frames,                                                  // out_frames
+	    ARRAY_SIZE(frames),                                      // max_frames
+	    &completed);                                             // out_completed_value
+	vk_cmd_pool_unlock(cmd_pool);
+
+	for (uint32_t i = 0; i < count; i++) {
+		xrt_frame_reference(&frames[i], NULL);
+	}
+
+	if (pool->pending_count != 0) {
+		U_LOG_W("%u readbacks still pending after wait!", pool->pending_count);
+	}
+}
+
 void
 vk_image_readback_to_xf_pool_create(struct vk_bundle *vk,
                                     VkExtent2D extent,
                                     struct vk_image_readback_to_xf_pool **out_pool,
                                     enum xrt_format xrt_format,
-                                    VkFormat vk_format)
+                                    VkFormat vk_format,
+                                    bool export_dmabuf)
 {
 	struct vk_image_readback_to_xf_pool *pool = U_TYPED_CALLOC(struct vk_image_readback_to_xf_pool);
 	assert(xrt_format == XRT_FORMAT_R8G8B8X8 || xrt_format == XRT_FORMAT_R8G8B8A8);
@@ -193,6 +541,14 @@ vk_image_readback_to_xf_pool_create(struct vk_bundle *vk,
 	pool->num_images = 0;
 	pool->xrt_format = xrt_format;
 	pool->vk_format = vk_format;
+	pool->export_dmabuf = export_dmabuf && vk->has_EXT_external_memory_dma_buf;
+
+#ifdef VK_KHR_timeline_semaphore
+	// Without it readbacks are synchronous, so not fatal.
+	if (vk->features.timeline_semaphore && create_timeline_semaphore(vk, &pool->timeline) != VK_SUCCESS) {
+		pool->timeline = VK_NULL_HANDLE;
+	}
+#endif
 
 	*out_pool = pool;
 }
@@ -220,6 +576,17 @@ vk_image_readback_to_xf_pool_destroy(struct vk_bundle *vk, struct vk_image_readb
 		);
 		vk->vkFreeMemory(vk->device, im->memory, NULL);
 		vk->vkDestroyImage(vk->device, im->image, NULL);
+
+#ifdef XRT_OS_LINUX
+		if (im->dmabuf_fd >= 0) {
+			close(im->dmabuf_fd);
+		}
+#endif
+	}
+
+	if (pool->timeline != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, pool->timeline, NULL);
+		pool->timeline = VK_NULL_HANDLE;
 	}
 
 	os_mutex_destroy(&pool->mutex);
@@ -22,6 +22,7 @@
 #include "util/u_string_list.h"
 
 #include "vk/vk_helpers.h"
+#include "vk/vk_cmd_pool.h"
 
 
 #define READBACK_POOL_NUM_FRAMES 16
@@ -46,6 +47,9 @@ struct vk_image_readback_to_xf
 	VkImage image;
 	VkDeviceMemory memory;
 
+	//! Exported dma-buf of @ref memory, -1 if not exported.
+	int dmabuf_fd;
+
 	bool in_use;
 	bool created;
 };
@@ -56,12 +60,75 @@ vk_image_readback_to_xf_pool_get_unused_frame(struct vk_bundle *vk,
                                               struct vk_image_readback_to_xf_pool *pool,
                                               struct vk_image_readback_to_xf **out);
 
+/*!
+ * Create a readback pool, if @p export_dmabuf is set and the device supports
+ * it the memory of the images are exported as dma-bufs and given out on the
+ * frames, see @ref xrt_frame::dmabuf_fd.
+ */
 void
 vk_image_readback_to_xf_pool_create(struct vk_bundle *vk,
                                     VkExtent2D extent,
                                     struct vk_image_readback_to_xf_pool **out_pool,
                                     enum xrt_format xrt_format,
-                                    VkFormat vk_format);
+                                    VkFormat vk_format,
+                                    bool export_dmabuf);
+
+/*!
+ * Can the async functions be used on this pool, requires timeline semaphores.
+ */
+bool
+vk_image_readback_to_xf_pool_supports_async(struct vk_image_readback_to_xf_pool *pool);
+
+/*!
+ * Ends and submits @p cmd_buffer, which writes to @p wrap, without waiting for
+ * it to complete. The pool takes ownership of the command buffer and of the
+ * reference on @p wrap, the frame is handed back by
+ * @ref vk_image_readback_to_xf_pool_retire_locked once the GPU is done with it.
+ * The command buffer is freed to @p cmd_pool at the same time.
+ *
+ * Submitting and retiring must only be done from one thread.
+ *
+ * @pre Command pool lock must be held, see @ref vk_cmd_pool_lock.
+ * @pre @ref vk_image_readback_to_xf_pool_supports_async returned true.
+ *
+ * @param[out] out_value Timeline value that is reached once the command buffer is done.
+ */
+XRT_CHECK_RESULT VkResult
+vk_image_readback_to_xf_pool_submit_async_locked(struct vk_bundle *vk,
+                                                 struct vk_image_readback_to_xf_pool *pool,
+                                                 struct vk_cmd_pool *cmd_pool,
+                                                 VkCommandBuffer cmd_buffer,
+                                                 struct vk_image_readback_to_xf *wrap,
+                                                 uint64_t *out_value);
+
+/*!
+ * Never blocks, collects the frames of async readbacks the GPU has completed,
+ * in submission order. The caller gets the reference of each returned frame.
+ *
+ * @pre Command pool lock must be held, see @ref vk_cmd_pool_lock.
+ *
+ * @param[out] out_frames          Array of at least @p max_frames frames.
+ * @param[out] out_completed_value Timeline value reached by the GPU.
+ *
+ * @return Number of frames written to @p out_frames.
+ */
+uint32_t
+vk_image_readback_to_xf_pool_retire_locked(struct vk_bundle *vk,
+                                           struct vk_image_readback_to_xf_pool *pool,
+                                           struct vk_cmd_pool *cmd_pool,
+                                           struct xrt_frame **out_frames,
+                                           uint32_t max_frames,
+                                           uint64_t *out_completed_value);
+
+/*!
+ * Waits for all async readbacks to complete and drops their frames, needs to
+ * be called before destroying the pool or @p cmd_pool if any were submitted.
+ * Takes the lock of @p cmd_pool if there is anything to wait for.
+ */
+void
+vk_image_readback_to_xf_pool_wait_idle(struct vk_bundle *vk,
+                                       struct vk_image_readback_to_xf_pool *pool,
+                                       struct vk_cmd_pool *cmd_pool);
 
 void
 vk_image_readback_to_xf_pool_destroy(struct vk_bundle *vk, struct vk_image_readback_to_xf_pool **pool_ptr);
@@ -11,6 +11,8 @@
 
 #include "vk/vk_helpers.h"
 
+#include <string.h>
+
 
 VkResult
 vk_create_descriptor_pool(struct vk_bundle *vk,
@@ -145,11 +147,43 @@ vk_create_pipeline_layout(struct vk_bundle *vk,
 
 VkResult
 vk_create_pipeline_cache(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache)
+{
+	return vk_create_pipeline_cache_with_data(vk, NULL, 0, out_pipeline_cache);
+}
+
+VkResult
+vk_create_pipeline_cache_with_data(struct vk_bundle *vk,
+                                   const void *initial_data,
+                                   size_t initial_data_size,
+                                   VkPipelineCache *out_pipeline_cache)
 {
 	VkResult ret;
 
+	// Drivers should reject foreign data, but don't hand it over if we can tell.
+	if (initial_data != NULL && initial_data_size >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+		VkPipelineCacheHeaderVersionOne header;
+		memcpy(&header, initial_data, sizeof(header));
+
+		VkPhysicalDeviceProperties props;
+		vk->vkGetPhysicalDeviceProperties(vk->physical_device, &props);
+
+		if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || //
+		    header.vendorID != props.vendorID ||                            //
+		    header.deviceID != props.deviceID ||                            //
+		    memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			VK_DEBUG(vk, "Ignoring pipeline cache data from another device or driver");
+			initial_data = NULL;
+			initial_data_size = 0;
+		}
+	} else {
+		initial_data = NULL;
+		initial_data_size = 0;
+	}
+
 	VkPipelineCacheCreateInfo pipeline_cache_info = {
 	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+	    .initialDataSize = initial_data_size,
+	    .pInitialData = initial_data,
 	};
 
 	VkPipelineCache pipeline_cache;
@@ -51,6 +51,7 @@ using namespace std::chrono;
 using xrt::compositor::client::unique_swapchain_ref;
 
 DEBUG_GET_ONCE_LOG_OPTION(log, "D3D_COMPOSITOR_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(force_keyed_mutex, "D3D_COMPOSITOR_FORCE_KEYED_MUTEX", false)
 
 /*!
  * Spew level logging.
@@ -185,6 +186,12 @@ struct client_d3d11_swapchain_data
 {
 	explicit client_d3d11_swapchain_data(enum u_logging_level log_level) : keyed_mutex_collection(log_level) {}
 
+	/*!
+	 * Only used when there is no fence, then the keyed mutexes are what
+	 * flushes the app's work before the compositor reads the images.
+	 */
+	bool use_keyed_mutex = false;
+
 	xrt::compositor::client::KeyedMutexCollection keyed_mutex_collection;
 
 	//! The shared DXGI handles for our images
@@ -283,7 +290,7 @@ client_d3d11_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_wait_image(sc->xsc.get(), timeout_ns, index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// OK, we got the image in the native compositor, now need the keyed mutex in d3d11.
 		xret = sc->data->keyed_mutex_collection.waitKeyedMutex(index, timeout_ns);
 	}
@@ -306,7 +313,7 @@ client_d3d11_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_release_image(sc->xsc.get(), index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// Release the keyed mutex
 		xret = sc->data->keyed_mutex_collection.releaseKeyedMutex(index);
 	}
@@ -404,8 +411,18 @@ try {
 	std::unique_ptr<struct client_d3d11_swapchain> sc = std::make_unique<struct client_d3d11_swapchain>();
 	sc->data = std::make_unique<client_d3d11_swapchain_data>(c->log_level);
 	auto &data = sc->data;
-	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count, true,
-	                                                        data->comp_images, data->dxgi_handles);
+
+	/*
+	 * With a fence the native compositor, or our own wait in layer_commit,
+	 * makes sure the app is done with the images, and wait_image on the
+	 * native swapchain that the compositor is done with them. The keyed
+	 * mutexes would only add a flush of the immediate context per image.
+	 */
+	data->use_keyed_mutex = !c->fence || debug_get_bool_option_force_keyed_mutex();
+
+	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count,
+	                                                        data->use_keyed_mutex, data->comp_images,
+	                                                        data->dxgi_handles);
 	if (xret != XRT_SUCCESS) {
 		return xret;
 	}
@@ -424,10 +441,12 @@ try {
 	}
 
 	// Cache the keyed mutex interface
-	xret = data->keyed_mutex_collection.init(data->app_images);
-	if (xret != XRT_SUCCESS) {
-		D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
-		return xret;
+	if (data->use_keyed_mutex) {
+		xret = data->keyed_mutex_collection.init(data->app_images);
+		if (xret != XRT_SUCCESS) {
+			D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
+			return xret;
+		}
 	}
 
 	// Import into the native compositor, to create the corresponding swapchain which we wrap.
@@ -663,6 +682,9 @@ client_d3d11_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_syn
 			D3D_ERROR(c, "Error signaling fence: %s", buf);
 			return xrt_comp_layer_commit(&c->xcn->base, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
 		}
+
+		// Without keyed mutexes nothing else flushes the app's work, once per frame.
+		c->fence_context->Flush();
 	}
 
 	if (c->timeline_semaphore) {
@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef XRT_HAVE_EGL
 #error "This file shouldn't be compiled without EGL"
@@ -184,19 +185,37 @@ ensure_native_fence_is_loaded(EGLDisplay dpy, PFNEGLGETPROCADDRESSPROC get_gl_pr
 	PFNEGLQUERYSTRINGIMPLEMENTATIONANDROIDPROC eglQueryStringImplementationANDROID;
 	// clang-format on
 
-	eglQueryStringImplementationANDROID =
-	    (PFNEGLQUERYSTRINGIMPLEMENTATIONANDROIDPROC)get_gl_procaddr("eglQueryStringImplementationANDROID");
+	/*
+	 * Without native fences every commit ends in a glFinish, which stalls
+	 * the app's render thread, so look everywhere the extension can be.
+	 */
+	if (!GLAD_EGL_ANDROID_native_fence_sync) {
+		eglQueryStringImplementationANDROID =
+		    (PFNEGLQUERYSTRINGIMPLEMENTATIONANDROIDPROC)get_gl_procaddr("eglQueryStringImplementationANDROID");
+
+		// On Android, EGL_ANDROID_native_fence_sync only shows up in this
+		// extension list, not the normal one.
+		const char *ext = NULL;
+		if (eglQueryStringImplementationANDROID != NULL) {
+			ext = eglQueryStringImplementationANDROID(dpy, EGL_EXTENSIONS);
+		}
+		if (!has_extension(ext, "EGL_ANDROID_native_fence_sync")) {
+			EGL_WARN("EGL_ANDROID_native_fence_sync not found, will use glFinish on commit!");
+			return;
+		}
 
-	// On Android, EGL_ANDROID_native_fence_sync only shows up in this
-	// extension list, not the normal one.
-	const char *ext = eglQueryStringImplementationANDROID(dpy, EGL_EXTENSIONS);
-	if (!has_extension(ext, "EGL_ANDROID_native_fence_sync")) {
-		return;
+		GLAD_EGL_ANDROID_native_fence_sync = true;
+	}
+
+	if (glad_eglDupNativeFenceFDANDROID == NULL) {
+		glad_eglDupNativeFenceFDANDROID =
+		    (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)get_gl_procaddr("eglDupNativeFenceFDANDROID");
 	}
 
-	GLAD_EGL_ANDROID_native_fence_sync = true;
-	glad_eglDupNativeFenceFDANDROID =
-	    (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)get_gl_procaddr("eglDupNativeFenceFDANDROID");
+	if (glad_eglDupNativeFenceFDANDROID == NULL) {
+		EGL_WARN("Got EGL_ANDROID_native_fence_sync but no eglDupNativeFenceFDANDROID, not using it!");
+		GLAD_EGL_ANDROID_native_fence_sync = false;
+	}
 #endif
 }
 
@@ -325,17 +344,64 @@ check_context_and_debug_print(EGLint egl_client_type)
 	return XRT_SUCCESS;
 }
 
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD)
+/*!
+ * Is the current context on another GPU than the one the native compositor
+ * allocates its images on, assumes the same one if it can't be told.
+ */
+static bool
+is_context_on_other_device(const xrt_uuid_t *vk_device_uuid)
+{
+	const xrt_uuid_t zero = {0};
+	if (memcmp(vk_device_uuid->data, zero.data, sizeof(zero.data)) == 0) {
+		return false;
+	}
+
+	if (!GLAD_GL_EXT_memory_object) {
+		return false;
+	}
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_DEVICE_UUIDS_EXT, &count);
+
+	for (GLint i = 0; i < count; i++) {
+		GLubyte uuid[GL_UUID_SIZE_EXT] = {0};
+		glGetUnsignedBytei_vEXT(GL_DEVICE_UUID_EXT, (GLuint)i, uuid);
+
+		if (memcmp(uuid, vk_device_uuid->data, sizeof(uuid)) == 0) {
+			return false;
+		}
+	}
+
+	return count > 0;
+}
+#endif // defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD)
+
 static xrt_result_t
-get_client_gl_functions(client_gl_swapchain_create_func_t *out_sc_create_func,
-                        client_gl_insert_fence_func_t *out_insert_fence)
+get_client_gl_functions(const xrt_uuid_t *vk_device_uuid,
+                        client_gl_swapchain_create_func_t *out_sc_create_func,
+                        client_gl_insert_fence_func_t *out_insert_fence,
+                        enum xrt_swapchain_create_flags *out_extra_create_flags)
 {
 	client_gl_swapchain_create_func_t sc_create_func = NULL;
 	client_gl_insert_fence_func_t insert_fence_func = NULL;
+	enum xrt_swapchain_create_flags extra_create_flags = 0;
 
 
 #if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD)
 
-	if (GLAD_GL_EXT_memory_object && GLAD_GL_EXT_memory_object_fd) {
+	/*
+	 * Memory objects can't be imported across devices, on hybrid laptops
+	 * the app might have picked the other GPU, so share the images as
+	 * linear dma-bufs instead which both GPUs can get to.
+	 */
+	if (is_context_on_other_device(vk_device_uuid) && GLAD_EGL_EXT_image_dma_buf_import) {
+		EGL_WARN("OpenGL context is on another GPU than the compositor, sharing images as linear dma-bufs");
+		sc_create_func = client_gl_eglimage_swapchain_create;
+		extra_create_flags |= XRT_SWAPCHAIN_CREATE_CROSS_DEVICE;
+	}
+
+	if (sc_create_func == NULL && GLAD_GL_EXT_memory_object && GLAD_GL_EXT_memory_object_fd) {
 		EGL_DEBUG("Using GL memory object swapchain implementation");
 		sc_create_func = client_gl_memobj_swapchain_create;
 	}
@@ -356,6 +422,7 @@ get_client_gl_functions(client_gl_swapchain_create_func_t *out_sc_create_func,
 
 	EGL_DEBUG("Using EGL_Image swapchain implementation with AHardwareBuffer");
 	sc_create_func = client_gl_eglimage_swapchain_create;
+	(void)vk_device_uuid;
 
 #endif
 
@@ -370,6 +437,7 @@ get_client_gl_functions(client_gl_swapchain_create_func_t *out_sc_create_func,
 
 	*out_sc_create_func = sc_create_func;
 	*out_insert_fence = insert_fence_func;
+	*out_extra_create_flags = extra_create_flags;
 
 	return XRT_SUCCESS;
 }
@@ -566,8 +634,13 @@ xrt_gfx_provider_create_gl_egl(struct xrt_compositor_native *xcn,
 	// Get functions.
 	client_gl_swapchain_create_func_t sc_create_func = NULL;
 	client_gl_insert_fence_func_t insert_fence_func = NULL;
+	enum xrt_swapchain_create_flags extra_create_flags = 0;
 
-	xret = get_client_gl_functions(&sc_create_func, &insert_fence_func);
+	xret = get_client_gl_functions(    //
+	    &xcn->base.info.vk_deviceUUID, // vk_device_uuid
+	    &sc_create_func,               // out_sc_create_func
+	    &insert_fence_func,            // out_insert_fence
+	    &extra_create_flags);          // out_extra_create_flags
 	if (xret != XRT_SUCCESS) {
 		restore_context(&old);
 		DESTROY_CONTEXT(display, context);
@@ -600,6 +673,7 @@ xrt_gfx_provider_create_gl_egl(struct xrt_compositor_native *xcn,
 	}
 
 	ceglc->base.base.base.destroy = client_egl_compositor_destroy;
+	ceglc->base.extra_create_flags = extra_create_flags;
 	restore_context(&old);
 	*out_xcgl = &ceglc->base.base;
 
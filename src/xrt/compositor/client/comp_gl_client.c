@@ -27,6 +27,7 @@
 
 #include "client/comp_gl_client.h"
 
+#include "util/u_handles.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
@@ -106,10 +107,125 @@ vk_format_to_gl(int64_t format)
 	case 127 /* VK_FORMAT_S8_UINT                  */: return 0; // GL_STENCIL_INDEX8?
 	case 129 /* VK_FORMAT_D24_UNORM_S8_UINT        */: return GL_DEPTH24_STENCIL8;
 	case 130 /* VK_FORMAT_D32_SFLOAT_S8_UINT       */: return GL_DEPTH32F_STENCIL8;
+	case 133 /* VK_FORMAT_BC1_RGBA_UNORM_BLOCK     */: return 0; // Compressed, not imported into GL.
+	case 134 /* VK_FORMAT_BC1_RGBA_SRGB_BLOCK      */: return 0;
+	case 145 /* VK_FORMAT_BC7_UNORM_BLOCK          */: return 0;
+	case 146 /* VK_FORMAT_BC7_SRGB_BLOCK           */: return 0;
+	case 157 /* VK_FORMAT_ASTC_4x4_UNORM_BLOCK     */: return 0;
+	case 158 /* VK_FORMAT_ASTC_4x4_SRGB_BLOCK      */: return 0;
 	default: U_LOG_W("Cannot convert VK format %" PRIu64 " to GL format!", format); return 0;
 	}
 }
 
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+#define SEMAPHORE_VALUE_PNAME GL_TIMELINE_SEMAPHORE_VALUE_NV
+#elif defined(XRT_GRAPHICS_SYNC_HANDLE_IS_WIN32_HANDLE)
+#define SEMAPHORE_VALUE_PNAME GL_D3D12_FENCE_VALUE_EXT
+#endif
+
+static bool
+has_semaphore_support(void)
+{
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	// Plain GL_EXT_semaphore objects are binary, need the NV extension to make a timeline one.
+	return GLAD_GL_EXT_semaphore && GLAD_GL_EXT_semaphore_fd && GLAD_GL_NV_timeline_semaphore;
+#elif defined(XRT_GRAPHICS_SYNC_HANDLE_IS_WIN32_HANDLE)
+	// Timeline semaphores are shared as D3D12 fences, which carry their own value.
+	return GLAD_GL_EXT_semaphore && GLAD_GL_EXT_semaphore_win32;
+#else
+	return false;
+#endif
+}
+
+/*!
+ * Always takes ownership of the handle.
+ */
+static GLuint
+import_semaphore(xrt_graphics_sync_handle_t handle)
+{
+	GLuint semaphore = 0;
+
+	// Clear any old errors so we can tell if the import failed.
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	GLint type = GL_SEMAPHORE_TYPE_TIMELINE_NV;
+	glCreateSemaphoresNV(1, &semaphore);
+	glSemaphoreParameterivNV(semaphore, GL_SEMAPHORE_TYPE_NV, &type);
+
+	// Consumes the fd on success.
+	glImportSemaphoreFdEXT(semaphore, GL_HANDLE_TYPE_OPAQUE_FD_EXT, handle);
+#elif defined(XRT_GRAPHICS_SYNC_HANDLE_IS_WIN32_HANDLE)
+	glGenSemaphoresEXT(1, &semaphore);
+
+	// Does not take ownership of the handle.
+	glImportSemaphoreWin32HandleEXT(semaphore, GL_HANDLE_TYPE_D3D12_FENCE_EXT, handle);
+	u_graphics_sync_unref(&handle);
+#endif
+
+	GLenum err = glGetError();
+	if (err == GL_NO_ERROR) {
+		return semaphore;
+	}
+
+	U_LOG_E("Failed to import semaphore: 0x%04x", err);
+
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	u_graphics_sync_unref(&handle);
+#endif
+	glDeleteSemaphoresEXT(1, &semaphore);
+
+	return 0;
+}
+
+/*!
+ * Called with the app's context made current, failing is not fatal as we can
+ * always fall back to glFinish.
+ */
+static void
+setup_semaphore(struct client_gl_compositor *c)
+{
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	struct xrt_compositor_semaphore *xcsem = NULL;
+	xrt_result_t xret;
+
+	if (!has_semaphore_support()) {
+		U_LOG_I("No GL semaphore support, will use glFinish on commit.");
+		return;
+	}
+
+	xret = xrt_comp_create_semaphore(&c->xcn->base, &handle, &xcsem);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_W("Failed to create semaphore, will use glFinish on commit!");
+		return;
+	}
+
+	GLuint semaphore = import_semaphore(handle);
+	if (semaphore == 0) {
+		xrt_compositor_semaphore_reference(&xcsem, NULL);
+		return;
+	}
+
+	c->sync.semaphore = semaphore;
+	c->sync.xcsem = xcsem; // No need to reference.
+}
+
+/*!
+ * Called with the right context made current.
+ */
+static void
+signal_semaphore(struct client_gl_compositor *c)
+{
+	GLuint64 value = ++c->sync.value;
+
+	glSemaphoreParameterui64vEXT(c->sync.semaphore, SEMAPHORE_VALUE_PNAME, &value);
+	glSignalSemaphoreEXT(c->sync.semaphore, 0, NULL, 0, NULL, NULL);
+
+	// Make sure the signal operation reaches the GPU, doesn't wait for it.
+	glFlush();
+}
+
 /*!
  * Called with the right context made current.
  */
@@ -398,11 +514,26 @@ client_gl_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_h
 	sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	xrt_result_t xret = client_gl_compositor_context_begin(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
-	if (xret == XRT_SUCCESS) {
-		sync_handle = handle_fencing_or_finish(c);
+	if (xret != XRT_SUCCESS) {
+		COMP_TRACE_IDENT(layer_commit);
+
+		return xrt_comp_layer_commit(&c->xcn->base, sync_handle);
+	}
+
+	if (c->sync.xcsem != NULL) {
+		COMP_TRACE_IDENT(signal_semaphore);
+
+		signal_semaphore(c);
 		client_gl_compositor_context_end(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+
+		COMP_TRACE_IDENT(layer_commit_with_semaphore);
+
+		return xrt_comp_layer_commit_with_semaphore(&c->xcn->base, c->sync.xcsem, c->sync.value);
 	}
 
+	sync_handle = handle_fencing_or_finish(c);
+	client_gl_compositor_context_end(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+
 	COMP_TRACE_IDENT(layer_commit);
 
 	return xrt_comp_layer_commit(&c->xcn->base, sync_handle);
@@ -471,6 +602,7 @@ client_gl_swapchain_create(struct xrt_compositor *xc,
 	xinfo.bits |= xsccp.extra_bits;
 	vkinfo.format = vk_format;
 	vkinfo.bits |= xsccp.extra_bits;
+	vkinfo.create |= c->extra_create_flags;
 
 	struct xrt_swapchain_native *xscn = NULL; // Has to be NULL.
 	xret = xrt_comp_native_create_swapchain(c->xcn, &vkinfo, &xscn);
@@ -545,6 +677,16 @@ client_gl_compositor_destroy(struct xrt_compositor *xc)
 void
 client_gl_compositor_close(struct client_gl_compositor *c)
 {
+	if (c->sync.semaphore != 0) {
+		xrt_result_t xret = client_gl_compositor_context_begin(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER);
+		if (xret == XRT_SUCCESS) {
+			glDeleteSemaphoresEXT(1, &c->sync.semaphore);
+			client_gl_compositor_context_end(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER);
+		}
+		c->sync.semaphore = 0;
+	}
+	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
+
 	os_mutex_destroy(&c->context_mutex);
 }
 
@@ -607,5 +749,17 @@ client_gl_compositor_init(struct client_gl_compositor *c,
 
 	os_mutex_init(&c->context_mutex);
 
+	/*
+	 * Without a way to insert a fence we would have to glFinish on every
+	 * commit, so try to get a semaphore we can signal from the app's
+	 * context instead. Some callers have already restored the previously
+	 * current context, so make the app's context current for this.
+	 */
+	if (c->insert_fence == NULL &&
+	    client_gl_compositor_context_begin(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER) == XRT_SUCCESS) {
+		setup_semaphore(c);
+		client_gl_compositor_context_end(&c->base.base, CLIENT_GL_CONTEXT_REASON_OTHER);
+	}
+
 	return true;
 }
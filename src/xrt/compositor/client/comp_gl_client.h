@@ -165,6 +165,27 @@ struct client_gl_compositor
 	 */
 	client_gl_insert_fence_func_t insert_fence;
 
+	/*!
+	 * Flags added when creating native swapchains, set by the window
+	 * system code, for instance when the app's context is on another GPU.
+	 */
+	enum xrt_swapchain_create_flags extra_create_flags;
+
+	/*!
+	 * Timeline semaphore shared with the native compositor, signaled from
+	 * the app's context on xrt_compositor::layer_commit when no fence can
+	 * be inserted, instead of having to call glFinish.
+	 */
+	struct
+	{
+		struct xrt_compositor_semaphore *xcsem;
+
+		// GLuint
+		unsigned int semaphore;
+
+		uint64_t value;
+	} sync;
+
 	/*!
 	 * @ref client_gl_xlib_compositor::app_context can only be current on one thread; block other threads while we
 	 * know it is bound to a thread.
@@ -49,6 +49,11 @@ DEBUG_GET_ONCE_LOG_OPTION(egl_swapchain_log, "EGL_SWAPCHAIN_LOG", U_LOGGING_WARN
 
 #define EGL_PROTECTED_CONTENT_EXT 0x32C0
 
+#ifndef DRM_FORMAT_MOD_LINEAR
+//! From drm_fourcc.h, which we don't want to depend on only for this.
+#define DRM_FORMAT_MOD_LINEAR (0ULL)
+#endif
+
 /*!
  * Down-cast helper.
  * @private @memberof client_gl_eglimage_swapchain
@@ -200,6 +205,13 @@ client_gl_eglimage_swapchain_create(struct xrt_compositor *xc,
 		EGL_SC_INFO("Computed row pitch is %" PRIu32 " bytes: %" PRIu32 " bpp, %" PRIu32 " pixels wide",
 		            row_pitch, bpp, info->width);
 	}
+
+	// Linear images come with the pitch the allocator picked, which might be padded.
+	bool is_linear = xscn->base.image_count > 0 && xscn->images[0].row_pitch != 0;
+	if (is_linear) {
+		row_pitch = xscn->images[0].row_pitch;
+		EGL_SC_INFO("Using row pitch of linear image: %" PRIu32 " bytes", row_pitch);
+	}
 #endif // defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD)
 
 	struct xrt_swapchain *native_xsc = &xscn->base;
@@ -276,7 +288,20 @@ client_gl_eglimage_swapchain_create(struct xrt_compositor *xc,
 		                  0,
 		                  EGL_DMA_BUF_PLANE0_PITCH_EXT,
 		                  row_pitch,
+		                  EGL_NONE,
+		                  EGL_NONE,
+		                  EGL_NONE,
+		                  EGL_NONE,
 		                  EGL_NONE};
+
+		// Don't let the driver guess the layout of images from another device.
+		if (is_linear && GLAD_EGL_EXT_image_dma_buf_import_modifiers) {
+			attrs[14] = EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT;
+			attrs[15] = (EGLint)(DRM_FORMAT_MOD_LINEAR & 0xffffffff);
+			attrs[16] = EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT;
+			attrs[17] = (EGLint)(DRM_FORMAT_MOD_LINEAR >> 32);
+		}
+
 		EGLenum source = EGL_LINUX_DMA_BUF_EXT;
 #else
 #error "need port"
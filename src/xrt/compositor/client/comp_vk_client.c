@@ -68,25 +68,154 @@ to_native_compositor(struct xrt_compositor *xc)
  *
  */
 
+/*!
+ * Submits all pending release barriers followed by @p cmd_buffer, if not null,
+ * in one go. If @p submit_info is not NULL its semaphores are signalled by the
+ * same submit, and it's submitted even if there are no command buffers.
+ *
+ * @pre Command pool lock must be held, see @ref vk_cmd_pool_lock.
+ */
+static VkResult
+submit_pending_barriers_locked(struct client_vk_compositor *c, VkCommandBuffer cmd_buffer, VkSubmitInfo *submit_info)
+{
+	struct vk_bundle *vk = &c->vk;
+	VkCommandBuffer cmd_buffers[CLIENT_VK_MAX_PENDING_BARRIERS + 1];
+	uint32_t count = 0;
+	VkResult ret;
+
+	for (uint32_t i = 0; i < c->pending.count; i++) {
+		cmd_buffers[count++] = c->pending.cmd_buffers[i];
+	}
+	if (cmd_buffer != VK_NULL_HANDLE) {
+		cmd_buffers[count++] = cmd_buffer;
+	}
+
+	// Even if the submit fails they are not retried.
+	c->pending.count = 0;
+
+	VkSubmitInfo barrier_submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	};
+
+	if (submit_info == NULL) {
+		if (count == 0) {
+			return VK_SUCCESS;
+		}
+		submit_info = &barrier_submit_info;
+	}
+
+	submit_info->commandBufferCount = count;
+	submit_info->pCommandBuffers = count > 0 ? cmd_buffers : NULL;
+
+	// Note we do not submit a fence here, it's not needed.
+	os_mutex_lock(&vk->queue_mutex);
+	ret = vk->vkQueueSubmit( //
+	    vk->queue,           // queue
+	    1,                   // submitCount
+	    submit_info,         // pSubmits
+	    VK_NULL_HANDLE);     // fence
+	os_mutex_unlock(&vk->queue_mutex);
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
+/*!
+ * The app is about to use the image, so the acquire barrier has to go now,
+ * any pending release barriers go with it so they stay in order.
+ */
 static xrt_result_t
-submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer)
+submit_acquire_barrier(struct client_vk_swapchain *sc, uint32_t index)
 {
 	COMP_TRACE_MARKER();
 
 	struct client_vk_compositor *c = sc->c;
-	struct vk_bundle *vk = &c->vk;
 	VkResult ret;
 
-	// Note we do not submit a fence here, it's not needed.
-	ret = vk_cmd_pool_submit_cmd_buffer(vk, &c->pool, cmd_buffer);
+	vk_cmd_pool_lock(&c->pool);
+	ret = submit_pending_barriers_locked(c, sc->acquire[index], NULL);
+	vk_cmd_pool_unlock(&c->pool);
+
 	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vk_cmd_pool_submit_cmd_buffer: %s %u", vk_result_string(ret), ret);
 		return XRT_ERROR_FAILED_TO_SUBMIT_VULKAN_COMMANDS;
 	}
 
 	return XRT_SUCCESS;
 }
 
+/*!
+ * The compositor doesn't read the image until after the next layer commit,
+ * so the release barrier is held back until then.
+ */
+static xrt_result_t
+queue_release_barrier(struct client_vk_swapchain *sc, uint32_t index)
+{
+	COMP_TRACE_MARKER();
+
+	struct client_vk_compositor *c = sc->c;
+	VkResult ret = VK_SUCCESS;
+
+	vk_cmd_pool_lock(&c->pool);
+
+	// Should not happen with a well behaved app, just get them out.
+	if (c->pending.count >= ARRAY_SIZE(c->pending.cmd_buffers)) {
+		ret = submit_pending_barriers_locked(c, VK_NULL_HANDLE, NULL);
+	}
+
+	c->pending.cmd_buffers[c->pending.count++] = sc->release[index];
+
+	vk_cmd_pool_unlock(&c->pool);
+
+	if (ret != VK_SUCCESS) {
+		return XRT_ERROR_FAILED_TO_SUBMIT_VULKAN_COMMANDS;
+	}
+
+	return XRT_SUCCESS;
+}
+
+/*!
+ * Drop any pending release barriers of the swapchain, its images are about to
+ * be destroyed and were never committed so no need to transition them.
+ */
+static void
+drop_pending_barriers(struct client_vk_swapchain *sc)
+{
+	struct client_vk_compositor *c = sc->c;
+
+	vk_cmd_pool_lock(&c->pool);
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < c->pending.count; i++) {
+		VkCommandBuffer cmd_buffer = c->pending.cmd_buffers[i];
+
+		bool is_ours = false;
+		for (uint32_t k = 0; k < sc->base.base.image_count; k++) {
+			is_ours = is_ours || cmd_buffer == sc->release[k];
+		}
+
+		if (!is_ours) {
+			c->pending.cmd_buffers[count++] = cmd_buffer;
+		}
+	}
+	c->pending.count = count;
+
+	vk_cmd_pool_unlock(&c->pool);
+}
+
+//! For the commit paths that can not fold the barriers into their own submit.
+static VkResult
+flush_pending_barriers(struct client_vk_compositor *c)
+{
+	vk_cmd_pool_lock(&c->pool);
+	VkResult ret = submit_pending_barriers_locked(c, VK_NULL_HANDLE, NULL);
+	vk_cmd_pool_unlock(&c->pool);
+
+	return ret;
+}
+
 
 /*
  *
@@ -128,6 +257,100 @@ setup_semaphore(struct client_vk_compositor *c)
 }
 #endif
 
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+static void
+setup_binary_semaphore(struct client_vk_compositor *c)
+{
+	struct vk_bundle *vk = &c->vk;
+	VkResult ret;
+
+	VkExportSemaphoreCreateInfo export_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT,
+	};
+	VkSemaphoreCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	    .pNext = &export_info,
+	};
+
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	ret = vk->vkCreateSemaphore(vk->device, &create_info, NULL, &semaphore);
+	if (ret != VK_SUCCESS) {
+		// Not fatal, we will use the fence fallback.
+		VK_WARN(vk, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return;
+	}
+
+	VK_NAME_SEMAPHORE(vk, semaphore, "binary semaphore");
+
+	c->sync.binary = semaphore;
+}
+#endif
+
+static VkResult
+setup_fence(struct client_vk_compositor *c)
+{
+	struct vk_bundle *vk = &c->vk;
+	VkResult ret;
+
+	VkFenceCreateInfo create_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .flags = 0, // Not signalled.
+	};
+
+	VkFence fence = VK_NULL_HANDLE;
+	ret = vk->vkCreateFence(vk->device, &create_info, NULL, &fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VK_NAME_FENCE(vk, fence, "client_vk_compositor fence");
+
+	c->sync.fence = fence;
+
+	return VK_SUCCESS;
+}
+
+/*!
+ * Wait for all work submitted to the queue so far to complete. Unlike
+ * vkQueueWaitIdle the queue mutex is only held for the submit, so other
+ * threads can keep submitting while we wait.
+ */
+static VkResult
+submit_and_wait_for_fence(struct client_vk_compositor *c)
+{
+	struct vk_bundle *vk = &c->vk;
+	VkResult ret;
+
+	os_mutex_lock(&vk->queue_mutex);
+	ret = vk->vkQueueSubmit( //
+	    vk->queue,           // queue
+	    0,                   // submitCount
+	    NULL,                // pSubmits
+	    c->sync.fence);      // fence
+	os_mutex_unlock(&vk->queue_mutex);
+
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	ret = vk->vkWaitForFences(vk->device, 1, &c->sync.fence, VK_TRUE, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	ret = vk->vkResetFences(vk->device, 1, &c->sync.fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkResetFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
 
 /*
  *
@@ -143,6 +366,12 @@ submit_handle(struct client_vk_compositor *c, xrt_graphics_sync_handle_t sync_ha
 		return false;
 	}
 
+	if (flush_pending_barriers(c) != VK_SUCCESS) {
+		u_graphics_sync_unref(&sync_handle);
+		*out_xret = XRT_ERROR_VULKAN;
+		return true;
+	}
+
 	// Commit consumes the sync_handle.
 	*out_xret = xrt_comp_layer_commit(&c->xcn->base, sync_handle);
 	return true;
@@ -180,13 +409,12 @@ submit_semaphore(struct client_vk_compositor *c, xrt_result_t *out_xret)
 	    .pSignalSemaphores = semaphores,
 	};
 
-	ret = vk->vkQueueSubmit( //
-	    vk->queue,           // queue
-	    1,                   // submitCount
-	    &submit_info,        // pSubmits
-	    VK_NULL_HANDLE);     // fence
+	// The release barriers go in the same submit as the signal.
+	vk_cmd_pool_lock(&c->pool);
+	ret = submit_pending_barriers_locked(c, VK_NULL_HANDLE, &submit_info);
+	vk_cmd_pool_unlock(&c->pool);
+
 	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vkQueueSubmit: %s", vk_result_string(ret));
 		*out_xret = XRT_ERROR_VULKAN;
 		return true;
 	}
@@ -222,6 +450,12 @@ submit_fence(struct client_vk_compositor *c, xrt_result_t *out_xret)
 		return false;
 	}
 
+	ret = flush_pending_barriers(c);
+	if (ret != VK_SUCCESS) {
+		*out_xret = XRT_ERROR_VULKAN;
+		return true;
+	}
+
 	{
 		COMP_TRACE_IDENT(create_and_submit_fence);
 
@@ -239,17 +473,74 @@ submit_fence(struct client_vk_compositor *c, xrt_result_t *out_xret)
 }
 
 static bool
-submit_fallback(struct client_vk_compositor *c, xrt_result_t *out_xret)
+submit_binary_semaphore(struct client_vk_compositor *c, xrt_result_t *out_xret)
 {
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	if (c->sync.binary == VK_NULL_HANDLE) {
+		return false;
+	}
+
+	xrt_graphics_sync_handle_t sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 	struct vk_bundle *vk = &c->vk;
+	VkResult ret;
+
+	COMP_TRACE_IDENT(submit_binary_semaphore);
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .signalSemaphoreCount = 1,
+	    .pSignalSemaphores = &c->sync.binary,
+	};
 
+	// The release barriers go in the same submit as the signal.
+	vk_cmd_pool_lock(&c->pool);
+	ret = submit_pending_barriers_locked(c, VK_NULL_HANDLE, &submit_info);
+	vk_cmd_pool_unlock(&c->pool);
+
+	if (ret != VK_SUCCESS) {
+		*out_xret = XRT_ERROR_VULKAN;
+		return true;
+	}
+
+	/*
+	 * Exporting a sync fd moves the pending signal into the fd and leaves
+	 * the semaphore unsignalled, so it can be signalled again next frame.
+	 */
+	VkSemaphoreGetFdInfoKHR get_fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+	    .semaphore = c->sync.binary,
+	    .handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT,
+	};
+
+	ret = vk->vkGetSemaphoreFdKHR(vk->device, &get_fd_info, &sync_handle);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkGetSemaphoreFdKHR: %s", vk_result_string(ret));
+		*out_xret = XRT_ERROR_VULKAN;
+		return true;
+	}
+
+	*out_xret = xrt_comp_layer_commit(&c->xcn->base, sync_handle);
+	return true;
+#else
+	return false;
+#endif
+}
+
+static bool
+submit_fallback(struct client_vk_compositor *c, xrt_result_t *out_xret)
+{
 	{
-		COMP_TRACE_IDENT(device_wait_idle);
+		COMP_TRACE_IDENT(wait_for_fence);
 
-		// Last course of action fallback.
-		os_mutex_lock(&vk->queue_mutex);
-		vk->vkQueueWaitIdle(vk->queue);
-		os_mutex_unlock(&vk->queue_mutex);
+		// Last course of action fallback, only waits for work submitted so far.
+		VkResult ret = flush_pending_barriers(c);
+		if (ret == VK_SUCCESS) {
+			ret = submit_and_wait_for_fence(c);
+		}
+		if (ret != VK_SUCCESS) {
+			*out_xret = XRT_ERROR_VULKAN;
+			return true;
+		}
 	}
 
 	*out_xret = xrt_comp_layer_commit(&c->xcn->base, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
@@ -272,11 +563,16 @@ client_vk_swapchain_destroy(struct xrt_swapchain *xsc)
 	struct client_vk_compositor *c = sc->c;
 	struct vk_bundle *vk = &c->vk;
 
-	// Make sure images are not used anymore.
+	drop_pending_barriers(sc);
+
+	// Make sure images are not used anymore, without blocking other threads' submits.
 	if (BREAK_OPENXR_SPEC_IN_DESTROY_SWAPCHAIN) {
-		os_mutex_lock(&vk->queue_mutex);
-		vk->vkQueueWaitIdle(vk->queue);
-		os_mutex_unlock(&vk->queue_mutex);
+		VkResult ret = submit_and_wait_for_fence(c);
+		if (ret != VK_SUCCESS) {
+			os_mutex_lock(&vk->queue_mutex);
+			vk->vkQueueWaitIdle(vk->queue);
+			os_mutex_unlock(&vk->queue_mutex);
+		}
 	}
 
 	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
@@ -333,15 +629,12 @@ client_vk_swapchain_barrier_image(struct xrt_swapchain *xsc, enum xrt_barrier_di
 	COMP_TRACE_MARKER();
 
 	struct client_vk_swapchain *sc = client_vk_swapchain(xsc);
-	VkCommandBuffer cmd_buffer = VK_NULL_HANDLE;
 
 	switch (direction) {
-	case XRT_BARRIER_TO_APP: cmd_buffer = sc->acquire[index]; break;
-	case XRT_BARRIER_TO_COMP: cmd_buffer = sc->release[index]; break;
-	default: assert(false);
+	case XRT_BARRIER_TO_APP: return submit_acquire_barrier(sc, index);
+	case XRT_BARRIER_TO_COMP: return queue_release_barrier(sc, index);
+	default: assert(false); return XRT_ERROR_VULKAN;
 	}
-
-	return submit_image_barrier(sc, cmd_buffer);
 }
 
 static xrt_result_t
@@ -368,20 +661,31 @@ client_vk_compositor_destroy(struct xrt_compositor *xc)
 	struct client_vk_compositor *c = client_vk_compositor(xc);
 	struct vk_bundle *vk = &c->vk;
 
-	if (c->sync.semaphore != VK_NULL_HANDLE) {
-		vk->vkDestroySemaphore(vk->device, c->sync.semaphore, NULL);
-		c->sync.semaphore = VK_NULL_HANDLE;
-	}
-	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
-
 	/*
 	 * Make sure that any of the command buffers from the command pool are
 	 * not in use (pending in Vulkan terms), to please the validation layer.
+	 * This also covers any pending signal of the semaphores.
 	 */
 	os_mutex_lock(&vk->queue_mutex);
 	vk->vkQueueWaitIdle(vk->queue);
 	os_mutex_unlock(&vk->queue_mutex);
 
+	if (c->sync.semaphore != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, c->sync.semaphore, NULL);
+		c->sync.semaphore = VK_NULL_HANDLE;
+	}
+	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
+
+	if (c->sync.binary != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, c->sync.binary, NULL);
+		c->sync.binary = VK_NULL_HANDLE;
+	}
+
+	if (c->sync.fence != VK_NULL_HANDLE) {
+		vk->vkDestroyFence(vk->device, c->sync.fence, NULL);
+		c->sync.fence = VK_NULL_HANDLE;
+	}
+
 	// Now safe to free the pool.
 	vk_cmd_pool_destroy(vk, &c->pool);
 
@@ -601,6 +905,8 @@ client_vk_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_h
 		return xret;
 	} else if (submit_fence(c, &xret)) {
 		return xret;
+	} else if (submit_binary_semaphore(c, &xret)) {
+		return xret;
 	} else if (submit_fallback(c, &xret)) {
 		return xret;
 	} else {
@@ -860,6 +1166,18 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	}
 #endif
 
+#if defined(XRT_GRAPHICS_SYNC_HANDLE_IS_FD)
+	// Only needed if neither of the above can be used.
+	if (c->sync.xcsem == NULL && !c->vk.external.fence_sync_fd && c->vk.external.binary_semaphore_sync_fd) {
+		setup_binary_semaphore(c);
+	}
+#endif
+
+	ret = setup_fence(c);
+	if (ret != VK_SUCCESS) {
+		goto err_sync;
+	}
+
 	// Get max texture size.
 	{
 		struct vk_bundle *vk = &c->vk;
@@ -884,11 +1202,22 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	    vk, &c->pool, "vr-marker,frame_end,type,application", &c->dcb);
 	if (ret != VK_SUCCESS) {
 		VK_ERROR(vk, "vk_cmd_pool_create_insert_debug_label_and_end_cmd_buffer: %s", vk_result_string(ret));
-		goto err_pool;
+		goto err_sync;
 	}
 
 	return c;
 
+err_sync:
+	if (c->sync.binary != VK_NULL_HANDLE) {
+		c->vk.vkDestroySemaphore(c->vk.device, c->sync.binary, NULL);
+	}
+	if (c->sync.fence != VK_NULL_HANDLE) {
+		c->vk.vkDestroyFence(c->vk.device, c->sync.fence, NULL);
+	}
+	if (c->sync.semaphore != VK_NULL_HANDLE) {
+		c->vk.vkDestroySemaphore(c->vk.device, c->sync.semaphore, NULL);
+	}
+	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
 err_pool:
 	vk_cmd_pool_destroy(&c->vk, &c->pool);
 err_mutex:
@@ -19,6 +19,9 @@ extern "C" {
 #endif
 
 
+//! How many release barriers can be waiting for the next layer commit.
+#define CLIENT_VK_MAX_PENDING_BARRIERS (XRT_MAX_LAYERS * 2)
+
 /*
  *
  * Structs
@@ -73,12 +76,29 @@ struct client_vk_compositor
 		VkSemaphore semaphore;
 		struct xrt_compositor_semaphore *xcsem;
 		uint64_t value;
+
+		//! Exportable as a sync fd, used when fences can't be exported.
+		VkSemaphore binary;
+
+		//! Last resort, waited on by the CPU without holding the queue mutex.
+		VkFence fence;
 	} sync;
 
 	struct vk_bundle vk;
 
 	struct vk_cmd_pool pool;
 
+	/*!
+	 * Release barriers of images handed back to the compositor, these are
+	 * not needed until the compositor reads the images so they are batched
+	 * into one submit at layer commit. Protected by the pool lock.
+	 */
+	struct
+	{
+		VkCommandBuffer cmd_buffers[CLIENT_VK_MAX_PENDING_BARRIERS];
+		uint32_t count;
+	} pending;
+
 	bool renderdoc_enabled;
 	VkCommandBuffer dcb;
 };
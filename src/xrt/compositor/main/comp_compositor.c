@@ -58,6 +58,7 @@
 #include "util/u_pretty_print.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_verify.h"
+#include "util/u_worker.h"
 
 #include "util/comp_vulkan.h"
 #include "main/comp_compositor.h"
@@ -159,6 +160,7 @@ compositor_end_session(struct xrt_compositor *xc)
 	if (c->deferred_surface) {
 		// Make sure we don't have anything to destroy.
 		comp_swapchain_shared_garbage_collect(&c->base.cscs);
+		render_resources_flush_descriptor_cache(&c->nr);
 		comp_renderer_destroy(&c->r);
 #ifdef XRT_FEATURE_WINDOW_PEEK
 		comp_window_peek_destroy(&c->peek);
@@ -169,6 +171,41 @@ compositor_end_session(struct xrt_compositor *xc)
 	return XRT_SUCCESS;
 }
 
+static float
+get_current_refresh_rate_hz(struct comp_compositor *c)
+{
+	return (float)(1. / time_ns_to_s(c->settings.nominal_frame_interval_ns));
+}
+
+//! Switch the display over if a new refresh rate has been requested, on the compositor thread between frames.
+static void
+apply_requested_refresh_rate(struct comp_compositor *c)
+{
+	int32_t requested_mhz = c->requested_refresh_rate_mhz;
+	if (requested_mhz == 0) {
+		return;
+	}
+
+	// Leave a newer request for the next frame.
+	xrt_atomic_s32_cmpxchg(&c->requested_refresh_rate_mhz, requested_mhz, 0);
+
+	float requested_hz = (float)requested_mhz / 1000.f;
+	float current_hz = get_current_refresh_rate_hz(c);
+	if (fabsf(requested_hz - current_hz) < 0.5f) {
+		return;
+	}
+
+	if (!comp_target_set_refresh_rate(c->target, requested_hz)) {
+		COMP_ERROR(c, "Failed to switch to %.2fHz, staying at %.2fHz", requested_hz, current_hz);
+		return;
+	}
+
+	// The target has already retuned its pacer, the app pacers follow from the predicted period.
+	c->settings.nominal_frame_interval_ns = (uint64_t)time_s_to_ns(1. / requested_hz);
+
+	COMP_INFO(c, "Display refresh rate changed from %.2fHz to %.2fHz", current_hz, requested_hz);
+}
+
 static xrt_result_t
 compositor_predict_frame(struct xrt_compositor *xc,
                          int64_t *out_frame_id,
@@ -183,6 +220,8 @@ compositor_predict_frame(struct xrt_compositor *xc,
 
 	COMP_SPEW(c, "PREDICT_FRAME");
 
+	apply_requested_refresh_rate(c);
+
 	// A little bit easier to read.
 	uint64_t interval_ns = (int64_t)c->settings.nominal_frame_interval_ns;
 
@@ -316,8 +355,10 @@ compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sy
 
 	COMP_SPEW(c, "LAYER_COMMIT finished drawing at %8.3fms", ns_to_ms(c->last_frame_time_ns));
 
-	// Now is a good point to garbage collect.
-	comp_swapchain_shared_garbage_collect(&c->base.cscs);
+	// Now is a good point to garbage collect, cached descriptors might refer to destroyed images.
+	if (comp_swapchain_shared_garbage_collect(&c->base.cscs)) {
+		render_resources_flush_descriptor_cache(&c->nr);
+	}
 
 	return XRT_SUCCESS;
 }
@@ -327,8 +368,7 @@ compositor_get_display_refresh_rate(struct xrt_compositor *xc, float *out_displa
 {
 	struct comp_compositor *c = comp_compositor(xc);
 
-	//! @todo: Implement the method to change display refresh rate.
-	*out_display_refresh_rate_hz = (float)(1. / time_ns_to_s(c->settings.nominal_frame_interval_ns));
+	*out_display_refresh_rate_hz = get_current_refresh_rate_hz(c);
 
 	return XRT_SUCCESS;
 }
@@ -336,7 +376,30 @@ compositor_get_display_refresh_rate(struct xrt_compositor *xc, float *out_displa
 static xrt_result_t
 compositor_request_display_refresh_rate(struct xrt_compositor *xc, float display_refresh_rate_hz)
 {
-	//! @todo: Implement the method to change display refresh rate.
+	struct comp_compositor *c = comp_compositor(xc);
+
+	// The state tracker has checked it against the rates we listed, switched to at the next frame.
+	c->requested_refresh_rate_mhz = (int32_t)(display_refresh_rate_hz * 1000.f);
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+compositor_set_performance_level(struct xrt_compositor *xc, enum xrt_perf_domain domain, enum xrt_perf_set_level level)
+{
+	struct comp_compositor *c = comp_compositor(xc);
+
+	// Only the GPU side is something the compositor can do anything about.
+	if (domain != XRT_PERF_DOMAIN_GPU) {
+		return XRT_SUCCESS;
+	}
+
+	if (c->gpu_perf_level != (int32_t)level) {
+		COMP_INFO(c, "GPU performance level set to %u", (uint32_t)level);
+	}
+
+	c->gpu_perf_level = (int32_t)level;
+
 	return XRT_SUCCESS;
 }
 
@@ -557,6 +620,9 @@ static const char *optional_device_extensions[] = {
 #ifdef VK_EXT_display_control
     VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME,
 #endif
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD) && defined(VK_EXT_external_memory_dma_buf)
+    VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+#endif
 };
 
 static bool
@@ -628,6 +694,8 @@ compositor_init_vulkan(struct comp_compositor *c)
 	    .optional_device_extensions = optional_device_extension_list,
 	    .log_level = c->settings.log_level,
 	    .only_compute_queue = c->settings.use_compute,
+	    .async_compute_queue = c->settings.use_compute && c->settings.use_async_compute,
+	    .transfer_queue = c->settings.use_transfer_queue,
 	    .selected_gpu_index = c->settings.selected_gpu_index,
 	    .client_gpu_index = c->settings.client_gpu_index,
 	    .timeline_semaphore = true, // Flag is optional, not a hard requirement.
@@ -678,6 +746,9 @@ compositor_init_vulkan(struct comp_compositor *c)
  */
 
 const struct comp_target_factory *ctfs[] = {
+#ifdef XRT_HAVE_KMS
+    &comp_target_factory_direct_kms,
+#endif
 #if defined VK_USE_PLATFORM_WAYLAND_KHR && defined XRT_HAVE_WAYLAND_DIRECT
     &comp_target_factory_direct_wayland,
 #endif
@@ -702,6 +773,7 @@ const struct comp_target_factory *ctfs[] = {
 #ifdef VK_USE_PLATFORM_DISPLAY_KHR
     &comp_target_factory_vk_display,
 #endif
+    &comp_target_factory_offscreen,
 };
 
 static void
@@ -907,9 +979,85 @@ compositor_init_render_resources(struct comp_compositor *c)
 		return false;
 	}
 
+	c->nr.gfx.descriptor_cache.enabled = c->settings.use_descriptor_cache;
+
 	return true;
 }
 
+static bool
+compositor_init_window_and_swapchain(struct comp_compositor *c)
+{
+	COMP_TRACE_MARKER();
+
+	return compositor_init_window_post_vulkan(c) && compositor_init_swapchain(c);
+}
+
+/*!
+ * A startup step that only needs Vulkan, independent of the other steps.
+ */
+struct startup_task
+{
+	struct comp_compositor *c;
+	bool (*func)(struct comp_compositor *c);
+	bool result;
+};
+
+static void
+run_startup_task(void *ptr)
+{
+	struct startup_task *task = (struct startup_task *)ptr;
+
+	task->result = task->func(task->c);
+}
+
+/*!
+ * Sets up the render resources and the target at the same time, the shaders,
+ * pipelines and distortion images don't depend on the target and the target
+ * can spend a long time bringing up the display.
+ */
+static bool
+compositor_init_render_resources_and_target(struct comp_compositor *c)
+{
+	COMP_TRACE_MARKER();
+
+	struct startup_task tasks[] = {
+	    {c, compositor_init_render_resources, false},
+	    {c, compositor_init_window_and_swapchain, false},
+	};
+
+	// With a deferred surface the target is set up later on.
+	uint32_t task_count = c->deferred_surface ? 1 : ARRAY_SIZE(tasks);
+
+	// The calling thread is donated while waiting, so needs one less.
+	struct u_worker_thread_pool *pool = NULL;
+	struct u_worker_group *group = NULL;
+	if (task_count > 1) {
+		pool = u_worker_thread_pool_create(task_count - 1, task_count, "Compositor Startup");
+		group = pool != NULL ? u_worker_group_create(pool) : NULL;
+	}
+
+	if (group != NULL) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			u_worker_group_push(group, run_startup_task, &tasks[i]);
+		}
+		u_worker_group_wait_all(group);
+	} else {
+		for (uint32_t i = 0; i < task_count; i++) {
+			run_startup_task(&tasks[i]);
+		}
+	}
+
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+
+	bool ret = true;
+	for (uint32_t i = 0; i < task_count; i++) {
+		ret = ret && tasks[i].result;
+	}
+
+	return ret;
+}
+
 static bool
 compositor_init_renderer(struct comp_compositor *c)
 {
@@ -926,6 +1074,47 @@ compositor_init_renderer(struct comp_compositor *c)
 	return c->r != NULL;
 }
 
+/*!
+ * The rates both the panel and the display modes of the target support, in
+ * ascending order. Always has the current rate, even if nothing can be switched.
+ */
+static void
+fill_refresh_rates(struct comp_compositor *c, struct xrt_system_compositor_info *sys_info)
+{
+	const struct comp_target *ct = c->target;
+	float current_hz = get_current_refresh_rate_hz(c);
+
+	uint32_t count = 0;
+	float *rates = sys_info->refresh_rates_hz;
+	rates[count++] = current_hz;
+
+	for (uint32_t i = 0; i < ct->refresh_rate_count && count < XRT_MAX_SUPPORTED_REFRESH_RATES; i++) {
+		float hz = ct->refresh_rates_hz[i];
+		if (fabsf(hz - current_hz) < 0.5f) {
+			continue;
+		}
+
+		for (uint32_t k = 0; k < c->xdev->hmd->screens[0].refresh_rate_count; k++) {
+			if (fabsf(hz - c->xdev->hmd->screens[0].refresh_rates_hz[k]) < 0.5f) {
+				rates[count++] = hz;
+				break;
+			}
+		}
+	}
+
+	// Insertion sort, there are only a handful.
+	for (uint32_t i = 1; i < count; i++) {
+		float hz = rates[i];
+		uint32_t k = i;
+		for (; k > 0 && rates[k - 1] > hz; k--) {
+			rates[k] = rates[k - 1];
+		}
+		rates[k] = hz;
+	}
+
+	sys_info->refresh_rate_count = count;
+}
+
 xrt_result_t
 comp_main_create_system_compositor(struct xrt_device *xdev,
                                    const struct comp_target_factory *ctf,
@@ -944,9 +1133,11 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	c->base.base.base.layer_commit = compositor_layer_commit;
 	c->base.base.base.get_display_refresh_rate = compositor_get_display_refresh_rate;
 	c->base.base.base.request_display_refresh_rate = compositor_request_display_refresh_rate;
+	c->base.base.base.set_performance_level = compositor_set_performance_level;
 	c->base.base.base.destroy = compositor_destroy;
 	c->frame.waited.id = -1;
 	c->frame.rendering.id = -1;
+	c->gpu_perf_level = XRT_PERF_SET_LEVEL_SUSTAINED_HIGH;
 	c->xdev = xdev;
 
 	COMP_DEBUG(c, "Doing init %p", (void *)c);
@@ -996,7 +1187,7 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	if (!compositor_check_and_prepare_xdev(c, xdev) ||
 	    !compositor_init_window_pre_vulkan(c, ctf) ||
 	    !compositor_init_vulkan(c) ||
-	    !compositor_init_render_resources(c)) {
+	    !compositor_init_render_resources_and_target(c)) {
 		COMP_ERROR(c, "Failed to init compositor %p", (void *)c);
 		c->base.base.base.destroy(&c->base.base.base);
 
@@ -1004,9 +1195,7 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	}
 
 	if (!c->deferred_surface) {
-		if (!compositor_init_window_post_vulkan(c) ||
-		    !compositor_init_swapchain(c) ||
-		    !compositor_init_renderer(c)) {
+		if (!compositor_init_renderer(c)) {
 			COMP_ERROR(c, "Failed to init compositor %p", (void*)c);
 			c->base.base.base.destroy(&c->base.base.base);
 
@@ -1032,6 +1221,9 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 
 	struct comp_vulkan_formats formats = {0};
 	comp_vulkan_formats_check(get_vk(c), &formats);
+	if (c->settings.use_compressed_formats) {
+		comp_vulkan_formats_check_compressed(get_vk(c), &formats);
+	}
 	comp_vulkan_formats_copy_to_info(&formats, info);
 	comp_vulkan_formats_log(c->settings.log_level, &formats);
 
@@ -1039,14 +1231,17 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	/*
 	 * Rest of info.
 	 */
+
+	// Swapchain images are allocated on the compositor's device.
+	info->vk_deviceUUID = c->settings.selected_gpu_deviceUUID;
 	// Hardcoded for now.
 	uint32_t view_count = 2;
 
 	struct xrt_system_compositor_info sys_info_storage = {0};
 	struct xrt_system_compositor_info *sys_info = &sys_info_storage;
 
-	// Required by OpenXR spec.
-	sys_info->max_layers = 16;
+	// Required by OpenXR spec to be at least 16.
+	sys_info->max_layers = XRT_MAX_LAYERS;
 	sys_info->compositor_vk_deviceUUID = c->settings.selected_gpu_deviceUUID;
 	sys_info->client_vk_deviceUUID = c->settings.client_gpu_deviceUUID;
 	sys_info->client_d3d_deviceLUID = c->settings.client_gpu_deviceLUID;
@@ -1096,9 +1291,7 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 		u_var_add_native_images_debug(c, &c->scratch.views[i].unid, tmp);
 	}
 
-	//! @todo: Query all supported refresh rates of the current mode
-	sys_info->refresh_rate_count = 1;
-	sys_info->refresh_rates_hz[0] = (float)(1. / time_ns_to_s(c->settings.nominal_frame_interval_ns));
+	fill_refresh_rates(c, sys_info);
 
 	// Needs to be delayed until after compositor's u_var has been setup.
 	if (!c->deferred_surface) {
@@ -1111,5 +1304,11 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	assert(xret == XRT_SUCCESS && upaf != NULL);
 	(void)xret;
 
-	return comp_multi_create_system_compositor(&c->base.base, upaf, sys_info, !c->deferred_surface, out_xsysc);
+	return comp_multi_create_system_compositor( //
+	    &c->base.base,                          // xcn
+	    upaf,                                   // upaf
+	    sys_info,                               // xsci
+	    c->xdev,                                // xdev
+	    !c->deferred_surface,                   // do_warm_start
+	    out_xsysc);                             // out_xsysc
 }
@@ -116,6 +116,19 @@ struct comp_compositor
 	// Extents of one view, in pixels.
 	VkExtent2D view_extents;
 
+	/*!
+	 * The GPU @ref xrt_perf_set_level asked for by the app, written from
+	 * the IPC threads and read by the renderer, which shrinks the scratch
+	 * images at the lower levels.
+	 */
+	xrt_atomic_s32_t gpu_perf_level;
+
+	/*!
+	 * Refresh rate in mHz asked for with @ref xrt_compositor::request_display_refresh_rate,
+	 * written from the IPC threads and applied by the compositor thread, zero if none.
+	 */
+	xrt_atomic_s32_t requested_refresh_rate_mhz;
+
 	//! Are we mirroring any of the views to the debug gui? If so, turn off the fast path.
 	bool mirroring_to_debug_gui;
 
@@ -10,9 +10,13 @@
 
 #include "xrt/xrt_results.h"
 #include "math/m_mathinclude.h"
+#include "util/u_debug.h"
 #include "main/comp_mirror_to_debug_gui.h"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(mirror_dmabuf, "XRT_COMPOSITOR_MIRROR_DMABUF", false)
+
+
 /*
  *
  * Helper functions.
@@ -52,6 +56,15 @@
 	}
 
 
+static void
+release_wrap(struct vk_image_readback_to_xf **wrap_ptr)
+{
+	struct xrt_frame *frame = &(*wrap_ptr)->base_frame;
+	*wrap_ptr = NULL;
+
+	xrt_frame_reference(&frame, NULL);
+}
+
 static VkResult
 create_blit_descriptor_set_layout(struct vk_bundle *vk, VkDescriptorSetLayout *out_descriptor_set_layout)
 {
@@ -286,12 +299,16 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 		m->image_extent.width += 1;
 	}
 
+	// Lets hardware encoders import the frames without a CPU copy.
+	bool export_dmabuf = debug_get_bool_option_mirror_dmabuf();
+
 	vk_image_readback_to_xf_pool_create( //
 	    vk,                              // vk_bundle
 	    m->image_extent,                 // extent
 	    &m->pool,                        // out_pool
 	    XRT_FORMAT_R8G8B8X8,             // xrt_format
-	    VK_FORMAT_R8G8B8A8_UNORM);       // vk_format
+	    VK_FORMAT_R8G8B8A8_UNORM,        // vk_format
+	    export_dmabuf);                  // export_dmabuf
 
 	ret = vk_cmd_pool_init(vk, &m->cmd_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
 	if (ret != VK_SUCCESS) {
@@ -307,7 +324,7 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	    .sampler_per_descriptor_count = 1,
 	    .storage_image_per_descriptor_count = 1,
 	    .storage_buffer_per_descriptor_count = 0,
-	    .descriptor_count = 1,
+	    .descriptor_count = READBACK_POOL_NUM_FRAMES,
 	    .freeable = false,
 	};
 
@@ -344,6 +361,17 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 
 	VK_NAME_PIPELINE(vk, m->blit.pipeline, "comp_mirror_to_debug_ui blit pipeline");
 
+	// Allocated up front, readbacks can outlive the frame they were made in.
+	for (uint32_t i = 0; i < ARRAY_SIZE(m->blit.descriptor_sets); i++) {
+		C(vk_create_descriptor_set(        //
+		    vk,                            // vk_bundle
+		    m->blit.descriptor_pool,       // descriptor_pool
+		    m->blit.descriptor_set_layout, // descriptor_set_layout
+		    &m->blit.descriptor_sets[i])); // descriptor_set
+
+		VK_NAME_DESCRIPTOR_SET(vk, m->blit.descriptor_sets[i], "comp_mirror_to_debug_ui blit descriptor set");
+	}
+
 	return VK_SUCCESS;
 }
 
@@ -428,26 +456,24 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	struct vk_image_readback_to_xf *wrap = NULL;
 
-	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
-		return XRT_ERROR_VULKAN;
+	// Skip this frame if the GPU is still using the next descriptor set.
+	uint32_t set_index = m->blit.next_descriptor_set;
+	if (m->blit.descriptor_set_values[set_index] > m->completed_value) {
+		U_LOG_W("Readbacks not completing, skipping mirror frame!");
+		return XRT_SUCCESS;
 	}
 
-	if (!ensure_scratch(m, vk)) {
+	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
 		return XRT_ERROR_VULKAN;
 	}
 
-	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
-	ret = vk_create_descriptor_set(    //
-	    vk,                            //
-	    m->blit.descriptor_pool,       // descriptor_pool
-	    m->blit.descriptor_set_layout, // descriptor_set_layout
-	    &descriptor_set);              // descriptor_set
-	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vk_create_descriptor_set: %s", vk_result_string(ret));
+	if (!ensure_scratch(m, vk)) {
+		release_wrap(&wrap);
 		return XRT_ERROR_VULKAN;
 	}
 
-	VK_NAME_DESCRIPTOR_SET(vk, descriptor_set, "comp_mirror_to_debug_ui blit descriptor set");
+	VkDescriptorSet descriptor_set = m->blit.descriptor_sets[set_index];
+	m->blit.next_descriptor_set = (set_index + 1) % ARRAY_SIZE(m->blit.descriptor_sets);
 
 	struct vk_cmd_pool *pool = &m->cmd_pool;
 
@@ -457,8 +483,8 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	VkCommandBuffer cmd;
 	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, pool, 0, &cmd);
 	if (ret != VK_SUCCESS) {
-		vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
 		vk_cmd_pool_unlock(pool);
+		release_wrap(&wrap);
 		return XRT_ERROR_VULKAN;
 	}
 
@@ -622,6 +648,34 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
 	    first_color_level_subresource_range); // subresourceRange
 
+	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
+	wrap->base_frame.source_sequence = frame_id;
+
+	if (vk_image_readback_to_xf_pool_supports_async(m->pool)) {
+		uint64_t value = 0;
+
+		// Ends and submits, the frame is pushed by comp_mirror_retire once done.
+		ret = vk_image_readback_to_xf_pool_submit_async_locked( //
+		    vk,                                                 // vk_bundle
+		    m->pool,                                            // pool
+		    pool,                                               // cmd_pool
+		    cmd,                                                // cmd_buffer
+		    wrap,                                               // wrap
+		    &value);                                            // out_value
+
+		vk_cmd_pool_unlock(pool);
+
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vk_image_readback_to_xf_pool_submit_async_locked: %s", vk_result_string(ret));
+			release_wrap(&wrap);
+			return XRT_ERROR_VULKAN;
+		}
+
+		m->blit.descriptor_set_values[set_index] = value;
+
+		return XRT_SUCCESS;
+	}
+
 	// This takes a long time so make sure to trace it.
 	COMP_TRACE_BEGIN(submit_and_wait);
 
@@ -638,12 +692,10 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	if (ret != VK_SUCCESS) {
 		//! @todo Better handling of error?
 		VK_ERROR(vk, "vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked: %s", vk_result_string(ret));
+		release_wrap(&wrap);
 		return XRT_ERROR_VULKAN;
 	}
 
-	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
-	wrap->base_frame.source_sequence = frame_id;
-
 	struct xrt_frame *frame = &wrap->base_frame;
 	wrap = NULL;
 
@@ -653,9 +705,33 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	xrt_frame_reference(&frame, NULL);
 
-	// Tidies the descriptor we created.
-	vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
-	return XRT_ERROR_VULKAN;
+	return XRT_SUCCESS;
+}
+
+void
+comp_mirror_retire(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
+{
+	if (m->pool == NULL || !vk_image_readback_to_xf_pool_supports_async(m->pool)) {
+		return;
+	}
+
+	struct xrt_frame *frames[READBACK_POOL_NUM_FRAMES];
+
+	vk_cmd_pool_lock(&m->cmd_pool);
+	uint32_t count = vk_image_readback_to_xf_pool_retire_locked( //
+	    vk,                                                      // vk_bundle
+	    m->pool,                                                 // pool
+	    &m->cmd_pool,                                            // cmd_pool
+	    frames,                                                  // out_frames
+	    ARRAY_SIZE(frames),                                      // max_frames
+	    &m->completed_value);                                    // out_completed_value
+	vk_cmd_pool_unlock(&m->cmd_pool);
+
+	for (uint32_t i = 0; i < count; i++) {
+		u_sink_debug_push_frame(&m->debug_sink, frames[i]);
+		u_frame_times_widget_push_sample(&m->push_frame_times, frames[i]->timestamp);
+		xrt_frame_reference(&frames[i], NULL);
+	}
 }
 
 void
@@ -664,7 +740,8 @@ comp_mirror_fini(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
 	// Remove u_var root as early as possible.
 	u_var_remove_root(m);
 
-	// Left eye readback
+	// Left eye readback, wait for any async readbacks first.
+	vk_image_readback_to_xf_pool_wait_idle(vk, m->pool, &m->cmd_pool);
 	vk_image_readback_to_xf_pool_destroy(vk, &m->pool);
 
 	// Bounce image resources.
@@ -70,8 +70,20 @@ struct comp_mirror_to_debug_gui
 
 		//! Doesn't depend on target so is static.
 		VkPipeline pipeline;
+
+		//! One per readback that can be in flight, used round robin.
+		VkDescriptorSet descriptor_sets[READBACK_POOL_NUM_FRAMES];
+
+		//! Readback timeline value that must be reached before reusing the set.
+		uint64_t descriptor_set_values[READBACK_POOL_NUM_FRAMES];
+
+		//! Next descriptor set to use.
+		uint32_t next_descriptor_set;
 	} blit;
 
+	//! Timeline value of the readbacks completed by the GPU.
+	uint64_t completed_value;
+
 	struct vk_cmd_pool cmd_pool;
 };
 
@@ -129,6 +141,15 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
                     VkExtent2D from_extent,
                     struct xrt_normalized_rect from_rect);
 
+/*!
+ * Push any readbacks that the GPU has completed to the debug sink, never
+ * blocks. Should be called every frame.
+ *
+ * @public @memberof comp_mirror_to_debug_gui
+ */
+void
+comp_mirror_retire(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk);
+
 /*!
  * Finalise the struct, frees and resources.
  *
@@ -25,6 +25,7 @@
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
+#include "util/u_visibility_mask.h"
 #include "util/u_sink.h"
 #include "util/u_var.h"
 #include "util/u_frame_times_widget.h"
@@ -56,6 +57,12 @@
  *
  */
 
+/*!
+ * With async compute, how much earlier than strictly needed the distortion is
+ * submitted, covers the submit itself and scheduling jitter of the thread.
+ */
+#define ASYNC_DISTORTION_MARGIN_NS (U_TIME_1MS_IN_NS)
+
 #define CHAIN(STRUCT, NEXT)                                                                                            \
 	do {                                                                                                           \
 		(STRUCT).pNext = NEXT;                                                                                 \
@@ -88,6 +95,20 @@ enum comp_target_fov_source
 	COMP_TARGET_FOV_SOURCE_DEVICE_VIEWS,
 };
 
+/*!
+ * Everything the compute layer squash of a single view depends on, other than
+ * the layers themselves.
+ */
+struct squash_view_state
+{
+	struct xrt_pose world_pose;
+	struct xrt_pose eye_pose;
+	struct xrt_fov fov;
+	struct xrt_normalized_rect pre_transform;
+	struct comp_render_foveation_data foveation;
+	uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE];
+};
+
 /*!
  * Holds associated vulkan objects and state to render with a distortion.
  *
@@ -108,8 +129,53 @@ struct comp_renderer
 	//! Render pass for graphics pipeline rendering to the scratch buffer.
 	struct render_gfx_render_pass scratch_render_pass;
 
+	/*!
+	 * Signalled by the layer squash submitted on the compute queue and
+	 * waited on by the distortion submit on the main queue, only created
+	 * if async compute is used, otherwise VK_NULL_HANDLE.
+	 */
+	VkSemaphore squash_complete;
+
+	/*!
+	 * How long the distortion took on the GPU in the last frame, only the
+	 * distortion is on the main queue with async compute, so it is what
+	 * decides how late it can be submitted. Zero if not known.
+	 */
+	uint64_t last_distortion_ns;
+
+	/*!
+	 * State of the last compute layer squash of each view, lets the next
+	 * frame reuse the scratch image of a view when neither the layers nor
+	 * what the squash of that view depends on have changed.
+	 */
 	struct
 	{
+		//! The last done scratch image of this view holds a squash of the layers.
+		bool valid;
+
+		//! What the squash was done with.
+		struct squash_view_state state;
+	} last_squash[2];
+
+	/*!
+	 * Cells of the views hidden by the visibility mask, for the compute
+	 * layer squasher, only remade when the fov of the view changes.
+	 */
+	struct
+	{
+		bool valid[2];
+
+		//! Fovs the grids were made for.
+		struct xrt_fov fovs[2];
+
+		uint32_t hidden_rows[2][RENDER_VISIBILITY_GRID_SIZE];
+	} visibility;
+
+	struct
+	{
+		//! Size of the scratch images at full performance, they are made smaller at lower levels.
+		VkExtent2D full_extent;
+
 		struct
 		{
 			//! Targets for rendering to the scratch buffer.
@@ -213,6 +279,12 @@ renderer_wait_queue_idle(struct comp_renderer *r)
 	os_mutex_lock(&vk->queue_mutex);
 	vk->vkQueueWaitIdle(vk->queue);
 	os_mutex_unlock(&vk->queue_mutex);
+
+	if (vk->compute_queue != VK_NULL_HANDLE) {
+		os_mutex_lock(&vk->compute_queue_mutex);
+		vk->vkQueueWaitIdle(vk->compute_queue);
+		os_mutex_unlock(&vk->compute_queue_mutex);
+	}
 }
 
 static void
@@ -368,6 +440,137 @@ calc_pose_data(struct comp_renderer *r,
 	}
 }
 
+/*!
+ * Fills in the foveation data for the compute layer squasher, the full rate
+ * region follows the eye gaze if the head device has it, otherwise the fixed
+ * centres supplied by the device are used.
+ */
+static void
+calc_foveation_data(struct comp_renderer *r,
+                    const struct xrt_pose world_poses[2],
+                    const struct xrt_normalized_rect pre_transforms[2],
+                    struct comp_render_foveation_data out_foveation[2])
+{
+	struct comp_compositor *c = r->c;
+	struct xrt_device *xdev = c->xdev;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		out_foveation[i].enabled = c->settings.foveation.enabled;
+		out_foveation[i].radius = c->settings.foveation.radius;
+
+		if (xdev->hmd->foveation.enabled) {
+			out_foveation[i].center = xdev->hmd->foveation.centers[i];
+		} else {
+			out_foveation[i].center = (struct xrt_vec2){0.5f, 0.5f};
+		}
+	}
+
+	if (!c->settings.foveation.enabled) {
+		return;
+	}
+
+	bool has_gaze = false;
+	for (size_t i = 0; i < xdev->input_count; i++) {
+		if (xdev->inputs[i].name == XRT_INPUT_GENERIC_EYE_GAZE_POSE) {
+			has_gaze = true;
+			break;
+		}
+	}
+
+	if (!has_gaze) {
+		return;
+	}
+
+	struct xrt_space_relation gaze = XRT_SPACE_RELATION_ZERO;
+	xrt_device_get_tracked_pose(                         //
+	    xdev,                                            // xdev
+	    XRT_INPUT_GENERIC_EYE_GAZE_POSE,                 // name
+	    r->c->frame.rendering.predicted_display_time_ns, // at_timestamp_ns
+	    &gaze);                                          // out_relation
+
+	if ((gaze.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+		return;
+	}
+
+	// Gaze direction in the same space as the view poses.
+	struct xrt_vec3 forward = {0.0f, 0.0f, -1.0f};
+	struct xrt_vec3 gaze_dir;
+	math_quat_rotate_vec3(&gaze.pose.orientation, &forward, &gaze_dir);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		struct xrt_quat inv_orientation;
+		math_quat_invert(&world_poses[i].orientation, &inv_orientation);
+
+		struct xrt_vec3 dir;
+		math_quat_rotate_vec3(&inv_orientation, &gaze_dir, &dir);
+
+		// Not looking forward (or broken data), keep the fixed centre.
+		if (dir.z > -0.001f) {
+			continue;
+		}
+
+		// From direction to tangent space and then into view uv space.
+		float tan_x = dir.x / -dir.z;
+		float tan_y = dir.y / -dir.z;
+
+		const struct xrt_normalized_rect *pre = &pre_transforms[i];
+		out_foveation[i].center.x = (tan_x - pre->x) / pre->w;
+		out_foveation[i].center.y = (-tan_y - pre->y) / pre->h;
+	}
+}
+
+/*!
+ * Fills in which parts of the views are hidden by the visibility mask of the
+ * device, falling back to the default mask if the device doesn't have one.
+ */
+static void
+calc_visibility_data(struct comp_renderer *r,
+                     const struct xrt_fov fovs[2],
+                     uint32_t out_hidden_rows[2][RENDER_VISIBILITY_GRID_SIZE])
+{
+	struct xrt_device *xdev = r->c->xdev;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		if (!r->settings->use_visibility_mask) {
+			U_ZERO_ARRAY(out_hidden_rows[i]);
+			continue;
+		}
+
+		bool same_fov = memcmp(&r->visibility.fovs[i], &fovs[i], sizeof(fovs[i])) == 0;
+		if (!r->visibility.valid[i] || !same_fov) {
+			struct xrt_visibility_mask *mask = NULL;
+			xrt_result_t xret = XRT_ERROR_DEVICE_FUNCTION_NOT_IMPLEMENTED;
+
+			if (xdev->get_visibility_mask != NULL) {
+				xret = xrt_device_get_visibility_mask(               //
+				    xdev,                                            // xdev
+				    XRT_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH,   // type
+				    i,                                               // view_index
+				    &mask);                                          // out_mask
+			}
+
+			if (xret != XRT_SUCCESS || mask == NULL) {
+				free(mask);
+				mask = NULL;
+
+				u_visibility_mask_get_default(                     //
+				    XRT_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH,   // type
+				    &xdev->hmd->distortion.fov[i],                   // fov
+				    &mask);                                          // out_mask
+			}
+
+			// A NULL mask hides nothing.
+			u_visibility_mask_get_hidden_grid(mask, &fovs[i], r->visibility.hidden_rows[i]);
+			free(mask);
+
+			r->visibility.fovs[i] = fovs[i];
+			r->visibility.valid[i] = true;
+		}
+
+		memcpy(out_hidden_rows[i], r->visibility.hidden_rows[i], sizeof(r->visibility.hidden_rows[i]));
+	}
+}
+
 //! @pre comp_target_has_images(r->c->target)
 static void
 renderer_build_rendering_target_resources(struct comp_renderer *r,
@@ -420,6 +623,9 @@ renderer_create_renderings_and_fences(struct comp_renderer *r)
 		for (uint32_t i = 0; i < r->buffer_count; ++i) {
 			renderer_build_rendering_target_resources(r, &r->rtr_array[i], i);
 		}
+
+		// The target render pass created new pipelines.
+		render_resources_save_pipeline_cache(&r->c->nr);
 	}
 
 	r->fences = U_TYPED_ARRAY_CALLOC(VkFence, r->buffer_count);
@@ -566,6 +772,91 @@ renderer_ensure_images_and_renderings(struct comp_renderer *r, bool force_recrea
 	return true;
 }
 
+static void
+renderer_init_scratch_targets(struct comp_renderer *r)
+{
+	struct comp_compositor *c = r->c;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->scratch.views); i++) {
+		VkExtent2D extent = {c->scratch.views[i].info.width, c->scratch.views[i].info.height};
+
+		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
+			struct render_scratch_color_image *rsci = &c->scratch.views[i].images[k];
+
+			render_gfx_target_resources_init(    //
+			    &r->scratch.views[i].targets[k], //
+			    &r->c->nr,                       //
+			    &r->scratch_render_pass,         //
+			    rsci->srgb_view,                 //
+			    extent);                         //
+		}
+	}
+}
+
+static void
+renderer_close_scratch_targets(struct comp_renderer *r)
+{
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->scratch.views); i++) {
+		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
+			render_gfx_target_resources_close(&r->scratch.views[i].targets[k]);
+		}
+	}
+}
+
+/*!
+ * The scratch images are where the layers are squashed and the distortion
+ * samples from, making them smaller saves GPU time and memory bandwidth in
+ * both at the cost of sharpness. So shrink them at the lower GPU performance
+ * levels the app can ask for, the distortion scales them back up.
+ */
+static void
+renderer_ensure_scratch_extent(struct comp_renderer *r)
+{
+	struct comp_compositor *c = r->c;
+
+	double scale = 1.0;
+	switch (c->gpu_perf_level) {
+	case XRT_PERF_SET_LEVEL_POWER_SAVINGS: scale = r->settings->power_savings_scale; break;
+	case XRT_PERF_SET_LEVEL_SUSTAINED_LOW: scale = (1.0 + r->settings->power_savings_scale) / 2.0; break;
+	default: break;
+	}
+
+	VkExtent2D extent = {
+	    (uint32_t)(r->scratch.full_extent.width * scale),
+	    (uint32_t)(r->scratch.full_extent.height * scale),
+	};
+	extent.width = extent.width > 0 ? extent.width : 1;
+	extent.height = extent.height > 0 ? extent.height : 1;
+
+	struct xrt_swapchain_create_info *info = &c->scratch.views[0].info;
+	if (info->width == extent.width && info->height == extent.height) {
+		return;
+	}
+
+	COMP_INFO(c, "Scratch images resized to %ux%u", extent.width, extent.height);
+
+	// Rare, so it's fine to stall to make sure nothing uses the old images.
+	renderer_wait_queue_idle(r);
+
+	// Cached descriptor sets refer to the views of the old images.
+	render_resources_flush_descriptor_cache(&c->nr);
+
+	renderer_close_scratch_targets(r);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->scratch.views); i++) {
+		// Keeps the old images if this fails, the targets are made for whichever we have.
+		if (!comp_scratch_single_images_ensure(&c->scratch.views[i], &c->base.vk, extent)) {
+			COMP_ERROR(c, "comp_scratch_single_images_ensure: false");
+		}
+	}
+
+	renderer_init_scratch_targets(r);
+
+	// Nothing to reuse in the new images.
+	r->last_squash[0].valid = false;
+	r->last_squash[1].valid = false;
+}
+
 //! Create renderer and initialize non-image-dependent members
 static void
 renderer_init(struct comp_renderer *r, struct comp_compositor *c, VkExtent2D scratch_extent)
@@ -588,30 +879,39 @@ renderer_init(struct comp_renderer *r, struct comp_compositor *c, VkExtent2D scr
 	    VK_ATTACHMENT_LOAD_OP_CLEAR,               // load_op
 	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL); // final_layout
 
+	r->scratch.full_extent = scratch_extent;
+
 	for (uint32_t i = 0; i < ARRAY_SIZE(r->scratch.views); i++) {
 		bret = comp_scratch_single_images_ensure(&r->c->scratch.views[i], &r->c->base.vk, scratch_extent);
 		if (!bret) {
 			COMP_ERROR(c, "comp_scratch_single_images_ensure: false");
 			assert(false && "Whelp, can't return an error. But should never really fail.");
 		}
-
-		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
-			struct render_scratch_color_image *rsci = &c->scratch.views[i].images[k];
-
-			render_gfx_target_resources_init(    //
-			    &r->scratch.views[i].targets[k], //
-			    &r->c->nr,                       //
-			    &r->scratch_render_pass,         //
-			    rsci->srgb_view,                 //
-			    scratch_extent);                 //
-		}
 	}
 
+	renderer_init_scratch_targets(r);
+
 	// Try to early-allocate these, in case we can.
 	renderer_ensure_images_and_renderings(r, false);
 
 	struct vk_bundle *vk = &r->c->base.vk;
 
+	// The compositor only asks for the queue if the setting is enabled.
+	if (r->settings->use_compute && c->nr.async_compute_cmd != VK_NULL_HANDLE) {
+		VkSemaphoreCreateInfo info = {
+		    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		};
+
+		VkResult sem_ret = vk->vkCreateSemaphore(vk->device, &info, NULL, &r->squash_complete);
+		if (sem_ret != VK_SUCCESS) {
+			COMP_ERROR(c, "vkCreateSemaphore: %s, not using async compute", vk_result_string(sem_ret));
+			r->squash_complete = VK_NULL_HANDLE;
+		} else {
+			VK_NAME_SEMAPHORE(vk, r->squash_complete, "comp_renderer squash complete");
+			COMP_INFO(c, "Squashing layers on the async compute queue.");
+		}
+	}
+
 	VkResult ret = comp_mirror_init( //
 	    &r->mirror_to_debug_gui,     //
 	    vk,                          //
@@ -643,8 +943,44 @@ renderer_wait_for_last_fence(struct comp_renderer *r)
 	r->fenced_buffer = -1;
 }
 
+/*!
+ * Samples the head pose again, as late as possible before submitting, and
+ * rewrites the timewarp matrices that the distortion pass has already put in
+ * the mapped UBOs. Only views that are timewarped are touched.
+ */
+static void
+renderer_late_latch(struct comp_renderer *r,
+                    enum comp_target_fov_source fov_source,
+                    const struct render_late_latch *rll)
+{
+	COMP_TRACE_MARKER();
+
+	if (!r->settings->late_latch) {
+		return;
+	}
+
+	struct xrt_fov fovs[2];
+	struct xrt_pose world_poses[2];
+	struct xrt_pose eye_poses[2];
+	calc_pose_data(  //
+	    r,           // r
+	    fov_source,  // fov_source
+	    fovs,        // fovs[2]
+	    world_poses, // world_poses[2]
+	    eye_poses);  // eye_poses[2]
+
+	render_late_latch_update(rll, world_poses);
+}
+
+/*!
+ * Submits @p cmd to the main queue, if @p squash_complete is not
+ * VK_NULL_HANDLE the submit also waits on it before running any compute work.
+ */
 static XRT_CHECK_RESULT VkResult
-renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineStageFlags pipeline_stage_flag)
+renderer_submit_queue(struct comp_renderer *r,
+                      VkCommandBuffer cmd,
+                      VkPipelineStageFlags pipeline_stage_flag,
+                      VkSemaphore squash_complete)
 {
 	COMP_TRACE_MARKER();
 
@@ -674,18 +1010,31 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 
 	// Convenience.
 	struct comp_target *ct = r->c->target;
-#define WAIT_SEMAPHORE_COUNT 1
+#define MAX_WAIT_SEMAPHORE_COUNT 2
+#define SIGNAL_SEMAPHORE_COUNT 1
 
-	VkSemaphore wait_sems[WAIT_SEMAPHORE_COUNT] = {ct->semaphores.present_complete};
-	VkPipelineStageFlags stage_flags[WAIT_SEMAPHORE_COUNT] = {pipeline_stage_flag};
+	VkSemaphore wait_sems[MAX_WAIT_SEMAPHORE_COUNT];
+	VkPipelineStageFlags stage_flags[MAX_WAIT_SEMAPHORE_COUNT];
+	uint32_t wait_sem_count = 0;
+
+	if (ct->semaphores.present_complete != VK_NULL_HANDLE) {
+		wait_sems[wait_sem_count] = ct->semaphores.present_complete;
+		stage_flags[wait_sem_count] = pipeline_stage_flag;
+		wait_sem_count++;
+	}
+
+	// The layers were squashed on the compute queue, only the distortion reads them.
+	if (squash_complete != VK_NULL_HANDLE) {
+		wait_sems[wait_sem_count] = squash_complete;
+		stage_flags[wait_sem_count] = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		wait_sem_count++;
+	}
 
 	VkSemaphore *wait_sems_ptr = NULL;
 	VkPipelineStageFlags *stage_flags_ptr = NULL;
-	uint32_t wait_sem_count = 0;
-	if (wait_sems[0] != VK_NULL_HANDLE) {
+	if (wait_sem_count > 0) {
 		wait_sems_ptr = wait_sems;
 		stage_flags_ptr = stage_flags;
-		wait_sem_count = WAIT_SEMAPHORE_COUNT;
 	}
 
 	// Next pointer for VkSubmitInfo
@@ -693,7 +1042,7 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 
 #ifdef VK_KHR_timeline_semaphore
 	assert(!comp_frame_is_invalid_locked(&r->c->frame.rendering));
-	uint64_t render_complete_signal_values[WAIT_SEMAPHORE_COUNT] = {(uint64_t)frame_id};
+	uint64_t render_complete_signal_values[SIGNAL_SEMAPHORE_COUNT] = {(uint64_t)frame_id};
 
 	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
 	    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
@@ -702,7 +1051,7 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	if (ct->semaphores.render_complete_is_timeline) {
 		timeline_info = (VkTimelineSemaphoreSubmitInfoKHR){
 		    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
-		    .signalSemaphoreValueCount = WAIT_SEMAPHORE_COUNT,
+		    .signalSemaphoreValueCount = SIGNAL_SEMAPHORE_COUNT,
 		    .pSignalSemaphoreValues = render_complete_signal_values,
 		};
 
@@ -719,7 +1068,7 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	    .waitSemaphoreCount = wait_sem_count,
 	    .commandBufferCount = 1,
 	    .pCommandBuffers = &cmd,
-	    .signalSemaphoreCount = 1,
+	    .signalSemaphoreCount = SIGNAL_SEMAPHORE_COUNT,
 	    .pSignalSemaphores = &ct->semaphores.render_complete,
 	};
 
@@ -746,6 +1095,65 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	return ret;
 }
 
+/*!
+ * With the layers squashed on the compute queue only the distortion is left
+ * for the main queue. Hold it back so it is done just before the frame is
+ * to be presented, going by how long it took last frame, the pose it latches
+ * is then that much fresher. The squash runs while we wait here, and if it
+ * isn't done in time the main queue waits on it anyway, so this never makes
+ * the frame later than submitting straight away.
+ */
+static void
+renderer_wait_for_late_distortion(struct comp_renderer *r)
+{
+	COMP_TRACE_MARKER();
+
+	uint64_t distortion_ns = r->last_distortion_ns;
+	if (distortion_ns == 0) {
+		// No timestamps, no idea how late is safe.
+		return;
+	}
+
+	uint64_t desired_present_time_ns = r->c->frame.rendering.desired_present_time_ns;
+	uint64_t budget_ns = r->c->frame.rendering.present_slop_ns + distortion_ns + ASYNC_DISTORTION_MARGIN_NS;
+	if (desired_present_time_ns <= budget_ns) {
+		return;
+	}
+
+	uint64_t start_ns = desired_present_time_ns - budget_ns;
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (start_ns <= now_ns) {
+		return;
+	}
+
+	os_nanosleep((int64_t)(start_ns - now_ns));
+}
+
+/*!
+ * Submits the layer squash to the compute queue, signals
+ * @ref comp_renderer::squash_complete that the main queue submit waits on.
+ */
+static XRT_CHECK_RESULT VkResult
+renderer_submit_async_compute(struct comp_renderer *r, VkCommandBuffer cmd)
+{
+	COMP_TRACE_MARKER();
+
+	struct vk_bundle *vk = &r->c->base.vk;
+
+	assert(r->squash_complete != VK_NULL_HANDLE);
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd,
+	    .signalSemaphoreCount = 1,
+	    .pSignalSemaphores = &r->squash_complete,
+	};
+
+	// Same as above, the pool is only accessed from this thread.
+	return vk_cmd_submit_compute_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+}
+
 static void
 renderer_acquire_swapchain_image(struct comp_renderer *r)
 {
@@ -838,14 +1246,15 @@ renderer_fini(struct comp_renderer *r)
 	comp_mirror_fini(&r->mirror_to_debug_gui, vk);
 
 	// Do this after the layer renderer.
-	for (uint32_t i = 0; i < ARRAY_SIZE(r->scratch.views); i++) {
-		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
-			render_gfx_target_resources_close(&r->scratch.views[i].targets[k]);
-		}
-	}
+	renderer_close_scratch_targets(r);
 
 	// Do this after the layer renderer and targert resources.
 	render_gfx_render_pass_close(&r->scratch_render_pass);
+
+	if (r->squash_complete != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, r->squash_complete, NULL);
+		r->squash_complete = VK_NULL_HANDLE;
+	}
 }
 
 
@@ -866,6 +1275,10 @@ dispatch_graphics(struct comp_renderer *r,
 {
 	COMP_TRACE_MARKER();
 
+	// The compute squash reuse doesn't know about the graphics path.
+	r->last_squash[0].valid = false;
+	r->last_squash[1].valid = false;
+
 	struct comp_compositor *c = r->c;
 	struct vk_bundle *vk = &c->base.vk;
 	VkResult ret;
@@ -967,8 +1380,11 @@ dispatch_graphics(struct comp_renderer *r,
 	// Make the command buffer submittable.
 	render_gfx_end(rr);
 
+	// Freshest possible pose for the timewarp.
+	renderer_late_latch(r, fov_source, &rr->late_latch);
+
 	// Everything is ready, submit to the queue.
-	ret = renderer_submit_queue(r, rr->r->cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	ret = renderer_submit_queue(r, rr->r->cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_NULL_HANDLE);
 	VK_CHK_AND_RET(ret, "renderer_submit_queue");
 
 	return ret;
@@ -981,6 +1397,69 @@ dispatch_graphics(struct comp_renderer *r,
  *
  */
 
+static bool
+foveation_equal(const struct comp_render_foveation_data *a, const struct comp_render_foveation_data *b)
+{
+	if (a->enabled != b->enabled) {
+		return false;
+	}
+
+	// The rest is not used when disabled.
+	if (!a->enabled) {
+		return true;
+	}
+
+	return a->center.x == b->center.x && a->center.y == b->center.y && a->radius == b->radius;
+}
+
+/*!
+ * Can the squashed layers in the last scratch image of the view be used again.
+ * The layers needs to be unchanged, and so does everything in @p state. The
+ * world pose only matters if any of the layers isn't view space, as only those
+ * depend on where the head is.
+ */
+static bool
+can_reuse_last_squash(struct comp_renderer *r,
+                      uint32_t view_index,
+                      bool fast_path,
+                      const struct squash_view_state *state)
+{
+	struct comp_compositor *c = r->c;
+	const struct comp_layer *layers = c->base.slot.layers;
+	uint32_t layer_count = c->base.slot.layer_count;
+	const struct squash_view_state *last = &r->last_squash[view_index].state;
+
+	if (!r->last_squash[view_index].valid || !c->base.slot.data.layers_unchanged || fast_path ||
+	    layer_count == 0) {
+		return false;
+	}
+
+#ifdef XRT_FEATURE_WINDOW_PEEK
+	// The peek window changes the layout of the scratch images.
+	if (c->peek != NULL) {
+		return false;
+	}
+#endif
+
+	bool all_view_space = true;
+	for (uint32_t i = 0; i < layer_count; i++) {
+		if ((layers[i].data.flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) == 0) {
+			all_view_space = false;
+			break;
+		}
+	}
+
+	if (!all_view_space && memcmp(&last->world_pose, &state->world_pose, sizeof(state->world_pose)) != 0) {
+		return false;
+	}
+
+	return memcmp(&last->eye_pose, &state->eye_pose, sizeof(state->eye_pose)) == 0 &&
+	       memcmp(&last->fov, &state->fov, sizeof(state->fov)) == 0 &&
+	       memcmp(&last->pre_transform, &state->pre_transform, sizeof(state->pre_transform)) == 0 &&
+	       memcmp(last->hidden_rows, state->hidden_rows, sizeof(state->hidden_rows)) == 0 &&
+	       foveation_equal(&last->foveation, &state->foveation);
+}
+
 /*!
  * @pre render_compute_init(crc, &c->nr)
  */
@@ -1013,6 +1492,43 @@ dispatch_compute(struct comp_renderer *r,
 	    world_poses, // world_poses[2]
 	    eye_poses);  // eye_poses[2]
 
+	// Everything the squash of each view depends on, the fast path doesn't squash.
+	struct xrt_normalized_rect pre_transforms[2];
+	for (uint32_t i = 0; i < 2; i++) {
+		render_calc_uv_to_tangent_lengths_rect(&fovs[i], &pre_transforms[i]);
+	}
+
+	struct comp_render_foveation_data foveation[2];
+	calc_foveation_data( //
+	    r,               // r
+	    world_poses,     // world_poses
+	    pre_transforms,  // pre_transforms
+	    foveation);      // out_foveation
+
+	// Don't squash what can't be seen through the lenses.
+	uint32_t hidden_rows[2][RENDER_VISIBILITY_GRID_SIZE];
+	calc_visibility_data(r, fovs, hidden_rows);
+
+	// Each view keeps the squash in its last scratch image if nothing it depends on changed.
+	struct squash_view_state states[2];
+	bool reuse_squash[2];
+	for (uint32_t i = 0; i < 2; i++) {
+		U_ZERO(&states[i]);
+		states[i].world_pose = world_poses[i];
+		states[i].eye_pose = eye_poses[i];
+		states[i].fov = fovs[i];
+		states[i].pre_transform = pre_transforms[i];
+		states[i].foveation = foveation[i];
+		memcpy(states[i].hidden_rows, hidden_rows[i], sizeof(hidden_rows[i]));
+
+		reuse_squash[i] = can_reuse_last_squash(r, i, fast_path, &states[i]) &&
+		                  comp_scratch_single_images_reuse_last(&c->scratch.views[i], &crss->views[i].index);
+
+		// Only valid again once everything has been submitted.
+		r->last_squash[i].valid = false;
+	}
+	bool reuse_all_squashes = reuse_squash[0] && reuse_squash[1];
+
 	// Target Vulkan resources..
 	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
 	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
@@ -1030,6 +1546,9 @@ dispatch_compute(struct comp_renderer *r,
 	    fast_path,               // fast_path
 	    do_timewarp);            // do_timewarp
 
+	// Only the fast path with a depth layer can use it.
+	data.do_positional_timewarp = do_timewarp && r->settings->positional_timewarp;
+
 	for (uint32_t i = 0; i < 2; i++) {
 		// Which image of the scratch images for this view are we using.
 		uint32_t scratch_index = crss->views[i].index;
@@ -1070,26 +1589,94 @@ dispatch_compute(struct comp_renderer *r,
 		}
 	}
 
+	for (uint32_t i = 0; i < 2; i++) {
+		data.views[i].cs.foveation = foveation[i];
+		memcpy(data.views[i].cs.hidden_rows, hidden_rows[i], sizeof(hidden_rows[i]));
+		data.views[i].cs.squash_reused = reuse_squash[i];
+	}
+
+	/*
+	 * If we have the async compute queue the layers are squashed on it,
+	 * and the main queue only has the distortion which waits on the
+	 * squash. The fast path doesn't squash so it can't use it.
+	 */
+	VkSemaphore squash_complete = VK_NULL_HANDLE;
+	if (r->squash_complete != VK_NULL_HANDLE && !fast_path && layer_count > 0 && !reuse_all_squashes) {
+		squash_complete = r->squash_complete;
+	}
+
+	if (squash_complete != VK_NULL_HANDLE) {
+		render_compute_begin_async(crc);
+
+		// Leave the scratch images ready for the distortion, skips the reused ones.
+		comp_render_cs_layers(                         //
+		    crc,                                       // crc
+		    layers,                                    // layers
+		    layer_count,                               // layer_count
+		    &data,                                     // d
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL); // transition_to
+
+		render_compute_end_async(crc);
+
+		// Get the squash going as soon as possible.
+		ret = renderer_submit_async_compute(r, r->c->nr.async_compute_cmd);
+		VK_CHK_AND_RET(ret, "renderer_submit_async_compute");
+
+		// The squash runs on the GPU meanwhile, the distortion below is recorded and latched late.
+		renderer_wait_for_late_distortion(r);
+	}
+
 	// Start the compute pipeline.
 	render_compute_begin(crc);
 
-	// Build the command buffer.
-	comp_render_cs_dispatch( //
-	    crc,                 // crc
-	    layers,              // layers
-	    layer_count,         // layer_count
-	    &data);              // d
+	// Build the command buffer, the squash of views that are reused is skipped.
+	if (squash_complete != VK_NULL_HANDLE || reuse_all_squashes) {
+		comp_render_cs_distortion_from_scratch( //
+		    crc,                                // crc
+		    &data);                             // d
+	} else {
+		comp_render_cs_dispatch( //
+		    crc,                 // crc
+		    layers,              // layers
+		    layer_count,         // layer_count
+		    &data);              // d
+	}
 
 	// Make the command buffer submittable.
 	render_compute_end(crc);
 
+	// Freshest possible pose for the timewarp.
+	renderer_late_latch(r, fov_source, &crc->late_latch);
+
 	// Everything is ready, submit to the queue.
-	ret = renderer_submit_queue(r, crc->r->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	ret = renderer_submit_queue(r, crc->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, squash_complete);
 	VK_CHK_AND_RET(ret, "renderer_submit_queue");
 
+	// Remember what the scratch images now holds.
+	for (uint32_t i = 0; i < 2; i++) {
+		r->last_squash[i].valid = !fast_path && layer_count > 0;
+		r->last_squash[i].state = states[i];
+	}
+
 	return ret;
 }
 
+//! Oldest pose sample time of the layers in the slot, zero if none of them has one.
+static uint64_t
+get_oldest_pose_sample_ns(struct comp_compositor *c)
+{
+	uint64_t oldest_ns = 0;
+
+	for (uint32_t i = 0; i < c->base.slot.layer_count; i++) {
+		uint64_t ns = c->base.slot.layers[i].data.pose_sample_ns;
+		if (ns != 0 && (oldest_ns == 0 || ns < oldest_ns)) {
+			oldest_ns = ns;
+		}
+	}
+
+	return oldest_ns;
+}
+
 
 /*
  *
@@ -1127,6 +1714,16 @@ comp_renderer_draw(struct comp_renderer *r)
 		return XRT_SUCCESS;
 	}
 
+	// For motion to photon latency, only known if the state tracker provided it.
+	uint64_t pose_sample_ns = get_oldest_pose_sample_ns(c);
+	if (pose_sample_ns != 0) {
+		comp_target_mark_pose_sample(ct, c->frame.rendering.id, pose_sample_ns);
+	}
+
+	// What we are about to render, lets the pacing predict the next frames.
+	comp_target_info_layers(ct, c->frame.rendering.id, c->base.slot.layer_count,
+	                        c->base.slot.one_projection_layer_fast_path);
+
 	comp_target_flush(ct);
 
 	comp_target_update_timings(ct);
@@ -1142,6 +1739,9 @@ comp_renderer_draw(struct comp_renderer *r)
 	uint32_t view_count = 2;
 	enum comp_target_fov_source fov_source = COMP_TARGET_FOV_SOURCE_DISTORTION;
 
+	// Follow the performance level the app asked for, before using the scratch images.
+	renderer_ensure_scratch_extent(r);
+
 	// For sratch image debugging.
 	struct comp_render_scratch_state crss;
 	scratch_get_init(&crss, r, view_count);
@@ -1162,37 +1762,33 @@ comp_renderer_draw(struct comp_renderer *r)
 		return XRT_ERROR_VULKAN;
 	}
 
+	renderer_present_swapchain_image(r, c->frame.rendering.desired_present_time_ns,
+	                                 c->frame.rendering.present_slop_ns);
+
 #ifdef XRT_FEATURE_WINDOW_PEEK
+	// After the present so the peek window never delays the HMD.
 	if (c->peek) {
-		switch (comp_window_peek_get_eye(c->peek)) {
-		case COMP_WINDOW_PEEK_EYE_LEFT: {
-			struct comp_scratch_single_images *view = &c->scratch.views[0];
-			comp_window_peek_blit(                       //
-			    c->peek,                                 //
-			    view->images[crss.views[0].index].image, //
-			    view->info.width,                        //
-			    view->info.height);                      //
-		} break;
-		case COMP_WINDOW_PEEK_EYE_RIGHT: {
-			struct comp_scratch_single_images *view = &c->scratch.views[1];
-			comp_window_peek_blit(                       //
-			    c->peek,                                 //
-			    view->images[crss.views[1].index].image, //
-			    view->info.width,                        //
-			    view->info.height);                      //
-		} break;
-		case COMP_WINDOW_PEEK_EYE_BOTH:
-			/* TODO: display the undistorted image */
-			comp_window_peek_blit(c->peek, c->target->images[r->acquired_buffer].handle, c->target->width,
-			                      c->target->height);
-			break;
+		enum comp_window_peek_eye eye = comp_window_peek_get_eye(c->peek);
+		VkImage images[ARRAY_SIZE(c->scratch.views)];
+		VkExtent2D extents[ARRAY_SIZE(c->scratch.views)];
+		uint32_t count = 0;
+
+		for (uint32_t i = 0; i < view_count; i++) {
+			// Left and right match the view index.
+			if (eye != COMP_WINDOW_PEEK_EYE_BOTH && (uint32_t)eye != i) {
+				continue;
+			}
+
+			struct comp_scratch_single_images *view = &c->scratch.views[i];
+			images[count] = view->images[crss.views[i].index].image;
+			extents[count] = (VkExtent2D){view->info.width, view->info.height};
+			count++;
 		}
+
+		comp_window_peek_blit(c->peek, images, extents, count);
 	}
 #endif
 
-	renderer_present_swapchain_image(r, c->frame.rendering.desired_present_time_ns,
-	                                 c->frame.rendering.present_slop_ns);
-
 	// Save for timestamps below.
 	uint64_t frame_id = c->frame.rendering.id;
 	uint64_t desired_present_time_ns = c->frame.rendering.desired_present_time_ns;
@@ -1202,6 +1798,7 @@ comp_renderer_draw(struct comp_renderer *r)
 	comp_frame_clear_locked(&c->frame.rendering);
 
 	xrt_result_t xret = XRT_SUCCESS;
+	comp_mirror_retire(&r->mirror_to_debug_gui, &c->base.vk);
 	comp_mirror_fixup_ui_state(&r->mirror_to_debug_gui, c);
 	if (comp_mirror_is_ready_and_active(&r->mirror_to_debug_gui, c, predicted_display_time_ns)) {
 
@@ -1247,8 +1844,23 @@ comp_renderer_draw(struct comp_renderer *r)
 
 		uint64_t gpu_start_ns, gpu_end_ns;
 		if (render_resources_get_timestamps(&c->nr, &gpu_start_ns, &gpu_end_ns)) {
+			uint64_t stage_ns[RENDER_TIMING_STAGE_COUNT];
+			if (!render_resources_get_stage_durations(&c->nr, stage_ns)) {
+				U_ZERO_ARRAY(stage_ns);
+			}
+
+			// Only the distortion was timed if the squash was on the compute queue.
+			r->last_distortion_ns = stage_ns[RENDER_TIMING_STAGE_DISTORTION];
+
 			uint64_t now_ns = os_monotonic_get_ns();
-			comp_target_info_gpu(ct, frame_id, gpu_start_ns, gpu_end_ns, now_ns);
+			comp_target_info_gpu(                           //
+			    ct,                                         // ct
+			    frame_id,                                   // frame_id
+			    gpu_start_ns,                               // gpu_start_ns
+			    gpu_end_ns,                                 // gpu_end_ns
+			    stage_ns[RENDER_TIMING_STAGE_LAYER_SQUASH], // layer_squash_ns
+			    stage_ns[RENDER_TIMING_STAGE_DISTORTION],   // distortion_ns
+			    now_ns);                                    // when_ns
 		}
 	}
 
@@ -20,14 +20,26 @@ DEBUG_GET_ONCE_OPTION(nvidia_display, "XRT_COMPOSITOR_FORCE_NVIDIA_DISPLAY", NUL
 DEBUG_GET_ONCE_NUM_OPTION(vk_display, "XRT_COMPOSITOR_FORCE_VK_DISPLAY", -1)
 DEBUG_GET_ONCE_BOOL_OPTION(force_xcb, "XRT_COMPOSITOR_FORCE_XCB", false)
 DEBUG_GET_ONCE_BOOL_OPTION(force_wayland, "XRT_COMPOSITOR_FORCE_WAYLAND", false)
+DEBUG_GET_ONCE_BOOL_OPTION(force_offscreen, "XRT_COMPOSITOR_FORCE_OFFSCREEN", false)
 DEBUG_GET_ONCE_NUM_OPTION(force_gpu_index, "XRT_COMPOSITOR_FORCE_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(force_client_gpu_index, "XRT_COMPOSITOR_FORCE_CLIENT_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(desired_mode, "XRT_COMPOSITOR_DESIRED_MODE", -1)
 DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 140)
+DEBUG_GET_ONCE_NUM_OPTION(power_savings_scale_percentage, "XRT_COMPOSITOR_POWER_SAVINGS_SCALE_PERCENTAGE", 50)
 DEBUG_GET_ONCE_BOOL_OPTION(xcb_fullscreen, "XRT_COMPOSITOR_XCB_FULLSCREEN", false)
 DEBUG_GET_ONCE_NUM_OPTION(xcb_display, "XRT_COMPOSITOR_XCB_DISPLAY", -1)
 DEBUG_GET_ONCE_NUM_OPTION(default_framerate, "XRT_COMPOSITOR_DEFAULT_FRAMERATE", 60)
 DEBUG_GET_ONCE_BOOL_OPTION(compute, "XRT_COMPOSITOR_COMPUTE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_compute, "XRT_COMPOSITOR_ASYNC_COMPUTE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(transfer_queue, "XRT_COMPOSITOR_TRANSFER_QUEUE", true)
+DEBUG_GET_ONCE_BOOL_OPTION(late_latch, "XRT_COMPOSITOR_LATE_LATCH", false)
+DEBUG_GET_ONCE_BOOL_OPTION(descriptor_cache, "XRT_COMPOSITOR_DESCRIPTOR_CACHE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(positional_timewarp, "XRT_COMPOSITOR_POSITIONAL_TIMEWARP", false)
+DEBUG_GET_ONCE_BOOL_OPTION(visibility_mask, "XRT_COMPOSITOR_VISIBILITY_MASK", true)
+DEBUG_GET_ONCE_BOOL_OPTION(compressed_formats, "XRT_COMPOSITOR_COMPRESSED_FORMATS", false)
+DEBUG_GET_ONCE_BOOL_OPTION(mailbox, "XRT_COMPOSITOR_MAILBOX", false)
+DEBUG_GET_ONCE_TRISTATE_OPTION(foveation, "XRT_COMPOSITOR_FOVEATION")
+DEBUG_GET_ONCE_FLOAT_OPTION(foveation_radius, "XRT_COMPOSITOR_FOVEATION_RADIUS", 0.0f)
 // clang-format on
 
 static inline void
@@ -63,6 +75,13 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	}
 
 	s->use_compute = debug_get_bool_option_compute();
+	s->use_async_compute = debug_get_bool_option_async_compute();
+	s->use_transfer_queue = debug_get_bool_option_transfer_queue();
+	s->late_latch = debug_get_bool_option_late_latch();
+	s->use_descriptor_cache = debug_get_bool_option_descriptor_cache();
+	s->positional_timewarp = debug_get_bool_option_positional_timewarp();
+	s->use_visibility_mask = debug_get_bool_option_visibility_mask();
+	s->use_compressed_formats = debug_get_bool_option_compressed_formats();
 
 	if (s->use_compute) {
 		// This was the default before, keep it first.
@@ -112,6 +131,9 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	s->display = debug_get_num_option_xcb_display();
 	s->color_space = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 	s->present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	if (debug_get_bool_option_mailbox()) {
+		s->present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+	}
 	s->fullscreen = debug_get_bool_option_xcb_fullscreen();
 	s->preferred.width = xdev->hmd->screens[0].w_pixels;
 	s->preferred.height = xdev->hmd->screens[0].h_pixels;
@@ -123,6 +145,33 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	s->desired_mode = debug_get_num_option_desired_mode();
 	s->viewport_scale = debug_get_num_option_scale_percentage() / 100.0;
 
+	long power_savings_percentage = debug_get_num_option_power_savings_scale_percentage();
+	if (power_savings_percentage < 25) {
+		power_savings_percentage = 25;
+	} else if (power_savings_percentage > 100) {
+		power_savings_percentage = 100;
+	}
+	s->power_savings_scale = power_savings_percentage / 100.0;
+
+	s->foveation.enabled = xdev->hmd->foveation.enabled;
+	s->foveation.radius = xdev->hmd->foveation.radius;
+
+	switch (debug_get_tristate_option_foveation()) {
+	case DEBUG_TRISTATE_OFF: s->foveation.enabled = false; break;
+	case DEBUG_TRISTATE_ON: s->foveation.enabled = true; break;
+	case DEBUG_TRISTATE_AUTO: break;
+	}
+
+	float radius = debug_get_float_option_foveation_radius();
+	if (radius > 0.0f) {
+		s->foveation.radius = radius;
+	}
+
+	// Forced on for a device that doesn't have any values.
+	if (s->foveation.radius <= 0.0f) {
+		s->foveation.radius = 0.35f;
+	}
+
 
 	s->nvidia_display = debug_get_option_nvidia_display();
 	if (debug_get_bool_option_force_nvidia()) {
@@ -156,4 +205,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 		s->preferred.width /= 2;
 		s->preferred.height /= 2;
 	}
+	if (debug_get_bool_option_force_offscreen()) {
+		s->target_identifier = "offscreen";
+	}
 }
@@ -50,10 +50,40 @@ struct comp_settings
 
 	bool use_compute;
 
+	/*!
+	 * Squash layers on a second queue as soon as the frame starts and hold
+	 * the distortion back until just before present, only used with
+	 * @ref use_compute.
+	 */
+	bool use_async_compute;
+
+	//! Upload distortion images on a separate queue, if the device has one to spare.
+	bool use_transfer_queue;
+
+	//! Sample the head pose again just before submitting and update the timewarp.
+	bool late_latch;
+
+	//! Keep gfx descriptor sets between frames and skip unchanged layer squasher descriptor writes.
+	bool use_descriptor_cache;
+
+	//! Use app depth to also correct for head position, only used with @ref use_compute.
+	bool positional_timewarp;
+
+	//! Skip squashing the parts of the views hidden by the visibility mask, only used with @ref use_compute.
+	bool use_visibility_mask;
+
+	//! Offer block compressed swapchain formats, for static quad and cylinder layers.
+	bool use_compressed_formats;
+
 	VkFormat formats[XRT_MAX_SWAPCHAIN_FORMATS];
 	uint32_t format_count;
 
 	VkColorSpaceKHR color_space;
+
+	/*!
+	 * FIFO, or MAILBOX where the pacer alone decides when frames are
+	 * rendered, falls back to FIFO if the target doesn't support it.
+	 */
 	VkPresentModeKHR present_mode;
 
 	//! Preferred window type to use, not actual used.
@@ -74,6 +104,23 @@ struct comp_settings
 	//! Percentage to scale the viewport by.
 	double viewport_scale;
 
+	/*!
+	 * Scale of the scratch images when the app asked for the power savings
+	 * GPU performance level, relative to @ref viewport_scale. The sustained
+	 * low level uses half way between this and full size.
+	 */
+	double power_savings_scale;
+
+	//! Foveated composition, from the device and possibly overridden by the user.
+	struct
+	{
+		//! Shade the periphery of the views at a reduced rate.
+		bool enabled;
+
+		//! Radius of the full rate region, in view uv space.
+		float radius;
+	} foveation;
+
 	//! Not used with direct mode.
 	bool fullscreen;
 
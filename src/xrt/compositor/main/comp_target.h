@@ -11,6 +11,7 @@
 
 #include "xrt/xrt_compiler.h"
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_limits.h"
 
 #include "vk/vk_helpers.h"
 
@@ -40,6 +41,9 @@ enum comp_target_timing_point
 
 	//! Just after submitting work to the GPU.
 	COMP_TARGET_TIMING_POINT_SUBMIT_END,
+
+	//! When the oldest pose used by the frame's layers was sampled.
+	COMP_TARGET_TIMING_POINT_POSE_SAMPLE,
 };
 
 /*!
@@ -150,6 +154,10 @@ struct comp_target
 	//! Transformation of the current surface, required for pre-rotation
 	VkSurfaceTransformFlagBitsKHR surface_transform;
 
+	//! Refresh rates @ref set_refresh_rate can switch to, in Hz, zero if it can't.
+	uint32_t refresh_rate_count;
+	float refresh_rates_hz[XRT_MAX_SUPPORTED_REFRESH_RATES];
+
 	// Holds semaphore information.
 	struct comp_target_semaphores semaphores;
 
@@ -273,13 +281,36 @@ struct comp_target
 	 * @param[in] frame_id     The frame ID to record for.
 	 * @param[in] gpu_start_ns When the GPU work startred.
 	 * @param[in] gpu_end_ns   When the GPU work stopped.
+	 * @param[in] layer_squash_ns How long the layer squashing took on the
+	 *                            GPU, zero if not measured.
+	 * @param[in] distortion_ns   How long the distortion took on the GPU,
+	 *                            zero if not measured.
 	 * @param[in] when_ns      When the informatioon collected, nominally
 	 *                         from @ref os_monotonic_get_ns.
 	 *
 	 * @see @ref frame-pacing.
 	 */
-	void (*info_gpu)(
-	    struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns);
+	void (*info_gpu)(struct comp_target *ct,
+	                 int64_t frame_id,
+	                 uint64_t gpu_start_ns,
+	                 uint64_t gpu_end_ns,
+	                 uint64_t layer_squash_ns,
+	                 uint64_t distortion_ns,
+	                 uint64_t when_ns);
+
+	/*!
+	 * Tell the target what the compositor is rendering for a frame, so
+	 * the frame pacing can predict how long the next frames will take.
+	 *
+	 * @param[in] ct          The compositor target.
+	 * @param[in] frame_id    The frame ID to record for.
+	 * @param[in] layer_count Number of layers in the frame.
+	 * @param[in] fast_path   The single projection layer goes straight to
+	 *                        distortion, no layers are squashed.
+	 *
+	 * @see @ref frame-pacing.
+	 */
+	void (*info_layers)(struct comp_target *ct, int64_t frame_id, uint32_t layer_count, bool fast_path);
 
 	/*
 	 *
@@ -292,6 +323,16 @@ struct comp_target
 	 */
 	void (*set_title)(struct comp_target *ct, const char *title);
 
+	/*!
+	 * Optional, switch the display to one of @ref refresh_rates_hz. Takes
+	 * effect when the images are next created, which is forced by making
+	 * @ref has_images return false. Also retunes the pacing of the target,
+	 * the caller updates @ref comp_settings::nominal_frame_interval_ns.
+	 *
+	 * Must only be called from the compositor thread.
+	 */
+	bool (*set_refresh_rate)(struct comp_target *ct, float refresh_rate_hz);
+
 	/*!
 	 * Destroys this target.
 	 */
@@ -507,6 +548,21 @@ comp_target_mark_submit_end(struct comp_target *ct, int64_t frame_id, uint64_t w
 	ct->mark_timing_point(ct, COMP_TARGET_TIMING_POINT_SUBMIT_END, frame_id, when_submit_end_ns);
 }
 
+/*!
+ * Quick helper for marking pose sample.
+ * @copydoc comp_target::mark_timing_point
+ *
+ * @public @memberof comp_target
+ * @ingroup comp_main
+ */
+static inline void
+comp_target_mark_pose_sample(struct comp_target *ct, int64_t frame_id, uint64_t when_pose_sampled_ns)
+{
+	COMP_TRACE_MARKER();
+
+	ct->mark_timing_point(ct, COMP_TARGET_TIMING_POINT_POSE_SAMPLE, frame_id, when_pose_sampled_ns);
+}
+
 /*!
  * @copydoc comp_target::update_timings
  *
@@ -528,12 +584,31 @@ comp_target_update_timings(struct comp_target *ct)
  * @ingroup comp_main
  */
 static inline void
-comp_target_info_gpu(
-    struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+comp_target_info_gpu(struct comp_target *ct,
+                     int64_t frame_id,
+                     uint64_t gpu_start_ns,
+                     uint64_t gpu_end_ns,
+                     uint64_t layer_squash_ns,
+                     uint64_t distortion_ns,
+                     uint64_t when_ns)
 {
 	COMP_TRACE_MARKER();
 
-	ct->info_gpu(ct, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+	ct->info_gpu(ct, frame_id, gpu_start_ns, gpu_end_ns, layer_squash_ns, distortion_ns, when_ns);
+}
+
+/*!
+ * @copydoc comp_target::info_layers
+ *
+ * @public @memberof comp_target
+ * @ingroup comp_main
+ */
+static inline void
+comp_target_info_layers(struct comp_target *ct, int64_t frame_id, uint32_t layer_count, bool fast_path)
+{
+	COMP_TRACE_MARKER();
+
+	ct->info_layers(ct, frame_id, layer_count, fast_path);
 }
 
 /*!
@@ -550,6 +625,24 @@ comp_target_set_title(struct comp_target *ct, const char *title)
 	ct->set_title(ct, title);
 }
 
+/*!
+ * @copydoc comp_target::set_refresh_rate
+ *
+ * @public @memberof comp_target
+ * @ingroup comp_main
+ */
+static inline bool
+comp_target_set_refresh_rate(struct comp_target *ct, float refresh_rate_hz)
+{
+	COMP_TRACE_MARKER();
+
+	if (ct->set_refresh_rate == NULL) {
+		return false;
+	}
+
+	return ct->set_refresh_rate(ct, refresh_rate_hz);
+}
+
 /*!
  * @copydoc comp_target::destroy
  *
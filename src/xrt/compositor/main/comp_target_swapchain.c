@@ -13,6 +13,7 @@
 #include "util/u_misc.h"
 #include "util/u_pacing.h"
 #include "util/u_pretty_print.h"
+#include "util/u_thread_role.h"
 
 #include "vk/vk_surface_info.h"
 
@@ -24,6 +25,10 @@
 #include <inttypes.h>
 
 
+//! How many presents between each vblank event the counter estimate is anchored on.
+#define VBLANK_COUNTER_EVENT_INTERVAL (64)
+
+
 /*
  *
  * Vulkan functions.
@@ -186,9 +191,7 @@ select_image_count(struct comp_target_swapchain *cts,
 }
 
 static bool
-check_surface_present_mode(struct comp_target_swapchain *cts,
-                           const struct vk_surface_info *info,
-                           VkPresentModeKHR present_mode)
+has_surface_present_mode(const struct vk_surface_info *info, VkPresentModeKHR present_mode)
 {
 	for (uint32_t i = 0; i < info->present_mode_count; i++) {
 		if (info->present_modes[i] == present_mode) {
@@ -196,6 +199,18 @@ check_surface_present_mode(struct comp_target_swapchain *cts,
 		}
 	}
 
+	return false;
+}
+
+static bool
+check_surface_present_mode(struct comp_target_swapchain *cts,
+                           const struct vk_surface_info *info,
+                           VkPresentModeKHR present_mode)
+{
+	if (has_surface_present_mode(info, present_mode)) {
+		return true;
+	}
+
 	struct u_pp_sink_stack_only sink;
 	u_pp_delegate_t dg = u_pp_sink_stack_only_init(&sink);
 
@@ -347,7 +362,8 @@ do_update_timings_google_display_timing(struct comp_target_swapchain *cts)
 static void
 do_update_timings_vblank_thread(struct comp_target_swapchain *cts)
 {
-	if (!cts->vblank.has_started) {
+	// With the counter the events are only used as anchors for it.
+	if (!cts->vblank.has_started || cts->vblank_counter.enabled) {
 		return;
 	}
 
@@ -387,15 +403,15 @@ check_surface_counter_caps(struct comp_target *ct, struct vk_bundle *vk, struct
 	return true;
 }
 
-static uint64_t
-get_surface_counter_val(struct comp_target *ct)
+static bool
+get_surface_counter_val(struct comp_target *ct, uint64_t *out_counter_val)
 {
 	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
 	struct vk_bundle *vk = get_vk(cts);
 	VkResult ret;
 
 	if ((cts->surface.surface_counter_flags & VK_SURFACE_COUNTER_VBLANK_EXT) == 0) {
-		return 0;
+		return false;
 	}
 
 	uint64_t counter_val = 0;
@@ -409,11 +425,118 @@ get_surface_counter_val(struct comp_target *ct)
 		COMP_SPEW(cts->base.c, "vkGetSwapchainCounterEXT: %" PRIu64, counter_val);
 	} else if (ret == VK_ERROR_OUT_OF_DATE_KHR) {
 		COMP_ERROR(cts->base.c, "vkGetSwapchainCounterEXT: Swapchain out of date!");
+		return false;
 	} else {
 		COMP_ERROR(cts->base.c, "vkGetSwapchainCounterEXT: %s", vk_result_string(ret));
+		return false;
+	}
+
+	*out_counter_val = counter_val;
+
+	return true;
+}
+
+static bool
+can_use_vblank_counter(struct comp_target_swapchain *cts)
+{
+	struct vk_bundle *vk = get_vk(cts);
+
+	return vk->has_EXT_display_control &&    //
+	       cts->display != VK_NULL_HANDLE && //
+	       (cts->surface.surface_counter_flags & VK_SURFACE_COUNTER_VBLANK_EXT) != 0;
+}
+
+/*!
+ * Anchor the counter estimate on a vblank timestamp from the event thread. The
+ * counter is read after the event so it might have moved on, the vblanks that
+ * fit between the event and now are taken off to get the event's counter value.
+ */
+static void
+vblank_counter_anchor(struct comp_target_swapchain *cts, uint64_t event_ns, uint64_t counter, uint64_t now_ns)
+{
+	uint64_t period_ns = cts->vblank_counter.period_ns;
+	uint64_t since = now_ns > event_ns ? (now_ns - event_ns) / period_ns : 0;
+	if (since > counter) {
+		return;
+	}
+
+	uint64_t event_counter = counter - since;
+
+	if (cts->vblank_counter.has_anchor &&                     //
+	    event_counter > cts->vblank_counter.anchor_counter && //
+	    event_ns > cts->vblank_counter.anchor_ns) {
+		// The anchors are many vblanks apart, so the timestamp jitter is spread over all of them.
+		uint64_t count = event_counter - cts->vblank_counter.anchor_counter;
+		uint64_t fitted_ns = (event_ns - cts->vblank_counter.anchor_ns) / count;
+		uint64_t nominal_ns = cts->base.c->settings.nominal_frame_interval_ns;
+
+		// A missed event gives a period twice as long, leave it alone.
+		if (fitted_ns > nominal_ns - nominal_ns / 8 && fitted_ns < nominal_ns + nominal_ns / 8) {
+			cts->vblank_counter.period_ns = (period_ns * 3 + fitted_ns) / 4;
+		}
+	}
+
+	cts->vblank_counter.has_anchor = true;
+	cts->vblank_counter.anchor_counter = event_counter;
+	cts->vblank_counter.anchor_ns = event_ns;
+}
+
+/*!
+ * Estimate the time of the last vblank from the swapchain vblank counter, this
+ * lets the vblank event thread only be woken up now and then instead of on
+ * every frame.
+ *
+ * The estimate is the last real vblank timestamp stepped forward by the fitted
+ * period for each vblank counted since, so it doesn't depend on how late the
+ * compositor thread gets around to reading the counter.
+ */
+static void
+do_update_timings_vblank_counter(struct comp_target_swapchain *cts)
+{
+	if (!cts->vblank_counter.enabled || cts->swapchain.handle == VK_NULL_HANDLE) {
+		return;
+	}
+
+	uint64_t event_ns = 0;
+	if (cts->vblank.has_started) {
+		os_thread_helper_lock(&cts->vblank.event_thread);
+		event_ns = cts->vblank.last_vblank_ns;
+		cts->vblank.last_vblank_ns = 0;
+		os_thread_helper_unlock(&cts->vblank.event_thread);
+	}
+
+	uint64_t counter = 0;
+	if (!get_surface_counter_val(&cts->base, &counter)) {
+		return;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// The counter was reset by a new swapchain, wait for a new anchor.
+	if (cts->vblank_counter.has_anchor && counter < cts->vblank_counter.anchor_counter) {
+		cts->vblank_counter.has_anchor = false;
+	}
+
+	if (event_ns != 0) {
+		vblank_counter_anchor(cts, event_ns, counter, now_ns);
+	}
+
+	// Nothing to go on yet or still the same vblank, nothing new to learn.
+	if (!cts->vblank_counter.has_anchor || counter == cts->vblank_counter.last_counter) {
+		return;
+	}
+
+	uint64_t count = counter - cts->vblank_counter.anchor_counter;
+	uint64_t vblank_ns = cts->vblank_counter.anchor_ns + count * cts->vblank_counter.period_ns;
+
+	cts->vblank_counter.last_counter = counter;
+
+	// Only off by the jitter of the anchor, but never tell the pacer about a vblank in the future.
+	if (vblank_ns > now_ns) {
+		return;
 	}
 
-	return counter_val;
+	u_pc_update_vblank_from_display_control(cts->upc, vblank_ns);
 }
 
 static bool
@@ -459,7 +582,8 @@ vblank_event_func(struct comp_target *ct, uint64_t *out_timestamp_ns)
 		 * and is currently not used by the code so skip for now.
 		 */
 #if 0
-		uint64_t counter_val = get_surface_counter_val(ct);
+		uint64_t counter_val = 0;
+		get_surface_counter_val(ct, &counter_val);
 
 		static uint64_t last_ns = 0;
 		uint64_t diff_ns = now_ns - last_ns;
@@ -499,6 +623,9 @@ run_vblank_event_thread(void *ptr)
 	os_thread_helper_name(&cts->vblank.event_thread, "VBlank Events");
 	U_TRACE_SET_THREAD_NAME("VBlank Events");
 
+	// Late vblank timestamps make the compositor pacing worse.
+	u_thread_role_apply(U_THREAD_ROLE_COMPOSITOR, ct->c->settings.log_level, "VBlank Events");
+
 	os_thread_helper_lock(&cts->vblank.event_thread);
 
 	while (os_thread_helper_is_running_locked(&cts->vblank.event_thread)) {
@@ -637,6 +764,16 @@ comp_target_swapchain_create_images(struct comp_target *ct, const struct comp_ta
 
 	VkSwapchainKHR old_swapchain_handle = cts->swapchain.handle;
 
+	// Switching display mode, the old swapchain can't be reused with the new surface.
+	if (cts->surface.pending != VK_NULL_HANDLE) {
+		destroy_old(cts, old_swapchain_handle);
+		old_swapchain_handle = VK_NULL_HANDLE;
+
+		vk->vkDestroySurfaceKHR(vk->instance, cts->surface.handle, NULL);
+		cts->surface.handle = cts->surface.pending;
+		cts->surface.pending = VK_NULL_HANDLE;
+	}
+
 	cts->base.image_count = 0;
 	cts->swapchain.handle = VK_NULL_HANDLE;
 	cts->present_mode = create_info->present_mode;
@@ -670,6 +807,12 @@ comp_target_swapchain_create_images(struct comp_target *ct, const struct comp_ta
 		goto error_print_and_free;
 	}
 
+	// MAILBOX is only a preference, FIFO is always supported.
+	if (cts->present_mode == VK_PRESENT_MODE_MAILBOX_KHR && !has_surface_present_mode(&info, cts->present_mode)) {
+		COMP_INFO(ct->c, "Surface doesn't support MAILBOX present mode, using FIFO.");
+		cts->present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	}
+
 	// Check that the present mode is supported.
 	if (!check_surface_present_mode(cts, &info, cts->present_mode)) {
 		goto error_print_and_free;
@@ -726,8 +869,13 @@ comp_target_swapchain_create_images(struct comp_target *ct, const struct comp_ta
 	 * When not in direct mode and display to a composited window we
 	 * probably want 3, but most compositors on Linux sets the minImageCount
 	 * to 3 anyways so we get what we want.
+	 *
+	 * With MAILBOX the acquire never blocks, the pacer alone decides when
+	 * we render and a newer frame replaces a queued one instead of adding
+	 * a refresh of latency. Needs 3 so that one image can be scanned out,
+	 * one queued and one rendered to.
 	 */
-	const uint32_t preferred_at_least_image_count = 2;
+	const uint32_t preferred_at_least_image_count = cts->present_mode == VK_PRESENT_MODE_MAILBOX_KHR ? 3 : 2;
 
 	// Get the image count.
 	uint32_t image_count = select_image_count(cts, surface_caps, preferred_at_least_image_count);
@@ -793,6 +941,17 @@ comp_target_swapchain_create_images(struct comp_target *ct, const struct comp_ta
 		COMP_ERROR(ct->c, "Failed to query surface counter capabilities");
 	}
 
+	// Can't trust the old counter values, start the estimate over.
+	cts->vblank_counter.has_anchor = false;
+	cts->vblank_counter.last_counter = 0;
+	cts->vblank_counter.presents_since_event = 0;
+	cts->vblank_counter.period_ns = ct->c->settings.nominal_frame_interval_ns;
+	cts->vblank_counter.enabled = can_use_vblank_counter(cts);
+
+	if (cts->vblank_counter.enabled) {
+		COMP_INFO(ct->c, "Using swapchain vblank counter, anchored on vblank events.");
+	}
+
 	if (vk->has_EXT_display_control && cts->display != VK_NULL_HANDLE) {
 		if (cts->vblank.has_started) {
 			// Already running.
@@ -819,7 +978,8 @@ static bool
 comp_target_swapchain_has_images(struct comp_target *ct)
 {
 	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
-	return cts->surface.handle != VK_NULL_HANDLE && cts->swapchain.handle != VK_NULL_HANDLE;
+	return cts->surface.handle != VK_NULL_HANDLE && cts->swapchain.handle != VK_NULL_HANDLE &&
+	       cts->surface.pending == VK_NULL_HANDLE;
 }
 
 static VkResult
@@ -842,6 +1002,28 @@ comp_target_swapchain_acquire_next_image(struct comp_target *ct, uint32_t *out_i
 	    out_index);                            // pImageIndex
 }
 
+#ifdef VK_EXT_display_control
+/*!
+ * Should the event thread wait for the next vblank, always unless the counter
+ * is used, then only until it has an anchor and after that every so often.
+ */
+static bool
+want_vblank_event(struct comp_target_swapchain *cts)
+{
+	if (!cts->vblank_counter.enabled || !cts->vblank_counter.has_anchor) {
+		return true;
+	}
+
+	if (++cts->vblank_counter.presents_since_event < VBLANK_COUNTER_EVENT_INTERVAL) {
+		return false;
+	}
+
+	cts->vblank_counter.presents_since_event = 0;
+
+	return true;
+}
+#endif
+
 static VkResult
 comp_target_swapchain_present(struct comp_target *ct,
                               VkQueue queue,
@@ -885,7 +1067,7 @@ comp_target_swapchain_present(struct comp_target *ct,
 
 
 #ifdef VK_EXT_display_control
-	if (cts->vblank.has_started) {
+	if (cts->vblank.has_started && want_vblank_event(cts)) {
 		os_thread_helper_lock(&cts->vblank.event_thread);
 		if (!cts->vblank.should_wait) {
 			cts->vblank.should_wait = true;
@@ -972,32 +1154,57 @@ comp_target_swapchain_mark_timing_point(struct comp_target *ct,
 	case COMP_TARGET_TIMING_POINT_SUBMIT_END:
 		u_pc_mark_point(cts->upc, U_TIMING_POINT_SUBMIT_END, cts->current_frame_id, when_ns);
 		break;
+	case COMP_TARGET_TIMING_POINT_POSE_SAMPLE:
+		u_pc_mark_point(cts->upc, U_TIMING_POINT_POSE_SAMPLE, cts->current_frame_id, when_ns);
+		break;
 	default: assert(false);
 	}
 }
 
-static VkResult
+VkResult
 comp_target_swapchain_update_timings(struct comp_target *ct)
 {
 	COMP_TRACE_MARKER();
 
 	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
 
+	/*
+	 * All of these bail out early if the target doesn't support them, when
+	 * the counter is used it takes the events from the thread.
+	 */
 	do_update_timings_google_display_timing(cts);
+#if defined(VK_EXT_display_surface_counter) && defined(VK_EXT_display_control)
+	do_update_timings_vblank_counter(cts);
+#endif
 	do_update_timings_vblank_thread(cts);
 
 	return VK_SUCCESS;
 }
 
 static void
-comp_target_swapchain_info_gpu(
-    struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+comp_target_swapchain_info_gpu(struct comp_target *ct,
+                               int64_t frame_id,
+                               uint64_t gpu_start_ns,
+                               uint64_t gpu_end_ns,
+                               uint64_t layer_squash_ns,
+                               uint64_t distortion_ns,
+                               uint64_t when_ns)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
+
+	u_pc_info_gpu(cts->upc, frame_id, gpu_start_ns, gpu_end_ns, layer_squash_ns, distortion_ns, when_ns);
+}
+
+static void
+comp_target_swapchain_info_layers(struct comp_target *ct, int64_t frame_id, uint32_t layer_count, bool fast_path)
 {
 	COMP_TRACE_MARKER();
 
 	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
 
-	u_pc_info_gpu(cts->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+	u_pc_info_layers(cts->upc, frame_id, layer_count, fast_path);
 }
 
 
@@ -1056,6 +1263,11 @@ comp_target_swapchain_cleanup(struct comp_target_swapchain *cts)
 		cts->surface.handle = VK_NULL_HANDLE;
 	}
 
+	if (cts->surface.pending != VK_NULL_HANDLE) {
+		vk->vkDestroySurfaceKHR(vk->instance, cts->surface.pending, NULL);
+		cts->surface.pending = VK_NULL_HANDLE;
+	}
+
 	target_fini_semaphores(cts);
 
 	u_pc_destroy(&cts->upc);
@@ -1075,5 +1287,6 @@ comp_target_swapchain_init_and_set_fnptrs(struct comp_target_swapchain *cts,
 	cts->base.mark_timing_point = comp_target_swapchain_mark_timing_point;
 	cts->base.update_timings = comp_target_swapchain_update_timings;
 	cts->base.info_gpu = comp_target_swapchain_info_gpu;
+	cts->base.info_layers = comp_target_swapchain_info_layers;
 	os_thread_helper_init(&cts->vblank.event_thread);
 }
@@ -71,6 +71,13 @@ struct comp_target_swapchain
 	struct
 	{
 		VkSurfaceKHR handle;
+
+		/*!
+		 * Surface for a new display mode, replaces @p handle before the
+		 * next swapchain is created. Set by sub-classes that switch modes.
+		 */
+		VkSurfaceKHR pending;
+
 		VkSurfaceFormatKHR format;
 #ifdef VK_EXT_display_surface_counter
 		VkSurfaceCounterFlagsEXT surface_counter_flags;
@@ -100,10 +107,47 @@ struct comp_target_swapchain
 		//! Protected by event_thread lock.
 		uint64_t last_vblank_ns;
 
-		//! Thread waiting on vblank_event_fence (first pixel out).
+		/*!
+		 * Thread waiting on vblank_event_fence (first pixel out), one
+		 * per target. The compositor only drives a single target, and
+		 * with the vblank counter it is only woken up every
+		 * VBLANK_COUNTER_EVENT_INTERVAL presents. A thread shared
+		 * between targets would have to wait on fences from different
+		 * displays and devices at once, so it is kept per target.
+		 */
 		struct os_thread_helper event_thread;
 	} vblank;
 
+	/*!
+	 * Vblank time estimate from the swapchain vblank counter, when it is
+	 * available the event thread is only woken up now and then to give a
+	 * real vblank timestamp to anchor the estimate on. Only accessed from
+	 * the main compositor thread.
+	 */
+	struct
+	{
+		//! The display and surface supports the vblank counter.
+		bool enabled;
+
+		//! Has @p anchor_ns been set since the swapchain was created.
+		bool has_anchor;
+
+		//! Counter value of the vblank at @p anchor_ns.
+		uint64_t anchor_counter;
+
+		//! Timestamp of a vblank from the event thread.
+		uint64_t anchor_ns;
+
+		//! Period fitted between anchors, starts at the nominal frame interval.
+		uint64_t period_ns;
+
+		//! Last counter value an estimate was given for.
+		uint64_t last_counter;
+
+		//! Presents since the event thread was last asked for a vblank.
+		uint32_t presents_since_event;
+	} vblank_counter;
+
 	/*!
 	 * We print swapchain info as INFO the first time we create a
 	 * VkSWapchain, this keeps track if we have done it.
@@ -167,6 +211,18 @@ comp_target_swapchain_override_extents(struct comp_target_swapchain *cts, VkExte
 void
 comp_target_swapchain_cleanup(struct comp_target_swapchain *cts);
 
+/*!
+ * The @ref comp_target::update_timings function set by
+ * @ref comp_target_swapchain_init_and_set_fnptrs, for subclasses that feed
+ * the pacer timing of their own before calling it.
+ *
+ * @protected @memberof comp_target_swapchain
+ *
+ * @ingroup comp_main
+ */
+VkResult
+comp_target_swapchain_update_timings(struct comp_target *ct);
+
 
 #ifdef __cplusplus
 }
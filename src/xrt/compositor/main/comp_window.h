@@ -14,6 +14,7 @@
 #include "main/comp_compositor.h"
 
 #include "xrt/xrt_config_os.h"
+#include "xrt/xrt_config_have.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -103,6 +104,32 @@ comp_window_vk_display_create(struct comp_compositor *c);
 extern const struct comp_target_factory comp_target_factory_vk_display;
 #endif // 1
 
+#ifdef XRT_HAVE_KMS
+/*!
+ * Create a direct mode target to an HMD using atomic DRM/KMS commits, on a
+ * DRM lease or a device node.
+ *
+ * @ingroup comp_main
+ * @public @memberof comp_window_direct_kms
+ */
+struct comp_target *
+comp_window_direct_kms_create(struct comp_compositor *c);
+
+extern const struct comp_target_factory comp_target_factory_direct_kms;
+#endif // XRT_HAVE_KMS
+
+/*!
+ * Create a target that renders to images that are never shown, for running
+ * the compositor without any display, like for benchmarking.
+ *
+ * @ingroup comp_main
+ * @public @memberof comp_window_offscreen
+ */
+struct comp_target *
+comp_window_offscreen_create(struct comp_compositor *c);
+
+extern const struct comp_target_factory comp_target_factory_offscreen;
+
 #ifdef XRT_OS_ANDROID
 /*!
  * Create a surface to an HMD on Android.
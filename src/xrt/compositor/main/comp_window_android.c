@@ -11,7 +11,12 @@
 
 #include "xrt/xrt_compiler.h"
 
+#include "os/os_threading.h"
+
 #include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_pacing.h"
+#include "util/u_trace_marker.h"
 
 #include "android/android_globals.h"
 #include "android/android_custom_surface.h"
@@ -19,8 +24,11 @@
 #include "main/comp_window.h"
 
 #include <android/native_window.h>
+#include <android/choreographer.h>
+#include <android/looper.h>
 
 #include <poll.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +36,9 @@
 
 #define WINDOW_TITLE "Monado"
 
+DEBUG_GET_ONCE_BOOL_OPTION(android_choreographer, "XRT_COMPOSITOR_ANDROID_CHOREOGRAPHER", true)
+DEBUG_GET_ONCE_BOOL_OPTION(android_display_timing, "XRT_COMPOSITOR_ANDROID_DISPLAY_TIMING", false)
+
 /*
  *
  * Private structs.
@@ -44,9 +55,111 @@ struct comp_window_android
 	struct comp_target_swapchain base;
 
 	struct android_custom_surface *custom_surface;
+
+	//! Vsync timing from the choreographer, which calls us on a looper thread of our own.
+	struct
+	{
+		struct os_thread_helper oth;
+
+		//! Protected by @ref oth, zero once handed to the pacer.
+		uint64_t last_vblank_ns;
+
+		//! Protected by @ref oth, zero once handed to the pacer.
+		uint64_t frame_period_ns;
+	} vsync;
 };
 
 
+/*
+ *
+ * Choreographer functions.
+ *
+ */
+
+#if __ANDROID_API__ >= 29
+static void
+vsync_frame_callback(int64_t frame_time_ns, void *data)
+{
+	struct comp_window_android *cwa = (struct comp_window_android *)data;
+
+	// Same clock as os_monotonic_get_ns, so it can be used directly.
+	os_thread_helper_lock(&cwa->vsync.oth);
+	cwa->vsync.last_vblank_ns = (uint64_t)frame_time_ns;
+	os_thread_helper_unlock(&cwa->vsync.oth);
+
+	// Callbacks are one shot, ask for the next vsync.
+	AChoreographer_postFrameCallback64(AChoreographer_getInstance(), vsync_frame_callback, cwa);
+}
+#endif
+
+#if __ANDROID_API__ >= 30
+static void
+vsync_refresh_rate_callback(int64_t vsync_period_ns, void *data)
+{
+	struct comp_window_android *cwa = (struct comp_window_android *)data;
+
+	COMP_INFO(cwa->base.base.c, "Display refresh period is now %" PRId64 "ns", vsync_period_ns);
+
+	os_thread_helper_lock(&cwa->vsync.oth);
+	cwa->vsync.frame_period_ns = (uint64_t)vsync_period_ns;
+	os_thread_helper_unlock(&cwa->vsync.oth);
+}
+#endif
+
+static void *
+vsync_thread_func(void *ptr)
+{
+	struct comp_window_android *cwa = (struct comp_window_android *)ptr;
+
+	os_thread_helper_name(&cwa->vsync.oth, "Choreographer");
+	U_TRACE_SET_THREAD_NAME("Choreographer");
+
+#if __ANDROID_API__ >= 29
+	// The choreographer delivers its callbacks on the looper of the thread that got it.
+	ALooper_prepare(0);
+	AChoreographer *choreographer = AChoreographer_getInstance();
+	if (choreographer == NULL) {
+		COMP_ERROR(cwa->base.base.c, "AChoreographer_getInstance failed, no vsync timing");
+		return NULL;
+	}
+
+	AChoreographer_postFrameCallback64(choreographer, vsync_frame_callback, cwa);
+#if __ANDROID_API__ >= 30
+	// Also called right away with the current period.
+	AChoreographer_registerRefreshRateCallback(choreographer, vsync_refresh_rate_callback, cwa);
+#endif
+
+	// Callbacks are dispatched from in here, the timeout is only for noticing being stopped.
+	while (os_thread_helper_is_running(&cwa->vsync.oth)) {
+		ALooper_pollOnce(100, NULL, NULL, NULL);
+	}
+
+#if __ANDROID_API__ >= 30
+	AChoreographer_unregisterRefreshRateCallback(choreographer, vsync_refresh_rate_callback, cwa);
+#endif
+#endif
+
+	return NULL;
+}
+
+static void
+vsync_start(struct comp_window_android *cwa)
+{
+#if __ANDROID_API__ >= 29
+	if (!debug_get_bool_option_android_choreographer()) {
+		return;
+	}
+
+	int ret = os_thread_helper_start(&cwa->vsync.oth, vsync_thread_func, cwa);
+	if (ret != 0) {
+		COMP_ERROR(cwa->base.base.c, "Failed to start choreographer thread: %d", ret);
+	}
+#else
+	COMP_INFO(cwa->base.base.c, "Built for API level %d, AChoreographer vsync timing needs 29", __ANDROID_API__);
+#endif
+}
+
+
 /*
  *
  * Functions.
@@ -72,6 +185,9 @@ comp_window_android_destroy(struct comp_target *ct)
 {
 	struct comp_window_android *cwa = (struct comp_window_android *)ct;
 
+	// Stops the thread if it was started.
+	os_thread_helper_destroy(&cwa->vsync.oth);
+
 	comp_target_swapchain_cleanup(&cwa->base);
 
 	android_custom_surface_destroy(&cwa->custom_surface);
@@ -177,6 +293,8 @@ comp_window_android_init_swapchain(struct comp_target *ct, uint32_t width, uint3
 		return false;
 	}
 
+	vsync_start(cwa);
+
 	return true;
 }
 
@@ -186,13 +304,54 @@ comp_window_android_flush(struct comp_target *ct)
 	(void)ct;
 }
 
+static VkResult
+comp_window_android_update_timings(struct comp_target *ct)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_window_android *cwa = (struct comp_window_android *)ct;
+
+	// The pacer is created with the swapchain images, keep the values until then.
+	if (cwa->base.upc == NULL) {
+		return comp_target_swapchain_update_timings(ct);
+	}
+
+	os_thread_helper_lock(&cwa->vsync.oth);
+	uint64_t last_vblank_ns = cwa->vsync.last_vblank_ns;
+	uint64_t frame_period_ns = cwa->vsync.frame_period_ns;
+	cwa->vsync.last_vblank_ns = 0;
+	cwa->vsync.frame_period_ns = 0;
+	os_thread_helper_unlock(&cwa->vsync.oth);
+
+	if (frame_period_ns != 0) {
+		u_pc_update_frame_period(cwa->base.upc, frame_period_ns);
+	}
+	if (last_vblank_ns != 0) {
+		u_pc_update_vblank_from_display_control(cwa->base.upc, last_vblank_ns);
+	}
+
+	return comp_target_swapchain_update_timings(ct);
+}
+
 struct comp_target *
 comp_window_android_create(struct comp_compositor *c)
 {
 	struct comp_window_android *w = U_TYPED_CALLOC(struct comp_window_android);
 
-	// The display timing code hasn't been tested on Android and may be broken.
-	comp_target_swapchain_init_and_set_fnptrs(&w->base, COMP_TARGET_FORCE_FAKE_DISPLAY_TIMING);
+	if (os_thread_helper_init(&w->vsync.oth) != 0) {
+		COMP_ERROR(c, "Failed to init choreographer thread helper");
+		free(w);
+		return NULL;
+	}
+
+	/*
+	 * The display timing code hasn't been well tested on Android, by default
+	 * the fake pacer is used and locked to the vsync from the choreographer.
+	 */
+	enum comp_target_display_timing_usage timing_usage = debug_get_bool_option_android_display_timing()
+	                                                         ? COMP_TARGET_USE_DISPLAY_IF_AVAILABLE
+	                                                         : COMP_TARGET_FORCE_FAKE_DISPLAY_TIMING;
+	comp_target_swapchain_init_and_set_fnptrs(&w->base, timing_usage);
 
 	w->base.base.name = "Android";
 	w->base.base.destroy = comp_window_android_destroy;
@@ -200,6 +359,7 @@ comp_window_android_create(struct comp_compositor *c)
 	w->base.base.init_pre_vulkan = comp_window_android_init;
 	w->base.base.init_post_vulkan = comp_window_android_init_swapchain;
 	w->base.base.set_title = comp_window_android_update_window_title;
+	w->base.base.update_timings = comp_window_android_update_timings;
 	w->base.base.c = c;
 
 	return &w->base.base;
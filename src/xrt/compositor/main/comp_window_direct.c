@@ -9,10 +9,12 @@
  */
 
 #include <inttypes.h>
+#include <math.h>
 
 #include "comp_window_direct.h"
 
 #include "util/u_misc.h"
+#include "util/u_pacing.h"
 
 
 static inline struct vk_bundle *
@@ -74,6 +76,35 @@ print_modes(struct comp_target *ct, VkDisplayModePropertiesKHR *mode_properties,
 	COMP_PRINT_MODE(ct->c, "Listed %d modes", mode_count);
 }
 
+//! All modes the same size as @p chosen can be switched between without changing anything else.
+static void
+fill_refresh_rates(struct comp_target *ct,
+                   const VkDisplayModePropertiesKHR *mode_properties,
+                   uint32_t mode_count,
+                   const VkDisplayModeParametersKHR *chosen)
+{
+	ct->refresh_rate_count = 0;
+
+	for (uint32_t i = 0; i < mode_count && ct->refresh_rate_count < ARRAY_SIZE(ct->refresh_rates_hz); i++) {
+		const VkDisplayModeParametersKHR *params = &mode_properties[i].parameters;
+		if (params->visibleRegion.width != chosen->visibleRegion.width ||
+		    params->visibleRegion.height != chosen->visibleRegion.height) {
+			continue;
+		}
+
+		// Same rate with different timings, only list it once.
+		float refresh_hz = (float)params->refreshRate / 1000.f;
+		bool listed = false;
+		for (uint32_t k = 0; k < ct->refresh_rate_count; k++) {
+			listed = listed || fabsf(ct->refresh_rates_hz[k] - refresh_hz) < 0.5f;
+		}
+
+		if (!listed) {
+			ct->refresh_rates_hz[ct->refresh_rate_count++] = refresh_hz;
+		}
+	}
+}
+
 static VkDisplayModeKHR
 get_primary_display_mode(struct comp_target_swapchain *cts,
                          VkDisplayKHR display,
@@ -143,6 +174,8 @@ get_primary_display_mode(struct comp_target_swapchain *cts,
 
 	ct->c->settings.nominal_frame_interval_ns = new_frame_interval;
 
+	fill_refresh_rates(ct, mode_properties, mode_count, &props.parameters);
+
 	free(mode_properties);
 
 	*out_width = props.parameters.visibleRegion.width;
@@ -164,17 +197,12 @@ choose_alpha_mode(VkDisplayPlaneAlphaFlagsKHR flags)
 }
 
 
-/*
- *
- * 'Exported' functions.
- *
- */
-
-VkResult
-comp_window_direct_create_surface(struct comp_target_swapchain *cts,
-                                  VkDisplayKHR display,
-                                  uint32_t width,
-                                  uint32_t height)
+static VkResult
+create_surface_for_mode(struct comp_target_swapchain *cts,
+                        VkDisplayModeKHR display_mode,
+                        uint32_t mode_width,
+                        uint32_t mode_height,
+                        VkSurfaceKHR *out_surface)
 {
 	struct vk_bundle *vk = get_vk(cts);
 	VkDisplayPlanePropertiesKHR *plane_properties = NULL;
@@ -200,6 +228,61 @@ comp_window_direct_create_surface(struct comp_target_swapchain *cts,
 	free(plane_properties);
 	plane_properties = NULL;
 
+	// We need the capabilities of the selected plane.
+	VkDisplayPlaneCapabilitiesKHR plane_caps;
+	vk->vkGetDisplayPlaneCapabilitiesKHR(vk->physical_device, display_mode, plane_index, &plane_caps);
+
+	VkDisplaySurfaceCreateInfoKHR surface_info = {
+	    .sType = VK_STRUCTURE_TYPE_DISPLAY_SURFACE_CREATE_INFO_KHR,
+	    .pNext = NULL,
+	    .flags = 0,
+	    .displayMode = display_mode,
+	    .planeIndex = plane_index,
+	    .planeStackIndex = plane_stack_index,
+	    .transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR,
+	    .globalAlpha = 1.0,
+	    .alphaMode = choose_alpha_mode(plane_caps.supportedAlpha),
+	    .imageExtent =
+	        {
+	            .width = mode_width,
+	            .height = mode_height,
+	        },
+	};
+
+	// This function is called seldom so ok to always print.
+	vk_print_display_surface_create_info(vk, &surface_info, U_LOGGING_INFO);
+
+	// Everything decided and logged, do the creation.
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	ret = vk->vkCreateDisplayPlaneSurfaceKHR( //
+	    vk->instance,                         //
+	    &surface_info,                        //
+	    NULL,                                 //
+	    &surface);                            //
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(cts->base.c, "vkCreateDisplayPlaneSurfaceKHR: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VK_NAME_SURFACE(vk, surface, "comp_target_swapchain direct surface");
+	*out_surface = surface;
+
+	return VK_SUCCESS;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+VkResult
+comp_window_direct_create_surface(struct comp_target_swapchain *cts,
+                                  VkDisplayKHR display,
+                                  uint32_t width,
+                                  uint32_t height)
+{
 	// Select the mode.
 	uint32_t mode_width = 0, mode_height = 0;
 	VkDisplayModeKHR display_mode = get_primary_display_mode( //
@@ -232,46 +315,72 @@ comp_window_direct_create_surface(struct comp_target_swapchain *cts,
 		          mode_height); //
 	}
 
-	// We need the capabilities of the selected plane.
-	VkDisplayPlaneCapabilitiesKHR plane_caps;
-	vk->vkGetDisplayPlaneCapabilitiesKHR(vk->physical_device, display_mode, plane_index, &plane_caps);
+	return create_surface_for_mode(cts, display_mode, mode_width, mode_height, &cts->surface.handle);
+}
 
-	VkDisplaySurfaceCreateInfoKHR surface_info = {
-	    .sType = VK_STRUCTURE_TYPE_DISPLAY_SURFACE_CREATE_INFO_KHR,
-	    .pNext = NULL,
-	    .flags = 0,
-	    .displayMode = display_mode,
-	    .planeIndex = plane_index,
-	    .planeStackIndex = plane_stack_index,
-	    .transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR,
-	    .globalAlpha = 1.0,
-	    .alphaMode = choose_alpha_mode(plane_caps.supportedAlpha),
-	    .imageExtent =
-	        {
-	            .width = mode_width,
-	            .height = mode_height,
-	        },
-	};
+bool
+comp_window_direct_set_refresh_rate(struct comp_target *ct, float refresh_rate_hz)
+{
+	struct comp_target_swapchain *cts = (struct comp_target_swapchain *)ct;
+	struct vk_bundle *vk = get_vk(cts);
+	VkDisplayModePropertiesKHR *mode_properties = NULL;
+	uint32_t mode_count = 0;
+	VkResult ret;
 
-	// This function is called seldom so ok to always print.
-	vk_print_display_surface_create_info(vk, &surface_info, U_LOGGING_INFO);
+	if (cts->display == VK_NULL_HANDLE) {
+		return false;
+	}
+
+	ret = vk_enumerate_display_mode_properties( //
+	    vk,                                     //
+	    vk->physical_device,                    //
+	    cts->display,                           //
+	    &mode_count,                            //
+	    &mode_properties);                      //
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vk_enumerate_display_mode_properties: %s", vk_result_string(ret));
+		return false;
+	}
+
+	// Keep the size, the swapchain extent always matches the mode.
+	VkDisplayModeKHR display_mode = VK_NULL_HANDLE;
+	uint32_t refresh_mhz = 0;
+	for (uint32_t i = 0; i < mode_count; i++) {
+		const VkDisplayModeParametersKHR *params = &mode_properties[i].parameters;
+		if (params->visibleRegion.width == ct->width && params->visibleRegion.height == ct->height &&
+		    fabsf((float)params->refreshRate / 1000.f - refresh_rate_hz) < 0.5f) {
+			display_mode = mode_properties[i].displayMode;
+			refresh_mhz = params->refreshRate;
+			break;
+		}
+	}
+
+	free(mode_properties);
+
+	if (display_mode == VK_NULL_HANDLE) {
+		COMP_ERROR(ct->c, "No %ux%u@%.2f mode to switch to", ct->width, ct->height, refresh_rate_hz);
+		return false;
+	}
 
-	// Everything decided and logged, do the creation.
 	VkSurfaceKHR surface = VK_NULL_HANDLE;
-	ret = vk->vkCreateDisplayPlaneSurfaceKHR( //
-	    vk->instance,                         //
-	    &surface_info,                        //
-	    NULL,                                 //
-	    &surface);                            //
+	ret = create_surface_for_mode(cts, display_mode, ct->width, ct->height, &surface);
 	if (ret != VK_SUCCESS) {
-		COMP_ERROR(cts->base.c, "vkCreateDisplayPlaneSurfaceKHR: %s", vk_result_string(ret));
-		return ret;
+		return false;
 	}
 
-	VK_NAME_SURFACE(vk, surface, "comp_target_swapchain direct surface");
-	cts->surface.handle = surface;
+	// Switched again before the images were recreated.
+	if (cts->surface.pending != VK_NULL_HANDLE) {
+		vk->vkDestroySurfaceKHR(vk->instance, cts->surface.pending, NULL);
+	}
+	cts->surface.pending = surface;
 
-	return VK_SUCCESS;
+	if (cts->upc != NULL) {
+		u_pc_update_frame_period(cts->upc, (uint64_t)(1000. * 1000. * 1000. * 1000. / refresh_mhz));
+	}
+
+	COMP_INFO(ct->c, "Switching to %ux%u@%.2f", ct->width, ct->height, (float)refresh_mhz / 1000.f);
+
+	return true;
 }
 
 #ifdef VK_USE_PLATFORM_XLIB_XRANDR_EXT
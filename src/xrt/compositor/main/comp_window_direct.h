@@ -23,6 +23,14 @@ comp_window_direct_create_surface(struct comp_target_swapchain *cts,
                                   uint32_t width,
                                   uint32_t height);
 
+/*!
+ * Implements @ref comp_target::set_refresh_rate for direct mode targets that
+ * have set @ref comp_target_swapchain::display, by creating a surface for the
+ * mode of the same size with the requested refresh rate.
+ */
+bool
+comp_window_direct_set_refresh_rate(struct comp_target *ct, float refresh_rate_hz);
+
 #ifdef VK_USE_PLATFORM_XLIB_XRANDR_EXT
 
 int
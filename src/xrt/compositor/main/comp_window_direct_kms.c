@@ -0,0 +1,1326 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Direct mode target that scans out with atomic DRM/KMS commits.
+ * @ingroup comp_main
+ */
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_pacing.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_mini_helpers.h"
+
+#include "main/comp_window.h"
+#include "main/comp_compositor.h"
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <inttypes.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+DEBUG_GET_ONCE_OPTION(kms_device, "XRT_COMPOSITOR_KMS_DEVICE", NULL)
+DEBUG_GET_ONCE_NUM_OPTION(kms_lease_fd, "XRT_COMPOSITOR_KMS_LEASE_FD", -1)
+DEBUG_GET_ONCE_NUM_OPTION(kms_connector, "XRT_COMPOSITOR_KMS_CONNECTOR", 0)
+
+//! One being scanned out, one waiting to flip and one being rendered to.
+#define KMS_IMAGE_COUNT (3)
+
+//! Longest to wait for a page flip before giving up on it.
+#define KMS_FLIP_TIMEOUT_MS (100)
+
+//! Commit this long after the vblank before the one we are aiming for.
+#define KMS_COMMIT_AFTER_VBLANK_NS (U_TIME_1MS_IN_NS / 2)
+
+//! Property ids of the objects we touch in the commits.
+struct kms_props
+{
+	uint32_t connector_crtc_id;
+
+	uint32_t crtc_mode_id;
+	uint32_t crtc_active;
+
+	uint32_t plane_fb_id;
+	uint32_t plane_crtc_id;
+	uint32_t plane_src_x;
+	uint32_t plane_src_y;
+	uint32_t plane_src_w;
+	uint32_t plane_src_h;
+	uint32_t plane_crtc_x;
+	uint32_t plane_crtc_y;
+	uint32_t plane_crtc_w;
+	uint32_t plane_crtc_h;
+	uint32_t plane_in_fence_fd;
+};
+
+//! A target image and the framebuffer made from its dma-buf.
+struct kms_image
+{
+	VkDeviceMemory memory;
+
+	int dmabuf_fd;
+	uint32_t gem_handle;
+	uint32_t fb_id;
+};
+
+//! What we know about a presented frame, reported to the pacer once complete.
+struct kms_frame
+{
+	int64_t frame_id;
+	uint64_t desired_present_time_ns;
+
+	//! From info_gpu, zero until known.
+	uint64_t gpu_end_ns;
+
+	//! From the page flip event, zero until known.
+	uint64_t actual_present_time_ns;
+};
+
+/*!
+ * A target that imports its images as framebuffers and presents them with
+ * atomic KMS commits, the commits carry the render complete fence as
+ * `IN_FENCE_FD` so the kernel flips as soon as the GPU is done. The page flip
+ * events give the exact vblank each frame was shown at, which is fed back to
+ * the pacer instead of relying on the FIFO queue of a Vulkan swapchain.
+ *
+ * The DRM device is either a lease file descriptor handed to us, or a device
+ * node, where only connectors marked as `non-desktop` are used unless one is
+ * asked for.
+ *
+ * @implements comp_target
+ */
+struct comp_window_direct_kms
+{
+	struct comp_target base;
+
+	struct u_pacing_compositor *upc;
+
+	int fd;
+
+	uint32_t connector_id;
+	uint32_t crtc_id;
+	uint32_t plane_id;
+
+	drmModeModeInfo mode;
+	uint32_t mode_blob_id;
+
+	struct kms_props props;
+
+	struct kms_image images[KMS_IMAGE_COUNT];
+
+	//! Exported as a sync file for each commit.
+	VkFence present_fence;
+
+	uint32_t next_index;
+
+	//! Has the first commit with the mode been done.
+	bool modeset_done;
+
+	//! Is a commit waiting for its page flip event.
+	bool flip_pending;
+
+	uint64_t frame_period_ns;
+
+	//! Frame currently being rendered.
+	struct kms_frame current;
+
+	//! Last presented frame, until it has been reported to the pacer.
+	struct kms_frame presented;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct vk_bundle *
+get_vk(struct comp_window_direct_kms *w)
+{
+	return &w->base.c->base.vk;
+}
+
+static uint32_t
+get_prop_id(struct comp_window_direct_kms *w, uint32_t object_id, uint32_t object_type, const char *name)
+{
+	drmModeObjectProperties *props = drmModeObjectGetProperties(w->fd, object_id, object_type);
+	if (props == NULL) {
+		return 0;
+	}
+
+	uint32_t id = 0;
+	for (uint32_t i = 0; i < props->count_props && id == 0; i++) {
+		drmModePropertyRes *prop = drmModeGetProperty(w->fd, props->props[i]);
+		if (prop == NULL) {
+			continue;
+		}
+
+		if (strcmp(prop->name, name) == 0) {
+			id = prop->prop_id;
+		}
+
+		drmModeFreeProperty(prop);
+	}
+
+	drmModeFreeObjectProperties(props);
+
+	return id;
+}
+
+static bool
+get_prop_value(
+    struct comp_window_direct_kms *w, uint32_t object_id, uint32_t object_type, const char *name, uint64_t *out_value)
+{
+	drmModeObjectProperties *props = drmModeObjectGetProperties(w->fd, object_id, object_type);
+	if (props == NULL) {
+		return false;
+	}
+
+	bool found = false;
+	for (uint32_t i = 0; i < props->count_props && !found; i++) {
+		drmModePropertyRes *prop = drmModeGetProperty(w->fd, props->props[i]);
+		if (prop == NULL) {
+			continue;
+		}
+
+		if (strcmp(prop->name, name) == 0) {
+			*out_value = props->prop_values[i];
+			found = true;
+		}
+
+		drmModeFreeProperty(prop);
+	}
+
+	drmModeFreeObjectProperties(props);
+
+	return found;
+}
+
+static bool
+is_connector_wanted(struct comp_window_direct_kms *w, drmModeConnector *conn, bool leased)
+{
+	uint32_t wanted_id = (uint32_t)debug_get_num_option_kms_connector();
+
+	if (conn->connection != DRM_MODE_CONNECTED || conn->count_modes == 0) {
+		return false;
+	}
+
+	if (wanted_id != 0) {
+		return conn->connector_id == wanted_id;
+	}
+
+	// Everything in a lease is ours to use.
+	if (leased) {
+		return true;
+	}
+
+	// Don't take over the desktop's displays.
+	uint64_t non_desktop = 0;
+	get_prop_value(w, conn->connector_id, DRM_MODE_OBJECT_CONNECTOR, "non-desktop", &non_desktop);
+
+	return non_desktop != 0;
+}
+
+static const drmModeModeInfo *
+pick_mode(const drmModeConnector *conn)
+{
+	for (int i = 0; i < conn->count_modes; i++) {
+		if (conn->modes[i].type & DRM_MODE_TYPE_PREFERRED) {
+			return &conn->modes[i];
+		}
+	}
+
+	return &conn->modes[0];
+}
+
+static bool
+find_crtc(struct comp_window_direct_kms *w, drmModeRes *res, drmModeConnector *conn, uint32_t *out_crtc_index)
+{
+	for (int i = 0; i < conn->count_encoders; i++) {
+		drmModeEncoder *enc = drmModeGetEncoder(w->fd, conn->encoders[i]);
+		if (enc == NULL) {
+			continue;
+		}
+
+		uint32_t possible_crtcs = enc->possible_crtcs;
+		drmModeFreeEncoder(enc);
+
+		for (int k = 0; k < res->count_crtcs; k++) {
+			if (possible_crtcs & (1u << k)) {
+				w->crtc_id = res->crtcs[k];
+				*out_crtc_index = (uint32_t)k;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static bool
+find_primary_plane(struct comp_window_direct_kms *w, uint32_t crtc_index)
+{
+	drmModePlaneRes *plane_res = drmModeGetPlaneResources(w->fd);
+	if (plane_res == NULL) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < plane_res->count_planes && w->plane_id == 0; i++) {
+		drmModePlane *plane = drmModeGetPlane(w->fd, plane_res->planes[i]);
+		if (plane == NULL) {
+			continue;
+		}
+
+		uint64_t type = 0;
+		if ((plane->possible_crtcs & (1u << crtc_index)) != 0 &&
+		    get_prop_value(w, plane->plane_id, DRM_MODE_OBJECT_PLANE, "type", &type) &&
+		    type == DRM_PLANE_TYPE_PRIMARY) {
+			w->plane_id = plane->plane_id;
+		}
+
+		drmModeFreePlane(plane);
+	}
+
+	drmModeFreePlaneResources(plane_res);
+
+	return w->plane_id != 0;
+}
+
+static bool
+get_props(struct comp_window_direct_kms *w)
+{
+	struct kms_props *p = &w->props;
+
+	p->connector_crtc_id = get_prop_id(w, w->connector_id, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID");
+	p->crtc_mode_id = get_prop_id(w, w->crtc_id, DRM_MODE_OBJECT_CRTC, "MODE_ID");
+	p->crtc_active = get_prop_id(w, w->crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE");
+	p->plane_fb_id = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID");
+	p->plane_crtc_id = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_ID");
+	p->plane_src_x = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "SRC_X");
+	p->plane_src_y = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "SRC_Y");
+	p->plane_src_w = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "SRC_W");
+	p->plane_src_h = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "SRC_H");
+	p->plane_crtc_x = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_X");
+	p->plane_crtc_y = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_Y");
+	p->plane_crtc_w = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_W");
+	p->plane_crtc_h = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "CRTC_H");
+	p->plane_in_fence_fd = get_prop_id(w, w->plane_id, DRM_MODE_OBJECT_PLANE, "IN_FENCE_FD");
+
+	return p->connector_crtc_id != 0 && p->crtc_mode_id != 0 && p->crtc_active != 0 && p->plane_fb_id != 0 &&
+	       p->plane_crtc_id != 0 && p->plane_src_x != 0 && p->plane_src_y != 0 && p->plane_src_w != 0 &&
+	       p->plane_src_h != 0 && p->plane_crtc_x != 0 && p->plane_crtc_y != 0 && p->plane_crtc_w != 0 &&
+	       p->plane_crtc_h != 0 && p->plane_in_fence_fd != 0;
+}
+
+static bool
+open_device(struct comp_window_direct_kms *w)
+{
+	int lease_fd = (int)debug_get_num_option_kms_lease_fd();
+	const char *path = debug_get_option_kms_device();
+
+	if (lease_fd >= 0) {
+		w->fd = fcntl(lease_fd, F_DUPFD_CLOEXEC, 0);
+	} else if (path != NULL) {
+		w->fd = open(path, O_RDWR | O_CLOEXEC);
+	} else {
+		COMP_DEBUG(w->base.c, "Neither XRT_COMPOSITOR_KMS_LEASE_FD nor XRT_COMPOSITOR_KMS_DEVICE set.");
+		return false;
+	}
+
+	if (w->fd < 0) {
+		COMP_ERROR(w->base.c, "Failed to open DRM device: %s", strerror(errno));
+		return false;
+	}
+
+	if (drmSetClientCap(w->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 ||
+	    drmSetClientCap(w->fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+		COMP_ERROR(w->base.c, "DRM device doesn't support atomic modesetting.");
+		return false;
+	}
+
+	// The flip timestamps are given straight to the pacer.
+	uint64_t monotonic = 0;
+	if (drmGetCap(w->fd, DRM_CAP_TIMESTAMP_MONOTONIC, &monotonic) != 0 || monotonic == 0) {
+		COMP_ERROR(w->base.c, "DRM device doesn't use monotonic timestamps.");
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+setup_output(struct comp_window_direct_kms *w)
+{
+	bool leased = debug_get_num_option_kms_lease_fd() >= 0;
+
+	drmModeRes *res = drmModeGetResources(w->fd);
+	if (res == NULL) {
+		COMP_ERROR(w->base.c, "drmModeGetResources: %s", strerror(errno));
+		return false;
+	}
+
+	drmModeConnector *conn = NULL;
+	for (int i = 0; i < res->count_connectors && conn == NULL; i++) {
+		conn = drmModeGetConnector(w->fd, res->connectors[i]);
+		if (conn != NULL && !is_connector_wanted(w, conn, leased)) {
+			drmModeFreeConnector(conn);
+			conn = NULL;
+		}
+	}
+
+	if (conn == NULL) {
+		COMP_ERROR(w->base.c, "No connected non-desktop connector found, set XRT_COMPOSITOR_KMS_CONNECTOR.");
+		drmModeFreeResources(res);
+		return false;
+	}
+
+	uint32_t crtc_index = 0;
+	bool found = find_crtc(w, res, conn, &crtc_index);
+
+	w->connector_id = conn->connector_id;
+	w->mode = *pick_mode(conn);
+
+	drmModeFreeConnector(conn);
+	drmModeFreeResources(res);
+
+	if (!found) {
+		COMP_ERROR(w->base.c, "No CRTC for connector %u.", w->connector_id);
+		return false;
+	}
+
+	if (!find_primary_plane(w, crtc_index)) {
+		COMP_ERROR(w->base.c, "No primary plane for CRTC %u.", w->crtc_id);
+		return false;
+	}
+
+	if (!get_props(w)) {
+		COMP_ERROR(w->base.c, "Missing KMS properties, does the driver support IN_FENCE_FD?");
+		return false;
+	}
+
+	if (drmModeCreatePropertyBlob(w->fd, &w->mode, sizeof(w->mode), &w->mode_blob_id) != 0) {
+		COMP_ERROR(w->base.c, "drmModeCreatePropertyBlob: %s", strerror(errno));
+		return false;
+	}
+
+	// Clock is in kHz.
+	uint64_t pixels = (uint64_t)w->mode.htotal * w->mode.vtotal;
+	w->frame_period_ns = pixels * U_TIME_1MS_IN_NS / w->mode.clock;
+
+	COMP_INFO(w->base.c, "Using connector %u, CRTC %u and plane %u with mode %s, %" PRIu64 "ns period.",
+	          w->connector_id, w->crtc_id, w->plane_id, w->mode.name, w->frame_period_ns);
+
+	return true;
+}
+
+static uint32_t
+vk_format_to_fourcc(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB: return DRM_FORMAT_XRGB8888;
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB: return DRM_FORMAT_XBGR8888;
+	case VK_FORMAT_A2R10G10B10_UNORM_PACK32: return DRM_FORMAT_XRGB2101010;
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return DRM_FORMAT_XBGR2101010;
+	default: return 0;
+	}
+}
+
+/*!
+ * Can a linear image of @p format with @p usage be made and exported as a
+ * dma-buf, linear images have much tighter limits than optimal ones and many
+ * implementations don't allow them with storage or multisampled usage.
+ */
+static bool
+can_create_linear_image(struct comp_window_direct_kms *w, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage)
+{
+	struct vk_bundle *vk = get_vk(w);
+
+	// In->pNext
+	VkPhysicalDeviceExternalImageFormatInfo external_image_format_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	// In
+	VkPhysicalDeviceImageFormatInfo2 format_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+	    .pNext = &external_image_format_info,
+	    .format = format,
+	    .type = VK_IMAGE_TYPE_2D,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	};
+
+	// Out->pNext
+	VkExternalImageFormatProperties external_format_properties = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+	};
+
+	// Out
+	VkImageFormatProperties2 format_properties = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+	    .pNext = &external_format_properties,
+	};
+
+	VkResult ret =
+	    vk->vkGetPhysicalDeviceImageFormatProperties2(vk->physical_device, &format_info, &format_properties);
+	if (ret == VK_ERROR_FORMAT_NOT_SUPPORTED) {
+		return false;
+	}
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(w->base.c, "vkGetPhysicalDeviceImageFormatProperties2: %s", vk_result_string(ret));
+		return false;
+	}
+
+	const VkImageFormatProperties *props = &format_properties.imageFormatProperties;
+	VkExternalMemoryFeatureFlags features =
+	    external_format_properties.externalMemoryProperties.externalMemoryFeatures;
+
+	return (features & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) != 0 && //
+	       props->maxExtent.width >= extent.width &&                       //
+	       props->maxExtent.height >= extent.height;                       //
+}
+
+/*!
+ * Linear images can be scanned out by pretty much any display engine, and
+ * are the only thing that works across devices if the display and the GPU
+ * we render on are not the same.
+ */
+static VkResult
+create_image(struct comp_window_direct_kms *w,
+             VkExtent2D extent,
+             VkFormat format,
+             VkImageUsageFlags usage,
+             VkDeviceMemory *out_memory,
+             VkImage *out_image)
+{
+	struct vk_bundle *vk = get_vk(w);
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkResult ret;
+
+	VkExternalMemoryImageCreateInfo external_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkImageCreateInfo image_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .pNext = &external_info,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = format,
+	    .extent = {extent.width, extent.height, 1},
+	    .mipLevels = 1,
+	    .arrayLayers = 1,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	ret = vk->vkCreateImage(vk->device, &image_info, NULL, &image);
+	VK_CHK_AND_RET(ret, "vkCreateImage");
+
+	VkMemoryRequirements memory_requirements;
+	vk->vkGetImageMemoryRequirements(vk->device, image, &memory_requirements);
+
+	uint32_t memory_type_index = UINT32_MAX;
+	if (!vk_get_memory_type(vk, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	                        &memory_type_index)) {
+		VK_ERROR(vk, "vk_get_memory_type failed!");
+		ret = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		goto err_image;
+	}
+
+	VkExportMemoryAllocateInfo export_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	// Scanout engines often can't deal with memory not allocated for the image alone.
+	VkMemoryDedicatedAllocateInfo dedicated_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+	    .pNext = &export_info,
+	    .image = image,
+	};
+
+	VkMemoryAllocateInfo alloc_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+	    .pNext = &dedicated_info,
+	    .allocationSize = memory_requirements.size,
+	    .memoryTypeIndex = memory_type_index,
+	};
+
+	ret = vk->vkAllocateMemory(vk->device, &alloc_info, NULL, &memory);
+	VK_CHK_WITH_GOTO(ret, "vkAllocateMemory", err_image);
+
+	ret = vk->vkBindImageMemory(vk->device, image, memory, 0);
+	VK_CHK_WITH_GOTO(ret, "vkBindImageMemory", err_memory);
+
+	*out_memory = memory;
+	*out_image = image;
+
+	return VK_SUCCESS;
+
+err_memory:
+	vk->vkFreeMemory(vk->device, memory, NULL);
+err_image:
+	vk->vkDestroyImage(vk->device, image, NULL);
+
+	return ret;
+}
+
+static bool
+create_framebuffer(struct comp_window_direct_kms *w, VkImage image, uint32_t fourcc, struct kms_image *ki)
+{
+	struct vk_bundle *vk = get_vk(w);
+	VkResult ret;
+
+	VkMemoryGetFdInfoKHR fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+	    .memory = ki->memory,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	ret = vk->vkGetMemoryFdKHR(vk->device, &fd_info, &ki->dmabuf_fd);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(w->base.c, "vkGetMemoryFdKHR: %s", vk_result_string(ret));
+		ki->dmabuf_fd = -1;
+		return false;
+	}
+
+	VkImageSubresource subresource = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .mipLevel = 0,
+	    .arrayLayer = 0,
+	};
+	VkSubresourceLayout layout;
+	vk->vkGetImageSubresourceLayout(vk->device, image, &subresource, &layout);
+
+	if (drmPrimeFDToHandle(w->fd, ki->dmabuf_fd, &ki->gem_handle) != 0) {
+		COMP_ERROR(w->base.c, "drmPrimeFDToHandle: %s", strerror(errno));
+		return false;
+	}
+
+	uint32_t handles[4] = {ki->gem_handle};
+	uint32_t pitches[4] = {(uint32_t)layout.rowPitch};
+	uint32_t offsets[4] = {(uint32_t)layout.offset};
+
+	if (drmModeAddFB2(w->fd, w->base.width, w->base.height, fourcc, handles, pitches, offsets, &ki->fb_id, 0) !=
+	    0) {
+		COMP_ERROR(w->base.c, "drmModeAddFB2: %s", strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+static void
+destroy_images(struct comp_window_direct_kms *w)
+{
+	struct vk_bundle *vk = get_vk(w);
+
+	if (w->base.images == NULL && w->base.semaphores.render_complete == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vk->vkDeviceWaitIdle(vk->device);
+
+	for (uint32_t i = 0; i < KMS_IMAGE_COUNT; i++) {
+		struct kms_image *ki = &w->images[i];
+
+		// Removing the framebuffer being scanned out turns off the plane.
+		if (ki->fb_id != 0) {
+			drmModeRmFB(w->fd, ki->fb_id);
+		}
+		if (ki->gem_handle != 0) {
+			struct drm_gem_close close_args = {.handle = ki->gem_handle};
+			drmIoctl(w->fd, DRM_IOCTL_GEM_CLOSE, &close_args);
+		}
+		if (ki->dmabuf_fd >= 0) {
+			close(ki->dmabuf_fd);
+		}
+
+		if (w->base.images != NULL) {
+			D(ImageView, w->base.images[i].view);
+			D(Image, w->base.images[i].handle);
+		}
+		DF(Memory, ki->memory);
+
+		U_ZERO(ki);
+		ki->dmabuf_fd = -1;
+	}
+
+	free(w->base.images);
+	w->base.images = NULL;
+	w->base.image_count = 0;
+
+	D(Semaphore, w->base.semaphores.render_complete);
+
+	// The mode needs to be set again with the new framebuffers.
+	w->modeset_done = false;
+	w->flip_pending = false;
+}
+
+static void
+report_presented(struct comp_window_direct_kms *w)
+{
+	struct kms_frame *f = &w->presented;
+
+	if (f->frame_id < 0 || f->gpu_end_ns == 0 || f->actual_present_time_ns == 0) {
+		return;
+	}
+
+	uint64_t actual = f->actual_present_time_ns;
+	uint64_t margin = actual > f->gpu_end_ns ? actual - f->gpu_end_ns : 0;
+
+	// The GPU was done this many whole periods before the flip, it could have been shown that early.
+	uint64_t earliest = actual - (margin / w->frame_period_ns) * w->frame_period_ns;
+
+	u_pc_info(w->upc,                      //
+	          f->frame_id,                 //
+	          f->desired_present_time_ns,  //
+	          actual,                      //
+	          earliest,                    //
+	          margin,                      //
+	          os_monotonic_get_ns());      //
+
+	f->frame_id = -1;
+}
+
+static void
+page_flip_handler(int fd,
+                  unsigned int sequence,
+                  unsigned int tv_sec,
+                  unsigned int tv_usec,
+                  unsigned int crtc_id,
+                  void *user_data)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)user_data;
+
+	uint64_t flip_ns = (uint64_t)tv_sec * U_TIME_1S_IN_NS + (uint64_t)tv_usec * 1000;
+
+	w->flip_pending = false;
+	w->presented.actual_present_time_ns = flip_ns;
+
+	report_presented(w);
+}
+
+//! Dispatch any page flip events, waiting up to @p timeout_ms for one.
+static bool
+handle_events(struct comp_window_direct_kms *w, int timeout_ms)
+{
+	struct pollfd pfd = {
+	    .fd = w->fd,
+	    .events = POLLIN,
+	};
+
+	int ret = poll(&pfd, 1, timeout_ms);
+	if (ret < 0 && errno != EINTR) {
+		COMP_ERROR(w->base.c, "poll: %s", strerror(errno));
+		return false;
+	}
+	if (ret <= 0) {
+		return true;
+	}
+
+	drmEventContext ctx = {
+	    .version = 3,
+	    .page_flip_handler2 = page_flip_handler,
+	};
+
+	if (drmHandleEvent(w->fd, &ctx) != 0) {
+		COMP_ERROR(w->base.c, "drmHandleEvent failed");
+		return false;
+	}
+
+	return true;
+}
+
+static int
+export_present_fence(struct comp_window_direct_kms *w)
+{
+	struct vk_bundle *vk = get_vk(w);
+	int fence_fd = -1;
+
+	VkFenceGetFdInfoKHR get_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_GET_FD_INFO_KHR,
+	    .fence = w->present_fence,
+	    .handleType = VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT,
+	};
+
+	// Exporting a sync file resets the fence, so it can be used again next frame.
+	VkResult ret = vk->vkGetFenceFdKHR(vk->device, &get_info, &fence_fd);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(w->base.c, "vkGetFenceFdKHR: %s", vk_result_string(ret));
+		return -1;
+	}
+
+	return fence_fd;
+}
+
+/*!
+ * Commit the image to the plane, returns zero or a negative errno. The kernel
+ * refuses a non-blocking commit with -EBUSY while an earlier one has not yet
+ * flipped, that is left to the caller to deal with.
+ */
+static int
+commit(struct comp_window_direct_kms *w, uint32_t index, int fence_fd)
+{
+	const struct kms_props *p = &w->props;
+	uint32_t width = w->base.width;
+	uint32_t height = w->base.height;
+
+	drmModeAtomicReq *req = drmModeAtomicAlloc();
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT;
+
+	if (!w->modeset_done) {
+		drmModeAtomicAddProperty(req, w->connector_id, p->connector_crtc_id, w->crtc_id);
+		drmModeAtomicAddProperty(req, w->crtc_id, p->crtc_mode_id, w->mode_blob_id);
+		drmModeAtomicAddProperty(req, w->crtc_id, p->crtc_active, 1);
+		flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+	} else {
+		flags |= DRM_MODE_ATOMIC_NONBLOCK;
+	}
+
+	// Source is in 16.16 fixed point.
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_fb_id, w->images[index].fb_id);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_crtc_id, w->crtc_id);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_src_x, 0);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_src_y, 0);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_src_w, (uint64_t)width << 16);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_src_h, (uint64_t)height << 16);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_crtc_x, 0);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_crtc_y, 0);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_crtc_w, width);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_crtc_h, height);
+	drmModeAtomicAddProperty(req, w->plane_id, p->plane_in_fence_fd, fence_fd);
+
+	int ret = drmModeAtomicCommit(w->fd, req, flags, w);
+	int err = errno;
+	drmModeAtomicFree(req);
+
+	if (ret != 0) {
+		if (err != EBUSY) {
+			COMP_ERROR(w->base.c, "drmModeAtomicCommit: %s", strerror(err));
+		}
+		return -err;
+	}
+
+	w->modeset_done = true;
+	w->flip_pending = true;
+
+	return 0;
+}
+
+//! Wait for the pending flip, returns false if it didn't happen in time.
+static bool
+wait_for_flip(struct comp_window_direct_kms *w)
+{
+	uint64_t timeout_ns = os_monotonic_get_ns() + KMS_FLIP_TIMEOUT_MS * U_TIME_1MS_IN_NS;
+	while (w->flip_pending && os_monotonic_get_ns() < timeout_ns) {
+		if (!handle_events(w, KMS_FLIP_TIMEOUT_MS)) {
+			break;
+		}
+	}
+
+	return !w->flip_pending;
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	return open_device(w) && setup_output(w);
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+	struct vk_bundle *vk = get_vk(w);
+
+	if (!vk->has_EXT_external_memory_dma_buf) {
+		COMP_ERROR(ct->c, "KMS target needs VK_EXT_external_memory_dma_buf.");
+		return false;
+	}
+
+	if (!vk->external.fence_sync_fd) {
+		COMP_ERROR(ct->c, "KMS target needs fences exportable as sync files.");
+		return false;
+	}
+
+	VkExportFenceCreateInfo export_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_FENCE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_FENCE_HANDLE_TYPE_SYNC_FD_BIT,
+	};
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .pNext = &export_info,
+	};
+
+	VkResult ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &w->present_fence);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vkCreateFence: %s", vk_result_string(ret));
+		return false;
+	}
+	VK_NAME_FENCE(vk, w->present_fence, "comp_window_direct_kms present_fence");
+
+	// The mode decides the size, not the compositor.
+	ct->width = w->mode.hdisplay;
+	ct->height = w->mode.vdisplay;
+
+	u_pc_display_timing_create(w->frame_period_ns, &U_PC_DISPLAY_TIMING_CONFIG_DEFAULT, &w->upc);
+
+	return true;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	return true;
+}
+
+static void
+target_create_images(struct comp_target *ct, const struct comp_target_create_images_info *create_info)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+	struct vk_bundle *vk = get_vk(w);
+	VkResult ret;
+
+	destroy_images(w);
+
+	// Always the size of the mode.
+	VkExtent2D extent = {w->mode.hdisplay, w->mode.vdisplay};
+
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t fourcc = 0;
+	for (uint32_t i = 0; i < create_info->format_count && fourcc == 0; i++) {
+		format = create_info->formats[i];
+		fourcc = vk_format_to_fourcc(format);
+
+		// The renderer wants to render straight to the image, linear has to support that usage.
+		if (fourcc != 0 && !can_create_linear_image(w, extent, format, create_info->image_usage)) {
+			COMP_DEBUG(ct->c, "%s can't be a linear image with the usage needed.", vk_format_string(format));
+			fourcc = 0;
+		}
+	}
+
+	if (fourcc == 0) {
+		COMP_ERROR(ct->c, "None of the formats can be scanned out as linear images with the usage needed.");
+		return;
+	}
+	ct->width = extent.width;
+	ct->height = extent.height;
+
+	VkSemaphoreCreateInfo semaphore_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	};
+	ret = vk->vkCreateSemaphore(vk->device, &semaphore_info, NULL, &ct->semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return;
+	}
+	VK_NAME_SEMAPHORE(vk, ct->semaphores.render_complete, "comp_window_direct_kms render_complete");
+	ct->semaphores.render_complete_is_timeline = false;
+
+	VkImageSubresourceRange range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ct->images = U_TYPED_ARRAY_CALLOC(struct comp_target_image, KMS_IMAGE_COUNT);
+	ct->image_count = KMS_IMAGE_COUNT;
+
+	bool ok = true;
+	for (uint32_t i = 0; i < KMS_IMAGE_COUNT && ok; i++) {
+		ret = create_image(w, extent, format, create_info->image_usage, &w->images[i].memory,
+		                   &ct->images[i].handle);
+		if (ret != VK_SUCCESS) {
+			ok = false;
+			break;
+		}
+
+		ret = vk_create_view(vk, ct->images[i].handle, VK_IMAGE_VIEW_TYPE_2D, format, range, &ct->images[i].view);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_create_view: %s", vk_result_string(ret));
+			ok = false;
+			break;
+		}
+
+		ok = create_framebuffer(w, ct->images[i].handle, fourcc, &w->images[i]);
+	}
+
+	if (!ok) {
+		destroy_images(w);
+		return;
+	}
+
+	ct->format = format;
+	ct->surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	w->next_index = 0;
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	return ct->images != NULL;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	/*
+	 * Present waits for the previous flip before committing, so at most
+	 * one image is scanned out and one waiting to flip, the third is free.
+	 */
+	*out_index = w->next_index;
+	w->next_index = (w->next_index + 1) % ct->image_count;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+	struct vk_bundle *vk = get_vk(w);
+	VkResult ret;
+
+	// Turn the render complete semaphore into a fence we can give to KMS.
+	VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &ct->semaphores.render_complete,
+	    .pWaitDstStageMask = &stage,
+	};
+
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, w->present_fence);
+	VK_CHK_AND_RET(ret, "vk_cmd_submit_locked");
+
+	int fence_fd = export_present_fence(w);
+	if (fence_fd < 0) {
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	// Only one commit can be in flight, so wait for the last flip.
+	if (w->flip_pending && !wait_for_flip(w)) {
+		// The event might just be lost, try to commit anyway.
+		COMP_WARN(ct->c, "Timed out waiting for page flip.");
+		w->flip_pending = false;
+	}
+
+	/*
+	 * A commit flips at the first vblank after its fence signals, so to
+	 * not show the frame early it has to be done after the vblank before
+	 * the one we are aiming for.
+	 */
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t commit_after_ns = desired_present_time_ns - w->frame_period_ns + KMS_COMMIT_AFTER_VBLANK_NS;
+	if (w->modeset_done && desired_present_time_ns > w->frame_period_ns && now_ns < commit_after_ns) {
+		os_nanosleep((int64_t)(commit_after_ns - now_ns));
+	}
+
+	int err = commit(w, index, fence_fd);
+	if (err == -EBUSY) {
+		// The flip that timed out is still queued, give it one more go.
+		w->flip_pending = true;
+		if (wait_for_flip(w)) {
+			err = commit(w, index, fence_fd);
+		}
+	}
+
+	if (err == -EBUSY) {
+		// Keep going with the next frame rather than tearing down the target.
+		COMP_WARN(ct->c, "Previous page flip still pending, dropping frame.");
+		w->flip_pending = false;
+	} else if (err == 0) {
+		// After the commit, a late event for the previous frame belongs to that frame.
+		w->presented = w->current;
+		w->presented.desired_present_time_ns = desired_present_time_ns;
+	}
+
+	// The kernel holds its own reference.
+	close(fence_fd);
+
+	return err == 0 || err == -EBUSY ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	// No-op
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t desired_present_time_ns = 0;
+	uint64_t present_slop_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(w->upc,                       //
+	             now_ns,                       //
+	             &frame_id,                    //
+	             &wake_up_time_ns,             //
+	             &desired_present_time_ns,     //
+	             &present_slop_ns,             //
+	             &predicted_display_time_ns,   //
+	             &predicted_display_period_ns, //
+	             &min_display_period_ns);      //
+
+	U_ZERO(&w->current);
+	w->current.frame_id = frame_id;
+	w->current.desired_present_time_ns = desired_present_time_ns;
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_desired_present_time_ns = desired_present_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_present_slop_ns = present_slop_ns;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+	assert(frame_id == w->current.frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(w->upc, U_TIMING_POINT_WAKE_UP, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN: u_pc_mark_point(w->upc, U_TIMING_POINT_BEGIN, frame_id, when_ns); break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_BEGIN:
+		u_pc_mark_point(w->upc, U_TIMING_POINT_SUBMIT_BEGIN, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_END:
+		u_pc_mark_point(w->upc, U_TIMING_POINT_SUBMIT_END, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_POSE_SAMPLE:
+		u_pc_mark_point(w->upc, U_TIMING_POINT_POSE_SAMPLE, frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	// Pick up any flips that have happened, without blocking.
+	if (w->flip_pending) {
+		handle_events(w, 0);
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(struct comp_target *ct,
+                int64_t frame_id,
+                uint64_t gpu_start_ns,
+                uint64_t gpu_end_ns,
+                uint64_t layer_squash_ns,
+                uint64_t distortion_ns,
+                uint64_t when_ns)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	u_pc_info_gpu(w->upc, frame_id, gpu_start_ns, gpu_end_ns, layer_squash_ns, distortion_ns, when_ns);
+
+	if (frame_id != w->presented.frame_id) {
+		return;
+	}
+
+	w->presented.gpu_end_ns = gpu_end_ns;
+
+	report_presented(w);
+}
+
+static void
+target_info_layers(struct comp_target *ct, int64_t frame_id, uint32_t layer_count, bool fast_path)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+
+	u_pc_info_layers(w->upc, frame_id, layer_count, fast_path);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	// No-op
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_window_direct_kms *w = (struct comp_window_direct_kms *)ct;
+	struct vk_bundle *vk = get_vk(w);
+
+	if (w->fd >= 0 && w->flip_pending) {
+		handle_events(w, KMS_FLIP_TIMEOUT_MS);
+	}
+
+	if (w->fd >= 0) {
+		destroy_images(w);
+	}
+
+	if (w->present_fence != VK_NULL_HANDLE) {
+		vk->vkDestroyFence(vk->device, w->present_fence, NULL);
+		w->present_fence = VK_NULL_HANDLE;
+	}
+
+	if (w->mode_blob_id != 0) {
+		drmModeDestroyPropertyBlob(w->fd, w->mode_blob_id);
+	}
+
+	if (w->fd >= 0) {
+		close(w->fd);
+		w->fd = -1;
+	}
+
+	u_pc_destroy(&w->upc);
+
+	free(w);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct comp_target *
+comp_window_direct_kms_create(struct comp_compositor *c)
+{
+	struct comp_window_direct_kms *w = U_TYPED_CALLOC(struct comp_window_direct_kms);
+
+	w->fd = -1;
+	w->current.frame_id = -1;
+	w->presented.frame_id = -1;
+	for (uint32_t i = 0; i < KMS_IMAGE_COUNT; i++) {
+		w->images[i].dmabuf_fd = -1;
+	}
+
+	w->base.name = "direct_kms";
+	w->base.c = c;
+	w->base.init_pre_vulkan = target_init_pre_vulkan;
+	w->base.init_post_vulkan = target_init_post_vulkan;
+	w->base.check_ready = target_check_ready;
+	w->base.create_images = target_create_images;
+	w->base.has_images = target_has_images;
+	w->base.acquire = target_acquire;
+	w->base.present = target_present;
+	w->base.flush = target_flush;
+	w->base.calc_frame_pacing = target_calc_frame_pacing;
+	w->base.mark_timing_point = target_mark_timing_point;
+	w->base.update_timings = target_update_timings;
+	w->base.info_gpu = target_info_gpu;
+	w->base.info_layers = target_info_layers;
+	w->base.set_title = target_set_title;
+	w->base.destroy = target_destroy;
+
+	return &w->base;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	// Only when configured, it takes the display away from everything else.
+	return debug_get_num_option_kms_lease_fd() >= 0 || debug_get_option_kms_device() != NULL;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	struct comp_target *ct = comp_window_direct_kms_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_direct_kms = {
+    .name = "Direct KMS",
+    .identifier = "kms",
+    .requires_vulkan_for_create = false,
+    .is_deferred = false,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .detect = detect,
+    .create_target = create_target,
+};
@@ -123,6 +123,7 @@ comp_window_direct_randr_create(struct comp_compositor *c)
 	w->base.base.init_pre_vulkan = comp_window_direct_randr_init;
 	w->base.base.init_post_vulkan = comp_window_direct_randr_init_swapchain;
 	w->base.base.set_title = _update_window_title;
+	w->base.base.set_refresh_rate = comp_window_direct_set_refresh_rate;
 	w->base.base.c = c;
 
 	return &w->base.base;
@@ -0,0 +1,463 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Target that renders to images that are never shown.
+ * @ingroup comp_main
+ */
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_pacing.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_mini_helpers.h"
+
+#include "main/comp_window.h"
+#include "main/comp_window_offscreen.h"
+#include "main/comp_compositor.h"
+
+#include <assert.h>
+#include <inttypes.h>
+
+
+#define OFFSCREEN_IMAGE_COUNT (3)
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+/*!
+ * A target that renders into images it owns and never shows, paced by a fake
+ * display. Every frame is reported to the function set with
+ * @ref comp_window_offscreen_set_frame_func once the GPU is done with it.
+ *
+ * @implements comp_target
+ */
+struct comp_window_offscreen
+{
+	struct comp_target base;
+
+	struct u_pacing_compositor *upc;
+
+	VkDeviceMemory memories[OFFSCREEN_IMAGE_COUNT];
+
+	uint32_t next_index;
+
+	//! Frame currently being rendered, reported from info_gpu.
+	struct comp_window_offscreen_frame frame;
+
+	uint64_t frame_count;
+	uint64_t missed_count;
+};
+
+static struct
+{
+	comp_window_offscreen_frame_func_t func;
+	void *user;
+} g_frame_listener;
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct vk_bundle *
+get_vk(struct comp_window_offscreen *ow)
+{
+	return &ow->base.c->base.vk;
+}
+
+static void
+destroy_images(struct comp_window_offscreen *ow)
+{
+	struct vk_bundle *vk = get_vk(ow);
+
+	if (ow->base.images == NULL && ow->base.semaphores.render_complete == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vk->vkDeviceWaitIdle(vk->device);
+
+	if (ow->base.images != NULL) {
+		for (uint32_t i = 0; i < ow->base.image_count; i++) {
+			D(ImageView, ow->base.images[i].view);
+			D(Image, ow->base.images[i].handle);
+			DF(Memory, ow->memories[i]);
+		}
+
+		free(ow->base.images);
+		ow->base.images = NULL;
+		ow->base.image_count = 0;
+	}
+
+	D(Semaphore, ow->base.semaphores.render_complete);
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	return true;
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	ct->width = preferred_width;
+	ct->height = preferred_height;
+
+	u_pc_fake_create(ct->c->settings.nominal_frame_interval_ns, os_monotonic_get_ns(), &ow->upc);
+
+	return true;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	return true;
+}
+
+static void
+target_create_images(struct comp_target *ct, const struct comp_target_create_images_info *create_info)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+	struct vk_bundle *vk = get_vk(ow);
+	VkResult ret;
+
+	destroy_images(ow);
+
+	assert(create_info->format_count > 0);
+	VkFormat format = create_info->formats[0];
+
+	VkExtent2D extent = create_info->extent;
+	if (extent.width == 0 || extent.height == 0) {
+		extent = (VkExtent2D){ct->width, ct->height};
+	}
+
+	VkSemaphoreCreateInfo semaphore_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	};
+	ret = vk->vkCreateSemaphore(vk->device, &semaphore_info, NULL, &ct->semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		return;
+	}
+	VK_NAME_SEMAPHORE(vk, ct->semaphores.render_complete, "comp_window_offscreen render_complete");
+	ct->semaphores.render_complete_is_timeline = false;
+
+	VkImageSubresourceRange range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ct->images = U_TYPED_ARRAY_CALLOC(struct comp_target_image, OFFSCREEN_IMAGE_COUNT);
+
+	for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; i++) {
+		ret = vk_create_image_simple(vk, extent, format, create_info->image_usage, &ow->memories[i],
+		                             &ct->images[i].handle);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_create_image_simple: %s", vk_result_string(ret));
+			break;
+		}
+
+		ret = vk_create_view(vk, ct->images[i].handle, VK_IMAGE_VIEW_TYPE_2D, format, range, &ct->images[i].view);
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(ct->c, "vk_create_view: %s", vk_result_string(ret));
+			break;
+		}
+	}
+
+	ct->image_count = OFFSCREEN_IMAGE_COUNT;
+
+	if (ret != VK_SUCCESS) {
+		destroy_images(ow);
+		return;
+	}
+
+	ct->width = extent.width;
+	ct->height = extent.height;
+	ct->format = format;
+	ct->surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	ow->next_index = 0;
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	return ct->images != NULL;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	*out_index = ow->next_index;
+	ow->next_index = (ow->next_index + 1) % ct->image_count;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+	struct vk_bundle *vk = get_vk(ow);
+
+	// Nothing to show, but the render complete semaphore must be waited on before it is signalled again.
+	VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &ct->semaphores.render_complete,
+	    .pWaitDstStageMask = &stage,
+	};
+
+	return vk_cmd_submit_locked(vk, 1, &submit_info, VK_NULL_HANDLE);
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	// No-op
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	int64_t frame_id = -1;
+	uint64_t wake_up_time_ns = 0;
+	uint64_t desired_present_time_ns = 0;
+	uint64_t present_slop_ns = 0;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(ow->upc,                      //
+	             now_ns,                       //
+	             &frame_id,                    //
+	             &wake_up_time_ns,             //
+	             &desired_present_time_ns,     //
+	             &present_slop_ns,             //
+	             &predicted_display_time_ns,   //
+	             &predicted_display_period_ns, //
+	             &min_display_period_ns);      //
+
+	U_ZERO(&ow->frame);
+	ow->frame.frame_id = frame_id;
+	ow->frame.desired_present_time_ns = desired_present_time_ns;
+	ow->frame.present_slop_ns = present_slop_ns;
+
+	*out_frame_id = frame_id;
+	*out_wake_up_time_ns = wake_up_time_ns;
+	*out_desired_present_time_ns = desired_present_time_ns;
+	*out_predicted_display_time_ns = predicted_display_time_ns;
+	*out_present_slop_ns = present_slop_ns;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+	assert(frame_id == ow->frame.frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(ow->upc, U_TIMING_POINT_WAKE_UP, frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN:
+		u_pc_mark_point(ow->upc, U_TIMING_POINT_BEGIN, frame_id, when_ns);
+		ow->frame.begin_ns = when_ns;
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_BEGIN:
+		u_pc_mark_point(ow->upc, U_TIMING_POINT_SUBMIT_BEGIN, frame_id, when_ns);
+		ow->frame.submit_begin_ns = when_ns;
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_END:
+		u_pc_mark_point(ow->upc, U_TIMING_POINT_SUBMIT_END, frame_id, when_ns);
+		ow->frame.submit_end_ns = when_ns;
+		break;
+	case COMP_TARGET_TIMING_POINT_POSE_SAMPLE:
+		u_pc_mark_point(ow->upc, U_TIMING_POINT_POSE_SAMPLE, frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(struct comp_target *ct,
+                int64_t frame_id,
+                uint64_t gpu_start_ns,
+                uint64_t gpu_end_ns,
+                uint64_t layer_squash_ns,
+                uint64_t distortion_ns,
+                uint64_t when_ns)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	u_pc_info_gpu(ow->upc, frame_id, gpu_start_ns, gpu_end_ns, layer_squash_ns, distortion_ns, when_ns);
+
+	if (frame_id != ow->frame.frame_id) {
+		return;
+	}
+
+	ow->frame.gpu_start_ns = gpu_start_ns;
+	ow->frame.gpu_end_ns = gpu_end_ns;
+	ow->frame.layer_squash_ns = layer_squash_ns;
+	ow->frame.distortion_ns = distortion_ns;
+
+	ow->frame_count++;
+	if (gpu_end_ns > ow->frame.desired_present_time_ns + ow->frame.present_slop_ns) {
+		ow->missed_count++;
+	}
+
+	if (g_frame_listener.func != NULL) {
+		g_frame_listener.func(g_frame_listener.user, &ow->frame);
+	}
+}
+
+static void
+target_info_layers(struct comp_target *ct, int64_t frame_id, uint32_t layer_count, bool fast_path)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	u_pc_info_layers(ow->upc, frame_id, layer_count, fast_path);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	// No-op
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_window_offscreen *ow = (struct comp_window_offscreen *)ct;
+
+	COMP_INFO(ct->c, "Offscreen target rendered %" PRIu64 " frames, %" PRIu64 " missed.", ow->frame_count,
+	          ow->missed_count);
+
+	destroy_images(ow);
+	u_pc_destroy(&ow->upc);
+
+	free(ow);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+comp_window_offscreen_set_frame_func(comp_window_offscreen_frame_func_t func, void *user)
+{
+	g_frame_listener.func = func;
+	g_frame_listener.user = user;
+}
+
+struct comp_target *
+comp_window_offscreen_create(struct comp_compositor *c)
+{
+	struct comp_window_offscreen *ow = U_TYPED_CALLOC(struct comp_window_offscreen);
+
+	ow->base.name = "offscreen";
+	ow->base.c = c;
+	ow->base.init_pre_vulkan = target_init_pre_vulkan;
+	ow->base.init_post_vulkan = target_init_post_vulkan;
+	ow->base.check_ready = target_check_ready;
+	ow->base.create_images = target_create_images;
+	ow->base.has_images = target_has_images;
+	ow->base.acquire = target_acquire;
+	ow->base.present = target_present;
+	ow->base.flush = target_flush;
+	ow->base.calc_frame_pacing = target_calc_frame_pacing;
+	ow->base.mark_timing_point = target_mark_timing_point;
+	ow->base.update_timings = target_update_timings;
+	ow->base.info_gpu = target_info_gpu;
+	ow->base.info_layers = target_info_layers;
+	ow->base.set_title = target_set_title;
+	ow->base.destroy = target_destroy;
+
+	return &ow->base;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	// Never picked as a fallback, only when asked for.
+	return false;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	struct comp_target *ct = comp_window_offscreen_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_offscreen = {
+    .name = "Offscreen",
+    .identifier = "offscreen",
+    .requires_vulkan_for_create = true,
+    .is_deferred = false,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .detect = detect,
+    .create_target = create_target,
+};
@@ -0,0 +1,61 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Frame timings of the offscreen target, usable without Vulkan.
+ * @ingroup comp_main
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Timings of one frame rendered to the offscreen target, all in
+ * @ref os_monotonic_get_ns time.
+ *
+ * @ingroup comp_main
+ */
+struct comp_window_offscreen_frame
+{
+	int64_t frame_id;
+
+	//! When @ref comp_renderer_draw started and when it was done submitting.
+	uint64_t begin_ns;
+	uint64_t submit_begin_ns;
+	uint64_t submit_end_ns;
+
+	//! When the frame should have been done, a frame is missed if the GPU ends after both added together.
+	uint64_t desired_present_time_ns;
+	uint64_t present_slop_ns;
+
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+	uint64_t layer_squash_ns;
+	uint64_t distortion_ns;
+};
+
+/*!
+ * Called from the compositor thread for every frame rendered to the offscreen
+ * target, once the GPU is done with it.
+ *
+ * @ingroup comp_main
+ */
+typedef void (*comp_window_offscreen_frame_func_t)(void *user, const struct comp_window_offscreen_frame *frame);
+
+/*!
+ * Set the function that gets the frame timings of the offscreen target, must
+ * be called before the compositor is created.
+ *
+ * @ingroup comp_main
+ */
+void
+comp_window_offscreen_set_frame_func(comp_window_offscreen_frame_func_t func, void *user);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,9 @@
 #include "main/comp_target_swapchain.h"
 #include "main/comp_window_peek.h"
 
+#include "os/os_time.h"
+
+#include "util/u_time.h"
 #include "util/u_debug.h"
 
 #ifdef XRT_HAVE_SDL2
@@ -23,6 +26,7 @@
 
 
 DEBUG_GET_ONCE_OPTION(window_peek, "XRT_WINDOW_PEEK", NULL)
+DEBUG_GET_ONCE_NUM_OPTION(window_peek_rate, "XRT_WINDOW_PEEK_RATE", 30)
 
 #define PEEK_IMAGE_USAGE (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)
 
@@ -40,6 +44,13 @@ struct comp_window_peek
 	struct vk_cmd_pool pool;
 	VkCommandBuffer cmd;
 
+	//! Signaled when the last blit is done, created signaled.
+	VkFence fence;
+
+	//! Minimum time between blits, zero blits every frame.
+	uint64_t period_ns;
+	uint64_t last_blit_ns;
+
 	struct os_thread_helper oth;
 };
 
@@ -180,6 +191,22 @@ comp_window_peek_create(struct comp_compositor *c)
 
 	VK_NAME_COMMAND_BUFFER(vk, w->cmd, "comp_window_peek command buffer");
 
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+	};
+
+	ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &w->fence);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(c, "vkCreateFence: %s", vk_result_string(ret));
+		goto err_pool;
+	}
+
+	VK_NAME_FENCE(vk, w->fence, "comp_window_peek fence");
+
+	int64_t rate = debug_get_num_option_window_peek_rate();
+	w->period_ns = rate > 0 ? U_TIME_1S_IN_NS / (uint64_t)rate : 0;
+
 
 	/*
 	 * SDL
@@ -238,6 +265,9 @@ err_window:
 	SDL_DestroyWindow(w->window);
 
 err_pool:
+	if (w->fence != VK_NULL_HANDLE) {
+		vk->vkDestroyFence(vk->device, w->fence, NULL);
+	}
 	vk_cmd_pool_destroy(vk, &w->pool);
 
 err_free:
@@ -260,10 +290,14 @@ comp_window_peek_destroy(struct comp_window_peek **w_ptr)
 
 
 	struct vk_bundle *vk = get_vk(w);
+	VkResult ret;
 
-	os_mutex_lock(&vk->queue_mutex);
-	vk->vkDeviceWaitIdle(vk->device);
-	os_mutex_unlock(&vk->queue_mutex);
+	// Only our own last blit can still be in flight, no need to idle the device.
+	ret = vk->vkWaitForFences(vk->device, 1, &w->fence, VK_TRUE, U_TIME_1S_IN_NS);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(w->c, "vkWaitForFences: %s", vk_result_string(ret));
+	}
+	vk->vkDestroyFence(vk->device, w->fence, NULL);
 
 	vk_cmd_pool_lock(&w->pool);
 	vk->vkFreeCommandBuffers(vk->device, w->pool.pool, 1, &w->cmd);
@@ -281,9 +315,26 @@ comp_window_peek_destroy(struct comp_window_peek **w_ptr)
 }
 
 void
-comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, int32_t height)
+comp_window_peek_blit(struct comp_window_peek *w, const VkImage *images, const VkExtent2D *extents, uint32_t count)
 {
-	if (w->hidden || !w->running) {
+	if (w->hidden || !w->running || count == 0) {
+		return;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (now_ns - w->last_blit_ns < w->period_ns) {
+		return;
+	}
+
+	struct vk_bundle *vk = get_vk(w);
+
+	// Drop the frame rather than wait on the previous blit.
+	VkResult ret = vk->vkGetFenceStatus(vk->device, w->fence);
+	if (ret == VK_NOT_READY) {
+		return;
+	}
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(w->c, "vkGetFenceStatus: %s", vk_result_string(ret));
 		return;
 	}
 
@@ -292,21 +343,39 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 		create_images(w);
 	}
 
-	while (!comp_target_check_ready(&w->base.base))
-		;
+	if (!comp_target_check_ready(&w->base.base) || !comp_target_has_images(&w->base.base)) {
+		return;
+	}
 
+	// Don't wait for the window, drop the frame if no image is free.
 	uint32_t current;
-	VkResult ret = comp_target_acquire(&w->base.base, &current);
-	if (ret != VK_SUCCESS) {
-		COMP_ERROR(w->c, "comp_target_acquire: %s", vk_result_string(ret));
+	ret = vk->vkAcquireNextImageKHR(              //
+	    vk->device,                               // device
+	    w->base.swapchain.handle,                 // swapchain
+	    0,                                        // timeout
+	    w->base.base.semaphores.present_complete, // semaphore
+	    VK_NULL_HANDLE,                           // fence
+	    &current);                                // pImageIndex
+	if (ret == VK_NOT_READY || ret == VK_TIMEOUT) {
+		return;
+	}
+	if (ret == VK_ERROR_OUT_OF_DATE_KHR) {
+		// Recreate and try again on the next blit.
+		create_images(w);
+		return;
+	}
+	if (ret != VK_SUCCESS && ret != VK_SUBOPTIMAL_KHR) {
+		COMP_ERROR(w->c, "vkAcquireNextImageKHR: %s", vk_result_string(ret));
+		return;
 	}
 
-	VkImage dst = w->base.base.images[current].handle;
+	w->last_blit_ns = now_ns;
 
-	struct vk_bundle *vk = get_vk(w);
+	VkImage dst = w->base.base.images[current].handle;
 
 	VkCommandBufferBeginInfo begin_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
 	};
 
 	// For writing and submitting commands.
@@ -322,18 +391,25 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 	    .layerCount = 1,
 	};
 
-	// Barrier to make source a source
-	vk_cmd_image_barrier_locked(                       //
-	    vk,                                            // vk_bundle
-	    w->cmd,                                        // cmdbuffer
-	    src,                                           // image
-	    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,          // srcAccessMask
-	    VK_ACCESS_TRANSFER_READ_BIT,                   // dstAccessMask
-	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,      // oldImageLayout
-	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,          // newImageLayout
-	    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // srcStageMask
-	    VK_PIPELINE_STAGE_TRANSFER_BIT,                // dstStageMask
-	    range);                                        // subresourceRange
+	// Written by the squasher and read by the distortion shader.
+	VkPipelineStageFlags written_stages =
+	    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	VkPipelineStageFlags read_stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	// Barriers to make sources a source
+	for (uint32_t i = 0; i < count; i++) {
+		vk_cmd_image_barrier_locked(                  //
+		    vk,                                       // vk_bundle
+		    w->cmd,                                   // cmdbuffer
+		    images[i],                                // image
+		    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,     // srcAccessMask
+		    VK_ACCESS_TRANSFER_READ_BIT,              // dstAccessMask
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // oldImageLayout
+		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,     // newImageLayout
+		    written_stages,                           // srcStageMask
+		    VK_PIPELINE_STAGE_TRANSFER_BIT,           // dstStageMask
+		    range);                                   // subresourceRange
+	}
 
 	// Barrier to make destination a destination
 	vk_cmd_image_barrier_locked(              //
@@ -348,37 +424,41 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 	    VK_PIPELINE_STAGE_TRANSFER_BIT,       // dstStageMask
 	    range);                               // subresourceRange
 
-	VkImageBlit blit = {
-	    .srcSubresource =
-	        {
-	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-	            .layerCount = 1,
-	        },
-	    .dstSubresource =
-	        {
-	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-	            .layerCount = 1,
-	        },
-	};
-
-	blit.srcOffsets[1].x = width;
-	blit.srcOffsets[1].y = height;
-	blit.srcOffsets[1].z = 1;
-
-	blit.dstOffsets[1].x = w->width;
-	blit.dstOffsets[1].y = w->height;
-	blit.dstOffsets[1].z = 1;
-
-	vk->vkCmdBlitImage(                       //
-	    w->cmd,                               // commandBuffer
-	    src,                                  // srcImage
-	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
-	    dst,                                  // dstImage
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
-	    1,                                    // regionCount
-	    &blit,                                // pRegions
-	    VK_FILTER_LINEAR                      // filter
-	);
+	// Each image gets an equal slice of the window, side by side.
+	for (uint32_t i = 0; i < count; i++) {
+		VkImageBlit blit = {
+		    .srcSubresource =
+		        {
+		            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		            .layerCount = 1,
+		        },
+		    .dstSubresource =
+		        {
+		            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		            .layerCount = 1,
+		        },
+		};
+
+		blit.srcOffsets[1].x = (int32_t)extents[i].width;
+		blit.srcOffsets[1].y = (int32_t)extents[i].height;
+		blit.srcOffsets[1].z = 1;
+
+		blit.dstOffsets[0].x = (int32_t)(w->width * i / count);
+		blit.dstOffsets[1].x = (int32_t)(w->width * (i + 1) / count);
+		blit.dstOffsets[1].y = (int32_t)w->height;
+		blit.dstOffsets[1].z = 1;
+
+		vk->vkCmdBlitImage(                       //
+		    w->cmd,                               // commandBuffer
+		    images[i],                            // srcImage
+		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // srcImageLayout
+		    dst,                                  // dstImage
+		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+		    1,                                    // regionCount
+		    &blit,                                // pRegions
+		    VK_FILTER_LINEAR                      // filter
+		);
+	}
 
 	// Reset destination
 	vk_cmd_image_barrier_locked(              //
@@ -393,18 +473,20 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // dstStageMask
 	    range);                               // subresourceRange
 
-	// Reset src
-	vk_cmd_image_barrier_locked(                  //
-	    vk,                                       // vk_bundle
-	    w->cmd,                                   // cmdbuffer
-	    src,                                      // image
-	    VK_ACCESS_TRANSFER_READ_BIT,              // srcAccessMask
-	    0,                                        // dstAccessMask
-	    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,     // oldImageLayout
-	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, // newImageLayout
-	    VK_PIPELINE_STAGE_TRANSFER_BIT,           // srcStageMask
-	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,        // dstStageMask
-	    range);                                   // subresourceRange
+	// Reset sources, the debug gui mirror samples them after us.
+	for (uint32_t i = 0; i < count; i++) {
+		vk_cmd_image_barrier_locked(                  //
+		    vk,                                       // vk_bundle
+		    w->cmd,                                   // cmdbuffer
+		    images[i],                                // image
+		    0,                                        // srcAccessMask
+		    VK_ACCESS_SHADER_READ_BIT,                // dstAccessMask
+		    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,     // oldImageLayout
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // newImageLayout
+		    VK_PIPELINE_STAGE_TRANSFER_BIT,           // srcStageMask
+		    read_stages,                              // dstStageMask
+		    range);                                   // subresourceRange
+	}
 
 	ret = vk->vkEndCommandBuffer(w->cmd);
 	if (ret != VK_SUCCESS) {
@@ -428,8 +510,9 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 	    .pSignalSemaphores = &w->base.base.semaphores.render_complete,
 	};
 
-	// Done writing commands, submit to queue.
-	ret = vk_cmd_submit_locked(vk, 1, &submit, VK_NULL_HANDLE);
+	// Done writing commands, submit to queue, the fence lets the next blit skip instead of wait.
+	vk->vkResetFences(vk->device, 1, &w->fence);
+	ret = vk_cmd_submit_locked(vk, 1, &submit, w->fence);
 
 	// Done submitting commands, unlock pool.
 	vk_cmd_pool_unlock(&w->pool);
@@ -455,7 +538,11 @@ comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, in
 	ret = vk->vkQueuePresentKHR(vk->queue, &present);
 	os_mutex_unlock(&vk->queue_mutex);
 
-	if (ret != VK_SUCCESS) {
+	if (ret == VK_ERROR_OUT_OF_DATE_KHR) {
+		create_images(w);
+		return;
+	}
+	if (ret != VK_SUCCESS && ret != VK_SUBOPTIMAL_KHR) {
 		VK_ERROR(vk, "Error: could not present to queue.\n");
 		return;
 	}
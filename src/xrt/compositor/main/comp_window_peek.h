@@ -38,8 +38,22 @@ comp_window_peek_create(struct comp_compositor *c);
 void
 comp_window_peek_destroy(struct comp_window_peek **w_ptr);
 
+/*!
+ * Blit @p count images side by side into the peek window and present it, at
+ * most at the rate given by the @p XRT_WINDOW_PEEK_RATE option. This never
+ * waits, the frame is dropped if the previous blit is still in flight or if
+ * no window image can be acquired right away.
+ *
+ * The images must be in @p VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL layout
+ * and are returned to it.
+ *
+ * @param[in] w       The peek window struct this compositor has.
+ * @param[in] images  Source images, usually the scratch images.
+ * @param[in] extents Size of each of the source images.
+ * @param[in] count   Number of images, at least one.
+ */
 void
-comp_window_peek_blit(struct comp_window_peek *w, VkImage src, int32_t width, int32_t height);
+comp_window_peek_blit(struct comp_window_peek *w, const VkImage *images, const VkExtent2D *extents, uint32_t count);
 
 /*!
  *
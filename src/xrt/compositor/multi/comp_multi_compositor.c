@@ -19,6 +19,7 @@
 #include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
+#include "util/u_thread_role.h"
 #include "util/u_distortion_mesh.h"
 
 #include "multi/comp_multi_private.h"
@@ -36,6 +37,9 @@
 #endif
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(perf_notify, "XRT_COMPOSITOR_PERF_NOTIFY", false)
+
+
 /*
  *
  * Slot management functions.
@@ -60,36 +64,58 @@ slot_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *slot)
 		}
 	}
 
-	U_ZERO(slot);
+	/*
+	 * Layers past layer_count are never read and their swapchain
+	 * references have already been dropped, only reset the header.
+	 */
+	U_ZERO(&slot->data);
 	slot->data.frame_id = -1;
+	slot->layer_count = 0;
+	slot->active = false;
 }
 
 /*!
- * Clear a slot, need to have the list_and_timing_lock held.
+ * Move a slot into a cleared slot, this just swaps the slot pointers so that
+ * @p src ends up pointing at the cleared slot, nothing is copied.
  */
 static void
-slot_move_into_cleared(struct multi_layer_slot *dst, struct multi_layer_slot *src)
+slot_move_into_cleared(struct multi_layer_slot **dst, struct multi_layer_slot **src)
 {
-	assert(!dst->active);
-	assert(dst->data.frame_id == -1);
+	assert(!(*dst)->active);
+	assert((*dst)->data.frame_id == -1);
 
 	// All references are kept.
+	struct multi_layer_slot *cleared = *dst;
 	*dst = *src;
-
-	U_ZERO(src);
-	src->data.frame_id = -1;
+	*src = cleared;
 }
 
 /*!
- * Move a slot into a cleared slot, must be cleared before.
+ * Clear a slot and move another slot into it, need to have the list_and_timing_lock held.
  */
 static void
-slot_move_and_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *dst, struct multi_layer_slot *src)
+slot_move_and_clear_locked(struct multi_compositor *mc, struct multi_layer_slot **dst, struct multi_layer_slot **src)
 {
-	slot_clear_locked(mc, dst);
+	slot_clear_locked(mc, *dst);
 	slot_move_into_cleared(dst, src);
 }
 
+/*!
+ * The state tracker checks the layer count against the max we advertise, this
+ * guards the slot against anybody else pushing too many layers.
+ */
+static bool
+is_progress_full(struct multi_compositor *mc)
+{
+	if (mc->progress->layer_count < MULTI_MAX_LAYERS) {
+		return false;
+	}
+
+	U_LOG_E("Too many layers, dropping layer (max: %u)", MULTI_MAX_LAYERS);
+
+	return true;
+}
+
 
 /*
  *
@@ -104,120 +130,225 @@ multi_compositor_push_event(struct multi_compositor *mc, const union xrt_session
 	return xrt_session_event_sink_push(mc->xses, xse);
 }
 
+/*!
+ * Turn the render scale recommended by the app pacer into a performance
+ * level, with some hysteresis so we don't flip between levels every frame.
+ */
+static enum xrt_perf_notify_level
+perf_level_from_scale(enum xrt_perf_notify_level current, float scale)
+{
+	switch (current) {
+	case XRT_PERF_NOTIFY_LEVEL_NORMAL: return scale < 0.95f ? XRT_PERF_NOTIFY_LEVEL_WARNING : current;
+	case XRT_PERF_NOTIFY_LEVEL_WARNING:
+		if (scale < 0.8f) {
+			return XRT_PERF_NOTIFY_LEVEL_IMPAIRED;
+		}
+		return scale >= 1.0f ? XRT_PERF_NOTIFY_LEVEL_NORMAL : current;
+	case XRT_PERF_NOTIFY_LEVEL_IMPAIRED: return scale > 0.85f ? XRT_PERF_NOTIFY_LEVEL_WARNING : current;
+	default: return current;
+	}
+}
+
+/*!
+ * Tell the app that it should lower (or can raise) its render resolution,
+ * must not be called with the list_and_timing_lock held.
+ */
+static void
+update_perf_level(struct multi_compositor *mc, float scale)
+{
+	if (!debug_get_bool_option_perf_notify()) {
+		return;
+	}
+
+	enum xrt_perf_notify_level from = mc->perf_level;
+	enum xrt_perf_notify_level to = perf_level_from_scale(from, scale);
+	if (from == to) {
+		return;
+	}
+
+	mc->perf_level = to;
+
+	union xrt_session_event xse = XRT_STRUCT_INIT;
+	xse.performance.type = XRT_SESSION_EVENT_PERFORMANCE_CHANGE;
+	xse.performance.domain = XRT_PERF_DOMAIN_GPU;
+	xse.performance.sub_domain = XRT_PERF_SUB_DOMAIN_RENDERING;
+	xse.performance.from_level = from;
+	xse.performance.to_level = to;
+
+	xrt_result_t xret = multi_compositor_push_event(mc, &xse);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_W("Failed to push performance change event: %d", xret);
+	}
+}
+
 
 /*
  *
- * Wait helper thread.
+ * Wait helper threads.
  *
  */
 
+/*!
+ * How long the wait thread waits on the GPU work of a frame before it warns
+ * about it not being done, it then goes back to waiting.
+ */
+#define WAIT_WARN_NS (100 * U_TIME_1MS_IN_NS)
+
 static bool
-is_pushed_or_waiting_locked(struct multi_compositor *mc)
+wait_item_is_pending(const struct multi_wait_item *wi)
 {
-	return mc->wait_thread.waiting ||     //
-	       mc->wait_thread.xcf != NULL || //
-	       mc->wait_thread.xcsem != NULL; //
+	return wi->xcf != NULL || wi->xcsem != NULL;
 }
 
-static void
-wait_fence(struct xrt_compositor_fence **xcf_ptr)
+/*!
+ * Waits on the sync object of the item, returns false on timeout, or true if
+ * the sync object has signalled or failed and has been released.
+ */
+static bool
+wait_item_sync_object(struct multi_wait_item *wi, uint64_t timeout_ns)
 {
-	COMP_TRACE_MARKER();
 	xrt_result_t ret = XRT_SUCCESS;
 
-	// 100ms
-	uint64_t timeout_ns = 100 * U_TIME_1MS_IN_NS;
+	if (wi->xcsem != NULL) {
+		ret = xrt_compositor_semaphore_wait(wi->xcsem, wi->value, timeout_ns);
+		if (ret == XRT_TIMEOUT) {
+			return false;
+		}
 
-	do {
-		ret = xrt_compositor_fence_wait(*xcf_ptr, timeout_ns);
-		if (ret != XRT_TIMEOUT) {
-			break;
+		xrt_compositor_semaphore_reference(&wi->xcsem, NULL);
+
+		if (ret != XRT_SUCCESS) {
+			U_LOG_E("Semaphore waiting failed!");
 		}
+	}
 
-		U_LOG_W("Waiting on client fence timed out > 100ms!");
-	} while (true);
+	if (wi->xcf != NULL) {
+		ret = xrt_compositor_fence_wait(wi->xcf, timeout_ns);
+		if (ret == XRT_TIMEOUT) {
+			return false;
+		}
 
-	xrt_compositor_fence_destroy(xcf_ptr);
+		xrt_compositor_fence_destroy(&wi->xcf);
 
-	if (ret != XRT_SUCCESS) {
-		U_LOG_E("Fence waiting failed!");
+		if (ret != XRT_SUCCESS) {
+			U_LOG_E("Fence waiting failed!");
+		}
 	}
+
+	return true;
 }
 
 static void
-wait_semaphore(struct xrt_compositor_semaphore **xcsem_ptr, uint64_t value)
+mark_wait_item_gpu_done(struct multi_wait_item *wi)
 {
-	COMP_TRACE_MARKER();
-	xrt_result_t ret = XRT_SUCCESS;
+	struct multi_compositor *mc = wi->mc;
 
-	// 100ms
-	uint64_t timeout_ns = 100 * U_TIME_1MS_IN_NS;
+	// Sample time outside of lock.
+	uint64_t now_ns = os_monotonic_get_ns();
 
-	do {
-		ret = xrt_compositor_semaphore_wait(*xcsem_ptr, value, timeout_ns);
-		if (ret != XRT_TIMEOUT) {
-			break;
-		}
+	float scale = 1.0f;
 
-		U_LOG_W("Waiting on client semaphore value '%" PRIu64 "' timed out > 100ms!", value);
-	} while (true);
+	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	u_pa_mark_gpu_done(mc->upa, wi->frame_id, now_ns);
+	u_pa_get_render_scale(mc->upa, &scale);
+	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
-	xrt_compositor_semaphore_reference(xcsem_ptr, NULL);
+	update_perf_level(mc, scale);
+}
 
-	if (ret != XRT_SUCCESS) {
-		U_LOG_E("Semaphore waiting failed!");
+/*!
+ * Waits on the sync object of the item and marks the GPU work as done, returns
+ * false if the GPU work was not done within @p timeout_ns.
+ */
+static bool
+check_wait_item(struct multi_wait_item *wi, uint64_t timeout_ns)
+{
+	if (!wait_item_sync_object(wi, timeout_ns)) {
+		return false;
 	}
+
+	mark_wait_item_gpu_done(wi);
+
+	return true;
 }
 
+/*!
+ * Blocks until the GPU work of any of the pending items might be done, the
+ * thread is woken up, or @p timeout_ns has passed.
+ *
+ * If all pending items have timeline semaphores they are waited on at once
+ * together with the wake semaphore. Otherwise it blocks on the oldest pending
+ * item, then wakes are only noticed once it is done or at the timeout.
+ */
 static void
-wait_for_scheduled_free(struct multi_compositor *mc)
+wait_for_any_gpu_work(struct multi_system_compositor *msc,
+                      struct multi_wait_item *items,
+                      uint32_t item_count,
+                      uint64_t wake_value,
+                      uint64_t timeout_ns)
 {
 	COMP_TRACE_MARKER();
 
-	os_mutex_lock(&mc->slot_lock);
-
-	struct multi_compositor volatile *v_mc = mc;
+	struct xrt_compositor_semaphore *wake_xcsem = msc->wait_thread.wake_xcsem;
+	struct xrt_compositor_semaphore *xcsems[MULTI_MAX_CLIENTS + 1];
+	uint64_t values[MULTI_MAX_CLIENTS + 1];
+	struct multi_wait_item *oldest = NULL;
+	bool can_wait_any = wake_xcsem != NULL;
+	uint32_t count = 0;
 
-	// Block here if the scheduled slot is not clear.
-	while (v_mc->scheduled.active) {
-		uint64_t now_ns = os_monotonic_get_ns();
+	for (uint32_t i = 0; i < item_count; i++) {
+		struct multi_wait_item *wi = &items[i];
+		if (!wait_item_is_pending(wi)) {
+			continue;
+		}
 
-		// This frame is for the next frame, drop the old one no matter what.
-		if (time_is_within_half_ms(mc->progress.data.display_time_ns, mc->slot_next_frame_display)) {
-			U_LOG_W("%.3fms: Dropping old missed frame in favour for completed new frame",
-			        time_ns_to_ms_f(now_ns));
-			break;
+		// Items are kept in the order they were pushed.
+		if (oldest == NULL) {
+			oldest = wi;
 		}
 
-		// Replace the scheduled frame if it's in the past.
-		if (v_mc->scheduled.data.display_time_ns < now_ns) {
-			U_LOG_T("%.3fms: Replacing frame for time in past in favour of completed new frame",
-			        time_ns_to_ms_f(now_ns));
-			break;
+		if (wi->xcf != NULL || !can_wait_any || wi->xcsem->wait_any != wake_xcsem->wait_any) {
+			can_wait_any = false;
+			continue;
 		}
 
-		U_LOG_D(
-		    "Two frames have completed GPU work and are waiting to be displayed."
-		    "\n\tnext frame: %fms (%" PRIu64
-		    ") (next time for compositor to pick up frame)"
-		    "\n\tprogress: %fms (%" PRIu64
-		    ")  (latest completed frame)"
-		    "\n\tscheduled: %fms (%" PRIu64 ") (oldest waiting frame)",
-		    time_ns_to_ms_f((int64_t)v_mc->slot_next_frame_display - now_ns),        //
-		    v_mc->slot_next_frame_display,                                           //
-		    time_ns_to_ms_f((int64_t)v_mc->progress.data.display_time_ns - now_ns),  //
-		    v_mc->progress.data.display_time_ns,                                     //
-		    time_ns_to_ms_f((int64_t)v_mc->scheduled.data.display_time_ns - now_ns), //
-		    v_mc->scheduled.data.display_time_ns);                                   //
+		xcsems[count] = wi->xcsem;
+		values[count] = wi->value;
+		count++;
+	}
 
-		os_mutex_unlock(&mc->slot_lock);
+	if (oldest == NULL) {
+		return;
+	}
 
-		os_precise_sleeper_nanosleep(&mc->scheduled_sleeper, U_TIME_1MS_IN_NS);
+	if (can_wait_any) {
+		xcsems[count] = wake_xcsem;
+		values[count] = wake_value + 1;
+		count++;
+
+		xrt_result_t xret = xrt_compositor_semaphore_wait_any(xcsems, values, count, timeout_ns);
+		if (xret == XRT_SUCCESS || xret == XRT_TIMEOUT) {
+			return;
+		}
 
-		os_mutex_lock(&mc->slot_lock);
+		U_LOG_E("Waiting on the semaphores of all clients failed, waiting on the oldest frame!");
 	}
 
-	os_mutex_unlock(&mc->slot_lock);
+	check_wait_item(oldest, timeout_ns);
+}
+
+/*!
+ * Move the frame from the progress slot to scheduled, unless the scheduled
+ * slot is still in use. Lowers @p in_out_retry_ns to when the scheduled frame
+ * is in the past and can be replaced.
+ *
+ * Once moved the client thread is released, and the compositor might be
+ * destroyed as soon as this function returns.
+ */
+static bool
+try_move_to_scheduled(struct multi_compositor *mc, uint64_t *in_out_retry_ns)
+{
+	COMP_TRACE_MARKER();
 
 	/*
 	 * Need to take list_and_timing_lock before slot_lock because slot_lock
@@ -226,170 +357,269 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 	 */
 	os_mutex_lock(&mc->msc->list_and_timing_lock);
 	os_mutex_lock(&mc->slot_lock);
-	slot_move_and_clear_locked(mc, &mc->scheduled, &mc->progress);
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	bool can_move = !mc->scheduled->active;
+
+	// This frame is for the next frame, drop the old one no matter what.
+	if (!can_move && time_is_within_half_ms(mc->progress->data.display_time_ns, mc->slot_next_frame_display)) {
+		U_LOG_W("%.3fms: Dropping old missed frame in favour for completed new frame", time_ns_to_ms_f(now_ns));
+		can_move = true;
+	}
+
+	// Replace the scheduled frame if it's in the past.
+	if (!can_move && mc->scheduled->data.display_time_ns < now_ns) {
+		U_LOG_T("%.3fms: Replacing frame for time in past in favour of completed new frame",
+		        time_ns_to_ms_f(now_ns));
+		can_move = true;
+	}
+
+	if (can_move) {
+		slot_move_and_clear_locked(mc, &mc->scheduled, &mc->progress);
+
+		/*
+		 * Finally no longer waiting, this must be done after the frame has
+		 * been moved from progress to scheduled to be picked up by the
+		 * compositor.
+		 */
+		mc->wait_thread.waiting = false;
+		os_cond_signal(&mc->slot_cond);
+	} else {
+		U_LOG_D(
+		    "Two frames have completed GPU work and are waiting to be displayed."
+		    "\n\tnext frame: %fms (%" PRIu64
+		    ") (next time for compositor to pick up frame)"
+		    "\n\tprogress: %fms (%" PRIu64
+		    ")  (latest completed frame)"
+		    "\n\tscheduled: %fms (%" PRIu64 ") (oldest waiting frame)",
+		    time_ns_to_ms_f((int64_t)mc->slot_next_frame_display - now_ns),        //
+		    mc->slot_next_frame_display,                                           //
+		    time_ns_to_ms_f((int64_t)mc->progress->data.display_time_ns - now_ns),  //
+		    mc->progress->data.display_time_ns,                                     //
+		    time_ns_to_ms_f((int64_t)mc->scheduled->data.display_time_ns - now_ns), //
+		    mc->scheduled->data.display_time_ns);                                   //
+
+		uint64_t retry_ns = mc->scheduled->data.display_time_ns + 1;
+		if (retry_ns < *in_out_retry_ns) {
+			*in_out_retry_ns = retry_ns;
+		}
+	}
+
 	os_mutex_unlock(&mc->slot_lock);
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+
+	return can_move;
+}
+
+/*!
+ * Wake up the wait thread, both when it's sleeping on its conditional variable
+ * and when it's blocked on the semaphores of the clients.
+ */
+static void
+wake_wait_thread_locked(struct multi_system_compositor *msc)
+{
+	os_thread_helper_signal_locked(&msc->wait_thread.oth);
+
+	if (msc->wait_thread.wake_xcsem == NULL) {
+		return;
+	}
+
+	xrt_result_t xret = xrt_compositor_semaphore_signal( //
+	    msc->wait_thread.wake_xcsem,                     //
+	    ++msc->wait_thread.wake_value);                  //
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Failed to signal the wake semaphore!");
+	}
 }
 
 static void *
 run_func(void *ptr)
 {
-	struct multi_compositor *mc = (struct multi_compositor *)ptr;
+	struct multi_system_compositor *msc = (struct multi_system_compositor *)ptr;
+	struct multi_wait_item items[MULTI_MAX_CLIENTS];
+	uint32_t item_count = 0;
 
 	U_TRACE_SET_THREAD_NAME("Multi Client Module: Waiter");
-	os_thread_helper_name(&mc->wait_thread.oth, "Multi Client Module: Waiter");
+	os_thread_helper_name(&msc->wait_thread.oth, "Multi Client Module: Waiter");
+
+	// Clients are blocked on this thread to render their frames.
+	u_thread_role_apply(U_THREAD_ROLE_IPC_FRAME, U_LOGGING_INFO, "Multi Client Module: Waiter");
 
-	os_thread_helper_lock(&mc->wait_thread.oth);
+	os_thread_helper_lock(&msc->wait_thread.oth);
 
 	// Signal the start function that we are enterting the loop.
-	mc->wait_thread.alive = true;
-	os_thread_helper_signal_locked(&mc->wait_thread.oth);
+	msc->wait_thread.alive = true;
+	os_thread_helper_signal_locked(&msc->wait_thread.oth);
 
 	/*
-	 * One can view the layer_commit function and the wait thread as a
-	 * producer/consumer pair. This loop is the consumer side of that pair.
-	 * We look for either a fence or a semaphore on each loop, if none are
-	 * found we check if we are running then wait on the conditional
-	 * variable once again waiting to be signalled by the producer.
+	 * One can view the clients as producers and this thread as the
+	 * consumer. The thread waits on the GPU work of all pushed frames at
+	 * once, and moves the frames that are done to the scheduled slot of
+	 * their client, which releases the client. A frame that can't be moved
+	 * yet waits until a scheduled slot is freed, the timings changes, or
+	 * the scheduled frame ends up in the past so that it can be replaced.
 	 */
-	while (os_thread_helper_is_running_locked(&mc->wait_thread.oth)) {
-		/*
-		 * Here we wait for the either a semaphore or a fence, if
-		 * neither has been set we wait/sleep here (again).
-		 */
-		if (mc->wait_thread.xcsem == NULL && mc->wait_thread.xcf == NULL) {
-			// Spurious wakeups are handled below.
-			os_thread_helper_wait_locked(&mc->wait_thread.oth);
-			// Fall through here on stopping to clean up and outstanding waits.
+	while (os_thread_helper_is_running_locked(&msc->wait_thread.oth)) {
+		// Pick up any pushed frames, no need to ref, a move.
+		for (uint32_t i = 0; i < msc->wait_thread.pushed_count; i++) {
+			assert(item_count < ARRAY_SIZE(items));
+			items[item_count++] = msc->wait_thread.pushed[i];
 		}
+		msc->wait_thread.pushed_count = 0;
 
-		int64_t frame_id = mc->wait_thread.frame_id;
-		struct xrt_compositor_fence *xcf = mc->wait_thread.xcf;
-		struct xrt_compositor_semaphore *xcsem = mc->wait_thread.xcsem; // No need to ref, a move.
-		uint64_t value = mc->wait_thread.value;
-
-		// Ok to clear these on spurious wakeup as they are empty then anyways.
-		mc->wait_thread.frame_id = 0;
-		mc->wait_thread.xcf = NULL;
-		mc->wait_thread.xcsem = NULL;
-		mc->wait_thread.value = 0;
-
-		// We are being stopped, or a spurious wakeup, loop back and check running.
-		if (xcf == NULL && xcsem == NULL) {
+		// Nothing to do, or a spurious wakeup, loop back and check running.
+		if (item_count == 0) {
+			os_thread_helper_wait_locked(&msc->wait_thread.oth);
 			continue;
 		}
 
-		// We now know that we should wait.
-		mc->wait_thread.waiting = true;
+		uint64_t slot_generation = msc->wait_thread.slot_generation;
+		uint64_t wake_value = msc->wait_thread.wake_value;
 
-		os_thread_helper_unlock(&mc->wait_thread.oth);
+		os_thread_helper_unlock(&msc->wait_thread.oth);
 
-		if (xcsem != NULL) {
-			wait_semaphore(&xcsem, value);
-		}
-		if (xcf != NULL) {
-			wait_fence(&xcf);
+		uint64_t now_ns = os_monotonic_get_ns();
+		uint64_t deadline_ns = UINT64_MAX;
+		bool any_pending = false;
+		bool any_scheduled = false;
+		uint32_t kept = 0;
+
+		for (uint32_t i = 0; i < item_count; i++) {
+			struct multi_wait_item *wi = &items[i];
+
+			// Only check, the blocking is done below for all of them at once.
+			if (wait_item_is_pending(wi) && !check_wait_item(wi, 0)) {
+				if (now_ns >= wi->warn_ns) {
+					U_LOG_W("Sync object for frame %" PRIi64 " not done after > 100ms!", wi->frame_id);
+					wi->warn_ns = now_ns + WAIT_WARN_NS;
+				}
+				if (wi->warn_ns < deadline_ns) {
+					deadline_ns = wi->warn_ns;
+				}
+
+				any_pending = true;
+				items[kept++] = *wi;
+				continue;
+			}
+
+			// The client might be gone once moved, don't touch it again.
+			if (try_move_to_scheduled(wi->mc, &deadline_ns)) {
+				any_scheduled = true;
+				continue;
+			}
+
+			items[kept++] = *wi;
 		}
+		item_count = kept;
 
-		// Sample time outside of lock.
-		uint64_t now_ns = os_monotonic_get_ns();
+		// Let an idling render loop know there is something to show.
+		if (any_scheduled) {
+			multi_system_compositor_notify_new_frame(msc);
+		}
 
-		os_mutex_lock(&mc->msc->list_and_timing_lock);
-		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
-		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+		now_ns = os_monotonic_get_ns();
+		uint64_t timeout_ns = deadline_ns > now_ns ? deadline_ns - now_ns : 0;
 
-		// Wait for the delivery slot.
-		wait_for_scheduled_free(mc);
+		/*
+		 * Block on the GPU work until the first deadline, any push, freed
+		 * scheduled slot and timing change signals the wake semaphore.
+		 */
+		if (any_pending && timeout_ns > 0) {
+			wait_for_any_gpu_work(msc, items, item_count, wake_value, timeout_ns);
+		}
 
-		os_thread_helper_lock(&mc->wait_thread.oth);
+		os_thread_helper_lock(&msc->wait_thread.oth);
 
 		/*
-		 * Finally no longer waiting, this must be done after
-		 * wait_for_scheduled_free because it moves the slots/layers
-		 * from progress to scheduled to be picked up by the compositor.
+		 * Only frames waiting for their scheduled slot remain, sleep until
+		 * a frame is delivered, the timings changes, another frame is
+		 * pushed, or the oldest scheduled frame ends up in the past.
 		 */
-		mc->wait_thread.waiting = false;
+		if (item_count > 0 && !any_pending && timeout_ns > 0 && msc->wait_thread.pushed_count == 0 &&
+		    slot_generation == msc->wait_thread.slot_generation) {
+			os_thread_helper_timedwait_locked(&msc->wait_thread.oth, timeout_ns);
+		}
+	}
 
-		if (mc->wait_thread.blocked) {
-			// Release one thread
-			mc->wait_thread.blocked = false;
-			os_thread_helper_signal_locked(&mc->wait_thread.oth);
+	// Only stopped once all clients are gone, but clean up just in case.
+	for (uint32_t i = 0; i < item_count; i++) {
+		xrt_compositor_semaphore_reference(&items[i].xcsem, NULL);
+		if (items[i].xcf != NULL) {
+			xrt_compositor_fence_destroy(&items[i].xcf);
 		}
 	}
 
-	os_thread_helper_unlock(&mc->wait_thread.oth);
+	os_thread_helper_unlock(&msc->wait_thread.oth);
 
 	return NULL;
 }
 
+/*!
+ * Block until the wait thread has moved the last pushed frame to the scheduled
+ * slot, must be called with the slot_lock held.
+ */
 static void
 wait_for_wait_thread_locked(struct multi_compositor *mc)
 {
 	// Should we wait for the last frame.
-	if (is_pushed_or_waiting_locked(mc)) {
+	while (mc->wait_thread.waiting) {
 		COMP_TRACE_IDENT(blocked);
 
-		// There should only be one thread entering here.
-		assert(mc->wait_thread.blocked == false);
-
-		// OK, wait until the wait thread releases us by setting blocked to false
-		mc->wait_thread.blocked = true;
-		while (mc->wait_thread.blocked) {
-			os_thread_helper_wait_locked(&mc->wait_thread.oth);
-		}
+		// Signalled by the wait thread once it has moved the frame.
+		os_cond_wait(&mc->slot_cond, &mc->slot_lock);
 	}
 }
 
 static void
 wait_for_wait_thread(struct multi_compositor *mc)
 {
-	os_thread_helper_lock(&mc->wait_thread.oth);
+	os_mutex_lock(&mc->slot_lock);
 
 	wait_for_wait_thread_locked(mc);
 
-	os_thread_helper_unlock(&mc->wait_thread.oth);
+	os_mutex_unlock(&mc->slot_lock);
 }
 
+/*!
+ * Push the frame in the progress slot to the wait thread, if both @p xcf and
+ * @p xcsem are NULL the GPU work is assumed to be completed.
+ */
 static void
-push_fence_to_wait_thread(struct multi_compositor *mc, int64_t frame_id, struct xrt_compositor_fence *xcf)
+push_to_wait_thread(struct multi_compositor *mc,
+                    int64_t frame_id,
+                    struct xrt_compositor_fence *xcf,
+                    struct xrt_compositor_semaphore *xcsem,
+                    uint64_t value)
 {
-	os_thread_helper_lock(&mc->wait_thread.oth);
+	struct multi_system_compositor *msc = mc->msc;
+
+	os_mutex_lock(&mc->slot_lock);
 
 	// The function begin_layer should have waited, but just in case.
 	assert(!mc->wait_thread.waiting);
 	wait_for_wait_thread_locked(mc);
 
-	assert(mc->wait_thread.xcf == NULL);
-
-	mc->wait_thread.frame_id = frame_id;
-	mc->wait_thread.xcf = xcf;
-
-	os_thread_helper_signal_locked(&mc->wait_thread.oth);
-
-	os_thread_helper_unlock(&mc->wait_thread.oth);
-}
-
-static void
-push_semaphore_to_wait_thread(struct multi_compositor *mc,
-                              int64_t frame_id,
-                              struct xrt_compositor_semaphore *xcsem,
-                              uint64_t value)
-{
-	os_thread_helper_lock(&mc->wait_thread.oth);
+	// We now know that we should wait.
+	mc->wait_thread.waiting = true;
 
-	// The function begin_layer should have waited, but just in case.
-	assert(!mc->wait_thread.waiting);
-	wait_for_wait_thread_locked(mc);
+	os_mutex_unlock(&mc->slot_lock);
 
-	assert(mc->wait_thread.xcsem == NULL);
+	struct multi_wait_item wi = {
+	    .mc = mc,
+	    .xcf = xcf,
+	    .value = value,
+	    .frame_id = frame_id,
+	    .warn_ns = os_monotonic_get_ns() + WAIT_WARN_NS,
+	};
+	xrt_compositor_semaphore_reference(&wi.xcsem, xcsem);
 
-	mc->wait_thread.frame_id = frame_id;
-	xrt_compositor_semaphore_reference(&mc->wait_thread.xcsem, xcsem);
-	mc->wait_thread.value = value;
+	os_thread_helper_lock(&msc->wait_thread.oth);
 
-	os_thread_helper_signal_locked(&mc->wait_thread.oth);
+	assert(msc->wait_thread.pushed_count < ARRAY_SIZE(msc->wait_thread.pushed));
+	msc->wait_thread.pushed[msc->wait_thread.pushed_count++] = wi;
+	wake_wait_thread_locked(msc);
 
-	os_thread_helper_unlock(&mc->wait_thread.oth);
+	os_thread_helper_unlock(&msc->wait_thread.oth);
 }
 
 
@@ -635,11 +865,11 @@ multi_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_f
 	 */
 	wait_for_wait_thread(mc);
 
-	assert(mc->progress.layer_count == 0);
-	U_ZERO(&mc->progress);
+	// The progress slot is always cleared when it is moved in.
+	assert(mc->progress->layer_count == 0);
 
-	mc->progress.active = true;
-	mc->progress.data = *data;
+	mc->progress->active = true;
+	mc->progress->data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -652,13 +882,16 @@ multi_compositor_layer_stereo_projection(struct xrt_compositor *xc,
                                          const struct xrt_layer_data *data)
 {
 	struct multi_compositor *mc = multi_compositor(xc);
-	(void)mc;
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], l_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[1], r_xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], l_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[1], r_xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -674,13 +907,17 @@ multi_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], l_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[1], r_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[2], l_d_xsc);
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[3], r_d_xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], l_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[1], r_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[2], l_d_xsc);
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[3], r_d_xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -693,10 +930,14 @@ multi_compositor_layer_quad(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -709,10 +950,14 @@ multi_compositor_layer_cube(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -725,10 +970,14 @@ multi_compositor_layer_cylinder(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -741,10 +990,14 @@ multi_compositor_layer_equirect1(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -757,10 +1010,14 @@ multi_compositor_layer_equirect2(struct xrt_compositor *xc,
 {
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	size_t index = mc->progress.layer_count++;
-	mc->progress.layers[index].xdev = xdev;
-	xrt_swapchain_reference(&mc->progress.layers[index].xscs[0], xsc);
-	mc->progress.layers[index].data = *data;
+	if (is_progress_full(mc)) {
+		return XRT_SUCCESS;
+	}
+
+	size_t index = mc->progress->layer_count++;
+	mc->progress->layers[index].xdev = xdev;
+	xrt_swapchain_reference(&mc->progress->layers[index].xscs[0], xsc);
+	mc->progress->layers[index].data = *data;
 
 	return XRT_SUCCESS;
 }
@@ -772,7 +1029,7 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 
 	struct multi_compositor *mc = multi_compositor(xc);
 	struct xrt_compositor_fence *xcf = NULL;
-	int64_t frame_id = mc->progress.data.frame_id;
+	int64_t frame_id = mc->progress->data.frame_id;
 
 	do {
 		if (!xrt_graphics_sync_handle_is_valid(sync_handle)) {
@@ -796,16 +1053,22 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 	} while (false); // Goto without the labels.
 
 	if (xcf != NULL) {
-		push_fence_to_wait_thread(mc, frame_id, xcf);
+		push_to_wait_thread(mc, frame_id, xcf, NULL, 0);
 	} else {
 		// Assume that the app side compositor waited.
 		uint64_t now_ns = os_monotonic_get_ns();
 
+		float scale = 1.0f;
+
 		os_mutex_lock(&mc->msc->list_and_timing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
+		u_pa_get_render_scale(mc->upa, &scale);
 		os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
-		wait_for_scheduled_free(mc);
+		update_perf_level(mc, scale);
+
+		// Nothing to wait on, the wait thread only moves it to scheduled.
+		push_to_wait_thread(mc, frame_id, NULL, NULL, 0);
 	}
 
 	return XRT_SUCCESS;
@@ -819,9 +1082,9 @@ multi_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	COMP_TRACE_MARKER();
 
 	struct multi_compositor *mc = multi_compositor(xc);
-	int64_t frame_id = mc->progress.data.frame_id;
+	int64_t frame_id = mc->progress->data.frame_id;
 
-	push_semaphore_to_wait_thread(mc, frame_id, xcsem, value);
+	push_to_wait_thread(mc, frame_id, NULL, xcsem, value);
 
 	return XRT_SUCCESS;
 }
@@ -855,6 +1118,22 @@ multi_compositor_request_display_refresh_rate(struct xrt_compositor *xc, float d
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+multi_compositor_set_performance_level(struct xrt_compositor *xc,
+                                       enum xrt_perf_domain domain,
+                                       enum xrt_perf_set_level level)
+{
+	COMP_TRACE_MARKER();
+
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	if (mc->msc->xcn->base.set_performance_level == NULL) {
+		return XRT_SUCCESS;
+	}
+
+	return xrt_comp_set_performance_level(&mc->msc->xcn->base, domain, level);
+}
+
 static void
 multi_compositor_destroy(struct xrt_compositor *xc)
 {
@@ -867,6 +1146,17 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 		mc->state.session_active = false;
 	}
 
+	/*
+	 * Let the wait thread finish with any pushed frame while we are still
+	 * on the list, after this it will not touch this compositor anymore.
+	 */
+	wait_for_wait_thread(mc);
+
+	os_thread_helper_lock(&mc->msc->wait_thread.oth);
+	assert(mc->msc->wait_thread.client_count > 0);
+	mc->msc->wait_thread.client_count--;
+	os_thread_helper_unlock(&mc->msc->wait_thread.oth);
+
 	os_mutex_lock(&mc->msc->list_and_timing_lock);
 
 	// Remove it from the list of clients.
@@ -878,22 +1168,19 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
-	// Destroy the wait thread, destroy also stops the thread.
-	os_thread_helper_destroy(&mc->wait_thread.oth);
-
 	// We are now off the rendering list, clear slots for any swapchains.
 	os_mutex_lock(&mc->msc->list_and_timing_lock);
-	slot_clear_locked(mc, &mc->progress);
-	slot_clear_locked(mc, &mc->scheduled);
-	slot_clear_locked(mc, &mc->delivered);
+	slot_clear_locked(mc, mc->progress);
+	slot_clear_locked(mc, mc->scheduled);
+	slot_clear_locked(mc, mc->delivered);
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
 	// Does null checking.
 	u_pa_destroy(&mc->upa);
 
 	os_precise_sleeper_deinit(&mc->frame_sleeper);
-	os_precise_sleeper_deinit(&mc->scheduled_sleeper);
 
+	os_cond_destroy(&mc->slot_cond);
 	os_mutex_destroy(&mc->slot_lock);
 
 	free(mc);
@@ -917,15 +1204,18 @@ multi_compositor_deliver_any_frames(struct multi_compositor *mc, uint64_t displa
 {
 	os_mutex_lock(&mc->slot_lock);
 
-	if (!mc->scheduled.active) {
+	if (!mc->scheduled->active) {
 		os_mutex_unlock(&mc->slot_lock);
 		return;
 	}
 
-	if (time_is_greater_then_or_within_half_ms(display_time_ns, mc->scheduled.data.display_time_ns)) {
+	if (time_is_greater_then_or_within_half_ms(display_time_ns, mc->scheduled->data.display_time_ns)) {
 		slot_move_and_clear_locked(mc, &mc->delivered, &mc->scheduled);
 
-		uint64_t frame_time_ns = mc->delivered.data.display_time_ns;
+		// The wait thread might be waiting on the scheduled slot.
+		multi_system_compositor_wake_wait_thread(mc->msc);
+
+		uint64_t frame_time_ns = mc->delivered->data.display_time_ns;
 		if (!time_is_within_half_ms(frame_time_ns, display_time_ns)) {
 			log_frame_time_diff(frame_time_ns, display_time_ns);
 		}
@@ -937,13 +1227,13 @@ multi_compositor_deliver_any_frames(struct multi_compositor *mc, uint64_t displa
 void
 multi_compositor_latch_frame_locked(struct multi_compositor *mc, uint64_t when_ns, int64_t system_frame_id)
 {
-	u_pa_latched(mc->upa, mc->delivered.data.frame_id, when_ns, system_frame_id);
+	u_pa_latched(mc->upa, mc->delivered->data.frame_id, when_ns, system_frame_id);
 }
 
 void
 multi_compositor_retire_delivered_locked(struct multi_compositor *mc, uint64_t when_ns)
 {
-	slot_clear_locked(mc, &mc->delivered);
+	slot_clear_locked(mc, mc->delivered);
 }
 
 xrt_result_t
@@ -954,8 +1244,25 @@ multi_compositor_create(struct multi_system_compositor *msc,
 {
 	COMP_TRACE_MARKER();
 
+	// The wait thread can only keep track of this many clients.
+	os_thread_helper_lock(&msc->wait_thread.oth);
+	bool full = msc->wait_thread.client_count >= MULTI_MAX_CLIENTS;
+	if (!full) {
+		msc->wait_thread.client_count++;
+	}
+	os_thread_helper_unlock(&msc->wait_thread.oth);
+
+	if (full) {
+		U_LOG_E("Too many clients, max is %d!", MULTI_MAX_CLIENTS);
+		return XRT_ERROR_ALLOCATION;
+	}
+
 	struct multi_compositor *mc = U_TYPED_CALLOC(struct multi_compositor);
 
+	mc->progress = &mc->slots[0];
+	mc->scheduled = &mc->slots[1];
+	mc->delivered = &mc->slots[2];
+
 	mc->base.base.get_swapchain_create_properties = multi_compositor_get_swapchain_create_properties;
 	mc->base.base.create_swapchain = multi_compositor_create_swapchain;
 	mc->base.base.import_swapchain = multi_compositor_import_swapchain;
@@ -982,12 +1289,13 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.set_thread_hint = multi_compositor_set_thread_hint;
 	mc->base.base.get_display_refresh_rate = multi_compositor_get_display_refresh_rate;
 	mc->base.base.request_display_refresh_rate = multi_compositor_request_display_refresh_rate;
+	mc->base.base.set_performance_level = multi_compositor_set_performance_level;
 	mc->msc = msc;
 	mc->xses = xses;
 	mc->xsi = *xsi;
 
 	os_mutex_init(&mc->slot_lock);
-	os_thread_helper_init(&mc->wait_thread.oth);
+	os_cond_init(&mc->slot_cond);
 
 	// Passthrough our formats from the native compositor to the client.
 	mc->base.base.info = msc->xcn->base.info;
@@ -995,9 +1303,6 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	// Used in wait frame.
 	os_precise_sleeper_init(&mc->frame_sleeper);
 
-	// Used in scheduled waiting function.
-	os_precise_sleeper_init(&mc->scheduled_sleeper);
-
 	// This is safe to do without a lock since we are not on the list yet.
 	u_paf_create(msc->upaf, &mc->upa);
 
@@ -1020,20 +1325,55 @@ multi_compositor_create(struct multi_system_compositor *msc,
 
 	os_mutex_unlock(&msc->list_and_timing_lock);
 
-	// Last start the wait thread.
-	os_thread_helper_start(&mc->wait_thread.oth, run_func, mc);
+	*out_xcn = &mc->base;
 
-	os_thread_helper_lock(&mc->wait_thread.oth);
+	return XRT_SUCCESS;
+}
 
-	// Wait for the wait thread to fully start.
-	while (!mc->wait_thread.alive) {
-		os_thread_helper_wait_locked(&mc->wait_thread.oth);
+xrt_result_t
+multi_system_compositor_start_wait_thread(struct multi_system_compositor *msc)
+{
+	int ret = os_thread_helper_init(&msc->wait_thread.oth);
+	if (ret < 0) {
+		return XRT_ERROR_THREADING_INIT_FAILURE;
 	}
 
-	os_thread_helper_unlock(&mc->wait_thread.oth);
+	/*
+	 * Lets the thread block on the semaphores of all clients at once, if the
+	 * native compositor can't do that it blocks on one frame at a time.
+	 */
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	struct xrt_compositor_semaphore *xcsem = NULL;
+	if (msc->xcn->base.create_semaphore != NULL &&
+	    xrt_comp_create_semaphore(&msc->xcn->base, &handle, &xcsem) == XRT_SUCCESS &&
+	    (xcsem->signal == NULL || xcsem->wait_any == NULL)) {
+		xrt_compositor_semaphore_reference(&xcsem, NULL);
+	}
 
+	// The semaphore keeps the ownership of the handle.
+	msc->wait_thread.wake_xcsem = xcsem;
 
-	*out_xcn = &mc->base;
+	os_thread_helper_start(&msc->wait_thread.oth, run_func, msc);
+
+	os_thread_helper_lock(&msc->wait_thread.oth);
+
+	// Wait for the wait thread to fully start.
+	while (!msc->wait_thread.alive) {
+		os_thread_helper_wait_locked(&msc->wait_thread.oth);
+	}
+
+	os_thread_helper_unlock(&msc->wait_thread.oth);
 
 	return XRT_SUCCESS;
 }
+
+void
+multi_system_compositor_wake_wait_thread(struct multi_system_compositor *msc)
+{
+	os_thread_helper_lock(&msc->wait_thread.oth);
+
+	msc->wait_thread.slot_generation++;
+	wake_wait_thread_locked(msc);
+
+	os_thread_helper_unlock(&msc->wait_thread.oth);
+}
@@ -16,6 +16,7 @@
 extern "C" {
 #endif
 
+struct xrt_device;
 struct u_pacing_app_factory;
 
 
@@ -28,6 +29,8 @@ struct u_pacing_app_factory;
  * @param xcn           Native compositor that client are multi-plexed to.
  * @param upaf          App pacing factory, one pacer created per client.
  * @param xsci          Information to be exposed.
+ * @param xdev          Head device, its head detect input is used to idle
+ *                      when the headset isn't worn, may be NULL.
  * @param do_warm_start Should we always submit a frame at startup.
  * @param out_xsysc     Created @ref xrt_system_compositor.
  *
@@ -37,6 +40,7 @@ xrt_result_t
 comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
                                     struct u_pacing_app_factory *upaf,
                                     const struct xrt_system_compositor_info *xsci,
+                                    struct xrt_device *xdev,
                                     bool do_warm_start,
                                     struct xrt_system_compositor **out_xsysc);
 
@@ -16,6 +16,7 @@
 #include "os/os_time.h"
 #include "os/os_threading.h"
 
+#include "util/u_time.h"
 #include "util/u_pacing.h"
 
 #ifdef __cplusplus
@@ -34,10 +35,32 @@ extern "C" {
 /*!
  * Number of max active layers per @ref multi_compositor.
  *
- * @todo Move to `xrt_limits.h` and share.
  * @ingroup comp_multi
  */
-#define MULTI_MAX_LAYERS 16
+#define MULTI_MAX_LAYERS XRT_MAX_LAYERS
+
+/*!
+ * How long there must have been nothing to show before going idle.
+ *
+ * @ingroup comp_multi
+ */
+#define MULTI_IDLE_TIMEOUT_NS (U_TIME_1S_IN_NS)
+
+/*!
+ * While idle the render loop produces a frame this often, keeps the display
+ * timing and the timings given to the clients from going stale.
+ *
+ * @ingroup comp_multi
+ */
+#define MULTI_IDLE_FRAME_PERIOD_NS (100 * U_TIME_1MS_IN_NS)
+
+/*!
+ * While idle the head detect input is checked this often, less than a frame
+ * so rendering resumes within one frame of the headset being put on.
+ *
+ * @ingroup comp_multi
+ */
+#define MULTI_IDLE_POLL_PERIOD_NS (5 * U_TIME_1MS_IN_NS)
 
 
 /*
@@ -87,6 +110,25 @@ struct multi_layer_slot
 	bool active;
 };
 
+/*!
+ * A frame of a client handed to the wait thread of the system compositor,
+ * holds a reference to the sync object the frame is waiting on.
+ *
+ * @ingroup comp_multi
+ */
+struct multi_wait_item
+{
+	struct multi_compositor *mc;
+
+	struct xrt_compositor_fence *xcf;
+	struct xrt_compositor_semaphore *xcsem;
+	uint64_t value;
+	int64_t frame_id;
+
+	//! When to next warn about the GPU work not being done.
+	uint64_t warn_ns;
+};
+
 /*!
  * A single compositor for feeding the layers from one session/app into
  * the multi-client-capable system compositor.
@@ -114,9 +156,6 @@ struct multi_compositor
 	//! Used to implement wait frame, only used for in process.
 	struct os_precise_sleeper frame_sleeper;
 
-	//! Used when waiting for the scheduled frame to complete.
-	struct os_precise_sleeper scheduled_sleeper;
-
 	struct
 	{
 		bool visible;
@@ -127,62 +166,61 @@ struct multi_compositor
 		bool session_active;
 	} state;
 
+	/*!
+	 * State shared with the wait thread of the system compositor.
+	 */
 	struct
 	{
-		//! Fence to wait for.
-		struct xrt_compositor_fence *xcf;
-
-		//! Timeline semaphore to wait for.
-		struct xrt_compositor_semaphore *xcsem;
-
-		//! Timeline semaphore value to wait for.
-		uint64_t value;
-
-		//! Frame id of frame being waited on.
-		int64_t frame_id;
-
-		//! The wait thread itself
-		struct os_thread_helper oth;
-
-		//! Have we gotten to the loop?
-		bool alive;
-
-		//! Is the thread waiting, if so the client should block.
-		bool waiting;
-
 		/*!
-		 * Is the client thread blocked?
-		 *
-		 * Set to true by the client thread,
-		 * cleared by the wait thread to release the client thread.
+		 * Is a frame in flight, if so the client should block on
+		 * @ref slot_cond, protected by @ref slot_lock.
 		 */
-		bool blocked;
+		bool waiting;
 	} wait_thread;
 
 	//! Lock for all of the slots.
 	struct os_mutex slot_lock;
 
+	/*!
+	 * Signalled with @ref slot_lock held when the wait thread has moved the
+	 * frame of this client to the scheduled slot, waited on by the client
+	 * thread before it can push the next frame.
+	 */
+	struct os_cond slot_cond;
+
 	/*!
 	 * The next which the next frames to be picked up will be displayed.
 	 */
 	uint64_t slot_next_frame_display;
 
+	/*!
+	 * Storage for the slots below, moving a frame from one stage to the
+	 * next only swaps the pointers, the layers are never copied.
+	 */
+	struct multi_layer_slot slots[3];
+
 	/*!
 	 * Currently being transferred or waited on.
 	 * Not protected by the slot lock as it is only touched by the client thread.
 	 */
-	struct multi_layer_slot progress;
+	struct multi_layer_slot *progress;
 
 	//! Scheduled frames for a future timepoint.
-	struct multi_layer_slot scheduled;
+	struct multi_layer_slot *scheduled;
 
 	/*!
 	 * Fully ready to be used.
 	 * Not protected by the slot lock as it is only touched by the main render loop thread.
 	 */
-	struct multi_layer_slot delivered;
+	struct multi_layer_slot *delivered;
 
 	struct u_pacing_app *upa;
+
+	/*!
+	 * Last GPU performance level sent to the app, only touched from the
+	 * thread that marks frames as GPU done.
+	 */
+	enum xrt_perf_notify_level perf_level;
 };
 
 /*!
@@ -363,8 +401,88 @@ struct multi_system_compositor
 		uint64_t diff_ns;
 	} last_timings;
 
+	//! Refresh rate of the native compositor last frame, only accessed from the render thread.
+	float last_refresh_rate_hz;
+
 	//! List of active clients.
 	struct multi_compositor *clients[MULTI_MAX_CLIENTS];
+
+	/*!
+	 * A single thread waits on the GPU work of all clients and moves their
+	 * frames from progress to scheduled once done, see
+	 * multi_compositor::wait_thread.
+	 */
+	struct
+	{
+		//! The wait thread itself, also protects the fields below.
+		struct os_thread_helper oth;
+
+		//! Frames pushed by clients, not yet picked up by the thread.
+		struct multi_wait_item pushed[MULTI_MAX_CLIENTS];
+
+		//! Number of valid entries in @p pushed.
+		uint32_t pushed_count;
+
+		//! Number of created clients, bounded by @ref MULTI_MAX_CLIENTS.
+		uint32_t client_count;
+
+		//! Bumped when a scheduled slot is freed or the timings changes.
+		uint64_t slot_generation;
+
+		/*!
+		 * Signalled from the CPU whenever the thread is woken up, so it
+		 * can block on the semaphores of all clients at once and still
+		 * notice new work. NULL if the native compositor's semaphores
+		 * can't do that.
+		 */
+		struct xrt_compositor_semaphore *wake_xcsem;
+
+		//! The last value @p wake_xcsem was signalled with.
+		uint64_t wake_value;
+
+		//! Have we gotten to the loop?
+		bool alive;
+	} wait_thread;
+
+	/*!
+	 * The clients and their frames that were transferred last frame, in
+	 * order, used to detect that none of the layers has changed. Only
+	 * touched by the render loop thread.
+	 */
+	struct
+	{
+		struct multi_compositor *mc;
+		int64_t frame_id;
+	} last_transfer[MULTI_MAX_CLIENTS];
+
+	//! Number of valid entries in @ref last_transfer.
+	size_t last_transfer_count;
+
+	/*!
+	 * When there has been nothing to show for @ref MULTI_IDLE_TIMEOUT_NS,
+	 * or the headset isn't being worn, the render loop idles and only
+	 * produces a frame every @ref MULTI_IDLE_FRAME_PERIOD_NS.
+	 */
+	struct
+	{
+		//! Set from XRT_COMPOSITOR_IDLE at creation.
+		bool enabled;
+
+		//! Head detect input of the head device, NULL if it has none.
+		struct xrt_input *head_detect;
+
+		//! Is the render loop idling, protected by oth.
+		bool active;
+
+		//! A client has a new frame scheduled, protected by oth.
+		bool new_frame;
+
+		//! Last time a frame had any layers, only touched by the render loop thread.
+		uint64_t last_layers_ns;
+
+		//! When the next idle frame is due, only touched by the render loop thread.
+		uint64_t next_frame_ns;
+	} idle;
 };
 
 /*!
@@ -389,6 +507,36 @@ multi_system_compositor(struct xrt_system_compositor *xsc)
 void
 multi_system_compositor_update_session_status(struct multi_system_compositor *msc, bool active);
 
+/*!
+ * Start the wait thread, called when creating the system compositor.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+xrt_result_t
+multi_system_compositor_start_wait_thread(struct multi_system_compositor *msc);
+
+/*!
+ * Wake the wait thread up if it's waiting for a scheduled slot to be freed,
+ * called when a frame has been delivered or the timings have changed. Can be
+ * called with the list_and_timing_lock and slot_lock held.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+void
+multi_system_compositor_wake_wait_thread(struct multi_system_compositor *msc);
+
+/*!
+ * A client frame has been moved to its scheduled slot, wakes up the render
+ * loop if it is idling. Must not be called with the list_and_timing_lock held.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+void
+multi_system_compositor_notify_new_frame(struct multi_system_compositor *msc);
+
 
 #ifdef __cplusplus
 }
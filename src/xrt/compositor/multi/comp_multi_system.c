@@ -10,6 +10,7 @@
  */
 
 #include "xrt/xrt_config_os.h"
+#include "xrt/xrt_device.h"
 #include "xrt/xrt_session.h"
 
 #include "os/os_time.h"
@@ -22,10 +23,7 @@
 #include "util/u_debug.h"
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
-
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "multi/comp_multi_private.h"
 #include "multi/comp_multi_interface.h"
@@ -42,6 +40,10 @@
 #endif
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(stagger_clients, "XRT_COMPOSITOR_MULTI_STAGGER_CLIENTS", true)
+DEBUG_GET_ONCE_BOOL_OPTION(idle, "XRT_COMPOSITOR_IDLE", true)
+
+
 /*
  *
  * Render thread.
@@ -219,8 +221,41 @@ overlay_sort_func(const void *a, const void *b)
 	return 0;
 }
 
-static void
-transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_time_ns, int64_t system_frame_id)
+/*!
+ * Records which frames of which clients are about to be transferred, returns
+ * true if it's exactly the same as the last time. A frame that is delivered
+ * again means that the app hasn't released any new images for it.
+ */
+static bool
+update_last_transfer(struct multi_system_compositor *msc, struct multi_compositor **array, size_t count)
+{
+	bool unchanged = count > 0 && count == msc->last_transfer_count;
+
+	for (size_t k = 0; k < count; k++) {
+		struct multi_compositor *mc = array[k];
+		int64_t frame_id = mc->delivered->data.frame_id;
+
+		if (msc->last_transfer[k].mc != mc || msc->last_transfer[k].frame_id != frame_id) {
+			unchanged = false;
+		}
+
+		msc->last_transfer[k].mc = mc;
+		msc->last_transfer[k].frame_id = frame_id;
+	}
+
+	msc->last_transfer_count = count;
+
+	return unchanged;
+}
+
+/*!
+ * Returns the number of layers transferred.
+ */
+static uint32_t
+transfer_layers_locked(struct multi_system_compositor *msc,
+                       struct xrt_layer_frame_data *data,
+                       uint64_t display_time_ns,
+                       int64_t system_frame_id)
 {
 	COMP_TRACE_MARKER();
 
@@ -232,7 +267,7 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 	uint64_t now_ns = os_monotonic_get_ns();
 
 	size_t count = 0;
-	for (size_t k = 0; k < ARRAY_SIZE(array); k++) {
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
 		struct multi_compositor *mc = msc->clients[k];
 
 		// Array can be empty
@@ -244,7 +279,7 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		multi_compositor_deliver_any_frames(mc, display_time_ns);
 
 		// None of the data in this slot is valid, don't check access it.
-		if (!mc->delivered.active) {
+		if (!mc->delivered->active) {
 			continue;
 		}
 
@@ -270,16 +305,24 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		array[count++] = msc->clients[k];
 	}
 
-	// Sort the stack array
+	// Sort the clients by z-order.
 	qsort(array, count, sizeof(struct multi_compositor *), overlay_sort_func);
 
+	// Lets the native compositor reuse any work it did on the same layers.
+	data->layers_unchanged = update_last_transfer(msc, array, count);
+	xrt_comp_layer_begin(xc, data);
+
+	uint32_t layer_count = 0;
+
 	// Copy all active layers.
 	for (size_t k = 0; k < count; k++) {
 		struct multi_compositor *mc = array[k];
 		assert(mc != NULL);
 
-		for (uint32_t i = 0; i < mc->delivered.layer_count; i++) {
-			struct multi_layer_entry *layer = &mc->delivered.layers[i];
+		layer_count += mc->delivered->layer_count;
+
+		for (uint32_t i = 0; i < mc->delivered->layer_count; i++) {
+			struct multi_layer_entry *layer = &mc->delivered->layers[i];
 
 			switch (layer->data.type) {
 			case XRT_LAYER_STEREO_PROJECTION: do_projection_layer(xc, mc, layer, i); break;
@@ -293,6 +336,8 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 			}
 		}
 	}
+
+	return layer_count;
 }
 
 static void
@@ -313,9 +358,106 @@ broadcast_timings_to_clients(struct multi_system_compositor *msc, uint64_t predi
 		os_mutex_unlock(&mc->slot_lock);
 	}
 
+	// Frames waiting on the scheduled slot might now be for the next frame.
+	multi_system_compositor_wake_wait_thread(msc);
+
 	os_mutex_unlock(&msc->list_and_timing_lock);
 }
 
+//! The native compositor switches rates between frames, tell every session when it has.
+static void
+broadcast_refresh_rate_change(struct multi_system_compositor *msc)
+{
+	float refresh_rate_hz = 0.0f;
+	xrt_result_t xret = xrt_comp_get_display_refresh_rate(&msc->xcn->base, &refresh_rate_hz);
+	if (xret != XRT_SUCCESS || refresh_rate_hz == msc->last_refresh_rate_hz) {
+		return;
+	}
+
+	float from_hz = msc->last_refresh_rate_hz;
+	msc->last_refresh_rate_hz = refresh_rate_hz;
+
+	// First frame, nothing changed.
+	if (from_hz == 0.0f) {
+		return;
+	}
+
+	union xrt_session_event xse = XRT_STRUCT_INIT;
+	xse.type = XRT_SESSION_EVENT_DISPLAY_REFRESH_RATE_CHANGE;
+	xse.display.from_display_refresh_rate_hz = from_hz;
+	xse.display.to_display_refresh_rate_hz = refresh_rate_hz;
+
+	os_mutex_lock(&msc->list_and_timing_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(msc->clients); i++) {
+		if (msc->clients[i] != NULL) {
+			multi_compositor_push_event(msc->clients[i], &xse);
+		}
+	}
+
+	os_mutex_unlock(&msc->list_and_timing_lock);
+}
+
+/*!
+ * Clients that are rendering come first, the main app before any overlays,
+ * then focused clients and lastly the ones on top.
+ */
+static int
+pacing_priority_sort_func(const void *a, const void *b)
+{
+	struct multi_compositor *mc_a = *(struct multi_compositor **)a;
+	struct multi_compositor *mc_b = *(struct multi_compositor **)b;
+
+	bool rendering_a = mc_a->state.visible && mc_a->state.session_active;
+	bool rendering_b = mc_b->state.visible && mc_b->state.session_active;
+	if (rendering_a != rendering_b) {
+		return rendering_a ? -1 : 1;
+	}
+
+	if (mc_a->xsi.is_overlay != mc_b->xsi.is_overlay) {
+		return mc_a->xsi.is_overlay ? 1 : -1;
+	}
+
+	if (mc_a->state.focused != mc_b->state.focused) {
+		return mc_a->state.focused ? -1 : 1;
+	}
+
+	if (mc_a->state.z_order > mc_b->state.z_order) {
+		return -1;
+	}
+
+	if (mc_a->state.z_order < mc_b->state.z_order) {
+		return 1;
+	}
+
+	return 0;
+}
+
+/*!
+ * How much earlier than the compositor needs it the given client should have
+ * its frame done, so that clients don't all wake up at the same time and fight
+ * over the CPU and GPU right before the compositor picks up their frames.
+ *
+ * The first client gets no offset and the lowest latency, every following
+ * client gets the app time of the clients before it. Offsets never push a
+ * client's own app time past the start of the period.
+ */
+static uint64_t
+stagger_offset(uint64_t *accumulated_ns, uint64_t app_time_ns, uint64_t period_ns)
+{
+	uint64_t offset_ns = *accumulated_ns;
+
+	if (app_time_ns >= period_ns) {
+		offset_ns = 0;
+	} else if (offset_ns > period_ns - app_time_ns) {
+		offset_ns = period_ns - app_time_ns;
+	}
+
+	*accumulated_ns += app_time_ns;
+
+	return offset_ns;
+}
+
 static void
 broadcast_timings_to_pacers(struct multi_system_compositor *msc,
                             uint64_t predicted_display_time_ns,
@@ -326,23 +468,45 @@ broadcast_timings_to_pacers(struct multi_system_compositor *msc,
 
 	os_mutex_lock(&msc->list_and_timing_lock);
 
+	struct multi_compositor *array[MULTI_MAX_CLIENTS] = {0};
+	size_t count = 0;
+
 	for (size_t i = 0; i < ARRAY_SIZE(msc->clients); i++) {
-		struct multi_compositor *mc = msc->clients[i];
-		if (mc == NULL) {
-			continue;
+		if (msc->clients[i] != NULL) {
+			array[count++] = msc->clients[i];
+		}
+	}
+
+	qsort(array, count, sizeof(struct multi_compositor *), pacing_priority_sort_func);
+
+	uint64_t accumulated_ns = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		struct multi_compositor *mc = array[i];
+		uint64_t offset_ns = 0;
+
+		// Only clients that are rendering need to be kept apart.
+		bool rendering = mc->state.visible && mc->state.session_active;
+		if (rendering && debug_get_bool_option_stagger_clients()) {
+			uint64_t app_time_ns = 0;
+			u_pa_get_app_time(mc->upa, &app_time_ns);
+			offset_ns = stagger_offset(&accumulated_ns, app_time_ns, predicted_display_period_ns);
 		}
 
 		u_pa_info(                       //
 		    mc->upa,                     //
 		    predicted_display_time_ns,   //
 		    predicted_display_period_ns, //
-		    diff_ns);                    //
+		    diff_ns + offset_ns);        //
 
 		os_mutex_lock(&mc->slot_lock);
 		mc->slot_next_frame_display = predicted_display_time_ns;
 		os_mutex_unlock(&mc->slot_lock);
 	}
 
+	// Frames waiting on the scheduled slot might now be for the next frame.
+	multi_system_compositor_wake_wait_thread(msc);
+
 	msc->last_timings.predicted_display_time_ns = predicted_display_time_ns;
 	msc->last_timings.predicted_display_period_ns = predicted_display_period_ns;
 	msc->last_timings.diff_ns = diff_ns;
@@ -426,16 +590,83 @@ update_session_state_locked(struct multi_system_compositor *msc)
 	}
 }
 
+static bool
+is_head_worn(struct multi_system_compositor *msc)
+{
+	// No way to tell, assume it is.
+	if (msc->idle.head_detect == NULL) {
+		return true;
+	}
+
+	// The driver hasn't gotten any data yet, same as above.
+	if (msc->idle.head_detect->timestamp == 0) {
+		return true;
+	}
+
+	// Updated by the driver from its own thread.
+	return msc->idle.head_detect->value.boolean;
+}
+
+/*!
+ * Decides if the render loop should be idling, if so and no idle frame is
+ * due it waits to be signalled or for the head detect to be polled again.
+ *
+ * Returns true if the loop should skip this frame and loop back.
+ */
+static bool
+idle_wait_locked(struct multi_system_compositor *msc)
+{
+	if (!msc->idle.enabled) {
+		return false;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// A new client frame only gets us out of idle if someone is looking.
+	bool new_frame = msc->idle.new_frame;
+	msc->idle.new_frame = false;
+
+	bool worn = is_head_worn(msc);
+	bool nothing_shown = !new_frame && now_ns - msc->idle.last_layers_ns > MULTI_IDLE_TIMEOUT_NS;
+	bool idle = !worn || nothing_shown;
+
+	if (idle != msc->idle.active) {
+		U_LOG_I("%s idle mode, %s.", idle ? "Entering" : "Leaving",
+		        !worn ? "headset not worn" : (nothing_shown ? "nothing to show" : "resuming"));
+		msc->idle.active = idle;
+
+		// Render the first frame right away.
+		msc->idle.next_frame_ns = now_ns;
+	}
+
+	if (!idle) {
+		return false;
+	}
+
+	if (now_ns >= msc->idle.next_frame_ns) {
+		msc->idle.next_frame_ns = now_ns + MULTI_IDLE_FRAME_PERIOD_NS;
+		return false;
+	}
+
+	uint64_t wait_ns = msc->idle.next_frame_ns - now_ns;
+	if (msc->idle.head_detect != NULL && wait_ns > MULTI_IDLE_POLL_PERIOD_NS) {
+		wait_ns = MULTI_IDLE_POLL_PERIOD_NS;
+	}
+
+	// Woken up early by a new client frame or the session changing.
+	os_thread_helper_timedwait_locked(&msc->oth, wait_ns);
+
+	return true;
+}
+
 static int
 multi_main_loop(struct multi_system_compositor *msc)
 {
 	U_TRACE_SET_THREAD_NAME("Multi Client Module");
 	os_thread_helper_name(&msc->oth, "Multi Client Module");
 
-#ifdef XRT_OS_LINUX
-	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(U_LOGGING_INFO, "Multi Client Module");
-#endif
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_COMPOSITOR, U_LOGGING_INFO, "Multi Client Module");
 
 	struct xrt_compositor *xc = &msc->xcn->base;
 
@@ -459,6 +690,11 @@ multi_main_loop(struct multi_system_compositor *msc)
 			continue;
 		}
 
+		if (idle_wait_locked(msc)) {
+			// Loop back to running and session check.
+			continue;
+		}
+
 		// Unlock the thread after the checks has been done.
 		os_thread_helper_unlock(&msc->oth);
 
@@ -477,6 +713,9 @@ multi_main_loop(struct multi_system_compositor *msc)
 		    &predicted_display_time_ns,    //
 		    &predicted_display_period_ns); //
 
+		// The app pacers pick the new period up from the timings below.
+		broadcast_refresh_rate_change(msc);
+
 		// Do this as soon as we have the new display time.
 		broadcast_timings_to_clients(msc, predicted_display_time_ns);
 
@@ -503,13 +742,16 @@ multi_main_loop(struct multi_system_compositor *msc)
 		    .display_time_ns = display_time_ns,
 		    .env_blend_mode = blend_mode,
 		};
-		xrt_comp_layer_begin(xc, &data);
 
 		// Make sure that the clients doesn't go away while we transfer layers.
 		os_mutex_lock(&msc->list_and_timing_lock);
-		transfer_layers_locked(msc, predicted_display_time_ns, frame_id);
+		uint32_t layer_count = transfer_layers_locked(msc, &data, predicted_display_time_ns, frame_id);
 		os_mutex_unlock(&msc->list_and_timing_lock);
 
+		if (layer_count > 0) {
+			msc->idle.last_layers_ns = os_monotonic_get_ns();
+		}
+
 		xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
 
 		// Re-lock the thread for check in while statement.
@@ -670,6 +912,10 @@ system_compositor_destroy(struct xrt_system_compositor *xsc)
 	// Destroy the render thread first, destroy also stops the thread.
 	os_thread_helper_destroy(&msc->oth);
 
+	// All clients are gone, so nothing is pushed to the wait thread.
+	os_thread_helper_destroy(&msc->wait_thread.oth);
+	xrt_compositor_semaphore_reference(&msc->wait_thread.wake_xcsem, NULL);
+
 	u_paf_destroy(&msc->upaf);
 
 	xrt_comp_native_destroy(&msc->xcn);
@@ -705,10 +951,26 @@ multi_system_compositor_update_session_status(struct multi_system_compositor *ms
 	os_thread_helper_unlock(&msc->oth);
 }
 
+void
+multi_system_compositor_notify_new_frame(struct multi_system_compositor *msc)
+{
+	os_thread_helper_lock(&msc->oth);
+
+	msc->idle.new_frame = true;
+
+	// Only need to wake it up if it's idling.
+	if (msc->idle.active) {
+		os_thread_helper_signal_locked(&msc->oth);
+	}
+
+	os_thread_helper_unlock(&msc->oth);
+}
+
 xrt_result_t
 comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
                                     struct u_pacing_app_factory *upaf,
                                     const struct xrt_system_compositor_info *xsci,
+                                    struct xrt_device *xdev,
                                     bool do_warm_start,
                                     struct xrt_system_compositor **out_xsysc)
 {
@@ -728,6 +990,15 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->sessions.active_count = 0;
 	msc->sessions.state = do_warm_start ? MULTI_SYSTEM_STATE_INIT_WARM_START : MULTI_SYSTEM_STATE_STOPPED;
 
+	msc->idle.enabled = debug_get_bool_option_idle();
+
+	for (uint32_t i = 0; xdev != NULL && i < xdev->input_count; i++) {
+		if (xdev->inputs[i].name == XRT_INPUT_GENERIC_HEAD_DETECT) {
+			msc->idle.head_detect = &xdev->inputs[i];
+			break;
+		}
+	}
+
 	os_mutex_init(&msc->list_and_timing_lock);
 
 	//! @todo Make the clients not go from IDLE to READY before we have completed a first frame.
@@ -736,6 +1007,11 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->last_timings.predicted_display_period_ns = U_TIME_1MS_IN_NS * 16; // Just a wild guess.
 	msc->last_timings.diff_ns = U_TIME_1MS_IN_NS * 5;                      // Make sure it's not zero at least.
 
+	xrt_result_t xret = multi_system_compositor_start_wait_thread(msc);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
 	int ret = os_thread_helper_init(&msc->oth);
 	if (ret < 0) {
 		return XRT_ERROR_THREADING_INIT_FAILURE;
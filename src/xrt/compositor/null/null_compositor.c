@@ -185,6 +185,7 @@ compositor_init_vulkan(struct null_compositor *c)
 	    .optional_device_extensions = optional_device_extension_list,
 	    .log_level = c->settings.log_level,
 	    .only_compute_queue = false, // Regular GFX
+	    .async_compute_queue = false,
 	    .selected_gpu_index = -1,    // Auto
 	    .client_gpu_index = -1,      // Auto
 	    .timeline_semaphore = true,  // Flag is optional, not a hard requirement.
@@ -254,6 +255,9 @@ compositor_init_info(struct null_compositor *c)
 	comp_vulkan_formats_copy_to_info(&formats, info);
 	comp_vulkan_formats_log(c->settings.log_level, &formats);
 
+	// Swapchain images are allocated on the compositor's device.
+	info->vk_deviceUUID = c->sys_info.compositor_vk_deviceUUID;
+
 	return true;
 }
 
@@ -262,8 +266,8 @@ compositor_init_sys_info(struct null_compositor *c, struct xrt_device *xdev)
 {
 	struct xrt_system_compositor_info *sys_info = &c->sys_info;
 
-	// Required by OpenXR spec.
-	sys_info->max_layers = 16;
+	// Required by OpenXR spec to be at least 16.
+	sys_info->max_layers = XRT_MAX_LAYERS;
 
 	// UUIDs and LUID already set in vk init.
 	(void)sys_info->compositor_vk_deviceUUID;
@@ -556,5 +560,5 @@ null_compositor_create_system(struct xrt_device *xdev, struct xrt_system_composi
 	XRT_MAYBE_UNUSED xrt_result_t xret = u_pa_factory_create(&upaf);
 	assert(xret == XRT_SUCCESS && upaf != NULL);
 
-	return comp_multi_create_system_compositor(&c->base.base, upaf, &c->sys_info, false, out_xsysc);
+	return comp_multi_create_system_compositor(&c->base.base, upaf, &c->sys_info, c->xdev, false, out_xsysc);
 }
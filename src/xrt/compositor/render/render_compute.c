@@ -14,6 +14,8 @@
 
 #include "render/render_interface.h"
 
+#include <string.h>
+
 
 /*
  *
@@ -73,17 +75,75 @@ calc_dispatch_dims_2_views(const struct render_viewport_data views[2], uint32_t
  *
  */
 
-XRT_MAYBE_UNUSED static void
+/*!
+ * The state of @p descriptor_set if it is one of the layer sets kept between
+ * frames and the descriptor cache is enabled, NULL otherwise.
+ */
+static struct render_compute_layer_descriptor_state *
+get_layer_descriptor_state(struct render_resources *r, VkDescriptorSet descriptor_set)
+{
+	if (!r->gfx.descriptor_cache.enabled) {
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->compute.layer.descriptor_sets); i++) {
+		if (r->compute.layer.descriptor_sets[i] == descriptor_set) {
+			return &r->compute.layer.written[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*!
+ * Records the sources in @p state, returns true if they are the same as what
+ * it already held, then they don't need to be written.
+ */
+static bool
+layer_descriptor_state_update(struct render_compute_layer_descriptor_state *state,
+                              VkSampler src_samplers[RENDER_MAX_IMAGES],
+                              VkImageView src_image_views[RENDER_MAX_IMAGES],
+                              uint32_t image_count,
+                              VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES],
+                              VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES])
+{
+	size_t src_size = sizeof(VkSampler) * image_count;
+	size_t src_view_size = sizeof(VkImageView) * image_count;
+
+	if (state->valid &&                                                                   //
+	    state->image_count == image_count &&                                              //
+	    memcmp(state->src_samplers, src_samplers, src_size) == 0 &&                       //
+	    memcmp(state->src_image_views, src_image_views, src_view_size) == 0 &&            //
+	    memcmp(state->cube_samplers, cube_samplers, sizeof(state->cube_samplers)) == 0 && //
+	    memcmp(state->cube_image_views, cube_image_views, sizeof(state->cube_image_views)) == 0) {
+		return true;
+	}
+
+	state->valid = true;
+	state->image_count = image_count;
+	memcpy(state->src_samplers, src_samplers, src_size);
+	memcpy(state->src_image_views, src_image_views, src_view_size);
+	memcpy(state->cube_samplers, cube_samplers, sizeof(state->cube_samplers));
+	memcpy(state->cube_image_views, cube_image_views, sizeof(state->cube_image_views));
+
+	return false;
+}
+
+static void
 update_compute_layer_descriptor_set(struct vk_bundle *vk,
                                     uint32_t src_binding,
                                     VkSampler src_samplers[RENDER_MAX_IMAGES],
                                     VkImageView src_image_views[RENDER_MAX_IMAGES],
                                     uint32_t image_count,
+                                    uint32_t cube_binding,
+                                    VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES],
+                                    VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES],
                                     uint32_t target_binding,
                                     VkImageView target_image_view,
                                     uint32_t ubo_binding,
                                     VkBuffer ubo_buffer,
                                     VkDeviceSize ubo_size,
+                                    bool write_sources,
                                     VkDescriptorSet descriptor_set)
 {
 	assert(image_count <= RENDER_MAX_IMAGES);
@@ -95,6 +155,13 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 		src_image_info[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	}
 
+	VkDescriptorImageInfo cube_image_info[RENDER_MAX_CUBE_IMAGES];
+	for (uint32_t i = 0; i < RENDER_MAX_CUBE_IMAGES; i++) {
+		cube_image_info[i].sampler = cube_samplers[i];
+		cube_image_info[i].imageView = cube_image_views[i];
+		cube_image_info[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
 	VkDescriptorImageInfo target_image_info = {
 	    .imageView = target_image_view,
 	    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
@@ -106,15 +173,8 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 	    .range = ubo_size,
 	};
 
-	VkWriteDescriptorSet write_descriptor_sets[3] = {
-	    {
-	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-	        .dstSet = descriptor_set,
-	        .dstBinding = src_binding,
-	        .descriptorCount = image_count,
-	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-	        .pImageInfo = src_image_info,
-	    },
+	// The source writes go last so they can be skipped.
+	VkWriteDescriptorSet write_descriptor_sets[4] = {
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
@@ -131,14 +191,32 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	        .pBufferInfo = &buffer_info,
 	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = src_binding,
+	        .descriptorCount = image_count,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = src_image_info,
+	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = cube_binding,
+	        .descriptorCount = ARRAY_SIZE(cube_image_info),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = cube_image_info,
+	    },
 	};
 
-	vk->vkUpdateDescriptorSets(            //
-	    vk->device,                        //
-	    ARRAY_SIZE(write_descriptor_sets), // descriptorWriteCount
-	    write_descriptor_sets,             // pDescriptorWrites
-	    0,                                 // descriptorCopyCount
-	    NULL);                             // pDescriptorCopies
+	uint32_t write_count = write_sources ? ARRAY_SIZE(write_descriptor_sets) : 2;
+
+	vk->vkUpdateDescriptorSets( //
+	    vk->device,             //
+	    write_count,            // descriptorWriteCount
+	    write_descriptor_sets,  // pDescriptorWrites
+	    0,                      // descriptorCopyCount
+	    NULL);                  // pDescriptorCopies
 }
 
 XRT_MAYBE_UNUSED static void
@@ -154,6 +232,9 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
                                      uint32_t ubo_binding,
                                      VkBuffer ubo_buffer,
                                      VkDeviceSize ubo_size,
+                                     uint32_t depth_binding,
+                                     VkSampler depth_samplers[2],
+                                     VkImageView depth_image_views[2],
                                      VkDescriptorSet descriptor_set)
 {
 	VkDescriptorImageInfo src_image_info[2] = {
@@ -213,7 +294,20 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
 	    .range = ubo_size,
 	};
 
-	VkWriteDescriptorSet write_descriptor_sets[4] = {
+	VkDescriptorImageInfo depth_image_info[2] = {
+	    {
+	        .sampler = depth_samplers[0],
+	        .imageView = depth_image_views[0],
+	        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	    },
+	    {
+	        .sampler = depth_samplers[1],
+	        .imageView = depth_image_views[1],
+	        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	    },
+	};
+
+	VkWriteDescriptorSet write_descriptor_sets[5] = {
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
@@ -246,6 +340,14 @@ update_compute_shared_descriptor_set(struct vk_bundle *vk,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	        .pBufferInfo = &buffer_info,
 	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = depth_binding,
+	        .descriptorCount = ARRAY_SIZE(depth_image_info),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .pImageInfo = depth_image_info,
+	    },
 	};
 
 	vk->vkUpdateDescriptorSets(            //
@@ -320,15 +422,9 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 	struct vk_bundle *vk = r->vk;
 	crc->r = r;
 
+	// Kept between frames, like the UBOs of the runs.
 	for (uint32_t i = 0; i < ARRAY_SIZE(crc->layer_descriptor_sets); i++) {
-		ret = vk_create_descriptor_set(             //
-		    vk,                                     // vk_bundle
-		    r->compute.descriptor_pool,             // descriptor_pool
-		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
-		    &crc->layer_descriptor_sets[i]);        // descriptor_set
-		VK_CHK_WITH_RET(ret, "vk_create_descriptor_set", false);
-
-		VK_NAME_DESCRIPTOR_SET(vk, crc->layer_descriptor_sets[i], "render_compute layer descriptor set");
+		crc->layer_descriptor_sets[i] = r->compute.layer.descriptor_sets[i];
 	}
 
 	ret = vk_create_descriptor_set(                  //
@@ -352,24 +448,26 @@ render_compute_begin(struct render_compute *crc)
 	ret = vk->vkResetCommandPool(vk->device, crc->r->cmd_pool, 0);
 	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
 
+	crc->cmd = crc->r->cmd;
+
 	VkCommandBufferBeginInfo begin_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
 	};
 
 	ret = vk->vkBeginCommandBuffer( //
-	    crc->r->cmd,                // commandBuffer
+	    crc->cmd,                   // commandBuffer
 	    &begin_info);               // pBeginInfo
 	VK_CHK_WITH_RET(ret, "vkBeginCommandBuffer", false);
 
 	vk->vkCmdResetQueryPool( //
-	    crc->r->cmd,         // commandBuffer
+	    crc->cmd,            // commandBuffer
 	    crc->r->query_pool,  // queryPool
 	    0,                   // firstQuery
 	    2);                  // queryCount
 
 	vk->vkCmdWriteTimestamp(               //
-	    crc->r->cmd,                       // commandBuffer
+	    crc->cmd,                          // commandBuffer
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
 	    crc->r->query_pool,                // queryPool
 	    0);                                // query
@@ -384,17 +482,126 @@ render_compute_end(struct render_compute *crc)
 	VkResult ret;
 
 	vk->vkCmdWriteTimestamp(                  //
-	    crc->r->cmd,                          // commandBuffer
+	    crc->cmd,                             // commandBuffer
 	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
 	    crc->r->query_pool,                   // queryPool
 	    1);                                   // query
 
-	ret = vk->vkEndCommandBuffer(crc->r->cmd);
+	ret = vk->vkEndCommandBuffer(crc->cmd);
 	VK_CHK_WITH_RET(ret, "vkEndCommandBuffer", false);
 
 	return true;
 }
 
+bool
+render_compute_begin_async(struct render_compute *crc)
+{
+	VkResult ret;
+	struct vk_bundle *vk = vk_from_crc(crc);
+
+	assert(crc->r->async_compute_cmd != VK_NULL_HANDLE);
+
+	ret = vk->vkResetCommandPool(vk->device, crc->r->async_compute_cmd_pool, 0);
+	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
+
+	crc->cmd = crc->r->async_compute_cmd;
+
+	VkCommandBufferBeginInfo begin_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+
+	ret = vk->vkBeginCommandBuffer( //
+	    crc->cmd,                   // commandBuffer
+	    &begin_info);               // pBeginInfo
+	VK_CHK_WITH_RET(ret, "vkBeginCommandBuffer", false);
+
+	return true;
+}
+
+bool
+render_compute_end_async(struct render_compute *crc)
+{
+	struct vk_bundle *vk = vk_from_crc(crc);
+	VkResult ret;
+
+	assert(crc->cmd == crc->r->async_compute_cmd);
+
+	ret = vk->vkEndCommandBuffer(crc->cmd);
+	VK_CHK_WITH_RET(ret, "vkEndCommandBuffer", false);
+
+	// Any further recording goes to the main command buffer.
+	crc->cmd = VK_NULL_HANDLE;
+
+	return true;
+}
+
+bool
+render_compute_can_record_views(struct render_compute *crc)
+{
+	return crc->r->view_record.group != NULL && crc->cmd == crc->r->cmd;
+}
+
+bool
+render_compute_begin_view(struct render_compute *crc, uint32_t view_index, struct render_compute *view_crc)
+{
+	struct vk_bundle *vk = vk_from_crc(crc);
+	struct render_resources *r = crc->r;
+	VkResult ret;
+
+	assert(view_index < ARRAY_SIZE(r->view_record.cmds));
+
+	// Only touches the pool of this view, so safe to do from its thread.
+	ret = vk->vkResetCommandPool(vk->device, r->view_record.pools[view_index].pool, 0);
+	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
+
+	*view_crc = *crc;
+	view_crc->cmd = r->view_record.cmds[view_index];
+
+	// Not used inside of a render pass.
+	VkCommandBufferInheritanceInfo inheritance_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+	};
+
+	VkCommandBufferBeginInfo begin_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	    .pInheritanceInfo = &inheritance_info,
+	};
+
+	ret = vk->vkBeginCommandBuffer( //
+	    view_crc->cmd,              // commandBuffer
+	    &begin_info);               // pBeginInfo
+	VK_CHK_WITH_RET(ret, "vkBeginCommandBuffer", false);
+
+	return true;
+}
+
+bool
+render_compute_end_view(struct render_compute *view_crc)
+{
+	struct vk_bundle *vk = vk_from_crc(view_crc);
+	VkResult ret;
+
+	ret = vk->vkEndCommandBuffer(view_crc->cmd);
+	VK_CHK_WITH_RET(ret, "vkEndCommandBuffer", false);
+
+	return true;
+}
+
+void
+render_compute_execute_views(struct render_compute *crc, uint32_t view_count)
+{
+	struct vk_bundle *vk = vk_from_crc(crc);
+
+	assert(view_count <= ARRAY_SIZE(crc->r->view_record.cmds));
+
+	vk->vkCmdExecuteCommands(      //
+	    crc->cmd,                  // commandBuffer
+	    view_count,                // commandBufferCount
+	    crc->r->view_record.cmds); // pCommandBuffers
+}
+
 void
 render_compute_close(struct render_compute *crc)
 {
@@ -404,12 +611,15 @@ render_compute_close(struct render_compute *crc)
 
 	// Reclaimed by vkResetDescriptorPool.
 	crc->shared_descriptor_set = VK_NULL_HANDLE;
+
+	// Owned by render_resources.
 	for (uint32_t i = 0; i < ARRAY_SIZE(crc->layer_descriptor_sets); i++) {
 		crc->layer_descriptor_sets[i] = VK_NULL_HANDLE;
 	}
 
 	vk->vkResetDescriptorPool(vk->device, crc->r->compute.descriptor_pool, 0);
 
+	crc->cmd = VK_NULL_HANDLE;
 	crc->r = NULL;
 }
 
@@ -420,9 +630,13 @@ render_compute_layers(struct render_compute *crc,
                       VkSampler src_samplers[RENDER_MAX_IMAGES],
                       VkImageView src_image_views[RENDER_MAX_IMAGES],
                       uint32_t num_srcs,
+                      VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES],
+                      VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES],
                       VkImageView target_image_view,
                       const struct render_viewport_data *view,
-                      bool do_timewarp)
+                      enum render_compute_layer_mix mix,
+                      bool do_timewarp,
+                      bool do_foveation)
 {
 	assert(crc->r != NULL);
 
@@ -434,27 +648,46 @@ render_compute_layers(struct render_compute *crc,
 	 * Source, target and distortion images.
 	 */
 
+	bool write_sources = true;
+	struct render_compute_layer_descriptor_state *state = get_layer_descriptor_state(r, descriptor_set);
+	if (state != NULL) {
+		write_sources = !layer_descriptor_state_update( //
+		    state,                                      //
+		    src_samplers,                               //
+		    src_image_views,                            //
+		    num_srcs,                                   //
+		    cube_samplers,                              //
+		    cube_image_views);                          //
+	}
+
 	update_compute_layer_descriptor_set( //
 	    vk,                              //
 	    r->compute.src_binding,          //
 	    src_samplers,                    //
 	    src_image_views,                 //
 	    num_srcs,                        //
+	    r->compute.cube_binding,         //
+	    cube_samplers,                   //
+	    cube_image_views,                //
 	    r->compute.target_binding,       //
 	    target_image_view,               //
 	    r->compute.ubo_binding,          //
 	    ubo,                             //
 	    VK_WHOLE_SIZE,                   //
+	    write_sources,                   //
 	    descriptor_set);                 //
 
-	VkPipeline pipeline = do_timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
+	assert(mix < RENDER_COMPUTE_LAYER_MIX_COUNT);
+
+	VkPipeline pipeline =
+	    do_timewarp ? r->compute.layer.timewarp_pipeline[mix] : r->compute.layer.non_timewarp_pipeline[mix];
 	vk->vkCmdBindPipeline(              //
-	    crc->r->cmd,                    // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    pipeline);                      // pipeline
 
 	vk->vkCmdBindDescriptorSets(          //
-	    r->cmd,                           // commandBuffer
+	    crc->cmd,                         // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,   // pipelineBindPoint
 	    r->compute.layer.pipeline_layout, // layout
 	    0,                                // firstSet
@@ -469,7 +702,36 @@ render_compute_layers(struct render_compute *crc,
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
+	    w,             // groupCountX
+	    h,             // groupCountY
+	    1);            // groupCountZ
+
+	if (!do_foveation) {
+		return;
+	}
+
+	/*
+	 * The full rate dispatch above skipped the peripheral blocks, shade
+	 * them here with 2x2 pixels per invocation. Both dispatches write to
+	 * different pixels so no barrier is needed, the descriptor set stays
+	 * bound as the pipeline layout is the same.
+	 */
+
+	VkPipeline reduced_rate_pipeline = do_timewarp ? r->compute.layer.reduced_rate_timewarp_pipeline[mix]
+	                                               : r->compute.layer.reduced_rate_non_timewarp_pipeline[mix];
+	vk->vkCmdBindPipeline(              //
+	    crc->cmd,                       // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    reduced_rate_pipeline);         // pipeline
+
+	struct render_viewport_data reduced_view = *view;
+	reduced_view.w = uint_divide_and_round_up(view->w, 2);
+	reduced_view.h = uint_divide_and_round_up(view->h, 2);
+	calc_dispatch_dims_1_view(reduced_view, &w, &h);
+
+	vk->vkCmdDispatch( //
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    1);            // groupCountZ
@@ -520,6 +782,11 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	data->post_transforms[0] = src_norm_rects[0];
 	data->post_transforms[1] = src_norm_rects[1];
 
+	// Let the transforms be updated with a fresher pose before submitting.
+	for (uint32_t i = 0; i < 2; i++) {
+		render_late_latch_set_view(&crc->late_latch, i, &src_poses[i], &src_fovs[i], &data->transforms[i]);
+	}
+
 
 	/*
 	 * Source, target and distortion images.
@@ -535,7 +802,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -561,15 +828,18 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	    r->compute.ubo_binding,           //
 	    r->compute.distortion.ubo.buffer, //
 	    VK_WHOLE_SIZE,                    //
+	    r->compute.depth_binding,         // The depth isn't used.
+	    src_samplers,                     //
+	    src_image_views,                  //
 	    crc->shared_descriptor_set);      //
 
 	vk->vkCmdBindPipeline(                        //
-	    r->cmd,                                   // commandBuffer
+	    crc->cmd,                                 // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,           // pipelineBindPoint
 	    r->compute.distortion.timewarp_pipeline); // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -584,7 +854,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -602,7 +872,160 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
+	    0,                                    //
+	    0,                                    //
+	    NULL,                                 //
+	    0,                                    //
+	    NULL,                                 //
+	    1,                                    //
+	    &memoryBarrier);                      //
+}
+
+void
+render_compute_projection_positional_timewarp(struct render_compute *crc,
+                                              VkSampler src_samplers[2],
+                                              VkImageView src_image_views[2],
+                                              const struct xrt_normalized_rect src_norm_rects[2],
+                                              VkImageView depth_image_views[2],
+                                              const struct xrt_normalized_rect depth_norm_rects[2],
+                                              const struct render_depth_params depth_params[2],
+                                              const struct xrt_pose src_poses[2],
+                                              const struct xrt_fov src_fovs[2],
+                                              const struct xrt_pose new_poses[2],
+                                              VkImage target_image,
+                                              VkImageView target_image_view,
+                                              const struct render_viewport_data views[2])
+{
+	assert(crc->r != NULL);
+
+	struct vk_bundle *vk = vk_from_crc(crc);
+	struct render_resources *r = crc->r;
+
+
+	/*
+	 * UBO
+	 */
+
+	struct render_compute_distortion_ubo_data *data =
+	    (struct render_compute_distortion_ubo_data *)r->compute.distortion.ubo.mapped;
+	data->views[0] = views[0];
+	data->views[1] = views[1];
+	data->pre_transforms[0] = r->distortion.uv_to_tanangle[0];
+	data->pre_transforms[1] = r->distortion.uv_to_tanangle[1];
+	data->post_transforms[0] = src_norm_rects[0];
+	data->post_transforms[1] = src_norm_rects[1];
+	data->depth_post_transforms[0] = depth_norm_rects[0];
+	data->depth_post_transforms[1] = depth_norm_rects[1];
+	data->depth_params[0] = depth_params[0];
+	data->depth_params[1] = depth_params[1];
+
+	for (uint32_t i = 0; i < 2; i++) {
+		render_calc_positional_time_warp_matrices( //
+		    &src_poses[i],                         //
+		    &src_fovs[i],                          //
+		    &new_poses[i],                         //
+		    &data->transforms[i],                  //
+		    &data->src_from_new[i],                //
+		    &data->new_from_src[i]);               //
+	}
+
+	/*
+	 * Not late latched, the late latch only knows about rotation only
+	 * timewarp matrices and would overwrite the source projection.
+	 */
+
+
+	/*
+	 * Source, target and distortion images.
+	 */
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = VK_REMAINING_MIP_LEVELS,
+	    .baseArrayLayer = 0,
+	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+	};
+
+	vk_cmd_image_barrier_gpu_locked( //
+	    vk,                          //
+	    crc->cmd,                    //
+	    target_image,                //
+	    0,                           //
+	    VK_ACCESS_SHADER_WRITE_BIT,  //
+	    VK_IMAGE_LAYOUT_UNDEFINED,   //
+	    VK_IMAGE_LAYOUT_GENERAL,     //
+	    subresource_range);          //
+
+	VkSampler sampler = r->samplers.clamp_to_edge;
+	VkSampler distortion_samplers[6] = {
+	    sampler, sampler, sampler, sampler, sampler, sampler,
+	};
+
+	// Clamp to edge to keep the depth stable at the edges.
+	VkSampler depth_samplers[2] = {sampler, sampler};
+
+	update_compute_shared_descriptor_set( //
+	    vk,                               //
+	    r->compute.src_binding,           //
+	    src_samplers,                     //
+	    src_image_views,                  //
+	    r->compute.distortion_binding,    //
+	    distortion_samplers,              //
+	    r->distortion.image_views,        //
+	    r->compute.target_binding,        //
+	    target_image_view,                //
+	    r->compute.ubo_binding,           //
+	    r->compute.distortion.ubo.buffer, //
+	    VK_WHOLE_SIZE,                    //
+	    r->compute.depth_binding,         //
+	    depth_samplers,                   //
+	    depth_image_views,                //
+	    crc->shared_descriptor_set);      //
+
+	vk->vkCmdBindPipeline(                                   //
+	    crc->cmd,                                            // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE,                      // pipelineBindPoint
+	    r->compute.distortion.positional_timewarp_pipeline); // pipeline
+
+	vk->vkCmdBindDescriptorSets(               //
+	    crc->cmd,                              // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
+	    r->compute.distortion.pipeline_layout, // layout
+	    0,                                     // firstSet
+	    1,                                     // descriptorSetCount
+	    &crc->shared_descriptor_set,           // pDescriptorSets
+	    0,                                     // dynamicOffsetCount
+	    NULL);                                 // pDynamicOffsets
+
+
+	uint32_t w = 0, h = 0;
+	calc_dispatch_dims_2_views(views, &w, &h);
+	assert(w != 0 && h != 0);
+
+	vk->vkCmdDispatch( //
+	    crc->cmd,      // commandBuffer
+	    w,             // groupCountX
+	    h,             // groupCountY
+	    2);            // groupCountZ
+
+	VkImageMemoryBarrier memoryBarrier = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+	    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+	    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+	    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+	    .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+	    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+	    .image = target_image,
+	    .subresourceRange = subresource_range,
+	};
+
+	vk->vkCmdPipelineBarrier(                 //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -655,7 +1078,7 @@ render_compute_projection(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -681,15 +1104,18 @@ render_compute_projection(struct render_compute *crc,
 	    r->compute.ubo_binding,           //
 	    r->compute.distortion.ubo.buffer, //
 	    VK_WHOLE_SIZE,                    //
+	    r->compute.depth_binding,         // The depth isn't used.
+	    src_samplers,                     //
+	    src_image_views,                  //
 	    crc->shared_descriptor_set);      //
 
 	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
+	    crc->cmd,                        // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,  // pipelineBindPoint
 	    r->compute.distortion.pipeline); // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -704,7 +1130,7 @@ render_compute_projection(struct render_compute *crc,
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -722,7 +1148,7 @@ render_compute_projection(struct render_compute *crc,
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -776,7 +1202,7 @@ render_compute_clear(struct render_compute *crc,                 //
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -802,15 +1228,18 @@ render_compute_clear(struct render_compute *crc,                 //
 	    r->compute.ubo_binding,           // ubo_binding
 	    r->compute.clear.ubo.buffer,      // ubo_buffer
 	    VK_WHOLE_SIZE,                    // ubo_size
+	    r->compute.depth_binding,         // depth_binding
+	    src_samplers,                     // depth_samplers[2]
+	    src_image_views,                  // depth_image_views[2]
 	    crc->shared_descriptor_set);      // descriptor_set
 
 	vk->vkCmdBindPipeline(              //
-	    r->cmd,                         // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    r->compute.clear.pipeline);     // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -825,7 +1254,7 @@ render_compute_clear(struct render_compute *crc,                 //
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -843,7 +1272,7 @@ render_compute_clear(struct render_compute *crc,                 //
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
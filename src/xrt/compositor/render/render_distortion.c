@@ -13,10 +13,101 @@
 #include "math/m_matrix_2x2.h"
 #include "math/m_vec2.h"
 
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_worker.h"
+
 #include "vk/vk_mini_helpers.h"
 
 #include "render/render_interface.h"
 
+#include <math.h>
+#include <string.h>
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+//! Size of the grid used to see how strong the distortion is.
+#define SIZING_GRID_COUNT (17)
+
+//! Largest interpolation error accepted in UV space, about a quarter pixel on a 2k wide view.
+#define SIZING_MAX_ERROR (1.0 / 8192.0)
+
+//! Offsets up to this size keeps enough precision when stored as half-floats.
+#define HALF_FLOAT_MAX_OFFSET (0.25f)
+
+//! Number of rows computed by each task given to the worker threads.
+#define ROWS_PER_TASK (16)
+
+//! Number of threads used to compute the distortion.
+#define THREAD_COUNT (4)
+
+//! Local size of the distortion generation shaders.
+#define GPU_GROUP_SIZE (8)
+
+DEBUG_GET_ONCE_BOOL_OPTION(gpu_distortion, "XRT_COMPOSITOR_GPU_DISTORTION", true)
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * Which model distortion_generate.comp evaluates, must match the shader.
+ */
+enum distortion_gpu_model
+{
+	DISTORTION_GPU_MODEL_VIVE = 0,
+	DISTORTION_GPU_MODEL_PANOTOOLS = 1,
+	DISTORTION_GPU_MODEL_CARDBOARD = 2,
+	DISTORTION_GPU_MODEL_NS_P2D = 3,
+};
+
+/*!
+ * Uniform data for distortion_generate.comp, std140 layout, only the values
+ * of the model in use are filled in.
+ */
+struct distortion_gpu_ubo_data
+{
+	//! texel_count, model, unused, unused.
+	int32_t config[4];
+
+	//! Row major, same as @ref xrt_matrix_2x2.
+	struct xrt_matrix_2x2 rot[2];
+
+	struct
+	{
+		//! aspect_x_over_y, grow_for_undistort, flip_y, unused.
+		float vive_params[4];
+		float vive_center[3][4];
+		float vive_coefficients[3][4];
+
+		//! distortion_k 0 to 3, then distortion_k 4, scale, unused.
+		float panotools_k[2][4];
+		float panotools_aberration[4];
+		//! lens_center, viewport_size.
+		float panotools_center_and_size[4];
+
+		//! distortion_k 0 to 3, then distortion_k 4, unused.
+		float cardboard_k[2][4];
+		//! size, offset.
+		float cardboard_screen[4];
+		float cardboard_texture[4];
+
+		//! x^i * y^j at [i * 4 + j].
+		float ns_p2d_x[16];
+		float ns_p2d_y[16];
+		//! Tangent of the left, right, up and down angles.
+		float ns_p2d_bounds[4];
+	} views[2];
+};
+
 
 /*
  *
@@ -27,24 +118,25 @@
 XRT_CHECK_RESULT static VkResult
 create_distortion_image_and_view(struct vk_bundle *vk,
                                  VkExtent2D extent,
+                                 VkFormat format,
+                                 VkImageUsageFlags usage,
                                  VkDeviceMemory *out_device_memory,
                                  VkImage *out_image,
                                  VkImageView *out_image_view)
 {
-	VkFormat format = VK_FORMAT_R32G32_SFLOAT;
 	VkImage image = VK_NULL_HANDLE;
 	VkDeviceMemory device_memory = VK_NULL_HANDLE;
 	VkImageView image_view = VK_NULL_HANDLE;
 	VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
 	VkResult ret;
 
-	ret = vk_create_image_simple(                                     //
-	    vk,                                                           // vk_bundle
-	    extent,                                                       // extent
-	    format,                                                       // format
-	    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, // usage
-	    &device_memory,                                               // out_device_memory
-	    &image);                                                      // out_image
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    extent,                   // extent
+	    format,                   // format
+	    usage,                    // usage
+	    &device_memory,           // out_device_memory
+	    &image);                  // out_image
 	VK_CHK_AND_RET(ret, "vk_create_image_simple");
 
 	VK_NAME_DEVICE_MEMORY(vk, device_memory, "distortion device_memory");
@@ -144,22 +236,25 @@ create_and_queue_upload_locked(struct vk_bundle *vk,
                                struct vk_cmd_pool *pool,
                                VkCommandBuffer cmd,
                                VkBuffer src_buffer,
+                               VkExtent2D extent,
+                               VkFormat format,
                                VkDeviceMemory *out_image_device_memory,
                                VkImage *out_image,
                                VkImageView *out_image_view)
 {
-	VkExtent2D extent = {RENDER_DISTORTION_IMAGE_DIMENSIONS, RENDER_DISTORTION_IMAGE_DIMENSIONS};
 	VkDeviceMemory device_memory = VK_NULL_HANDLE;
 	VkImage image = VK_NULL_HANDLE;
 	VkImageView image_view = VK_NULL_HANDLE;
 	VkResult ret;
 
-	ret = create_distortion_image_and_view( //
-	    vk,                                 // vk_bundle
-	    extent,                             // extent
-	    &device_memory,                     // out_device_memory
-	    &image,                             // out_image
-	    &image_view);                       // out_image_view
+	ret = create_distortion_image_and_view(                           //
+	    vk,                                                           // vk_bundle
+	    extent,                                                       // extent
+	    format,                                                       // format
+	    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, // usage
+	    &device_memory,                                               // out_device_memory
+	    &image,                                                       // out_image
+	    &image_view);                                                 // out_image_view
 	VK_CHK_AND_RET(ret, "create_distortion_image_and_view");
 
 	queue_upload_for_first_level_and_layer_locked( //
@@ -176,33 +271,124 @@ create_and_queue_upload_locked(struct vk_bundle *vk,
 	return VK_SUCCESS;
 }
 
+static uint16_t
+float_to_half(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	// Too small even for a denormal.
+	if (exponent < -10) {
+		return (uint16_t)sign;
+	}
+
+	// Denormal, move the implicit one into the mantissa.
+	if (exponent <= 0) {
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) {
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+
+	// Clamp to infinity, we never store anything that large.
+	if (exponent >= 31) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	// Rounding carries over into the exponent correctly.
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000) {
+		half++;
+	}
+
+	return (uint16_t)half;
+}
+
+static float
+second_difference(const struct xrt_vec2 *a, const struct xrt_vec2 *b, const struct xrt_vec2 *c)
+{
+	float x = fabsf(a->x - 2.0f * b->x + c->x);
+	float y = fabsf(a->y - 2.0f * b->y + c->y);
+
+	return x > y ? x : y;
+}
+
 /*!
- * Helper struct to make code easier to read.
+ * Evaluates the distortion at the output position @p u @p v, the result is
+ * the offset from that position per channel.
  */
-struct texture
+static void
+compute_offsets_at(
+    struct xrt_device *xdev, const struct xrt_matrix_2x2 *rot, uint32_t view, float u, float v, struct xrt_vec2 out[3])
 {
-	struct xrt_vec2 pixels[RENDER_DISTORTION_IMAGE_DIMENSIONS][RENDER_DISTORTION_IMAGE_DIMENSIONS];
-};
+	// These need to go from -0.5 to 0.5 for the rotation
+	struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
+	m_mat2x2_transform_vec2(rot, &uv, &uv);
+	uv.x += 0.5f;
+	uv.y += 0.5f;
+
+	struct xrt_uv_triplet result;
+	xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
+
+	// Store as offset from the unrotated position, the shader adds it back.
+	out[0] = (struct xrt_vec2){result.r.x - u, result.r.y - v};
+	out[1] = (struct xrt_vec2){result.g.x - u, result.g.y - v};
+	out[2] = (struct xrt_vec2){result.b.x - u, result.b.y - v};
+}
 
-struct tan_angles_transforms
+/*!
+ * A range of rows of the distortion images for one view, computed on a worker thread.
+ */
+struct distortion_task
 {
-	struct xrt_vec2 offset;
-	struct xrt_vec2 scale;
+	struct xrt_device *xdev;
+	struct xrt_matrix_2x2 rot;
+	uint32_t view;
+	uint32_t texel_count;
+	uint32_t row_start;
+	uint32_t row_end;
+
+	//! Offsets from the undistorted position per channel, texel_count squared each.
+	struct xrt_vec2 *r, *g, *b;
 };
 
-XRT_CHECK_RESULT static VkResult
-create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
-                                              struct xrt_device *xdev,
-                                              struct render_buffer *r_buffer,
-                                              struct render_buffer *g_buffer,
-                                              struct render_buffer *b_buffer,
-                                              uint32_t view,
-                                              bool pre_rotate)
+static void
+run_distortion_task(void *ptr)
 {
-	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-	VkResult ret;
+	struct distortion_task *task = (struct distortion_task *)ptr;
+
+	const uint32_t dim = task->texel_count;
+	const double dim_minus_one_f64 = dim - 1;
+
+	for (uint32_t row = task->row_start; row < task->row_end; row++) {
+		// This goes from 0 to 1.0 inclusive.
+		float v = (float)(row / dim_minus_one_f64);
+
+		for (uint32_t col = 0; col < dim; col++) {
+			// This goes from 0 to 1.0 inclusive.
+			float u = (float)(col / dim_minus_one_f64);
 
+			struct xrt_vec2 offsets[3];
+			compute_offsets_at(task->xdev, &task->rot, task->view, u, v, offsets);
+
+			uint32_t index = row * dim + col;
+			task->r[index] = offsets[0];
+			task->g[index] = offsets[1];
+			task->b[index] = offsets[2];
+		}
+	}
+}
+
+static struct xrt_matrix_2x2
+get_view_rotation(struct xrt_device *xdev, uint32_t view, bool pre_rotate)
+{
 	struct xrt_matrix_2x2 rot = xdev->hmd->views[view].rot;
 
 	const struct xrt_matrix_2x2 rotation_90_cw = {{
@@ -217,101 +403,658 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 		m_mat2x2_multiply(&rot, &rotation_90_cw, &rot);
 	}
 
-	VkDeviceSize size = sizeof(struct texture);
+	return rot;
+}
+
+/*!
+ * Computes the offsets for all images, split up in tasks over a few threads
+ * as large images needs hundreds of thousands of distortion evaluations.
+ */
+static void
+compute_distortion_offsets(struct xrt_device *xdev,
+                           uint32_t texel_count,
+                           bool pre_rotate,
+                           struct xrt_vec2 *offsets[RENDER_DISTORTION_NUM_IMAGES])
+{
+	const uint32_t tasks_per_view = (texel_count + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	const uint32_t task_count = tasks_per_view * 2;
+
+	struct distortion_task *tasks = U_TYPED_ARRAY_CALLOC(struct distortion_task, task_count);
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_matrix_2x2 rot = get_view_rotation(xdev, view, pre_rotate);
+
+		for (uint32_t i = 0; i < tasks_per_view; i++) {
+			struct distortion_task *task = &tasks[view * tasks_per_view + i];
+
+			task->xdev = xdev;
+			task->rot = rot;
+			task->view = view;
+			task->texel_count = texel_count;
+			task->row_start = i * ROWS_PER_TASK;
+			task->row_end = task->row_start + ROWS_PER_TASK;
+			if (task->row_end > texel_count) {
+				task->row_end = texel_count;
+			}
+
+			// Images are ordered by channel then view.
+			task->r = offsets[view + 0];
+			task->g = offsets[view + 2];
+			task->b = offsets[view + 4];
+		}
+	}
+
+	// The device might keep state in its distortion function, only spread it out if it says that is safe.
+	struct u_worker_thread_pool *pool = NULL;
+	struct u_worker_group *group = NULL;
+	if (xdev->compute_distortion_thread_safe) {
+		pool = u_worker_thread_pool_create(THREAD_COUNT - 1, THREAD_COUNT, "Distortion");
+		group = pool != NULL ? u_worker_group_create(pool) : NULL;
+	}
 
-	ret = render_buffer_init(vk, r_buffer, usage_flags, properties, size);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_init", err_buffers);
-	VK_NAME_BUFFER(vk, r_buffer->buffer, "distortion r_buffer");
-	ret = render_buffer_init(vk, g_buffer, usage_flags, properties, size);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_init", err_buffers);
-	VK_NAME_BUFFER(vk, g_buffer->buffer, "distortion g_buffer");
-	ret = render_buffer_init(vk, b_buffer, usage_flags, properties, size);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_init", err_buffers);
-	VK_NAME_BUFFER(vk, b_buffer->buffer, "distortion b_buffer");
+	if (group != NULL) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			u_worker_group_push(group, run_distortion_task, &tasks[i]);
+		}
+		u_worker_group_wait_all(group);
+	} else {
+		for (uint32_t i = 0; i < task_count; i++) {
+			run_distortion_task(&tasks[i]);
+		}
+	}
 
-	ret = render_buffer_map(vk, r_buffer);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_map", err_buffers);
-	ret = render_buffer_map(vk, g_buffer);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_map", err_buffers);
-	ret = render_buffer_map(vk, b_buffer);
-	VK_CHK_WITH_GOTO(ret, "render_buffer_map", err_buffers);
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
 
-	struct texture *r = r_buffer->mapped;
-	struct texture *g = g_buffer->mapped;
-	struct texture *b = b_buffer->mapped;
+	free(tasks);
+}
 
-	const double dim_minus_one_f64 = RENDER_DISTORTION_IMAGE_DIMENSIONS - 1;
+/*!
+ * Picks the model to generate the distortion with on the GPU, returns false
+ * if the device has no model that can be run there, or it has been disabled.
+ */
+static bool
+get_gpu_model(struct xrt_device *xdev, enum distortion_gpu_model *out_model)
+{
+	enum xrt_distortion_model models = xdev->hmd->distortion.models;
 
-	for (int row = 0; row < RENDER_DISTORTION_IMAGE_DIMENSIONS; row++) {
-		// This goes from 0 to 1.0 inclusive.
-		float v = (float)(row / dim_minus_one_f64);
+	if (!debug_get_bool_option_gpu_distortion()) {
+		return false;
+	}
 
-		for (int col = 0; col < RENDER_DISTORTION_IMAGE_DIMENSIONS; col++) {
-			// This goes from 0 to 1.0 inclusive.
-			float u = (float)(col / dim_minus_one_f64);
+	if ((models & XRT_DISTORTION_MODEL_VIVE) != 0) {
+		*out_model = DISTORTION_GPU_MODEL_VIVE;
+	} else if ((models & XRT_DISTORTION_MODEL_PANOTOOLS) != 0) {
+		*out_model = DISTORTION_GPU_MODEL_PANOTOOLS;
+	} else if ((models & XRT_DISTORTION_MODEL_CARDBOARD) != 0) {
+		*out_model = DISTORTION_GPU_MODEL_CARDBOARD;
+	} else if ((models & XRT_DISTORTION_MODEL_NS_P2D) != 0) {
+		*out_model = DISTORTION_GPU_MODEL_NS_P2D;
+	} else {
+		return false;
+	}
 
-			// These need to go from -0.5 to 0.5 for the rotation
-			struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
-			m_mat2x2_transform_vec2(&rot, &uv, &uv);
-			uv.x += 0.5f;
-			uv.y += 0.5f;
+	return true;
+}
 
-			struct xrt_uv_triplet result;
-			xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
+/*!
+ * The generation shader writes the images directly, so the format needs to
+ * support storage.
+ */
+static bool
+gpu_format_supported(struct vk_bundle *vk, VkFormat format)
+{
+	VkFormatProperties prop;
+	vk->vkGetPhysicalDeviceFormatProperties(vk->physical_device, format, &prop);
+
+	const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+	return (prop.optimalTilingFeatures & features) == features;
+}
+
+/*!
+ * The offsets never reach the CPU on the GPU path, so the format is picked
+ * from the largest offset on the sizing grid instead. The distortion is smooth
+ * so the grid, which includes the edges, gets close to the real maximum.
+ */
+static float
+estimate_max_offset(struct xrt_device *xdev, bool pre_rotate)
+{
+	const double step = 1.0 / (SIZING_GRID_COUNT - 1);
+	float max_offset = 0.0f;
 
-			r->pixels[row][col] = result.r;
-			g->pixels[row][col] = result.g;
-			b->pixels[row][col] = result.b;
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_matrix_2x2 rot = get_view_rotation(xdev, view, pre_rotate);
+
+		for (uint32_t row = 0; row < SIZING_GRID_COUNT; row++) {
+			for (uint32_t col = 0; col < SIZING_GRID_COUNT; col++) {
+				struct xrt_vec2 offsets[3];
+				compute_offsets_at(xdev, &rot, view, (float)(col * step), (float)(row * step), offsets);
+
+				for (uint32_t i = 0; i < 3; i++) {
+					max_offset = fmaxf(max_offset, fmaxf(fabsf(offsets[i].x), fabsf(offsets[i].y)));
+				}
+			}
 		}
 	}
 
-	render_buffer_unmap(vk, r_buffer);
-	render_buffer_unmap(vk, g_buffer);
-	render_buffer_unmap(vk, b_buffer);
+	return max_offset;
+}
+
+//! Use half-floats if all of the offsets are small enough to keep their precision.
+static VkFormat
+pick_offset_format(float max_offset)
+{
+	return max_offset <= HALF_FLOAT_MAX_OFFSET ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+}
+
+/*!
+ * Descriptor set layout for the distortion generation shader, the images it
+ * writes and the uniform data.
+ */
+XRT_CHECK_RESULT static VkResult
+create_gpu_descriptor_set_layout(struct vk_bundle *vk, VkDescriptorSetLayout *out_descriptor_set_layout)
+{
+	VkResult ret;
+
+	VkDescriptorSetLayoutBinding set_layout_bindings[2] = {
+	    {
+	        .binding = 0,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	        .descriptorCount = RENDER_DISTORTION_NUM_IMAGES,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	    {
+	        .binding = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	        .descriptorCount = 1,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	};
+
+	VkDescriptorSetLayoutCreateInfo set_layout_info = {
+	    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+	    .bindingCount = ARRAY_SIZE(set_layout_bindings),
+	    .pBindings = set_layout_bindings,
+	};
+
+	VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+	ret = vk->vkCreateDescriptorSetLayout(vk->device,              //
+	                                      &set_layout_info,        //
+	                                      NULL,                    //
+	                                      &descriptor_set_layout); //
+	VK_CHK_AND_RET(ret, "vkCreateDescriptorSetLayout");
+
+	*out_descriptor_set_layout = descriptor_set_layout;
 
 	return VK_SUCCESS;
+}
+
+static void
+copy_vec2_pair(float dst[4], struct xrt_vec2 a, struct xrt_vec2 b)
+{
+	dst[0] = a.x;
+	dst[1] = a.y;
+	dst[2] = b.x;
+	dst[3] = b.y;
+}
+
+static void
+fill_in_gpu_ubo(struct xrt_device *xdev,
+                enum distortion_gpu_model model,
+                uint32_t texel_count,
+                bool pre_rotate,
+                struct distortion_gpu_ubo_data *data)
+{
+	const struct xrt_hmd_parts *parts = xdev->hmd;
+
+	U_ZERO(data);
+
+	data->config[0] = (int32_t)texel_count;
+	data->config[1] = (int32_t)model;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		data->rot[view] = get_view_rotation(xdev, view, pre_rotate);
+
+		switch (model) {
+		case DISTORTION_GPU_MODEL_VIVE: {
+			const struct xrt_distortion_vive_values *vive = &parts->distortion.vive[view];
+
+			data->views[view].vive_params[0] = vive->aspect_x_over_y;
+			data->views[view].vive_params[1] = vive->grow_for_undistort;
+			data->views[view].vive_params[2] = vive->flip_y ? 1.0f : 0.0f;
+
+			for (uint32_t i = 0; i < 3; i++) {
+				data->views[view].vive_center[i][0] = vive->center[i].x;
+				data->views[view].vive_center[i][1] = vive->center[i].y;
+				memcpy(data->views[view].vive_coefficients[i], vive->coefficients[i], sizeof(float[4]));
+			}
+		} break;
+		case DISTORTION_GPU_MODEL_PANOTOOLS: {
+			const struct xrt_distortion_panotools_values *pano = &parts->distortion.panotools[view];
+
+			memcpy(data->views[view].panotools_k[0], pano->distortion_k, sizeof(float[4]));
+			data->views[view].panotools_k[1][0] = pano->distortion_k[4];
+			data->views[view].panotools_k[1][1] = pano->scale;
+			memcpy(data->views[view].panotools_aberration, pano->aberration_k, sizeof(float[3]));
+			copy_vec2_pair(data->views[view].panotools_center_and_size, pano->lens_center,
+			               pano->viewport_size);
+		} break;
+		case DISTORTION_GPU_MODEL_CARDBOARD: {
+			const struct xrt_distortion_cardboard_values *cb = &parts->distortion.cardboard[view];
+
+			memcpy(data->views[view].cardboard_k[0], cb->distortion_k, sizeof(float[4]));
+			data->views[view].cardboard_k[1][0] = cb->distortion_k[4];
+			copy_vec2_pair(data->views[view].cardboard_screen, cb->screen.size, cb->screen.offset);
+			copy_vec2_pair(data->views[view].cardboard_texture, cb->texture.size, cb->texture.offset);
+		} break;
+		case DISTORTION_GPU_MODEL_NS_P2D: {
+			const struct xrt_distortion_ns_p2d_values *ns = &parts->distortion.ns_p2d[view];
+
+			memcpy(data->views[view].ns_p2d_x, ns->x_coefficients, sizeof(ns->x_coefficients));
+			memcpy(data->views[view].ns_p2d_y, ns->y_coefficients, sizeof(ns->y_coefficients));
+			data->views[view].ns_p2d_bounds[0] = tanf(ns->fov.angle_left);
+			data->views[view].ns_p2d_bounds[1] = tanf(ns->fov.angle_right);
+			data->views[view].ns_p2d_bounds[2] = tanf(ns->fov.angle_up);
+			data->views[view].ns_p2d_bounds[3] = tanf(ns->fov.angle_down);
+		} break;
+		}
+	}
+}
+
+/*!
+ * Records the dispatch of the distortion generation shader, with the
+ * transitions of the images around it, and waits for it.
+ */
+XRT_CHECK_RESULT static VkResult
+submit_gpu_generation(struct render_resources *r,
+                      struct vk_bundle *vk,
+                      VkPipeline pipeline,
+                      VkPipelineLayout pipeline_layout,
+                      VkDescriptorSet descriptor_set,
+                      uint32_t texel_count,
+                      VkImage images[RENDER_DISTORTION_NUM_IMAGES],
+                      VkImageLayout old_layout)
+{
+	struct vk_cmd_pool *pool = &r->distortion_pool;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkResult ret;
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = VK_REMAINING_MIP_LEVELS,
+	    .baseArrayLayer = 0,
+	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+	};
+
+	// The old content is thrown away, but reads of it by earlier frames must be done.
+	VkAccessFlags src_access = old_layout == VK_IMAGE_LAYOUT_UNDEFINED ? 0 : VK_ACCESS_SHADER_READ_BIT;
+
+	vk_cmd_pool_lock(pool);
+
+	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, pool, 0, &cmd);
+	VK_CHK_WITH_GOTO(ret, "vk_cmd_pool_create_and_begin_cmd_buffer_locked", err_unlock);
+	VK_NAME_COMMAND_BUFFER(vk, cmd, "render_resources distortion generation command buffer");
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		vk_cmd_image_barrier_gpu_locked( //
+		    vk,                          //
+		    cmd,                         //
+		    images[i],                   //
+		    src_access,                  //
+		    VK_ACCESS_SHADER_WRITE_BIT,  //
+		    VK_IMAGE_LAYOUT_UNDEFINED,   //
+		    VK_IMAGE_LAYOUT_GENERAL,     //
+		    subresource_range);          //
+	}
+
+	vk->vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
-err_buffers:
-	render_buffer_close(vk, r_buffer);
-	render_buffer_close(vk, g_buffer);
-	render_buffer_close(vk, b_buffer);
+	vk->vkCmdBindDescriptorSets(        //
+	    cmd,                            // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    pipeline_layout,                // layout
+	    0,                              // firstSet
+	    1,                              // descriptorSetCount
+	    &descriptor_set,                // pDescriptorSets
+	    0,                              // dynamicOffsetCount
+	    NULL);                          // pDynamicOffsets
+
+	// One view per z.
+	const uint32_t group_count = (texel_count + GPU_GROUP_SIZE - 1) / GPU_GROUP_SIZE;
+	vk->vkCmdDispatch(cmd, group_count, group_count, 2);
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		vk_cmd_image_barrier_gpu_locked(              //
+		    vk,                                       //
+		    cmd,                                      //
+		    images[i],                                //
+		    VK_ACCESS_SHADER_WRITE_BIT,               //
+		    VK_ACCESS_SHADER_READ_BIT,                //
+		    VK_IMAGE_LAYOUT_GENERAL,                  //
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+		    subresource_range);                       //
+	}
+
+	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(vk, pool, cmd);
+	VK_CHK_WITH_GOTO(ret, "vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked", err_cmd);
+
+	vk_cmd_pool_unlock(pool);
+
+	return VK_SUCCESS;
+
+err_cmd:
+	vk->vkFreeCommandBuffers(vk->device, pool->pool, 1, &cmd);
+
+err_unlock:
+	vk_cmd_pool_unlock(pool);
+
+	return ret;
+}
+
+/*!
+ * Evaluates the distortion model in a compute shader that writes the
+ * distortion images directly, instead of calling compute_distortion for every
+ * texel and uploading the result, so it takes microseconds instead of blocking
+ * the compositor. The images must have storage usage, @p old_layout is the
+ * layout they are in, their content is replaced.
+ */
+XRT_CHECK_RESULT static VkResult
+generate_offsets_on_gpu(struct render_resources *r,
+                        struct vk_bundle *vk,
+                        struct xrt_device *xdev,
+                        enum distortion_gpu_model model,
+                        bool pre_rotate,
+                        VkImage images[RENDER_DISTORTION_NUM_IMAGES],
+                        VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES],
+                        VkImageLayout old_layout)
+{
+	VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+	VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+	struct render_buffer ubo = {0};
+	VkResult ret;
+
+	const uint32_t texel_count = r->distortion.texel_count;
+	const VkMemoryPropertyFlags properties =
+	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+
+	/*
+	 * Buffers.
+	 */
+
+	struct distortion_gpu_ubo_data data;
+	fill_in_gpu_ubo(xdev, model, texel_count, pre_rotate, &data);
+
+	ret = render_buffer_init(vk, &ubo, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, properties, sizeof(data));
+	VK_CHK_WITH_GOTO(ret, "render_buffer_init", tidy);
+	VK_NAME_BUFFER(vk, ubo.buffer, "distortion generation ubo");
+
+	ret = render_buffer_write(vk, &ubo, &data, sizeof(data));
+	VK_CHK_WITH_GOTO(ret, "render_buffer_write", tidy);
+
+
+	/*
+	 * Pipeline, only used at startup and on changes so not kept around.
+	 */
+
+	ret = create_gpu_descriptor_set_layout(vk, &descriptor_set_layout);
+	VK_CHK_WITH_GOTO(ret, "create_gpu_descriptor_set_layout", tidy);
+
+	ret = vk_create_pipeline_layout(vk, descriptor_set_layout, &pipeline_layout);
+	VK_CHK_WITH_GOTO(ret, "vk_create_pipeline_layout", tidy);
+
+	ret = vk_create_compute_pipeline(         //
+	    vk,                                   // vk_bundle
+	    r->pipeline_cache,                    // pipeline_cache
+	    r->shaders->distortion_generate_comp, // shader
+	    pipeline_layout,                      // pipeline_layout
+	    NULL,                                 // specialization_info
+	    &pipeline);                           // out_compute_pipeline
+	VK_CHK_WITH_GOTO(ret, "vk_create_compute_pipeline", tidy);
+
+	struct vk_descriptor_pool_info pool_info = {
+	    .uniform_per_descriptor_count = 1,
+	    .storage_image_per_descriptor_count = RENDER_DISTORTION_NUM_IMAGES,
+	    .descriptor_count = 1,
+	    .freeable = false,
+	};
+
+	ret = vk_create_descriptor_pool(vk, &pool_info, &descriptor_pool);
+	VK_CHK_WITH_GOTO(ret, "vk_create_descriptor_pool", tidy);
+
+	ret = vk_create_descriptor_set(vk, descriptor_pool, descriptor_set_layout, &descriptor_set);
+	VK_CHK_WITH_GOTO(ret, "vk_create_descriptor_set", tidy);
+
+	VkDescriptorImageInfo image_infos[RENDER_DISTORTION_NUM_IMAGES];
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		image_infos[i] = (VkDescriptorImageInfo){
+		    .imageView = image_views[i],
+		    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+		};
+	}
+
+	VkDescriptorBufferInfo ubo_info = {
+	    .buffer = ubo.buffer,
+	    .offset = 0,
+	    .range = VK_WHOLE_SIZE,
+	};
+
+	VkWriteDescriptorSet write_descriptor_sets[2] = {
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = 0,
+	        .descriptorCount = ARRAY_SIZE(image_infos),
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	        .pImageInfo = image_infos,
+	    },
+	    {
+	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	        .dstSet = descriptor_set,
+	        .dstBinding = 1,
+	        .descriptorCount = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	        .pBufferInfo = &ubo_info,
+	    },
+	};
+
+	vk->vkUpdateDescriptorSets(            //
+	    vk->device,                        //
+	    ARRAY_SIZE(write_descriptor_sets), // descriptorWriteCount
+	    write_descriptor_sets,             // pDescriptorWrites
+	    0,                                 // descriptorCopyCount
+	    NULL);                             // pDescriptorCopies
+
+
+	/*
+	 * Dispatch.
+	 */
+
+	ret = submit_gpu_generation( //
+	    r,                       // r
+	    vk,                      // vk_bundle
+	    pipeline,                // pipeline
+	    pipeline_layout,         // pipeline_layout
+	    descriptor_set,          // descriptor_set
+	    texel_count,             // texel_count
+	    images,                  // images
+	    old_layout);             // old_layout
+	VK_CHK_WITH_GOTO(ret, "submit_gpu_generation", tidy);
+
+	VK_DEBUG(vk, "Generated the distortion on the GPU");
+
+tidy:
+	D(DescriptorPool, descriptor_pool);
+	D(Pipeline, pipeline);
+	D(PipelineLayout, pipeline_layout);
+	D(DescriptorSetLayout, descriptor_set_layout);
+	render_buffer_close(vk, &ubo);
 
 	return ret;
 }
 
+/*!
+ * Fills in a staging buffer with the offsets, converted to the given format.
+ */
+XRT_CHECK_RESULT static VkResult
+create_and_fill_in_distortion_buffer(struct vk_bundle *vk,
+                                     struct render_buffer *buffer,
+                                     const struct xrt_vec2 *offsets,
+                                     uint32_t texel_count,
+                                     VkFormat format)
+{
+	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	VkResult ret;
+
+	const bool half = format == VK_FORMAT_R16G16_SFLOAT;
+	const uint32_t count = texel_count * texel_count;
+	VkDeviceSize size = count * (half ? sizeof(uint16_t[2]) : sizeof(struct xrt_vec2));
+
+	ret = render_buffer_init(vk, buffer, usage_flags, properties, size);
+	VK_CHK_AND_RET(ret, "render_buffer_init");
+	VK_NAME_BUFFER(vk, buffer->buffer, "distortion buffer");
+
+	ret = render_buffer_map(vk, buffer);
+	VK_CHK_WITH_GOTO(ret, "render_buffer_map", err_buffer);
+
+	if (half) {
+		uint16_t *dst = buffer->mapped;
+		for (uint32_t i = 0; i < count; i++) {
+			dst[i * 2 + 0] = float_to_half(offsets[i].x);
+			dst[i * 2 + 1] = float_to_half(offsets[i].y);
+		}
+	} else {
+		memcpy(buffer->mapped, offsets, size);
+	}
+
+	render_buffer_unmap(vk, buffer);
+
+	return VK_SUCCESS;
+
+err_buffer:
+	render_buffer_close(vk, buffer);
+
+	return ret;
+}
+
+/*!
+ * Creates the images and has the generation shader write them.
+ */
 static bool
-render_distortion_buffer_init(struct render_resources *r,
-                              struct vk_bundle *vk,
-                              struct xrt_device *xdev,
-                              bool pre_rotate)
+init_images_gpu(struct render_resources *r,
+                struct vk_bundle *vk,
+                struct xrt_device *xdev,
+                enum distortion_gpu_model model,
+                bool pre_rotate)
 {
-	struct render_buffer bufs[RENDER_DISTORTION_NUM_IMAGES];
-	VkDeviceMemory device_memories[RENDER_DISTORTION_NUM_IMAGES];
-	VkImage images[RENDER_DISTORTION_NUM_IMAGES];
-	VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES];
+	VkDeviceMemory device_memories[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImage images[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkResult ret;
+
+	const uint32_t texel_count = r->distortion.texel_count;
+	const VkExtent2D extent = {texel_count, texel_count};
+
+	float max_offset = estimate_max_offset(xdev, pre_rotate);
+	VkFormat format = pick_offset_format(max_offset);
+	VK_DEBUG(vk, "Distortion max offset about %f, using %s", max_offset, vk_format_string(format));
+
+	if (!gpu_format_supported(vk, format)) {
+		VK_DEBUG(vk, "Can't write %s from a shader, generating the distortion on the CPU",
+		         vk_format_string(format));
+		return false;
+	}
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		ret = create_distortion_image_and_view(                      //
+		    vk,                                                      // vk_bundle
+		    extent,                                                  // extent
+		    format,                                                  // format
+		    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, // usage
+		    &device_memories[i],                                     // out_device_memory
+		    &images[i],                                              // out_image
+		    &image_views[i]);                                        // out_image_view
+		VK_CHK_WITH_GOTO(ret, "create_distortion_image_and_view", err_resources);
+	}
+
+	ret = generate_offsets_on_gpu(r, vk, xdev, model, pre_rotate, images, image_views, VK_IMAGE_LAYOUT_UNDEFINED);
+	VK_CHK_WITH_GOTO(ret, "generate_offsets_on_gpu", err_resources);
+
+	r->distortion.pre_rotated = pre_rotate;
+	r->distortion.format = format;
+	r->distortion.generated_on_gpu = true;
+
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		r->distortion.device_memories[i] = device_memories[i];
+		r->distortion.images[i] = images[i];
+		r->distortion.image_views[i] = image_views[i];
+	}
+
+	return true;
+
+err_resources:
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		D(ImageView, image_views[i]);
+		D(Image, images[i]);
+		DF(Memory, device_memories[i]);
+	}
+
+	return false;
+}
+
+/*!
+ * Computes the offsets on the CPU and uploads them to the images.
+ */
+static bool
+init_images_cpu(struct render_resources *r, struct vk_bundle *vk, struct xrt_device *xdev, bool pre_rotate)
+{
+	struct render_buffer bufs[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkDeviceMemory device_memories[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImage images[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	VkImageView image_views[RENDER_DISTORTION_NUM_IMAGES] = {0};
+	struct xrt_vec2 *offsets[RENDER_DISTORTION_NUM_IMAGES] = {0};
 	VkCommandBuffer upload_buffer = VK_NULL_HANDLE;
 	VkResult ret;
 
+	const uint32_t texel_count = r->distortion.texel_count;
+	const VkExtent2D extent = {texel_count, texel_count};
+
 
 	/*
-	 * Basics
+	 * Compute the distortion.
 	 */
 
-	static_assert(RENDER_DISTORTION_NUM_IMAGES == 6, "Wrong number of distortion images!");
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		offsets[i] = U_TYPED_ARRAY_CALLOC(struct xrt_vec2, texel_count * texel_count);
+	}
 
-	render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[0], &r->distortion.uv_to_tanangle[0]);
-	render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[1], &r->distortion.uv_to_tanangle[1]);
+	compute_distortion_offsets(xdev, texel_count, pre_rotate, offsets);
+
+	float max_offset = 0.0f;
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		for (uint32_t k = 0; k < texel_count * texel_count; k++) {
+			max_offset = fmaxf(max_offset, fmaxf(fabsf(offsets[i][k].x), fabsf(offsets[i][k].y)));
+		}
+	}
+
+	VkFormat format = pick_offset_format(max_offset);
+	VK_DEBUG(vk, "Distortion max offset %f, using %s", max_offset, vk_format_string(format));
 
 
 	/*
 	 * Buffers with data to upload.
 	 */
 
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[0], &bufs[2], &bufs[4], 0, pre_rotate);
-	VK_CHK_WITH_GOTO(ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
-
-	ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[1], &bufs[3], &bufs[5], 1, pre_rotate);
-	VK_CHK_WITH_GOTO(ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
+	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
+		ret = create_and_fill_in_distortion_buffer(vk, &bufs[i], offsets[i], texel_count, format);
+		VK_CHK_WITH_GOTO(ret, "create_and_fill_in_distortion_buffer", err_resources);
+	}
 
 
 	/*
@@ -332,6 +1075,8 @@ render_distortion_buffer_init(struct render_resources *r,
 		    pool,                             // pool
 		    upload_buffer,                    // cmd
 		    bufs[i].buffer,                   // src_buffer
+		    extent,                           // extent
+		    format,                           // format
 		    &device_memories[i],              // out_image_device_memory
 		    &images[i],                       // out_image
 		    &image_views[i]);                 // out_image_view
@@ -348,6 +1093,8 @@ render_distortion_buffer_init(struct render_resources *r,
 	 */
 
 	r->distortion.pre_rotated = pre_rotate;
+	r->distortion.format = format;
+	r->distortion.generated_on_gpu = false;
 
 	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
 		r->distortion.device_memories[i] = device_memories[i];
@@ -362,6 +1109,7 @@ render_distortion_buffer_init(struct render_resources *r,
 
 	for (uint32_t i = 0; i < RENDER_DISTORTION_NUM_IMAGES; i++) {
 		render_buffer_close(vk, &bufs[i]);
+		free(offsets[i]);
 	}
 
 	return true;
@@ -379,18 +1127,94 @@ err_resources:
 		D(Image, images[i]);
 		DF(Memory, device_memories[i]);
 		render_buffer_close(vk, &bufs[i]);
+		free(offsets[i]);
 	}
 
 	return false;
 }
 
 
+static bool
+render_distortion_buffer_init(struct render_resources *r,
+                              struct vk_bundle *vk,
+                              struct xrt_device *xdev,
+                              bool pre_rotate)
+{
+	static_assert(RENDER_DISTORTION_NUM_IMAGES == 6, "Wrong number of distortion images!");
+
+	render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[0], &r->distortion.uv_to_tanangle[0]);
+	render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[1], &r->distortion.uv_to_tanangle[1]);
+
+	enum distortion_gpu_model model;
+	if (get_gpu_model(xdev, &model) && init_images_gpu(r, vk, xdev, model, pre_rotate)) {
+		return true;
+	}
+
+	return init_images_cpu(r, vk, xdev, pre_rotate);
+}
+
+
 /*
  *
  * 'Exported' functions.
  *
  */
 
+uint32_t
+render_distortion_calc_texel_count(struct xrt_device *xdev)
+{
+	const double step = 1.0 / (SIZING_GRID_COUNT - 1);
+	float max_d2 = 0.0f;
+
+	for (uint32_t view = 0; view < 2; view++) {
+		struct xrt_uv_triplet grid[SIZING_GRID_COUNT][SIZING_GRID_COUNT];
+
+		for (uint32_t row = 0; row < SIZING_GRID_COUNT; row++) {
+			for (uint32_t col = 0; col < SIZING_GRID_COUNT; col++) {
+				float u = (float)(col * step);
+				float v = (float)(row * step);
+				xrt_device_compute_distortion(xdev, view, u, v, &grid[row][col]);
+			}
+		}
+
+		// The second difference tells us how far from linear the distortion is.
+		for (uint32_t row = 1; row < SIZING_GRID_COUNT - 1; row++) {
+			for (uint32_t col = 1; col < SIZING_GRID_COUNT - 1; col++) {
+				const struct xrt_uv_triplet *c = &grid[row][col];
+				const struct xrt_uv_triplet *l = &grid[row][col - 1];
+				const struct xrt_uv_triplet *r = &grid[row][col + 1];
+				const struct xrt_uv_triplet *t = &grid[row - 1][col];
+				const struct xrt_uv_triplet *b = &grid[row + 1][col];
+
+				max_d2 = fmaxf(max_d2, second_difference(&l->r, &c->r, &r->r));
+				max_d2 = fmaxf(max_d2, second_difference(&l->g, &c->g, &r->g));
+				max_d2 = fmaxf(max_d2, second_difference(&l->b, &c->b, &r->b));
+				max_d2 = fmaxf(max_d2, second_difference(&t->r, &c->r, &b->r));
+				max_d2 = fmaxf(max_d2, second_difference(&t->g, &c->g, &b->g));
+				max_d2 = fmaxf(max_d2, second_difference(&t->b, &c->b, &b->b));
+			}
+		}
+	}
+
+	/*
+	 * Bilinear filtering has an error of about h^2 * f'' / 8 with a texel
+	 * spacing of h, the second difference on the grid is about step^2 * f''.
+	 * Solve for the texel count that keeps the error below the maximum.
+	 */
+	double texels = 1.0 + (SIZING_GRID_COUNT - 1) * sqrt(max_d2 / (8.0 * SIZING_MAX_ERROR));
+
+	// Round up to a multiple of 16 and clamp.
+	uint32_t texel_count = ((uint32_t)ceil(fmin(texels, RENDER_DISTORTION_IMAGE_MAX_DIMENSIONS)) + 15) & ~15u;
+	if (texel_count < RENDER_DISTORTION_IMAGE_MIN_DIMENSIONS) {
+		texel_count = RENDER_DISTORTION_IMAGE_MIN_DIMENSIONS;
+	}
+	if (texel_count > RENDER_DISTORTION_IMAGE_MAX_DIMENSIONS) {
+		texel_count = RENDER_DISTORTION_IMAGE_MAX_DIMENSIONS;
+	}
+
+	return texel_count;
+}
+
 void
 render_distortion_images_close(struct render_resources *r)
 {
@@ -421,3 +1245,43 @@ render_distortion_images_ensure(struct render_resources *r,
 
 	return true;
 }
+
+bool
+render_distortion_images_regenerate(struct render_resources *r, struct vk_bundle *vk, struct xrt_device *xdev)
+{
+	// Nothing to regenerate, ensure will pick up the new parameters.
+	if (r->distortion.image_views[0] == VK_NULL_HANDLE) {
+		return true;
+	}
+
+	const bool pre_rotate = r->distortion.pre_rotated;
+
+	/*
+	 * Rewrite the images in place if they were generated on the GPU and the
+	 * new offsets still fit in their format, the common case for an IPD
+	 * change, otherwise create them all over again.
+	 */
+	enum distortion_gpu_model model;
+	if (r->distortion.generated_on_gpu && get_gpu_model(xdev, &model) &&
+	    pick_offset_format(estimate_max_offset(xdev, pre_rotate)) == r->distortion.format) {
+		render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[0], &r->distortion.uv_to_tanangle[0]);
+		render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[1], &r->distortion.uv_to_tanangle[1]);
+
+		VkResult ret = generate_offsets_on_gpu(        //
+		    r,                                         // r
+		    vk,                                        // vk_bundle
+		    xdev,                                      // xdev
+		    model,                                     // model
+		    pre_rotate,                                // pre_rotate
+		    r->distortion.images,                      // images
+		    r->distortion.image_views,                 // image_views
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL); // old_layout
+		if (ret == VK_SUCCESS) {
+			return true;
+		}
+	}
+
+	render_distortion_images_close(r);
+
+	return render_distortion_buffer_init(r, vk, xdev, pre_rotate);
+}
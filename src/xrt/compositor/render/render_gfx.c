@@ -13,6 +13,7 @@
 #include "render/render_interface.h"
 
 #include <stdio.h>
+#include <string.h>
 
 
 /*
@@ -230,6 +231,105 @@ update_ubo_and_src_descriptor_set(struct vk_bundle *vk,
 	    NULL);                             // pDescriptorCopies
 }
 
+static inline bool
+cache_entry_matches(const struct render_gfx_descriptor_cache_entry *e,
+                    VkDescriptorSetLayout descriptor_set_layout,
+                    const struct render_sub_alloc *ubo,
+                    VkSampler src_sampler,
+                    VkImageView src_image_view)
+{
+	return e->descriptor_set_layout == descriptor_set_layout && //
+	       e->buffer == ubo->buffer &&                          //
+	       e->offset == ubo->offset &&                          //
+	       e->size == ubo->size &&                              //
+	       e->sampler == src_sampler &&                         //
+	       e->image_view == src_image_view;                     //
+}
+
+/*!
+ * Get a descriptor set from the cache that refers to the given UBO range and
+ * source image, writing a new or evicted one if needed. Returns
+ * VK_NULL_HANDLE in @p out_descriptor_set if the cache couldn't be used.
+ */
+XRT_CHECK_RESULT static VkResult
+descriptor_cache_get(struct render_gfx *rr,
+                     uint32_t ubo_binding,
+                     const struct render_sub_alloc *ubo,
+                     uint32_t src_binding,
+                     VkSampler src_sampler,
+                     VkImageView src_image_view,
+                     VkDescriptorSetLayout descriptor_set_layout,
+                     VkDescriptorSet *out_descriptor_set)
+{
+	struct render_gfx_descriptor_cache *cache = &rr->r->gfx.descriptor_cache;
+	struct render_gfx_descriptor_cache_entry *oldest = NULL;
+	struct render_gfx_descriptor_cache_entry *e = NULL;
+	struct vk_bundle *vk = vk_from_rr(rr);
+	VkResult ret;
+
+	for (uint32_t i = 0; i < cache->count; i++) {
+		e = &cache->entries[i];
+
+		if (cache_entry_matches(e, descriptor_set_layout, ubo, src_sampler, src_image_view)) {
+			e->last_used_frame = cache->frame;
+			*out_descriptor_set = e->descriptor_set;
+			return VK_SUCCESS;
+		}
+
+		// Sets used this frame are referenced by the command buffer, the layout can't be changed.
+		if (e->last_used_frame == cache->frame || e->descriptor_set_layout != descriptor_set_layout) {
+			continue;
+		}
+
+		if (oldest == NULL || e->last_used_frame < oldest->last_used_frame) {
+			oldest = e;
+		}
+	}
+
+	if (cache->count < ARRAY_SIZE(cache->entries)) {
+		e = &cache->entries[cache->count];
+
+		ret = vk_create_descriptor_set( //
+		    vk,                         // vk_bundle
+		    cache->descriptor_pool,     // descriptor_pool
+		    descriptor_set_layout,      // descriptor_set_layout
+		    &e->descriptor_set);        // descriptor_set
+		VK_CHK_AND_RET(ret, "vk_create_descriptor_set");
+
+		VK_NAME_DESCRIPTOR_SET(vk, e->descriptor_set, "render_gfx descriptor cache set");
+
+		cache->count++;
+	} else if (oldest != NULL) {
+		e = oldest;
+	} else {
+		*out_descriptor_set = VK_NULL_HANDLE;
+		return VK_SUCCESS;
+	}
+
+	update_ubo_and_src_descriptor_set( //
+	    vk,                            // vk_bundle
+	    ubo_binding,                   // ubo_binding
+	    ubo->buffer,                   // buffer
+	    ubo->offset,                   // offset
+	    ubo->size,                     // size
+	    src_binding,                   // src_binding
+	    src_sampler,                   // sampler
+	    src_image_view,                // image_view
+	    e->descriptor_set);            // descriptor_set
+
+	e->descriptor_set_layout = descriptor_set_layout;
+	e->buffer = ubo->buffer;
+	e->offset = ubo->offset;
+	e->size = ubo->size;
+	e->sampler = src_sampler;
+	e->image_view = src_image_view;
+	e->last_used_frame = cache->frame;
+
+	*out_descriptor_set = e->descriptor_set;
+
+	return VK_SUCCESS;
+}
+
 XRT_CHECK_RESULT static VkResult
 do_ubo_and_src_alloc_and_write(struct render_gfx *rr,
                                uint32_t ubo_binding,
@@ -240,6 +340,7 @@ do_ubo_and_src_alloc_and_write(struct render_gfx *rr,
                                VkImageView src_image_view,
                                VkDescriptorPool descriptor_pool,
                                VkDescriptorSetLayout descriptor_set_layout,
+                               void **out_mapped_ubo,
                                VkDescriptorSet *out_descriptor_set)
 {
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
@@ -260,6 +361,34 @@ do_ubo_and_src_alloc_and_write(struct render_gfx *rr,
 	    &ubo);                                  // out_rsa
 	VK_CHK_AND_RET(ret, "render_sub_alloc_ubo_alloc_and_write");
 
+	// Optional, used for late latching, the write above checks that it's mapped.
+	if (out_mapped_ubo != NULL) {
+		*out_mapped_ubo = (void *)((uint8_t *)rr->ubo_tracker.mapped + ubo.offset);
+	}
+
+
+	/*
+	 * Reuse a descriptor set from an earlier frame if we can.
+	 */
+
+	if (rr->r->gfx.descriptor_cache.enabled) {
+		ret = descriptor_cache_get( //
+		    rr,                     // rr
+		    ubo_binding,            // ubo_binding
+		    &ubo,                   // ubo
+		    src_binding,            // src_binding
+		    src_sampler,            // src_sampler
+		    src_image_view,         // src_image_view
+		    descriptor_set_layout,  // descriptor_set_layout
+		    &descriptor_set);       // out_descriptor_set
+		VK_CHK_AND_RET(ret, "descriptor_cache_get");
+
+		if (descriptor_set != VK_NULL_HANDLE) {
+			*out_descriptor_set = descriptor_set;
+			return VK_SUCCESS;
+		}
+	}
+
 
 	/*
 	 * Create and fill out destriptor.
@@ -288,8 +417,32 @@ do_ubo_and_src_alloc_and_write(struct render_gfx *rr,
 	return VK_SUCCESS;
 }
 
+/*!
+ * Bind the given graphics pipeline, unless it is already bound.
+ */
+static inline void
+bind_pipeline(struct render_gfx *rr, VkPipeline pipeline)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	if (rr->bound.pipeline == pipeline) {
+		return;
+	}
+
+	vk->vkCmdBindPipeline(               //
+	    rr->r->cmd,                      // commandBuffer
+	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
+	    pipeline);                       // pipeline
+
+	rr->bound.pipeline = pipeline;
+}
+
 static inline void
-dispatch_no_vbo(struct render_gfx *rr, uint32_t vertex_count, VkPipeline pipeline, VkDescriptorSet descriptor_set)
+dispatch_no_vbo(struct render_gfx *rr,
+                uint32_t vertex_count,
+                uint32_t instance_count,
+                VkPipeline pipeline,
+                VkDescriptorSet descriptor_set)
 {
 	struct vk_bundle *vk = vk_from_rr(rr);
 	struct render_resources *r = rr->r;
@@ -306,19 +459,16 @@ dispatch_no_vbo(struct render_gfx *rr, uint32_t vertex_count, VkPipeline pipelin
 	    0,                                   // dynamicOffsetCount
 	    NULL);                               // pDynamicOffsets
 
-	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
-	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
-	    pipeline);                       // pipeline
+	bind_pipeline(rr, pipeline);
 
 	// This pipeline doesn't have any VBO input or indices.
 
-	vk->vkCmdDraw(    //
-	    r->cmd,       // commandBuffer
-	    vertex_count, // vertexCount
-	    1,            // instanceCount
-	    0,            // firstVertex
-	    0);           // firstInstance
+	vk->vkCmdDraw(      //
+	    r->cmd,         // commandBuffer
+	    vertex_count,   // vertexCount
+	    instance_count, // instanceCount
+	    0,              // firstVertex
+	    0);             // firstInstance
 }
 
 
@@ -984,6 +1134,9 @@ render_gfx_begin(struct render_gfx *rr)
 	    &begin_info);               // pBeginInfo
 	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
 
+	// New frame, descriptor sets used by the last frame can now be evicted.
+	rr->r->gfx.descriptor_cache.frame++;
+
 	vk->vkCmdResetQueryPool( //
 	    rr->r->cmd,          // commandBuffer
 	    rr->r->query_pool,   // queryPool
@@ -1048,6 +1201,9 @@ render_gfx_begin_target(struct render_gfx *rr, struct render_gfx_target_resource
 	assert(rr->rtr == NULL);
 	rr->rtr = rtr;
 
+	// Be conservative, other code might have bound things since last target.
+	U_ZERO(&rr->bound);
+
 	VkRenderPass render_pass = rtr->rgrp->render_pass;
 	VkFramebuffer framebuffer = rtr->framebuffer;
 	VkExtent2D extent = rtr->extent;
@@ -1139,6 +1295,7 @@ render_gfx_mesh_alloc_and_write(struct render_gfx *rr,
                                 const struct render_gfx_mesh_ubo_data *data,
                                 VkSampler src_sampler,
                                 VkImageView src_image_view,
+                                struct render_gfx_mesh_ubo_data **out_mapped_data,
                                 VkDescriptorSet *out_descriptor_set)
 {
 	struct render_resources *r = rr->r;
@@ -1153,6 +1310,7 @@ render_gfx_mesh_alloc_and_write(struct render_gfx *rr,
 	    src_image_view,                     // src_image_view
 	    r->gfx.ubo_and_src_descriptor_pool, // descriptor_pool
 	    r->mesh.descriptor_set_layout,      // descriptor_set_layout
+	    (void **)out_mapped_data,           // out_mapped_ubo
 	    out_descriptor_set);                // out_descriptor_set
 }
 
@@ -1181,26 +1339,35 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 	// Select which pipeline we want.
 	VkPipeline pipeline = do_timewarp ? rr->rtr->rgrp->mesh.pipeline_timewarp : rr->rtr->rgrp->mesh.pipeline;
 
-	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
-	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
-	    pipeline);                       // pipeline
+	bind_pipeline(rr, pipeline);
 
 
 	/*
-	 * Vertex buffer.
+	 * Vertex and index buffers, shared between all views.
 	 */
 
-	VkBuffer buffers[1] = {r->mesh.vbo.buffer};
-	VkDeviceSize offsets[1] = {0};
-	assert(ARRAY_SIZE(buffers) == ARRAY_SIZE(offsets));
-
-	vk->vkCmdBindVertexBuffers( //
-	    r->cmd,                 // commandBuffer
-	    0,                      // firstBinding
-	    ARRAY_SIZE(buffers),    // bindingCount
-	    buffers,                // pBuffers
-	    offsets);               // pOffsets
+	if (!rr->bound.mesh_buffers) {
+		VkBuffer buffers[1] = {r->mesh.vbo.buffer};
+		VkDeviceSize offsets[1] = {0};
+		assert(ARRAY_SIZE(buffers) == ARRAY_SIZE(offsets));
+
+		vk->vkCmdBindVertexBuffers( //
+		    r->cmd,                 // commandBuffer
+		    0,                      // firstBinding
+		    ARRAY_SIZE(buffers),    // bindingCount
+		    buffers,                // pBuffers
+		    offsets);               // pOffsets
+
+		if (r->mesh.index_count_total > 0) {
+			vk->vkCmdBindIndexBuffer(  //
+			    r->cmd,                // commandBuffer
+			    r->mesh.ibo.buffer,    // buffer
+			    0,                     // offset
+			    VK_INDEX_TYPE_UINT32); // indexType
+		}
+
+		rr->bound.mesh_buffers = true;
+	}
 
 
 	/*
@@ -1208,12 +1375,6 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 	 */
 
 	if (r->mesh.index_count_total > 0) {
-		vk->vkCmdBindIndexBuffer(  //
-		    r->cmd,                // commandBuffer
-		    r->mesh.ibo.buffer,    // buffer
-		    0,                     // offset
-		    VK_INDEX_TYPE_UINT32); // indexType
-
 		vk->vkCmdDrawIndexed(                  //
 		    r->cmd,                            // commandBuffer
 		    r->mesh.index_counts[mesh_index],  // indexCount
@@ -1257,6 +1418,7 @@ render_gfx_layer_cylinder_alloc_and_write(struct render_gfx *rr,
 	    src_image_view,                            // src_image_view
 	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
 	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
+	    NULL,                                      // out_mapped_ubo
 	    out_descriptor_set);                       // out_descriptor_set
 }
 
@@ -1279,6 +1441,7 @@ render_gfx_layer_equirect2_alloc_and_write(struct render_gfx *rr,
 	    src_image_view,                            // src_image_view
 	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
 	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
+	    NULL,                                      // out_mapped_ubo
 	    out_descriptor_set);                       // out_descriptor_set
 }
 
@@ -1301,28 +1464,37 @@ render_gfx_layer_projection_alloc_and_write(struct render_gfx *rr,
 	    src_image_view,                            // src_image_view
 	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
 	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
+	    NULL,                                      // out_mapped_ubo
 	    out_descriptor_set);                       // out_descriptor_set
 }
 
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_quad_alloc_and_write(struct render_gfx *rr,
                                       const struct render_gfx_layer_quad_data *data,
+                                      uint32_t instance_count,
                                       VkSampler src_sampler,
                                       VkImageView src_image_view,
                                       VkDescriptorSet *out_descriptor_set)
 {
 	struct render_resources *r = rr->r;
 
+	assert(instance_count > 0 && instance_count <= RENDER_GFX_LAYER_QUAD_MAX_INSTANCES);
+
+	/*
+	 * Only upload and bind the instances drawn, the shader never reads an
+	 * instance past the instance count so the rest of the block isn't needed.
+	 */
 	return do_ubo_and_src_alloc_and_write(         //
 	    rr,                                        // rr
 	    RENDER_BINDING_LAYER_SHARED_UBO,           // ubo_binding
 	    data,                                      // ubo_ptr
-	    sizeof(*data),                             // ubo_size
+	    sizeof(*data) * instance_count,            // ubo_size
 	    RENDER_BINDING_LAYER_SHARED_SRC,           // src_binding
 	    src_sampler,                               // src_sampler
 	    src_image_view,                            // src_image_view
 	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
 	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
+	    NULL,                                      // out_mapped_ubo
 	    out_descriptor_set);                       // out_descriptor_set
 }
 
@@ -1346,6 +1518,7 @@ render_gfx_layer_cylinder(struct render_gfx *rr, bool premultiplied_alpha, VkDes
 	dispatch_no_vbo(     //
 	    rr,              // rr
 	    vertex_count,    // vertex_count
+	    1,               // instance_count
 	    pipeline,        // pipeline
 	    descriptor_set); // descriptor_set
 }
@@ -1362,6 +1535,7 @@ render_gfx_layer_equirect2(struct render_gfx *rr, bool premultiplied_alpha, VkDe
 	dispatch_no_vbo(     //
 	    rr,              // rr
 	    4,               // vertex_count
+	    1,               // instance_count
 	    pipeline,        // pipeline
 	    descriptor_set); // descriptor_set
 }
@@ -1378,22 +1552,27 @@ render_gfx_layer_projection(struct render_gfx *rr, bool premultiplied_alpha, VkD
 	dispatch_no_vbo(     //
 	    rr,              // rr
 	    4,               // vertex_count
+	    1,               // instance_count
 	    pipeline,        // pipeline
 	    descriptor_set); // descriptor_set
 }
 
 void
-render_gfx_layer_quad(struct render_gfx *rr, bool premultiplied_alpha, VkDescriptorSet descriptor_set)
+render_gfx_layer_quad(struct render_gfx *rr,
+                      bool premultiplied_alpha,
+                      VkDescriptorSet descriptor_set,
+                      uint32_t instance_count)
 {
 	VkPipeline pipeline =                                      //
 	    premultiplied_alpha                                    //
 	        ? rr->rtr->rgrp->layer.quad_premultiplied_alpha    //
 	        : rr->rtr->rgrp->layer.quad_unpremultiplied_alpha; //
 
-	// Hardcoded to 4 vertices.
+	// Hardcoded to 4 vertices, instances are drawn in order.
 	dispatch_no_vbo(     //
 	    rr,              // rr
 	    4,               // vertex_count
+	    instance_count,  // instance_count
 	    pipeline,        // pipeline
 	    descriptor_set); // descriptor_set
 }
@@ -22,6 +22,9 @@ extern "C" {
 #endif
 
 
+struct u_worker_group;
+struct u_worker_thread_pool;
+
 /*!
  * @defgroup comp_render Compositor render code
  * @ingroup comp
@@ -55,29 +58,54 @@ extern "C" {
  * Max number of layers for layer squasher, can be different from
  * @ref COMP_MAX_LAYERS as the render module is separate from the compositor.
  */
-#define RENDER_MAX_LAYERS (16)
+#define RENDER_MAX_LAYERS (64)
+
+/*!
+ * Max number of layers that the compute layer squasher shader takes in a
+ * single dispatch, if a view has more layers than this they are squashed in
+ * multiple runs where each run blends on top of what the earlier runs wrote.
+ */
+#define RENDER_MAX_LAYERS_PER_RUN (16)
 
 /*!
  * Max number of images that can be given at a single time to the layer
  * squasher in a single dispatch.
  */
-#define RENDER_MAX_IMAGES (RENDER_MAX_LAYERS * 2)
+#define RENDER_MAX_IMAGES (RENDER_MAX_LAYERS_PER_RUN * 2)
+
+/*!
+ * Max number of cube map images that can be given to the layer squasher in a
+ * single dispatch, they have their own binding as they are sampled as cubes.
+ */
+#define RENDER_MAX_CUBE_IMAGES (4)
+
+/*!
+ * Max number of times that the layer squasher shader can run on a single view.
+ */
+#define RENDER_MAX_LAYER_RUNS_PER_VIEW (RENDER_MAX_LAYERS / RENDER_MAX_LAYERS_PER_RUN)
 
 /*!
  * Maximum number of times that the layer squasher shader can run per
- * @ref render_compute. Since you run the layer squasher shader once per view
- * this is essentially the same as number of views. But if you you where to do
- * two or more different compositions it's not the maximum number of views per
- * composition (which is this number divided by number of composition).
+ * @ref render_compute. Since you run the layer squasher shader at least once
+ * per view this is the number of views times
+ * @ref RENDER_MAX_LAYER_RUNS_PER_VIEW. But if you you where to do two or more
+ * different compositions it's not the maximum number of views per composition
+ * (which is this number divided by number of composition).
  */
-#define RENDER_MAX_LAYER_RUNS (2)
+#define RENDER_MAX_LAYER_RUNS (2 * RENDER_MAX_LAYER_RUNS_PER_VIEW)
 
-//! How large in pixels the distortion image is.
-#define RENDER_DISTORTION_IMAGE_DIMENSIONS (128)
+//! Smallest size in pixels of the distortion images, used for mild lenses.
+#define RENDER_DISTORTION_IMAGE_MIN_DIMENSIONS (64)
+
+//! Largest size in pixels of the distortion images, used for strong lenses.
+#define RENDER_DISTORTION_IMAGE_MAX_DIMENSIONS (512)
 
 //! How many distortion images we have, one for each channel (3 rgb) and per view, total 6.
 #define RENDER_DISTORTION_NUM_IMAGES (6)
 
+//! Cells along each side of the visibility mask grid of the layer squasher, one bit per cell in a row.
+#define RENDER_VISIBILITY_GRID_SIZE (32)
+
 //! Which binding does the layer projection and quad shader has it's UBO on.
 #define RENDER_BINDING_LAYER_SHARED_UBO 0
 
@@ -101,6 +129,19 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
                              const struct xrt_pose *new_pose,
                              struct xrt_matrix_4x4 *matrix);
 
+/*!
+ * Calculates the matrices used by the positional timewarp, the source
+ * projection matrix and the full transforms between the source view and the
+ * new view, unlike @ref render_calc_time_warp_matrix they include position.
+ */
+void
+render_calc_positional_time_warp_matrices(const struct xrt_pose *src_pose,
+                                          const struct xrt_fov *src_fov,
+                                          const struct xrt_pose *new_pose,
+                                          struct xrt_matrix_4x4 *out_projection,
+                                          struct xrt_matrix_4x4 *out_src_from_new,
+                                          struct xrt_matrix_4x4 *out_new_from_src);
+
 /*!
  * This function constructs a transformation in the form of a normalized rect
  * that lets you go from a UV coordinate on a projection plane to the a point on
@@ -120,6 +161,53 @@ void
 render_calc_uv_to_tangent_lengths_rect(const struct xrt_fov *fov, struct xrt_normalized_rect *out_rect);
 
 
+/*
+ *
+ * Late latching.
+ *
+ */
+
+/*!
+ * Keeps track of the timewarp matrices the distortion pass has written into
+ * mapped UBO memory, so that they can be rewritten with a fresher head pose
+ * after the command buffer has been recorded but before it is submitted. All
+ * UBOs are host coherent and persistently mapped so a write done before the
+ * submit is seen by the GPU.
+ *
+ * Zero initialise to have nothing to latch.
+ */
+struct render_late_latch
+{
+	struct
+	{
+		//! Pose and fov the source image was rendered with.
+		struct xrt_pose src_pose;
+		struct xrt_fov src_fov;
+
+		//! Points into mapped UBO memory, NULL if the view has no timewarp.
+		struct xrt_matrix_4x4 *transform;
+	} views[2];
+};
+
+/*!
+ * Record that the timewarp matrix for @p view_index lives at @p transform,
+ * the memory must stay mapped until the late latch has been done.
+ */
+void
+render_late_latch_set_view(struct render_late_latch *rll,
+                           uint32_t view_index,
+                           const struct xrt_pose *src_pose,
+                           const struct xrt_fov *src_fov,
+                           struct xrt_matrix_4x4 *transform);
+
+/*!
+ * Recalculate all of the recorded timewarp matrices with @p new_poses and
+ * write them to the UBOs, returns false if there was nothing to latch.
+ */
+bool
+render_late_latch_update(const struct render_late_latch *rll, const struct xrt_pose new_poses[2]);
+
+
 /*
  *
  * Shaders.
@@ -135,6 +223,7 @@ struct render_shaders
 	VkShaderModule clear_comp;
 	VkShaderModule layer_comp;
 	VkShaderModule distortion_comp;
+	VkShaderModule distortion_generate_comp;
 
 	VkShaderModule mesh_vert;
 	VkShaderModule mesh_frag;
@@ -342,6 +431,84 @@ render_sub_alloc_ubo_alloc_and_write(struct vk_bundle *vk,
  *
  */
 
+//! Number of descriptor sets kept between frames, enough for one full frame.
+#define RENDER_GFX_DESCRIPTOR_CACHE_SIZE (2 * RENDER_MAX_LAYERS + 2)
+
+/*!
+ * A descriptor set of the gfx path kept between frames, the UBO is
+ * sub-allocated from a tracker that restarts each frame, so an unchanged set
+ * of layers gets the same UBO ranges every frame.
+ */
+struct render_gfx_descriptor_cache_entry
+{
+	VkDescriptorSetLayout descriptor_set_layout;
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	VkSampler sampler;
+	VkImageView image_view;
+
+	//! Value of @ref render_gfx_descriptor_cache::frame when last used.
+	uint64_t last_used_frame;
+
+	VkDescriptorSet descriptor_set;
+};
+
+/*!
+ * Cache of gfx descriptor sets, used so that frames with the same layers and
+ * swapchain images as earlier frames don't need to allocate and write any
+ * descriptor sets, only the UBO contents are updated.
+ */
+struct render_gfx_descriptor_cache
+{
+	//! Is the cache used, also covers the layer squasher sets, off by default.
+	bool enabled;
+
+	//! Never reset by @ref render_gfx, only when the cache is flushed.
+	VkDescriptorPool descriptor_pool;
+
+	//! Incremented for each frame, sets used in the current frame are never evicted.
+	uint64_t frame;
+
+	//! Number of used entries.
+	uint32_t count;
+
+	struct render_gfx_descriptor_cache_entry entries[RENDER_GFX_DESCRIPTOR_CACHE_SIZE];
+};
+
+/*!
+ * What the source bindings of a layer squasher descriptor set were last
+ * written with, the sets are kept between frames so unchanged sources don't
+ * need to be written again.
+ */
+struct render_compute_layer_descriptor_state
+{
+	//! Nothing is known about the set, write everything.
+	bool valid;
+
+	uint32_t image_count;
+	VkSampler src_samplers[RENDER_MAX_IMAGES];
+	VkImageView src_image_views[RENDER_MAX_IMAGES];
+	VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES];
+	VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES];
+};
+
+/*!
+ * Which layer types a layer squasher pipeline is specialised for, all but the
+ * generic variant leave out the code for the other layer types. Projection
+ * layers with depth are sampled the same as without so are in both mixes.
+ */
+enum render_compute_layer_mix
+{
+	//! Handles all layer types.
+	RENDER_COMPUTE_LAYER_MIX_ALL = 0,
+	//! Only projection layers, by far the most common case.
+	RENDER_COMPUTE_LAYER_MIX_PROJECTION = 1,
+	//! Projection and quad layers.
+	RENDER_COMPUTE_LAYER_MIX_PROJECTION_QUAD = 2,
+	RENDER_COMPUTE_LAYER_MIX_COUNT = 3,
+};
+
 /*!
  * Holds all pools and static resources for rendering.
  */
@@ -368,10 +535,23 @@ struct render_resources
 	//! Shared for all rendering.
 	VkPipelineCache pipeline_cache;
 
+	//! Size of the pipeline cache data when last loaded or saved to disk.
+	size_t pipeline_cache_saved_size;
+
 	VkCommandPool cmd_pool;
 
+	/*!
+	 * Pool for @ref async_compute_cmd, separate from @ref cmd_pool so both
+	 * can be reset on their own, only created if the vk_bundle has a
+	 * compute queue.
+	 */
+	VkCommandPool async_compute_cmd_pool;
+
 	VkQueryPool query_pool;
 
+	//! Bitmask of @ref render_timing_stage recorded since the durations were last read.
+	uint32_t timing_stages_recorded;
+
 
 	/*
 	 * Static
@@ -380,6 +560,25 @@ struct render_resources
 	//! Command buffer for recording everything.
 	VkCommandBuffer cmd;
 
+	//! Command buffer for work submitted to the compute queue, may be VK_NULL_HANDLE.
+	VkCommandBuffer async_compute_cmd;
+
+	/*!
+	 * For recording the commands of each view on its own thread into a
+	 * secondary command buffer that is then executed from @ref cmd. Each
+	 * view has its own pool as pools can not be used from two threads at
+	 * the same time, see @ref render_compute_begin_view.
+	 */
+	struct
+	{
+		struct vk_cmd_pool pools[2];
+		VkCommandBuffer cmds[2];
+
+		//! Does the recording, NULL if it could not be created.
+		struct u_worker_group *group;
+		struct u_worker_thread_pool *thread_pool;
+	} view_record;
+
 	struct
 	{
 		//! Sampler for mock/null images.
@@ -409,6 +608,9 @@ struct render_resources
 		 */
 		struct render_buffer shared_ubo;
 
+		//! Descriptor sets reused between frames.
+		struct render_gfx_descriptor_cache descriptor_cache;
+
 		struct
 		{
 			struct
@@ -461,6 +663,14 @@ struct render_resources
 			VkImageView image_view;
 			VkDeviceMemory memory;
 		} color;
+
+		//! Six faced image with a cube view, pads out cube map descriptors.
+		struct
+		{
+			VkImage image;
+			VkImageView image_view;
+			VkDeviceMemory memory;
+		} cube;
 	} mock;
 
 	struct
@@ -480,6 +690,12 @@ struct render_resources
 		//! Uniform data binding.
 		uint32_t ubo_binding;
 
+		//! Depth of the source projection views, only used by positional timewarp.
+		uint32_t depth_binding;
+
+		//! Cube map sources of the layer squasher.
+		uint32_t cube_binding;
+
 		struct
 		{
 			//! Descriptor set layout for compute.
@@ -488,17 +704,35 @@ struct render_resources
 			//! Pipeline layout used for compute distortion.
 			VkPipelineLayout pipeline_layout;
 
-			//! Doesn't depend on target so is static.
-			VkPipeline non_timewarp_pipeline;
+			//! Doesn't depend on target so is static, one per layer mix.
+			VkPipeline non_timewarp_pipeline[RENDER_COMPUTE_LAYER_MIX_COUNT];
 
-			//! Doesn't depend on target so is static.
-			VkPipeline timewarp_pipeline;
+			//! Doesn't depend on target so is static, one per layer mix.
+			VkPipeline timewarp_pipeline[RENDER_COMPUTE_LAYER_MIX_COUNT];
+
+			//! Shades 2x2 pixels per invocation, for the periphery when foveated.
+			VkPipeline reduced_rate_non_timewarp_pipeline[RENDER_COMPUTE_LAYER_MIX_COUNT];
+
+			//! Shades 2x2 pixels per invocation, for the periphery when foveated.
+			VkPipeline reduced_rate_timewarp_pipeline[RENDER_COMPUTE_LAYER_MIX_COUNT];
 
 			//! Size of combined image sampler array
 			uint32_t image_array_size;
 
 			//! Target info.
 			struct render_buffer ubos[RENDER_MAX_LAYER_RUNS];
+
+			//! Never reset, the sets are allocated once at init.
+			VkDescriptorPool descriptor_pool;
+
+			//! One descriptor set per run, kept between frames like @ref ubos.
+			VkDescriptorSet descriptor_sets[RENDER_MAX_LAYER_RUNS];
+
+			/*!
+			 * What each of @ref descriptor_sets was last written with,
+			 * only used if @ref render_gfx_descriptor_cache::enabled.
+			 */
+			struct render_compute_layer_descriptor_state written[RENDER_MAX_LAYER_RUNS];
 		} layer;
 
 		struct
@@ -515,6 +749,9 @@ struct render_resources
 			//! Doesn't depend on target so is static.
 			VkPipeline timewarp_pipeline;
 
+			//! Uses the source depth to also correct for head position.
+			VkPipeline positional_timewarp_pipeline;
+
 			//! Target info.
 			struct render_buffer ubo;
 		} distortion;
@@ -547,6 +784,15 @@ struct render_resources
 
 		//! Whether distortion images have been pre-rotated 90 degrees.
 		bool pre_rotated;
+
+		//! Format of the distortion images, half-floats when the offsets are small.
+		VkFormat format;
+
+		//! Were the images written by the generation shader, they can then be rewritten in place.
+		bool generated_on_gpu;
+
+		//! Size in pixels of the square distortion images, picked per device.
+		uint32_t texel_count;
 	} distortion;
 };
 
@@ -572,7 +818,24 @@ void
 render_resources_close(struct render_resources *r);
 
 /*!
- * Creates or recreates the compute distortion textures if necessary.
+ * Write the pipeline cache to disk if it has grown since it was last loaded
+ * or saved, call after creating new pipelines. Also done on close.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_save_pipeline_cache(struct render_resources *r);
+
+/*!
+ * Pick how large the distortion images needs to be for the device, the
+ * distortion is sampled on a coarse grid to see how far from linear it is.
+ */
+uint32_t
+render_distortion_calc_texel_count(struct xrt_device *xdev);
+
+/*!
+ * Creates or recreates the compute distortion textures if necessary, the
+ * images holds the offset from the undistorted position to the distorted one.
  */
 bool
 render_distortion_images_ensure(struct render_resources *r,
@@ -580,6 +843,15 @@ render_distortion_images_ensure(struct render_resources *r,
                                 struct xrt_device *xdev,
                                 bool pre_rotate);
 
+/*!
+ * Generates the distortion images again from the current parameters of the
+ * device, call after it changes them, say the IPD or a new calibration. The
+ * images are rewritten in place when possible, the size of the images is kept.
+ * Must not be called while GPU work using the images is in flight.
+ */
+bool
+render_distortion_images_regenerate(struct render_resources *r, struct vk_bundle *vk, struct xrt_device *xdev);
+
 /*!
  * Free distortion images.
  */
@@ -616,6 +888,60 @@ render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_st
 bool
 render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_duration_ns);
 
+/*!
+ * Stages of the GPU work that are timed on their own, each stage has a pair of
+ * timestamp queries in @ref render_resources::query_pool. The frame stage is
+ * the whole command buffer and is written by the begin and end functions of
+ * @ref render_gfx and @ref render_compute.
+ */
+enum render_timing_stage
+{
+	RENDER_TIMING_STAGE_FRAME = 0,
+	RENDER_TIMING_STAGE_LAYER_SQUASH = 1,
+	RENDER_TIMING_STAGE_DISTORTION = 2,
+	RENDER_TIMING_STAGE_COUNT = 3,
+};
+
+/*!
+ * Reset the queries of @p stage and write the start timestamp, must be called
+ * outside of a render pass since it resets the queries. Not for the frame stage.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_begin_timing_stage(struct render_resources *r, VkCommandBuffer cmd, enum render_timing_stage stage);
+
+/*!
+ * Write the end timestamp of @p stage.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_end_timing_stage(struct render_resources *r, VkCommandBuffer cmd, enum render_timing_stage stage);
+
+/*!
+ * Returns how long each stage of the latest GPU work took, a stage that was
+ * not recorded since the last call gets zero, as does the frame stage. Unlike
+ * the other functions this doesn't wait for the results, but the same
+ * requirement on the GPU having completed applies.
+ *
+ * @public @memberof render_resources
+ */
+bool
+render_resources_get_stage_durations(struct render_resources *r,
+                                     uint64_t out_durations_ns[RENDER_TIMING_STAGE_COUNT]);
+
+/*!
+ * Drop all cached gfx descriptor sets and forget what the layer squasher
+ * descriptor sets refer to, must be called when any image view that might be
+ * referenced by them is destroyed. The GPU must be done with any work using
+ * the sets.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_flush_descriptor_cache(struct render_resources *r);
+
 
 /*
  *
@@ -819,6 +1145,22 @@ struct render_gfx
 
 	//! The current target we are rendering too, can change during command building.
 	struct render_gfx_target_resources *rtr;
+
+	//! Timewarp matrices written by the mesh distortion, for late latching.
+	struct render_late_latch late_latch;
+
+	/*!
+	 * State currently bound on the command buffer, used to skip binding
+	 * the same thing again for every view, reset on each new target.
+	 */
+	struct
+	{
+		//! Last graphics pipeline bound.
+		VkPipeline pipeline;
+
+		//! Are the mesh vertex and index buffers bound.
+		bool mesh_buffers;
+	} bound;
 };
 
 /*!
@@ -915,7 +1257,14 @@ struct render_gfx_layer_projection_data
 };
 
 /*!
- * UBO data that is sent to the layer quad shader.
+ * Max number of quads drawn with a single instanced draw, must match the
+ * array size in the layer quad shader.
+ */
+#define RENDER_GFX_LAYER_QUAD_MAX_INSTANCES (8)
+
+/*!
+ * Data for one quad drawn by the layer quad shader, see
+ * @ref render_gfx_layer_quad_ubo_data.
  */
 struct render_gfx_layer_quad_data
 {
@@ -923,6 +1272,15 @@ struct render_gfx_layer_quad_data
 	struct xrt_matrix_4x4 mvp;
 };
 
+/*!
+ * Layout of the layer quad shader's UBO, one entry per instance, only the
+ * instances drawn are uploaded.
+ */
+struct render_gfx_layer_quad_ubo_data
+{
+	struct render_gfx_layer_quad_data instances[RENDER_GFX_LAYER_QUAD_MAX_INSTANCES];
+};
+
 
 /*!
  * @name Drawing functions
@@ -965,6 +1323,9 @@ render_gfx_end_view(struct render_gfx *rr);
  * descriptor pool of @ref render_resources, both of which will be reset once
  * closed, so don't save any reference to these objects beyond the frame.
  *
+ * If @p out_mapped_data is not NULL it is set to the mapped UBO memory, this
+ * is so the timewarp matrix can be late latched, see @ref render_late_latch.
+ *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
@@ -972,6 +1333,7 @@ render_gfx_mesh_alloc_and_write(struct render_gfx *rr,
                                 const struct render_gfx_mesh_ubo_data *data,
                                 VkSampler src_sampler,
                                 VkImageView src_image_view,
+                                struct render_gfx_mesh_ubo_data **out_mapped_data,
                                 VkDescriptorSet *out_descriptor_set);
 
 /*!
@@ -1025,12 +1387,15 @@ render_gfx_layer_projection_alloc_and_write(struct render_gfx *rr,
 /*!
  * Allocate and write a UBO and descriptor_set to be used for quad layer
  * rendering, the content of @p data need to be valid at the time of the call.
+ * All @p instance_count quads sample the same image, they are drawn in order
+ * by a single @ref render_gfx_layer_quad call.
  *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_quad_alloc_and_write(struct render_gfx *rr,
                                       const struct render_gfx_layer_quad_data *data,
+                                      uint32_t instance_count,
                                       VkSampler src_sampler,
                                       VkImageView src_image_view,
                                       VkDescriptorSet *out_descriptor_set);
@@ -1067,12 +1432,16 @@ render_gfx_layer_projection(struct render_gfx *rr, bool premultiplied_alpha, VkD
 
 /*!
  * Dispatch a quad layer shader into the current target and view, allocate
- * @p descriptor_set and ubo with @ref render_gfx_layer_quad_alloc_and_write.
+ * @p descriptor_set and ubo with @ref render_gfx_layer_quad_alloc_and_write,
+ * @p instance_count must be the same as given to it.
  *
  * @public @memberof render_gfx
  */
 void
-render_gfx_layer_quad(struct render_gfx *rr, bool premultiplied_alpha, VkDescriptorSet descriptor_set);
+render_gfx_layer_quad(struct render_gfx *rr,
+                      bool premultiplied_alpha,
+                      VkDescriptorSet descriptor_set,
+                      uint32_t instance_count);
 
 /*!
  * @}
@@ -1095,7 +1464,18 @@ struct render_compute
 	//! Shared resources.
 	struct render_resources *r;
 
-	//! Layer descriptor set.
+	/*!
+	 * The command buffer being recorded into, @ref render_resources::cmd,
+	 * @ref render_resources::async_compute_cmd depending on how recording
+	 * was started, or one of the per view command buffers when recording
+	 * views on their own threads.
+	 */
+	VkCommandBuffer cmd;
+
+	//! Timewarp matrices written by the distortion pass, for late latching.
+	struct render_late_latch late_latch;
+
+	//! Layer descriptor sets, owned by @ref render_resources and kept between frames.
 	VkDescriptorSet layer_descriptor_sets[RENDER_MAX_LAYER_RUNS];
 
 	/*!
@@ -1127,11 +1507,15 @@ struct render_compute_layer_ubo_data
 	struct
 	{
 		uint32_t value;
-		uint32_t padding[3];
+
+		//! Non-zero if this run blends on top of what is already in the target.
+		uint32_t blend_on_target;
+
+		uint32_t padding[2];
 	} layer_count;
 
 	struct xrt_normalized_rect pre_transform;
-	struct xrt_normalized_rect post_transforms[RENDER_MAX_LAYERS];
+	struct xrt_normalized_rect post_transforms[RENDER_MAX_LAYERS_PER_RUN];
 
 	//! std140 uvec2, corresponds to enum xrt_layer_type and unpremultiplied alpha.
 	struct
@@ -1139,7 +1523,7 @@ struct render_compute_layer_ubo_data
 		uint32_t val;
 		uint32_t unpremultiplied;
 		uint32_t padding[2];
-	} layer_type[RENDER_MAX_LAYERS];
+	} layer_type[RENDER_MAX_LAYERS_PER_RUN];
 
 	//! Which image/sampler(s) correspond to each layer.
 	struct
@@ -1147,10 +1531,10 @@ struct render_compute_layer_ubo_data
 		uint32_t images[2];
 		//! @todo Implement separated samplers and images (and change to samplers[2])
 		uint32_t padding[2];
-	} images_samplers[RENDER_MAX_LAYERS];
+	} images_samplers[RENDER_MAX_LAYERS_PER_RUN];
 
-	//! Shared between cylinder and equirect2.
-	struct xrt_matrix_4x4 mv_inverse[RENDER_MAX_LAYERS];
+	//! Shared between cylinder, cube, equirect1 and equirect2.
+	struct xrt_matrix_4x4 mv_inverse[RENDER_MAX_LAYERS_PER_RUN];
 
 
 	/*!
@@ -1162,11 +1546,11 @@ struct render_compute_layer_ubo_data
 		float central_angle;
 		float aspect_ratio;
 		float padding;
-	} cylinder_data[RENDER_MAX_LAYERS];
+	} cylinder_data[RENDER_MAX_LAYERS_PER_RUN];
 
 
 	/*!
-	 * For equirect2 layers
+	 * For equirect2 layers, equirect1 layers use the radius.
 	 */
 	struct
 	{
@@ -1174,7 +1558,17 @@ struct render_compute_layer_ubo_data
 		float central_horizontal_angle;
 		float upper_vertical_angle;
 		float lower_vertical_angle;
-	} eq2_data[RENDER_MAX_LAYERS];
+	} eq2_data[RENDER_MAX_LAYERS_PER_RUN];
+
+
+	/*!
+	 * For equirect1 layers
+	 */
+	struct
+	{
+		struct xrt_vec2 scale;
+		struct xrt_vec2 bias;
+	} eq1_data[RENDER_MAX_LAYERS_PER_RUN];
 
 
 	/*!
@@ -1182,7 +1576,7 @@ struct render_compute_layer_ubo_data
 	 */
 
 	//! Timewarp matrices
-	struct xrt_matrix_4x4 transforms[RENDER_MAX_LAYERS];
+	struct xrt_matrix_4x4 transforms[RENDER_MAX_LAYERS_PER_RUN];
 
 
 	/*!
@@ -1194,20 +1588,65 @@ struct render_compute_layer_ubo_data
 	{
 		struct xrt_vec3 val;
 		float padding;
-	} quad_position[RENDER_MAX_LAYERS];
+	} quad_position[RENDER_MAX_LAYERS_PER_RUN];
 	struct
 	{
 		struct xrt_vec3 val;
 		float padding;
-	} quad_normal[RENDER_MAX_LAYERS];
-	struct xrt_matrix_4x4 inverse_quad_transform[RENDER_MAX_LAYERS];
+	} quad_normal[RENDER_MAX_LAYERS_PER_RUN];
+	struct xrt_matrix_4x4 inverse_quad_transform[RENDER_MAX_LAYERS_PER_RUN];
 
 	//! Quad extent in world scale
 	struct
 	{
 		struct xrt_vec2 val;
 		float padding[2];
-	} quad_extent[RENDER_MAX_LAYERS];
+	} quad_extent[RENDER_MAX_LAYERS_PER_RUN];
+
+
+	/*!
+	 * Culling.
+	 */
+
+	//! Rect in view uv space that each layer is within, tiles outside of it skip the layer.
+	struct xrt_normalized_rect view_bounds[RENDER_MAX_LAYERS_PER_RUN];
+
+
+	/*!
+	 * Foveation.
+	 */
+
+	struct
+	{
+		//! Centre of the full rate region, in view uv space.
+		struct xrt_vec2 center;
+
+		//! Radius of the full rate region, in view uv space.
+		float radius;
+
+		//! Non-zero if the view is shaded in a full and a reduced rate dispatch.
+		uint32_t enabled;
+	} foveation;
+
+
+	/*!
+	 * Visibility mask, a grid over the view in view uv space where bit x of
+	 * row y is set if that cell can't be seen through the lens. Laid out as
+	 * `uvec4[8]` in the shader, all zero if nothing is hidden.
+	 */
+	uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE];
+};
+
+/*!
+ * How to turn a value in a depth image into a distance along the view axis,
+ * see @ref xrt_layer_depth_data, laid out as a vec4 in the shader.
+ */
+struct render_depth_params
+{
+	float min_depth;
+	float depth_range;
+	float near_z;
+	float far_z;
 };
 
 /*!
@@ -1220,7 +1659,15 @@ struct render_compute_distortion_ubo_data
 	struct render_viewport_data views[2];
 	struct xrt_normalized_rect pre_transforms[2];
 	struct xrt_normalized_rect post_transforms[2];
+
+	//! For positional timewarp this only holds the source projection.
 	struct xrt_matrix_4x4 transforms[2];
+
+	//! The rest is only used by positional timewarp.
+	struct xrt_normalized_rect depth_post_transforms[2];
+	struct xrt_matrix_4x4 src_from_new[2];
+	struct xrt_matrix_4x4 new_from_src[2];
+	struct render_depth_params depth_params[2];
 };
 
 /*!
@@ -1258,10 +1705,84 @@ bool
 render_compute_end(struct render_compute *crc);
 
 /*!
- * Updates the given @p descriptor_set and dispatches the layer shader. Unlike
- * other dispatch functions below this function doesn't do any layer barriers
- * before or after dispatching, this is to allow the callee to batch any such
- * image transitions.
+ * Begin building the async compute command buffer, any commands recorded
+ * until @ref render_compute_end_async goes into
+ * @ref render_resources::async_compute_cmd. Does not write the frame
+ * timestamps, those are only on the main command buffer, the timing stages
+ * recorded into it are still measured.
+ *
+ * Must only be called if the vk_bundle has a compute queue.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_begin_async(struct render_compute *crc);
+
+/*!
+ * Ends the async compute command buffer so it can be submitted to the compute
+ * queue, after this @ref render_compute_begin needs to be called before
+ * recording anything else.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_end_async(struct render_compute *crc);
+
+/*!
+ * Can the views be recorded on their own threads, needs the worker group and
+ * @p crc to be recording into @ref render_resources::cmd, the secondary
+ * command buffers are only for the main queue family.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_can_record_views(struct render_compute *crc);
+
+/*!
+ * Begin recording the commands of @p view_index into its own secondary
+ * command buffer, @p view_crc is set up as a copy of @p crc that records into
+ * it and can be used with the render_compute functions on another thread,
+ * but only one thread per view. Finish with @ref render_compute_end_view.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_begin_view(struct render_compute *crc, uint32_t view_index, struct render_compute *view_crc);
+
+/*!
+ * Ends the secondary command buffer that @p view_crc records into.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_end_view(struct render_compute *view_crc);
+
+/*!
+ * Executes the secondary command buffers of the first @p view_count views in
+ * order from the main command buffer, all must have been ended.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_execute_views(struct render_compute *crc, uint32_t view_count);
+
+/*!
+ * Updates the given @p descriptor_set and dispatches the layer shader, the
+ * source bindings are not written again if they are the same as last time the
+ * set was used and the descriptor cache is enabled. Unlike other dispatch
+ * functions below this function doesn't do any layer barriers before or after
+ * dispatching, this is to allow the callee to batch any such image
+ * transitions.
+ *
+ * With @p do_foveation the layer shader is dispatched twice, once at full rate
+ * for the foveal blocks and once at a reduced rate for the rest, the foveation
+ * data in the UBO needs to be filled in and enabled.
+ *
+ * Cube layers are sampled from @p cube_image_views, all of which must be
+ * valid cube views, pad with @ref render_resources::mock cube.
+ *
+ * The pipeline specialised for @p mix is used, it must cover the types of all
+ * the layers in the UBO.
  *
  * Expected layouts:
  * * Source images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
@@ -1270,15 +1791,19 @@ render_compute_end(struct render_compute *crc);
  * @public @memberof render_compute
  */
 void
-render_compute_layers(struct render_compute *crc,                     //
-                      VkDescriptorSet descriptor_set,                 //
-                      VkBuffer ubo,                                   //
-                      VkSampler src_samplers[RENDER_MAX_IMAGES],      //
-                      VkImageView src_image_views[RENDER_MAX_IMAGES], //
-                      uint32_t num_srcs,                              //
-                      VkImageView target_image_view,                  //
-                      const struct render_viewport_data *view,        //
-                      bool timewarp);                                 //
+render_compute_layers(struct render_compute *crc,                           //
+                      VkDescriptorSet descriptor_set,                       //
+                      VkBuffer ubo,                                         //
+                      VkSampler src_samplers[RENDER_MAX_IMAGES],            //
+                      VkImageView src_image_views[RENDER_MAX_IMAGES],       //
+                      uint32_t num_srcs,                                    //
+                      VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES],      //
+                      VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES], //
+                      VkImageView target_image_view,                        //
+                      const struct render_viewport_data *view,              //
+                      enum render_compute_layer_mix mix,                    //
+                      bool timewarp,                                        //
+                      bool do_foveation);                                   //
 
 /*!
  * @public @memberof render_compute
@@ -1295,6 +1820,29 @@ render_compute_projection_timewarp(struct render_compute *crc,
                                    VkImageView target_image_view,
                                    const struct render_viewport_data views[2]);
 
+/*!
+ * Like @ref render_compute_projection_timewarp but also uses the depth of the
+ * source views to correct for the change in head position, not just the
+ * rotation. Done by searching along each new view ray for the surface stored
+ * in the source depth, so doesn't need any motion vectors.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_projection_positional_timewarp(struct render_compute *crc,
+                                              VkSampler src_samplers[2],
+                                              VkImageView src_image_views[2],
+                                              const struct xrt_normalized_rect src_rects[2],
+                                              VkImageView depth_image_views[2],
+                                              const struct xrt_normalized_rect depth_rects[2],
+                                              const struct render_depth_params depth_params[2],
+                                              const struct xrt_pose src_poses[2],
+                                              const struct xrt_fov src_fovs[2],
+                                              const struct xrt_pose new_poses[2],
+                                              VkImage target_image,
+                                              VkImageView target_image_view,
+                                              const struct render_viewport_data views[2]);
+
 /*!
  * @public @memberof render_compute
  */
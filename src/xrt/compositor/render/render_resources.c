@@ -9,6 +9,11 @@
  */
 
 #include "xrt/xrt_device.h"
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_debug.h"
+#include "util/u_file.h"
+#include "util/u_worker.h"
 
 #include "math/m_api.h"
 #include "math/m_matrix_2x2.h"
@@ -18,6 +23,18 @@
 
 #include "render/render_interface.h"
 
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef XRT_OS_LINUX
+#include <linux/limits.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(persistent_pipeline_cache, "XRT_COMPOSITOR_PERSISTENT_PIPELINE_CACHE", true)
+DEBUG_GET_ONCE_OPTION(pipeline_cache_dir, "XRT_COMPOSITOR_PIPELINE_CACHE_DIR", NULL)
+
 
 /*
  *
@@ -192,12 +209,13 @@ create_compute_layer_descriptor_set_layout(struct vk_bundle *vk,
                                            uint32_t src_binding,
                                            uint32_t target_binding,
                                            uint32_t ubo_binding,
+                                           uint32_t cube_binding,
                                            uint32_t source_images_count,
                                            VkDescriptorSetLayout *out_descriptor_set_layout)
 {
 	VkResult ret;
 
-	VkDescriptorSetLayoutBinding set_layout_bindings[3] = {
+	VkDescriptorSetLayoutBinding set_layout_bindings[4] = {
 	    {
 	        .binding = src_binding,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -216,6 +234,12 @@ create_compute_layer_descriptor_set_layout(struct vk_bundle *vk,
 	        .descriptorCount = 1,
 	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
 	    },
+	    {
+	        .binding = cube_binding,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .descriptorCount = RENDER_MAX_CUBE_IMAGES,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
 	};
 
 	VkDescriptorSetLayoutCreateInfo set_layout_info = {
@@ -243,11 +267,12 @@ create_compute_distortion_descriptor_set_layout(struct vk_bundle *vk,
                                                 uint32_t distortion_binding,
                                                 uint32_t target_binding,
                                                 uint32_t ubo_binding,
+                                                uint32_t depth_binding,
                                                 VkDescriptorSetLayout *out_descriptor_set_layout)
 {
 	VkResult ret;
 
-	VkDescriptorSetLayoutBinding set_layout_bindings[4] = {
+	VkDescriptorSetLayoutBinding set_layout_bindings[5] = {
 	    {
 	        .binding = src_binding,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -272,6 +297,12 @@ create_compute_distortion_descriptor_set_layout(struct vk_bundle *vk,
 	        .descriptorCount = 1,
 	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
 	    },
+	    {
+	        .binding = depth_binding,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	        .descriptorCount = 2,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
 	};
 
 	VkDescriptorSetLayoutCreateInfo set_layout_info = {
@@ -299,12 +330,15 @@ struct compute_layer_params
 	VkBool32 do_color_correction;
 	uint32_t max_layers;
 	uint32_t image_array_size;
+	uint32_t shading_rate;
+	uint32_t layer_types;
 };
 
 struct compute_distortion_params
 {
 	uint32_t distortion_texel_count;
 	VkBool32 do_timewarp;
+	VkBool32 do_positional_timewarp;
 };
 
 XRT_CHECK_RESULT static VkResult
@@ -327,6 +361,8 @@ create_compute_layer_pipeline(struct vk_bundle *vk,
 	    ENTRY(2, do_color_correction), //
 	    ENTRY(3, max_layers),          //
 	    ENTRY(4, image_array_size),    //
+	    ENTRY(5, shading_rate),        //
+	    ENTRY(6, layer_types),         //
 	};
 #undef ENTRY
 
@@ -346,6 +382,89 @@ create_compute_layer_pipeline(struct vk_bundle *vk,
 	    out_compute_pipeline);         // out_compute_pipeline
 }
 
+//! Bitmask of @ref xrt_layer_type values, the layer_types constant of the shader.
+static uint32_t
+get_layer_mix_types(enum render_compute_layer_mix mix)
+{
+	const uint32_t projection = (1u << XRT_LAYER_STEREO_PROJECTION) | (1u << XRT_LAYER_STEREO_PROJECTION_DEPTH);
+
+	switch (mix) {
+	case RENDER_COMPUTE_LAYER_MIX_PROJECTION: return projection;
+	case RENDER_COMPUTE_LAYER_MIX_PROJECTION_QUAD: return projection | (1u << XRT_LAYER_QUAD);
+	case RENDER_COMPUTE_LAYER_MIX_ALL:
+	default: return UINT32_MAX;
+	}
+}
+
+/*!
+ * Creates the full and reduced rate, with and without timewarp, pipelines of
+ * the layer squasher for one layer mix. They come out of the pipeline cache
+ * after the first run, so the extra variants don't slow down startup much.
+ */
+XRT_CHECK_RESULT static VkResult
+create_compute_layer_pipelines_for_mix(struct render_resources *r, enum render_compute_layer_mix mix)
+{
+	struct vk_bundle *vk = r->vk;
+	VkResult ret;
+
+	struct
+	{
+		bool do_timewarp;
+		uint32_t shading_rate;
+		VkPipeline *out_pipeline;
+		const char *name;
+	} variants[4] = {
+	    {
+	        false,
+	        1,
+	        &r->compute.layer.non_timewarp_pipeline[mix],
+	        "render_resources compute layer non timewarp pipeline",
+	    },
+	    {
+	        true,
+	        1,
+	        &r->compute.layer.timewarp_pipeline[mix],
+	        "render_resources compute layer timewarp pipeline",
+	    },
+	    {
+	        false,
+	        2,
+	        &r->compute.layer.reduced_rate_non_timewarp_pipeline[mix],
+	        "render_resources compute layer reduced rate non timewarp pipeline",
+	    },
+	    {
+	        true,
+	        2,
+	        &r->compute.layer.reduced_rate_timewarp_pipeline[mix],
+	        "render_resources compute layer reduced rate timewarp pipeline",
+	    },
+	};
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(variants); i++) {
+		struct compute_layer_params params = {
+		    .do_timewarp = variants[i].do_timewarp,
+		    .do_color_correction = true,
+		    .max_layers = RENDER_MAX_LAYERS_PER_RUN,
+		    .image_array_size = r->compute.layer.image_array_size,
+		    .shading_rate = variants[i].shading_rate,
+		    .layer_types = get_layer_mix_types(mix),
+		};
+
+		ret = create_compute_layer_pipeline(  //
+		    vk,                               // vk_bundle
+		    r->pipeline_cache,                // pipeline_cache
+		    r->shaders->layer_comp,           // shader
+		    r->compute.layer.pipeline_layout, // pipeline_layout
+		    &params,                          // params
+		    variants[i].out_pipeline);        // out_compute_pipeline
+		VK_CHK_AND_RET(ret, "create_compute_layer_pipeline");
+
+		VK_NAME_PIPELINE(vk, *variants[i].out_pipeline, variants[i].name);
+	}
+
+	return VK_SUCCESS;
+}
+
 XRT_CHECK_RESULT static VkResult
 create_compute_distortion_pipeline(struct vk_bundle *vk,
                                    VkPipelineCache pipeline_cache,
@@ -361,9 +480,10 @@ create_compute_distortion_pipeline(struct vk_bundle *vk,
 	    sizeof(params->FIELD),                                                                                     \
 	}
 
-	VkSpecializationMapEntry entries[2] = {
+	VkSpecializationMapEntry entries[3] = {
 	    ENTRY(0, distortion_texel_count),
 	    ENTRY(1, do_timewarp),
+	    ENTRY(2, do_positional_timewarp),
 	};
 #undef ENTRY
 
@@ -414,6 +534,75 @@ prepare_mock_image_locked(struct vk_bundle *vk, VkCommandBuffer cmd, VkImage dst
 	return VK_SUCCESS;
 }
 
+XRT_CHECK_RESULT static VkResult
+create_mock_cube_image(
+    struct vk_bundle *vk, VkFormat format, VkDeviceMemory *out_mem, VkImage *out_image, VkImageView *out_view)
+{
+	VkResult ret;
+
+	VkImageCreateInfo image_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = format,
+	    .extent = {1, 1, 1},
+	    .mipLevels = 1,
+	    .arrayLayers = 6,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_OPTIMAL,
+	    .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	VkImage image = VK_NULL_HANDLE;
+	ret = vk->vkCreateImage(vk->device, &image_info, NULL, &image);
+	VK_CHK_AND_RET(ret, "vkCreateImage");
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	ret = vk_alloc_and_bind_image_memory( //
+	    vk,                               // vk_bundle
+	    image,                            // image
+	    SIZE_MAX,                         // max_size
+	    NULL,                             // pNext_for_allocate
+	    __func__,                         // caller_name
+	    &memory,                          // out_mem
+	    NULL);                            // out_size
+	if (ret != VK_SUCCESS) {
+		vk->vkDestroyImage(vk->device, image, NULL);
+		return ret;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 6,
+	};
+
+	VkImageView view = VK_NULL_HANDLE;
+	ret = vk_create_view(        //
+	    vk,                      // vk_bundle
+	    image,                   // image
+	    VK_IMAGE_VIEW_TYPE_CUBE, // type
+	    format,                  // format
+	    subresource_range,       // subresource_range
+	    &view);                  // out_view
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_view: %s", vk_result_string(ret));
+		vk->vkDestroyImage(vk->device, image, NULL);
+		vk->vkFreeMemory(vk->device, memory, NULL);
+		return ret;
+	}
+
+	*out_mem = memory;
+	*out_image = image;
+	*out_view = view;
+
+	return VK_SUCCESS;
+}
+
 
 /*
  *
@@ -505,6 +694,109 @@ teardown_scratch_color_image(struct vk_bundle *vk, struct render_scratch_color_i
 }
 
 
+/*
+ *
+ * Pipeline cache.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+/*!
+ * The cache is stored per device and driver, so machines with more than one
+ * GPU, or a driver update, don't throw away each other's caches.
+ */
+static void
+get_pipeline_cache_filename(struct vk_bundle *vk, const char *suffix, char *out_name, size_t out_name_size)
+{
+	VkPhysicalDeviceProperties props;
+	vk->vkGetPhysicalDeviceProperties(vk->physical_device, &props);
+
+	char uuid[VK_UUID_SIZE * 2 + 1];
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+		snprintf(uuid + i * 2, 3, "%02x", props.pipelineCacheUUID[i]);
+	}
+
+	snprintf(out_name, out_name_size, "pipeline_cache_%04x_%04x_%s.bin%s", props.vendorID, props.deviceID, uuid,
+	         suffix);
+}
+
+static bool
+get_pipeline_cache_path(struct vk_bundle *vk, const char *suffix, char *out_path, size_t out_path_size)
+{
+	char dir[PATH_MAX];
+	const char *dir_override = debug_get_option_pipeline_cache_dir();
+	ssize_t len;
+	if (dir_override != NULL) {
+		len = snprintf(dir, sizeof(dir), "%s", dir_override);
+	} else {
+		len = u_file_get_cache_dir(dir, sizeof(dir));
+	}
+	if (len <= 0 || len >= (ssize_t)sizeof(dir)) {
+		return false;
+	}
+
+	char name[128];
+	get_pipeline_cache_filename(vk, suffix, name, sizeof(name));
+
+	len = snprintf(out_path, out_path_size, "%s/%s", dir, name);
+
+	return len > 0 && len < (ssize_t)out_path_size;
+}
+#endif
+
+/*!
+ * Creates the pipeline cache, seeded from the one saved by the last run so
+ * that pipelines don't have to be compiled again on every start.
+ */
+XRT_CHECK_RESULT static VkResult
+create_pipeline_cache(struct render_resources *r)
+{
+	struct vk_bundle *vk = r->vk;
+
+	r->pipeline_cache_saved_size = 0;
+
+#ifdef XRT_OS_LINUX
+	char path[PATH_MAX + 64];
+	if (!debug_get_bool_option_persistent_pipeline_cache() ||
+	    !get_pipeline_cache_path(vk, "", path, sizeof(path))) {
+		return vk_create_pipeline_cache(vk, &r->pipeline_cache);
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return vk_create_pipeline_cache(vk, &r->pipeline_cache);
+	}
+
+	void *data = NULL;
+	size_t size = 0;
+
+	fseek(file, 0L, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0L, SEEK_SET);
+
+	if (file_size > 0) {
+		data = malloc((size_t)file_size);
+		if (data != NULL && fread(data, 1, (size_t)file_size, file) == (size_t)file_size) {
+			size = (size_t)file_size;
+		}
+	}
+	fclose(file);
+
+	VkResult ret = vk_create_pipeline_cache_with_data(vk, data, size, &r->pipeline_cache);
+	free(data);
+
+	if (ret == VK_SUCCESS) {
+		VK_DEBUG(vk, "Loaded %u bytes of pipeline cache from '%s'", (uint32_t)size, path);
+		r->pipeline_cache_saved_size = size;
+	}
+
+	return ret;
+#else
+	return vk_create_pipeline_cache(vk, &r->pipeline_cache);
+#endif
+}
+
+
 /*
  *
  * 'Exported' renderer functions.
@@ -547,8 +839,11 @@ render_resources_init(struct render_resources *r,
 	r->compute.distortion_binding = 1;
 	r->compute.target_binding = 2;
 	r->compute.ubo_binding = 3;
+	r->compute.depth_binding = 4;
+	r->compute.cube_binding = 5;
 
-	r->compute.layer.image_array_size = vk->features.max_per_stage_descriptor_sampled_images;
+	// The cube map sources share the per stage limit, which is at least 16.
+	r->compute.layer.image_array_size = vk->features.max_per_stage_descriptor_sampled_images - RENDER_MAX_CUBE_IMAGES;
 	if (r->compute.layer.image_array_size > RENDER_MAX_IMAGES) {
 		r->compute.layer.image_array_size = RENDER_MAX_IMAGES;
 	}
@@ -595,8 +890,9 @@ render_resources_init(struct render_resources *r,
 	 * Command buffer pool, needs to go first.
 	 */
 
-	ret = vk_cmd_pool_init(vk, &r->distortion_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
-	VK_CHK_WITH_RET(ret, "vk_cmd_pool_init", false);
+	// Uploads are waited on before use, so they can go on the transfer queue.
+	ret = vk_cmd_pool_init_transfer(vk, &r->distortion_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	VK_CHK_WITH_RET(ret, "vk_cmd_pool_init_transfer", false);
 
 	VK_NAME_COMMAND_POOL(vk, r->distortion_pool.pool, "render_resources distortion command pool");
 
@@ -611,6 +907,13 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_COMMAND_POOL(vk, r->cmd_pool, "render_resources command pool");
 
+	if (vk->compute_queue != VK_NULL_HANDLE) {
+		ret = vk->vkCreateCommandPool(vk->device, &command_pool_info, NULL, &r->async_compute_cmd_pool);
+		VK_CHK_WITH_RET(ret, "vkCreateCommandPool", false);
+
+		VK_NAME_COMMAND_POOL(vk, r->async_compute_cmd_pool, "render_resources async compute command pool");
+	}
+
 
 	/*
 	 * Mock, used as a default image empty image.
@@ -652,6 +955,18 @@ render_resources_init(struct render_resources *r,
 
 		VK_NAME_IMAGE_VIEW(vk, r->mock.color.image_view, "render_resources mock color image view");
 
+		ret = create_mock_cube_image(  //
+		    vk,                        // vk_bundle
+		    format,                    // format
+		    &r->mock.cube.memory,      // out_mem
+		    &r->mock.cube.image,       // out_image
+		    &r->mock.cube.image_view); // out_view
+		VK_CHK_WITH_RET(ret, "create_mock_cube_image", false);
+
+		VK_NAME_DEVICE_MEMORY(vk, r->mock.cube.memory, "render_resources mock cube device memory");
+		VK_NAME_IMAGE(vk, r->mock.cube.image, "render_resources mock cube image");
+		VK_NAME_IMAGE_VIEW(vk, r->mock.cube.image_view, "render_resources mock cube image view");
+
 
 		VkCommandBuffer cmd = VK_NULL_HANDLE;
 		ret = vk_cmd_create_and_begin_cmd_buffer_locked(vk, r->cmd_pool, 0, &cmd);
@@ -665,6 +980,12 @@ render_resources_init(struct render_resources *r,
 		    r->mock.color.image);        // dst
 		VK_CHK_WITH_RET(ret, "prepare_mock_image_locked", false);
 
+		ret = prepare_mock_image_locked( //
+		    vk,                          // vk_bundle
+		    cmd,                         // cmd
+		    r->mock.cube.image);         // dst
+		VK_CHK_WITH_RET(ret, "prepare_mock_image_locked", false);
+
 		ret = vk_cmd_end_submit_wait_and_free_cmd_buffer_locked(vk, r->cmd_pool, cmd);
 		VK_CHK_WITH_RET(ret, "vk_cmd_end_submit_wait_and_free_cmd_buffer_locked", false);
 
@@ -676,8 +997,8 @@ render_resources_init(struct render_resources *r,
 	 * Shared
 	 */
 
-	ret = vk_create_pipeline_cache(vk, &r->pipeline_cache);
-	VK_CHK_WITH_RET(ret, "vk_create_pipeline_cache", false);
+	ret = create_pipeline_cache(r);
+	VK_CHK_WITH_RET(ret, "create_pipeline_cache", false);
 
 	VK_NAME_PIPELINE_CACHE(vk, r->pipeline_cache, "render_resources pipeline cache");
 
@@ -696,14 +1017,59 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_COMMAND_BUFFER(vk, r->cmd, "render_resources command buffer");
 
+	if (r->async_compute_cmd_pool != VK_NULL_HANDLE) {
+		VkCommandBufferAllocateInfo async_cmd_buffer_info = {
+		    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		    .commandPool = r->async_compute_cmd_pool,
+		    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		    .commandBufferCount = 1,
+		};
+
+		ret = vk->vkAllocateCommandBuffers( //
+		    vk->device,                     // device
+		    &async_cmd_buffer_info,         // pAllocateInfo
+		    &r->async_compute_cmd);         // pCommandBuffers
+		VK_CHK_WITH_RET(ret, "vkAllocateCommandBuffers", false);
+
+		VK_NAME_COMMAND_BUFFER(vk, r->async_compute_cmd, "render_resources async compute command buffer");
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->view_record.pools); i++) {
+		ret = vk_cmd_pool_init(vk, &r->view_record.pools[i], VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		VK_CHK_WITH_RET(ret, "vk_cmd_pool_init", false);
+
+		VK_NAME_COMMAND_POOL(vk, r->view_record.pools[i].pool, "render_resources view record command pool");
+
+		VkCommandBufferAllocateInfo view_cmd_buffer_info = {
+		    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		    .commandPool = r->view_record.pools[i].pool,
+		    .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+		    .commandBufferCount = 1,
+		};
+
+		ret = vk->vkAllocateCommandBuffers( //
+		    vk->device,                     // device
+		    &view_cmd_buffer_info,          // pAllocateInfo
+		    &r->view_record.cmds[i]);       // pCommandBuffers
+		VK_CHK_WITH_RET(ret, "vkAllocateCommandBuffers", false);
+
+		VK_NAME_COMMAND_BUFFER(vk, r->view_record.cmds[i], "render_resources view record command buffer");
+	}
+
+	// The compositor thread records one view itself while waiting, not fatal if missing.
+	r->view_record.thread_pool = u_worker_thread_pool_create(1, ARRAY_SIZE(r->view_record.pools), "View record");
+	if (r->view_record.thread_pool != NULL) {
+		r->view_record.group = u_worker_group_create(r->view_record.thread_pool);
+	}
+
 
 	/*
 	 * Gfx.
 	 */
 
 	{
-		// Number of layer shader runs (views) times number of layers.
-		const uint32_t layer_shader_count = RENDER_MAX_LAYER_RUNS * RENDER_MAX_LAYERS;
+		// Number of views times number of layers, each layer is drawn once per view.
+		const uint32_t layer_shader_count = 2 * RENDER_MAX_LAYERS;
 
 		// Two mesh distortion runs.
 		const uint32_t mesh_shader_count = 2;
@@ -726,15 +1092,33 @@ render_resources_init(struct render_resources *r,
 		VK_NAME_DESCRIPTOR_POOL(vk, r->gfx.ubo_and_src_descriptor_pool,
 		                        "render_resources ubo and src descriptor pool");
 
+		struct vk_descriptor_pool_info cache_pool_info = mesh_pool_info;
+		cache_pool_info.descriptor_count = RENDER_GFX_DESCRIPTOR_CACHE_SIZE;
+
+		ret = vk_create_descriptor_pool(               //
+		    vk,                                        // vk_bundle
+		    &cache_pool_info,                          // info
+		    &r->gfx.descriptor_cache.descriptor_pool); // out_descriptor_pool
+		VK_CHK_WITH_RET(ret, "vk_create_descriptor_pool", false);
+
+		VK_NAME_DESCRIPTOR_POOL(vk, r->gfx.descriptor_cache.descriptor_pool,
+		                        "render_resources gfx descriptor cache pool");
+
 		VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 		VkMemoryPropertyFlags memory_property_flags = //
 		    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |    //
 		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;      //
 
+		const VkDeviceSize alignment = RENDER_ALWAYS_SAFE_UBO_ALIGNMENT;
+
+		// Quad UBOs hold up to all instances and are the largest, assume every layer could be one.
+		const VkDeviceSize quad_ubo_size = sizeof(struct render_gfx_layer_quad_ubo_data);
+		const uint32_t slots_per_layer = (uint32_t)((quad_ubo_size + alignment - 1) / alignment);
+
 		uint32_t buffer_count = 0;
 
 		// One UBO per layer shader.
-		buffer_count += layer_shader_count;
+		buffer_count += layer_shader_count * slots_per_layer;
 
 		// One UBO per mesh shader.
 		buffer_count += 2;
@@ -743,7 +1127,7 @@ render_resources_init(struct render_resources *r,
 		static_assert(sizeof(struct render_gfx_mesh_ubo_data) <= RENDER_ALWAYS_SAFE_UBO_ALIGNMENT, "MAX");
 
 		// Calculate size.
-		VkDeviceSize size = buffer_count * RENDER_ALWAYS_SAFE_UBO_ALIGNMENT;
+		VkDeviceSize size = buffer_count * alignment;
 
 		ret = render_buffer_init(  //
 		    vk,                    // vk_bundle
@@ -836,14 +1220,14 @@ render_resources_init(struct render_resources *r,
 	VkMemoryPropertyFlags memory_property_flags =
 	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
+	// The layer shader runs have their own pool, see below.
 	const uint32_t compute_descriptor_count = //
-	    1 +                                   // Shared/distortion run(s).
-	    RENDER_MAX_LAYER_RUNS;                // Layer shader run(s).
+	    1;                                    // Shared/distortion run(s).
 
 	struct vk_descriptor_pool_info compute_pool_info = {
 	    .uniform_per_descriptor_count = 1,
 	    // layer images
-	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + 6,
+	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + RENDER_MAX_CUBE_IMAGES + 6,
 	    .storage_image_per_descriptor_count = 1,
 	    .storage_buffer_per_descriptor_count = 0,
 	    .descriptor_count = compute_descriptor_count,
@@ -867,6 +1251,7 @@ render_resources_init(struct render_resources *r,
 	    r->compute.src_binding,                       // src_binding,
 	    r->compute.target_binding,                    // target_binding,
 	    r->compute.ubo_binding,                       // ubo_binding,
+	    r->compute.cube_binding,                      // cube_binding,
 	    r->compute.layer.image_array_size,            // source_images_count,
 	    &r->compute.layer.descriptor_set_layout);     // out_descriptor_set_layout
 	VK_CHK_WITH_RET(ret, "create_compute_layer_descriptor_set_layout", false);
@@ -882,42 +1267,33 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_PIPELINE_LAYOUT(vk, r->compute.layer.pipeline_layout, "render_resources compute layer pipeline layout");
 
-	struct compute_layer_params layer_params = {
-	    .do_timewarp = false,
-	    .do_color_correction = true,
-	    .max_layers = RENDER_MAX_LAYERS,
-	    .image_array_size = r->compute.layer.image_array_size,
-	};
+	struct vk_descriptor_pool_info layer_pool_info = compute_pool_info;
+	layer_pool_info.descriptor_count = RENDER_MAX_LAYER_RUNS;
 
-	ret = create_compute_layer_pipeline(          //
-	    vk,                                       // vk_bundle
-	    r->pipeline_cache,                        // pipeline_cache
-	    r->shaders->layer_comp,                   // shader
-	    r->compute.layer.pipeline_layout,         // pipeline_layout
-	    &layer_params,                            // params
-	    &r->compute.layer.non_timewarp_pipeline); // out_compute_pipeline
-	VK_CHK_WITH_RET(ret, "create_compute_layer_pipeline", false);
+	ret = vk_create_descriptor_pool(        //
+	    vk,                                 // vk_bundle
+	    &layer_pool_info,                   // info
+	    &r->compute.layer.descriptor_pool); // out_descriptor_pool
+	VK_CHK_WITH_RET(ret, "vk_create_descriptor_pool", false);
 
-	VK_NAME_PIPELINE(vk, r->compute.layer.non_timewarp_pipeline,
-	                 "render_resources compute layer non timewarp pipeline");
+	VK_NAME_DESCRIPTOR_POOL(vk, r->compute.layer.descriptor_pool, "render_resources compute layer descriptor pool");
 
-	struct compute_layer_params layer_timewarp_params = {
-	    .do_timewarp = true,
-	    .do_color_correction = true,
-	    .max_layers = RENDER_MAX_LAYERS,
-	    .image_array_size = r->compute.layer.image_array_size,
-	};
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->compute.layer.descriptor_sets); i++) {
+		ret = vk_create_descriptor_set(             //
+		    vk,                                     // vk_bundle
+		    r->compute.layer.descriptor_pool,       // descriptor_pool
+		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
+		    &r->compute.layer.descriptor_sets[i]);  // descriptor_set
+		VK_CHK_WITH_RET(ret, "vk_create_descriptor_set", false);
 
-	ret = create_compute_layer_pipeline(      //
-	    vk,                                   // vk_bundle
-	    r->pipeline_cache,                    // pipeline_cache
-	    r->shaders->layer_comp,               // shader
-	    r->compute.layer.pipeline_layout,     // pipeline_layout
-	    &layer_timewarp_params,               // params
-	    &r->compute.layer.timewarp_pipeline); // out_compute_pipeline
-	VK_CHK_WITH_RET(ret, "create_compute_layer_pipeline", false);
+		VK_NAME_DESCRIPTOR_SET(vk, r->compute.layer.descriptor_sets[i],
+		                       "render_resources compute layer descriptor set");
+	}
 
-	VK_NAME_PIPELINE(vk, r->compute.layer.timewarp_pipeline, "render_resources compute layer timewarp pipeline");
+	for (uint32_t mix = 0; mix < RENDER_COMPUTE_LAYER_MIX_COUNT; mix++) {
+		ret = create_compute_layer_pipelines_for_mix(r, (enum render_compute_layer_mix)mix);
+		VK_CHK_WITH_RET(ret, "create_compute_layer_pipelines_for_mix", false);
+	}
 
 	size_t layer_ubo_size = sizeof(struct render_compute_layer_ubo_data);
 
@@ -948,6 +1324,7 @@ render_resources_init(struct render_resources *r,
 	    r->compute.distortion_binding,                     // distortion_binding,
 	    r->compute.target_binding,                         // target_binding,
 	    r->compute.ubo_binding,                            // ubo_binding,
+	    r->compute.depth_binding,                          // depth_binding,
 	    &r->compute.distortion.descriptor_set_layout);     // out_descriptor_set_layout
 	VK_CHK_WITH_RET(ret, "create_compute_distortion_descriptor_set_layout", false);
 
@@ -963,8 +1340,12 @@ render_resources_init(struct render_resources *r,
 	VK_NAME_PIPELINE_LAYOUT(vk, r->compute.distortion.pipeline_layout,
 	                        "render_resources compute distortion pipeline layout");
 
+	// Needed by the pipelines, the images are created later.
+	r->distortion.texel_count = render_distortion_calc_texel_count(xdev);
+	VK_INFO(vk, "Distortion images are %ux%u", r->distortion.texel_count, r->distortion.texel_count);
+
 	struct compute_distortion_params distortion_params = {
-	    .distortion_texel_count = RENDER_DISTORTION_IMAGE_DIMENSIONS,
+	    .distortion_texel_count = r->distortion.texel_count,
 	    .do_timewarp = false,
 	};
 
@@ -980,7 +1361,7 @@ render_resources_init(struct render_resources *r,
 	VK_NAME_PIPELINE(vk, r->compute.distortion.pipeline, "render_resources compute distortion pipeline");
 
 	struct compute_distortion_params distortion_timewarp_params = {
-	    .distortion_texel_count = RENDER_DISTORTION_IMAGE_DIMENSIONS,
+	    .distortion_texel_count = r->distortion.texel_count,
 	    .do_timewarp = true,
 	};
 
@@ -996,6 +1377,24 @@ render_resources_init(struct render_resources *r,
 	VK_NAME_PIPELINE(vk, r->compute.distortion.timewarp_pipeline,
 	                 "render_resources compute distortion timewarp pipeline");
 
+	struct compute_distortion_params distortion_positional_timewarp_params = {
+	    .distortion_texel_count = r->distortion.texel_count,
+	    .do_timewarp = true,
+	    .do_positional_timewarp = true,
+	};
+
+	ret = create_compute_distortion_pipeline(                 //
+	    vk,                                                   // vk_bundle
+	    r->pipeline_cache,                                    // pipeline_cache
+	    r->shaders->distortion_comp,                          // shader
+	    r->compute.distortion.pipeline_layout,                // pipeline_layout
+	    &distortion_positional_timewarp_params,               // params
+	    &r->compute.distortion.positional_timewarp_pipeline); // out_compute_pipeline
+	VK_CHK_WITH_RET(ret, "create_compute_distortion_pipeline", false);
+
+	VK_NAME_PIPELINE(vk, r->compute.distortion.positional_timewarp_pipeline,
+	                 "render_resources compute distortion positional timewarp pipeline");
+
 	size_t distortion_ubo_size = sizeof(struct render_compute_distortion_ubo_data);
 
 	ret = render_buffer_init(       //
@@ -1068,8 +1467,8 @@ render_resources_init(struct render_resources *r,
 	    .pNext = NULL,
 	    .flags = 0, // Reserved.
 	    .queryType = VK_QUERY_TYPE_TIMESTAMP,
-	    .queryCount = 2,         // Start & end
-	    .pipelineStatistics = 0, // Not used.
+	    .queryCount = RENDER_TIMING_STAGE_COUNT * 2, // Start & end per stage
+	    .pipelineStatistics = 0,                     // Not used.
 	};
 
 	vk->vkCreateQueryPool( //
@@ -1080,6 +1479,9 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_QUERY_POOL(vk, r->query_pool, "render_resources query pool");
 
+	// All of the compute pipelines have been created now.
+	render_resources_save_pipeline_cache(r);
+
 	/*
 	 * Done
 	 */
@@ -1089,6 +1491,77 @@ render_resources_init(struct render_resources *r,
 	return true;
 }
 
+void
+render_resources_save_pipeline_cache(struct render_resources *r)
+{
+#ifdef XRT_OS_LINUX
+	struct vk_bundle *vk = r->vk;
+
+	if (r->pipeline_cache == VK_NULL_HANDLE || !debug_get_bool_option_persistent_pipeline_cache()) {
+		return;
+	}
+
+	size_t size = 0;
+	VkResult ret = vk->vkGetPipelineCacheData(vk->device, r->pipeline_cache, &size, NULL);
+	if (ret != VK_SUCCESS || size == 0) {
+		return;
+	}
+
+	// Pipelines are only ever added, same size means nothing new.
+	if (size == r->pipeline_cache_saved_size) {
+		return;
+	}
+
+	char path[PATH_MAX + 64];
+	char tmp_path[PATH_MAX + 64];
+	if (!get_pipeline_cache_path(vk, "", path, sizeof(path)) ||
+	    !get_pipeline_cache_path(vk, ".tmp", tmp_path, sizeof(tmp_path))) {
+		return;
+	}
+
+	void *data = malloc(size);
+	if (data == NULL) {
+		return;
+	}
+
+	ret = vk->vkGetPipelineCacheData(vk->device, r->pipeline_cache, &size, data);
+	if (ret != VK_SUCCESS) {
+		VK_WARN(vk, "vkGetPipelineCacheData: %s", vk_result_string(ret));
+		free(data);
+		return;
+	}
+
+	// Written to a temporary file so a starting service never reads half a cache.
+	FILE *file = NULL;
+	if (debug_get_option_pipeline_cache_dir() == NULL) {
+		// Creates the default cache directory if needed.
+		char tmp_name[128];
+		get_pipeline_cache_filename(vk, ".tmp", tmp_name, sizeof(tmp_name));
+		file = u_file_open_file_in_cache_dir(tmp_name, "wb");
+	} else {
+		file = fopen(tmp_path, "wb");
+	}
+	if (file == NULL) {
+		VK_WARN(vk, "Failed to open '%s' for writing", tmp_path);
+		free(data);
+		return;
+	}
+
+	bool written = fwrite(data, 1, size, file) == size;
+	written = fclose(file) == 0 && written;
+	free(data);
+
+	if (!written || rename(tmp_path, path) != 0) {
+		VK_WARN(vk, "Failed to write pipeline cache to '%s'", path);
+		remove(tmp_path);
+		return;
+	}
+
+	VK_DEBUG(vk, "Saved %u bytes of pipeline cache to '%s'", (uint32_t)size, path);
+	r->pipeline_cache_saved_size = size;
+#endif
+}
+
 void
 render_resources_close(struct render_resources *r)
 {
@@ -1108,14 +1581,20 @@ render_resources_close(struct render_resources *r)
 	D(Image, r->mock.color.image);
 	DF(Memory, r->mock.color.memory);
 
+	D(ImageView, r->mock.cube.image_view);
+	D(Image, r->mock.cube.image);
+	DF(Memory, r->mock.cube.memory);
+
 	render_buffer_close(vk, &r->gfx.shared_ubo);
 	D(DescriptorPool, r->gfx.ubo_and_src_descriptor_pool);
+	D(DescriptorPool, r->gfx.descriptor_cache.descriptor_pool);
 
 	D(DescriptorSetLayout, r->gfx.layer.shared.descriptor_set_layout);
 	D(PipelineLayout, r->gfx.layer.shared.pipeline_layout);
 
 	D(DescriptorSetLayout, r->mesh.descriptor_set_layout);
 	D(PipelineLayout, r->mesh.pipeline_layout);
+	render_resources_save_pipeline_cache(r);
 	D(PipelineCache, r->pipeline_cache);
 	D(QueryPool, r->query_pool);
 	render_buffer_close(vk, &r->mesh.vbo);
@@ -1124,15 +1603,21 @@ render_resources_close(struct render_resources *r)
 	render_buffer_close(vk, &r->mesh.ubos[1]);
 
 	D(DescriptorPool, r->compute.descriptor_pool);
+	D(DescriptorPool, r->compute.layer.descriptor_pool);
 
 	D(DescriptorSetLayout, r->compute.layer.descriptor_set_layout);
-	D(Pipeline, r->compute.layer.non_timewarp_pipeline);
-	D(Pipeline, r->compute.layer.timewarp_pipeline);
+	for (uint32_t i = 0; i < RENDER_COMPUTE_LAYER_MIX_COUNT; i++) {
+		D(Pipeline, r->compute.layer.non_timewarp_pipeline[i]);
+		D(Pipeline, r->compute.layer.timewarp_pipeline[i]);
+		D(Pipeline, r->compute.layer.reduced_rate_non_timewarp_pipeline[i]);
+		D(Pipeline, r->compute.layer.reduced_rate_timewarp_pipeline[i]);
+	}
 	D(PipelineLayout, r->compute.layer.pipeline_layout);
 
 	D(DescriptorSetLayout, r->compute.distortion.descriptor_set_layout);
 	D(Pipeline, r->compute.distortion.pipeline);
 	D(Pipeline, r->compute.distortion.timewarp_pipeline);
+	D(Pipeline, r->compute.distortion.positional_timewarp_pipeline);
 	D(PipelineLayout, r->compute.distortion.pipeline_layout);
 
 	D(Pipeline, r->compute.clear.pipeline);
@@ -1144,7 +1629,15 @@ render_resources_close(struct render_resources *r)
 	}
 	render_buffer_close(vk, &r->compute.distortion.ubo);
 
+	u_worker_group_reference(&r->view_record.group, NULL);
+	u_worker_thread_pool_reference(&r->view_record.thread_pool, NULL);
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->view_record.pools); i++) {
+		// Frees the command buffers as well.
+		vk_cmd_pool_destroy(vk, &r->view_record.pools[i]);
+		r->view_record.cmds[i] = VK_NULL_HANDLE;
+	}
 	vk_cmd_pool_destroy(vk, &r->distortion_pool);
+	D(CommandPool, r->async_compute_cmd_pool);
 	D(CommandPool, r->cmd_pool);
 
 	// Finally forget about the vk bundle. We do not own it!
@@ -1242,6 +1735,115 @@ render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_dura
 	return true;
 }
 
+void
+render_resources_begin_timing_stage(struct render_resources *r, VkCommandBuffer cmd, enum render_timing_stage stage)
+{
+	struct vk_bundle *vk = r->vk;
+
+	assert(stage != RENDER_TIMING_STAGE_FRAME && stage < RENDER_TIMING_STAGE_COUNT);
+
+	vk->vkCmdResetQueryPool( //
+	    cmd,                 // commandBuffer
+	    r->query_pool,       // queryPool
+	    stage * 2,           // firstQuery
+	    2);                  // queryCount
+
+	r->timing_stages_recorded |= 1u << stage;
+
+	vk->vkCmdWriteTimestamp(               //
+	    cmd,                               // commandBuffer
+	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
+	    r->query_pool,                     // queryPool
+	    stage * 2);                        // query
+}
+
+void
+render_resources_end_timing_stage(struct render_resources *r, VkCommandBuffer cmd, enum render_timing_stage stage)
+{
+	struct vk_bundle *vk = r->vk;
+
+	assert(stage != RENDER_TIMING_STAGE_FRAME && stage < RENDER_TIMING_STAGE_COUNT);
+
+	vk->vkCmdWriteTimestamp(                  //
+	    cmd,                                  // commandBuffer
+	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
+	    r->query_pool,                        // queryPool
+	    stage * 2 + 1);                       // query
+}
+
+bool
+render_resources_get_stage_durations(struct render_resources *r,
+                                     uint64_t out_durations_ns[RENDER_TIMING_STAGE_COUNT])
+{
+	struct vk_bundle *vk = r->vk;
+	VkResult ret = VK_SUCCESS;
+
+	// Only what has been recorded since the last call.
+	uint32_t recorded = r->timing_stages_recorded;
+	r->timing_stages_recorded = 0;
+
+	for (uint32_t i = 0; i < RENDER_TIMING_STAGE_COUNT; i++) {
+		out_durations_ns[i] = 0;
+
+		if ((recorded & (1u << i)) == 0) {
+			continue;
+		}
+
+		/*
+		 * If the submit failed the queries were reset but never written,
+		 * so use the availability rather than waiting on them.
+		 */
+		VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+		// Value and availability for start and end.
+		uint64_t data[2][2] = {0};
+
+		ret = vk->vkGetQueryPoolResults( //
+		    vk->device,                  // device
+		    r->query_pool,               // queryPool
+		    i * 2,                       // firstQuery
+		    2,                           // queryCount
+		    sizeof(data),                // dataSize
+		    data,                        // pData
+		    sizeof(data[0]),             // stride
+		    flags);                      // flags
+
+		if (ret != VK_SUCCESS && ret != VK_NOT_READY) {
+			return false;
+		}
+
+		if (data[0][1] == 0 || data[1][1] == 0 || data[1][0] < data[0][0]) {
+			continue;
+		}
+
+		double duration_ticks = (double)(data[1][0] - data[0][0]);
+		out_durations_ns[i] = (uint64_t)(duration_ticks * vk->features.timestamp_period);
+	}
+
+	return true;
+}
+
+void
+render_resources_flush_descriptor_cache(struct render_resources *r)
+{
+	struct vk_bundle *vk = r->vk;
+	struct render_gfx_descriptor_cache *cache = &r->gfx.descriptor_cache;
+
+	// The sets themselves are kept, they are written again on next use.
+	U_ZERO_ARRAY(r->compute.layer.written);
+
+	if (cache->count == 0) {
+		return;
+	}
+
+	vk->vkResetDescriptorPool(  //
+	    vk->device,             //
+	    cache->descriptor_pool, //
+	    0);                     //
+
+	U_ZERO_ARRAY(cache->entries);
+	cache->count = 0;
+}
 
 /*
  *
@@ -29,6 +29,7 @@
 #include "shaders/clear.comp.h"
 #include "shaders/layer.comp.h"
 #include "shaders/distortion.comp.h"
+#include "shaders/distortion_generate.comp.h"
 #include "shaders/layer_cylinder.frag.h"
 #include "shaders/layer_cylinder.vert.h"
 #include "shaders/layer_equirect2.frag.h"
@@ -108,6 +109,7 @@ render_shaders_load(struct render_shaders *s, struct vk_bundle *vk)
 	LOAD(layer_comp);
 
 	LOAD(distortion_comp);
+	LOAD(distortion_generate_comp);
 
 	LOAD(mesh_vert);
 	LOAD(mesh_frag);
@@ -131,6 +133,7 @@ render_shaders_close(struct render_shaders *s, struct vk_bundle *vk)
 	D(ShaderModule, s->blit_comp);
 	D(ShaderModule, s->clear_comp);
 	D(ShaderModule, s->distortion_comp);
+	D(ShaderModule, s->distortion_generate_comp);
 	D(ShaderModule, s->layer_comp);
 	D(ShaderModule, s->mesh_vert);
 	D(ShaderModule, s->mesh_frag);
@@ -10,8 +10,12 @@
 #include "math/m_api.h"
 #include "math/m_matrix_4x4_f64.h"
 
+#include "util/u_misc.h"
+
 #include "render/render_interface.h"
 
+#include <assert.h>
+
 
 /*!
  * Create a simplified projection matrix for timewarp.
@@ -123,6 +127,32 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
 	}
 }
 
+void
+render_calc_positional_time_warp_matrices(const struct xrt_pose *src_pose,
+                                          const struct xrt_fov *src_fov,
+                                          const struct xrt_pose *new_pose,
+                                          struct xrt_matrix_4x4 *out_projection,
+                                          struct xrt_matrix_4x4 *out_src_from_new,
+                                          struct xrt_matrix_4x4 *out_new_from_src)
+{
+	// Src projection matrix, same as for rotation only timewarp.
+	struct xrt_matrix_4x4_f64 src_proj;
+	calc_projection(src_fov, &src_proj);
+
+	// Convert from f64 to f32.
+	for (int i = 0; i < 16; i++) {
+		out_projection->v[i] = (float)src_proj.v[i];
+	}
+
+	// Full poses this time, position included.
+	struct xrt_matrix_4x4 src_view, new_model;
+	math_matrix_4x4_view_from_pose(src_pose, &src_view);
+	math_matrix_4x4_isometry_from_pose(new_pose, &new_model);
+
+	math_matrix_4x4_multiply(&src_view, &new_model, out_src_from_new);
+	math_matrix_4x4_isometry_inverse(out_src_from_new, out_new_from_src);
+}
+
 void
 render_calc_uv_to_tangent_lengths_rect(const struct xrt_fov *fov, struct xrt_normalized_rect *out_rect)
 {
@@ -157,3 +187,42 @@ render_calc_uv_to_tangent_lengths_rect(const struct xrt_fov *fov, struct xrt_nor
 
 	*out_rect = transform;
 }
+
+void
+render_late_latch_set_view(struct render_late_latch *rll,
+                           uint32_t view_index,
+                           const struct xrt_pose *src_pose,
+                           const struct xrt_fov *src_fov,
+                           struct xrt_matrix_4x4 *transform)
+{
+	assert(view_index < ARRAY_SIZE(rll->views));
+
+	rll->views[view_index].src_pose = *src_pose;
+	rll->views[view_index].src_fov = *src_fov;
+	rll->views[view_index].transform = transform;
+}
+
+bool
+render_late_latch_update(const struct render_late_latch *rll, const struct xrt_pose new_poses[2])
+{
+	bool latched = false;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(rll->views); i++) {
+		if (rll->views[i].transform == NULL) {
+			continue;
+		}
+
+		// Calculate on the stack, only write the final result to the mapped memory.
+		struct xrt_matrix_4x4 matrix;
+		render_calc_time_warp_matrix( //
+		    &rll->views[i].src_pose,  //
+		    &rll->views[i].src_fov,   //
+		    &new_poses[i],            //
+		    &matrix);                 //
+
+		*rll->views[i].transform = matrix;
+		latched = true;
+	}
+
+	return latched;
+}
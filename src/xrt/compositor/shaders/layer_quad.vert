@@ -5,10 +5,19 @@
 #version 460
 
 
-layout (binding = 0, std140) uniform Config
+// Should match RENDER_GFX_LAYER_QUAD_MAX_INSTANCES.
+#define MAX_INSTANCES 8
+
+struct Instance
 {
 	vec4 post_transform;
 	mat4 mvp;
+};
+
+// Consecutive quads sampling the same image are drawn as instances.
+layout (binding = 0, std140) uniform Config
+{
+	Instance instances[MAX_INSTANCES];
 } ubo;
 
 layout (location = 0) out vec2 out_uv;
@@ -27,6 +36,8 @@ vec2 pos[4] = {
 
 void main()
 {
+	Instance instance = ubo.instances[gl_InstanceIndex];
+
 	// We now get a unmodified UV position.
 	vec2 in_uv = pos[gl_VertexIndex % 4];
 
@@ -37,10 +48,10 @@ void main()
 	pos.y = -pos.y;
 
 	// Place quad in the center of the mvp, it will scale it.
-	vec4 position = ubo.mvp * vec4(pos, 0.0f, 1.0f);
+	vec4 position = instance.mvp * vec4(pos, 0.0f, 1.0f);
 
 	// To deal with OpenGL flip and sub image view.
-	vec2 uv = fma(in_uv, ubo.post_transform.zw, ubo.post_transform.xy);
+	vec2 uv = fma(in_uv, instance.post_transform.zw, instance.post_transform.xy);
 
 	gl_Position = position;
 	out_uv = uv;
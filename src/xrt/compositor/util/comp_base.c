@@ -21,6 +21,22 @@
  *
  */
 
+/*!
+ * The layers of all clients are pushed into the same slot, so even if each
+ * client keeps within its limit they might not all fit, drop the ones that don't.
+ */
+static bool
+is_slot_full(struct comp_base *cb)
+{
+	if (cb->slot.layer_count < COMP_MAX_LAYERS) {
+		return false;
+	}
+
+	VK_WARN(&cb->vk, "Too many layers in slot, dropping layer (max: %u)", COMP_MAX_LAYERS);
+
+	return true;
+}
+
 static xrt_result_t
 do_single_layer(struct xrt_compositor *xc,
                 struct xrt_device *xdev,
@@ -29,6 +45,10 @@ do_single_layer(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
+	if (is_slot_full(cb)) {
+		return XRT_SUCCESS;
+	}
+
 	uint32_t layer_id = cb->slot.layer_count;
 
 	struct comp_layer *layer = &cb->slot.layers[layer_id];
@@ -123,6 +143,10 @@ base_layer_stereo_projection(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
+	if (is_slot_full(cb)) {
+		return XRT_SUCCESS;
+	}
+
 	uint32_t layer_id = cb->slot.layer_count;
 
 	struct comp_layer *layer = &cb->slot.layers[layer_id];
@@ -146,6 +170,10 @@ base_layer_stereo_projection_depth(struct xrt_compositor *xc,
 {
 	struct comp_base *cb = comp_base(xc);
 
+	if (is_slot_full(cb)) {
+		return XRT_SUCCESS;
+	}
+
 	uint32_t layer_id = cb->slot.layer_count;
 
 	struct comp_layer *layer = &cb->slot.layers[layer_id];
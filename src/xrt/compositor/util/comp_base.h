@@ -18,7 +18,12 @@
 extern "C" {
 #endif
 
-#define COMP_MAX_LAYERS 16
+/*!
+ * Max number of layers in a single @ref comp_layer_slot, larger than
+ * @ref XRT_MAX_LAYERS as the layers of multiple clients can be pushed into one
+ * slot. Must not be larger than @ref RENDER_MAX_LAYERS.
+ */
+#define COMP_MAX_LAYERS 64
 
 /*!
  * A single layer.
@@ -28,6 +28,22 @@ struct comp_layer;
  *
  */
 
+/*!
+ * Foveation parameters for the compute layer squasher of a single view, the
+ * part of the view outside the full rate region is shaded at a reduced rate.
+ */
+struct comp_render_foveation_data
+{
+	//! Shade the periphery of the view at a reduced rate.
+	bool enabled;
+
+	//! Centre of the full rate region, in view uv space, follows the eye gaze if available.
+	struct xrt_vec2 center;
+
+	//! Radius of the full rate region, in view uv space.
+	float radius;
+};
+
 /*!
  * The input data needed for a single view, it shared between both GFX and CS
  * paths. To fully render a single view two "rendering" might be needed, the
@@ -93,6 +109,21 @@ struct comp_render_view_data
 	{
 		//! Only used on compute path.
 		VkImageView unorm_view;
+
+		//! Foveation of the layer squasher, zeroed means disabled.
+		struct comp_render_foveation_data foveation;
+
+		/*!
+		 * Cells of the view hidden by the visibility mask, tiles of the
+		 * layer squasher fully within them are skipped, zeroed means none.
+		 */
+		uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE];
+
+		/*!
+		 * The layer image already holds the squashed layers of this view
+		 * from an earlier frame, the layer squasher leaves it untouched.
+		 */
+		bool squash_reused;
 	} cs;
 };
 
@@ -113,6 +144,9 @@ struct comp_render_dispatch_data
 	//! Very often true, can be disabled for debugging.
 	bool do_timewarp;
 
+	//! Use the depth of a fast path projection layer to also correct for position, needs @p do_timewarp.
+	bool do_positional_timewarp;
+
 	struct
 	{
 		// The resources needed for the target.
@@ -272,9 +306,19 @@ comp_render_cs_add_view(struct comp_render_dispatch_data *data,
  * Helper to dispatch the layer squasher for a single view.
  *
  * All source layer images and target image needs to be in the correct image
- * layout, no barrier is inserted at all. The @p view_index argument is needed
- * to grab a pre-allocated UBO from the @ref render_resources and to correctly
- * select left/right data from various layers.
+ * layout, no barrier is inserted for them to change layout. The @p view_index
+ * argument is needed to grab pre-allocated UBOs from the @ref render_resources
+ * and to correctly select left/right data from various layers.
+ *
+ * If there are more layers than fits in a single dispatch, the layers are
+ * squashed in multiple runs where each run blends on top of the previous one,
+ * with a barrier on the target image between them.
+ *
+ * If @p foveation is enabled, the periphery of the view is shaded at a reduced
+ * rate, see @ref comp_render_foveation_data.
+ *
+ * Tiles fully within the cells set in @p hidden_rows are cleared instead of
+ * squashed, see @ref render_compute_layer_ubo_data::hidden_rows.
  *
  * Expected layouts:
  * * Layer images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
@@ -291,6 +335,8 @@ comp_render_cs_layer(struct render_compute *crc,
                      const VkImage target_image,
                      const VkImageView target_image_view,
                      const struct render_viewport_data *target_view,
+                     const struct comp_render_foveation_data *foveation,
+                     const uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE],
                      bool do_timewarp);
 
 /*!
@@ -344,6 +390,27 @@ comp_render_cs_dispatch(struct render_compute *crc,
                         const uint32_t layer_count,
                         const struct comp_render_dispatch_data *d);
 
+/*!
+ * Second half of @ref comp_render_cs_dispatch for when the layers have already
+ * been squashed into the scratch images with @ref comp_render_cs_layers, for
+ * instance on another queue. Does the distortion from the scratch images to
+ * the target image.
+ *
+ * Currently limited to exactly two views.
+ *
+ * Expected layouts:
+ * * Sratch images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+ * * Target image: Any
+ *
+ * After call layouts:
+ * * Sratch images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+ * * Target image: VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+ *
+ * @ingroup comp_util
+ */
+void
+comp_render_cs_distortion_from_scratch(struct render_compute *crc, const struct comp_render_dispatch_data *d);
+
 
 #ifdef __cplusplus
 }
@@ -18,6 +18,7 @@
 
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
+#include "util/u_worker.h"
 
 #include "vk/vk_helpers.h"
 
@@ -34,6 +35,63 @@
  *
  */
 
+/*!
+ * Bounds covering the whole view, used for layers that we can't cull.
+ */
+static const struct xrt_normalized_rect full_view_bounds = {.x = 0.0f, .y = 0.0f, .w = 1.0f, .h = 1.0f};
+
+/*!
+ * Calculates a conservative bounding rect, in view uv space, of a quad given
+ * its transform into view space. Returns false if any corner is on or behind
+ * the plane of the viewer, the projected quad could then cover any part of
+ * the view so it can't be culled.
+ */
+static bool
+calc_quad_view_bounds(const struct xrt_matrix_4x4 *plane_transform_view_space,
+                      const struct xrt_vec2 *size,
+                      const struct xrt_normalized_rect *pre_transform,
+                      struct xrt_normalized_rect *out_bounds)
+{
+	const struct xrt_vec3 corners[4] = {
+	    {-size->x / 2.0f, -size->y / 2.0f, 0.0f},
+	    {size->x / 2.0f, -size->y / 2.0f, 0.0f},
+	    {-size->x / 2.0f, size->y / 2.0f, 0.0f},
+	    {size->x / 2.0f, size->y / 2.0f, 0.0f},
+	};
+
+	float min_x = INFINITY, min_y = INFINITY;
+	float max_x = -INFINITY, max_y = -INFINITY;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(corners); i++) {
+		struct xrt_vec3 p;
+		math_matrix_4x4_transform_vec3(plane_transform_view_space, &corners[i], &p);
+
+		// Forward is -Z, give up if close to or behind the viewer.
+		if (p.z > -0.001f) {
+			return false;
+		}
+
+		// Tangent space, the inverse of get_direction in the shader.
+		float tan_x = p.x / -p.z;
+		float tan_y = p.y / -p.z;
+
+		float u = (tan_x - pre_transform->x) / pre_transform->w;
+		float v = (-tan_y - pre_transform->y) / pre_transform->h;
+
+		min_x = fminf(min_x, u);
+		min_y = fminf(min_y, v);
+		max_x = fmaxf(max_x, u);
+		max_y = fmaxf(max_y, v);
+	}
+
+	out_bounds->x = min_x;
+	out_bounds->y = min_y;
+	out_bounds->w = max_x - min_x;
+	out_bounds->h = max_y - min_y;
+
+	return true;
+}
+
 static inline void
 do_cs_equirect2_layer(const struct xrt_layer_data *data,
                       const struct comp_layer *layer,
@@ -97,6 +155,117 @@ do_cs_equirect2_layer(const struct xrt_layer_data *data,
 	*out_cur_image = cur_image;
 }
 
+static inline void
+do_cs_equirect1_layer(const struct xrt_layer_data *data,
+                      const struct comp_layer *layer,
+                      const struct xrt_matrix_4x4 *eye_view_mat,
+                      const struct xrt_matrix_4x4 *world_view_mat,
+                      uint32_t view_index,
+                      uint32_t cur_layer,
+                      uint32_t cur_image,
+                      VkSampler clamp_to_edge,
+                      VkSampler clamp_to_border_black,
+                      VkSampler src_samplers[RENDER_MAX_IMAGES],
+                      VkImageView src_image_views[RENDER_MAX_IMAGES],
+                      struct render_compute_layer_ubo_data *ubo_data,
+                      uint32_t *out_cur_image)
+{
+	const struct xrt_layer_equirect1_data *eq1 = &data->equirect1;
+
+	const struct comp_swapchain_image *image = &layer->sc_array[0]->images[eq1->sub.image_index];
+	uint32_t array_index = eq1->sub.array_index;
+
+	// Image to use.
+	src_samplers[cur_image] = clamp_to_edge;
+	src_image_views[cur_image] = get_image_view(image, data->flags, array_index);
+
+	// Used for Subimage and OpenGL flip.
+	set_post_transform_rect(                    //
+	    data,                                   // data
+	    &eq1->sub.norm_rect,                    // src_norm_rect
+	    false,                                  // invert_flip
+	    &ubo_data->post_transforms[cur_layer]); // out_norm_rect
+
+	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+
+	struct xrt_matrix_4x4 model;
+	math_matrix_4x4_model(&eq1->pose, &scale, &model);
+
+	struct xrt_matrix_4x4 model_inv;
+	math_matrix_4x4_inverse(&model, &model_inv);
+
+	const struct xrt_matrix_4x4 *v = is_layer_view_space(data) ? eye_view_mat : world_view_mat;
+
+	struct xrt_matrix_4x4 v_inv;
+	math_matrix_4x4_inverse(v, &v_inv);
+
+	math_matrix_4x4_multiply(&model_inv, &v_inv, &ubo_data->mv_inverse[cur_layer]);
+
+	// Simplifies the shader.
+	if (eq1->radius >= INFINITY) {
+		ubo_data->eq2_data[cur_layer].radius = 0.f;
+	} else {
+		ubo_data->eq2_data[cur_layer].radius = eq1->radius;
+	}
+
+	ubo_data->eq1_data[cur_layer].scale = eq1->scale;
+	ubo_data->eq1_data[cur_layer].bias = eq1->bias;
+
+	ubo_data->images_samplers[cur_layer].images[0] = cur_image;
+	cur_image++;
+
+	*out_cur_image = cur_image;
+}
+
+/*!
+ * Cube layers are sampled through their cube views, that have their own
+ * binding, so they don't use any of the regular source images.
+ */
+static inline void
+do_cs_cube_layer(const struct xrt_layer_data *data,
+                 const struct comp_layer *layer,
+                 const struct xrt_matrix_4x4 *eye_view_mat,
+                 const struct xrt_matrix_4x4 *world_view_mat,
+                 uint32_t cur_layer,
+                 uint32_t cur_cube,
+                 VkSampler clamp_to_edge,
+                 VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES],
+                 VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES],
+                 struct render_compute_layer_ubo_data *ubo_data,
+                 uint32_t *out_cur_cube)
+{
+	const struct xrt_layer_cube_data *cube = &data->cube;
+
+	const struct comp_swapchain_image *image = &layer->sc_array[0]->images[cube->sub.image_index];
+	uint32_t array_index = cube->sub.array_index;
+
+	// The views of cube swapchains are cube views.
+	cube_samplers[cur_cube] = clamp_to_edge;
+	cube_image_views[cur_cube] = get_image_view(image, data->flags, array_index);
+
+	// Infinitely far away, only the orientation is used.
+	struct xrt_pose pose = {cube->pose.orientation, XRT_VEC3_ZERO};
+	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+
+	struct xrt_matrix_4x4 model;
+	math_matrix_4x4_model(&pose, &scale, &model);
+
+	struct xrt_matrix_4x4 model_inv;
+	math_matrix_4x4_inverse(&model, &model_inv);
+
+	const struct xrt_matrix_4x4 *v = is_layer_view_space(data) ? eye_view_mat : world_view_mat;
+
+	struct xrt_matrix_4x4 v_inv;
+	math_matrix_4x4_inverse(v, &v_inv);
+
+	math_matrix_4x4_multiply(&model_inv, &v_inv, &ubo_data->mv_inverse[cur_layer]);
+
+	ubo_data->images_samplers[cur_layer].images[0] = cur_cube;
+	cur_cube++;
+
+	*out_cur_cube = cur_cube;
+}
+
 static inline void
 do_cs_projection_layer(const struct xrt_layer_data *data,
                        const struct comp_layer *layer,
@@ -236,6 +405,12 @@ do_cs_quad_layer(const struct xrt_layer_data *data,
 	ubo_data->quad_normal[cur_layer].val = normal_view_space;
 	ubo_data->inverse_quad_transform[cur_layer] = inverse_quad_transform;
 	ubo_data->images_samplers[cur_layer].images[0] = cur_image;
+
+	// Lets the shader skip this layer on tiles it doesn't touch.
+	struct xrt_normalized_rect bounds;
+	if (calc_quad_view_bounds(&plane_transform_view_space, &data->quad.size, &ubo_data->pre_transform, &bounds)) {
+		ubo_data->view_bounds[cur_layer] = bounds;
+	}
 	cur_image++;
 
 	*out_cur_image = cur_image;
@@ -480,25 +655,154 @@ do_cs_distortion_from_stereo_layer(struct render_compute *crc,
 }
 
 
+/*!
+ * OpenXR allows the near or far plane of the depth to be at infinity, clamp
+ * them to something the shader can do math with.
+ */
+#define MAX_DEPTH_PLANE_DISTANCE (10000.0f)
+
+static void
+do_cs_positional_distortion_from_stereo_depth_layer(struct render_compute *crc,
+                                                    const struct comp_layer *layer,
+                                                    const struct comp_render_dispatch_data *d)
+{
+	// Hardcoded to two views.
+	if (d->view_count != 2) {
+		U_LOG_E("Only supports exactly 2 views!");
+		assert(d->view_count == 2);
+		return;
+	}
+
+	// Fetch from this data.
+	const struct xrt_layer_data *data = &layer->data;
+
+	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
+
+	// Data to fill in.
+	struct xrt_pose world_poses[2];
+	struct render_viewport_data target_viewport_datas[2];
+	struct xrt_normalized_rect src_norm_rects[2];
+	struct xrt_normalized_rect depth_norm_rects[2];
+	struct render_depth_params depth_params[2];
+	struct xrt_pose src_poses[2];
+	struct xrt_fov src_fovs[2];
+	VkSampler src_samplers[2];
+	VkImageView src_image_views[2];
+	VkImageView depth_image_views[2];
+
+	for (uint32_t i = 0; i < d->view_count; i++) {
+		const struct xrt_layer_projection_view_data *vd = NULL;
+		const struct xrt_layer_depth_data *dvd = NULL;
+		view_index_to_depth_data(i, data, &vd, &dvd);
+
+		// Color is in the first two swapchains and depth in the last two.
+		uint32_t sc_array_index = is_view_index_right(i) ? 1 : 0;
+		const struct comp_swapchain_image *image = &layer->sc_array[sc_array_index]->images[vd->sub.image_index];
+		const struct comp_swapchain_image *d_image =
+		    &layer->sc_array[sc_array_index + 2]->images[dvd->sub.image_index];
+
+		struct xrt_normalized_rect src_norm_rect = vd->sub.norm_rect;
+		struct xrt_normalized_rect depth_norm_rect = dvd->sub.norm_rect;
+
+		if (data->flip_y) {
+			src_norm_rect.h = -src_norm_rect.h;
+			src_norm_rect.y = 1 + src_norm_rect.y;
+			depth_norm_rect.h = -depth_norm_rect.h;
+			depth_norm_rect.y = 1 + depth_norm_rect.y;
+		}
+
+		depth_params[i] = (struct render_depth_params){
+		    .min_depth = dvd->min_depth,
+		    .depth_range = dvd->max_depth - dvd->min_depth,
+		    .near_z = fminf(dvd->near_z, MAX_DEPTH_PLANE_DISTANCE),
+		    .far_z = fminf(dvd->far_z, MAX_DEPTH_PLANE_DISTANCE),
+		};
+
+		// Fill in data.
+		world_poses[i] = d->views[i].world_pose;
+		target_viewport_datas[i] = d->views[i].target_viewport_data;
+		src_norm_rects[i] = src_norm_rect;
+		depth_norm_rects[i] = depth_norm_rect;
+		src_poses[i] = vd->pose;
+		src_fovs[i] = vd->fov;
+		src_samplers[i] = clamp_to_border_black;
+		src_image_views[i] = get_image_view(image, data->flags, vd->sub.array_index);
+		depth_image_views[i] = get_image_view(d_image, data->flags, dvd->sub.array_index);
+	}
+
+	render_compute_projection_positional_timewarp( //
+	    crc,                                       //
+	    src_samplers,                              //
+	    src_image_views,                           //
+	    src_norm_rects,                            //
+	    depth_image_views,                         //
+	    depth_norm_rects,                          //
+	    depth_params,                              //
+	    src_poses,                                 //
+	    src_fovs,                                  //
+	    world_poses,                               //
+	    d->cs.target_image,                        //
+	    d->cs.target_unorm_view,                   //
+	    target_viewport_datas);                    //
+}
+
 /*
  *
- * 'Exported' compute helpers.
+ * Layer squasher helpers.
  *
  */
 
-void
-comp_render_cs_layer(struct render_compute *crc,
-                     uint32_t view_index,
-                     const struct comp_layer *layers,
-                     const uint32_t layer_count,
-                     const struct xrt_normalized_rect *pre_transform,
-                     const struct xrt_pose *world_pose,
-                     const struct xrt_pose *eye_pose,
-                     const VkImage target_image,
-                     const VkImageView target_image_view,
-                     const struct render_viewport_data *target_view,
-                     bool do_timewarp)
+/*!
+ * The most specialised layer shader variant that handles all layer types set
+ * in @p layer_types, a bit per @ref xrt_layer_type.
+ */
+static enum render_compute_layer_mix
+select_layer_mix(uint32_t layer_types)
+{
+	const uint32_t projection = (1u << XRT_LAYER_STEREO_PROJECTION) | (1u << XRT_LAYER_STEREO_PROJECTION_DEPTH);
+	const uint32_t quad = 1u << XRT_LAYER_QUAD;
+
+	if ((layer_types & ~projection) == 0) {
+		return RENDER_COMPUTE_LAYER_MIX_PROJECTION;
+	}
+	if ((layer_types & ~(projection | quad)) == 0) {
+		return RENDER_COMPUTE_LAYER_MIX_PROJECTION_QUAD;
+	}
+
+	return RENDER_COMPUTE_LAYER_MIX_ALL;
+}
+
+/*!
+ * Squash as many layers, starting at @p first_layer, as fits in a single
+ * dispatch of the layer shader. Any run but the first blends on top of what
+ * the earlier runs wrote to the target.
+ *
+ * Returns the index of the first layer that was not squashed.
+ */
+static uint32_t
+do_cs_layer_run(struct render_compute *crc,
+                uint32_t view_index,
+                uint32_t run_index,
+                const struct comp_layer *layers,
+                const uint32_t layer_count,
+                const uint32_t first_layer,
+                const struct xrt_normalized_rect *pre_transform,
+                const struct xrt_pose *world_pose,
+                const struct xrt_pose *eye_pose,
+                const VkImage target_image,
+                const VkImageView target_image_view,
+                const struct render_viewport_data *target_view,
+                const struct comp_render_foveation_data *foveation,
+                const uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE],
+                bool do_timewarp)
 {
+	assert(view_index < RENDER_MAX_LAYER_RUNS / RENDER_MAX_LAYER_RUNS_PER_VIEW);
+	assert(run_index < RENDER_MAX_LAYER_RUNS_PER_VIEW);
+
+	// Each run has its own UBO and descriptor set.
+	uint32_t run = view_index * RENDER_MAX_LAYER_RUNS_PER_VIEW + run_index;
+	bool blend_on_target = run_index > 0;
+
 	VkSampler clamp_to_edge = crc->r->samplers.clamp_to_edge;
 	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
 
@@ -507,21 +811,34 @@ comp_render_cs_layer(struct render_compute *crc,
 	math_matrix_4x4_view_from_pose(world_pose, &world_view_mat);
 	math_matrix_4x4_view_from_pose(eye_pose, &eye_view_mat);
 
-	struct render_buffer *ubo = &crc->r->compute.layer.ubos[view_index];
+	struct render_buffer *ubo = &crc->r->compute.layer.ubos[run];
 	struct render_compute_layer_ubo_data *ubo_data = ubo->mapped;
 
 	// Tightly pack layers in data struct.
 	uint32_t cur_layer = 0;
 
+	// Which layer types are in this run, picks the shader variant.
+	uint32_t layer_types = 0;
+
 	// Tightly pack color and optional depth images.
 	uint32_t cur_image = 0;
 	VkSampler src_samplers[RENDER_MAX_IMAGES];
 	VkImageView src_image_views[RENDER_MAX_IMAGES];
 
+	// Cube layers have their own images.
+	uint32_t cur_cube = 0;
+	VkSampler cube_samplers[RENDER_MAX_CUBE_IMAGES];
+	VkImageView cube_image_views[RENDER_MAX_CUBE_IMAGES];
+
 	ubo_data->view = *target_view;
 	ubo_data->pre_transform = *pre_transform;
+	ubo_data->foveation.center = foveation->center;
+	ubo_data->foveation.radius = foveation->radius;
+	ubo_data->foveation.enabled = foveation->enabled;
+	memcpy(ubo_data->hidden_rows, hidden_rows, sizeof(ubo_data->hidden_rows));
 
-	for (uint32_t c_layer_i = 0; c_layer_i < layer_count; c_layer_i++) {
+	uint32_t c_layer_i = first_layer;
+	for (; c_layer_i < layer_count; c_layer_i++) {
 		const struct comp_layer *layer = &layers[c_layer_i];
 		const struct xrt_layer_data *data = &layer->data;
 
@@ -529,6 +846,11 @@ comp_render_cs_layer(struct render_compute *crc,
 			continue;
 		}
 
+		// The rest of the layers goes into the next run.
+		if (cur_layer >= RENDER_MAX_LAYERS_PER_RUN) {
+			break;
+		}
+
 		/*!
 		 * Stop compositing layers if device's sampled image limit is
 		 * reached. For most hardware this isn't a problem, most have
@@ -537,8 +859,14 @@ comp_render_cs_layer(struct render_compute *crc,
 		 * on a RPi4 you have more problems then max samplers.
 		 */
 		uint32_t required_image_samplers;
+		uint32_t required_cube_samplers = 0;
 		switch (data->type) {
+		case XRT_LAYER_CUBE:
+			required_image_samplers = 0;
+			required_cube_samplers = 1;
+			break;
 		case XRT_LAYER_CYLINDER: required_image_samplers = 1; break;
+		case XRT_LAYER_EQUIRECT1: required_image_samplers = 1; break;
 		case XRT_LAYER_EQUIRECT2: required_image_samplers = 1; break;
 		case XRT_LAYER_STEREO_PROJECTION: required_image_samplers = 1; break;
 		case XRT_LAYER_STEREO_PROJECTION_DEPTH: required_image_samplers = 2; break;
@@ -552,8 +880,44 @@ comp_render_cs_layer(struct render_compute *crc,
 		if (cur_image + required_image_samplers > crc->r->compute.layer.image_array_size) {
 			break;
 		}
+		if (cur_cube + required_cube_samplers > RENDER_MAX_CUBE_IMAGES) {
+			break;
+		}
+
+		// Layer builders that can calculate tighter bounds overwrite this.
+		ubo_data->view_bounds[cur_layer] = full_view_bounds;
 
 		switch (data->type) {
+		case XRT_LAYER_CUBE:
+			do_cs_cube_layer(     //
+			    data,             // data
+			    layer,            // layer
+			    &eye_view_mat,    // eye_view_mat
+			    &world_view_mat,  // world_view_mat
+			    cur_layer,        // cur_layer
+			    cur_cube,         // cur_cube
+			    clamp_to_edge,    // clamp_to_edge
+			    cube_samplers,    // cube_samplers
+			    cube_image_views, // cube_image_views
+			    ubo_data,         // ubo_data
+			    &cur_cube);       // out_cur_cube
+			break;
+		case XRT_LAYER_EQUIRECT1:
+			do_cs_equirect1_layer(     //
+			    data,                  // data
+			    layer,                 // layer
+			    &eye_view_mat,         // eye_view_mat
+			    &world_view_mat,       // world_view_mat
+			    view_index,            // view_index
+			    cur_layer,             // cur_layer
+			    cur_image,             // cur_image
+			    clamp_to_edge,         // clamp_to_edge
+			    clamp_to_border_black, // clamp_to_border_black
+			    src_samplers,          // src_samplers
+			    src_image_views,       // src_image_views
+			    ubo_data,              // ubo_data
+			    &cur_image);           // out_cur_image
+			break;
 		case XRT_LAYER_CYLINDER:
 			do_cs_cylinder_layer(      //
 			    data,                  // data
@@ -628,15 +992,22 @@ comp_render_cs_layer(struct render_compute *crc,
 
 		ubo_data->layer_type[cur_layer].val = data->type;
 		ubo_data->layer_type[cur_layer].unpremultiplied = is_layer_unpremultiplied(data);
+		layer_types |= 1u << data->type;
 
 		// Finally okay to increment the current layer.
 		cur_layer++;
 	}
 
+	// Only layers that are not visible in this view were left, nothing to do.
+	if (blend_on_target && cur_layer == 0) {
+		return c_layer_i;
+	}
+
 	// Set the number of layers.
 	ubo_data->layer_count.value = cur_layer;
+	ubo_data->layer_count.blend_on_target = blend_on_target;
 
-	for (uint32_t i = cur_layer; i < RENDER_MAX_LAYERS; i++) {
+	for (uint32_t i = cur_layer; i < RENDER_MAX_LAYERS_PER_RUN; i++) {
 		ubo_data->layer_type[i].val = UINT32_MAX;
 	}
 
@@ -647,18 +1018,212 @@ comp_render_cs_layer(struct render_compute *crc,
 		cur_image++;
 	}
 
-	VkDescriptorSet descriptor_set = crc->layer_descriptor_sets[view_index];
+	while (cur_cube < RENDER_MAX_CUBE_IMAGES) {
+		cube_samplers[cur_cube] = clamp_to_edge;
+		cube_image_views[cur_cube] = crc->r->mock.cube.image_view;
+		cur_cube++;
+	}
 
-	render_compute_layers( //
-	    crc,               //
-	    descriptor_set,    //
-	    ubo->buffer,       //
-	    src_samplers,      //
-	    src_image_views,   //
-	    cur_image,         //
-	    target_image_view, //
-	    target_view,       //
-	    do_timewarp);      //
+	if (blend_on_target) {
+		VkImageSubresourceRange first_color_level_subresource_range = {
+		    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		    .baseMipLevel = 0,
+		    .levelCount = 1,
+		    .baseArrayLayer = 0,
+		    .layerCount = 1,
+		};
+
+		// Wait for the earlier run to have written the target.
+		vk_cmd_image_barrier_locked(                                //
+		    crc->r->vk,                                             // vk_bundle
+		    crc->cmd,                                               // cmd_buffer
+		    target_image,                                           // image
+		    VK_ACCESS_SHADER_WRITE_BIT,                             // src_access_mask
+		    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, // dst_access_mask
+		    VK_IMAGE_LAYOUT_GENERAL,                                // old_image_layout
+		    VK_IMAGE_LAYOUT_GENERAL,                                // new_image_layout
+		    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                   // src_stage_mask
+		    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,                   // dst_stage_mask
+		    first_color_level_subresource_range);                   // subresource_range
+	}
+
+	VkDescriptorSet descriptor_set = crc->layer_descriptor_sets[run];
+
+	render_compute_layers(             //
+	    crc,                           //
+	    descriptor_set,                //
+	    ubo->buffer,                   //
+	    src_samplers,                  //
+	    src_image_views,               //
+	    cur_image,                     //
+	    cube_samplers,                 //
+	    cube_image_views,              //
+	    target_image_view,             //
+	    target_view,                   //
+	    select_layer_mix(layer_types), //
+	    do_timewarp,                   //
+	    foveation->enabled);           //
+
+	return c_layer_i;
+}
+
+void
+comp_render_cs_layer(struct render_compute *crc,
+                     uint32_t view_index,
+                     const struct comp_layer *layers,
+                     const uint32_t layer_count,
+                     const struct xrt_normalized_rect *pre_transform,
+                     const struct xrt_pose *world_pose,
+                     const struct xrt_pose *eye_pose,
+                     const VkImage target_image,
+                     const VkImageView target_image_view,
+                     const struct render_viewport_data *target_view,
+                     const struct comp_render_foveation_data *foveation,
+                     const uint32_t hidden_rows[RENDER_VISIBILITY_GRID_SIZE],
+                     bool do_timewarp)
+{
+	uint32_t next_layer = 0;
+
+	// Always do the first run, it also clears the target.
+	for (uint32_t run_index = 0; run_index < RENDER_MAX_LAYER_RUNS_PER_VIEW; run_index++) {
+		next_layer = do_cs_layer_run( //
+		    crc,                      //
+		    view_index,               //
+		    run_index,                //
+		    layers,                   //
+		    layer_count,              //
+		    next_layer,               //
+		    pre_transform,            //
+		    world_pose,               //
+		    eye_pose,                 //
+		    target_image,             //
+		    target_image_view,        //
+		    target_view,              //
+		    foveation,                //
+		    hidden_rows,              //
+		    do_timewarp);             //
+
+		if (next_layer >= layer_count) {
+			return;
+		}
+	}
+
+	uint32_t dropped = 0;
+	for (uint32_t i = next_layer; i < layer_count; i++) {
+		if (is_layer_view_visible(&layers[i].data, view_index)) {
+			dropped++;
+		}
+	}
+
+	if (dropped > 0) {
+		VK_WARN(crc->r->vk, "Out of layer squasher runs, dropped %u layer(s) on view %u", dropped, view_index);
+	}
+}
+
+/*
+ *
+ * Parallel view recording.
+ *
+ */
+
+/*!
+ * Below this many layers recording both views on the compositor thread is
+ * cheaper than handing one of them to a worker thread.
+ */
+#define PARALLEL_VIEW_RECORD_MIN_LAYERS (8)
+
+struct view_record_task
+{
+	struct render_compute crc;
+	const struct comp_layer *layers;
+	uint32_t layer_count;
+	const struct comp_render_dispatch_data *d;
+	uint32_t view_index;
+	bool ok;
+};
+
+static void
+do_cs_view_layers(struct render_compute *crc,
+                  const struct comp_layer *layers,
+                  const uint32_t layer_count,
+                  const struct comp_render_dispatch_data *d,
+                  uint32_t view_index)
+{
+	const struct comp_render_view_data *view = &d->views[view_index];
+
+	comp_render_cs_layer(            //
+	    crc,                         //
+	    view_index,                  //
+	    layers,                      //
+	    layer_count,                 //
+	    &view->target_pre_transform, //
+	    &view->world_pose,           //
+	    &view->eye_pose,             //
+	    view->image,                 //
+	    view->cs.unorm_view,         //
+	    &view->layer_viewport_data,  //
+	    &view->cs.foveation,         //
+	    view->cs.hidden_rows,        //
+	    d->do_timewarp);             //
+}
+
+static void
+record_view_task(void *ptr)
+{
+	COMP_TRACE_MARKER();
+
+	struct view_record_task *task = (struct view_record_task *)ptr;
+
+	do_cs_view_layers(&task->crc, task->layers, task->layer_count, task->d, task->view_index);
+
+	task->ok = render_compute_end_view(&task->crc);
+}
+
+/*!
+ * Each view only touches its own UBOs and descriptor sets, so they can be
+ * recorded on different threads into their own secondary command buffers.
+ * Returns false if nothing was recorded into @p crc, the caller then needs to
+ * record the views itself.
+ */
+static bool
+do_cs_views_in_parallel(struct render_compute *crc,
+                        const struct comp_layer *layers,
+                        const uint32_t layer_count,
+                        const struct comp_render_dispatch_data *d)
+{
+	struct u_worker_group *group = crc->r->view_record.group;
+	struct view_record_task tasks[ARRAY_SIZE(crc->r->view_record.cmds)];
+	uint32_t view_count = d->view_count;
+
+	assert(view_count <= ARRAY_SIZE(tasks));
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		tasks[i] = (struct view_record_task){
+		    .layers = layers,
+		    .layer_count = layer_count,
+		    .d = d,
+		    .view_index = i,
+		};
+
+		if (!render_compute_begin_view(crc, i, &tasks[i].crc)) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		u_worker_group_push(group, record_view_task, &tasks[i]);
+	}
+	u_worker_group_wait_all(group);
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		if (!tasks[i].ok) {
+			return false;
+		}
+	}
+
+	render_compute_execute_views(crc, view_count);
+
+	return true;
 }
 
 void
@@ -668,10 +1233,12 @@ comp_render_cs_layers(struct render_compute *crc,
                       const struct comp_render_dispatch_data *d,
                       VkImageLayout transition_to)
 {
+	render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_LAYER_SQUASH);
+
 	cmd_barrier_view_images(                   //
 	    crc->r->vk,                            //
 	    d,                                     //
-	    crc->r->cmd,                           // cmd
+	    crc->cmd,                              // cmd
 	    0,                                     // src_access_mask
 	    VK_ACCESS_SHADER_WRITE_BIT,            // dst_access_mask
 	    VK_IMAGE_LAYOUT_UNDEFINED,             // transition_from
@@ -679,33 +1246,39 @@ comp_render_cs_layers(struct render_compute *crc,
 	    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,    // src_stage_mask
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT); // dst_stage_mask
 
+	// Views whose squash is reused are skipped, then there is only one view left to record.
+	bool any_reused = false;
 	for (uint32_t view_index = 0; view_index < d->view_count; view_index++) {
-		const struct comp_render_view_data *view = &d->views[view_index];
-
-		comp_render_cs_layer(            //
-		    crc,                         //
-		    view_index,                  //
-		    layers,                      //
-		    layer_count,                 //
-		    &view->target_pre_transform, //
-		    &view->world_pose,           //
-		    &view->eye_pose,             //
-		    view->image,                 //
-		    view->cs.unorm_view,         //
-		    &view->layer_viewport_data,  //
-		    d->do_timewarp);             //
+		any_reused = any_reused || d->views[view_index].cs.squash_reused;
+	}
+
+	bool recorded = false;
+	if (layer_count >= PARALLEL_VIEW_RECORD_MIN_LAYERS && d->view_count > 1 && !any_reused &&
+	    render_compute_can_record_views(crc)) {
+		recorded = do_cs_views_in_parallel(crc, layers, layer_count, d);
+	}
+
+	if (!recorded) {
+		for (uint32_t view_index = 0; view_index < d->view_count; view_index++) {
+			if (d->views[view_index].cs.squash_reused) {
+				continue;
+			}
+			do_cs_view_layers(crc, layers, layer_count, d, view_index);
+		}
 	}
 
 	cmd_barrier_view_images(                   //
 	    crc->r->vk,                            //
 	    d,                                     //
-	    crc->r->cmd,                           // cmd
+	    crc->cmd,                              // cmd
 	    VK_ACCESS_SHADER_WRITE_BIT,            // src_access_mask
 	    VK_ACCESS_MEMORY_READ_BIT,             // dst_access_mask
 	    VK_IMAGE_LAYOUT_GENERAL,               // transition_from
 	    transition_to,                         // transition_to
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,  // src_stage_mask
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT); // dst_stage_mask
+
+	render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_LAYER_SQUASH);
 }
 
 void
@@ -729,12 +1302,26 @@ comp_render_cs_dispatch(struct render_compute *crc,
 		const struct xrt_layer_projection_view_data *lvd = &stereo->l;
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
+		render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_cs_distortion_from_stereo_layer( //
 		    crc,                            // crc
 		    layer,                          // layer
 		    lvd,                            // lvd
 		    rvd,                            // rvd
 		    d);                             // d
+
+		render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+	} else if (fast_path && layers[0].data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH &&
+	           d->do_positional_timewarp) {
+		render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
+		do_cs_positional_distortion_from_stereo_depth_layer( //
+		    crc,                                             // crc
+		    &layers[0],                                      // layer
+		    d);                                              // d
+
+		render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
 	} else if (fast_path && layers[0].data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
 		int i = 0;
 		const struct comp_layer *layer = &layers[i];
@@ -742,12 +1329,16 @@ comp_render_cs_dispatch(struct render_compute *crc,
 		const struct xrt_layer_projection_view_data *lvd = &stereo->l;
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
+		render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_cs_distortion_from_stereo_layer( //
 		    crc,                            // crc
 		    layer,                          // layer
 		    lvd,                            // lvd
 		    rvd,                            // rvd
 		    d);                             // d
+
+		render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
 	} else if (layer_count > 0) {
 		comp_render_cs_layers( //
 		    crc,               //
@@ -756,12 +1347,32 @@ comp_render_cs_dispatch(struct render_compute *crc,
 		    d,                 //
 		    transition_to);    //
 
+		render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_cs_distortion_from_scratch( //
 		    crc,                       //
 		    d);                        //
+
+		render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
 	} else {
+		render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_cs_clear( //
 		    crc,     //
 		    d);      //
+
+		render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
 	}
 }
+
+void
+comp_render_cs_distortion_from_scratch(struct render_compute *crc, const struct comp_render_dispatch_data *d)
+{
+	render_resources_begin_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
+	do_cs_distortion_from_scratch( //
+	    crc,                       //
+	    d);                        //
+
+	render_resources_end_timing_stage(crc->r, crc->cmd, RENDER_TIMING_STAGE_DISTORTION);
+}
@@ -41,6 +41,18 @@ struct gfx_layer_view_state
 	enum xrt_layer_type types[RENDER_MAX_LAYERS];
 	// Is the alpha premultipled, false means unpremultiplied.
 	bool premultiplied_alphas[RENDER_MAX_LAYERS];
+	// Number of instances drawn, more than one for batched quads.
+	uint32_t instance_counts[RENDER_MAX_LAYERS];
+
+	// Consecutive quads sampling the same image, not yet added as a layer.
+	struct
+	{
+		struct render_gfx_layer_quad_data instances[RENDER_GFX_LAYER_QUAD_MAX_INSTANCES];
+		uint32_t count;
+		VkSampler src_sampler;
+		VkImageView src_image_view;
+		const struct xrt_layer_data *first;
+	} quad_batch;
 
 	// To go to this view's tangent lengths.
 	struct xrt_normalized_rect to_tangent;
@@ -222,6 +234,43 @@ add_layer(struct gfx_layer_view_state *state, const struct xrt_layer_data *data,
 	state->descriptor_sets[cur_layer] = descriptor_set;
 	state->types[cur_layer] = data->type;
 	state->premultiplied_alphas[cur_layer] = !is_layer_unpremultiplied(data);
+	state->instance_counts[cur_layer] = 1;
+}
+
+/*!
+ * Write out the batched quads as one layer, must be called before any other
+ * layer is added so the draw order is kept.
+ */
+static VkResult
+flush_quad_batch(struct render_gfx *rr, struct gfx_layer_view_state *state)
+{
+	struct vk_bundle *vk = rr->r->vk;
+	VkResult ret;
+
+	uint32_t count = state->quad_batch.count;
+	if (count == 0) {
+		return VK_SUCCESS;
+	}
+
+	// Can fail if we have too many layers.
+	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+	ret = render_gfx_layer_quad_alloc_and_write( //
+	    rr,                                      // rr
+	    state->quad_batch.instances,             // data
+	    count,                                   // instance_count
+	    state->quad_batch.src_sampler,           // src_sampler
+	    state->quad_batch.src_image_view,        // src_image_view
+	    &descriptor_set);                        // out_descriptor_set
+	VK_CHK_AND_RET(ret, "render_gfx_layer_quad_alloc_and_write");
+
+	VK_NAME_DESCRIPTOR_SET(vk, descriptor_set, "render_gfx layer quad descriptor set");
+
+	add_layer(state, state->quad_batch.first, descriptor_set);
+	state->instance_counts[state->layer_count - 1] = count;
+
+	state->quad_batch.count = 0;
+
+	return VK_SUCCESS;
 }
 
 static VkResult
@@ -424,7 +473,6 @@ do_quad_layer(struct render_gfx *rr,
 {
 	const struct xrt_layer_data *layer_data = &layer->data;
 	const struct xrt_layer_quad_data *q = &layer_data->quad;
-	struct vk_bundle *vk = rr->r->vk;
 	VkResult ret;
 
 	const uint32_t array_index = q->sub.array_index;
@@ -448,19 +496,25 @@ do_quad_layer(struct render_gfx *rr,
 	struct xrt_vec3 scale = {q->size.x, q->size.y, 1};
 	calc_mvp_full(state, layer_data, &q->pose, &scale, &data.mvp);
 
-	// Can fail if we have too many layers.
-	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
-	ret = render_gfx_layer_quad_alloc_and_write( //
-	    rr,                                      // rr
-	    &data,                                   // data
-	    src_sampler,                             // src_sampler
-	    src_image_view,                          // src_image_view
-	    &descriptor_set);                        // out_descriptor_set
-	VK_CHK_AND_RET(ret, "render_gfx_layer_quad_alloc_and_write");
+	// Quads in a batch are drawn with the same image and blending.
+	bool can_batch = state->quad_batch.count > 0 &&
+	                 state->quad_batch.count < RENDER_GFX_LAYER_QUAD_MAX_INSTANCES &&
+	                 state->quad_batch.src_sampler == src_sampler &&
+	                 state->quad_batch.src_image_view == src_image_view;
+	if (can_batch) {
+		can_batch = is_layer_unpremultiplied(state->quad_batch.first) == is_layer_unpremultiplied(layer_data);
+	}
 
-	VK_NAME_DESCRIPTOR_SET(vk, descriptor_set, "render_gfx layer quad descriptor set");
+	if (!can_batch) {
+		ret = flush_quad_batch(rr, state);
+		VK_CHK_AND_RET(ret, "flush_quad_batch");
 
-	add_layer(state, layer_data, descriptor_set);
+		state->quad_batch.src_sampler = src_sampler;
+		state->quad_batch.src_image_view = src_image_view;
+		state->quad_batch.first = layer_data;
+	}
+
+	state->quad_batch.instances[state->quad_batch.count++] = data;
 
 	return VK_SUCCESS;
 }
@@ -540,6 +594,12 @@ do_layers(struct render_gfx *rr,
 				continue;
 			}
 
+			// Anything but a quad ends the batch, keeps the draw order.
+			if (data->type != XRT_LAYER_QUAD) {
+				ret = flush_quad_batch(rr, state);
+				VK_CHK_WITH_GOTO(ret, "flush_quad_batch", err_layer);
+			}
+
 			switch (data->type) {
 			case XRT_LAYER_CYLINDER:
 				ret = do_cylinder_layer(   //
@@ -585,6 +645,9 @@ do_layers(struct render_gfx *rr,
 			default: break;
 			}
 		}
+
+		ret = flush_quad_batch(rr, state);
+		VK_CHK_WITH_GOTO(ret, "flush_quad_batch", err_layer);
 	}
 
 
@@ -637,7 +700,8 @@ do_layers(struct render_gfx *rr,
 				render_gfx_layer_quad(              //
 				    rr,                             //
 				    state->premultiplied_alphas[i], //
-				    state->descriptor_sets[i]);     //
+				    state->descriptor_sets[i],      //
+				    state->instance_counts[i]);     //
 				break;
 			default: break;
 			}
@@ -698,14 +762,26 @@ do_mesh(struct render_gfx *rr,
 			    &data.transform);         //
 		}
 
+		struct render_gfx_mesh_ubo_data *mapped_data = NULL;
 		ret = render_gfx_mesh_alloc_and_write( //
 		    rr,                                //
 		    &data,                             //
 		    md->views[i].src_sampler,          //
 		    md->views[i].src_image_view,       //
+		    &mapped_data,                      //
 		    &ms.descriptor_sets[i]);           //
 		VK_CHK_WITH_GOTO(ret, "render_gfx_mesh_alloc", err_no_memory);
 
+		// Let the transform be updated with a fresher pose before submitting.
+		if (do_timewarp) {
+			render_late_latch_set_view(   //
+			    &rr->late_latch,          //
+			    i,                        //
+			    &md->views[i].src_pose,   //
+			    &md->views[i].src_fov,    //
+			    &mapped_data->transform); //
+		}
+
 		VK_NAME_DESCRIPTOR_SET(vk, ms.descriptor_sets[i], "render_gfx mesh descriptor sets");
 	}
 
@@ -833,6 +909,8 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 		const struct xrt_layer_projection_view_data *lvd = &stereo->l;
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
+		render_resources_begin_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_mesh_from_proj( //
 		    rr,            //
 		    d,             //
@@ -840,12 +918,16 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 		    lvd,           //
 		    rvd);          //
 
+		render_resources_end_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 	} else if (fast_path && layer->data.type == XRT_LAYER_STEREO_PROJECTION_DEPTH) {
 		// Fast path.
 		const struct xrt_layer_stereo_projection_depth_data *stereo = &layer->data.stereo_depth;
 		const struct xrt_layer_projection_view_data *lvd = &stereo->l;
 		const struct xrt_layer_projection_view_data *rvd = &stereo->r;
 
+		render_resources_begin_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		do_mesh_from_proj( //
 		    rr,            //
 		    d,             //
@@ -853,6 +935,8 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 		    lvd,           //
 		    rvd);          //
 
+		render_resources_end_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 	} else {
 		if (fast_path) {
 			U_LOG_W("Wanted fast path but no projection layer, falling back to layer squasher.");
@@ -863,17 +947,23 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 		 * Layer squashing.
 		 */
 
+		render_resources_begin_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_LAYER_SQUASH);
+
 		do_layers(       //
 		    rr,          // rr
 		    layers,      // layers
 		    layer_count, // layer_count
 		    d);          // d
 
+		render_resources_end_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_LAYER_SQUASH);
+
 
 		/*
 		 * Distortion.
 		 */
 
+		render_resources_begin_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
+
 		VkImageLayout transition_from = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		VkImageLayout transition_to = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
@@ -914,5 +1004,7 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 		    false, // do_timewarp
 		    &md,   // md
 		    d);    // d
+
+		render_resources_end_timing_stage(rr->r, rr->r->cmd, RENDER_TIMING_STAGE_DISTORTION);
 	}
 }
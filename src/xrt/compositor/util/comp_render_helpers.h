@@ -167,6 +167,11 @@ cmd_barrier_view_images(struct vk_bundle *vk,
 	for (uint32_t i = 0; i < d->view_count; i++) {
 		bool already_barried = false;
 
+		// Holds the squash of an earlier frame that is being reused, leave it be.
+		if (d->views[i].cs.squash_reused) {
+			continue;
+		}
+
 		VkImage image = d->views[i].image;
 
 		uint32_t k = i;
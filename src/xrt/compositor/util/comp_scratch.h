@@ -122,6 +122,16 @@ comp_scratch_single_images_free(struct comp_scratch_single_images *cssi, struct
 void
 comp_scratch_single_images_get(struct comp_scratch_single_images *cssi, uint32_t *out_index);
 
+/*!
+ * After calling @p get, switch to the image from the last @p done call so its
+ * contents can be reused instead of rendering to a new image. Returns false,
+ * and leaves the index untouched, if there is no such image.
+ *
+ * @ingroup comp_util
+ */
+bool
+comp_scratch_single_images_reuse_last(struct comp_scratch_single_images *cssi, uint32_t *out_index);
+
 /*!
  * After calling @p get and rendering to the image you call this function to
  * signal that you are done with this function, the GPU work needs to be fully
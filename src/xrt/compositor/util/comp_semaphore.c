@@ -7,6 +7,7 @@
  * @ingroup comp_util
  */
 
+#include "util/u_misc.h"
 #include "util/u_handles.h"
 
 #include "util/comp_semaphore.h"
@@ -49,6 +50,78 @@ semaphore_wait(struct xrt_compositor_semaphore *xcsem, uint64_t value, uint64_t
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+semaphore_signal(struct xrt_compositor_semaphore *xcsem, uint64_t value)
+{
+	struct comp_semaphore *csem = comp_semaphore(xcsem);
+	struct vk_bundle *vk = csem->vk;
+	VkResult ret;
+
+	VkSemaphoreSignalInfo signal_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+	    .semaphore = csem->semaphore,
+	    .value = value,
+	};
+
+	ret = vk->vkSignalSemaphore( //
+	    vk->device,              // device
+	    &signal_info);           // pSignalInfo
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkSignalSemaphore: %s", vk_result_string(ret));
+		return XRT_ERROR_VULKAN;
+	}
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+semaphore_wait_any(struct xrt_compositor_semaphore **xcsems,
+                   const uint64_t *values,
+                   uint32_t count,
+                   uint64_t timeout_ns)
+{
+	struct vk_bundle *vk = comp_semaphore(xcsems[0])->vk;
+	VkSemaphore local[16];
+	VkSemaphore *semaphores = local;
+	VkResult ret;
+
+	// Only allocate when there are a lot of semaphores.
+	if (count > ARRAY_SIZE(local)) {
+		semaphores = U_TYPED_ARRAY_CALLOC(VkSemaphore, count);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		semaphores[i] = comp_semaphore(xcsems[i])->semaphore;
+	}
+
+	VkSemaphoreWaitInfo wait_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+	    .flags = VK_SEMAPHORE_WAIT_ANY_BIT,
+	    .semaphoreCount = count,
+	    .pSemaphores = semaphores,
+	    .pValues = values,
+	};
+
+	ret = vk->vkWaitSemaphores( //
+	    vk->device,             // device
+	    &wait_info,             // pWaitInfo
+	    timeout_ns);            // timeout
+
+	if (semaphores != local) {
+		free(semaphores);
+	}
+
+	if (ret == VK_TIMEOUT) {
+		return XRT_TIMEOUT;
+	}
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitSemaphores: %s", vk_result_string(ret));
+		return XRT_ERROR_VULKAN;
+	}
+
+	return XRT_SUCCESS;
+}
+
 static void
 semaphore_destroy(struct xrt_compositor_semaphore *xcsem)
 {
@@ -104,6 +177,8 @@ comp_semaphore_create(struct vk_bundle *vk,
 	csem->base.reference.count = 1;
 	csem->base.destroy = semaphore_destroy;
 	csem->base.wait = semaphore_wait;
+	csem->base.signal = semaphore_signal;
+	csem->base.wait_any = semaphore_wait_any;
 	csem->semaphore = semaphore;
 	csem->handle = handle;
 	csem->vk = vk;
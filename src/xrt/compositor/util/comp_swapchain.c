@@ -13,15 +13,13 @@
 #include "xrt/xrt_results.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
 
 #include "vk/vk_helpers.h"
 #include "vk/vk_cmd_pool.h"
-#include "vk/vk_mini_helpers.h"
-
-#include "util/comp_swapchain.h"
 
 #include "util/comp_swapchain.h"
 
@@ -31,6 +29,212 @@
 #include <errno.h>
 
 
+DEBUG_GET_ONCE_NUM_OPTION(swapchain_cache_mb, "XRT_COMPOSITOR_SWAPCHAIN_CACHE_MB", 0)
+
+
+/*
+ *
+ * Image cache functions.
+ *
+ */
+
+static VkDeviceSize
+cache_collection_size(const struct vk_image_collection *vkic)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < vkic->image_count; i++) {
+		size += vkic->images[i].size;
+	}
+	return size;
+}
+
+static bool
+cache_formats_contains(const struct xrt_swapchain_create_info *info, int64_t format)
+{
+	for (uint32_t i = 0; i < info->format_count; i++) {
+		if (info->formats[i] == format) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*!
+ * The client creates its own images on top of the exported memory, from the
+ * info it asked for. So everything that goes into the VkImageCreateInfo must be
+ * the same, or the two images might not agree on the memory layout. The usage
+ * bits are compared as the Vulkan usage flags they turn into and the view format
+ * list as a set, since duplicates are dropped when creating the images. That
+ * rules out larger images standing in for smaller ones, the coordinates the
+ * client gives in its layers are normalized against the size it asked for,
+ * only a collection with more images than asked for can be used.
+ */
+static bool
+cache_info_compatible(struct vk_bundle *vk,
+                      const struct xrt_swapchain_create_info *a,
+                      const struct xrt_swapchain_create_info *b)
+{
+	if (a->create != b->create ||             //
+	    a->format != b->format ||             //
+	    a->sample_count != b->sample_count || //
+	    a->width != b->width ||               //
+	    a->height != b->height ||             //
+	    a->face_count != b->face_count ||     //
+	    a->array_size != b->array_size ||     //
+	    a->mip_count != b->mip_count) {
+		return false;
+	}
+
+	bool a_mutable = (a->bits & XRT_SWAPCHAIN_USAGE_MUTABLE_FORMAT) != 0;
+	bool b_mutable = (b->bits & XRT_SWAPCHAIN_USAGE_MUTABLE_FORMAT) != 0;
+	if (a_mutable != b_mutable) {
+		return false;
+	}
+
+	if (a->bits != b->bits) {
+		VkFormat format = (VkFormat)a->format;
+		if (vk_csci_get_image_usage_flags(vk, format, a->bits) !=
+		    vk_csci_get_image_usage_flags(vk, format, b->bits)) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < a->format_count; i++) {
+		if (!cache_formats_contains(b, a->formats[i])) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < b->format_count; i++) {
+		if (!cache_formats_contains(a, b->formats[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Only images we can clear are cached, so no client ever sees the content of
+ * images of another client.
+ */
+static bool
+cache_info_clearable(const struct xrt_swapchain_create_info *info)
+{
+	return (info->bits & XRT_SWAPCHAIN_USAGE_TRANSFER_DST) != 0;
+}
+
+/*!
+ * Removes entry @p index from the cache, keeping the rest in order.
+ */
+static void
+cache_remove_locked(struct comp_swapchain_shared *cscs, uint32_t index)
+{
+	cscs->cache.bytes -= cache_collection_size(&cscs->cache.vkics[index]);
+
+	for (uint32_t k = index + 1; k < cscs->cache.count; k++) {
+		cscs->cache.vkics[k - 1] = cscs->cache.vkics[k];
+	}
+	cscs->cache.count--;
+}
+
+/*!
+ * Take a cached image collection compatible with @p info that has at least
+ * @p image_count images, any images above that are destroyed.
+ */
+static bool
+cache_take(struct comp_swapchain_shared *cscs,
+           struct vk_bundle *vk,
+           const struct xrt_swapchain_create_info *info,
+           uint32_t image_count,
+           struct vk_image_collection *out_vkic)
+{
+	bool found = false;
+
+	os_mutex_lock(&cscs->cache.mutex);
+
+	// Newest first, it's the most likely to be asked for again.
+	for (uint32_t i = cscs->cache.count; i-- > 0;) {
+		struct vk_image_collection *vkic = &cscs->cache.vkics[i];
+		if (vkic->image_count < image_count || !cache_info_compatible(vk, &vkic->info, info)) {
+			continue;
+		}
+
+		*out_vkic = *vkic;
+		cache_remove_locked(cscs, i);
+
+		found = true;
+		break;
+	}
+
+	os_mutex_unlock(&cscs->cache.mutex);
+
+	if (!found) {
+		return false;
+	}
+
+	// Hand the images we don't need to the deferred destroy.
+	if (out_vkic->image_count > image_count) {
+		struct vk_image_collection surplus = {
+		    .info = out_vkic->info,
+		    .image_count = out_vkic->image_count - image_count,
+		};
+		for (uint32_t i = 0; i < surplus.image_count; i++) {
+			surplus.images[i] = out_vkic->images[image_count + i];
+		}
+		vk_ic_destroy_deferred(vk, &surplus);
+
+		out_vkic->image_count = image_count;
+	}
+
+	// Same Vulkan images, but report what this swapchain was created with.
+	out_vkic->info = *info;
+
+	return true;
+}
+
+/*!
+ * Give the image collection to the cache, the oldest entries are destroyed to
+ * keep the cache within its byte budget. Takes ownership of the content of
+ * @p vkic.
+ */
+static void
+cache_give(struct comp_swapchain_shared *cscs, struct vk_bundle *vk, struct vk_image_collection *vkic)
+{
+	VkDeviceSize size = cache_collection_size(vkic);
+	if (size > cscs->cache.max_bytes || !cache_info_clearable(&vkic->info)) {
+		vk_ic_destroy_deferred(vk, vkic);
+		return;
+	}
+
+	os_mutex_lock(&cscs->cache.mutex);
+
+	while (cscs->cache.count > 0 && cscs->cache.bytes + size > cscs->cache.max_bytes) {
+		vk_ic_destroy_deferred(vk, &cscs->cache.vkics[0]);
+		cache_remove_locked(cscs, 0);
+	}
+
+	// Grown on demand, so nothing is allocated while the cache is off.
+	if (cscs->cache.count >= cscs->cache.capacity) {
+		uint32_t capacity = cscs->cache.capacity + 4;
+		struct vk_image_collection *vkics =
+		    realloc(cscs->cache.vkics, sizeof(struct vk_image_collection) * capacity);
+		if (vkics == NULL) {
+			os_mutex_unlock(&cscs->cache.mutex);
+			vk_ic_destroy_deferred(vk, vkic);
+			return;
+		}
+		cscs->cache.vkics = vkics;
+		cscs->cache.capacity = capacity;
+	}
+
+	cscs->cache.vkics[cscs->cache.count++] = *vkic;
+	cscs->cache.bytes += size;
+	U_ZERO(vkic);
+
+	os_mutex_unlock(&cscs->cache.mutex);
+}
+
+
 /*
  *
  * Swapchain member functions.
@@ -263,7 +467,8 @@ image_view_array_cleanup(struct vk_bundle *vk, size_t array_size, VkImageView **
 			continue;
 		}
 
-		D(ImageView, views[i]);
+		// The renderer might still be using them.
+		vk_deferred_destroy(vk, VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)views[i]);
 	}
 
 	free(views);
@@ -279,14 +484,10 @@ static void
 image_cleanup(struct vk_bundle *vk, struct comp_swapchain_image *image)
 {
 	/*
-	 * This makes sure that any pending command buffer has completed and all
-	 * resources referred by it can now be manipulated. This make sure that
-	 * validation doesn't complain. This is done during image destruction so
-	 * isn't time critical.
+	 * The views are destroyed once any command buffers using them have
+	 * completed, see vk_deferred_destroy. Waiting for the device to go idle
+	 * here would stall the compositor every time an app changes swapchains.
 	 */
-	os_mutex_lock(&vk->queue_mutex);
-	vk->vkDeviceWaitIdle(vk->device);
-	os_mutex_unlock(&vk->queue_mutex);
 
 	// The field array_size is shared, only reset once both are freed.
 	image_view_array_cleanup(vk, image->array_size, &image->views.alpha);
@@ -303,12 +504,15 @@ cleanup_post_create_vulkan_setup(struct vk_bundle *vk, struct comp_swapchain *sc
 	for (uint32_t i = 0; i < image_count; i++) {
 		image_cleanup(vk, &(sc->images[i]));
 	}
+
+	vk_deferred_submit(vk);
 }
 
 static XRT_CHECK_RESULT xrt_result_t
 do_post_create_vulkan_setup(struct vk_bundle *vk,
                             const struct xrt_swapchain_create_info *info,
-                            struct comp_swapchain *sc)
+                            struct comp_swapchain *sc,
+                            bool clear)
 {
 	xrt_result_t xret = XRT_SUCCESS;
 	uint32_t image_count = sc->vkic.image_count;
@@ -412,7 +616,7 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 	    .layerCount = info->array_size * info->face_count,
 	};
 
-	for (uint32_t i = 0; i < image_count; i++) {
+	for (uint32_t i = 0; i < image_count && !clear; i++) {
 		vk_cmd_image_barrier_gpu_locked(              //
 		    vk,                                       //
 		    cmd_buffer,                               //
@@ -424,6 +628,54 @@ do_post_create_vulkan_setup(struct vk_bundle *vk,
 		    subresource_range);                       //
 	}
 
+	// Reused images still hold what the last swapchain rendered, all mip levels.
+	VkImageSubresourceRange clear_range = subresource_range;
+	clear_range.levelCount = VK_REMAINING_MIP_LEVELS;
+
+	for (uint32_t i = 0; i < image_count && clear; i++) {
+		VkImage image = sc->vkic.images[i].handle;
+
+		vk_cmd_image_barrier_gpu_locked(          //
+		    vk,                                   //
+		    cmd_buffer,                           //
+		    image,                                //
+		    0,                                    //
+		    VK_ACCESS_TRANSFER_WRITE_BIT,         //
+		    VK_IMAGE_LAYOUT_UNDEFINED,            //
+		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, //
+		    clear_range);                         //
+
+		if ((image_barrier_aspect & VK_IMAGE_ASPECT_COLOR_BIT) != 0) {
+			VkClearColorValue color = {0};
+			vk->vkCmdClearColorImage(                 //
+			    cmd_buffer,                           // commandBuffer
+			    image,                                // image
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // imageLayout
+			    &color,                               // pColor
+			    1,                                    // rangeCount
+			    &clear_range);                        // pRanges
+		} else {
+			VkClearDepthStencilValue depth_stencil = {0};
+			vk->vkCmdClearDepthStencilImage(          //
+			    cmd_buffer,                           // commandBuffer
+			    image,                                // image
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // imageLayout
+			    &depth_stencil,                       // pDepthStencil
+			    1,                                    // rangeCount
+			    &clear_range);                        // pRanges
+		}
+
+		vk_cmd_image_barrier_gpu_locked(              //
+		    vk,                                       //
+		    cmd_buffer,                               //
+		    image,                                    //
+		    VK_ACCESS_TRANSFER_WRITE_BIT,             //
+		    VK_ACCESS_SHADER_READ_BIT,                //
+		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,     //
+		    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, //
+		    clear_range);                             //
+	}
+
 	// Done writing commands, submit to queue, waits for command to finish.
 	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(vk, pool, cmd_buffer);
 
@@ -514,18 +766,26 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 
 	set_common_fields(sc, destroy_func, vk, cscs, xsccp->image_count);
 
-	// Use the image helper to allocate the images.
-	ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
-	if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
-		return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
-	}
-	if (ret == VK_ERROR_FORMAT_NOT_SUPPORTED) {
-		return XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
-	}
-	if (ret != VK_SUCCESS) {
-		return XRT_ERROR_VULKAN;
+	// Reuse the images of a destroyed swapchain if we can, otherwise allocate new ones.
+	if (cache_info_clearable(info) && cache_take(cscs, vk, info, xsccp->image_count, &sc->vkic)) {
+		VK_DEBUG(vk, "Reusing cached images for %p", (void *)sc);
+		sc->reused = true;
+	} else {
+		// Use the image helper to allocate the images.
+		ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
+		if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
+			return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
+		}
+		if (ret == VK_ERROR_FORMAT_NOT_SUPPORTED) {
+			return XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
+		if (ret != VK_SUCCESS) {
+			return XRT_ERROR_VULKAN;
+		}
 	}
 
+	sc->allocated = true;
+
 	xrt_graphics_buffer_handle_t handles[ARRAY_SIZE(sc->vkic.images)];
 
 	ret = vk_ic_get_handles(vk, &sc->vkic, ARRAY_SIZE(handles), handles);
@@ -539,9 +799,10 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 		sc->base.images[i].handle = handles[i];
 		sc->base.images[i].size = sc->vkic.images[i].size;
 		sc->base.images[i].use_dedicated_allocation = sc->vkic.images[i].use_dedicated_allocation;
+		sc->base.images[i].row_pitch = sc->vkic.images[i].row_pitch;
 	}
 
-	xrt_result_t res = do_post_create_vulkan_setup(vk, info, sc);
+	xrt_result_t res = do_post_create_vulkan_setup(vk, info, sc, sc->reused);
 	if (res != XRT_SUCCESS) {
 		vk_ic_destroy(vk, &sc->vkic);
 		free(sc);
@@ -575,7 +836,7 @@ comp_swapchain_import_init(struct comp_swapchain *sc,
 		return XRT_ERROR_VULKAN;
 	}
 
-	xrt_result_t res = do_post_create_vulkan_setup(vk, info, sc);
+	xrt_result_t res = do_post_create_vulkan_setup(vk, info, sc, false);
 	if (res != XRT_SUCCESS) {
 		vk_ic_destroy(vk, &sc->vkic);
 		free(sc);
@@ -612,7 +873,15 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 		u_graphics_buffer_unref(&sc->base.images[i].handle);
 	}
 
-	vk_ic_destroy(vk, &sc->vkic);
+	// Imported images belongs to the client, never cache them.
+	if (sc->allocated) {
+		cache_give(sc->cscs, vk, &sc->vkic);
+	} else {
+		vk_ic_destroy_deferred(vk, &sc->vkic);
+	}
+
+	// Everything above is destroyed once the GPU is done with it.
+	vk_deferred_submit(vk);
 }
 
 
@@ -625,29 +894,72 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 XRT_CHECK_RESULT xrt_result_t
 comp_swapchain_shared_init(struct comp_swapchain_shared *cscs, struct vk_bundle *vk)
 {
+	cscs->vk = vk;
+
 	VkResult ret = vk_cmd_pool_init(vk, &cscs->pool, 0);
 	if (ret != VK_SUCCESS) {
 		VK_ERROR(vk, "vk_cmd_pool_init: %s", vk_result_string(ret));
 		return XRT_ERROR_VULKAN;
 	}
 
+	int iret = os_mutex_init(&cscs->cache.mutex);
+	if (iret != 0) {
+		VK_ERROR(vk, "os_mutex_init: %i", iret);
+		vk_cmd_pool_destroy(vk, &cscs->pool);
+		return XRT_ERROR_THREADING_INIT_FAILURE;
+	}
+
+	int64_t max_mb = debug_get_num_option_swapchain_cache_mb();
+	if (max_mb < 0) {
+		max_mb = 0;
+	}
+	cscs->cache.max_bytes = (VkDeviceSize)max_mb * 1024 * 1024;
+	cscs->cache.vkics = NULL;
+	cscs->cache.capacity = 0;
+	cscs->cache.bytes = 0;
+	cscs->cache.count = 0;
+
 	return XRT_SUCCESS;
 }
 
 void
 comp_swapchain_shared_destroy(struct comp_swapchain_shared *cscs, struct vk_bundle *vk)
 {
+	// Nothing can be using the images after this.
+	vk_deferred_wait_and_collect_all(vk);
+
+	for (uint32_t i = 0; i < cscs->cache.count; i++) {
+		vk_ic_destroy(vk, &cscs->cache.vkics[i]);
+	}
+	cscs->cache.count = 0;
+	cscs->cache.bytes = 0;
+
+	free(cscs->cache.vkics);
+	cscs->cache.vkics = NULL;
+	cscs->cache.capacity = 0;
+
+	os_mutex_destroy(&cscs->cache.mutex);
+
 	vk_cmd_pool_destroy(vk, &cscs->pool);
 }
 
-void
+bool
 comp_swapchain_shared_garbage_collect(struct comp_swapchain_shared *cscs)
 {
 	struct comp_swapchain *sc;
+	bool destroyed = false;
 
 	while ((sc = u_threading_stack_pop(&cscs->destroy_swapchains))) {
 		sc->real_destroy(sc);
+		destroyed = true;
 	}
+
+	// Free what the GPU has finished with, from this or earlier calls.
+	if (cscs->vk != NULL) {
+		vk_deferred_collect(cscs->vk);
+	}
+
+	return destroyed;
 }
 
 
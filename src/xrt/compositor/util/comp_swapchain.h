@@ -45,7 +45,42 @@ struct comp_swapchain_shared
 	//! Thread object for safely destroying swapchain.
 	struct u_threading_stack destroy_swapchains;
 
+	//! Bundle the swapchains are created on, used to free deferred objects.
+	struct vk_bundle *vk;
+
 	struct vk_cmd_pool pool;
+
+	/*!
+	 * Images of destroyed swapchains, kept so that a swapchain created with
+	 * a compatible info can reuse them instead of allocating new memory.
+	 * This is common for apps that change their render scale. Oldest first.
+	 *
+	 * The images can be handed to a different client, so they are cleared
+	 * before being reused, which needs transfer destination usage; images
+	 * without it are never cached. The budget is VRAM that stays allocated
+	 * with no swapchain using it, so this is off by default. A budget the
+	 * size of one stereo set of app swapchains, about 3 images of two
+	 * 2k by 2k RGBA8 layers plus depth, is 100-200 MB.
+	 */
+	struct
+	{
+		struct os_mutex mutex;
+
+		//! Cached collections, grown as needed, NULL until the first one.
+		struct vk_image_collection *vkics;
+
+		//! Number of valid entries in @ref vkics.
+		uint32_t count;
+
+		//! Number of entries @ref vkics has room for.
+		uint32_t capacity;
+
+		//! Memory held by the images in @ref vkics, in bytes.
+		VkDeviceSize bytes;
+
+		//! Budget for @ref bytes, from XRT_COMPOSITOR_SWAPCHAIN_CACHE_MB, zero disables the cache.
+		VkDeviceSize max_bytes;
+	} cache;
 };
 
 /*!
@@ -98,6 +133,12 @@ struct comp_swapchain
 	struct vk_image_collection vkic;
 	struct comp_swapchain_image images[XRT_MAX_SWAPCHAIN_IMAGES];
 
+	//! Were the images allocated by us, and can therefore be given back to the cache.
+	bool allocated;
+
+	//! Were the images taken from the cache, and must therefore be cleared before use.
+	bool reused;
+
 	/*!
 	 * This fifo is used to always give out the oldest image to acquire
 	 * image, this should probably be made even smarter.
@@ -200,9 +241,11 @@ comp_swapchain_shared_destroy(struct comp_swapchain_shared *cscs, struct vk_bund
  * Do garbage collection, destroying any resources that has been scheduled for
  * destruction from other threads.
  *
+ * @return True if any swapchain was destroyed.
+ *
  * @ingroup comp_util
  */
-void
+bool
 comp_swapchain_shared_garbage_collect(struct comp_swapchain_shared *cscs);
 
 
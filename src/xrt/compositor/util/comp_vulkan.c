@@ -287,6 +287,8 @@ create_device(struct vk_bundle *vk, const struct comp_vulkan_arguments *vk_args)
 		    vk,                                  //
 		    vk_args->selected_gpu_index,         //
 		    only_compute_queue,                  // compute_only
+		    vk_args->async_compute_queue,        // async_compute
+		    vk_args->transfer_queue,             // async_transfer
 		    prios[i],                            // global_priority
 		    vk_args->required_device_extensions, //
 		    vk_args->optional_device_extensions, //
@@ -296,6 +298,12 @@ create_device(struct vk_bundle *vk, const struct comp_vulkan_arguments *vk_args)
 		if (ret == VK_SUCCESS) {
 			VK_INFO(vk, "Created device and %s queue with %s.", only_compute_queue ? "COMPUTE" : "GRAPHICS",
 			        prio_strs[i]);
+			if (vk->compute_queue != VK_NULL_HANDLE) {
+				VK_INFO(vk, "Created async compute queue.");
+			}
+			if (vk->transfer_queue != VK_NULL_HANDLE) {
+				VK_INFO(vk, "Created transfer queue.");
+			}
 			break;
 		}
 
@@ -430,6 +438,11 @@ is_format_supported(struct vk_bundle *vk, VkFormat format, enum xrt_swapchain_us
 		return false;
 	}
 
+	if ((xbits & XRT_SWAPCHAIN_USAGE_TRANSFER_DST) != 0 && (bits & VK_FORMAT_FEATURE_TRANSFER_DST_BIT) == 0) {
+		VK_DEBUG(vk, "Format '%s' cannot be copied to in optimal layout!", vk_format_string(format));
+		return false;
+	}
+
 
 	/*
 	 * Check exportability.
@@ -565,6 +578,19 @@ comp_vulkan_formats_check(struct vk_bundle *vk, struct comp_vulkan_formats *form
 #endif
 }
 
+void
+comp_vulkan_formats_check_compressed(struct vk_bundle *vk, struct comp_vulkan_formats *formats)
+{
+	// Can't be rendered to, apps upload to them.
+	const enum xrt_swapchain_usage_bits bits = XRT_SWAPCHAIN_USAGE_SAMPLED | XRT_SWAPCHAIN_USAGE_TRANSFER_DST;
+
+#define CHECK_COMPRESSED(FORMAT) formats->has_##FORMAT = is_format_supported(vk, VK_FORMAT_##FORMAT, bits);
+
+	VK_CSCI_COMPRESSED_FORMATS(CHECK_COMPRESSED)
+
+#undef CHECK_COMPRESSED
+}
+
 void
 comp_vulkan_formats_copy_to_info(const struct comp_vulkan_formats *formats, struct xrt_compositor_info *info)
 {
@@ -576,6 +602,7 @@ comp_vulkan_formats_copy_to_info(const struct comp_vulkan_formats *formats, stru
 	}
 
 	VK_CSCI_FORMATS(ADD_IF_SUPPORTED, ADD_IF_SUPPORTED, ADD_IF_SUPPORTED, ADD_IF_SUPPORTED)
+	VK_CSCI_COMPRESSED_FORMATS(ADD_IF_SUPPORTED)
 
 #undef ADD_IF_SUPPORTED
 
@@ -594,6 +621,11 @@ comp_vulkan_formats_log(enum u_logging_level log_level, const struct comp_vulkan
 	            VK_CSCI_FORMATS(PRINT_BOOLEAN, PRINT_BOOLEAN, PRINT_BOOLEAN, PRINT_BOOLEAN) //
 	);
 
+	U_LOG_IFL_I(log_level, "Compressed formats:"          //
+	            VK_CSCI_COMPRESSED_FORMATS(PRINT_NAME)    //
+	            VK_CSCI_COMPRESSED_FORMATS(PRINT_BOOLEAN) //
+	);
+
 #undef PRINT_NAME
 #undef PRINT_BOOLEAN
 
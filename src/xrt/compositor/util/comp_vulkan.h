@@ -49,6 +49,12 @@ struct comp_vulkan_arguments
 	//! Should we look for a queue with no graphics, only compute.
 	bool only_compute_queue;
 
+	//! Should we try to get a second queue for async compute work.
+	bool async_compute_queue;
+
+	//! Should we try to get a queue for uploads, see @ref vk_bundle::transfer_queue.
+	bool transfer_queue;
+
 	//! Should we try to enable timeline semaphores if available
 	bool timeline_semaphore;
 
@@ -108,6 +114,7 @@ struct comp_vulkan_formats
 {
 #define FIELD(IDENT) bool has_##IDENT;
 	VK_CSCI_FORMATS(FIELD, FIELD, FIELD, FIELD)
+	VK_CSCI_COMPRESSED_FORMATS(FIELD)
 #undef FIELD
 
 #if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER)
@@ -125,6 +132,16 @@ struct comp_vulkan_formats
 void
 comp_vulkan_formats_check(struct vk_bundle *vk, struct comp_vulkan_formats *formats);
 
+/*!
+ * Opt-in check of the block compressed formats, they are left as unsupported
+ * by @ref comp_vulkan_formats_check. Only formats that can be sampled from and
+ * copied to, as well as imported and exported, are marked as supported.
+ *
+ * @ingroup comp_util
+ */
+void
+comp_vulkan_formats_check_compressed(struct vk_bundle *vk, struct comp_vulkan_formats *formats);
+
 /*!
  * Fills in a @ref xrt_compositor_info struct with the formats listed from a
  * @ref comp_vulkan_formats. This and @ref comp_vulkan_formats_check are split
@@ -237,6 +237,7 @@ android_device_create(struct xrt_prober *xp)
 	d->base.get_tracked_pose = android_device_get_tracked_pose;
 	d->base.get_view_poses = u_device_get_view_poses;
 	d->base.compute_distortion = android_device_compute_distortion;
+	d->base.compute_distortion_thread_safe = true;
 	d->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
 	d->base.device_type = XRT_DEVICE_TYPE_HMD;
 	snprintf(d->base.str, XRT_DEVICE_NAME_LEN, "Android Sensors");
@@ -305,6 +306,7 @@ android_device_create(struct xrt_prober *xp)
 	};
 
 	u_distortion_cardboard_calculate(&args, d->base.hmd, &d->cardboard);
+	u_distortion_cardboard_fill_in_model(&d->base, d->cardboard.values);
 
 
 	u_var_add_root(d, "Android phone", true);
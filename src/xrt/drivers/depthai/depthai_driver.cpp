@@ -24,10 +24,7 @@
 #include "util/u_format.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
-
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "tracking/t_tracking.h"
 
@@ -55,12 +52,17 @@
 #define DEPTHAI_WARN(d, ...) U_LOG_IFL_W(d->log_level, __VA_ARGS__)
 #define DEPTHAI_ERROR(d, ...) U_LOG_IFL_E(d->log_level, __VA_ARGS__)
 
+//! More than the feature tracker gives with its default config.
+#define DEPTHAI_MAX_FEATURES (512)
+
 DEBUG_GET_ONCE_LOG_OPTION(depthai_log, "DEPTHAI_LOG", U_LOGGING_INFO)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_floodlight_brightness, "DEPTHAI_FLOODLIGHT_BRIGHTNESS", 1000)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_startup_wait_frames, "DEPTHAI_STARTUP_WAIT_FRAMES", 0)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_hz, "DEPTHAI_IMU_HZ", 500)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_batch_size, "DEPTHAI_IMU_BATCH_SIZE", 2)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_max_batch_size, "DEPTHAI_IMU_MAX_BATCH_SIZE", 2)
+DEBUG_GET_ONCE_BOOL_OPTION(depthai_feature_tracker, "DEPTHAI_FEATURE_TRACKER", false)
+DEBUG_GET_ONCE_NUM_OPTION(depthai_feature_tracker_shaves, "DEPTHAI_FEATURE_TRACKER_SHAVES", 2)
 
 
 
@@ -128,6 +130,7 @@ struct depthai_fs
 	struct xrt_frame_node node;
 	struct os_thread_helper image_thread;
 	struct os_thread_helper imu_thread;
+	struct os_thread_helper feature_thread;
 
 	u_logging_level log_level;
 
@@ -144,6 +147,8 @@ struct depthai_fs
 	dai::Device *device;
 	dai::DataOutputQueue *image_queue;
 	dai::DataOutputQueue *imu_queue;
+	//! Left and right, only used when @ref want_features is set.
+	dai::DataOutputQueue *feature_queues[2];
 
 	dai::DataInputQueue *control_queue;
 
@@ -186,8 +191,21 @@ struct depthai_fs
 
 	bool want_cameras;
 	bool want_imu;
+	bool want_features;
 	bool half_size_ov9282;
 
+	struct
+	{
+		depthai_features_func_t func;
+		void *user;
+
+		//! Features in the last message of each camera, for the debug UI.
+		int32_t last_count[2];
+
+		//! Reused between messages to avoid allocating on every frame.
+		struct depthai_feature scratch[DEPTHAI_MAX_FEATURES];
+	} features;
+
 	uint32_t first_frames_idx;
 	uint32_t first_frames_camera_to_watch;
 };
@@ -482,6 +500,9 @@ depthai_mainloop(void *ptr)
 	U_TRACE_SET_THREAD_NAME("DepthAI: Image");
 	os_thread_helper_name(&depthai->image_thread, "DepthAI: Image");
 
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_CAMERA, depthai->log_level, "DepthAI: Image");
+
 	DEPTHAI_DEBUG(depthai, "DepthAI: Image thread called");
 
 	os_thread_helper_lock(&depthai->image_thread);
@@ -620,10 +641,8 @@ depthai_imu_mainloop(void *ptr)
 	U_TRACE_SET_THREAD_NAME("DepthAI: IMU");
 	os_thread_helper_name(&depthai->imu_thread, "DepthAI: IMU");
 
-#ifdef XRT_OS_LINUX
-	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(depthai->log_level, "DepthAI: IMU");
-#endif
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_IMU, depthai->log_level, "DepthAI: IMU");
 
 	DEPTHAI_DEBUG(depthai, "DepthAI: IMU thread called");
 
@@ -643,12 +662,79 @@ depthai_imu_mainloop(void *ptr)
 	return nullptr;
 }
 
+static void
+depthai_do_one_features(struct depthai_fs *depthai, uint32_t camera_index)
+{
+	std::shared_ptr<dai::TrackedFeatures> msg =
+	    depthai->feature_queues[camera_index]->get<dai::TrackedFeatures>();
+	if (!msg) {
+		return; // Nothing to do.
+	}
+
+	SINK_TRACE_IDENT(depthai_features);
+
+	// Same clock as the image frames.
+	auto duration = msg->getTimestamp().time_since_epoch();
+	auto nano = std::chrono::duration_cast<std::chrono::duration<int64_t, std::nano>>(duration);
+	uint64_t timestamp_ns = nano.count();
+
+	struct depthai_feature *out = depthai->features.scratch;
+	uint32_t count = 0;
+	for (const dai::TrackedFeature &tf : msg->trackedFeatures) {
+		if (count >= DEPTHAI_MAX_FEATURES) {
+			DEPTHAI_WARN(depthai, "Too many features (%u), dropping the rest!",
+			             (uint32_t)msg->trackedFeatures.size());
+			break;
+		}
+		out[count].x = tf.position.x;
+		out[count].y = tf.position.y;
+		out[count].id = tf.id;
+		out[count].age = tf.age;
+		count++;
+	}
+
+	depthai->features.last_count[camera_index] = (int32_t)count;
+
+	if (depthai->features.func != nullptr) {
+		depthai->features.func(depthai->features.user, camera_index, timestamp_ns, out, count);
+	}
+}
+
+static void *
+depthai_feature_mainloop(void *ptr)
+{
+	struct depthai_fs *depthai = (struct depthai_fs *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("DepthAI: Features");
+	os_thread_helper_name(&depthai->feature_thread, "DepthAI: Features");
+
+	DEPTHAI_DEBUG(depthai, "DepthAI: Feature thread called");
+
+	os_thread_helper_lock(&depthai->feature_thread);
+	while (os_thread_helper_is_running_locked(&depthai->feature_thread)) {
+		os_thread_helper_unlock(&depthai->feature_thread);
+
+		// Both cameras run in lockstep, so left then right keeps them in order.
+		depthai_do_one_features(depthai, 0);
+		depthai_do_one_features(depthai, 1);
+
+		// Need to lock the thread when we go back to the while condition.
+		os_thread_helper_lock(&depthai->feature_thread);
+	}
+	os_thread_helper_unlock(&depthai->feature_thread);
+
+	DEPTHAI_DEBUG(depthai, "DepthAI: Feature thread exiting");
+
+	return nullptr;
+}
+
 static bool
 depthai_destroy(struct depthai_fs *depthai)
 {
 	DEPTHAI_DEBUG(depthai, "DepthAI: Frameserver destroy called");
 	os_thread_helper_destroy(&depthai->image_thread);
 	os_thread_helper_destroy(&depthai->imu_thread);
+	os_thread_helper_destroy(&depthai->feature_thread);
 	u_var_remove_root(depthai);
 	for (int i = 0; i < 4; i++) {
 		u_sink_debug_destroy(&depthai->debug_sinks[i]);
@@ -661,6 +747,11 @@ depthai_destroy(struct depthai_fs *depthai)
 	if (depthai->imu_queue) {
 		depthai->imu_queue->close();
 	}
+	for (int i = 0; i < 2; i++) {
+		if (depthai->feature_queues[i]) {
+			depthai->feature_queues[i]->close();
+		}
+	}
 	delete depthai->device;
 
 	free(depthai);
@@ -802,14 +893,19 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 
 	const char *name_images = "image_frames";
 	const char *name_imu = "imu_samples";
+	const char *name_features[2] = {"features_left", "features_right"};
 
 	auto controlIn = p.create<dai::node::XLinkIn>();
 	controlIn->setStreamName("control");
 
-	if (depthai->want_cameras) {
+	// The cameras are needed on the device for the feature tracker even if no images are sent to the host.
+	if (depthai->want_cameras || depthai->want_features) {
 
-		std::shared_ptr<dai::node::XLinkOut> xlinkOut = p.create<dai::node::XLinkOut>();
-		xlinkOut->setStreamName(name_images);
+		std::shared_ptr<dai::node::XLinkOut> xlinkOut = nullptr;
+		if (depthai->want_cameras) {
+			xlinkOut = p.create<dai::node::XLinkOut>();
+			xlinkOut->setStreamName(name_images);
+		}
 
 		dai::CameraBoardSocket sockets[2] = {
 		    dai::CameraBoardSocket::LEFT,
@@ -826,9 +922,27 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 			grayCam->setFps(depthai->fps);
 
 			// Link plugins CAM -> XLINK
-			grayCam->out.link(xlinkOut->input);
+			if (xlinkOut != nullptr) {
+				grayCam->out.link(xlinkOut->input);
+			}
 			// Link control to camera
 			controlIn->out.link(grayCam->inputControl);
+
+			if (!depthai->want_features) {
+				continue;
+			}
+
+			// Link plugins CAM -> FEATURE TRACKER -> XLINK, only the features go over USB.
+			auto featureTracker = p.create<dai::node::FeatureTracker>();
+			int32_t shaves = (int32_t)debug_get_num_option_depthai_feature_tracker_shaves();
+			featureTracker->setHardwareResources(shaves, shaves);
+			featureTracker->inputImage.setBlocking(false);
+			featureTracker->inputImage.setQueueSize(1);
+			grayCam->out.link(featureTracker->inputImage);
+
+			auto xlinkOut_features = p.create<dai::node::XLinkOut>();
+			xlinkOut_features->setStreamName(name_features[i]);
+			featureTracker->outputFeatures.link(xlinkOut_features->input);
 		}
 	}
 
@@ -895,6 +1009,12 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 	if (depthai->want_imu) {
 		depthai->imu_queue = depthai->device->getOutputQueue(name_imu, 4, false).get(); // out of shared pointer
 	}
+	if (depthai->want_features) {
+		for (int i = 0; i < 2; i++) {
+			depthai->feature_queues[i] =
+			    depthai->device->getOutputQueue(name_features[i], 4, false).get(); // out of shared pointer
+		}
+	}
 
 
 	depthai->control_queue = depthai->device->getInputQueue("control").get();
@@ -1050,6 +1170,9 @@ depthai_fs_slam_stream_start(struct xrt_fs *xfs, struct xrt_slam_sinks *sinks)
 		os_thread_helper_start(&depthai->imu_thread, depthai_imu_mainloop, depthai);
 		depthai->imu_sink = sinks->imu;
 	}
+	if (depthai->want_features && depthai->features.func != nullptr) {
+		os_thread_helper_start(&depthai->feature_thread, depthai_feature_mainloop, depthai);
+	}
 	return true;
 }
 
@@ -1062,6 +1185,7 @@ depthai_fs_stream_stop(struct xrt_fs *xfs)
 	// This call fully stops the thread.
 	os_thread_helper_stop_and_wait(&depthai->image_thread);
 	os_thread_helper_stop_and_wait(&depthai->imu_thread);
+	os_thread_helper_stop_and_wait(&depthai->feature_thread);
 
 	return true;
 }
@@ -1188,6 +1312,7 @@ depthai_create_and_do_minimal_setup(void)
 	// Make sure that the thread helper is initialised.
 	os_thread_helper_init(&depthai->image_thread);
 	os_thread_helper_init(&depthai->imu_thread);
+	os_thread_helper_init(&depthai->feature_thread);
 
 	return depthai;
 }
@@ -1237,8 +1362,14 @@ depthai_fs_slam(struct xrt_frame_context *xfctx, struct depthai_slam_startup_set
 	depthai->fps = settings->frames_per_second;
 	depthai->want_cameras = settings->want_cameras;
 	depthai->want_imu = settings->want_imu;
+	depthai->want_features = settings->want_features || debug_get_bool_option_depthai_feature_tracker();
 	depthai->half_size_ov9282 = settings->half_size_ov9282;
 
+	if (depthai->want_features) {
+		u_var_add_ro_i32(depthai, &depthai->features.last_count[0], "Left features");
+		u_var_add_ro_i32(depthai, &depthai->features.last_count[1], "Right features");
+	}
+
 	// Last bit is to setup the pipeline.
 	depthai_setup_stereo_grayscale_pipeline(depthai);
 
@@ -1324,3 +1455,12 @@ depthai_fs_get_stereo_calibration(struct xrt_fs *xfs, struct t_stereo_camera_cal
 
 	return depthai_get_gray_cameras_calibration(depthai, c_ptr);
 }
+
+extern "C" void
+depthai_fs_set_features_callback(struct xrt_fs *xfs, depthai_features_func_t func, void *user)
+{
+	struct depthai_fs *depthai = depthai_fs(xfs);
+
+	depthai->features.func = func;
+	depthai->features.user = user;
+}
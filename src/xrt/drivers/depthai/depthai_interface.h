@@ -32,10 +32,41 @@ struct depthai_slam_startup_settings
 {
 	bool want_cameras;
 	bool want_imu;
+	//! Run the feature tracker on the device, works with or without @ref want_cameras.
+	bool want_features;
 	bool half_size_ov9282;
 	int frames_per_second;
 };
 
+/*!
+ * One feature tracked on the device, in pixels of the camera it came from.
+ *
+ * @ingroup drv_depthai
+ */
+struct depthai_feature
+{
+	float x, y;
+
+	//! Stays the same for as long as the feature is tracked.
+	uint32_t id;
+
+	//! Number of frames the feature has been tracked for.
+	uint32_t age;
+};
+
+/*!
+ * Called from the feature thread with the features of one camera for the frame
+ * at @p timestamp_ns, @p camera_index is 0 for left and 1 for right. The
+ * features are only valid during the call.
+ *
+ * @ingroup drv_depthai
+ */
+typedef void (*depthai_features_func_t)(void *user,
+                                        uint32_t camera_index,
+                                        uint64_t timestamp_ns,
+                                        const struct depthai_feature *features,
+                                        uint32_t feature_count);
+
 int
 depthai_3dof_device_found(struct xrt_prober *xp,
                           struct xrt_prober_device **devices,
@@ -86,6 +117,16 @@ depthai_fs_stereo_rgb(struct xrt_frame_context *xfctx);
 bool
 depthai_fs_get_stereo_calibration(struct xrt_fs *xfs, struct t_stereo_camera_calibration **c_ptr);
 
+/*!
+ * Set where the features tracked on the device go, must be called before the
+ * stream is started. Does nothing unless the frameserver was created with
+ * @ref depthai_slam_startup_settings::want_features set.
+ *
+ * @ingroup drv_depthai
+ */
+void
+depthai_fs_set_features_callback(struct xrt_fs *xfs, depthai_features_func_t func, void *user);
+
 
 #ifdef __cplusplus
 }
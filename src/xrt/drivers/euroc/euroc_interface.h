@@ -16,6 +16,8 @@
 extern "C" {
 #endif
 
+struct t_slam_stats;
+
 /*!
  * @defgroup drv_euroc Euroc driver
  * @ingroup drv
@@ -47,6 +49,7 @@ struct euroc_player_playback_config
 	bool use_source_ts;       //!< If true, use the original timestamps from the dataset
 	bool play_from_start;     //!< If set, the euroc player does not wait for user input to start
 	bool print_progress;      //!< Whether to print progress to stdout (useful for CLI runs)
+	uint32_t read_ahead;      //!< How many frames to read and decode ahead of playback, 0 disables
 };
 
 /*!
@@ -108,6 +111,7 @@ euroc_create_auto_prober(void);
  * @param euroc_path Dataset path
  * @param slam_config Path to config file for the SLAM system
  * @param output_path Path to write resulting tracking data to
+ * @param[out] out_stats Accuracy and timing of the run, can be NULL
  *
  * @ingroup drv_euroc
  */
@@ -115,7 +119,8 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit);
+                  const volatile bool *should_exit,
+                  struct t_slam_stats *out_stats);
 
 /*!
  * @dir drivers/euroc
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <deque>
 #include <stdint.h>
 #include <stdio.h>
 #include <fstream>
@@ -48,6 +49,7 @@ DEBUG_GET_ONCE_BOOL_OPTION(send_all_imus_first, "EUROC_SEND_ALL_IMUS_FIRST", fal
 DEBUG_GET_ONCE_BOOL_OPTION(use_source_ts, "EUROC_USE_SOURCE_TS", false)
 DEBUG_GET_ONCE_BOOL_OPTION(play_from_start, "EUROC_PLAY_FROM_START", false)
 DEBUG_GET_ONCE_BOOL_OPTION(print_progress, "EUROC_PRINT_PROGRESS", false)
+DEBUG_GET_ONCE_NUM_OPTION(read_ahead, "EUROC_READ_AHEAD", 4)
 
 #define EUROC_PLAYER_STR "Euroc Player"
 
@@ -55,6 +57,8 @@ DEBUG_GET_ONCE_BOOL_OPTION(print_progress, "EUROC_PRINT_PROGRESS", false)
 #define EUROC_MAX_CAMS XRT_TRACKING_MAX_SLAM_CAMS
 
 using std::async;
+using std::deque;
+using std::future;
 using std::find_if;
 using std::ifstream;
 using std::is_same_v;
@@ -72,6 +76,15 @@ using imu_samples = vector<xrt_imu_sample>;
 using img_samples = vector<img_sample>;
 using gt_trajectory = vector<xrt_pose_sample>;
 
+//! Images of one frame number being read and decoded in the background.
+struct euroc_player_read_ahead_frame
+{
+	uint64_t seq;
+	bool color;
+	float scale;
+	vector<future<cv::Mat>> imgs; //!< One per camera
+};
+
 enum euroc_player_ui_state
 {
 	UNINITIALIZED = 0,
@@ -115,6 +128,9 @@ struct euroc_player
 	vector<img_samples> *imgs; //!< List of all image names to read from the dataset per camera
 	gt_trajectory *gt;         //!< List of all groundtruth poses read from the dataset
 
+	//! Frames after `img_seq` being read ahead, only touched by the image streaming thread.
+	deque<euroc_player_read_ahead_frame> *read_ahead;
+
 	// Timestamp correction fields (can be disabled through `use_source_ts`)
 	timepoint_ns base_ts;   //!< First sample timestamp, stream timestamps are relative to this
 	timepoint_ns start_ts;  //!< When did the dataset started to be played
@@ -422,21 +438,10 @@ euroc_player_mapped_playback_ts(struct euroc_player *ep, timepoint_ns ts)
 	return euroc_player_mapped_ts(ep, ts);
 }
 
-static void
-euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_frame *&xf)
+//! Reads an image from disk, can be called from any thread.
+static cv::Mat
+euroc_player_read_img(const string &img_name, bool allow_color, float scale)
 {
-	using xrt::auxiliary::tracking::FrameMat;
-	img_sample sample = ep->imgs->at(cam_index).at(ep->img_seq);
-	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
-
-	// Load will be influenced by these playback options
-	bool allow_color = ep->playback.color;
-	float scale = ep->playback.scale;
-
-	// Load image from disk
-	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
-	string img_name = sample.second;
-	EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, timestamp, img_name.c_str());
 	cv::ImreadModes read_mode = allow_color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
 	cv::Mat img = cv::imread(img_name, read_mode); // If colored, reads in BGR order
 
@@ -446,6 +451,61 @@ euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_
 		img = tmp;
 	}
 
+	return img;
+}
+
+/*!
+ * Gets the images of every camera for frame `img_seq`, and starts reading the
+ * next `read_ahead` frames in the background.
+ */
+static vector<cv::Mat>
+euroc_player_read_next_imgs(struct euroc_player *ep, int cam_count)
+{
+	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
+
+	// Load will be influenced by these playback options
+	bool allow_color = ep->playback.color;
+	float scale = ep->playback.scale;
+
+	deque<euroc_player_read_ahead_frame> &queue = *ep->read_ahead;
+
+	// Throw away what was read with other options, or would be out of order
+	bool stale = !queue.empty() && (queue.front().seq != ep->img_seq || queue.back().color != allow_color ||
+	                                queue.back().scale != scale || queue.back().imgs.size() != (size_t)cam_count);
+	if (stale) {
+		queue.clear();
+	}
+
+	uint64_t next_seq = queue.empty() ? ep->img_seq : queue.back().seq + 1;
+	uint64_t frame_count = ep->imgs->at(0).size();
+	while (queue.size() <= ep->playback.read_ahead && next_seq < frame_count) {
+		euroc_player_read_ahead_frame frame{next_seq, allow_color, scale, {}};
+		for (int i = 0; i < cam_count; i++) {
+			string img_name = ep->imgs->at(i).at(next_seq).second;
+			frame.imgs.push_back(async(launch::async, euroc_player_read_img, img_name, allow_color, scale));
+		}
+		queue.push_back(std::move(frame));
+		next_seq++;
+	}
+
+	vector<cv::Mat> imgs;
+	for (future<cv::Mat> &img : queue.front().imgs) {
+		imgs.push_back(img.get());
+	}
+	queue.pop_front();
+
+	return imgs;
+}
+
+static void
+euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, cv::Mat &img, struct xrt_frame *&xf)
+{
+	using xrt::auxiliary::tracking::FrameMat;
+	img_sample sample = ep->imgs->at(cam_index).at(ep->img_seq);
+
+	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
+	EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, timestamp, sample.second.c_str());
+
 	// Create xrt_frame, it will be freed by FrameMat destructor
 	EUROC_ASSERT(xf == NULL || xf->reference.count > 0, "Must be given a valid or NULL frame ptr");
 	EUROC_ASSERT(timestamp >= 0, "Unexpected negative timestamp");
@@ -467,9 +527,11 @@ euroc_player_push_next_frame(struct euroc_player *ep)
 {
 	int cam_count = ep->playback.cam_count;
 
+	vector<cv::Mat> imgs = euroc_player_read_next_imgs(ep, cam_count);
+
 	vector<xrt_frame *> xfs(cam_count, nullptr);
 	for (int i = 0; i < cam_count; i++) {
-		euroc_player_load_next_frame(ep, i, xfs[i]);
+		euroc_player_load_next_frame(ep, i, imgs[i], xfs[i]);
 	}
 
 	// TODO: Some SLAM systems expect synced frames, but that's not an
@@ -632,6 +694,9 @@ euroc_player_stream(void *ptr)
 	serve_imgs.get();
 	serve_imus.get();
 
+	// Wait for any frames still being read ahead if stopped early
+	ep->read_ahead->clear();
+
 	ep->is_running = false;
 
 	EUROC_INFO(ep, "Euroc dataset playback finished");
@@ -801,6 +866,7 @@ euroc_player_destroy(struct xrt_frame_node *node)
 	delete ep->gt;
 	delete ep->imus;
 	delete ep->imgs;
+	delete ep->read_ahead;
 
 	u_var_remove_root(ep);
 	for (int i = 0; i < ep->dataset.cam_count; i++) {
@@ -946,6 +1012,7 @@ euroc_player_fill_default_config_for(struct euroc_player_config *config, const c
 	playback.use_source_ts = debug_get_bool_option_use_source_ts();
 	playback.play_from_start = debug_get_bool_option_play_from_start();
 	playback.print_progress = debug_get_bool_option_print_progress();
+	playback.read_ahead = (uint32_t)MAX(debug_get_num_option_read_ahead(), 0);
 
 	config->log_level = debug_get_log_option_euroc_log();
 	config->dataset = dataset;
@@ -990,6 +1057,7 @@ euroc_player_create(struct xrt_frame_context *xfctx, const char *path, struct eu
 	ep->gt = new gt_trajectory{};
 	ep->imus = new imu_samples{};
 	ep->imgs = new vector<img_samples>(ep->dataset.cam_count);
+	ep->read_ahead = new deque<euroc_player_read_ahead_frame>{};
 
 	euroc_player_setup_gui(ep);
 
@@ -27,7 +27,8 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit)
+                  const volatile bool *should_exit,
+                  struct t_slam_stats *out_stats)
 {}
 
 #else
@@ -77,6 +78,12 @@ make_slam_tracker_config(const char *slam_config, const char *output_path)
 	if (getenv("SLAM_WRITE_CSVS") == NULL) {
 		st_config->write_csvs = true;
 	}
+	if (getenv("SLAM_LOCKSTEP") == NULL) {
+		st_config->lockstep = true;
+	}
+	if (getenv("SLAM_TIMING_STAT") == NULL) {
+		st_config->timing_stat = true;
+	}
 
 	st_config->slam_config = slam_config;
 	st_config->csv_path = output_path;
@@ -88,7 +95,8 @@ void
 euroc_run_dataset(const char *euroc_path,
                   const char *slam_config,
                   const char *output_path,
-                  const volatile bool *should_exit)
+                  const volatile bool *should_exit,
+                  struct t_slam_stats *out_stats)
 {
 	struct euroc_player_config *ep_config = make_euroc_player_config(euroc_path);
 	struct t_slam_tracker_config *st_config = make_slam_tracker_config(slam_config, output_path);
@@ -125,6 +133,10 @@ euroc_run_dataset(const char *euroc_path,
 		streaming = xrt_fs_is_running(xfs);
 	}
 
+	if (out_stats != NULL) {
+		t_slam_get_stats(xts, out_stats);
+	}
+
 	xrt_frame_context_destroy_nodes(&xfctx);
 	free(st_config);
 	free(ep_config);
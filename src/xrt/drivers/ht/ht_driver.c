@@ -162,6 +162,20 @@ ht_device_get_hand_tracking(struct xrt_device *xdev,
 	htd->async->get_hand(htd->async, name, at_timestamp_ns, out_value, out_timestamp_ns);
 }
 
+static xrt_result_t
+ht_device_set_feature_enabled(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled)
+{
+	struct ht_device *htd = ht_device(xdev);
+
+	if (type != XRT_DEVICE_FEATURE_HAND_TRACKING) {
+		return XRT_ERROR_FEATURE_NOT_SUPPORTED;
+	}
+
+	htd->async->set_paused(htd->async, !enabled);
+
+	return XRT_SUCCESS;
+}
+
 static void
 ht_device_destroy(struct xrt_device *xdev)
 {
@@ -210,6 +224,7 @@ ht_device_create_common(struct t_stereo_camera_calibration *calib,
 
 	htd->base.update_inputs = u_device_noop_update_inputs;
 	htd->base.get_hand_tracking = ht_device_get_hand_tracking;
+	htd->base.set_feature_enabled = ht_device_set_feature_enabled;
 	htd->base.destroy = ht_device_destroy;
 
 	snprintf(htd->base.str, XRT_DEVICE_NAME_LEN, "Camera based Hand Tracker");
@@ -13,6 +13,7 @@
 #include "xrt/xrt_device.h"
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 
 #include "math/m_api.h"
 #include "math/m_space.h"
@@ -56,6 +57,31 @@ static enum xrt_space_relation_flags valid_flags = (enum xrt_space_relation_flag
     XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
     XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
 
+/*!
+ * The hand as last fetched from the hand tracker, apps ask for several poses
+ * per hand each frame all at the same time.
+ */
+struct cemu_hand_cache
+{
+	//! Time asked for, zero if empty.
+	uint64_t at_timestamp_ns;
+
+	uint64_t hand_timestamp_ns;
+	struct xrt_hand_joint_set joint_set;
+};
+
+//! Emulated poses derived from the hand for a single time.
+struct cemu_pose_cache
+{
+	//! Time asked for, zero if empty.
+	uint64_t at_timestamp_ns;
+
+	bool grip_valid;
+	bool aim_valid;
+	struct xrt_space_relation grip;
+	struct xrt_space_relation aim;
+};
+
 struct cemu_system
 {
 	// We don't own the head - never free this
@@ -71,6 +97,20 @@ struct cemu_system
 	float waggle, curl, twist;
 
 	enum u_logging_level log_level;
+
+	/*!
+	 * Guards the caches, never held while calling into other devices.
+	 * Both hands go through the same entries, so the secondary hand used by
+	 * the aim pose is also shared.
+	 */
+	struct os_mutex cache_mutex;
+	struct cemu_hand_cache hands[2];
+
+	struct
+	{
+		uint64_t at_timestamp_ns;
+		struct xrt_pose pose;
+	} head;
 };
 
 struct cemu_device
@@ -82,6 +122,9 @@ struct cemu_device
 	enum xrt_input_name ht_input_name;
 
 	struct xrt_tracking_origin tracking_origin;
+
+	//! Protected by @ref cemu_system::cache_mutex.
+	struct cemu_pose_cache poses;
 };
 
 xrt_quat
@@ -112,6 +155,55 @@ cemu_device(struct xrt_device *xdev)
 	return (struct cemu_device *)xdev;
 }
 
+static void
+get_hand_cached(struct cemu_system *sys,
+                int hand_index,
+                uint64_t at_timestamp_ns,
+                struct xrt_hand_joint_set *out_value,
+                uint64_t *out_timestamp_ns)
+{
+	struct cemu_hand_cache *cache = &sys->hands[hand_index];
+
+	os_mutex_lock(&sys->cache_mutex);
+	if (at_timestamp_ns != 0 && cache->at_timestamp_ns == at_timestamp_ns) {
+		*out_value = cache->joint_set;
+		*out_timestamp_ns = cache->hand_timestamp_ns;
+		os_mutex_unlock(&sys->cache_mutex);
+		return;
+	}
+	os_mutex_unlock(&sys->cache_mutex);
+
+	enum xrt_input_name name = sys->out_hand[hand_index]->ht_input_name;
+	xrt_device_get_hand_tracking(sys->in_hand, name, at_timestamp_ns, out_value, out_timestamp_ns);
+
+	os_mutex_lock(&sys->cache_mutex);
+	cache->at_timestamp_ns = at_timestamp_ns;
+	cache->hand_timestamp_ns = *out_timestamp_ns;
+	cache->joint_set = *out_value;
+	os_mutex_unlock(&sys->cache_mutex);
+}
+
+static void
+get_head_cached(struct cemu_system *sys, uint64_t at_timestamp_ns, struct xrt_pose *out_pose)
+{
+	os_mutex_lock(&sys->cache_mutex);
+	if (at_timestamp_ns != 0 && sys->head.at_timestamp_ns == at_timestamp_ns) {
+		*out_pose = sys->head.pose;
+		os_mutex_unlock(&sys->cache_mutex);
+		return;
+	}
+	os_mutex_unlock(&sys->cache_mutex);
+
+	struct xrt_space_relation head_rel;
+	xrt_device_get_tracked_pose(sys->in_head, XRT_INPUT_GENERIC_HEAD_POSE, at_timestamp_ns, &head_rel);
+	*out_pose = head_rel.pose;
+
+	os_mutex_lock(&sys->cache_mutex);
+	sys->head.at_timestamp_ns = at_timestamp_ns;
+	sys->head.pose = head_rel.pose;
+	os_mutex_unlock(&sys->cache_mutex);
+}
+
 
 static void
 cemu_device_destroy(struct xrt_device *xdev)
@@ -127,6 +219,7 @@ cemu_device_destroy(struct xrt_device *xdev)
 	if ((system->out_hand[0] == NULL) && (system->out_hand[1] == NULL)) {
 		xrt_device_destroy(&system->in_hand);
 		u_var_remove_root(system);
+		os_mutex_destroy(&system->cache_mutex);
 		free(system);
 	}
 }
@@ -149,8 +242,7 @@ cemu_device_get_hand_tracking(struct xrt_device *xdev,
 		return;
 	}
 
-	xrt_device_get_hand_tracking(system->in_hand, dev->ht_input_name, requested_timestamp_ns, out_value,
-	                             out_timestamp_ns);
+	get_hand_cached(system, dev->hand_index, requested_timestamp_ns, out_value, out_timestamp_ns);
 }
 
 static xrt_vec3
@@ -222,9 +314,7 @@ get_other_two(struct cemu_device *dev,
               xrt_pose *out_head,
               xrt_hand_joint_set *out_secondary)
 {
-	struct xrt_space_relation head_rel;
-	xrt_device_get_tracked_pose(dev->sys->in_head, XRT_INPUT_GENERIC_HEAD_POSE, head_timestamp_ns, &head_rel);
-	*out_head = head_rel.pose;
+	get_head_cached(dev->sys, head_timestamp_ns, out_head);
 	int other;
 	if (dev->hand_index == 0) {
 		other = 1;
@@ -233,8 +323,7 @@ get_other_two(struct cemu_device *dev,
 	}
 	uint64_t noop;
 
-	xrt_device_get_hand_tracking(dev->sys->in_hand, dev->sys->out_hand[other]->ht_input_name, hand_timestamp_ns,
-	                             out_secondary, &noop);
+	get_hand_cached(dev->sys, other, hand_timestamp_ns, out_secondary, &noop);
 }
 
 // Mostly stolen from
@@ -329,32 +418,57 @@ cemu_device_get_tracked_pose(struct xrt_device *xdev,
 		CEMU_ERROR(dev, "unknown input name %d for controller pose", name);
 		return;
 	}
-	static uint64_t hand_timestamp_ns;
 
-	struct xrt_hand_joint_set joint_set;
-	sys->in_hand->get_hand_tracking(sys->in_hand, dev->ht_input_name, at_timestamp_ns, &joint_set,
-	                                &hand_timestamp_ns);
+	bool is_grip = name == XRT_INPUT_SIMPLE_GRIP_POSE;
+	struct cemu_pose_cache *cache = &dev->poses;
 
-	if (joint_set.is_active == false) {
-		out_relation->relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
-		return;
+	os_mutex_lock(&sys->cache_mutex);
+	if (at_timestamp_ns != 0 && cache->at_timestamp_ns == at_timestamp_ns) {
+		if (is_grip && cache->grip_valid) {
+			*out_relation = cache->grip;
+			os_mutex_unlock(&sys->cache_mutex);
+			return;
+		}
+		if (!is_grip && cache->aim_valid) {
+			*out_relation = cache->aim;
+			os_mutex_unlock(&sys->cache_mutex);
+			return;
+		}
 	}
+	os_mutex_unlock(&sys->cache_mutex);
 
+	uint64_t hand_timestamp_ns;
+	struct xrt_hand_joint_set joint_set;
+	get_hand_cached(sys, dev->hand_index, at_timestamp_ns, &joint_set, &hand_timestamp_ns);
 
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
 
-	switch (name) {
-	case XRT_INPUT_SIMPLE_GRIP_POSE: {
-		do_grip_pose(&joint_set, out_relation, sys->grip_offset_from_palm, dev->hand_index);
-		break;
-	}
-	case XRT_INPUT_SIMPLE_AIM_POSE: {
+	if (!joint_set.is_active) {
+		relation.relation_flags = XRT_SPACE_RELATION_BITMASK_NONE;
+	} else if (is_grip) {
+		do_grip_pose(&joint_set, &relation, sys->grip_offset_from_palm, dev->hand_index);
+	} else {
 		// Assume that now we're doing everything in the timestamp from the hand-tracker, so use
 		// hand_timestamp_ns. This will cause the controller to lag behind but otherwise be correct
-		do_aim_pose(dev, &joint_set, at_timestamp_ns, hand_timestamp_ns, out_relation);
-		break;
+		do_aim_pose(dev, &joint_set, at_timestamp_ns, hand_timestamp_ns, &relation);
 	}
-	default: assert(false);
+
+	*out_relation = relation;
+
+	os_mutex_lock(&sys->cache_mutex);
+	if (cache->at_timestamp_ns != at_timestamp_ns) {
+		cache->at_timestamp_ns = at_timestamp_ns;
+		cache->grip_valid = false;
+		cache->aim_valid = false;
 	}
+	if (is_grip) {
+		cache->grip = relation;
+		cache->grip_valid = true;
+	} else {
+		cache->aim = relation;
+		cache->aim_valid = true;
+	}
+	os_mutex_unlock(&sys->cache_mutex);
 }
 
 static void
@@ -418,6 +532,9 @@ cemu_devices_create(struct xrt_device *head, struct xrt_device *hands, struct xr
 
 	system->log_level = debug_get_log_option_cemu_log();
 
+	// In reality never fails.
+	os_mutex_init(&system->cache_mutex);
+
 	system->grip_offset_from_palm = 0.03f; // 3 centimeters
 
 	for (int i = 0; i < 2; i++) {
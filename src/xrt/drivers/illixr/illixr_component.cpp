@@ -10,6 +10,11 @@
 
 #include "xrt/xrt_device.h"
 
+#include "os/os_time.h"
+#include "math/m_clock_offset.h"
+
+#include <mutex>
+#include <chrono>
 #include <iostream>
 #include "common/plugin.hpp"
 #include "common/phonebook.hpp"
@@ -29,6 +34,12 @@ public:
 
 	const std::shared_ptr<switchboard> sb;
 	const std::shared_ptr<pose_prediction> sb_pose;
+
+	//! Guards @ref monotonic_to_illixr_ns, poses are read from many threads.
+	std::mutex clock_mutex;
+
+	//! Filtered offset from the Monado monotonic clock to the ILLIXR clock.
+	time_duration_ns monotonic_to_illixr_ns{0};
 };
 
 static illixr_plugin *illixr_plugin_obj = nullptr;
@@ -41,25 +52,60 @@ illixr_monado_create_plugin(phonebook *pb)
 	return illixr_plugin_obj;
 }
 
-extern "C" struct xrt_pose
-illixr_read_pose()
+static timepoint_ns
+illixr_time_to_ns(time_type time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+static time_type
+ns_to_illixr_time(timepoint_ns time_ns)
+{
+	return time_type{std::chrono::duration_cast<time_type::duration>(std::chrono::nanoseconds{time_ns})};
+}
+
+/*!
+ * Samples both clocks back to back and returns the smoothed offset, done on
+ * every read so it follows the ILLIXR wall clock as it is slewed.
+ */
+static time_duration_ns
+update_clock_offset()
+{
+	timepoint_ns monotonic_ns = (timepoint_ns)os_monotonic_get_ns();
+	timepoint_ns illixr_ns = illixr_time_to_ns(std::chrono::system_clock::now());
+
+	std::unique_lock<std::mutex> lock(illixr_plugin_obj->clock_mutex);
+	m_clock_offset_a2b(1000.f, monotonic_ns, illixr_ns, &illixr_plugin_obj->monotonic_to_illixr_ns);
+	return illixr_plugin_obj->monotonic_to_illixr_ns;
+}
+
+extern "C" bool
+illixr_read_pose(uint64_t at_timestamp_ns, struct xrt_pose *out_pose, uint64_t *out_timestamp_ns)
 {
 	assert(illixr_plugin_obj && "illixr_plugin_obj must be initialized first.");
 
-	if (!illixr_plugin_obj->sb_pose->fast_pose_reliable()) {
+	bool reliable = illixr_plugin_obj->sb_pose->fast_pose_reliable();
+	if (!reliable) {
 		std::cerr << "Pose not reliable yet; returning best guess" << std::endl;
 	}
-	struct xrt_pose ret;
-	const fast_pose_type fast_pose = illixr_plugin_obj->sb_pose->get_fast_pose();
+
+	time_duration_ns monotonic_to_illixr_ns = update_clock_offset();
+
+	// Let ILLIXR predict to the display time asked for, it knows its own latency.
+	time_type target_time = ns_to_illixr_time((timepoint_ns)at_timestamp_ns + monotonic_to_illixr_ns);
+	const fast_pose_type fast_pose = illixr_plugin_obj->sb_pose->get_fast_pose(target_time);
 	const pose_type pose = fast_pose.pose;
 
-	ret.orientation.x = pose.orientation.x();
-	ret.orientation.y = pose.orientation.y();
-	ret.orientation.z = pose.orientation.z();
-	ret.orientation.w = pose.orientation.w();
-	ret.position.x = pose.position.x();
-	ret.position.y = pose.position.y();
-	ret.position.z = pose.position.z();
+	out_pose->orientation.x = pose.orientation.x();
+	out_pose->orientation.y = pose.orientation.y();
+	out_pose->orientation.z = pose.orientation.z();
+	out_pose->orientation.w = pose.orientation.w();
+	out_pose->position.x = pose.position.x();
+	out_pose->position.y = pose.position.y();
+	out_pose->position.z = pose.position.z();
+
+	// The plugin may clamp how far it predicts, report the time it predicted to.
+	*out_timestamp_ns = (uint64_t)(illixr_time_to_ns(fast_pose.predict_target_time) - monotonic_to_illixr_ns);
 
-	return ret;
+	return reliable;
 }
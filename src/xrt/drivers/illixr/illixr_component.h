@@ -9,14 +9,22 @@
 
 #pragma once
 
+#include "xrt/xrt_defines.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void *
 illixr_monado_create_plugin(void *pb);
-struct xrt_pose
-illixr_read_pose();
+
+/*!
+ * Read the pose ILLIXR predicts for @p at_timestamp_ns, in the Monado monotonic
+ * clock. Writes the time the pose was predicted to, in the same clock, to
+ * @p out_timestamp_ns. Returns false if ILLIXR does not trust the pose yet.
+ */
+bool
+illixr_read_pose(uint64_t at_timestamp_ns, struct xrt_pose *out_pose, uint64_t *out_timestamp_ns);
 
 #ifdef __cplusplus
 }
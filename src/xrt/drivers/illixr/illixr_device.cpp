@@ -9,6 +9,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,6 +20,7 @@
 #include <sstream>
 
 #include "math/m_api.h"
+#include "math/m_relation_history.h"
 #include "xrt/xrt_device.h"
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -43,6 +45,9 @@ struct illixr_hmd
 
 	struct xrt_pose pose;
 
+	//! Predicted poses handed out, so callers asking for the same time agree.
+	struct m_relation_history *relation_hist;
+
 	bool print_spew;
 	bool print_debug;
 
@@ -101,6 +106,8 @@ illixr_hmd_destroy(struct xrt_device *xdev)
 	delete dh->runtime;
 	delete dh->runtime_lib;
 
+	m_relation_history_destroy(&dh->relation_hist);
+
 	// Remove the variable tracking.
 	u_var_remove_root(dh);
 
@@ -118,10 +125,32 @@ illixr_hmd_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	out_relation->pose = illixr_read_pose();
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(
-	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
-	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+	struct illixr_hmd *dh = illixr_hmd(xdev);
+
+	// Times up to the newest prediction are answered from the history.
+	uint64_t latest_ns = 0;
+	struct xrt_space_relation latest = XRT_SPACE_RELATION_ZERO;
+	if (!m_relation_history_get_latest(dh->relation_hist, &latest_ns, &latest) || at_timestamp_ns > latest_ns) {
+		struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+		uint64_t timestamp_ns = 0;
+
+		bool reliable = illixr_read_pose(at_timestamp_ns, &relation.pose, &timestamp_ns);
+		relation.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+		                                                          XRT_SPACE_RELATION_POSITION_VALID_BIT);
+		if (reliable) {
+			relation.relation_flags = (enum xrt_space_relation_flags)(
+			    relation.relation_flags | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+			    XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+		}
+
+		// Fails if another thread pushed a newer one meanwhile, fine.
+		m_relation_history_push(dh->relation_hist, &relation, timestamp_ns);
+		dh->pose = relation.pose;
+
+		DH_SPEW(dh, "predicted to %" PRIu64 " for %" PRIu64, timestamp_ns, at_timestamp_ns);
+	}
+
+	m_relation_history_get(dh->relation_hist, at_timestamp_ns, out_relation);
 }
 
 std::vector<std::string>
@@ -166,6 +195,7 @@ illixr_hmd_create(const char *path_in, const char *comp_in)
 	dh->base.hmd->blend_mode_count = idx;
 
 	dh->pose.orientation.w = 1.0f; // All other values set to zero.
+	m_relation_history_create(&dh->relation_hist);
 	dh->print_spew = debug_get_bool_option_illixr_spew();
 	dh->print_debug = debug_get_bool_option_illixr_debug();
 	dh->path = path_in;
@@ -209,6 +209,14 @@ compute_distortion(struct xrt_device *xdev, uint32_t view, float u, float v, str
 	return target->compute_distortion(target, view, u, v, result);
 }
 
+static xrt_result_t
+set_feature_enabled(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled)
+{
+	struct multi_device *d = (struct multi_device *)xdev;
+	struct xrt_device *target = d->tracking_override.target;
+	return xrt_device_set_feature_enabled(target, type, enabled);
+}
+
 static void
 update_inputs(struct xrt_device *xdev)
 {
@@ -262,5 +270,11 @@ multi_create_tracking_override(enum xrt_tracking_override_type override_type,
 	d->base.compute_distortion = compute_distortion;
 	d->base.get_view_poses = get_view_poses;
 
+	// Copied from the target above, but it must be called with the target.
+	d->base.set_feature_enabled = NULL;
+	if (tracking_override_target->set_feature_enabled != NULL) {
+		d->base.set_feature_enabled = set_feature_enabled;
+	}
+
 	return &d->base;
 }
@@ -284,3 +284,31 @@ ns_3d_display_uv_to_render_uv(struct xrt_vec2 in, struct xrt_vec2 *out, struct n
 	out->x = outUV.x;
 	out->y = outUV.y;
 }
+
+extern "C" void
+ns_3d_bake_lut(struct ns_3d_eye *eye, uint32_t size, struct xrt_vec2 *out_lut)
+{
+	OpticalSystem *opticalSystem = (OpticalSystem *)eye->optical_system;
+	// Same as the first solve of a point, the seeds are better than the centre.
+	int iterations = 50;
+
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			Vector2 inUV = Vector2((float)x / (float)(size - 1), 1.f - (float)y / (float)(size - 1));
+
+			// Neighbouring points are close, start from the one before or the one above.
+			Vector2 seed = Vector2(0.5f, 0.5f);
+			if (x > 0) {
+				struct xrt_vec2 prev = out_lut[y * size + x - 1];
+				seed = Vector2(prev.x, prev.y);
+			} else if (y > 0) {
+				struct xrt_vec2 above = out_lut[(y - 1) * size];
+				seed = Vector2(above.x, above.y);
+			}
+
+			Vector2 outUV = opticalSystem->SolveDisplayUVToRenderUV(inUV, seed, iterations);
+			out_lut[y * size + x].x = outUV.x;
+			out_lut[y * size + x].y = outUV.y;
+		}
+	}
+}
@@ -12,12 +12,16 @@
  * @ingroup drv_ns
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "math/m_mathinclude.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stddef.h>
+#include <inttypes.h>
 
 #include "os/os_time.h"
 
@@ -27,10 +31,13 @@
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_time.h"
+#include "util/u_file.h"
 
 #include "math/m_space.h"
+#include "math/m_vec2.h"
 
 DEBUG_GET_ONCE_LOG_OPTION(ns_log, "NS_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(ns_3d_lut, "NS_3D_LUT", true)
 
 /*
  *
@@ -169,6 +176,141 @@ ns_3d_fov_calculate(struct xrt_quat projection, struct xrt_fov *out_fov)
 	out_fov->angle_down = atanf(projection.w);
 }
 
+/*
+ *
+ * 3D distortion lookup tables.
+ *
+ */
+
+#define LUT_CACHE_MAGIC 0x4c44334e /* "N3DL" */
+
+struct lut_cache_header
+{
+	uint32_t magic;
+	uint32_t size;
+	uint64_t eye_hash;
+};
+
+//! 64 bit FNV-1a of the parsed optics, everything before the optical system pointer.
+static uint64_t
+ns_3d_eye_hash(const struct ns_3d_eye *eye)
+{
+	const uint8_t *bytes = (const uint8_t *)eye;
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	for (size_t i = 0; i < offsetof(struct ns_3d_eye, optical_system); i++) {
+		hash ^= bytes[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+#ifdef XRT_OS_LINUX
+static FILE *
+ns_3d_lut_cache_open(uint64_t eye_hash, const char *mode)
+{
+	char filename[64];
+	snprintf(filename, sizeof(filename), "north_star_3d_lut_%016" PRIx64 ".bin", eye_hash);
+
+	return u_file_open_file_in_cache_dir(filename, mode);
+}
+
+static bool
+ns_3d_lut_cache_load(uint64_t eye_hash, struct xrt_vec2 *lut, size_t count)
+{
+	FILE *file = ns_3d_lut_cache_open(eye_hash, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	struct lut_cache_header header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == LUT_CACHE_MAGIC &&
+	          header.size == NS_3D_LUT_SIZE && header.eye_hash == eye_hash &&
+	          fread(lut, sizeof(*lut), count, file) == count;
+
+	fclose(file);
+
+	return ok;
+}
+
+static void
+ns_3d_lut_cache_store(uint64_t eye_hash, const struct xrt_vec2 *lut, size_t count)
+{
+	FILE *file = ns_3d_lut_cache_open(eye_hash, "wb");
+	if (file == NULL) {
+		return;
+	}
+
+	struct lut_cache_header header = {
+	    .magic = LUT_CACHE_MAGIC,
+	    .size = NS_3D_LUT_SIZE,
+	    .eye_hash = eye_hash,
+	};
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(lut, sizeof(*lut), count, file) == count;
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		U_LOG_W("Failed to write the North Star distortion cache.");
+	}
+}
+#endif
+
+/*!
+ * Solving the optics is iterative and slow, so it's done once for a grid and
+ * only interpolated after that, the grid is kept on disk between runs.
+ */
+static void
+ns_3d_lut_init(struct ns_hmd *ns, struct ns_3d_eye *eye)
+{
+	const size_t count = NS_3D_LUT_SIZE * NS_3D_LUT_SIZE;
+	eye->lut = U_TYPED_ARRAY_CALLOC(struct xrt_vec2, count);
+
+#ifdef XRT_OS_LINUX
+	uint64_t eye_hash = ns_3d_eye_hash(eye);
+	if (ns_3d_lut_cache_load(eye_hash, eye->lut, count)) {
+		NS_DEBUG(ns, "Loaded distortion from cache");
+		return;
+	}
+#endif
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	ns_3d_bake_lut(eye, NS_3D_LUT_SIZE, eye->lut);
+	NS_INFO(ns, "Baked the 3D distortion in %.1fms", time_ns_to_ms_f(os_monotonic_get_ns() - start_ns));
+
+#ifdef XRT_OS_LINUX
+	ns_3d_lut_cache_store(eye_hash, eye->lut, count);
+#endif
+}
+
+static void
+ns_3d_lut_sample(const struct xrt_vec2 *lut, float u, float v, struct xrt_vec2 *out_uv)
+{
+	const int last = NS_3D_LUT_SIZE - 1;
+
+	float fx = CLAMP(u, 0.0f, 1.0f) * (float)last;
+	float fy = CLAMP(v, 0.0f, 1.0f) * (float)last;
+	int x = MIN((int)fx, last - 1);
+	int y = MIN((int)fy, last - 1);
+	float tx = fx - (float)x;
+	float ty = fy - (float)y;
+
+	struct xrt_vec2 top = m_vec2_lerp(lut[y * NS_3D_LUT_SIZE + x], lut[y * NS_3D_LUT_SIZE + x + 1], tx);
+	struct xrt_vec2 bottom =
+	    m_vec2_lerp(lut[(y + 1) * NS_3D_LUT_SIZE + x], lut[(y + 1) * NS_3D_LUT_SIZE + x + 1], tx);
+
+	*out_uv = m_vec2_lerp(top, bottom, ty);
+}
+
+static void
+ns_3d_free(struct ns_3d_values *values)
+{
+	for (int i = 0; i < 2; i++) {
+		ns_3d_free_optical_system(&values->eyes[i].optical_system);
+		free(values->eyes[i].lut);
+		values->eyes[i].lut = NULL;
+	}
+}
+
+
 /*
  *
  * Parse functions.
@@ -231,11 +373,15 @@ ns_3d_parse(struct ns_hmd *ns, const cJSON *json)
 	values->eyes[0].optical_system = ns_3d_create_optical_system(&values->eyes[0]);
 	values->eyes[1].optical_system = ns_3d_create_optical_system(&values->eyes[1]);
 
+	if (debug_get_bool_option_ns_3d_lut()) {
+		ns_3d_lut_init(ns, &values->eyes[0]);
+		ns_3d_lut_init(ns, &values->eyes[1]);
+	}
+
 	return true;
 
 cleanup_l3d:
-	ns_3d_free_optical_system(&values->eyes[0].optical_system);
-	ns_3d_free_optical_system(&values->eyes[1].optical_system);
+	ns_3d_free(values);
 	return false;
 }
 
@@ -357,8 +503,7 @@ ns_hmd_destroy(struct xrt_device *xdev)
 	u_var_remove_root(ns);
 
 	if (ns->config.distortion_type == NS_DISTORTION_TYPE_GEOMETRIC_3D) {
-		ns_3d_free_optical_system(&ns->config.dist_3d.eyes[0].optical_system);
-		ns_3d_free_optical_system(&ns->config.dist_3d.eyes[1].optical_system);
+		ns_3d_free(&ns->config.dist_3d);
 	} else if (ns->config.distortion_type == NS_DISTORTION_TYPE_MOSHI_MESHGRID) {
 		free(ns->config.dist_meshgrid.grid[0]);
 		free(ns->config.dist_meshgrid.grid[1]);
@@ -420,10 +565,15 @@ ns_mesh_calc(struct xrt_device *xdev, uint32_t view, float u, float v, struct xr
 	// struct xrt_vec2 warped_uv;
 	switch (ns->config.distortion_type) {
 	case NS_DISTORTION_TYPE_GEOMETRIC_3D: {
+		struct ns_3d_eye *eye = &ns->config.dist_3d.eyes[view];
 		struct xrt_vec2 uv = {u, v};
 		struct xrt_vec2 warped_uv = {0.0f, 0.0f};
 
-		ns_3d_display_uv_to_render_uv(uv, &warped_uv, &ns->config.dist_3d.eyes[view]);
+		if (eye->lut != NULL) {
+			ns_3d_lut_sample(eye->lut, u, v, &warped_uv);
+		} else {
+			ns_3d_display_uv_to_render_uv(uv, &warped_uv, eye);
+		}
 
 		result->r.x = warped_uv.x;
 		result->r.y = warped_uv.y;
@@ -459,12 +609,12 @@ ns_hmd_create(const cJSON *config_json)
 	    (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD | U_DEVICE_ALLOC_TRACKING_NONE);
 	struct ns_hmd *ns = U_DEVICE_ALLOCATE(struct ns_hmd, flags, 1, 0);
 
-	ns->config_json = config_json;
-	ns_optical_config_parse(ns);
-
 	ns->log_level = debug_get_log_option_ns_log();
 	NS_DEBUG(ns, "Called!");
 
+	ns->config_json = config_json;
+	ns_optical_config_parse(ns);
+
 	ns->base.hmd->distortion.fov[0] = ns->config.fov[0];
 	ns->base.hmd->distortion.fov[1] = ns->config.fov[1];
 
@@ -507,6 +657,11 @@ ns_hmd_create(const cJSON *config_json)
 	ns->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	ns->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 
+	// Lets the compositor generate the distortion on the GPU.
+	if (ns->config.distortion_type == NS_DISTORTION_TYPE_POLYNOMIAL_2D) {
+		u_distortion_ns_p2d_fill_in_model(&ns->base, &ns->config.dist_p2d);
+	}
+
 	// Setup variable tracker.
 	u_var_add_root(ns, "North Star", true);
 	u_var_add_pose(ns, &ns->no_tracker_relation.pose, "pose");
@@ -63,8 +63,18 @@ struct ns_3d_eye
 	struct xrt_matrix_4x4 world_to_screen_space;
 
 	struct ns_optical_system *optical_system;
+
+	//! Display UV to render UV baked from @ref optical_system, row major, @ref NS_3D_LUT_SIZE squared.
+	struct xrt_vec2 *lut;
 };
 
+/*!
+ * Number of points along each side of the baked 3D distortion tables.
+ *
+ * @ingroup drv_ns
+ */
+#define NS_3D_LUT_SIZE (129)
+
 struct ns_3d_values
 {
 	struct ns_3d_eye eyes[2];
@@ -146,6 +156,15 @@ ns_3d_create_optical_system(struct ns_3d_eye *eye);
 void
 ns_3d_free_optical_system(struct ns_optical_system **system);
 
+/*!
+ * Solve the display UV to render UV mapping for a @p size by @p size grid
+ * spanning the whole display, each solve is seeded with its neighbour.
+ *
+ * @ingroup drv_ns
+ */
+void
+ns_3d_bake_lut(struct ns_3d_eye *eye, uint32_t size, struct xrt_vec2 *out_lut);
+
 
 #ifdef __cplusplus
 }
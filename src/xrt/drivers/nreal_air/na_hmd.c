@@ -31,12 +31,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef XRT_OS_LINUX
+#include <poll.h>
+#endif
+
 #define NA_DEBUG(hmd, ...) U_LOG_XDEV_IFL_D(&hmd->base, hmd->log_level, __VA_ARGS__)
 #define NA_ERROR(hmd, ...) U_LOG_XDEV_IFL_E(&hmd->base, hmd->log_level, __VA_ARGS__)
 
 #define SENSOR_BUFFER_SIZE 64
 #define CONTROL_BUFFER_SIZE 64
 
+//! How long the read thread sleeps at most without any reports, so it notices being stopped.
+#define READ_WAIT_TIMEOUT_MS 100
+
 #define SENSOR_HEAD 0xFD
 #define CONTROL_HEAD 0xFD
 
@@ -588,12 +595,38 @@ sensor_read_one_packet(struct na_hmd *hmd)
 	}
 
 	handle_sensor_msg(hmd, buffer, size);
-	return 0;
+	return size;
 }
 
 static int
 read_one_control_packet(struct na_hmd *hmd);
 
+/*!
+ * Sleeps until either device has a report or the timeout expires. The
+ * reports themselves are left for the caller to read.
+ */
+static void
+wait_for_reports(struct na_hmd *hmd, int timeout_ms)
+{
+#ifdef XRT_OS_LINUX
+	int sensor_fd = os_hid_hidraw_get_fd(hmd->hid_sensor);
+	int control_fd = os_hid_hidraw_get_fd(hmd->hid_control);
+	if (sensor_fd >= 0 && control_fd >= 0) {
+		struct pollfd fds[2] = {
+		    {.fd = sensor_fd, .events = POLLIN},
+		    {.fd = control_fd, .events = POLLIN},
+		};
+
+		// Errors and disconnects show up on the following read.
+		poll(fds, 2, timeout_ms);
+		return;
+	}
+#endif
+
+	// No fds to wait on, the sensor reports at 1kHz so this is about one report.
+	os_nanosleep(U_TIME_1MS_IN_NS);
+}
+
 static void *
 read_thread(void *ptr)
 {
@@ -609,10 +642,18 @@ read_thread(void *ptr)
 	while (os_thread_helper_is_running_locked(&hmd->oth) && ret >= 0) {
 		os_thread_helper_unlock(&hmd->oth);
 
-		ret = read_one_control_packet(hmd);
+		wait_for_reports(hmd, READ_WAIT_TIMEOUT_MS);
+
+		// Drain everything that came in while waiting.
+		do {
+			ret = read_one_control_packet(hmd);
+		} while (ret > 0);
 
-		if (ret >= 0) {
+		while (ret >= 0) {
 			ret = sensor_read_one_packet(hmd);
+			if (ret == 0) {
+				break;
+			}
 		}
 
 		os_thread_helper_lock(&hmd->oth);
@@ -1106,6 +1147,7 @@ na_hmd_create_device(struct os_hid_device *sensor_device,
 	hmd->base.get_tracked_pose = na_hmd_get_tracked_pose;
 	hmd->base.get_view_poses = u_device_get_view_poses;
 	hmd->base.compute_distortion = na_hmd_compute_distortion;
+	hmd->base.compute_distortion_thread_safe = true;
 	hmd->base.destroy = na_hmd_destroy;
 	hmd->base.name = XRT_DEVICE_GENERIC_HMD;
 	hmd->base.device_type = XRT_DEVICE_TYPE_HMD;
@@ -12,10 +12,12 @@
 #include "xrt/xrt_prober.h"
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 
 #include "math/m_mathinclude.h"
 #include "math/m_api.h"
 #include "math/m_vec2.h"
+#include "math/m_relation_history.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
@@ -24,6 +26,7 @@
 #include "util/u_time.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_logging.h"
+#include "util/u_trace_marker.h"
 
 #include "oh_device.h"
 
@@ -40,6 +43,8 @@
 DEBUG_GET_ONCE_BOOL_OPTION(ohmd_finite_diff, "OHMD_ALLOW_FINITE_DIFF", true)
 DEBUG_GET_ONCE_LOG_OPTION(ohmd_log, "OHMD_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(ohmd_external, "OHMD_EXTERNAL_DRIVER", false)
+// How often the update thread polls OpenHMD, it has no way to tell us the rate of the devices.
+DEBUG_GET_ONCE_NUM_OPTION(ohmd_update_hz, "OHMD_UPDATE_HZ", 1000)
 
 // Define this if you have the appropriately hacked-up OpenHMD version.
 #undef OHMD_HAVE_ANG_VEL
@@ -118,6 +123,14 @@ struct oh_system
 {
 	struct xrt_tracking_origin base;
 
+	ohmd_context *ctx;
+
+	//! Polls OpenHMD and pushes the poses of all devices into their histories.
+	struct os_thread_helper oth;
+
+	//! OpenHMD is not thread safe, guards all calls into it and @ref devices.
+	struct os_mutex lock;
+
 	struct oh_device *devices[XRT_MAX_DEVICES_PER_PROBE];
 };
 
@@ -135,6 +148,9 @@ struct oh_device
 	int64_t last_update;
 	struct xrt_space_relation last_relation;
 
+	//! Filled by the update thread, pose queries are answered from here.
+	struct m_relation_history *relation_history;
+
 	enum u_logging_level log_level;
 	bool enable_finite_difference;
 
@@ -176,6 +192,10 @@ static void
 oh_device_destroy(struct xrt_device *xdev)
 {
 	struct oh_device *ohd = oh_device(xdev);
+	struct oh_system *sys = ohd->sys;
+
+	// The update thread only touches devices with the lock held.
+	os_mutex_lock(&sys->lock);
 
 	if (ohd->dev != NULL) {
 		ohmd_close_device(ohd->dev);
@@ -184,22 +204,30 @@ oh_device_destroy(struct xrt_device *xdev)
 
 	bool all_null = true;
 	for (int i = 0; i < XRT_MAX_DEVICES_PER_PROBE; i++) {
-		if (ohd->sys->devices[i] == ohd) {
-			ohd->sys->devices[i] = NULL;
+		if (sys->devices[i] == ohd) {
+			sys->devices[i] = NULL;
 		}
 
-		if (ohd->sys->devices[i] != NULL) {
+		if (sys->devices[i] != NULL) {
 			all_null = false;
 		}
 	}
 
+	os_mutex_unlock(&sys->lock);
+
 	if (all_null) {
+		// Stops the thread, nothing else uses the system after this.
+		os_thread_helper_destroy(&sys->oth);
+		os_mutex_destroy(&sys->lock);
+
 		// Remove the variable tracking.
-		u_var_remove_root(ohd->sys);
+		u_var_remove_root(sys);
 
-		free(ohd->sys);
+		free(sys);
 	}
 
+	m_relation_history_destroy(&ohd->relation_history);
+
 	u_device_free(&ohd->base);
 }
 
@@ -302,12 +330,16 @@ oh_device_update_inputs(struct xrt_device *xdev)
 	int control_count;
 	float control_state[256];
 
+	os_mutex_lock(&ohd->sys->lock);
+
 	ohmd_device_geti(ohd->dev, OHMD_CONTROL_COUNT, &control_count);
 	if (control_count > 64)
 		control_count = 64;
 
 	ohmd_device_getf(ohd->dev, OHMD_CONTROLS_STATE, control_state);
 
+	os_mutex_unlock(&ohd->sys->lock);
+
 	if (ohd->ohmd_device_type == OPENHMD_OCULUS_RIFT_CONTROLLER ||
 	    ohd->ohmd_device_type == OPENHMD_GENERIC_CONTROLLER) {
 		update_ohmd_controller(ohd, control_count, control_state);
@@ -350,23 +382,17 @@ check_tracker_pose(struct oh_device *ohd, enum xrt_input_name name)
 	return (ohd->ohmd_device_type == OPENHMD_GENERIC_TRACKER) && name == XRT_INPUT_GENERIC_TRACKER_POSE;
 }
 
+/*!
+ * Reads the current pose of the device out of OpenHMD and pushes it into the
+ * history, called from the update thread right after @p ohmd_ctx_update.
+ */
 static void
-oh_device_get_tracked_pose(struct xrt_device *xdev,
-                           enum xrt_input_name name,
-                           uint64_t at_timestamp_ns,
-                           struct xrt_space_relation *out_relation)
+oh_device_sample_locked(struct oh_device *ohd, uint64_t now)
 {
-	struct oh_device *ohd = oh_device(xdev);
 	struct xrt_quat quat = XRT_QUAT_IDENTITY;
 	struct xrt_vec3 pos = XRT_VEC3_ZERO;
-
-	if (!check_head_pose(ohd, name) && !check_controller_pose(ohd, name) && !check_tracker_pose(ohd, name)) {
-		OHMD_ERROR(ohd, "unknown input name: %d", name);
-		return;
-	}
-
-	ohmd_ctx_update(ohd->ctx);
-	uint64_t now = os_monotonic_get_ns();
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	struct xrt_space_relation *out_relation = &relation;
 
 	//! @todo adjust for latency here
 	ohmd_device_getf(ohd->dev, OHMD_ROTATION_QUAT, &quat.x);
@@ -404,8 +430,7 @@ oh_device_get_tracked_pose(struct xrt_device *xdev,
 		/*! @todo this is a hack - should really get a timestamp on the
 		 * USB data and use that instead.
 		 */
-		*out_relation = ohd->last_relation;
-		OHMD_TRACE(ohd, "GET_TRACKED_POSE (%s) - no new data", ohd->base.str);
+		OHMD_TRACE(ohd, "SAMPLE (%s) - no new data", ohd->base.str);
 		return;
 	}
 
@@ -437,16 +462,78 @@ oh_device_get_tracked_pose(struct xrt_device *xdev,
 		out_relation->relation_flags = (enum xrt_space_relation_flags)(
 		    out_relation->relation_flags | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
 
-		OHMD_TRACE(ohd, "GET_TRACKED_POSE (%s) (%f, %f, %f, %f) (%f, %f, %f)", ohd->base.str, quat.x, quat.y,
-		           quat.z, quat.w, ang_vel.x, ang_vel.y, ang_vel.z);
+		OHMD_TRACE(ohd, "SAMPLE (%s) (%f, %f, %f, %f) (%f, %f, %f)", ohd->base.str, quat.x, quat.y, quat.z,
+		           quat.w, ang_vel.x, ang_vel.y, ang_vel.z);
 	} else {
-		OHMD_TRACE(ohd, "GET_TRACKED_POSE (%s) (%f, %f, %f, %f)", ohd->base.str, quat.x, quat.y, quat.z,
-		           quat.w);
+		OHMD_TRACE(ohd, "SAMPLE (%s) (%f, %f, %f, %f)", ohd->base.str, quat.x, quat.y, quat.z, quat.w);
 	}
 
 	// Update state within driver
 	ohd->last_update = (int64_t)now;
 	ohd->last_relation = *out_relation;
+
+	m_relation_history_push(ohd->relation_history, out_relation, now);
+}
+
+static void
+oh_device_get_tracked_pose(struct xrt_device *xdev,
+                           enum xrt_input_name name,
+                           uint64_t at_timestamp_ns,
+                           struct xrt_space_relation *out_relation)
+{
+	struct oh_device *ohd = oh_device(xdev);
+
+	if (!check_head_pose(ohd, name) && !check_controller_pose(ohd, name) && !check_tracker_pose(ohd, name)) {
+		OHMD_ERROR(ohd, "unknown input name: %d", name);
+		return;
+	}
+
+	// No device I/O here, the update thread keeps the history filled.
+	enum m_relation_history_result res =
+	    m_relation_history_get(ohd->relation_history, at_timestamp_ns, out_relation);
+	if (res == M_RELATION_HISTORY_RESULT_INVALID) {
+		// Nothing sampled yet.
+		*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+	}
+}
+
+static void *
+oh_system_run_thread(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("OpenHMD");
+
+	struct oh_system *sys = (struct oh_system *)ptr;
+	os_thread_helper_name(&sys->oth, "OpenHMD");
+
+	int64_t hz = debug_get_num_option_ohmd_update_hz();
+	int64_t period_ns = U_TIME_1S_IN_NS / (hz > 0 ? hz : 1000);
+
+	os_thread_helper_lock(&sys->oth);
+	while (os_thread_helper_is_running_locked(&sys->oth)) {
+		os_thread_helper_unlock(&sys->oth);
+
+		os_mutex_lock(&sys->lock);
+
+		ohmd_ctx_update(sys->ctx);
+		uint64_t now = os_monotonic_get_ns();
+
+		for (int i = 0; i < XRT_MAX_DEVICES_PER_PROBE; i++) {
+			struct oh_device *ohd = sys->devices[i];
+			if (ohd != NULL && ohd->dev != NULL) {
+				oh_device_sample_locked(ohd, now);
+			}
+		}
+
+		os_mutex_unlock(&sys->lock);
+
+		os_nanosleep(period_ns);
+
+		// Must lock thread before check in while.
+		os_thread_helper_lock(&sys->oth);
+	}
+	os_thread_helper_unlock(&sys->oth);
+
+	return NULL;
 }
 
 
@@ -826,6 +913,7 @@ create_hmd(ohmd_context *ctx, int device_idx, int device_flags)
 	ohd->base.hmd->distortion.models |= XRT_DISTORTION_MODEL_COMPUTE;
 	ohd->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	ohd->base.compute_distortion = compute_distortion_openhmd;
+	ohd->base.compute_distortion_thread_safe = true;
 
 	// Which blend modes does the device support.
 
@@ -1229,6 +1317,13 @@ oh_device_create(ohmd_context *ctx, bool no_hmds, struct xrt_device **out_xdevs)
 	struct oh_system *sys = U_TYPED_CALLOC(struct oh_system);
 	sys->base.type = XRT_TRACKING_TYPE_NONE;
 	sys->base.offset.orientation.w = 1.0f;
+	sys->ctx = ctx;
+
+	if (os_mutex_init(&sys->lock) != 0 || os_thread_helper_init(&sys->oth) != 0) {
+		U_LOG_E("Failed to init threading!");
+		free(sys);
+		return 0;
+	}
 
 	u_var_add_root(sys, "OpenHMD Wrapper", false);
 
@@ -1290,9 +1385,22 @@ oh_device_create(ohmd_context *ctx, bool no_hmds, struct xrt_device **out_xdevs)
 
 	for (int i = 0; i < XRT_MAX_DEVICES_PER_PROBE; i++) {
 		if (sys->devices[i] != NULL) {
+			m_relation_history_create(&sys->devices[i]->relation_history);
 			u_var_add_ro_text(sys, sys->devices[i]->base.str, "OpenHMD Device");
 		}
 	}
 
+	if (created == 0) {
+		os_thread_helper_destroy(&sys->oth);
+		os_mutex_destroy(&sys->lock);
+		u_var_remove_root(sys);
+		free(sys);
+		return 0;
+	}
+
+	if (os_thread_helper_start(&sys->oth, oh_system_run_thread, sys) != 0) {
+		U_LOG_E("Failed to start OpenHMD update thread!");
+	}
+
 	return created;
 }
@@ -8,7 +8,9 @@
  */
 
 #include <string>
-#include <stdexcept>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
 
 #include <map>
 #include "util/u_logging.h"
@@ -16,245 +18,295 @@
 #include "alpha_encoding.h"
 #include "encoding.h"
 
-enum opengloves_alpha_encoding_key
+static_assert(OPENGLOVES_ALPHA_ENCODING_MAX <= 64, "Keys seen in a packet are kept in a 64 bit mask");
+
+//! Values are never larger than @ref OPENGLOVES_ENCODING_MAX_ANALOG_VALUE, stops junk from overflowing.
+#define OPENGLOVES_ALPHA_ENCODING_MAX_VALUE 1000000
+
+enum opengloves_alpha_decoder_state
 {
-	OPENGLOVES_ALPHA_ENCODING_FinThumb,
-	OPENGLOVES_ALPHA_ENCODING_FinSplayThumb,
+	//! Skipping until the next key.
+	OPENGLOVES_ALPHA_DECODER_STATE_KEY,
+	//! In a bracketed long key, like (AB).
+	OPENGLOVES_ALPHA_DECODER_STATE_LONG_KEY,
+	//! Reading the digits after a key.
+	OPENGLOVES_ALPHA_DECODER_STATE_VALUE,
+};
 
-	OPENGLOVES_ALPHA_ENCODING_FinIndex,
-	OPENGLOVES_ALPHA_ENCODING_FinSplayIndex,
+static const std::map<int, std::string> opengloves_alpha_encoding_output_key_string{
+    {OPENGLOVES_ALPHA_ENCODING_FinThumb, "A"},  // thumb force feedback
+    {OPENGLOVES_ALPHA_ENCODING_FinIndex, "B"},  // index force feedback
+    {OPENGLOVES_ALPHA_ENCODING_FinMiddle, "C"}, // middle force feedback
+    {OPENGLOVES_ALPHA_ENCODING_FinRing, "D"},   // ring force feedback
+    {OPENGLOVES_ALPHA_ENCODING_FinPinky, "E"},  // pinky force feedback
+};
 
-	OPENGLOVES_ALPHA_ENCODING_FinMiddle,
-	OPENGLOVES_ALPHA_ENCODING_FinSplayMiddle,
+static bool
+opengloves_alpha_encoding_is_key_letter(char c)
+{
+	return c >= 'A' && c <= 'Z';
+}
 
-	OPENGLOVES_ALPHA_ENCODING_FinRing,
-	OPENGLOVES_ALPHA_ENCODING_FinSplayRing,
+/*!
+ * Short keys are a single letter, A to E are the finger curls.
+ */
+static enum opengloves_alpha_encoding_key
+opengloves_alpha_encoding_short_key(char c)
+{
+	switch (c) {
+	case 'A': return OPENGLOVES_ALPHA_ENCODING_FinThumb;      // whole thumb curl
+	case 'B': return OPENGLOVES_ALPHA_ENCODING_FinIndex;      // whole index curl
+	case 'C': return OPENGLOVES_ALPHA_ENCODING_FinMiddle;     // whole middle curl
+	case 'D': return OPENGLOVES_ALPHA_ENCODING_FinRing;       // whole ring curl
+	case 'E': return OPENGLOVES_ALPHA_ENCODING_FinPinky;      // whole pinky curl
+	case 'F': return OPENGLOVES_ALPHA_ENCODING_JoyX;          // joystick x component
+	case 'G': return OPENGLOVES_ALPHA_ENCODING_JoyY;          // joystick y component
+	case 'H': return OPENGLOVES_ALPHA_ENCODING_JoyBtn;        // joystick button
+	case 'I': return OPENGLOVES_ALPHA_ENCODING_BtnTrg;        // trigger button
+	case 'J': return OPENGLOVES_ALPHA_ENCODING_BtnA;          // A button
+	case 'K': return OPENGLOVES_ALPHA_ENCODING_BtnB;          // B button
+	case 'L': return OPENGLOVES_ALPHA_ENCODING_GesGrab;       // grab gesture (boolean)
+	case 'M': return OPENGLOVES_ALPHA_ENCODING_GesPinch;      // pinch gesture (boolean)
+	case 'N': return OPENGLOVES_ALPHA_ENCODING_BtnMenu;       // system button pressed (opens SteamVR menu)
+	case 'O': return OPENGLOVES_ALPHA_ENCODING_BtnCalib;      // calibration button
+	case 'P': return OPENGLOVES_ALPHA_ENCODING_TrgValue;      // analog trigger value
+	default: return OPENGLOVES_ALPHA_ENCODING_MAX; // junk key
+	}
+}
 
-	OPENGLOVES_ALPHA_ENCODING_FinPinky,
-	OPENGLOVES_ALPHA_ENCODING_FinSplayPinky,
+/*!
+ * Long keys are the finger letter followed by B for the splay, (AB) is the
+ * thumb splay, or by A and the joint letter, (BAC) is index joint 2.
+ */
+static enum opengloves_alpha_encoding_key
+opengloves_alpha_encoding_long_key(const char *key, uint32_t len)
+{
+	if (len < 2 || key[0] < 'A' || key[0] > 'E') {
+		return OPENGLOVES_ALPHA_ENCODING_MAX;
+	}
 
-	OPENGLOVES_ALPHA_ENCODING_FinJointThumb0,
-	OPENGLOVES_ALPHA_ENCODING_FinJointThumb1,
-	OPENGLOVES_ALPHA_ENCODING_FinJointThumb2,
-	OPENGLOVES_ALPHA_ENCODING_FinJointThumb3, // unused in input but used for parity to other fingers in the array
+	int finger = key[0] - 'A';
 
+	if (len == 2 && key[1] == 'B') {
+		return (enum opengloves_alpha_encoding_key)(OPENGLOVES_ALPHA_ENCODING_FinSplayThumb + finger * 2);
+	}
 
-	OPENGLOVES_ALPHA_ENCODING_FinJointIndex0,
-	OPENGLOVES_ALPHA_ENCODING_FinJointIndex1,
-	OPENGLOVES_ALPHA_ENCODING_FinJointIndex2,
-	OPENGLOVES_ALPHA_ENCODING_FinJointIndex3,
+	if (len == 3 && key[1] == 'A' && key[2] >= 'A' && key[2] <= 'D') {
+		return (enum opengloves_alpha_encoding_key)(OPENGLOVES_ALPHA_ENCODING_FinJointThumb0 + finger * 4 +
+		                                            (key[2] - 'A'));
+	}
 
+	return OPENGLOVES_ALPHA_ENCODING_MAX;
+}
 
-	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle0,
-	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle1,
-	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle2,
-	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle3,
+static void
+opengloves_alpha_decoder_commit_key(struct opengloves_alpha_decoder *dec)
+{
+	if (dec->key == OPENGLOVES_ALPHA_ENCODING_MAX) {
+		U_LOG_W("Unable to use a key in an input packet as it was not known");
+	} else {
+		// Even if the value is empty we still want to use the key, it means that we have a button that
+		// is pressed (it only appears in the packet if it is)
+		uint64_t bit = 1ull << dec->key;
+		dec->present |= bit;
+		if (dec->has_value) {
+			dec->valued |= bit;
+			dec->values[dec->key] = dec->value;
+		} else {
+			dec->valued &= ~bit;
+		}
+	}
 
+	dec->state = OPENGLOVES_ALPHA_DECODER_STATE_KEY;
+}
 
-	OPENGLOVES_ALPHA_ENCODING_FinJointRing0,
-	OPENGLOVES_ALPHA_ENCODING_FinJointRing1,
-	OPENGLOVES_ALPHA_ENCODING_FinJointRing2,
-	OPENGLOVES_ALPHA_ENCODING_FinJointRing3,
+static void
+opengloves_alpha_decoder_start_key(struct opengloves_alpha_decoder *dec, enum opengloves_alpha_encoding_key key)
+{
+	dec->key = key;
+	dec->value = 0;
+	dec->has_value = false;
+	dec->state = OPENGLOVES_ALPHA_DECODER_STATE_VALUE;
+}
 
+static bool
+opengloves_alpha_decoder_has(const struct opengloves_alpha_decoder *dec, int key)
+{
+	return (dec->present & (1ull << key)) != 0;
+}
 
-	OPENGLOVES_ALPHA_ENCODING_FinJointPinky0,
-	OPENGLOVES_ALPHA_ENCODING_FinJointPinky1,
-	OPENGLOVES_ALPHA_ENCODING_FinJointPinky2,
-	OPENGLOVES_ALPHA_ENCODING_FinJointPinky3,
+//! Analog values need digits, a key without any is ignored.
+static bool
+opengloves_alpha_decoder_get(const struct opengloves_alpha_decoder *dec, int key, float *out_value)
+{
+	if ((dec->valued & (1ull << key)) == 0) {
+		return false;
+	}
 
-	OPENGLOVES_ALPHA_ENCODING_JoyX,
-	OPENGLOVES_ALPHA_ENCODING_JoyY,
-	OPENGLOVES_ALPHA_ENCODING_JoyBtn,
+	*out_value = (float)dec->values[key] / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE;
+	return true;
+}
 
-	OPENGLOVES_ALPHA_ENCODING_TrgValue,
-	OPENGLOVES_ALPHA_ENCODING_BtnTrg,
-	OPENGLOVES_ALPHA_ENCODING_BtnA,
-	OPENGLOVES_ALPHA_ENCODING_BtnB,
+static void
+opengloves_alpha_decoder_finish_packet(struct opengloves_alpha_decoder *dec, struct opengloves_input *out)
+{
+	float value = 0.0f;
+
+	// five fingers, 2 (curl + splay)
+	for (int i = 0; i < 5; i++) {
+		int enum_position = i * 2;
+		// curls
+		if (opengloves_alpha_decoder_get(dec, enum_position, &value)) {
+			std::fill(std::begin(out->flexion[i]), std::begin(out->flexion[i]) + 4, value);
+		}
 
-	OPENGLOVES_ALPHA_ENCODING_GesGrab,
-	OPENGLOVES_ALPHA_ENCODING_GesPinch,
+		// splay
+		if (opengloves_alpha_decoder_get(dec, enum_position + 1, &value)) {
+			out->splay[i] = (value - 0.5f) * 2.0f;
+		}
+	}
 
-	OPENGLOVES_ALPHA_ENCODING_BtnMenu,
-	OPENGLOVES_ALPHA_ENCODING_BtnCalib,
+	int current_finger_joint = OPENGLOVES_ALPHA_ENCODING_FinJointThumb0;
+	for (int i = 0; i < 5; i++) {
+		for (int j = 0; j < 4; j++) {
+			// individual joint curls, or use the curl of the previous joint
+			out->flexion[i][j] = opengloves_alpha_decoder_get(dec, current_finger_joint, &value)
+			                         ? value
+			                         : out->flexion[i][j > 0 ? j - 1 : 0];
+			current_finger_joint++;
+		}
+	}
 
-	OPENGLOVES_ALPHA_ENCODING_MAX
-};
+	// joysticks
+	if (opengloves_alpha_decoder_get(dec, OPENGLOVES_ALPHA_ENCODING_JoyX, &value)) {
+		out->joysticks.main.x = 2 * value - 1;
+	}
+	if (opengloves_alpha_decoder_get(dec, OPENGLOVES_ALPHA_ENCODING_JoyY, &value)) {
+		out->joysticks.main.y = 2 * value - 1;
+	}
+	out->joysticks.main.pressed = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_JoyBtn);
 
-#define OPENGLOVES_ALPHA_ENCODING_VAL_IN_MAP_E_0
+	if (opengloves_alpha_decoder_get(dec, OPENGLOVES_ALPHA_ENCODING_TrgValue, &value)) {
+		out->buttons.trigger.value = value;
+	}
+	out->buttons.trigger.pressed = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_BtnTrg);
 
-static const std::string opengloves_alpha_encoding_key_characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ()";
+	out->buttons.A.pressed = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_BtnA);
+	out->buttons.B.pressed = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_BtnB);
+	out->gestures.grab.activated = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_GesGrab);
+	out->gestures.pinch.activated = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_GesPinch);
+	out->buttons.menu.pressed = opengloves_alpha_decoder_has(dec, OPENGLOVES_ALPHA_ENCODING_BtnMenu);
 
-static bool
-opengloves_alpha_encoding_is_key_character(const char character)
-{
-	return opengloves_alpha_encoding_key_characters.find(character) != std::string::npos;
+	dec->present = 0;
+	dec->valued = 0;
 }
 
-static const std::map<std::string, int> opengloves_alpha_encoding_input_key_string{
-    {"A", OPENGLOVES_ALPHA_ENCODING_FinThumb},         // whole thumb curl (default curl value for thumb joints)
-    {"(AB)", OPENGLOVES_ALPHA_ENCODING_FinSplayThumb}, // whole thumb splay thumb joint 3 (doesn't exist, but keeps
-                                                       // consistency with the other fingers
-    {"B", OPENGLOVES_ALPHA_ENCODING_FinIndex},         // whole index curl (default curl value for index joints)
-    {"(BB)", OPENGLOVES_ALPHA_ENCODING_FinSplayIndex}, // whole index splay
-
-    {"C", OPENGLOVES_ALPHA_ENCODING_FinMiddle},         // whole middle curl (default curl value for middle joints)
-    {"(CB)", OPENGLOVES_ALPHA_ENCODING_FinSplayMiddle}, // whole middle splay
-
-    {"D", OPENGLOVES_ALPHA_ENCODING_FinRing},            // whole ring curl (default curl value for
-    {"(DB)", OPENGLOVES_ALPHA_ENCODING_FinSplayRing},    // whole ring splay
-                                                         // ring joints)
-    {"E", OPENGLOVES_ALPHA_ENCODING_FinPinky},           // whole pinky curl (default curl value
-    {"(EB)", OPENGLOVES_ALPHA_ENCODING_FinSplayPinky},   // whole pinky splay
-                                                         // for pinky joints
-    {"(AAA)", OPENGLOVES_ALPHA_ENCODING_FinJointThumb0}, // thumb joint 0
-    {"(AAB)", OPENGLOVES_ALPHA_ENCODING_FinJointThumb1}, // thumb joint 1
-    {"(AAC)", OPENGLOVES_ALPHA_ENCODING_FinJointThumb2}, // thumb joint 2
-    {"(AAD)", OPENGLOVES_ALPHA_ENCODING_FinJointThumb3},
-    {"(BAA)", OPENGLOVES_ALPHA_ENCODING_FinJointIndex0},  // index joint 0
-    {"(BAB)", OPENGLOVES_ALPHA_ENCODING_FinJointIndex1},  // index joint 1
-    {"(BAC)", OPENGLOVES_ALPHA_ENCODING_FinJointIndex2},  // index joint 2
-    {"(BAD)", OPENGLOVES_ALPHA_ENCODING_FinJointIndex3},  // index joint 3
-    {"(CAA)", OPENGLOVES_ALPHA_ENCODING_FinJointMiddle0}, // middle joint 0
-    {"(CAB)", OPENGLOVES_ALPHA_ENCODING_FinJointMiddle1}, // middle joint 1
-    {"(CAC)", OPENGLOVES_ALPHA_ENCODING_FinJointMiddle2}, // middle joint 2
-    {"(CAD)", OPENGLOVES_ALPHA_ENCODING_FinJointMiddle3}, // middle joint 3
-    {"(DAA)", OPENGLOVES_ALPHA_ENCODING_FinJointRing0},   // ring joint 0
-    {"(DAB)", OPENGLOVES_ALPHA_ENCODING_FinJointRing1},   // ring joint 1
-    {"(DAC)", OPENGLOVES_ALPHA_ENCODING_FinJointRing2},   // ring joint 2
-    {"(DAD)", OPENGLOVES_ALPHA_ENCODING_FinJointRing3},   // ring joint 3
-    {"(EAA)", OPENGLOVES_ALPHA_ENCODING_FinJointPinky0},  // pinky joint 0
-    {"(EAB)", OPENGLOVES_ALPHA_ENCODING_FinJointPinky1},  // pinky joint 1
-    {"(EAC)", OPENGLOVES_ALPHA_ENCODING_FinJointPinky2},  // pinky joint 2
-    {"(EAD)", OPENGLOVES_ALPHA_ENCODING_FinJointPinky3},  // pinky joint 3
-    {"F", OPENGLOVES_ALPHA_ENCODING_JoyX},                // joystick x component
-    {"G", OPENGLOVES_ALPHA_ENCODING_JoyY},                // joystick y component
-    {"H", OPENGLOVES_ALPHA_ENCODING_JoyBtn},              // joystick button
-    {"I", OPENGLOVES_ALPHA_ENCODING_BtnTrg},              // trigger button
-    {"J", OPENGLOVES_ALPHA_ENCODING_BtnA},                // A button
-    {"K", OPENGLOVES_ALPHA_ENCODING_BtnB},                // B button
-    {"L", OPENGLOVES_ALPHA_ENCODING_GesGrab},             // grab gesture (boolean)
-    {"M", OPENGLOVES_ALPHA_ENCODING_GesPinch},            // pinch gesture (boolean)
-    {"N", OPENGLOVES_ALPHA_ENCODING_BtnMenu},             // system button pressed (opens SteamVR menu)
-    {"O", OPENGLOVES_ALPHA_ENCODING_BtnCalib},            // calibration button
-    {"P", OPENGLOVES_ALPHA_ENCODING_TrgValue},            // analog trigger value
-    {"", OPENGLOVES_ALPHA_ENCODING_MAX}                   // Junk key
-};
 
-static const std::map<int, std::string> opengloves_alpha_encoding_output_key_string{
-    {OPENGLOVES_ALPHA_ENCODING_FinThumb, "A"},  // thumb force feedback
-    {OPENGLOVES_ALPHA_ENCODING_FinIndex, "B"},  // index force feedback
-    {OPENGLOVES_ALPHA_ENCODING_FinMiddle, "C"}, // middle force feedback
-    {OPENGLOVES_ALPHA_ENCODING_FinRing, "D"},   // ring force feedback
-    {OPENGLOVES_ALPHA_ENCODING_FinPinky, "E"},  // pinky force feedback
-};
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+opengloves_alpha_decoder_init(struct opengloves_alpha_decoder *dec)
+{
+	*dec = {};
+	dec->state = OPENGLOVES_ALPHA_DECODER_STATE_KEY;
+	dec->key = OPENGLOVES_ALPHA_ENCODING_MAX;
+}
 
-static std::map<int, std::string>
-opengloves_alpha_encoding_parse_to_map(const std::string &str)
+size_t
+opengloves_alpha_decoder_feed(struct opengloves_alpha_decoder *dec,
+                              const char *data,
+                              size_t size,
+                              struct opengloves_input *out,
+                              bool *out_complete)
 {
-	std::map<int, std::string> result;
+	*out_complete = false;
 
 	size_t i = 0;
-	while (i < str.length()) {
-		// Advance until we get an alphabetic character (no point in looking at values that don't have a key
-		// associated with them)
+	while (i < size) {
+		char c = data[i];
 
-		if (str[i] >= 0 && opengloves_alpha_encoding_is_key_character(str[i])) {
-			std::string key = {str[i]};
+		if (c == '\0') {
+			// Some devices pad with zeroes, skip them.
 			i++;
+			continue;
+		}
 
-			// we're going to be parsing a "long key", i.e. (AB) for thumb finger splay. Long keys must
-			// always be enclosed in brackets
-			if (key[0] == '(') {
-				while (str[i] >= 0 && opengloves_alpha_encoding_is_key_character(str[i]) &&
-				       i < str.length()) {
-					key += str[i];
-					i++;
-				}
+		if (c == '\n') {
+			if (dec->state != OPENGLOVES_ALPHA_DECODER_STATE_KEY) {
+				opengloves_alpha_decoder_commit_key(dec);
+			}
+			opengloves_alpha_decoder_finish_packet(dec, out);
+			*out_complete = true;
+			return i + 1;
+		}
+
+		switch (dec->state) {
+		case OPENGLOVES_ALPHA_DECODER_STATE_KEY:
+			// Advance until we get a key character (no point in looking at values that don't have a key
+			// associated with them)
+			if (c == '(') {
+				dec->long_key_len = 0;
+				dec->state = OPENGLOVES_ALPHA_DECODER_STATE_LONG_KEY;
+			} else if (opengloves_alpha_encoding_is_key_letter(c)) {
+				opengloves_alpha_decoder_start_key(dec, opengloves_alpha_encoding_short_key(c));
 			}
+			i++;
+			break;
 
-			std::string value;
-			while (str[i] >= 0 && isdigit(str[i]) && i < str.length()) {
-				value += str[i];
+		case OPENGLOVES_ALPHA_DECODER_STATE_LONG_KEY:
+			if (opengloves_alpha_encoding_is_key_letter(c)) {
+				// Too long keys are junk, mark them by going past the end.
+				if (dec->long_key_len < sizeof(dec->long_key)) {
+					dec->long_key[dec->long_key_len] = c;
+				}
+				dec->long_key_len++;
+				i++;
+			} else if (c == ')') {
+				opengloves_alpha_decoder_start_key(
+				    dec, opengloves_alpha_encoding_long_key(dec->long_key, dec->long_key_len));
 				i++;
+			} else {
+				// Long keys must always be enclosed in brackets, the value still belongs to it.
+				opengloves_alpha_decoder_start_key(dec, OPENGLOVES_ALPHA_ENCODING_MAX);
 			}
+			break;
 
-			// Even if the value is empty we still want to use the key, it means that we have a button that
-			// is pressed (it only appears in the packet if it is)
-			if (opengloves_alpha_encoding_input_key_string.find(key) !=
-			    opengloves_alpha_encoding_input_key_string.end())
-				result.insert_or_assign(opengloves_alpha_encoding_input_key_string.at(key), value);
-			else
-				U_LOG_W("Unable to insert key: %s into input map as it was not found", key.c_str());
-		} else
-			i++;
+		case OPENGLOVES_ALPHA_DECODER_STATE_VALUE:
+			if (c >= '0' && c <= '9') {
+				if (dec->value < OPENGLOVES_ALPHA_ENCODING_MAX_VALUE) {
+					dec->value = dec->value * 10 + (uint32_t)(c - '0');
+				}
+				dec->has_value = true;
+				i++;
+			} else {
+				// Look at this character again as the start of the next key.
+				opengloves_alpha_decoder_commit_key(dec);
+			}
+			break;
+		}
 	}
 
-	return result;
+	return i;
 }
 
-
 void
 opengloves_alpha_encoding_decode(const char *data, struct opengloves_input *out)
 {
-	std::map<int, std::string> input_map = opengloves_alpha_encoding_parse_to_map(data);
-
-	try {
-		// five fingers, 2 (curl + splay)
-		for (int i = 0; i < 5; i++) {
-			int enum_position = i * 2;
-			// curls
-			if (input_map.find(enum_position) != input_map.end()) {
-				float fin_curl_value = std::stof(input_map.at(enum_position));
-				std::fill(std::begin(out->flexion[i]), std::begin(out->flexion[i]) + 4,
-				          fin_curl_value / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE);
-			}
-
-			// splay
-			if (input_map.find(enum_position + 1) != input_map.end())
-				out->splay[i] =
-				    (std::stof(input_map.at(enum_position + 1)) / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-				     0.5f) *
-				    2.0f;
-		}
+	struct opengloves_alpha_decoder dec;
+	opengloves_alpha_decoder_init(&dec);
 
-		int current_finger_joint = OPENGLOVES_ALPHA_ENCODING_FinJointThumb0;
-		for (int i = 0; i < 5; i++) {
-			for (int j = 0; j < 4; j++) {
-				// individual joint curls
-				out->flexion[i][j] = input_map.find(current_finger_joint) != input_map.end()
-				                         ? (std::stof(input_map.at(current_finger_joint)) /
-				                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE)
-				                         // use the curl of the previous joint
-				                         : out->flexion[i][j > 0 ? j - 1 : 0];
-				current_finger_joint++;
-			}
-		}
+	bool complete = false;
+	size_t len = strlen(data);
+	size_t consumed = opengloves_alpha_decoder_feed(&dec, data, len, out, &complete);
 
-		// joysticks
-		if (input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyX) != input_map.end())
-			out->joysticks.main.x = 2 * std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_JoyX)) /
-			                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-			                        1;
-		if (input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyY) != input_map.end())
-			out->joysticks.main.y = 2 * std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_JoyY)) /
-			                            OPENGLOVES_ENCODING_MAX_ANALOG_VALUE -
-			                        1;
-		out->joysticks.main.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_JoyBtn) != input_map.end();
-
-	} catch (std::invalid_argument &e) {
-		U_LOG_E("Error parsing input string: %s", e.what());
+	// Packets given here don't have the newline.
+	if (!complete && consumed == len) {
+		opengloves_alpha_decoder_feed(&dec, "\n", 1, out, &complete);
 	}
-
-	if (input_map.find(OPENGLOVES_ALPHA_ENCODING_TrgValue) != input_map.end())
-		out->buttons.trigger.value =
-		    std::stof(input_map.at(OPENGLOVES_ALPHA_ENCODING_TrgValue)) / OPENGLOVES_ENCODING_MAX_ANALOG_VALUE;
-	out->buttons.trigger.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnTrg) != input_map.end();
-
-	out->buttons.A.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnA) != input_map.end();
-	out->buttons.B.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnB) != input_map.end();
-	out->gestures.grab.activated = input_map.find(OPENGLOVES_ALPHA_ENCODING_GesGrab) != input_map.end();
-	out->gestures.pinch.activated = input_map.find(OPENGLOVES_ALPHA_ENCODING_GesPinch) != input_map.end();
-	out->buttons.menu.pressed = input_map.find(OPENGLOVES_ALPHA_ENCODING_BtnMenu) != input_map.end();
 }
 
 void
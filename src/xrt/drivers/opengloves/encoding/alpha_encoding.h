@@ -10,10 +10,131 @@
 #pragma once
 #include "encoding.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+enum opengloves_alpha_encoding_key
+{
+	OPENGLOVES_ALPHA_ENCODING_FinThumb,
+	OPENGLOVES_ALPHA_ENCODING_FinSplayThumb,
+
+	OPENGLOVES_ALPHA_ENCODING_FinIndex,
+	OPENGLOVES_ALPHA_ENCODING_FinSplayIndex,
+
+	OPENGLOVES_ALPHA_ENCODING_FinMiddle,
+	OPENGLOVES_ALPHA_ENCODING_FinSplayMiddle,
+
+	OPENGLOVES_ALPHA_ENCODING_FinRing,
+	OPENGLOVES_ALPHA_ENCODING_FinSplayRing,
+
+	OPENGLOVES_ALPHA_ENCODING_FinPinky,
+	OPENGLOVES_ALPHA_ENCODING_FinSplayPinky,
+
+	OPENGLOVES_ALPHA_ENCODING_FinJointThumb0,
+	OPENGLOVES_ALPHA_ENCODING_FinJointThumb1,
+	OPENGLOVES_ALPHA_ENCODING_FinJointThumb2,
+	OPENGLOVES_ALPHA_ENCODING_FinJointThumb3, // unused in input but used for parity to other fingers in the array
+
+
+	OPENGLOVES_ALPHA_ENCODING_FinJointIndex0,
+	OPENGLOVES_ALPHA_ENCODING_FinJointIndex1,
+	OPENGLOVES_ALPHA_ENCODING_FinJointIndex2,
+	OPENGLOVES_ALPHA_ENCODING_FinJointIndex3,
+
+
+	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle0,
+	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle1,
+	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle2,
+	OPENGLOVES_ALPHA_ENCODING_FinJointMiddle3,
+
+
+	OPENGLOVES_ALPHA_ENCODING_FinJointRing0,
+	OPENGLOVES_ALPHA_ENCODING_FinJointRing1,
+	OPENGLOVES_ALPHA_ENCODING_FinJointRing2,
+	OPENGLOVES_ALPHA_ENCODING_FinJointRing3,
+
+
+	OPENGLOVES_ALPHA_ENCODING_FinJointPinky0,
+	OPENGLOVES_ALPHA_ENCODING_FinJointPinky1,
+	OPENGLOVES_ALPHA_ENCODING_FinJointPinky2,
+	OPENGLOVES_ALPHA_ENCODING_FinJointPinky3,
+
+	OPENGLOVES_ALPHA_ENCODING_JoyX,
+	OPENGLOVES_ALPHA_ENCODING_JoyY,
+	OPENGLOVES_ALPHA_ENCODING_JoyBtn,
+
+	OPENGLOVES_ALPHA_ENCODING_TrgValue,
+	OPENGLOVES_ALPHA_ENCODING_BtnTrg,
+	OPENGLOVES_ALPHA_ENCODING_BtnA,
+	OPENGLOVES_ALPHA_ENCODING_BtnB,
+
+	OPENGLOVES_ALPHA_ENCODING_GesGrab,
+	OPENGLOVES_ALPHA_ENCODING_GesPinch,
+
+	OPENGLOVES_ALPHA_ENCODING_BtnMenu,
+	OPENGLOVES_ALPHA_ENCODING_BtnCalib,
+
+	OPENGLOVES_ALPHA_ENCODING_MAX
+};
+
+/*!
+ * Incremental decoder for the alpha encoding, bytes are fed to it as they are
+ * read from the device and it keeps no more than the key and value it is in
+ * the middle of. Doesn't allocate, so it can live on the stack of the reader.
+ *
+ * @ingroup drv_opengloves
+ */
+struct opengloves_alpha_decoder
+{
+	//! Where in a key value pair the decoder is, internal.
+	int state;
+
+	//! Key being decoded, @ref OPENGLOVES_ALPHA_ENCODING_MAX for junk keys.
+	enum opengloves_alpha_encoding_key key;
+
+	//! Characters of a long key between the brackets.
+	char long_key[4];
+	uint32_t long_key_len;
+
+	uint32_t value;
+	bool has_value;
+
+	//! Bit per key seen in this packet, and if it had a value.
+	uint64_t present;
+	uint64_t valued;
+
+	uint32_t values[OPENGLOVES_ALPHA_ENCODING_MAX];
+};
+
+void
+opengloves_alpha_decoder_init(struct opengloves_alpha_decoder *dec);
+
+/*!
+ * Feed bytes to the decoder, stops after the newline ending a packet. On the
+ * end of a packet the values in it are written to @p out, values not in the
+ * packet are kept as they were and buttons not in it are released.
+ *
+ * @param      dec          Decoder.
+ * @param      data         Bytes read from the device.
+ * @param      size         Number of bytes in @p data.
+ * @param[out] out          Input updated with a finished packet.
+ * @param[out] out_complete Set to true if a packet was finished.
+ * @return Number of bytes consumed, less than @p size if a packet finished before the end.
+ */
+size_t
+opengloves_alpha_decoder_feed(struct opengloves_alpha_decoder *dec,
+                              const char *data,
+                              size_t size,
+                              struct opengloves_input *out,
+                              bool *out_complete);
+
+/*!
+ * Decode a single null terminated packet into @p out_kv.
+ */
 void
 opengloves_alpha_encoding_decode(const char *data, struct opengloves_input *out_kv);
 
@@ -8,11 +8,15 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
 
 #include "xrt/xrt_device.h"
 #include "xrt/xrt_defines.h"
 
 #include "math/m_space.h"
+#include "math/m_hand_history.h"
+
+#include "os/os_time.h"
 
 #include "util/u_device.h"
 #include "util/u_debug.h"
@@ -73,6 +77,9 @@ struct opengloves_device
 
 	struct opengloves_input *last_input;
 
+	//! Simulated hands stamped with when their packet was received, to interpolate between packets.
+	struct m_hand_history *hand_history;
+
 	enum xrt_hand hand;
 
 	struct u_hand_tracking hand_tracking;
@@ -87,55 +94,65 @@ opengloves_device(struct xrt_device *xdev)
 }
 
 static void
-opengloves_device_get_hand_tracking(struct xrt_device *xdev,
-                                    enum xrt_input_name name,
-                                    uint64_t requested_timestamp_ns,
-                                    struct xrt_hand_joint_set *out_joint_set,
-                                    uint64_t *out_timestamp_ns)
+opengloves_input_to_joint_set(const struct opengloves_input *input,
+                              enum xrt_hand hand,
+                              struct xrt_hand_joint_set *out_joint_set)
 {
-	struct opengloves_device *od = opengloves_device(xdev);
-
-	enum xrt_hand hand = od->hand;
-
 	struct u_hand_tracking_values values = {.little =
 	                                            {
-	                                                .splay = od->last_input->splay[4],
+	                                                .splay = input->splay[4],
 	                                                .joint_count = 5,
 	                                            },
 	                                        .ring =
 	                                            {
-	                                                .splay = od->last_input->splay[3],
+	                                                .splay = input->splay[3],
 	                                                .joint_count = 5,
 	                                            },
 	                                        .middle =
 	                                            {
-	                                                .splay = od->last_input->splay[2],
+	                                                .splay = input->splay[2],
 	                                                .joint_count = 5,
 	                                            },
 	                                        .index =
 	                                            {
-	                                                .splay = od->last_input->splay[1],
+	                                                .splay = input->splay[1],
 	                                                .joint_count = 5,
 	                                            },
 	                                        .thumb = {
-	                                            .splay = od->last_input->splay[0],
+	                                            .splay = input->splay[0],
 	                                            .joint_count = 4,
 	                                        }};
-	// copy in the curls
-	memcpy(values.little.joint_curls, od->last_input->flexion[4], sizeof(od->last_input->flexion[4]));
-	memcpy(values.ring.joint_curls, od->last_input->flexion[3], sizeof(od->last_input->flexion[3]));
-	memcpy(values.middle.joint_curls, od->last_input->flexion[2], sizeof(od->last_input->flexion[2]));
-	memcpy(values.index.joint_curls, od->last_input->flexion[1], sizeof(od->last_input->flexion[1]));
-	memcpy(values.thumb.joint_curls, od->last_input->flexion[0], sizeof(od->last_input->flexion[0]));
+	// copy in the curls, the glove sends four per finger
+	memcpy(values.little.joint_curls, input->flexion[4], sizeof(values.little.joint_curls));
+	memcpy(values.ring.joint_curls, input->flexion[3], sizeof(values.ring.joint_curls));
+	memcpy(values.middle.joint_curls, input->flexion[2], sizeof(values.middle.joint_curls));
+	memcpy(values.index.joint_curls, input->flexion[1], sizeof(values.index.joint_curls));
+	memcpy(values.thumb.joint_curls, input->flexion[0], sizeof(values.thumb.joint_curls));
 
 	struct xrt_space_relation ident;
 	m_space_relation_ident(&ident);
 	u_hand_sim_simulate_generic(&values, hand, &ident, out_joint_set);
 
-	*out_timestamp_ns = requested_timestamp_ns;
 	out_joint_set->is_active = true;
 }
 
+static void
+opengloves_device_get_hand_tracking(struct xrt_device *xdev,
+                                    enum xrt_input_name name,
+                                    uint64_t requested_timestamp_ns,
+                                    struct xrt_hand_joint_set *out_joint_set,
+                                    uint64_t *out_timestamp_ns)
+{
+	struct opengloves_device *od = opengloves_device(xdev);
+
+	enum m_relation_history_result res =
+	    m_hand_history_get(od->hand_history, requested_timestamp_ns, out_joint_set, out_timestamp_ns);
+	if (res == M_RELATION_HISTORY_RESULT_INVALID) {
+		// No packets yet, not active.
+		*out_timestamp_ns = requested_timestamp_ns;
+	}
+}
+
 static void
 opengloves_device_update_inputs(struct xrt_device *xdev)
 {
@@ -207,62 +224,65 @@ opengloves_device_destroy(struct xrt_device *xdev)
 
 	opengloves_communication_device_destory(od->ocd);
 
+	m_hand_history_destroy(&od->hand_history);
 	free(od->last_input);
 	free(od);
 }
 
 
-/*!
- * Reads the next packet from the device, finishing successfully when reaching a newline
- * Returns true if finished at a newline, or false if there was an error
- */
-static bool
-opengloves_read_next_packet(struct opengloves_device *od, char *buffer, int buffer_len)
+static void
+opengloves_push_input(struct opengloves_device *od, const struct opengloves_input *input, uint64_t timestamp_ns)
 {
-	os_thread_helper_lock(&od->oth);
-
-	char next_char = 0;
-	int i = 0;
-	do {
-		// try read one byte
-		int ret = opengloves_communication_device_read(od->ocd, &next_char, 1);
-		if (ret < 0) {
-			OPENGLOVES_ERROR(od, "Failed to read from device! %s", strerror(ret));
-			os_thread_helper_unlock(&od->oth);
-			return false;
-		}
-
-		if (next_char == 0 || next_char == '\n')
-			continue;
-
-		buffer[i++] = next_char;
-	} while (next_char != '\n' && i < buffer_len);
-
-	// null terminate
-	buffer[i] = '\0';
-
-	OPENGLOVES_DEBUG(od, "%s -> len %i", buffer, i);
+	os_mutex_lock(&od->lock);
+	*od->last_input = *input;
+	os_mutex_unlock(&od->lock);
 
-	os_thread_helper_unlock(&od->oth);
+	struct xrt_hand_joint_set joint_set;
+	opengloves_input_to_joint_set(input, od->hand, &joint_set);
 
-	return true;
+	m_hand_history_push(od->hand_history, &joint_set, timestamp_ns);
 }
 
 /*!
- * Main thread for reading data from the device
+ * Main thread for reading data from the device, the bytes are decoded straight
+ * out of the read buffer as they arrive. Packets are stamped with the time of
+ * the read that finished them, only the newest one of a read is kept.
  */
 static void *
 opengloves_run_thread(void *ptr)
 {
 	struct opengloves_device *od = (struct opengloves_device *)ptr;
 
+	struct opengloves_alpha_decoder decoder;
+	opengloves_alpha_decoder_init(&decoder);
+
+	// Persists between packets, values not in a packet are kept.
+	struct opengloves_input input = {0};
+
 	char buffer[OPENGLOVES_ENCODING_MAX_PACKET_SIZE];
 
-	while (opengloves_read_next_packet(od, buffer, OPENGLOVES_ENCODING_MAX_PACKET_SIZE) &&
-	       os_thread_helper_is_running(&od->oth)) {
-		os_mutex_lock(&od->lock);
-		opengloves_alpha_encoding_decode(buffer, od->last_input);
-		os_mutex_unlock(&od->lock);
+	while (os_thread_helper_is_running(&od->oth)) {
+		// Returns what is there, or nothing after the serial timeout.
+		int ret = opengloves_communication_device_read(od->ocd, buffer, sizeof(buffer));
+		if (ret < 0) {
+			OPENGLOVES_ERROR(od, "Failed to read from device! %s", strerror(errno));
+			break;
+		}
+
+		uint64_t now_ns = os_monotonic_get_ns();
+
+		bool got_packet = false;
+		size_t offset = 0;
+		while (offset < (size_t)ret) {
+			bool complete = false;
+			offset += opengloves_alpha_decoder_feed(&decoder, buffer + offset, (size_t)ret - offset, &input,
+			                                        &complete);
+			got_packet = got_packet || complete;
+		}
+
+		if (got_packet) {
+			opengloves_push_input(od, &input, now_ns);
+		}
 	}
 
 	return 0;
@@ -294,6 +314,7 @@ opengloves_device_create(struct opengloves_communication_device *ocd, enum xrt_h
 	// inputs
 	od->base.update_inputs = opengloves_device_update_inputs;
 	od->last_input = U_TYPED_CALLOC(struct opengloves_input);
+	m_hand_history_create(&od->hand_history, 0);
 
 	od->base.inputs[OPENGLOVES_INPUT_INDEX_A_CLICK].name = XRT_INPUT_INDEX_A_CLICK;
 	od->base.inputs[OPENGLOVES_INPUT_INDEX_B_CLICK].name = XRT_INPUT_INDEX_B_CLICK;
@@ -35,6 +35,7 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 
 
 /*!
@@ -437,7 +438,17 @@ struct psmv_device
 
 	struct xrt_tracked_psmv *ball;
 
-	struct os_thread_helper oth;
+	struct
+	{
+		//! Set once the device has been added to the HID reactor.
+		bool added;
+
+		//! The first packet is only used to sync up.
+		bool synced;
+
+		//! When the last packet was read.
+		timepoint_ns then_ns;
+	} reader;
 
 	struct
 	{
@@ -672,100 +683,67 @@ update_fusion(struct psmv_device *psmv,
 }
 
 /*!
- * Reads one packet from the device, handles time out, locking and checking if
- * the thread has been told to shut down.
+ * Called from the HID reactor thread with each packet read from the device.
  */
-static bool
-psmv_read_one_packet(struct psmv_device *psmv, uint8_t *buffer, size_t size)
+static void
+psmv_handle_report(void *user, const uint8_t *buffer, int size, int64_t timestamp_ns)
 {
-	os_thread_helper_lock(&psmv->oth);
-
-	while (os_thread_helper_is_running_locked(&psmv->oth)) {
+	struct psmv_device *psmv = (struct psmv_device *)user;
 
-		os_thread_helper_unlock(&psmv->oth);
-
-		int ret = os_hid_read(psmv->hid, buffer, size, 1000);
-
-		if (ret == 0) {
-			PSMV_DEBUG(psmv, "Timeout");
-
-			// Must lock thread before check in while.
-			os_thread_helper_lock(&psmv->oth);
-			continue;
-		}
-		if (ret < 0) {
-			PSMV_ERROR(psmv, "Failed to read device '%i'!", ret);
-			return false;
-		}
-
-		return true;
+	if (size < 0) {
+		PSMV_ERROR(psmv, "Failed to read device '%i'!", size);
+		return;
 	}
 
-	return false;
-}
-
-static void *
-psmv_run_thread(void *ptr)
-{
-	U_TRACE_SET_THREAD_NAME("PS Move");
-
-	struct psmv_device *psmv = (struct psmv_device *)ptr;
+	// Wait for a package to sync up, it's discarded but that's okay.
+	if (!psmv->reader.synced) {
+		psmv->reader.synced = true;
+		psmv->reader.then_ns = timestamp_ns;
+		return;
+	}
 
 	union {
 		uint8_t buffer[256];
 		struct psmv_input_zcm1 input;
 	} data;
 
-	struct psmv_parsed_input input = {0};
-
-	while (os_hid_read(psmv->hid, data.buffer, sizeof(data), 0) > 0) {
-		// Empty queue first
-	}
-
-	// Now wait for a package to sync up, it's discarded but that's okay.
-	if (!psmv_read_one_packet(psmv, data.buffer, sizeof(data))) {
-		return NULL;
-	}
-
-	timepoint_ns then_ns = os_monotonic_get_ns();
-
-	while (psmv_read_one_packet(psmv, data.buffer, sizeof(data))) {
+	size_t copy = (size_t)size < sizeof(data) ? (size_t)size : sizeof(data);
+	memcpy(data.buffer, buffer, copy);
 
-		timepoint_ns now_ns = os_monotonic_get_ns();
-
-		int num = psmv_parse_input(psmv, data.buffer, &input);
-
-		time_duration_ns delta_ns = now_ns - then_ns;
-		then_ns = now_ns;
+	struct psmv_parsed_input input = {0};
 
-		// Lock last and the fusion.
-		os_mutex_lock(&psmv->lock);
+	timepoint_ns now_ns = timestamp_ns;
 
-		// Make sure the leds stays on.
-		psmv_led_and_trigger_update_locked(psmv, now_ns);
+	int num = psmv_parse_input(psmv, data.buffer, &input);
 
-		// Copy to device.
-		psmv->last = input;
+	time_duration_ns delta_ns = now_ns - psmv->reader.then_ns;
+	psmv->reader.then_ns = now_ns;
 
-		// Process the parsed data.
-		if (num == 2) {
-			// ZCM1
-			update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
-			update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
-			psmv->last_timestamp_ns = now_ns;
-		} else if (num == 1) {
-			// ZCM2
-			update_fusion(psmv, &input.sample, now_ns, delta_ns);
-			psmv->last_timestamp_ns = now_ns;
-		} else {
-			assert(false);
-		}
+	// Lock last and the fusion.
+	os_mutex_lock(&psmv->lock);
 
-		// Now done.
-		os_mutex_unlock(&psmv->lock);
+	// Make sure the leds stays on.
+	psmv_led_and_trigger_update_locked(psmv, now_ns);
+
+	// Copy to device.
+	psmv->last = input;
+
+	// Process the parsed data.
+	if (num == 2) {
+		// ZCM1
+		update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
+		update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
+		psmv->last_timestamp_ns = now_ns;
+	} else if (num == 1) {
+		// ZCM2
+		update_fusion(psmv, &input.sample, now_ns, delta_ns);
+		psmv->last_timestamp_ns = now_ns;
+	} else {
+		assert(false);
 	}
 
-	return NULL;
+	// Now done.
+	os_mutex_unlock(&psmv->lock);
 }
 
 static void
@@ -832,10 +810,13 @@ psmv_device_destroy(struct xrt_device *xdev)
 {
 	struct psmv_device *psmv = psmv_device(xdev);
 
-	// Destroy the thread object.
-	os_thread_helper_destroy(&psmv->oth);
+	// Stop reading, the callback is not running once this returns.
+	if (psmv->reader.added) {
+		os_hid_reactor_remove(psmv->hid);
+		psmv->reader.added = false;
+	}
 
-	// Now that the thread is not running we can destroy the lock.
+	// Now that nothing is reading we can destroy the lock.
 	os_mutex_destroy(&psmv->lock);
 
 	// Destroy the IMU fusion.
@@ -951,9 +932,11 @@ psmv_device_set_output(struct xrt_device *xdev, enum xrt_output_name name, const
 	}
 	psmv->wants.rumble = psmv_clamp_zero_to_one_float_to_u8(amp);
 
-	// Resend if the rumble has been changed.
-	int64_t now = os_monotonic_get_ns();
-	psmv_led_and_trigger_update_locked(psmv, now);
+	/*
+	 * Don't write to the device from the application's thread, the reader
+	 * thread resends on the next input packet if the rumble has changed,
+	 * only sending the latest value if set several times in between.
+	 */
 
 	os_mutex_unlock(&psmv->lock);
 }
@@ -1125,13 +1108,6 @@ psmv_device_create(struct xrt_prober *xp, struct xrt_prober_device *xpdev, struc
 		return NULL;
 	}
 
-	// Thread and other state.
-	ret = os_thread_helper_init(&psmv->oth);
-	if (ret != 0) {
-		PSMV_ERROR(psmv, "Failed to init threading!");
-		psmv_device_destroy(&psmv->base);
-		return NULL;
-	}
 	// Get calibration data.
 	ret = psmv_get_calibration(psmv);
 	if (ret != 0) {
@@ -1173,12 +1149,18 @@ psmv_device_create(struct xrt_prober *xp, struct xrt_prober_device *xpdev, struc
 	// Send the first update package.
 	psmv_led_and_trigger_update(psmv, 1);
 
-	ret = os_thread_helper_start(&psmv->oth, psmv_run_thread, psmv);
+	uint8_t discard[256];
+	while (os_hid_read(psmv->hid, discard, sizeof(discard), 0) > 0) {
+		// Empty queue first
+	}
+
+	ret = os_hid_reactor_add(psmv->hid, psmv_handle_report, psmv);
 	if (ret != 0) {
-		PSMV_ERROR(psmv, "Failed to start thread!");
+		PSMV_ERROR(psmv, "Failed to start reading device '%i'!", ret);
 		psmv_device_destroy(&psmv->base);
 		return NULL;
 	}
+	psmv->reader.added = true;
 
 	// Start the variable tracking now that everything is in place.
 	// clang-format off
@@ -1033,6 +1033,7 @@ psvr_device_create_auto_prober(struct hid_device_info *sensor_hid_info,
 	psvr->base.get_tracked_pose = psvr_device_get_tracked_pose;
 	psvr->base.get_view_poses = u_device_get_view_poses;
 	psvr->base.compute_distortion = psvr_compute_distortion;
+	psvr->base.compute_distortion_thread_safe = true;
 	psvr->base.destroy = psvr_device_destroy;
 	psvr->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
 	psvr->base.name = XRT_DEVICE_GENERIC_HMD;
@@ -1059,6 +1060,10 @@ psvr_device_create_auto_prober(struct hid_device_info *sensor_hid_info,
 		struct xrt_hmd_parts *hmd = psvr->base.hmd;
 		hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 		hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
+
+		// Lets the compositor generate the distortion on the GPU, same values for both views.
+		const struct u_panotools_values views[2] = {vals, vals};
+		u_distortion_panotools_fill_in_model(&psvr->base, views);
 	}
 
 #if 1
@@ -18,6 +18,7 @@
 #include "vive/vive_bindings.h"
 
 #include "math/m_api.h"
+#include "math/m_relation_history.h"
 
 #include "r_internal.h"
 #include "util/u_hand_simulation.h"
@@ -55,8 +56,13 @@ r_device_update_inputs(struct xrt_device *xdev)
 	struct r_device *rd = r_device(xdev);
 	struct r_hub *r = rd->r;
 
-	uint64_t now = os_monotonic_get_ns();
-	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
+	struct r_remote_data data;
+	uint64_t received_ns;
+	r_hub_get_latest(r, &data, &received_ns);
+
+	// Stamp the inputs with when they arrived, if anything has arrived.
+	uint64_t now = received_ns != 0 ? received_ns : os_monotonic_get_ns();
+	struct r_remote_controller_data *latest = rd->is_left ? &data.left : &data.right;
 
 	if (!latest->active) {
 		for (uint32_t i = 0; i < 19; i++) {
@@ -107,7 +113,18 @@ r_device_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
+	struct r_remote_data data;
+	uint64_t received_ns;
+	r_hub_get_latest(r, &data, &received_ns);
+
+	struct r_remote_controller_data *latest = rd->is_left ? &data.left : &data.right;
+	struct m_relation_history *history = rd->is_left ? r->history.left : r->history.right;
+
+	// Interpolate or predict from the received poses, they are empty while inactive.
+	if (latest->active &&
+	    m_relation_history_get(history, at_timestamp_ns, out_relation) != M_RELATION_HISTORY_RESULT_INVALID) {
+		return;
+	}
 
 	/*
 	 * It's easier to reason about angular velocity if it's controlled in
@@ -146,7 +163,11 @@ r_device_get_hand_tracking(struct xrt_device *xdev,
 		return;
 	}
 
-	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
+	struct r_remote_data data;
+	uint64_t received_ns;
+	r_hub_get_latest(r, &data, &received_ns);
+
+	struct r_remote_controller_data *latest = rd->is_left ? &data.left : &data.right;
 
 	struct u_hand_tracking_curl_values values = {
 	    .little = latest->hand_curl[0],
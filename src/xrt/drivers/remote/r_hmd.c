@@ -17,6 +17,7 @@
 
 #include "math/m_api.h"
 #include "math/m_mathinclude.h"
+#include "math/m_relation_history.h"
 
 #include "r_internal.h"
 
@@ -36,9 +37,9 @@ r_hmd(struct xrt_device *xdev)
 }
 
 static inline void
-copy_head_center_to_relation(struct r_hmd *rh, struct xrt_space_relation *out_relation)
+copy_head_center_to_relation(const struct r_remote_data *data, struct xrt_space_relation *out_relation)
 {
-	out_relation->pose = rh->r->latest.head.center;
+	out_relation->pose = data->head.center;
 	out_relation->relation_flags = (enum xrt_space_relation_flags)(
 	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
 	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
@@ -64,8 +65,19 @@ r_hmd_get_tracked_pose(struct xrt_device *xdev,
 {
 	struct r_hmd *rh = r_hmd(xdev);
 
+	struct r_remote_data data;
+	uint64_t received_ns;
+
 	switch (name) {
-	case XRT_INPUT_GENERIC_HEAD_POSE: copy_head_center_to_relation(rh, out_relation); break;
+	case XRT_INPUT_GENERIC_HEAD_POSE:
+		// Interpolate or predict from the received poses, fall back to the latest before any arrived.
+		if (m_relation_history_get(rh->r->history.head, at_timestamp_ns, out_relation) !=
+		    M_RELATION_HISTORY_RESULT_INVALID) {
+			break;
+		}
+		r_hub_get_latest(rh->r, &data, &received_ns);
+		copy_head_center_to_relation(&data, out_relation);
+		break;
 	case XRT_INPUT_GENERIC_STAGE_SPACE_POSE:
 		// STAGE is implicitly defined as the space poses are returned in, therefore STAGE origin is (0, 0, 0).
 		*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
@@ -97,7 +109,11 @@ r_hmd_get_view_poses(struct xrt_device *xdev,
 {
 	struct r_hmd *rh = r_hmd(xdev);
 
-	if (!rh->r->latest.head.per_view_data_valid) {
+	struct r_remote_data data;
+	uint64_t received_ns;
+	r_hub_get_latest(rh->r, &data, &received_ns);
+
+	if (!data.head.per_view_data_valid) {
 		u_device_get_view_poses(  //
 		    xdev,                 //
 		    default_eye_relation, //
@@ -111,16 +127,16 @@ r_hmd_get_view_poses(struct xrt_device *xdev,
 		return;
 	}
 
-	if (view_count > ARRAY_SIZE(rh->r->latest.head.views)) {
+	if (view_count > ARRAY_SIZE(data.head.views)) {
 		U_LOG_E("Asking for too many views!");
 		return;
 	}
 
-	copy_head_center_to_relation(rh, out_head_relation);
+	r_hmd_get_tracked_pose(xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_timestamp_ns, out_head_relation);
 
 	for (uint32_t i = 0; i < view_count; i++) {
-		out_poses[i] = rh->r->latest.head.views[i].pose;
-		out_fovs[i] = rh->r->latest.head.views[i].fov;
+		out_poses[i] = data.head.views[i].pose;
+		out_fovs[i] = data.head.views[i].fov;
 	}
 }
 
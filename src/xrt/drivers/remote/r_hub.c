@@ -7,6 +7,11 @@
  * @ingroup drv_remote
  */
 
+#include "os/os_time.h"
+
+#include "math/m_api.h"
+#include "math/m_relation_history.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -18,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 
 #if defined(XRT_OS_WINDOWS)
 #include <winsock2.h>
@@ -55,6 +61,7 @@
  */
 
 DEBUG_GET_ONCE_LOG_OPTION(remote_log, "REMOTE_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(remote_udp, "REMOTE_UDP", false)
 
 #define R_TRACE(R, ...) U_LOG_IFL_T((R)->rc.log_level, __VA_ARGS__)
 #define R_DEBUG(R, ...) U_LOG_IFL_D((R)->rc.log_level, __VA_ARGS__)
@@ -89,6 +96,12 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 }
 
+static inline SOCKET
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+}
+
 static inline int
 socket_set_opt(SOCKET id, int flag)
 {
@@ -107,6 +120,18 @@ socket_write(SOCKET id, void *ptr, size_t size, size_t current)
 	return send(id, (const char *)ptr, size - current, 0);
 }
 
+static inline ssize_t
+socket_recv_datagram(SOCKET id, void *ptr, size_t size)
+{
+	return recv(id, (char *)ptr, (int)size, 0);
+}
+
+static inline ssize_t
+socket_send_datagram(SOCKET id, const void *ptr, size_t size)
+{
+	return send(id, (const char *)ptr, (int)size, 0);
+}
+
 #elif defined(XRT_OS_UNIX)
 
 static inline void
@@ -121,6 +146,12 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, 0);
 }
 
+static inline SOCKET
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, 0);
+}
+
 static inline int
 socket_set_opt(SOCKET id, int flag)
 {
@@ -139,6 +170,18 @@ socket_write(SOCKET id, void *ptr, size_t size, size_t current)
 	return write(id, ptr, size - current);
 }
 
+static inline ssize_t
+socket_recv_datagram(SOCKET id, void *ptr, size_t size)
+{
+	return recv(id, ptr, size, 0);
+}
+
+static inline ssize_t
+socket_send_datagram(SOCKET id, const void *ptr, size_t size)
+{
+	return send(id, ptr, size, 0);
+}
+
 #endif // XRT_OS_UNIX
 
 
@@ -203,6 +246,50 @@ cleanup:
 	return ret;
 }
 
+static int
+setup_udp_fd(struct r_hub *r)
+{
+	struct sockaddr_in server_address = {0};
+#if defined(XRT_OS_WINDOWS)
+	// Initialize Winsock.
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		int error = WSAGetLastError();
+		R_ERROR(r, "Failed to do WSAStartup %ld", error);
+		return error;
+	}
+#endif
+	SOCKET ret = socket_create_udp();
+
+	if (ret < 0) {
+		R_ERROR(r, "socket: %i", ret);
+		goto cleanup;
+	}
+
+	r->accept_fd = ret;
+
+	server_address.sin_family = AF_INET;
+	server_address.sin_addr.s_addr = htonl(INADDR_ANY);
+	server_address.sin_port = htons(r->port);
+
+	ret = bind(r->accept_fd, (struct sockaddr *)&server_address, sizeof(server_address));
+	if (ret < 0) {
+		R_ERROR(r, "bind: %i", ret);
+		socket_close(r->accept_fd);
+		r->accept_fd = -1;
+		goto cleanup;
+	}
+
+	R_INFO(r, "Receiving datagrams on %s port %d", inet_ntoa(server_address.sin_addr), r->port);
+
+	return 0;
+cleanup:
+#if defined(XRT_OS_WINDOWS)
+	WSACleanup();
+#endif
+	return ret;
+}
+
 static bool
 wait_for_read_and_to_continue(struct r_hub *r, SOCKET socket)
 {
@@ -303,12 +390,134 @@ read_one(struct r_hub *r, struct r_remote_data *data)
 	return 0;
 }
 
+static void
+push_controller(struct m_relation_history *history, const struct r_remote_controller_data *data, uint64_t ts)
+{
+	if (!data->active) {
+		m_relation_history_clear(history);
+		return;
+	}
+
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
+	rel.pose = data->pose;
+	rel.linear_velocity = data->linear_velocity;
+
+	// The angular velocity is sent in body space, the relation wants it in base space.
+	math_quat_rotate_derivative(&data->pose.orientation, &data->angular_velocity, &rel.angular_velocity);
+
+	m_relation_history_push(history, &rel, ts);
+}
+
+static void
+push_head(struct m_relation_history *history, const struct r_head_data *data, uint64_t ts)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+	rel.pose = data->center;
+
+	// No velocities are sent for the head, derive them from the previous pose.
+	m_relation_history_estimate_motion(history, &rel, ts, &rel);
+	m_relation_history_push(history, &rel, ts);
+}
+
+static void
+update_latest(struct r_hub *r, const struct r_remote_data *data)
+{
+	uint64_t now = os_monotonic_get_ns();
+
+	u_seqlock_write_begin(&r->latest_seqlock);
+	r->latest = *data;
+	r->latest_timestamp_ns = now;
+	u_seqlock_write_end(&r->latest_seqlock);
+
+	push_head(r->history.head, &data->head, now);
+	push_controller(r->history.left, &data->left, now);
+	push_controller(r->history.right, &data->right, now);
+}
+
+/*!
+ * Validates a datagram and applies its newest state, if that is newer than
+ * anything seen before. Entries older than the newest are repeats that only
+ * matter when the datagrams carrying them were lost, since this is a state
+ * and not an event protocol the newest entry supersedes them.
+ */
+static void
+handle_datagram(struct r_hub *r, const uint8_t *buffer, size_t size)
+{
+	struct r_remote_udp_header header;
+	if (size < sizeof(header)) {
+		R_WARN(r, "Datagram too small: %zu", size);
+		return;
+	}
+
+	memcpy(&header, buffer, sizeof(header));
+	if (header.header != R_UDP_HEADER_VALUE || header.count == 0 || header.count > R_UDP_MAX_BATCH ||
+	    size != sizeof(header) + header.count * sizeof(struct r_remote_data)) {
+		R_WARN(r, "Invalid datagram, header 0x%016" PRIx64 " count %u size %zu", header.header, header.count,
+		       size);
+		return;
+	}
+
+	// Signed distance handles the sequence wrapping around.
+	int32_t diff = (int32_t)(header.sequence - r->udp.sequence);
+	if (r->udp.have_sequence && diff <= 0) {
+		r->udp.out_of_order++;
+		return;
+	}
+
+	// Anything between the last applied and the oldest entry here never arrived.
+	if (r->udp.have_sequence && (uint32_t)diff > header.count) {
+		r->udp.lost += (uint32_t)diff - header.count;
+	}
+
+	struct r_remote_data data;
+	memcpy(&data, buffer + sizeof(header) + (header.count - 1) * sizeof(data), sizeof(data));
+
+	r->udp.have_sequence = true;
+	r->udp.sequence = header.sequence;
+
+	update_latest(r, &data);
+}
+
+static void
+run_udp(struct r_hub *r)
+{
+	uint8_t buffer[sizeof(struct r_remote_udp_header) + R_UDP_MAX_BATCH * sizeof(struct r_remote_data)];
+
+	while (os_thread_helper_is_running(&r->oth)) {
+		// Only false when stopping or on errors.
+		if (!wait_for_read_and_to_continue(r, r->accept_fd)) {
+			break;
+		}
+
+		ssize_t ret = socket_recv_datagram(r->accept_fd, buffer, sizeof(buffer));
+		if (ret < 0) {
+			R_ERROR(r, "recv: %zi", ret);
+			break;
+		}
+
+		handle_datagram(r, buffer, (size_t)ret);
+	}
+}
+
 static void *
 run_thread(void *ptr)
 {
 	struct r_hub *r = (struct r_hub *)ptr;
 	int ret;
 
+	if (r->udp.enabled) {
+		ret = setup_udp_fd(r);
+		if (ret >= 0) {
+			run_udp(r);
+		}
+		R_INFO(r, "Leaving thread");
+		return NULL;
+	}
+
 	ret = setup_accept_fd(r);
 	if (ret < 0) {
 		R_INFO(r, "Leaving thread");
@@ -327,6 +536,11 @@ run_thread(void *ptr)
 		r_remote_connection_write_one(&r->rc, &r->reset);
 		r_remote_connection_write_one(&r->rc, &r->latest);
 
+		// Poses from a new connection should not be mixed with the old ones.
+		m_relation_history_clear(r->history.head);
+		m_relation_history_clear(r->history.left);
+		m_relation_history_clear(r->history.right);
+
 		while (true) {
 			struct r_remote_data data;
 
@@ -335,7 +549,7 @@ run_thread(void *ptr)
 				break;
 			}
 
-			r->latest = data;
+			update_latest(r, &data);
 		}
 	}
 
@@ -374,6 +588,10 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 		xrt_device_destroy(&r->base.xdevs[i]);
 	}
 
+	m_relation_history_destroy(&r->history.head);
+	m_relation_history_destroy(&r->history.left);
+	m_relation_history_destroy(&r->history.right);
+
 	// Should be safe to destroy the sockets now.
 	if (r->accept_fd >= 0) {
 		socket_close(r->accept_fd);
@@ -396,10 +614,21 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 
 /*
  *
- * 'Exported' create function.
+ * 'Exported' functions.
  *
  */
 
+void
+r_hub_get_latest(struct r_hub *r, struct r_remote_data *out_data, uint64_t *out_timestamp_ns)
+{
+	uint32_t seq;
+	do {
+		seq = u_seqlock_read_begin(&r->latest_seqlock);
+		*out_data = r->latest;
+		*out_timestamp_ns = r->latest_timestamp_ns;
+	} while (u_seqlock_read_retry(&r->latest_seqlock, seq));
+}
+
 xrt_result_t
 r_create_devices(uint16_t port,
                  struct xrt_session_event_sink *broadcast,
@@ -429,12 +658,16 @@ r_create_devices(uint16_t port,
 	r->reset.right.pose.position.z = -0.5f;
 	r->reset.right.pose.orientation.w = 1.0f;
 	r->latest = r->reset;
+	m_relation_history_create(&r->history.head);
+	m_relation_history_create(&r->history.left);
+	m_relation_history_create(&r->history.right);
 	r->rc.log_level = debug_get_log_option_remote_log();
 	r->gui.hmd = true;
 	r->gui.left = true;
 	r->gui.right = true;
 	r->port = port;
 	r->accept_fd = -1;
+	r->udp.enabled = debug_get_bool_option_remote_udp();
 	r->rc.fd = -1;
 
 	snprintf(r->origin.name, sizeof(r->origin.name), "Remote Simulator");
@@ -521,6 +754,10 @@ r_create_devices(uint16_t port,
 	// u_var_add_gui_header(r, &r->gui.right, "Right");
 	u_var_add_bool(r, &r->latest.right.active, "right.active");
 	u_var_add_pose(r, &r->latest.right.pose, "right.pose");
+	if (r->udp.enabled) {
+		u_var_add_ro_u64(r, &r->udp.lost, "udp.lost");
+		u_var_add_ro_u64(r, &r->udp.out_of_order, "udp.out_of_order");
+	}
 
 	/*
 	 * Done now.
@@ -539,6 +776,29 @@ r_create_devices(uint16_t port,
  *
  */
 
+static int
+resolve_address(struct r_remote_connection *rc, const char *ip_addr, uint16_t port, struct sockaddr_in *out_addr)
+{
+	int ret;
+
+	// Address
+	out_addr->sin_family = AF_INET;
+	out_addr->sin_port = htons(port);
+
+	// inet_pton/InetPton resolves "localhost" as 0.0.0.0 or 255.255.255.255, and it causes connection error. To
+	// avoid this issue, the following logic converts "localhost" to "127.0.0.1" first.
+	if (strcmp("localhost", ip_addr) == 0) {
+		ret = inet_pton(AF_INET, "127.0.0.1", &out_addr->sin_addr);
+	} else {
+		ret = inet_pton(AF_INET, ip_addr, &out_addr->sin_addr);
+	}
+	if (ret < 0) {
+		RC_ERROR(rc, "Failed to do inet pton for %s: %i", ip_addr, ret);
+	}
+
+	return ret;
+}
+
 int
 r_remote_connection_init(struct r_remote_connection *rc, const char *ip_addr, uint16_t port)
 {
@@ -559,19 +819,8 @@ r_remote_connection_init(struct r_remote_connection *rc, const char *ip_addr, ui
 	}
 #endif
 
-	// Address
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(port);
-
-	// inet_pton/InetPton resolves "localhost" as 0.0.0.0 or 255.255.255.255, and it causes connection error. To
-	// avoid this issue, the following logic converts "localhost" to "127.0.0.1" first.
-	if (strcmp("localhost", ip_addr) == 0) {
-		ret = inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
-	} else {
-		ret = inet_pton(AF_INET, ip_addr, &addr.sin_addr);
-	}
+	ret = resolve_address(rc, ip_addr, port, &addr);
 	if (ret < 0) {
-		RC_ERROR(rc, "Failed to do inet pton for %s: %i", ip_addr, ret);
 		goto cleanup;
 	}
 
@@ -668,3 +917,91 @@ r_remote_connection_write_one(struct r_remote_connection *rc, const struct r_rem
 
 	return 0;
 }
+
+int
+r_remote_connection_init_udp(struct r_remote_connection *rc, const char *ip_addr, uint16_t port)
+{
+	struct sockaddr_in addr = {0};
+	int conn_fd;
+	int ret;
+
+	// Set log level.
+	rc->log_level = debug_get_log_option_remote_log();
+	rc->sequence = 0;
+
+#if defined(XRT_OS_WINDOWS)
+	// Initialize Winsock.
+	WSADATA wsaData;
+	ret = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	if (ret != 0) {
+		RC_ERROR(rc, "Failed to do WSAStartup %ld", WSAGetLastError());
+		return ret;
+	}
+#endif
+
+	ret = resolve_address(rc, ip_addr, port, &addr);
+	if (ret < 0) {
+		goto cleanup;
+	}
+
+	ret = socket_create_udp();
+	if (ret < 0) {
+		RC_ERROR(rc, "Failed to create socket: %i", ret);
+		goto cleanup;
+	}
+
+	conn_fd = ret;
+
+	// Only sets the default destination, nothing is sent.
+	ret = connect(conn_fd, (struct sockaddr *)&addr, sizeof(addr));
+	if (ret != 0) {
+		RC_ERROR(rc, "Failed to connect id %d and addr %s", conn_fd, inet_ntoa(addr.sin_addr));
+		socket_close(conn_fd);
+		goto cleanup;
+	}
+
+	rc->fd = conn_fd;
+
+	return 0;
+
+cleanup:
+#if defined(XRT_OS_WINDOWS)
+	WSACleanup();
+#endif
+	return ret;
+}
+
+int
+r_remote_connection_write_udp(struct r_remote_connection *rc,
+                              const struct r_remote_data *data,
+                              uint32_t count,
+                              uint32_t new_count)
+{
+	if (count == 0 || count > R_UDP_MAX_BATCH || new_count > count) {
+		RC_ERROR(rc, "Invalid count %u or new count %u", count, new_count);
+		return -1;
+	}
+
+	uint8_t buffer[sizeof(struct r_remote_udp_header) + R_UDP_MAX_BATCH * sizeof(struct r_remote_data)];
+
+	rc->sequence += new_count;
+
+	struct r_remote_udp_header header = {
+	    .header = R_UDP_HEADER_VALUE,
+	    .sequence = rc->sequence,
+	    .count = count,
+	};
+
+	const size_t size = sizeof(header) + count * sizeof(*data);
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + sizeof(header), data, count * sizeof(*data));
+
+	// A datagram is sent whole or not at all.
+	ssize_t ret = socket_send_datagram(rc->fd, buffer, size);
+	if (ret < 0) {
+		RC_ERROR(rc, "send: %zi", ret);
+		return (int)ret;
+	}
+
+	return 0;
+}
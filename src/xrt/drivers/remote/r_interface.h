@@ -118,6 +118,40 @@ struct r_remote_data
 	struct r_remote_controller_data left, right;
 };
 
+/*!
+ * Header value to be set in UDP datagrams.
+ *
+ * @ingroup drv_remote
+ */
+#define R_UDP_HEADER_VALUE (*(uint64_t *)"mndrmu1\0")
+
+/*!
+ * Most @ref r_remote_data a single UDP datagram carries, keeps the datagram
+ * under a 1500 byte MTU so it is never fragmented.
+ *
+ * @ingroup drv_remote
+ */
+#define R_UDP_MAX_BATCH (3)
+
+/*!
+ * Start of every UDP datagram, followed by @ref count @ref r_remote_data
+ * oldest first. The entries have consecutive sequence numbers ending with
+ * @ref sequence, so repeating the last few states in each datagram lets the
+ * hub recover from lost datagrams.
+ *
+ * @ingroup drv_remote
+ */
+struct r_remote_udp_header
+{
+	uint64_t header;
+
+	//! Sequence number of the last entry in the datagram.
+	uint32_t sequence;
+
+	//! Number of entries in the datagram, at most @ref R_UDP_MAX_BATCH.
+	uint32_t count;
+};
+
 /*!
  * Shared connection.
  *
@@ -130,11 +164,17 @@ struct r_remote_connection
 
 	//! Socket.
 	int fd;
+
+	//! Sequence number of the last state sent, UDP only.
+	uint32_t sequence;
 };
 
 /*!
  * Creates the remote system devices.
  *
+ * Listens for a TCP connection on @p port, or if the `REMOTE_UDP` option is
+ * set receives @ref r_remote_udp_header datagrams on it instead.
+ *
  * @ingroup drv_remote
  */
 xrt_result_t
@@ -157,6 +197,34 @@ r_remote_connection_read_one(struct r_remote_connection *rc, struct r_remote_dat
 int
 r_remote_connection_write_one(struct r_remote_connection *rc, const struct r_remote_data *data);
 
+/*!
+ * Initializes a UDP connection, there is no handshake so the reset and
+ * latest data is not read back from the hub.
+ *
+ * @ingroup drv_remote
+ */
+int
+r_remote_connection_init_udp(struct r_remote_connection *rc, const char *addr, uint16_t port);
+
+/*!
+ * Sends @p count states, oldest first, in one datagram over a connection
+ * made with @ref r_remote_connection_init_udp. Each state gets the next
+ * sequence number, to send redundant states pass the last few sent again
+ * with the new ones, only the new ones count towards the sequence.
+ *
+ * @param rc Connection.
+ * @param data States to send, the last @p new_count of them are new.
+ * @param count Number of states in @p data, at most @ref R_UDP_MAX_BATCH.
+ * @param new_count How many of the states have not been sent before.
+ *
+ * @ingroup drv_remote
+ */
+int
+r_remote_connection_write_udp(struct r_remote_connection *rc,
+                              const struct r_remote_data *data,
+                              uint32_t count,
+                              uint32_t new_count);
+
 
 #ifdef __cplusplus
 }
@@ -15,6 +15,7 @@
 
 #include "os/os_threading.h"
 
+#include "util/u_seqlock.h"
 #include "util/u_hand_tracking.h"
 
 #include "r_interface.h"
@@ -25,6 +26,9 @@ extern "C" {
 #endif
 
 
+struct m_relation_history;
+
+
 /*!
  * Central object remote object.
  *
@@ -44,12 +48,44 @@ struct r_hub
 	//! The data that the is the reset position.
 	struct r_remote_data reset;
 
-	//! The latest data received.
+	//! The latest data received, only written by the thread, read with @ref r_hub_get_latest.
 	struct r_remote_data latest;
 
-	//! Incoming connection socket.
+	//! Guards @ref latest and @ref latest_timestamp_ns.
+	struct u_seqlock latest_seqlock;
+
+	//! When @ref latest was received, zero before anything has been received.
+	uint64_t latest_timestamp_ns;
+
+	//! Received poses stamped with their receive time, so they can be interpolated and predicted.
+	struct
+	{
+		struct m_relation_history *head;
+		struct m_relation_history *left;
+		struct m_relation_history *right;
+	} history;
+
+	//! Incoming connection socket, or the datagram socket in UDP mode.
 	int accept_fd;
 
+	//! Receive @ref r_remote_udp_header datagrams instead of a TCP stream.
+	struct
+	{
+		bool enabled;
+
+		//! Has any datagram been received, @ref sequence is valid.
+		bool have_sequence;
+
+		//! Sequence number of the newest state applied.
+		uint32_t sequence;
+
+		//! States that were never received, not even as a repeat.
+		uint64_t lost;
+
+		//! Datagrams that arrived after a newer one and were dropped.
+		uint64_t out_of_order;
+	} udp;
+
 	uint16_t port;
 
 	struct os_thread_helper oth;
@@ -95,6 +131,14 @@ struct r_device
 };
 
 
+/*!
+ * Copies out the latest data received, safe to call from any thread.
+ *
+ * @public @memberof r_hub
+ */
+void
+r_hub_get_latest(struct r_hub *r, struct r_remote_data *out_data, uint64_t *out_timestamp_ns);
+
 struct xrt_device *
 r_hmd_create(struct r_hub *r);
 
@@ -53,12 +53,14 @@ static void
 rift_s_system_free(struct rift_s_system *sys);
 
 static int
-read_camera_calibration(struct os_hid_device *hid_hmd, struct rift_s_camera_calibration_block *calibration)
+read_camera_calibration(struct os_hid_device *hid_hmd,
+                        const char *serial,
+                        struct rift_s_camera_calibration_block *calibration)
 {
 	char *json = NULL;
 	int json_len = 0;
 
-	int ret = rift_s_read_firmware_block(hid_hmd, RIFT_S_FIRMWARE_BLOCK_CAMERA_CALIB, &json, &json_len);
+	int ret = rift_s_read_firmware_block_cached(hid_hmd, serial, RIFT_S_FIRMWARE_BLOCK_CAMERA_CALIB, &json, &json_len);
 	if (ret < 0)
 		return ret;
 
@@ -69,12 +71,14 @@ read_camera_calibration(struct os_hid_device *hid_hmd, struct rift_s_camera_cali
 }
 
 static int
-read_hmd_fw_imu_calibration(struct os_hid_device *hid_hmd, struct rift_s_imu_calibration *imu_calibration)
+read_hmd_fw_imu_calibration(struct os_hid_device *hid_hmd,
+                            const char *serial,
+                            struct rift_s_imu_calibration *imu_calibration)
 {
 	char *json = NULL;
 	int json_len = 0;
 
-	int ret = rift_s_read_firmware_block(hid_hmd, RIFT_S_FIRMWARE_BLOCK_IMU_CALIB, &json, &json_len);
+	int ret = rift_s_read_firmware_block_cached(hid_hmd, serial, RIFT_S_FIRMWARE_BLOCK_IMU_CALIB, &json, &json_len);
 	if (ret < 0)
 		return ret;
 
@@ -85,12 +89,12 @@ read_hmd_fw_imu_calibration(struct os_hid_device *hid_hmd, struct rift_s_imu_cal
 }
 
 static int
-read_hmd_proximity_threshold(struct os_hid_device *hid_hmd, int *proximity_threshold)
+read_hmd_proximity_threshold(struct os_hid_device *hid_hmd, const char *serial, int *proximity_threshold)
 {
 	char *json = NULL;
 	int json_len = 0;
 
-	int ret = rift_s_read_firmware_block(hid_hmd, RIFT_S_FIRMWARE_BLOCK_THRESHOLD, &json, &json_len);
+	int ret = rift_s_read_firmware_block_cached(hid_hmd, serial, RIFT_S_FIRMWARE_BLOCK_THRESHOLD, &json, &json_len);
 	if (ret < 0)
 		return ret;
 
@@ -101,7 +105,7 @@ read_hmd_proximity_threshold(struct os_hid_device *hid_hmd, int *proximity_thres
 }
 
 static int
-read_hmd_config(struct os_hid_device *hid_hmd, struct rift_s_hmd_config *config)
+read_hmd_config(struct os_hid_device *hid_hmd, const char *serial, struct rift_s_hmd_config *config)
 {
 	int ret;
 
@@ -123,20 +127,20 @@ read_hmd_config(struct os_hid_device *hid_hmd, struct rift_s_hmd_config *config)
 		return ret;
 	}
 
-	ret = read_hmd_fw_imu_calibration(hid_hmd, &config->imu_calibration);
+	ret = read_hmd_fw_imu_calibration(hid_hmd, serial, &config->imu_calibration);
 	if (ret < 0) {
 		RIFT_S_ERROR("Failed to read IMU configuration block");
 		return ret;
 	}
 
 	/* Configure the proximity sensor threshold */
-	ret = read_hmd_proximity_threshold(hid_hmd, &config->proximity_threshold);
+	ret = read_hmd_proximity_threshold(hid_hmd, serial, &config->proximity_threshold);
 	if (ret < 0) {
 		RIFT_S_ERROR("Failed to read proximity sensor firmware block");
 		return ret;
 	}
 
-	ret = read_camera_calibration(hid_hmd, &config->camera_calibration);
+	ret = read_camera_calibration(hid_hmd, serial, &config->camera_calibration);
 	if (ret < 0) {
 		RIFT_S_ERROR("Failed to read HMD camera calibration block");
 		return ret;
@@ -180,7 +184,7 @@ rift_s_system_create(struct xrt_prober *xp,
 		goto cleanup;
 	}
 
-	if (read_hmd_config(hid_hmd, &sys->hmd_config) < 0) {
+	if (read_hmd_config(hid_hmd, (const char *)hmd_serial_no, &sys->hmd_config) < 0) {
 		RIFT_S_ERROR("Failed to read HMD configuration");
 		goto cleanup;
 	}
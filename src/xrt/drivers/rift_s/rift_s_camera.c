@@ -390,17 +390,24 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 
 	// If the top left pixel is > 128, send as SLAM frame else controller
 	if (row_data.data.frame_type & 0x80) {
-		int y_offset = get_y_offset(cam, 0, &row_data);
-		struct xrt_rect roi = {.offset = {0, y_offset}, .extent = {.w = xf->width, .h = 480}};
-
-		struct xrt_frame *xf_crop = NULL;
-		u_frame_create_roi(xf, roi, &xf_crop);
-		u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
-		xrt_frame_reference(&xf_crop, NULL);
+		if (u_sink_debug_is_active(&cam->debug_sinks[0])) {
+			int y_offset = get_y_offset(cam, 0, &row_data);
+			struct xrt_rect roi = {.offset = {0, y_offset}, .extent = {.w = xf->width, .h = 480}};
+
+			struct xrt_frame *xf_crop = NULL;
+			u_frame_create_roi(xf, roi, &xf_crop);
+			u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
+			xrt_frame_reference(&xf_crop, NULL);
+		}
 
-		/* Extract camera frames and push to the tracker */
+		/* Extract camera frames and push to the tracker. The views all share the
+		 * storage of the combined frame, only cameras someone listens to get one,
+		 * and the first camera always does as it drives the auto exposure. */
 		struct xrt_frame *frames[RIFT_S_CAMERA_COUNT] = {0};
 		for (int i = 0; i < RIFT_S_CAMERA_COUNT; i++) {
+			if (i != 0 && !rift_s_tracker_wants_slam_frame(cam->tracker, i)) {
+				continue;
+			}
 			frames[i] = rift_s_camera_extract_frame(cam, CAM_IDX_TO_ID[i], xf, &row_data);
 		}
 
@@ -414,7 +421,7 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 		for (int i = 0; i < RIFT_S_CAMERA_COUNT; i++) {
 			xrt_frame_reference(&frames[i], NULL);
 		}
-	} else {
+	} else if (u_sink_debug_is_active(&cam->debug_sinks[1])) {
 		struct xrt_rect roi = {.offset = {0, 40}, .extent = {.w = xf->width, .h = 480}};
 		struct xrt_frame *xf_crop = NULL;
 
@@ -62,6 +62,14 @@ rift_s_get_tracked_pose(struct xrt_device *xdev,
 	rift_s_tracker_get_tracked_pose(hmd->tracker, RIFT_S_TRACKER_POSE_DEVICE, at_timestamp_ns, out_relation);
 }
 
+static xrt_result_t
+rift_s_hmd_set_feature_enabled(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled)
+{
+	struct rift_s_hmd *hmd = (struct rift_s_hmd *)(xdev);
+
+	return rift_s_tracker_set_feature_enabled(hmd->tracker, type, enabled);
+}
+
 void
 rift_s_hmd_handle_report(struct rift_s_hmd *hmd, timepoint_ns local_ts, rift_s_hmd_report_t *report)
 {
@@ -200,7 +208,7 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 	enum u_device_alloc_flags flags =
 	    (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD | U_DEVICE_ALLOC_TRACKING_NONE);
 
-	struct rift_s_hmd *hmd = U_DEVICE_ALLOCATE(struct rift_s_hmd, flags, 1, 0);
+	struct rift_s_hmd *hmd = U_DEVICE_ALLOCATE(struct rift_s_hmd, flags, 2, 0);
 	if (hmd == NULL) {
 		return NULL;
 	}
@@ -215,6 +223,7 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 	hmd->base.update_inputs = u_device_noop_update_inputs;
 	hmd->base.get_tracked_pose = rift_s_get_tracked_pose;
 	hmd->base.get_view_poses = u_device_get_view_poses;
+	hmd->base.set_feature_enabled = rift_s_hmd_set_feature_enabled;
 	hmd->base.destroy = rift_s_hmd_destroy;
 	hmd->base.name = XRT_DEVICE_GENERIC_HMD;
 	hmd->base.device_type = XRT_DEVICE_TYPE_HMD;
@@ -227,6 +236,7 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 
 	// Setup input.
 	hmd->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
+	hmd->base.inputs[1].name = XRT_INPUT_GENERIC_HEAD_DETECT;
 
 	hmd->last_imu_timestamp_ns = 0;
 
@@ -318,6 +328,8 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 	hmd->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	hmd->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	hmd->base.compute_distortion = rift_s_compute_distortion;
+	hmd->base.compute_distortion_thread_safe = true;
+	u_distortion_panotools_fill_in_model(&hmd->base, hmd->distortion_vals);
 	u_distortion_mesh_fill_in_compute(&hmd->base);
 
 	/* Set Opaque blend mode */
@@ -345,6 +357,10 @@ cleanup:
 void
 rift_s_hmd_set_proximity(struct rift_s_hmd *hmd, bool prox_sensor)
 {
+	/* Let the compositor know if the headset is being worn. */
+	hmd->base.inputs[1].value.boolean = prox_sensor;
+	hmd->base.inputs[1].timestamp = (int64_t)os_monotonic_get_ns();
+
 	/* Enable the screen if the prox sensor is triggered, or turn it off otherwise. */
 	if (prox_sensor != hmd->display_on) {
 		struct os_hid_device *hid_hmd = rift_s_system_hid_handle(hmd->sys);
@@ -29,6 +29,8 @@
 #include "os/os_hid.h"
 #include "os/os_time.h"
 
+#include "util/u_file.h"
+
 #include "xrt/xrt_defines.h"
 
 #include "rift_s.h"
@@ -237,26 +239,22 @@ read_one_fw_block(struct os_hid_device *dev, uint8_t block_id, uint32_t pos, uin
 	return ret;
 }
 
-int
-rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **data_out, int *len_out)
+/* Reads the 12 byte block header, 8 byte checksum(?) and 4 byte size */
+static int
+read_fw_block_header(struct os_hid_device *dev, uint8_t block_id, uint64_t *checksum_out, uint32_t *len_out)
 {
-	uint32_t pos = 0x00, block_len;
 	unsigned char buf[64] = {
 	    0x4a,
 	    0x00,
 	};
-	unsigned char *outbuf;
-	size_t total_read = 0;
-	int ret;
 
-	ret = read_one_fw_block(dev, block_id, 0, 0xC, buf);
+	int ret = read_one_fw_block(dev, block_id, 0, 0xC, buf);
 	if (ret < 0) {
 		RIFT_S_ERROR("Failed to read fw block %02x header", block_id);
 		return ret;
 	}
 
-	/* The block header is 12 bytes. 8 byte checksum, 4 byte size? */
-	block_len = *(uint32_t *)(buf + 16);
+	uint32_t block_len = *(uint32_t *)(buf + 16);
 
 	if (block_len < 0xC || block_len == 0xFFFFFFFF)
 		return -1; /* Invalid block */
@@ -266,6 +264,24 @@ rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **d
 	printf ("FW Block %02x Header. Checksum(?) %08lx len %d\n", block_id, checksum, block_len);
 #endif
 
+	*checksum_out = *(uint64_t *)(buf + 8);
+	*len_out = block_len;
+
+	return ret;
+}
+
+static int
+read_fw_block_contents(struct os_hid_device *dev, uint8_t block_id, uint32_t block_len, char **data_out)
+{
+	unsigned char buf[64] = {
+	    0x4a,
+	    0x00,
+	};
+	uint32_t pos;
+	unsigned char *outbuf;
+	size_t total_read = 0;
+	int ret = 0;
+
 	/* Copy the contents of the fw block, minus the header */
 	outbuf = malloc(block_len + 1);
 	outbuf[block_len] = 0;
@@ -304,9 +320,148 @@ rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **d
 	}
 
 	*data_out = (char *)(outbuf);
+
+	return ret;
+}
+
+int
+rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **data_out, int *len_out)
+{
+	uint64_t checksum;
+	uint32_t block_len;
+
+	int ret = read_fw_block_header(dev, block_id, &checksum, &block_len);
+	if (ret < 0)
+		return ret;
+
+	ret = read_fw_block_contents(dev, block_id, block_len, data_out);
+	if (ret < 0)
+		return ret;
+
+	*len_out = block_len;
+
+	return ret;
+}
+
+#ifdef XRT_OS_LINUX
+/*
+ * Firmware blocks are cached on disk by headset serial and block id. The
+ * checksum and size from the block header are stored with the contents, the
+ * cached copy is only used if they still match what the headset reports.
+ */
+#define FW_BLOCK_CACHE_MAGIC 0x42465352 /* "RSFB" */
+
+struct fw_block_cache_header
+{
+	uint32_t magic;
+	uint32_t block_len;
+	uint64_t checksum;
+};
+
+static FILE *
+open_fw_block_cache(const char *serial, uint8_t block_id, const char *mode)
+{
+	char clean[64];
+	size_t i;
+
+	/* Only keep characters that are safe in a file name */
+	for (i = 0; serial[i] != '\0' && i < sizeof(clean) - 1; i++) {
+		char c = serial[i];
+		bool ok = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		clean[i] = ok ? c : '_';
+	}
+	clean[i] = '\0';
+
+	char filename[96];
+	snprintf(filename, sizeof(filename), "rift_s_%s_block_%02x.bin", clean, block_id);
+
+	return u_file_open_file_in_cache_dir(filename, mode);
+}
+
+static bool
+load_fw_block_cache(const char *serial, uint8_t block_id, uint64_t checksum, uint32_t block_len, char **data_out)
+{
+	FILE *file = open_fw_block_cache(serial, block_id, "rb");
+	if (file == NULL)
+		return false;
+
+	struct fw_block_cache_header header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == FW_BLOCK_CACHE_MAGIC &&
+	          header.checksum == checksum && header.block_len == block_len;
+
+	char *outbuf = NULL;
+	if (ok) {
+		outbuf = malloc(block_len + 1);
+		outbuf[block_len] = 0;
+		ok = fread(outbuf, 1, block_len, file) == block_len;
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		free(outbuf);
+		return false;
+	}
+
+	*data_out = outbuf;
+	return true;
+}
+
+static void
+store_fw_block_cache(const char *serial, uint8_t block_id, uint64_t checksum, uint32_t block_len, const char *data)
+{
+	FILE *file = open_fw_block_cache(serial, block_id, "wb");
+	if (file == NULL)
+		return;
+
+	struct fw_block_cache_header header = {
+	    .magic = FW_BLOCK_CACHE_MAGIC,
+	    .block_len = block_len,
+	    .checksum = checksum,
+	};
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, 1, block_len, file) == block_len;
+	fclose(file);
+
+	if (!ok)
+		RIFT_S_WARN("Failed to cache fw block %02x", block_id);
+}
+#endif
+
+int
+rift_s_read_firmware_block_cached(
+    struct os_hid_device *dev, const char *serial, uint8_t block_id, char **data_out, int *len_out)
+{
+#ifdef XRT_OS_LINUX
+	uint64_t checksum;
+	uint32_t block_len;
+
+	if (serial == NULL || serial[0] == '\0')
+		return rift_s_read_firmware_block(dev, block_id, data_out, len_out);
+
+	int ret = read_fw_block_header(dev, block_id, &checksum, &block_len);
+	if (ret < 0)
+		return ret;
+
+	if (load_fw_block_cache(serial, block_id, checksum, block_len, data_out)) {
+		RIFT_S_DEBUG("Using cached fw block %02x", block_id);
+		*len_out = block_len;
+		return 0;
+	}
+
+	ret = read_fw_block_contents(dev, block_id, block_len, data_out);
+	if (ret < 0)
+		return ret;
+
+	store_fw_block_cache(serial, block_id, checksum, block_len, *data_out);
+
 	*len_out = block_len;
 
 	return ret;
+#else
+	(void)serial;
+	return rift_s_read_firmware_block(dev, block_id, data_out, len_out);
+#endif
 }
 
 void
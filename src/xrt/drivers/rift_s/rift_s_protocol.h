@@ -295,6 +295,15 @@ rift_s_parse_controller_report(rift_s_controller_report_t *report, const unsigne
 int
 rift_s_read_firmware_block(struct os_hid_device *handle, uint8_t block_id, char **data_out, int *len_out);
 
+/*!
+ * Like @ref rift_s_read_firmware_block but keeps a copy in the cache
+ * directory, only the block header is read from the headset when the cached
+ * copy is still current.
+ */
+int
+rift_s_read_firmware_block_cached(
+    struct os_hid_device *handle, const char *serial, uint8_t block_id, char **data_out, int *len_out);
+
 int
 rift_s_read_devices_list(struct os_hid_device *handle, rift_s_devices_list_t *dev_list);
 
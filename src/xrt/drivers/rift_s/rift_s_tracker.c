@@ -32,7 +32,6 @@
 
 #include "util/u_debug.h"
 #include "util/u_device.h"
-#include "util/u_sink.h"
 #include "util/u_trace_marker.h"
 #include "util/u_var.h"
 
@@ -75,24 +74,34 @@ rift_s_tracker_get_tracked_pose_imu(struct xrt_device *xdev,
                                     struct xrt_space_relation *out_relation);
 
 static void
-rift_s_tracker_switch_method_cb(void *t_ptr)
-{
-	DRV_TRACE_MARKER();
+rift_s_tracker_fall_back_to_3dof(struct rift_s_tracker *t);
 
-	struct rift_s_tracker *t = t_ptr;
-	t->slam_over_3dof = !t->slam_over_3dof;
+static void
+rift_s_tracker_update_switch_label(struct rift_s_tracker *t)
+{
 	struct u_var_button *btn = &t->gui.switch_tracker_btn;
 
 	if (t->slam_over_3dof) { // Use SLAM
 		snprintf(btn->label, sizeof(btn->label), "Switch to 3DoF Tracking");
 	} else { // Use 3DoF
 		snprintf(btn->label, sizeof(btn->label), "Switch to SLAM Tracking");
+	}
+}
 
-		os_mutex_lock(&t->mutex);
-		m_imu_3dof_reset(&t->fusion.i3dof);
-		t->fusion.i3dof.rot = t->pose.orientation;
-		os_mutex_unlock(&t->mutex);
+static void
+rift_s_tracker_switch_method_cb(void *t_ptr)
+{
+	DRV_TRACE_MARKER();
+
+	struct rift_s_tracker *t = t_ptr;
+
+	if (t->slam_over_3dof) {
+		rift_s_tracker_fall_back_to_3dof(t);
+	} else {
+		t->slam_over_3dof = true;
 	}
+
+	rift_s_tracker_update_switch_label(t);
 }
 
 XRT_MAYBE_UNUSED void
@@ -332,6 +341,8 @@ rift_s_tracker_create(struct xrt_tracking_origin *origin,
 	t->base.tracking_origin = origin;
 	t->base.get_tracked_pose = rift_s_tracker_get_tracked_pose_imu;
 
+	m_clock_tracker_init(&t->hw2mono_tracker, 0, 0);
+
 	// Pose / state lock
 	int ret = os_mutex_init(&t->mutex);
 	if (ret != 0) {
@@ -361,6 +372,8 @@ rift_s_tracker_create(struct xrt_tracking_origin *origin,
 
 	t->tracking.slam_enabled = slam_enabled;
 	t->tracking.hand_enabled = hand_enabled;
+	t->tracking.slam_active = slam_enabled;
+	t->tracking.hand_active = hand_enabled;
 
 	t->slam_over_3dof = slam_enabled; // We prefer SLAM over 3dof tracking if possible
 
@@ -404,7 +417,7 @@ rift_s_tracker_create(struct xrt_tracking_origin *origin,
 	// Initialize hand tracker
 	struct xrt_slam_sinks *hand_sinks = NULL;
 	struct xrt_device *hand_device = NULL;
-	struct xrt_hand_masks_sink *masks_sink = slam_sinks->hand_masks;
+	struct xrt_hand_masks_sink *masks_sink = slam_sinks != NULL ? slam_sinks->hand_masks : NULL;
 	if (t->tracking.hand_enabled) {
 		int hand_status = rift_s_create_hand_tracker(t, xfctx, masks_sink, &hand_sinks, &hand_device);
 		if (hand_status != 0 || hand_sinks == NULL || hand_device == NULL) {
@@ -414,27 +427,16 @@ rift_s_tracker_create(struct xrt_tracking_origin *origin,
 		}
 	}
 
-	// Setup sinks depending on tracking configuration
-	struct xrt_slam_sinks entry_sinks = {0};
-	if (slam_enabled && hand_enabled) {
-		struct xrt_frame_sink *entry_cam0_sink = NULL;
-		struct xrt_frame_sink *entry_cam1_sink = NULL;
-
-		u_sink_split_create(xfctx, slam_sinks->cams[0], hand_sinks->cams[0], &entry_cam0_sink);
-		u_sink_split_create(xfctx, slam_sinks->cams[1], hand_sinks->cams[1], &entry_cam1_sink);
-
-		entry_sinks = *slam_sinks;
-		entry_sinks.cams[0] = entry_cam0_sink;
-		entry_sinks.cams[1] = entry_cam1_sink;
-	} else if (slam_enabled) {
-		entry_sinks = *slam_sinks;
-	} else if (hand_enabled) {
-		entry_sinks = *hand_sinks;
-	} else {
-		entry_sinks = (struct xrt_slam_sinks){0};
+	/*
+	 * Kept apart instead of behind split sinks, so each tracker can be
+	 * stopped and restarted on its own, see rift_s_tracker_set_feature_enabled.
+	 */
+	if (slam_sinks != NULL) {
+		t->slam_sinks = *slam_sinks;
+	}
+	if (hand_sinks != NULL) {
+		t->hand_sinks = *hand_sinks;
 	}
-
-	t->slam_sinks = entry_sinks;
 	t->handtracker = hand_device;
 
 	return t;
@@ -466,13 +468,12 @@ rift_s_tracker_clock_update(struct rift_s_tracker *t, uint64_t device_timestamp_
 {
 	os_mutex_lock(&t->mutex);
 	time_duration_ns last_hw2mono = t->hw2mono;
-	const float freq = 250.0;
 
 	t->seen_clock_observations++;
 	if (t->seen_clock_observations < 100)
 		goto done;
 
-	m_clock_offset_a2b(freq, device_timestamp_ns, local_timestamp_ns, &t->hw2mono);
+	m_clock_tracker_a2b(&t->hw2mono_tracker, device_timestamp_ns, local_timestamp_ns, &t->hw2mono);
 
 	if (!t->have_hw2mono) {
 		time_duration_ns change_ns = last_hw2mono - t->hw2mono;
@@ -489,7 +490,7 @@ done:
 static void
 clock_hw2mono_get(struct rift_s_tracker *t, uint64_t device_ts, timepoint_ns *out)
 {
-	*out = t->hw2mono + device_ts;
+	*out = m_clock_tracker_get_a2b(&t->hw2mono_tracker, device_ts) + device_ts;
 }
 
 void
@@ -529,9 +530,11 @@ rift_s_tracker_imu_update(struct rift_s_tracker *t,
 
 	t->pose.orientation = t->fusion.i3dof.rot;
 
+	bool slam_active = t->tracking.slam_active;
+
 	os_mutex_unlock(&t->mutex);
 
-	if (t->slam_sinks.imu) {
+	if (slam_active && t->slam_sinks.imu) {
 		/* Push IMU sample to the SLAM tracker */
 		struct xrt_vec3_f64 accel64 = {accel->x, accel->y, accel->z};
 		struct xrt_vec3_f64 gyro64 = {gyro->x, gyro->y, gyro->z};
@@ -544,6 +547,19 @@ rift_s_tracker_imu_update(struct rift_s_tracker *t,
 
 #define UPPER_32BITS(x) ((x)&0xffffffff00000000ULL)
 
+/*!
+ * Whether frames of camera @p cam_index go anywhere. The sinks are set up at
+ * create time and the active flags are only a hint here, so this doesn't need
+ * the lock. Frames that are not wanted may be passed as NULL to
+ * @ref rift_s_tracker_push_slam_frames.
+ */
+bool
+rift_s_tracker_wants_slam_frame(struct rift_s_tracker *t, int cam_index)
+{
+	return (t->tracking.slam_active && t->slam_sinks.cams[cam_index] != NULL) ||
+	       (t->tracking.hand_active && t->hand_sinks.cams[cam_index] != NULL);
+}
+
 void
 rift_s_tracker_push_slam_frames(struct rift_s_tracker *t,
                                 uint64_t frame_ts_ns,
@@ -590,13 +606,22 @@ rift_s_tracker_push_slam_frames(struct rift_s_tracker *t,
 	RIFT_S_TRACE("SLAM frame timestamp %" PRIu64 " local %" PRIu64, frame_ts_ns, frame_time);
 
 	t->last_frame_time = frame_time;
+	bool slam_active = t->tracking.slam_active;
+	bool hand_active = t->tracking.hand_active;
 	os_mutex_unlock(&t->mutex);
 
 	for (int i = 0; i < RIFT_S_CAMERA_COUNT; i++) {
-		if (t->slam_sinks.cams[i]) {
-			frames[i]->timestamp = frame_time;
+		if (frames[i] == NULL) {
+			continue;
+		}
+
+		frames[i]->timestamp = frame_time;
+		if (slam_active && t->slam_sinks.cams[i]) {
 			xrt_sink_push_frame(t->slam_sinks.cams[i], frames[i]);
 		}
+		if (hand_active && t->hand_sinks.cams[i]) {
+			xrt_sink_push_frame(t->hand_sinks.cams[i], frames[i]);
+		}
 	}
 }
 
@@ -609,6 +634,46 @@ rift_s_tracker_correct_pose_from_basalt(struct xrt_pose *pose)
 	math_quat_rotate_vec3(&q, &pose->position, &pose->position);
 }
 
+//! The IMU pose from the SLAM tracker.
+static void
+rift_s_tracker_get_slam_relation(struct rift_s_tracker *t,
+                                 uint64_t at_timestamp_ns,
+                                 struct xrt_space_relation *out_relation)
+{
+	xrt_tracked_slam_get_tracked_pose(t->tracking.slam, at_timestamp_ns, out_relation);
+#ifdef XRT_FEATURE_SLAM
+	// !todo Correct pose depending on the VIT system in use, this should be done in the system itself.
+	// For now, assume that we are using Basalt.
+	rift_s_tracker_correct_pose_from_basalt(&out_relation->pose);
+#endif
+	out_relation->relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+}
+
+/*!
+ * Use the 3DoF tracker from now on, starting it from the latest SLAM pose so
+ * the position is kept and the orientation doesn't jump.
+ */
+static void
+rift_s_tracker_fall_back_to_3dof(struct rift_s_tracker *t)
+{
+	struct xrt_space_relation imu_relation = XRT_SPACE_RELATION_ZERO;
+	bool from_slam = t->tracking.slam_enabled && t->tracking.slam_active && t->slam_over_3dof;
+	if (from_slam) {
+		rift_s_tracker_get_slam_relation(t, os_monotonic_get_ns(), &imu_relation);
+	}
+
+	os_mutex_lock(&t->mutex);
+	t->slam_over_3dof = false;
+	if (from_slam) {
+		t->pose = imu_relation.pose;
+	}
+	m_imu_3dof_reset(&t->fusion.i3dof);
+	t->fusion.i3dof.rot = t->pose.orientation;
+	os_mutex_unlock(&t->mutex);
+}
+
 static void
 rift_s_tracker_get_tracked_pose_imu(struct xrt_device *xdev,
                                     enum xrt_input_name name,
@@ -635,19 +700,9 @@ rift_s_tracker_get_tracked_pose(struct rift_s_tracker *t,
 		m_relation_chain_push_pose(&xrc, &t->left_cam_from_imu);
 	}
 
-	if (t->tracking.slam_enabled && t->slam_over_3dof) {
+	if (t->tracking.slam_enabled && t->tracking.slam_active && t->slam_over_3dof) {
 		struct xrt_space_relation imu_relation = XRT_SPACE_RELATION_ZERO;
-
-		// Get the IMU pose from the SLAM tracker
-		xrt_tracked_slam_get_tracked_pose(t->tracking.slam, at_timestamp_ns, &imu_relation);
-#ifdef XRT_FEATURE_SLAM
-		// !todo Correct pose depending on the VIT system in use, this should be done in the system itself.
-		// For now, assume that we are using Basalt.
-		rift_s_tracker_correct_pose_from_basalt(&imu_relation.pose);
-#endif
-		imu_relation.relation_flags = (enum xrt_space_relation_flags)(
-		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
-		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+		rift_s_tracker_get_slam_relation(t, at_timestamp_ns, &imu_relation);
 
 		m_relation_chain_push_relation(&xrc, &imu_relation);
 	} else {
@@ -677,3 +732,59 @@ rift_s_tracker_start(struct rift_s_tracker *t)
 	t->ready_for_data = true;
 	os_mutex_unlock(&t->mutex);
 }
+
+xrt_result_t
+rift_s_tracker_set_feature_enabled(struct rift_s_tracker *t, enum xrt_device_feature_type type, bool enabled)
+{
+	switch (type) {
+	case XRT_DEVICE_FEATURE_SLAM_TRACKING:
+		if (!t->tracking.slam_enabled) {
+			return XRT_ERROR_FEATURE_NOT_SUPPORTED;
+		}
+
+		// Take over from the last SLAM pose before it stops being fed.
+		if (!enabled) {
+			rift_s_tracker_fall_back_to_3dof(t);
+		}
+
+		os_mutex_lock(&t->mutex);
+		t->tracking.slam_active = enabled;
+		if (enabled) {
+			t->slam_over_3dof = true;
+		}
+		os_mutex_unlock(&t->mutex);
+
+		rift_s_tracker_update_switch_label(t);
+		(void)snprintf(t->gui.slam_status, sizeof(t->gui.slam_status), "%s",
+		               enabled ? "Enabled" : "Paused (disabled at runtime)");
+		break;
+	case XRT_DEVICE_FEATURE_HAND_TRACKING:
+		if (!t->tracking.hand_enabled) {
+			return XRT_ERROR_FEATURE_NOT_SUPPORTED;
+		}
+
+		// Resume the hand tracker before feeding it again and pause it after it stops being fed.
+		if (enabled) {
+			xrt_device_set_feature_enabled(t->handtracker, XRT_DEVICE_FEATURE_HAND_TRACKING, true);
+		}
+
+		os_mutex_lock(&t->mutex);
+		t->tracking.hand_active = enabled;
+		os_mutex_unlock(&t->mutex);
+
+		// Otherwise its history keeps predicting the hands from the last frame.
+		if (!enabled) {
+			xrt_device_set_feature_enabled(t->handtracker, XRT_DEVICE_FEATURE_HAND_TRACKING, false);
+		}
+
+		(void)snprintf(t->gui.hand_status, sizeof(t->gui.hand_status), "%s",
+		               enabled ? "Enabled" : "Paused (disabled at runtime)");
+		break;
+	default: return XRT_ERROR_FEATURE_NOT_SUPPORTED;
+	}
+
+	RIFT_S_INFO("%s %s tracking", enabled ? "Resumed" : "Paused",
+	            type == XRT_DEVICE_FEATURE_SLAM_TRACKING ? "SLAM" : "hand");
+
+	return XRT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include "math/m_clock_offset.h"
 #include "math/m_imu_3dof.h"
 #include "os/os_threading.h"
 #include "util/u_var.h"
@@ -77,6 +78,12 @@ struct rift_s_tracker
 
 		//! Set at start. Whether the hand tracker was initialized.
 		bool hand_enabled;
+
+		//! Whether the SLAM tracker is fed, toggled at runtime. Protected by mutex.
+		bool slam_active;
+
+		//! Whether the hand tracker is fed, toggled at runtime. Protected by mutex.
+		bool hand_active;
 	} tracking;
 
 	// Correction offset poses from firmware
@@ -87,6 +94,8 @@ struct rift_s_tracker
 	uint64_t seen_clock_observations;
 	bool have_hw2mono;
 	time_duration_ns hw2mono;
+	//! Tracks hw2mono, including drift.
+	struct m_clock_tracker hw2mono_tracker;
 	timepoint_ns last_frame_time;
 
 	//! Adjustment to apply to camera timestamps to bring them into the
@@ -106,8 +115,9 @@ struct rift_s_tracker
 	/* Input sinks that the camera delivers SLAM frames to */
 	struct xrt_slam_sinks in_slam_sinks;
 
-	/* SLAM/HT sinks we deliver imu and frame data to */
+	/* SLAM and HT sinks we deliver imu and frame data to, only while active */
 	struct xrt_slam_sinks slam_sinks;
+	struct xrt_slam_sinks hand_sinks;
 
 	struct xrt_device *handtracker;
 
@@ -145,6 +155,9 @@ rift_s_tracker_imu_update(struct rift_s_tracker *t,
                           const struct xrt_vec3 *accel,
                           const struct xrt_vec3 *gyro);
 
+bool
+rift_s_tracker_wants_slam_frame(struct rift_s_tracker *t, int cam_index);
+
 void
 rift_s_tracker_push_slam_frames(struct rift_s_tracker *t,
                                 uint64_t frame_ts_ns,
@@ -155,4 +168,12 @@ rift_s_tracker_get_tracked_pose(struct rift_s_tracker *t,
                                 uint64_t at_timestamp_ns,
                                 struct xrt_space_relation *out_relation);
 
+/*!
+ * Stop or restart feeding the SLAM or hand tracker without tearing down the
+ * camera pipeline. Without SLAM the 3DoF tracker takes over from the last
+ * SLAM pose.
+ */
+xrt_result_t
+rift_s_tracker_set_feature_enabled(struct rift_s_tracker *t, enum xrt_device_feature_type type, bool enabled);
+
 #endif
@@ -28,10 +28,7 @@
 #include "util/u_distortion_mesh.h"
 #include "util/u_trace_marker.h"
 #include "util/u_var.h"
-
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 
 
@@ -278,10 +275,8 @@ rokid_usb_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("Rokid USB thread");
 	struct rokid_hmd *rokid = ptr;
 
-#ifdef XRT_OS_LINUX
-	// Try to raise priority of this thread, so we don't miss packets under load
-	u_linux_try_to_set_realtime_priority_on_thread(U_LOGGING_INFO, "Rokid USB thread");
-#endif
+	// Raise the priority of this thread, so we don't miss packets under load
+	u_thread_role_apply(U_THREAD_ROLE_IMU, U_LOGGING_INFO, "Rokid USB thread");
 
 	int last_libusb_result = LIBUSB_SUCCESS;
 
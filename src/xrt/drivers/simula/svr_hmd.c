@@ -265,6 +265,7 @@ svr_hmd_create(struct svr_two_displays_distortion *distortion)
 	svr->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	svr->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	svr->base.compute_distortion = svr_mesh_calc;
+	svr->base.compute_distortion_thread_safe = true;
 
 	// Setup variable tracker.
 	u_var_add_root(svr, "Simula HMD", true);
@@ -25,6 +25,7 @@
 #include "util/u_hand_tracking.h"
 #include "util/u_logging.h"
 #include "util/u_json.hpp"
+#include "util/u_time.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_device.h"
 
@@ -205,11 +206,17 @@ ControllerDevice::ControllerDevice(vr::PropertyContainerHandle_t handle, const D
 Device::~Device()
 {
 	m_relation_history_destroy(&relation_hist);
+	m_predictor_destroy(&predictor);
 }
 
 Device::Device(const DeviceBuilder &builder) : xrt_device({}), ctx(builder.ctx), driver(builder.driver)
 {
 	m_relation_history_create(&relation_hist);
+
+	// SteamVR gives velocities with every pose, estimate acceleration from them as well.
+	m_predictor_create(&predictor, M_PREDICTOR_MODEL_CONSTANT_ACCELERATION, nullptr);
+	m_relation_history_set_predictor(relation_hist, predictor);
+
 	std::strncpy(this->serial, builder.serial, XRT_DEVICE_NAME_LEN - 1);
 	this->serial[XRT_DEVICE_NAME_LEN - 1] = 0;
 	this->tracking_origin = ctx.get();
@@ -687,7 +694,9 @@ Device::update_pose(const vr::DriverPose_t &newPose) const
 		math_quat_rotate_vec3(&chaperone.orientation, &relation.angular_velocity, &relation.angular_velocity);
 	}
 
-	const uint64_t ts = chrono_timestamp_ns() + static_cast<uint64_t>(newPose.poseTimeOffset * 1000000.0);
+	// poseTimeOffset is in seconds and usually negative, the pose is from a little while ago.
+	const int64_t offset_ns = static_cast<int64_t>(newPose.poseTimeOffset * static_cast<double>(U_TIME_1S_IN_NS));
+	const uint64_t ts = static_cast<uint64_t>(static_cast<int64_t>(chrono_timestamp_ns()) + offset_ns);
 
 	m_relation_history_push(relation_hist, &relation, ts);
 }
@@ -16,6 +16,7 @@
 #include <mutex>
 
 #include "interfaces/context.hpp"
+#include "math/m_predictor.h"
 #include "math/m_relation_history.h"
 #include "xrt/xrt_device.h"
 #include "openvr_driver.h"
@@ -42,6 +43,9 @@ class Device : public xrt_device
 public:
 	m_relation_history *relation_hist;
 
+	//! Predicts past the newest pose SteamVR gave us, owned by the device.
+	m_predictor *predictor;
+
 	virtual ~Device();
 
 	xrt_input *
@@ -57,6 +57,15 @@
 // If we haven't gotten a config for devices this long after startup, just start without those devices
 #define DEFAULT_WAIT_TIMEOUT 3.5f
 
+/*
+ * Devices libsurvive knows about show up over the first few tens of ms, wait
+ * for no new ones for this long before trusting that we have them all.
+ */
+#define DEVICE_SETTLE_NS (100 * U_TIME_1MS_IN_NS)
+
+// libsurvive has no timed wait for events, how long to sleep between polls.
+#define EVENT_POLL_NS (500 * 1000)
+
 // index in sys->controllers[] array
 #define SURVIVE_LEFT_CONTROLLER_INDEX 0
 #define SURVIVE_RIGHT_CONTROLLER_INDEX 1
@@ -68,6 +77,7 @@
 DEBUG_GET_ONCE_BOOL_OPTION(survive_disable_hand_emulation, "SURVIVE_DISABLE_HAND_EMULATION", false)
 DEBUG_GET_ONCE_BOOL_OPTION(survive_default_ipd, "SURVIVE_DEFAULT_IPD", false)
 DEBUG_GET_ONCE_FLOAT_OPTION(survive_timecode_offset_ms, "SURVIVE_TIMECODE_OFFSET_MS", 0.0)
+DEBUG_GET_ONCE_FLOAT_OPTION(survive_wait_timeout, "SURVIVE_WAIT_TIMEOUT", DEFAULT_WAIT_TIMEOUT)
 
 #define SURVIVE_TRACE(d, ...) U_LOG_XDEV_IFL_T(&d->base, d->sys->log_level, __VA_ARGS__)
 #define SURVIVE_DEBUG(d, ...) U_LOG_XDEV_IFL_D(&d->base, d->sys->log_level, __VA_ARGS__)
@@ -973,6 +983,9 @@ _create_hmd_device(struct survive_system *sys, const struct SurviveSimpleObject
 	survive->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	survive->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	survive->base.compute_distortion = compute_distortion;
+	survive->base.compute_distortion_thread_safe = true;
+	u_distortion_vive_fill_in_model(&survive->base, survive->hmd.config.distortion.values,
+	                                survive->hmd.config.variant == VIVE_VARIANT_PRO2);
 
 	survive->base.orientation_tracking_supported = true;
 	survive->base.position_tracking_supported = true;
@@ -1233,40 +1246,43 @@ add_device(struct survive_system *ss, const struct SurviveSimpleConfigEvent *e)
 	}
 }
 
-static bool
-add_connected_devices(struct survive_system *ss)
+//! Number of non-lighthouse objects libsurvive knows, those we want configs for.
+static int
+count_config_objects(struct survive_system *ss)
 {
-	/** @todo We don't know how many device added events we will get.
-	 * After 25ms Index HMD + Controllers are added here. So 250ms should be a safe value.
-	 * Device added just means libsurvive knows the usb devices, the config will then be loaded asynchronously.
-	 */
-	os_nanosleep(250 * 1000 * 1000);
-
-	size_t objs = survive_simple_get_object_count(ss->ctx);
-	U_LOG_IFL_D(ss->log_level, "Object count: %zu", objs);
-
-	timepoint_ns start = os_monotonic_get_ns();
-
-	// First count how many non-lighthouse objects libsurvive knows.
-	// Then poll events until we have gotten configs for this many, or until timeout.
-	int configs_to_wait_for = 0;
-	int configs_gotten = 0;
+	int count = 0;
 
 	for (const SurviveSimpleObject *sso = survive_simple_get_first_object(ss->ctx); sso;
 	     sso = survive_simple_get_next_object(ss->ctx, sso)) {
 		enum SurviveSimpleObject_type t = survive_simple_object_get_type(sso);
-		const char *name = survive_simple_object_name(sso);
-		U_LOG_IFL_D(ss->log_level, "Object name %s: type %d", name, t);
 
 		// we only want to wait for configs of HMDs and controllers / trackers.
 		// Note: HMDs will be of type SurviveSimpleObject_OBJECT until the config is loaded.
 		if (t == SurviveSimpleObject_HMD || t == SurviveSimpleObject_OBJECT) {
-			configs_to_wait_for++;
+			count++;
 		}
 	}
 
-	U_LOG_IFL_D(ss->log_level, "Waiting for %d configs", configs_to_wait_for);
-	while (configs_gotten < configs_to_wait_for) {
+	return count;
+}
+
+static bool
+add_connected_devices(struct survive_system *ss)
+{
+	/*
+	 * Device added just means libsurvive knows the usb devices, the config
+	 * will then be loaded asynchronously. We don't know how many devices
+	 * will be added, so configs are processed as soon as they arrive while
+	 * the device count is watched, and we are done once every device seen
+	 * has its config and no new device has shown up for a little while.
+	 */
+	timepoint_ns start = os_monotonic_get_ns();
+	timepoint_ns last_change = start;
+
+	int configs_to_wait_for = 0;
+	int configs_gotten = 0;
+
+	while (true) {
 		struct SurviveSimpleEvent event = {0};
 		while (survive_simple_next_event(ss->ctx, &event) != SurviveSimpleEventType_None) {
 			if (event.event_type == SurviveSimpleEventType_ConfigEvent) {
@@ -1279,13 +1295,28 @@ add_connected_devices(struct survive_system *ss)
 			}
 		}
 
-		if (time_ns_to_s(os_monotonic_get_ns() - start) > ss->wait_timeout) {
+		timepoint_ns now = os_monotonic_get_ns();
+
+		int count = count_config_objects(ss);
+		if (count != configs_to_wait_for) {
+			U_LOG_IFL_D(ss->log_level, "Waiting for %d configs", count);
+			configs_to_wait_for = count;
+			last_change = now;
+		}
+
+		if (configs_gotten >= configs_to_wait_for && now - last_change >= DEVICE_SETTLE_NS) {
+			break;
+		}
+
+		if (time_ns_to_s(now - start) > ss->wait_timeout) {
 			U_LOG_IFL_D(ss->log_level, "Timed out after getting configs for %d/%d devices", configs_gotten,
 			            configs_to_wait_for);
 			break;
 		}
-		os_nanosleep(500 * 1000);
+
+		os_nanosleep(EVENT_POLL_NS);
 	}
+
 	U_LOG_IFL_D(ss->log_level, "Waiting for configs took %f ms", time_ns_to_ms_f(os_monotonic_get_ns() - start));
 	return true;
 }
@@ -1357,7 +1388,7 @@ survive_get_devices(struct xrt_device **out_xdevs, struct vive_config **out_vive
 
 	ss->log_level = debug_get_log_option_survive_log();
 
-	ss->wait_timeout = DEFAULT_WAIT_TIMEOUT;
+	ss->wait_timeout = debug_get_float_option_survive_wait_timeout();
 
 
 	while (!add_connected_devices(ss)) {
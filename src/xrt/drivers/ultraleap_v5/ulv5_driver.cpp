@@ -13,6 +13,7 @@
 #include "util/u_debug.h"
 #include "math/m_space.h"
 #include "math/m_api.h"
+#include "math/m_hand_history.h"
 #include "util/u_time.h"
 #include "os/os_time.h"
 #include "os/os_threading.h"
@@ -74,9 +75,8 @@ struct ulv5_device
 
 	struct os_thread_helper oth;
 
-	struct xrt_hand_joint_set joint_set[2];
-
-	bool hand_exists[2];
+	//! Thread safe, interpolates the hands for the time asked for.
+	struct m_hand_history *hand_hist[2];
 
 	// LEAP_CONNECTION *leap_connection;
 };
@@ -109,22 +109,8 @@ ulv5_device_get_hand_tracking(struct xrt_device *xdev,
 
 	bool hand_index = (name == XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT); // 0 if left, 1 if right.
 
-	bool hand_valid = ulv5d->hand_exists[hand_index];
-
-	os_thread_helper_lock(&ulv5d->oth);
-	memcpy(out_value, &ulv5d->joint_set[hand_index], sizeof(struct xrt_hand_joint_set));
-	hand_valid = ulv5d->hand_exists[hand_index];
-	os_thread_helper_unlock(&ulv5d->oth);
-	m_space_relation_ident(&out_value->hand_pose);
-
-	if (hand_valid) {
-		out_value->is_active = true;
-		out_value->hand_pose.relation_flags = valid_flags;
-	} else {
-		out_value->is_active = false;
-	}
-	// still a lie...
-	*out_timestamp_ns = at_timestamp_ns;
+	// Not active if no hand has been seen yet.
+	m_hand_history_get(ulv5d->hand_hist[hand_index], at_timestamp_ns, out_value, out_timestamp_ns);
 }
 
 // todo: cleanly shutdown the LEAP_CONNECTION
@@ -141,6 +127,10 @@ ulv5_device_destroy(struct xrt_device *xdev)
 	// Remove the variable tracking.
 	u_var_remove_root(ulv5d);
 
+	for (int i = 0; i < 2; i++) {
+		m_hand_history_destroy(&ulv5d->hand_hist[i]);
+	}
+
 	u_device_free(&ulv5d->base);
 }
 
@@ -160,7 +150,7 @@ ulv5_process_joint(LEAP_VECTOR joint_pos,
 }
 
 void
-ulv5_process_hand(LEAP_HAND hand, struct ulv5_device *ulv5d, int handedness)
+ulv5_process_hand(LEAP_HAND hand, struct ulv5_device *ulv5d, int handedness, uint64_t timestamp_ns)
 {
 	struct xrt_hand_joint_set dummy_joint_set;
 // gives access to individual joints of the joint_set
@@ -223,10 +213,11 @@ ulv5_process_hand(LEAP_HAND hand, struct ulv5_device *ulv5d, int handedness)
 	ulv5_process_joint(hand.pinky.distal.next_joint, hand.pinky.distal.rotation, hand.pinky.distal.width,
 	                   dummy_joint_set(LITTLE_TIP));
 
-	// copy over to ulv5d joint set
-	os_thread_helper_lock(&ulv5d->oth);
-	memcpy(&ulv5d->joint_set[handedness], &dummy_joint_set, sizeof(struct xrt_hand_joint_set));
-	os_thread_helper_unlock(&ulv5d->oth);
+	m_space_relation_ident(&dummy_joint_set.hand_pose);
+	dummy_joint_set.hand_pose.relation_flags = valid_flags;
+	dummy_joint_set.is_active = true;
+
+	m_hand_history_push(ulv5d->hand_hist[handedness], &dummy_joint_set, timestamp_ns);
 }
 
 void *
@@ -281,10 +272,22 @@ leap_input_loop(void *ptr_to_xdev)
 			uint32_t num_hands = tracking_event->nHands;
 			LEAP_HAND *hands = tracking_event->pHands;
 
+			// The Leap clock isn't ours, use when we got the event.
+			uint64_t now_ns = os_monotonic_get_ns();
+			bool seen[2] = {false, false};
+
 			for (uint32_t i = 0; i < num_hands; i++) {
 				int handedness = hands[i].type;
-				ulv5_process_hand(hands[i], ulv5d, handedness);
-				ulv5d->hand_exists[handedness] = true;
+				ulv5_process_hand(hands[i], ulv5d, handedness, now_ns);
+				seen[handedness] = true;
+			}
+
+			// Lost hands are pushed as not active, so they aren't predicted forever.
+			for (int i = 0; i < 2; i++) {
+				if (!seen[i]) {
+					struct xrt_hand_joint_set lost = {};
+					m_hand_history_push(ulv5d->hand_hist[i], &lost, now_ns);
+				}
 			}
 		}
 	}
@@ -298,6 +301,11 @@ ulv5_create_device(struct xrt_device **out_xdev)
 
 	struct ulv5_device *ulv5d = U_DEVICE_ALLOCATE(struct ulv5_device, flags, num_hands, 0);
 
+	// Before the thread is started, it pushes to them.
+	for (int i = 0; i < 2; i++) {
+		m_hand_history_create(&ulv5d->hand_hist[i], M_HAND_HISTORY_DEFAULT_CAPACITY);
+	}
+
 	os_thread_helper_init(&ulv5d->oth);
 	os_thread_helper_start(&ulv5d->oth, (&leap_input_loop), (void *)&ulv5d->base);
 
@@ -58,6 +58,8 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(v4l2_log, "V4L2_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_NUM_OPTION(v4l2_exposure_absolute, "V4L2_EXPOSURE_ABSOLUTE", 10)
+DEBUG_GET_ONCE_NUM_OPTION(v4l2_buffer_count, "V4L2_BUFFER_COUNT", NUM_V4L2_BUFFERS)
+DEBUG_GET_ONCE_BOOL_OPTION(v4l2_dmabuf, "V4L2_DMABUF", true)
 
 /*!
  * Streaming thread entrypoint
@@ -300,6 +302,34 @@ v4l2_setup_mmap_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_b
 	return 0;
 }
 
+/*!
+ * Exports a mmap buffer as a dma-buf so consumers can import the frames
+ * without copying them, failing is not an error as the frame still has its
+ * mapped memory.
+ */
+static void
+v4l2_export_dmabuf(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_buffer *v_buf)
+{
+	if (vf->dmabuf_fd >= 0) {
+		close(vf->dmabuf_fd);
+		vf->dmabuf_fd = -1;
+	}
+
+	struct v4l2_exportbuffer v_expbuf;
+	U_ZERO(&v_expbuf);
+	v_expbuf.type = v_buf->type;
+	v_expbuf.index = v_buf->index;
+	v_expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+	if (ioctl(vid->fd, VIDIOC_EXPBUF, &v_expbuf) < 0) {
+		V4L2_DEBUG(vid, "info: Driver can not export buffer %u as dma-buf.", v_buf->index);
+		vid->capture.dmabuf = false;
+		return;
+	}
+
+	vf->dmabuf_fd = v_expbuf.fd;
+}
+
 static int
 v4l2_setup_userptr_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_buffer *v_buf)
 {
@@ -643,6 +673,13 @@ v4l2_fs_destroy(struct v4l2_fs *vid)
 		}
 	}
 
+	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+		if (vid->frames[i].dmabuf_fd >= 0) {
+			close(vid->frames[i].dmabuf_fd);
+			vid->frames[i].dmabuf_fd = -1;
+		}
+	}
+
 	if (vid->fd >= 0) {
 		close(vid->fd);
 		vid->fd = -1;
@@ -682,6 +719,9 @@ v4l2_fs_create(struct xrt_frame_context *xfctx,
 	vid->node.destroy = v4l2_fs_node_destroy;
 	vid->log_level = debug_get_log_option_v4l2_log();
 	vid->fd = -1;
+	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+		vid->frames[i].dmabuf_fd = -1;
+	}
 
 	snprintf(vid->base.product, sizeof(vid->base.product), "%s", product);
 	snprintf(vid->base.manufacturer, sizeof(vid->base.manufacturer), "%s", manufacturer);
@@ -741,18 +781,40 @@ v4l2_fs_mainloop(void *ptr)
 	// set up our buffers - prefer userptr (client alloc) vs mmap (kernel
 	// alloc)
 	// TODO: using buffer caps may be better than 'fallthrough to mmap'
+	// Only mmap buffers are owned by the driver and can be exported.
+	vid->capture.dmabuf = debug_get_bool_option_v4l2_dmabuf();
+
+	// More buffers lets slow consumers hold on to frames longer before capture starves.
+	long count = debug_get_num_option_v4l2_buffer_count();
+	if (count < 2 || count > NUM_V4L2_BUFFERS) {
+		V4L2_WARN(vid, "V4L2_BUFFER_COUNT %li is not in [2, %i], using %i.", count, NUM_V4L2_BUFFERS,
+		          NUM_V4L2_BUFFERS);
+		count = NUM_V4L2_BUFFERS;
+	}
+
 	struct v4l2_requestbuffers v_bufrequest;
 	U_ZERO(&v_bufrequest);
-	v_bufrequest.count = NUM_V4L2_BUFFERS;
+	v_bufrequest.count = (uint32_t)count;
 	v_bufrequest.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-	if (v4l2_try_userptr(vid, &v_bufrequest) != 0 && v4l2_try_mmap(vid, &v_bufrequest) != 0) {
+	// Exporting dma-bufs needs driver allocated memory, so try mmap first then.
+	bool got_buffers = false;
+	if (vid->capture.dmabuf) {
+		got_buffers = v4l2_try_mmap(vid, &v_bufrequest) == 0 || v4l2_try_userptr(vid, &v_bufrequest) == 0;
+	} else {
+		got_buffers = v4l2_try_userptr(vid, &v_bufrequest) == 0 || v4l2_try_mmap(vid, &v_bufrequest) == 0;
+	}
+	if (!got_buffers) {
 		V4L2_ERROR(vid, "error: Driver does not support mmap or userptr.");
 		return NULL;
 	}
 
+	// The driver is allowed to give us a different number of buffers.
+	vid->buffer_count = v_bufrequest.count < NUM_V4L2_BUFFERS ? v_bufrequest.count : NUM_V4L2_BUFFERS;
+	vid->capture.dmabuf = vid->capture.dmabuf && vid->capture.mmap;
+	V4L2_DEBUG(vid, "info: Got %u buffers, %s.", vid->buffer_count, vid->capture.mmap ? "mmap" : "userptr");
 
-	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+	for (uint32_t i = 0; i < vid->buffer_count; i++) {
 		struct v4l2_frame *vf = &vid->frames[i];
 		struct v4l2_buffer *v_buf = &vf->v_buf;
 
@@ -774,9 +836,14 @@ v4l2_fs_mainloop(void *ptr)
 		if (vid->capture.mmap && v4l2_setup_mmap_buffer(vid, vf, v_buf) != 0) {
 			return NULL;
 		}
+		if (vid->capture.dmabuf) {
+			v4l2_export_dmabuf(vid, vf, v_buf);
+		}
 
-		// Silence valgrind.
-		memset(vf->mem, 0, v_buf->length);
+		// Silence valgrind, mmap buffers are mapped read only.
+		if (vid->capture.userptr) {
+			memset(vf->mem, 0, v_buf->length);
+		}
 
 		// Queue this buffer
 		if (ioctl(vid->fd, VIDIOC_QBUF, v_buf) < 0) {
@@ -801,7 +868,7 @@ v4l2_fs_mainloop(void *ptr)
 	v_buf.memory = v_bufrequest.memory;
 
 	while (vid->is_running) {
-		if (vid->used_frames == NUM_V4L2_BUFFERS) {
+		if (vid->used_frames == vid->buffer_count) {
 			V4L2_ERROR(vid, "No frames left");
 		}
 
@@ -836,6 +903,11 @@ v4l2_fs_mainloop(void *ptr)
 		xf->source_id = vid->base.source_id;
 		xf->source_sequence = v_buf.sequence;
 
+		// Zero-copy path, the dma-buf stays valid as long as the frame is referenced.
+		xf->has_dmabuf = vid->capture.dmabuf && vf->dmabuf_fd >= 0;
+		xf->dmabuf_fd = xf->has_dmabuf ? vf->dmabuf_fd : -1;
+		xf->dmabuf_offset = xf->has_dmabuf ? desc->offset : 0;
+
 		if ((v_buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) != 0) {
 			xf->timestamp = os_timeval_to_ns(&v_buf.timestamp);
 			xf->source_timestamp = xf->timestamp;
@@ -46,6 +46,8 @@ struct v4l2_frame
 
 	void *mem; //!< Data might be at an offset, so we need base memory.
 
+	int dmabuf_fd; //!< Exported dma-buf of this buffer, -1 if it could not be exported.
+
 	struct v4l2_buffer v_buf;
 };
 
@@ -102,12 +104,14 @@ struct v4l2_fs
 	} quirks;
 
 	struct v4l2_frame frames[NUM_V4L2_BUFFERS];
+	uint32_t buffer_count; //!< How many of @ref frames the driver gave us.
 	uint32_t used_frames;
 
 	struct
 	{
 		bool mmap;
 		bool userptr;
+		bool dmabuf; //!< Export mmap buffers as dma-bufs.
 	} capture;
 
 	struct xrt_frame_sink *sink;
@@ -497,8 +497,13 @@ vive_controller_device_set_output(struct xrt_device *xdev,
 		return;
 	}
 
+	/*
+	 * The feature report write can take milliseconds and this is called
+	 * from the application's thread, so leave it to the controller thread.
+	 */
 	os_mutex_lock(&d->lock);
-	vive_controller_haptic_pulse(d, value);
+	d->haptic.value = *value;
+	d->haptic.pending = true;
 	os_mutex_unlock(&d->lock);
 }
 
@@ -961,6 +966,25 @@ vive_controller_device_update(struct vive_controller_device *d)
 	return true;
 }
 
+static void
+vive_controller_flush_haptic(struct vive_controller_device *d)
+{
+	os_mutex_lock(&d->lock);
+	bool pending = d->haptic.pending;
+	union xrt_output_value value = d->haptic.value;
+	d->haptic.pending = false;
+	os_mutex_unlock(&d->lock);
+
+	if (!pending) {
+		return;
+	}
+
+	int ret = vive_controller_haptic_pulse(d, &value);
+	if (ret < 0) {
+		VIVE_ERROR(d, "Failed to send haptic pulse '%i'!", ret);
+	}
+}
+
 static void *
 vive_controller_run_thread(void *ptr)
 {
@@ -975,6 +999,9 @@ vive_controller_run_thread(void *ptr)
 	while (os_thread_helper_is_running_locked(&d->controller_thread)) {
 		os_thread_helper_unlock(&d->controller_thread);
 
+		// Reports come in at a high rate, so pulses are only briefly delayed.
+		vive_controller_flush_haptic(d);
+
 		if (!vive_controller_device_update(d)) {
 			return NULL;
 		}
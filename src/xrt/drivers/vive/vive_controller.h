@@ -110,6 +110,16 @@ struct vive_controller_device
 		uint8_t battery;
 	} state;
 
+	/*!
+	 * Haptic pulse waiting to be sent by the controller thread, protected
+	 * by @ref lock. A newer pulse replaces one that is still pending.
+	 */
+	struct
+	{
+		bool pending;
+		union xrt_output_value value;
+	} haptic;
+
 	enum watchman_gen watchman_gen;
 
 	struct u_hand_tracking hand_tracking;
@@ -18,13 +18,11 @@
 #include "util/u_var.h"
 #include "util/u_time.h"
 #include "util/u_trace_marker.h"
-
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "math/m_api.h"
 #include "math/m_predict.h"
+#include "math/m_vec3.h"
 
 #include "os/os_hid.h"
 #include "os/os_time.h"
@@ -40,6 +38,17 @@
 // Used to scale the IMU range from config.
 #define VIVE_IMU_RANGE_CONVERSION_VALUE (32768.0)
 
+//! Lighthouse positions older than this are no longer extrapolated.
+#define VIVE_LH_POSITION_TIMEOUT_NS (100 * U_TIME_1MS_IN_NS)
+
+//! How much of the way the IMU orientation is pulled towards each lighthouse solve.
+#define VIVE_LH_ORIENTATION_CORRECTION (0.05f)
+
+//! How much of each new velocity estimate from lighthouse positions is blended in.
+#define VIVE_LH_VELOCITY_ALPHA (0.3f)
+
+DEBUG_GET_ONCE_BOOL_OPTION(vive_lighthouse_tracking, "VIVE_LIGHTHOUSE_TRACKING", false)
+
 
 static bool
 vive_mainboard_power_off(struct vive_device *d);
@@ -123,9 +132,11 @@ vive_device_get_3dof_tracked_pose(struct xrt_device *xdev,
 	relation.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
 
 	m_relation_history_get(d->fusion.relation_hist, at_timestamp_ns, &relation);
+	if ((relation.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) == 0) {
+		relation.pose.position = d->pose.position;
+		relation.linear_velocity = (struct xrt_vec3){0, 0, 0};
+	}
 	relation.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL; // Needed after history_get
-	relation.pose.position = d->pose.position;
-	relation.linear_velocity = (struct xrt_vec3){0, 0, 0};
 
 	*out_relation = relation;
 	d->pose = out_relation->pose;
@@ -506,6 +517,16 @@ update_imu(struct vive_device *d, const void *buffer)
 		os_mutex_lock(&d->fusion.mutex);
 		m_imu_3dof_update(&d->fusion.i3dof, d->imu.last_sample_ts_ns, &acceleration, &angular_velocity);
 		rel.pose.orientation = d->fusion.i3dof.rot;
+
+		// Carry the last lighthouse position forward to this sample.
+		if (d->fusion.have_position && now_ns - d->fusion.position_ns < VIVE_LH_POSITION_TIMEOUT_NS) {
+			float dt = (float)time_ns_to_s((int64_t)(now_ns - d->fusion.position_ns));
+			rel.pose.position = m_vec3_add(d->fusion.position, m_vec3_mul_scalar(d->fusion.linear_velocity, dt));
+			rel.linear_velocity = d->fusion.linear_velocity;
+			rel.relation_flags |= XRT_SPACE_RELATION_POSITION_VALID_BIT |
+			                      XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+			                      XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT;
+		}
 		os_mutex_unlock(&d->fusion.mutex);
 
 		m_relation_history_push(d->fusion.relation_hist, &rel, now_ns);
@@ -842,6 +863,58 @@ vive_sensors_read_lighthouse_msg(struct vive_device *d)
 	return true;
 }
 
+static void
+vive_device_handle_lighthouse_frame(void *user, struct lighthouse_watchman *watchman, uint32_t base_index)
+{
+	XRT_TRACE_MARKER();
+
+	struct vive_device *d = (struct vive_device *)user;
+	struct lighthouse_base *base = &watchman->base[base_index];
+
+	struct lighthouse_observation obs[LIGHTHOUSE_SOLVER_MAX_OBSERVATIONS];
+	uint32_t obs_count = lighthouse_base_get_observations(base, obs, ARRAY_SIZE(obs));
+	if (obs_count == 0) {
+		return;
+	}
+
+	struct xrt_quat orientation;
+	os_mutex_lock(&d->fusion.mutex);
+	orientation = d->fusion.i3dof.rot;
+	os_mutex_unlock(&d->fusion.mutex);
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	struct xrt_pose pose;
+	if (!lighthouse_solver_solve(&d->lh.solver, base_index, &base->gravity, &orientation, obs, obs_count, now_ns,
+	                             &pose)) {
+		return;
+	}
+
+	VIVE_TRACE(d, "Lighthouse %u pose %f %f %f, rms %f", base_index, pose.position.x, pose.position.y,
+	           pose.position.z, d->lh.solver.last_rms);
+
+	os_mutex_lock(&d->fusion.mutex);
+
+	bool recent = d->fusion.have_position && now_ns - d->fusion.position_ns < VIVE_LH_POSITION_TIMEOUT_NS;
+	if (recent) {
+		float dt = (float)time_ns_to_s((int64_t)(now_ns - d->fusion.position_ns));
+		struct xrt_vec3 velocity = m_vec3_div_scalar(m_vec3_sub(pose.position, d->fusion.position), dt);
+		d->fusion.linear_velocity = m_vec3_lerp(d->fusion.linear_velocity, velocity, VIVE_LH_VELOCITY_ALPHA);
+	} else {
+		d->fusion.linear_velocity = (struct xrt_vec3){0, 0, 0};
+	}
+
+	// The lighthouse is the only source of heading, snap to it after a gap.
+	float t = recent ? VIVE_LH_ORIENTATION_CORRECTION : 1.0f;
+	math_quat_slerp(&d->fusion.i3dof.rot, &pose.orientation, t, &d->fusion.i3dof.rot);
+
+	d->fusion.have_position = true;
+	d->fusion.position_ns = now_ns;
+	d->fusion.position = pose.position;
+
+	os_mutex_unlock(&d->fusion.mutex);
+}
+
 static void *
 vive_watchman_run_thread(void *ptr)
 {
@@ -872,10 +945,8 @@ vive_sensors_run_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("Vive: Sensors");
 	os_thread_helper_name(&d->sensors_thread, "Vive: Sensors");
 
-#ifdef XRT_OS_LINUX
-	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(d->log_level, "Vive: Sensors");
-#endif
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_IMU, d->log_level, "Vive: Sensors");
 
 	/*
 	 * We want to drain all old packets to avoid old ones,
@@ -939,6 +1010,9 @@ vive_device_setup_ui(struct vive_device *d)
 		d->gui.switch_tracker_btn.ptr = d;
 		u_var_add_button(d, &d->gui.switch_tracker_btn, "Switch to 3DoF Tracking");
 	}
+	if (d->lh.enabled) {
+		u_var_add_ro_f32(d, &d->lh.solver.last_rms, "Lighthouse residual (rad)");
+	}
 	u_var_add_pose(d, &d->pose, "Tracked Pose");
 	u_var_add_pose(d, &d->offset, "Pose Offset");
 	u_var_add_draggable_f32(d, &d->tracked_offset_ms, "Timecode offset(ms)");
@@ -1092,6 +1166,7 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	d->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	d->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	d->base.compute_distortion = compute_distortion;
+	d->base.compute_distortion_thread_safe = true;
 
 	if (d->mainboard_dev) {
 		vive_mainboard_power_on(d);
@@ -1128,6 +1203,9 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	d->base.hmd->distortion.fov[0] = d->config.distortion.fov[0];
 	d->base.hmd->distortion.fov[1] = d->config.distortion.fov[1];
 
+	// Lets the compositor generate the distortion on the GPU.
+	u_distortion_vive_fill_in_model(&d->base, d->config.distortion.values, d->config.variant == VIVE_VARIANT_PRO2);
+
 	// Per-view size.
 	uint32_t w_pixels = d->config.display.eye_target_width_in_pixels;
 	uint32_t h_pixels = d->config.display.eye_target_height_in_pixels;
@@ -1138,6 +1216,13 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 
 	if (d->config.variant == VIVE_VARIANT_INDEX) {
 		d->base.hmd->screens[0].nominal_frame_interval_ns = (uint64_t)time_s_to_ns(1.0f / 144.0f);
+
+		// Modes the Index panel exposes to the GPU.
+		const float index_rates_hz[] = {80.0f, 90.0f, 120.0f, 144.0f};
+		for (uint32_t i = 0; i < ARRAY_SIZE(index_rates_hz); i++) {
+			d->base.hmd->screens[0].refresh_rates_hz[i] = index_rates_hz[i];
+		}
+		d->base.hmd->screens[0].refresh_rate_count = ARRAY_SIZE(index_rates_hz);
 	} else {
 		d->base.hmd->screens[0].nominal_frame_interval_ns = (uint64_t)time_s_to_ns(1.0f / 90.0f);
 	}
@@ -1174,9 +1259,27 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 		} else {
 			lighthouse_watchman_init(&d->watchman, "headset");
 			VIVE_DEBUG(d, "Successfully enabled watchman receiver.");
+
+			d->lh.enabled = debug_get_bool_option_vive_lighthouse_tracking() && d->config.lh.sensor_count > 0;
 		}
 	}
 
+	if (d->lh.enabled) {
+		// Same axes as the IMU samples once they are converted to OpenXR.
+		struct xrt_vec3 sensors[LIGHTHOUSE_SOLVER_MAX_SENSORS];
+		uint32_t count = MIN((uint32_t)d->config.lh.sensor_count, LIGHTHOUSE_SOLVER_MAX_SENSORS);
+		for (uint32_t i = 0; i < count; i++) {
+			struct xrt_vec3 normal = d->config.lh.sensors[i].normal;
+			sensors[i] = d->config.lh.sensors[i].pos;
+			convert_imu_to_openxr(d, &normal, &sensors[i]);
+		}
+
+		lighthouse_solver_init(&d->lh.solver, sensors, count);
+		d->watchman.frame_func = vive_device_handle_lighthouse_frame;
+		d->watchman.frame_user = d;
+		VIVE_INFO(d, "Lighthouse tracking enabled with %u sensors.", count);
+	}
+
 	if (d->mainboard_dev) {
 		ret = os_thread_helper_start(&d->mainboard_thread, vive_mainboard_run_thread, d);
 		if (ret != 0) {
@@ -81,8 +81,23 @@ struct vive_device
 
 		//! Prediction
 		struct m_relation_history *relation_hist;
+
+		//! Last position from the lighthouse solver and when it was solved.
+		bool have_position;
+		uint64_t position_ns;
+		struct xrt_vec3 position;
+		struct xrt_vec3 linear_velocity;
 	} fusion;
 
+	//! Native lighthouse tracking, only used from the watchman thread.
+	struct
+	{
+		//! Set at start, see VIVE_LIGHTHOUSE_TRACKING.
+		bool enabled;
+
+		struct lighthouse_solver solver;
+	} lh;
+
 	//! Fields related to camera-based tracking (SLAM and hand tracking)
 	struct
 	{
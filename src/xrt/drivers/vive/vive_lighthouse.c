@@ -17,6 +17,7 @@
 #include <stdio.h>
 
 #include "math/m_api.h"
+#include "math/m_mathinclude.h"
 #include "util/u_debug.h"
 #include "util/u_logging.h"
 
@@ -304,8 +305,6 @@ lighthouse_base_handle_frame(struct lighthouse_watchman *watchman,
 {
 	struct lighthouse_frame *frame = &base->frame[base->active_rotor];
 
-	(void)watchman;
-
 	if (!frame->sweep_ids)
 		return;
 
@@ -319,6 +318,18 @@ lighthouse_base_handle_frame(struct lighthouse_watchman *watchman,
 		return;
 
 	// telemetry_send_lighthouse_frame(watchman->id, frame);
+
+	/*
+	 * Hand both sweeps on once the vertical one is done, as long as the
+	 * horizontal one is from the rotation just before.
+	 */
+	if (watchman->frame_func == NULL || base->active_rotor != 1 || base->frame[0].sweep_ids == 0)
+		return;
+
+	if (frame->sync_timestamp - base->frame[0].sync_timestamp > 2 * 400000 + 50000)
+		return;
+
+	watchman->frame_func(watchman->frame_user, watchman, (uint32_t)(base - watchman->base));
 }
 
 /*
@@ -531,6 +542,43 @@ lighthouse_watchman_handle_pulse(struct lighthouse_watchman *watchman,
 	}
 }
 
+uint32_t
+lighthouse_base_get_observations(const struct lighthouse_base *base,
+                                 struct lighthouse_observation *out_obs,
+                                 uint32_t max_obs)
+{
+	// No OOTX frame yet, the rotor phases are not known.
+	if (base->serial == 0)
+		return 0;
+
+	uint32_t count = 0;
+
+	for (int rotor = 0; rotor < 2; rotor++) {
+		const struct lighthouse_frame *frame = &base->frame[rotor];
+
+		for (uint8_t id = 0; id < 32 && count < max_obs; id++) {
+			if (!(frame->sweep_ids & (1u << id)))
+				continue;
+
+			/*
+			 * The rotors spin at 60 Hz, half a turn is the 400000
+			 * ticks between two sync pulses with the laser pointing
+			 * straight ahead half way through.
+			 * @todo Apply tilt, curve and gib calibration.
+			 */
+			double center = frame->sweep_offset[id] + frame->sweep_duration[id] / 2.0;
+			double angle = (center - 200000.0) * M_PI / 400000.0;
+
+			out_obs[count].sensor = id;
+			out_obs[count].axis = (uint8_t)rotor;
+			out_obs[count].angle = (float)(angle - base->calibration.rotor[rotor].phase);
+			count++;
+		}
+	}
+
+	return count;
+}
+
 void
 lighthouse_watchman_init(struct lighthouse_watchman *watchman, const char *name)
 {
@@ -19,6 +19,8 @@
 
 #include "xrt/xrt_defines.h"
 
+#include "vive_lighthouse_solver.h"
+
 struct lighthouse_rotor_calibration
 {
 	float tilt;
@@ -85,6 +87,14 @@ struct tracking_model
 	struct xrt_vec3 *normals;
 };
 
+struct lighthouse_watchman;
+
+/*!
+ * Called from @ref lighthouse_watchman_handle_pulse when both sweeps of a base
+ * station have come in, see @ref lighthouse_base_get_observations.
+ */
+typedef void (*lighthouse_frame_func_t)(void *user, struct lighthouse_watchman *watchman, uint32_t base_index);
+
 struct lighthouse_watchman
 {
 	uint32_t id;
@@ -98,6 +108,10 @@ struct lighthouse_watchman
 	struct lighthouse_sensor sensor[32];
 	struct lighthouse_pulse last_sync;
 	bool sync_lock;
+
+	//! Optional, set after @ref lighthouse_watchman_init.
+	lighthouse_frame_func_t frame_func;
+	void *frame_user;
 };
 
 void
@@ -105,5 +119,15 @@ lighthouse_watchman_handle_pulse(struct lighthouse_watchman *watchman,
                                  uint8_t id,
                                  uint16_t duration,
                                  uint32_t timestamp);
+/*!
+ * Turn the last two sweeps of a base station into angles, returns how many
+ * were written to @p out_obs. Returns zero until the calibration of the base
+ * station has been received.
+ */
+uint32_t
+lighthouse_base_get_observations(const struct lighthouse_base *base,
+                                 struct lighthouse_observation *out_obs,
+                                 uint32_t max_obs);
+
 void
 lighthouse_watchman_init(struct lighthouse_watchman *watchman, const char *name);
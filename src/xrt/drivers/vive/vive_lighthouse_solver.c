@@ -0,0 +1,384 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Allocation free pose solver for lighthouse sweeps.
+ * @ingroup drv_vive
+ */
+
+#include "math/m_api.h"
+#include "math/m_mathinclude.h"
+#include "math/m_vec3.h"
+
+#include "vive_lighthouse_solver.h"
+
+#include <string.h>
+
+
+//! Gauss-Newton steps per solve.
+#define MAX_ITERATIONS (10)
+
+//! Headings tried when there is no previous solution to start from.
+#define SEED_YAW_COUNT (8)
+
+//! Where the device is assumed to be without a previous solution, in front of the base station.
+#define SEED_DISTANCE_M (2.0f)
+
+//! Residuals larger than this are weighted down, reflections and bad sweeps.
+#define HUBER_THRESHOLD_RAD (0.005)
+
+//! A solve is only accepted if it fits the sweeps to within this.
+#define MAX_RMS_RAD (0.004f)
+
+//! How close in time two solutions must be to place a second base station from them.
+#define REGISTER_WINDOW_NS (50 * 1000 * 1000)
+
+#define MIN_SENSORS (4)
+#define MIN_OBSERVATIONS (6)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+//! Rotation that takes @p a onto @p b, both unit length.
+static void
+quat_from_a_to_b(struct xrt_vec3 a, struct xrt_vec3 b, struct xrt_quat *out)
+{
+	struct xrt_vec3 axis;
+	math_vec3_cross(&a, &b, &axis);
+
+	float s = m_vec3_len(axis);
+	float c = m_vec3_dot(a, b);
+
+	if (s < 1e-6f) {
+		if (c > 0.0f) {
+			*out = (struct xrt_quat)XRT_QUAT_IDENTITY;
+		} else {
+			*out = (struct xrt_quat){1.0f, 0.0f, 0.0f, 0.0f};
+		}
+		return;
+	}
+
+	axis = m_vec3_div_scalar(axis, s);
+	math_quat_from_angle_vector(atan2f(s, c), &axis, out);
+}
+
+//! Solves A x = b for a symmetric positive definite 6x6 A, in place.
+static bool
+cholesky_solve_6(double A[6][6], double b[6])
+{
+	for (int j = 0; j < 6; j++) {
+		double d = A[j][j];
+		for (int k = 0; k < j; k++) {
+			d -= A[j][k] * A[j][k];
+		}
+		if (d <= 1e-12) {
+			return false;
+		}
+		A[j][j] = sqrt(d);
+
+		for (int i = j + 1; i < 6; i++) {
+			double v = A[i][j];
+			for (int k = 0; k < j; k++) {
+				v -= A[i][k] * A[j][k];
+			}
+			A[i][j] = v / A[j][j];
+		}
+	}
+
+	for (int i = 0; i < 6; i++) {
+		double v = b[i];
+		for (int k = 0; k < i; k++) {
+			v -= A[i][k] * b[k];
+		}
+		b[i] = v / A[i][i];
+	}
+
+	for (int i = 5; i >= 0; i--) {
+		double v = b[i];
+		for (int k = i + 1; k < 6; k++) {
+			v -= A[k][i] * b[k];
+		}
+		b[i] = v / A[i][i];
+	}
+
+	return true;
+}
+
+static double
+wrap_angle(double a)
+{
+	while (a > M_PI) {
+		a -= 2.0 * M_PI;
+	}
+	while (a < -M_PI) {
+		a += 2.0 * M_PI;
+	}
+	return a;
+}
+
+/*!
+ * Refines @p inout_pose, the device in base station space, against the sweeps
+ * and returns the root mean square of the residuals. Returns a negative value
+ * if the solve broke down, like a sensor ending up behind the base station.
+ */
+static float
+refine(const struct lighthouse_solver *s,
+       const struct lighthouse_observation *obs,
+       uint32_t obs_count,
+       struct xrt_pose *inout_pose)
+{
+	struct xrt_pose pose = *inout_pose;
+	double err = 0.0;
+
+	for (int iter = 0; iter < MAX_ITERATIONS; iter++) {
+		double JtJ[6][6] = {{0}};
+		double Jtr[6] = {0};
+		err = 0.0;
+
+		for (uint32_t i = 0; i < obs_count; i++) {
+			struct xrt_vec3 Rp;
+			math_quat_rotate_vec3(&pose.orientation, &s->sensors[obs[i].sensor], &Rp);
+			struct xrt_vec3 q = m_vec3_add(Rp, pose.position);
+
+			if (q.z >= -1e-3f) {
+				return -1.0f;
+			}
+
+			// Derivative of the angle with respect to the point.
+			float lateral = obs[i].axis == 0 ? q.x : q.y;
+			float d = lateral * lateral + q.z * q.z;
+			struct xrt_vec3 g = {0.0f, 0.0f, lateral / d};
+			if (obs[i].axis == 0) {
+				g.x = -q.z / d;
+			} else {
+				g.y = -q.z / d;
+			}
+
+			double r = wrap_angle(obs[i].angle - atan2(lateral, -q.z));
+			double w = fabs(r) > HUBER_THRESHOLD_RAD ? HUBER_THRESHOLD_RAD / fabs(r) : 1.0;
+			err += r * r;
+
+			// Left perturbation of the rotation moves the point by w x Rp.
+			struct xrt_vec3 Jw;
+			math_vec3_cross(&Rp, &g, &Jw);
+			double J[6] = {Jw.x, Jw.y, Jw.z, g.x, g.y, g.z};
+
+			for (int a = 0; a < 6; a++) {
+				Jtr[a] += w * J[a] * r;
+				for (int b = 0; b <= a; b++) {
+					JtJ[a][b] += w * J[a] * J[b];
+				}
+			}
+		}
+
+		// A little damping keeps the step sane far from the solution.
+		for (int a = 0; a < 6; a++) {
+			JtJ[a][a] *= 1.0 + 1e-3;
+			JtJ[a][a] += 1e-9;
+			for (int b = a + 1; b < 6; b++) {
+				JtJ[a][b] = JtJ[b][a];
+			}
+		}
+
+		if (!cholesky_solve_6(JtJ, Jtr)) {
+			return -1.0f;
+		}
+
+		// math_quat_exp takes half of the rotation vector.
+		struct xrt_vec3 half_rot = {(float)Jtr[0] * 0.5f, (float)Jtr[1] * 0.5f, (float)Jtr[2] * 0.5f};
+		struct xrt_quat delta;
+		math_quat_exp(&half_rot, &delta);
+		math_quat_rotate(&delta, &pose.orientation, &pose.orientation);
+		math_quat_normalize(&pose.orientation);
+
+		pose.position.x += (float)Jtr[3];
+		pose.position.y += (float)Jtr[4];
+		pose.position.z += (float)Jtr[5];
+
+		double step = 0.0;
+		for (int a = 0; a < 6; a++) {
+			step += Jtr[a] * Jtr[a];
+		}
+		if (step < 1e-12) {
+			break;
+		}
+	}
+
+	*inout_pose = pose;
+
+	return (float)sqrt(err / obs_count);
+}
+
+static bool
+enough_observations(const struct lighthouse_solver *s, const struct lighthouse_observation *obs, uint32_t obs_count)
+{
+	if (obs_count < MIN_OBSERVATIONS) {
+		return false;
+	}
+
+	uint32_t seen = 0;
+	for (uint32_t i = 0; i < obs_count; i++) {
+		if (obs[i].sensor >= s->sensor_count) {
+			return false;
+		}
+		seen |= 1u << obs[i].sensor;
+	}
+
+	uint32_t count = 0;
+	for (; seen != 0; seen &= seen - 1) {
+		count++;
+	}
+
+	return count >= MIN_SENSORS;
+}
+
+/*!
+ * Solve from scratch, trying a few headings for the device around the
+ * gravity direction both the device and the base station agree on.
+ */
+static float
+solve_from_seeds(const struct lighthouse_solver *s,
+                 const struct xrt_quat *level,
+                 const struct xrt_quat *orientation,
+                 const struct lighthouse_observation *obs,
+                 uint32_t obs_count,
+                 struct xrt_pose *out_pose)
+{
+	struct xrt_quat unlevel;
+	math_quat_invert(level, &unlevel);
+
+	float best_rms = -1.0f;
+	struct xrt_vec3 up = {0.0f, 1.0f, 0.0f};
+
+	for (int i = 0; i < SEED_YAW_COUNT; i++) {
+		struct xrt_quat yaw;
+		math_quat_from_angle_vector((float)(2.0 * M_PI * i / SEED_YAW_COUNT), &up, &yaw);
+
+		struct xrt_pose pose = {.position = {0.0f, 0.0f, -SEED_DISTANCE_M}};
+		math_quat_rotate(&yaw, orientation, &pose.orientation);
+		math_quat_rotate(&unlevel, &pose.orientation, &pose.orientation);
+
+		float rms = refine(s, obs, obs_count, &pose);
+		if (rms >= 0.0f && (best_rms < 0.0f || rms < best_rms)) {
+			best_rms = rms;
+			*out_pose = pose;
+		}
+	}
+
+	return best_rms;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+lighthouse_solver_init(struct lighthouse_solver *s, const struct xrt_vec3 *sensors, uint32_t sensor_count)
+{
+	memset(s, 0, sizeof(*s));
+
+	if (sensor_count > LIGHTHOUSE_SOLVER_MAX_SENSORS) {
+		sensor_count = LIGHTHOUSE_SOLVER_MAX_SENSORS;
+	}
+	memcpy(s->sensors, sensors, sizeof(*sensors) * sensor_count);
+	s->sensor_count = sensor_count;
+
+	lighthouse_solver_reset(s);
+}
+
+void
+lighthouse_solver_reset(struct lighthouse_solver *s)
+{
+	for (uint32_t i = 0; i < LIGHTHOUSE_SOLVER_MAX_BASES; i++) {
+		s->base[i].known = false;
+		s->base[i].have_last = false;
+		math_pose_identity(&s->base[i].pose);
+		math_pose_identity(&s->base[i].last_in_base);
+	}
+
+	math_pose_identity(&s->last_pose);
+	s->last_timestamp_ns = 0;
+	s->last_base = 0;
+	s->last_rms = 0.0f;
+}
+
+bool
+lighthouse_solver_solve(struct lighthouse_solver *s,
+                        uint32_t base_index,
+                        const struct xrt_vec3 *base_up,
+                        const struct xrt_quat *orientation,
+                        const struct lighthouse_observation *obs,
+                        uint32_t obs_count,
+                        uint64_t timestamp_ns,
+                        struct xrt_pose *out_pose)
+{
+	if (base_index >= LIGHTHOUSE_SOLVER_MAX_BASES || !enough_observations(s, obs, obs_count)) {
+		return false;
+	}
+
+	struct xrt_vec3 up = *base_up;
+	if (m_vec3_len_sqrd(up) < 0.25f) {
+		up = (struct xrt_vec3){0.0f, 1.0f, 0.0f};
+	}
+	up = m_vec3_normalize(up);
+
+	struct xrt_quat level;
+	quat_from_a_to_b(up, (struct xrt_vec3){0.0f, 1.0f, 0.0f}, &level);
+
+	struct xrt_pose in_base;
+	float rms = -1.0f;
+
+	// Track from the last solution first, only search if that fails.
+	if (s->base[base_index].have_last) {
+		in_base = s->base[base_index].last_in_base;
+		rms = refine(s, obs, obs_count, &in_base);
+	}
+	if (rms < 0.0f || rms > MAX_RMS_RAD) {
+		rms = solve_from_seeds(s, &level, orientation, obs, obs_count, &in_base);
+	}
+	if (rms < 0.0f || rms > MAX_RMS_RAD) {
+		s->base[base_index].have_last = false;
+		return false;
+	}
+
+	s->base[base_index].have_last = true;
+	s->base[base_index].last_in_base = in_base;
+
+	if (!s->base[base_index].known) {
+		bool any_known = false;
+		for (uint32_t i = 0; i < LIGHTHOUSE_SOLVER_MAX_BASES; i++) {
+			any_known = any_known || s->base[i].known;
+		}
+
+		if (!any_known) {
+			// The first base station makes up tracking space.
+			s->base[base_index].pose.orientation = level;
+			s->base[base_index].pose.position = (struct xrt_vec3){0};
+		} else if (s->last_base != base_index && timestamp_ns - s->last_timestamp_ns < REGISTER_WINDOW_NS) {
+			// Seen by a placed base station a moment ago, place this one from that.
+			struct xrt_pose base_from_device;
+			math_pose_invert(&in_base, &base_from_device);
+			math_pose_transform(&s->last_pose, &base_from_device, &s->base[base_index].pose);
+		} else {
+			return false;
+		}
+
+		s->base[base_index].known = true;
+	}
+
+	math_pose_transform(&s->base[base_index].pose, &in_base, out_pose);
+
+	s->last_pose = *out_pose;
+	s->last_timestamp_ns = timestamp_ns;
+	s->last_base = base_index;
+	s->last_rms = rms;
+
+	return true;
+}
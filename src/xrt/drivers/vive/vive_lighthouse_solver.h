@@ -0,0 +1,124 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Allocation free pose solver for lighthouse sweeps.
+ * @ingroup drv_vive
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * @addtogroup drv_vive
+ * @{
+ */
+
+#define LIGHTHOUSE_SOLVER_MAX_SENSORS (32)
+#define LIGHTHOUSE_SOLVER_MAX_BASES (2)
+
+//! Two sweep angles per sensor at most.
+#define LIGHTHOUSE_SOLVER_MAX_OBSERVATIONS (LIGHTHOUSE_SOLVER_MAX_SENSORS * 2)
+
+/*!
+ * One sweep hitting one sensor, as an angle in base station space.
+ *
+ * Base station space looks down -Z with +Y up, axis 0 is the horizontal
+ * sweep giving `atan2(x, -z)` and axis 1 the vertical sweep giving
+ * `atan2(y, -z)` of the sensor position.
+ */
+struct lighthouse_observation
+{
+	uint8_t sensor;
+	uint8_t axis;
+	float angle;
+};
+
+/*!
+ * Solves the pose of a device from lighthouse sweeps with Gauss-Newton, all
+ * state is in the struct so it can be embedded and used from a reading thread
+ * without any allocations.
+ *
+ * Tracking space is made up from the first base station seen: it sits at the
+ * origin, levelled using the gravity it reports. Other base stations are
+ * placed in that space the first time the device is seen by both at once.
+ */
+struct lighthouse_solver
+{
+	//! Sensor positions in device space.
+	struct xrt_vec3 sensors[LIGHTHOUSE_SOLVER_MAX_SENSORS];
+	uint32_t sensor_count;
+
+	struct
+	{
+		//! Set once the base station has been placed in tracking space.
+		bool known;
+
+		//! Base station in tracking space.
+		struct xrt_pose pose;
+
+		//! Last solution from this base station, seeds the next solve.
+		bool have_last;
+		struct xrt_pose last_in_base;
+	} base[LIGHTHOUSE_SOLVER_MAX_BASES];
+
+	//! Last solution in tracking space and the base station it came from.
+	struct xrt_pose last_pose;
+	uint64_t last_timestamp_ns;
+	uint32_t last_base;
+
+	//! Residual of the last accepted solve, in radians.
+	float last_rms;
+};
+
+/*!
+ * Set up the solver for a device with the given sensor positions, count is
+ * clamped to @ref LIGHTHOUSE_SOLVER_MAX_SENSORS.
+ */
+void
+lighthouse_solver_init(struct lighthouse_solver *s, const struct xrt_vec3 *sensors, uint32_t sensor_count);
+
+//! Forget all base stations and solutions.
+void
+lighthouse_solver_reset(struct lighthouse_solver *s);
+
+/*!
+ * Solve the pose of the device from the sweeps of one base station.
+ *
+ * @param s               Solver.
+ * @param base_index      Which base station the sweeps came from.
+ * @param base_up         Up direction in base station space, from its accelerometer.
+ * @param orientation     Gravity aligned device orientation, from IMU fusion. Only
+ *                        used when there is no previous solution to start from.
+ * @param obs             Sweep angles.
+ * @param obs_count       Number of entries in @p obs.
+ * @param timestamp_ns    When the sweeps happened.
+ * @param[out] out_pose   Device pose in tracking space.
+ *
+ * @return true if the sweeps gave a pose that fits them well enough.
+ */
+bool
+lighthouse_solver_solve(struct lighthouse_solver *s,
+                        uint32_t base_index,
+                        const struct xrt_vec3 *base_up,
+                        const struct xrt_quat *orientation,
+                        const struct lighthouse_observation *obs,
+                        uint32_t obs_count,
+                        uint64_t timestamp_ns,
+                        struct xrt_pose *out_pose);
+
+/*!
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
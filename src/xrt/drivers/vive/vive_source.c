@@ -49,8 +49,9 @@ struct vive_source
 	timepoint_ns last_frame_ts_ns;                //! Last frame timestamp in device nanoseconds
 
 	// Clock offsets
-	time_duration_ns hw2mono; //!< Estimated offset from IMU to monotonic clock
-	time_duration_ns hw2v4l2; //!< Estimated offset from IMU to V4L2 clock
+	time_duration_ns hw2mono;               //!< Estimated offset from IMU to monotonic clock
+	struct m_clock_tracker hw2mono_tracker; //!< Tracks hw2mono, including drift
+	time_duration_ns hw2v4l2;               //!< Estimated offset from IMU to V4L2 clock
 };
 
 /*
@@ -182,6 +183,7 @@ vive_source_create(struct xrt_frame_context *xfctx)
 {
 	struct vive_source *vs = U_TYPED_CALLOC(struct vive_source);
 	vs->log_level = debug_get_log_option_vive_log();
+	m_clock_tracker_init(&vs->hw2mono_tracker, 0, 0);
 
 	// Setup sinks
 	vs->sbs_sink.push_frame = vive_source_receive_sbs_frame;
@@ -239,7 +241,7 @@ vive_source_push_imu_packet(struct vive_source *vs, uint32_t age, timepoint_ns t
 	timepoint_ns sample_point = now_ns - t2ms_ns - age_diff_ns;
 
 	// Time adjustment.
-	t = m_clock_offset_a2b(IMU_FREQUENCY, t, sample_point, &vs->hw2mono);
+	t = m_clock_tracker_a2b(&vs->hw2mono_tracker, t, sample_point, &vs->hw2mono);
 
 	// Finished sample.
 	struct xrt_imu_sample sample = {
@@ -123,6 +123,9 @@ struct wmr_camera
 
 	struct xrt_frame_sink *cam_sinks[WMR_MAX_CAMERAS]; //!< Downstream sinks to push tracking frames to
 
+	//! Recycles the buffers of the frames made in img_xfer_cb, rows are kept tightly packed.
+	struct u_frame_pool *frame_pool;
+
 	enum u_logging_level log_level;
 };
 
@@ -296,43 +299,18 @@ img_xfer_cb(struct libusb_transfer *xfer)
 
 	WMR_CAM_TRACE(cam, "Camera transfer complete - %d bytes of %d", xfer->actual_length, xfer->length);
 
-	/* Convert the output into frames and send them off to debug / tracking */
-	struct xrt_frame *xf = NULL;
-
-	/* There's always one extra line of pixels with exposure info */
-	u_frame_create_one_off(XRT_FORMAT_L8, cam->frame_width, cam->frame_height + 1, &xf);
-
-	const uint8_t *src = xfer->buffer;
-
-	uint8_t *dst = xf->data;
-	size_t dst_remain = xf->size;
+	/* Each 0x6000 byte chunk starts with a 32 byte header, see compute_frame_size */
 	const size_t chunk_size = 0x6000 - 32;
-
-	DRV_TRACE_BEGIN(copy_to_frame);
-	while (dst_remain > 0) {
-		const size_t to_copy = dst_remain > chunk_size ? chunk_size : dst_remain;
-
-		/* 32 byte header seems to contain:
-		 *   __be32 magic = "Dlo+"
-		 *   __le32 frame_ctr;
-		 *   __le32 slice_ctr;
-		 *   __u8 unknown[20]; - binary block where all bytes are different each slice,
-		 *                       but repeat every 8 slices. They're different each boot
-		 *                       of the headset. Might just be uninitialised memory?
-		 */
-		src += 0x20;
-
-		memcpy(dst, src, to_copy);
-		src += to_copy;
-		dst += to_copy;
-		dst_remain -= to_copy;
-	}
-	DRV_TRACE_END(copy_to_frame);
+	const size_t frame_size = (size_t)cam->frame_width * (cam->frame_height + 1);
 
 	/* There should be exactly a 26 byte footer left over */
-	assert(xfer->buffer + xfer->length - src == 26);
+	assert(xfer->length - (frame_size + ((frame_size + chunk_size - 1) / chunk_size) * 0x20) == 26);
 
-	/* Footer contains:
+	/*
+	 * Parse the footer and pixel header straight from the transfer first,
+	 * so frames nobody looks at are never copied out.
+	 *
+	 * Footer contains:
 	 * __le64 start_ts; - 100ns unit timestamp, from same clock as video_timestamps on the IMU feed
 	 * __le64 end_ts;   - 100ns unit timestamp, always about 111000 * 100ns later than start_ts ~= 90Hz
 	 * __le16 ctr1;     - Counter that increments by 88, but sometimes by 96, and wraps at 16384
@@ -340,6 +318,7 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	 * __be32 magic     - "Dlo+"
 	 * __le16 frametype?- either 0x00 or 0x02. Every 3rd frame is 0x0, others are 0x2. Might be SLAM vs controllers?
 	 */
+	const uint8_t *src = xfer->buffer + xfer->length - 26;
 	uint64_t frame_start_ts = read64(&src) * WMR_MS_HOLOLENS_NS_PER_TICK;
 	uint64_t frame_end_ts = read64(&src) * WMR_MS_HOLOLENS_NS_PER_TICK;
 	int64_t delta = frame_end_ts - frame_start_ts;
@@ -357,9 +336,10 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	              frame_start_ts, frame_start_ts - cam->last_frame_ts, frame_end_ts, delta, unknown16, unknown16_2,
 	              frametype);
 
-	/* Read values from the pixel header */
-	uint16_t exposure = xf->data[6] << 8 | xf->data[7];
-	uint8_t seq = xf->data[89];
+	/* Read values from the pixel header, well within the first chunk */
+	const uint8_t *pixels = xfer->buffer + 0x20;
+	uint16_t exposure = pixels[6] << 8 | pixels[7];
+	uint8_t seq = pixels[89];
 	uint8_t seq_delta = seq - cam->last_seq;
 
 	/* Extend the sequence number to 64-bits */
@@ -368,16 +348,54 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	WMR_CAM_TRACE(cam, "Camera frame seq %u (prev %u) -> frame %" PRIu64 " - exposure %u", seq, cam->last_seq,
 	              cam->frame_sequence, exposure);
 
+	cam->last_frame_ts = frame_start_ts;
+	cam->last_seq = seq;
+
+	/* Controller tracking frames, two out of three, are only used for debugging */
+	int sink_index = slam_tracking_frame ? WMR_DEBUG_SINK_SLAM : WMR_DEBUG_SINK_CONTROLLER;
+	bool debug_active = u_sink_debug_is_active(&cam->debug_sinks[sink_index]);
+	if (!slam_tracking_frame && !debug_active) {
+		goto out;
+	}
+
+	/* Convert the output into frames and send them off to debug / tracking */
+	struct xrt_frame *xf = NULL;
+
+	/* There's always one extra line of pixels with exposure info */
+	u_frame_pool_get(cam->frame_pool, XRT_FORMAT_L8, cam->frame_width, cam->frame_height + 1, &xf);
+
+	src = xfer->buffer;
+
+	uint8_t *dst = xf->data;
+	size_t dst_remain = xf->size;
+
+	DRV_TRACE_BEGIN(copy_to_frame);
+	while (dst_remain > 0) {
+		const size_t to_copy = dst_remain > chunk_size ? chunk_size : dst_remain;
+
+		/* 32 byte header seems to contain:
+		 *   __be32 magic = "Dlo+"
+		 *   __le32 frame_ctr;
+		 *   __le32 slice_ctr;
+		 *   __u8 unknown[20]; - binary block where all bytes are different each slice,
+		 *                       but repeat every 8 slices. They're different each boot
+		 *                       of the headset. Might just be uninitialised memory?
+		 */
+		src += 0x20;
+
+		memcpy(dst, src, to_copy);
+		src += to_copy;
+		dst += to_copy;
+		dst_remain -= to_copy;
+	}
+	DRV_TRACE_END(copy_to_frame);
+
 	xf->source_sequence = cam->frame_sequence;
 	xf->timestamp = frame_start_ts + delta / 2;
 	xf->source_timestamp = frame_start_ts;
 
-	cam->last_frame_ts = frame_start_ts;
-	cam->last_seq = seq;
-
 	/* Push to the appropriate debug output based on frame type */
-	int sink_index = slam_tracking_frame ? WMR_DEBUG_SINK_SLAM : WMR_DEBUG_SINK_CONTROLLER;
-	if (u_sink_debug_is_active(&cam->debug_sinks[sink_index])) {
+	if (debug_active) {
 		u_sink_debug_push_frame(&cam->debug_sinks[sink_index], xf);
 	}
 
@@ -439,6 +457,13 @@ wmr_camera_open(struct wmr_camera_open_config *config)
 		return NULL;
 	}
 
+	cam->frame_pool = u_frame_pool_create(false, 0);
+	if (cam->frame_pool == NULL) {
+		WMR_CAM_ERROR(cam, "Failed to create frame pool");
+		wmr_camera_free(cam);
+		return NULL;
+	}
+
 	res = libusb_init(&cam->ctx);
 	if (res < 0) {
 		goto fail;
@@ -571,6 +596,9 @@ wmr_camera_free(struct wmr_camera *cam)
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_SLAM]);
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_CONTROLLER]);
 
+	// Frames still held downstream keep the pool alive.
+	u_frame_pool_reference(&cam->frame_pool, NULL);
+
 	free(cam);
 }
 
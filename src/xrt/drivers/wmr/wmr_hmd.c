@@ -26,7 +26,6 @@
 
 #include "math/m_api.h"
 #include "math/m_mathinclude.h"
-#include "math/m_predict.h"
 #include "math/m_vec2.h"
 
 #include "util/u_var.h"
@@ -37,10 +36,7 @@
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_sink.h"
-
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "tracking/t_tracking.h"
 
@@ -374,6 +370,26 @@ hololens_handle_debug(struct wmr_hmd *wh, const unsigned char *buffer, int size)
 	WMR_DEBUG(wh, "HMD debug: TS %f seq %u src %d: %.*s", timestamp / 1000.0, seq, src_tag, msg_len, buffer);
 }
 
+/*!
+ * One relation per packet for the 3DoF pose queries, the rest of the relation
+ * is filled in on query.
+ */
+static void
+hololens_push_fusion_relation(struct wmr_hmd *wh,
+                              const struct xrt_quat *rot,
+                              const struct xrt_vec3 *angular_velocity,
+                              uint64_t now_ns)
+{
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |      //
+	                          XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |    //
+	                          XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT; //
+	relation.pose.orientation = *rot;
+	relation.angular_velocity = *angular_velocity;
+
+	m_relation_history_push(wh->fusion.relation_hist, &relation, now_ns);
+}
+
 static void
 hololens_handle_sensors_avg(struct wmr_hmd *wh, const unsigned char *buffer, int size)
 {
@@ -414,8 +430,11 @@ hololens_handle_sensors_avg(struct wmr_hmd *wh, const unsigned char *buffer, int
 	m_imu_3dof_update(&wh->fusion.i3dof, t, &avg_calib_accel, &avg_calib_gyro);
 	wh->fusion.last_imu_timestamp_ns = now_ns;
 	wh->fusion.last_angular_velocity = avg_calib_gyro;
+	struct xrt_quat rot = wh->fusion.i3dof.rot;
 	os_mutex_unlock(&wh->fusion.mutex);
 
+	hololens_push_fusion_relation(wh, &rot, &avg_calib_gyro, now_ns);
+
 	// SLAM tracking
 	wmr_source_push_imu_packet(wh->tracking.source, t, avg_raw_accel, avg_raw_gyro);
 }
@@ -434,8 +453,11 @@ hololens_handle_sensors_all(struct wmr_hmd *wh, const unsigned char *buffer, int
 	struct xrt_vec3 raw_accel[IMU_SAMPLES_PER_PACKET];
 	struct xrt_vec3 calib_gyro[IMU_SAMPLES_PER_PACKET];
 	struct xrt_vec3 calib_accel[IMU_SAMPLES_PER_PACKET];
+	uint64_t timestamps_ns[IMU_SAMPLES_PER_PACKET];
 
 	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
+		timestamps_ns[i] = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
+
 		struct xrt_vec3 *rg = &raw_gyro[i];
 		struct xrt_vec3 *cg = &calib_gyro[i];
 		vec3_from_hololens_gyro(wh->packet.gyro, i, rg);
@@ -453,22 +475,22 @@ hololens_handle_sensors_all(struct wmr_hmd *wh, const unsigned char *buffer, int
 
 	// Fusion tracking
 	os_mutex_lock(&wh->fusion.mutex);
-	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
-		m_imu_3dof_update(                                              //
-		    &wh->fusion.i3dof,                                          //
-		    wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK, //
-		    &calib_accel[i],                                            //
-		    &calib_gyro[i]);                                            //
-	}
+	m_imu_3dof_update_batch(     //
+	    &wh->fusion.i3dof,       //
+	    timestamps_ns,           //
+	    calib_accel,             //
+	    calib_gyro,              //
+	    IMU_SAMPLES_PER_PACKET); //
 	wh->fusion.last_imu_timestamp_ns = now_ns;
-	wh->fusion.last_angular_velocity = calib_gyro[3];
+	wh->fusion.last_angular_velocity = calib_gyro[IMU_SAMPLES_PER_PACKET - 1];
+	struct xrt_quat rot = wh->fusion.i3dof.rot;
 	os_mutex_unlock(&wh->fusion.mutex);
 
+	hololens_push_fusion_relation(wh, &rot, &calib_gyro[IMU_SAMPLES_PER_PACKET - 1], now_ns);
+
 	// SLAM tracking
-	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
-		timepoint_ns t = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
-		wmr_source_push_imu_packet(wh->tracking.source, t, raw_accel[i], raw_gyro[i]);
-	}
+	wmr_source_push_imu_packets(wh->tracking.source, (const timepoint_ns *)timestamps_ns, raw_accel, raw_gyro,
+	                            IMU_SAMPLES_PER_PACKET);
 }
 
 static void
@@ -565,6 +587,10 @@ control_ipd_value_decode(struct wmr_hmd *wh, const unsigned char *buffer, int si
 	wh->raw_ipd = ipd_value;
 	wh->proximity_sensor = proximity;
 
+	// Let the compositor know if the headset is being worn.
+	wh->base.inputs[1].value.boolean = proximity != 0;
+	wh->base.inputs[1].timestamp = (int64_t)os_monotonic_get_ns();
+
 	if (changed) {
 		WMR_DEBUG(wh, "Proximity sensor %d IPD: %d", proximity, ipd_value);
 	}
@@ -661,10 +687,8 @@ wmr_run_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("WMR: USB-HMD");
 	os_thread_helper_name(&wh->oth, "WMR: USB-HMD");
 
-#ifdef XRT_OS_LINUX
-	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(wh->log_level, "WMR: USB-HMD");
-#endif
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_IMU, wh->log_level, "WMR: USB-HMD");
 
 
 	os_thread_helper_lock(&wh->oth);
@@ -1043,6 +1067,7 @@ wmr_read_config(struct wmr_hmd *wh)
 	WMR_INFO(wh, "Revision Date: %.*s", (int)sizeof(hdr->revision_date), hdr->revision_date);
 
 	snprintf(wh->base.str, XRT_DEVICE_NAME_LEN, "%.*s", (int)sizeof(hdr->name), hdr->name);
+	snprintf(wh->base.serial, XRT_DEVICE_NAME_LEN, "%.*s", (int)sizeof(hdr->serial), hdr->serial);
 
 	if (hdr->json_start >= data_size || (data_size - hdr->json_start) < hdr->json_size) {
 		WMR_ERROR(wh, "Invalid WMR config block - incorrect sizes");
@@ -1087,30 +1112,21 @@ wmr_hmd_get_3dof_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	// Variables needed for prediction.
-	uint64_t last_imu_timestamp_ns = 0;
-	struct xrt_space_relation relation = {0};
+	// Interpolated or predicted from the per packet relations, no need to wait on the fusion.
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	enum m_relation_history_result res = m_relation_history_get(wh->fusion.relation_hist, at_timestamp_ns, &relation);
+	if (res == M_RELATION_HISTORY_RESULT_INVALID) {
+		// No IMU packets yet, the fusion holds the starting orientation.
+		os_mutex_lock(&wh->fusion.mutex);
+		relation.pose.orientation = wh->fusion.i3dof.rot;
+		os_mutex_unlock(&wh->fusion.mutex);
+	}
+
 	relation.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
 	relation.pose.position = wh->pose.position;
 	relation.linear_velocity = (struct xrt_vec3){0, 0, 0};
 
-	// Get data while holding the lock.
-	os_mutex_lock(&wh->fusion.mutex);
-	relation.pose.orientation = wh->fusion.i3dof.rot;
-	relation.angular_velocity = wh->fusion.last_angular_velocity;
-	last_imu_timestamp_ns = wh->fusion.last_imu_timestamp_ns;
-	os_mutex_unlock(&wh->fusion.mutex);
-
-	// No prediction needed.
-	if (at_timestamp_ns < last_imu_timestamp_ns) {
-		*out_relation = relation;
-		return;
-	}
-
-	uint64_t prediction_ns = at_timestamp_ns - last_imu_timestamp_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
-
-	m_predict_relation(&relation, prediction_s, out_relation);
+	*out_relation = relation;
 	wh->pose = out_relation->pose;
 }
 
@@ -1229,6 +1245,7 @@ wmr_hmd_destroy(struct xrt_device *xdev)
 
 	// Destroy the fusion.
 	m_imu_3dof_close(&wh->fusion.i3dof);
+	m_relation_history_destroy(&wh->fusion.relation_hist);
 
 	os_mutex_destroy(&wh->fusion.mutex);
 	os_mutex_destroy(&wh->hid_lock);
@@ -1618,6 +1635,9 @@ wmr_hmd_switch_hmd_tracker(void *wh_ptr)
 		m_imu_3dof_reset(&wh->fusion.i3dof);
 		wh->fusion.i3dof.rot = wh->pose.orientation;
 		os_mutex_unlock(&wh->fusion.mutex);
+
+		// Old relations are from before the reset.
+		m_relation_history_clear(wh->fusion.relation_hist);
 	}
 }
 
@@ -1637,6 +1657,9 @@ wmr_hmd_slam_track(struct wmr_hmd *wh)
 	if (debug_get_option_slam_submit_from_start() == NULL) {
 		config.submit_from_start = true;
 	}
+	if (config.map_key == NULL && wh->base.serial[0] != '\0') {
+		config.map_key = wh->base.serial; // One map per headset unless the user asks for another
+	}
 
 	int create_status = t_slam_create(&wh->tracking.xfctx, &config, &wh->tracking.slam, &sinks);
 	if (create_status != 0) {
@@ -1935,7 +1958,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	int i;
 	int eye;
 
-	struct wmr_hmd *wh = U_DEVICE_ALLOCATE(struct wmr_hmd, flags, 1, 0);
+	struct wmr_hmd *wh = U_DEVICE_ALLOCATE(struct wmr_hmd, flags, 2, 0);
 	if (!wh) {
 		return;
 	}
@@ -1964,6 +1987,8 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 		return;
 	}
 
+	m_relation_history_create(&wh->fusion.relation_hist);
+
 	ret = os_mutex_init(&wh->hid_lock);
 	if (ret != 0) {
 		WMR_ERROR(wh, "Failed to init HID mutex!");
@@ -1999,6 +2024,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 
 	// Setup input.
 	wh->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
+	wh->base.inputs[1].name = XRT_INPUT_GENERIC_HEAD_DETECT;
 
 	// Read config file from HMD
 	if (wmr_read_config(wh) < 0) {
@@ -2080,6 +2106,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	wh->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
 	wh->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
 	wh->base.compute_distortion = compute_distortion_wmr;
+	wh->base.compute_distortion_thread_safe = true;
 	u_distortion_mesh_fill_in_compute(&wh->base);
 
 	// Set initial HMD screen power state.
@@ -20,6 +20,7 @@
 #include "xrt/xrt_prober.h"
 #include "os/os_threading.h"
 #include "math/m_imu_3dof.h"
+#include "math/m_relation_history.h"
 #include "util/u_logging.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_var.h"
@@ -132,6 +133,12 @@ struct wmr_hmd
 
 		//! When did we get the last IMU sample, in CPU time.
 		uint64_t last_imu_timestamp_ns;
+
+		/*!
+		 * One relation per IMU packet in CPU time, 3DoF pose queries are
+		 * answered from here without taking @ref mutex. Has its own lock.
+		 */
+		struct m_relation_history *relation_hist;
 	} fusion;
 
 	//! Fields related to camera-based tracking (SLAM and hand tracking)
@@ -75,8 +75,9 @@ struct wmr_source
 	bool is_running;              //!< Whether the device is streaming
 	bool first_imu_received;      //!< Don't send frames until first IMU sample
 	timepoint_ns last_imu_ns;     //!< Last timepoint received.
-	time_duration_ns hw2mono;     //!< Estimated offset from IMU to monotonic clock
-	time_duration_ns cam_hw2mono; //!< Caches hw2mono for use in the full frame bundle
+	time_duration_ns hw2mono;               //!< Estimated offset from IMU to monotonic clock
+	struct m_clock_tracker hw2mono_tracker; //!< Tracks hw2mono, including drift
+	time_duration_ns cam_hw2mono;           //!< Caches hw2mono for use in the full frame bundle
 };
 
 /*
@@ -121,10 +122,9 @@ receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 
 	// Convert hardware timestamp into monotonic clock. Update offset estimate hw2mono.
 	// Note this is only done with IMU samples as they have the smallest USB transmission time.
-	const float IMU_FREQ = 250.f; //!< @todo use 1000 if "average_imus" is false
 	timepoint_ns now_hw = s->timestamp_ns;
 	timepoint_ns now_mono = (timepoint_ns)os_monotonic_get_ns();
-	timepoint_ns ts = m_clock_offset_a2b(IMU_FREQ, now_hw, now_mono, &ws->hw2mono);
+	timepoint_ns ts = m_clock_tracker_a2b(&ws->hw2mono_tracker, now_hw, now_mono, &ws->hw2mono);
 
 	/*
 	 * Check if the timepoint does time travel, we get one or two
@@ -301,6 +301,7 @@ wmr_source_create(struct xrt_frame_context *xfctx, struct xrt_prober_device *dev
 
 	struct wmr_source *ws = U_TYPED_CALLOC(struct wmr_source);
 	ws->log_level = debug_get_log_option_wmr_log();
+	m_clock_tracker_init(&ws->hw2mono_tracker, 0, 0);
 
 	// Setup xrt_fs
 	struct xrt_fs *xfs = &ws->xfs;
@@ -377,3 +378,25 @@ wmr_source_push_imu_packet(struct xrt_fs *xfs, timepoint_ns t, struct xrt_vec3 a
 	struct xrt_imu_sample sample = {.timestamp_ns = t, .accel_m_s2 = accel_f64, .gyro_rad_secs = gyro_f64};
 	xrt_sink_push_imu(&ws->imu_sink, &sample);
 }
+
+void
+wmr_source_push_imu_packets(struct xrt_fs *xfs,
+                            const timepoint_ns *ts,
+                            const struct xrt_vec3 *accels,
+                            const struct xrt_vec3 *gyros,
+                            uint32_t count)
+{
+	DRV_TRACE_MARKER();
+	struct wmr_source *ws = wmr_source_from_xfs(xfs);
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_vec3_f64 accel_f64 = {accels[i].x, accels[i].y, accels[i].z};
+		struct xrt_vec3_f64 gyro_f64 = {gyros[i].x, gyros[i].y, gyros[i].z};
+		struct xrt_imu_sample sample = {
+		    .timestamp_ns = ts[i],
+		    .accel_m_s2 = accel_f64,
+		    .gyro_rad_secs = gyro_f64,
+		};
+		receive_imu_sample(&ws->imu_sink, &sample);
+	}
+}
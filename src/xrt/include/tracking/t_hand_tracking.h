@@ -182,6 +182,13 @@ struct t_hand_tracking_async
 	                 uint64_t desired_timestamp_ns,
 	                 struct xrt_hand_joint_set *out_value,
 	                 uint64_t *out_timestamp_ns);
+
+	/*!
+	 * Pause or resume tracking. While paused pushed frames are dropped and
+	 * the hands are not active, the hands from before the pause are
+	 * forgotten so they aren't predicted from when tracking resumes.
+	 */
+	void (*set_paused)(struct t_hand_tracking_async *ht_async, bool paused);
 };
 
 struct t_hand_tracking_async *
@@ -381,6 +381,12 @@ struct xrt_layer_data
 	 */
 	uint64_t timestamp;
 
+	/*!
+	 * When the poses the layer was rendered with were sampled, zero if not
+	 * known. Only used for measuring motion to photon latency.
+	 */
+	uint64_t pose_sample_ns;
+
 	/*!
 	 * Composition flags
 	 */
@@ -448,6 +454,12 @@ struct xrt_layer_frame_data
 	int64_t frame_id;
 	uint64_t display_time_ns;
 	enum xrt_blend_mode env_blend_mode;
+
+	/*!
+	 * All layers are the same as in the previous frame, same images and
+	 * data with no new releases, set by the multi compositor.
+	 */
+	bool layers_unchanged;
 };
 
 
@@ -466,6 +478,12 @@ enum xrt_swapchain_create_flags
 	XRT_SWAPCHAIN_CREATE_PROTECTED_CONTENT = (1u << 0u),
 	//! Signals that the allocator should only allocate one image.
 	XRT_SWAPCHAIN_CREATE_STATIC_IMAGE = (1u << 1u),
+	/*!
+	 * Internal flag, the images will be imported on a different GPU than
+	 * the one they are allocated on, so they have to be allocated in a
+	 * linear layout that can be shared between devices.
+	 */
+	XRT_SWAPCHAIN_CREATE_CROSS_DEVICE = (1u << 2u),
 };
 
 /*!
@@ -765,6 +783,23 @@ struct xrt_compositor_semaphore
 	 */
 	xrt_result_t (*wait)(struct xrt_compositor_semaphore *xcsem, uint64_t value, uint64_t timeout_ns);
 
+	/*!
+	 * Optional, sets the semaphore to the given value from the CPU side,
+	 * the value must be greater then the current value.
+	 */
+	xrt_result_t (*signal)(struct xrt_compositor_semaphore *xcsem, uint64_t value);
+
+	/*!
+	 * Optional, does a CPU side wait until any of the @p count semaphores
+	 * in @p xcsems has reached its value in @p values. All of the
+	 * semaphores must have the same @p wait_any function, returns
+	 * XRT_TIMEOUT if none of them reached its value in time.
+	 */
+	xrt_result_t (*wait_any)(struct xrt_compositor_semaphore **xcsems,
+	                         const uint64_t *values,
+	                         uint32_t count,
+	                         uint64_t timeout_ns);
+
 	/*!
 	 * Destroys the semaphore.
 	 */
@@ -817,6 +852,36 @@ xrt_compositor_semaphore_wait(struct xrt_compositor_semaphore *xcsem, uint64_t v
 	return xcsem->wait(xcsem, value, timeout);
 }
 
+/*!
+ * @copydoc xrt_compositor_semaphore::signal
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof xrt_compositor_semaphore
+ */
+static inline xrt_result_t
+xrt_compositor_semaphore_signal(struct xrt_compositor_semaphore *xcsem, uint64_t value)
+{
+	return xcsem->signal(xcsem, value);
+}
+
+/*!
+ * @copydoc xrt_compositor_semaphore::wait_any
+ *
+ * Helper for calling through the function pointer, uses the function of the
+ * first semaphore.
+ *
+ * @public @memberof xrt_compositor_semaphore
+ */
+static inline xrt_result_t
+xrt_compositor_semaphore_wait_any(struct xrt_compositor_semaphore **xcsems,
+                                  const uint64_t *values,
+                                  uint32_t count,
+                                  uint64_t timeout_ns)
+{
+	return xcsems[0]->wait_any(xcsems, values, count, timeout_ns);
+}
+
 
 /*
  *
@@ -900,6 +965,9 @@ struct xrt_compositor_info
 
 	//! Max texture size that GPU supports (size of a single dimension), zero means any size.
 	uint32_t max_texture_size;
+
+	//! UUID of the Vulkan device images are allocated on, all zero if unknown.
+	xrt_uuid_t vk_deviceUUID;
 };
 
 /*!
@@ -2027,6 +2095,12 @@ struct xrt_image_native
 	 * Is the native buffer handle a DXGI handle?
 	 */
 	bool is_dxgi_handle;
+
+	/*!
+	 * Bytes per row, only set for images allocated in a linear layout,
+	 * zero otherwise.
+	 */
+	uint32_t row_pitch;
 };
 
 /*!
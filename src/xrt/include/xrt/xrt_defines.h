@@ -125,6 +125,10 @@ enum xrt_distortion_model
 	XRT_DISTORTION_MODEL_NONE      = 1u << 0u,
 	XRT_DISTORTION_MODEL_COMPUTE   = 1u << 1u,
 	XRT_DISTORTION_MODEL_MESHUV    = 1u << 2u,
+	XRT_DISTORTION_MODEL_VIVE      = 1u << 3u,
+	XRT_DISTORTION_MODEL_PANOTOOLS = 1u << 4u,
+	XRT_DISTORTION_MODEL_CARDBOARD = 1u << 5u,
+	XRT_DISTORTION_MODEL_NS_P2D    = 1u << 6u,
 	// clang-format on
 };
 
@@ -221,6 +225,66 @@ struct xrt_uv_triplet
 	struct xrt_vec2 r, g, b;
 };
 
+/*!
+ * Parameters of the distortion used by the Vive, Vive Pro and Index, set on
+ * devices that support @ref XRT_DISTORTION_MODEL_VIVE so that the compositor
+ * can evaluate it on the GPU.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_vive_values
+{
+	float aspect_x_over_y;
+	float grow_for_undistort;
+
+	//! r/g/b
+	struct xrt_vec2 center[3];
+
+	//! r/g/b, a/b/c/d
+	float coefficients[3][4];
+
+	//! Flip the resulting V coordinate, needed by the Vive Pro 2.
+	bool flip_y;
+};
+
+/*!
+ * Parameters of the Panotools distortion, set on devices that support
+ * @ref XRT_DISTORTION_MODEL_PANOTOOLS.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_panotools_values
+{
+	//! Universal distortion k, from r^1 to r^5.
+	float distortion_k[5];
+
+	//! Post distortion scale, r/g/b.
+	float aberration_k[3];
+
+	float scale;
+	struct xrt_vec2 lens_center;
+	struct xrt_vec2 viewport_size;
+};
+
+/*!
+ * Parameters of the Cardboard distortion, set on devices that support
+ * @ref XRT_DISTORTION_MODEL_CARDBOARD.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_cardboard_values
+{
+	//! Distortion k, from r^2 to r^10.
+	float distortion_k[5];
+
+	//! Used to transform to and from tanangle space.
+	struct
+	{
+		struct xrt_vec2 size;
+		struct xrt_vec2 offset;
+	} screen, texture;
+};
+
 /*!
  * A 3 element vector with single floats.
  *
@@ -449,6 +513,22 @@ struct xrt_fov
 	float angle_down;
 };
 
+/*!
+ * Parameters of the North Star 2D polynomial distortion for one view, set on
+ * devices that support @ref XRT_DISTORTION_MODEL_NS_P2D.
+ *
+ * @ingroup xrt_iface
+ */
+struct xrt_distortion_ns_p2d_values
+{
+	//! Coefficients of the polynomials giving the ray for a UV, x^i * y^j at [i * 4 + j].
+	float x_coefficients[16];
+	float y_coefficients[16];
+
+	//! The rays are mapped from this fov to UVs.
+	struct xrt_fov fov;
+};
+
 /*!
  * The number of values in @ref xrt_matrix_2x2
  *
@@ -1335,6 +1415,16 @@ enum xrt_form_factor
 	XRT_FORM_FACTOR_HANDHELD, //!< Handheld display.
 };
 
+/*!
+ * Camera based tracking that a device can turn on and off while running,
+ * see @ref xrt_device::set_feature_enabled.
+ */
+enum xrt_device_feature_type
+{
+	XRT_DEVICE_FEATURE_HAND_TRACKING = 0, //!< Optical hand tracking.
+	XRT_DEVICE_FEATURE_SLAM_TRACKING = 1, //!< Inside out positional tracking.
+};
+
 /*!
  * Domain type.
  * Use for performance level setting
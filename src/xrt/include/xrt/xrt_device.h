@@ -11,6 +11,7 @@
 #pragma once
 
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_limits.h"
 #include "xrt/xrt_visibility_mask.h"
 
 
@@ -99,6 +100,14 @@ struct xrt_hmd_parts
 		int h_pixels;
 		//! Nominal frame interval
 		uint64_t nominal_frame_interval_ns;
+
+		/*!
+		 * Refresh rates the panel can be switched between, in Hz. Zero if
+		 * the driver only knows about the nominal one. The compositor can
+		 * only switch to the ones the display also exposes a mode for.
+		 */
+		uint32_t refresh_rate_count;
+		float refresh_rates_hz[XRT_MAX_SUPPORTED_REFRESH_RATES];
 	} screens[1];
 
 	/*!
@@ -147,7 +156,35 @@ struct xrt_hmd_parts
 
 		//! distortion is subject to the field of view
 		struct xrt_fov fov[2];
+
+		//! Per view parameters, valid if @ref XRT_DISTORTION_MODEL_VIVE is in models.
+		struct xrt_distortion_vive_values vive[2];
+
+		//! Per view parameters, valid if @ref XRT_DISTORTION_MODEL_PANOTOOLS is in models.
+		struct xrt_distortion_panotools_values panotools[2];
+
+		//! Per view parameters, valid if @ref XRT_DISTORTION_MODEL_CARDBOARD is in models.
+		struct xrt_distortion_cardboard_values cardboard[2];
+
+		//! Per view parameters, valid if @ref XRT_DISTORTION_MODEL_NS_P2D is in models.
+		struct xrt_distortion_ns_p2d_values ns_p2d[2];
 	} distortion;
+
+	/*!
+	 * Foveation information, lets the compositor shade the periphery of
+	 * the views at a reduced rate.
+	 */
+	struct
+	{
+		//! Does this device want foveated composition.
+		bool enabled;
+
+		//! Radius of the full rate region, in view uv space [0 .. 1].
+		float radius;
+
+		//! Centre of the full rate region, in view uv space, used without eye gaze.
+		struct xrt_vec2 centers[2];
+	} foveation;
 };
 
 /*!
@@ -266,6 +303,13 @@ struct xrt_device
 	bool form_factor_check_supported;
 	bool stage_supported;
 
+	/*!
+	 * Can @ref compute_distortion be called from multiple threads at the
+	 * same time, if so the compositor can spread the work over a few. Only
+	 * set this if the function doesn't modify any state.
+	 */
+	bool compute_distortion_thread_safe;
+
 
 	/*
 	 *
@@ -453,6 +497,21 @@ struct xrt_device
 	 */
 	bool (*is_form_factor_available)(struct xrt_device *xdev, enum xrt_form_factor form_factor);
 
+	/*!
+	 * Turn camera based tracking on or off without tearing down the camera
+	 * pipeline, so tracking load can be shed while sessions keep running.
+	 * While SLAM is off the device keeps its last known position and only
+	 * tracks orientation. Optional, may be NULL.
+	 *
+	 * @param[in] xdev    The device.
+	 * @param[in] type    Which tracking to change.
+	 * @param[in] enabled Turn it on or off.
+	 *
+	 * @return XRT_ERROR_FEATURE_NOT_SUPPORTED if the device doesn't have
+	 *         the tracking, or it wasn't built.
+	 */
+	xrt_result_t (*set_feature_enabled)(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled);
+
 	/*!
 	 * Destroy device.
 	 */
@@ -598,6 +657,19 @@ xrt_device_is_form_factor_available(struct xrt_device *xdev, enum xrt_form_facto
 	return xdev->is_form_factor_available(xdev, form_factor);
 }
 
+/*!
+ * Helper function for @ref xrt_device::set_feature_enabled.
+ *
+ * @copydoc xrt_device::set_feature_enabled
+ *
+ * @public @memberof xrt_device
+ */
+static inline xrt_result_t
+xrt_device_set_feature_enabled(struct xrt_device *xdev, enum xrt_device_feature_type type, bool enabled)
+{
+	return xdev->set_feature_enabled(xdev, type, enabled);
+}
+
 /*!
  * Helper function for @ref xrt_device::destroy.
  *
@@ -40,6 +40,18 @@ struct xrt_frame
 	uint64_t source_timestamp;
 	uint64_t source_sequence; //!< sequence id
 	uint64_t source_id;       //!< Which @ref xrt_fs this frame originated from.
+
+	/*!
+	 * Optional dma-buf that backs @ref data, lets consumers like hardware
+	 * encoders import the frame without reading it with the CPU. Owned by
+	 * the producer of the frame, only valid if @ref has_dmabuf is set.
+	 */
+	int dmabuf_fd;
+
+	//! Offset of the first pixel in @ref dmabuf_fd.
+	size_t dmabuf_offset;
+
+	bool has_dmabuf;
 };
 
 
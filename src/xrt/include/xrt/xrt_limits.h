@@ -32,7 +32,7 @@
 /*!
  * Max formats supported by a compositor, artificial limit.
  */
-#define XRT_MAX_SWAPCHAIN_FORMATS 16
+#define XRT_MAX_SWAPCHAIN_FORMATS 32
 
 /*!
  * Max formats in the swapchain creation info formats list, artificial limit.
@@ -44,6 +44,13 @@
  */
 #define XRT_MAX_SUPPORTED_REFRESH_RATES 16
 
+/*!
+ * Max number of layers a single compositor client can submit per frame,
+ * artificial limit. The native compositor can take more than this in total as
+ * the layers of multiple clients are rendered together.
+ */
+#define XRT_MAX_LAYERS 32
+
 /*!
  * @}
  */
@@ -61,6 +61,7 @@ typedef __eglMustCastToProperFunctionPointerType (*PFNEGLGETPROCADDRESSPROC)(con
 #include "openxr/openxr_platform.h"           // IWYU pragma: export
 #include "openxr/openxr_loader_negotiation.h" // IWYU pragma: export
 
+#include "openxr/XR_KHR_locate_spaces.h"
 #include "openxr/XR_MNDX_hydra.h"
 #include "openxr/XR_MNDX_system_buttons.h"
 #include "openxr/XR_MNDX_ball_on_a_stick_controller.h"
@@ -181,4 +181,9 @@ typedef enum xrt_result
 	 * error condition on bad code.
 	 */
 	XRT_ERROR_DEVICE_FUNCTION_NOT_IMPLEMENTED = -29,
+
+	/*!
+	 * The device doesn't have the requested feature, or it wasn't built.
+	 */
+	XRT_ERROR_FEATURE_NOT_SUPPORTED = -30,
 } xrt_result_t;
@@ -158,6 +158,8 @@ struct ipc_connection
 
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
+	//! Size of the mapping of @ref ism, read from its layout.
+	size_t ism_size;
 
 	struct os_mutex mutex;
 
@@ -179,6 +181,9 @@ struct ipc_client_xdev
 	struct ipc_connection *ipc_c;
 
 	uint32_t device_id;
+
+	//! Last sequence copied from the published inputs, zero forces a copy.
+	uint64_t input_sequence;
 };
 
 
@@ -199,6 +204,42 @@ ipc_client_xdev(struct xrt_device *xdev)
 	return (struct ipc_client_xdev *)xdev;
 }
 
+/*!
+ * Get a tracked pose from the poses published by the service in
+ * @ref ipc_shared_memory::device_poses, without doing a round trip.
+ *
+ * Returns false if the pose isn't published, or if @p at_timestamp_ns is
+ * outside of the published window, the caller then needs to fall back to
+ * calling the service.
+ *
+ * @ingroup ipc_client
+ */
+bool
+ipc_client_xdev_get_shared_tracked_pose(struct ipc_client_xdev *icx,
+                                        enum xrt_input_name name,
+                                        uint64_t at_timestamp_ns,
+                                        struct xrt_space_relation *out_relation);
+
+/*!
+ * Allocate the inputs of the device and copy the initial state from the
+ * shared memory, the device owns the inputs so the service can't change them
+ * behind the back of the caller.
+ *
+ * @ingroup ipc_client
+ */
+void
+ipc_client_xdev_init_inputs(struct ipc_client_xdev *icx);
+
+/*!
+ * Update the inputs of the device, uses the inputs published by the service in
+ * @ref ipc_shared_memory_layout::published_inputs when possible. Otherwise does a
+ * round trip to have the service update them.
+ *
+ * @ingroup ipc_client
+ */
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx);
+
 /*!
  * Create an IPC client system compositor.
  *
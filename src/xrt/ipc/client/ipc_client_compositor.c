@@ -18,6 +18,7 @@
 
 #include "util/u_misc.h"
 #include "util/u_wait.h"
+#include "util/u_index_fifo.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
@@ -97,6 +98,12 @@ struct ipc_client_swapchain
 	struct ipc_client_compositor *icc;
 
 	uint32_t id;
+
+	/*!
+	 * Images available to acquire, only the app acquires and releases
+	 * images, so this is tracked here instead of in the service.
+	 */
+	struct u_index_fifo fifo;
 };
 
 /*!
@@ -185,34 +192,50 @@ ipc_compositor_swapchain_destroy(struct xrt_swapchain *xsc)
 static xrt_result_t
 ipc_compositor_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns, uint32_t index)
 {
-	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
-	struct ipc_client_compositor *icc = ics->icc;
-	xrt_result_t xret;
-
-	xret = ipc_call_swapchain_wait_image(icc->ipc_c, ics->id, timeout_ns, index);
-	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_wait_image");
+	/*
+	 * The service swapchain only blocks here while the image use count is
+	 * raised with xrt_swapchain_inc_image_use, which the service does not
+	 * do, the acquire order keeps the app away from images the compositor
+	 * is reading. So there is no need for a round trip here.
+	 *
+	 * @todo Export the use count through shared memory if the service
+	 *       starts tracking image use.
+	 */
+	return XRT_SUCCESS;
 }
 
 static xrt_result_t
 ipc_compositor_swapchain_acquire_image(struct xrt_swapchain *xsc, uint32_t *out_index)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
-	struct ipc_client_compositor *icc = ics->icc;
-	xrt_result_t xret;
 
-	xret = ipc_call_swapchain_acquire_image(icc->ipc_c, ics->id, out_index);
-	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_acquire_image");
+	// Returns negative on empty fifo.
+	if (u_index_fifo_pop(&ics->fifo, out_index) < 0) {
+		return XRT_ERROR_NO_IMAGE_AVAILABLE;
+	}
+
+	return XRT_SUCCESS;
 }
 
 static xrt_result_t
 ipc_compositor_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
-	struct ipc_client_compositor *icc = ics->icc;
-	xrt_result_t xret;
 
-	xret = ipc_call_swapchain_release_image(icc->ipc_c, ics->id, index);
-	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_release_image");
+	// The service gets the released index with the layers.
+	if (u_index_fifo_push(&ics->fifo, index) < 0) {
+		return XRT_ERROR_NO_IMAGE_AVAILABLE;
+	}
+
+	return XRT_SUCCESS;
+}
+
+static void
+swapchain_prime_fifo(struct ipc_client_swapchain *ics, uint32_t image_count)
+{
+	for (uint32_t i = 0; i < image_count; i++) {
+		u_index_fifo_push(&ics->fifo, i);
+	}
 }
 
 
@@ -278,6 +301,7 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	uint32_t image_count;
 	uint64_t size;
 	bool use_dedicated_allocation;
+	uint32_t row_pitch;
 
 	xret = ipc_call_swapchain_create( //
 	    icc->ipc_c,                   // connection
@@ -286,6 +310,7 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	    &image_count,                 // out
 	    &size,                        // out
 	    &use_dedicated_allocation,    // out
+	    &row_pitch,                   // out
 	    remote_handles,               // handles
 	    XRT_MAX_SWAPCHAIN_IMAGES);    // handles
 	IPC_CHK_AND_RET(icc->ipc_c, xret, "ipc_call_swapchain_create");
@@ -300,11 +325,13 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	ics->base.limited_unique_id = u_limited_unique_id_get();
 	ics->icc = icc;
 	ics->id = handle;
+	swapchain_prime_fifo(ics, image_count);
 
 	for (uint32_t i = 0; i < image_count; i++) {
 		ics->base.images[i].handle = remote_handles[i];
 		ics->base.images[i].size = size;
 		ics->base.images[i].use_dedicated_allocation = use_dedicated_allocation;
+		ics->base.images[i].row_pitch = row_pitch;
 	}
 
 	*out_xsc = &ics->base.base;
@@ -357,6 +384,7 @@ swapchain_server_import(struct ipc_client_compositor *icc,
 	ics->base.limited_unique_id = u_limited_unique_id_get();
 	ics->icc = icc;
 	ics->id = id;
+	swapchain_prime_fifo(ics, image_count);
 
 	// The handles were copied in the IPC call so we can reuse them here.
 	for (uint32_t i = 0; i < image_count; i++) {
@@ -543,7 +571,7 @@ ipc_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_fra
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 
 	slot->data = *data;
 
@@ -562,7 +590,7 @@ ipc_compositor_layer_stereo_projection(struct xrt_compositor *xc,
 	assert(data->type == XRT_LAYER_STEREO_PROJECTION);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	struct ipc_client_swapchain *l = ipc_client_swapchain(l_xsc);
 	struct ipc_client_swapchain *r = ipc_client_swapchain(r_xsc);
@@ -594,7 +622,7 @@ ipc_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 	assert(data->type == XRT_LAYER_STEREO_PROJECTION_DEPTH);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	struct ipc_client_swapchain *l = ipc_client_swapchain(l_xsc);
 	struct ipc_client_swapchain *r = ipc_client_swapchain(r_xsc);
@@ -626,7 +654,7 @@ handle_layer(struct xrt_compositor *xc,
 	assert(data->type == type);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
 
@@ -697,7 +725,7 @@ ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_
 	bool valid_sync = xrt_graphics_sync_handle_is_valid(sync_handle);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
@@ -736,7 +764,7 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	xrt_result_t xret;
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ism)[icc->layers.slot_id];
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
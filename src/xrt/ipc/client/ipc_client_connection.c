@@ -27,7 +27,9 @@
 #include "util/u_system_helpers.h"
 
 #include "shared/ipc_utils.h"
+#include "shared/ipc_shmem.h"
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_command_ring.h"
 #include "client/ipc_client_connection.h"
 
 #include "ipc_client_generated.h"
@@ -56,6 +58,18 @@
 #endif // XRT_OS_ANDROID
 
 DEBUG_GET_ONCE_BOOL_OPTION(ipc_ignore_version, "IPC_IGNORE_VERSION", false)
+/*
+ * On Android every cross process wakeup is expensive and the headsets are
+ * often CPU bound, so there the frame loop goes over the command ring unless
+ * turned off, the binder connection is only used to get the socket.
+ */
+#ifdef XRT_OS_ANDROID
+#define IPC_COMMAND_RING_DEFAULT true
+#else
+#define IPC_COMMAND_RING_DEFAULT false
+#endif
+
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_command_ring, "IPC_COMMAND_RING", IPC_COMMAND_RING_DEFAULT)
 
 #ifdef XRT_OS_ANDROID
 
@@ -263,27 +277,47 @@ ipc_client_setup_shm(struct ipc_connection *ipc_c)
 	}
 
 	/*
-	 * Now map it.
+	 * Map just the header first, it says how big the whole thing is.
 	 */
 
-	const size_t size = sizeof(struct ipc_shared_memory);
+	struct ipc_shared_memory *ism = NULL;
+	xret = ipc_shmem_map(ipc_c->ism_handle, sizeof(struct ipc_shared_memory), (void **)&ism);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ipc_c, "Failed to mmap shm!");
+		return xret;
+	}
 
-#ifdef XRT_OS_WINDOWS
-	DWORD access = FILE_MAP_READ | FILE_MAP_WRITE;
+	const uint32_t version = ism->layout.version;
+	const size_t size = ism->layout.size;
 
-	ipc_c->ism = MapViewOfFile(ipc_c->ism_handle, access, 0, 0, size);
-#else
-	const int flags = MAP_SHARED;
-	const int access = PROT_READ | PROT_WRITE;
+	if (version != IPC_SHARED_MEMORY_LAYOUT_VERSION) {
+		IPC_ERROR(ipc_c, "Shared memory layout %u does not match ours %u, client %s and service %s", version,
+		          IPC_SHARED_MEMORY_LAYOUT_VERSION, u_git_tag, ism->u_git_tag);
+		ipc_shmem_unmap((void **)&ism, sizeof(struct ipc_shared_memory));
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
-	ipc_c->ism = mmap(NULL, size, access, flags, ipc_c->ism_handle, 0);
-#endif
+	ipc_shmem_unmap((void **)&ism, sizeof(struct ipc_shared_memory));
+
+	/*
+	 * Now map all of it.
+	 */
 
-	if (ipc_c->ism == NULL) {
+	xret = ipc_shmem_map(ipc_c->ism_handle, size, (void **)&ism);
+	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(ipc_c, "Failed to mmap shm!");
+		return xret;
+	}
+
+	if (!ipc_shared_memory_layout_is_valid(&ism->layout, size)) {
+		IPC_ERROR(ipc_c, "Invalid shared memory layout!");
+		ipc_shmem_unmap((void **)&ism, size);
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	ipc_c->ism = ism;
+	ipc_c->ism_size = size;
+
 	return XRT_SUCCESS;
 }
 
@@ -307,6 +341,55 @@ ipc_client_check_git_tag(struct ipc_connection *ipc_c)
 	return XRT_SUCCESS;
 }
 
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)
+static void
+ipc_client_setup_command_ring(struct ipc_connection *ipc_c)
+{
+	xrt_shmem_handle_t handles[IPC_COMMAND_RING_HANDLE_COUNT];
+	void *map = NULL;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(handles); i++) {
+		handles[i] = XRT_SHMEM_HANDLE_INVALID;
+	}
+
+	xrt_result_t xret = ipc_call_instance_get_command_ring(ipc_c, handles, ARRAY_SIZE(handles));
+	if (xret != XRT_SUCCESS) {
+		IPC_WARN(ipc_c, "Service didn't give us a command ring, staying on the socket.");
+		return;
+	}
+
+	xret = ipc_shmem_map(handles[0], sizeof(struct ipc_command_ring), &map);
+
+	// The mapping keeps the memory alive.
+#ifdef XRT_OS_WINDOWS
+	CloseHandle(handles[0]);
+
+	// The events are owned by the channel from here on, closed with it.
+	for (uint32_t i = 0; i < IPC_COMMAND_RING_EVENT_COUNT; i++) {
+		ipc_c->imc.ring_events[i] = handles[1 + i];
+	}
+#else
+	close(handles[0]);
+#endif
+
+	if (xret != XRT_SUCCESS) {
+		/*
+		 * The service has already switched this connection to the ring,
+		 * so the socket can't be used for commands anymore, disconnect.
+		 */
+		IPC_ERROR(ipc_c, "Failed to map command ring, closing connection!");
+		ipc_message_channel_close(&ipc_c->imc);
+		return;
+	}
+
+	// Everything after the reply goes over the ring, from both sides.
+	ipc_c->imc.ring = (struct ipc_command_ring *)map;
+	ipc_c->imc.ring_is_server = false;
+
+	IPC_DEBUG(ipc_c, "Using shared memory command ring.");
+}
+#endif
+
 static xrt_result_t
 ipc_client_describe_client(struct ipc_connection *ipc_c, const struct xrt_instance_info *i_info)
 {
@@ -384,6 +467,13 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 		goto err_fini; // Already logged.
 	}
 
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)
+	// Optional, must be done before any other threads uses the connection.
+	if (debug_get_bool_option_ipc_command_ring()) {
+		ipc_client_setup_command_ring(ipc_c);
+	}
+#endif
+
 	// Do this last.
 	xret = ipc_client_describe_client(ipc_c, i_info);
 	if (xret != XRT_SUCCESS) {
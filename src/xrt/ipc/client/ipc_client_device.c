@@ -12,13 +12,19 @@
 #include "os/os_time.h"
 
 #include "math/m_api.h"
+#include "math/m_space.h"
+#include "math/m_predict.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
+#include "util/u_atomic.h"
+#include "util/u_time.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
+#include "util/u_seqlock.h"
 
 #include "client/ipc_client.h"
+#include "shared/ipc_hand_packing.h"
 #include "ipc_client_generated.h"
 
 #include <math.h>
@@ -43,6 +49,244 @@
  */
 typedef struct ipc_client_xdev ipc_client_device_t;
 
+DEBUG_GET_ONCE_BOOL_OPTION(shared_poses, "IPC_CLIENT_SHARED_POSES", true)
+/*!
+ * How far past the newest shared sample the client predicts by itself, using
+ * the velocity of that sample. Requests further out than this go to the
+ * service, zero sends any request past the newest sample to the service.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(shared_pose_max_prediction_ms, "IPC_CLIENT_SHARED_POSE_MAX_PREDICTION_MS", 100)
+DEBUG_GET_ONCE_BOOL_OPTION(shared_inputs, "IPC_CLIENT_SHARED_INPUTS", true)
+DEBUG_GET_ONCE_BOOL_OPTION(packed_hands, "IPC_CLIENT_PACKED_HANDS", true)
+
+
+/*
+ *
+ * Shared pose functions.
+ *
+ */
+
+static struct ipc_shared_pose_ring *
+find_shared_pose_ring(struct ipc_client_xdev *icx, enum xrt_input_name name)
+{
+	struct ipc_shared_device_poses *isdp = &ipc_shm_device_poses(icx->ipc_c->ism)[icx->device_id];
+
+	for (uint32_t i = 0; i < isdp->ring_count; i++) {
+		if (isdp->rings[i].name == name) {
+			return &isdp->rings[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool
+is_input_active(struct ipc_client_xdev *icx, enum xrt_input_name name)
+{
+	for (uint32_t i = 0; i < icx->base.input_count; i++) {
+		if (icx->base.inputs[i].name == name) {
+			return icx->base.inputs[i].active;
+		}
+	}
+
+	return false;
+}
+
+bool
+ipc_client_xdev_get_shared_tracked_pose(struct ipc_client_xdev *icx,
+                                        enum xrt_input_name name,
+                                        uint64_t at_timestamp_ns,
+                                        struct xrt_space_relation *out_relation)
+{
+	const uint64_t period_ns = icx->ipc_c->ism->pose_publish_period_ns;
+	if (period_ns == 0 || !debug_get_bool_option_shared_poses()) {
+		return false;
+	}
+
+	struct ipc_shared_pose_ring *ring = find_shared_pose_ring(icx, name);
+	if (ring == NULL) {
+		return false;
+	}
+
+	// Let the service deal with error reporting of inactive inputs.
+	if (!is_input_active(icx, name)) {
+		return false;
+	}
+
+	/*
+	 * Keep the service sampling this ring, it stops when no client reads
+	 * it. Only write it now and then so the cache line isn't bounced.
+	 */
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (now_ns > u_atomic_u64_load_acquire(&ring->last_read_ns) + period_ns) {
+		u_atomic_u64_store_release(&ring->last_read_ns, now_ns);
+	}
+
+	// Copy out a consistent snapshot of the ring.
+	struct ipc_shared_pose_sample samples[IPC_SHARED_POSE_RING_SIZE];
+	uint64_t sample_count;
+	uint32_t seq;
+	do {
+		seq = u_seqlock_read_begin(&ring->lock);
+		sample_count = ring->sample_count;
+		memcpy(samples, ring->samples, sizeof(samples));
+	} while (u_seqlock_read_retry(&ring->lock, seq));
+
+	if (sample_count == 0) {
+		return false;
+	}
+
+	const uint64_t valid_count = MIN(sample_count, IPC_SHARED_POSE_RING_SIZE);
+	const uint64_t first = sample_count - valid_count;
+#define SAMPLE(INDEX) (&samples[(first + (INDEX)) % IPC_SHARED_POSE_RING_SIZE])
+
+	struct ipc_shared_pose_sample *oldest = SAMPLE(0);
+	struct ipc_shared_pose_sample *newest = SAMPLE(valid_count - 1);
+
+	// The publisher has stopped, stalled or not picked up the ring yet.
+	if (now_ns > newest->timestamp_ns + period_ns * 4) {
+		return false;
+	}
+
+	// Too old for the window.
+	if (at_timestamp_ns < oldest->timestamp_ns) {
+		return false;
+	}
+
+	// Exactly the newest sample, nothing to interpolate or predict.
+	if (at_timestamp_ns == newest->timestamp_ns) {
+		*out_relation = newest->relation;
+		return true;
+	}
+
+	// Predict forward from the newest sample, only if enabled and within limits.
+	if (at_timestamp_ns > newest->timestamp_ns) {
+		long max_prediction_ms = debug_get_num_option_shared_pose_max_prediction_ms();
+		if (max_prediction_ms <= 0) {
+			return false;
+		}
+
+		uint64_t max_prediction_ns = (uint64_t)max_prediction_ms * U_TIME_1MS_IN_NS;
+		uint64_t diff_ns = at_timestamp_ns - newest->timestamp_ns;
+		if (diff_ns > max_prediction_ns) {
+			return false;
+		}
+
+		m_predict_relation(&newest->relation, time_ns_to_s((time_duration_ns)diff_ns), out_relation);
+		return true;
+	}
+
+	// Interpolate between the two samples around the timestamp, searching from the newest.
+	for (uint64_t i = valid_count - 1; i > 0; i--) {
+		struct ipc_shared_pose_sample *before = SAMPLE(i - 1);
+		struct ipc_shared_pose_sample *after = SAMPLE(i);
+
+		if (before->timestamp_ns > at_timestamp_ns) {
+			continue;
+		}
+
+		uint64_t diff_before = at_timestamp_ns - before->timestamp_ns;
+		uint64_t diff_total = after->timestamp_ns - before->timestamp_ns;
+		float t = (float)diff_before / (float)diff_total;
+
+		enum xrt_space_relation_flags flags =
+		    (enum xrt_space_relation_flags)(before->relation.relation_flags & after->relation.relation_flags);
+
+		U_ZERO(out_relation);
+		m_space_relation_interpolate(&before->relation, &after->relation, t, flags, out_relation);
+		return true;
+	}
+
+#undef SAMPLE
+
+	return false;
+}
+
+
+/*
+ *
+ * Shared input functions.
+ *
+ */
+
+static bool
+try_get_shared_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+
+	// Published by the same thread as the poses.
+	if (ism->pose_publish_period_ns == 0 || !debug_get_bool_option_shared_inputs()) {
+		return false;
+	}
+
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[icx->device_id];
+	struct ipc_shared_device_inputs *isdi = &ipc_shm_device_inputs(ism)[icx->device_id];
+	const struct xrt_input *src = &ipc_shm_published_inputs(ism)[isdev->first_input_index];
+	const size_t size = sizeof(struct xrt_input) * icx->base.input_count;
+
+	bool valid;
+	bool copied;
+	uint64_t sequence;
+	uint32_t seq;
+	do {
+		seq = u_seqlock_read_begin(&isdi->lock);
+		valid = isdi->valid;
+		sequence = isdi->sequence;
+		copied = false;
+
+		// Nothing changed since the last copy, keep what we have.
+		if (!valid || sequence == icx->input_sequence) {
+			continue;
+		}
+
+		memcpy(icx->base.inputs, src, size);
+		copied = true;
+	} while (u_seqlock_read_retry(&isdi->lock, seq));
+
+	// Only a copy that wasn't torn may claim to be this sequence.
+	if (copied) {
+		icx->input_sequence = sequence;
+	}
+
+	return valid;
+}
+
+void
+ipc_client_xdev_init_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[icx->device_id];
+
+	assert(isdev->input_count > 0);
+	icx->base.inputs = U_TYPED_ARRAY_CALLOC(struct xrt_input, isdev->input_count);
+	icx->base.input_count = isdev->input_count;
+	icx->input_sequence = 0;
+
+	memcpy(icx->base.inputs, &ipc_shm_inputs(ism)[isdev->first_input_index],
+	       sizeof(struct xrt_input) * isdev->input_count);
+}
+
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx)
+{
+	// Fast path, no round trip needed.
+	if (try_get_shared_inputs(icx)) {
+		return;
+	}
+
+	struct ipc_connection *ipc_c = icx->ipc_c;
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ipc_c->ism)[icx->device_id];
+
+	xrt_result_t xret = ipc_call_device_update_input(ipc_c, icx->device_id);
+	IPC_CHK_ONLY_PRINT(ipc_c, xret, "ipc_call_device_update_input");
+
+	memcpy(icx->base.inputs, &ipc_shm_inputs(ipc_c->ism)[isdev->first_input_index],
+	       sizeof(struct xrt_input) * icx->base.input_count);
+
+	// What we have is no longer what was published.
+	icx->input_sequence = 0;
+}
+
 
 /*
  *
@@ -64,8 +308,11 @@ ipc_client_device_destroy(struct xrt_device *xdev)
 	// Remove the variable tracking.
 	u_var_remove_root(icd);
 
-	// We do not own these, so don't free them.
+	// We own the inputs.
+	free(icd->base.inputs);
 	icd->base.inputs = NULL;
+
+	// We do not own these, so don't free them.
 	icd->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -77,8 +324,7 @@ ipc_client_device_update_inputs(struct xrt_device *xdev)
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
-	xrt_result_t xret = ipc_call_device_update_input(icd->ipc_c, icd->device_id);
-	IPC_CHK_ONLY_PRINT(icd->ipc_c, xret, "ipc_call_device_update_input");
+	ipc_client_xdev_update_inputs(icd);
 }
 
 static void
@@ -89,6 +335,11 @@ ipc_client_device_get_tracked_pose(struct xrt_device *xdev,
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
+	// Fast path, no round trip needed.
+	if (ipc_client_xdev_get_shared_tracked_pose(icd, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xrt_result_t xret = ipc_call_device_get_tracked_pose( //
 	    icd->ipc_c,                                       //
 	    icd->device_id,                                   //
@@ -107,6 +358,25 @@ ipc_client_device_get_hand_tracking(struct xrt_device *xdev,
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
+	// A third of the size, apps and controller emulation poll both hands every frame.
+	if (debug_get_bool_option_packed_hands()) {
+		struct ipc_packed_hand_joint_set packed;
+
+		xrt_result_t xret = ipc_call_device_get_hand_tracking_packed( //
+		    icd->ipc_c,                                               //
+		    icd->device_id,                                           //
+		    name,                                                     //
+		    at_timestamp_ns,                                          //
+		    &packed,                                                  //
+		    out_timestamp_ns);                                        //
+		IPC_CHK_ONLY_PRINT(icd->ipc_c, xret, "ipc_call_device_get_hand_tracking_packed");
+
+		if (xret == XRT_SUCCESS) {
+			ipc_unpack_hand_joint_set(&packed, out_value);
+		}
+		return;
+	}
+
 	xrt_result_t xret = ipc_call_device_get_hand_tracking( //
 	    icd->ipc_c,                                        //
 	    icd->device_id,                                    //
@@ -157,7 +427,7 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 {
 	// Helpers.
 	struct ipc_shared_memory *ism = ipc_c->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[device_id];
 
 	// Allocate and setup the basics.
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
@@ -180,15 +450,13 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	snprintf(icd->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(icd->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
-	assert(isdev->input_count > 0);
-	icd->base.inputs = &ism->inputs[isdev->first_input_index];
-	icd->base.input_count = isdev->input_count;
+	// Setup inputs, a copy of the shared memory.
+	ipc_client_xdev_init_inputs(icd);
 
 	// Setup outputs, if any point directly into the shared memory.
 	icd->base.output_count = isdev->output_count;
 	if (isdev->output_count > 0) {
-		icd->base.outputs = &ism->outputs[isdev->first_output_index];
+		icd->base.outputs = &ipc_shm_outputs(ism)[isdev->first_output_index];
 	} else {
 		icd->base.outputs = NULL;
 	}
@@ -202,15 +470,15 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	for (size_t i = 0; i < isdev->binding_profile_count; i++) {
 		struct xrt_binding_profile *xbp = &icd->base.binding_profiles[i];
 		struct ipc_shared_binding_profile *isbp =
-		    &ism->binding_profiles[isdev->first_binding_profile_index + i];
+		    &ipc_shm_binding_profiles(ism)[isdev->first_binding_profile_index + i];
 
 		xbp->name = isbp->name;
 		if (isbp->input_count > 0) {
-			xbp->inputs = &ism->input_pairs[isbp->first_input_index];
+			xbp->inputs = &ipc_shm_input_pairs(ism)[isbp->first_input_index];
 			xbp->input_count = isbp->input_count;
 		}
 		if (isbp->output_count > 0) {
-			xbp->outputs = &ism->output_pairs[isbp->first_output_index];
+			xbp->outputs = &ipc_shm_output_pairs(ism)[isbp->first_output_index];
 			xbp->output_count = isbp->output_count;
 		}
 	}
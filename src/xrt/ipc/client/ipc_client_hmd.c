@@ -131,8 +131,11 @@ ipc_client_hmd_destroy(struct xrt_device *xdev)
 	// Remove the variable tracking.
 	u_var_remove_root(ich);
 
-	// We do not own these, so don't free them.
+	// We own the inputs.
+	free(ich->base.inputs);
 	ich->base.inputs = NULL;
+
+	// We do not own these, so don't free them.
 	ich->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -144,8 +147,7 @@ ipc_client_hmd_update_inputs(struct xrt_device *xdev)
 {
 	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
 
-	xrt_result_t xret = ipc_call_device_update_input(ich->ipc_c, ich->device_id);
-	IPC_CHK_ONLY_PRINT(ich->ipc_c, xret, "ipc_call_device_update_input");
+	ipc_client_xdev_update_inputs(ich);
 }
 
 static void
@@ -157,6 +159,11 @@ ipc_client_hmd_get_tracked_pose(struct xrt_device *xdev,
 	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
 	xrt_result_t xret;
 
+	// Fast path, no round trip needed.
+	if (ipc_client_xdev_get_shared_tracked_pose(ich, name, at_timestamp_ns, out_relation)) {
+		return;
+	}
+
 	xret = ipc_call_device_get_tracked_pose( //
 	    ich->ipc_c,                          //
 	    ich->device_id,                      //
@@ -300,7 +307,7 @@ struct xrt_device *
 ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id)
 {
 	struct ipc_shared_memory *ism = ipc_c->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[device_id];
 
 
 
@@ -325,10 +332,8 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 	snprintf(ich->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(ich->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
-	assert(isdev->input_count > 0);
-	ich->base.inputs = &ism->inputs[isdev->first_input_index];
-	ich->base.input_count = isdev->input_count;
+	// Setup inputs, a copy of the shared memory.
+	ipc_client_xdev_init_inputs(ich);
 
 #if 0
 	// Setup info.
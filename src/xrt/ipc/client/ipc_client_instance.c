@@ -234,7 +234,7 @@ ipc_client_instance_destroy(struct xrt_instance *xinst)
 	timeEndPeriod(1);
 #endif
 
-	ipc_shmem_destroy(&ii->ipc_c.ism_handle, (void **)&ii->ipc_c.ism, sizeof(struct ipc_shared_memory));
+	ipc_shmem_destroy(&ii->ipc_c.ism_handle, (void **)&ii->ipc_c.ism, ii->ipc_c.ism_size);
 
 	free(ii);
 }
@@ -278,10 +278,10 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	for (uint32_t i = 0; i < ism->itrack_count; i++) {
 		xtrack = U_TYPED_CALLOC(struct xrt_tracking_origin);
 
-		memcpy(xtrack->name, ism->itracks[i].name, sizeof(xtrack->name));
+		memcpy(xtrack->name, ipc_shm_itracks(ism)[i].name, sizeof(xtrack->name));
 
-		xtrack->type = ism->itracks[i].type;
-		xtrack->offset = ism->itracks[i].offset;
+		xtrack->type = ipc_shm_itracks(ism)[i].type;
+		xtrack->offset = ipc_shm_itracks(ism)[i].offset;
 		ii->xtracks[count++] = xtrack;
 
 		u_var_add_root(xtrack, "Tracking origin", true);
@@ -294,7 +294,7 @@ ipc_instance_create(struct xrt_instance_info *i_info, struct xrt_instance **out_
 	// Query the server for how many devices it has.
 	count = 0;
 	for (uint32_t i = 0; i < ism->isdev_count; i++) {
-		struct ipc_shared_device *isdev = &ism->isdevs[i];
+		struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[i];
 		xtrack = ii->xtracks[isdev->tracking_origin_index];
 
 		if (isdev->name == XRT_DEVICE_GENERIC_HMD) {
@@ -10,6 +10,8 @@
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_space.h"
 
+#include "client/ipc_client_connection.h"
+
 #include "ipc_client_generated.h"
 
 
@@ -150,6 +152,92 @@ locate_space(struct xrt_space_overseer *xso,
 	IPC_CHK_ALWAYS_RET(icspo->ipc_c, xret, "ipc_call_space_locate_space");
 }
 
+static xrt_result_t
+call_locate_spaces_locked(struct ipc_connection *ipc_c,
+                          uint32_t base_space_id,
+                          const struct xrt_pose *base_offset,
+                          uint64_t at_timestamp_ns,
+                          const uint32_t *space_ids,
+                          uint32_t space_count,
+                          const struct xrt_pose *offsets,
+                          struct xrt_space_relation *out_relations)
+{
+	xrt_result_t xret;
+
+	xret = ipc_send_space_locate_spaces_locked( //
+	    ipc_c,                                  //
+	    base_space_id,                          //
+	    base_offset,                            //
+	    at_timestamp_ns,                        //
+	    space_count);                           //
+	IPC_CHK_AND_RET(ipc_c, xret, "ipc_send_space_locate_spaces_locked");
+
+	xret = ipc_send(&ipc_c->imc, space_ids, sizeof(uint32_t) * space_count);
+	IPC_CHK_AND_RET(ipc_c, xret, "ipc_send(1)");
+
+	xret = ipc_send(&ipc_c->imc, offsets, sizeof(struct xrt_pose) * space_count);
+	IPC_CHK_AND_RET(ipc_c, xret, "ipc_send(2)");
+
+	// The relations are only sent if the call succeeded.
+	xret = ipc_receive_space_locate_spaces_locked(ipc_c);
+	IPC_CHK_AND_RET(ipc_c, xret, "ipc_receive_space_locate_spaces_locked");
+
+	// We can read directly to the output variables.
+	xret = ipc_receive(&ipc_c->imc, out_relations, sizeof(struct xrt_space_relation) * space_count);
+	IPC_CHK_AND_RET(ipc_c, xret, "ipc_receive");
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct ipc_client_space_overseer *icspo = ipc_client_space_overseer(xso);
+	struct ipc_connection *ipc_c = icspo->ipc_c;
+	xrt_result_t xret = XRT_SUCCESS;
+
+	struct ipc_client_space *icsp_base_space = ipc_client_space(base_space);
+
+	ipc_client_connection_lock(ipc_c);
+
+	// Batch the spaces, each batch is a single round trip.
+	for (uint32_t first = 0; first < space_count; first += IPC_MAX_LOCATE_SPACES) {
+		uint32_t count = space_count - first;
+		if (count > IPC_MAX_LOCATE_SPACES) {
+			count = IPC_MAX_LOCATE_SPACES;
+		}
+		uint32_t space_ids[IPC_MAX_LOCATE_SPACES];
+
+		for (uint32_t i = 0; i < count; i++) {
+			space_ids[i] = ipc_client_space(spaces[first + i])->id;
+		}
+
+		xret = call_locate_spaces_locked( //
+		    ipc_c,                        //
+		    icsp_base_space->id,          //
+		    base_offset,                  //
+		    at_timestamp_ns,              //
+		    space_ids,                    //
+		    count,                        //
+		    &offsets[first],              //
+		    &out_relations[first]);       //
+		if (xret != XRT_SUCCESS) {
+			break;
+		}
+	}
+
+	ipc_client_connection_unlock(ipc_c);
+
+	return xret;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -265,6 +353,7 @@ ipc_client_space_overseer_create(struct ipc_connection *ipc_c)
 	icspo->base.create_offset_space = create_offset_space;
 	icspo->base.create_pose_space = create_pose_space;
 	icspo->base.locate_space = locate_space;
+	icspo->base.locate_spaces = locate_spaces;
 	icspo->base.locate_device = locate_device;
 	icspo->base.ref_space_inc = ref_space_inc;
 	icspo->base.ref_space_dec = ref_space_dec;
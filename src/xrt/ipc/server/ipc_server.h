@@ -51,6 +51,7 @@ extern "C" {
 #define IPC_MAX_CLIENT_SEMAPHORES 8
 #define IPC_MAX_CLIENT_SWAPCHAINS 32
 #define IPC_MAX_CLIENT_SPACES 128
+#define IPC_MAX_IO_THREADS 8
 
 struct xrt_instance;
 struct xrt_compositor;
@@ -126,6 +127,29 @@ struct ipc_client_state
 	//! Socket fd used for client comms
 	struct ipc_message_channel imc;
 
+	/*!
+	 * Command ring created by instance_get_command_ring, attached to
+	 * @ref imc once the reply has been sent over the socket.
+	 */
+	struct ipc_command_ring *pending_command_ring;
+
+	//! Handle of @ref pending_command_ring, closed when it is attached.
+	xrt_shmem_handle_t pending_command_ring_handle;
+
+#ifdef XRT_OS_WINDOWS
+	//! Events of @ref pending_command_ring, moved to @ref imc when it is attached.
+	HANDLE pending_command_ring_events[IPC_COMMAND_RING_EVENT_COUNT];
+#else
+	//! Socket @ref ipc_system_event are pushed on, -1 if not subscribed, guarded by the global state lock.
+	int event_fd;
+
+	//! Other end of @ref event_fd, closed once the reply carrying it has been sent, -1 if none.
+	int pending_event_fd;
+
+	//! Events were dropped, the next one pushed is preceded by a lost event.
+	bool event_lost;
+#endif
+
 	struct ipc_app_state client_state;
 
 	int server_thread_index;
@@ -146,7 +170,6 @@ struct ipc_thread
 	volatile struct ipc_client_state ics;
 };
 
-
 /*!
  *
  */
@@ -175,6 +198,9 @@ struct ipc_server_mainloop
 #if defined(XRT_OS_ANDROID) || defined(XRT_OS_LINUX) || defined(XRT_DOXYGEN)
 	//! For waiting on various events in the main thread.
 	int epoll_fd;
+
+	//! Eventfd used to wake the main thread up from @ref epoll_fd.
+	int wake_fd;
 #endif
 
 #if defined(XRT_OS_ANDROID) || defined(XRT_DOXYGEN)
@@ -271,6 +297,9 @@ struct ipc_server_mainloop
 	//! Name of the Pipe that we accept connections on.
 	char *pipe_name;
 
+	//! Event used to wake the main thread up.
+	HANDLE wake_event;
+
 	/*! @} */
 
 #define XRT_IPC_GOT_IMPL
@@ -300,12 +329,24 @@ ipc_server_mainloop_init(struct ipc_server_mainloop *ml);
 /*!
  * @brief Poll the mainloop.
  *
+ * Blocks until there is something to handle, like a new client, or until
+ * woken up by @ref ipc_server_mainloop_wake.
+ *
  * Any errors are signalled by calling ipc_server_handle_failure()
  * @public @memberof ipc_server_mainloop
  */
 void
 ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml);
 
+/*!
+ * Wake the mainloop up if it's blocked in @ref ipc_server_mainloop_poll,
+ * safe to call from any thread.
+ *
+ * @public @memberof ipc_server_mainloop
+ */
+void
+ipc_server_mainloop_wake(struct ipc_server_mainloop *ml);
+
 /*!
  * Main IPC object for the server.
  *
@@ -337,6 +378,11 @@ struct ipc_server
 
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
+	//! Size of the mapping of @ref ism, depends on the devices.
+	size_t ism_size;
+
+	//! Thread that samples device poses into the shared memory.
+	struct os_thread_helper pose_publisher;
 
 	struct ipc_server_mainloop ml;
 
@@ -350,6 +396,47 @@ struct ipc_server
 
 	struct ipc_thread threads[IPC_MAX_CLIENTS];
 
+	/*!
+	 * Optional pool of threads that serves all clients from a single epoll
+	 * set, used instead of one thread per client when IPC_IO_THREADS is set.
+	 */
+	struct
+	{
+		//! Number of started IO threads, zero when not used.
+		uint32_t thread_count;
+
+		//! All client sockets, armed one shot so only one thread serves a client at a time.
+		int epoll_fd;
+
+		struct os_thread threads[IPC_MAX_IO_THREADS];
+
+		//! Serves the frame critical commands in @p frame_queue, as many as @p threads.
+		struct os_thread frame_threads[IPC_MAX_IO_THREADS];
+
+		//! Protects the frame queue fields below.
+		struct os_mutex frame_lock;
+
+		//! Signalled when a client is added to @p frame_queue or the pool stops.
+		struct os_cond frame_cond;
+
+		/*!
+		 * Clients with a frame critical command waiting, oldest first. A
+		 * client is on it at most once since its socket is only re-armed
+		 * once the command has been served, which keeps the commands of
+		 * each client in order.
+		 */
+		volatile struct ipc_client_state *frame_queue[IPC_MAX_CLIENTS];
+
+		//! Index of the oldest entry in @p frame_queue.
+		uint32_t frame_queue_first;
+
+		//! Number of valid entries in @p frame_queue.
+		uint32_t frame_queue_count;
+
+		//! Are the frame threads supposed to run.
+		bool frame_running;
+	} io_pool;
+
 	volatile uint32_t current_slot_index;
 
 	//! Generator for IDs.
@@ -360,6 +447,9 @@ struct ipc_server
 		int active_client_index;
 		int last_active_client_index;
 
+		//! Generation of the roles last seen, to send out events when they change.
+		uint64_t roles_generation_id;
+
 		struct os_mutex lock;
 	} global_state;
 };
@@ -373,6 +463,23 @@ struct ipc_server
 xrt_result_t
 ipc_server_get_client_app_state(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias);
 
+/*!
+ * Get the state of all clients at once, the roles are filled in by the caller.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_get_system_snapshot(struct ipc_server *s, struct ipc_system_snapshot *out_snapshot);
+
+/*!
+ * Push an event to all clients subscribed to system events, never blocks,
+ * events are dropped for subscribers that don't keep up.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_push_system_event(struct ipc_server *s, enum ipc_system_event_type type, uint32_t client_id);
+
 /*!
  * Set the new active client.
  *
@@ -421,6 +528,35 @@ ipc_server_update_state(struct ipc_server *s);
 void *
 ipc_server_client_thread(void *_ics);
 
+/*!
+ * Start the IO thread pool, after this clients are added to it with
+ * @ref ipc_server_io_pool_add_client instead of getting their own thread.
+ * Commands that are in the frame loop are served by a separate thread.
+ *
+ * Not supported on Windows, where it leaves the server using one thread per
+ * client. The shared memory command ring is not offered with the pool.
+ *
+ * @ingroup ipc_server
+ */
+int
+ipc_server_io_pool_start(struct ipc_server *s, uint32_t thread_count);
+
+/*!
+ * Stops the IO thread pool and shuts down any clients still on it.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_io_pool_stop(struct ipc_server *s);
+
+/*!
+ * Add a newly connected client to the IO thread pool.
+ *
+ * @ingroup ipc_server
+ */
+int
+ipc_server_io_pool_add_client(struct ipc_server *s, volatile struct ipc_client_state *ics);
+
 /*!
  * This destroys the native compositor for this client and any extra objects
  * created from it, like all of the swapchains.
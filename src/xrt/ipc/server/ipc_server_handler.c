@@ -15,6 +15,9 @@
 #include "util/u_visibility_mask.h"
 #include "util/u_trace_marker.h"
 
+#include "shared/ipc_shmem.h"
+#include "shared/ipc_command_ring.h"
+#include "shared/ipc_hand_packing.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -22,6 +25,12 @@
 #include <unistd.h>
 #endif
 
+#ifndef XRT_OS_WINDOWS
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
 
 /*
  *
@@ -176,6 +185,77 @@ ipc_handle_instance_get_shm_fd(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_instance_get_command_ring(volatile struct ipc_client_state *ics,
+                                     uint32_t max_handle_capacity,
+                                     xrt_shmem_handle_t *out_handles,
+                                     uint32_t *out_handle_count)
+{
+	IPC_TRACE_MARKER();
+
+	assert(max_handle_capacity >= IPC_COMMAND_RING_HANDLE_COUNT);
+
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)
+	struct ipc_server *s = ics->server;
+	xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+	void *map = NULL;
+	xrt_result_t xret;
+
+	if (ics->imc.ring != NULL || ics->pending_command_ring != NULL) {
+		IPC_ERROR(s, "Client already has a command ring!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// The IO pool waits on the sockets, the client stays on those.
+	if (s->io_pool.thread_count > 0) {
+		IPC_WARN(s, "Command ring not supported with the IO thread pool!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// The shmem helper uses a fixed name before unlinking it, don't race other clients.
+	os_mutex_lock(&s->global_state.lock);
+	xret = ipc_shmem_create(sizeof(struct ipc_command_ring), &handle, &map);
+	os_mutex_unlock(&s->global_state.lock);
+
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(s, "Failed to create command ring shared memory!");
+		return xret;
+	}
+
+	out_handles[0] = handle;
+
+#ifdef XRT_OS_WINDOWS
+	for (uint32_t i = 0; i < IPC_COMMAND_RING_EVENT_COUNT; i++) {
+		// Auto-reset, each signal wakes the one side sleeping on it.
+		HANDLE event = CreateEventA(NULL, FALSE, FALSE, NULL);
+		if (event == NULL) {
+			IPC_ERROR(s, "Failed to create command ring event!");
+			for (uint32_t k = 0; k < i; k++) {
+				CloseHandle(ics->pending_command_ring_events[k]);
+				ics->pending_command_ring_events[k] = NULL;
+			}
+			ipc_shmem_destroy(&handle, &map, sizeof(struct ipc_command_ring));
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		ics->pending_command_ring_events[i] = event;
+		out_handles[1 + i] = event;
+	}
+#endif
+
+	// Attached by the client loop after the reply with the handles has been sent.
+	ics->pending_command_ring = (struct ipc_command_ring *)map;
+	ics->pending_command_ring_handle = handle;
+
+	*out_handle_count = IPC_COMMAND_RING_HANDLE_COUNT;
+
+	return XRT_SUCCESS;
+#else
+	IPC_WARN(ics->server, "Command ring not supported on this platform!");
+	return XRT_ERROR_IPC_FAILURE;
+#endif
+}
+
 xrt_result_t
 ipc_handle_instance_describe_client(volatile struct ipc_client_state *ics,
                                     const struct ipc_client_description *client_desc)
@@ -209,6 +289,9 @@ ipc_handle_instance_describe_client(volatile struct ipc_client_state *ics,
 	// Log the pretty message.
 	IPC_INFO(ics->server, "%s", sink.buffer);
 
+	// Subscribers now know the name of the client.
+	ipc_server_push_system_event(ics->server, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, ics->client_state.id);
+
 	return XRT_SUCCESS;
 }
 
@@ -482,6 +565,92 @@ ipc_handle_space_locate_space(volatile struct ipc_client_state *ics,
 	    out_relation);                      //
 }
 
+xrt_result_t
+ipc_handle_space_locate_spaces(volatile struct ipc_client_state *ics,
+                               uint32_t base_space_id,
+                               const struct xrt_pose *base_offset,
+                               uint64_t at_timestamp,
+                               uint32_t space_count)
+{
+	IPC_TRACE_MARKER();
+
+	struct ipc_message_channel *imc = (struct ipc_message_channel *)&ics->imc;
+	struct ipc_result_reply reply = XRT_STRUCT_INIT;
+	struct ipc_server *s = ics->server;
+	struct xrt_space_overseer *xso = s->xso;
+	struct xrt_space *base_space = NULL;
+	xrt_result_t xret;
+
+	if (space_count == 0 || space_count > IPC_MAX_LOCATE_SPACES) {
+		// We can't read the arrays that follows, so the stream is broken.
+		IPC_ERROR(s, "Client asked for zero or too many spaces! (%u)", space_count);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	uint32_t space_ids[IPC_MAX_LOCATE_SPACES];
+	struct xrt_pose offsets[IPC_MAX_LOCATE_SPACES];
+	struct xrt_space *spaces[IPC_MAX_LOCATE_SPACES];
+	struct xrt_space_relation relations[IPC_MAX_LOCATE_SPACES];
+
+	// Always read the arrays so the stream stays in sync, even on error.
+	xret = ipc_receive(imc, space_ids, sizeof(uint32_t) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(s, "Failed to receive space ids!");
+		return xret;
+	}
+
+	xret = ipc_receive(imc, offsets, sizeof(struct xrt_pose) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(s, "Failed to receive offsets!");
+		return xret;
+	}
+
+	xret = validate_space_id(ics, base_space_id, &base_space);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Invalid base_space_id!");
+		reply.result = xret;
+		return ipc_send(imc, &reply, sizeof(reply));
+	}
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		xret = validate_space_id(ics, space_ids[i], &spaces[i]);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Invalid space_id! (index %u)", i);
+			reply.result = xret;
+			return ipc_send(imc, &reply, sizeof(reply));
+		}
+	}
+
+	reply.result = xrt_space_overseer_locate_spaces( //
+	    xso,                                         //
+	    base_space,                                  //
+	    base_offset,                                 //
+	    at_timestamp,                                //
+	    spaces,                                      //
+	    space_count,                                 //
+	    offsets,                                     //
+	    relations);                                  //
+
+	xret = ipc_send(imc, &reply, sizeof(reply));
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(s, "Failed to send reply!");
+		return xret;
+	}
+
+	// The client only expects the relations if the locate succeeded.
+	if (reply.result != XRT_SUCCESS) {
+		return XRT_SUCCESS;
+	}
+
+	xret = ipc_send(imc, relations, sizeof(struct xrt_space_relation) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(s, "Failed to send relations!");
+		return xret;
+	}
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_space_locate_device(volatile struct ipc_client_state *ics,
                                uint32_t base_space_id,
@@ -602,7 +771,12 @@ ipc_handle_space_recenter_local_spaces(volatile struct ipc_client_state *ics)
 {
 	struct xrt_space_overseer *xso = ics->server->xso;
 
-	return xrt_space_overseer_recenter_local_spaces(xso);
+	xrt_result_t xret = xrt_space_overseer_recenter_local_spaces(xso);
+	if (xret == XRT_SUCCESS) {
+		ipc_server_push_system_event(ics->server, IPC_SYSTEM_EVENT_LOCAL_SPACES_RECENTERED, 0);
+	}
+
+	return xret;
 }
 
 xrt_result_t
@@ -985,6 +1159,31 @@ _update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc,
 	return true;
 }
 
+static bool
+_copy_layer_slot(volatile struct ipc_client_state *ics, uint32_t slot_id, struct ipc_layer_slot *out_slot)
+{
+	if (slot_id >= ics->server->ism->layout.slots.count) {
+		IPC_ERROR(ics->server, "Invalid slot_id %u!", slot_id);
+		return false;
+	}
+
+	const struct ipc_layer_slot *slot = &ipc_shm_slots(ics->server->ism)[slot_id];
+
+	// Read once, the client can change the shared memory under us.
+	uint32_t layer_count = slot->layer_count;
+	if (layer_count > IPC_MAX_LAYERS) {
+		IPC_ERROR(ics->server, "Too many layers %u!", layer_count);
+		return false;
+	}
+
+	// Only copy the layers in use, the full slot is mostly unused entries.
+	out_slot->data = slot->data;
+	out_slot->layer_count = layer_count;
+	memcpy(out_slot->layers, slot->layers, sizeof(struct ipc_layer_entry) * layer_count);
+
+	return true;
+}
+
 xrt_result_t
 ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
                                  uint32_t slot_id,
@@ -998,8 +1197,6 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 		return XRT_ERROR_IPC_SESSION_NOT_CREATED;
 	}
 
-	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
 	xrt_graphics_sync_handle_t sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	// If we have one or more save the first handle.
@@ -1015,7 +1212,11 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 	}
 
 	// Copy current slot data.
-	struct ipc_layer_slot copy = *slot;
+	struct ipc_layer_slot copy;
+	if (!_copy_layer_slot(ics, slot_id, &copy)) {
+		u_graphics_sync_unref(&sync_handle);
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
 
 	/*
@@ -1066,12 +1267,11 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 
 	struct xrt_compositor_semaphore *xcsem = ics->xcsems[semaphore_id];
 
-	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
-
 	// Copy current slot data.
-	struct ipc_layer_slot copy = *slot;
-
+	struct ipc_layer_slot copy;
+	if (!_copy_layer_slot(ics, slot_id, &copy)) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
 
 
 	/*
@@ -1143,6 +1343,67 @@ ipc_handle_system_get_clients(volatile struct ipc_client_state *_ics, struct ipc
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_system_get_snapshot(volatile struct ipc_client_state *ics, struct ipc_system_snapshot *out_snapshot)
+{
+	struct ipc_server *s = ics->server;
+
+	U_ZERO(out_snapshot);
+
+	ipc_server_get_system_snapshot(s, out_snapshot);
+
+	// Also up the generation the same way as system_devices_get_roles.
+	return ipc_handle_system_devices_get_roles(ics, &out_snapshot->roles);
+}
+
+xrt_result_t
+ipc_handle_system_subscribe_events(volatile struct ipc_client_state *ics,
+                                   uint32_t max_handle_capacity,
+                                   xrt_shmem_handle_t *out_handles,
+                                   uint32_t *out_handle_count)
+{
+	IPC_TRACE_MARKER();
+
+#ifndef XRT_OS_WINDOWS
+	struct ipc_server *s = ics->server;
+
+	assert(max_handle_capacity >= 1);
+
+	if (ics->event_fd >= 0) {
+		IPC_ERROR(s, "Client already subscribed to events!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Packets keep each event whole, the subscriber only reads from its end.
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+		IPC_ERROR(s, "Failed to create event socket: %s", strerror(errno));
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	shutdown(fds[0], SHUT_WR);
+	shutdown(fds[1], SHUT_RD);
+
+	os_mutex_lock(&s->global_state.lock);
+	ics->event_fd = fds[1];
+	ics->event_lost = false;
+	os_mutex_unlock(&s->global_state.lock);
+
+	// Closed by the client loop after the reply with it has been sent.
+	ics->pending_event_fd = fds[0];
+
+	out_handles[0] = fds[0];
+	*out_handle_count = 1;
+
+	IPC_INFO(s, "Client %u subscribed to system events.", ics->client_state.id);
+
+	return XRT_SUCCESS;
+#else
+	IPC_WARN(ics->server, "System events not supported on this platform!");
+	return XRT_ERROR_IPC_FAILURE;
+#endif
+}
+
 xrt_result_t
 ipc_handle_system_get_client_info(volatile struct ipc_client_state *_ics,
                                   uint32_t client_id,
@@ -1216,6 +1477,7 @@ ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
                             uint32_t *out_image_count,
                             uint64_t *out_size,
                             bool *out_use_dedicated_allocation,
+                            uint32_t *out_row_pitch,
                             uint32_t max_handle_capacity,
                             xrt_graphics_buffer_handle_t *out_handles,
                             uint32_t *out_handle_count)
@@ -1260,11 +1522,13 @@ ipc_handle_swapchain_create(volatile struct ipc_client_state *ics,
 	for (size_t i = 1; i < xsc->image_count; i++) {
 		assert(xscn->images[0].size == xscn->images[i].size);
 		assert(xscn->images[0].use_dedicated_allocation == xscn->images[i].use_dedicated_allocation);
+		assert(xscn->images[0].row_pitch == xscn->images[i].row_pitch);
 	}
 
 	// Assuming all images allocated in the same swapchain have the same allocation requirements.
 	*out_size = xscn->images[0].size;
 	*out_use_dedicated_allocation = xscn->images[0].use_dedicated_allocation;
+	*out_row_pitch = xscn->images[0].row_pitch;
 	*out_id = index;
 	*out_image_count = xsc->image_count;
 
@@ -1476,14 +1740,14 @@ ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t i
 	struct ipc_shared_memory *ism = ics->server->ism;
 	struct ipc_device *idev = get_idev(ics, device_id);
 	struct xrt_device *xdev = idev->xdev;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[device_id];
 
 	// Update inputs.
 	xrt_device_update_inputs(xdev);
 
 	// Copy data into the shared memory.
 	struct xrt_input *src = xdev->inputs;
-	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
+	struct xrt_input *dst = &ipc_shm_inputs(ism)[isdev->first_input_index];
 	size_t size = sizeof(struct xrt_input) * isdev->input_count;
 
 	bool io_active = ics->io_active && idev->io_active;
@@ -1510,8 +1774,8 @@ static struct xrt_input *
 find_input(volatile struct ipc_client_state *ics, uint32_t device_id, enum xrt_input_name name)
 {
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-	struct xrt_input *io = &ism->inputs[isdev->first_input_index];
+	struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[device_id];
+	struct xrt_input *io = &ipc_shm_inputs(ism)[isdev->first_input_index];
 
 	for (uint32_t i = 0; i < isdev->input_count; i++) {
 		if (io[i].name == name) {
@@ -1579,6 +1843,26 @@ ipc_handle_device_get_hand_tracking(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_get_hand_tracking_packed(volatile struct ipc_client_state *ics,
+                                           uint32_t id,
+                                           enum xrt_input_name name,
+                                           uint64_t at_timestamp,
+                                           struct ipc_packed_hand_joint_set *out_value,
+                                           uint64_t *out_timestamp)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	struct xrt_device *xdev = get_xdev(ics, device_id);
+
+	struct xrt_hand_joint_set value = XRT_STRUCT_INIT;
+	xrt_device_get_hand_tracking(xdev, name, at_timestamp, &value, out_timestamp);
+
+	ipc_pack_hand_joint_set(&value, out_value);
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_device_get_view_poses(volatile struct ipc_client_state *ics,
                                  uint32_t id,
@@ -1748,19 +2032,12 @@ ipc_handle_device_get_visibility_mask(volatile struct ipc_client_state *ics,
 		reply.mask_size = xrt_visibility_mask_get_size(mask);
 	}
 
-	xret = ipc_send(imc, &reply, sizeof(reply));
+	// Reply and mask in one go, no need to copy the mask.
+	xret = ipc_send_with_payload(imc, &reply, sizeof(reply), mask, reply.mask_size);
 	if (xret != XRT_SUCCESS) {
-		IPC_ERROR(s, "Failed to send reply");
-		goto out_free;
+		IPC_ERROR(s, "Failed to send reply and mask");
 	}
 
-	xret = ipc_send(imc, mask, reply.mask_size);
-	if (xret != XRT_SUCCESS) {
-		IPC_ERROR(s, "Failed to send mask");
-		goto out_free;
-	}
-
-out_free:
 	free(mask);
 	return xret;
 }
@@ -1778,8 +2055,57 @@ ipc_handle_device_is_form_factor_available(volatile struct ipc_client_state *ics
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_set_feature_enabled(volatile struct ipc_client_state *ics,
+                                      uint32_t id,
+                                      enum xrt_device_feature_type type,
+                                      bool enabled)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	if (device_id >= IPC_MAX_DEVICES) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct xrt_device *xdev = get_xdev(ics, device_id);
+	if (xdev == NULL) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	if (xdev->set_feature_enabled == NULL) {
+		return XRT_ERROR_FEATURE_NOT_SUPPORTED;
+	}
+
+	IPC_INFO(ics->server, "%s feature %u on device '%s'.", enabled ? "Enabling" : "Disabling", type, xdev->str);
+
+	return xrt_device_set_feature_enabled(xdev, type, enabled);
+}
+
 xrt_result_t
 ipc_handle_system_devices_get_roles(volatile struct ipc_client_state *ics, struct xrt_system_roles *out_roles)
 {
-	return xrt_system_devices_get_roles(ics->server->xsysd, out_roles);
+	struct ipc_server *s = ics->server;
+
+	xrt_result_t xret = xrt_system_devices_get_roles(s->xsysd, out_roles);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	/*
+	 * There is no callback for role changes, but the state trackers of
+	 * all apps fetch the roles on every action sync, so notice them here.
+	 */
+	os_mutex_lock(&s->global_state.lock);
+	uint64_t last_generation_id = s->global_state.roles_generation_id;
+	if (out_roles->generation_id > last_generation_id) {
+		s->global_state.roles_generation_id = out_roles->generation_id;
+	}
+	os_mutex_unlock(&s->global_state.lock);
+
+	// The first roles seen are not a change.
+	if (last_generation_id != 0 && out_roles->generation_id > last_generation_id) {
+		ipc_server_push_system_event(s, IPC_SYSTEM_EVENT_ROLES_CHANGED, 0);
+	}
+
+	return XRT_SUCCESS;
 }
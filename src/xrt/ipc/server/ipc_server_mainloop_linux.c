@@ -35,6 +35,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
@@ -185,8 +186,24 @@ init_epoll(struct ipc_server_mainloop *ml)
 
 	ml->epoll_fd = ret;
 
+	ret = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (ret < 0) {
+		U_LOG_E("eventfd failed '%i'", errno);
+		return ret;
+	}
+
+	ml->wake_fd = ret;
+
 	struct epoll_event ev = {0};
 
+	ev.events = EPOLLIN;
+	ev.data.fd = ml->wake_fd;
+	ret = epoll_ctl(ml->epoll_fd, EPOLL_CTL_ADD, ml->wake_fd, &ev);
+	if (ret < 0) {
+		U_LOG_E("epoll_ctl(wake_fd) failed '%i'", ret);
+		return ret;
+	}
+
 	if (!ml->launched_by_socket && !debug_get_bool_option_skip_stdin()) {
 		// Can't do this when launched by systemd socket activation by
 		// default.
@@ -226,7 +243,12 @@ handle_listen(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 }
 
 #define NUM_POLL_EVENTS 8
-#define NO_SLEEP 0
+
+/*!
+ * The running flag can also be cleared from the debug gui without waking us
+ * up, so don't block forever.
+ */
+#define POLL_TIMEOUT_MS 1000
 
 /*
  *
@@ -243,8 +265,11 @@ ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 
 	struct epoll_event events[NUM_POLL_EVENTS] = {0};
 
-	// No sleeping, returns immediately.
-	int ret = epoll_wait(epoll_fd, events, NUM_POLL_EVENTS, NO_SLEEP);
+	// Sleeps until something happens, the caller checks if we are running.
+	int ret = epoll_wait(epoll_fd, events, NUM_POLL_EVENTS, POLL_TIMEOUT_MS);
+	if (ret < 0 && errno == EINTR) {
+		return;
+	}
 	if (ret < 0) {
 		U_LOG_E("epoll_wait failed with '%i'.", ret);
 		ipc_server_handle_failure(vs);
@@ -252,6 +277,15 @@ ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 	}
 
 	for (int i = 0; i < ret; i++) {
+		// Woken up, just drain it, the caller checks if we are running.
+		if (events[i].data.fd == ml->wake_fd) {
+			uint64_t value = 0;
+			if (read(ml->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+				U_LOG_E("read(wake_fd) failed '%i'", errno);
+			}
+			continue;
+		}
+
 		// If we get data on stdin, stop.
 		if (events[i].data.fd == 0) {
 			ipc_server_handle_shutdown_signal(vs);
@@ -303,5 +337,23 @@ ipc_server_mainloop_deinit(struct ipc_server_mainloop *ml)
 			ml->socket_filename = NULL;
 		}
 	}
+	if (ml->wake_fd > 0) {
+		close(ml->wake_fd);
+		ml->wake_fd = -1;
+	}
 	//! @todo close epoll_fd?
 }
+
+void
+ipc_server_mainloop_wake(struct ipc_server_mainloop *ml)
+{
+	if (ml->wake_fd <= 0) {
+		return;
+	}
+
+	// Only fails if the counter would overflow, then it's already awake.
+	uint64_t value = 1;
+	if (write(ml->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		U_LOG_E("write(wake_fd) failed '%i'", errno);
+	}
+}
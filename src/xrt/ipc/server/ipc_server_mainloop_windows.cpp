@@ -44,6 +44,12 @@
 
 #define ERROR_STR(BUF, ERR) (u_winerror(BUF, ARRAY_SIZE(BUF), ERR, true))
 
+/*!
+ * The pipe is non-blocking so there is nothing to wait on for new clients,
+ * how long to sleep on the wake event between checking the pipe.
+ */
+#define POLL_TIMEOUT_MS 5
+
 DEBUG_GET_ONCE_BOOL_OPTION(relaxed, "IPC_RELAXED_CONNECTION_SECURITY", false)
 
 
@@ -218,6 +224,9 @@ ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 {
 	IPC_TRACE_MARKER();
 
+	// Sleep until woken up or it's time to check the pipe again.
+	WaitForSingleObject(ml->wake_event, POLL_TIMEOUT_MS);
+
 	if (_kbhit()) {
 		U_LOG_E("console input! exiting...");
 		ipc_server_handle_shutdown_signal(vs);
@@ -256,6 +265,14 @@ ipc_server_mainloop_init(struct ipc_server_mainloop *ml)
 	ml->pipe_handle = INVALID_HANDLE_VALUE;
 	ml->pipe_name = nullptr;
 
+	// Auto-reset, a single wake up is enough.
+	ml->wake_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+	if (ml->wake_event == nullptr) {
+		DWORD err = GetLastError();
+		U_LOG_E("CreateEventA failed: %d %s", err, ipc_winerror(err));
+		return -1;
+	}
+
 	constexpr char pipe_prefix[] = "\\\\.\\pipe\\";
 	constexpr int prefix_len = sizeof(pipe_prefix) - 1;
 	char pipe_name[MAX_PATH + prefix_len];
@@ -298,4 +315,16 @@ ipc_server_mainloop_deinit(struct ipc_server_mainloop *ml)
 		free(ml->pipe_name);
 		ml->pipe_name = nullptr;
 	}
+	if (ml->wake_event != nullptr) {
+		CloseHandle(ml->wake_event);
+		ml->wake_event = nullptr;
+	}
+}
+
+void
+ipc_server_mainloop_wake(struct ipc_server_mainloop *ml)
+{
+	if (ml->wake_event != nullptr) {
+		SetEvent(ml->wake_event);
+	}
 }
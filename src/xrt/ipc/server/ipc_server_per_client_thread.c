@@ -8,10 +8,15 @@
  * @ingroup ipc_server
  */
 
+#include "xrt/xrt_config_os.h"
+
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
+#include "util/u_thread_role.h"
 
 #include "shared/ipc_utils.h"
+#include "shared/ipc_shmem.h"
+#include "shared/ipc_command_ring.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -47,12 +52,41 @@ common_shutdown(volatile struct ipc_client_state *ics)
 
 	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
 
+	// Closing the channel unmaps an attached ring, but not one never attached.
+	if (ics->pending_command_ring != NULL) {
+		ipc_shmem_destroy((xrt_shmem_handle_t *)&ics->pending_command_ring_handle,
+		                  (void **)&ics->pending_command_ring, sizeof(struct ipc_command_ring));
+
+#ifdef XRT_OS_WINDOWS
+		for (uint32_t i = 0; i < IPC_COMMAND_RING_EVENT_COUNT; i++) {
+			CloseHandle(ics->pending_command_ring_events[i]);
+			ics->pending_command_ring_events[i] = NULL;
+		}
+#endif
+	}
+
+#ifndef XRT_OS_WINDOWS
+	// Events are pushed under the lock, so no more after this.
+	if (ics->event_fd >= 0) {
+		close(ics->event_fd);
+		ics->event_fd = -1;
+	}
+	if (ics->pending_event_fd >= 0) {
+		close(ics->pending_event_fd);
+		ics->pending_event_fd = -1;
+	}
+#endif
+
+	uint32_t client_id = ics->client_state.id;
+
 	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
 	ics->server_thread_index = -1;
 	memset((void *)&ics->client_state, 0, sizeof(struct ipc_app_state));
 
 	os_mutex_unlock(&ics->server->global_state.lock);
 
+	ipc_server_push_system_event(ics->server, IPC_SYSTEM_EVENT_CLIENT_DISCONNECTED, client_id);
+
 
 	/*
 	 * Clean up various resources.
@@ -80,7 +114,7 @@ common_shutdown(volatile struct ipc_client_state *ics)
 
 	// Should we stop the server when a client disconnects?
 	if (ics->server->exit_on_disconnect) {
-		ics->server->running = false;
+		ipc_server_handle_shutdown_signal(ics->server);
 	}
 
 	ipc_server_deactivate_session(ics);
@@ -93,6 +127,108 @@ common_shutdown(volatile struct ipc_client_state *ics)
  *
  */
 
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)
+/*!
+ * Wait for the next command on the command ring and peek its type, returns 1
+ * if @p out_cmd is set, 0 on timeout and -1 if the client should be
+ * disconnected. The ring notices the client hanging up through the socket or
+ * pipe.
+ */
+static int
+peek_command_ring(volatile struct ipc_client_state *ics, enum ipc_command *out_cmd)
+{
+	const uint32_t half_a_second_ms = 500;
+	bool peeked = false;
+
+	xrt_result_t xret = ipc_command_ring_peek( //
+	    (struct ipc_message_channel *)&ics->imc,  //
+	    out_cmd,                                  //
+	    sizeof(*out_cmd),                         //
+	    half_a_second_ms,                         //
+	    &peeked);                                 //
+	if (xret != XRT_SUCCESS) {
+		IPC_INFO(ics->server, "Client disconnected.");
+		return -1;
+	}
+
+	return peeked ? 1 : 0;
+}
+
+static void
+attach_pending_command_ring(volatile struct ipc_client_state *ics)
+{
+	// The reply carrying the handles has gone out, everything after goes through the ring.
+	ics->imc.ring = ics->pending_command_ring;
+	ics->imc.ring_is_server = true;
+	ics->pending_command_ring = NULL;
+
+#ifdef XRT_OS_WINDOWS
+	for (uint32_t i = 0; i < IPC_COMMAND_RING_EVENT_COUNT; i++) {
+		ics->imc.ring_events[i] = ics->pending_command_ring_events[i];
+		ics->pending_command_ring_events[i] = NULL;
+	}
+
+	CloseHandle(ics->pending_command_ring_handle);
+#else
+	close(ics->pending_command_ring_handle);
+#endif
+	ics->pending_command_ring_handle = XRT_SHMEM_HANDLE_INVALID;
+
+	IPC_INFO(ics->server, "Client %u switched to the command ring.", ics->client_state.id);
+}
+#endif
+
+/*!
+ * Reads the whole command that has been peeked as @p cmd and dispatches it,
+ * returns false if the client should be disconnected.
+ */
+static bool
+handle_command(volatile struct ipc_client_state *ics, enum ipc_command cmd)
+{
+	size_t cmd_size = ipc_command_size(cmd);
+	if (cmd_size == 0) {
+		IPC_ERROR(ics->server, "Invalid command size.");
+		return false;
+	}
+
+	// Read the whole command now that we know its size
+	uint8_t buf[IPC_BUF_SIZE] = {0};
+
+	xrt_result_t xret = ipc_receive((struct ipc_message_channel *)&ics->imc, &buf, cmd_size);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		return false;
+	}
+
+	// Check the first 4 bytes of the message and dispatch.
+	ipc_command_t *ipc_command = (ipc_command_t *)buf;
+
+	IPC_TRACE_BEGIN(ipc_dispatch);
+	xrt_result_t result = ipc_dispatch(ics, ipc_command);
+	IPC_TRACE_END(ipc_dispatch);
+
+	if (result != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		return false;
+	}
+
+#if defined(XRT_OS_LINUX) || defined(XRT_OS_WINDOWS)
+	if (ics->pending_command_ring != NULL) {
+		attach_pending_command_ring(ics);
+	}
+#endif
+
+#ifndef XRT_OS_WINDOWS
+	// The subscriber has its end of the event socket now.
+	if (ics->pending_event_fd >= 0) {
+		close(ics->pending_event_fd);
+		ics->pending_event_fd = -1;
+	}
+#endif
+
+	return true;
+}
+
 #ifndef XRT_OS_WINDOWS // Linux & Android
 
 static int
@@ -121,6 +257,49 @@ setup_epoll(volatile struct ipc_client_state *ics)
 	return epoll_fd;
 }
 
+/*!
+ * Wait for the next command on the socket and peek its type, returns 1 if
+ * @p out_cmd is set, 0 on timeout and -1 if the client should be disconnected.
+ */
+static int
+peek_command_socket(volatile struct ipc_client_state *ics, int epoll_fd, enum ipc_command *out_cmd)
+{
+	const int half_a_second_ms = 500;
+	struct epoll_event event = XRT_STRUCT_INIT;
+	int ret = 0;
+
+	// On temporary failures retry.
+	do {
+		// We use epoll here to be able to timeout.
+		ret = epoll_wait(epoll_fd, &event, 1, half_a_second_ms);
+	} while (ret == -1 && errno == EINTR);
+
+	if (ret < 0) {
+		IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
+		return -1;
+	}
+
+	// Timed out, loop again.
+	if (ret == 0) {
+		return 0;
+	}
+
+	// Detect clients disconnecting gracefully.
+	if (ret > 0 && (event.events & EPOLLHUP) != 0) {
+		IPC_INFO(ics->server, "Client disconnected.");
+		return -1;
+	}
+
+	// Peek the first 4 bytes to get the command type
+	ssize_t len = recv(ics->imc.ipc_handle, out_cmd, sizeof(*out_cmd), MSG_PEEK);
+	if (len != sizeof(*out_cmd)) {
+		IPC_ERROR(ics->server, "Invalid command received.");
+		return -1;
+	}
+
+	return 1;
+}
+
 static void
 client_loop(volatile struct ipc_client_state *ics)
 {
@@ -135,18 +314,19 @@ client_loop(volatile struct ipc_client_state *ics)
 	}
 
 	while (ics->server->running) {
-		const int half_a_second_ms = 500;
-		struct epoll_event event = XRT_STRUCT_INIT;
+		enum ipc_command cmd;
 		int ret = 0;
 
-		// On temporary failures retry.
-		do {
-			// We use epoll here to be able to timeout.
-			ret = epoll_wait(epoll_fd, &event, 1, half_a_second_ms);
-		} while (ret == -1 && errno == EINTR);
+#ifdef XRT_OS_LINUX
+		if (ics->imc.ring != NULL) {
+			ret = peek_command_ring(ics, &cmd);
+		} else
+#endif
+		{
+			ret = peek_command_socket(ics, epoll_fd, &cmd);
+		}
 
 		if (ret < 0) {
-			IPC_ERROR(ics->server, "Failed epoll_wait '%i', disconnecting client.", ret);
 			break;
 		}
 
@@ -155,53 +335,292 @@ client_loop(volatile struct ipc_client_state *ics)
 			continue;
 		}
 
-		// Detect clients disconnecting gracefully.
-		if (ret > 0 && (event.events & EPOLLHUP) != 0) {
-			IPC_INFO(ics->server, "Client disconnected.");
+		if (!handle_command(ics, cmd)) {
 			break;
 		}
+	}
+
+	close(epoll_fd);
+	epoll_fd = -1;
+
+	// Following code is same for all platforms.
+	common_shutdown(ics);
+}
+
+/*
+ *
+ * IO pool, Linux & Android.
+ *
+ */
+
+/*!
+ * Commands that are in the critical path of the client rendering frames, they
+ * are served by the frame threads so they never queue up behind other calls,
+ * and a client blocking in one only holds up one of the frame threads.
+ */
+static bool
+is_frame_critical(enum ipc_command cmd)
+{
+	switch (cmd) {
+	case IPC_COMPOSITOR_WAIT_WOKE:
+	case IPC_COMPOSITOR_LAYER_SYNC:
+	case IPC_COMPOSITOR_LAYER_SYNC_WITH_SEMAPHORE: return true;
+	default: return false;
+	}
+}
+
+static void
+pool_remove_client(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	epoll_ctl(s->io_pool.epoll_fd, EPOLL_CTL_DEL, ics->imc.ipc_handle, NULL);
+
+	// Following code is same for all platforms.
+	common_shutdown(ics);
+}
+
+/*!
+ * The socket is registered one shot, re-arm it for the next command after
+ * the current command has been handled.
+ */
+static void
+pool_rearm_client(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	struct epoll_event ev = XRT_STRUCT_INIT;
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = (void *)ics;
+
+	int ret = epoll_ctl(s->io_pool.epoll_fd, EPOLL_CTL_MOD, ics->imc.ipc_handle, &ev);
+	if (ret < 0) {
+		IPC_ERROR(s, "Error epoll_ctl(EPOLL_CTL_MOD) failed '%i', disconnecting client.", ret);
+		pool_remove_client(s, ics);
+	}
+}
+
+static void
+pool_handle_and_rearm(struct ipc_server *s, volatile struct ipc_client_state *ics, enum ipc_command cmd)
+{
+	if (!handle_command(ics, cmd)) {
+		pool_remove_client(s, ics);
+		return;
+	}
+
+	pool_rearm_client(s, ics);
+}
+
+static void
+pool_push_frame_queue(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	os_mutex_lock(&s->io_pool.frame_lock);
+
+	// A client is only ever in one place, so there is always room.
+	assert(s->io_pool.frame_queue_count < ARRAY_SIZE(s->io_pool.frame_queue));
+	uint32_t index = (s->io_pool.frame_queue_first + s->io_pool.frame_queue_count) % IPC_MAX_CLIENTS;
+	s->io_pool.frame_queue[index] = ics;
+	s->io_pool.frame_queue_count++;
+
+	os_cond_signal(&s->io_pool.frame_cond);
+	os_mutex_unlock(&s->io_pool.frame_lock);
+}
+
+static void *
+pool_io_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	const int half_a_second_ms = 500;
+
+	U_TRACE_SET_THREAD_NAME("IPC IO");
+
+	while (s->running) {
+		struct epoll_event event = XRT_STRUCT_INIT;
+
+		int ret = epoll_wait(s->io_pool.epoll_fd, &event, 1, half_a_second_ms);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0) {
+			IPC_ERROR(s, "Failed epoll_wait '%i', stopping IO thread.", ret);
+			break;
+		}
+
+		// Timed out, loop again.
+		if (ret == 0) {
+			continue;
+		}
+
+		// We are now the only thread looking at this client until it's re-armed.
+		volatile struct ipc_client_state *ics = (volatile struct ipc_client_state *)event.data.ptr;
+
+		// Detect clients disconnecting gracefully.
+		if ((event.events & (EPOLLHUP | EPOLLERR)) != 0) {
+			IPC_INFO(s, "Client disconnected.");
+			pool_remove_client(s, ics);
+			continue;
+		}
 
 		// Peek the first 4 bytes to get the command type
 		enum ipc_command cmd;
-		ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK);
+		ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK | MSG_DONTWAIT);
+		if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			pool_rearm_client(s, ics);
+			continue;
+		}
 		if (len != sizeof(cmd)) {
-			IPC_ERROR(ics->server, "Invalid command received.");
-			break;
+			IPC_ERROR(s, "Invalid command received.");
+			pool_remove_client(s, ics);
+			continue;
 		}
 
-		size_t cmd_size = ipc_command_size(cmd);
-		if (cmd_size == 0) {
-			IPC_ERROR(ics->server, "Invalid command size.");
-			break;
+		if (is_frame_critical(cmd)) {
+			pool_push_frame_queue(s, ics);
+			continue;
 		}
 
-		// Read the whole command now that we know its size
-		uint8_t buf[IPC_BUF_SIZE] = {0};
+		pool_handle_and_rearm(s, ics, cmd);
+	}
 
-		len = recv(ics->imc.ipc_handle, &buf, cmd_size, 0);
-		if (len != (ssize_t)cmd_size) {
-			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
-			break;
+	return NULL;
+}
+
+static void *
+pool_frame_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("IPC IO Frame");
+
+	// Raise the priority of this thread.
+	u_thread_role_apply(U_THREAD_ROLE_IPC_FRAME, s->log_level, "IPC IO Frame");
+
+	os_mutex_lock(&s->io_pool.frame_lock);
+
+	while (s->io_pool.frame_running) {
+		if (s->io_pool.frame_queue_count == 0) {
+			os_cond_wait(&s->io_pool.frame_cond, &s->io_pool.frame_lock);
+			continue;
 		}
 
-		// Check the first 4 bytes of the message and dispatch.
-		ipc_command_t *ipc_command = (ipc_command_t *)buf;
+		volatile struct ipc_client_state *ics = s->io_pool.frame_queue[s->io_pool.frame_queue_first];
+		s->io_pool.frame_queue_first = (s->io_pool.frame_queue_first + 1) % IPC_MAX_CLIENTS;
+		s->io_pool.frame_queue_count--;
 
-		IPC_TRACE_BEGIN(ipc_dispatch);
-		xrt_result_t result = ipc_dispatch(ics, ipc_command);
-		IPC_TRACE_END(ipc_dispatch);
+		os_mutex_unlock(&s->io_pool.frame_lock);
 
-		if (result != XRT_SUCCESS) {
-			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
-			break;
+		// Already peeked by the IO thread, so there is data waiting.
+		enum ipc_command cmd;
+		ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK);
+		if (len != sizeof(cmd)) {
+			IPC_ERROR(s, "Invalid command received.");
+			pool_remove_client(s, ics);
+		} else {
+			pool_handle_and_rearm(s, ics, cmd);
 		}
+
+		os_mutex_lock(&s->io_pool.frame_lock);
 	}
 
-	close(epoll_fd);
-	epoll_fd = -1;
+	os_mutex_unlock(&s->io_pool.frame_lock);
 
-	// Following code is same for all platforms.
-	common_shutdown(ics);
+	return NULL;
+}
+
+int
+ipc_server_io_pool_start(struct ipc_server *s, uint32_t thread_count)
+{
+	if (thread_count > IPC_MAX_IO_THREADS) {
+		IPC_WARN(s, "Clamping IO thread count %u to %u.", thread_count, IPC_MAX_IO_THREADS);
+		thread_count = IPC_MAX_IO_THREADS;
+	}
+
+	int ret = epoll_create1(EPOLL_CLOEXEC);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to create IO pool epoll '%i'.", ret);
+		return ret;
+	}
+	s->io_pool.epoll_fd = ret;
+
+	os_mutex_init(&s->io_pool.frame_lock);
+	os_cond_init(&s->io_pool.frame_cond);
+	s->io_pool.frame_queue_first = 0;
+	s->io_pool.frame_queue_count = 0;
+	s->io_pool.frame_running = true;
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		os_thread_init(&s->io_pool.threads[i]);
+		os_thread_start(&s->io_pool.threads[i], pool_io_thread, s);
+
+		os_thread_init(&s->io_pool.frame_threads[i]);
+		os_thread_start(&s->io_pool.frame_threads[i], pool_frame_thread, s);
+	}
+
+	s->io_pool.thread_count = thread_count;
+
+	IPC_INFO(s, "Serving all clients with %u IO threads.", thread_count);
+
+	return 0;
+}
+
+void
+ipc_server_io_pool_stop(struct ipc_server *s)
+{
+	if (s->io_pool.thread_count == 0) {
+		return;
+	}
+
+	// The IO threads checks the running flag.
+	s->running = false;
+
+	for (uint32_t i = 0; i < s->io_pool.thread_count; i++) {
+		os_thread_join(&s->io_pool.threads[i]);
+		os_thread_destroy(&s->io_pool.threads[i]);
+	}
+
+	// Wake up all of the frame threads, they check the running flag.
+	os_mutex_lock(&s->io_pool.frame_lock);
+	s->io_pool.frame_running = false;
+	for (uint32_t i = 0; i < s->io_pool.thread_count; i++) {
+		os_cond_signal(&s->io_pool.frame_cond);
+	}
+	os_mutex_unlock(&s->io_pool.frame_lock);
+
+	for (uint32_t i = 0; i < s->io_pool.thread_count; i++) {
+		os_thread_join(&s->io_pool.frame_threads[i]);
+		os_thread_destroy(&s->io_pool.frame_threads[i]);
+	}
+
+	// Anything left on the queue is shut down below.
+	s->io_pool.frame_queue_count = 0;
+	os_cond_destroy(&s->io_pool.frame_cond);
+	os_mutex_destroy(&s->io_pool.frame_lock);
+
+	// Nobody is serving the clients anymore, shut down those that are left.
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+		if (ics->server_thread_index >= 0 && ics->server == s) {
+			pool_remove_client(s, ics);
+		}
+	}
+
+	close(s->io_pool.epoll_fd);
+	s->io_pool.epoll_fd = -1;
+	s->io_pool.thread_count = 0;
+}
+
+int
+ipc_server_io_pool_add_client(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	IPC_INFO(s, "Client %u connected", ics->client_state.id);
+
+	struct epoll_event ev = XRT_STRUCT_INIT;
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = (void *)ics;
+
+	int ret = epoll_ctl(s->io_pool.epoll_fd, EPOLL_CTL_ADD, ics->imc.ipc_handle, &ev);
+	if (ret < 0) {
+		IPC_ERROR(s, "Error epoll_ctl(client_socket) failed '%i'.", ret);
+		return ret;
+	}
+
+	return 0;
 }
 
 #else // XRT_OS_WINDOWS
@@ -226,6 +645,19 @@ client_loop(volatile struct ipc_client_state *ics)
 	IPC_INFO(ics->server, "Client connected");
 
 	while (ics->server->running) {
+		// Once attached commands come over the ring, the pipe only tells us about hang ups.
+		if (ics->imc.ring != NULL) {
+			enum ipc_command cmd;
+			int ret = peek_command_ring(ics, &cmd);
+			if (ret < 0) {
+				break;
+			}
+			if (ret > 0 && !handle_command(ics, cmd)) {
+				break;
+			}
+			continue;
+		}
+
 		uint8_t buf[IPC_BUF_SIZE] = {0};
 		DWORD len = 0;
 		BOOL bret = false;
@@ -278,12 +710,36 @@ client_loop(volatile struct ipc_client_state *ics)
 			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
 			break;
 		}
+
+		// The reply with the ring's handles has gone out over the pipe.
+		if (ics->pending_command_ring != NULL) {
+			attach_pending_command_ring(ics);
+		}
 	}
 
 	// Following code is same for all platforms.
 	common_shutdown(ics);
 }
 
+int
+ipc_server_io_pool_start(struct ipc_server *s, uint32_t thread_count)
+{
+	IPC_WARN(s, "IO thread pool not supported on this platform, using one thread per client.");
+	return 0;
+}
+
+void
+ipc_server_io_pool_stop(struct ipc_server *s)
+{
+	// Never started.
+}
+
+int
+ipc_server_io_pool_add_client(struct ipc_server *s, volatile struct ipc_client_state *ics)
+{
+	return -1;
+}
+
 #endif // XRT_OS_WINDOWS
 
 
@@ -17,14 +17,19 @@
 #include "xrt/xrt_config_os.h"
 
 #include "os/os_time.h"
+#include "os/os_threading.h"
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
+#include "util/u_atomic.h"
 #include "util/u_trace_marker.h"
 #include "util/u_verify.h"
 #include "util/u_process.h"
+#include "util/u_metrics.h"
 #include "util/u_debug_gui.h"
 #include "util/u_pretty_print.h"
+#include "util/u_seqlock.h"
+#include "util/u_thread_role.h"
 
 #include "util/u_git_tag.h"
 
@@ -46,6 +51,8 @@
 
 #if defined(XRT_OS_WINDOWS)
 #include <timeapi.h>
+#else
+#include <sys/socket.h>
 #endif
 
 
@@ -57,6 +64,8 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(exit_on_disconnect, "IPC_EXIT_ON_DISCONNECT", false)
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_NUM_OPTION(pose_publish_hz, "IPC_POSE_PUBLISH_HZ", 500)
+DEBUG_GET_ONCE_NUM_OPTION(io_threads, "IPC_IO_THREADS", 0)
 
 
 /*
@@ -194,6 +203,15 @@ teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
 
+	// The stats are in the shared memory, stop updating them.
+	u_metrics_set_stats(NULL);
+
+	// Shuts down any clients left on it, does nothing if not started.
+	ipc_server_io_pool_stop(s);
+
+	// Uses the devices and shared memory, stop it first.
+	os_thread_helper_destroy(&s->pose_publisher);
+
 	xrt_syscomp_destroy(&s->xsysc);
 
 	teardown_idevs(s);
@@ -208,7 +226,7 @@ teardown_all(struct ipc_server *s)
 
 	u_process_destroy(s->process);
 
-	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, sizeof(struct ipc_shared_memory));
+	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, s->ism_size);
 
 	// Destroyed last.
 	os_mutex_destroy(&s->global_state.lock);
@@ -241,6 +259,92 @@ init_tracking_origins(struct ipc_server *s)
 	return 0;
 }
 
+/*!
+ * Adds a region of @p count elements of @p elem_size bytes at the end of the
+ * layout, the regions are kept on separate cache lines.
+ */
+static void
+add_shm_region(struct ipc_shared_region *region, size_t *offset_ptr, uint32_t count, size_t elem_size)
+{
+	size_t offset = *offset_ptr;
+
+	offset = (offset + IPC_SHARED_REGION_ALIGNMENT - 1) & ~((size_t)IPC_SHARED_REGION_ALIGNMENT - 1);
+
+	region->offset = (uint32_t)offset;
+	region->count = count;
+
+	*offset_ptr = offset + count * elem_size;
+}
+
+/*!
+ * Sizes the shared memory for the devices and tracking origins there are, the
+ * static regions go first and the ones written while running last.
+ */
+static void
+init_shm_layout(struct ipc_server *s, struct ipc_shared_memory_layout *layout)
+{
+	uint32_t itrack_count = 0;
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		if (s->xtracks[i] != NULL) {
+			itrack_count++;
+		}
+	}
+
+	uint32_t device_count = 0;
+	uint32_t input_count = 0;
+	uint32_t output_count = 0;
+	uint32_t binding_count = 0;
+	uint32_t input_pair_count = 0;
+	uint32_t output_pair_count = 0;
+
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		struct xrt_device *xdev = s->idevs[i].xdev;
+		if (xdev == NULL) {
+			continue;
+		}
+
+		device_count++;
+		input_count += (uint32_t)xdev->input_count;
+		output_count += (uint32_t)xdev->output_count;
+		binding_count += (uint32_t)xdev->binding_profile_count;
+
+		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
+			input_pair_count += (uint32_t)xdev->binding_profiles[k].input_count;
+			output_pair_count += (uint32_t)xdev->binding_profiles[k].output_count;
+		}
+	}
+
+	size_t offset = sizeof(struct ipc_shared_memory);
+
+#define ADD(NAME, COUNT, TYPE) add_shm_region(&layout->NAME, &offset, COUNT, sizeof(TYPE))
+
+	// Static.
+	ADD(itracks, itrack_count, struct ipc_shared_tracking_origin);
+	ADD(isdevs, device_count, struct ipc_shared_device);
+	ADD(outputs, output_count, struct xrt_output);
+	ADD(binding_profiles, binding_count, struct ipc_shared_binding_profile);
+	ADD(input_pairs, input_pair_count, struct xrt_binding_input_pair);
+	ADD(output_pairs, output_pair_count, struct xrt_binding_output_pair);
+
+	// Written by the service while running.
+	ADD(inputs, input_count, struct xrt_input);
+	ADD(device_poses, device_count, struct ipc_shared_device_poses);
+	ADD(device_inputs, device_count, struct ipc_shared_device_inputs);
+	ADD(published_inputs, input_count, struct xrt_input);
+	ADD(stats, 1, struct u_metrics_stats);
+
+	// Written by the clients.
+	ADD(slots, IPC_MAX_SLOTS, struct ipc_layer_slot);
+
+#undef ADD
+
+	// Round up so the last region doesn't share a cache line with anything.
+	offset = (offset + IPC_SHARED_REGION_ALIGNMENT - 1) & ~((size_t)IPC_SHARED_REGION_ALIGNMENT - 1);
+
+	layout->version = IPC_SHARED_MEMORY_LAYOUT_VERSION;
+	layout->size = (uint32_t)offset;
+}
+
 static void
 handle_binding(struct ipc_shared_memory *ism,
                struct xrt_binding_profile *xbp,
@@ -256,7 +360,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in input_pairs.
 	uint32_t input_pair_start = input_pair_index;
 	for (size_t k = 0; k < xbp->input_count; k++) {
-		ism->input_pairs[input_pair_index++] = xbp->inputs[k];
+		ipc_shm_input_pairs(ism)[input_pair_index++] = xbp->inputs[k];
 	}
 
 	// Setup the 'offsets' and number of input_pairs.
@@ -268,7 +372,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in outputs.
 	uint32_t output_pair_start = output_pair_index;
 	for (size_t k = 0; k < xbp->output_count; k++) {
-		ism->output_pairs[output_pair_index++] = xbp->outputs[k];
+		ipc_shm_output_pairs(ism)[output_pair_index++] = xbp->outputs[k];
 	}
 
 	// Setup the 'offsets' and number of output_pairs.
@@ -281,10 +385,30 @@ handle_binding(struct ipc_shared_memory *ism,
 	*output_pair_index_ptr = output_pair_index;
 }
 
+static void
+init_shm_device_poses(struct ipc_shared_device_poses *isdp, struct xrt_device *xdev)
+{
+	for (uint32_t i = 0; i < xdev->input_count; i++) {
+		enum xrt_input_name name = xdev->inputs[i].name;
+		if (XRT_GET_INPUT_TYPE(name) != XRT_INPUT_TYPE_POSE) {
+			continue;
+		}
+
+		if (isdp->ring_count >= ARRAY_SIZE(isdp->rings)) {
+			break;
+		}
+
+		isdp->rings[isdp->ring_count++].name = name;
+	}
+}
+
 static int
 init_shm(struct ipc_server *s)
 {
-	const size_t size = sizeof(struct ipc_shared_memory);
+	struct ipc_shared_memory_layout layout = {0};
+	init_shm_layout(s, &layout);
+
+	const size_t size = layout.size;
 	xrt_shmem_handle_t handle;
 	xrt_result_t result = ipc_shmem_create(size, &handle, (void **)&s->ism);
 	if (result != XRT_SUCCESS) {
@@ -293,6 +417,9 @@ init_shm(struct ipc_server *s)
 
 	// we have a filehandle, we will pass this to our client
 	s->ism_handle = handle;
+	s->ism_size = size;
+
+	U_LOG_D("Shared memory is %zu bytes", size);
 
 
 	/*
@@ -304,6 +431,7 @@ init_shm(struct ipc_server *s)
 	uint32_t count = 0;
 	struct ipc_shared_memory *ism = s->ism;
 
+	ism->layout = layout;
 	ism->startup_timestamp = os_monotonic_get_ns();
 
 	// Setup the tracking origins.
@@ -318,7 +446,7 @@ init_shm(struct ipc_server *s)
 		// server's memory.
 		assert(i < XRT_SYSTEM_MAX_DEVICES);
 
-		struct ipc_shared_tracking_origin *itrack = &ism->itracks[count++];
+		struct ipc_shared_tracking_origin *itrack = &ipc_shm_itracks(ism)[count++];
 		memcpy(itrack->name, xtrack->name, sizeof(itrack->name));
 		itrack->type = xtrack->type;
 		itrack->offset = xtrack->offset;
@@ -339,7 +467,7 @@ init_shm(struct ipc_server *s)
 			continue;
 		}
 
-		struct ipc_shared_device *isdev = &ism->isdevs[count++];
+		struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[count++];
 
 		isdev->name = xdev->name;
 		memcpy(isdev->str, xdev->str, sizeof(isdev->str));
@@ -388,7 +516,7 @@ init_shm(struct ipc_server *s)
 		// Bindings
 		uint32_t binding_start = binding_index;
 		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
-			handle_binding(ism, &xdev->binding_profiles[k], &ism->binding_profiles[binding_index++],
+			handle_binding(ism, &xdev->binding_profiles[k], &ipc_shm_binding_profiles(ism)[binding_index++],
 			               &input_pair_index, &output_pair_index);
 		}
 
@@ -401,7 +529,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in inputs.
 		uint32_t input_start = input_index;
 		for (size_t k = 0; k < xdev->input_count; k++) {
-			ism->inputs[input_index++] = xdev->inputs[k];
+			ipc_shm_inputs(ism)[input_index++] = xdev->inputs[k];
 		}
 
 		// Setup the 'offsets' and number of inputs.
@@ -413,7 +541,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in outputs.
 		uint32_t output_start = output_index;
 		for (size_t k = 0; k < xdev->output_count; k++) {
-			ism->outputs[output_index++] = xdev->outputs[k];
+			ipc_shm_outputs(ism)[output_index++] = xdev->outputs[k];
 		}
 
 		// Setup the 'offsets' and number of outputs.
@@ -421,6 +549,9 @@ init_shm(struct ipc_server *s)
 			isdev->output_count = output_index - output_start;
 			isdev->first_output_index = output_start;
 		}
+
+		// Which pose inputs are published, same index as the isdev.
+		init_shm_device_poses(&ipc_shm_device_poses(ism)[count - 1], xdev);
 	}
 
 	// Finally tell the client how many devices we have.
@@ -435,9 +566,209 @@ init_shm(struct ipc_server *s)
 	// Fill out git version info.
 	snprintf(s->ism->u_git_tag, IPC_VERSION_NAME_LEN, "%s", u_git_tag);
 
+	// Keep the live stats up to date from now on.
+	u_metrics_set_stats(ipc_shm_stats(ism));
+
 	return 0;
 }
 
+static bool
+any_client_running(struct ipc_server *s)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		if (s->threads[i].state == IPC_THREAD_RUNNING) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+publish_poses(struct ipc_server *s, uint64_t now_ns)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	for (uint32_t i = 0; i < ism->isdev_count; i++) {
+		struct ipc_device *idev = &s->idevs[i];
+		struct ipc_shared_device_poses *isdp = &ipc_shm_device_poses(ism)[i];
+
+		for (uint32_t k = 0; k < isdp->ring_count; k++) {
+			struct ipc_shared_pose_ring *ring = &isdp->rings[k];
+
+			// Only sample what clients read, they go to the call until it's picked up.
+			uint64_t last_read_ns = u_atomic_u64_load_acquire(&ring->last_read_ns);
+			if (now_ns > last_read_ns + IPC_SHARED_POSE_IDLE_NS) {
+				continue;
+			}
+
+			// Same rules as the get_tracked_pose call, head pose is always active.
+			struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+			if (idev->io_active || ring->name == XRT_INPUT_GENERIC_HEAD_POSE) {
+				xrt_device_get_tracked_pose(idev->xdev, ring->name, now_ns, &relation);
+			}
+
+			// Don't let clients interpolate over the time the ring wasn't sampled.
+			uint64_t newest = (ring->sample_count - 1) % IPC_SHARED_POSE_RING_SIZE;
+			bool restart = ring->sample_count > 0 &&
+			               now_ns > ring->samples[newest].timestamp_ns + ism->pose_publish_period_ns * 4;
+
+			u_seqlock_write_begin(&ring->lock);
+			if (restart) {
+				ring->sample_count = 0;
+			}
+			uint64_t index = ring->sample_count % IPC_SHARED_POSE_RING_SIZE;
+			ring->samples[index].timestamp_ns = now_ns;
+			ring->samples[index].relation = relation;
+			ring->sample_count++;
+			u_seqlock_write_end(&ring->lock);
+		}
+	}
+}
+
+static bool
+all_clients_io_active(struct ipc_server *s)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		if (s->threads[i].state == IPC_THREAD_RUNNING && !s->threads[i].ics.io_active) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//! Same rules as the device_update_input call.
+static void
+gate_input(const struct xrt_input *src, bool io_active, struct xrt_input *out_input)
+{
+	if (io_active) {
+		*out_input = *src;
+		return;
+	}
+
+	U_ZERO(out_input);
+	out_input->name = src->name;
+
+	// Special case the rotation of the head.
+	if (src->name == XRT_INPUT_GENERIC_HEAD_POSE) {
+		out_input->active = src->active;
+	}
+}
+
+static void
+publish_inputs(struct ipc_server *s)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	// Inputs are not per client, so fall back to the call if any client has io off.
+	bool valid = all_clients_io_active(s);
+
+	for (uint32_t i = 0; i < ism->isdev_count; i++) {
+		struct ipc_device *idev = &s->idevs[i];
+		struct ipc_shared_device *isdev = &ipc_shm_isdevs(ism)[i];
+		struct ipc_shared_device_inputs *isdi = &ipc_shm_device_inputs(ism)[i];
+		struct xrt_input *dst = &ipc_shm_published_inputs(ism)[isdev->first_input_index];
+
+		if (!valid) {
+			if (isdi->valid) {
+				u_seqlock_write_begin(&isdi->lock);
+				isdi->valid = false;
+				u_seqlock_write_end(&isdi->lock);
+			}
+			continue;
+		}
+
+		xrt_device_update_inputs(idev->xdev);
+
+		bool changed = !isdi->valid;
+		for (uint32_t k = 0; k < isdev->input_count && !changed; k++) {
+			struct xrt_input input;
+			gate_input(&idev->xdev->inputs[k], idev->io_active, &input);
+			changed = memcmp(&input, &dst[k], sizeof(input)) != 0;
+		}
+
+		// Readers only copy when the sequence moves.
+		if (!changed) {
+			continue;
+		}
+
+		u_seqlock_write_begin(&isdi->lock);
+		for (uint32_t k = 0; k < isdev->input_count; k++) {
+			gate_input(&idev->xdev->inputs[k], idev->io_active, &dst[k]);
+		}
+		isdi->sequence++;
+		isdi->valid = true;
+		u_seqlock_write_end(&isdi->lock);
+	}
+}
+
+static void *
+pose_publisher_thread(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("IPC Pose Publisher");
+
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	struct os_thread_helper *oth = &s->pose_publisher;
+	const uint64_t period_ns = s->ism->pose_publish_period_ns;
+
+	os_thread_helper_name(oth, "IPC Pose Publisher");
+
+	// Clients read these poses to render their frames.
+	u_thread_role_apply(U_THREAD_ROLE_IPC_FRAME, s->log_level, "IPC Pose Publisher");
+
+	struct os_precise_sleeper sleeper = {0};
+	os_precise_sleeper_init(&sleeper);
+
+	uint64_t next_ns = os_monotonic_get_ns();
+
+	os_thread_helper_lock(oth);
+	while (os_thread_helper_is_running_locked(oth)) {
+		os_thread_helper_unlock(oth);
+
+		uint64_t now_ns = os_monotonic_get_ns();
+
+		// No need to poke the drivers when nobody is listening.
+		if (any_client_running(s)) {
+			publish_poses(s, now_ns);
+			publish_inputs(s);
+		}
+
+		// Don't try to catch up if we fell behind.
+		next_ns += period_ns;
+		if (next_ns <= now_ns) {
+			next_ns = now_ns + period_ns;
+		}
+
+		now_ns = os_monotonic_get_ns();
+		if (next_ns > now_ns) {
+			os_precise_sleeper_nanosleep(&sleeper, (int32_t)(next_ns - now_ns));
+		}
+
+		os_thread_helper_lock(oth);
+	}
+	os_thread_helper_unlock(oth);
+
+	os_precise_sleeper_deinit(&sleeper);
+
+	return NULL;
+}
+
+static int
+start_pose_publisher(struct ipc_server *s)
+{
+	long hz = debug_get_num_option_pose_publish_hz();
+	if (hz <= 0) {
+		// Clients will always do round trips.
+		s->ism->pose_publish_period_ns = 0;
+		return 0;
+	}
+
+	s->ism->pose_publish_period_ns = U_TIME_1S_IN_NS / (uint64_t)hz;
+
+	return os_thread_helper_start(&s->pose_publisher, pose_publisher_thread, s);
+}
+
 static void
 init_server_state(struct ipc_server *s)
 {
@@ -451,6 +782,10 @@ init_server_state(struct ipc_server *s)
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 		ics->server = s;
 		ics->server_thread_index = -1;
+#ifndef XRT_OS_WINDOWS
+		ics->event_fd = -1;
+		ics->pending_event_fd = -1;
+#endif
 	}
 }
 
@@ -471,6 +806,14 @@ init_all(struct ipc_server *s, enum u_logging_level log_level)
 		return ret;
 	}
 
+	// This should never fail either, started once the shared memory is setup.
+	ret = os_thread_helper_init(&s->pose_publisher);
+	if (ret < 0) {
+		IPC_ERROR(s, "Pose publisher thread helper failed to init!");
+		os_mutex_destroy(&s->global_state.lock);
+		return ret;
+	}
+
 	s->process = u_process_create_if_not_running();
 
 	if (!s->process) {
@@ -528,6 +871,25 @@ init_all(struct ipc_server *s, enum u_logging_level log_level)
 	// Never fails, do this second last.
 	init_server_state(s);
 
+	// Needs the client threads to be initialised.
+	ret = start_pose_publisher(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to start pose publisher thread!");
+		teardown_all(s);
+		return ret;
+	}
+
+	// Optional, otherwise each client gets its own thread.
+	int64_t io_threads = debug_get_num_option_io_threads();
+	if (io_threads > 0) {
+		ret = ipc_server_io_pool_start(s, (uint32_t)io_threads);
+		if (ret < 0) {
+			IPC_ERROR(s, "Failed to start IO thread pool!");
+			teardown_all(s);
+			return ret;
+		}
+	}
+
 	u_var_add_root(s, "IPC Server", false);
 	u_var_add_log_level(s, &s->log_level, "Log level");
 	u_var_add_bool(s, &s->exit_on_disconnect, "exit_on_disconnect");
@@ -540,9 +902,7 @@ static int
 main_loop(struct ipc_server *s)
 {
 	while (s->running) {
-		os_nanosleep(U_TIME_1S_IN_NS / 20);
-
-		// Check polling.
+		// Blocks until there is something to do.
 		ipc_server_mainloop_poll(s, &s->ml);
 	}
 
@@ -620,6 +980,38 @@ handle_focused_client_events(volatile struct ipc_client_state *ics, int active_i
 	}
 }
 
+static void
+push_system_event_locked(struct ipc_server *s, enum ipc_system_event_type type, uint32_t client_id)
+{
+#ifndef XRT_OS_WINDOWS
+	const struct ipc_system_event lost = {IPC_SYSTEM_EVENT_EVENTS_LOST, 0};
+	const struct ipc_system_event event = {type, client_id};
+	const int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+
+		// Not running or not subscribed?
+		if (ics->server_thread_index < 0 || ics->event_fd < 0) {
+			continue;
+		}
+
+		// Let the subscriber know it has to resync before it gets anything new.
+		if (ics->event_lost) {
+			if (send(ics->event_fd, &lost, sizeof(lost), flags) < 0) {
+				continue;
+			}
+			ics->event_lost = false;
+		}
+
+		// Packets are either sent whole or not at all, never block the service on a slow subscriber.
+		if (send(ics->event_fd, &event, sizeof(event), flags) < 0) {
+			ics->event_lost = true;
+		}
+	}
+#endif
+}
+
 static void
 flush_state_to_all_clients_locked(struct ipc_server *s)
 {
@@ -636,6 +1028,8 @@ flush_state_to_all_clients_locked(struct ipc_server *s)
 		handle_overlay_client_events(ics, s->global_state.active_client_index,
 		                             s->global_state.last_active_client_index);
 	}
+
+	push_system_event_locked(s, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, 0);
 }
 
 static void
@@ -730,14 +1124,11 @@ find_client_locked(struct ipc_server *s, uint32_t client_id)
 	return NULL;
 }
 
-static xrt_result_t
-get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias)
+static void
+fill_client_app_state_locked(struct ipc_server *s,
+                             volatile struct ipc_client_state *ics,
+                             struct ipc_app_state *out_ias)
 {
-	volatile struct ipc_client_state *ics = find_client_locked(s, client_id);
-	if (ics == NULL) {
-		return XRT_ERROR_IPC_FAILURE;
-	}
-
 	struct ipc_app_state ias = ics->client_state;
 	ias.io_active = ics->io_active;
 
@@ -752,6 +1143,17 @@ get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc
 	}
 
 	*out_ias = ias;
+}
+
+static xrt_result_t
+get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias)
+{
+	volatile struct ipc_client_state *ics = find_client_locked(s, client_id);
+	if (ics == NULL) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	fill_client_app_state_locked(s, ics, out_ias);
 
 	return XRT_SUCCESS;
 }
@@ -769,6 +1171,7 @@ set_active_client_locked(struct ipc_server *s, uint32_t client_id)
 
 	if (index != s->global_state.active_client_index) {
 		s->global_state.active_client_index = index;
+		push_system_event_locked(s, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, client_id);
 	}
 
 	return XRT_SUCCESS;
@@ -784,6 +1187,8 @@ toggle_io_client_locked(struct ipc_server *s, uint32_t client_id)
 
 	ics->io_active = !ics->io_active;
 
+	push_system_event_locked(s, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, client_id);
+
 	return XRT_SUCCESS;
 }
 
@@ -794,6 +1199,35 @@ toggle_io_client_locked(struct ipc_server *s, uint32_t client_id)
  *
  */
 
+void
+ipc_server_get_system_snapshot(struct ipc_server *s, struct ipc_system_snapshot *out_snapshot)
+{
+	os_mutex_lock(&s->global_state.lock);
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+
+		// Is this thread running?
+		if (ics->server_thread_index < 0) {
+			continue;
+		}
+
+		fill_client_app_state_locked(s, ics, &out_snapshot->clients[count++]);
+	}
+	out_snapshot->client_count = count;
+
+	os_mutex_unlock(&s->global_state.lock);
+}
+
+void
+ipc_server_push_system_event(struct ipc_server *s, enum ipc_system_event_type type, uint32_t client_id)
+{
+	os_mutex_lock(&s->global_state.lock);
+	push_system_event_locked(s, type, client_id);
+	os_mutex_unlock(&s->global_state.lock);
+}
+
 xrt_result_t
 ipc_server_get_client_app_state(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias)
 {
@@ -855,6 +1289,8 @@ ipc_server_activate_session(volatile struct ipc_client_state *ics)
 		update_server_state_locked(s);
 	}
 
+	push_system_event_locked(s, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, ics->client_state.id);
+
 	os_mutex_unlock(&s->global_state.lock);
 }
 
@@ -870,6 +1306,11 @@ ipc_server_deactivate_session(volatile struct ipc_client_state *ics)
 
 	update_server_state_locked(s);
 
+	// Also called after the client is gone, it then has no id.
+	if (ics->client_state.id != 0) {
+		push_system_event_locked(s, IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED, ics->client_state.id);
+	}
+
 	os_mutex_unlock(&s->global_state.lock);
 }
 
@@ -888,13 +1329,16 @@ void
 ipc_server_handle_failure(struct ipc_server *vs)
 {
 	// Right now handled just the same as a graceful shutdown.
-	vs->running = false;
+	ipc_server_handle_shutdown_signal(vs);
 }
 
 void
 ipc_server_handle_shutdown_signal(struct ipc_server *vs)
 {
 	vs->running = false;
+
+	// Might be called from other threads, make sure the mainloop notices.
+	ipc_server_mainloop_wake(&vs->ml);
 }
 
 void
@@ -937,11 +1381,12 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 		return;
 	}
 
-	if (it->state != IPC_THREAD_READY) {
+	// Clients on the IO pool don't have a thread to join.
+	if (it->state != IPC_THREAD_READY && vs->io_pool.thread_count == 0) {
 		os_thread_join(&it->thread);
 		os_thread_destroy(&it->thread);
-		it->state = IPC_THREAD_READY;
 	}
+	it->state = IPC_THREAD_READY;
 
 	it->state = IPC_THREAD_STARTING;
 
@@ -958,8 +1403,24 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 	ics->server = vs;
 	ics->server_thread_index = cs_index;
 	ics->io_active = true;
+#ifndef XRT_OS_WINDOWS
+	ics->event_fd = -1;
+	ics->pending_event_fd = -1;
+#endif
 
-	os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
+	if (vs->io_pool.thread_count > 0) {
+		if (ipc_server_io_pool_add_client(vs, ics) < 0) {
+			xrt_ipc_handle_close(ipc_handle);
+			ics->server_thread_index = -1;
+			it->state = IPC_THREAD_READY;
+		}
+	} else {
+		os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
+	}
+
+	if (ics->server_thread_index >= 0) {
+		push_system_event_locked(vs, IPC_SYSTEM_EVENT_CLIENT_CONNECTED, id);
+	}
 
 	// Unlock when we are done.
 	os_mutex_unlock(&vs->global_state.lock);
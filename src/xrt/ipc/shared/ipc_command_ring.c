@@ -0,0 +1,391 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory command ring transport, sleeps on a futex on Linux
+ *         and on events on Windows.
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#if !defined(XRT_OS_LINUX) && !defined(XRT_OS_WINDOWS)
+#error "This file shouldn't be compiled on platforms other than Linux and Windows!"
+#endif
+
+#include "util/u_atomic.h"
+#include "util/u_logging.h"
+
+#include "shared/ipc_command_ring.h"
+#include "shared/ipc_message_channel.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include "util/u_windows.h"
+#endif
+
+
+/*
+ *
+ * Logging
+ *
+ */
+
+#define IPC_TRACE(d, ...) U_LOG_IFL_T(d->log_level, __VA_ARGS__)
+#define IPC_DEBUG(d, ...) U_LOG_IFL_D(d->log_level, __VA_ARGS__)
+#define IPC_INFO(d, ...) U_LOG_IFL_I(d->log_level, __VA_ARGS__)
+#define IPC_WARN(d, ...) U_LOG_IFL_W(d->log_level, __VA_ARGS__)
+#define IPC_ERROR(d, ...) U_LOG_IFL_E(d->log_level, __VA_ARGS__)
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+/*!
+ * How many times to poll the other sides position before going to sleep, the
+ * other side often answers within a few microseconds so this avoids a pair
+ * of futex or event syscalls per message.
+ */
+#define SPIN_COUNT 2048
+
+/*!
+ * How long to sleep at most before checking if the other side has hung up.
+ */
+#define SLEEP_SLICE_MS 100
+
+#define MASK (IPC_COMMAND_RING_SIZE - 1)
+
+static_assert((IPC_COMMAND_RING_SIZE & MASK) == 0, "IPC_COMMAND_RING_SIZE must be a power of two");
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct ipc_command_ring_buffer *
+tx_buffer(struct ipc_message_channel *imc)
+{
+	return imc->ring_is_server ? &imc->ring->to_client : &imc->ring->to_server;
+}
+
+static inline struct ipc_command_ring_buffer *
+rx_buffer(struct ipc_message_channel *imc)
+{
+	return imc->ring_is_server ? &imc->ring->to_server : &imc->ring->to_client;
+}
+
+#ifdef XRT_OS_LINUX
+
+static void
+sleep_on(struct ipc_message_channel *imc,
+         struct ipc_command_ring_buffer *rb,
+         bool as_writer,
+         uint32_t *pos,
+         uint32_t seen,
+         uint32_t timeout_ms)
+{
+	struct timespec ts = {
+	    .tv_sec = timeout_ms / 1000,
+	    .tv_nsec = (long)(timeout_ms % 1000) * 1000 * 1000,
+	};
+
+	// Not private, the word lives in memory shared between processes.
+	syscall(SYS_futex, pos, FUTEX_WAIT, seen, &ts, NULL, 0);
+}
+
+static void
+wake_up(struct ipc_message_channel *imc, struct ipc_command_ring_buffer *rb, bool wake_writer, uint32_t *pos)
+{
+	syscall(SYS_futex, pos, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static bool
+peer_hung_up(struct ipc_message_channel *imc)
+{
+	// The socket is still the connection, it tells us when the other side goes away.
+	struct pollfd pfd = {
+	    .fd = imc->ipc_handle,
+	    .events = POLLRDHUP,
+	};
+
+	int ret = poll(&pfd, 1, 0);
+	if (ret < 0) {
+		return errno != EINTR;
+	}
+
+	return (pfd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) != 0;
+}
+
+#else // XRT_OS_WINDOWS
+
+static inline HANDLE
+get_event(struct ipc_message_channel *imc, struct ipc_command_ring_buffer *rb, bool writer)
+{
+	uint32_t index = rb == &imc->ring->to_server ? IPC_COMMAND_RING_EVENT_TO_SERVER_READER
+	                                             : IPC_COMMAND_RING_EVENT_TO_CLIENT_READER;
+
+	// The writer event always follows the reader one.
+	return imc->ring_events[index + (writer ? 1 : 0)];
+}
+
+static void
+sleep_on(struct ipc_message_channel *imc,
+         struct ipc_command_ring_buffer *rb,
+         bool as_writer,
+         uint32_t *pos,
+         uint32_t seen,
+         uint32_t timeout_ms)
+{
+	/*
+	 * Auto-reset, if the other side signalled after we checked the
+	 * position this returns straight away. A stale signal only makes us
+	 * return early, the caller checks the position again.
+	 */
+	WaitForSingleObject(get_event(imc, rb, as_writer), timeout_ms);
+}
+
+static void
+wake_up(struct ipc_message_channel *imc, struct ipc_command_ring_buffer *rb, bool wake_writer, uint32_t *pos)
+{
+	SetEvent(get_event(imc, rb, wake_writer));
+}
+
+static bool
+peer_hung_up(struct ipc_message_channel *imc)
+{
+	// The pipe is still the connection, it breaks when the other side goes away.
+	return !PeekNamedPipe(imc->ipc_handle, NULL, 0, NULL, NULL, NULL);
+}
+
+#endif
+
+/*!
+ * Wait for the other side's position in @p rb to move away from @p seen, or
+ * @p timeout_ms to pass, the caller is responsible for checking the position
+ * again. The writer waits on the read position and the reader on the write
+ * position.
+ */
+static xrt_result_t
+wait_for_change(struct ipc_message_channel *imc,
+                struct ipc_command_ring_buffer *rb,
+                bool as_writer,
+                uint32_t seen,
+                uint32_t timeout_ms)
+{
+	uint32_t *pos = as_writer ? &rb->read_pos : &rb->write_pos;
+	uint32_t *waiting = as_writer ? &rb->writer_waiting : &rb->reader_waiting;
+
+	for (uint32_t i = 0; i < SPIN_COUNT; i++) {
+		if (u_atomic_u32_load_acquire(pos) != seen) {
+			return XRT_SUCCESS;
+		}
+	}
+
+	/*
+	 * The other side stores its position and then loads the waiting flag,
+	 * we store the flag then load the position, with both sequentially
+	 * consistent at least one of us sees the others store.
+	 */
+	u_atomic_u32_store_seq_cst(waiting, 1);
+	if (u_atomic_u32_load_seq_cst(pos) == seen) {
+		sleep_on(imc, rb, as_writer, pos, seen, timeout_ms);
+	}
+	u_atomic_u32_store_relaxed(waiting, 0);
+
+	if (u_atomic_u32_load_acquire(pos) == seen && peer_hung_up(imc)) {
+		IPC_INFO(imc, "Other side hung up on the command ring.");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
+//! Store our new position in @p rb and wake the other side if it sleeps on it.
+static inline void
+publish(struct ipc_message_channel *imc, struct ipc_command_ring_buffer *rb, bool as_writer, uint32_t value)
+{
+	uint32_t *pos = as_writer ? &rb->write_pos : &rb->read_pos;
+	uint32_t *waiting = as_writer ? &rb->reader_waiting : &rb->writer_waiting;
+
+	u_atomic_u32_store_seq_cst(pos, value);
+	if (u_atomic_u32_load_seq_cst(waiting) != 0) {
+		wake_up(imc, rb, !as_writer, pos);
+	}
+}
+
+static void
+copy_in(struct ipc_command_ring_buffer *rb, uint32_t pos, const uint8_t *src, uint32_t size)
+{
+	uint32_t offset = pos & MASK;
+	uint32_t first = IPC_COMMAND_RING_SIZE - offset;
+	if (first > size) {
+		first = size;
+	}
+
+	memcpy(&rb->data[offset], src, first);
+	memcpy(&rb->data[0], src + first, size - first);
+}
+
+static void
+copy_out(const struct ipc_command_ring_buffer *rb, uint32_t pos, uint8_t *dst, uint32_t size)
+{
+	uint32_t offset = pos & MASK;
+	uint32_t first = IPC_COMMAND_RING_SIZE - offset;
+	if (first > size) {
+		first = size;
+	}
+
+	memcpy(dst, &rb->data[offset], first);
+	memcpy(dst + first, &rb->data[0], size - first);
+}
+
+/*!
+ * Returns the number of readable bytes, or -1 if the other side has written
+ * garbage to the positions.
+ */
+static inline int64_t
+readable(struct ipc_command_ring_buffer *rb, uint32_t *out_read_pos, uint32_t *out_write_pos)
+{
+	uint32_t r = u_atomic_u32_load_relaxed(&rb->read_pos);
+	uint32_t w = u_atomic_u32_load_acquire(&rb->write_pos);
+	uint32_t used = w - r;
+
+	*out_read_pos = r;
+	*out_write_pos = w;
+
+	return used > IPC_COMMAND_RING_SIZE ? -1 : (int64_t)used;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+xrt_result_t
+ipc_command_ring_write(struct ipc_message_channel *imc, const void *data, size_t size)
+{
+	struct ipc_command_ring_buffer *rb = tx_buffer(imc);
+	const uint8_t *src = (const uint8_t *)data;
+	xrt_result_t xret;
+
+	while (size > 0) {
+		uint32_t w = u_atomic_u32_load_relaxed(&rb->write_pos);
+		uint32_t r = u_atomic_u32_load_acquire(&rb->read_pos);
+		uint32_t used = w - r;
+
+		if (used > IPC_COMMAND_RING_SIZE) {
+			IPC_ERROR(imc, "Command ring corrupted (used: %u)!", used);
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		uint32_t space = IPC_COMMAND_RING_SIZE - used;
+		if (space == 0) {
+			xret = wait_for_change(imc, rb, true, r, SLEEP_SLICE_MS);
+			if (xret != XRT_SUCCESS) {
+				return xret;
+			}
+			continue;
+		}
+
+		uint32_t count = size < space ? (uint32_t)size : space;
+		copy_in(rb, w, src, count);
+		publish(imc, rb, true, w + count);
+
+		src += count;
+		size -= count;
+	}
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_command_ring_read(struct ipc_message_channel *imc, void *out_data, size_t size)
+{
+	struct ipc_command_ring_buffer *rb = rx_buffer(imc);
+	uint8_t *dst = (uint8_t *)out_data;
+	xrt_result_t xret;
+
+	while (size > 0) {
+		uint32_t r, w;
+		int64_t used = readable(rb, &r, &w);
+
+		if (used < 0) {
+			IPC_ERROR(imc, "Command ring corrupted (used: %u)!", w - r);
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		if (used == 0) {
+			xret = wait_for_change(imc, rb, false, w, SLEEP_SLICE_MS);
+			if (xret != XRT_SUCCESS) {
+				return xret;
+			}
+			continue;
+		}
+
+		uint32_t count = size < (size_t)used ? (uint32_t)size : (uint32_t)used;
+		copy_out(rb, r, dst, count);
+		publish(imc, rb, false, r + count);
+
+		dst += count;
+		size -= count;
+	}
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_command_ring_peek(
+    struct ipc_message_channel *imc, void *out_data, size_t size, uint32_t timeout_ms, bool *out_peeked)
+{
+	struct ipc_command_ring_buffer *rb = rx_buffer(imc);
+	xrt_result_t xret;
+
+	*out_peeked = false;
+
+	if (size > IPC_COMMAND_RING_SIZE) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	uint32_t r, w;
+	int64_t used = readable(rb, &r, &w);
+
+	// Only wait once, the caller loops when we time out.
+	if (used >= 0 && (size_t)used < size) {
+		xret = wait_for_change(imc, rb, false, w, timeout_ms);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+		used = readable(rb, &r, &w);
+	}
+
+	if (used < 0) {
+		IPC_ERROR(imc, "Command ring corrupted (used: %u)!", w - r);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	if ((size_t)used < size) {
+		return XRT_SUCCESS;
+	}
+
+	copy_out(rb, r, (uint8_t *)out_data, (uint32_t)size);
+	*out_peeked = true;
+
+	return XRT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory command ring transport for the IPC message channel.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_config_os.h"
+#include "xrt/xrt_results.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ipc_message_channel;
+
+//! Size in bytes of each direction of the command ring, must be a power of two.
+#define IPC_COMMAND_RING_SIZE (64 * 1024)
+
+#ifdef XRT_OS_WINDOWS
+/*!
+ * Windows can't wait on an address shared between processes, instead each
+ * side that can sleep has an auto-reset event, created by the service and
+ * sent with the shared memory handle in this order.
+ *
+ * @ingroup ipc_shared
+ */
+enum ipc_command_ring_event
+{
+	//! Signalled when data is written to the service, it waits on it.
+	IPC_COMMAND_RING_EVENT_TO_SERVER_READER = 0,
+	//! Signalled when the service has read data, a full client waits on it.
+	IPC_COMMAND_RING_EVENT_TO_SERVER_WRITER = 1,
+	//! Signalled when data is written to the client, it waits on it.
+	IPC_COMMAND_RING_EVENT_TO_CLIENT_READER = 2,
+	//! Signalled when the client has read data, a full service waits on it.
+	IPC_COMMAND_RING_EVENT_TO_CLIENT_WRITER = 3,
+};
+
+//! Number of @ref ipc_command_ring_event.
+#define IPC_COMMAND_RING_EVENT_COUNT (4)
+#else
+//! Other platforms wait on the positions directly.
+#define IPC_COMMAND_RING_EVENT_COUNT (0)
+#endif
+
+//! Number of handles instance_get_command_ring returns, the shared memory first.
+#define IPC_COMMAND_RING_HANDLE_COUNT (1 + IPC_COMMAND_RING_EVENT_COUNT)
+
+/*!
+ * A single producer, single consumer byte ring living in shared memory.
+ *
+ * The positions are free running counters, only the producer writes
+ * @ref write_pos and only the consumer writes @ref read_pos. Both positions
+ * are also used as futex words when a side needs to sleep, on Windows the
+ * events in @ref ipc_command_ring_event are used instead.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_command_ring_buffer
+{
+	//! Total number of bytes written, futex word the consumer sleeps on.
+	uint32_t write_pos;
+
+	//! Total number of bytes read, futex word the producer sleeps on.
+	uint32_t read_pos;
+
+	//! Set by the consumer before it sleeps, so the producer knows to wake it.
+	uint32_t reader_waiting;
+
+	//! Set by the producer before it sleeps, so the consumer knows to wake it.
+	uint32_t writer_waiting;
+
+	uint8_t data[IPC_COMMAND_RING_SIZE];
+};
+
+/*!
+ * The shared memory area used for a command ring, one ring per direction.
+ *
+ * Created by the service per client and attached to both ends
+ * @ref ipc_message_channel, after that all data sent with @ref ipc_send and
+ * @ref ipc_receive goes through it. File descriptors still needs to go over
+ * the socket, Windows handles are duplicated into the other process and then
+ * sent as plain data so they go through the ring too.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_command_ring
+{
+	struct ipc_command_ring_buffer to_server;
+	struct ipc_command_ring_buffer to_client;
+};
+
+/*!
+ * Write @p size bytes into the ring of the channel, blocks while the ring is
+ * full. Called by @ref ipc_send when a ring is attached.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_command_ring_write(struct ipc_message_channel *imc, const void *data, size_t size);
+
+/*!
+ * Read exactly @p size bytes from the ring of the channel, blocks until all
+ * of the data has arrived. Called by @ref ipc_receive when a ring is attached.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_command_ring_read(struct ipc_message_channel *imc, void *out_data, size_t size);
+
+/*!
+ * Wait up to @p timeout_ms for @p size bytes to be available and copy them out
+ * without consuming them, used by the service to look at the next command.
+ *
+ * @param imc              Message channel with a ring attached.
+ * @param[out] out_data    Where to copy the data to.
+ * @param[in] size         Number of bytes to peek.
+ * @param[in] timeout_ms   For how long to wait for the data.
+ * @param[out] out_peeked  Set to false if timed out.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_command_ring_peek(
+    struct ipc_message_channel *imc, void *out_data, size_t size, uint32_t timeout_ms, bool *out_peeked);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,189 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Packing of hand joint sets for sending them over IPC.
+ * @ingroup ipc_shared
+ */
+
+#include "shared/ipc_hand_packing.h"
+
+#include "math/m_api.h"
+#include "math/m_mathinclude.h"
+
+#include <stdint.h>
+
+
+#define POSITION_SCALE ((float)INT16_MAX / IPC_PACKED_HAND_POSITION_RANGE)
+#define ORIENTATION_SCALE ((float)INT16_MAX * (float)M_SQRT2)
+#define RADIUS_SCALE (5000.f)
+
+#define BIT_POSITION_VALID (1 << 0)
+#define BIT_POSITION_TRACKED (1 << 1)
+#define BIT_ORIENTATION_VALID (1 << 2)
+#define BIT_ORIENTATION_TRACKED (1 << 3)
+#define LARGEST_SHIFT (4)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static int16_t
+quantize_i16(float value, float scale)
+{
+	float v = roundf(value * scale);
+	if (v > (float)INT16_MAX) {
+		return INT16_MAX;
+	}
+	if (v < -(float)INT16_MAX) {
+		return -INT16_MAX;
+	}
+	return (int16_t)v;
+}
+
+static uint8_t
+pack_flags(enum xrt_space_relation_flags flags)
+{
+	uint8_t bits = 0;
+	bits |= (flags & XRT_SPACE_RELATION_POSITION_VALID_BIT) != 0 ? BIT_POSITION_VALID : 0;
+	bits |= (flags & XRT_SPACE_RELATION_POSITION_TRACKED_BIT) != 0 ? BIT_POSITION_TRACKED : 0;
+	bits |= (flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0 ? BIT_ORIENTATION_VALID : 0;
+	bits |= (flags & XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT) != 0 ? BIT_ORIENTATION_TRACKED : 0;
+	return bits;
+}
+
+static enum xrt_space_relation_flags
+unpack_flags(uint8_t bits)
+{
+	uint32_t flags = 0;
+	flags |= (bits & BIT_POSITION_VALID) != 0 ? XRT_SPACE_RELATION_POSITION_VALID_BIT : 0;
+	flags |= (bits & BIT_POSITION_TRACKED) != 0 ? XRT_SPACE_RELATION_POSITION_TRACKED_BIT : 0;
+	flags |= (bits & BIT_ORIENTATION_VALID) != 0 ? XRT_SPACE_RELATION_ORIENTATION_VALID_BIT : 0;
+	flags |= (bits & BIT_ORIENTATION_TRACKED) != 0 ? XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT : 0;
+	return (enum xrt_space_relation_flags)flags;
+}
+
+/*!
+ * Smallest three encoding, the largest component is left out and made
+ * positive so it can be recovered from the others, which are then all
+ * within +-1/sqrt(2).
+ */
+static uint8_t
+pack_orientation(const struct xrt_quat *q, int16_t out_values[3])
+{
+	float c[4] = {q->x, q->y, q->z, q->w};
+
+	uint8_t largest = 0;
+	for (uint8_t i = 1; i < 4; i++) {
+		if (fabsf(c[i]) > fabsf(c[largest])) {
+			largest = i;
+		}
+	}
+
+	float sign = c[largest] < 0.f ? -1.f : 1.f;
+
+	for (uint8_t i = 0, k = 0; i < 4; i++) {
+		if (i != largest) {
+			out_values[k++] = quantize_i16(c[i] * sign, ORIENTATION_SCALE);
+		}
+	}
+
+	return largest;
+}
+
+static void
+unpack_orientation(const int16_t values[3], uint8_t largest, struct xrt_quat *out_q)
+{
+	float c[4];
+	float sum = 0.f;
+
+	for (uint8_t i = 0, k = 0; i < 4; i++) {
+		if (i != largest) {
+			c[i] = (float)values[k++] / ORIENTATION_SCALE;
+			sum += c[i] * c[i];
+		}
+	}
+
+	c[largest] = sqrtf(fmaxf(0.f, 1.f - sum));
+
+	*out_q = (struct xrt_quat){c[0], c[1], c[2], c[3]};
+	math_quat_normalize(out_q);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+ipc_pack_hand_joint_set(const struct xrt_hand_joint_set *set, struct ipc_packed_hand_joint_set *out_packed)
+{
+	const struct xrt_hand_joint_value *joints = set->values.hand_joint_set_default;
+
+	out_packed->wrist = joints[XRT_HAND_JOINT_WRIST].relation;
+	out_packed->hand_pose = set->hand_pose;
+	out_packed->is_active = set->is_active;
+
+	struct xrt_pose wrist_inv;
+	math_pose_invert(&out_packed->wrist.pose, &wrist_inv);
+
+	struct xrt_pose poses[XRT_HAND_JOINT_COUNT];
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		poses[i] = joints[i].relation.pose;
+	}
+	math_pose_transform_batch(&wrist_inv, poses, XRT_HAND_JOINT_COUNT, poses);
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		struct ipc_packed_hand_joint *pj = &out_packed->joints[i];
+
+		pj->position[0] = quantize_i16(poses[i].position.x, POSITION_SCALE);
+		pj->position[1] = quantize_i16(poses[i].position.y, POSITION_SCALE);
+		pj->position[2] = quantize_i16(poses[i].position.z, POSITION_SCALE);
+
+		uint8_t largest = pack_orientation(&poses[i].orientation, pj->orientation);
+
+		float radius = roundf(joints[i].radius * RADIUS_SCALE);
+		pj->radius = (uint8_t)fminf(fmaxf(radius, 0.f), (float)UINT8_MAX);
+
+		pj->bits = pack_flags(joints[i].relation.relation_flags) | (uint8_t)(largest << LARGEST_SHIFT);
+	}
+}
+
+void
+ipc_unpack_hand_joint_set(const struct ipc_packed_hand_joint_set *packed, struct xrt_hand_joint_set *out_set)
+{
+	struct xrt_pose poses[XRT_HAND_JOINT_COUNT];
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct ipc_packed_hand_joint *pj = &packed->joints[i];
+
+		poses[i].position.x = (float)pj->position[0] / POSITION_SCALE;
+		poses[i].position.y = (float)pj->position[1] / POSITION_SCALE;
+		poses[i].position.z = (float)pj->position[2] / POSITION_SCALE;
+
+		unpack_orientation(pj->orientation, (pj->bits >> LARGEST_SHIFT) & 0x3, &poses[i].orientation);
+	}
+
+	math_pose_transform_batch(&packed->wrist.pose, poses, XRT_HAND_JOINT_COUNT, poses);
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		struct xrt_hand_joint_value *joint = &out_set->values.hand_joint_set_default[i];
+		const struct ipc_packed_hand_joint *pj = &packed->joints[i];
+
+		joint->relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+		joint->relation.relation_flags = unpack_flags(pj->bits);
+		joint->relation.pose = poses[i];
+		joint->radius = (float)pj->radius / RADIUS_SCALE;
+	}
+
+	// The wrist is sent as is.
+	out_set->values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation = packed->wrist;
+
+	out_set->hand_pose = packed->hand_pose;
+	out_set->is_active = packed->is_active;
+}
@@ -0,0 +1,40 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Packing of hand joint sets for sending them over IPC.
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Packs a joint set, the joints are made relative to the wrist and quantized.
+ * Positions are within about 10 micrometers and radii 0.1 millimeters of the
+ * original, velocities of joints other than the wrist are dropped.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_pack_hand_joint_set(const struct xrt_hand_joint_set *set, struct ipc_packed_hand_joint_set *out_packed);
+
+/*!
+ * Unpacks a joint set packed with @ref ipc_pack_hand_joint_set.
+ *
+ * @ingroup ipc_shared
+ */
+void
+ipc_unpack_hand_joint_set(const struct ipc_packed_hand_joint_set *packed, struct xrt_hand_joint_set *out_set);
+
+
+#ifdef __cplusplus
+}
+#endif
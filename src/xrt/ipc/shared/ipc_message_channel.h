@@ -18,11 +18,14 @@
 
 #include "util/u_logging.h"
 
+#include "shared/ipc_command_ring.h"
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+
 /*!
  * Wrapper for a socket and flags.
  */
@@ -30,6 +33,26 @@ struct ipc_message_channel
 {
 	xrt_ipc_handle_t ipc_handle;
 	enum u_logging_level log_level;
+
+	/*!
+	 * Optional shared memory command ring, supported on Linux, Android and Windows.
+	 * When attached all data sent with @ref ipc_send and @ref ipc_receive
+	 * goes through the ring, the socket is then only used for passing file
+	 * descriptors and noticing the other side hanging up. Owned by the
+	 * channel, unmapped on close.
+	 */
+	struct ipc_command_ring *ring;
+
+	//! Which end of @ref ring this channel is.
+	bool ring_is_server;
+
+#ifdef XRT_OS_WINDOWS
+	//! Events for sleeping on @ref ring, owned by the channel.
+	HANDLE ring_events[IPC_COMMAND_RING_EVENT_COUNT];
+
+	//! Other process opened for duplicating handles into, lazily opened and owned by the channel.
+	HANDLE target_process;
+#endif
 };
 
 /*!
@@ -56,6 +79,23 @@ ipc_message_channel_close(struct ipc_message_channel *imc);
 xrt_result_t
 ipc_send(struct ipc_message_channel *imc, const void *data, size_t size);
 
+/*!
+ * Send a message followed by a variable length payload over the IPC channel,
+ * used by @p varlen calls. Both are gathered straight from the callers memory
+ * into a single send, the other end receives them as two messages.
+ *
+ * @param imc              Message channel to use
+ * @param[in] data         Pointer to the reply to send. Must not be null.
+ * @param[in] size         Size of data pointed-to by @p data, must be greater than 0
+ * @param[in] payload      Pointer to the payload, may be null if @p payload_size is 0.
+ * @param[in] payload_size Size of the payload, must have been sent in the reply.
+ *
+ * @public @memberof ipc_message_channel
+ */
+xrt_result_t
+ipc_send_with_payload(
+    struct ipc_message_channel *imc, const void *data, size_t size, const void *payload, size_t payload_size);
+
 /*!
  * Receive a bare message over the IPC channel.
  *
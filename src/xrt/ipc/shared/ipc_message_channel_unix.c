@@ -18,9 +18,14 @@
 #include "util/u_logging.h"
 #include "util/u_pretty_print.h"
 
+#include "shared/ipc_shmem.h"
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_message_channel.h"
 
+#ifdef XRT_OS_LINUX
+#include "shared/ipc_command_ring.h"
+#endif
+
 #include <errno.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -64,6 +69,12 @@ union imcontrol_buf {
 void
 ipc_message_channel_close(struct ipc_message_channel *imc)
 {
+#ifdef XRT_OS_LINUX
+	if (imc->ring != NULL) {
+		ipc_shmem_unmap((void **)&imc->ring, sizeof(struct ipc_command_ring));
+	}
+#endif
+
 	if (imc->ipc_handle < 0) {
 		return;
 	}
@@ -74,6 +85,12 @@ ipc_message_channel_close(struct ipc_message_channel *imc)
 xrt_result_t
 ipc_send(struct ipc_message_channel *imc, const void *data, size_t size)
 {
+#ifdef XRT_OS_LINUX
+	if (imc->ring != NULL) {
+		return ipc_command_ring_write(imc, data, size);
+	}
+#endif
+
 	struct msghdr msg = {0};
 	struct iovec iov = {0};
 
@@ -96,9 +113,77 @@ ipc_send(struct ipc_message_channel *imc, const void *data, size_t size)
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_send_with_payload(
+    struct ipc_message_channel *imc, const void *data, size_t size, const void *payload, size_t payload_size)
+{
+	if (payload_size == 0) {
+		return ipc_send(imc, data, size);
+	}
+
+#ifdef XRT_OS_LINUX
+	if (imc->ring != NULL) {
+		xrt_result_t xret = ipc_command_ring_write(imc, data, size);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+		return ipc_command_ring_write(imc, payload, payload_size);
+	}
+#endif
+
+	struct msghdr msg = {0};
+	struct iovec iov[2] = {0};
+
+	iov[0].iov_base = (void *)data;
+	iov[0].iov_len = size;
+	iov[1].iov_base = (void *)payload;
+	iov[1].iov_len = payload_size;
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	size_t total = size + payload_size;
+	size_t sent = 0;
+
+	// Large payloads might not fit in the socket buffer in one go.
+	while (sent < total) {
+		ssize_t ret = sendmsg(imc->ipc_handle, &msg, MSG_NOSIGNAL);
+		if (ret < 0) {
+			int code = errno;
+			if (code == EINTR) {
+				continue;
+			}
+			IPC_ERROR(imc, "sendmsg(%i) failed: '%i' '%s'!", imc->ipc_handle, code, strerror(code));
+			return XRT_ERROR_IPC_FAILURE;
+		}
+
+		sent += (size_t)ret;
+
+		// Skip over what has been sent.
+		size_t skip = (size_t)ret;
+		while (msg.msg_iovlen > 0 && skip >= msg.msg_iov[0].iov_len) {
+			skip -= msg.msg_iov[0].iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+		if (msg.msg_iovlen > 0) {
+			msg.msg_iov[0].iov_base = (uint8_t *)msg.msg_iov[0].iov_base + skip;
+			msg.msg_iov[0].iov_len -= skip;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
 {
+#ifdef XRT_OS_LINUX
+	if (imc->ring != NULL) {
+		return ipc_command_ring_read(imc, out_data, size);
+	}
+#endif
+
 	// wait for the response
 	struct iovec iov = {0};
 	struct msghdr msg = {0};
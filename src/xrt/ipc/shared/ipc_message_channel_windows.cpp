@@ -21,7 +21,9 @@
 #include "util/u_logging.h"
 
 #include "shared/ipc_utils.h"
+#include "shared/ipc_shmem.h"
 #include "shared/ipc_protocol.h"
+#include "shared/ipc_command_ring.h"
 #include "shared/ipc_message_channel.h"
 
 #include <stdio.h>
@@ -51,9 +53,17 @@
  *
  */
 
+/*!
+ * The other process doesn't change for the lifetime of the pipe, so it is
+ * opened on the first handle transfer and kept until the channel is closed.
+ */
 static HANDLE
-open_target_process_dup_handle(struct ipc_message_channel *imc)
+get_target_process_dup_handle(struct ipc_message_channel *imc)
 {
+	if (imc->target_process != NULL) {
+		return imc->target_process;
+	}
+
 	DWORD flags;
 	if (!GetNamedPipeInfo(imc->ipc_handle, &flags, NULL, NULL, NULL)) {
 		DWORD err = GetLastError();
@@ -84,6 +94,8 @@ open_target_process_dup_handle(struct ipc_message_channel *imc)
 		IPC_ERROR(imc, "OpenProcess(PROCESS_DUP_HANDLE, pid %d) failed: %d %s", pid, err, ipc_winerror(err));
 	}
 
+	imc->target_process = h;
+
 	return h;
 }
 
@@ -97,6 +109,22 @@ open_target_process_dup_handle(struct ipc_message_channel *imc)
 void
 ipc_message_channel_close(struct ipc_message_channel *imc)
 {
+	if (imc->ring != NULL) {
+		ipc_shmem_unmap((void **)&imc->ring, sizeof(struct ipc_command_ring));
+	}
+
+	for (uint32_t i = 0; i < IPC_COMMAND_RING_EVENT_COUNT; i++) {
+		if (imc->ring_events[i] != NULL) {
+			CloseHandle(imc->ring_events[i]);
+			imc->ring_events[i] = NULL;
+		}
+	}
+
+	if (imc->target_process != NULL) {
+		CloseHandle(imc->target_process);
+		imc->target_process = NULL;
+	}
+
 	if (imc->ipc_handle != INVALID_HANDLE_VALUE) {
 		CloseHandle(imc->ipc_handle);
 		imc->ipc_handle = INVALID_HANDLE_VALUE;
@@ -106,6 +134,10 @@ ipc_message_channel_close(struct ipc_message_channel *imc)
 xrt_result_t
 ipc_send(struct ipc_message_channel *imc, const void *data, size_t size)
 {
+	if (imc->ring != NULL) {
+		return ipc_command_ring_write(imc, data, size);
+	}
+
 	DWORD len;
 	if (!WriteFile(imc->ipc_handle, data, DWORD(size), &len, NULL)) {
 		DWORD err = GetLastError();
@@ -115,9 +147,25 @@ ipc_send(struct ipc_message_channel *imc, const void *data, size_t size)
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_send_with_payload(
+    struct ipc_message_channel *imc, const void *data, size_t size, const void *payload, size_t payload_size)
+{
+	// Message mode pipe, the other end reads these as two messages, so does the ring.
+	auto rc = ipc_send(imc, data, size);
+	if (rc != XRT_SUCCESS || payload_size == 0) {
+		return rc;
+	}
+	return ipc_send(imc, payload, payload_size);
+}
+
 xrt_result_t
 ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
 {
+	if (imc->ring != NULL) {
+		return ipc_command_ring_read(imc, out_data, size);
+	}
+
 	DWORD len;
 	if (!ReadFile(imc->ipc_handle, out_data, DWORD(size), &len, NULL)) {
 		DWORD err = GetLastError();
@@ -134,6 +182,45 @@ ipc_receive(struct ipc_message_channel *imc, void *out_data, size_t size)
  *
  */
 
+/*!
+ * The pipe is in message mode so the receiver can read fewer handles than it
+ * asked for, the ring is a byte stream so the count is sent first there.
+ */
+static xrt_result_t
+send_handle_values(struct ipc_message_channel *imc, const HANDLE *handles, uint32_t handle_count)
+{
+	if (imc->ring == NULL) {
+		return ipc_send(imc, handles, handle_count * sizeof(*handles));
+	}
+
+	xrt_result_t xret = ipc_command_ring_write(imc, &handle_count, sizeof(handle_count));
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+	return ipc_command_ring_write(imc, handles, handle_count * sizeof(*handles));
+}
+
+static xrt_result_t
+receive_handle_values(struct ipc_message_channel *imc, HANDLE *out_handles, uint32_t handle_count)
+{
+	if (imc->ring == NULL) {
+		return ipc_receive(imc, out_handles, handle_count * sizeof(*out_handles));
+	}
+
+	uint32_t count = 0;
+	xrt_result_t xret = ipc_command_ring_read(imc, &count, sizeof(count));
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	if (count > handle_count) {
+		IPC_ERROR(imc, "Got %u handles, expected at most %u!", count, handle_count);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return ipc_command_ring_read(imc, out_handles, count * sizeof(*out_handles));
+}
+
 xrt_result_t
 ipc_receive_handles(
     struct ipc_message_channel *imc, void *out_data, size_t size, HANDLE *out_handles, uint32_t handle_count)
@@ -142,7 +229,7 @@ ipc_receive_handles(
 	if (rc != XRT_SUCCESS) {
 		return rc;
 	}
-	return ipc_receive(imc, out_handles, handle_count * sizeof(*out_handles));
+	return receive_handle_values(imc, out_handles, handle_count);
 }
 
 xrt_result_t
@@ -155,13 +242,13 @@ ipc_send_handles(
 	}
 
 	if (!handle_count) {
-		return ipc_send(imc, nullptr, 0);
+		return send_handle_values(imc, nullptr, 0);
 	}
 
-	HANDLE target_process = open_target_process_dup_handle(imc);
+	HANDLE target_process = get_target_process_dup_handle(imc);
 	if (!target_process) {
 		DWORD err = GetLastError();
-		IPC_ERROR(imc, "open_target_process_dup_handle failed: %d %s", err, ipc_winerror(err));
+		IPC_ERROR(imc, "get_target_process_dup_handle failed: %d %s", err, ipc_winerror(err));
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
@@ -177,13 +264,13 @@ ipc_send_handles(
 		                            DUPLICATE_SAME_ACCESS)) {
 			DWORD err = GetLastError();
 			IPC_ERROR(imc, "DuplicateHandle(%p) failed: %d %s", handles[i], err, ipc_winerror(err));
-			CloseHandle(target_process);
 			return XRT_ERROR_IPC_FAILURE;
 		}
 		v.push_back(handle);
 	}
-	CloseHandle(target_process);
-	return ipc_send(imc, v.data(), v.size() * sizeof(*v.data()));
+
+	// Once duplicated the handles are plain values, they go through the ring if attached.
+	return send_handle_values(imc, v.data(), (uint32_t)v.size());
 }
 
 
@@ -24,6 +24,9 @@
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_config_build.h"
 
+#include "util/u_seqlock.h"
+#include "util/u_metrics.h"
+
 #include <sys/types.h>
 
 
@@ -32,19 +35,27 @@
 #define IPC_MAX_VIEWS 8    // max views we will return configs for
 #define IPC_MAX_FORMATS 32 // max formats our server-side compositor supports
 #define IPC_MAX_DEVICES 8  // max number of devices we will map using shared mem
-#define IPC_MAX_LAYERS 16
+#define IPC_MAX_LAYERS XRT_MAX_LAYERS
 #define IPC_MAX_SLOTS 128
 #define IPC_MAX_CLIENTS 8
 #define IPC_MAX_RAW_VIEWS 32 // Max views that we can get, artificial limit.
 #define IPC_EVENT_QUEUE_SIZE 32
+#define IPC_MAX_LOCATE_SPACES 64 // max spaces located per space_locate_spaces call
+
+#define IPC_SHARED_MAX_DEVICE_POSES 4 // max pose inputs per device published in shared memory
+#define IPC_SHARED_POSE_RING_SIZE 16  // must be a power of two
+#define IPC_SHARED_POSE_IDLE_NS (1000 * 1000 * 1000) // rings not read by any client for this long are not sampled
 
-#define IPC_SHARED_MAX_INPUTS 1024
-#define IPC_SHARED_MAX_OUTPUTS 128
-#define IPC_SHARED_MAX_BINDINGS 64
+#define IPC_PACKED_HAND_POSITION_RANGE 0.5f // farthest in meters a packed hand joint can be from the wrist
 
 // example: v21.0.0-560-g586d33b5
 #define IPC_VERSION_NAME_LEN 64
 
+// bump when the layout of ipc_shared_memory changes
+#define IPC_SHARED_MEMORY_LAYOUT_VERSION 3
+// regions of the shared memory start on their own cache line
+#define IPC_SHARED_REGION_ALIGNMENT 64
+
 #if defined(XRT_OS_WINDOWS) && !defined(XRT_ENV_MINGW)
 typedef int pid_t;
 #endif
@@ -136,6 +147,83 @@ struct ipc_shared_device
 	bool stage_supported;
 };
 
+/*!
+ * A single sample of a published pose.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_sample
+{
+	uint64_t timestamp_ns;
+	struct xrt_space_relation relation;
+};
+
+/*!
+ * A ring of the latest sampled poses for a single pose input on a device,
+ * written by the service and read by clients without any round trip.
+ *
+ * Protected by @ref lock, the service is the only writer.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_pose_ring
+{
+	//! Which pose input is published in this ring.
+	enum xrt_input_name name;
+
+	//! Guards @ref sample_count and @ref samples.
+	struct u_seqlock lock;
+
+	//! Total number of samples ever pushed, the newest is at (count - 1) % size.
+	uint64_t sample_count;
+
+	struct ipc_shared_pose_sample samples[IPC_SHARED_POSE_RING_SIZE];
+
+	/*!
+	 * Written by the clients with the time they last read this ring, the
+	 * service only samples rings that have been read within
+	 * @ref IPC_SHARED_POSE_IDLE_NS. Not protected by @ref lock.
+	 */
+	uint64_t last_read_ns;
+};
+
+/*!
+ * Published poses for a single device.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_device_poses
+{
+	//! Number of elements in @ref rings that are populated/valid.
+	uint32_t ring_count;
+
+	struct ipc_shared_pose_ring rings[IPC_SHARED_MAX_DEVICE_POSES];
+};
+
+/*!
+ * State of the published inputs of a single device, the inputs themselves are
+ * in @ref ipc_shared_memory_layout::published_inputs at the same offset as in
+ * @ref ipc_shared_memory_layout::inputs.
+ *
+ * Protected by @ref lock, the service is the only writer.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_device_inputs
+{
+	//! Guards @ref sequence, @ref valid and the published inputs.
+	struct u_seqlock lock;
+
+	//! Bumped every time the service publishes inputs that changed.
+	uint64_t sequence;
+
+	/*!
+	 * Cleared while the published inputs can't be used, like when any
+	 * client has io turned off, clients then call device_update_input.
+	 */
+	bool valid;
+};
+
 /*!
  * Data for a single composition layer.
  *
@@ -175,15 +263,94 @@ struct ipc_layer_slot
 };
 
 /*!
- * A big struct that contains all data that is shared to a client, no pointers
- * allowed in this. To get the inputs of a device you go:
+ * An array in the shared memory, placed after the @ref ipc_shared_memory
+ * header, the offset is from the start of the header.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_region
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+/*!
+ * Where the arrays of the shared memory are, sized by the service for the
+ * devices it actually has. The regions are aligned to
+ * @ref IPC_SHARED_REGION_ALIGNMENT, the ones written by the service while
+ * running come after the static ones and are kept apart from the layer slots
+ * that clients write.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_memory_layout
+{
+	//! Checked against @ref IPC_SHARED_MEMORY_LAYOUT_VERSION by the client.
+	uint32_t version;
+
+	//! Size of the whole shared memory, header and regions.
+	uint32_t size;
+
+	/*
+	 * Written once at startup.
+	 */
+
+	//! Of @ref ipc_shared_tracking_origin.
+	struct ipc_shared_region itracks;
+
+	//! Of @ref ipc_shared_device.
+	struct ipc_shared_region isdevs;
+
+	//! Of @ref xrt_output.
+	struct ipc_shared_region outputs;
+
+	//! Of @ref ipc_shared_binding_profile.
+	struct ipc_shared_region binding_profiles;
+
+	//! Of @ref xrt_binding_input_pair.
+	struct ipc_shared_region input_pairs;
+
+	//! Of @ref xrt_binding_output_pair.
+	struct ipc_shared_region output_pairs;
+
+	/*
+	 * Written by the service while running.
+	 */
+
+	//! Of @ref xrt_input, updated on device_update_input calls.
+	struct ipc_shared_region inputs;
+
+	//! Of @ref ipc_shared_device_poses, indexed the same as isdevs.
+	struct ipc_shared_region device_poses;
+
+	//! Of @ref ipc_shared_device_inputs, indexed the same as isdevs.
+	struct ipc_shared_region device_inputs;
+
+	//! Of @ref xrt_input, same indexing as inputs.
+	struct ipc_shared_region published_inputs;
+
+	//! A single @ref u_metrics_stats.
+	struct ipc_shared_region stats;
+
+	/*
+	 * Written by clients.
+	 */
+
+	//! Of @ref ipc_layer_slot.
+	struct ipc_shared_region slots;
+};
+
+/*!
+ * Header of the data that is shared to a client, no pointers allowed in this.
+ * The arrays are placed after it as described by @ref layout, use the
+ * `ipc_shm_*` helpers to get to them. To get the inputs of a device you go:
  *
  * ```C++
  * struct xrt_input *
  * helper(struct ipc_shared_memory *ism, uint32_t device_id, uint32_t input)
  * {
- * 	uint32_t index = ism->isdevs[device_id]->first_input_index + input;
- * 	return &ism->inputs[index];
+ * 	uint32_t index = ipc_shm_isdevs(ism)[device_id].first_input_index + input;
+ * 	return &ipc_shm_inputs(ism)[index];
  * }
  * ```
  *
@@ -193,33 +360,23 @@ struct ipc_shared_memory
 {
 	/*!
 	 * The git revision of the service, used by clients to detect version mismatches.
+	 * Must stay first so it can be read whatever the layout.
 	 */
 	char u_git_tag[IPC_VERSION_NAME_LEN];
 
-	/*!
-	 * Number of elements in @ref itracks that are populated/valid.
-	 */
-	uint32_t itrack_count;
+	//! Must stay right after @ref u_git_tag.
+	struct ipc_shared_memory_layout layout;
 
 	/*!
-	 * @brief Array of shared tracking origin data.
-	 *
-	 * Only @ref itrack_count elements are populated/valid.
+	 * Number of elements in the itracks region that are populated/valid.
 	 */
-	struct ipc_shared_tracking_origin itracks[XRT_SYSTEM_MAX_DEVICES];
+	uint32_t itrack_count;
 
 	/*!
-	 * Number of elements in @ref isdevs that are populated/valid.
+	 * Number of elements in the isdevs region that are populated/valid.
 	 */
 	uint32_t isdev_count;
 
-	/*!
-	 * @brief Array of shared data per device.
-	 *
-	 * Only @ref isdev_count elements are populated/valid.
-	 */
-	struct ipc_shared_device isdevs[XRT_SYSTEM_MAX_DEVICES];
-
 	/*!
 	 * Various roles for the devices.
 	 */
@@ -262,18 +419,135 @@ struct ipc_shared_memory
 		uint32_t blend_mode_count;
 	} hmd;
 
-	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
+	/*!
+	 * How often the service samples and publishes poses into the
+	 * device_poses region, zero if it doesn't publish any poses.
+	 */
+	uint64_t pose_publish_period_ns;
 
-	struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
+	uint64_t startup_timestamp;
+};
 
-	struct ipc_shared_binding_profile binding_profiles[IPC_SHARED_MAX_BINDINGS];
-	struct xrt_binding_input_pair input_pairs[IPC_SHARED_MAX_INPUTS];
-	struct xrt_binding_output_pair output_pairs[IPC_SHARED_MAX_OUTPUTS];
+static inline void *
+ipc_shm_region(struct ipc_shared_memory *ism, const struct ipc_shared_region *region)
+{
+	return (uint8_t *)ism + region->offset;
+}
 
-	struct ipc_layer_slot slots[IPC_MAX_SLOTS];
+static inline struct ipc_shared_tracking_origin *
+ipc_shm_itracks(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_shared_tracking_origin *)ipc_shm_region(ism, &ism->layout.itracks);
+}
 
-	uint64_t startup_timestamp;
-};
+static inline struct ipc_shared_device *
+ipc_shm_isdevs(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_shared_device *)ipc_shm_region(ism, &ism->layout.isdevs);
+}
+
+static inline struct xrt_output *
+ipc_shm_outputs(struct ipc_shared_memory *ism)
+{
+	return (struct xrt_output *)ipc_shm_region(ism, &ism->layout.outputs);
+}
+
+static inline struct ipc_shared_binding_profile *
+ipc_shm_binding_profiles(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_shared_binding_profile *)ipc_shm_region(ism, &ism->layout.binding_profiles);
+}
+
+static inline struct xrt_binding_input_pair *
+ipc_shm_input_pairs(struct ipc_shared_memory *ism)
+{
+	return (struct xrt_binding_input_pair *)ipc_shm_region(ism, &ism->layout.input_pairs);
+}
+
+static inline struct xrt_binding_output_pair *
+ipc_shm_output_pairs(struct ipc_shared_memory *ism)
+{
+	return (struct xrt_binding_output_pair *)ipc_shm_region(ism, &ism->layout.output_pairs);
+}
+
+static inline struct xrt_input *
+ipc_shm_inputs(struct ipc_shared_memory *ism)
+{
+	return (struct xrt_input *)ipc_shm_region(ism, &ism->layout.inputs);
+}
+
+static inline struct ipc_shared_device_poses *
+ipc_shm_device_poses(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_shared_device_poses *)ipc_shm_region(ism, &ism->layout.device_poses);
+}
+
+static inline struct ipc_shared_device_inputs *
+ipc_shm_device_inputs(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_shared_device_inputs *)ipc_shm_region(ism, &ism->layout.device_inputs);
+}
+
+static inline struct xrt_input *
+ipc_shm_published_inputs(struct ipc_shared_memory *ism)
+{
+	return (struct xrt_input *)ipc_shm_region(ism, &ism->layout.published_inputs);
+}
+
+/*!
+ * Live frame timing stats of the compositor and sessions, kept up to date by
+ * the service so monitoring tools can sample them without any round trip,
+ * read with @ref u_metrics_stats_copy.
+ */
+static inline struct u_metrics_stats *
+ipc_shm_stats(struct ipc_shared_memory *ism)
+{
+	return (struct u_metrics_stats *)ipc_shm_region(ism, &ism->layout.stats);
+}
+
+static inline struct ipc_layer_slot *
+ipc_shm_slots(struct ipc_shared_memory *ism)
+{
+	return (struct ipc_layer_slot *)ipc_shm_region(ism, &ism->layout.slots);
+}
+
+/*!
+ * Is the @p layout usable for a shared memory of @p size bytes, every region
+ * has to fit and be aligned.
+ */
+static inline bool
+ipc_shared_memory_layout_is_valid(const struct ipc_shared_memory_layout *layout, size_t size)
+{
+#define CHECK_REGION(NAME, TYPE)                                                                                       \
+	do {                                                                                                           \
+		if (layout->NAME.offset % IPC_SHARED_REGION_ALIGNMENT != 0 ||                                          \
+		    layout->NAME.offset < sizeof(struct ipc_shared_memory) || layout->NAME.offset > size ||            \
+		    layout->NAME.count > (size - layout->NAME.offset) / sizeof(TYPE)) {                                \
+			return false;                                                                                  \
+		}                                                                                                      \
+	} while (false)
+
+	if (layout->version != IPC_SHARED_MEMORY_LAYOUT_VERSION || layout->size > size) {
+		return false;
+	}
+
+	CHECK_REGION(itracks, struct ipc_shared_tracking_origin);
+	CHECK_REGION(isdevs, struct ipc_shared_device);
+	CHECK_REGION(outputs, struct xrt_output);
+	CHECK_REGION(binding_profiles, struct ipc_shared_binding_profile);
+	CHECK_REGION(input_pairs, struct xrt_binding_input_pair);
+	CHECK_REGION(output_pairs, struct xrt_binding_output_pair);
+	CHECK_REGION(inputs, struct xrt_input);
+	CHECK_REGION(device_poses, struct ipc_shared_device_poses);
+	CHECK_REGION(device_inputs, struct ipc_shared_device_inputs);
+	CHECK_REGION(published_inputs, struct xrt_input);
+	CHECK_REGION(stats, struct u_metrics_stats);
+	CHECK_REGION(slots, struct ipc_layer_slot);
+
+#undef CHECK_REGION
+
+	return true;
+}
 
 /*!
  * Initial info from a client when it connects.
@@ -290,6 +564,37 @@ struct ipc_client_list
 	uint32_t id_count;
 };
 
+/*!
+ * Type of @ref ipc_system_event, the values are shared with libmonado.
+ *
+ * @ingroup ipc
+ */
+enum ipc_system_event_type
+{
+	IPC_SYSTEM_EVENT_CLIENT_CONNECTED = 1,
+	IPC_SYSTEM_EVENT_CLIENT_DISCONNECTED = 2,
+	//! Primary, session or io state of a client changed.
+	IPC_SYSTEM_EVENT_CLIENT_STATE_CHANGED = 3,
+	IPC_SYSTEM_EVENT_ROLES_CHANGED = 4,
+	IPC_SYSTEM_EVENT_LOCAL_SPACES_RECENTERED = 5,
+	//! The subscriber didn't keep up and events were dropped before this one.
+	IPC_SYSTEM_EVENT_EVENTS_LOST = 6,
+};
+
+/*!
+ * Event pushed to clients subscribed with system_subscribe_events, each is
+ * sent as one packet on the socket handed out by that call.
+ *
+ * @ingroup ipc
+ */
+struct ipc_system_event
+{
+	uint32_t type;
+
+	//! Client the event is about, zero if not about a single client.
+	uint32_t client_id;
+};
+
 /*!
  * State for a connected application.
  *
@@ -311,6 +616,21 @@ struct ipc_app_state
 	struct xrt_instance_info info;
 };
 
+/*!
+ * Everything a monitoring tool polls for, in one reply.
+ *
+ * @ingroup ipc
+ */
+struct ipc_system_snapshot
+{
+	//! State of all connected clients, same as system_get_client_info.
+	struct ipc_app_state clients[IPC_MAX_CLIENTS];
+	uint32_t client_count;
+
+	//! Static device info is in @ref ipc_shared_memory, only the roles change.
+	struct xrt_system_roles roles;
+};
+
 
 /*!
  * Arguments for creating swapchains from native images.
@@ -329,3 +649,41 @@ struct ipc_info_get_view_poses_2
 	struct xrt_pose poses[2];
 	struct xrt_space_relation head_relation;
 };
+
+/*!
+ * A single joint of a @ref ipc_packed_hand_joint_set, relative to the wrist.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_packed_hand_joint
+{
+	//! Position in units of @ref IPC_PACKED_HAND_POSITION_RANGE / INT16_MAX meters.
+	int16_t position[3];
+
+	//! The three smallest components of the orientation, scaled by sqrt(2) * INT16_MAX.
+	int16_t orientation[3];
+
+	//! Radius in fifths of a millimeter.
+	uint8_t radius;
+
+	//! Position and orientation valid and tracked bits, and which orientation component was left out.
+	uint8_t bits;
+};
+
+/*!
+ * A hand joint set packed to about a third of the size of a
+ * @ref xrt_hand_joint_set, see @ref ipc_pack_hand_joint_set.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_packed_hand_joint_set
+{
+	//! Kept as is, has the velocities of the hand.
+	struct xrt_space_relation wrist;
+
+	struct xrt_space_relation hand_pose;
+
+	struct ipc_packed_hand_joint joints[XRT_HAND_JOINT_COUNT];
+
+	bool is_active;
+};
@@ -84,6 +84,10 @@ def write_msg_struct(f, call, ident):
 
 
 def write_reply_struct(f, call, ident):
+    # No reply struct
+    if call.noreply:
+        return
+
     # Reply struct
     if call.out_args:
         f.write(ident + "struct ipc_" + call.name + "_reply _reply;\n")
@@ -296,6 +300,7 @@ class Call:
         self.in_handles = None
         self.out_handles = None
         self.varlen = False
+        self.noreply = False
         for key, val in data.items():
             if key == 'id':
                 self.id = val
@@ -309,12 +314,17 @@ class Call:
                 self.in_handles = HandleType(val)
             elif key == 'varlen':
                 self.varlen = val
+            elif key == 'noreply':
+                self.noreply = val
             else:
                 raise RuntimeError("Unrecognized key")
         if not self.id:
             self.id = "IPC_" + name.upper()
         if self.varlen and (self.in_handles or self.out_handles):
             raise Exception("Can not have handles with varlen functions")
+        if self.noreply and (self.varlen or self.out_args or
+                             self.in_handles or self.out_handles):
+            raise Exception("Can only have in arguments with noreply functions")
 
 
 class Proto:
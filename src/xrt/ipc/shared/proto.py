@@ -73,6 +73,13 @@ def write_call_definition(f, call):
 
     # Prepare initial sending
     write_msg_send(f, 'xrt_result_t ret', indent="\t")
+
+    # The service doesn't reply, we are done.
+    if call.noreply:
+        f.write("\n\n\t" + cleanup)
+        f.write("\n\treturn ret;\n}\n")
+        return
+
     write_result_handler(f, 'ret', cleanup, indent="\t")
 
     if call.in_handles:
@@ -277,8 +284,16 @@ def generate_server_c(file, p):
 
 #include "ipc_server_generated.h"
 
+#include <assert.h>
+
 ''')
 
+    # The server reads commands into a fixed size buffer.
+    for call in p.calls:
+        if call.needs_msg_struct:
+            f.write("static_assert(sizeof(struct ipc_{0}_msg) <= IPC_BUF_SIZE, "
+                    "\"ipc_{0}_msg too large for IPC_BUF_SIZE\");\n".format(call.name))
+
     f.write('''
 xrt_result_t
 ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
@@ -299,6 +314,8 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
 
         if call.varlen:
             f.write("\t\t// No return arguments")
+        elif call.noreply:
+            f.write("\t\t// No reply")
         elif call.out_args:
             f.write("\t\tstruct ipc_%s_reply reply = {0};\n" % call.name)
         else:
@@ -383,7 +400,7 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
 
         # Should we put the return in the reply or return it?
         return_target = 'reply.result'
-        if call.varlen:
+        if call.varlen or call.noreply:
             return_target = 'xrt_result_t xret'
 
         write_invocation(f, return_target, 'ipc_handle_' +
@@ -393,6 +410,16 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
         # TODO do we check reply.result and
         # error out before replying if it's not success?
 
+        # The client isn't waiting for the result, don't disconnect it.
+        if call.noreply:
+            f.write("\t\tif (xret != XRT_SUCCESS) {\n")
+            f.write("\t\t\tIPC_WARN(ics->server, \"Failed " + call.name +
+                    " with no reply: %d\", xret);\n")
+            f.write("\t\t}\n")
+            f.write("\t\treturn XRT_SUCCESS;\n")
+            f.write("\t}\n")
+            continue
+
         if not call.varlen:
             func = 'ipc_send'
             args = ["(struct ipc_message_channel *)&ics->imc",
@@ -10,6 +10,7 @@
 
 #include "xrt/xrt_frame.h"
 #include "util/u_misc.h"
+#include "util/u_frame.h"
 #include "util/u_logging.h"
 
 #include "ogl/ogl_api.h"
@@ -18,10 +19,19 @@
 
 #include <pthread.h>
 #include <limits.h>
+#include <string.h>
 
 
+//! Frames this wide or high are halved before being uploaded.
+#define DOWNSAMPLE_SIZE (1024)
+
 /*!
  * An @ref xrt_frame_sink that shows sunk frames in the GUI.
+ *
+ * Pushed frames are copied, and halved if large, into a frame owned by the
+ * sink, so no reference to the producer's frame is held until the GUI thread
+ * gets around to uploading it.
+ *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
  */
@@ -32,28 +42,113 @@ struct gui_ogl_sink
 	struct xrt_frame_sink sink;
 	struct xrt_frame_node node;
 
+	//! Latest copied frame waiting to be uploaded, protected by mutex.
 	struct xrt_frame *frame;
 
+	//! Size of the frame before it was downsampled, protected by mutex.
+	uint32_t full_width, full_height;
+
 	pthread_mutex_t mutex;
 
 	bool running;
 };
 
+static uint32_t
+bytes_per_pixel(enum xrt_format format)
+{
+	switch (format) {
+	case XRT_FORMAT_R8G8B8: return 3;
+	case XRT_FORMAT_R8G8B8A8:
+	case XRT_FORMAT_R8G8B8X8: return 4;
+	case XRT_FORMAT_L8: return 1;
+	default: return 0;
+	}
+}
+
+//! Averages each 2x2 block of pixels, odd edges are dropped.
+static void
+downsample_half(const struct xrt_frame *src, struct xrt_frame *dst, uint32_t bpp)
+{
+	for (uint32_t y = 0; y < dst->height; y++) {
+		const uint8_t *row0 = src->data + (size_t)(y * 2) * src->stride;
+		const uint8_t *row1 = row0 + src->stride;
+		uint8_t *out = dst->data + (size_t)y * dst->stride;
+
+		for (uint32_t x = 0; x < dst->width; x++) {
+			const uint8_t *p0 = row0 + (size_t)(x * 2) * bpp;
+			const uint8_t *p1 = row1 + (size_t)(x * 2) * bpp;
+
+			for (uint32_t c = 0; c < bpp; c++) {
+				uint32_t sum = p0[c] + p0[c + bpp] + p1[c] + p1[c + bpp];
+				out[x * bpp + c] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+//! Sink owned copy of @p xf to upload, NULL if the format isn't supported.
+static struct xrt_frame *
+make_upload_frame(struct xrt_frame *xf)
+{
+	uint32_t bpp = bytes_per_pixel(xf->format);
+	if (bpp == 0) {
+		return NULL;
+	}
+
+	bool half = xf->width >= DOWNSAMPLE_SIZE || xf->height >= DOWNSAMPLE_SIZE;
+	uint32_t w = half ? xf->width / 2 : xf->width;
+	uint32_t h = half ? xf->height / 2 : xf->height;
+
+	struct xrt_frame *copy = NULL;
+	u_frame_create_one_off(xf->format, w, h, &copy);
+	if (copy == NULL) {
+		return NULL;
+	}
+
+	if (half) {
+		downsample_half(xf, copy, bpp);
+	} else {
+		for (uint32_t y = 0; y < h; y++) {
+			memcpy(copy->data + (size_t)y * copy->stride, xf->data + (size_t)y * xf->stride, (size_t)w * bpp);
+		}
+	}
+
+	copy->timestamp = xf->timestamp;
+	copy->source_timestamp = xf->source_timestamp;
+	copy->source_sequence = xf->source_sequence;
+	copy->source_id = xf->source_id;
+
+	return copy;
+}
+
 static void
 push_frame(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 {
 	struct gui_ogl_sink *s = container_of(xs, struct gui_ogl_sink, sink);
 
+	// Copy without holding the lock, the GUI thread only ever waits for a swap.
+	struct xrt_frame *copy = make_upload_frame(xf);
+	if (copy == NULL) {
+		return;
+	}
+
 	// The fields are protected.
 	pthread_mutex_lock(&s->mutex);
 
-	// If we are in the process of shutting down, don't take the reference.
+	// If we are in the process of shutting down, don't keep the frame.
 	if (s->running) {
-		xrt_frame_reference(&s->frame, xf);
+		struct xrt_frame *old = s->frame;
+		s->frame = copy;
+		s->full_width = xf->width;
+		s->full_height = xf->height;
+		copy = old;
 	}
 
 	// Done
 	pthread_mutex_unlock(&s->mutex);
+
+	// Either the replaced frame, or our copy if not running.
+	xrt_frame_reference(&copy, NULL);
 }
 
 static void
@@ -120,12 +215,16 @@ gui_ogl_sink_update(struct gui_ogl_texture *tex)
 	pthread_mutex_lock(&s->mutex);
 
 	struct xrt_frame *frame = NULL;
+	uint32_t full_width = 0;
+	uint32_t full_height = 0;
 
 	// Only take the frame if we are running.
 	if (s->running) {
 		// Take the frame no need to adjust reference.
 		frame = s->frame;
 		s->frame = NULL;
+		full_width = s->full_width;
+		full_height = s->full_height;
 	}
 
 	pthread_mutex_unlock(&s->mutex);
@@ -151,9 +250,10 @@ gui_ogl_sink_update(struct gui_ogl_texture *tex)
 	GLint stride = (GLint)frame->stride;
 	uint8_t *data = frame->data;
 
-	if (tex->w != (uint32_t)w || tex->h != (uint32_t)h) {
-		tex->w = w;
-		tex->h = h;
+	// Keep the size of the source, the texture might be downsampled.
+	if (tex->w != full_width || tex->h != full_height) {
+		tex->w = full_width;
+		tex->h = full_height;
 
 		// Automatically set the half scaling.
 		if (tex->w >= 1024 || tex->h >= 1024) {
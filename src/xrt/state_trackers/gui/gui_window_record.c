@@ -10,12 +10,15 @@
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_drivers.h"
 
+#include "os/os_time.h"
 #include "os/os_threading.h"
 
 #include "math/m_api.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
 #include "util/u_sink.h"
 #include "util/u_file.h"
 #include "util/u_json.h"
@@ -45,6 +48,14 @@
 #include <inttypes.h>
 
 
+/*!
+ * Preview frames are dropped if the preview hasn't been drawn for this long,
+ * such as when its header is collapsed.
+ */
+#define PREVIEW_HIDDEN_TIMEOUT_NS (U_TIME_1S_IN_NS / 2)
+
+DEBUG_GET_ONCE_NUM_OPTION(preview_rate, "XRT_GUI_PREVIEW_RATE", 15)
+
 /*
  *
  * GStreamer functions.
@@ -93,6 +104,39 @@ create_pipeline(struct gui_record_window *rw)
 		         "mp4mux ! "
 		         "filesink location=\"%s\"",
 		         source_name, bitrate, speed_preset, rw->gst.filename);
+	} else if (rw->gst.pipeline == GUI_RECORD_PIPELINE_AUTO_H264) {
+		char encoder[256];
+		gstreamer_pipeline_get_h264_encoder(bitrate, encoder, sizeof(encoder));
+
+		snprintf(pipeline_string,         //
+		         sizeof(pipeline_string), //
+		         "appsrc name=\"%s\" ! "
+		         "queue ! "
+		         "videoconvert ! "
+		         "video/x-raw,format=NV12 ! "
+		         "queue ! "
+		         "%s ! "
+		         "video/x-h264,profile=main ! "
+		         "h264parse ! "
+		         "queue ! "
+		         "mp4mux ! "
+		         "filesink location=\"%s\"",
+		         source_name, encoder, rw->gst.filename);
+	} else if (rw->gst.pipeline == GUI_RECORD_PIPELINE_VAAPI_H246_DMABUF) {
+		// The frames are imported straight from the dma-bufs, no CPU copy.
+		snprintf(pipeline_string,         //
+		         sizeof(pipeline_string), //
+		         "appsrc name=\"%s\" ! "
+		         "queue ! "
+		         "vaapipostproc ! "
+		         "video/x-raw(memory:VASurface),format=NV12 ! "
+		         "vaapih264enc rate-control=cbr bitrate=\"%s\" tune=high-compression ! "
+		         "video/x-h264,profile=main ! "
+		         "h264parse ! "
+		         "queue ! "
+		         "mp4mux ! "
+		         "filesink location=\"%s\"",
+		         source_name, bitrate, rw->gst.filename);
 	} else {
 		snprintf(pipeline_string,         //
 		         sizeof(pipeline_string), //
@@ -119,14 +163,21 @@ create_pipeline(struct gui_record_window *rw)
 	uint32_t height = rw->source.height;
 	enum xrt_format format = rw->source.format;
 
+	bool dmabuf = rw->gst.pipeline == GUI_RECORD_PIPELINE_VAAPI_H246_DMABUF;
+
+	// Can't convert without touching the pixels, dma-buf frames are never MJPEG.
 	bool do_convert = false;
-	if (format == XRT_FORMAT_MJPEG) {
+	if (format == XRT_FORMAT_MJPEG && !dmabuf) {
 		format = XRT_FORMAT_R8G8B8;
 		do_convert = true;
 	}
 
 	struct gstreamer_sink *gs = NULL;
-	gstreamer_sink_create_with_pipeline(gp, width, height, format, source_name, &gs, &tmp);
+	if (dmabuf) {
+		gstreamer_sink_create_with_pipeline_dmabuf(gp, width, height, format, source_name, &gs, &tmp);
+	} else {
+		gstreamer_sink_create_with_pipeline(gp, width, height, format, source_name, &gs, &tmp);
+	}
 	if (do_convert) {
 		u_sink_create_to_r8g8b8_or_l8(&rw->gst.xfctx, tmp, &tmp);
 	}
@@ -173,7 +224,9 @@ draw_gst(struct gui_record_window *rw)
 	os_mutex_unlock(&rw->gst.mutex);
 
 	igComboStr("Pipeline", (int *)&rw->gst.pipeline,
-	           "SW Ultrafast\0SW Veryfast\0SW Fast\0SW Medium\0SW Slow\0SW Veryslow\0VAAPI H264\0\0", 5);
+	           "SW Ultrafast\0SW Veryfast\0SW Fast\0SW Medium\0SW Slow\0SW Veryslow\0VAAPI H264\0VAAPI H264 (dma-buf)\0"
+	           "Auto H264\0\0",
+	           5);
 	igComboStr("Bitrate", (int *)&rw->gst.bitrate, "32768bps (Be careful!)\0004096bps\0002048bps\0001024bps\0\0",
 	           3);
 
@@ -239,6 +292,35 @@ window_draw_misc(struct gui_record_window *rw)
 	igSameLine(0, 30);
 
 	igText("Sequence %u", (uint32_t)rw->texture.ogl->seq);
+
+	igSliderInt("Preview rate", &rw->texture.rate_hz, 0, 120, rw->texture.rate_hz == 0 ? "Unlimited" : "%d Hz",
+	            ImGuiSliderFlags_None);
+}
+
+/*!
+ * Should this frame go to the preview, only called from the pushing thread.
+ * Limits the rate so converting and copying for the preview doesn't take CPU
+ * time from the trackers producing the frames.
+ */
+static bool
+should_push_preview(struct gui_record_window *rw)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// Racy read, at worst one frame too many or too few.
+	uint64_t last_shown_ns = rw->texture.last_shown_ns;
+	if (now_ns - last_shown_ns > PREVIEW_HIDDEN_TIMEOUT_NS) {
+		return false;
+	}
+
+	int rate_hz = rw->texture.rate_hz;
+	if (rate_hz > 0 && now_ns - rw->texture.last_push_ns < U_TIME_1S_IN_NS / (uint64_t)rate_hz) {
+		return false;
+	}
+
+	rw->texture.last_push_ns = now_ns;
+
+	return true;
 }
 
 static void
@@ -267,7 +349,9 @@ window_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	os_mutex_unlock(&rw->gst.mutex);
 #endif
 
-	xrt_sink_push_frame(rw->texture.sink, xf);
+	if (should_push_preview(rw)) {
+		xrt_sink_push_frame(rw->texture.sink, xf);
+	}
 }
 
 
@@ -299,6 +383,7 @@ gui_window_record_init(struct gui_record_window *rw)
 	// Setup the preview texture.
 	// 50% scale.
 	rw->texture.scale = 50.0;
+	rw->texture.rate_hz = (int)debug_get_num_option_preview_rate();
 	struct xrt_frame_sink *tmp = NULL;
 	rw->texture.ogl = gui_ogl_sink_create("View", &rw->texture.xfctx, &tmp);
 	u_sink_create_to_r8g8b8_r8g8b8a8_r8g8b8x8_or_l8(&rw->texture.xfctx, tmp, &tmp);
@@ -312,6 +397,7 @@ gui_window_record_to_background(struct gui_record_window *rw, struct gui_program
 {
 	struct gui_ogl_texture *tex = rw->texture.ogl;
 
+	rw->texture.last_shown_ns = os_monotonic_get_ns();
 	gui_ogl_sink_update(tex);
 
 	gui_ogl_draw_background(    //
@@ -328,6 +414,7 @@ gui_window_record_render(struct gui_record_window *rw, struct gui_program *p)
 	// Make all IDs unique.
 	igPushIDPtr(rw);
 
+	rw->texture.last_shown_ns = os_monotonic_get_ns();
 	gui_ogl_sink_update(rw->texture.ogl);
 
 	window_draw_misc(rw);
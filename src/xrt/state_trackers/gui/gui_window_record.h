@@ -42,6 +42,8 @@ enum gui_record_pipeline
 	GUI_RECORD_PIPELINE_SOFTWARE_SLOW,
 	GUI_RECORD_PIPELINE_SOFTWARE_VERYSLOW,
 	GUI_RECORD_PIPELINE_VAAPI_H246,
+	GUI_RECORD_PIPELINE_VAAPI_H246_DMABUF,
+	GUI_RECORD_PIPELINE_AUTO_H264,
 };
 
 struct gui_record_window
@@ -61,6 +63,15 @@ struct gui_record_window
 		float scale;
 		bool rotate_180;
 
+		//! Max rate frames are sent to the preview, zero means every frame.
+		int rate_hz;
+
+		//! When a frame was last sent to the preview, only touched by the pushing thread.
+		uint64_t last_push_ns;
+
+		//! When the preview was last drawn, set on the GUI thread and read without locking.
+		uint64_t last_shown_ns;
+
 		struct xrt_frame_sink *sink;
 		struct gui_ogl_texture *ogl;
 	} texture;
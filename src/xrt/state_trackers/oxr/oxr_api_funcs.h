@@ -365,6 +365,12 @@ oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySpace(XrSpace space);
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+//! OpenXR API function @ep{xrLocateSpacesKHR}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR *locateInfo, XrSpaceLocationsKHR *spaceLocations);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 
 /*
  *
@@ -208,6 +208,10 @@ handle_non_null(struct oxr_instance *inst, struct oxr_logger *log, const char *n
 	ENTRY_IF_EXT(xrGetVisibilityMaskKHR, KHR_visibility_mask);
 #endif // OXR_HAVE_KHR_visibility_mask
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+	ENTRY_IF_EXT(xrLocateSpacesKHR, KHR_locate_spaces);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 #ifdef OXR_HAVE_KHR_convert_timespec_time
 	ENTRY_IF_EXT(xrConvertTimespecTimeToTimeKHR, KHR_convert_timespec_time);
 	ENTRY_IF_EXT(xrConvertTimeToTimespecTimeKHR, KHR_convert_timespec_time);
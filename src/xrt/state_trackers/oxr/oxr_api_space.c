@@ -17,6 +17,7 @@
 #include "oxr_objects.h"
 #include "oxr_logger.h"
 #include "oxr_conversions.h"
+#include "oxr_chain.h"
 #include "oxr_two_call.h"
 
 #include "oxr_api_funcs.h"
@@ -236,6 +237,78 @@ oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation
 	return oxr_space_locate(&log, spc, baseSpc, time, location);
 }
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR *locateInfo, XrSpaceLocationsKHR *spaceLocations)
+{
+	OXR_TRACE_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_space *baseSpc;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrLocateSpacesKHR");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, KHR_locate_spaces);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, locateInfo, XR_TYPE_SPACES_LOCATE_INFO_KHR);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, spaceLocations, XR_TYPE_SPACE_LOCATIONS_KHR);
+	OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->baseSpace, baseSpc);
+	OXR_VERIFY_ARG_NOT_NULL(&log, locateInfo->spaces);
+	OXR_VERIFY_ARG_NOT_NULL(&log, spaceLocations->locations);
+
+	if (locateInfo->time <= (XrTime)0) {
+		return oxr_error(&log, XR_ERROR_TIME_INVALID, "(locateInfo->time == %" PRIi64 ") is not a valid time.",
+		                 locateInfo->time);
+	}
+
+	if (locateInfo->spaceCount == 0) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(locateInfo->spaceCount == 0)");
+	}
+
+	if (spaceLocations->locationCount != locateInfo->spaceCount) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(spaceLocations->locationCount == %u) must equal (locateInfo->spaceCount == %u)",
+		                 spaceLocations->locationCount, locateInfo->spaceCount);
+	}
+
+	XrSpaceVelocitiesKHR *vels =
+	    OXR_GET_OUTPUT_FROM_CHAIN(spaceLocations->next, XR_TYPE_SPACE_VELOCITIES_KHR, XrSpaceVelocitiesKHR);
+	if (vels != NULL) {
+		OXR_VERIFY_ARG_NOT_NULL(&log, vels->velocities);
+
+		if (vels->velocityCount != locateInfo->spaceCount) {
+			return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+			                 "(velocities->velocityCount == %u) must equal (locateInfo->spaceCount == %u)",
+			                 vels->velocityCount, locateInfo->spaceCount);
+		}
+	}
+
+	if (baseSpc->sess != sess) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(locateInfo->baseSpace) was not created from (session)");
+	}
+
+	for (uint32_t i = 0; i < locateInfo->spaceCount; i++) {
+		struct oxr_space *spc;
+		OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->spaces[i], spc);
+
+		if (spc->sess != sess) {
+			return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+			                 "(locateInfo->spaces[%u]) was not created from (session)", i);
+		}
+	}
+
+	return oxr_space_locate_spaces(              //
+	    &log,                                    //
+	    sess,                                    //
+	    baseSpc,                                 //
+	    locateInfo->time,                        //
+	    locateInfo->spaces,                      //
+	    locateInfo->spaceCount,                  //
+	    spaceLocations->locations,               //
+	    vels != NULL ? vels->velocities : NULL); //
+}
+#endif // OXR_HAVE_KHR_locate_spaces
+
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySpace(XrSpace space)
 {
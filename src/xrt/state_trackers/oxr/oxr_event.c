@@ -20,121 +20,79 @@
 #include <stdlib.h>
 
 
-/*
- *
- * Struct and defines.
- *
- */
-
-struct oxr_event
-{
-	struct oxr_event *next;
-	size_t length;
-	XrResult result;
-};
-
-
 /*
  *
  * Internal helpers.
  *
  */
 
-void
+static void
 lock(struct oxr_instance *inst)
 {
 	os_mutex_lock(&inst->event.mutex);
 }
 
-void
+static void
 unlock(struct oxr_instance *inst)
 {
 	os_mutex_unlock(&inst->event.mutex);
 }
 
-void *
-oxr_event_extra(struct oxr_event *event)
+static struct oxr_event *
+slot_locked(struct oxr_instance *inst, uint32_t index)
 {
-	return &event[1];
+	return &inst->event.ring[(inst->event.first + index) % OXR_MAX_EVENTS];
 }
 
-struct oxr_event *
-pop(struct oxr_instance *inst)
+/*!
+ * Queue a XrEventDataEventsLost if events were dropped and there now is room.
+ */
+static void
+flush_lost_locked(struct oxr_instance *inst)
 {
-	struct oxr_event *ret = inst->event.next;
-	if (ret == NULL) {
-		return NULL;
+	uint32_t count = (uint32_t)inst->event.count;
+	if (inst->event.lost == 0 || count >= OXR_MAX_EVENTS) {
+		return;
 	}
 
-	inst->event.next = ret->next;
-	ret->next = NULL;
+	struct oxr_event *event = slot_locked(inst, count);
+	U_ZERO(event);
+	event->data.events_lost.type = XR_TYPE_EVENT_DATA_EVENTS_LOST;
+	event->data.events_lost.lostEventCount = inst->event.lost;
+	event->length = sizeof(event->data.events_lost);
 
-	if (ret == inst->event.last) {
-		inst->event.last = NULL;
-	}
-
-	return ret;
+	inst->event.lost = 0;
+	xrt_atomic_s32_inc_return(&inst->event.count);
 }
 
-void
-push(struct oxr_instance *inst, struct oxr_event *event)
+static void
+push(struct oxr_instance *inst, const struct oxr_event *event)
 {
-	struct oxr_event *last = inst->event.last;
-	if (last != NULL) {
-		last->next = event;
-	}
-	inst->event.last = event;
-
-	if (inst->event.next == NULL) {
-		inst->event.next = event;
-	}
-}
+	lock(inst);
 
-#define ALLOC(log, inst, event, extra)                                                                                 \
-	do {                                                                                                           \
-		XrResult ret = oxr_event_alloc(log, inst, sizeof(**extra), event);                                     \
-		if (ret != XR_SUCCESS) {                                                                               \
-			return ret;                                                                                    \
-		}                                                                                                      \
-		*((void **)extra) = oxr_event_extra(*event);                                                           \
-	} while (false)
-
-static XrResult
-oxr_event_alloc(struct oxr_logger *log, struct oxr_instance *inst, size_t size, struct oxr_event **out_event)
-{
-	struct oxr_event *event = U_CALLOC_WITH_CAST(struct oxr_event, sizeof(struct oxr_event) + size);
+	// Keep the lost event in order with the events around it.
+	flush_lost_locked(inst);
 
-	if (event == NULL) {
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Out of memory");
+	uint32_t count = (uint32_t)inst->event.count;
+	if (count < OXR_MAX_EVENTS) {
+		*slot_locked(inst, count) = *event;
+		xrt_atomic_s32_inc_return(&inst->event.count);
+	} else {
+		inst->event.lost++;
 	}
 
-	event->next = NULL;
-	event->length = size;
-	event->result = XR_SUCCESS;
-
-	*out_event = event;
-
-	return XR_SUCCESS;
+	unlock(inst);
 }
 
 static bool
-is_session_link_to_event(struct oxr_event *event, XrSession session)
+is_session_link_to_event(const struct oxr_event *event, XrSession session)
 {
-	XrStructureType *type = oxr_event_extra(event);
-
-	switch (*type) {
-	case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: {
-		XrEventDataSessionStateChanged *changed = (XrEventDataSessionStateChanged *)type;
-		return changed->session == session;
-	}
-	case XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED: {
-		XrEventDataInteractionProfileChanged *changed = (XrEventDataInteractionProfileChanged *)type;
-		return changed->session == session;
-	}
-	case XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING: {
-		XrEventDataReferenceSpaceChangePending *pending = (XrEventDataReferenceSpaceChangePending *)type;
-		return pending->session == session;
-	}
+	switch (event->data.base.type) {
+	case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: return event->data.session_state_changed.session == session;
+	case XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED:
+		return event->data.interaction_profile_changed.session == session;
+	case XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING:
+		return event->data.reference_space_change_pending.session == session;
 	default: return false;
 	}
 }
@@ -153,21 +111,16 @@ oxr_event_push_XrEventDataSessionStateChanged(struct oxr_logger *log,
                                               XrTime time)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event = {0};
+	XrEventDataSessionStateChanged *changed = &event.data.session_state_changed;
+	event.length = sizeof(*changed);
 
 	changed->type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
 	changed->session = oxr_session_to_openxr(sess);
 	changed->state = state;
 	changed->time = time;
 
-	event->result = XR_SUCCESS;
-
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -176,17 +129,14 @@ XrResult
 oxr_event_push_XrEventDataInteractionProfileChanged(struct oxr_logger *log, struct oxr_session *sess)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event = {0};
+	XrEventDataInteractionProfileChanged *changed = &event.data.interaction_profile_changed;
+	event.length = sizeof(*changed);
 
 	changed->type = XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED;
 	changed->session = oxr_session_to_openxr(sess);
 
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -200,10 +150,9 @@ oxr_event_push_XrEventDataReferenceSpaceChangePending(struct oxr_logger *log,
                                                       const XrPosef *poseInPreviousSpace)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataReferenceSpaceChangePending *pending;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &pending);
+	struct oxr_event event = {0};
+	XrEventDataReferenceSpaceChangePending *pending = &event.data.reference_space_change_pending;
+	event.length = sizeof(*pending);
 
 	pending->type = XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING;
 	pending->session = oxr_session_to_openxr(sess);
@@ -211,11 +160,8 @@ oxr_event_push_XrEventDataReferenceSpaceChangePending(struct oxr_logger *log,
 	pending->changeTime = changeTime;
 	pending->poseValid = poseValid;
 	pending->poseInPreviousSpace = *poseInPreviousSpace;
-	event->result = XR_SUCCESS;
 
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -228,17 +174,14 @@ oxr_event_push_XrEventDataDisplayRefreshRateChangedFB(struct oxr_logger *log,
                                                       float toDisplayRefreshRate)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataDisplayRefreshRateChangedFB *changed;
-	struct oxr_event *event = NULL;
+	struct oxr_event event = {0};
+	XrEventDataDisplayRefreshRateChangedFB *changed = &event.data.display_refresh_rate_changed;
+	event.length = sizeof(*changed);
 
-	ALLOC(log, inst, &event, &changed);
 	changed->type = XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB;
 	changed->fromDisplayRefreshRate = fromDisplayRefreshRate;
 	changed->toDisplayRefreshRate = toDisplayRefreshRate;
-	event->result = XR_SUCCESS;
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -251,17 +194,14 @@ oxr_event_push_XrEventDataMainSessionVisibilityChangedEXTX(struct oxr_logger *lo
                                                            bool visible)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataMainSessionVisibilityChangedEXTX *changed;
-	struct oxr_event *event = NULL;
+	struct oxr_event event = {0};
+	XrEventDataMainSessionVisibilityChangedEXTX *changed = &event.data.main_session_visibility_changed;
+	event.length = sizeof(*changed);
 
-	ALLOC(log, inst, &event, &changed);
 	changed->type = XR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX;
 	changed->flags = 0;
 	changed->visible = visible;
-	event->result = XR_SUCCESS;
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -278,19 +218,16 @@ oxr_event_push_XrEventDataPerfSettingsEXTX(struct oxr_logger *log,
                                            enum xrt_perf_notify_level toLevel)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataPerfSettingsEXT *changed;
-	struct oxr_event *event = NULL;
+	struct oxr_event event = {0};
+	XrEventDataPerfSettingsEXT *changed = &event.data.perf_settings;
+	event.length = sizeof(*changed);
 
-	ALLOC(log, inst, &event, &changed);
 	changed->type = XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT;
 	changed->domain = xrt_perf_domain_to_xr(domain);
 	changed->subDomain = xrt_perf_sub_domain_to_xr(subDomain);
 	changed->fromLevel = xrt_perf_notify_level_to_xr(fromLevel);
 	changed->toLevel = xrt_perf_notify_level_to_xr(toLevel);
-	event->result = XR_SUCCESS;
-	lock(inst);
-	push(inst, event);
-	unlock(inst);
+	push(inst, &event);
 
 	return XR_SUCCESS;
 }
@@ -304,24 +241,20 @@ oxr_event_remove_session_events(struct oxr_logger *log, struct oxr_session *sess
 
 	lock(inst);
 
-	struct oxr_event *e = inst->event.next;
-	while (e != NULL) {
-		struct oxr_event *cur = e;
-		e = e->next;
-
-		if (!is_session_link_to_event(cur, session)) {
+	// Compact the ring in place, keeping the order of the other events.
+	uint32_t count = (uint32_t)inst->event.count;
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct oxr_event *event = slot_locked(inst, i);
+		if (is_session_link_to_event(event, session)) {
 			continue;
 		}
-
-		if (cur == inst->event.next) {
-			inst->event.next = cur->next;
-		}
-
-		if (cur == inst->event.last) {
-			inst->event.last = NULL;
+		if (kept != i) {
+			*slot_locked(inst, kept) = *event;
 		}
-		free(cur);
+		kept++;
 	}
+	inst->event.count = (int32_t)kept;
 
 	unlock(inst);
 
@@ -343,17 +276,28 @@ oxr_poll_event(struct oxr_logger *log, struct oxr_instance *inst, XrEventDataBuf
 		sess = sess->next;
 	}
 
+	// Common case, nothing queued and no need to take the lock.
+	if (inst->event.count == 0) {
+		return XR_EVENT_UNAVAILABLE;
+	}
+
 	lock(inst);
-	struct oxr_event *event = pop(inst);
-	unlock(inst);
 
-	if (event == NULL) {
+	if (inst->event.count == 0) {
+		unlock(inst);
 		return XR_EVENT_UNAVAILABLE;
 	}
 
-	ret = event->result;
-	memcpy(eventData, oxr_event_extra(event), event->length);
-	free(event);
+	struct oxr_event *event = slot_locked(inst, 0);
+	memcpy(eventData, &event->data, event->length);
+
+	inst->event.first = (inst->event.first + 1) % OXR_MAX_EVENTS;
+	xrt_atomic_s32_dec_return(&inst->event.count);
+
+	// There is room now.
+	flush_lost_locked(inst);
 
-	return ret;
+	unlock(inst);
+
+	return XR_SUCCESS;
 }
@@ -179,6 +179,17 @@
 #endif
 
 
+/*
+ * XR_KHR_locate_spaces
+ */
+#if defined(XR_KHR_locate_spaces)
+#define OXR_HAVE_KHR_locate_spaces
+#define OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_) _(KHR_locate_spaces, KHR_LOCATE_SPACES)
+#else
+#define OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_)
+#endif
+
+
 /*
  * XR_KHR_opengl_enable
  */
@@ -625,6 +636,7 @@
     OXR_EXTENSION_SUPPORT_KHR_D3D12_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_loader_init(_) \
     OXR_EXTENSION_SUPPORT_KHR_loader_init_android(_) \
+    OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_) \
     OXR_EXTENSION_SUPPORT_KHR_opengl_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_opengl_es_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_swapchain_usage_input_attachment_bit(_) \
@@ -67,6 +67,7 @@ oxr_handle_init(struct oxr_logger *log,
 
 	hb->state = OXR_HANDLE_STATE_UNINITIALIZED;
 
+	uint32_t parent_index = 0;
 	if (parent != NULL) {
 		if (parent->state != OXR_HANDLE_STATE_LIVE) {
 			return oxr_error(log, XR_ERROR_RUNTIME_FAILURE,
@@ -74,27 +75,40 @@ oxr_handle_init(struct oxr_logger *log,
 			                 oxr_handle_state_to_string(parent->state));
 		}
 
-		bool placed = false;
-		for (int i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
-			if (parent->children[i] == NULL) {
-				HANDLE_LIFECYCLE_LOG(log,
-				                     "[init %p] Assigned to "
-				                     "child slot %d in parent",
-				                     (void *)hb, i);
-				parent->children[i] = hb;
-				placed = true;
-				break;
-			}
-		}
-		if (!placed) {
+		if (parent->child_count >= XRT_MAX_HANDLE_CHILDREN) {
 			return oxr_error(log, XR_ERROR_LIMIT_REACHED,
 			                 "Parent handle has no more room for "
 			                 "child handles");
 		}
+
+		if (parent->child_count == parent->child_capacity) {
+			uint32_t capacity = parent->child_capacity == 0 ? 8 : parent->child_capacity * 2;
+			if (capacity > XRT_MAX_HANDLE_CHILDREN) {
+				capacity = XRT_MAX_HANDLE_CHILDREN;
+			}
+
+			struct oxr_handle_base **children =
+			    realloc(parent->children, sizeof(struct oxr_handle_base *) * capacity);
+			if (children == NULL) {
+				return oxr_error(log, XR_ERROR_OUT_OF_MEMORY, "Failed to grow child handle array");
+			}
+
+			parent->children = children;
+			parent->child_capacity = capacity;
+		}
+
+		parent_index = parent->child_count++;
+		parent->children[parent_index] = hb;
+
+		HANDLE_LIFECYCLE_LOG(log,
+		                     "[init %p] Assigned to "
+		                     "child slot %u in parent",
+		                     (void *)hb, parent_index);
 	}
 	U_ZERO(hb);
 	hb->debug = debug;
 	hb->parent = parent;
+	hb->parent_index = parent_index;
 	hb->state = OXR_HANDLE_STATE_LIVE;
 	hb->destroy = destroy;
 	return XR_SUCCESS;
@@ -138,43 +152,55 @@ oxr_handle_do_destroy(struct oxr_logger *log, struct oxr_handle_base *hb, int le
 	                     "contained handles (recursively)",
 	                     level, (void *)hb);
 
-	/* Remove from parent, if any. */
+	/* Remove from parent, if any, not set when the parent is being destroyed. */
 	if (hb->parent != NULL) {
-		bool found = false;
 		struct oxr_handle_base *parent = hb->parent;
+		uint32_t index = hb->parent_index;
 
-		for (int i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
-			if (parent->children[i] == hb) {
-				HANDLE_LIFECYCLE_LOG(log,
-				                     "[%d: destroying %p] Removing handle from "
-				                     "child slot %d in parent %p",
-				                     level, (void *)hb, i, (void *)hb->parent);
-
-				parent->children[i] = NULL;
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
+		if (index >= parent->child_count || parent->children[index] != hb) {
 			return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Parent handle does not refer to this handle");
 		}
 
+		HANDLE_LIFECYCLE_LOG(log,
+		                     "[%d: destroying %p] Removing handle from "
+		                     "child slot %u in parent %p",
+		                     level, (void *)hb, index, (void *)hb->parent);
+
+		// Move the last child into the hole, keeps the array dense.
+		uint32_t last = --parent->child_count;
+		if (index != last) {
+			parent->children[index] = parent->children[last];
+			parent->children[index]->parent_index = index;
+		}
+		parent->children[last] = NULL;
+
 		/* clear parent pointer */
 		hb->parent = NULL;
 	}
 
-	/* Destroy child handles */
-	for (size_t i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
+	/* Destroy child handles, they don't need to remove themselves. */
+	for (uint32_t i = 0; i < hb->child_count; ++i) {
 		struct oxr_handle_base *child = hb->children[i];
+		child->parent = NULL;
 
-		if (child != NULL) {
-			XrResult result = oxr_handle_do_destroy(log, child, level + 1);
-			if (result != XR_SUCCESS) {
-				return result;
+		XrResult result = oxr_handle_do_destroy(log, child, level + 1);
+		if (result != XR_SUCCESS) {
+			// Drop the children that have been destroyed so far.
+			uint32_t remaining = hb->child_count - (i + 1);
+			memmove(&hb->children[0], &hb->children[i + 1], sizeof(*hb->children) * remaining);
+			hb->child_count = remaining;
+			for (uint32_t k = 0; k < remaining; k++) {
+				hb->children[k]->parent_index = k;
 			}
+			return result;
 		}
 	}
 
+	free(hb->children);
+	hb->children = NULL;
+	hb->child_count = 0;
+	hb->child_capacity = 0;
+
 	/* Might destroy instance, which log needs, so use secured variant */
 	HANDLE_LIFECYCLE_LOG_SCOPED_BEGIN(log)
 	{
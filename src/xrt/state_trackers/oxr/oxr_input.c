@@ -51,8 +51,6 @@ oxr_session_get_action_attachment(struct oxr_session *sess,
 static void
 oxr_action_cache_update(struct oxr_logger *log,
                         struct oxr_session *sess,
-                        uint32_t countActionSets,
-                        const XrActiveActionSet *actionSets,
                         struct oxr_action_attachment *act_attached,
                         struct oxr_action_cache *cache,
                         int64_t time,
@@ -62,8 +60,6 @@ oxr_action_cache_update(struct oxr_logger *log,
 static void
 oxr_action_attachment_update(struct oxr_logger *log,
                              struct oxr_session *sess,
-                             uint32_t countActionSets,
-                             const XrActiveActionSet *actionSets,
                              struct oxr_action_attachment *act_attached,
                              int64_t time,
                              struct oxr_subaction_paths subaction_paths);
@@ -135,6 +131,10 @@ oxr_action_cache_teardown(struct oxr_action_cache *cache)
 		struct oxr_action_input *action_input = &cache->inputs[i];
 		oxr_input_transform_destroy(&(action_input->transforms));
 		action_input->transform_count = 0;
+
+		free(action_input->suppressors);
+		action_input->suppressors = NULL;
+		action_input->suppressor_count = 0;
 	}
 
 	free(cache->inputs);
@@ -924,38 +924,17 @@ oxr_input_is_bound_in_act_set(struct oxr_action_input *action_input, struct oxr_
 	return false;
 }
 
+/*!
+ * Is this input suppressed for this sync, done by looking at the higher
+ * priority action sets that bind the same source, see
+ * @ref oxr_action_input::suppressors. Only action sets given to this
+ * xrSyncActions call have any requested sub-action paths.
+ */
 static bool
-oxr_input_supressed(struct oxr_session *sess,
-                    uint32_t countActionSets,
-                    const XrActiveActionSet *actionSets,
-                    struct oxr_subaction_paths *subaction_path,
-                    struct oxr_action_attachment *act_attached,
-                    struct oxr_action_input *action_input)
+oxr_input_supressed(struct oxr_subaction_paths *subaction_path, struct oxr_action_input *action_input)
 {
-	struct oxr_action_set_ref *act_set_ref = act_attached->act_set_attached->act_set_ref;
-	uint32_t priority = act_set_ref->priority;
-
-	// find sources that are bound to an action in a set with higher prio
-	for (uint32_t i = 0; i < countActionSets; i++) {
-		XrActionSet set = actionSets[i].actionSet;
-
-		struct oxr_action_set *other_act_set = NULL;
-		struct oxr_action_set_attachment *other_act_set_attached = NULL;
-		oxr_session_get_action_set_attachment(sess, set, &other_act_set_attached, &other_act_set);
-
-		if (other_act_set_attached == NULL) {
-			continue;
-		}
-
-		/* skip the action set that the current action is in */
-		if (other_act_set_attached->act_set_ref == act_set_ref) {
-			continue;
-		}
-
-		/* input may be suppressed by action set with higher prio */
-		if (other_act_set_attached->act_set_ref->priority <= priority) {
-			continue;
-		}
+	for (uint32_t i = 0; i < action_input->suppressor_count; i++) {
+		struct oxr_action_set_attachment *other_act_set_attached = action_input->suppressors[i];
 
 		/* Currently updated input source with subactionpath X can be
 		 * suppressed, if input source also occurs in action set with
@@ -971,24 +950,82 @@ oxr_input_supressed(struct oxr_session *sess,
 		OXR_FOR_EACH_SUBACTION_PATH(ACCUMULATE_PATHS)
 #undef ACCUMULATE_PATHS
 
-		if (!relevant_subactionpath) {
+		if (relevant_subactionpath) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Find the higher priority action sets that may suppress @p action_input.
+ */
+static void
+oxr_input_compile_suppressors(struct oxr_session *sess,
+                              struct oxr_action_set_attachment *act_set_attached,
+                              struct oxr_action_input *action_input)
+{
+	uint32_t priority = act_set_attached->act_set_ref->priority;
+
+	free(action_input->suppressors);
+	action_input->suppressors = NULL;
+	action_input->suppressor_count = 0;
+
+	for (size_t i = 0; i < sess->action_set_attachment_count; i++) {
+		struct oxr_action_set_attachment *other_act_set_attached = &sess->act_set_attachments[i];
+
+		/* skip the action set that the current action is in */
+		if (other_act_set_attached == act_set_attached) {
+			continue;
+		}
+
+		/* input may be suppressed by action set with higher prio */
+		if (other_act_set_attached->act_set_ref->priority <= priority) {
 			continue;
 		}
 
-		if (oxr_input_is_bound_in_act_set(action_input, other_act_set_attached)) {
-			return true;
+		if (!oxr_input_is_bound_in_act_set(action_input, other_act_set_attached)) {
+			continue;
 		}
+
+		// Allocate only when needed, most inputs have no suppressors.
+		if (action_input->suppressors == NULL) {
+			action_input->suppressors =
+			    U_TYPED_ARRAY_CALLOC(struct oxr_action_set_attachment *, sess->action_set_attachment_count);
+		}
+
+		action_input->suppressors[action_input->suppressor_count++] = other_act_set_attached;
 	}
+}
 
-	return false;
+/*!
+ * Called after all actions have been bound, needs to be redone every time the
+ * bindings change.
+ *
+ * @private @memberof oxr_session
+ */
+static void
+oxr_session_compile_suppressors(struct oxr_session *sess)
+{
+	for (size_t i = 0; i < sess->action_set_attachment_count; i++) {
+		struct oxr_action_set_attachment *act_set_attached = &sess->act_set_attachments[i];
+
+		for (size_t k = 0; k < act_set_attached->action_attachment_count; k++) {
+			struct oxr_action_attachment *act_attached = &act_set_attached->act_attachments[k];
+
+#define COMPILE_CACHE(X)                                                                                               \
+	for (size_t j = 0; j < act_attached->X.input_count; j++) {                                                     \
+		oxr_input_compile_suppressors(sess, act_set_attached, &act_attached->X.inputs[j]);                     \
+	}
+			OXR_FOR_EACH_SUBACTION_PATH(COMPILE_CACHE)
+#undef COMPILE_CACHE
+		}
+	}
 }
 
 static bool
-oxr_input_combine_input(struct oxr_session *sess,
-                        uint32_t countActionSets,
-                        const XrActiveActionSet *actionSets,
-                        struct oxr_action_attachment *act_attached,
-                        struct oxr_subaction_paths *subaction_path,
+oxr_input_combine_input(struct oxr_subaction_paths *subaction_path,
                         struct oxr_action_cache *cache,
                         struct oxr_input_value_tagged *out_input,
                         int64_t *out_timestamp,
@@ -1012,8 +1049,7 @@ oxr_input_combine_input(struct oxr_session *sess,
 
 		// suppress input if it is also bound to action in set with
 		// higher priority
-		if (oxr_input_supressed(sess, countActionSets, actionSets, subaction_path, act_attached,
-		                        action_input)) {
+		if (oxr_input_supressed(subaction_path, action_input)) {
 			continue;
 		}
 
@@ -1098,8 +1134,6 @@ oxr_input_combine_input(struct oxr_session *sess,
 static void
 oxr_action_cache_update(struct oxr_logger *log,
                         struct oxr_session *sess,
-                        uint32_t countActionSets,
-                        const XrActiveActionSet *actionSets,
                         struct oxr_action_attachment *act_attached,
                         struct oxr_action_cache *cache,
                         int64_t time,
@@ -1129,10 +1163,6 @@ oxr_action_cache_update(struct oxr_logger *log,
 
 		bool is_active = false;
 		bool bret = oxr_input_combine_input( //
-		    sess,                            // sess
-		    countActionSets,                 // countActionSets
-		    actionSets,                      // actionSets
-		    act_attached,                    // act_attached
 		    subaction_path,                  // subaction_path
 		    cache,                           // cache
 		    &combined,                       // out_input
@@ -1280,8 +1310,6 @@ oxr_state_update_vec2(
 static void
 oxr_action_attachment_update(struct oxr_logger *log,
                              struct oxr_session *sess,
-                             uint32_t countActionSets,
-                             const XrActiveActionSet *actionSets,
                              struct oxr_action_attachment *act_attached,
                              int64_t time,
                              struct oxr_subaction_paths subaction_paths)
@@ -1297,8 +1325,7 @@ oxr_action_attachment_update(struct oxr_logger *log,
 	struct oxr_subaction_paths subaction_paths_##X = {0};                                                          \
 	subaction_paths_##X.X = true;                                                                                  \
 	bool select_##X = subaction_paths.X || subaction_paths.any;                                                    \
-	oxr_action_cache_update(log, sess, countActionSets, actionSets, act_attached, &act_attached->X, time,          \
-	                        &subaction_paths_##X, select_##X);
+	oxr_action_cache_update(log, sess, act_attached, &act_attached->X, time, &subaction_paths_##X, select_##X);
 
 	OXR_FOR_EACH_VALID_SUBACTION_PATH(UPDATE_SELECT)
 #undef UPDATE_SELECT
@@ -1669,13 +1696,7 @@ oxr_session_get_action_attachment(struct oxr_session *sess,
 static inline size_t
 oxr_handle_base_get_num_children(struct oxr_handle_base *hb)
 {
-	size_t ret = 0;
-	for (uint32_t i = 0; i < XRT_MAX_HANDLE_CHILDREN; ++i) {
-		if (hb->children[i] != NULL) {
-			++ret;
-		}
-	}
-	return ret;
+	return hb->child_count;
 }
 
 static void
@@ -1733,11 +1754,8 @@ oxr_session_attach_action_sets(struct oxr_logger *log,
 
 		// Set up the per-session data for the actions.
 		uint32_t child_index = 0;
-		for (uint32_t k = 0; k < XRT_MAX_HANDLE_CHILDREN; k++) {
+		for (uint32_t k = 0; k < act_set->handle.child_count; k++) {
 			struct oxr_action *act = (struct oxr_action *)act_set->handle.children[k];
-			if (act == NULL) {
-				continue;
-			}
 
 			struct oxr_action_attachment *act_attached = &act_set_attached->act_attachments[child_index];
 			oxr_action_attachment_init(log, act_set_attached, act_attached, act);
@@ -1746,6 +1764,8 @@ oxr_session_attach_action_sets(struct oxr_logger *log,
 		}
 	}
 
+	oxr_session_compile_suppressors(sess);
+
 #define POPULATE_PROFILE(X)                                                                                            \
 	sess->X = XR_NULL_PATH;                                                                                        \
 	if (profiles.X != NULL) {                                                                                      \
@@ -1771,6 +1791,8 @@ oxr_session_update_action_bindings(struct oxr_logger *log, struct oxr_session *s
 		}
 	}
 
+	oxr_session_compile_suppressors(sess);
+
 #define POPULATE_PROFILE(X)                                                                                            \
 	sess->X = XR_NULL_PATH;                                                                                        \
 	if (profiles.X != NULL) {                                                                                      \
@@ -1783,6 +1805,59 @@ oxr_session_update_action_bindings(struct oxr_logger *log, struct oxr_session *s
 	return oxr_session_success_result(sess);
 }
 
+static void
+add_xdev_to_set(struct xrt_device *xdevs[XRT_SYSTEM_MAX_DEVICES], struct xrt_device *xdev, uint32_t *inout_xdev_count)
+{
+	if (xdev == NULL) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < *inout_xdev_count; i++) {
+		if (xdevs[i] == xdev) {
+			return;
+		}
+	}
+
+	if (*inout_xdev_count < XRT_SYSTEM_MAX_DEVICES) {
+		xdevs[(*inout_xdev_count)++] = xdev;
+	}
+}
+
+/*!
+ * Collect the devices backing the bound inputs of the actions that will be
+ * selected during this sync, only those need their inputs updated. Must be
+ * called after the requested sub-action paths have been accumulated.
+ *
+ * @private @memberof oxr_session
+ */
+static void
+oxr_session_get_sync_xdevs(struct oxr_session *sess,
+                           struct xrt_device *xdevs[XRT_SYSTEM_MAX_DEVICES],
+                           uint32_t *out_xdev_count)
+{
+	uint32_t xdev_count = 0;
+
+	for (size_t i = 0; i < sess->action_set_attachment_count; i++) {
+		struct oxr_action_set_attachment *act_set_attached = &sess->act_set_attachments[i];
+		struct oxr_subaction_paths requested = act_set_attached->requested_subaction_paths;
+
+		for (size_t k = 0; k < act_set_attached->action_attachment_count; k++) {
+			struct oxr_action_attachment *act_attached = &act_set_attached->act_attachments[k];
+
+#define ADD_XDEVS(X)                                                                                                   \
+	if (requested.X || requested.any) {                                                                            \
+		for (size_t j = 0; j < act_attached->X.input_count; j++) {                                             \
+			add_xdev_to_set(xdevs, act_attached->X.inputs[j].xdev, &xdev_count);                           \
+		}                                                                                                      \
+	}
+			OXR_FOR_EACH_VALID_SUBACTION_PATH(ADD_XDEVS)
+#undef ADD_XDEVS
+		}
+	}
+
+	*out_xdev_count = xdev_count;
+}
+
 XrResult
 oxr_action_sync_data(struct oxr_logger *log,
                      struct oxr_session *sess,
@@ -1806,10 +1881,8 @@ oxr_action_sync_data(struct oxr_logger *log,
 	// Synchronize outputs to this time.
 	int64_t now = time_state_get_now(sess->sys->inst->timekeeping);
 
-	// Loop over all xdev devices.
-	for (size_t i = 0; i < sess->sys->xsysd->xdev_count; i++) {
-		oxr_xdev_update(sess->sys->xsysd->xdevs[i]);
-	}
+	// Action spaces may be bound to other inputs after this.
+	oxr_space_locate_cache_clear(sess);
 
 	// Reset all action set attachments.
 	for (size_t i = 0; i < sess->action_set_attachment_count; ++i) {
@@ -1855,6 +1928,15 @@ oxr_action_sync_data(struct oxr_logger *log,
 		}
 	}
 
+	// Only update the devices that back inputs of the requested action sets.
+	struct xrt_device *xdevs[XRT_SYSTEM_MAX_DEVICES];
+	uint32_t xdev_count = 0;
+	oxr_session_get_sync_xdevs(sess, xdevs, &xdev_count);
+
+	for (uint32_t i = 0; i < xdev_count; i++) {
+		oxr_xdev_update(xdevs[i]);
+	}
+
 	// Now, update all action attachments
 	for (size_t i = 0; i < sess->action_set_attachment_count; ++i) {
 		act_set_attached = &sess->act_set_attachments[i];
@@ -1868,8 +1950,7 @@ oxr_action_sync_data(struct oxr_logger *log,
 				continue;
 			}
 
-			oxr_action_attachment_update(log, sess, countActionSets, actionSets, act_attached, now,
-			                             subaction_paths);
+			oxr_action_attachment_update(log, sess, act_attached, now, subaction_paths);
 		}
 	}
 
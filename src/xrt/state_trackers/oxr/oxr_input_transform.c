@@ -112,6 +112,8 @@ oxr_input_transform_init_vec2_dpad(struct oxr_input_transform *transform,
 	transform->data.dpad_state.activation_input_type = activation_input_type;
 	transform->data.dpad_state.activation_input = activation_input;
 	transform->data.dpad_state.already_active = activation_input == NULL;
+	transform->data.dpad_state.center_region_sq = dpad_settings.centerRegion * dpad_settings.centerRegion;
+	transform->data.dpad_state.tan_half_wedge = tanf(dpad_settings.wedgeAngle / 2.0f);
 
 	return true;
 }
@@ -158,6 +160,28 @@ oxr_input_transform_init_bool_to_vec1(struct oxr_input_transform *transform,
 	return true;
 }
 
+/*!
+ * Is the point, rotated so the region points up, within the wedge?
+ *
+ * Same as checking that the angle from the up axis is within the half-open
+ * range (-halfAngle, halfAngle], but without any trigonometry in the frame
+ * loop. The wedge angle is verified to be below pi, so the region is always
+ * in the upper half plane.
+ */
+static inline bool
+in_dpad_wedge(float local_x, float local_y, float tan_half_wedge)
+{
+	if (local_y <= 0.0f) {
+		return false;
+	}
+
+	float edge = local_y * tan_half_wedge;
+	float abs_x = fabsf(local_x);
+
+	// On the edge only the clockwise side belongs to the region.
+	return abs_x < edge || (abs_x == edge && local_x >= 0.0f);
+}
+
 bool
 oxr_input_transform_process(struct oxr_input_transform *transform,
                             size_t transform_count,
@@ -221,31 +245,18 @@ oxr_input_transform_process(struct oxr_input_transform *transform,
 			enum oxr_dpad_region bound_region = dpad_state->bound_region;
 			enum oxr_dpad_region active_regions = OXR_DPAD_REGION_CENTER;
 
-			for (unsigned int i = 0; i < 4; i++) {
-				enum oxr_dpad_region query_region = 1u << i;
+			float x = data.value.vec2.x;
+			float y = data.value.vec2.y;
 
-				bool rot90 =
-				    (query_region == OXR_DPAD_REGION_LEFT) || (query_region == OXR_DPAD_REGION_RIGHT);
-				bool rot180 =
-				    (query_region == OXR_DPAD_REGION_DOWN) || (query_region == OXR_DPAD_REGION_RIGHT);
-
-				float localX = rot90 ? data.value.vec2.y : data.value.vec2.x;
-				float localY = rot90 ? -data.value.vec2.x : data.value.vec2.y;
-				if (rot180) {
-					localX = -localX;
-					localY = -localY;
-				}
+			// The center test doesn't care about rotation, do it once for all regions.
+			if (x * x + y * y > dpad_state->center_region_sq) {
+				float tan_half = dpad_state->tan_half_wedge;
 
-				float centerRadius = dpad_state->settings.centerRegion;
-				if (localX * localX + localY * localY <= centerRadius * centerRadius) {
-					continue;
-				}
-
-				float tanXY = atan2f(localX, localY);
-				float halfAngle = dpad_state->settings.wedgeAngle / 2.0f;
-				if (-halfAngle < tanXY && tanXY <= halfAngle) {
-					active_regions |= query_region;
-				}
+				// Each region rotated so that it points up.
+				active_regions |= in_dpad_wedge(x, y, tan_half) ? OXR_DPAD_REGION_UP : 0;
+				active_regions |= in_dpad_wedge(-x, -y, tan_half) ? OXR_DPAD_REGION_DOWN : 0;
+				active_regions |= in_dpad_wedge(y, -x, tan_half) ? OXR_DPAD_REGION_LEFT : 0;
+				active_regions |= in_dpad_wedge(-y, x, tan_half) ? OXR_DPAD_REGION_RIGHT : 0;
 			}
 
 			if (!dpad_state->already_active || !dpad_state->settings.isSticky ||
@@ -133,6 +133,12 @@ struct oxr_input_transform_dpad_data
 	enum xrt_input_type activation_input_type;
 	struct xrt_input *activation_input;
 	bool already_active;
+
+	//! Square of oxr_dpad_settings::centerRegion, computed at bind time.
+	float center_region_sq;
+
+	//! Tangent of half of oxr_dpad_settings::wedgeAngle, which is below pi.
+	float tan_half_wedge;
 };
 
 /*!
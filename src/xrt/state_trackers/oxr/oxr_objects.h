@@ -24,6 +24,7 @@
 
 #include "os/os_threading.h"
 
+#include "util/u_arena.h"
 #include "util/u_index_fifo.h"
 #include "util/u_hashset.h"
 #include "util/u_hashmap.h"
@@ -826,6 +827,34 @@ XrResult
 oxr_space_locate(
     struct oxr_logger *log, struct oxr_space *spc, struct oxr_space *baseSpc, XrTime time, XrSpaceLocation *location);
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+/*!
+ * Locate many spaces in the same base space at the same time, all of them go
+ * to the space overseer in batches so each device is only sampled once per
+ * batch. Used to implement xrLocateSpacesKHR.
+ *
+ * @param      log          Logging struct.
+ * @param      sess         Session all of the spaces belong to.
+ * @param      baseSpc      Base space where the spaces are to be located.
+ * @param[in]  time         Time in OpenXR domain.
+ * @param[in]  spaces       Spaces to locate, already verified.
+ * @param[in]  space_count  Number of spaces, locations and velocities.
+ * @param[out] locations    Returns the locations of the spaces.
+ * @param[out] velocities   Optional, returns the velocities of the spaces.
+ *
+ * @return Any errors, XR_SUCCESS, poses might not be valid on XR_SUCCESS.
+ */
+XrResult
+oxr_space_locate_spaces(struct oxr_logger *log,
+                        struct oxr_session *sess,
+                        struct oxr_space *baseSpc,
+                        XrTime time,
+                        const XrSpace *spaces,
+                        uint32_t space_count,
+                        XrSpaceLocationDataKHR *locations,
+                        XrSpaceVelocityDataKHR *velocities);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 /*!
  * Locate the @ref xrt_device in the given base space, useful for implementing
  * hand tracking location look ups and the like.
@@ -845,6 +874,16 @@ oxr_space_locate_device(struct oxr_logger *log,
                         XrTime time,
                         struct xrt_space_relation *out_relation);
 
+/*!
+ * Forget all locations remembered for this frame, see
+ * @ref oxr_session::locate_cache. Called on xrWaitFrame, xrSyncActions, when
+ * a space is destroyed and when a reference space change is pending.
+ *
+ * @public @memberof oxr_session
+ */
+void
+oxr_space_locate_cache_clear(struct oxr_session *sess);
+
 
 /*
  *
@@ -1290,9 +1329,19 @@ struct oxr_handle_base
 	struct oxr_handle_base *parent;
 
 	/*!
-	 * Array of children, if any.
+	 * Dense array of children, if any, grown as needed up to
+	 * @ref XRT_MAX_HANDLE_CHILDREN elements.
 	 */
-	struct oxr_handle_base *children[XRT_MAX_HANDLE_CHILDREN];
+	struct oxr_handle_base **children;
+
+	//! Number of elements in @ref children that are valid.
+	uint32_t child_count;
+
+	//! Number of elements allocated in @ref children.
+	uint32_t child_capacity;
+
+	//! Index of this handle in the @ref children array of the parent.
+	uint32_t parent_index;
 
 	/*!
 	 * Current handle state.
@@ -1464,6 +1513,35 @@ struct oxr_extension_status
 };
 #undef MAKE_EXT_STATUS
 
+//! Number of events that can be queued on an instance, see @ref oxr_instance::event.
+#define OXR_MAX_EVENTS 64
+
+/*!
+ * A single queued event, big enough to hold any event the runtime produces.
+ */
+struct oxr_event
+{
+	union {
+		XrEventDataBaseHeader base;
+		XrEventDataEventsLost events_lost;
+		XrEventDataSessionStateChanged session_state_changed;
+		XrEventDataInteractionProfileChanged interaction_profile_changed;
+		XrEventDataReferenceSpaceChangePending reference_space_change_pending;
+#ifdef OXR_HAVE_FB_display_refresh_rate
+		XrEventDataDisplayRefreshRateChangedFB display_refresh_rate_changed;
+#endif
+#ifdef OXR_HAVE_EXTX_overlay
+		XrEventDataMainSessionVisibilityChangedEXTX main_session_visibility_changed;
+#endif
+#ifdef OXR_HAVE_EXT_performance_settings
+		XrEventDataPerfSettingsEXT perf_settings;
+#endif
+	} data;
+
+	//! Size of the event struct in @ref data that is copied out.
+	size_t length;
+};
+
 /*!
  * Main object that ties everything together.
  *
@@ -1504,12 +1582,25 @@ struct oxr_instance
 	//! Number of paths in the array (0 is always null).
 	size_t path_num;
 
-	// Event queue.
+	/*!
+	 * Event queue, a fixed ring so pushing never allocates. Pushing and
+	 * popping takes the mutex, but @ref count can be checked without it
+	 * so polling an empty queue is lock-free.
+	 */
 	struct
 	{
 		struct os_mutex mutex;
-		struct oxr_event *last;
-		struct oxr_event *next;
+
+		//! Index of the oldest queued event in @ref ring.
+		uint32_t first;
+
+		//! Number of queued events, only changed with the mutex held.
+		xrt_atomic_s32_t count;
+
+		//! Events dropped since the ring was full, reported with XrEventDataEventsLost.
+		uint32_t lost;
+
+		struct oxr_event ring[OXR_MAX_EVENTS];
 	} event;
 
 	//! Interaction profile bindings that have been suggested by the client.
@@ -1587,6 +1678,21 @@ struct oxr_instance
 #endif
 };
 
+//! Number of locations remembered per frame, see @ref oxr_session::locate_cache.
+#define OXR_LOCATE_CACHE_SIZE 32
+
+/*!
+ * A single remembered location, either of @p spc or of @p xdev in @p base_spc.
+ */
+struct oxr_locate_cache_entry
+{
+	struct oxr_space *spc;
+	struct xrt_device *xdev;
+	struct oxr_space *base_spc;
+	XrTime time;
+	struct xrt_space_relation relation;
+};
+
 /*!
  * Object that client program interact with.
  *
@@ -1713,6 +1819,11 @@ struct oxr_session
 	//! Extra sleep in wait frame.
 	uint32_t frame_timing_wait_sleep_ms;
 
+	/*!
+	 * Scratch memory for xrEndFrame, reset at the start of every call.
+	 */
+	struct u_arena frame_arena;
+
 	/*!
 	 * To pipe swapchain creation to right code.
 	 */
@@ -1725,6 +1836,42 @@ struct oxr_session
 	 * Used as reference for local space.  */
 	struct xrt_space_relation local_space_pure_relation;
 
+	/*!
+	 * Spaces and devices located during the current frame, apps locate the
+	 * same thing at the same time more than once per frame, and over IPC
+	 * each location is a round trip.
+	 */
+	struct
+	{
+		//! Guards all fields below, spaces can be located from any thread.
+		struct os_mutex mutex;
+
+		//! Can be turned off with OXR_LOCATE_CACHE.
+		bool enabled;
+
+		//! Number of valid entries.
+		uint32_t count;
+
+		//! Entry to replace next when full.
+		uint32_t next;
+
+		struct oxr_locate_cache_entry entries[OXR_LOCATE_CACHE_SIZE];
+	} locate_cache;
+
+	/*!
+	 * When the views were last located, passed on in projection layers for
+	 * the same display time so the compositor can measure motion to photon
+	 * latency.
+	 */
+	struct
+	{
+		//! Guards the fields below, views can be located from any thread.
+		struct os_mutex mutex;
+
+		uint64_t display_time_ns;
+		uint64_t sample_ns;
+	} view_sample;
+
 	bool has_lost;
 };
 
@@ -2022,6 +2169,14 @@ struct oxr_action_input
 	struct oxr_input_transform *transforms;
 	size_t transform_count;
 	XrPath bound_path;
+
+	/*!
+	 * Attached action sets with a higher priority that have an action bound
+	 * to the same source, compiled when binding so xrSyncActions doesn't
+	 * have to search every action of every set for each input.
+	 */
+	struct oxr_action_set_attachment **suppressors;
+	uint32_t suppressor_count;
 };
 
 /*!
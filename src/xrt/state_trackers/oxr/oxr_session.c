@@ -54,6 +54,7 @@
 DEBUG_GET_ONCE_NUM_OPTION(ipd, "OXR_DEBUG_IPD_MM", 63)
 DEBUG_GET_ONCE_NUM_OPTION(wait_frame_sleep, "OXR_DEBUG_WAIT_FRAME_EXTRA_SLEEP_MS", 0)
 DEBUG_GET_ONCE_BOOL_OPTION(frame_timing_spew, "OXR_FRAME_TIMING_SPEW", false)
+DEBUG_GET_ONCE_BOOL_OPTION(locate_cache, "OXR_LOCATE_CACHE", true)
 
 
 /*
@@ -99,6 +100,11 @@ handle_reference_space_change_pending(struct oxr_logger *log,
 	struct oxr_instance *inst = sess->sys->inst;
 	XrReferenceSpaceType type = XR_REFERENCE_SPACE_TYPE_MAX_ENUM;
 
+	/*
+	 * The space has moved, so anything located so far this frame is stale,
+	 * even for the spaces of extensions that are not enabled.
+	 */
+	oxr_space_locate_cache_clear(sess);
 
 	switch (ref_change->ref_type) {
 	case XRT_SPACE_REFERENCE_TYPE_VIEW: type = XR_REFERENCE_SPACE_TYPE_VIEW; break;
@@ -464,6 +470,9 @@ oxr_session_locate_views(struct oxr_logger *log,
 	struct xrt_fov fovs[2] = {0};
 	struct xrt_pose poses[2] = {0};
 
+	// Devices sample the pose when asked, so this is when the pose was sampled.
+	uint64_t sample_ns = os_monotonic_get_ns();
+
 	xrt_device_get_view_poses( //
 	    xdev,                  //
 	    &default_eye_relation, //
@@ -473,6 +482,11 @@ oxr_session_locate_views(struct oxr_logger *log,
 	    fovs,                  //
 	    poses);
 
+	os_mutex_lock(&sess->view_sample.mutex);
+	sess->view_sample.display_time_ns = xdisplay_time;
+	sess->view_sample.sample_ns = sample_ns;
+	os_mutex_unlock(&sess->view_sample.mutex);
+
 	// The xdev pose in the base space.
 	struct xrt_space_relation T_base_xdev = XRT_SPACE_RELATION_ZERO;
 	XrResult ret = oxr_space_locate_device( //
@@ -641,6 +655,9 @@ oxr_session_frame_wait(struct oxr_logger *log, struct oxr_session *sess, XrFrame
 	//! more than one session per instance.
 	XRT_MAYBE_UNUSED timepoint_ns now = time_state_get_now_and_update(sess->sys->inst->timekeeping);
 
+	// New frame, poses need to be located again.
+	oxr_space_locate_cache_clear(sess);
+
 	struct xrt_compositor *xc = sess->compositor;
 	if (xc == NULL) {
 		frameState->shouldRender = XR_FALSE;
@@ -792,9 +809,12 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	xrt_comp_native_destroy(&sess->xcn);
 	xrt_session_destroy(&sess->xs);
 
+	u_arena_fini(&sess->frame_arena);
 	os_precise_sleeper_deinit(&sess->sleeper);
 	os_semaphore_destroy(&sess->sem);
 	os_mutex_destroy(&sess->active_wait_frames_lock);
+	os_mutex_destroy(&sess->locate_cache.mutex);
+	os_mutex_destroy(&sess->view_sample.mutex);
 
 	free(sess);
 
@@ -825,11 +845,19 @@ oxr_session_allocate_and_init(struct oxr_logger *log,
 	sess->active_wait_frames = 0;
 	os_mutex_init(&sess->active_wait_frames_lock);
 
+	os_mutex_init(&sess->locate_cache.mutex);
+	sess->locate_cache.enabled = debug_get_bool_option_locate_cache();
+
+	os_mutex_init(&sess->view_sample.mutex);
+
 	// Debug and user options.
 	sess->ipd_meters = debug_get_num_option_ipd() / 1000.0f;
 	sess->frame_timing_spew = debug_get_bool_option_frame_timing_spew();
 	sess->frame_timing_wait_sleep_ms = debug_get_num_option_wait_frame_sleep();
 
+	// Grows to fit what the application submits.
+	u_arena_init(&sess->frame_arena, 0);
+
 	// Action system hashmaps.
 	u_hashmap_int_create(&sess->act_sets_attachments_by_key);
 	u_hashmap_int_create(&sess->act_attachments_by_key);
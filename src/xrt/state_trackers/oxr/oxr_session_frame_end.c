@@ -14,6 +14,7 @@
 
 #include "os/os_time.h"
 
+#include "util/u_arena.h"
 #include "util/u_debug.h"
 #include "util/u_misc.h"
 #include "util/u_time.h"
@@ -44,6 +45,111 @@
  *
  */
 
+DEBUG_GET_ONCE_BOOL_OPTION(trusted_layers, "OXR_TRUSTED_LAYERS", false)
+
+/*!
+ * The extension structs chained to a single layer, gathered in one walk of
+ * the next chain and then used by both the verify and submit functions.
+ * Only structs of enabled extensions are recorded.
+ */
+struct layer_chain
+{
+#ifdef OXR_HAVE_KHR_composition_layer_color_scale_bias
+	const XrCompositionLayerColorScaleBiasKHR *color_scale_bias;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_image_layout
+	const XrCompositionLayerImageLayoutFB *image_layout;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_alpha_blend
+	const XrCompositionLayerAlphaBlendFB *alpha_blend;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_settings
+	const XrCompositionLayerSettingsFB *settings;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_depth_test
+	const XrCompositionLayerDepthTestFB *depth_test;
+#endif
+#ifdef OXR_HAVE_KHR_composition_layer_depth
+	//! Depth info chained to the views of a projection layer.
+	const XrCompositionLayerDepthInfoKHR *depth[2];
+#endif
+	//! Silence empty struct warnings when no extensions are built.
+	bool dummy;
+};
+
+/*!
+ * In release builds the app can be trusted to submit valid poses and rects,
+ * checks that protect the runtime and compositor are always done.
+ */
+static inline bool
+skip_app_checks(void)
+{
+#ifdef NDEBUG
+	return debug_get_bool_option_trusted_layers();
+#else
+	return false;
+#endif
+}
+
+static void
+gather_layer_chain(struct oxr_session *sess, const XrCompositionLayerBaseHeader *layer, struct layer_chain *lc)
+{
+	U_ZERO(lc);
+
+	XRT_MAYBE_UNUSED const struct oxr_extension_status *ext = &sess->sys->inst->extensions;
+
+	for (const XrBaseInStructure *it = layer->next; it != NULL; it = it->next) {
+		switch ((int)it->type) {
+#ifdef OXR_HAVE_KHR_composition_layer_color_scale_bias
+		case XR_TYPE_COMPOSITION_LAYER_COLOR_SCALE_BIAS_KHR:
+			if (ext->KHR_composition_layer_color_scale_bias && lc->color_scale_bias == NULL) {
+				lc->color_scale_bias = (const XrCompositionLayerColorScaleBiasKHR *)it;
+			}
+			break;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_image_layout
+		case XR_TYPE_COMPOSITION_LAYER_IMAGE_LAYOUT_FB:
+			if (ext->FB_composition_layer_image_layout && lc->image_layout == NULL) {
+				lc->image_layout = (const XrCompositionLayerImageLayoutFB *)it;
+			}
+			break;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_alpha_blend
+		case XR_TYPE_COMPOSITION_LAYER_ALPHA_BLEND_FB:
+			if (ext->FB_composition_layer_alpha_blend && lc->alpha_blend == NULL) {
+				lc->alpha_blend = (const XrCompositionLayerAlphaBlendFB *)it;
+			}
+			break;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_settings
+		case XR_TYPE_COMPOSITION_LAYER_SETTINGS_FB:
+			if (ext->FB_composition_layer_settings && lc->settings == NULL) {
+				lc->settings = (const XrCompositionLayerSettingsFB *)it;
+			}
+			break;
+#endif
+#ifdef OXR_HAVE_FB_composition_layer_depth_test
+		case XR_TYPE_COMPOSITION_LAYER_DEPTH_TEST_FB:
+			if (ext->FB_composition_layer_depth_test && lc->depth_test == NULL) {
+				lc->depth_test = (const XrCompositionLayerDepthTestFB *)it;
+			}
+			break;
+#endif
+		default: break;
+		}
+	}
+
+#ifdef OXR_HAVE_KHR_composition_layer_depth
+	if (layer->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+		const XrCompositionLayerProjection *proj = (const XrCompositionLayerProjection *)layer;
+		for (uint32_t i = 0; i < proj->viewCount && i < ARRAY_SIZE(lc->depth); i++) {
+			lc->depth[i] = OXR_GET_INPUT_FROM_CHAIN( //
+			    &proj->views[i], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
+		}
+	}
+#endif
+}
+
 static double
 ns_to_ms(int64_t ns)
 {
@@ -199,18 +305,10 @@ fill_in_xr_color(const struct XrColor4f *src, struct xrt_colour_rgba_f32 *dest)
 }
 
 static void
-fill_in_color_scale_bias(struct oxr_session *sess,
-                         const XrCompositionLayerBaseHeader *layer,
-                         struct xrt_layer_data *xlayer_data)
+fill_in_color_scale_bias(const struct layer_chain *lc, struct xrt_layer_data *xlayer_data)
 {
 #ifdef OXR_HAVE_KHR_composition_layer_color_scale_bias
-	// Is the extension enabled?
-	if (!sess->sys->inst->extensions.KHR_composition_layer_color_scale_bias) {
-		return;
-	}
-
-	const XrCompositionLayerColorScaleBiasKHR *color_scale_bias = OXR_GET_INPUT_FROM_CHAIN(
-	    layer->next, XR_TYPE_COMPOSITION_LAYER_COLOR_SCALE_BIAS_KHR, XrCompositionLayerColorScaleBiasKHR);
+	const XrCompositionLayerColorScaleBiasKHR *color_scale_bias = lc->color_scale_bias;
 	if (color_scale_bias) {
 		xlayer_data->flags |= XRT_LAYER_COMPOSITION_COLOR_BIAS_SCALE;
 		fill_in_xr_color(&color_scale_bias->colorScale, &xlayer_data->color_scale);
@@ -220,16 +318,10 @@ fill_in_color_scale_bias(struct oxr_session *sess,
 }
 
 static void
-fill_in_y_flip(struct oxr_session *sess, const XrCompositionLayerBaseHeader *layer, struct xrt_layer_data *xlayer_data)
+fill_in_y_flip(const struct layer_chain *lc, struct xrt_layer_data *xlayer_data)
 {
 #ifdef OXR_HAVE_FB_composition_layer_image_layout
-	// Is the extension enabled?
-	if (!sess->sys->inst->extensions.FB_composition_layer_image_layout) {
-		return;
-	}
-
-	const XrCompositionLayerImageLayoutFB *layer_image_layout = OXR_GET_INPUT_FROM_CHAIN(
-	    layer->next, XR_TYPE_COMPOSITION_LAYER_IMAGE_LAYOUT_FB, XrCompositionLayerImageLayoutFB);
+	const XrCompositionLayerImageLayoutFB *layer_image_layout = lc->image_layout;
 
 	// Is the layer here, and does it have the flag, if not nothing to do.
 	if (layer_image_layout == NULL ||
@@ -258,15 +350,10 @@ fill_in_sub_image(const struct oxr_swapchain *sc, const XrSwapchainSubImage *oxr
 }
 
 static void
-fill_in_blend_factors(struct oxr_session *sess, const XrCompositionLayerBaseHeader *layer, struct xrt_layer_data *data)
+fill_in_blend_factors(const struct layer_chain *lc, struct xrt_layer_data *data)
 {
 #ifdef OXR_HAVE_FB_composition_layer_alpha_blend
-	// Is the extension enabled?
-	if (!sess->sys->inst->extensions.FB_composition_layer_alpha_blend) {
-		return;
-	}
-	const XrCompositionLayerAlphaBlendFB *alphaBlend = OXR_GET_INPUT_FROM_CHAIN(
-	    layer, (XrStructureType)XR_TYPE_COMPOSITION_LAYER_ALPHA_BLEND_FB, XrCompositionLayerAlphaBlendFB);
+	const XrCompositionLayerAlphaBlendFB *alphaBlend = lc->alpha_blend;
 	if (alphaBlend != NULL) {
 		data->flags |= XRT_LAYER_COMPOSITION_ADVANCED_BLENDING_BIT;
 		data->advanced_blend.src_factor_color = convert_blend_factor(alphaBlend->srcFactorColor);
@@ -278,17 +365,10 @@ fill_in_blend_factors(struct oxr_session *sess, const XrCompositionLayerBaseHead
 }
 
 static void
-fill_in_layer_settings(struct oxr_session *sess,
-                       const XrCompositionLayerBaseHeader *layer,
-                       struct xrt_layer_data *xlayer_data)
+fill_in_layer_settings(const struct layer_chain *lc, struct xrt_layer_data *xlayer_data)
 {
 #ifdef OXR_HAVE_FB_composition_layer_settings
-	// Is the extension enabled?
-	if (!sess->sys->inst->extensions.FB_composition_layer_settings) {
-		return;
-	}
-	const XrCompositionLayerSettingsFB *layer_settings =
-	    OXR_GET_INPUT_FROM_CHAIN(layer->next, XR_TYPE_COMPOSITION_LAYER_SETTINGS_FB, XrCompositionLayerSettingsFB);
+	const XrCompositionLayerSettingsFB *layer_settings = lc->settings;
 	if (layer_settings != NULL) {
 		xlayer_data->flags |= convert_layer_settings_flags(layer_settings->layerFlags);
 	}
@@ -296,15 +376,10 @@ fill_in_layer_settings(struct oxr_session *sess,
 }
 
 static void
-fill_in_depth_test(struct oxr_session *sess, const XrCompositionLayerBaseHeader *layer, struct xrt_layer_data *data)
+fill_in_depth_test(const struct layer_chain *lc, struct xrt_layer_data *data)
 {
 #ifdef OXR_HAVE_FB_composition_layer_depth_test
-	// Is the extension enabled?
-	if (!sess->sys->inst->extensions.FB_composition_layer_depth_test) {
-		return;
-	}
-	const XrCompositionLayerDepthTestFB *depthTest = OXR_GET_INPUT_FROM_CHAIN(
-	    layer, (XrStructureType)XR_TYPE_COMPOSITION_LAYER_DEPTH_TEST_FB, XrCompositionLayerDepthTestFB);
+	const XrCompositionLayerDepthTestFB *depthTest = lc->depth_test;
 	if (depthTest != NULL) {
 		data->flags |= XRT_LAYER_COMPOSITION_DEPTH_TEST;
 		data->depth_test.depth_mask = depthTest->depthMask;
@@ -320,18 +395,10 @@ fill_in_depth_test(struct oxr_session *sess, const XrCompositionLayerBaseHeader
  */
 
 static XrResult
-verify_blend_factors(struct oxr_logger *log,
-                     struct oxr_session *sess,
-                     uint32_t layer_index,
-                     const XrCompositionLayerBaseHeader *layer)
+verify_blend_factors(struct oxr_logger *log, const struct layer_chain *lc, uint32_t layer_index)
 {
 #ifdef OXR_HAVE_FB_composition_layer_alpha_blend
-	if (!sess->sys->inst->extensions.FB_composition_layer_alpha_blend) {
-		return XR_SUCCESS;
-	}
-
-	const XrCompositionLayerAlphaBlendFB *alphaBlend = OXR_GET_INPUT_FROM_CHAIN(
-	    layer, (XrStructureType)XR_TYPE_COMPOSITION_LAYER_ALPHA_BLEND_FB, XrCompositionLayerAlphaBlendFB);
+	const XrCompositionLayerAlphaBlendFB *alphaBlend = lc->alpha_blend;
 
 	if (alphaBlend != NULL) {
 		if (!u_verify_blend_factor_valid(alphaBlend->srcFactorColor)) {
@@ -381,6 +448,7 @@ verify_quad_layer(struct oxr_session *sess,
                   struct oxr_logger *log,
                   uint32_t layer_index,
                   XrCompositionLayerQuad *quad,
+                  const struct layer_chain *lc,
                   struct xrt_device *head,
                   uint64_t timestamp)
 {
@@ -396,19 +464,19 @@ verify_quad_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)quad);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
 
-	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&quad->pose.orientation)) {
+	if (!skip_app_checks() && !math_quat_validate_within_1_percent((struct xrt_quat *)&quad->pose.orientation)) {
 		XrQuaternionf *q = &quad->pose.orientation;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.orientation == {%f %f %f %f}) is not a valid quat",
 		                 layer_index, q->x, q->y, q->z, q->w);
 	}
 
-	if (!math_vec3_validate((struct xrt_vec3 *)&quad->pose.position)) {
+	if (!skip_app_checks() && !math_vec3_validate((struct xrt_vec3 *)&quad->pose.position)) {
 		XrVector3f *p = &quad->pose.position;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.position == {%f %f %f}) is not valid", layer_index,
@@ -441,14 +509,14 @@ verify_quad_layer(struct oxr_session *sess,
 		                 layer_index);
 	}
 
-	if (is_rect_neg(&quad->subImage.imageRect)) {
+	if (!skip_app_checks() && is_rect_neg(&quad->subImage.imageRect)) {
 		return oxr_error(
 		    log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		    "(frameEndInfo->layers[%u]->subImage.imageRect.offset == {%i, %i}) has negative component(s)",
 		    layer_index, quad->subImage.imageRect.offset.x, quad->subImage.imageRect.offset.y);
 	}
 
-	if (is_rect_out_of_bounds(&quad->subImage.imageRect, sc)) {
+	if (!skip_app_checks() && is_rect_out_of_bounds(&quad->subImage.imageRect, sc)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->subImage.imageRect == {{%i, %i}, {%u, %u}}) imageRect out "
 		                 "of image bounds (%u, %u)",
@@ -504,7 +572,7 @@ verify_depth_layer(struct xrt_compositor *xc,
 		                 layer_index, sc->face_count);
 	}
 
-	if (is_rect_neg(&depth->subImage.imageRect)) {
+	if (!skip_app_checks() && is_rect_neg(&depth->subImage.imageRect)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerDepthInfoKHR>.subImage."
 		                 "imageRect.offset == {%i, %i}) has negative component(s)",
@@ -512,7 +580,7 @@ verify_depth_layer(struct xrt_compositor *xc,
 		                 depth->subImage.imageRect.offset.y);
 	}
 
-	if (is_rect_out_of_bounds(&depth->subImage.imageRect, sc)) {
+	if (!skip_app_checks() && is_rect_out_of_bounds(&depth->subImage.imageRect, sc)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerDepthInfoKHR>.subImage."
 		                 "imageRect == {{%i, %i}, {%u, %u}}) imageRect out of image bounds (%u, %u)",
@@ -559,6 +627,7 @@ verify_projection_layer(struct oxr_session *sess,
                         struct oxr_logger *log,
                         uint32_t layer_index,
                         XrCompositionLayerProjection *proj,
+                        const struct layer_chain *lc,
                         struct xrt_device *head,
                         uint64_t timestamp)
 {
@@ -567,7 +636,7 @@ verify_projection_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)proj);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
@@ -587,7 +656,8 @@ verify_projection_layer(struct oxr_session *sess,
 		const XrCompositionLayerProjectionView *view = &proj->views[i];
 
 		//! @todo More validation?
-		if (!math_quat_validate_within_1_percent((struct xrt_quat *)&view->pose.orientation)) {
+		if (!skip_app_checks() &&
+		    !math_quat_validate_within_1_percent((struct xrt_quat *)&view->pose.orientation)) {
 			const XrQuaternionf *q = &view->pose.orientation;
 			return oxr_error(log, XR_ERROR_POSE_INVALID,
 			                 "(frameEndInfo->layers[%u]->views[%i]->pose."
@@ -595,7 +665,7 @@ verify_projection_layer(struct oxr_session *sess,
 			                 layer_index, i, q->x, q->y, q->z, q->w);
 		}
 
-		if (!math_vec3_validate((struct xrt_vec3 *)&view->pose.position)) {
+		if (!skip_app_checks() && !math_vec3_validate((struct xrt_vec3 *)&view->pose.position)) {
 			const XrVector3f *p = &view->pose.position;
 			return oxr_error(log, XR_ERROR_POSE_INVALID,
 			                 "(frameEndInfo->layers[%u]->views[%i]->pose."
@@ -641,7 +711,7 @@ verify_projection_layer(struct oxr_session *sess,
 			                 layer_index, i, sc->face_count);
 		}
 
-		if (is_rect_neg(&view->subImage.imageRect)) {
+		if (!skip_app_checks() && is_rect_neg(&view->subImage.imageRect)) {
 			return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 			                 "(frameEndInfo->layers[%u]->views[%i]-"
 			                 ">subImage.imageRect.offset == {%i, "
@@ -650,7 +720,7 @@ verify_projection_layer(struct oxr_session *sess,
 			                 view->subImage.imageRect.offset.y);
 		}
 
-		if (is_rect_out_of_bounds(&view->subImage.imageRect, sc)) {
+		if (!skip_app_checks() && is_rect_out_of_bounds(&view->subImage.imageRect, sc)) {
 			return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 			                 "(frameEndInfo->layers[%u]->views[%i]->subImage."
 			                 "imageRect == {{%i, %i}, {%u, %u}}) imageRect out "
@@ -661,8 +731,7 @@ verify_projection_layer(struct oxr_session *sess,
 		}
 
 #ifdef OXR_HAVE_KHR_composition_layer_depth
-		const XrCompositionLayerDepthInfoKHR *depth_info = OXR_GET_INPUT_FROM_CHAIN(
-		    view, XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
+		const XrCompositionLayerDepthInfoKHR *depth_info = lc->depth[i];
 
 		if (depth_info) {
 			ret = verify_depth_layer(xc, log, layer_index, i, depth_info);
@@ -692,6 +761,7 @@ verify_cube_layer(struct oxr_session *sess,
                   struct oxr_logger *log,
                   uint32_t layer_index,
                   const XrCompositionLayerCubeKHR *cube,
+                  const struct layer_chain *lc,
                   struct xrt_device *head,
                   uint64_t timestamp)
 {
@@ -713,12 +783,12 @@ verify_cube_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)cube);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
 
-	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&cube->orientation)) {
+	if (!skip_app_checks() && !math_quat_validate_within_1_percent((struct xrt_quat *)&cube->orientation)) {
 		const XrQuaternionf *q = &cube->orientation;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.orientation == {%f %f %f %f}) is not a valid quat",
@@ -760,6 +830,7 @@ verify_cylinder_layer(struct oxr_session *sess,
                       struct oxr_logger *log,
                       uint32_t layer_index,
                       const XrCompositionLayerCylinderKHR *cylinder,
+                      const struct layer_chain *lc,
                       struct xrt_device *head,
                       uint64_t timestamp)
 {
@@ -781,19 +852,20 @@ verify_cylinder_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)cylinder);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
 
-	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&cylinder->pose.orientation)) {
+	if (!skip_app_checks() &&
+	    !math_quat_validate_within_1_percent((struct xrt_quat *)&cylinder->pose.orientation)) {
 		const XrQuaternionf *q = &cylinder->pose.orientation;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.orientation == {%f %f %f %f}) is not a valid quat",
 		                 layer_index, q->x, q->y, q->z, q->w);
 	}
 
-	if (!math_vec3_validate((struct xrt_vec3 *)&cylinder->pose.position)) {
+	if (!skip_app_checks() && !math_vec3_validate((struct xrt_vec3 *)&cylinder->pose.position)) {
 		const XrVector3f *p = &cylinder->pose.position;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.position == {%f %f %f}) is not valid", layer_index,
@@ -826,14 +898,14 @@ verify_cylinder_layer(struct oxr_session *sess,
 		                 layer_index);
 	}
 
-	if (is_rect_neg(&cylinder->subImage.imageRect)) {
+	if (!skip_app_checks() && is_rect_neg(&cylinder->subImage.imageRect)) {
 		return oxr_error(
 		    log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		    "(frameEndInfo->layers[%u]->subImage.imageRect.offset == {%i, %i}) has negative component(s)",
 		    layer_index, cylinder->subImage.imageRect.offset.x, cylinder->subImage.imageRect.offset.y);
 	}
 
-	if (is_rect_out_of_bounds(&cylinder->subImage.imageRect, sc)) {
+	if (!skip_app_checks() && is_rect_out_of_bounds(&cylinder->subImage.imageRect, sc)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->subImage.imageRect == {{%i, %i}, {%u, %u}}) imageRect out "
 		                 "of image bounds (%u, %u)",
@@ -870,6 +942,7 @@ verify_equirect1_layer(struct oxr_session *sess,
                        struct oxr_logger *log,
                        uint32_t layer_index,
                        const XrCompositionLayerEquirectKHR *equirect,
+                       const struct layer_chain *lc,
                        struct xrt_device *head,
                        uint64_t timestamp)
 {
@@ -891,19 +964,20 @@ verify_equirect1_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)equirect);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
 
-	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&equirect->pose.orientation)) {
+	if (!skip_app_checks() &&
+	    !math_quat_validate_within_1_percent((struct xrt_quat *)&equirect->pose.orientation)) {
 		const XrQuaternionf *q = &equirect->pose.orientation;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.orientation == {%f %f %f %f}) is not a valid quat",
 		                 layer_index, q->x, q->y, q->z, q->w);
 	}
 
-	if (!math_vec3_validate((struct xrt_vec3 *)&equirect->pose.position)) {
+	if (!skip_app_checks() && !math_vec3_validate((struct xrt_vec3 *)&equirect->pose.position)) {
 		const XrVector3f *p = &equirect->pose.position;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.position == {%f %f %f}) is not valid", layer_index,
@@ -936,14 +1010,14 @@ verify_equirect1_layer(struct oxr_session *sess,
 		                 layer_index);
 	}
 
-	if (is_rect_neg(&equirect->subImage.imageRect)) {
+	if (!skip_app_checks() && is_rect_neg(&equirect->subImage.imageRect)) {
 		return oxr_error(
 		    log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		    "(frameEndInfo->layers[%u]->subImage.imageRect.offset == {%i, %i}) has negative component(s)",
 		    layer_index, equirect->subImage.imageRect.offset.x, equirect->subImage.imageRect.offset.y);
 	}
 
-	if (is_rect_out_of_bounds(&equirect->subImage.imageRect, sc)) {
+	if (!skip_app_checks() && is_rect_out_of_bounds(&equirect->subImage.imageRect, sc)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->subImage.imageRect == {{%i, %i}, {%u, %u}}) imageRect out "
 		                 "of image bounds (%u, %u)",
@@ -968,6 +1042,7 @@ verify_equirect2_layer(struct oxr_session *sess,
                        struct oxr_logger *log,
                        uint32_t layer_index,
                        const XrCompositionLayerEquirect2KHR *equirect,
+                       const struct layer_chain *lc,
                        struct xrt_device *head,
                        uint64_t timestamp)
 {
@@ -988,19 +1063,20 @@ verify_equirect2_layer(struct oxr_session *sess,
 		return ret;
 	}
 
-	ret = verify_blend_factors(log, sess, layer_index, (XrCompositionLayerBaseHeader *)equirect);
+	ret = verify_blend_factors(log, lc, layer_index);
 	if (ret != XR_SUCCESS) {
 		return ret;
 	}
 
-	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&equirect->pose.orientation)) {
+	if (!skip_app_checks() &&
+	    !math_quat_validate_within_1_percent((struct xrt_quat *)&equirect->pose.orientation)) {
 		const XrQuaternionf *q = &equirect->pose.orientation;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.orientation == {%f %f %f %f}) is not a valid quat",
 		                 layer_index, q->x, q->y, q->z, q->w);
 	}
 
-	if (!math_vec3_validate((struct xrt_vec3 *)&equirect->pose.position)) {
+	if (!skip_app_checks() && !math_vec3_validate((struct xrt_vec3 *)&equirect->pose.position)) {
 		const XrVector3f *p = &equirect->pose.position;
 		return oxr_error(log, XR_ERROR_POSE_INVALID,
 		                 "(frameEndInfo->layers[%u]->pose.position == {%f %f %f}) is not valid", layer_index,
@@ -1033,14 +1109,14 @@ verify_equirect2_layer(struct oxr_session *sess,
 		                 layer_index);
 	}
 
-	if (is_rect_neg(&equirect->subImage.imageRect)) {
+	if (!skip_app_checks() && is_rect_neg(&equirect->subImage.imageRect)) {
 		return oxr_error(
 		    log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		    "(frameEndInfo->layers[%u]->subImage.imageRect.offset == {%i, %i}) has negative component(s)",
 		    layer_index, equirect->subImage.imageRect.offset.x, equirect->subImage.imageRect.offset.y);
 	}
 
-	if (is_rect_out_of_bounds(&equirect->subImage.imageRect, sc)) {
+	if (!skip_app_checks() && is_rect_out_of_bounds(&equirect->subImage.imageRect, sc)) {
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
 		                 "(frameEndInfo->layers[%u]->subImage.imageRect == {{%i, %i}, {%u, %u}}) imageRect out "
 		                 "of image bounds (%u, %u)",
@@ -1143,6 +1219,7 @@ submit_quad_layer(struct oxr_session *sess,
                   struct xrt_compositor *xc,
                   struct oxr_logger *log,
                   XrCompositionLayerQuad *quad,
+                  const struct layer_chain *lc,
                   struct xrt_device *head,
                   struct xrt_pose *inv_offset,
                   uint64_t oxr_timestamp,
@@ -1177,11 +1254,11 @@ submit_quad_layer(struct oxr_session *sess,
 	data.quad.pose = pose;
 	data.quad.size = *size;
 	fill_in_sub_image(sc, &quad->subImage, &data.quad.sub);
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)quad, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)quad, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)quad, &data);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)quad, &data);
-	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)quad, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_layer_settings(lc, &data);
+	fill_in_depth_test(lc, &data);
 
 	xrt_result_t xret = xrt_comp_layer_quad(xc, head, sc->swapchain, &data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_quad);
@@ -1189,11 +1266,30 @@ submit_quad_layer(struct oxr_session *sess,
 	return XR_SUCCESS;
 }
 
+/*!
+ * Only passed on if the views were located for the frame, a projection layer
+ * rendered with older poses would report too low a latency.
+ */
+static uint64_t
+get_view_sample_ns(struct oxr_session *sess, uint64_t xrt_timestamp)
+{
+	uint64_t sample_ns = 0;
+
+	os_mutex_lock(&sess->view_sample.mutex);
+	if (sess->view_sample.display_time_ns == xrt_timestamp) {
+		sample_ns = sess->view_sample.sample_ns;
+	}
+	os_mutex_unlock(&sess->view_sample.mutex);
+
+	return sample_ns;
+}
+
 static XrResult
 submit_projection_layer(struct oxr_session *sess,
                         struct xrt_compositor *xc,
                         struct oxr_logger *log,
                         XrCompositionLayerProjection *proj,
+                        const struct layer_chain *lc,
                         struct xrt_device *head,
                         struct xrt_pose *inv_offset,
                         uint64_t oxr_timestamp,
@@ -1229,6 +1325,7 @@ submit_projection_layer(struct oxr_session *sess,
 	data.type = XRT_LAYER_STEREO_PROJECTION;
 	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
 	data.timestamp = xrt_timestamp;
+	data.pose_sample_ns = get_view_sample_ns(sess, xrt_timestamp);
 	data.flags = flags;
 	data.stereo.l.fov = *l_fov;
 	data.stereo.l.pose = pose[0];
@@ -1236,14 +1333,13 @@ submit_projection_layer(struct oxr_session *sess,
 	data.stereo.r.pose = pose[1];
 	fill_in_sub_image(scs[0], &proj->views[0].subImage, &data.stereo.l.sub);
 	fill_in_sub_image(scs[1], &proj->views[1].subImage, &data.stereo.r.sub);
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)proj, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)proj, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)proj, &data);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)proj, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_layer_settings(lc, &data);
 
 #ifdef OXR_HAVE_KHR_composition_layer_depth
-	const XrCompositionLayerDepthInfoKHR *d_l = OXR_GET_INPUT_FROM_CHAIN(
-	    &proj->views[0], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
+	const XrCompositionLayerDepthInfoKHR *d_l = lc->depth[0];
 	if (d_l) {
 		data.stereo_depth.l_d.far_z = d_l->farZ;
 		data.stereo_depth.l_d.near_z = d_l->nearZ;
@@ -1258,8 +1354,7 @@ submit_projection_layer(struct oxr_session *sess,
 		d_scs[0] = sc;
 	}
 
-	const XrCompositionLayerDepthInfoKHR *d_r = OXR_GET_INPUT_FROM_CHAIN(
-	    &proj->views[1], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, XrCompositionLayerDepthInfoKHR);
+	const XrCompositionLayerDepthInfoKHR *d_r = lc->depth[1];
 
 	if (d_r) {
 		data.stereo_depth.r_d.far_z = d_r->farZ;
@@ -1278,7 +1373,7 @@ submit_projection_layer(struct oxr_session *sess,
 
 	if (d_scs[0] != NULL && d_scs[1] != NULL) {
 #ifdef OXR_HAVE_KHR_composition_layer_depth
-		fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)proj, &data);
+		fill_in_depth_test(lc, &data);
 		data.type = XRT_LAYER_STEREO_PROJECTION_DEPTH;
 		xrt_result_t xret = xrt_comp_layer_stereo_projection_depth( //
 		    xc,                                                     // compositor
@@ -1310,6 +1405,7 @@ submit_cube_layer(struct oxr_session *sess,
                   struct xrt_compositor *xc,
                   struct oxr_logger *log,
                   const XrCompositionLayerCubeKHR *cube,
+                  const struct layer_chain *lc,
                   struct xrt_device *head,
                   struct xrt_pose *inv_offset,
                   uint64_t oxr_timestamp,
@@ -1324,7 +1420,7 @@ submit_cube_layer(struct oxr_session *sess,
 	data.name = XRT_INPUT_GENERIC_HEAD_POSE;
 	data.timestamp = xrt_timestamp;
 	data.flags = convert_layer_flags(cube->layerFlags);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)cube, &data);
+	fill_in_layer_settings(lc, &data);
 
 	if (spc->space_type == OXR_SPACE_TYPE_REFERENCE_VIEW) {
 		data.flags |= XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT;
@@ -1334,10 +1430,10 @@ submit_cube_layer(struct oxr_session *sess,
 
 	data.cube.sub.image_index = sc->released.index;
 	data.cube.sub.array_index = cube->imageArrayIndex;
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)cube, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)cube, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)cube, &data);
-	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)cube, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_depth_test(lc, &data);
 
 	struct xrt_pose pose = {
 	    .orientation =
@@ -1365,6 +1461,7 @@ submit_cylinder_layer(struct oxr_session *sess,
                       struct xrt_compositor *xc,
                       struct oxr_logger *log,
                       const XrCompositionLayerCylinderKHR *cylinder,
+                      const struct layer_chain *lc,
                       struct xrt_device *head,
                       struct xrt_pose *inv_offset,
                       uint64_t oxr_timestamp,
@@ -1400,11 +1497,11 @@ submit_cylinder_layer(struct oxr_session *sess,
 	data.cylinder.central_angle = cylinder->centralAngle;
 	data.cylinder.aspect_ratio = cylinder->aspectRatio;
 	fill_in_sub_image(sc, &cylinder->subImage, &data.cylinder.sub);
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
-	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_layer_settings(lc, &data);
+	fill_in_depth_test(lc, &data);
 
 	xrt_result_t xret = xrt_comp_layer_cylinder(xc, head, sc->swapchain, &data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_cylinder);
@@ -1417,6 +1514,7 @@ submit_equirect1_layer(struct oxr_session *sess,
                        struct xrt_compositor *xc,
                        struct oxr_logger *log,
                        const XrCompositionLayerEquirectKHR *equirect,
+                       const struct layer_chain *lc,
                        struct xrt_device *head,
                        struct xrt_pose *inv_offset,
                        uint64_t oxr_timestamp,
@@ -1448,11 +1546,11 @@ submit_equirect1_layer(struct oxr_session *sess,
 	data.equirect1.pose = pose;
 	data.equirect1.radius = equirect->radius;
 	fill_in_sub_image(sc, &equirect->subImage, &data.equirect1.sub);
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_layer_settings(lc, &data);
+	fill_in_depth_test(lc, &data);
 
 	struct xrt_vec2 *scale = (struct xrt_vec2 *)&equirect->scale;
 	struct xrt_vec2 *bias = (struct xrt_vec2 *)&equirect->bias;
@@ -1480,6 +1578,7 @@ submit_equirect2_layer(struct oxr_session *sess,
                        struct xrt_compositor *xc,
                        struct oxr_logger *log,
                        const XrCompositionLayerEquirect2KHR *equirect,
+                       const struct layer_chain *lc,
                        struct xrt_device *head,
                        struct xrt_pose *inv_offset,
                        uint64_t oxr_timestamp,
@@ -1514,11 +1613,11 @@ submit_equirect2_layer(struct oxr_session *sess,
 	data.equirect2.upper_vertical_angle = equirect->upperVerticalAngle;
 	data.equirect2.lower_vertical_angle = equirect->lowerVerticalAngle;
 	fill_in_sub_image(sc, &equirect->subImage, &data.equirect2.sub);
-	fill_in_color_scale_bias(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_y_flip(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
-	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
+	fill_in_color_scale_bias(lc, &data);
+	fill_in_y_flip(lc, &data);
+	fill_in_blend_factors(lc, &data);
+	fill_in_layer_settings(lc, &data);
+	fill_in_depth_test(lc, &data);
 
 	xrt_result_t xret = xrt_comp_layer_equirect2(xc, head, sc->swapchain, &data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_equirect2);
@@ -1621,6 +1720,23 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 		return oxr_error(log, XR_ERROR_LAYER_INVALID, "(frameEndInfo->layers == NULL)");
 	}
 
+	uint32_t max_layers = sess->sys->xsysc->info.max_layers;
+	if (frameEndInfo->layerCount > max_layers) {
+		return oxr_error(log, XR_ERROR_LAYER_LIMIT_EXCEEDED,
+		                 "(frameEndInfo->layerCount == %u) exceeds maxLayerCount of %u", frameEndInfo->layerCount,
+		                 max_layers);
+	}
+
+	// Nothing from the previous frame is kept around.
+	u_arena_reset(&sess->frame_arena);
+
+	// Chains are walked once here and reused when submitting.
+	struct layer_chain *chains =
+	    U_ARENA_TYPED_ARRAY_CALLOC(&sess->frame_arena, struct layer_chain, frameEndInfo->layerCount);
+	if (chains == NULL && frameEndInfo->layerCount > 0) {
+		return oxr_error(log, XR_ERROR_OUT_OF_MEMORY, "Failed to allocate layer chains");
+	}
+
 	for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
 		const XrCompositionLayerBaseHeader *layer = frameEndInfo->layers[i];
 		if (layer == NULL) {
@@ -1628,32 +1744,34 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 			                 "(frameEndInfo->layers[%u] == NULL) layer cannot be null", i);
 		}
 
+		gather_layer_chain(sess, layer, &chains[i]);
+
 		XrResult res;
 
 		switch (layer->type) {
 		case XR_TYPE_COMPOSITION_LAYER_PROJECTION:
-			res = verify_projection_layer(sess, xc, log, i, (XrCompositionLayerProjection *)layer, xdev,
-			                              frameEndInfo->displayTime);
+			res = verify_projection_layer(sess, xc, log, i, (XrCompositionLayerProjection *)layer,
+			                              &chains[i], xdev, frameEndInfo->displayTime);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_QUAD:
-			res = verify_quad_layer(sess, xc, log, i, (XrCompositionLayerQuad *)layer, xdev,
+			res = verify_quad_layer(sess, xc, log, i, (XrCompositionLayerQuad *)layer, &chains[i], xdev,
 			                        frameEndInfo->displayTime);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR:
-			res = verify_cube_layer(sess, xc, log, i, (XrCompositionLayerCubeKHR *)layer, xdev,
+			res = verify_cube_layer(sess, xc, log, i, (XrCompositionLayerCubeKHR *)layer, &chains[i], xdev,
 			                        frameEndInfo->displayTime);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
-			res = verify_cylinder_layer(sess, xc, log, i, (XrCompositionLayerCylinderKHR *)layer, xdev,
-			                            frameEndInfo->displayTime);
+			res = verify_cylinder_layer(sess, xc, log, i, (XrCompositionLayerCylinderKHR *)layer,
+			                            &chains[i], xdev, frameEndInfo->displayTime);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
-			res = verify_equirect1_layer(sess, xc, log, i, (XrCompositionLayerEquirectKHR *)layer, xdev,
-			                             frameEndInfo->displayTime);
+			res = verify_equirect1_layer(sess, xc, log, i, (XrCompositionLayerEquirectKHR *)layer,
+			                             &chains[i], xdev, frameEndInfo->displayTime);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
-			res = verify_equirect2_layer(sess, xc, log, i, (XrCompositionLayerEquirect2KHR *)layer, xdev,
-			                             frameEndInfo->displayTime);
+			res = verify_equirect2_layer(sess, xc, log, i, (XrCompositionLayerEquirect2KHR *)layer,
+			                             &chains[i], xdev, frameEndInfo->displayTime);
 			break;
 		default:
 			return oxr_error(log, XR_ERROR_LAYER_INVALID,
@@ -1693,27 +1811,27 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 
 		switch (layer->type) {
 		case XR_TYPE_COMPOSITION_LAYER_PROJECTION:
-			submit_projection_layer(sess, xc, log, (XrCompositionLayerProjection *)layer, xdev, &inv_offset,
-			                        frameEndInfo->displayTime, xrt_display_time_ns);
+			submit_projection_layer(sess, xc, log, (XrCompositionLayerProjection *)layer, &chains[i], xdev,
+			                        &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_QUAD:
-			submit_quad_layer(sess, xc, log, (XrCompositionLayerQuad *)layer, xdev, &inv_offset,
+			submit_quad_layer(sess, xc, log, (XrCompositionLayerQuad *)layer, &chains[i], xdev, &inv_offset,
 			                  frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR:
-			submit_cube_layer(sess, xc, log, (XrCompositionLayerCubeKHR *)layer, xdev, &inv_offset,
-			                  frameEndInfo->displayTime, xrt_display_time_ns);
+			submit_cube_layer(sess, xc, log, (XrCompositionLayerCubeKHR *)layer, &chains[i], xdev,
+			                  &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
-			submit_cylinder_layer(sess, xc, log, (XrCompositionLayerCylinderKHR *)layer, xdev, &inv_offset,
-			                      frameEndInfo->displayTime, xrt_display_time_ns);
+			submit_cylinder_layer(sess, xc, log, (XrCompositionLayerCylinderKHR *)layer, &chains[i], xdev,
+			                      &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
-			submit_equirect1_layer(sess, xc, log, (XrCompositionLayerEquirectKHR *)layer, xdev, &inv_offset,
-			                       frameEndInfo->displayTime, xrt_display_time_ns);
+			submit_equirect1_layer(sess, xc, log, (XrCompositionLayerEquirectKHR *)layer, &chains[i], xdev,
+			                       &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
-			submit_equirect2_layer(sess, xc, log, (XrCompositionLayerEquirect2KHR *)layer, xdev,
+			submit_equirect2_layer(sess, xc, log, (XrCompositionLayerEquirect2KHR *)layer, &chains[i], xdev,
 			                       &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		default: assert(false && "invalid layer type");
@@ -120,6 +120,9 @@ oxr_space_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_space *spc = (struct oxr_space *)hb;
 
+	// A new space could be allocated at the same address.
+	oxr_space_locate_cache_clear(spc->sess);
+
 	// Unreference the reference space.
 	enum xrt_reference_space_type xtype = oxr_ref_space_to_xrt(spc->space_type);
 	if (xtype != XRT_SPACE_REFERENCE_TYPE_INVALID) {
@@ -192,6 +195,113 @@ oxr_space_reference_create(struct oxr_logger *log,
 }
 
 
+/*
+ *
+ * Locate cache functions.
+ *
+ */
+
+static bool
+locate_cache_find(struct oxr_session *sess,
+                  struct oxr_space *spc,
+                  struct xrt_device *xdev,
+                  struct oxr_space *base_spc,
+                  XrTime time,
+                  struct xrt_space_relation *out_relation)
+{
+	if (!sess->locate_cache.enabled) {
+		return false;
+	}
+
+	bool found = false;
+
+	os_mutex_lock(&sess->locate_cache.mutex);
+	for (uint32_t i = 0; i < sess->locate_cache.count; i++) {
+		struct oxr_locate_cache_entry *e = &sess->locate_cache.entries[i];
+		if (e->spc == spc && e->xdev == xdev && e->base_spc == base_spc && e->time == time) {
+			*out_relation = e->relation;
+			found = true;
+			break;
+		}
+	}
+	os_mutex_unlock(&sess->locate_cache.mutex);
+
+	return found;
+}
+
+static void
+locate_cache_store(struct oxr_session *sess,
+                   struct oxr_space *spc,
+                   struct xrt_device *xdev,
+                   struct oxr_space *base_spc,
+                   XrTime time,
+                   const struct xrt_space_relation *relation)
+{
+	if (!sess->locate_cache.enabled) {
+		return;
+	}
+
+	os_mutex_lock(&sess->locate_cache.mutex);
+
+	uint32_t index;
+	if (sess->locate_cache.count < OXR_LOCATE_CACHE_SIZE) {
+		index = sess->locate_cache.count++;
+	} else {
+		// Full, replace the oldest entry.
+		index = sess->locate_cache.next;
+		sess->locate_cache.next = (index + 1) % OXR_LOCATE_CACHE_SIZE;
+	}
+
+	struct oxr_locate_cache_entry *e = &sess->locate_cache.entries[index];
+	e->spc = spc;
+	e->xdev = xdev;
+	e->base_spc = base_spc;
+	e->time = time;
+	e->relation = *relation;
+
+	os_mutex_unlock(&sess->locate_cache.mutex);
+}
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+/*!
+ * Fill in the velocity part of a location, shared between XrSpaceVelocity
+ * and XrSpaceVelocityDataKHR which have the same fields. An invalid
+ * relation has no valid velocity bits, so it gets zeroed velocities.
+ */
+static void
+fill_in_velocity(const struct xrt_space_relation *result,
+                 XrSpaceVelocityFlags *out_flags,
+                 XrVector3f *out_linear,
+                 XrVector3f *out_angular)
+{
+	*out_flags = 0;
+
+	if ((result->relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0) {
+		out_linear->x = result->linear_velocity.x;
+		out_linear->y = result->linear_velocity.y;
+		out_linear->z = result->linear_velocity.z;
+		*out_flags |= XR_SPACE_VELOCITY_LINEAR_VALID_BIT;
+	} else {
+		U_ZERO(out_linear);
+	}
+
+	if ((result->relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0) {
+		out_angular->x = result->angular_velocity.x;
+		out_angular->y = result->angular_velocity.y;
+		out_angular->z = result->angular_velocity.z;
+		*out_flags |= XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+	} else {
+		U_ZERO(out_angular);
+	}
+}
+
+
 /*
  *
  * OpenXR API functions.
@@ -235,7 +345,8 @@ oxr_space_locate(
 
 	// Only fill this out if the above succeeded.
 	struct xrt_space_relation result = XRT_SPACE_RELATION_ZERO;
-	if (xtarget != NULL && xbase != NULL) {
+	if (xtarget != NULL && xbase != NULL &&
+	    !locate_cache_find(spc->sess, spc, NULL, baseSpc, time, &result)) {
 		// Convert at_time to monotonic and give to device.
 		uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
 
@@ -248,6 +359,8 @@ oxr_space_locate(
 		    xtarget,                     //
 		    &spc->pose,                  //
 		    &result);                    //
+
+		locate_cache_store(spc->sess, spc, NULL, baseSpc, time, &result);
 	}
 
 
@@ -261,9 +374,7 @@ oxr_space_locate(
 		OXR_XRT_POSE_TO_XRPOSEF(XRT_POSE_IDENTITY, location->pose);
 
 		if (vel) {
-			vel->velocityFlags = 0;
-			U_ZERO(&vel->linearVelocity);
-			U_ZERO(&vel->angularVelocity);
+			fill_in_velocity(&result, &vel->velocityFlags, &vel->linearVelocity, &vel->angularVelocity);
 		}
 
 		if (print) {
@@ -289,24 +400,7 @@ oxr_space_locate(
 	}
 
 	if (vel) {
-		vel->velocityFlags = 0;
-		if ((result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0) {
-			vel->linearVelocity.x = result.linear_velocity.x;
-			vel->linearVelocity.y = result.linear_velocity.y;
-			vel->linearVelocity.z = result.linear_velocity.z;
-			vel->velocityFlags |= XR_SPACE_VELOCITY_LINEAR_VALID_BIT;
-		} else {
-			U_ZERO(&vel->linearVelocity);
-		}
-
-		if ((result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0) {
-			vel->angularVelocity.x = result.angular_velocity.x;
-			vel->angularVelocity.y = result.angular_velocity.y;
-			vel->angularVelocity.z = result.angular_velocity.z;
-			vel->velocityFlags |= XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
-		} else {
-			U_ZERO(&vel->angularVelocity);
-		}
+		fill_in_velocity(&result, &vel->velocityFlags, &vel->linearVelocity, &vel->angularVelocity);
 	}
 
 
@@ -324,6 +418,130 @@ oxr_space_locate(
 	return oxr_session_success_result(spc->sess);
 }
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+
+//! How many spaces are given to the space overseer at once, keeps the arrays on the stack.
+#define OXR_LOCATE_SPACES_BATCH_SIZE (32)
+
+static void
+write_space_location_data(const struct xrt_space_relation *result,
+                          XrSpaceLocationDataKHR *location,
+                          XrSpaceVelocityDataKHR *vel)
+{
+	if (result->relation_flags == 0) {
+		location->locationFlags = 0;
+		OXR_XRT_POSE_TO_XRPOSEF(XRT_POSE_IDENTITY, location->pose);
+	} else {
+		OXR_XRT_POSE_TO_XRPOSEF(result->pose, location->pose);
+		location->locationFlags = xrt_to_xr_space_location_flags(result->relation_flags);
+	}
+
+	if (vel) {
+		fill_in_velocity(result, &vel->velocityFlags, &vel->linearVelocity, &vel->angularVelocity);
+	}
+}
+
+XrResult
+oxr_space_locate_spaces(struct oxr_logger *log,
+                        struct oxr_session *sess,
+                        struct oxr_space *baseSpc,
+                        XrTime time,
+                        const XrSpace *spaces,
+                        uint32_t space_count,
+                        XrSpaceLocationDataKHR *locations,
+                        XrSpaceVelocityDataKHR *velocities)
+{
+	struct oxr_system *sys = sess->sys;
+	const struct xrt_space_relation invalid = XRT_SPACE_RELATION_ZERO;
+
+	struct xrt_space *xbase = NULL;
+	XrResult ret = get_xrt_space(log, baseSpc, &xbase);
+	if (xbase == NULL) {
+		for (uint32_t i = 0; i < space_count; i++) {
+			XrSpaceVelocityDataKHR *vel = velocities != NULL ? &velocities[i] : NULL;
+			write_space_location_data(&invalid, &locations[i], vel);
+		}
+		return ret; // Return any error.
+	}
+
+	// Convert at_time to monotonic and give to device.
+	uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
+
+	for (uint32_t start = 0; start < space_count; start += OXR_LOCATE_SPACES_BATCH_SIZE) {
+		uint32_t count = MIN(space_count - start, OXR_LOCATE_SPACES_BATCH_SIZE);
+
+		struct xrt_space *xspaces[OXR_LOCATE_SPACES_BATCH_SIZE];
+		struct xrt_pose offsets[OXR_LOCATE_SPACES_BATCH_SIZE];
+		struct xrt_space_relation results[OXR_LOCATE_SPACES_BATCH_SIZE];
+		struct oxr_space *spcs[OXR_LOCATE_SPACES_BATCH_SIZE];
+		uint32_t indices[OXR_LOCATE_SPACES_BATCH_SIZE];
+		uint32_t located_count = 0;
+
+		for (uint32_t i = start; i < start + count; i++) {
+			struct oxr_space *spc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, spaces[i]);
+			struct xrt_space *xspace = NULL;
+
+			XrResult xret = get_xrt_space(log, spc, &xspace);
+			// Make sure not to overwrite the first error.
+			if (ret == XR_SUCCESS) {
+				ret = xret;
+			}
+
+			// Unbound action spaces and the like are not located.
+			if (xspace == NULL) {
+				XrSpaceVelocityDataKHR *vel = velocities != NULL ? &velocities[i] : NULL;
+				write_space_location_data(&invalid, &locations[i], vel);
+				continue;
+			}
+
+			// Already located this frame, same as oxr_space_locate does.
+			struct xrt_space_relation cached;
+			if (locate_cache_find(sess, spc, NULL, baseSpc, time, &cached)) {
+				XrSpaceVelocityDataKHR *vel = velocities != NULL ? &velocities[i] : NULL;
+				write_space_location_data(&cached, &locations[i], vel);
+				continue;
+			}
+
+			xspaces[located_count] = xspace;
+			offsets[located_count] = spc->pose;
+			spcs[located_count] = spc;
+			indices[located_count] = i;
+			located_count++;
+		}
+
+		if (located_count == 0) {
+			continue;
+		}
+
+		// Ask the space overseer to locate all of the spaces in one go.
+		xrt_space_overseer_locate_spaces( //
+		    sys->xso,                     //
+		    xbase,                        //
+		    &baseSpc->pose,               //
+		    at_timestamp_ns,              //
+		    xspaces,                      //
+		    located_count,                //
+		    offsets,                      //
+		    results);                     //
+
+		for (uint32_t k = 0; k < located_count; k++) {
+			uint32_t i = indices[k];
+			locate_cache_store(sess, spcs[k], NULL, baseSpc, time, &results[k]);
+
+			XrSpaceVelocityDataKHR *vel = velocities != NULL ? &velocities[i] : NULL;
+			write_space_location_data(&results[k], &locations[i], vel);
+		}
+	}
+
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	return oxr_session_success_result(sess);
+}
+
+#endif // OXR_HAVE_KHR_locate_spaces
+
 
 /*
  *
@@ -348,6 +566,10 @@ oxr_space_locate_device(struct oxr_logger *log,
 		return ret;
 	}
 
+	if (locate_cache_find(baseSpc->sess, NULL, xdev, baseSpc, time, out_relation)) {
+		return ret;
+	}
+
 	// Convert at_time to monotonic and give to device.
 	uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
 
@@ -360,5 +582,16 @@ oxr_space_locate_device(struct oxr_logger *log,
 	    xdev,                         //
 	    out_relation);                //
 
+	locate_cache_store(baseSpc->sess, NULL, xdev, baseSpc, time, out_relation);
+
 	return ret;
 }
+
+void
+oxr_space_locate_cache_clear(struct oxr_session *sess)
+{
+	os_mutex_lock(&sess->locate_cache.mutex);
+	sess->locate_cache.count = 0;
+	sess->locate_cache.next = 0;
+	os_mutex_unlock(&sess->locate_cache.mutex);
+}
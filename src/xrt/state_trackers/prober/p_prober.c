@@ -266,6 +266,7 @@ fill_out_product(struct prober *p, struct prober_device *pdev)
 			str = U_CALLOC_WITH_CAST(char, ret + 1);
 		} else {
 			pdev->usb.product = str;
+			pdev->usb.product_is_placeholder = true;
 			return;
 		}
 	} while (true);
@@ -298,6 +299,136 @@ add_builder(struct prober *p, struct xrt_builder *xb)
 	P_TRACE(p, "%s: %s", xb->identifier, xb->name);
 }
 
+static bool
+string_cache_matches(const struct prober_string_cache_entry *e, const struct prober_device *pdev)
+{
+	return e->bus == pdev->usb.bus && e->addr == pdev->usb.addr && e->vendor_id == pdev->base.vendor_id &&
+	       e->product_id == pdev->base.product_id;
+}
+
+static struct prober_string_cache_entry *
+string_cache_get(struct prober *p, const struct prober_device *pdev)
+{
+	for (size_t i = 0; i < p->string_cache_count; i++) {
+		if (string_cache_matches(&p->string_cache[i], pdev)) {
+			return &p->string_cache[i];
+		}
+	}
+
+	U_ARRAY_REALLOC_OR_FREE(p->string_cache, struct prober_string_cache_entry, (p->string_cache_count + 1));
+
+	struct prober_string_cache_entry *e = &p->string_cache[p->string_cache_count++];
+	U_ZERO(e);
+	e->bus = pdev->usb.bus;
+	e->addr = pdev->usb.addr;
+	e->vendor_id = pdev->base.vendor_id;
+	e->product_id = pdev->base.product_id;
+
+	return e;
+}
+
+/*!
+ * Drop the strings of devices that are gone, called after probing.
+ */
+static void
+string_cache_prune(struct prober *p)
+{
+	size_t i = 0;
+	while (i < p->string_cache_count) {
+		bool found = false;
+		for (size_t k = 0; k < p->device_count && !found; k++) {
+			found = p->devices[k].base.bus == XRT_BUS_TYPE_USB &&
+			        string_cache_matches(&p->string_cache[i], &p->devices[k]);
+		}
+
+		if (found) {
+			i++;
+		} else {
+			// Order does not matter, move the last one in.
+			p->string_cache[i] = p->string_cache[--p->string_cache_count];
+		}
+	}
+}
+
+static int
+copy_string(const char *str, unsigned char *buffer, size_t max_length)
+{
+	if (max_length == 0) {
+		return 0;
+	}
+
+	size_t len = strlen(str);
+	if (len >= max_length) {
+		len = max_length - 1;
+	}
+	memcpy(buffer, str, len);
+	buffer[len] = '\0';
+
+	return (int)len;
+}
+
+/*!
+ * The strings udev read from sysfs, those came from the kernel's copy of the
+ * descriptors so they are free to get. Only used when plain ASCII, to give
+ * the same result as reading them through libusb.
+ */
+static const char *
+get_sysfs_string(const struct prober_device *pdev, enum xrt_prober_string which_string)
+{
+	const char *str = NULL;
+	switch (which_string) {
+	case XRT_PROBER_STRING_MANUFACTURER: str = pdev->usb.manufacturer; break;
+	case XRT_PROBER_STRING_PRODUCT: str = pdev->usb.product_is_placeholder ? NULL : pdev->usb.product; break;
+	case XRT_PROBER_STRING_SERIAL_NUMBER: str = pdev->usb.serial; break;
+	default: break;
+	}
+
+	for (const char *c = str; c != NULL && *c != '\0'; c++) {
+		if ((unsigned char)*c > 0x7f) {
+			return NULL;
+		}
+	}
+
+	return str;
+}
+
+#ifdef XRT_HAVE_LIBUSB
+static int
+get_usb_string_cached(struct prober *p,
+                      struct prober_device *pdev,
+                      enum xrt_prober_string which_string,
+                      unsigned char *buffer,
+                      size_t max_length)
+{
+	if ((uint32_t)which_string >= P_PROBER_STRING_COUNT) {
+		return 0;
+	}
+
+	struct prober_string_cache_entry *e = string_cache_get(p, pdev);
+	uint32_t bit = 1u << which_string;
+
+	if ((e->have_mask & bit) == 0) {
+		unsigned char tmp[P_PROBER_STRING_CACHE_LENGTH];
+		int ret = p_libusb_get_string_descriptor(p, pdev, which_string, tmp, (int)sizeof(tmp));
+		if (ret < 0) {
+			// Not cached, the device might be openable the next time around.
+			return ret;
+		}
+		if (ret >= (int)sizeof(tmp)) {
+			ret = (int)sizeof(tmp) - 1;
+		}
+
+		// The array might have moved, look the entry up again.
+		e = string_cache_get(p, pdev);
+		memcpy(e->strings[which_string], tmp, (size_t)ret);
+		e->strings[which_string][ret] = '\0';
+		e->have_mask |= bit;
+	}
+
+	return copy_string(e->strings[which_string], buffer, max_length);
+}
+#endif
+
 static int
 collect_entries(struct prober *p)
 {
@@ -612,6 +743,10 @@ teardown(struct prober *p)
 
 	teardown_devices(p);
 
+	free(p->string_cache);
+	p->string_cache = NULL;
+	p->string_cache_count = 0;
+
 #ifdef XRT_HAVE_LIBUVC
 	p_libuvc_teardown(p);
 #endif
@@ -912,6 +1047,8 @@ p_probe(struct xrt_prober *xp)
 	}
 #endif
 
+	string_cache_prune(p);
+
 	return XRT_SUCCESS;
 }
 
@@ -1345,10 +1482,17 @@ p_get_string_descriptor(struct xrt_prober *xp,
 	struct prober_device *pdev = (struct prober_device *)xpdev;
 	int ret = 0;
 
+	if (pdev->base.bus == XRT_BUS_TYPE_USB) {
+		const char *str = get_sysfs_string(pdev, which_string);
+		if (str != NULL) {
+			return copy_string(str, buffer, max_length);
+		}
+	}
+
 #ifdef XRT_HAVE_LIBUSB
 	if (pdev->base.bus == XRT_BUS_TYPE_USB && pdev->usb.dev != NULL) {
 		assert(max_length < INT_MAX);
-		ret = p_libusb_get_string_descriptor(p, pdev, which_string, buffer, (int)max_length);
+		ret = get_usb_string_cached(p, pdev, which_string, buffer, max_length);
 		if (ret >= 0) {
 			return ret;
 		}
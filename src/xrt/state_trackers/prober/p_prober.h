@@ -37,6 +37,8 @@
  */
 
 #define P_PROBER_BLUETOOTH_PRODUCT_COUNT 64
+#define P_PROBER_STRING_CACHE_LENGTH 256
+#define P_PROBER_STRING_COUNT 3
 
 #define P_TRACE(d, ...) U_LOG_IFL_T(d->log_level, __VA_ARGS__)
 #define P_DEBUG(d, ...) U_LOG_IFL_D(d->log_level, __VA_ARGS__)
@@ -87,6 +89,9 @@ struct prober_device
 		uint8_t ports[8];
 		uint32_t num_ports;
 
+		//! @ref product was made up for listing, it is not from the device.
+		bool product_is_placeholder;
+
 #ifdef XRT_HAVE_LIBUSB
 		libusb_device *dev;
 #endif
@@ -117,6 +122,24 @@ struct prober_device
 #endif
 };
 
+/*!
+ * String descriptors read from one USB device, identified by where it sits on
+ * the bus. A device that is plugged in again gets a new address and so a new
+ * entry.
+ */
+struct prober_string_cache_entry
+{
+	uint16_t bus;
+	uint16_t addr;
+	uint16_t vendor_id;
+	uint16_t product_id;
+
+	//! Bit per @ref xrt_prober_string that has been read, empty strings included.
+	uint32_t have_mask;
+
+	char strings[P_PROBER_STRING_COUNT][P_PROBER_STRING_CACHE_LENGTH];
+};
+
 /*!
  * @implements xrt_prober
  */
@@ -167,6 +190,13 @@ struct prober
 	size_t device_count;
 	struct prober_device *devices;
 
+	/*!
+	 * String descriptors read so far, kept across probes so a device only
+	 * has to be opened for them the first time it is seen.
+	 */
+	size_t string_cache_count;
+	struct prober_string_cache_entry *string_cache;
+
 	size_t num_entries;
 	struct xrt_prober_entry **entries;
 
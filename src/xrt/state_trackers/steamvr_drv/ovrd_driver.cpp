@@ -12,7 +12,10 @@
  */
 
 #include <cstring>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "math/m_api.h"
 #include "ovrd_log.hpp"
@@ -25,6 +28,7 @@ extern "C" {
 
 #include <math/m_space.h>
 #include "os/os_time.h"
+#include "util/u_time.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_builders.h"
@@ -52,6 +56,9 @@ DEBUG_GET_ONCE_BOOL_OPTION(emulate_index_controller, "STEAMVR_EMULATE_INDEX_CONT
 
 DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 140)
 
+//! Rate in Hz poses are sent to SteamVR at, zero uses twice the display frequency.
+DEBUG_GET_ONCE_NUM_OPTION(pose_rate, "STEAMVR_POSE_RATE", 0)
+
 #define MODELNUM_LEN (XRT_DEVICE_NAME_LEN + 9) // "[Monado] "
 
 #define OPENVR_BONE_COUNT 31
@@ -61,6 +68,182 @@ DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 1
 #undef DUMP_POSE_CONTROLLERS
 
 
+/*
+ *
+ * Pose publishing
+ *
+ */
+
+//! Poses that did not change are still sent this often, so SteamVR doesn't consider the device gone.
+#define POSE_KEEPALIVE_NS (100 * U_TIME_1MS_IN_NS)
+
+//! Used until the HMD tells us its display frequency.
+#define POSE_DEFAULT_PERIOD_NS (4 * U_TIME_1MS_IN_NS)
+
+//! A tracked device that has its pose sent to SteamVR by @ref PosePublisher.
+class PoseSource
+{
+public:
+	//! Pose of the device at @p at_ns, with the time offset relative to now.
+	virtual vr::DriverPose_t
+	GetPoseAt(timepoint_ns at_ns) = 0;
+};
+
+static bool
+vec3_changed(const double a[3], const double b[3])
+{
+	return a[0] != b[0] || a[1] != b[1] || a[2] != b[2];
+}
+
+//! SteamVR extrapolates with the velocities, so a pose with new velocities is a new pose.
+static bool
+pose_changed(const vr::DriverPose_t &a, const vr::DriverPose_t &b)
+{
+	return a.poseIsValid != b.poseIsValid || a.result != b.result ||
+	       a.deviceIsConnected != b.deviceIsConnected || a.qRotation.w != b.qRotation.w ||
+	       a.qRotation.x != b.qRotation.x || a.qRotation.y != b.qRotation.y || a.qRotation.z != b.qRotation.z ||
+	       vec3_changed(a.vecPosition, b.vecPosition) || vec3_changed(a.vecVelocity, b.vecVelocity) ||
+	       vec3_changed(a.vecAngularVelocity, b.vecAngularVelocity);
+}
+
+/*!
+ * One thread that sends the poses of all activated devices to SteamVR.
+ *
+ * All devices are sampled for the same point in time each tick, and a pose is
+ * only sent on if it changed since it was last sent. The thread is started
+ * when the first device is added and stopped when the last one is removed.
+ *
+ * Adding and removing is serialised by @p m_lifecycle_mutex, which is held
+ * while the thread is joined, so a new thread is never started on top of one
+ * that is still being stopped.
+ */
+class PosePublisher
+{
+public:
+	void
+	Add(vr::TrackedDeviceIndex_t index, PoseSource *source)
+	{
+		std::unique_lock<std::mutex> lifecycle_lock(m_lifecycle_mutex);
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_entries.push_back(Entry{index, source, {}, 0});
+
+		if (m_running) {
+			return;
+		}
+
+		// Remove already joins under the lifecycle lock, but never assign over a joinable thread.
+		if (m_thread.joinable()) {
+			lock.unlock();
+			m_thread.join();
+			lock.lock();
+		}
+
+		m_running = true;
+		m_thread = std::thread(&PosePublisher::ThreadFunction, this);
+	}
+
+	void
+	Remove(PoseSource *source)
+	{
+		std::unique_lock<std::mutex> lifecycle_lock(m_lifecycle_mutex);
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+			if (it->source == source) {
+				m_entries.erase(it);
+				break;
+			}
+		}
+
+		if (!m_entries.empty() || !m_running) {
+			return;
+		}
+
+		m_running = false;
+		lock.unlock();
+
+		m_cond.notify_all();
+		m_thread.join();
+	}
+
+	//! Set how often poses are sent, from the display frequency of the HMD.
+	void
+	SetDisplayFrequency(float hz)
+	{
+		int64_t rate = debug_get_num_option_pose_rate();
+		double pose_hz = rate > 0 ? (double)rate : 2.0 * hz;
+		if (pose_hz <= 0.0) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_period_ns = (time_duration_ns)(U_TIME_1S_IN_NS / pose_hz);
+		ovrd_log("Sending poses every %.2fms\n", time_ns_to_ms_f(m_period_ns));
+	}
+
+private:
+	struct Entry
+	{
+		vr::TrackedDeviceIndex_t index;
+		PoseSource *source;
+		vr::DriverPose_t last;
+		timepoint_ns last_sent_ns;
+	};
+
+	void
+	ThreadFunction()
+	{
+		ovrd_log("Starting pose publishing thread\n");
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		timepoint_ns next_ns = os_monotonic_get_ns();
+
+		while (m_running) {
+			// Sleeping on the condition lets Remove wake us up right away.
+			auto timeout = std::chrono::nanoseconds(next_ns - os_monotonic_get_ns());
+			if (m_cond.wait_for(lock, timeout, [this] { return !m_running; })) {
+				break;
+			}
+
+			timepoint_ns now_ns = os_monotonic_get_ns();
+
+			for (Entry &e : m_entries) {
+				vr::DriverPose_t pose = e.source->GetPoseAt(now_ns);
+				if (!pose_changed(pose, e.last) && now_ns - e.last_sent_ns < POSE_KEEPALIVE_NS) {
+					continue;
+				}
+
+				vr::VRServerDriverHost()->TrackedDevicePoseUpdated(e.index, pose, sizeof(vr::DriverPose_t));
+				e.last = pose;
+				e.last_sent_ns = now_ns;
+			}
+
+			// Keep a steady cadence, but don't try to catch up after a stall.
+			next_ns += m_period_ns;
+			if (next_ns < now_ns) {
+				next_ns = now_ns + m_period_ns;
+			}
+		}
+
+		ovrd_log("Stopping pose publishing thread\n");
+	}
+
+	//! Held for all of @ref Add and @ref Remove, taken before @p m_mutex.
+	std::mutex m_lifecycle_mutex;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::thread m_thread;
+	bool m_running = false;
+
+	std::vector<Entry> m_entries;
+	time_duration_ns m_period_ns = POSE_DEFAULT_PERIOD_NS;
+};
+
+static PosePublisher g_posePublisher;
+
+
 /*
  * Controller
  */
@@ -363,7 +546,7 @@ hand_joint_set_to_bone_transform(struct xrt_hand_joint_set hand_joint_set,
 	flexion_joints_to_bone_transform(&hand_joint_set, out_bone_transforms, hand);
 }
 
-class CDeviceDriver_Monado_Controller : public vr::ITrackedDeviceServerDriver
+class CDeviceDriver_Monado_Controller : public vr::ITrackedDeviceServerDriver, public PoseSource
 {
 public:
 	CDeviceDriver_Monado_Controller(struct xrt_instance *xinst, struct xrt_device *xdev, enum xrt_hand hand)
@@ -706,24 +889,6 @@ public:
 		}
 	}
 
-	void
-	PoseUpdateThreadFunction()
-	{
-		ovrd_log("Starting controller pose update thread for %s\n", m_xdev->str);
-
-		while (m_poseUpdating) {
-			//! @todo figure out the best pose update rate
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-			if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
-				vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(),
-				                                                   sizeof(vr::DriverPose_t));
-			}
-		}
-
-		ovrd_log("Stopping controller pose update thread for %s\n", m_xdev->str);
-	}
-
 	vr::EVRInitError
 	Activate(vr::TrackedDeviceIndex_t unObjectId)
 	{
@@ -801,11 +966,7 @@ public:
 
 		ovrd_log("Controller %d activated\n", m_unObjectId);
 
-		m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado_Controller::PoseUpdateThreadFunction, this);
-		if (!m_poseUpdateThread) {
-			ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-			return vr::VRInitError_Driver_Failed;
-		}
+		g_posePublisher.Add(m_unObjectId, this);
 
 		return vr::VRInitError_None;
 	}
@@ -814,8 +975,7 @@ public:
 	Deactivate()
 	{
 		ovrd_log("deactivate controller\n");
-		m_poseUpdating = false;
-		m_poseUpdateThread->join();
+		g_posePublisher.Remove(this);
 		m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
 	}
 
@@ -845,8 +1005,14 @@ public:
 	vr::DriverPose_t
 	GetPose()
 	{
-		// monado predicts pose "now", see xrt_device_get_tracked_pose
-		m_pose.poseTimeOffset = 0;
+		return GetPoseAt(os_monotonic_get_ns());
+	}
+
+	vr::DriverPose_t
+	GetPoseAt(timepoint_ns at_ns)
+	{
+		// monado predicts the pose to at_ns, see xrt_device_get_tracked_pose
+		m_pose.poseTimeOffset = time_ns_to_s(at_ns - os_monotonic_get_ns());
 
 		m_pose.poseIsValid = true;
 		m_pose.result = vr::TrackingResult_Running_OK;
@@ -874,10 +1040,8 @@ public:
 			grip_name = XRT_INPUT_GENERIC_HEAD_POSE; // ???
 		}
 
-		timepoint_ns now_ns = os_monotonic_get_ns();
-
 		struct xrt_space_relation rel;
-		xrt_device_get_tracked_pose(m_xdev, grip_name, now_ns, &rel);
+		xrt_device_get_tracked_pose(m_xdev, grip_name, at_ns, &rel);
 
 		struct xrt_pose *offset = &m_xdev->tracking_origin->offset;
 
@@ -1041,9 +1205,6 @@ private:
 	bool m_handed_controller;
 
 	std::string m_input_profile;
-
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
 };
 
 /*
@@ -1052,7 +1213,7 @@ private:
  *
  */
 
-class CDeviceDriver_Monado : public vr::ITrackedDeviceServerDriver, public vr::IVRDisplayComponent
+class CDeviceDriver_Monado : public vr::ITrackedDeviceServerDriver, public vr::IVRDisplayComponent, public PoseSource
 {
 public:
 	CDeviceDriver_Monado(struct xrt_instance *xinst, struct xrt_device *xdev) : m_xdev(xdev)
@@ -1101,6 +1262,9 @@ public:
 	virtual void DebugRequest(const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize);
 	virtual vr::DriverPose_t GetPose();
 
+	// PoseSource
+	virtual vr::DriverPose_t GetPoseAt(timepoint_ns at_ns);
+
 	// IVRDisplayComponent
 	virtual void GetWindowBounds(int32_t *pnX, int32_t *pnY, uint32_t *pnWidth, uint32_t *pnHeight);
 	virtual bool IsDisplayOnDesktop();
@@ -1127,10 +1291,6 @@ private:
 	struct xrt_fov m_fovs[2];
 	struct xrt_pose m_view_pose[2];
 
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
-	virtual void PoseUpdateThreadFunction();
-
 	// clang-format on
 };
 
@@ -1153,20 +1313,6 @@ create_translation_rotation_matrix(struct xrt_pose *pose, struct vr::HmdMatrix34
 	res->m[2][3] = t.z;
 }
 
-void
-CDeviceDriver_Monado::PoseUpdateThreadFunction()
-{
-	ovrd_log("Starting HMD pose update thread\n");
-
-	while (m_poseUpdating) {
-		//! @todo figure out the best pose update rate
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDeviceIndex, GetPose(),
-		                                                   sizeof(vr::DriverPose_t));
-	}
-	ovrd_log("Stopping HMD pose update thread\n");
-}
-
 vr::EVRInitError
 CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 {
@@ -1206,11 +1352,8 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 	vr::VRServerDriverHost()->SetDisplayEyeToHead(m_trackedDeviceIndex, left, right);
 
 
-	m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado::PoseUpdateThreadFunction, this);
-	if (!m_poseUpdateThread) {
-		ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-		return vr::VRInitError_Driver_Failed;
-	}
+	g_posePublisher.SetDisplayFrequency(m_flDisplayFrequency);
+	g_posePublisher.Add(m_trackedDeviceIndex, this);
 
 	return vr::VRInitError_None;
 }
@@ -1218,8 +1361,7 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 void
 CDeviceDriver_Monado::Deactivate()
 {
-	m_poseUpdating = false;
-	m_poseUpdateThread->join();
+	g_posePublisher.Remove(this);
 	ovrd_log("Deactivate\n");
 }
 
@@ -1261,10 +1403,14 @@ HmdQuaternion_Init(double w, double x, double y, double z)
 vr::DriverPose_t
 CDeviceDriver_Monado::GetPose()
 {
+	return GetPoseAt(os_monotonic_get_ns());
+}
 
-	timepoint_ns now_ns = os_monotonic_get_ns();
+vr::DriverPose_t
+CDeviceDriver_Monado::GetPoseAt(timepoint_ns at_ns)
+{
 	struct xrt_space_relation rel;
-	xrt_device_get_tracked_pose(m_xdev, XRT_INPUT_GENERIC_HEAD_POSE, now_ns, &rel);
+	xrt_device_get_tracked_pose(m_xdev, XRT_INPUT_GENERIC_HEAD_POSE, at_ns, &rel);
 
 	struct xrt_pose *offset = &m_xdev->tracking_origin->offset;
 
@@ -1276,8 +1422,8 @@ CDeviceDriver_Monado::GetPose()
 	vr::DriverPose_t t = {};
 
 
-	// monado predicts pose "now", see xrt_device_get_tracked_pose
-	t.poseTimeOffset = 0;
+	// monado predicts the pose to at_ns, see xrt_device_get_tracked_pose
+	t.poseTimeOffset = time_ns_to_s(at_ns - os_monotonic_get_ns());
 
 	//! @todo: Monado head model?
 	t.shouldApplyHeadModel = !m_xdev->position_tracking_supported;
@@ -0,0 +1,382 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Replays a stereo dataset through Mercury hand tracking and reports timings.
+ */
+
+#include "xrt/xrt_config_build.h"
+#include "xrt/xrt_config_drivers.h"
+
+#include "cli_common.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(XRT_BUILD_DRIVER_HANDTRACKING) && defined(XRT_BUILD_DRIVER_EUROC)
+
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_frameserver.h"
+#include "xrt/xrt_tracking.h"
+#include "os/os_time.h"
+#include "util/u_file.h"
+#include "util/u_logging.h"
+#include "util/u_misc.h"
+#include "tracking/t_tracking.h"
+#include "tracking/t_hand_tracking.h"
+#include "euroc/euroc_interface.h"
+#include "hg_interface.h"
+
+#endif
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+#if defined(XRT_BUILD_DRIVER_HANDTRACKING) && defined(XRT_BUILD_DRIVER_EUROC)
+
+enum stage
+{
+	STAGE_DETECTION,
+	STAGE_KEYPOINT,
+	STAGE_OPTIMIZER,
+	STAGE_TOTAL,
+	STAGE_COUNT,
+};
+
+static const char *stage_names[STAGE_COUNT] = {"detection", "keypoint", "optimizer", "total"};
+
+struct replay
+{
+	//! Sinks given to the player, frames of a pair arrive left then right on the same thread.
+	struct xrt_frame_sink left_sink;
+	struct xrt_frame_sink right_sink;
+
+	struct t_hand_tracking_sync *sync;
+
+	//! Left frame waiting for its right frame.
+	struct xrt_frame *left;
+
+	FILE *joints_file;
+	FILE *timing_file;
+
+	//! Durations of every processed frame, detection only for frames it ran on.
+	uint64_t *durations[STAGE_COUNT];
+	uint32_t counts[STAGE_COUNT];
+	uint32_t capacity;
+
+	uint32_t frame_count;
+	uint32_t unpaired_count;
+	uint64_t keypoint_count;
+
+	timepoint_ns first_ns;
+	timepoint_ns last_ns;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+push_duration(struct replay *r, enum stage stage, uint64_t duration_ns)
+{
+	if (r->counts[stage] == r->capacity) {
+		r->capacity = r->capacity == 0 ? 1024 : r->capacity * 2;
+		for (int i = 0; i < STAGE_COUNT; i++) {
+			U_ARRAY_REALLOC_OR_FREE(r->durations[i], uint64_t, r->capacity);
+		}
+	}
+
+	r->durations[stage][r->counts[stage]++] = duration_ns;
+}
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void
+write_joints(struct replay *r, uint64_t timestamp_ns, struct xrt_hand_joint_set hands[2])
+{
+	for (int h = 0; h < 2; h++) {
+		fprintf(r->joints_file, "%" PRIu64 ",%d,%d", timestamp_ns, h, hands[h].is_active);
+
+		for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+			struct xrt_vec3 p = hands[h].values.hand_joint_set_default[j].relation.pose.position;
+			fprintf(r->joints_file, ",%f,%f,%f", p.x, p.y, p.z);
+		}
+
+		fprintf(r->joints_file, "\n");
+	}
+}
+
+static void
+process_pair(struct replay *r, struct xrt_frame *left, struct xrt_frame *right)
+{
+	struct xrt_hand_joint_set hands[2] = {0};
+	uint64_t timestamp_ns = 0;
+
+	if (r->frame_count == 0) {
+		r->first_ns = os_monotonic_get_ns();
+	}
+
+	t_ht_sync_process(r->sync, left, right, &hands[0], &hands[1], &timestamp_ns);
+
+	r->last_ns = os_monotonic_get_ns();
+	r->frame_count++;
+
+	struct hg_frame_timing timing;
+	t_hand_tracking_sync_mercury_get_frame_timing(r->sync, &timing);
+
+	if (timing.detection_ns != 0) {
+		push_duration(r, STAGE_DETECTION, timing.detection_ns);
+	}
+	push_duration(r, STAGE_KEYPOINT, timing.keypoint_ns);
+	push_duration(r, STAGE_OPTIMIZER, timing.optimizer_ns);
+	push_duration(r, STAGE_TOTAL, timing.total_ns);
+	r->keypoint_count += timing.keypoint_count;
+
+	if (r->timing_file != NULL) {
+		fprintf(r->timing_file, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%u\n",
+		        timing.frame_timestamp_ns, timing.detection_ns, timing.keypoint_ns, timing.optimizer_ns,
+		        timing.total_ns, timing.keypoint_count);
+	}
+
+	if (r->joints_file != NULL) {
+		write_joints(r, timestamp_ns, hands);
+	}
+}
+
+static void
+print_summary(struct replay *r)
+{
+	double seconds = time_ns_to_s(r->last_ns - r->first_ns);
+
+	P("Frames: %u, unpaired: %u, keypoint runs per frame: %.2f\n", r->frame_count, r->unpaired_count,
+	  r->frame_count > 0 ? (double)r->keypoint_count / r->frame_count : 0.0);
+	P("Throughput: %.2f frames/s\n", seconds > 0 ? (r->frame_count - 1) / seconds : 0.0);
+	P("%-10s %8s %9s %9s %9s %9s\n", "stage", "count", "mean ms", "p50 ms", "p95 ms", "max ms");
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		uint32_t n = r->counts[i];
+		if (n == 0) {
+			P("%-10s %8u\n", stage_names[i], n);
+			continue;
+		}
+
+		uint64_t *d = r->durations[i];
+		qsort(d, n, sizeof(*d), compare_u64);
+
+		double sum_ms = 0;
+		for (uint32_t k = 0; k < n; k++) {
+			sum_ms += time_ns_to_ms_f(d[k]);
+		}
+
+		P("%-10s %8u %9.3f %9.3f %9.3f %9.3f\n", stage_names[i], n, sum_ms / n, time_ns_to_ms_f(d[n / 2]),
+		  time_ns_to_ms_f(d[n * 95 / 100]), time_ns_to_ms_f(d[n - 1]));
+	}
+}
+
+
+/*
+ *
+ * Sinks.
+ *
+ */
+
+static void
+receive_left(struct xrt_frame_sink *sink, struct xrt_frame *xf)
+{
+	struct replay *r = container_of(sink, struct replay, left_sink);
+
+	if (r->left != NULL) {
+		r->unpaired_count++;
+	}
+	xrt_frame_reference(&r->left, xf);
+}
+
+static void
+receive_right(struct xrt_frame_sink *sink, struct xrt_frame *xf)
+{
+	struct replay *r = container_of(sink, struct replay, right_sink);
+
+	if (r->left == NULL || r->left->timestamp != xf->timestamp) {
+		r->unpaired_count++;
+		xrt_frame_reference(&r->left, NULL);
+		return;
+	}
+
+	// Runs on the player thread, so the player waits for every frame: lockstep.
+	process_pair(r, r->left, xf);
+
+	xrt_frame_reference(&r->left, NULL);
+}
+
+
+/*
+ *
+ * Main.
+ *
+ */
+
+static int
+print_usage(const char *argv0, const char *argv1)
+{
+	P("Replays a EuRoC stereo dataset through Mercury hand tracking, as fast as it can.\n");
+	P("Usage: %s %s <euroc_path> <calibration.json> [-m <models_dir>] [-j <joints.csv>] [-t <timing.csv>]\n", argv0,
+	  argv1);
+	P("  -m  Hand tracking models, found like the driver does if not given.\n");
+	P("  -j  Write the joint positions of both hands for every frame.\n");
+	P("  -t  Write the stage timings of every frame.\n");
+	return 1;
+}
+
+#endif
+
+int
+cli_cmd_handbench(int argc, const char **argv)
+{
+#if !defined(XRT_BUILD_DRIVER_HANDTRACKING)
+	P("Hand tracking not built.\n");
+	return 1;
+#elif !defined(XRT_BUILD_DRIVER_EUROC)
+	P("Euroc driver not built, can't replay datasets.\n");
+	return 1;
+#else
+	if (argc < 4) {
+		return print_usage(argv[0], argv[1]);
+	}
+
+	const char *euroc_path = argv[2];
+	const char *calib_path = argv[3];
+	const char *models_path = NULL;
+	const char *joints_path = NULL;
+	const char *timing_path = NULL;
+
+	for (int i = 4; i < argc; i += 2) {
+		if (i + 1 >= argc) {
+			return print_usage(argv[0], argv[1]);
+		}
+
+		if (strcmp(argv[i], "-m") == 0) {
+			models_path = argv[i + 1];
+		} else if (strcmp(argv[i], "-j") == 0) {
+			joints_path = argv[i + 1];
+		} else if (strcmp(argv[i], "-t") == 0) {
+			timing_path = argv[i + 1];
+		} else {
+			return print_usage(argv[0], argv[1]);
+		}
+	}
+
+	char models_dir[1024] = {0};
+	if (models_path != NULL) {
+		snprintf(models_dir, sizeof(models_dir), "%s", models_path);
+	} else if (u_file_get_hand_tracking_models_dir(models_dir, sizeof(models_dir)) < 0) {
+		P("Could not find any directory with hand-tracking models, pass one with -m.\n");
+		return 1;
+	}
+
+	struct t_stereo_camera_calibration *calib = NULL;
+	if (!t_stereo_camera_calibration_load(calib_path, &calib)) {
+		P("Could not load calibration '%s'.\n", calib_path);
+		return 1;
+	}
+
+	struct replay r = {0};
+	int ret = 1;
+
+	if (joints_path != NULL) {
+		r.joints_file = fopen(joints_path, "w");
+		if (r.joints_file == NULL) {
+			P("Could not open '%s' for writing.\n", joints_path);
+			goto out;
+		}
+
+		fprintf(r.joints_file, "#timestamp [ns],hand,active");
+		for (int j = 0; j < XRT_HAND_JOINT_COUNT; j++) {
+			fprintf(r.joints_file, ",j%d_x [m],j%d_y [m],j%d_z [m]", j, j, j);
+		}
+		fprintf(r.joints_file, "\n");
+	}
+
+	if (timing_path != NULL) {
+		r.timing_file = fopen(timing_path, "w");
+		if (r.timing_file == NULL) {
+			P("Could not open '%s' for writing.\n", timing_path);
+			goto out;
+		}
+
+		fprintf(r.timing_file,
+		        "#timestamp [ns],detection [ns],keypoint [ns],optimizer [ns],total [ns],keypoint count\n");
+	}
+
+	// No vignette or rotation information for datasets.
+	struct t_hand_tracking_create_info create_info = {0};
+	r.sync = t_hand_tracking_sync_mercury_create(calib, create_info, models_dir);
+	if (r.sync == NULL) {
+		P("Could not create Mercury hand tracking.\n");
+		goto out;
+	}
+
+	struct euroc_player_config ep_config;
+	euroc_player_fill_default_config_for(&ep_config, euroc_path);
+	ep_config.playback.cam_count = 2;
+	ep_config.playback.color = false; // Mercury takes L8 frames.
+	ep_config.playback.gt = false;
+	ep_config.playback.max_speed = true;
+	ep_config.playback.use_source_ts = true;
+	ep_config.playback.play_from_start = true;
+	ep_config.playback.print_progress = false;
+
+	if (ep_config.dataset.cam_count < 2) {
+		P("Dataset '%s' is not stereo.\n", euroc_path);
+		goto out;
+	}
+
+	r.left_sink.push_frame = receive_left;
+	r.right_sink.push_frame = receive_right;
+
+	struct xrt_slam_sinks sinks = {0};
+	sinks.cam_count = 2;
+	sinks.cams[0] = &r.left_sink;
+	sinks.cams[1] = &r.right_sink;
+
+	struct xrt_frame_context xfctx = {0};
+	struct xrt_fs *xfs = euroc_player_create(&xfctx, euroc_path, &ep_config);
+	xrt_fs_slam_stream_start(xfs, &sinks);
+
+	while (xrt_fs_is_running(xfs)) {
+		os_nanosleep(100 * U_TIME_1MS_IN_NS);
+	}
+
+	// Stops the player thread, no more frames after this.
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&r.left, NULL);
+
+	print_summary(&r);
+	ret = 0;
+
+out:
+	t_ht_sync_destroy(&r.sync);
+	t_stereo_camera_calibration_reference(&calib, NULL);
+
+	if (r.joints_file != NULL) {
+		fclose(r.joints_file);
+	}
+	if (r.timing_file != NULL) {
+		fclose(r.timing_file);
+	}
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		free(r.durations[i]);
+	}
+
+	return ret;
+#endif
+}
@@ -1,4 +1,4 @@
-// Copyright 2022, Collabora, Ltd.
+// Copyright 2022-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -7,28 +7,442 @@
  */
 
 #include "euroc/euroc_interface.h"
+#include "math/m_api.h"
 #include "os/os_threading.h"
+#include "os/os_time.h"
+#include "tracking/t_tracking.h"
+#include "util/u_json.h"
 #include "util/u_logging.h"
+#include "util/u_misc.h"
 #include "xrt/xrt_config_build.h"
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_drivers.h"
+#include "xrt/xrt_config_os.h"
 
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_OS_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #define P(...) fprintf(stderr, __VA_ARGS__)
 #define I(...) U_LOG(U_LOGGING_INFO, __VA_ARGS__)
 
 #if defined(XRT_FEATURE_SLAM) && defined(XRT_BUILD_DRIVER_EUROC)
 
-static bool should_exit = false;
+//! SLAM systems are multithreaded themselves, so default to a few cores per run.
+#define CORES_PER_JOB (4)
+
+struct dataset
+{
+	const char *euroc_path;
+	const char *slam_config;
+	const char *output_path;
+
+	bool success;
+	double duration_s;
+	struct t_slam_stats stats;
+
+#ifdef XRT_OS_UNIX
+	pid_t pid;
+	int fd;
+	timepoint_ns start_ns;
+#endif
+};
+
+struct batch
+{
+	struct dataset *datasets;
+	int count;
+	int capacity;
+
+	//! Lines of the manifest, the dataset paths point into this.
+	char *manifest;
+};
+
+//! Never set, runs are not interactive so that the tool can be scripted.
+static volatile bool should_exit = false;
+
+
+/*
+ *
+ * Arguments.
+ *
+ */
+
+static void
+add_dataset(struct batch *b, const char *euroc_path, const char *slam_config, const char *output_path)
+{
+	if (b->count == b->capacity) {
+		b->capacity = b->capacity == 0 ? 16 : b->capacity * 2;
+		U_ARRAY_REALLOC_OR_FREE(b->datasets, struct dataset, b->capacity);
+	}
+
+	struct dataset *d = &b->datasets[b->count++];
+	U_ZERO(d);
+	d->euroc_path = euroc_path;
+	d->slam_config = slam_config;
+	d->output_path = output_path;
+}
+
+/*!
+ * Each non empty line that doesn't start with '#' is a dataset, as three
+ * whitespace separated paths: `<euroc_path> <slam_config> <output_path>`.
+ */
+static bool
+read_manifest(struct batch *b, const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		P("Could not open manifest '%s'.\n", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	b->manifest = U_TYPED_ARRAY_CALLOC(char, size + 1);
+	size_t read = fread(b->manifest, 1, size, file);
+	fclose(file);
+	b->manifest[read] = '\0';
+
+	int line_number = 0;
+	char *save_line = NULL;
+	for (char *line = strtok_r(b->manifest, "\n", &save_line); line != NULL;
+	     line = strtok_r(NULL, "\n", &save_line)) {
+		line_number++;
+
+		char *save_word = NULL;
+		char *words[3] = {0};
+		int word_count = 0;
+		for (char *w = strtok_r(line, " \t\r", &save_word); w != NULL; w = strtok_r(NULL, " \t\r", &save_word)) {
+			if (word_count == 0 && w[0] == '#') {
+				break;
+			}
+			if (word_count == 3) {
+				word_count++;
+				break;
+			}
+			words[word_count++] = w;
+		}
+
+		if (word_count == 0) {
+			continue;
+		}
+		if (word_count != 3) {
+			P("%s:%d: Expected '<euroc_path> <slam_config> <output_path>'.\n", path, line_number);
+			return false;
+		}
+
+		add_dataset(b, words[0], words[1], words[2]);
+	}
+
+	return true;
+}
+
+static void
+print_usage(const char *argv0, const char *argv1)
+{
+	P("Batch evaluator of SLAM datasets.\n");
+	P("Usage: %s %s [-j <jobs>] [-o <results.json>] [-m <manifest>] [<euroc_path> <slam_config> <output_path>]...\n",
+	  argv0, argv1);
+	P("  -j  Datasets to run at the same time, at most the number of cores.\n");
+	P("  -o  Where to write the results as JSON, defaults to stdout.\n");
+	P("  -m  File with one '<euroc_path> <slam_config> <output_path>' per line.\n");
+}
+
+
+/*
+ *
+ * Running.
+ *
+ */
+
+static void
+log_dataset(int index, int count, const struct dataset *d)
+{
+	I("Running dataset %d out of %d", index + 1, count);
+	I("Dataset path: %s", d->euroc_path);
+	I("SLAM config path: %s", d->slam_config);
+	I("Output path: %s", d->output_path);
+}
+
+#ifdef XRT_OS_UNIX
+
+//! Each dataset runs in its own process, the stats are sent back over a pipe.
+static bool
+start_dataset(struct dataset *d)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		close(fds[0]);
+
+		struct t_slam_stats stats;
+		euroc_run_dataset(d->euroc_path, d->slam_config, d->output_path, &should_exit, &stats);
+
+		// Smaller than the pipe buffer, doesn't block.
+		bool written = write(fds[1], &stats, sizeof(stats)) == (ssize_t)sizeof(stats);
+		close(fds[1]);
+		_exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close(fds[1]);
+	d->pid = pid;
+	d->fd = fds[0];
+	d->start_ns = os_monotonic_get_ns();
+
+	return true;
+}
+
+static void
+finish_dataset(struct dataset *d, int status)
+{
+	d->duration_s = time_ns_to_s(os_monotonic_get_ns() - d->start_ns);
+
+	ssize_t ret = read(d->fd, &d->stats, sizeof(d->stats));
+	close(d->fd);
+
+	d->success = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS && ret == (ssize_t)sizeof(d->stats);
+	if (!d->success) {
+		U_ZERO(&d->stats);
+		U_LOG_E("Dataset '%s' failed", d->euroc_path);
+	}
+}
+
+static void
+run_datasets(struct batch *b, int jobs)
+{
+	// Progress of several runs printing at once is unreadable.
+	if (jobs > 1) {
+		setenv("EUROC_PRINT_PROGRESS", "false", 0);
+	}
+
+	int next = 0;
+	int running = 0;
+	int done = 0;
+
+	while (done < b->count) {
+		while (running < jobs && next < b->count) {
+			struct dataset *d = &b->datasets[next];
+			log_dataset(next++, b->count, d);
+
+			if (start_dataset(d)) {
+				running++;
+			} else {
+				U_LOG_E("Could not start a process for '%s'", d->euroc_path);
+				done++;
+			}
+		}
+
+		if (running == 0) {
+			continue;
+		}
+
+		int status = 0;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			U_LOG_E("waitpid failed: %s", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < next; i++) {
+			if (b->datasets[i].pid == pid) {
+				finish_dataset(&b->datasets[i], status);
+				running--;
+				done++;
+				break;
+			}
+		}
+	}
+}
+
+#else
+
+static void
+run_datasets(struct batch *b, int jobs)
+{
+	// No fork, the datasets run one after another in this process.
+	(void)jobs;
+
+	for (int i = 0; i < b->count; i++) {
+		struct dataset *d = &b->datasets[i];
+		log_dataset(i, b->count, d);
+
+		timepoint_ns start_ns = os_monotonic_get_ns();
+		euroc_run_dataset(d->euroc_path, d->slam_config, d->output_path, &should_exit, &d->stats);
+		d->duration_s = time_ns_to_s(os_monotonic_get_ns() - start_ns);
+		d->success = true;
+	}
+}
+
+#endif
+
+
+/*
+ *
+ * Results.
+ *
+ */
+
+static cJSON *
+stage_to_json(const struct t_slam_stats_stage *s)
+{
+	cJSON *j = cJSON_CreateObject();
+	cJSON_AddStringToObject(j, "name", s->name);
+	cJSON_AddNumberToObject(j, "count", s->count);
+	cJSON_AddNumberToObject(j, "mean_ms", s->mean_ms);
+	cJSON_AddNumberToObject(j, "p50_ms", s->p50_ms);
+	cJSON_AddNumberToObject(j, "p95_ms", s->p95_ms);
+	cJSON_AddNumberToObject(j, "max_ms", s->max_ms);
+	return j;
+}
+
+static cJSON *
+dataset_to_json(const struct dataset *d)
+{
+	const struct t_slam_stats *s = &d->stats;
+
+	cJSON *j = cJSON_CreateObject();
+	cJSON_AddStringToObject(j, "euroc_path", d->euroc_path);
+	cJSON_AddStringToObject(j, "slam_config", d->slam_config);
+	cJSON_AddStringToObject(j, "output_path", d->output_path);
+	cJSON_AddBoolToObject(j, "success", d->success);
+	cJSON_AddNumberToObject(j, "duration_s", d->duration_s);
+	cJSON_AddNumberToObject(j, "pose_count", s->pose_count);
+
+	cJSON *ate = cJSON_AddObjectToObject(j, "ate");
+	cJSON_AddNumberToObject(ate, "count", s->ate_count);
+	cJSON_AddNumberToObject(ate, "rmse_m", s->ate_rmse_m);
+	cJSON_AddNumberToObject(ate, "mean_m", s->ate_mean_m);
+	cJSON_AddNumberToObject(ate, "max_m", s->ate_max_m);
+
+	cJSON *rpe = cJSON_AddObjectToObject(j, "rpe");
+	cJSON_AddNumberToObject(rpe, "delta_s", time_ns_to_s(T_SLAM_STATS_RPE_DELTA_NS));
+	cJSON_AddNumberToObject(rpe, "count", s->rpe_count);
+	cJSON_AddNumberToObject(rpe, "rmse_m", s->rpe_rmse_m);
+	cJSON_AddNumberToObject(rpe, "mean_m", s->rpe_mean_m);
+
+	cJSON *timing = cJSON_AddObjectToObject(j, "timing");
+	cJSON_AddItemToObject(timing, "total", stage_to_json(&s->total));
+	cJSON *stages = cJSON_AddArrayToObject(timing, "stages");
+	for (uint32_t i = 0; i < s->stage_count; i++) {
+		cJSON_AddItemToArray(stages, stage_to_json(&s->stages[i]));
+	}
+
+	return j;
+}
+
+//! Averages over the datasets that have the metric, so regressions show up in one number.
+static cJSON *
+summary_to_json(const struct batch *b, double duration_s, int jobs)
+{
+	int succeeded = 0;
+	int ate_count = 0;
+	int rpe_count = 0;
+	int timing_count = 0;
+	double ate_rmse_sum = 0;
+	double ate_rmse_max = 0;
+	double rpe_rmse_sum = 0;
+	double total_p50_sum = 0;
+	double total_p95_max = 0;
+
+	for (int i = 0; i < b->count; i++) {
+		const struct dataset *d = &b->datasets[i];
+		const struct t_slam_stats *s = &d->stats;
+		if (!d->success) {
+			continue;
+		}
+		succeeded++;
+
+		if (s->ate_count > 0) {
+			ate_count++;
+			ate_rmse_sum += s->ate_rmse_m;
+			ate_rmse_max = MAX(ate_rmse_max, s->ate_rmse_m);
+		}
+		if (s->rpe_count > 0) {
+			rpe_count++;
+			rpe_rmse_sum += s->rpe_rmse_m;
+		}
+		if (s->total.count > 0) {
+			timing_count++;
+			total_p50_sum += s->total.p50_ms;
+			total_p95_max = MAX(total_p95_max, s->total.p95_ms);
+		}
+	}
+
+	cJSON *j = cJSON_CreateObject();
+	cJSON_AddNumberToObject(j, "jobs", jobs);
+	cJSON_AddNumberToObject(j, "duration_s", duration_s);
+	cJSON_AddNumberToObject(j, "succeeded", succeeded);
+	cJSON_AddNumberToObject(j, "failed", b->count - succeeded);
+	cJSON_AddNumberToObject(j, "ate_rmse_m_mean", ate_count > 0 ? ate_rmse_sum / ate_count : 0);
+	cJSON_AddNumberToObject(j, "ate_rmse_m_max", ate_rmse_max);
+	cJSON_AddNumberToObject(j, "rpe_rmse_m_mean", rpe_count > 0 ? rpe_rmse_sum / rpe_count : 0);
+	cJSON_AddNumberToObject(j, "total_p50_ms_mean", timing_count > 0 ? total_p50_sum / timing_count : 0);
+	cJSON_AddNumberToObject(j, "total_p95_ms_max", total_p95_max);
+	return j;
+}
+
+static bool
+write_results(const struct batch *b, double duration_s, int jobs, const char *path)
+{
+	cJSON *root = cJSON_CreateObject();
+	cJSON_AddItemToObject(root, "summary", summary_to_json(b, duration_s, jobs));
+	cJSON *datasets = cJSON_AddArrayToObject(root, "datasets");
+	for (int i = 0; i < b->count; i++) {
+		cJSON_AddItemToArray(datasets, dataset_to_json(&b->datasets[i]));
+	}
+
+	char *str = cJSON_Print(root);
+	cJSON_Delete(root);
+
+	FILE *file = path != NULL ? fopen(path, "w") : stdout;
+	if (file == NULL) {
+		P("Could not open '%s' for writing.\n", path);
+		free(str);
+		return false;
+	}
+
+	fprintf(file, "%s\n", str);
+	free(str);
 
-static void *
-wait_for_exit_key(void *ptr)
+	if (file != stdout) {
+		fclose(file);
+	}
+
+	return true;
+}
+
+static int
+get_core_count(void)
 {
-	getchar();
-	should_exit = true;
-	return NULL;
+#ifdef XRT_OS_UNIX
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+#else
+	return 1;
+#endif
 }
+
 #endif
 
 int
@@ -42,43 +456,70 @@ cli_cmd_slambatch(int argc, const char **argv)
 	P("Euroc driver not built, can't reproduce datasets.\n");
 	return EXIT_FAILURE;
 #else
+	struct batch b = {0};
+	const char *json_path = NULL;
+	int cores = get_core_count();
+	int jobs = MAX(1, cores / CORES_PER_JOB);
+	int ret = EXIT_FAILURE;
+
 	// Do not count "monado-cli" and "slambatch" as args
-	int nof_args = argc - 2;
-	const char **args = &argv[2];
+	int i = 2;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (i + 1 >= argc) {
+			print_usage(argv[0], argv[1]);
+			goto out;
+		}
 
-	if (nof_args == 0 || nof_args % 3 != 0) {
-		P("Batch evaluator of SLAM datasets.\n");
-		P("Usage: %s %s [<euroc_path> <slam_config> <output_path>]...\n", argv[0], argv[1]);
-		return EXIT_FAILURE;
+		if (strcmp(argv[i], "-j") == 0) {
+			jobs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-o") == 0) {
+			json_path = argv[++i];
+		} else if (strcmp(argv[i], "-m") == 0) {
+			if (!read_manifest(&b, argv[++i])) {
+				goto out;
+			}
+		} else {
+			print_usage(argv[0], argv[1]);
+			goto out;
+		}
 	}
 
-	// Allow pressing enter to quit the program by launching a new thread
-	struct os_thread_helper wfk_thread;
-	os_thread_helper_init(&wfk_thread);
-	os_thread_helper_start(&wfk_thread, wait_for_exit_key, NULL);
+	int nof_args = argc - i;
+	if (nof_args % 3 != 0 || jobs < 1) {
+		print_usage(argv[0], argv[1]);
+		goto out;
+	}
+	for (; i < argc; i += 3) {
+		add_dataset(&b, argv[i], argv[i + 1], argv[i + 2]);
+	}
+	if (b.count == 0) {
+		print_usage(argv[0], argv[1]);
+		goto out;
+	}
 
-	timepoint_ns start_time = os_monotonic_get_ns();
-	int nof_datasets = nof_args / 3;
-	for (int i = 0; i < nof_datasets && !should_exit; i++) {
-		const char *dataset_path = args[i * 3];
-		const char *slam_config = args[i * 3 + 1];
-		const char *output_path = args[i * 3 + 2];
+	jobs = MIN(MIN(jobs, cores), b.count);
 
-		I("Running dataset %d out of %d", i + 1, nof_datasets);
-		I("Dataset path: %s", dataset_path);
-		I("SLAM config path: %s", slam_config);
-		I("Output path: %s", output_path);
+	timepoint_ns start_time = os_monotonic_get_ns();
+	run_datasets(&b, jobs);
+	timepoint_ns end_time = os_monotonic_get_ns();
 
-		euroc_run_dataset(dataset_path, slam_config, output_path, &should_exit);
+	double duration_s = (double)(end_time - start_time) / U_TIME_1S_IN_NS;
+	if (!write_results(&b, duration_s, jobs, json_path)) {
+		goto out;
 	}
-	timepoint_ns end_time = os_monotonic_get_ns();
 
-	pthread_cancel(wfk_thread.thread);
+	P("Done in %.2fs.\n", duration_s);
 
-	// Destroy also stops the thread.
-	os_thread_helper_destroy(&wfk_thread);
+	ret = EXIT_SUCCESS;
+	for (int k = 0; k < b.count; k++) {
+		if (!b.datasets[k].success) {
+			ret = EXIT_FAILURE;
+		}
+	}
 
-	printf("Done in %.2fs.\n", (double)(end_time - start_time) / U_TIME_1S_IN_NS);
+out:
+	free(b.datasets);
+	free(b.manifest);
+	return ret;
 #endif
-	return EXIT_SUCCESS;
 }
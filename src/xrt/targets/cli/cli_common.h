@@ -32,6 +32,9 @@ cli_cmd_probe(int argc, const char **argv);
 int
 cli_cmd_slambatch(int argc, const char **argv);
 
+int
+cli_cmd_handbench(int argc, const char **argv);
+
 int
 cli_cmd_test(int argc, const char **argv);
 
@@ -34,6 +34,7 @@ cli_print_help(int argc, const char **argv)
 	P("  calibrate  - Calibrate a camera and save config (not implemented yet).\n");
 	P("  calib-dumb - Load and dump a calibration to stdout.\n");
 	P("  slambatch  - Runs a sequence of EuRoC datasets with the SLAM tracker.\n");
+	P("  handbench  - Replays a EuRoC dataset through hand tracking and reports timings.\n");
 
 	return 1;
 }
@@ -68,5 +69,8 @@ main(int argc, const char **argv)
 	if (strcmp(argv[1], "slambatch") == 0) {
 		return cli_cmd_slambatch(argc, argv);
 	}
+	if (strcmp(argv[1], "handbench") == 0) {
+		return cli_cmd_handbench(argc, argv);
+	}
 	return cli_print_help(argc, argv);
 }
@@ -0,0 +1,706 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Runs the main compositor headless with synthetic clients and
+ *         measures how long it takes to composite their layers.
+ * @ingroup comp_main
+ */
+
+#include "xrt/xrt_instance.h"
+#include "xrt/xrt_system.h"
+#include "xrt/xrt_session.h"
+#include "xrt/xrt_compositor.h"
+#include "xrt/xrt_space.h"
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+
+#include "main/comp_window_offscreen.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+#define MAX_CLIENTS (8)
+#define MAX_LAYERS (8)
+
+//! Swapchains of a layer, projection layers use two, projection with depth four.
+#define MAX_LAYER_SWAPCHAINS (4)
+
+#define PROJECTION_SIZE (1024)
+#define LAYER_SIZE (512)
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+enum bench_stat
+{
+	BENCH_STAT_DRAW,
+	BENCH_STAT_SUBMIT,
+	BENCH_STAT_GPU,
+	BENCH_STAT_LAYER_SQUASH,
+	BENCH_STAT_DISTORTION,
+	BENCH_STAT_LATENCY,
+	BENCH_STAT_COUNT,
+};
+
+static const char *bench_stat_names[BENCH_STAT_COUNT] = {
+    "compositor cpu draw",
+    "compositor cpu submit",
+    "compositor gpu",
+    "gpu layer squash",
+    "gpu distortion",
+    "client wake to gpu done",
+};
+
+struct bench_samples
+{
+	uint64_t *values;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+struct bench_layer
+{
+	enum xrt_layer_type type;
+	struct xrt_swapchain *xscs[MAX_LAYER_SWAPCHAINS];
+	uint32_t xsc_count;
+};
+
+struct bench;
+
+struct bench_client
+{
+	struct os_thread thread;
+
+	struct bench *b;
+	uint32_t index;
+
+	struct xrt_session *xs;
+	struct xrt_compositor_native *xcn;
+
+	struct bench_layer layers[MAX_LAYERS];
+	uint32_t layer_count;
+
+	//! Woke up from wait frame and committed the last frame, guarded by @ref bench::mutex.
+	uint64_t pending_wake_ns;
+	uint64_t pending_commit_ns;
+	bool pending;
+
+	bool failed;
+};
+
+struct bench
+{
+	struct xrt_instance *xinst;
+	struct xrt_system *xsys;
+	struct xrt_system_devices *xsysd;
+	struct xrt_space_overseer *xso;
+	struct xrt_system_compositor *xsysc;
+
+	struct bench_client clients[MAX_CLIENTS];
+	uint32_t client_count;
+
+	const char *layer_mix;
+	uint32_t frames;
+	uint32_t warmup;
+
+	//! Guards everything below, the frame function runs on the compositor thread.
+	struct os_mutex mutex;
+
+	bool measuring;
+
+	struct bench_samples stats[BENCH_STAT_COUNT];
+	uint64_t frame_count;
+	uint64_t missed_count;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t l = *(const uint64_t *)a;
+	uint64_t r = *(const uint64_t *)b;
+	return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+static double
+percentile_us(const uint64_t *sorted, uint32_t count, double p)
+{
+	if (count == 0) {
+		return 0.0;
+	}
+
+	uint32_t index = (uint32_t)(p * (double)(count - 1) + 0.5);
+	return (double)sorted[index] / 1000.0;
+}
+
+static void
+samples_add(struct bench_samples *s, uint64_t value)
+{
+	if (s->count < s->capacity) {
+		s->values[s->count++] = value;
+	}
+}
+
+static bool
+is_depth_format(int64_t format)
+{
+	switch (format) {
+	case 124 /* VK_FORMAT_D16_UNORM         */:
+	case 126 /* VK_FORMAT_D32_SFLOAT        */:
+	case 129 /* VK_FORMAT_D24_UNORM_S8_UINT */:
+	case 130 /* VK_FORMAT_D32_SFLOAT_S8_UINT */: return true;
+	default: return false;
+	}
+}
+
+static void
+on_frame(void *user, const struct comp_window_offscreen_frame *frame)
+{
+	struct bench *b = (struct bench *)user;
+
+	os_mutex_lock(&b->mutex);
+
+	if (!b->measuring) {
+		os_mutex_unlock(&b->mutex);
+		return;
+	}
+
+	samples_add(&b->stats[BENCH_STAT_DRAW], frame->submit_end_ns - frame->begin_ns);
+	samples_add(&b->stats[BENCH_STAT_SUBMIT], frame->submit_end_ns - frame->submit_begin_ns);
+	samples_add(&b->stats[BENCH_STAT_GPU], frame->gpu_end_ns - frame->gpu_start_ns);
+	samples_add(&b->stats[BENCH_STAT_LAYER_SQUASH], frame->layer_squash_ns);
+	samples_add(&b->stats[BENCH_STAT_DISTORTION], frame->distortion_ns);
+
+	b->frame_count++;
+	if (frame->gpu_end_ns > frame->desired_present_time_ns + frame->present_slop_ns) {
+		b->missed_count++;
+	}
+
+	// The first compositor frame to begin after a commit is the one that shows it.
+	for (uint32_t i = 0; i < b->client_count; i++) {
+		struct bench_client *bc = &b->clients[i];
+		if (!bc->pending || bc->pending_commit_ns > frame->begin_ns) {
+			continue;
+		}
+
+		samples_add(&b->stats[BENCH_STAT_LATENCY], frame->gpu_end_ns - bc->pending_wake_ns);
+		bc->pending = false;
+	}
+
+	os_mutex_unlock(&b->mutex);
+}
+
+static xrt_result_t
+create_swapchain(struct bench_client *bc,
+                 int64_t format,
+                 enum xrt_swapchain_usage_bits bits,
+                 uint32_t size,
+                 uint32_t array_size,
+                 struct xrt_swapchain **out_xsc)
+{
+	struct xrt_swapchain_create_info info = {
+	    .bits = bits | XRT_SWAPCHAIN_USAGE_SAMPLED,
+	    .format = (uint32_t)format,
+	    .sample_count = 1,
+	    .width = size,
+	    .height = size,
+	    .face_count = 1,
+	    .array_size = array_size,
+	    .mip_count = 1,
+	};
+
+	return xrt_comp_create_swapchain(&bc->xcn->base, &info, out_xsc);
+}
+
+static xrt_result_t
+create_layers(struct bench_client *bc, const char *mix)
+{
+	const struct xrt_compositor_info *info = &bc->xcn->base.info;
+	xrt_result_t xret = XRT_SUCCESS;
+
+	int64_t color_format = info->formats[0];
+	int64_t depth_format = 0;
+	for (uint32_t i = 0; i < info->format_count; i++) {
+		if (is_depth_format(info->formats[i])) {
+			depth_format = info->formats[i];
+			break;
+		}
+	}
+
+	for (const char *c = mix; *c != '\0'; c++) {
+		struct bench_layer *bl = &bc->layers[bc->layer_count];
+
+		switch (*c) {
+		case 'p':
+		case 'd':
+			bl->type = *c == 'p' ? XRT_LAYER_STEREO_PROJECTION : XRT_LAYER_STEREO_PROJECTION_DEPTH;
+			bl->xsc_count = 2;
+			for (uint32_t i = 0; i < 2 && xret == XRT_SUCCESS; i++) {
+				xret = create_swapchain(bc, color_format, XRT_SWAPCHAIN_USAGE_COLOR, PROJECTION_SIZE, 1,
+				                        &bl->xscs[i]);
+			}
+			if (*c == 'p') {
+				break;
+			}
+			if (depth_format == 0) {
+				PE("Client %u: No depth format!\n", bc->index);
+				return XRT_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+			}
+			bl->xsc_count = 4;
+			for (uint32_t i = 2; i < 4 && xret == XRT_SUCCESS; i++) {
+				xret = create_swapchain(bc, depth_format, XRT_SWAPCHAIN_USAGE_DEPTH_STENCIL, PROJECTION_SIZE,
+				                        1, &bl->xscs[i]);
+			}
+			break;
+		case 'q': bl->type = XRT_LAYER_QUAD; break;
+		case 'c': bl->type = XRT_LAYER_CYLINDER; break;
+		case 'e': bl->type = XRT_LAYER_EQUIRECT2; break;
+		default: assert(false); break;
+		}
+
+		if (bl->xsc_count == 0) {
+			bl->xsc_count = 1;
+			xret = create_swapchain(bc, color_format, XRT_SWAPCHAIN_USAGE_COLOR, LAYER_SIZE, 1, &bl->xscs[0]);
+		}
+
+		if (xret != XRT_SUCCESS) {
+			PE("Client %u: xrt_comp_create_swapchain failed: %d\n", bc->index, xret);
+			return xret;
+		}
+
+		bc->layer_count++;
+	}
+
+	return XRT_SUCCESS;
+}
+
+static void
+destroy_layers(struct bench_client *bc)
+{
+	// Also the swapchains of a layer that failed half way.
+	for (uint32_t i = 0; i < MAX_LAYERS; i++) {
+		for (uint32_t k = 0; k < MAX_LAYER_SWAPCHAINS; k++) {
+			xrt_swapchain_reference(&bc->layers[i].xscs[k], NULL);
+		}
+	}
+	bc->layer_count = 0;
+}
+
+static void
+fill_sub_image(struct xrt_sub_image *sub, uint32_t index, uint32_t size)
+{
+	sub->image_index = index;
+	sub->array_index = 0;
+	sub->rect.extent.w = (int32_t)size;
+	sub->rect.extent.h = (int32_t)size;
+	sub->norm_rect.w = 1.0f;
+	sub->norm_rect.h = 1.0f;
+}
+
+static xrt_result_t
+submit_layer(struct bench_client *bc, struct xrt_device *head, struct bench_layer *bl, uint64_t display_time_ns)
+{
+	struct xrt_compositor *xc = &bc->xcn->base;
+	uint32_t indices[MAX_LAYER_SWAPCHAINS] = {0};
+	xrt_result_t xret;
+
+	// Nothing is drawn, the compositor does the same work for any content.
+	for (uint32_t i = 0; i < bl->xsc_count; i++) {
+		xret = xrt_swapchain_acquire_image(bl->xscs[i], &indices[i]);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+		xret = xrt_swapchain_wait_image(bl->xscs[i], U_TIME_1S_IN_NS, indices[i]);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+		xret = xrt_swapchain_release_image(bl->xscs[i], indices[i]);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+	}
+
+	struct xrt_layer_data data = {
+	    .type = bl->type,
+	    .name = XRT_INPUT_GENERIC_HEAD_POSE,
+	    .timestamp = display_time_ns,
+	    .color_scale = {1.0f, 1.0f, 1.0f, 1.0f},
+	};
+
+	struct xrt_fov fov = {.angle_left = -0.8f, .angle_right = 0.8f, .angle_up = 0.8f, .angle_down = -0.8f};
+	struct xrt_pose in_front = {XRT_QUAT_IDENTITY, {0.0f, 0.0f, -1.5f}};
+
+	switch (bl->type) {
+	case XRT_LAYER_STEREO_PROJECTION:
+		fill_sub_image(&data.stereo.l.sub, indices[0], PROJECTION_SIZE);
+		fill_sub_image(&data.stereo.r.sub, indices[1], PROJECTION_SIZE);
+		data.stereo.l.fov = fov;
+		data.stereo.r.fov = fov;
+		data.stereo.l.pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+		data.stereo.r.pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+		return xrt_comp_layer_stereo_projection(xc, head, bl->xscs[0], bl->xscs[1], &data);
+	case XRT_LAYER_STEREO_PROJECTION_DEPTH:
+		fill_sub_image(&data.stereo_depth.l.sub, indices[0], PROJECTION_SIZE);
+		fill_sub_image(&data.stereo_depth.r.sub, indices[1], PROJECTION_SIZE);
+		fill_sub_image(&data.stereo_depth.l_d.sub, indices[2], PROJECTION_SIZE);
+		fill_sub_image(&data.stereo_depth.r_d.sub, indices[3], PROJECTION_SIZE);
+		data.stereo_depth.l.fov = fov;
+		data.stereo_depth.r.fov = fov;
+		data.stereo_depth.l.pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+		data.stereo_depth.r.pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+		data.stereo_depth.l_d.max_depth = 1.0f;
+		data.stereo_depth.r_d.max_depth = 1.0f;
+		data.stereo_depth.l_d.near_z = 0.1f;
+		data.stereo_depth.r_d.near_z = 0.1f;
+		data.stereo_depth.l_d.far_z = 100.0f;
+		data.stereo_depth.r_d.far_z = 100.0f;
+		return xrt_comp_layer_stereo_projection_depth(xc, head, bl->xscs[0], bl->xscs[1], bl->xscs[2],
+		                                              bl->xscs[3], &data);
+	case XRT_LAYER_QUAD:
+		fill_sub_image(&data.quad.sub, indices[0], LAYER_SIZE);
+		data.quad.visibility = XRT_LAYER_EYE_VISIBILITY_BOTH;
+		data.quad.pose = in_front;
+		data.quad.size = (struct xrt_vec2){1.0f, 1.0f};
+		return xrt_comp_layer_quad(xc, head, bl->xscs[0], &data);
+	case XRT_LAYER_CYLINDER:
+		fill_sub_image(&data.cylinder.sub, indices[0], LAYER_SIZE);
+		data.cylinder.visibility = XRT_LAYER_EYE_VISIBILITY_BOTH;
+		data.cylinder.pose = in_front;
+		data.cylinder.radius = 1.5f;
+		data.cylinder.central_angle = 1.0f;
+		data.cylinder.aspect_ratio = 1.0f;
+		return xrt_comp_layer_cylinder(xc, head, bl->xscs[0], &data);
+	case XRT_LAYER_EQUIRECT2:
+		fill_sub_image(&data.equirect2.sub, indices[0], LAYER_SIZE);
+		data.equirect2.visibility = XRT_LAYER_EYE_VISIBILITY_BOTH;
+		data.equirect2.pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+		data.equirect2.radius = 0.0f; // Infinite.
+		data.equirect2.central_horizontal_angle = 2.0f;
+		data.equirect2.upper_vertical_angle = 0.8f;
+		data.equirect2.lower_vertical_angle = -0.8f;
+		return xrt_comp_layer_equirect2(xc, head, bl->xscs[0], &data);
+	default: assert(false); return XRT_SUCCESS;
+	}
+}
+
+static xrt_result_t
+run_frame(struct bench *b, struct bench_client *bc, uint32_t frame)
+{
+	struct xrt_compositor *xc = &bc->xcn->base;
+	struct xrt_device *head = b->xsysd->static_roles.head;
+	xrt_result_t xret;
+
+	// Drain the session events, nothing in them matters here.
+	union xrt_session_event xse;
+	do {
+		xret = xrt_session_poll_events(bc->xs, &xse);
+	} while (xret == XRT_SUCCESS && xse.type != XRT_SESSION_EVENT_NONE);
+
+	int64_t frame_id = -1;
+	uint64_t predicted_display_time_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+
+	xret = xrt_comp_wait_frame(xc, &frame_id, &predicted_display_time_ns, &predicted_display_period_ns);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: xrt_comp_wait_frame failed: %d\n", bc->index, xret);
+		return xret;
+	}
+
+	uint64_t wake_ns = os_monotonic_get_ns();
+
+	xret = xrt_comp_begin_frame(xc, frame_id);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: xrt_comp_begin_frame failed: %d\n", bc->index, xret);
+		return xret;
+	}
+
+	struct xrt_layer_frame_data frame_data = {
+	    .frame_id = frame_id,
+	    .display_time_ns = predicted_display_time_ns,
+	    .env_blend_mode = XRT_BLEND_MODE_OPAQUE,
+	};
+
+	xret = xrt_comp_layer_begin(xc, &frame_data);
+	for (uint32_t i = 0; i < bc->layer_count && xret == XRT_SUCCESS; i++) {
+		xret = submit_layer(bc, head, &bc->layers[i], predicted_display_time_ns);
+	}
+	if (xret == XRT_SUCCESS) {
+		xret = xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
+	}
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: layer submission failed: %d\n", bc->index, xret);
+		return xret;
+	}
+
+	uint64_t commit_ns = os_monotonic_get_ns();
+
+	os_mutex_lock(&b->mutex);
+
+	// Client zero decides when the measuring starts and stops.
+	if (bc->index == 0 && frame == b->warmup) {
+		b->measuring = true;
+	}
+
+	bc->pending_wake_ns = wake_ns;
+	bc->pending_commit_ns = commit_ns;
+	bc->pending = true;
+
+	os_mutex_unlock(&b->mutex);
+
+	return XRT_SUCCESS;
+}
+
+static void *
+run_client(void *ptr)
+{
+	struct bench_client *bc = (struct bench_client *)ptr;
+	struct bench *b = bc->b;
+	xrt_result_t xret;
+
+	xret = create_layers(bc, b->layer_mix);
+	if (xret != XRT_SUCCESS) {
+		bc->failed = true;
+		goto out;
+	}
+
+	struct xrt_begin_session_info begin_info = {.view_type = XRT_VIEW_TYPE_STEREO};
+	xret = xrt_comp_begin_session(&bc->xcn->base, &begin_info);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: xrt_comp_begin_session failed: %d\n", bc->index, xret);
+		bc->failed = true;
+		goto out;
+	}
+
+	uint32_t total = b->warmup + b->frames;
+	for (uint32_t i = 0; i < total; i++) {
+		xret = run_frame(b, bc, i);
+		if (xret != XRT_SUCCESS) {
+			bc->failed = true;
+			break;
+		}
+	}
+
+	xrt_comp_end_session(&bc->xcn->base);
+
+out:
+	os_mutex_lock(&b->mutex);
+	if (bc->index == 0) {
+		b->measuring = false;
+	}
+	os_mutex_unlock(&b->mutex);
+
+	return NULL;
+}
+
+static bool
+create_clients(struct bench *b)
+{
+	for (uint32_t i = 0; i < b->client_count; i++) {
+		struct bench_client *bc = &b->clients[i];
+
+		// Overlays don't need the primary role to get frames displayed.
+		struct xrt_session_info xsi = {
+		    .is_overlay = i > 0,
+		    .z_order = i,
+		};
+
+		xrt_result_t xret = xrt_system_create_session(b->xsys, &xsi, &bc->xs, &bc->xcn);
+		if (xret != XRT_SUCCESS) {
+			PE("Client %u: xrt_system_create_session failed: %d\n", i, xret);
+			return false;
+		}
+
+		if (b->xsysc->xmcc != NULL) {
+			xrt_syscomp_set_state(b->xsysc, &bc->xcn->base, true, true);
+			xrt_syscomp_set_z_order(b->xsysc, &bc->xcn->base, i);
+		}
+	}
+
+	return true;
+}
+
+static void
+destroy_clients(struct bench *b)
+{
+	for (uint32_t i = 0; i < b->client_count; i++) {
+		struct bench_client *bc = &b->clients[i];
+
+		destroy_layers(bc);
+		xrt_comp_native_destroy(&bc->xcn);
+		xrt_session_destroy(&bc->xs);
+		os_thread_destroy(&bc->thread);
+	}
+}
+
+static void
+print_results(struct bench *b)
+{
+	P("%-26s %10s %10s %10s %10s %10s\n", "stat (us)", "samples", "p50", "p99", "p999", "max");
+
+	for (uint32_t i = 0; i < BENCH_STAT_COUNT; i++) {
+		struct bench_samples *s = &b->stats[i];
+
+		qsort(s->values, s->count, sizeof(*s->values), compare_u64);
+
+		P("%-26s %10u %10.1f %10.1f %10.1f %10.1f\n", //
+		  bench_stat_names[i],                         //
+		  s->count,                                    //
+		  percentile_us(s->values, s->count, 0.50),    //
+		  percentile_us(s->values, s->count, 0.99),    //
+		  percentile_us(s->values, s->count, 0.999),   //
+		  percentile_us(s->values, s->count, 1.0));    //
+	}
+
+	P("Compositor frames %" PRIu64 ", missed %" PRIu64 "\n", b->frame_count, b->missed_count);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+main(int argc, char *argv[])
+{
+	static struct bench b = {0};
+	b.client_count = 1;
+	b.layer_mix = "p";
+	b.frames = 1000;
+	b.warmup = 60;
+
+	// parse arguments
+	int c;
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "c:l:n:w:")) != -1) {
+		switch (c) {
+		case 'c': b.client_count = (uint32_t)atoi(optarg); break;
+		case 'l': b.layer_mix = optarg; break;
+		case 'n': b.frames = (uint32_t)atoi(optarg); break;
+		case 'w': b.warmup = (uint32_t)atoi(optarg); break;
+		case '?':
+			if (isprint(optopt)) {
+				PE("Option `-%c' unknown. Usage:\n", optopt);
+				PE("    -c <count>: Number of concurrent clients, 1 to %d (default 1)\n", MAX_CLIENTS);
+				PE("    -l <mix>:   Layers per client, one letter per layer (default p)\n");
+				PE("                p projection, d projection with depth, q quad, c cylinder, e equirect2\n");
+				PE("    -n <count>: Measured frames per client (default 1000)\n");
+				PE("    -w <count>: Unmeasured warmup frames per client (default 60)\n");
+			} else {
+				PE("Option `\\x%x' unknown.\n", optopt);
+			}
+			exit(1);
+		default: exit(0);
+		}
+	}
+
+	if (b.client_count < 1 || b.client_count > MAX_CLIENTS || b.frames < 1) {
+		PE("Need 1 to %d clients and at least one frame.\n", MAX_CLIENTS);
+		exit(1);
+	}
+
+	size_t mix_len = strlen(b.layer_mix);
+	if (mix_len > MAX_LAYERS || strspn(b.layer_mix, "pdqce") != mix_len) {
+		PE("Layers must be at most %d of the letters p, d, q, c and e.\n", MAX_LAYERS);
+		exit(1);
+	}
+
+	// Headless on the simulated HMD unless told otherwise.
+	setenv("XRT_COMPOSITOR_FORCE_OFFSCREEN", "true", 0);
+	setenv("SIMULATED_ENABLE", "true", 0);
+
+	// The compositor renders more frames than the clients submit, room for a few times more.
+	for (uint32_t i = 0; i < BENCH_STAT_COUNT; i++) {
+		b.stats[i].capacity = (b.frames + b.warmup) * 4;
+		b.stats[i].values = U_TYPED_ARRAY_CALLOC(uint64_t, b.stats[i].capacity);
+	}
+
+	for (uint32_t i = 0; i < b.client_count; i++) {
+		b.clients[i].b = &b;
+		b.clients[i].index = i;
+		os_thread_init(&b.clients[i].thread);
+	}
+
+	os_mutex_init(&b.mutex);
+	comp_window_offscreen_set_frame_func(on_frame, &b);
+
+	int ret = 1;
+
+	xrt_result_t xret = xrt_instance_create(NULL, &b.xinst);
+	if (xret != XRT_SUCCESS) {
+		PE("xrt_instance_create failed: %d\n", xret);
+		goto out;
+	}
+
+	xret = xrt_instance_create_system(b.xinst, &b.xsys, &b.xsysd, &b.xso, &b.xsysc);
+	if (xret != XRT_SUCCESS || b.xsysc == NULL) {
+		PE("xrt_instance_create_system failed: %d\n", xret);
+		goto out;
+	}
+
+	if (!create_clients(&b)) {
+		goto out_clients;
+	}
+
+	P("Running %u frames on %u client(s) with layers '%s'.\n", b.frames, b.client_count, b.layer_mix);
+
+	for (uint32_t i = 0; i < b.client_count; i++) {
+		os_thread_start(&b.clients[i].thread, run_client, &b.clients[i]);
+	}
+
+	bool failed = false;
+	for (uint32_t i = 0; i < b.client_count; i++) {
+		os_thread_join(&b.clients[i].thread);
+		failed = failed || b.clients[i].failed;
+	}
+
+	print_results(&b);
+
+	ret = failed ? 1 : 0;
+
+out_clients:
+	destroy_clients(&b);
+out:
+	xrt_syscomp_destroy(&b.xsysc);
+	xrt_space_overseer_destroy(&b.xso);
+	xrt_system_devices_destroy(&b.xsysd);
+	xrt_system_destroy(&b.xsys);
+	xrt_instance_destroy(&b.xinst);
+
+	// The compositor thread is gone now.
+	comp_window_offscreen_set_frame_func(NULL, NULL);
+
+	os_mutex_destroy(&b.mutex);
+	for (uint32_t i = 0; i < BENCH_STAT_COUNT; i++) {
+		free(b.stats[i].values);
+	}
+
+	return ret;
+}
@@ -7,7 +7,11 @@
  * @ingroup ipc
  */
 
+#include "os/os_time.h"
+
 #include "util/u_file.h"
+#include "util/u_metrics.h"
+#include "util/u_time.h"
 
 #include "client/ipc_client.h"
 #include "client/ipc_client_connection.h"
@@ -15,6 +19,7 @@
 #include "ipc_client_generated.h"
 
 #include <ctype.h>
+#include <inttypes.h>
 
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -27,6 +32,7 @@ typedef enum op_mode
 	MODE_SET_FOCUSED,
 	MODE_TOGGLE_IO,
 	MODE_RECENTER,
+	MODE_STATS,
 } op_mode_t;
 
 
@@ -76,7 +82,7 @@ get_mode(struct ipc_connection *ipc_c)
 
 	P("\nDevices:\n");
 	for (uint32_t i = 0; i < ipc_c->ism->isdev_count; i++) {
-		struct ipc_shared_device *isdev = &ipc_c->ism->isdevs[i];
+		struct ipc_shared_device *isdev = &ipc_shm_isdevs(ipc_c->ism)[i];
 		P("\tid: %d"
 		  "\tname: %d"
 		  "\t\"%s\"\n",
@@ -143,6 +149,66 @@ recenter_local_spaces(struct ipc_connection *ipc_c)
 
 	return 0;
 }
+
+static const struct u_metrics_stats_session *
+find_session(const struct u_metrics_stats *stats, int64_t session_id)
+{
+	for (uint32_t i = 0; i < U_METRICS_STATS_MAX_SESSIONS; i++) {
+		const struct u_metrics_stats_session *s = &stats->sessions[i];
+		if (s->valid && s->session_id == session_id) {
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+static int
+print_stats(struct ipc_connection *ipc_c)
+{
+	struct u_metrics_stats last;
+	u_metrics_stats_copy(ipc_shm_stats(ipc_c->ism), &last);
+
+	// Runs until killed, deltas over one second make the rates.
+	while (true) {
+		os_nanosleep(U_TIME_1S_IN_NS);
+
+		struct u_metrics_stats now;
+		u_metrics_stats_copy(ipc_shm_stats(ipc_c->ism), &now);
+
+		P("fps: %" PRIu64 "\tmissed: %" PRIu64 "\tperiod: %.2fms\tgpu: %.2fms\tm2p: %.2fms\n", //
+		  now.frame_count - last.frame_count,                                                   //
+		  now.missed_frame_count - last.missed_frame_count,                                     //
+		  time_ns_to_ms_f(now.frame_period_ns),                                                 //
+		  time_ns_to_ms_f(now.gpu_time_ns),                                                     //
+		  time_ns_to_ms_f(now.pose_latency_ns));                                                //
+
+		for (uint32_t i = 0; i < U_METRICS_STATS_MAX_SESSIONS; i++) {
+			const struct u_metrics_stats_session *s = &now.sessions[i];
+			if (!s->valid) {
+				continue;
+			}
+
+			const struct u_metrics_stats_session *l = find_session(&last, s->session_id);
+			uint64_t frames = s->frame_count - (l != NULL ? l->frame_count : 0);
+			uint64_t discarded = s->discarded_frame_count - (l != NULL ? l->discarded_frame_count : 0);
+
+			P("\tsession: %" PRId64 "\tfps: %" PRIu64 "\tdiscarded: %" PRIu64
+			  "\tlatency: %.2fms\tcpu: %.2fms\n", //
+			  s->session_id,                    //
+			  frames,                           //
+			  discarded,                        //
+			  time_ns_to_ms_f(s->latency_ns),   //
+			  time_ns_to_ms_f(s->cpu_time_ns)); //
+		}
+
+		fflush(stdout);
+		last = now;
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -153,7 +219,7 @@ main(int argc, char *argv[])
 	int s_val = 0;
 
 	opterr = 0;
-	while ((c = getopt(argc, argv, "p:f:i:c")) != -1) {
+	while ((c = getopt(argc, argv, "p:f:i:cs")) != -1) {
 		switch (c) {
 		case 'p':
 			s_val = atoi(optarg);
@@ -168,12 +234,12 @@ main(int argc, char *argv[])
 			op_mode = MODE_TOGGLE_IO;
 			break;
 		case 'c': op_mode = MODE_RECENTER; break;
+		case 's': op_mode = MODE_STATS; break;
 		case '?':
-			if (optopt == 's') {
-				PE("Option -s requires an id to set.\n");
-			} else if (isprint(optopt)) {
+			if (isprint(optopt)) {
 				PE("Option `-%c' unknown. Usage:\n", optopt);
 				PE("    -c: Recenter local spaces\n");
+				PE("    -s: Print frame timing stats every second\n");
 				PE("    -f <id>: Set focused client\n");
 				PE("    -p <id>: Set primary client\n");
 				PE("    -i <id>: Toggle whether client receives input\n");
@@ -204,6 +270,7 @@ main(int argc, char *argv[])
 	case MODE_SET_FOCUSED: exit(set_focused(&ipc_c, s_val)); break;
 	case MODE_TOGGLE_IO: exit(toggle_io(&ipc_c, s_val)); break;
 	case MODE_RECENTER: exit(recenter_local_spaces(&ipc_c)); break;
+	case MODE_STATS: exit(print_stats(&ipc_c)); break;
 	default: P("Unrecognised operation mode.\n"); exit(1);
 	}
 
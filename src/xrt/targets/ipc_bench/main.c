@@ -0,0 +1,375 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Measures round trip latency of the hot IPC calls.
+ * @ingroup ipc
+ */
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+
+#include "client/ipc_client.h"
+#include "client/ipc_client_connection.h"
+
+#include "ipc_client_generated.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+#define MAX_CLIENTS IPC_MAX_CLIENTS
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+enum bench_call
+{
+	BENCH_GET_TRACKED_POSE,
+	BENCH_LOCATE_SPACE,
+	BENCH_PREDICT_FRAME,
+	BENCH_LAYER_SYNC,
+	BENCH_CALL_COUNT,
+};
+
+static const char *bench_call_names[BENCH_CALL_COUNT] = {
+    "device_get_tracked_pose",
+    "space_locate_space",
+    "compositor_predict_frame",
+    "compositor_layer_sync",
+};
+
+struct bench_client
+{
+	struct os_thread thread;
+
+	uint32_t index;
+	uint32_t iterations;
+	uint32_t warmup;
+
+	//! One sample per iteration and call, in nanoseconds.
+	uint64_t *samples[BENCH_CALL_COUNT];
+
+	//! Number of samples recorded for each call.
+	uint32_t sample_count[BENCH_CALL_COUNT];
+
+	bool failed;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static int
+compare_u64(const void *a, const void *b)
+{
+	uint64_t l = *(const uint64_t *)a;
+	uint64_t r = *(const uint64_t *)b;
+	return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+static double
+percentile_us(const uint64_t *sorted, uint32_t count, double p)
+{
+	if (count == 0) {
+		return 0.0;
+	}
+
+	uint32_t index = (uint32_t)(p * (double)(count - 1) + 0.5);
+	return (double)sorted[index] / 1000.0;
+}
+
+static void
+record(struct bench_client *bc, uint32_t iteration, enum bench_call call, uint64_t start_ns)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	// Warmup iterations are not recorded.
+	if (iteration < bc->warmup) {
+		return;
+	}
+
+	bc->samples[call][bc->sample_count[call]++] = now_ns - start_ns;
+}
+
+static xrt_result_t
+run_iteration(struct bench_client *bc,
+              struct ipc_connection *ipc_c,
+              uint32_t iteration,
+              uint32_t head_id,
+              uint32_t local_id,
+              uint32_t view_id,
+              uint32_t *slot_id)
+{
+	struct xrt_pose identity = XRT_POSE_IDENTITY;
+	struct xrt_space_relation relation;
+	xrt_result_t xret;
+	uint64_t start_ns;
+
+	start_ns = os_monotonic_get_ns();
+	xret = ipc_call_device_get_tracked_pose(ipc_c, head_id, XRT_INPUT_GENERIC_HEAD_POSE, start_ns, &relation);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: device_get_tracked_pose failed: %d\n", bc->index, xret);
+		return xret;
+	}
+	record(bc, iteration, BENCH_GET_TRACKED_POSE, start_ns);
+
+	start_ns = os_monotonic_get_ns();
+	xret = ipc_call_space_locate_space(ipc_c, local_id, &identity, start_ns, view_id, &identity, &relation);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: space_locate_space failed: %d\n", bc->index, xret);
+		return xret;
+	}
+	record(bc, iteration, BENCH_LOCATE_SPACE, start_ns);
+
+	int64_t frame_id;
+	uint64_t wake_up_time_ns;
+	uint64_t predicted_display_time_ns;
+	uint64_t predicted_display_period_ns;
+
+	start_ns = os_monotonic_get_ns();
+	xret = ipc_call_compositor_predict_frame( //
+	    ipc_c,                                //
+	    &frame_id,                            //
+	    &wake_up_time_ns,                     //
+	    &predicted_display_time_ns,           //
+	    &predicted_display_period_ns);        //
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: compositor_predict_frame failed: %d\n", bc->index, xret);
+		return xret;
+	}
+	record(bc, iteration, BENCH_PREDICT_FRAME, start_ns);
+
+	// Not measured, these pace the frame loop like a real client.
+	xret = ipc_call_compositor_wait_woke(ipc_c, frame_id);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: compositor_wait_woke failed: %d\n", bc->index, xret);
+		return xret;
+	}
+
+	xret = ipc_call_compositor_begin_frame(ipc_c, frame_id);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: compositor_begin_frame failed: %d\n", bc->index, xret);
+		return xret;
+	}
+
+	// Submit a frame without any layers.
+	struct ipc_layer_slot *slot = &ipc_shm_slots(ipc_c->ism)[*slot_id];
+	slot->data.frame_id = frame_id;
+	slot->data.display_time_ns = predicted_display_time_ns;
+	slot->data.env_blend_mode = XRT_BLEND_MODE_OPAQUE;
+	slot->layer_count = 0;
+
+	start_ns = os_monotonic_get_ns();
+	xret = ipc_call_compositor_layer_sync(ipc_c, *slot_id, NULL, 0, slot_id);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: compositor_layer_sync failed: %d\n", bc->index, xret);
+		return xret;
+	}
+	record(bc, iteration, BENCH_LAYER_SYNC, start_ns);
+
+	return XRT_SUCCESS;
+}
+
+static void *
+run_client(void *ptr)
+{
+	struct bench_client *bc = (struct bench_client *)ptr;
+	struct ipc_connection ipc_c = {0};
+	xrt_result_t xret;
+
+	struct xrt_instance_info info = {0};
+	snprintf(info.application_name, sizeof(info.application_name), "monado-ipc-bench-%u", bc->index);
+
+	xret = ipc_client_connection_init(&ipc_c, U_LOGGING_WARN, &info);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: ipc_client_connection_init: %d\n", bc->index, xret);
+		bc->failed = true;
+		return NULL;
+	}
+
+	int32_t head = ipc_c.ism->roles.head;
+	if (head < 0) {
+		PE("Client %u: No head device!\n", bc->index);
+		goto err_fini;
+	}
+
+	uint32_t root_id, view_id, local_id, local_floor_id, stage_id, unbounded_id;
+	xret = ipc_call_space_create_semantic_ids( //
+	    &ipc_c,                                //
+	    &root_id,                              //
+	    &view_id,                              //
+	    &local_id,                             //
+	    &local_floor_id,                       //
+	    &stage_id,                             //
+	    &unbounded_id);                        //
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: space_create_semantic_ids failed: %d\n", bc->index, xret);
+		goto err_fini;
+	}
+
+	// Overlays don't need the primary role to get frames displayed.
+	struct xrt_session_info xsi = {
+	    .is_overlay = bc->index > 0,
+	    .z_order = bc->index,
+	};
+
+	xret = ipc_call_session_create(&ipc_c, &xsi, true);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: session_create failed: %d\n", bc->index, xret);
+		goto err_fini;
+	}
+
+	xret = ipc_call_session_begin(&ipc_c);
+	if (xret != XRT_SUCCESS) {
+		PE("Client %u: session_begin failed: %d\n", bc->index, xret);
+		goto err_session;
+	}
+
+	uint32_t slot_id = 0;
+	uint32_t total = bc->warmup + bc->iterations;
+	for (uint32_t i = 0; i < total; i++) {
+		xret = run_iteration(bc, &ipc_c, i, (uint32_t)head, local_id, view_id, &slot_id);
+		if (xret != XRT_SUCCESS) {
+			bc->failed = true;
+			break;
+		}
+	}
+
+	ipc_call_session_end(&ipc_c);
+	ipc_call_session_destroy(&ipc_c);
+	ipc_client_connection_fini(&ipc_c);
+
+	return NULL;
+
+err_session:
+	ipc_call_session_destroy(&ipc_c);
+err_fini:
+	ipc_client_connection_fini(&ipc_c);
+	bc->failed = true;
+
+	return NULL;
+}
+
+static void
+print_results(struct bench_client *clients, uint32_t client_count, uint32_t iterations)
+{
+	P("%-26s %10s %10s %10s %10s %10s\n", "call (us)", "samples", "p50", "p99", "p999", "max");
+
+	for (uint32_t c = 0; c < BENCH_CALL_COUNT; c++) {
+		uint64_t *all = U_TYPED_ARRAY_CALLOC(uint64_t, (size_t)iterations * client_count);
+		uint32_t count = 0;
+
+		// Merge all clients, the distribution is what matters.
+		for (uint32_t i = 0; i < client_count; i++) {
+			for (uint32_t k = 0; k < clients[i].sample_count[c]; k++) {
+				all[count++] = clients[i].samples[c][k];
+			}
+		}
+
+		qsort(all, count, sizeof(*all), compare_u64);
+
+		P("%-26s %10u %10.1f %10.1f %10.1f %10.1f\n", //
+		  bench_call_names[c],                         //
+		  count,                                       //
+		  percentile_us(all, count, 0.50),             //
+		  percentile_us(all, count, 0.99),             //
+		  percentile_us(all, count, 0.999),            //
+		  percentile_us(all, count, 1.0));             //
+
+		free(all);
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+main(int argc, char *argv[])
+{
+	uint32_t client_count = 1;
+	uint32_t iterations = 10000;
+	uint32_t warmup = 100;
+
+	// parse arguments
+	int c;
+
+	opterr = 0;
+	while ((c = getopt(argc, argv, "c:n:w:")) != -1) {
+		switch (c) {
+		case 'c': client_count = (uint32_t)atoi(optarg); break;
+		case 'n': iterations = (uint32_t)atoi(optarg); break;
+		case 'w': warmup = (uint32_t)atoi(optarg); break;
+		case '?':
+			if (isprint(optopt)) {
+				PE("Option `-%c' unknown. Usage:\n", optopt);
+				PE("    -c <count>: Number of concurrent clients, 1 to %d (default 1)\n", MAX_CLIENTS);
+				PE("    -n <count>: Measured iterations per client (default 10000)\n");
+				PE("    -w <count>: Unmeasured warmup iterations per client (default 100)\n");
+			} else {
+				PE("Option `\\x%x' unknown.\n", optopt);
+			}
+			exit(1);
+		default: exit(0);
+		}
+	}
+
+	if (client_count < 1 || client_count > MAX_CLIENTS || iterations < 1) {
+		PE("Need 1 to %d clients and at least one iteration.\n", MAX_CLIENTS);
+		exit(1);
+	}
+
+	struct bench_client clients[MAX_CLIENTS] = {0};
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		struct bench_client *bc = &clients[i];
+		bc->index = i;
+		bc->iterations = iterations;
+		bc->warmup = warmup;
+		for (uint32_t k = 0; k < BENCH_CALL_COUNT; k++) {
+			bc->samples[k] = U_TYPED_ARRAY_CALLOC(uint64_t, iterations);
+		}
+		os_thread_init(&bc->thread);
+	}
+
+	P("Running %u iterations on %u client(s), make sure the service is running.\n", iterations, client_count);
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		os_thread_start(&clients[i].thread, run_client, &clients[i]);
+	}
+
+	bool failed = false;
+	for (uint32_t i = 0; i < client_count; i++) {
+		os_thread_join(&clients[i].thread);
+		os_thread_destroy(&clients[i].thread);
+		failed = failed || clients[i].failed;
+	}
+
+	print_results(clients, client_count, iterations);
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		for (uint32_t k = 0; k < BENCH_CALL_COUNT; k++) {
+			free(clients[i].samples[k]);
+		}
+	}
+
+	return failed ? 1 : 0;
+}
@@ -26,6 +26,12 @@
 #include <stdint.h>
 #include <assert.h>
 
+#ifndef XRT_OS_WINDOWS
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 
 struct mnd_root
 {
@@ -36,6 +42,13 @@ struct mnd_root
 
 	/// State of most recent app asked about
 	struct ipc_app_state app_state;
+
+	//! Latest snapshot, client queries are answered from it while valid.
+	struct ipc_system_snapshot snapshot;
+	bool snapshot_valid;
+
+	//! Socket events are received on, -1 if not subscribed.
+	int event_fd;
 };
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -88,6 +101,18 @@ get_client_info(mnd_root_t *root, uint32_t client_id)
 {
 	assert(root != NULL);
 
+	if (root->snapshot_valid) {
+		for (uint32_t i = 0; i < root->snapshot.client_count; i++) {
+			if (root->snapshot.clients[i].id == client_id) {
+				root->app_state = root->snapshot.clients[i];
+				return MND_SUCCESS;
+			}
+		}
+
+		PE("No client with id %u in the snapshot.\n", client_id);
+		return MND_ERROR_INVALID_VALUE;
+	}
+
 	xrt_result_t r = ipc_call_system_get_client_info(&root->ipc_c, client_id, &root->app_state);
 	if (r != XRT_SUCCESS) {
 		PE("Failed to get client info for client id: %u.\n", client_id);
@@ -125,6 +150,7 @@ mnd_root_create(mnd_root_t **out_root)
 	CHECK_NOT_NULL(out_root);
 
 	mnd_root_t *r = U_TYPED_CALLOC(mnd_root_t);
+	r->event_fd = -1;
 
 	struct xrt_instance_info info = {0};
 	snprintf(info.application_name, sizeof(info.application_name), "%s", "libmonado");
@@ -153,6 +179,12 @@ mnd_root_destroy(mnd_root_t **root_ptr)
 		return;
 	}
 
+#ifndef XRT_OS_WINDOWS
+	if (r->event_fd >= 0) {
+		close(r->event_fd);
+	}
+#endif
+
 	ipc_client_connection_fini(&r->ipc_c);
 	free(r);
 
@@ -166,6 +198,9 @@ mnd_root_update_client_list(mnd_root_t *root)
 {
 	CHECK_NOT_NULL(root);
 
+	// Back to asking the service for each client.
+	root->snapshot_valid = false;
+
 	xrt_result_t r = ipc_call_system_get_clients(&root->ipc_c, &root->clients);
 	if (r != XRT_SUCCESS) {
 		PE("Failed to get client list.\n");
@@ -175,6 +210,29 @@ mnd_root_update_client_list(mnd_root_t *root)
 	return MND_SUCCESS;
 }
 
+mnd_result_t
+mnd_root_snapshot(mnd_root_t *root)
+{
+	CHECK_NOT_NULL(root);
+
+	root->snapshot_valid = false;
+
+	xrt_result_t r = ipc_call_system_get_snapshot(&root->ipc_c, &root->snapshot);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to get snapshot.\n");
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	root->clients.id_count = root->snapshot.client_count;
+	for (uint32_t i = 0; i < root->snapshot.client_count; i++) {
+		root->clients.ids[i] = root->snapshot.clients[i].id;
+	}
+
+	root->snapshot_valid = true;
+
+	return MND_SUCCESS;
+}
+
 mnd_result_t
 mnd_root_get_number_clients(mnd_root_t *root, uint32_t *out_num)
 {
@@ -369,7 +427,7 @@ mnd_root_get_device_info_string(mnd_root_t *root, uint32_t device_index, mnd_pro
 		return MND_ERROR_INVALID_VALUE;
 	}
 
-	const struct ipc_shared_device *shared_device = &root->ipc_c.ism->isdevs[device_index];
+	const struct ipc_shared_device *shared_device = &ipc_shm_isdevs(root->ipc_c.ism)[device_index];
 
 	switch (prop) {
 	case MND_PROPERTY_NAME_STRING: *out_string = shared_device->str; break;
@@ -392,7 +450,7 @@ mnd_root_get_device_info(mnd_root_t *root, uint32_t device_index, uint32_t *out_
 		return MND_ERROR_INVALID_VALUE;
 	}
 
-	const struct ipc_shared_device *shared_device = &root->ipc_c.ism->isdevs[device_index];
+	const struct ipc_shared_device *shared_device = &ipc_shm_isdevs(root->ipc_c.ism)[device_index];
 	*out_device_id = shared_device->name;
 	*out_dev_name = shared_device->str;
 
@@ -437,10 +495,14 @@ mnd_root_get_device_from_role(mnd_root_t *root, const char *role_name, int32_t *
 	}
 
 	struct xrt_system_roles roles;
-	xrt_result_t xret = ipc_call_system_devices_get_roles(&root->ipc_c, &roles);
-	if (xret != XRT_SUCCESS) {
-		PE("Failed to get dynamic roles");
-		return MND_ERROR_OPERATION_FAILED;
+	if (root->snapshot_valid) {
+		roles = root->snapshot.roles;
+	} else {
+		xrt_result_t xret = ipc_call_system_devices_get_roles(&root->ipc_c, &roles);
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to get dynamic roles");
+			return MND_ERROR_OPERATION_FAILED;
+		}
 	}
 
 	// Assumes roles index match device id.
@@ -463,3 +525,173 @@ mnd_root_recenter_local_spaces(mnd_root_t *root)
 	default: PE("Internal error, shouldn't get here"); return MND_ERROR_OPERATION_FAILED;
 	}
 }
+
+mnd_result_t
+mnd_root_get_frame_stats(mnd_root_t *root, mnd_frame_stats_t *out_stats)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_stats);
+
+	struct u_metrics_stats stats;
+	u_metrics_stats_copy(ipc_shm_stats(root->ipc_c.ism), &stats);
+
+	U_ZERO(out_stats);
+	out_stats->frame_count = stats.frame_count;
+	out_stats->missed_frame_count = stats.missed_frame_count;
+	out_stats->frame_period_ns = stats.frame_period_ns;
+	out_stats->gpu_time_ns = stats.gpu_time_ns;
+	out_stats->layer_squash_ns = stats.layer_squash_ns;
+	out_stats->distortion_ns = stats.distortion_ns;
+
+	for (uint32_t i = 0; i < U_METRICS_STATS_MAX_SESSIONS && i < MND_MAX_SESSION_STATS; i++) {
+		const struct u_metrics_stats_session *s = &stats.sessions[i];
+		if (!s->valid) {
+			continue;
+		}
+
+		mnd_session_stats_t *out = &out_stats->sessions[out_stats->session_count++];
+		out->session_id = s->session_id;
+		out->frame_count = s->frame_count;
+		out->discarded_frame_count = s->discarded_frame_count;
+		out->latency_ns = s->latency_ns;
+		out->cpu_time_ns = s->cpu_time_ns;
+		out->when_delivered_ns = s->when_delivered_ns;
+	}
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_get_device_call_stats(mnd_root_t *root, uint32_t device_index, mnd_call_stats_t *out_calls)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_calls);
+
+	if (device_index >= root->ipc_c.ism->isdev_count) {
+		PE("Invalid device index (%u)", device_index);
+		return MND_ERROR_INVALID_VALUE;
+	}
+
+	if (device_index >= U_METRICS_STATS_MAX_DEVICES) {
+		PE("Device index (%u) has no stats", device_index);
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	struct u_metrics_stats stats;
+	u_metrics_stats_copy(ipc_shm_stats(root->ipc_c.ism), &stats);
+
+	const struct u_metrics_stats_device *d = &stats.devices[device_index];
+	if (!d->valid) {
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	static_assert((int)MND_DEVICE_CALL_COUNT == (int)U_METRICS_DEVICE_CALL_COUNT, "Call count mismatch");
+	static_assert(MND_CALL_LATENCY_BUCKET_COUNT == U_METRICS_LATENCY_BUCKET_COUNT, "Bucket count mismatch");
+
+	for (uint32_t i = 0; i < U_METRICS_DEVICE_CALL_COUNT; i++) {
+		const struct u_metrics_latency_histogram *hist = &d->calls[i];
+		mnd_call_stats_t *out = &out_calls[i];
+
+		out->count = hist->count;
+		out->total_ns = hist->total_ns;
+		out->max_ns = hist->max_ns;
+		for (uint32_t k = 0; k < U_METRICS_LATENCY_BUCKET_COUNT; k++) {
+			out->buckets[k] = hist->buckets[k];
+		}
+	}
+
+	return MND_SUCCESS;
+}
+
+mnd_result_t
+mnd_root_subscribe_events(mnd_root_t *root, int *out_fd)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_fd);
+
+#ifndef XRT_OS_WINDOWS
+	if (root->event_fd < 0) {
+		xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+		xrt_result_t xret = ipc_call_system_subscribe_events(&root->ipc_c, &handle, 1);
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to subscribe to events");
+			return MND_ERROR_OPERATION_FAILED;
+		}
+
+		root->event_fd = handle;
+	}
+
+	*out_fd = root->event_fd;
+
+	return MND_SUCCESS;
+#else
+	PE("Events are not supported on this platform");
+	return MND_ERROR_OPERATION_FAILED;
+#endif
+}
+
+mnd_result_t
+mnd_root_read_event(mnd_root_t *root, mnd_event_t *out_event)
+{
+	CHECK_NOT_NULL(root);
+	CHECK_NOT_NULL(out_event);
+
+	U_ZERO(out_event);
+
+#ifndef XRT_OS_WINDOWS
+	if (root->event_fd < 0) {
+		PE("Not subscribed to events");
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	struct ipc_system_event event;
+	ssize_t ret = recv(root->event_fd, &event, sizeof(event), MSG_DONTWAIT);
+	if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		out_event->type = MND_EVENT_NONE;
+		return MND_SUCCESS;
+	}
+	if (ret != (ssize_t)sizeof(event)) {
+		PE("Failed to read event, connection lost?");
+		return MND_ERROR_OPERATION_FAILED;
+	}
+
+	// The values are the same, see ipc_system_event_type.
+	out_event->type = (mnd_event_type_t)event.type;
+	out_event->client_id = event.client_id;
+
+	return MND_SUCCESS;
+#else
+	return MND_ERROR_OPERATION_FAILED;
+#endif
+}
+
+mnd_result_t
+mnd_root_set_device_feature_enabled(mnd_root_t *root,
+                                    uint32_t device_index,
+                                    mnd_device_feature_t feature,
+                                    bool enabled)
+{
+	CHECK_NOT_NULL(root);
+
+	if (device_index >= root->ipc_c.ism->isdev_count) {
+		PE("Invalid device index (%u)", device_index);
+		return MND_ERROR_INVALID_VALUE;
+	}
+
+	enum xrt_device_feature_type type;
+	switch (feature) {
+	case MND_DEVICE_FEATURE_HAND_TRACKING: type = XRT_DEVICE_FEATURE_HAND_TRACKING; break;
+	case MND_DEVICE_FEATURE_SLAM_TRACKING: type = XRT_DEVICE_FEATURE_SLAM_TRACKING; break;
+	default: PE("Invalid feature (%u)", feature); return MND_ERROR_INVALID_VALUE;
+	}
+
+	xrt_result_t xret = ipc_call_device_set_feature_enabled(&root->ipc_c, device_index, type, enabled);
+	switch (xret) {
+	case XRT_SUCCESS: return MND_SUCCESS;
+	case XRT_ERROR_FEATURE_NOT_SUPPORTED: return MND_ERROR_FEATURE_NOT_SUPPORTED;
+	case XRT_ERROR_IPC_FAILURE: PE("Connection error!"); return MND_ERROR_OPERATION_FAILED;
+	default: PE("Failed to change feature %u on device %u", feature, device_index); break;
+	}
+
+	return MND_ERROR_OPERATION_FAILED;
+}
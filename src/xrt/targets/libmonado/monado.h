@@ -25,7 +25,7 @@ extern "C" {
 //! Major version of the API.
 #define MND_API_VERSION_MAJOR 1
 //! Minor version of the API.
-#define MND_API_VERSION_MINOR 2
+#define MND_API_VERSION_MINOR 6
 //! Patch version of the API.
 #define MND_API_VERSION_PATCH 0
 
@@ -44,6 +44,8 @@ typedef enum mnd_result
 	MND_ERROR_RECENTERING_NOT_SUPPORTED = -5,
 	//! Supported in version 1.2 and above.
 	MND_ERROR_INVALID_PROPERTY = -6,
+	//! Supported in version 1.6 and above.
+	MND_ERROR_FEATURE_NOT_SUPPORTED = -7,
 } mnd_result_t;
 
 /*!
@@ -77,6 +79,146 @@ typedef enum mnd_property
  */
 typedef struct mnd_root mnd_root_t;
 
+/*!
+ * Max number of sessions in @ref mnd_frame_stats_t.
+ *
+ * Supported in version 1.3 and above.
+ */
+#define MND_MAX_SESSION_STATS 8
+
+/*!
+ * Frame timing stats of a single session, see @ref mnd_frame_stats_t.
+ *
+ * Supported in version 1.3 and above.
+ */
+typedef struct mnd_session_stats
+{
+	//! Service internal id of the session, not the client id.
+	int64_t session_id;
+	//! Frames delivered to the compositor.
+	uint64_t frame_count;
+	//! Frames discarded by the session.
+	uint64_t discarded_frame_count;
+	//! From the app waking up from xrWaitFrame to the display time, latest frame.
+	uint64_t latency_ns;
+	//! From xrBeginFrame to the frame being delivered, latest frame.
+	uint64_t cpu_time_ns;
+	//! Service monotonic time the latest frame was delivered at.
+	uint64_t when_delivered_ns;
+} mnd_session_stats_t;
+
+/*!
+ * Frame timing stats of the compositor and sessions. Counters only go up,
+ * sample them periodically to get rates.
+ *
+ * Supported in version 1.3 and above.
+ */
+typedef struct mnd_frame_stats
+{
+	//! Frames presented by the compositor.
+	uint64_t frame_count;
+	//! Frames presented later than desired.
+	uint64_t missed_frame_count;
+	//! Time between the latest two presented frames.
+	uint64_t frame_period_ns;
+	//! GPU time of the latest compositor frame.
+	uint64_t gpu_time_ns;
+	//! Layer squashing part of gpu_time_ns, zero if not measured.
+	uint64_t layer_squash_ns;
+	//! Distortion part of gpu_time_ns, zero if not measured.
+	uint64_t distortion_ns;
+	//! Number of elements in sessions that are valid.
+	uint32_t session_count;
+	//! Sessions most recently seen.
+	mnd_session_stats_t sessions[MND_MAX_SESSION_STATS];
+} mnd_frame_stats_t;
+
+/*!
+ * Number of buckets in @ref mnd_call_stats_t, bucket zero counts calls below
+ * two microseconds, each following bucket is twice as wide and the last one
+ * counts everything from 32 milliseconds and up.
+ *
+ * Supported in version 1.4 and above.
+ */
+#define MND_CALL_LATENCY_BUCKET_COUNT 16
+
+/*!
+ * A device entry point that the latency of is tracked.
+ *
+ * Supported in version 1.4 and above.
+ */
+typedef enum mnd_device_call
+{
+	MND_DEVICE_CALL_GET_TRACKED_POSE = 0,
+	MND_DEVICE_CALL_GET_HAND_TRACKING = 1,
+	MND_DEVICE_CALL_UPDATE_INPUTS = 2,
+	MND_DEVICE_CALL_SET_OUTPUT = 3,
+	MND_DEVICE_CALL_GET_VIEW_POSES = 4,
+	MND_DEVICE_CALL_COUNT = 5,
+} mnd_device_call_t;
+
+/*!
+ * Latency stats of calls to a single device entry point. Counters only go
+ * up, sample them periodically to get rates.
+ *
+ * Supported in version 1.4 and above.
+ */
+typedef struct mnd_call_stats
+{
+	//! Number of calls made.
+	uint64_t count;
+	//! Sum of the time of all calls.
+	uint64_t total_ns;
+	//! Longest call.
+	uint64_t max_ns;
+	//! Number of calls per latency bucket.
+	uint64_t buckets[MND_CALL_LATENCY_BUCKET_COUNT];
+} mnd_call_stats_t;
+
+/*!
+ * Type of @ref mnd_event_t.
+ *
+ * Supported in version 1.5 and above.
+ */
+typedef enum mnd_event_type
+{
+	//! No event was pending.
+	MND_EVENT_NONE = 0,
+	MND_EVENT_CLIENT_CONNECTED = 1,
+	MND_EVENT_CLIENT_DISCONNECTED = 2,
+	//! Primary, session or io state of a client changed.
+	MND_EVENT_CLIENT_STATE_CHANGED = 3,
+	//! The dynamic device roles changed.
+	MND_EVENT_ROLES_CHANGED = 4,
+	MND_EVENT_LOCAL_SPACES_RECENTERED = 5,
+	//! Events were dropped as they were not read fast enough, take a new snapshot.
+	MND_EVENT_EVENTS_LOST = 6,
+} mnd_event_type_t;
+
+/*!
+ * Event from the service, see @ref mnd_root_subscribe_events.
+ *
+ * Supported in version 1.5 and above.
+ */
+typedef struct mnd_event
+{
+	mnd_event_type_t type;
+	//! Client the event is about, zero if not about a single client.
+	uint32_t client_id;
+} mnd_event_t;
+
+/*!
+ * Camera based tracking of a device that can be turned on and off, see
+ * @ref mnd_root_set_device_feature_enabled.
+ *
+ * Supported in version 1.6 and above.
+ */
+typedef enum mnd_device_feature
+{
+	MND_DEVICE_FEATURE_HAND_TRACKING = 0,
+	MND_DEVICE_FEATURE_SLAM_TRACKING = 1,
+} mnd_device_feature_t;
+
 
 /*
  *
@@ -125,6 +267,20 @@ mnd_root_destroy(mnd_root_t **root_ptr);
 mnd_result_t
 mnd_root_update_client_list(mnd_root_t *root);
 
+/*!
+ * Update our local cached copy of the client list together with the state of
+ * all clients and the device roles, in a single round trip to the service.
+ * Until the next call to @ref mnd_root_update_client_list, the client name,
+ * state and role queries are answered from it without any round trip.
+ *
+ * Supported in version 1.5 and above.
+ *
+ * @param root The libmonado state.
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_snapshot(mnd_root_t *root);
+
 /*!
  * Get the number of active clients
  *
@@ -349,6 +505,94 @@ mnd_root_get_device_from_role(mnd_root_t *root, const char *role_name, int32_t *
 mnd_result_t
 mnd_root_recenter_local_spaces(mnd_root_t *root);
 
+/*!
+ * Get the frame timing stats of the compositor and sessions. Read straight
+ * from shared memory without any round trip to the service, so cheap enough
+ * to be polled.
+ *
+ * Supported in version 1.3 and above.
+ *
+ * @param root The libmonado state.
+ * @param[out] out_stats Pointer to populate with the stats.
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_get_frame_stats(mnd_root_t *root, mnd_frame_stats_t *out_stats);
+
+/*!
+ * Get the latency stats of calls to a device, indexed by @ref mnd_device_call_t.
+ * Only available if the service was started with @p XRT_DEVICE_TIMING set,
+ * read straight from shared memory like @ref mnd_root_get_frame_stats.
+ *
+ * Supported in version 1.4 and above.
+ *
+ * @param root The libmonado state.
+ * @param device_index Index of device to retrieve stats for.
+ * @param[out] out_calls Array of @ref MND_DEVICE_CALL_COUNT to populate.
+ *
+ * @return MND_SUCCESS on success, MND_ERROR_OPERATION_FAILED if the device isn't timed.
+ */
+mnd_result_t
+mnd_root_get_device_call_stats(mnd_root_t *root, uint32_t device_index, mnd_call_stats_t *out_calls);
+
+/*!
+ * Subscribe to events from the service, returns a file descriptor that is
+ * readable when there are events pending, for use with poll or a main loop.
+ * Read the events with @ref mnd_root_read_event. The descriptor is owned by
+ * libmonado and closed by @ref mnd_root_destroy. Calling this again returns
+ * the same descriptor.
+ *
+ * Fails on platforms without support for it (Windows).
+ *
+ * Supported in version 1.5 and above.
+ *
+ * @param root The libmonado state.
+ * @param[out] out_fd Pointer to populate with the file descriptor.
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_subscribe_events(mnd_root_t *root, int *out_fd);
+
+/*!
+ * Read the next pending event, never blocks, sets the type to
+ * @ref MND_EVENT_NONE if there are no events pending.
+ *
+ * Supported in version 1.5 and above.
+ *
+ * @param root The libmonado state.
+ * @param[out] out_event Pointer to populate with the event.
+ *
+ * @pre Called @ref mnd_root_subscribe_events
+ *
+ * @return MND_SUCCESS on success
+ */
+mnd_result_t
+mnd_root_read_event(mnd_root_t *root, mnd_event_t *out_event);
+
+/*!
+ * Turn camera based tracking of a device on or off while the service and all
+ * sessions keep running, to shed tracking load when an app needs the CPU.
+ * The camera keeps streaming, only the trackers stop getting frames. While
+ * SLAM is off the device keeps its last known position.
+ *
+ * Supported in version 1.6 and above.
+ *
+ * @param root The libmonado state.
+ * @param device_index Index of device to change.
+ * @param feature Which tracking to change.
+ * @param enabled Turn it on or off.
+ *
+ * @return MND_SUCCESS on success, MND_ERROR_FEATURE_NOT_SUPPORTED if the
+ *         device doesn't have the tracking.
+ */
+mnd_result_t
+mnd_root_set_device_feature_enabled(mnd_root_t *root,
+                                    uint32_t device_index,
+                                    mnd_device_feature_t feature,
+                                    bool enabled);
+
 
 #ifdef __cplusplus
 }
@@ -124,6 +124,35 @@ class Monado:
 
         self.client_count = self.client_count_ptr[0]
 
+    def update_snapshot(self):
+        ret = self.lib.mnd_root_snapshot(self.root)
+        if ret != 0:
+            raise Exception("Could not get snapshot")
+
+        ret = self.lib.mnd_root_get_number_clients(self.root, self.client_count_ptr)
+        if ret != 0:
+            raise Exception("Could not get snapshot")
+
+        self.client_count = self.client_count_ptr[0]
+
+    def subscribe_events(self):
+        fd = self.ffi.new("int *")
+        ret = self.lib.mnd_root_subscribe_events(self.root, fd)
+        if ret != 0:
+            raise Exception("Could not subscribe to events")
+        return fd[0]
+
+    def read_events(self):
+        events = []
+        event = self.ffi.new("mnd_event_t *")
+        while True:
+            ret = self.lib.mnd_root_read_event(self.root, event)
+            if ret != 0:
+                raise Exception("Could not read event")
+            if event.type == self.lib.MND_EVENT_NONE:
+                return events
+            events.append((event.type, event.client_id))
+
     def get_client_id_at_index(self, index):
         ret = self.lib.mnd_root_get_client_id_at_index(self.root, index, self.client_id_ptr)
         if ret != 0:
@@ -178,6 +207,25 @@ class Monado:
         if ret != 0:
             raise Exception(f"Failed to toggle io for client id {client_id}.")
 
+    def get_frame_stats(self):
+        stats = self.ffi.new("mnd_frame_stats_t *")
+        ret = self.lib.mnd_root_get_frame_stats(self.root, stats)
+        if ret != 0:
+            raise Exception("Could not get frame stats")
+        return stats[0]
+
+    def get_device_call_stats(self, index):
+        calls = self.ffi.new("mnd_call_stats_t[]", self.lib.MND_DEVICE_CALL_COUNT)
+        ret = self.lib.mnd_root_get_device_call_stats(self.root, index, calls)
+        if ret != 0:
+            raise Exception(f"Could not get call stats for device at index:{index}")
+        return [calls[i] for i in range(self.lib.MND_DEVICE_CALL_COUNT)]
+
+    def set_device_feature_enabled(self, index, feature, enabled: bool):
+        ret = self.lib.mnd_root_set_device_feature_enabled(self.root, index, feature, enabled)
+        if ret != 0:
+            raise Exception(f"Could not set feature {feature} for device at index:{index}")
+
     def get_device_count(self):
         ret = self.lib.mnd_root_get_device_count(self.root, self.device_count_ptr)
         if ret != 0:
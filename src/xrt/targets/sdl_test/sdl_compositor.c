@@ -252,8 +252,8 @@ compositor_init_sys_info(struct sdl_compositor *c, struct sdl_program *sp, struc
 {
 	struct xrt_system_compositor_info *sys_info = &c->sys_info;
 
-	// Required by OpenXR spec.
-	sys_info->max_layers = 16;
+	// Required by OpenXR spec to be at least 16.
+	sys_info->max_layers = XRT_MAX_LAYERS;
 
 	// UUIDs and LUID already set in vk init.
 	(void)sys_info->compositor_vk_deviceUUID;
@@ -264,8 +264,10 @@ compositor_init_sys_info(struct sdl_compositor *c, struct sdl_program *sp, struc
 	// Get window size and set recommended size to it.
 	const int min = 128;
 	const int max = 16 * 1024;
-	int w = 0, h = 0;
-	SDL_GetWindowSize(sp->win, &w, &h);
+	int w = 1920, h = 1080;
+	if (!sp->headless) {
+		SDL_GetWindowSize(sp->win, &w, &h);
+	}
 	if (w <= min || h <= min) {
 		U_LOG_W("Window size is %ix%i which is smaller then %ix%i upping size.", w, h, min, min);
 		w = min;
@@ -566,5 +568,5 @@ sdl_compositor_create_system(struct sdl_program *sp, struct xrt_system_composito
 	XRT_MAYBE_UNUSED xrt_result_t xret = u_pa_factory_create(&upaf);
 	assert(xret == XRT_SUCCESS && upaf != NULL);
 
-	return comp_multi_create_system_compositor(&sp->c.base.base, upaf, &sp->c.sys_info, false, out_xsysc);
+	return comp_multi_create_system_compositor(&sp->c.base.base, upaf, &sp->c.sys_info, NULL, false, out_xsysc);
 }
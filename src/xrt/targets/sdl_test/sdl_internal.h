@@ -164,7 +164,15 @@ struct sdl_program
 		} left, right;
 	} state;
 
-	//! The main window.
+	/*!
+	 * No window or OpenGL context, swapchains are not imported into OpenGL
+	 * and nothing is rendered. Lets the target be used to measure the
+	 * overhead of the state tracker, IPC and compositor on machines without
+	 * a display, set with `SDL_TEST_HEADLESS`.
+	 */
+	bool headless;
+
+	//! The main window, NULL if @ref headless.
 	SDL_Window *win;
 
 	//! Main OpenGL context.
@@ -10,10 +10,14 @@
 #include "ogl/ogl_api.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 
 #include "sdl_internal.hpp"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(sdl_test_headless, "SDL_TEST_HEADLESS", false)
+
+
 void
 sdl_create_window(struct sdl_program *sp)
 {
@@ -61,7 +65,13 @@ sdl_create_window(struct sdl_program *sp)
 
 	// Make the context current in this thread for loading OpenGL.
 	sdl_make_current(sp);
-	SDL_GL_SetSwapInterval(1); // Enable vsync
+
+	/*
+	 * Rendering happens in layer_commit on the compositor thread, the pacer
+	 * decides when frames happen. Waiting for vsync there would stall that
+	 * thread for up to a frame behind the pacer's back.
+	 */
+	SDL_GL_SetSwapInterval(0);
 
 	// Setup OpenGL bindings.
 	bool err = gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress) == 0;
@@ -84,9 +94,12 @@ sdl_program_plus_create()
 	// Initial state.
 	spp.log_level = U_LOGGING_INFO;
 	spp.state.head.pose = XRT_POSE_IDENTITY;
+	spp.headless = debug_get_bool_option_sdl_test_headless();
 
 	// Create the window, init before sub components.
-	sdl_create_window(&spp);
+	if (!spp.headless) {
+		sdl_create_window(&spp);
+	}
 
 	// Init sub components.
 	sdl_instance_init(&spp);
@@ -103,6 +116,10 @@ sdl_program_plus_render(struct sdl_program_plus *spp_ptr)
 {
 	auto &spp = *spp_ptr;
 
+	if (spp.headless) {
+		return;
+	}
+
 	// Make context current
 	sdl_make_current(&spp);
 
@@ -20,6 +20,15 @@ post_init_setup(struct sdl_swapchain *ssc, struct sdl_program *sp, const struct
 {
 	ST_DEBUG(sp, "CREATE");
 
+	// Setup fields
+	ssc->sp = sp;
+
+	if (sp->headless) {
+		ssc->w = (int)info->width;
+		ssc->h = (int)info->height;
+		return;
+	}
+
 	sdl_make_current(sp);
 
 	struct ogl_import_results results = XRT_STRUCT_INIT;
@@ -33,8 +42,6 @@ post_init_setup(struct sdl_swapchain *ssc, struct sdl_program *sp, const struct
 
 	sdl_make_uncurrent(sp);
 
-	// Setup fields
-	ssc->sp = sp;
 	ssc->w = (int)results.width;
 	ssc->h = (int)results.height;
 
@@ -52,18 +59,18 @@ really_destroy(struct comp_swapchain *sc)
 
 	ST_DEBUG(sp, "DESTROY");
 
-	sdl_make_current(sp);
-
 	uint32_t image_count = ssc->base.base.base.image_count;
-	if (image_count > 0) {
+	if (image_count > 0 && !sp->headless) {
+		sdl_make_current(sp);
+
 		glDeleteTextures(image_count, ssc->textures);
 		glDeleteMemoryObjectsEXT(image_count, ssc->memory);
 
 		U_ZERO_ARRAY(ssc->textures);
 		U_ZERO_ARRAY(ssc->memory);
-	}
 
-	sdl_make_uncurrent(sp);
+		sdl_make_uncurrent(sp);
+	}
 
 	// Teardown the base swapchain, freeing all Vulkan resources.
 	comp_swapchain_teardown(sc);
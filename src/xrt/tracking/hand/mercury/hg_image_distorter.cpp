@@ -1,4 +1,4 @@
-// Copyright 2021-2022, Collabora, Ltd.
+// Copyright 2021-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -8,6 +8,7 @@
  */
 
 #include <cmath>
+#include <cstring>
 #include <opencv2/core.hpp>
 #include <stdio.h>
 
@@ -27,6 +28,7 @@
 
 #include "tracking/t_calibration_opencv.hpp"
 #include <iostream>
+#include <memory>
 #include <opencv2/opencv.hpp>
 
 #include "math/m_eigen_interop.hpp"
@@ -36,6 +38,10 @@
 namespace xrt::tracking::hand::mercury {
 
 constexpr int wsize = 128;
+static_assert(wsize == kKeypointInputSize);
+
+// How far, in output pixels, a ROI may be from the cached grid for the grid to be reused.
+constexpr float kGridReuseMaxShiftPx = 0.25f;
 
 template <typename T> using OutputSizedArray = Eigen::Array<T, wsize, wsize, Eigen::RowMajor>;
 using OutputSizedFloatArray = OutputSizedArray<float>;
@@ -63,6 +69,15 @@ struct ArrayStack
 	}
 };
 
+// Too big for the stack and too slow to allocate per projection, kept per thread instead.
+struct projection_scratch
+{
+	ArrayStack stack = {};
+
+	// Used when the caller doesn't give a cache.
+	projection_grid_cache grid = {};
+};
+
 struct projection_state
 {
 	cv::Mat &input;
@@ -71,13 +86,18 @@ struct projection_state
 
 	const projection_instructions &instructions;
 
-	ArrayStack stack = {};
+	ArrayStack &stack;
 
-	OutputSizedArray<int16_t> image_x = {};
-	OutputSizedArray<int16_t> image_y = {};
+	OutputSizedArray<int16_t> &image_x;
+	OutputSizedArray<int16_t> &image_y;
 
-	projection_state(const projection_instructions &instructions, cv::Mat &input, cv::Mat &output)
-	    : input(input), distorted_image_eigen(output.data, 128, 128), instructions(instructions){};
+	projection_state(const projection_instructions &instructions,
+	                 cv::Mat &input,
+	                 cv::Mat &output,
+	                 ArrayStack &stack,
+	                 projection_grid_cache &grid)
+	    : input(input), distorted_image_eigen(output.data, 128, 128), instructions(instructions), stack(stack),
+	      image_x(grid.image_x), image_y(grid.image_y){};
 };
 
 
@@ -154,14 +174,20 @@ map_ranges(T value, T from_low, T from_high, T to_low, T to_high)
 	return (value - from_low) * (to_high - to_low) / (from_high - from_low) + to_low;
 }
 
+// Also sums up the output pixels and their squares, so normalizing doesn't need its own passes.
 void
 naive_remap(OutputSizedArray<int16_t> &image_x,
             OutputSizedArray<int16_t> &image_y,
             cv::Mat &input,
-            Eigen::Map<OutputSizedArray<uint8_t>> &output)
+            Eigen::Map<OutputSizedArray<uint8_t>> &output,
+            uint64_t &out_sum,
+            uint64_t &out_sum_sq)
 {
 	output = 0;
 
+	uint64_t sum = 0;
+	uint64_t sum_sq = 0;
+
 	for (int y = 0; y < wsize; y++) {
 		for (int x = 0; x < wsize; x++) {
 			if (image_y(y, x) < 0) {
@@ -176,18 +202,79 @@ naive_remap(OutputSizedArray<int16_t> &image_x,
 			if (image_x(y, x) >= input.cols) {
 				continue;
 			}
-			output(y, x) = input.at<uint8_t>(image_y(y, x), image_x(y, x));
+			uint8_t v = input.at<uint8_t>(image_y(y, x), image_x(y, x));
+			output(y, x) = v;
+			sum += v;
+			sum_sq += v * v;
 		}
 	}
+
+	out_sum = sum;
+	out_sum_sq = sum_sq;
 }
 
+/*!
+ * Same result as normalizeGrayscaleImage in hg_model.cpp: scale to a standard deviation of 0.25, then shift to a mean
+ * of 0.5. Done in one pass with the sums from naive_remap.
+ */
+static bool
+normalize_remapped(const cv::Mat &in, uint64_t sum, uint64_t sum_sq, float *out)
+{
+	constexpr uint64_t n = wsize * wsize;
 
+	// n^2 times the variance, exact in integers so a flat image is always caught.
+	uint64_t n2_var = n * sum_sq - sum * sum;
+
+	if (n2_var == 0) {
+		U_LOG_W("Got image with zero standard deviation!");
+		for (uint64_t i = 0; i < n; i++) {
+			out[i] = in.data[i] * (1 / 255.0f);
+		}
+		return false;
+	}
+
+	double mean = (double)sum / n;
+	double stddev = sqrt((double)n2_var) / n;
+
+	float scale = (float)(0.25 / stddev);
+	float offset = (float)(0.5 - mean * (0.25 / stddev));
+
+	for (uint64_t i = 0; i < n; i++) {
+		out[i] = in.data[i] * scale + offset;
+	}
+
+	return true;
+}
+
+static bool
+grid_cache_matches(const projection_grid_cache &cache,
+                   const t_camera_model_params &dist,
+                   const projection_instructions &instructions)
+{
+	float r = instructions.stereographic_radius;
+
+	if (!cache.valid || cache.flip != instructions.flip || r <= 0 ||
+	    memcmp(&cache.dist, &dist, sizeof(dist)) != 0) {
+		return false;
+	}
+
+	// Near the center a rotation by theta moves stereographic coordinates by about theta / 2, and one output
+	// pixel is 2r / wsize of those.
+	float rotation_px = cache.rot_quat.angularDistance(instructions.rot_quat) * wsize / (4 * r);
+
+	// A change in radius moves the edges the most, by half the window times the relative change.
+	float scale_px = fabsf(cache.stereographic_radius - r) / r * (wsize / 2);
+
+	return rotation_px + scale_px < kGridReuseMaxShiftPx;
+}
 
 void
 StereographicDistort(projection_state &mi)
 {
 	XRT_TRACE_MARKER();
 
+	mi.stack.dropAll();
+
 	OutputSizedFloatArray &sg_x = mi.stack.get();
 	OutputSizedFloatArray &sg_y = mi.stack.get();
 
@@ -295,8 +382,6 @@ StereographicDistort(projection_state &mi)
 
 	mi.image_x = image_x_f.cast<int16_t>();
 	mi.image_y = image_y_f.cast<int16_t>();
-
-	naive_remap(mi.image_x, mi.image_y, mi.input, mi.distorted_image_eigen);
 }
 
 
@@ -598,26 +683,59 @@ make_projection_instructions_angular(xrt_vec3 direction_3d,
 }
 
 
-void
+bool
 stereographic_project_image(const t_camera_model_params &dist,
-                            const projection_instructions &instructions,
+                            projection_instructions &instructions,
                             cv::Mat &input_image,
                             cv::Mat *debug_image,
                             const cv::Scalar boundary_color,
-                            cv::Mat &out)
+                            projection_grid_cache *grid_cache,
+                            cv::Mat &out,
+                            float *out_normalized)
 
 {
+	static thread_local std::unique_ptr<projection_scratch> scratch;
+	if (!scratch) {
+		scratch = std::make_unique<projection_scratch>();
+	}
+
 	out = cv::Mat(cv::Size(wsize, wsize), CV_8U);
-	projection_state *mi_ptr = new projection_state(instructions, input_image, out);
-	projection_state &mi = *mi_ptr;
+
+	bool reuse = grid_cache != nullptr && grid_cache_matches(*grid_cache, dist, instructions);
+	projection_grid_cache &grid = grid_cache != nullptr ? *grid_cache : scratch->grid;
+
+	if (reuse) {
+		// Snap to the cached grid, so the model outputs are read back in the space they were made in.
+		instructions.rot_quat = grid.rot_quat;
+		instructions.stereographic_radius = grid.stereographic_radius;
+	}
+
+	projection_state mi(instructions, input_image, out, scratch->stack, grid);
 
 	mi.dist = dist;
 
-	StereographicDistort(mi);
+	if (!reuse) {
+		StereographicDistort(mi);
+
+		grid.valid = true;
+		grid.rot_quat = instructions.rot_quat;
+		grid.stereographic_radius = instructions.stereographic_radius;
+		grid.flip = instructions.flip;
+		grid.dist = dist;
+	}
+
+	uint64_t sum = 0;
+	uint64_t sum_sq = 0;
+	naive_remap(mi.image_x, mi.image_y, mi.input, mi.distorted_image_eigen, sum, sum_sq);
 
 	if (debug_image) {
 		draw_boundary(mi, boundary_color, *debug_image);
 	}
-	delete mi_ptr;
+
+	if (out_normalized == nullptr) {
+		return true;
+	}
+
+	return normalize_remapped(out, sum, sum_sq, out_normalized);
 }
 } // namespace xrt::tracking::hand::mercury
@@ -26,6 +26,30 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
                                     struct t_hand_tracking_create_info create_info,
                                     const char *models_folder);
 
+/*!
+ * Where the time of the last processed frame went, for benchmarking.
+ *
+ * @ingroup aux_tracking
+ */
+struct hg_frame_timing
+{
+	uint64_t frame_timestamp_ns; //!< Timestamp of the left frame
+	uint64_t detection_ns;       //!< Hand detection model, zero if it didn't run this frame
+	uint64_t keypoint_ns;        //!< Keypoint estimation model for all regions of interest
+	uint64_t optimizer_ns;       //!< Kinematic optimizer for both hands
+	uint64_t total_ns;           //!< All of the process call
+	uint32_t keypoint_count;     //!< Regions of interest the keypoint model ran on
+};
+
+/*!
+ * Get the timing of the last frame processed by a Mercury hand tracker, only
+ * valid from the thread calling process and only until the next call.
+ *
+ * @ingroup aux_tracking
+ */
+void
+t_hand_tracking_sync_mercury_get_frame_timing(struct t_hand_tracking_sync *ht_sync, struct hg_frame_timing *out_timing);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -16,9 +16,14 @@
 
 #include <filesystem>
 #include <array>
+#include <cstring>
+#include <sstream>
+#include <string>
 
 namespace xrt::tracking::hand::mercury {
 
+DEBUG_GET_ONCE_OPTION(mercury_execution_providers, "MERCURY_EXECUTION_PROVIDERS", NULL)
+
 #define ORT(expr)                                                                                                      \
 	do {                                                                                                           \
 		OrtStatus *status = wrap->api->expr;                                                                   \
@@ -263,6 +268,69 @@ normalizeGrayscaleImage(cv::Mat &data_in, cv::Mat &data_out)
 	return true;
 }
 
+/*!
+ * Appends the execution providers listed in MERCURY_EXECUTION_PROVIDERS, comma separated and most preferred first.
+ * ORT runs whatever the providers can't on the CPU. A provider our ORT wasn't built with is skipped with a warning.
+ */
+static void
+append_execution_providers(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts, int num_threads)
+{
+	const char *providers = debug_get_option_mercury_execution_providers();
+	if (providers == NULL) {
+		return;
+	}
+
+	std::string threads = std::to_string(num_threads);
+	std::stringstream ss(providers);
+	std::string name;
+
+	while (std::getline(ss, name, ',')) {
+		if (name.empty()) {
+			continue;
+		}
+
+		OrtStatus *status = nullptr;
+
+		if (name == "cuda") {
+			OrtCUDAProviderOptionsV2 *cuda = nullptr;
+			status = wrap->api->CreateCUDAProviderOptions(&cuda);
+			if (status == nullptr) {
+				status = wrap->api->SessionOptionsAppendExecutionProvider_CUDA_V2(opts, cuda);
+				wrap->api->ReleaseCUDAProviderOptions(cuda);
+			}
+		} else if (name == "tensorrt") {
+			OrtTensorRTProviderOptionsV2 *tensorrt = nullptr;
+			status = wrap->api->CreateTensorRTProviderOptions(&tensorrt);
+			if (status == nullptr) {
+				status = wrap->api->SessionOptionsAppendExecutionProvider_TensorRT_V2(opts, tensorrt);
+				wrap->api->ReleaseTensorRTProviderOptions(tensorrt);
+			}
+		} else if (name == "qnn") {
+			// The HTP backend is the NPU on Snapdragon SoCs.
+			const char *keys[] = {"backend_path"};
+			const char *values[] = {"libQnnHtp.so"};
+			status = wrap->api->SessionOptionsAppendExecutionProvider(opts, "QNN", keys, values, 1);
+		} else if (name == "xnnpack") {
+			// XNNPACK has its own thread pool, give it the threads the session would have used.
+			const char *keys[] = {"intra_op_num_threads"};
+			const char *values[] = {threads.c_str()};
+			status = wrap->api->SessionOptionsAppendExecutionProvider(opts, "XNNPACK", keys, values, 1);
+		} else {
+			// Let ORT decide if it knows the name, like "SNPE" or "CoreML".
+			status = wrap->api->SessionOptionsAppendExecutionProvider(opts, name.c_str(), nullptr, nullptr, 0);
+		}
+
+		if (status != nullptr) {
+			HG_WARN(hgt, "Could not add execution provider '%s': %s", name.c_str(),
+			        wrap->api->GetErrorMessage(status));
+			wrap->api->ReleaseStatus(status);
+			continue;
+		}
+
+		HG_DEBUG(hgt, "Added execution provider '%s'", name.c_str());
+	}
+}
+
 void
 setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path)
 {
@@ -273,6 +341,7 @@ setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path)
 
 	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
 	ORT(SetIntraOpNumThreads(opts, 1));
+	append_execution_providers(hgt, wrap, opts, 1);
 
 	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
 
@@ -449,6 +518,7 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 	// TODO review options, config for threads?
 	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
 	ORT(SetIntraOpNumThreads(opts, 1));
+	append_execution_providers(hgt, wrap, opts, 1);
 
 
 	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
@@ -633,25 +703,22 @@ set_predicted_zero(float *data)
 	}
 }
 
-void
-run_keypoint_estimation(void *ptr)
+static void
+keypoint_estimation_prepare(keypoint_estimation_run_info &info,
+                            float *input_img,
+                            float *input_last_keypoints,
+                            float *input_use_last_keypoints)
 {
 	XRT_TRACE_MARKER();
-	keypoint_estimation_run_info info = *(keypoint_estimation_run_info *)ptr;
 
-	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
 	struct HandTracking *hgt = info.view->hgt;
 
 	int view_idx = info.view->view;
 	int hand_idx = info.hand_idx;
 	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
-	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
-	// Factor out starting here
 
 	hand_region_of_interest &output = info.view->regions_of_interest_this_frame[hand_idx];
 
-	cv::Mat data_128x128_uint8;
-
 	projection_instructions instr(info.view->hgdist);
 	instr.rot_quat = Eigen::Quaternionf::Identity();
 	instr.stereographic_radius = 0.4;
@@ -709,8 +776,8 @@ run_keypoint_estimation(void *ptr)
 		make_projection_instructions_angular(center, hand_idx, angle,
 		                                     hgt->tuneable_values.after_detection_fac.val, twist, instr);
 
-		wrap->wraps[2].data[0] = 0.0f;
-		set_predicted_zero(wrap->wraps[1].data);
+		input_use_last_keypoints[0] = 0.0f;
+		set_predicted_zero(input_last_keypoints);
 	} else {
 		Eigen::Array<float, 3, 21> keypoints_in_camera;
 
@@ -736,66 +803,46 @@ run_keypoint_estimation(void *ptr)
 
 		if (hgt->tuneable_values.enable_pose_predicted_input) {
 			for (int ml_joint_idx = 0; ml_joint_idx < 21; ml_joint_idx++) {
-				float *data = wrap->wraps[1].data;
+				float *data = input_last_keypoints;
 				data[(ml_joint_idx * 2) + 0] = bleh[ml_joint_idx].pos_2d.x;
 				data[(ml_joint_idx * 2) + 1] = bleh[ml_joint_idx].pos_2d.y;
 				// data[(ml_joint_idx * 2) + 2] = bleh[ml_joint_idx].depth_relative_to_midpxm;
 			}
 
 
-			wrap->wraps[2].data[0] = 1.0f;
+			input_use_last_keypoints[0] = 1.0f;
 		} else {
-			wrap->wraps[2].data[0] = 0.0f;
-			set_predicted_zero(wrap->wraps[1].data);
+			input_use_last_keypoints[0] = 0.0f;
+			set_predicted_zero(input_last_keypoints);
 		}
 	}
 
-	stereographic_project_image(dist, instr, hgt->views[view_idx].run_model_on_this,
-	                            &hgt->views[view_idx].debug_out_to_this, info.hand_idx ? RED : YELLOW,
-	                            data_128x128_uint8);
+	// Writes the normalized model input directly.
+	info.is_hand = stereographic_project_image(dist, instr, hgt->views[view_idx].run_model_on_this,
+	                                           &hgt->views[view_idx].debug_out_to_this,
+	                                           info.hand_idx ? RED : YELLOW, &info.grid_cache,
+	                                           info.data_128x128_uint8, input_img);
 
 
 	xrt::auxiliary::math::map_quat(this_output.look_dir) = instr.rot_quat;
 	this_output.stereographic_radius = instr.stereographic_radius;
+}
 
-	bool is_hand = true;
-
-	{
-		XRT_TRACE_IDENT(convert_format);
-
-		// here!
-		cv::Mat data_128x128_float(cv::Size(128, 128), CV_32FC1, wrap->wraps[0].data, 128 * sizeof(float));
-
-		is_hand = is_hand && normalizeGrayscaleImage(data_128x128_uint8, data_128x128_float);
-	}
-
-
-	// Ending here
-
-
-	const OrtValue *inputs[] = {wrap->wraps[0].tensor, wrap->wraps[1].tensor, wrap->wraps[2].tensor};
-	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
-
-	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
-	const char *output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
-
-	{
-		XRT_TRACE_IDENT(model);
-		assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
-		assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
-		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
-		        ARRAY_SIZE(output_names), output_tensors));
-	}
-
-	// To here
-
-	// Interpret model outputs!
-
-
-	float *out_data = nullptr;
+static void
+keypoint_estimation_interpret(keypoint_estimation_run_info &info,
+                              float *out_data,
+                              float *out_data_depth,
+                              float *out_data_extras,
+                              float *out_data_curls)
+{
+	XRT_TRACE_MARKER();
 
+	struct HandTracking *hgt = info.view->hgt;
 
-	ORT(GetTensorMutableData(output_tensors[0], (void **)&out_data));
+	int view_idx = info.view->view;
+	int hand_idx = info.hand_idx;
+	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
+	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
 
 	// I don't know why this was added
 	// float *confidences = info.view->keypoint_outputs.views[hand_idx].confidences;
@@ -839,8 +886,6 @@ run_keypoint_estimation(void *ptr)
 	}
 
 
-	float *out_data_depth = nullptr;
-	ORT(GetTensorMutableData(output_tensors[1], (void **)&out_data_depth));
 
 	for (int joint_idx = 0; joint_idx < 21; joint_idx++) {
 		float *p_ptr = &out_data_depth[(joint_idx * 22)];
@@ -860,9 +905,6 @@ run_keypoint_estimation(void *ptr)
 		}
 	}
 
-	float *out_data_extras = nullptr;
-	ORT(GetTensorMutableData(output_tensors[2], (void **)&out_data_extras));
-
 	float is_hand_explicit = out_data_extras[0];
 
 	is_hand_explicit = (1.0) / (1.0 + powf(2.71828182845904523536, -is_hand_explicit));
@@ -872,14 +914,11 @@ run_keypoint_estimation(void *ptr)
 	// North Star seemed to need 0.97.
 	if (is_hand_explicit < 0.97) {
 		U_LOG_D("Not hand! %f", is_hand_explicit);
-		is_hand = false;
+		info.is_hand = false;
 	}
 
-	this_output.active = is_hand;
-
+	this_output.active = info.is_hand;
 
-	float *out_data_curls = nullptr;
-	ORT(GetTensorMutableData(output_tensors[3], (void **)&out_data_curls));
 
 	for (int i = 0; i < 5; i++) {
 		float curl = out_data_curls[i];
@@ -905,7 +944,7 @@ run_keypoint_estimation(void *ptr)
 
 		cv::Rect p = cv::Rect(root_x, root_y, 128, 128);
 
-		data_128x128_uint8.copyTo(hgt->visualizers.mat(p));
+		info.data_128x128_uint8.copyTo(hgt->visualizers.mat(p));
 
 		make_keypoint_heatmap_output(info.view->view, hand_idx, 0, 0, out_data + (data_acc_idx * plane_size),
 		                             hgt->visualizers.mat);
@@ -965,15 +1004,241 @@ run_keypoint_estimation(void *ptr)
 			cv::line(hgt->visualizers.mat, center, pt2, {0}, 1);
 		}
 	}
+}
+
+void
+run_keypoint_estimation(void *ptr)
+{
+	XRT_TRACE_MARKER();
+	keypoint_estimation_run_info &info = *(keypoint_estimation_run_info *)ptr;
+
+	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
+	struct HandTracking *hgt = info.view->hgt;
+
+	keypoint_estimation_prepare(info, wrap->wraps[0].data, wrap->wraps[1].data, wrap->wraps[2].data);
+
+	const OrtValue *inputs[] = {wrap->wraps[0].tensor, wrap->wraps[1].tensor, wrap->wraps[2].tensor};
+	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
+
+	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
+	const char *output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
+
+	{
+		XRT_TRACE_IDENT(model);
+		assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
+		assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
+		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
+		        ARRAY_SIZE(output_names), output_tensors));
+	}
+
+	float *out[ARRAY_SIZE(output_tensors)] = {};
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&out[i]));
+	}
+
+	keypoint_estimation_interpret(info, out[0], out[1], out[2], out[3]);
+
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		wrap->api->ReleaseValue(output_tensors[i]);
+	}
+}
+
+static size_t
+batch_item_size(const model_input_wrap &input)
+{
+	size_t size = 1;
+	for (size_t i = 1; i < input.num_dimensions; i++) {
+		size *= input.dimensions[i];
+	}
+	return size;
+}
+
+bool
+init_keypoint_estimation_batched(HandTracking *hgt, onnx_wrap *wrap, int num_threads)
+{
+	std::filesystem::path path = hgt->models_folder;
+
+	path /= "grayscale_keypoint_jan18.onnx";
+
+	wrap->wraps.clear();
+
+	wrap->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+
+	OrtSessionOptions *opts = nullptr;
+	ORT(CreateSessionOptions(&opts));
+
+	// This one session does the work of the four per view and hand ones, give it their threads.
+	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
+	ORT(SetIntraOpNumThreads(opts, num_threads));
+	append_execution_providers(hgt, wrap, opts, num_threads);
+
+	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
+
+	ORT(CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &wrap->meminfo));
+
+	ORT(CreateSession(wrap->env, path.c_str(), opts, &wrap->session));
+	assert(wrap->session != NULL);
+
+	wrap->api->ReleaseSessionOptions(opts);
+
+	// Only a model exported with a dynamic first dimension on all inputs can be batched.
+	size_t input_count = 0;
+	ORT(SessionGetInputCount(wrap->session, &input_count));
+
+	bool dynamic_batch = input_count == 3;
+	for (size_t i = 0; i < input_count && dynamic_batch; i++) {
+		OrtTypeInfo *type_info = nullptr;
+		const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+		int64_t dims[4] = {};
+		size_t dim_count = 0;
+
+		ORT(SessionGetInputTypeInfo(wrap->session, i, &type_info));
+		ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+		ORT(GetDimensionsCount(tensor_info, &dim_count));
+		if (dim_count > 0 && dim_count <= ARRAY_SIZE(dims)) {
+			ORT(GetDimensions(tensor_info, dims, dim_count));
+		}
+
+		// Dynamic dimensions are reported as -1.
+		dynamic_batch = dims[0] < 0;
+
+		wrap->api->ReleaseTypeInfo(type_info);
+	}
+
+	if (!dynamic_batch) {
+		HG_INFO(hgt, "Keypoint model has a fixed batch size, running one session per view and hand.");
+		release_onnx_wrap(wrap);
+		*wrap = {};
+		return false;
+	}
+
+	// Room for all ROIs of a frame, the tensors are made per run as the batch size changes.
+	model_input_wrap inputimg = {};
+	inputimg.name = "inputImg";
+	inputimg.dimensions[0] = kKeypointMaxBatchSize;
+	inputimg.dimensions[1] = 1;
+	inputimg.dimensions[2] = kKeypointInputSize;
+	inputimg.dimensions[3] = kKeypointInputSize;
+	inputimg.num_dimensions = 4;
+
+	model_input_wrap last_keypoints = {};
+	last_keypoints.name = "lastKeypoints";
+	last_keypoints.dimensions[0] = kKeypointMaxBatchSize;
+	last_keypoints.dimensions[1] = 42;
+	last_keypoints.num_dimensions = 2;
+
+	model_input_wrap use_last_keypoints = {};
+	use_last_keypoints.name = "useLastKeypoints";
+	use_last_keypoints.dimensions[0] = kKeypointMaxBatchSize;
+	use_last_keypoints.num_dimensions = 1;
+
+	for (model_input_wrap *input : {&inputimg, &last_keypoints, &use_last_keypoints}) {
+		input->data = (float *)calloc(kKeypointMaxBatchSize * batch_item_size(*input), sizeof(float));
+		wrap->wraps.push_back(*input);
+	}
+
+	HG_INFO(hgt, "Running the keypoint model batched with %d threads.", num_threads);
+
+	return true;
+}
+
+static void
+run_keypoint_estimation_prepare_batched(void *ptr)
+{
+	keypoint_estimation_run_info &info = *(keypoint_estimation_run_info *)ptr;
+	std::vector<model_input_wrap> &wraps = info.view->hgt->keypoint_batched.wraps;
+	size_t idx = info.batch_idx;
+
+	keypoint_estimation_prepare(info,                                              //
+	                            wraps[0].data + (idx * batch_item_size(wraps[0])), //
+	                            wraps[1].data + (idx * batch_item_size(wraps[1])), //
+	                            wraps[2].data + (idx * batch_item_size(wraps[2])));
+}
+
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info **infos, int count)
+{
+	XRT_TRACE_MARKER();
+
+	onnx_wrap *wrap = &hgt->keypoint_batched;
+
+	assert(count > 0 && count <= kKeypointMaxBatchSize);
+
+	// The stereographic projections are most of the pre-processing, still spread them over the pool.
+	for (int i = 0; i < count; i++) {
+		infos[i]->batch_idx = i;
+		u_worker_group_push(hgt->group, run_keypoint_estimation_prepare_batched, infos[i]);
+	}
+	u_worker_group_wait_all(hgt->group);
+
+	OrtValue *input_tensors[] = {nullptr, nullptr, nullptr};
+	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
+
+	for (size_t i = 0; i < ARRAY_SIZE(input_tensors); i++) {
+		model_input_wrap &input = wrap->wraps[i];
+
+		int64_t dimensions[4];
+		memcpy(dimensions, input.dimensions, sizeof(dimensions));
+		dimensions[0] = count;
+
+		ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                                  //
+		                                   input.data,                                     //
+		                                   count * batch_item_size(input) * sizeof(float), //
+		                                   dimensions,                                     //
+		                                   input.num_dimensions,                           //
+		                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,            //
+		                                   &input_tensors[i]));
+	}
+
+	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
+	const char *output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
+
+	{
+		XRT_TRACE_IDENT(model);
+		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(input_tensors));
+		static_assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
+		ORT(Run(wrap->session, nullptr, input_names, input_tensors, ARRAY_SIZE(input_names), output_names,
+		        ARRAY_SIZE(output_names), output_tensors));
+	}
+
+	float *out[ARRAY_SIZE(output_tensors)] = {};
+	size_t out_item_size[ARRAY_SIZE(output_tensors)] = {};
+
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		OrtTensorTypeAndShapeInfo *shape = nullptr;
+		size_t element_count = 0;
+
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&out[i]));
+		ORT(GetTensorTypeAndShape(output_tensors[i], &shape));
+		ORT(GetTensorShapeElementCount(shape, &element_count));
+		wrap->api->ReleaseTensorTypeAndShapeInfo(shape);
+
+		out_item_size[i] = element_count / count;
+	}
+
+	for (int k = 0; k < count; k++) {
+		keypoint_estimation_interpret(*infos[k],                       //
+		                              out[0] + (k * out_item_size[0]), //
+		                              out[1] + (k * out_item_size[1]), //
+		                              out[2] + (k * out_item_size[2]), //
+		                              out[3] + (k * out_item_size[3]));
+	}
 
 	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
 		wrap->api->ReleaseValue(output_tensors[i]);
 	}
+	for (size_t i = 0; i < ARRAY_SIZE(input_tensors); i++) {
+		wrap->api->ReleaseValue(input_tensors[i]);
+	}
 }
 
 void
 release_onnx_wrap(onnx_wrap *wrap)
 {
+	if (wrap->api == nullptr) {
+		return;
+	}
+
 	wrap->api->ReleaseMemoryInfo(wrap->meminfo);
 	wrap->api->ReleaseSession(wrap->session);
 	for (model_input_wrap &a : wrap->wraps) {
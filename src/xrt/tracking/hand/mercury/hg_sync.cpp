@@ -15,6 +15,7 @@
 #include "util/u_box_iou.hpp"
 #include "util/u_hand_tracking.h"
 #include "math/m_vec2.h"
+#include "os/os_time.h"
 #include "util/u_misc.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_frame.h"
@@ -30,6 +31,8 @@ namespace xrt::tracking::hand::mercury {
 DEBUG_GET_ONCE_LOG_OPTION(mercury_log, "MERCURY_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(mercury_optimize_hand_size, "MERCURY_optimize_hand_size", true)
 DEBUG_GET_ONCE_FLOAT_OPTION(mercury_min_detection_confidence, "MERCURY_MIN_DETECTION_CONFIDENCE", 0.3)
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_batch_keypoint, "MERCURY_BATCH_KEYPOINT", true)
+DEBUG_GET_ONCE_NUM_OPTION(mercury_keypoint_threads, "MERCURY_KEYPOINT_THREADS", 0)
 
 // Flags to tell state tracker that these are indeed valid joints
 static const enum xrt_space_relation_flags valid_flags_ht = (enum xrt_space_relation_flags)(
@@ -686,6 +689,8 @@ HandTracking::~HandTracking()
 	release_onnx_wrap(&this->views[1].keypoint[1]);
 	release_onnx_wrap(&this->views[1].detection);
 
+	release_onnx_wrap(&this->keypoint_batched);
+
 	u_worker_group_reference(&this->group, NULL);
 
 	t_stereo_camera_calibration_reference(&this->calib, NULL);
@@ -697,6 +702,46 @@ HandTracking::~HandTracking()
 	u_frame_times_widget_teardown(&this->ft_widget);
 }
 
+/*!
+ * Inputs and outputs of one kinematic optimizer run, so the two hands can be solved on different threads.
+ */
+struct hand_solve_info
+{
+	struct HandTracking *hgt;
+	int hand_idx;
+	bool run;
+
+	float smoothing_factor;
+	float reprojection_error_threshold;
+	bool optimize_hand_size;
+
+	struct xrt_hand_joint_set *put_in_set;
+	float out_hand_size;
+	float reprojection_error;
+};
+
+static void
+run_hand_solve(void *ptr)
+{
+	XRT_TRACE_MARKER();
+
+	struct hand_solve_info &solve = *(struct hand_solve_info *)ptr;
+	struct HandTracking *hgt = solve.hgt;
+	int hand_idx = solve.hand_idx;
+
+	lm::optimizer_run(hgt->kinematic_hands[hand_idx],                  //
+	                  hgt->keypoint_outputs[hand_idx],                 //
+	                  !hgt->last_frame_hand_detected[hand_idx],        //
+	                  solve.smoothing_factor,                          //
+	                  solve.optimize_hand_size,                        //
+	                  hgt->target_hand_size,                           //
+	                  hgt->refinement.hand_size_refinement_schedule_y, //
+	                  hgt->tuneable_values.amt_use_depth.val,          //
+	                  *solve.put_in_set,                               //
+	                  solve.out_hand_size,                             //
+	                  solve.reprojection_error);
+}
+
 void
 HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
                                struct xrt_frame *left_frame,
@@ -709,8 +754,13 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 	HandTracking *hgt = (struct HandTracking *)ht_sync;
 
+	uint64_t process_start_ns = os_monotonic_get_ns();
+
 	hgt->current_frame_timestamp = left_frame->timestamp;
 
+	hgt->frame_timing = {};
+	hgt->frame_timing.frame_timestamp_ns = left_frame->timestamp;
+
 	struct xrt_hand_joint_set *out_xrt_hands[2] = {out_left_hand, out_right_hand};
 
 
@@ -805,7 +855,9 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	// Every now and then if we're not already tracking both hands, try to detect new hands.
 	bool saw_both_hands_last_frame = hgt->last_frame_hand_detected[0] && hgt->last_frame_hand_detected[1];
 	if (!saw_both_hands_last_frame) {
+		uint64_t detection_start_ns = os_monotonic_get_ns();
 		dispatch_and_process_hand_detections(hgt);
+		hgt->frame_timing.detection_ns = os_monotonic_get_ns() - detection_start_ns;
 	}
 
 	stop_everything_if_hands_are_overlapping(hgt);
@@ -822,6 +874,10 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 
 	// Dispatch keypoint estimator neural nets
+	uint64_t keypoint_start_ns = os_monotonic_get_ns();
+	struct keypoint_estimation_run_info *batch[kKeypointMaxBatchSize];
+	int batch_count = 0;
+
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 		for (int view_idx = 0; view_idx < 2; view_idx++) {
 			if (!hgt->views[view_idx].regions_of_interest_this_frame[hand_idx].found) {
@@ -831,11 +887,23 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 			struct keypoint_estimation_run_info &inf = hgt->views[view_idx].run_info[hand_idx];
 			inf.view = &hgt->views[view_idx];
 			inf.hand_idx = hand_idx;
+			hgt->frame_timing.keypoint_count++;
+
+			if (hgt->keypoint_batched_enabled) {
+				batch[batch_count++] = &inf;
+				continue;
+			}
+
 			u_worker_group_push(hgt->group, hgt->keypoint_estimation_run_func,
 			                    &hgt->views[view_idx].run_info[hand_idx]);
 		}
 	}
+
+	if (batch_count > 0) {
+		run_keypoint_estimation_batched(hgt, batch, batch_count);
+	}
 	u_worker_group_wait_all(hgt->group);
+	hgt->frame_timing.keypoint_ns = os_monotonic_get_ns() - keypoint_start_ns;
 
 	// Spaghetti logic for optimizing hand size
 	bool any_hands_are_only_visible_in_one_view = false;
@@ -880,7 +948,9 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	int num_hands = 0;
 	float avg_hand_size = 0;
 
-	// Dispatch the optimizers!
+	// Set up the optimizers, they are independent per hand so both can run at the same time.
+	struct hand_solve_info solves[2] = {};
+
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 
 
@@ -919,12 +989,15 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 			}
 		}
 
-		struct xrt_hand_joint_set *put_in_set = out_xrt_hands[hand_idx];
-
-		lm::KinematicHandLM *hand = hgt->kinematic_hands[hand_idx];
+		struct hand_solve_info &solve = solves[hand_idx];
+		solve.hgt = hgt;
+		solve.hand_idx = hand_idx;
+		solve.run = true;
+		solve.put_in_set = out_xrt_hands[hand_idx];
+		solve.optimize_hand_size = optimize_hand_size;
 
-		float reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
-		float smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val;
+		solve.reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
+		solve.smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val;
 
 		if (hgt->last_frame_hand_detected[hand_idx]) {
 			if (hgt->tuneable_values.enable_framerate_based_smoothing) {
@@ -933,33 +1006,39 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 				uint64_t diff = now - one_before;
 				double diff_d = time_ns_to_s(diff);
-				smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val * (1 / 60.0f) / diff_d;
+				solve.smoothing_factor = hgt->tuneable_values.opt_smooth_factor.val * (1 / 60.0f) / diff_d;
 			}
 		} else {
-			reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
+			solve.reprojection_error_threshold = hgt->tuneable_values.max_reprojection_error.val;
 		}
+	}
 
+	// Dispatch the optimizers! The second hand goes to the pool while this thread does the first.
+	uint64_t optimizer_start_ns = os_monotonic_get_ns();
+	if (solves[0].run && solves[1].run) {
+		u_worker_group_push(hgt->group, run_hand_solve, &solves[1]);
+		run_hand_solve(&solves[0]);
+		u_worker_group_wait_all(hgt->group);
+	} else {
+		for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+			if (solves[hand_idx].run) {
+				run_hand_solve(&solves[hand_idx]);
+			}
+		}
+	}
+	hgt->frame_timing.optimizer_ns = os_monotonic_get_ns() - optimizer_start_ns;
 
+	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+		struct hand_solve_info &solve = solves[hand_idx];
+		if (!solve.run) {
+			continue;
+		}
 
-		float out_hand_size;
-
-		//!@todo optimize: We can have one of these on each thread
-		float reprojection_error;
-		lm::optimizer_run(hand,                                     //
-		                  hgt->keypoint_outputs[hand_idx],          //
-		                  !hgt->last_frame_hand_detected[hand_idx], //
-		                  smoothing_factor,
-		                  optimize_hand_size,                              //
-		                  hgt->target_hand_size,                           //
-		                  hgt->refinement.hand_size_refinement_schedule_y, //
-		                  hgt->tuneable_values.amt_use_depth.val,
-		                  *put_in_set,   //
-		                  out_hand_size, //
-		                  reprojection_error);
-
-
+		struct xrt_hand_joint_set *put_in_set = solve.put_in_set;
+		float out_hand_size = solve.out_hand_size;
+		float reprojection_error = solve.reprojection_error;
 
-		if (reprojection_error > reprojection_error_threshold) {
+		if (reprojection_error > solve.reprojection_error_threshold) {
 			HG_DEBUG(hgt, "Reprojection error above threshold!");
 			hgt->this_frame_hand_detected[hand_idx] = false;
 			continue;
@@ -1066,6 +1145,8 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 		xrt_frame_reference(&hgt->visualizers.xrtframe, NULL);
 	}
 
+	hgt->frame_timing.total_ns = os_monotonic_get_ns() - process_start_ns;
+
 	// done!
 }
 
@@ -1124,17 +1205,31 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	init_hand_detection(hgt, &hgt->views[0].detection);
 	init_hand_detection(hgt, &hgt->views[1].detection);
 
-	init_keypoint_estimation(hgt, &hgt->views[0].keypoint[0]);
-	init_keypoint_estimation(hgt, &hgt->views[0].keypoint[1]);
+	int num_threads = 4;
+
+	// One batched run for all ROIs if the model allows it, else one session per view and hand.
+	if (debug_get_bool_option_mercury_batch_keypoint()) {
+		int keypoint_threads = (int)debug_get_num_option_mercury_keypoint_threads();
+		if (keypoint_threads <= 0) {
+			keypoint_threads = num_threads;
+		}
+
+		hgt->keypoint_batched_enabled =
+		    init_keypoint_estimation_batched(hgt, &hgt->keypoint_batched, keypoint_threads);
+	}
+
+	if (!hgt->keypoint_batched_enabled) {
+		init_keypoint_estimation(hgt, &hgt->views[0].keypoint[0]);
+		init_keypoint_estimation(hgt, &hgt->views[0].keypoint[1]);
 
-	init_keypoint_estimation(hgt, &hgt->views[1].keypoint[0]);
-	init_keypoint_estimation(hgt, &hgt->views[1].keypoint[1]);
+		init_keypoint_estimation(hgt, &hgt->views[1].keypoint[0]);
+		init_keypoint_estimation(hgt, &hgt->views[1].keypoint[1]);
+	}
 	hgt->keypoint_estimation_run_func = xrt::tracking::hand::mercury::run_keypoint_estimation;
 
 	hgt->views[0].view = 0;
 	hgt->views[1].view = 1;
 
-	int num_threads = 4;
 	hgt->pool = u_worker_thread_pool_create(num_threads - 1, num_threads, "Hand Tracking");
 	hgt->group = u_worker_group_create(hgt->pool);
 
@@ -1266,3 +1361,11 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 
 	return &hgt->base;
 }
+
+extern "C" void
+t_hand_tracking_sync_mercury_get_frame_timing(struct t_hand_tracking_sync *ht_sync, struct hg_frame_timing *out_timing)
+{
+	HandTracking &hgt = HandTracking::fromC(ht_sync);
+
+	*out_timing = hgt.frame_timing;
+}
@@ -62,6 +62,8 @@ using namespace xrt::auxiliary::math;
 
 static constexpr uint16_t kDetectionInputSize = 160;
 static constexpr uint16_t kKeypointInputSize = 128;
+// Two hands in two views.
+static constexpr int kKeypointMaxBatchSize = 4;
 
 static constexpr uint16_t kKeypointOutputHeatmapSize = 22;
 static constexpr uint16_t kVisSpacerSize = 8;
@@ -191,10 +193,32 @@ struct hand_detection_run_info
 };
 
 
+// The remap grid of the last stereographic projection of one ROI, reused when the next ROI is close enough to it.
+struct projection_grid_cache
+{
+	bool valid = false;
+	Eigen::Quaternionf rot_quat = Eigen::Quaternionf::Identity();
+	float stereographic_radius = 0;
+	bool flip = false;
+	t_camera_model_params dist = {};
+
+	Eigen::Array<int16_t, kKeypointInputSize, kKeypointInputSize, Eigen::RowMajor> image_x;
+	Eigen::Array<int16_t, kKeypointInputSize, kKeypointInputSize, Eigen::RowMajor> image_y;
+};
+
 struct keypoint_estimation_run_info
 {
 	ht_view *view;
 	bool hand_idx;
+
+	// Which slot of the batched model inputs this ROI is written to, only used by the batched path.
+	int batch_idx;
+
+	// Written by the pre-processing, read when interpreting the model outputs.
+	cv::Mat data_128x128_uint8;
+	bool is_hand;
+
+	struct projection_grid_cache grid_cache;
 };
 
 struct ht_view
@@ -331,12 +355,20 @@ public:
 	// This should be removed.
 	void (*keypoint_estimation_run_func)(void *);
 
+	// If the keypoint model takes a dynamic batch size, all ROIs of a frame go through this one session instead
+	// of the per view and hand ones.
+	onnx_wrap keypoint_batched = {};
+	bool keypoint_batched_enabled = false;
+
 
 
 	struct xrt_pose left_in_right = {};
 
 	u_frame_times_widget ft_widget = {};
 
+	//! Filled in by every process call.
+	struct hg_frame_timing frame_timing = {};
+
 	struct hg_tuneable_values tuneable_values;
 
 public:
@@ -374,6 +406,12 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap);
 void
 run_keypoint_estimation(void *ptr);
 
+bool
+init_keypoint_estimation_batched(HandTracking *hgt, onnx_wrap *wrap, int num_threads);
+
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info **infos, int count);
+
 void
 release_onnx_wrap(onnx_wrap *wrap);
 
@@ -396,13 +434,24 @@ make_projection_instructions_angular(xrt_vec3 direction_3d,
                                      float twist,
                                      projection_instructions &out_instructions);
 
-void
+/*!
+ * Stereographically projects the ROI described by @p instructions out of @p input_image into @p out.
+ *
+ * If @p grid_cache holds a grid close enough to @p instructions it is reused, and @p instructions is changed to match
+ * it so the model outputs are read back with the projection that was actually used.
+ *
+ * If @p out_normalized isn't null it also gets @p out as floats normalized for the keypoint model, returns false if
+ * that wasn't possible because the image is flat.
+ */
+bool
 stereographic_project_image(const t_camera_model_params &dist,
-                            const projection_instructions &instructions,
+                            projection_instructions &instructions,
                             cv::Mat &input_image,
                             cv::Mat *debug_image,
                             const cv::Scalar boundary_color,
-                            cv::Mat &out);
+                            projection_grid_cache *grid_cache,
+                            cv::Mat &out,
+                            float *out_normalized);
 
 
 
@@ -53,6 +53,12 @@ static constexpr size_t kNumOrientationsInFinger = 4;
 
 #undef RESIDUALS_HACKING
 
+// The analytic Jacobian only knows about the full set of parameters, autodiff is used when hacking on them.
+#if defined(USE_HAND_SIZE) && defined(USE_HAND_TRANSLATION) && defined(USE_HAND_ORIENTATION) &&                       \
+    defined(USE_EVERYTHING_ELSE)
+#define USE_ANALYTIC_JACOBIAN
+#endif
+
 static constexpr size_t kMetacarpalBoneDim = 3;
 static constexpr size_t kProximalBoneDim = 2;
 static constexpr size_t kFingerDim = kProximalBoneDim + 2;
@@ -590,5 +596,33 @@ template <bool optimize_hand_size> struct CostFunctor
 	}
 };
 
+/*!
+ * Wraps @ref CostFunctor for TinySolver, the residuals are the same but the Jacobian is computed analytically by
+ * walking the kinematic chain instead of evaluating the whole cost function again with Jets.
+ */
+template <bool optimize_hand_size> struct AnalyticCostFunction
+{
+	using Scalar = HandScalar;
+	enum
+	{
+		NUM_RESIDUALS = Eigen::Dynamic,
+		NUM_PARAMETERS = (int)calc_input_size(optimize_hand_size),
+	};
+
+	const CostFunctor<optimize_hand_size> &cost_functor;
+
+	AnalyticCostFunction(const CostFunctor<optimize_hand_size> &in_cost_functor) : cost_functor(in_cost_functor)
+	{}
+
+	bool
+	operator()(const HandScalar *x, HandScalar *residual, HandScalar *jacobian) const;
+
+	int
+	NumResiduals() const
+	{
+		return (int)cost_functor.NumResiduals();
+	}
+};
+
 
 } // namespace xrt::tracking::hand::mercury::lm
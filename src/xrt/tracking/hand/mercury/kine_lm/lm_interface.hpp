@@ -57,6 +57,18 @@ optimizer_run(KinematicHandLM *hand,
               float &out_hand_size,
               float &out_reprojection_error);
 
+/*!
+ * Compares the analytic Jacobian the optimizer uses against the one automatic differentiation gives, at the last
+ * solution of @ref optimizer_run with every parameter offset by a random amount. Only meant for tests, the
+ * observation given to optimizer_run must still be alive.
+ *
+ * @param max_offset: Largest offset added to each parameter
+ * @param seed: Seed for the random offsets
+ * @return The largest difference between the two, relative to the size of the automatically differentiated value.
+ */
+float
+optimizer_jacobian_error(KinematicHandLM *hand, float max_offset, uint32_t seed);
+
 // Destructor
 void
 optimizer_destroy(KinematicHandLM **hand);
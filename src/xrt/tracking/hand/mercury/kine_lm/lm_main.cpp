@@ -461,19 +461,15 @@ diff_stereographic(const Vec3<T> &model_joint_pos_rel_camera_,
 
 
 
+// The transform from tracking space into the space of one view, applied by calc_joint_rel_camera.
 template <typename T>
-void
-cjrc(const KinematicHandLM &state,                   //
-     const OptimizerHand<T> &hand,                   //
-     const Translations55<T> &translations_absolute, //
-     const int view,                                 //
-     Vec3<T> out_model_joints_rel_camera[21])
+static void
+cjrc_view_transform(const KinematicHandLM &state,
+                    const int view,
+                    Vec3<T> &move_direction,
+                    Quat<T> &move_orientation,
+                    Quat<T> &after_orientation)
 {
-	Vec3<T> move_direction;
-	Quat<T> move_orientation;
-
-	Quat<T> after_orientation;
-
 	if (view == 0) {
 		move_direction = Vec3<T>::Zero();
 		move_orientation = Quat<T>::Identity();
@@ -502,6 +498,22 @@ cjrc(const KinematicHandLM &state,                   //
 	after_orientation.x = T(extra_rot.x);
 	after_orientation.y = T(extra_rot.y);
 	after_orientation.z = T(extra_rot.z);
+}
+
+template <typename T>
+void
+cjrc(const KinematicHandLM &state,                   //
+     const OptimizerHand<T> &hand,                   //
+     const Translations55<T> &translations_absolute, //
+     const int view,                                 //
+     Vec3<T> out_model_joints_rel_camera[21])
+{
+	Vec3<T> move_direction;
+	Quat<T> move_orientation;
+
+	Quat<T> after_orientation;
+
+	cjrc_view_transform(state, view, move_direction, move_orientation, after_orientation);
 
 
 	int joint_acc_idx = 0;
@@ -723,6 +735,542 @@ CostFunctor<optimize_hand_size>::operator()(const T *const x, T *residual) const
 	return true;
 }
 
+/*
+ *
+ * Analytic Jacobian.
+ *
+ */
+
+#ifdef USE_ANALYTIC_JACOBIAN
+
+// Layout of the parameter vector, see OptimizerHandUnpackFromVector.
+static constexpr int kTranslationIdx = 0;
+static constexpr int kOrientationIdx = kTranslationIdx + kHandTranslationDim;
+static constexpr int kThumbIdx = kOrientationIdx + kHandOrientationDim;
+static constexpr int kFingersIdx = kThumbIdx + kThumbDim;
+static constexpr int kHandSizeIdx = kFingersIdx + (kFingerDim * 4);
+
+using JacobianVec3 = Eigen::Matrix<HandScalar, 3, 1>;
+
+static inline JacobianVec3
+to_jacobian_vec3(const Vec3<HandScalar> &v)
+{
+	return JacobianVec3(v.x, v.y, v.z);
+}
+
+// Derivative of CurlToQuaternion, both of its branches have the same one.
+static inline void
+d_curl_to_quaternion(const HandScalar curl, Quat<HandScalar> &result)
+{
+	result.w = -sin(curl * HandScalar(0.5)) * HandScalar(0.5);
+	result.x = cos(curl * HandScalar(0.5)) * HandScalar(0.5);
+	result.y = HandScalar(0);
+	result.z = HandScalar(0);
+}
+
+// Derivatives of SwingTwistToQuaternion with respect to swing.x, swing.y and twist. With a twist of zero this is also
+// SwingToQuaternion.
+static inline void
+d_swing_twist_to_quaternion(const Vec2<HandScalar> &swing, const HandScalar twist, Quat<HandScalar> result[3])
+{
+	const HandScalar swing_x = swing.x;
+	const HandScalar swing_y = swing.y;
+	const HandScalar theta_squared_swing = swing_x * swing_x + swing_y * swing_y;
+
+	const HandScalar cos_half_twist = cos(twist * HandScalar(0.5));
+	const HandScalar sin_half_twist = sin(twist * HandScalar(0.5));
+
+	// The same branches as SwingTwistToQuaternion, theta only shows up in cos(theta/2) and sin(theta/2)/theta.
+	HandScalar cos_half_theta = HandScalar(1);
+	HandScalar sin_half_theta_over_theta = HandScalar(0.5);
+	// d(cos(theta/2))/d(swing) is -half_k * swing and d(sin(theta/2)/theta)/d(swing) is dk_over_theta * swing.
+	HandScalar half_k = HandScalar(0);
+	HandScalar dk_over_theta = HandScalar(0);
+
+	if (theta_squared_swing > HandScalar(0)) {
+		const HandScalar theta = sqrt(theta_squared_swing);
+		const HandScalar half_theta = theta * HandScalar(0.5);
+		const HandScalar sin_half_theta = sin(half_theta);
+
+		cos_half_theta = cos(half_theta);
+		sin_half_theta_over_theta = sin_half_theta / theta;
+		half_k = sin_half_theta_over_theta * HandScalar(0.5);
+		dk_over_theta = (cos_half_theta * half_theta - sin_half_theta) / (theta_squared_swing * theta);
+	}
+
+	const HandScalar &k = sin_half_theta_over_theta;
+	const HandScalar x_part = swing_x * cos_half_twist + swing_y * sin_half_twist;
+	const HandScalar y_part = swing_y * cos_half_twist - swing_x * sin_half_twist;
+
+	// Swing x.
+	result[0].w = -half_k * swing_x * cos_half_twist;
+	result[0].x = dk_over_theta * swing_x * x_part + k * cos_half_twist;
+	result[0].y = dk_over_theta * swing_x * y_part - k * sin_half_twist;
+	result[0].z = -half_k * swing_x * sin_half_twist;
+
+	// Swing y.
+	result[1].w = -half_k * swing_y * cos_half_twist;
+	result[1].x = dk_over_theta * swing_y * x_part + k * sin_half_twist;
+	result[1].y = dk_over_theta * swing_y * y_part + k * cos_half_twist;
+	result[1].z = -half_k * swing_y * sin_half_twist;
+
+	// Twist.
+	result[2].w = -cos_half_theta * sin_half_twist * HandScalar(0.5);
+	result[2].x = k * y_part * HandScalar(0.5);
+	result[2].y = -k * x_part * HandScalar(0.5);
+	result[2].z = cos_half_theta * cos_half_twist * HandScalar(0.5);
+}
+
+// Derivatives of AngleAxisToQuaternion with respect to each of the angle-axis components.
+static inline void
+d_angle_axis_to_quaternion(const Vec3<HandScalar> &angle_axis, Quat<HandScalar> result[3])
+{
+	const HandScalar a[3] = {angle_axis.x, angle_axis.y, angle_axis.z};
+	const HandScalar theta_squared = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+
+	// Same as above, at the origin only the Taylor series' first term is left.
+	HandScalar k = HandScalar(0.5);
+	HandScalar half_k = HandScalar(0);
+	HandScalar dk_over_theta = HandScalar(0);
+
+	if (theta_squared > HandScalar(0)) {
+		const HandScalar theta = sqrt(theta_squared);
+		const HandScalar half_theta = theta * HandScalar(0.5);
+		const HandScalar sin_half_theta = sin(half_theta);
+
+		k = sin_half_theta / theta;
+		half_k = k * HandScalar(0.5);
+		dk_over_theta = (cos(half_theta) * half_theta - sin_half_theta) / (theta_squared * theta);
+	}
+
+	for (int i = 0; i < 3; i++) {
+		result[i].w = -half_k * a[i];
+		result[i].x = dk_over_theta * a[i] * a[0] + (i == 0 ? k : HandScalar(0));
+		result[i].y = dk_over_theta * a[i] * a[1] + (i == 1 ? k : HandScalar(0));
+		result[i].z = dk_over_theta * a[i] * a[2] + (i == 2 ? k : HandScalar(0));
+	}
+}
+
+/*!
+ * The tracking-relative angular velocity of a joint whose orientation is parent * rel, when rel changes by d_rel.
+ * Every orientation further down the finger is rotated by the same angular velocity.
+ */
+static inline JacobianVec3
+jacobian_angular_velocity(const Quat<HandScalar> &parent, const Quat<HandScalar> &rel, const Quat<HandScalar> &d_rel)
+{
+	const Quat<HandScalar> rel_conjugate(-rel.x, -rel.y, -rel.z, rel.w);
+
+	Quat<HandScalar> local = {};
+	QuaternionProduct(d_rel, rel_conjugate, local);
+
+	const Vec3<HandScalar> local_velocity( //
+	    local.x * HandScalar(2),           //
+	    local.y * HandScalar(2),           //
+	    local.z * HandScalar(2));
+
+	Vec3<HandScalar> velocity = {};
+	UnitQuaternionRotatePoint(parent, local_velocity, velocity);
+
+	return to_jacobian_vec3(velocity);
+}
+
+/*!
+ * Adds the motion of the model joints of a finger from @p first_bone onwards, when they all rotate around @p pivot
+ * with @p velocity, into column @p col of their Jacobians.
+ */
+template <typename JointJacobian>
+static inline void
+jacobian_add_rotation(const KinematicHandLM &state,
+                      const Vec3<HandScalar> model_joints[kNumNNJoints],
+                      const JacobianVec3 &velocity,
+                      const Vec3<HandScalar> &pivot,
+                      const size_t finger,
+                      const size_t first_bone,
+                      const int col,
+                      JointJacobian d_model_joints[kNumNNJoints])
+{
+	// Right hands get their X axis negated after each bone is rotated, undo that around the rotation.
+	const JacobianVec3 mirror(state.is_right ? HandScalar(-1) : HandScalar(1), HandScalar(1), HandScalar(1));
+
+	for (size_t bone = first_bone; bone < kNumJointsInFinger; bone++) {
+		// Same order as cjrc, the wrist and then the last four joints of each finger.
+		const size_t joint = 1 + (finger * 4) + (bone - 1);
+
+		const JacobianVec3 arm = to_jacobian_vec3(model_joints[joint]) - to_jacobian_vec3(pivot);
+		d_model_joints[joint].col(col) += mirror.cwiseProduct(velocity.cross(mirror.cwiseProduct(arm)));
+	}
+}
+
+template <bool optimize_hand_size>
+bool
+AnalyticCostFunction<optimize_hand_size>::operator()(const HandScalar *x,
+                                                     HandScalar *residual,
+                                                     HandScalar *jacobian) const
+{
+	if (!this->cost_functor(x, residual)) {
+		return false;
+	}
+
+	if (jacobian == nullptr) {
+		return true;
+	}
+
+	XRT_TRACE_MARKER();
+
+	using JointJacobian = Eigen::Matrix<HandScalar, 3, NUM_PARAMETERS>;
+	using RowJacobian = Eigen::Matrix<HandScalar, 1, NUM_PARAMETERS>;
+
+	const KinematicHandLM &state = this->cost_functor.parent;
+	const int residual_size = this->NumResiduals();
+
+	OptimizerHand<HandScalar> hand = {};
+	Quat<HandScalar> tmp = state.this_frame_pre_rotation;
+	OptimizerHandInit<HandScalar>(hand, tmp);
+	OptimizerHandUnpackFromVector(x, state, hand);
+
+	Translations55<HandScalar> translations_absolute = {};
+	Orientations54<HandScalar> orientations_absolute = {};
+	eval_hand_with_orientation(state, hand, state.is_right, translations_absolute, orientations_absolute);
+
+	Orientations54<HandScalar> rel_orientations = {};
+	eval_hand_set_rel_orientations(hand, rel_orientations);
+
+	// Tracking-relative model joints in the same order as cjrc, and their derivatives.
+	Vec3<HandScalar> model_joints[kNumNNJoints];
+	JointJacobian d_model_joints[kNumNNJoints];
+
+	model_joints[0] = hand.wrist_final_location;
+	for (int finger = 0; finger < 5; finger++) {
+		for (int joint = 0; joint < 4; joint++) {
+			model_joints[1 + (finger * 4) + joint] = translations_absolute.t[finger][joint + 1];
+		}
+	}
+
+	for (JointJacobian &d : d_model_joints) {
+		d.setZero();
+		d.template block<3, 3>(0, kTranslationIdx).setIdentity();
+	}
+
+	// Wrist orientation, moves every joint but the wrist itself.
+	{
+		Quat<HandScalar> post_orientation = {};
+		AngleAxisToQuaternion(hand.wrist_post_orientation_aax, post_orientation);
+
+		Quat<HandScalar> d_post_orientation[3];
+		d_angle_axis_to_quaternion(hand.wrist_post_orientation_aax, d_post_orientation);
+
+		for (int i = 0; i < 3; i++) {
+			const JacobianVec3 velocity = jacobian_angular_velocity( //
+			    state.this_frame_pre_rotation, post_orientation, d_post_orientation[i]);
+
+			for (size_t finger = 0; finger < kNumFingers; finger++) {
+				jacobian_add_rotation(state, model_joints, velocity, hand.wrist_final_location, //
+				                      finger, 1, kOrientationIdx + i, d_model_joints);
+			}
+		}
+	}
+
+	// Thumb metacarpal swing and twist.
+	{
+		const minmax limits[3] = {the_limit.thumb_mcp_swing_x, the_limit.thumb_mcp_swing_y,
+		                          the_limit.thumb_mcp_twist};
+
+		Quat<HandScalar> d_rel[3];
+		d_swing_twist_to_quaternion(hand.thumb.metacarpal.swing, hand.thumb.metacarpal.twist, d_rel);
+
+		for (int i = 0; i < 3; i++) {
+			const int col = kThumbIdx + i;
+			const JacobianVec3 velocity =
+			    jacobian_angular_velocity(orientations_absolute.q[0][0], rel_orientations.q[0][1],
+			                              d_rel[i]) *
+			    LMToModelDerivative(x[col], limits[i]);
+
+			jacobian_add_rotation(state, model_joints, velocity, translations_absolute.t[0][1], 0, 2, col,
+			                      d_model_joints);
+		}
+	}
+
+	// Thumb curls.
+	for (int i = 0; i < 2; i++) {
+		const int col = kThumbIdx + kMetacarpalBoneDim + i;
+
+		Quat<HandScalar> d_rel = {};
+		d_curl_to_quaternion(hand.thumb.rots[i], d_rel);
+
+		const JacobianVec3 velocity =
+		    jacobian_angular_velocity(orientations_absolute.q[0][1 + i], rel_orientations.q[0][2 + i], d_rel) *
+		    LMToModelDerivative(x[col], the_limit.thumb_curls[i]);
+
+		jacobian_add_rotation(state, model_joints, velocity, translations_absolute.t[0][2 + i], 0, 3 + i, col,
+		                      d_model_joints);
+	}
+
+	// Proximal swings and curls of the other fingers, the metacarpals are constant.
+	for (int finger_idx = 0; finger_idx < 4; finger_idx++) {
+		const int finger = finger_idx + 1;
+		const int idx = kFingersIdx + (finger_idx * kFingerDim);
+		const FingerLimit &limit = the_limit.fingers[finger_idx];
+		const minmax swing_limits[2] = {limit.pxm_swing_x, limit.pxm_swing_y};
+
+		Quat<HandScalar> d_swing[3];
+		d_swing_twist_to_quaternion(hand.finger[finger_idx].proximal_swing, HandScalar(0), d_swing);
+
+		for (int i = 0; i < 2; i++) {
+			const JacobianVec3 velocity =
+			    jacobian_angular_velocity(orientations_absolute.q[finger][0], rel_orientations.q[finger][1],
+			                              d_swing[i]) *
+			    LMToModelDerivative(x[idx + i], swing_limits[i]);
+
+			jacobian_add_rotation(state, model_joints, velocity, translations_absolute.t[finger][1], //
+			                      finger, 2, idx + i, d_model_joints);
+		}
+
+		for (int i = 0; i < 2; i++) {
+			const int col = idx + kProximalBoneDim + i;
+
+			Quat<HandScalar> d_rel = {};
+			d_curl_to_quaternion(hand.finger[finger_idx].rots[i], d_rel);
+
+			const JacobianVec3 velocity =
+			    jacobian_angular_velocity(orientations_absolute.q[finger][1 + i],
+			                              rel_orientations.q[finger][2 + i], d_rel) *
+			    LMToModelDerivative(x[col], limit.curls[i]);
+
+			jacobian_add_rotation(state, model_joints, velocity, translations_absolute.t[finger][2 + i],
+			                      finger, 3 + i, col, d_model_joints);
+		}
+	}
+
+	// Hand size scales everything around the wrist.
+	HandScalar d_hand_size = HandScalar(0);
+	if constexpr (optimize_hand_size) {
+		d_hand_size = LMToModelDerivative(x[kHandSizeIdx], the_limit.hand_size);
+
+		for (size_t joint = 1; joint < kNumNNJoints; joint++) {
+			d_model_joints[joint].col(kHandSizeIdx) =
+			    (to_jacobian_vec3(model_joints[joint]) - to_jacobian_vec3(hand.wrist_final_location)) *
+			    (d_hand_size / hand.hand_size);
+		}
+	}
+
+	Eigen::Map<Eigen::Matrix<HandScalar, Eigen::Dynamic, NUM_PARAMETERS>> jac(jacobian, residual_size,
+	                                                                          NUM_PARAMETERS);
+	jac.setZero();
+
+	int row = 0;
+
+	// CostFunctor_PositionsPart
+	for (int view = 0; view < 2; view++) {
+		const one_frame_one_view &inp = state.observation->views[view];
+		if (!inp.active) {
+			continue;
+		}
+
+		Vec3<HandScalar> move_direction = {};
+		Quat<HandScalar> move_orientation = {};
+		Quat<HandScalar> after_orientation = {};
+		cjrc_view_transform(state, view, move_direction, move_orientation, after_orientation);
+
+		// calc_joint_rel_camera is rotate, translate and rotate again, so only the rotations touch derivatives.
+		Eigen::Matrix<HandScalar, 3, 3> view_rotation;
+		for (int i = 0; i < 3; i++) {
+			Vec3<HandScalar> axis = Vec3<HandScalar>::Zero();
+			Vec3<HandScalar> moved = {};
+			Vec3<HandScalar> rotated = {};
+			(i == 0 ? axis.x : i == 1 ? axis.y : axis.z) = HandScalar(1);
+
+			UnitQuaternionRotatePoint(move_orientation, axis, moved);
+			UnitQuaternionRotatePoint(after_orientation, moved, rotated);
+			view_rotation.col(i) = to_jacobian_vec3(rotated);
+		}
+
+		Vec3<HandScalar> model_joints_rel_camera[kNumNNJoints] = {};
+		cjrc(state, hand, translations_absolute, view, model_joints_rel_camera);
+
+		const MLOutput2D &out = inp.keypoints_in_scaled_stereographic;
+
+		const JacobianVec3 pxm = to_jacobian_vec3(model_joints_rel_camera[Joint21::INDX_PXM]);
+		const HandScalar pxm_depth = pxm.norm();
+		const RowJacobian d_pxm_depth =
+		    (pxm / pxm_depth).transpose() * (view_rotation * d_model_joints[Joint21::INDX_PXM]);
+
+		for (int i = 0; i < 21; i++) {
+			const JacobianVec3 joint = to_jacobian_vec3(model_joints_rel_camera[i]);
+			const JointJacobian d_joint = view_rotation * d_model_joints[i];
+			const HandScalar depth = joint.norm();
+
+			// diff_stereographic, normalize_vector_inplace then unit_vector_stereographic_projection.
+			JacobianVec3 dir;
+			JointJacobian d_dir;
+			if (depth <= FLT_EPSILON) {
+				dir = JacobianVec3(joint.x(), joint.y(), HandScalar(-1));
+				d_dir = d_joint;
+				d_dir.row(2).setZero();
+			} else {
+				dir = joint / depth;
+				const Eigen::Matrix<HandScalar, 3, 3> d_normalize =
+				    (Eigen::Matrix<HandScalar, 3, 3>::Identity() - dir * dir.transpose()) / depth;
+				d_dir = d_normalize * d_joint;
+			}
+
+			const HandScalar one_over_denom = HandScalar(1) / (HandScalar(1) - dir.z());
+			const HandScalar confidence_xy = out[i].confidence_xy;
+
+			jac.row(row++) = (d_dir.row(0) + d_dir.row(2) * (dir.x() * one_over_denom)) *
+			                 (one_over_denom * confidence_xy);
+			jac.row(row++) = (d_dir.row(1) + d_dir.row(2) * (dir.y() * one_over_denom)) *
+			                 (one_over_denom * confidence_xy);
+
+			if (i == Joint21::MIDL_PXM) {
+				continue;
+			}
+
+			// Depth part, constant on the first frame.
+			if (!state.first_frame) {
+				RowJacobian d_rel_depth = (dir.transpose() * d_joint - d_pxm_depth) / hand.hand_size;
+				if constexpr (optimize_hand_size) {
+					d_rel_depth(kHandSizeIdx) -=
+					    (depth - pxm_depth) / (hand.hand_size * hand.hand_size) * d_hand_size;
+				}
+
+				HandScalar depth_mul = HandScalar(pow(out[i].confidence_depth, 3));
+				depth_mul *= state.depth_err_mul;
+				jac.row(row) = d_rel_depth * depth_mul;
+			}
+			row++;
+		}
+	}
+
+	// computeResidualStability, all linear in the model parameters except for the wrist orientation.
+	HandStability stab(state.smoothing_factor);
+
+	if constexpr (optimize_hand_size) {
+		jac(row++, kHandSizeIdx) = d_hand_size * stab.stabilityHandSize * state.hand_size_err_mul;
+	}
+
+	if (!state.first_frame) {
+		for (int i = 0; i < 3; i++) {
+			jac(row++, kTranslationIdx + i) = stab.stabilityRootPosition;
+		}
+
+		const Vec3<HandScalar> &aax = hand.wrist_post_orientation_aax;
+		const JacobianVec3 orientation_mul(stab.stabilityHandOrientationXY, stab.stabilityHandOrientationXY,
+		                                   stab.stabilityHandOrientationZ);
+
+		// Same epsilon and branches as computeResidualStability.
+		const float epsilon = 0.001;
+		if (aax.x < epsilon && aax.y < epsilon && aax.z < epsilon) {
+			for (int i = 0; i < 3; i++) {
+				jac(row++, kOrientationIdx + i) = orientation_mul(i);
+			}
+		} else {
+			// The residual is 2 * sin(|aax| / 2) * aax / |aax|.
+			const JacobianVec3 a = to_jacobian_vec3(aax);
+			const HandScalar theta = a.norm();
+			const HandScalar g = HandScalar(2) * sin(HandScalar(0.5) * theta) / theta;
+			const HandScalar dg_over_theta =
+			    (cos(HandScalar(0.5) * theta) * theta - HandScalar(2) * sin(HandScalar(0.5) * theta)) /
+			    (theta * theta * theta);
+
+			const Eigen::Matrix<HandScalar, 3, 3> d_orientation =
+			    Eigen::Matrix<HandScalar, 3, 3>::Identity() * g + a * a.transpose() * dg_over_theta;
+
+			for (int i = 0; i < 3; i++) {
+				jac.template block<1, 3>(row++, kOrientationIdx) =
+				    d_orientation.row(i) * orientation_mul(i);
+			}
+		}
+
+		const HandScalar thumb_mul[kThumbDim] = {stab.stabilityThumbMCPSwing, stab.stabilityThumbMCPSwing,
+		                                         stab.stabilityThumbMCPTwist, stab.stabilityCurlRoot,
+		                                         stab.stabilityCurlRoot};
+		const minmax thumb_limits[kThumbDim] = {the_limit.thumb_mcp_swing_x, the_limit.thumb_mcp_swing_y,
+		                                        the_limit.thumb_mcp_twist, the_limit.thumb_curls[0],
+		                                        the_limit.thumb_curls[1]};
+
+		for (size_t i = 0; i < kThumbDim; i++) {
+			const int col = kThumbIdx + i;
+			jac(row++, col) = LMToModelDerivative(x[col], thumb_limits[i]) * thumb_mul[i];
+		}
+
+#ifdef USE_HAND_PLAUSIBILITY
+		for (int finger_idx = 1; finger_idx < 3; finger_idx++) {
+			const int col_a = kFingersIdx + (finger_idx * kFingerDim);
+			const int col_b = col_a + kFingerDim;
+
+			const minmax &limit_a = the_limit.fingers[finger_idx].pxm_swing_x;
+			const minmax &limit_b = the_limit.fingers[finger_idx + 1].pxm_swing_x;
+
+			jac(row, col_a) = LMToModelDerivative(x[col_a], limit_a) * kPlausibilityProximalSimilarity;
+			jac(row, col_b) = -LMToModelDerivative(x[col_b], limit_b) * kPlausibilityProximalSimilarity;
+			row++;
+		}
+#endif
+
+		// computeResidualStability_Finger
+		for (int finger_idx = 0; finger_idx < 4; finger_idx++) {
+			const int idx = kFingersIdx + (finger_idx * kFingerDim);
+			const FingerLimit &limit = the_limit.fingers[finger_idx];
+
+			HandScalar obs_curl = HandScalar(get_avg_curl_value(*state.observation, finger_idx + 1));
+			HandScalar curl_sub_mul =
+			    calc_stability_curl_multiplier(state.last_frame.finger[finger_idx], obs_curl);
+
+			const HandScalar d_curls[2] = {
+			    LMToModelDerivative(x[idx + 2], limit.curls[0]),
+			    LMToModelDerivative(x[idx + 3], limit.curls[1]),
+			};
+
+			jac(row++, idx + 0) = LMToModelDerivative(x[idx + 0], limit.pxm_swing_x) *
+			                      stab.stabilityFingerPXMSwingX * curl_sub_mul;
+			jac(row++, idx + 1) = LMToModelDerivative(x[idx + 1], limit.pxm_swing_y) * //
+			                      stab.stabilityFingerPXMSwingY;
+			jac(row++, idx + 2) = d_curls[0] * stab.stabilityCurlRoot * curl_sub_mul;
+			jac(row++, idx + 3) = d_curls[1] * stab.stabilityCurlRoot * curl_sub_mul;
+
+#ifdef USE_HAND_PLAUSIBILITY
+			const OptimizerFinger<HandScalar> &finger = hand.finger[finger_idx];
+			const HandScalar plausibility_mul = finger.rots[0] < finger.rots[1]
+			                                        ? kPlausibilityCurlSimilarityHard
+			                                        : kPlausibilityCurlSimilaritySoft;
+			jac(row, idx + 2) = d_curls[0] * plausibility_mul;
+			jac(row, idx + 3) = -d_curls[1] * plausibility_mul;
+			row++;
+#endif
+		}
+	}
+
+#ifdef USE_HAND_CURLS
+	// CostFunctor_MatchCurls
+	for (int view = 0; view < 2; view++) {
+		const one_frame_one_view &inp = state.observation->views[view];
+		if (!inp.active) {
+			continue;
+		}
+
+		for (int finger_idx = 0; finger_idx < 4; finger_idx++) {
+			const int idx = kFingersIdx + (finger_idx * kFingerDim);
+			const FingerLimit &limit = the_limit.fingers[finger_idx];
+			const HandScalar mul = 1 / inp.curls[finger_idx + 1].variance;
+
+			jac(row, idx + 0) = LMToModelDerivative(x[idx + 0], limit.pxm_swing_x) * mul;
+			jac(row, idx + 2) = LMToModelDerivative(x[idx + 2], limit.curls[0]) * mul;
+			jac(row, idx + 3) = LMToModelDerivative(x[idx + 3], limit.curls[1]) * mul;
+			row++;
+		}
+	}
+#endif
+
+	if (row != residual_size) {
+		LM_ERROR(state, "Jacobian size was wrong! Residual size was %d, but row was %d", residual_size, row);
+	}
+	assert(row == residual_size);
+
+	return true;
+}
+
+#endif // USE_ANALYTIC_JACOBIAN
+
 // look at tests_quat_change_of_basis
 #if 0
 template <typename T>
@@ -853,12 +1401,16 @@ opt_run(KinematicHandLM &state, one_frame_input &observation, xrt_hand_joint_set
 
 	CostFunctor<optimize_hand_size> cf(state, residual_size);
 
-	using AutoDiffCostFunctor =
+#ifdef USE_ANALYTIC_JACOBIAN
+	using CostFunction = AnalyticCostFunction<optimize_hand_size>;
+#else
+	using CostFunction =
 	    ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>, Eigen::Dynamic, input_size, HandScalar>;
+#endif
 
-	AutoDiffCostFunctor f(cf);
+	CostFunction f(cf);
 
-	ceres::TinySolver<AutoDiffCostFunctor> solver = {};
+	ceres::TinySolver<CostFunction> solver = {};
 	solver.options.max_num_iterations = 30;
 
 	//!@todo We don't yet know what "good" termination conditions are.
@@ -968,10 +1520,11 @@ optimizer_run(KinematicHandLM *hand,
 	KinematicHandLM &state = *hand;
 	state.smoothing_factor = smoothing_factor;
 
-	xrt_pose blah = XRT_POSE_IDENTITY;
-	hand_init_guess(observation, target_hand_size, state.left_in_right, blah);
-
+	// Otherwise warm-start from last frame's solution, which is already in TinyOptimizerInput.
 	if (hand_was_untracked_last_frame) {
+		xrt_pose blah = XRT_POSE_IDENTITY;
+		hand_init_guess(observation, target_hand_size, state.left_in_right, blah);
+
 		OptimizerHandInit(state.last_frame, state.this_frame_pre_rotation);
 		OptimizerHandPackIntoVector(state.last_frame, state.optimize_hand_size,
 		                            state.TinyOptimizerInput.data());
@@ -1097,6 +1650,57 @@ optimizer_run(KinematicHandLM *hand,
 
 
 
+template <bool optimize_hand_size>
+static float
+jacobian_error(KinematicHandLM &state, float max_offset, uint32_t seed)
+{
+#ifdef USE_ANALYTIC_JACOBIAN
+	constexpr size_t input_size = calc_input_size(optimize_hand_size);
+
+	size_t residual_size = calc_residual_size(state.use_stability, optimize_hand_size, state.num_observation_views);
+
+	CostFunctor<optimize_hand_size> cf(state, residual_size);
+
+	AnalyticCostFunction<optimize_hand_size> analytic(cf);
+	ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>, Eigen::Dynamic, input_size, HandScalar>
+	    autodiff(cf);
+
+	std::mt19937 mt(seed);
+	std::uniform_real_distribution<HandScalar> offset(-max_offset, max_offset);
+
+	Eigen::Matrix<HandScalar, input_size, 1> inp = state.TinyOptimizerInput.head<input_size>();
+	for (size_t i = 0; i < input_size; i++) {
+		inp(i) += offset(mt);
+	}
+
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, 1> residuals(residual_size);
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, input_size> jac_analytic(residual_size, input_size);
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, input_size> jac_autodiff(residual_size, input_size);
+
+	analytic(inp.data(), residuals.data(), jac_analytic.data());
+	autodiff(inp.data(), residuals.data(), jac_autodiff.data());
+
+	// Relative for large values, absolute for ones close to zero.
+	return ((jac_analytic - jac_autodiff).array().abs() / (jac_autodiff.array().abs() + HandScalar(1))).maxCoeff();
+#else
+	return 0.0f;
+#endif
+}
+
+float
+optimizer_jacobian_error(KinematicHandLM *hand, float max_offset, uint32_t seed)
+{
+	KinematicHandLM &state = *hand;
+
+	// Like optimizer_run, the last frame is what stability is relative to.
+	state.use_stability = !state.first_frame;
+
+	if (state.optimize_hand_size) {
+		return jacobian_error<true>(state, max_offset, seed);
+	}
+	return jacobian_error<false>(state, max_offset, seed);
+}
+
 void
 optimizer_create(xrt_pose left_in_right, bool is_right, u_logging_level log_level, KinematicHandLM **out_kinematic_hand)
 {
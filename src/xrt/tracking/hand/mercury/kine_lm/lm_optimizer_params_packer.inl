@@ -28,6 +28,14 @@ LMToModel(T lm, minmax mm)
 	return mm.min + ((sin(lm) + T(1)) * ((mm.max - mm.min) * T(.5)));
 }
 
+// Derivative of LMToModel with respect to lm.
+template <typename T>
+inline T
+LMToModelDerivative(T lm, minmax mm)
+{
+	return cos(lm) * ((mm.max - mm.min) * T(.5));
+}
+
 template <typename T>
 inline T
 ModelToLM(T model, minmax mm)
@@ -9,11 +9,11 @@
 
 #include "os/os_threading.h"
 
-#include "math/m_space.h"
-#include "math/m_relation_history.h"
+#include "math/m_hand_history.h"
 
 #include "util/u_var.h"
 #include "util/u_misc.h"
+#include "util/u_atomic.h"
 #include "util/u_debug.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
@@ -47,13 +47,8 @@ struct ht_async_impl
 		uint64_t timestamp;
 	} working;
 
-	struct
-	{
-		struct os_mutex mutex;
-		struct xrt_hand_joint_set hands[2];
-		struct m_relation_history *relation_hist[2];
-		uint64_t timestamp;
-	} present;
+	//! Thread safe, interpolates the hands for the time asked for.
+	struct m_hand_history *hand_hist[2];
 
 	// in here:
 	// mutex is so that the mainloop and two push_frames don't fight over referencing frames;
@@ -62,6 +57,9 @@ struct ht_async_impl
 	struct os_thread_helper mainloop;
 
 	volatile bool hand_tracking_work_active;
+
+	//! Written under the mainloop lock, read lock free by the sinks, frames are dropped while set.
+	xrt_atomic_s32_t paused;
 };
 
 
@@ -118,41 +116,23 @@ ht_async_mainloop(void *ptr)
 		xrt_frame_reference(&hta->frames[0], NULL);
 		xrt_frame_reference(&hta->frames[1], NULL);
 
+		// Have to lock it again.
+		os_thread_helper_lock(&hta->mainloop);
+
 
 		/*
 		 * Post process.
 		 */
 
-		os_mutex_lock(&hta->present.mutex);
-
-		hta->present.timestamp = hta->working.timestamp;
-
-		for (int i = 0; i < 2; i++) {
-			hta->present.hands[i] = hta->working.hands[i];
-		}
-
-		os_mutex_unlock(&hta->present.mutex);
-
-		for (int i = 0; i < 2; i++) {
-			struct xrt_space_relation wrist_rel =
-			    hta->working.hands[i].values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
-
-			m_relation_history_estimate_motion( //
-			    hta->present.relation_hist[i],  //
-			    &wrist_rel,                     //
-			    hta->working.timestamp,         //
-			    &wrist_rel);                    //
-
-			m_relation_history_push(           //
-			    hta->present.relation_hist[i], //
-			    &wrist_rel,                    //
-			    hta->working.timestamp);       //
+		// Don't bring back the hands if we were paused while processing.
+		for (int i = 0; i < 2 && !u_atomic_s32_load_acquire(&hta->paused); i++) {
+			m_hand_history_push(         //
+			    hta->hand_hist[i],       //
+			    &hta->working.hands[i],  //
+			    hta->working.timestamp); //
 		}
 
 		hta->hand_tracking_work_active = false;
-
-		// Have to lock it again.
-		os_thread_helper_lock(&hta->mainloop);
 	}
 
 	os_thread_helper_unlock(&hta->mainloop);
@@ -172,6 +152,10 @@ ht_async_receive_left(struct xrt_frame_sink *sink, struct xrt_frame *frame)
 {
 	struct ht_async_impl *hta = ht_async_impl(container_of(sink, struct t_hand_tracking_async, left));
 
+	if (u_atomic_s32_load_acquire(&hta->paused)) {
+		return;
+	}
+
 	// See comment in ht_async_receive_right.
 	if (hta->hand_tracking_work_active) {
 		// Throw away this frame
@@ -190,6 +174,12 @@ ht_async_receive_right(struct xrt_frame_sink *sink, struct xrt_frame *frame)
 {
 	struct ht_async_impl *hta = ht_async_impl(container_of(sink, struct t_hand_tracking_async, right));
 
+	// Paused after the left frame was pushed, don't keep it around.
+	if (u_atomic_s32_load_acquire(&hta->paused)) {
+		xrt_frame_reference(&hta->frames[0], NULL);
+		return;
+	}
+
 	/*
 	 * Throw away this frame - either the hand tracking work is running now,
 	 * or it was a very short time ago, and ht_async_receive_left threw away
@@ -238,12 +228,11 @@ ht_async_destroy(struct xrt_frame_node *node)
 	struct ht_async_impl *hta = ht_async_impl(container_of(node, struct t_hand_tracking_async, node));
 
 	os_thread_helper_destroy(&hta->mainloop);
-	os_mutex_destroy(&hta->present.mutex);
 
 	t_ht_sync_destroy(&hta->provider);
 
 	for (int i = 0; i < 2; i++) {
-		m_relation_history_destroy(&hta->present.relation_hist[i]);
+		m_hand_history_destroy(&hta->hand_hist[i]);
 	}
 
 	free(hta);
@@ -271,44 +260,42 @@ ht_async_get_hand(struct t_hand_tracking_async *ht_async,
 		idx = 1;
 	}
 
-	os_mutex_lock(&hta->present.mutex);
-
-	struct xrt_hand_joint_set latest_hand = hta->present.hands[idx];
-
 	if (!hta->use_prediction) {
-		*out_value = latest_hand;
-		*out_timestamp_ns = hta->present.timestamp;
-		os_mutex_unlock(&hta->present.mutex);
+		if (!m_hand_history_get_latest(hta->hand_hist[idx], out_timestamp_ns, out_value)) {
+			U_ZERO(out_value);
+			*out_timestamp_ns = 0;
+		}
 		return;
 	}
 
-	os_mutex_unlock(&hta->present.mutex);
-
 	double prediction_offset_ns = (double)hta->prediction_offset_ms.val * (double)U_TIME_1MS_IN_NS;
 
 	desired_timestamp_ns += (uint64_t)prediction_offset_ns;
 
-	struct xrt_space_relation predicted_wrist;
-	m_relation_history_get(hta->present.relation_hist[idx], desired_timestamp_ns, &predicted_wrist);
+	/*
+	 * Interpolates the whole hand when we have a newer sample than asked
+	 * for, otherwise moves the latest hand along with the predicted wrist.
+	 */
+	m_hand_history_get(hta->hand_hist[idx], desired_timestamp_ns, out_value, out_timestamp_ns);
+}
 
-	struct xrt_space_relation latest_wrist =
-	    latest_hand.values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
+static void
+ht_async_set_paused(struct t_hand_tracking_async *ht_async, bool paused)
+{
+	struct ht_async_impl *hta = ht_async_impl(ht_async);
 
-	*out_value = latest_hand;
+	os_thread_helper_lock(&hta->mainloop);
 
-	// apply the pose change from the latest wrist to the predicted wrist
-	// to all the joints on the hand.
+	u_atomic_s32_store_release(&hta->paused, paused ? 1 : 0);
 
-	//! @todo We could slightly reduce the total number of transforms by putting some of this in ht_async_mainloop
-	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
-		struct xrt_relation_chain xrc = {0};
-		m_relation_chain_push_relation(&xrc, &latest_hand.values.hand_joint_set_default[i].relation);
-		m_relation_chain_push_inverted_relation(&xrc, &latest_wrist);
-		m_relation_chain_push_relation(&xrc, &predicted_wrist);
-		m_relation_chain_resolve(&xrc, &out_value->values.hand_joint_set_default[i].relation);
+	// The history is empty until the first hands after resuming, so there are no hands while paused.
+	if (paused) {
+		for (int i = 0; i < 2; i++) {
+			m_hand_history_clear(hta->hand_hist[i]);
+		}
 	}
 
-	*out_timestamp_ns = desired_timestamp_ns;
+	os_thread_helper_unlock(&hta->mainloop);
 }
 
 
@@ -330,10 +317,11 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 	hta->base.node.break_apart = ht_async_break_apart;
 	hta->base.node.destroy = ht_async_destroy;
 	hta->base.get_hand = ht_async_get_hand;
+	hta->base.set_paused = ht_async_set_paused;
 	hta->provider = sync;
 
 	for (int i = 0; i < 2; i++) {
-		m_relation_history_create(&hta->present.relation_hist[i]);
+		m_hand_history_create(&hta->hand_hist[i], M_HAND_HISTORY_DEFAULT_CAPACITY);
 	}
 
 	/*!
@@ -358,7 +346,6 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 	};
 
 	// In reality never fails.
-	os_mutex_init(&hta->present.mutex);
 	os_thread_helper_init(&hta->mainloop);
 	os_thread_helper_start(&hta->mainloop, ht_async_mainloop, hta);
 
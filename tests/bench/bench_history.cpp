@@ -0,0 +1,125 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Benchmarks for m_relation_history.
+ */
+
+#include <math/m_relation_history.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+
+
+static constexpr uint64_t T0 = 10 * (uint64_t)U_TIME_1S_IN_NS;
+static constexpr uint64_t STEP = 1 * (uint64_t)U_TIME_1MS_IN_NS;
+
+static struct xrt_space_relation
+make_relation(uint64_t i)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)( //
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |        //
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT |           //
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT |    //
+	    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);   //
+	rel.pose.orientation.w = 1.0f;
+	rel.pose.position.x = (float)i * 0.001f;
+	rel.linear_velocity.x = 1.0f;
+	rel.angular_velocity.y = 0.5f;
+	return rel;
+}
+
+//! Fills the history so every benchmark works on a full buffer.
+static uint64_t
+fill(struct m_relation_history *rh)
+{
+	uint64_t count = 4096;
+	for (uint64_t i = 0; i < count; i++) {
+		struct xrt_space_relation rel = make_relation(i);
+		m_relation_history_push(rh, &rel, T0 + i * STEP);
+	}
+	return count;
+}
+
+TEST_CASE("m_relation_history")
+{
+	struct m_relation_history *rh = NULL;
+	m_relation_history_create(&rh);
+	uint64_t count = fill(rh);
+	uint64_t last_ns = T0 + (count - 1) * STEP;
+
+	BENCHMARK_ADVANCED("push")(Catch::Benchmark::Chronometer meter)
+	{
+		struct xrt_space_relation rel = make_relation(count);
+		uint64_t start_ns = last_ns;
+		meter.measure([&](int i) { return m_relation_history_push(rh, &rel, start_ns + (i + 1) * STEP); });
+		last_ns = start_ns + meter.runs() * STEP;
+	};
+
+	BENCHMARK("get interpolated")
+	{
+		struct xrt_space_relation out;
+		m_relation_history_get(rh, last_ns - 10 * STEP - STEP / 3, &out);
+		return out.pose.position.x;
+	};
+
+	BENCHMARK("get predicted")
+	{
+		struct xrt_space_relation out;
+		m_relation_history_get(rh, last_ns + 10 * STEP, &out);
+		return out.pose.position.x;
+	};
+
+	BENCHMARK("get latest")
+	{
+		uint64_t ts;
+		struct xrt_space_relation out;
+		m_relation_history_get_latest(rh, &ts, &out);
+		return ts;
+	};
+
+	m_relation_history_destroy(&rh);
+}
+
+TEST_CASE("m_relation_history contended")
+{
+	struct m_relation_history *rh = NULL;
+	m_relation_history_create(&rh);
+	uint64_t count = fill(rh);
+
+	// A driver thread pushing as fast as it can while the reader gets.
+	std::atomic<bool> running{true};
+	std::atomic<uint64_t> latest_ns{T0 + (count - 1) * STEP};
+	std::thread writer([&] {
+		uint64_t i = count;
+		while (running.load(std::memory_order_relaxed)) {
+			struct xrt_space_relation rel = make_relation(i);
+			m_relation_history_push(rh, &rel, T0 + i * STEP);
+			latest_ns.store(T0 + i * STEP, std::memory_order_relaxed);
+			i++;
+		}
+	});
+
+	BENCHMARK("get interpolated")
+	{
+		struct xrt_space_relation out;
+		m_relation_history_get(rh, latest_ns.load(std::memory_order_relaxed) - 10 * STEP - STEP / 3, &out);
+		return out.pose.position.x;
+	};
+
+	BENCHMARK("get predicted")
+	{
+		struct xrt_space_relation out;
+		m_relation_history_get(rh, latest_ns.load(std::memory_order_relaxed) + 10 * STEP, &out);
+		return out.pose.position.x;
+	};
+
+	running = false;
+	writer.join();
+
+	m_relation_history_destroy(&rh);
+}
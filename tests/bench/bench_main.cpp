@@ -0,0 +1,9 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Translation unit to build Catch2 main with benchmarking enabled.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
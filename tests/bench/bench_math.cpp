@@ -0,0 +1,81 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Benchmarks for relation chains, prediction and IMU fusion.
+ */
+
+#include <math/m_api.h>
+#include <math/m_imu_3dof.h>
+#include <math/m_predict.h>
+#include <math/m_space.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+
+static const struct xrt_pose kPoseA = {{0.0f, 0.38268343f, 0.0f, 0.92387953f}, {0.1f, 1.6f, -0.2f}};
+static const struct xrt_pose kPoseB = {{0.13052619f, 0.0f, 0.0f, 0.99144486f}, {0.0f, -0.05f, 0.1f}};
+
+static struct xrt_space_relation
+make_relation(void)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)( //
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |        //
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT |           //
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT |    //
+	    XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);   //
+	rel.pose = kPoseA;
+	rel.linear_velocity = {0.3f, 0.0f, -0.1f};
+	rel.angular_velocity = {0.0f, 2.0f, 0.5f};
+	return rel;
+}
+
+TEST_CASE("m_relation_chain")
+{
+	struct xrt_space_relation rel = make_relation();
+
+	BENCHMARK("resolve relation and two poses")
+	{
+		struct xrt_relation_chain xrc = {};
+		m_relation_chain_push_relation(&xrc, &rel);
+		m_relation_chain_push_pose(&xrc, &kPoseB);
+		m_relation_chain_push_inverted_pose_if_not_identity(&xrc, &kPoseA);
+
+		struct xrt_space_relation out;
+		m_relation_chain_resolve(&xrc, &out);
+		return out.pose.position.x;
+	};
+}
+
+TEST_CASE("m_predict_relation")
+{
+	struct xrt_space_relation rel = make_relation();
+
+	BENCHMARK("predict 20ms")
+	{
+		struct xrt_space_relation out;
+		m_predict_relation(&rel, 0.020, &out);
+		return out.pose.orientation.w;
+	};
+}
+
+TEST_CASE("m_imu_3dof")
+{
+	struct m_imu_3dof f;
+	m_imu_3dof_init(&f, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	const struct xrt_vec3 accel = {0.1f, 9.81f, 0.2f};
+	const struct xrt_vec3 gyro = {0.01f, 0.5f, -0.02f};
+	uint64_t timestamp_ns = (uint64_t)U_TIME_1S_IN_NS;
+
+	BENCHMARK("update 1kHz")
+	{
+		timestamp_ns += U_TIME_1MS_IN_NS;
+		m_imu_3dof_update(&f, timestamp_ns, &accel, &gyro);
+		return f.rot.w;
+	};
+
+	m_imu_3dof_close(&f);
+}
@@ -0,0 +1,130 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Benchmarks for the PS Move fusion filters.
+ */
+
+#include <tracking/t_psmv_filter.hpp>
+
+#include "catch/catch.hpp"
+
+
+using namespace xrt::auxiliary::tracking;
+
+//! IMU sample rate of a PS Move, two samples per report.
+static constexpr double kImuDt = 1.0 / 350.0;
+//! IMU samples per camera frame at 60Hz.
+static constexpr int kImuPerFrame = 6;
+
+static const Eigen::Vector3d kLeverArm{0, 0.09, 0};
+static const Eigen::Vector3d kOrientationVariance = Eigen::Vector3d::Constant(0.01);
+static const Eigen::Vector3d kPositionVariance{1.e-4, 1.e-4, 4.e-4};
+
+//! Slowly spinning controller moving in a circle.
+static Eigen::Quaterniond
+orientation_at(double t)
+{
+	return Eigen::Quaterniond(Eigen::AngleAxisd(0.8 * t, Eigen::Vector3d(0.2, 1, 0.1).normalized()));
+}
+
+static Eigen::Vector3d
+position_at(double t)
+{
+	return Eigen::Vector3d(0.3 * std::cos(t), 1.2, -0.5 + 0.3 * std::sin(t)) + orientation_at(t) * kLeverArm;
+}
+
+/*!
+ * Runs one camera frame worth of data through the filter, either correcting
+ * on every IMU sample like the tracker used to or once per frame.
+ */
+template <typename Filter>
+static void
+run_frame(Filter &filter, int frame, bool batched)
+{
+	double t = frame * kImuPerFrame * kImuDt;
+
+	for (int i = 0; i < kImuPerFrame; i++) {
+		t += kImuDt;
+		filter.predict(kImuDt);
+		if (!batched) {
+			filter.correct_orientation(orientation_at(t), kOrientationVariance);
+		}
+	}
+	if (batched) {
+		filter.correct_orientation(orientation_at(t), kOrientationVariance);
+	}
+
+	filter.correct_position(position_at(t), kLeverArm, kPositionVariance);
+}
+
+template <typename Filter>
+static double
+run_and_get_error(int frames, bool batched)
+{
+	Filter filter;
+	for (int frame = 0; frame < frames; frame++) {
+		run_frame(filter, frame, batched);
+	}
+
+	double t = frames * kImuPerFrame * kImuDt;
+	return (filter.get_prediction(0).position - (position_at(t) - orientation_at(t) * kLeverArm)).norm();
+}
+
+TEST_CASE("psmv_fusion_accuracy")
+{
+	// Not a benchmark, makes sure the faster filters track as well.
+	double reference = run_and_get_error<PSMVUnscentedFilter>(600, false);
+	CHECK(reference < 0.01);
+	CHECK(run_and_get_error<PSMVBlockFilter<false>>(600, false) < 0.01);
+	CHECK(run_and_get_error<PSMVBlockFilter<false>>(600, true) < 0.01);
+	CHECK(run_and_get_error<PSMVBlockFilter<true>>(600, false) < 0.01);
+
+	// Both forms of the block filter are the same maths.
+	PSMVBlockFilter<false> normal;
+	PSMVBlockFilter<true> sqrt;
+	for (int frame = 0; frame < 120; frame++) {
+		run_frame(normal, frame, false);
+		run_frame(sqrt, frame, false);
+	}
+	CHECK(normal.error_covariance().isApprox(sqrt.error_covariance(), 1e-6));
+}
+
+TEST_CASE("psmv_fusion")
+{
+	int frame = 0;
+
+	PSMVUnscentedFilter unscented;
+	BENCHMARK("unscented frame")
+	{
+		run_frame(unscented, frame++, false);
+	};
+
+	PSMVBlockFilter<false> block;
+	BENCHMARK("block frame")
+	{
+		run_frame(block, frame++, false);
+	};
+
+	PSMVBlockFilter<false> block_batched;
+	BENCHMARK("block frame, imu batched")
+	{
+		run_frame(block_batched, frame++, true);
+	};
+
+	PSMVBlockFilter<true> block_sqrt;
+	BENCHMARK("block sqrt frame")
+	{
+		run_frame(block_sqrt, frame++, false);
+	};
+
+	BENCHMARK("unscented orientation correct")
+	{
+		return unscented.correct_orientation(orientation_at(0.5), kOrientationVariance);
+	};
+
+	BENCHMARK("block orientation correct")
+	{
+		return block.correct_orientation(orientation_at(0.5), kOrientationVariance);
+	};
+}
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# Copyright 2024, Collabora, Ltd.
+#
+# SPDX-License-Identifier: BSL-1.0
+"""Convert the XML report of monado-bench into a flat JSON list for trend tracking."""
+
+import argparse
+import json
+import xml.etree.ElementTree as ET
+
+
+def convert(root):
+    """Return one dict per benchmark, times in nanoseconds."""
+    results = []
+    for case in root.iter("TestCase"):
+        for bench in case.iter("BenchmarkResults"):
+            mean = bench.find("mean")
+            stddev = bench.find("standardDeviation")
+            results.append({
+                "name": "%s/%s" % (case.get("name"), bench.get("name")),
+                "samples": int(bench.get("samples")),
+                "iterations": int(bench.get("iterations")),
+                "mean_ns": float(mean.get("value")),
+                "mean_lower_ns": float(mean.get("lowerBound")),
+                "mean_upper_ns": float(mean.get("upperBound")),
+                "stddev_ns": float(stddev.get("value")),
+            })
+    return results
+
+
+def main():
+    """Handle command line and convert a file."""
+    parser = argparse.ArgumentParser(description="monado-bench XML to JSON.")
+    parser.add_argument("input", help="XML report from monado-bench -r xml")
+    parser.add_argument("output", help="JSON file to write")
+    args = parser.parse_args()
+
+    results = convert(ET.parse(args.input).getroot())
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump({"benchmarks": results}, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Benchmarks for hashset lookups, worker dispatch and format conversion.
+ */
+
+#include <util/u_frame.h>
+#include <util/u_hashset.h>
+#include <util/u_sink.h>
+#include <util/u_worker.h>
+
+#include "catch/catch.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+/*
+ *
+ * u_hashset
+ *
+ */
+
+static void
+free_callback(struct u_hashset_item *item, void *priv)
+{
+	free(item);
+}
+
+TEST_CASE("u_hashset")
+{
+	struct u_hashset *hs = NULL;
+	REQUIRE(u_hashset_create(&hs) == 0);
+
+	// Shaped like the input paths the state tracker looks up.
+	std::vector<std::string> paths;
+	for (int i = 0; i < 256; i++) {
+		char buf[64];
+		snprintf(buf, sizeof(buf), "/user/hand/%s/input/button_%d/click", i % 2 ? "left" : "right", i);
+		paths.push_back(buf);
+
+		struct u_hashset_item *item = NULL;
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, buf, &item) == 0);
+	}
+
+	size_t index = 0;
+
+	BENCHMARK("find hit")
+	{
+		struct u_hashset_item *item = NULL;
+		const std::string &path = paths[index++ % paths.size()];
+		return u_hashset_find_str(hs, path.c_str(), path.size(), &item);
+	};
+
+	BENCHMARK("find miss")
+	{
+		struct u_hashset_item *item = NULL;
+		return u_hashset_find_c_str(hs, "/user/hand/left/input/not_here/click", &item);
+	};
+
+	u_hashset_clear_and_call_for_each(hs, free_callback, NULL);
+	u_hashset_destroy(&hs);
+}
+
+
+/*
+ *
+ * u_worker
+ *
+ */
+
+static void
+empty_task(void *ptr)
+{
+	// Nothing, only measures the dispatch.
+}
+
+TEST_CASE("u_worker")
+{
+	struct u_worker_thread_pool *uwtp = u_worker_thread_pool_create(2, 3, "Bench");
+	REQUIRE(uwtp != NULL);
+	struct u_worker_group *uwg = u_worker_group_create(uwtp);
+	REQUIRE(uwg != NULL);
+
+	BENCHMARK("push and wait 1 task")
+	{
+		u_worker_group_push(uwg, empty_task, NULL);
+		u_worker_group_wait_all(uwg);
+	};
+
+	BENCHMARK("push and wait 16 tasks")
+	{
+		for (int i = 0; i < 16; i++) {
+			u_worker_group_push(uwg, empty_task, NULL);
+		}
+		u_worker_group_wait_all(uwg);
+	};
+
+	u_worker_group_reference(&uwg, NULL);
+	u_worker_thread_pool_reference(&uwtp, NULL);
+}
+
+
+/*
+ *
+ * u_sink_converter
+ *
+ */
+
+static void
+null_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	// Drops the frame, the converter does the work.
+}
+
+static void
+bench_convert(const char *name, enum xrt_format from, enum xrt_format to)
+{
+	struct xrt_frame_context xfctx = {};
+	struct xrt_frame_sink null_sink = {};
+	null_sink.push_frame = null_push_frame;
+
+	struct xrt_frame_sink *converter = NULL;
+	u_sink_create_format_converter(&xfctx, to, &null_sink, &converter);
+
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(from, 640, 480, &xf);
+	for (size_t i = 0; i < xf->size; i++) {
+		xf->data[i] = (uint8_t)(i * 7);
+	}
+
+	BENCHMARK(name)
+	{
+		xrt_sink_push_frame(converter, xf);
+	};
+
+	xrt_frame_reference(&xf, NULL);
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
+
+TEST_CASE("u_sink_converter 640x480")
+{
+	bench_convert("YUYV422 to R8G8B8", XRT_FORMAT_YUYV422, XRT_FORMAT_R8G8B8);
+	bench_convert("UYVY422 to R8G8B8", XRT_FORMAT_UYVY422, XRT_FORMAT_R8G8B8);
+	bench_convert("L8 to R8G8B8", XRT_FORMAT_L8, XRT_FORMAT_R8G8B8);
+}
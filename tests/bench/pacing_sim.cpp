@@ -0,0 +1,712 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Offline simulator that drives the app and compositor pacers with a workload.
+ *
+ * Models one app on top of the multi compositor: the same calls are made to
+ * @ref u_pacing_app and @ref u_pacing_compositor, in the same order, as
+ * comp_multi_system.c and comp_target_swapchain.c do. Time is simulated, so
+ * a run takes milliseconds and is fully determined by its seed.
+ */
+
+#include "pacing_sim.hpp"
+
+#include <util/u_time.h>
+
+#include "monado_metrics.pb.h"
+#include "pb_decode.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <random>
+
+
+namespace pacing_sim {
+
+namespace {
+
+/*
+ *
+ * Workloads.
+ *
+ */
+
+class synthetic_workload : public workload
+{
+public:
+	explicit synthetic_workload(const synthetic_params &params) : p(params), rng(params.seed) {}
+
+	void
+	next_app(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns) override
+	{
+		out_cpu_ns = sample(p.app_cpu_ns);
+		out_gpu_ns = sample(p.app_gpu_ns);
+
+		if (p.spike_every != 0 && ++app_count % p.spike_every == 0) {
+			out_cpu_ns += p.spike_ns;
+		}
+	}
+
+	void
+	next_compositor(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns, uint32_t &out_layer_count, bool &out_fast_path) override
+	{
+		out_cpu_ns = sample(p.comp_cpu_ns);
+		out_gpu_ns = sample(p.comp_gpu_ns);
+		out_layer_count = 1;
+		out_fast_path = true;
+
+		bool overlays = p.overlay_layers != 0 && p.overlay_period != 0 && (comp_count++ / p.overlay_period) % 2;
+		if (overlays) {
+			out_layer_count += p.overlay_layers;
+			out_fast_path = false;
+			out_gpu_ns += sample(p.layer_gpu_ns * out_layer_count);
+		}
+	}
+
+private:
+	uint64_t
+	sample(uint64_t mean_ns)
+	{
+		std::normal_distribution<double> dist((double)mean_ns, (double)mean_ns * p.jitter);
+		return (uint64_t)std::max(dist(rng), (double)mean_ns * 0.1);
+	}
+
+	synthetic_params p;
+	std::mt19937 rng;
+	uint32_t app_count = 0;
+	uint32_t comp_count = 0;
+};
+
+struct duration_pair
+{
+	uint64_t cpu_ns;
+	uint64_t gpu_ns;
+};
+
+struct compositor_sample
+{
+	uint64_t cpu_ns;
+	uint64_t gpu_ns;
+	bool squashed;
+};
+
+class trace_workload : public workload
+{
+public:
+	std::vector<duration_pair> app;
+	std::vector<compositor_sample> compositor;
+
+	void
+	next_app(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns) override
+	{
+		const duration_pair &d = app[app_index++ % app.size()];
+		out_cpu_ns = d.cpu_ns;
+		out_gpu_ns = d.gpu_ns;
+	}
+
+	void
+	next_compositor(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns, uint32_t &out_layer_count, bool &out_fast_path) override
+	{
+		const compositor_sample &d = compositor[compositor_index++ % compositor.size()];
+		out_cpu_ns = d.cpu_ns;
+		out_gpu_ns = d.gpu_ns;
+
+		// The trace only tells if layers were squashed, not how many there were.
+		out_layer_count = d.squashed ? 2 : 1;
+		out_fast_path = !d.squashed;
+	}
+
+private:
+	size_t app_index = 0;
+	size_t compositor_index = 0;
+};
+
+
+/*
+ *
+ * Simulation state.
+ *
+ */
+
+enum class event_kind
+{
+	comp_predict,
+	comp_woke,
+	comp_submit,
+	comp_gpu_done,
+	comp_info,
+	app_predict,
+	app_woke,
+	app_delivered,
+	app_gpu_done,
+};
+
+struct event
+{
+	uint64_t when_ns;
+	uint64_t seq; //!< Keeps events at the same time in the order they were queued.
+	event_kind kind;
+	int64_t frame_id;
+
+	bool
+	operator>(const event &other) const
+	{
+		return when_ns != other.when_ns ? when_ns > other.when_ns : seq > other.seq;
+	}
+};
+
+struct app_frame
+{
+	uint64_t wake_up_ns = 0;
+	uint64_t predicted_display_ns = 0;
+	uint64_t cpu_ns = 0;
+	uint64_t gpu_ns = 0;
+	uint64_t gpu_done_ns = 0;
+	uint64_t first_latch_ns = 0;
+	bool latched = false;
+	bool shown = false;
+	bool counted = false; //!< Started after the warm up.
+};
+
+struct comp_frame
+{
+	uint64_t wake_up_ns = 0;
+	uint64_t desired_present_ns = 0;
+	uint64_t predicted_display_ns = 0;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t cpu_ns = 0;
+	uint64_t gpu_ns = 0;
+	uint64_t gpu_start_ns = 0;
+	uint64_t gpu_end_ns = 0;
+	uint64_t actual_present_ns = 0;
+	uint64_t earliest_present_ns = 0;
+	int64_t latched_app_frame = -1;
+	bool counted = false;
+};
+
+distribution
+summarize(std::vector<int64_t> &samples)
+{
+	distribution d;
+	d.count = samples.size();
+	if (samples.empty()) {
+		return d;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (int64_t s : samples) {
+		sum += (double)s;
+	}
+
+	auto at = [&](double fraction) {
+		size_t index = std::min(samples.size() - 1, (size_t)(fraction * (double)samples.size()));
+		return time_ns_to_ms_f(samples[index]);
+	};
+
+	d.mean_ms = time_ns_to_ms_f((int64_t)(sum / (double)samples.size()));
+	d.p50_ms = at(0.50);
+	d.p95_ms = at(0.95);
+	d.p99_ms = at(0.99);
+	d.max_ms = time_ns_to_ms_f(samples.back());
+
+	return d;
+}
+
+class simulator
+{
+public:
+	simulator(const config &cfg, workload &work) : cfg(cfg), work(work), rng(cfg.seed) {}
+
+	results
+	run()
+	{
+		if (cfg.pacer == compositor_pacer::fake) {
+			u_pc_fake_create(cfg.period_ns, now_ns, &upc);
+		} else {
+			u_pc_display_timing_create(cfg.period_ns, &cfg.display_timing, &upc);
+		}
+
+		u_pa_factory_create(&upaf);
+		u_paf_create(upaf, &upa);
+
+		// The display has been scanning out for a while.
+		first_vblank_ns = now_ns + cfg.period_ns / 3;
+
+		push(now_ns, event_kind::comp_predict, -1);
+
+		while (!queue.empty() && comp_frame_count <= cfg.frames) {
+			event e = queue.top();
+			queue.pop();
+
+			now_ns = e.when_ns;
+			handle(e);
+		}
+
+		u_pa_destroy(&upa);
+		u_paf_destroy(&upaf);
+		u_pc_destroy(&upc);
+
+		return collect();
+	}
+
+private:
+	void
+	push(uint64_t when_ns, event_kind kind, int64_t frame_id)
+	{
+		queue.push({when_ns, seq++, kind, frame_id});
+	}
+
+	uint64_t
+	oversleep(uint64_t wake_up_ns)
+	{
+		std::uniform_int_distribution<uint64_t> dist(0, cfg.wake_jitter_ns);
+		return std::max(now_ns, wake_up_ns) + dist(rng);
+	}
+
+	//! First vblank at or after @p when_ns.
+	uint64_t
+	next_vblank(uint64_t when_ns) const
+	{
+		if (when_ns <= first_vblank_ns) {
+			return first_vblank_ns;
+		}
+		uint64_t periods = (when_ns - first_vblank_ns + cfg.period_ns - 1) / cfg.period_ns;
+		return first_vblank_ns + periods * cfg.period_ns;
+	}
+
+	void
+	handle(const event &e)
+	{
+		switch (e.kind) {
+		case event_kind::comp_predict: comp_predict(); break;
+		case event_kind::comp_woke: comp_woke(e.frame_id); break;
+		case event_kind::comp_submit: comp_submit(e.frame_id); break;
+		case event_kind::comp_gpu_done: comp_gpu_done(e.frame_id); break;
+		case event_kind::comp_info: comp_info(e.frame_id); break;
+		case event_kind::app_predict: app_predict(); break;
+		case event_kind::app_woke: app_woke(e.frame_id); break;
+		case event_kind::app_delivered: app_delivered(e.frame_id); break;
+		case event_kind::app_gpu_done: app_gpu_done(e.frame_id); break;
+		}
+	}
+
+
+	/*
+	 *
+	 * Compositor, the multi compositor render thread and the main compositor target.
+	 *
+	 */
+
+	void
+	comp_predict()
+	{
+		int64_t frame_id = -1;
+		comp_frame f;
+		uint64_t present_slop_ns = 0;
+		uint64_t min_display_period_ns = 0;
+
+		u_pc_predict(upc, now_ns, &frame_id, &f.wake_up_ns, &f.desired_present_ns, &present_slop_ns,
+		             &f.predicted_display_ns, &f.predicted_display_period_ns, &min_display_period_ns);
+
+		f.counted = comp_frame_count++ >= cfg.warmup_frames;
+		comp_frames[frame_id] = f;
+
+		push(oversleep(f.wake_up_ns), event_kind::comp_woke, frame_id);
+	}
+
+	void
+	comp_woke(int64_t frame_id)
+	{
+		comp_frame &f = comp_frames[frame_id];
+
+		u_pc_mark_point(upc, U_TIMING_POINT_WAKE_UP, frame_id, now_ns);
+
+		// The multi compositor broadcasts to the app pacers once woken.
+		u_pa_info(upa, f.predicted_display_ns, f.predicted_display_period_ns, f.predicted_display_ns - now_ns);
+
+		if (!app_started) {
+			app_started = true;
+			push(now_ns, event_kind::app_predict, -1);
+		}
+
+		u_pc_mark_point(upc, U_TIMING_POINT_BEGIN, frame_id, now_ns);
+
+		latch(frame_id, f);
+
+		uint32_t layer_count = 0;
+		bool fast_path = false;
+		work.next_compositor(f.cpu_ns, f.gpu_ns, layer_count, fast_path);
+		if (cfg.report_layers) {
+			u_pc_info_layers(upc, frame_id, layer_count, fast_path);
+		}
+
+		push(now_ns + f.cpu_ns, event_kind::comp_submit, frame_id);
+	}
+
+	void
+	latch(int64_t frame_id, comp_frame &f)
+	{
+		// Move any frames meant for this display time to delivered, like slot_move_and_clear_locked.
+		while (!scheduled.empty()) {
+			app_frame &a = app_frames[scheduled.front()];
+			if (a.predicted_display_ns > f.predicted_display_ns + U_TIME_HALF_MS_IN_NS) {
+				break;
+			}
+
+			if (delivered >= 0) {
+				u_pa_retired(upa, delivered, now_ns);
+			}
+			delivered = scheduled.front();
+			scheduled.pop_front();
+		}
+
+		if (delivered < 0) {
+			f.latched_app_frame = -1;
+			return;
+		}
+
+		app_frame &a = app_frames[delivered];
+		if (!a.latched) {
+			a.latched = true;
+			a.first_latch_ns = now_ns;
+		}
+
+		u_pa_latched(upa, delivered, now_ns, frame_id);
+		f.latched_app_frame = delivered;
+	}
+
+	void
+	comp_submit(int64_t frame_id)
+	{
+		comp_frame &f = comp_frames[frame_id];
+
+		u_pc_mark_point(upc, U_TIMING_POINT_SUBMIT_BEGIN, frame_id, now_ns);
+		u_pc_mark_point(upc, U_TIMING_POINT_SUBMIT_END, frame_id, now_ns);
+
+		f.gpu_start_ns = std::max(now_ns, comp_gpu_free_ns);
+		f.gpu_end_ns = f.gpu_start_ns + f.gpu_ns;
+		comp_gpu_free_ns = f.gpu_end_ns;
+
+		// FIFO present that honours the desired present time.
+		f.earliest_present_ns = next_vblank(f.gpu_end_ns);
+		f.actual_present_ns = next_vblank(std::max(f.gpu_end_ns, f.desired_present_ns - cfg.period_ns / 2));
+
+		push(f.gpu_end_ns, event_kind::comp_gpu_done, frame_id);
+
+		// The timing information arrives a little while after scanout.
+		push(f.actual_present_ns + U_TIME_1MS_IN_NS, event_kind::comp_info, frame_id);
+
+		// The render loop goes straight to predicting the next frame.
+		push(now_ns, event_kind::comp_predict, -1);
+	}
+
+	void
+	comp_gpu_done(int64_t frame_id)
+	{
+		comp_frame &f = comp_frames[frame_id];
+
+		u_pc_info_gpu(upc, frame_id, f.gpu_start_ns, f.gpu_end_ns, 0, 0, now_ns);
+	}
+
+	void
+	comp_info(int64_t frame_id)
+	{
+		comp_frame &f = comp_frames[frame_id];
+
+		u_pc_info(upc, frame_id, f.desired_present_ns, f.actual_present_ns, f.earliest_present_ns,
+		          f.earliest_present_ns - f.gpu_end_ns, now_ns);
+
+		// Like a vblank event from VK_EXT_display_control, only the fake pacer uses it.
+		u_pc_update_vblank_from_display_control(upc, f.actual_present_ns);
+
+		record_compositor_frame(f);
+		comp_frames.erase(frame_id);
+	}
+
+	void
+	record_compositor_frame(const comp_frame &f)
+	{
+		// What the display shows at the predicted display time of this frame.
+		uint64_t display_ns = f.actual_present_ns + (f.predicted_display_ns - f.desired_present_ns);
+
+		bool is_new = false;
+		if (f.latched_app_frame >= 0) {
+			app_frame &a = app_frames[f.latched_app_frame];
+			is_new = !a.shown;
+
+			if (is_new) {
+				a.shown = true;
+				if (a.counted) {
+					app_latency.push_back((int64_t)(display_ns - a.wake_up_ns));
+					app_display_error.push_back((int64_t)display_ns - (int64_t)a.predicted_display_ns);
+					app_margin.push_back((int64_t)(a.first_latch_ns - a.gpu_done_ns));
+
+					if (display_ns > a.predicted_display_ns + cfg.period_ns / 2) {
+						r.app_late++;
+					}
+				}
+			}
+		}
+
+		if (!f.counted) {
+			return;
+		}
+
+		r.compositor_frames++;
+		if (f.actual_present_ns > f.desired_present_ns + U_TIME_HALF_MS_IN_NS) {
+			r.compositor_missed++;
+		}
+		if (!is_new) {
+			r.compositor_repeated++;
+		}
+		compositor_margin.push_back((int64_t)f.desired_present_ns - (int64_t)f.gpu_end_ns);
+	}
+
+
+	/*
+	 *
+	 * App, the thread calling xrWaitFrame, xrBeginFrame and xrEndFrame.
+	 *
+	 */
+
+	void
+	app_predict()
+	{
+		int64_t frame_id = -1;
+		app_frame a;
+		uint64_t predicted_display_period_ns = 0;
+
+		u_pa_predict(upa, now_ns, &frame_id, &a.wake_up_ns, &a.predicted_display_ns,
+		             &predicted_display_period_ns);
+
+		a.counted = comp_frame_count > cfg.warmup_frames;
+		app_frames[frame_id] = a;
+
+		push(oversleep(a.wake_up_ns), event_kind::app_woke, frame_id);
+	}
+
+	void
+	app_woke(int64_t frame_id)
+	{
+		app_frame &a = app_frames[frame_id];
+
+		// Measured from when the app actually got to run.
+		a.wake_up_ns = now_ns;
+
+		u_pa_mark_point(upa, frame_id, U_TIMING_POINT_WAKE_UP, now_ns);
+		u_pa_mark_point(upa, frame_id, U_TIMING_POINT_BEGIN, now_ns);
+
+		work.next_app(a.cpu_ns, a.gpu_ns);
+		push(now_ns + a.cpu_ns, event_kind::app_delivered, frame_id);
+	}
+
+	void
+	app_delivered(int64_t frame_id)
+	{
+		app_frame &a = app_frames[frame_id];
+
+		u_pa_mark_delivered(upa, frame_id, now_ns, a.predicted_display_ns);
+
+		uint64_t gpu_start_ns = std::max(now_ns, app_gpu_free_ns);
+		app_gpu_free_ns = gpu_start_ns + a.gpu_ns;
+		push(app_gpu_free_ns, event_kind::app_gpu_done, frame_id);
+
+		// Straight back into xrWaitFrame.
+		push(now_ns, event_kind::app_predict, -1);
+	}
+
+	void
+	app_gpu_done(int64_t frame_id)
+	{
+		app_frame &a = app_frames[frame_id];
+		a.gpu_done_ns = now_ns;
+
+		u_pa_mark_gpu_done(upa, frame_id, now_ns);
+
+		scheduled.push_back(frame_id);
+	}
+
+
+	/*
+	 *
+	 * Results.
+	 *
+	 */
+
+	results
+	collect()
+	{
+		for (const auto &kv : app_frames) {
+			const app_frame &a = kv.second;
+			if (!a.counted || a.gpu_done_ns == 0) {
+				// Still in flight when the simulation stopped.
+				continue;
+			}
+
+			r.app_frames++;
+			if (!a.latched && kv.first < delivered) {
+				r.app_dropped++;
+			}
+		}
+
+		r.app_latency = summarize(app_latency);
+		r.app_display_error = summarize(app_display_error);
+		r.app_margin = summarize(app_margin);
+		r.compositor_margin = summarize(compositor_margin);
+
+		return r;
+	}
+
+	const config &cfg;
+	workload &work;
+	std::mt19937 rng;
+
+	struct u_pacing_compositor *upc = nullptr;
+	struct u_pacing_app_factory *upaf = nullptr;
+	struct u_pacing_app *upa = nullptr;
+
+	std::priority_queue<event, std::vector<event>, std::greater<event>> queue;
+	uint64_t seq = 0;
+
+	//! Arbitrary but not zero, the pacers treat zero as not set.
+	uint64_t now_ns = U_TIME_1S_IN_NS;
+	uint64_t first_vblank_ns = 0;
+	uint64_t comp_gpu_free_ns = 0;
+	uint64_t app_gpu_free_ns = 0;
+	uint32_t comp_frame_count = 0;
+	bool app_started = false;
+
+	std::map<int64_t, comp_frame> comp_frames;
+	std::map<int64_t, app_frame> app_frames;
+
+	//! App frames done on the GPU, waiting for their display time, oldest first.
+	std::deque<int64_t> scheduled;
+	//! App frame the compositor is showing, -1 for none.
+	int64_t delivered = -1;
+
+	results r;
+	std::vector<int64_t> app_latency;
+	std::vector<int64_t> app_display_error;
+	std::vector<int64_t> app_margin;
+	std::vector<int64_t> compositor_margin;
+};
+
+void
+print_distribution(FILE *file, const char *name, const distribution &d)
+{
+	fprintf(file, "  %-22s %8.3f %8.3f %8.3f %8.3f %8.3f\n", name, d.mean_ms, d.p50_ms, d.p95_ms, d.p99_ms,
+	        d.max_ms);
+}
+
+double
+percent(uint32_t part, uint32_t total)
+{
+	return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+} // namespace
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+std::unique_ptr<workload>
+make_synthetic_workload(const synthetic_params &params)
+{
+	return std::make_unique<synthetic_workload>(params);
+}
+
+std::unique_ptr<workload>
+load_metrics_workload(const char *path, std::string &out_error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		out_error = std::string("Could not open '") + path + "'";
+		return nullptr;
+	}
+
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	auto trace = std::make_unique<trace_workload>();
+	std::map<int64_t, uint64_t> comp_cpu_ns;
+
+	// Records are written back to back, each prefixed with its length.
+	pb_istream_t stream = pb_istream_from_buffer(data.data(), data.size());
+	while (stream.bytes_left > 0) {
+		monado_metrics_Record record = monado_metrics_Record_init_zero;
+		if (!pb_decode_delimited(&stream, monado_metrics_Record_fields, &record)) {
+			// A trace cut short when the service was killed, keep what we have.
+			break;
+		}
+
+		switch (record.which_record) {
+		case monado_metrics_Record_session_frame_tag: {
+			const monado_metrics_SessionFrame &sf = record.record.session_frame;
+			if (sf.discarded || sf.when_begin_ns == 0 || sf.when_delivered_ns < sf.when_begin_ns ||
+			    sf.when_gpu_done_ns < sf.when_delivered_ns) {
+				break;
+			}
+			// GPU time is only known as from delivery until done, which includes any queueing.
+			trace->app.push_back({sf.when_delivered_ns - sf.when_begin_ns,
+			                      sf.when_gpu_done_ns - sf.when_delivered_ns});
+		} break;
+		case monado_metrics_Record_system_present_info_tag: {
+			const monado_metrics_SystemPresentInfo &pi = record.record.system_present_info;
+			if (pi.when_began_ns != 0 && pi.when_submitted_ns >= pi.when_began_ns) {
+				comp_cpu_ns[pi.frame_id] = pi.when_submitted_ns - pi.when_began_ns;
+			}
+		} break;
+		case monado_metrics_Record_system_gpu_info_tag: {
+			const monado_metrics_SystemGpuInfo &gi = record.record.system_gpu_info;
+			auto it = comp_cpu_ns.find(gi.frame_id);
+			if (it != comp_cpu_ns.end() && gi.gpu_end_ns >= gi.gpu_start_ns) {
+				trace->compositor.push_back(
+				    {it->second, gi.gpu_end_ns - gi.gpu_start_ns, gi.layer_squash_ns != 0});
+				comp_cpu_ns.erase(it);
+			}
+		} break;
+		default: break;
+		}
+	}
+
+	if (trace->app.empty() || trace->compositor.empty()) {
+		out_error = std::string("No complete app and compositor frames in '") + path + "'";
+		return nullptr;
+	}
+
+	return trace;
+}
+
+results
+run(const config &cfg, workload &work)
+{
+	simulator sim(cfg, work);
+	return sim.run();
+}
+
+void
+print_results(FILE *file, const results &r)
+{
+	fprintf(file, "Compositor frames: %u, missed: %u (%.2f%%), without new app frame: %u (%.2f%%)\n",
+	        r.compositor_frames, r.compositor_missed, percent(r.compositor_missed, r.compositor_frames),
+	        r.compositor_repeated, percent(r.compositor_repeated, r.compositor_frames));
+	fprintf(file, "App frames: %u, late: %u (%.2f%%), dropped: %u (%.2f%%)\n", r.app_frames, r.app_late,
+	        percent(r.app_late, r.app_frames), r.app_dropped, percent(r.app_dropped, r.app_frames));
+	fprintf(file, "  %-22s %8s %8s %8s %8s %8s\n", "[ms]", "mean", "p50", "p95", "p99", "max");
+	print_distribution(file, "app latency", r.app_latency);
+	print_distribution(file, "app display error", r.app_display_error);
+	print_distribution(file, "app margin", r.app_margin);
+	print_distribution(file, "compositor margin", r.compositor_margin);
+}
+
+} // namespace pacing_sim
@@ -0,0 +1,150 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Offline simulator that drives the app and compositor pacers with a workload.
+ */
+
+#pragma once
+
+#include <util/u_pacing.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace pacing_sim {
+
+//! Which @ref u_pacing_compositor implementation to simulate.
+enum class compositor_pacer
+{
+	display_timing,
+	fake,
+};
+
+/*!
+ * Source of how long each frame takes, the simulator asks for the durations
+ * of every app and compositor frame as it starts them.
+ */
+struct workload
+{
+	virtual ~workload() = default;
+
+	virtual void
+	next_app(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns) = 0;
+
+	//! Also gives the layers the compositor renders, as reported with @ref u_pc_info_layers.
+	virtual void
+	next_compositor(uint64_t &out_cpu_ns, uint64_t &out_gpu_ns, uint32_t &out_layer_count, bool &out_fast_path) = 0;
+};
+
+/*!
+ * Normally distributed frame times with the occasional spike, like a shader
+ * compile or an asset load in the app.
+ */
+struct synthetic_params
+{
+	uint64_t app_cpu_ns = 4'000'000;
+	uint64_t app_gpu_ns = 6'000'000;
+	uint64_t comp_cpu_ns = 500'000;
+	uint64_t comp_gpu_ns = 1'500'000;
+
+	//! Standard deviation of all durations, as a fraction of their mean.
+	double jitter = 0.05;
+
+	//! Every this many app frames gets @ref spike_ns added to its CPU time, 0 disables.
+	uint32_t spike_every = 0;
+	uint64_t spike_ns = 0;
+
+	/*!
+	 * Alternate between just the projection layer and that plus this many
+	 * overlays every @ref overlay_period compositor frames, 0 disables.
+	 * Squashing costs @ref layer_gpu_ns of compositor GPU time per layer.
+	 */
+	uint32_t overlay_layers = 0;
+	uint32_t overlay_period = 120;
+	uint64_t layer_gpu_ns = 500'000;
+
+	uint32_t seed = 1;
+};
+
+std::unique_ptr<workload>
+make_synthetic_workload(const synthetic_params &params);
+
+/*!
+ * Replays the measured durations from a file written by @ref u_metrics, in
+ * order and looping when it runs out. Returns nullptr and sets @p out_error
+ * if the file has no usable app and compositor frames.
+ */
+std::unique_ptr<workload>
+load_metrics_workload(const char *path, std::string &out_error);
+
+struct config
+{
+	compositor_pacer pacer = compositor_pacer::display_timing;
+	struct u_pc_display_timing_config display_timing = U_PC_DISPLAY_TIMING_CONFIG_DEFAULT;
+
+	//! Refresh period of the simulated display.
+	uint64_t period_ns = 11'111'111;
+
+	//! Threads oversleep their wake up time by up to this much, uniformly distributed.
+	uint64_t wake_jitter_ns = 200'000;
+
+	//! Tell the compositor pacer which layers are rendered, to compare with it not knowing.
+	bool report_layers = true;
+
+	//! Compositor frames to simulate, and how many at the start to leave out of the results.
+	uint32_t frames = 2000;
+	uint32_t warmup_frames = 100;
+
+	uint32_t seed = 1;
+};
+
+//! Summary of a set of durations, in milliseconds.
+struct distribution
+{
+	size_t count = 0;
+	double mean_ms = 0;
+	double p50_ms = 0;
+	double p95_ms = 0;
+	double p99_ms = 0;
+	double max_ms = 0;
+};
+
+struct results
+{
+	//! Compositor frames and how many were presented after their desired present time.
+	uint32_t compositor_frames = 0;
+	uint32_t compositor_missed = 0;
+
+	//! Compositor frames that had no new app frame to show.
+	uint32_t compositor_repeated = 0;
+
+	//! App frames, how many were shown later than predicted and how many were never shown.
+	uint32_t app_frames = 0;
+	uint32_t app_late = 0;
+	uint32_t app_dropped = 0;
+
+	//! From the app waking up for a frame until it was first shown.
+	distribution app_latency;
+
+	//! How much later than the predicted display time an app frame was first shown.
+	distribution app_display_error;
+
+	//! From the app GPU finishing until the compositor latched the frame, waking up too early shows up here.
+	distribution app_margin;
+
+	//! From the compositor GPU finishing until its desired present time, negative when missed.
+	distribution compositor_margin;
+};
+
+results
+run(const config &cfg, workload &work);
+
+void
+print_results(FILE *file, const results &r);
+
+} // namespace pacing_sim
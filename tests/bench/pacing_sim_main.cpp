@@ -0,0 +1,149 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Command line front end for the frame pacing simulator.
+ */
+
+#include "pacing_sim.hpp"
+
+#include <util/u_time.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+static void
+print_usage(const char *argv0)
+{
+	fprintf(stderr,
+	        "Usage: %s [options]\n"
+	        "Runs the frame pacers against a simulated app and display.\n"
+	        "\n"
+	        "Workload, synthetic unless a trace is given:\n"
+	        "  --trace <file>          Replay the frame times of an XRT_METRICS_FILE recording\n"
+	        "  --app-cpu <ms>          App CPU time per frame\n"
+	        "  --app-gpu <ms>          App GPU time per frame\n"
+	        "  --comp-cpu <ms>         Compositor CPU time per frame\n"
+	        "  --comp-gpu <ms>         Compositor GPU time per frame\n"
+	        "  --jitter <fraction>     Standard deviation of all times, relative to their mean\n"
+	        "  --spike-every <frames>  Add a spike to the app CPU time every this many frames\n"
+	        "  --spike <ms>            Length of the spikes\n"
+	        "  --overlays <count>      Alternate between no overlays and this many\n"
+	        "  --overlay-period <n>    Compositor frames between switching overlays\n"
+	        "  --layer-gpu <ms>        Compositor GPU time for squashing each layer\n"
+	        "\n"
+	        "Simulation:\n"
+	        "  --pacer <name>          Compositor pacer, display-timing or fake\n"
+	        "  --margin <ms>           Display timing pacer margin\n"
+	        "  --comp-time <percent>   Display timing pacer initial compositor time, of the period\n"
+	        "  --no-layers             Don't tell the compositor pacer what layers are rendered\n"
+	        "  --hz <rate>             Display refresh rate\n"
+	        "  --wake-jitter <ms>      Most a thread oversleeps its wake up time by\n"
+	        "  --frames <count>        Compositor frames to simulate\n"
+	        "  --warmup <count>        Compositor frames to leave out of the results\n"
+	        "  --seed <seed>           Random seed for the workload and wake up jitter\n",
+	        argv0);
+}
+
+static uint64_t
+ms_to_ns(const char *str)
+{
+	return (uint64_t)time_ms_f_to_ns(strtod(str, NULL));
+}
+
+int
+main(int argc, const char **argv)
+{
+	pacing_sim::config cfg;
+	pacing_sim::synthetic_params params;
+	const char *trace_path = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+			print_usage(argv[0]);
+			return 0;
+		}
+
+		if (strcmp(arg, "--no-layers") == 0) {
+			cfg.report_layers = false;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			print_usage(argv[0]);
+			return 1;
+		}
+		const char *value = argv[++i];
+
+		if (strcmp(arg, "--trace") == 0) {
+			trace_path = value;
+		} else if (strcmp(arg, "--app-cpu") == 0) {
+			params.app_cpu_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--app-gpu") == 0) {
+			params.app_gpu_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--comp-cpu") == 0) {
+			params.comp_cpu_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--comp-gpu") == 0) {
+			params.comp_gpu_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--jitter") == 0) {
+			params.jitter = strtod(value, NULL);
+		} else if (strcmp(arg, "--spike-every") == 0) {
+			params.spike_every = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--spike") == 0) {
+			params.spike_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--overlays") == 0) {
+			params.overlay_layers = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--overlay-period") == 0) {
+			params.overlay_period = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--layer-gpu") == 0) {
+			params.layer_gpu_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--pacer") == 0) {
+			if (strcmp(value, "fake") == 0) {
+				cfg.pacer = pacing_sim::compositor_pacer::fake;
+			} else if (strcmp(value, "display-timing") == 0) {
+				cfg.pacer = pacing_sim::compositor_pacer::display_timing;
+			} else {
+				fprintf(stderr, "Unknown pacer '%s'\n", value);
+				return 1;
+			}
+		} else if (strcmp(arg, "--margin") == 0) {
+			cfg.display_timing.margin_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--comp-time") == 0) {
+			cfg.display_timing.comp_time_fraction = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--hz") == 0) {
+			cfg.period_ns = (uint64_t)((double)U_TIME_1S_IN_NS / strtod(value, NULL));
+		} else if (strcmp(arg, "--wake-jitter") == 0) {
+			cfg.wake_jitter_ns = ms_to_ns(value);
+		} else if (strcmp(arg, "--frames") == 0) {
+			cfg.frames = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--warmup") == 0) {
+			cfg.warmup_frames = (uint32_t)strtoul(value, NULL, 10);
+		} else if (strcmp(arg, "--seed") == 0) {
+			cfg.seed = params.seed = (uint32_t)strtoul(value, NULL, 10);
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::unique_ptr<pacing_sim::workload> work;
+	if (trace_path != nullptr) {
+		std::string error;
+		work = pacing_sim::load_metrics_workload(trace_path, error);
+		if (!work) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+	} else {
+		work = pacing_sim::make_synthetic_workload(params);
+	}
+
+	pacing_sim::results r = pacing_sim::run(cfg, *work);
+	pacing_sim::print_results(stdout, r);
+
+	return 0;
+}
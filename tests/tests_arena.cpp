@@ -0,0 +1,90 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the linear arena allocator.
+ */
+
+#include "catch/catch.hpp"
+#include "util/u_arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+TEST_CASE("u_arena")
+{
+	struct u_arena arena;
+	u_arena_init(&arena, 256);
+
+	SECTION("alignment")
+	{
+		for (size_t align = 1; align <= 256; align *= 2) {
+			(void)u_arena_alloc(&arena, 1, 1);
+			void *ptr = u_arena_alloc(&arena, 3, align);
+			REQUIRE(ptr != NULL);
+			CHECK(((uintptr_t)ptr & (align - 1)) == 0);
+		}
+	}
+
+	SECTION("allocations don't overlap")
+	{
+		uint8_t *ptrs[64];
+		for (int i = 0; i < 64; i++) {
+			ptrs[i] = (uint8_t *)u_arena_alloc(&arena, 24, 8);
+			REQUIRE(ptrs[i] != NULL);
+			memset(ptrs[i], i, 24);
+		}
+		for (int i = 0; i < 64; i++) {
+			for (int k = 0; k < 24; k++) {
+				CHECK(ptrs[i][k] == i);
+			}
+		}
+	}
+
+	SECTION("typed arrays are zeroed")
+	{
+		uint64_t *a = U_ARENA_TYPED_ARRAY_CALLOC(&arena, uint64_t, 100);
+		REQUIRE(a != NULL);
+		CHECK(((uintptr_t)a & (alignof(uint64_t) - 1)) == 0);
+		for (int i = 0; i < 100; i++) {
+			CHECK(a[i] == 0);
+		}
+
+		CHECK(u_arena_calloc(&arena, SIZE_MAX / 2, 4, 0) == NULL);
+	}
+
+	SECTION("reset reuses memory")
+	{
+		void *first = u_arena_alloc(&arena, 64, 0);
+		u_arena_reset(&arena);
+		CHECK(u_arena_alloc(&arena, 64, 0) == first);
+	}
+
+	SECTION("reset merges blocks")
+	{
+		// Goes over the first block a few times.
+		for (int i = 0; i < 10; i++) {
+			REQUIRE(u_arena_alloc(&arena, 200, 0) != NULL);
+		}
+		u_arena_reset(&arena);
+
+		// Now all of it fits in one block.
+		uint8_t *first = (uint8_t *)u_arena_alloc(&arena, 200, 1);
+		for (int i = 1; i < 10; i++) {
+			uint8_t *ptr = (uint8_t *)u_arena_alloc(&arena, 200, 1);
+			CHECK(ptr == first + i * 200);
+		}
+	}
+
+	SECTION("bigger than a block")
+	{
+		uint8_t *ptr = (uint8_t *)u_arena_alloc(&arena, 4096, 0);
+		REQUIRE(ptr != NULL);
+		memset(ptr, 0xff, 4096);
+		CHECK(u_arena_alloc(&arena, 0, 0) != NULL);
+	}
+
+	u_arena_fini(&arena);
+	CHECK(arena.current == NULL);
+}
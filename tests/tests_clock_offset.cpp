@@ -0,0 +1,62 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the clock tracker.
+ */
+
+#include <math/m_clock_offset.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <random>
+
+
+TEST_CASE("m_clock_tracker")
+{
+	struct m_clock_tracker ct;
+	m_clock_tracker_init(&ct, 0, 0);
+
+	SECTION("empty")
+	{
+		CHECK(m_clock_tracker_get_a2b(&ct, 1234) == 0);
+	}
+
+	SECTION("drift, jitter and outliers")
+	{
+		std::mt19937 gen(1234);
+		std::uniform_int_distribution<int64_t> delay_ns(100 * 1000, 2 * U_TIME_1MS_IN_NS);
+
+		// Device clock runs 50ppm fast and starts at zero, host is at 10s.
+		const timepoint_ns host_start = 10 * (timepoint_ns)U_TIME_1S_IN_NS;
+		auto device_to_host = [&](timepoint_ns device) {
+			return host_start + device - (timepoint_ns)((double)device * 50e-6);
+		};
+
+		// Five seconds of 1kHz IMU samples.
+		for (timepoint_ns device = 0; device < 5 * (timepoint_ns)U_TIME_1S_IN_NS; device += U_TIME_1MS_IN_NS) {
+			timepoint_ns received = device_to_host(device) + delay_ns(gen);
+
+			// Every now and then a sample is stuck in the USB stack.
+			if ((device / U_TIME_1MS_IN_NS) % 97 == 0) {
+				received += 15 * U_TIME_1MS_IN_NS;
+			}
+
+			m_clock_tracker_add_sample(&ct, device, received);
+		}
+
+		// Within the smallest delay, plus a bit for the fit.
+		timepoint_ns device = 5 * (timepoint_ns)U_TIME_1S_IN_NS;
+		timepoint_ns expected = device_to_host(device);
+		timepoint_ns got = device + m_clock_tracker_get_a2b(&ct, device);
+		CHECK(got - expected >= 0);
+		CHECK(got - expected < 300 * 1000);
+
+		// And the drift keeps it accurate a little while without samples.
+		device += U_TIME_1S_IN_NS;
+		expected = device_to_host(device);
+		got = device + m_clock_tracker_get_a2b(&ct, device);
+		CHECK(std::abs(got - expected) < 300 * 1000);
+	}
+}
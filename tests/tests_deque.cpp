@@ -56,4 +56,43 @@ TEST_CASE("u_deque")
 		u_deque_timepoint_ns_destroy(&dt);
 		CHECK(dt.ptr == NULL);
 	}
+
+	SECTION("Wraps around and grows while wrapped")
+	{
+		struct u_deque_timepoint_ns dt = u_deque_timepoint_ns_create();
+		timepoint_ns next_push = 0;
+		timepoint_ns next_pop = 0;
+		timepoint_ns elem = 0;
+
+		// Move the front into the middle of the inline storage.
+		for (int i = 0; i < U_DEQUE_INLINE_CAPACITY / 2; i++) {
+			u_deque_timepoint_ns_push_back(dt, next_push++);
+			CHECK(u_deque_timepoint_ns_pop_front(dt, &elem));
+			CHECK(elem == next_pop++);
+		}
+
+		// Wraps, then grows with the elements split over the end.
+		for (int i = 0; i < U_DEQUE_INLINE_CAPACITY * 3; i++) {
+			u_deque_timepoint_ns_push_back(dt, next_push++);
+		}
+		CHECK(u_deque_timepoint_ns_size(dt) == U_DEQUE_INLINE_CAPACITY * 3);
+
+		bool all_equal = true;
+		for (size_t i = 0; i < u_deque_timepoint_ns_size(dt); i++) {
+			all_equal = all_equal && u_deque_timepoint_ns_at(dt, i) == next_pop + (timepoint_ns)i;
+		}
+		CHECK(all_equal);
+
+		while (u_deque_timepoint_ns_pop_front(dt, &elem)) {
+			all_equal = all_equal && elem == next_pop++;
+		}
+		CHECK(all_equal);
+		CHECK(next_pop == next_push);
+
+		u_deque_timepoint_ns_push_back(dt, next_push);
+		u_deque_timepoint_ns_clear(dt);
+		CHECK(u_deque_timepoint_ns_size(dt) == 0);
+
+		u_deque_timepoint_ns_destroy(&dt);
+	}
 }
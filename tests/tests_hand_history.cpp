@@ -0,0 +1,194 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the hand joint set history.
+ */
+
+#include <math/m_api.h>
+#include <math/m_hand_history.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+
+static constexpr uint64_t T0 = 10 * (uint64_t)U_TIME_1S_IN_NS;
+static constexpr uint64_t STEP = 33 * (uint64_t)U_TIME_1MS_IN_NS;
+
+/*!
+ * A hand with the wrist at @p x, turned @p angle around Y, and the index tip
+ * 10 cm in front of it bent by @p bend around X.
+ */
+static struct xrt_hand_joint_set
+make_hand(float x, float angle, float bend)
+{
+	struct xrt_hand_joint_set set = {};
+	set.is_active = true;
+	set.hand_pose.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
+	set.hand_pose.pose.orientation.w = 1.f;
+
+	const enum xrt_space_relation_flags flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+
+	struct xrt_pose wrist = XRT_POSE_IDENTITY;
+	wrist.position.x = x;
+	struct xrt_vec3 up = {0.f, 1.f, 0.f};
+	math_quat_from_angle_vector(angle, &up, &wrist.orientation);
+
+	struct xrt_pose local = XRT_POSE_IDENTITY;
+	local.position.z = -0.1f;
+	struct xrt_vec3 right = {1.f, 0.f, 0.f};
+	math_quat_from_angle_vector(bend, &right, &local.orientation);
+
+	struct xrt_pose identity = XRT_POSE_IDENTITY;
+
+	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		struct xrt_hand_joint_value *joint = &set.values.hand_joint_set_default[i];
+		joint->relation.relation_flags = flags;
+		joint->radius = 0.01f;
+		math_pose_transform(&wrist, i == XRT_HAND_JOINT_WRIST ? &identity : &local, &joint->relation.pose);
+	}
+
+	return set;
+}
+
+static const struct xrt_space_relation &
+joint(const struct xrt_hand_joint_set &set, enum xrt_hand_joint j)
+{
+	return set.values.hand_joint_set_default[j].relation;
+}
+
+TEST_CASE("m_hand_history")
+{
+	struct m_hand_history *hh = NULL;
+	m_hand_history_create(&hh, 4);
+	REQUIRE(hh != NULL);
+
+	struct xrt_hand_joint_set out = {};
+	uint64_t out_ts = 0;
+
+	SECTION("empty")
+	{
+		CHECK(m_hand_history_get(hh, T0, &out, &out_ts) == M_RELATION_HISTORY_RESULT_INVALID);
+		CHECK_FALSE(out.is_active);
+		CHECK_FALSE(m_hand_history_get_latest(hh, &out_ts, &out));
+	}
+
+	SECTION("rejects old timestamps")
+	{
+		struct xrt_hand_joint_set hand = make_hand(0.f, 0.f, 0.f);
+		CHECK(m_hand_history_push(hh, &hand, T0));
+		CHECK_FALSE(m_hand_history_push(hh, &hand, T0));
+		CHECK_FALSE(m_hand_history_push(hh, &hand, T0 - STEP));
+		CHECK(m_hand_history_get_size(hh) == 1);
+	}
+
+	SECTION("exact")
+	{
+		struct xrt_hand_joint_set hand = make_hand(1.f, 0.5f, 0.2f);
+		m_hand_history_push(hh, &hand, T0);
+		CHECK(m_hand_history_get(hh, T0, &out, &out_ts) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out_ts == T0);
+		CHECK(out.is_active);
+
+		const struct xrt_pose &a = joint(hand, XRT_HAND_JOINT_INDEX_TIP).pose;
+		const struct xrt_pose &b = joint(out, XRT_HAND_JOINT_INDEX_TIP).pose;
+		CHECK(b.position.x == Approx(a.position.x));
+		CHECK(b.position.z == Approx(a.position.z));
+		CHECK(b.orientation.w == Approx(a.orientation.w));
+		CHECK(out.values.hand_joint_set_default[XRT_HAND_JOINT_INDEX_TIP].radius == Approx(0.01f));
+	}
+
+	SECTION("interpolates in the wrist's space")
+	{
+		struct xrt_hand_joint_set a = make_hand(0.f, 0.f, 0.f);
+		struct xrt_hand_joint_set b = make_hand(1.f, (float)M_PI / 2.f, 0.4f);
+		m_hand_history_push(hh, &a, T0);
+		m_hand_history_push(hh, &b, T0 + STEP);
+
+		CHECK(m_hand_history_get(hh, T0 + STEP / 2, &out, &out_ts) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out_ts == T0 + STEP / 2);
+
+		struct xrt_hand_joint_set expected = make_hand(0.5f, (float)M_PI / 4.f, 0.2f);
+		const struct xrt_pose &e = joint(expected, XRT_HAND_JOINT_INDEX_TIP).pose;
+		const struct xrt_pose &r = joint(out, XRT_HAND_JOINT_INDEX_TIP).pose;
+
+		// Lerping the world positions would cut the corner of the arc the finger moves along.
+		CHECK(r.position.x == Approx(e.position.x).margin(0.0001));
+		CHECK(r.position.y == Approx(e.position.y).margin(0.0001));
+		CHECK(r.position.z == Approx(e.position.z).margin(0.0001));
+		CHECK(r.orientation.w == Approx(e.orientation.w).margin(0.0001));
+
+		// Only the wrist gets velocities, estimated from the previous entry.
+		m_hand_history_get(hh, T0 + STEP, &out, &out_ts);
+		const struct xrt_space_relation &wrist = joint(out, XRT_HAND_JOINT_WRIST);
+		CHECK((wrist.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0);
+		CHECK(wrist.linear_velocity.x == Approx(1.0 / time_ns_to_s(STEP)));
+		CHECK((joint(out, XRT_HAND_JOINT_INDEX_TIP).relation_flags &
+		       XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) == 0);
+	}
+
+	SECTION("predicts the root past the newest entry")
+	{
+		struct xrt_hand_joint_set a = make_hand(0.f, 0.f, 0.3f);
+		struct xrt_hand_joint_set b = make_hand(0.1f, 0.f, 0.3f);
+		m_hand_history_push(hh, &a, T0);
+		m_hand_history_push(hh, &b, T0 + STEP);
+
+		CHECK(m_hand_history_get(hh, T0 + 2 * STEP, &out, &out_ts) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(joint(out, XRT_HAND_JOINT_WRIST).pose.position.x == Approx(0.2f));
+		CHECK(joint(out, XRT_HAND_JOINT_INDEX_TIP).pose.position.x == Approx(0.2f));
+		CHECK(joint(out, XRT_HAND_JOINT_INDEX_TIP).pose.position.z == Approx(-0.1f));
+	}
+
+	SECTION("stops predicting past the horizon")
+	{
+		struct xrt_hand_joint_set a = make_hand(0.f, 0.f, 0.3f);
+		struct xrt_hand_joint_set b = make_hand(0.1f, 0.f, 0.3f);
+		m_hand_history_push(hh, &a, T0);
+		m_hand_history_push(hh, &b, T0 + STEP);
+
+		uint64_t at = T0 + STEP + M_HAND_HISTORY_MAX_PREDICTION_NS + 1;
+		CHECK(m_hand_history_get(hh, at, &out, &out_ts) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK_FALSE(out.is_active);
+		CHECK(joint(out, XRT_HAND_JOINT_WRIST).relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+		CHECK(joint(out, XRT_HAND_JOINT_INDEX_TIP).relation_flags == XRT_SPACE_RELATION_BITMASK_NONE);
+	}
+
+	SECTION("doesn't interpolate to a lost hand")
+	{
+		struct xrt_hand_joint_set a = make_hand(0.f, 0.f, 0.f);
+		struct xrt_hand_joint_set b = make_hand(1.f, 0.f, 0.f);
+		b.is_active = false;
+		m_hand_history_push(hh, &a, T0);
+		m_hand_history_push(hh, &b, T0 + STEP);
+
+		m_hand_history_get(hh, T0 + STEP / 4, &out, &out_ts);
+		CHECK(out.is_active);
+		CHECK(out_ts == T0);
+		CHECK(joint(out, XRT_HAND_JOINT_WRIST).pose.position.x == Approx(0.f));
+	}
+
+	SECTION("wraps around")
+	{
+		for (uint32_t i = 0; i < 10; i++) {
+			struct xrt_hand_joint_set hand = make_hand((float)i, 0.f, 0.f);
+			CHECK(m_hand_history_push(hh, &hand, T0 + i * STEP));
+		}
+		CHECK(m_hand_history_get_size(hh) == 4);
+
+		CHECK(m_hand_history_get_latest(hh, &out_ts, &out));
+		CHECK(out_ts == T0 + 9 * STEP);
+		CHECK(joint(out, XRT_HAND_JOINT_WRIST).pose.position.x == Approx(9.f));
+
+		CHECK(m_hand_history_get(hh, T0, &out, &out_ts) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out_ts == T0 + 6 * STEP);
+
+		m_hand_history_clear(hh);
+		CHECK(m_hand_history_get_size(hh) == 0);
+	}
+
+	m_hand_history_destroy(&hh);
+	CHECK(hh == NULL);
+}
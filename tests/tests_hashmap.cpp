@@ -0,0 +1,116 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Test u_hashmap_int C interface.
+ */
+
+#include "catch/catch.hpp"
+#include "util/u_hashmap.h"
+
+#include <map>
+
+
+static void
+count_callback(void *item, void *priv)
+{
+	int *count = static_cast<int *>(priv);
+	(*count)++;
+}
+
+static void
+sum_callback(uint64_t key, const void *value, void *priv_ctx)
+{
+	uint64_t *sum = static_cast<uint64_t *>(priv_ctx);
+	*sum += key;
+}
+
+static void *
+value_for(uint64_t key)
+{
+	return reinterpret_cast<void *>(static_cast<uintptr_t>(key * 2 + 1));
+}
+
+TEST_CASE("u_hashmap_int")
+{
+	struct u_hashmap_int *hmi = NULL;
+	REQUIRE(u_hashmap_int_create(&hmi) == 0);
+	REQUIRE(hmi != NULL);
+	CHECK(u_hashmap_int_empty(hmi));
+
+	void *item = NULL;
+
+	SECTION("Small")
+	{
+		CHECK(u_hashmap_int_find(hmi, 0, &item) < 0);
+
+		CHECK(u_hashmap_int_insert(hmi, 0, value_for(0)) == 0);
+		CHECK(u_hashmap_int_insert(hmi, 7, value_for(7)) == 0);
+		CHECK_FALSE(u_hashmap_int_empty(hmi));
+
+		CHECK(u_hashmap_int_find(hmi, 0, &item) == 0);
+		CHECK(item == value_for(0));
+		CHECK(u_hashmap_int_find(hmi, 7, &item) == 0);
+		CHECK(item == value_for(7));
+
+		// Replaces the value.
+		CHECK(u_hashmap_int_insert(hmi, 7, value_for(8)) == 0);
+		CHECK(u_hashmap_int_find(hmi, 7, &item) == 0);
+		CHECK(item == value_for(8));
+
+		CHECK(u_hashmap_int_erase(hmi, 0) == 0);
+		CHECK(u_hashmap_int_find(hmi, 0, &item) < 0);
+		CHECK(u_hashmap_int_find(hmi, 7, &item) == 0);
+
+		CHECK(u_hashmap_int_erase(hmi, 7) == 0);
+		CHECK(u_hashmap_int_empty(hmi));
+	}
+
+	SECTION("Grows and erases like std::map")
+	{
+		std::map<uint64_t, void *> reference;
+
+		// Sequential and aligned pointer like keys.
+		for (uint64_t i = 0; i < 1000; i++) {
+			uint64_t key = (i % 2) == 0 ? i : 0x7f0000000000 + i * 64;
+			u_hashmap_int_insert(hmi, key, value_for(key));
+			reference[key] = value_for(key);
+		}
+
+		// Erase every third, exercises moving back items that were probed past.
+		for (uint64_t i = 0; i < 1000; i += 3) {
+			uint64_t key = (i % 2) == 0 ? i : 0x7f0000000000 + i * 64;
+			u_hashmap_int_erase(hmi, key);
+			reference.erase(key);
+		}
+
+		for (uint64_t i = 0; i < 1000; i++) {
+			uint64_t key = (i % 2) == 0 ? i : 0x7f0000000000 + i * 64;
+			item = NULL;
+			int ret = u_hashmap_int_find(hmi, key, &item);
+			if (reference.count(key) != 0) {
+				CHECK(ret == 0);
+				CHECK(item == reference[key]);
+			} else {
+				CHECK(ret < 0);
+			}
+		}
+
+		uint64_t sum = 0;
+		uint64_t expected = 0;
+		u_hashmap_int_for_each(hmi, sum_callback, &sum);
+		for (auto &kv : reference) {
+			expected += kv.first;
+		}
+		CHECK(sum == expected);
+
+		int count = 0;
+		u_hashmap_int_clear_and_call_for_each(hmi, count_callback, &count);
+		CHECK(count == (int)reference.size());
+		CHECK(u_hashmap_int_empty(hmi));
+		CHECK(u_hashmap_int_find(hmi, 2, &item) < 0);
+	}
+
+	u_hashmap_int_destroy(&hmi);
+	CHECK(hmi == NULL);
+}
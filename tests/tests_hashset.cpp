@@ -0,0 +1,102 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Test u_hashset C interface.
+ */
+
+#include "catch/catch.hpp"
+#include "util/u_hashset.h"
+
+#include <cstdlib>
+#include <cstring>
+
+
+static void
+free_callback(struct u_hashset_item *item, void *priv)
+{
+	int *count = static_cast<int *>(priv);
+	(*count)++;
+	free(item);
+}
+
+TEST_CASE("u_hashset")
+{
+	struct u_hashset *hs = NULL;
+	REQUIRE(u_hashset_create(&hs) == 0);
+	REQUIRE(hs != NULL);
+
+	SECTION("Lookups use the length, not the null terminator")
+	{
+		struct u_hashset_item *item = NULL;
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, "/user/hand/left", &item) == 0);
+		REQUIRE(item != NULL);
+		CHECK(item->length == strlen("/user/hand/left"));
+
+		struct u_hashset_item *found = NULL;
+		CHECK(u_hashset_find_c_str(hs, "/user/hand/left", &found) == 0);
+		CHECK(found == item);
+
+		// Prefix of a longer string.
+		const char *longer = "/user/hand/left/input";
+		found = NULL;
+		CHECK(u_hashset_find_str(hs, longer, strlen("/user/hand/left"), &found) == 0);
+		CHECK(found == item);
+
+		found = NULL;
+		CHECK(u_hashset_find_c_str(hs, longer, &found) < 0);
+		CHECK(found == NULL);
+
+		// Can't insert the same string twice.
+		struct u_hashset_item *other = NULL;
+		CHECK(u_hashset_create_and_insert_str_c(hs, "/user/hand/left", &other) < 0);
+	}
+
+	SECTION("Erase")
+	{
+		struct u_hashset_item *a = NULL;
+		struct u_hashset_item *b = NULL;
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, "a", &a) == 0);
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, "b", &b) == 0);
+
+		u_hashset_erase_item(hs, a);
+		free(a);
+
+		struct u_hashset_item *found = NULL;
+		CHECK(u_hashset_find_c_str(hs, "a", &found) < 0);
+		CHECK(u_hashset_find_c_str(hs, "b", &found) == 0);
+		CHECK(found == b);
+
+		u_hashset_erase_c_str(hs, "b");
+		free(b);
+		CHECK(u_hashset_find_c_str(hs, "b", &found) < 0);
+	}
+
+	SECTION("Replace item with the same string")
+	{
+		struct u_hashset_item *a = NULL;
+		REQUIRE(u_hashset_create_and_insert_str_c(hs, "same", &a) == 0);
+
+		// Same string but different storage.
+		size_t length = strlen("same");
+		auto *b = static_cast<struct u_hashset_item *>(calloc(1, sizeof(struct u_hashset_item) + length + 1));
+		b->length = length;
+		memcpy(const_cast<char *>(b->c_str()), "same", length + 1);
+
+		CHECK(u_hashset_insert_item(hs, b) == 0);
+
+		// The old item must not be referenced any more.
+		memset(const_cast<char *>(a->c_str()), 'x', length);
+		free(a);
+
+		struct u_hashset_item *found = NULL;
+		CHECK(u_hashset_find_c_str(hs, "same", &found) == 0);
+		CHECK(found == b);
+	}
+
+	int count = 0;
+	u_hashset_clear_and_call_for_each(hs, free_callback, &count);
+	CHECK(u_hashset_find_c_str(hs, "b", NULL) < 0);
+	u_hashset_destroy(&hs);
+	CHECK(hs == NULL);
+}
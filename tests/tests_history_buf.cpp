@@ -10,6 +10,7 @@
 #include <util/u_time.h>
 #include <util/u_template_historybuf.hpp>
 #include <iostream>
+#include <vector>
 
 
 using xrt::auxiliary::util::HistoryBuffer;
@@ -116,11 +117,79 @@ TEST_CASE("m_relation_history")
 		      M_RELATION_HISTORY_RESULT_PREDICTED);
 		CHECK(out_relation.pose.position.x > 2.f);
 	}
+	SECTION("wrapped buffer")
+	{
+		xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+		relation.relation_flags = XRT_SPACE_RELATION_POSITION_VALID_BIT;
+
+		// More than fits, so the oldest entries are dropped.
+		for (uint32_t i = 1; i <= 5000; i++) {
+			relation.pose.position.x = (float)i;
+			CHECK(m_relation_history_push(rh, &relation, i * (uint64_t)U_TIME_1MS_IN_NS));
+		}
+		CHECK(m_relation_history_get_size(rh) == 4096);
+
+		uint64_t out_time = 0;
+		xrt_space_relation out_relation = XRT_SPACE_RELATION_ZERO;
+		CHECK(m_relation_history_get_latest(rh, &out_time, &out_relation));
+		CHECK(out_time == 5000 * (uint64_t)U_TIME_1MS_IN_NS);
+
+		CHECK(m_relation_history_get(rh, 905 * (uint64_t)U_TIME_1MS_IN_NS, &out_relation) ==
+		      M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out_relation.pose.position.x == 905.f);
+
+		CHECK(m_relation_history_get(rh, 904 * (uint64_t)U_TIME_1MS_IN_NS, &out_relation) ==
+		      M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+
+		m_relation_history_clear(rh);
+		CHECK(m_relation_history_get_size(rh) == 0);
+		CHECK(m_relation_history_get(rh, 1, &out_relation) == M_RELATION_HISTORY_RESULT_INVALID);
+	}
 
 
 	m_relation_history_destroy(&rh);
 }
 
+TEST_CASE("m_relation_history_create_with_params")
+{
+	m_relation_history *rh = nullptr;
+
+	xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.relation_flags = (xrt_space_relation_flags)( //
+	    XRT_SPACE_RELATION_POSITION_VALID_BIT |           //
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);    //
+
+	SECTION("capacity")
+	{
+		m_relation_history_create_with_params(&rh, 16, M_RELATION_HISTORY_INTERPOLATION_LINEAR);
+
+		for (uint32_t i = 1; i <= 20; i++) {
+			m_relation_history_push(rh, &relation, i * (uint64_t)U_TIME_1MS_IN_NS);
+		}
+		CHECK(m_relation_history_get_size(rh) == 16);
+	}
+	SECTION("hermite")
+	{
+		m_relation_history_create_with_params(&rh, 0, M_RELATION_HISTORY_INTERPOLATION_HERMITE);
+
+		// Constant acceleration, x = t^2, which the spline follows exactly.
+		relation.pose.position.x = 0.f;
+		relation.linear_velocity.x = 0.f;
+		CHECK(m_relation_history_push(rh, &relation, U_TIME_1S_IN_NS));
+		relation.pose.position.x = 1.f;
+		relation.linear_velocity.x = 2.f;
+		CHECK(m_relation_history_push(rh, &relation, 2 * U_TIME_1S_IN_NS));
+
+		xrt_space_relation out_relation = XRT_SPACE_RELATION_ZERO;
+		CHECK(m_relation_history_get(rh, U_TIME_1S_IN_NS + U_TIME_1S_IN_NS / 2, &out_relation) ==
+		      M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out_relation.pose.position.x == Approx(0.25f));
+		CHECK(out_relation.linear_velocity.x == Approx(1.f));
+	}
+
+	m_relation_history_destroy(&rh);
+}
+
 
 TEST_CASE("RelationHistory")
 {
@@ -426,3 +495,64 @@ TEST_CASE("IteratorBase")
 		CHECK_FALSE((++end_constructed).is_cleared());
 	}
 }
+
+TEST_CASE("u_template_historybuf contiguous spans")
+{
+	HistoryBuffer<int, 4> buffer;
+	CHECK(HistoryBuffer<int, 4>::is_power_of_two);
+	CHECK_FALSE(HistoryBuffer<int, 3>::is_power_of_two);
+
+	SECTION("empty")
+	{
+		auto spans = buffer.contiguous_spans();
+		CHECK(spans.first.empty());
+		CHECK(spans.second.empty());
+	}
+	SECTION("not wrapped")
+	{
+		buffer.push_back(0);
+		buffer.push_back(2);
+		buffer.push_back(4);
+		auto spans = buffer.contiguous_spans();
+		REQUIRE(spans.first.count == 3);
+		CHECK(spans.second.empty());
+		CHECK(spans.first.data == &buffer.front());
+		CHECK(std::lower_bound(spans.first.begin(), spans.first.end(), 3) == &buffer.back());
+	}
+	SECTION("wrapped")
+	{
+		for (int i = 0; i < 6; i++) {
+			buffer.push_back(i * 2);
+		}
+		// Holding 4, 6, 8, 10
+		auto spans = buffer.contiguous_spans();
+		REQUIRE(spans.first.count + spans.second.count == 4);
+		REQUIRE_FALSE(spans.second.empty());
+		CHECK(spans.first.data == &buffer.front());
+		CHECK(spans.second.end() - 1 == &buffer.back());
+
+		// Chronological order is kept across the two spans.
+		std::vector<int> values;
+		values.insert(values.end(), spans.first.begin(), spans.first.end());
+		values.insert(values.end(), spans.second.begin(), spans.second.end());
+		CHECK(values == std::vector<int>{4, 6, 8, 10});
+		CHECK(values == std::vector<int>(buffer.begin(), buffer.end()));
+	}
+}
+
+TEST_CASE("u_template_historybuf non power of two")
+{
+	HistoryBuffer<int, 3> buffer;
+	for (int i = 0; i < 5; i++) {
+		buffer.push_back(i);
+	}
+	CHECK(buffer.size() == 3);
+	CHECK(*buffer.get_at_age(0) == 4);
+	CHECK(*buffer.get_at_index(0) == 2);
+	CHECK(buffer.pop_back());
+	CHECK(buffer.back() == 3);
+
+	auto spans = buffer.contiguous_spans();
+	CHECK(spans.first.count + spans.second.count == 2);
+	CHECK(*spans.first.data == 2);
+}
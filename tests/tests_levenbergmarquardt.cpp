@@ -25,17 +25,9 @@
 
 using namespace xrt::tracking::hand::mercury;
 
-TEST_CASE("LevenbergMarquardt")
+static void
+make_input(struct one_frame_input &input)
 {
-	// This does very little at the moment:
-	// * It will explode if any floating point exceptions are generated
-	// * You should run it with `valgrind --track-origins=yes` (and compile without optimizations so that origin
-	// tracking works well) to see if we are using any uninitialized values.
-
-	fetestexcept(FE_ALL_EXCEPT);
-
-	struct one_frame_input input = {};
-
 	for (int view = 0; view < 2; view++) {
 		input.views[view].active = true;
 		input.views[view].stereographic_radius = 0.5;
@@ -57,6 +49,19 @@ TEST_CASE("LevenbergMarquardt")
 			input.views[view].keypoints_in_scaled_stereographic[i].confidence_xy = 1.0f;
 		}
 	}
+}
+
+TEST_CASE("LevenbergMarquardt")
+{
+	// This does very little at the moment:
+	// * It will explode if any floating point exceptions are generated
+	// * You should run it with `valgrind --track-origins=yes` (and compile without optimizations so that origin
+	// tracking works well) to see if we are using any uninitialized values.
+
+	fetestexcept(FE_ALL_EXCEPT);
+
+	struct one_frame_input input = {};
+	make_input(input);
 
 	lm::KinematicHandLM *hand;
 
@@ -84,3 +89,48 @@ TEST_CASE("LevenbergMarquardt")
 	CHECK(std::isfinite(out_reprojection_error));
 	CHECK(std::isfinite(out_hand_size));
 }
+
+TEST_CASE("LevenbergMarquardtJacobian")
+{
+	// The optimizer uses an analytic Jacobian, it must match what autodiff gets out of the cost function.
+
+	struct one_frame_input input = {};
+	make_input(input);
+
+	lm::KinematicHandLM *hand;
+
+	xrt_pose left_in_right = XRT_POSE_IDENTITY;
+	left_in_right.position.x = 1;
+
+	bool is_right = GENERATE(false, true);
+	bool optimize_hand_size = GENERATE(false, true);
+
+	lm::optimizer_create(left_in_right, is_right, U_LOGGING_INFO, &hand);
+
+	xrt_hand_joint_set out = {};
+	float out_hand_size = 0.0f;
+	float out_reprojection_error = 0.0f;
+
+	// Twice, so the second frame also has depth and stability residuals.
+	for (int frame = 0; frame < 2; frame++) {
+		lm::optimizer_run(hand,               //
+		                  input,              //
+		                  frame == 0,         //
+		                  2.0f,               //
+		                  optimize_hand_size, //
+		                  0.09,               //
+		                  0.5,                //
+		                  0.5f,               //
+		                  out,                //
+		                  out_hand_size,      //
+		                  out_reprojection_error);
+	}
+
+	for (uint32_t seed = 0; seed < 16; seed++) {
+		float error = lm::optimizer_jacobian_error(hand, 0.5f, seed);
+		CAPTURE(seed);
+		CHECK(error < 1e-3f);
+	}
+
+	lm::optimizer_destroy(&hand);
+}
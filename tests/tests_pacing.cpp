@@ -11,6 +11,7 @@
 #include "catch/catch.hpp"
 
 #include "time_utils.hpp"
+#include "bench/pacing_sim.hpp"
 
 #include <iostream>
 #include <chrono>
@@ -402,3 +403,56 @@ TEST_CASE("u_pacing_compositor_fake")
 	}
 	u_pc_destroy(&upc);
 }
+
+TEST_CASE("u_pacing_simulated")
+{
+	pacing_sim::config cfg;
+	pacing_sim::synthetic_params params;
+
+	cfg.pacer = GENERATE(pacing_sim::compositor_pacer::display_timing, pacing_sim::compositor_pacer::fake);
+	INFO("fake pacer: " << (cfg.pacer == pacing_sim::compositor_pacer::fake));
+
+	SECTION("steady")
+	{
+		auto work = pacing_sim::make_synthetic_workload(params);
+		pacing_sim::results r = pacing_sim::run(cfg, *work);
+
+		CHECK(r.compositor_frames > 0);
+		CHECK(r.compositor_missed == 0);
+		CHECK(r.app_late == 0);
+		CHECK(r.app_dropped == 0);
+
+		// The app shouldn't wake up much earlier than needed.
+		CHECK(r.app_margin.p95_ms < 4.0);
+	}
+	SECTION("app spikes")
+	{
+		params.spike_every = 50;
+		params.spike_ns = 15'000'000;
+
+		auto work = pacing_sim::make_synthetic_workload(params);
+		pacing_sim::results r = pacing_sim::run(cfg, *work);
+
+		// A slow app must not make the compositor miss.
+		CHECK(r.compositor_missed == 0);
+		CHECK(r.app_dropped <= 2 * r.app_frames / params.spike_every);
+	}
+}
+
+TEST_CASE("u_pacing_simulated_layers")
+{
+	pacing_sim::config cfg;
+	pacing_sim::synthetic_params params;
+
+	// Scenes that keep switching between just projection and a few overlays.
+	params.overlay_layers = 4;
+	params.overlay_period = 30;
+	params.layer_gpu_ns = 200'000;
+	params.jitter = 0.1;
+
+	auto work = pacing_sim::make_synthetic_workload(params);
+	pacing_sim::results r = pacing_sim::run(cfg, *work);
+
+	CHECK(r.compositor_frames > 0);
+	CHECK(r.compositor_missed * 100 <= r.compositor_frames);
+}
@@ -66,3 +66,46 @@ TEST_CASE("Pose interpolation works")
 	CHECK(res.orientation.y == Approx(0).margin(e));
 	CHECK(res.orientation.w == Approx(1).margin(e));
 }
+
+TEST_CASE("Batched transforms match single ones")
+{
+	struct xrt_pose transform = {{0.2f, -0.4f, 0.1f, 0.9f}, {1.f, -2.f, 3.f}};
+	math_quat_normalize(&transform.orientation);
+
+	struct xrt_pose poses[5];
+	struct xrt_vec3 vecs[5];
+	for (uint32_t i = 0; i < 5; i++) {
+		poses[i].orientation = {0.1f * i, 0.3f, -0.2f * i, 1.f};
+		math_quat_normalize(&poses[i].orientation);
+		poses[i].position = {1.f * i, -0.5f * i, 2.f};
+		vecs[i] = poses[i].position;
+	}
+
+	struct xrt_pose out_poses[5];
+	math_pose_transform_batch(&transform, poses, 5, out_poses);
+
+	struct xrt_vec3 out_vecs[5];
+	math_quat_rotate_vec3_batch(&transform.orientation, vecs, 5, out_vecs);
+
+	for (uint32_t i = 0; i < 5; i++) {
+		struct xrt_pose expected_pose;
+		math_pose_transform(&transform, &poses[i], &expected_pose);
+		CHECK(m_vec3_len(out_poses[i].position - expected_pose.position) < 0.0001f);
+		CHECK(out_poses[i].orientation.x == Approx(expected_pose.orientation.x).margin(0.0001f));
+		CHECK(out_poses[i].orientation.y == Approx(expected_pose.orientation.y).margin(0.0001f));
+		CHECK(out_poses[i].orientation.z == Approx(expected_pose.orientation.z).margin(0.0001f));
+		CHECK(out_poses[i].orientation.w == Approx(expected_pose.orientation.w).margin(0.0001f));
+
+		struct xrt_vec3 expected_vec;
+		math_quat_rotate_vec3(&transform.orientation, &vecs[i], &expected_vec);
+		CHECK(m_vec3_len(out_vecs[i] - expected_vec) < 0.0001f);
+	}
+
+	// In place.
+	math_pose_transform_batch(&transform, poses, 5, poses);
+	math_quat_rotate_vec3_batch(&transform.orientation, vecs, 5, vecs);
+	for (uint32_t i = 0; i < 5; i++) {
+		CHECK(m_vec3_len(poses[i].position - out_poses[i].position) < 0.0001f);
+		CHECK(m_vec3_len(vecs[i] - out_vecs[i]) < 0.0001f);
+	}
+}
@@ -0,0 +1,156 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the pose predictor and its motion models.
+ */
+
+#include <math/m_api.h>
+#include <math/m_predictor.h>
+#include <math/m_relation_history.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+
+static constexpr uint64_t T0 = 10 * (uint64_t)U_TIME_1S_IN_NS;
+static constexpr uint64_t STEP = 10 * (uint64_t)U_TIME_1MS_IN_NS;
+
+static struct xrt_space_relation
+make_relation(float x, float vx)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
+	rel.pose.orientation.w = 1.f;
+	rel.pose.position.x = x;
+	rel.linear_velocity.x = vx;
+	return rel;
+}
+
+TEST_CASE("m_predictor constant velocity")
+{
+	struct m_predictor *p = NULL;
+	m_predictor_create(&p, M_PREDICTOR_MODEL_CONSTANT_VELOCITY, NULL);
+
+	struct xrt_space_relation rel = make_relation(1.f, 2.f);
+	struct xrt_space_relation out;
+	m_predictor_predict(p, &rel, T0, T0 + U_TIME_1S_IN_NS / 2, &out);
+	CHECK(out.pose.position.x == Approx(2.f));
+	CHECK(out.linear_velocity.x == Approx(2.f));
+	CHECK(out.relation_flags == rel.relation_flags);
+
+	m_predictor_destroy(&p);
+	CHECK(p == NULL);
+}
+
+TEST_CASE("m_predictor constant acceleration")
+{
+	struct m_predictor *p = NULL;
+	m_predictor_create(&p, M_PREDICTOR_MODEL_CONSTANT_ACCELERATION, NULL);
+
+	// Accelerating at 1 m/s^2 along X, enough samples for the filter to settle.
+	struct xrt_space_relation rel = {};
+	uint64_t ts = T0;
+	for (int i = 0; i < 100; i++) {
+		float t = (float)i * 0.01f;
+		ts = T0 + i * STEP;
+		rel = make_relation(t * t * 0.5f, t);
+		m_predictor_push_relation(p, &rel, ts);
+	}
+
+	// Within the horizon the acceleration is fully applied.
+	struct xrt_space_relation out;
+	double dt = 0.05;
+	m_predictor_predict(p, &rel, ts, ts + (uint64_t)(dt * U_TIME_1S_IN_NS), &out);
+	float expected = rel.pose.position.x + rel.linear_velocity.x * (float)dt + (float)(dt * dt * 0.5);
+	CHECK(out.pose.position.x == Approx(expected).margin(0.0001));
+	CHECK(out.linear_velocity.x == Approx(rel.linear_velocity.x + dt).margin(0.001));
+
+	SECTION("clear drops the acceleration")
+	{
+		m_predictor_clear(p);
+		m_predictor_predict(p, &rel, ts, ts + (uint64_t)(dt * U_TIME_1S_IN_NS), &out);
+		CHECK(out.linear_velocity.x == Approx(rel.linear_velocity.x));
+	}
+
+	m_predictor_destroy(&p);
+}
+
+TEST_CASE("m_predictor imu integrated")
+{
+	struct m_predictor *p = NULL;
+	struct xrt_vec3 gravity_correction = {0.f, -1.f, 0.f};
+	m_predictor_create(&p, M_PREDICTOR_MODEL_IMU_INTEGRATED, &gravity_correction);
+
+	struct xrt_space_relation rel = make_relation(0.f, 0.f);
+	struct xrt_space_relation out;
+
+	SECTION("no samples is constant velocity")
+	{
+		m_predictor_predict(p, &rel, T0, T0 + 10 * STEP, &out);
+		CHECK(out.pose.position.x == Approx(0.f));
+	}
+
+	SECTION("gravity is cancelled and rotation integrated")
+	{
+		// Rotating at 1 rad/s around Y, the accelerometer only sees gravity.
+		struct xrt_vec3 accel = {0.f, 1.f, 0.f};
+		struct xrt_vec3 gyro = {0.f, 1.f, 0.f};
+		for (int i = 1; i <= 10; i++) {
+			m_predictor_push_imu(p, T0 + i * STEP, &accel, &gyro);
+		}
+
+		m_predictor_predict(p, &rel, T0, T0 + 10 * STEP, &out);
+		CHECK(out.pose.position.x == Approx(0.f).margin(0.0001));
+		CHECK(out.pose.position.y == Approx(0.f).margin(0.0001));
+		CHECK(out.angular_velocity.y == Approx(1.f).margin(0.0001));
+
+		// 0.1 s at 1 rad/s.
+		struct xrt_quat expected;
+		struct xrt_vec3 up = {0.f, 1.f, 0.f};
+		math_quat_from_angle_vector(0.1f, &up, &expected);
+		CHECK(out.pose.orientation.y == Approx(expected.y).margin(0.0001));
+		CHECK(out.pose.orientation.w == Approx(expected.w).margin(0.0001));
+	}
+
+	SECTION("acceleration is integrated")
+	{
+		struct xrt_vec3 accel = {1.f, 1.f, 0.f};
+		struct xrt_vec3 gyro = {0.f, 0.f, 0.f};
+		for (int i = 1; i <= 10; i++) {
+			m_predictor_push_imu(p, T0 + i * STEP, &accel, &gyro);
+		}
+
+		m_predictor_predict(p, &rel, T0, T0 + 10 * STEP, &out);
+		CHECK(out.pose.position.x == Approx(0.005f).margin(0.0001));
+		CHECK(out.linear_velocity.x == Approx(0.1f).margin(0.0001));
+	}
+
+	m_predictor_destroy(&p);
+}
+
+TEST_CASE("m_relation_history with predictor")
+{
+	struct m_predictor *p = NULL;
+	m_predictor_create(&p, M_PREDICTOR_MODEL_CONSTANT_ACCELERATION, NULL);
+
+	struct m_relation_history *rh = NULL;
+	m_relation_history_create(&rh);
+	m_relation_history_set_predictor(rh, p);
+
+	struct xrt_space_relation rel = {};
+	uint64_t ts = T0;
+	for (int i = 0; i < 100; i++) {
+		float t = (float)i * 0.01f;
+		ts = T0 + i * STEP;
+		rel = make_relation(t * t * 0.5f, t);
+		m_relation_history_push(rh, &rel, ts);
+	}
+
+	struct xrt_space_relation out;
+	CHECK(m_relation_history_get(rh, ts + 5 * STEP, &out) == M_RELATION_HISTORY_RESULT_PREDICTED);
+	CHECK(out.linear_velocity.x == Approx(rel.linear_velocity.x + 0.05f).margin(0.001));
+
+	m_relation_history_destroy(&rh);
+	m_predictor_destroy(&p);
+}
@@ -0,0 +1,111 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the multi-camera timestamp synchronizer sink.
+ */
+
+#include <util/u_frame.h>
+#include <util/u_sink.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <vector>
+
+
+static constexpr uint64_t T0 = 10 * (uint64_t)U_TIME_1S_IN_NS;
+static constexpr uint64_t TOLERANCE = 1 * (uint64_t)U_TIME_1MS_IN_NS;
+static constexpr uint64_t STEP = 33 * (uint64_t)U_TIME_1MS_IN_NS;
+
+//! One entry per frame that came out of the synchronizer, in order.
+struct received
+{
+	uint32_t cam;
+	uint64_t timestamp;
+};
+
+struct recording_sink
+{
+	struct xrt_frame_sink base;
+	uint32_t cam;
+	std::vector<received> *log;
+};
+
+static void
+recording_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	auto *rs = reinterpret_cast<recording_sink *>(xfs);
+	rs->log->push_back({rs->cam, xf->timestamp});
+}
+
+static void
+push(struct xrt_frame_sink *xfs, uint64_t timestamp)
+{
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, 4, 4, &xf);
+	xf->timestamp = timestamp;
+	xrt_sink_push_frame(xfs, xf);
+	xrt_frame_reference(&xf, NULL);
+}
+
+TEST_CASE("u_sink_sync")
+{
+	struct xrt_frame_context xfctx = {};
+	std::vector<received> log;
+
+	recording_sink downstream[3] = {};
+	struct xrt_frame_sink *downstream_ptrs[3] = {};
+	for (uint32_t i = 0; i < 3; i++) {
+		downstream[i].base.push_frame = recording_push_frame;
+		downstream[i].cam = i;
+		downstream[i].log = &log;
+		downstream_ptrs[i] = &downstream[i].base;
+	}
+
+	struct xrt_frame_sink *inputs[3] = {};
+	REQUIRE(u_sink_sync_create(&xfctx, 3, TOLERANCE, downstream_ptrs, inputs));
+
+	SECTION("sets are pushed in camera order")
+	{
+		push(inputs[2], T0 + 200 * 1000);
+		push(inputs[0], T0);
+		CHECK(log.empty());
+		push(inputs[1], T0 + 500 * 1000);
+
+		REQUIRE(log.size() == 3);
+		for (uint32_t i = 0; i < 3; i++) {
+			CHECK(log[i].cam == i);
+		}
+		CHECK(log[0].timestamp == T0);
+	}
+
+	SECTION("frames without a match are dropped")
+	{
+		// Camera 0 has a frame the others missed.
+		push(inputs[0], T0);
+		push(inputs[0], T0 + STEP);
+		push(inputs[1], T0 + STEP);
+		push(inputs[2], T0 + STEP);
+
+		REQUIRE(log.size() == 3);
+		for (const received &r : log) {
+			CHECK(r.timestamp == T0 + STEP);
+		}
+	}
+
+	SECTION("a camera running ahead does not grow without bound")
+	{
+		for (uint64_t i = 0; i < 16; i++) {
+			push(inputs[0], T0 + i * STEP);
+		}
+		push(inputs[1], T0 + 15 * STEP);
+		push(inputs[2], T0 + 15 * STEP);
+
+		REQUIRE(log.size() == 3);
+		CHECK(log[0].timestamp == T0 + 15 * STEP);
+	}
+
+	// Also releases any frames still waiting for a match.
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
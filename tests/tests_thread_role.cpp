@@ -0,0 +1,53 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Thread role tests.
+ */
+
+#include <util/u_thread_role.h>
+
+#include "catch/catch.hpp"
+
+
+TEST_CASE("u_thread_role_parse_cpus")
+{
+	uint64_t mask = 0xdead;
+
+	SECTION("single cpus")
+	{
+		CHECK(u_thread_role_parse_cpus("0", &mask));
+		CHECK(mask == 0x1);
+		CHECK(u_thread_role_parse_cpus("1,3", &mask));
+		CHECK(mask == 0xa);
+		CHECK(u_thread_role_parse_cpus("63", &mask));
+		CHECK(mask == UINT64_C(1) << 63);
+	}
+	SECTION("ranges")
+	{
+		CHECK(u_thread_role_parse_cpus("2-5", &mask));
+		CHECK(mask == 0x3c);
+		CHECK(u_thread_role_parse_cpus("0,4-5,7", &mask));
+		CHECK(mask == 0xb1);
+		CHECK(u_thread_role_parse_cpus("3-3", &mask));
+		CHECK(mask == 0x8);
+	}
+	SECTION("empty")
+	{
+		CHECK(u_thread_role_parse_cpus("", &mask));
+		CHECK(mask == 0);
+	}
+	SECTION("invalid")
+	{
+		CHECK_FALSE(u_thread_role_parse_cpus("64", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus("5-2", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus("1,", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus(",1", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus("1-", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus("a", &mask));
+		CHECK_FALSE(u_thread_role_parse_cpus("1 2", &mask));
+
+		// Untouched on failure.
+		CHECK(mask == 0xdead);
+	}
+}
@@ -8,6 +8,7 @@
 
 #include "catch/catch.hpp"
 #include "util/u_vector.h"
+#include "util/u_arena.h"
 
 TEST_CASE("u_vector")
 {
@@ -35,4 +36,62 @@ TEST_CASE("u_vector")
 		u_vector_float_destroy(&vf);
 		CHECK(vf.ptr == NULL);
 	}
+
+	SECTION("Grows past the inline capacity and clears")
+	{
+		struct u_vector_int vi = u_vector_int_create();
+
+		for (int i = 0; i < U_VECTOR_INLINE_CAPACITY * 5; i++) {
+			u_vector_int_push_back(vi, i);
+		}
+		CHECK(u_vector_int_size(vi) == U_VECTOR_INLINE_CAPACITY * 5);
+
+		bool all_equal = true;
+		for (int i = 0; i < U_VECTOR_INLINE_CAPACITY * 5; i++) {
+			all_equal = all_equal && u_vector_int_at(vi, i) == i;
+		}
+		CHECK(all_equal);
+		CHECK_THROWS(u_vector_int_at(vi, U_VECTOR_INLINE_CAPACITY * 5));
+
+		u_vector_int_clear(vi);
+		CHECK(u_vector_int_size(vi) == 0);
+
+		u_vector_int_reserve(vi, 1000);
+		u_vector_int_push_back(vi, 42);
+		CHECK(u_vector_int_at(vi, 0) == 42);
+
+		u_vector_int_destroy(&vi);
+	}
+
+	SECTION("Lives in an arena and grows from it")
+	{
+		struct u_arena arena;
+		u_arena_init(&arena, 64);
+
+		struct u_vector_int vi = u_vector_int_create_in_arena(&arena);
+		CHECK(vi.ptr != NULL);
+
+		for (int i = 0; i < U_VECTOR_INLINE_CAPACITY * 5; i++) {
+			u_vector_int_push_back(vi, i);
+		}
+		CHECK(u_vector_int_size(vi) == U_VECTOR_INLINE_CAPACITY * 5);
+
+		bool all_equal = true;
+		for (int i = 0; i < U_VECTOR_INLINE_CAPACITY * 5; i++) {
+			all_equal = all_equal && u_vector_int_at(vi, i) == i;
+		}
+		CHECK(all_equal);
+
+		// Not needed before a reset, but allowed.
+		u_vector_int_destroy(&vi);
+		CHECK(vi.ptr == NULL);
+
+		u_arena_reset(&arena);
+
+		struct u_vector_float vf = u_vector_float_create_in_arena(&arena);
+		u_vector_float_push_back(vf, 1.0f);
+		CHECK(u_vector_float_at(vf, 0) == 1.0f);
+
+		u_arena_fini(&arena);
+	}
 }
@@ -0,0 +1,65 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Visibility mask tests.
+ */
+
+#include <util/u_misc.h>
+#include <util/u_visibility_mask.h>
+
+#include "catch/catch.hpp"
+
+
+TEST_CASE("u_visibility_mask_get_hidden_grid")
+{
+	uint32_t rows[U_VISIBILITY_MASK_GRID_SIZE];
+	const uint32_t last = U_VISIBILITY_MASK_GRID_SIZE - 1;
+
+	SECTION("no mask")
+	{
+		struct xrt_fov fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+		u_visibility_mask_get_hidden_grid(NULL, &fov, rows);
+
+		for (uint32_t y = 0; y < U_VISIBILITY_MASK_GRID_SIZE; y++) {
+			CHECK(rows[y] == 0);
+		}
+	}
+
+	SECTION("default mask")
+	{
+		// Asymmetric like a real lens, the mask is scaled to it so the grid should still be symmetric.
+		struct xrt_fov fov = {-0.9f, 0.7f, 0.8f, -0.85f};
+
+		struct xrt_visibility_mask *mask = NULL;
+		u_visibility_mask_get_default(XRT_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH, &fov, &mask);
+		REQUIRE(mask != NULL);
+
+		u_visibility_mask_get_hidden_grid(mask, &fov, rows);
+		free(mask);
+
+		// All four corners are hidden.
+		CHECK((rows[0] & 0x1) != 0);
+		CHECK((rows[0] & (1u << last)) != 0);
+		CHECK((rows[last] & 0x1) != 0);
+		CHECK((rows[last] & (1u << last)) != 0);
+
+		// But not the centre or the middle of the edges.
+		CHECK(rows[U_VISIBILITY_MASK_GRID_SIZE / 2] == 0);
+		CHECK((rows[0] & (1u << (U_VISIBILITY_MASK_GRID_SIZE / 2))) == 0);
+
+		// Corner triangles only cover an eighth of each side.
+		for (uint32_t y = U_VISIBILITY_MASK_GRID_SIZE / 8; y <= last - U_VISIBILITY_MASK_GRID_SIZE / 8; y++) {
+			CHECK(rows[y] == 0);
+		}
+
+		// Mirrored left to right and top to bottom.
+		for (uint32_t y = 0; y < U_VISIBILITY_MASK_GRID_SIZE; y++) {
+			for (uint32_t x = 0; x < U_VISIBILITY_MASK_GRID_SIZE; x++) {
+				bool hidden = (rows[y] >> x) & 1;
+				CHECK(hidden == (bool)((rows[y] >> (last - x)) & 1));
+				CHECK(hidden == (bool)((rows[last - y] >> x) & 1));
+			}
+		}
+	}
+}
@@ -12,6 +12,8 @@
 
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <algorithm>
 
 using namespace std::chrono_literals;
 
@@ -130,3 +132,63 @@ TEST_CASE("TaskCollection")
 		CHECK(calledA[2]);
 	}
 }
+
+TEST_CASE("ParallelFor")
+{
+	SharedThreadPool pool{2, 3, "Test"};
+	SharedThreadGroup group{pool};
+
+	SECTION("Every element once")
+	{
+		std::vector<int> hits(1000, 0);
+		std::atomic<bool> too_big{false};
+		// Catch isn't thread safe, so no checks inside the chunks.
+		group.parallelFor(0, hits.size(), 7, [&](size_t begin, size_t end) {
+			if (end - begin > 7) {
+				too_big = true;
+			}
+			for (size_t i = begin; i < end; i++) {
+				hits[i]++;
+			}
+		});
+		CHECK_FALSE(too_big);
+		CHECK(std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; }));
+	}
+
+	SECTION("Single chunk and empty range")
+	{
+		size_t calls = 0;
+		group.parallelFor(10, 20, 100, [&](size_t begin, size_t end) {
+			CHECK(begin == 10);
+			CHECK(end == 20);
+			calls++;
+		});
+		group.parallelFor(5, 5, 1, [&](size_t, size_t) { calls++; });
+		CHECK(calls == 1);
+	}
+}
+
+TEST_CASE("TaskGraph")
+{
+	SharedThreadPool pool{2, 3, "Test"};
+	SharedThreadGroup group{pool};
+
+	std::atomic<int> counter{0};
+	int order[4] = {};
+
+	{
+		TaskGraph graph{group};
+		auto a = graph.add([&] { order[0] = counter++; });
+		auto b = graph.add([&] { order[1] = counter++; }, {a});
+		auto c = graph.add([&] { order[2] = counter++; }, {a});
+		graph.add([&] { order[3] = counter++; }, {b, c});
+		graph.waitAll();
+	}
+
+	CHECK(counter == 4);
+	// Fan out from the first, fan in to the last.
+	CHECK(order[0] == 0);
+	CHECK(order[1] > order[0]);
+	CHECK(order[2] > order[0]);
+	CHECK(order[3] == 3);
+}